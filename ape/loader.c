@@ -803,8 +803,9 @@ __attribute__((__noreturn__)) static void Spawn(int os, char *exe, int fd,
 }
 
 static const char *TryElf(struct ApeLoader *M, union ElfEhdrBuf *ebuf,
-                          char *exe, int fd, long *sp, long *auxv,
-                          unsigned long pagesz, int os) {
+                          unsigned long lo, unsigned long hi, char *exe,
+                          int fd, long *sp, long *auxv, unsigned long pagesz,
+                          int os) {
   long i, rc;
   unsigned size;
   struct ElfEhdr *e;
@@ -849,12 +850,17 @@ static const char *TryElf(struct ApeLoader *M, union ElfEhdrBuf *ebuf,
     Pexit(os, exe, 0, "too many ELF program headers");
   }
 
-  /* read program headers */
-  rc = Pread(fd, M->phdr.buf, size, e->e_phoff, os);
-  if (rc < 0)
-    return "failed to read ELF program headers";
-  if (rc != size)
-    return "truncated read of ELF program headers";
+  /* read program headers, unless our first read got them already,
+     since file bytes [lo,hi) are still in ebuf at the same offset */
+  if (lo <= e->e_phoff && e->e_phoff <= hi && size <= hi - e->e_phoff) {
+    MemMove(M->phdr.buf, ebuf->buf + e->e_phoff, size);
+  } else {
+    rc = Pread(fd, M->phdr.buf, size, e->e_phoff, os);
+    if (rc < 0)
+      return "failed to read ELF program headers";
+    if (rc != size)
+      return "truncated read of ELF program headers";
+  }
 
   /* bail on recoverable program header errors */
   p = &M->phdr.phdr;
@@ -950,6 +956,7 @@ EXTERN_C __attribute__((__noreturn__)) void ApeLoader(long di, long *sp,
                                                       char dl) {
   int rc, n;
   unsigned i;
+  unsigned long lo;
   const char *ape;
   int c, fd, os, argc;
   struct ApeLoader *M;
@@ -1086,6 +1093,7 @@ EXTERN_C __attribute__((__noreturn__)) void ApeLoader(long di, long *sp,
     Pexit(os, exe, 0, "too small");
   }
   pe = ebuf->buf + rc;
+  lo = 0;
 
   /* ape intended behavior
      1. if ape, will scan shell script for elf printf statements
@@ -1118,10 +1126,11 @@ EXTERN_C __attribute__((__noreturn__)) void ApeLoader(long di, long *sp,
           break;
         }
       }
+      lo = MAX(lo, i); /* decoding clobbered the bytes before this */
       if (i >= sizeof(ebuf->ehdr)) {
-        TryElf(M, ebuf, exe, fd, sp, auxv, pagesz, os);
+        TryElf(M, ebuf, lo, rc, exe, fd, sp, auxv, pagesz, os);
       }
     }
   }
-  Pexit(os, exe, 0, TryElf(M, ebuf, exe, fd, sp, auxv, pagesz, os));
+  Pexit(os, exe, 0, TryElf(M, ebuf, lo, rc, exe, fd, sp, auxv, pagesz, os));
 }
@@ -132,6 +132,21 @@ o/$(MODE)/%.lua.runs: %.lua o/$(MODE)/tool/net/redbean
 o/$(MODE)/%.runs: o/$(MODE)/%
 	@$(COMPILE) -ACHECK -wtT$@ $< $(TESTARGS)
 
+################################################################################
+# BENCHMARKS
+#
+# Programs named *_bench print one json object per BENCHMARK() when the
+# BENCHMARK_JSON environment variable is set. Running `make bench` will
+# collect them into .bench files, which can be compared with a previous
+# run, e.g. one saved from the parent commit:
+#
+#     git checkout HEAD^ && make -j8 bench && cp -r o//test o//benchbase
+#     git checkout - && make -j8 bench
+#     tool/scripts/benchcmp o//benchbase o//test
+
+o/$(MODE)/%.bench: o/$(MODE)/%
+	@BENCHMARK_JSON=1 $< >$@
+
 ################################################################################
 # ELF ZIP FILES
 #
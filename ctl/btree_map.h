@@ -0,0 +1,441 @@
+// -*-mode:c++;indent-tabs-mode:nil;c-basic-offset:4;tab-width:8;coding:utf-8-*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+#ifndef CTL_BTREE_MAP_H_
+#define CTL_BTREE_MAP_H_
+#include "btree_set.h"
+#include "out_of_range.h"
+
+namespace ctl {
+
+namespace __ {
+
+template<typename Key, typename Value>
+struct btree_first
+{
+    static const Key& get(const ctl::pair<const Key, Value>& value) noexcept
+    {
+        return value.first;
+    }
+};
+
+} // namespace __
+
+template<typename Key, typename Value, typename Compare = ctl::less<Key>>
+class btree_map
+{
+    typedef __::btree<ctl::pair<const Key, Value>,
+                      Key,
+                      __::btree_first<Key, Value>,
+                      Compare>
+      tree_type;
+
+    tree_type tree_;
+
+  public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = ctl::pair<const Key, Value>;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using key_compare = Compare;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using iterator = typename tree_type::iterator;
+    using const_iterator = typename tree_type::const_iterator;
+    using reverse_iterator = ctl::reverse_iterator<iterator>;
+    using const_reverse_iterator = ctl::reverse_iterator<const_iterator>;
+
+    class value_compare
+    {
+        friend class btree_map;
+        Compare comp;
+
+        value_compare(Compare c) : comp(c)
+        {
+        }
+
+      public:
+        bool operator()(const value_type& lhs, const value_type& rhs) const
+        {
+            return comp(lhs.first, rhs.first);
+        }
+    };
+
+    btree_map() = default;
+
+    explicit btree_map(const Compare& comp) : tree_(comp)
+    {
+    }
+
+    template<class InputIt>
+    btree_map(InputIt first, InputIt last, const Compare& comp = Compare())
+      : tree_(comp)
+    {
+        insert(first, last);
+    }
+
+    // Builds map from input that's already sorted without duplicates.
+    // This takes linear time and creates nodes that are mostly full.
+    template<class InputIt>
+    btree_map(ctl::sorted_unique_t,
+              InputIt first,
+              InputIt last,
+              const Compare& comp = Compare())
+      : tree_(comp)
+    {
+        for (; first != last; ++first)
+            tree_.append(value_type(*first));
+    }
+
+    btree_map(std::initializer_list<value_type> init,
+              const Compare& comp = Compare())
+      : tree_(comp)
+    {
+        insert(init);
+    }
+
+    btree_map(const btree_map& other) = default;
+    btree_map(btree_map&& other) noexcept = default;
+    btree_map& operator=(const btree_map& other) = default;
+    btree_map& operator=(btree_map&& other) noexcept = default;
+
+    btree_map& operator=(std::initializer_list<value_type> ilist)
+    {
+        clear();
+        insert(ilist);
+        return *this;
+    }
+
+    iterator begin() noexcept
+    {
+        return tree_.begin();
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return tree_.begin();
+    }
+
+    const_iterator cbegin() const noexcept
+    {
+        return tree_.begin();
+    }
+
+    iterator end() noexcept
+    {
+        return tree_.end();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return tree_.end();
+    }
+
+    const_iterator cend() const noexcept
+    {
+        return tree_.end();
+    }
+
+    reverse_iterator rbegin() noexcept
+    {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator crbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+
+    reverse_iterator rend() noexcept
+    {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    const_reverse_iterator crend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    bool empty() const noexcept
+    {
+        return tree_.empty();
+    }
+
+    size_type size() const noexcept
+    {
+        return tree_.size();
+    }
+
+    size_type max_size() const noexcept
+    {
+        return tree_.max_size();
+    }
+
+    void clear() noexcept
+    {
+        tree_.clear();
+    }
+
+    Value& operator[](const Key& key)
+    {
+        return try_emplace(key).first->second;
+    }
+
+    Value& operator[](Key&& key)
+    {
+        return try_emplace(ctl::move(key)).first->second;
+    }
+
+    Value& at(const Key& key)
+    {
+        auto it = find(key);
+        if (it == end())
+            throw ctl::out_of_range();
+        return it->second;
+    }
+
+    const Value& at(const Key& key) const
+    {
+        auto it = find(key);
+        if (it == end())
+            throw ctl::out_of_range();
+        return it->second;
+    }
+
+    ctl::pair<iterator, bool> insert(const value_type& value)
+    {
+        return tree_.insert_unique(value_type(value));
+    }
+
+    ctl::pair<iterator, bool> insert(value_type&& value)
+    {
+        return tree_.insert_unique(ctl::move(value));
+    }
+
+    template<typename P>
+    ctl::pair<iterator, bool> insert(P&& value)
+    {
+        return insert(value_type(ctl::forward<P>(value)));
+    }
+
+    // Inserting at end() in ascending order will append in O(1) moves.
+    iterator insert(const_iterator hint, const value_type& value)
+    {
+        return insert(hint, value_type(value));
+    }
+
+    iterator insert(const_iterator hint, value_type&& value)
+    {
+        if (hint == end() && tree_.goes_last(value))
+            return tree_.append(ctl::move(value));
+        return insert(ctl::move(value)).first;
+    }
+
+    template<typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        for (; first != last; ++first)
+            insert(end(), value_type(*first));
+    }
+
+    void insert(std::initializer_list<value_type> ilist)
+    {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    template<typename M>
+    ctl::pair<iterator, bool> insert_or_assign(const Key& key, M&& obj)
+    {
+        auto res = try_emplace(key, ctl::forward<M>(obj));
+        if (!res.second)
+            res.first->second = ctl::forward<M>(obj);
+        return res;
+    }
+
+    template<typename M>
+    ctl::pair<iterator, bool> insert_or_assign(Key&& key, M&& obj)
+    {
+        auto res = try_emplace(ctl::move(key), ctl::forward<M>(obj));
+        if (!res.second)
+            res.first->second = ctl::forward<M>(obj);
+        return res;
+    }
+
+    // Inserts value constructed from args if key doesn't exist. Unlike
+    // emplace() this won't construct anything if the key is present.
+    template<typename... Args>
+    ctl::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+    {
+        return tree_.try_insert(key, [&]() {
+            return value_type(key, Value(ctl::forward<Args>(args)...));
+        });
+    }
+
+    template<typename... Args>
+    ctl::pair<iterator, bool> try_emplace(Key&& key, Args&&... args)
+    {
+        return tree_.try_insert(key, [&]() {
+            return value_type(ctl::move(key),
+                              Value(ctl::forward<Args>(args)...));
+        });
+    }
+
+    template<typename... Args>
+    ctl::pair<iterator, bool> emplace(Args&&... args)
+    {
+        return insert(value_type(ctl::forward<Args>(args)...));
+    }
+
+    template<typename... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args)
+    {
+        return insert(hint, value_type(ctl::forward<Args>(args)...));
+    }
+
+    iterator erase(const_iterator pos) noexcept
+    {
+        return tree_.erase(pos);
+    }
+
+    iterator erase(iterator pos) noexcept
+    {
+        return tree_.erase(pos);
+    }
+
+    iterator erase(const_iterator first, const_iterator last) noexcept
+    {
+        // erasing invalidates `last` so count how many to remove
+        size_type n = 0;
+        for (auto it = first; it != last; ++it)
+            ++n;
+        iterator res = tree_.to_iterator(first);
+        while (n--)
+            res = erase(res);
+        return res;
+    }
+
+    size_type erase(const Key& key) noexcept
+    {
+        return tree_.erase_key(key);
+    }
+
+    void swap(btree_map& other) noexcept
+    {
+        tree_.swap(other.tree_);
+    }
+
+    iterator find(const Key& key) noexcept
+    {
+        return tree_.find(key);
+    }
+
+    const_iterator find(const Key& key) const noexcept
+    {
+        return mut().find(key);
+    }
+
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator find(const K& key) noexcept
+    {
+        return tree_.find(key);
+    }
+
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    const_iterator find(const K& key) const noexcept
+    {
+        return mut().find(key);
+    }
+
+    size_type count(const Key& key) const noexcept
+    {
+        return find(key) != end();
+    }
+
+    bool contains(const Key& key) const noexcept
+    {
+        return find(key) != end();
+    }
+
+    iterator lower_bound(const Key& key) noexcept
+    {
+        return tree_.lower_bound(key);
+    }
+
+    const_iterator lower_bound(const Key& key) const noexcept
+    {
+        return mut().lower_bound(key);
+    }
+
+    iterator upper_bound(const Key& key) noexcept
+    {
+        return tree_.upper_bound(key);
+    }
+
+    const_iterator upper_bound(const Key& key) const noexcept
+    {
+        return mut().upper_bound(key);
+    }
+
+    ctl::pair<iterator, iterator> equal_range(const Key& key) noexcept
+    {
+        return { lower_bound(key), upper_bound(key) };
+    }
+
+    ctl::pair<const_iterator, const_iterator> equal_range(
+      const Key& key) const noexcept
+    {
+        return { lower_bound(key), upper_bound(key) };
+    }
+
+    key_compare key_comp() const
+    {
+        return tree_.key_comp();
+    }
+
+    value_compare value_comp() const
+    {
+        return value_compare(tree_.key_comp());
+    }
+
+    friend bool operator==(const btree_map& lhs, const btree_map& rhs)
+    {
+        if (lhs.size() != rhs.size())
+            return false;
+        for (auto i = lhs.begin(), j = rhs.begin(); i != lhs.end(); ++i, ++j)
+            if (!(i->first == j->first) || !(i->second == j->second))
+                return false;
+        return true;
+    }
+
+    friend bool operator!=(const btree_map& lhs, const btree_map& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    friend void swap(btree_map& lhs, btree_map& rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+
+  private:
+    tree_type& mut() const noexcept
+    {
+        return const_cast<tree_type&>(tree_);
+    }
+};
+
+} // namespace ctl
+
+#endif // CTL_BTREE_MAP_H_
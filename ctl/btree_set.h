@@ -0,0 +1,1079 @@
+// -*-mode:c++;indent-tabs-mode:nil;c-basic-offset:4;tab-width:8;coding:utf-8-*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+#ifndef CTL_BTREE_SET_H_
+#define CTL_BTREE_SET_H_
+#include "conditional.h"
+#include "enable_if.h"
+#include "initializer_list.h"
+#include "iterator.h"
+#include "less.h"
+#include "new.h"
+#include "pair.h"
+#include "reverse_iterator.h"
+
+namespace ctl {
+
+// Tag for constructing a btree from input that's sorted and unique.
+struct sorted_unique_t
+{
+    explicit sorted_unique_t() = default;
+};
+
+inline constexpr sorted_unique_t sorted_unique{};
+
+namespace __ {
+
+template<typename Key>
+struct btree_identity
+{
+    static const Key& get(const Key& value) noexcept
+    {
+        return value;
+    }
+};
+
+// B-tree in the style of Abseil's btree_set.
+//
+// Each node holds as many values as fit in about 256 bytes, which for
+// small keys is dozens of values per cache-friendly node rather than one
+// value per heap allocated red-black tree node. Searching a node is a
+// binary search over a contiguous array, and iterating is mostly just
+// incrementing an index, which makes range scans much faster.
+//
+// Since values move between nodes as the tree is rebalanced, inserting
+// or erasing invalidates all iterators, pointers and references, other
+// than the iterators returned by these operations.
+template<typename Value, typename Key, typename KeyOf, typename Compare>
+class btree
+{
+    static constexpr size_t kTargetNodeBytes = 256;
+    static constexpr int kNodeValues =
+      (kTargetNodeBytes - 2 * sizeof(void*)) / sizeof(Value) < 3
+        ? 3
+        : (kTargetNodeBytes - 2 * sizeof(void*)) / sizeof(Value);
+    static constexpr int kMinNodeValues = kNodeValues / 2;
+
+    struct node
+    {
+        node* parent;
+        unsigned short position; // index in parent's children
+        unsigned short count;    // number of values
+        bool leaf;
+        alignas(Value) unsigned char slots[kNodeValues * sizeof(Value)];
+        node* children[kNodeValues + 1]; // not allocated for leaf nodes
+
+        Value* value(int i) noexcept
+        {
+            return reinterpret_cast<Value*>(slots) + i;
+        }
+    };
+
+    static constexpr size_t kLeafBytes = __builtin_offsetof(node, children);
+    static constexpr size_t kInternalBytes = sizeof(node);
+
+    // position of an element, or the gap before a node's end
+    struct cursor
+    {
+        node* n;
+        int i;
+    };
+
+  public:
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    template<bool Const>
+    class basic_iterator
+    {
+      public:
+        using iterator_category = ctl::bidirectional_iterator_tag;
+        using value_type = Value;
+        using difference_type = ptrdiff_t;
+        using pointer = typename ctl::conditional<Const, const Value*,
+                                                  Value*>::type;
+        using reference = typename ctl::conditional<Const, const Value&,
+                                                    Value&>::type;
+
+        basic_iterator() noexcept : node_(nullptr), pos_(0)
+        {
+        }
+
+        template<bool C = Const, typename = typename ctl::enable_if<C>::type>
+        basic_iterator(const basic_iterator<false>& other) noexcept
+          : node_(other.node_), pos_(other.pos_)
+        {
+        }
+
+        reference operator*() const noexcept
+        {
+            return *node_->value(pos_);
+        }
+
+        pointer operator->() const noexcept
+        {
+            return node_->value(pos_);
+        }
+
+        basic_iterator& operator++() noexcept
+        {
+            if (!node_->leaf) {
+                node_ = node_->children[pos_ + 1];
+                while (!node_->leaf)
+                    node_ = node_->children[0];
+                pos_ = 0;
+            } else if (++pos_ == node_->count) {
+                normalize();
+            }
+            return *this;
+        }
+
+        basic_iterator& operator--() noexcept
+        {
+            if (!node_->leaf) {
+                node_ = node_->children[pos_];
+                while (!node_->leaf)
+                    node_ = node_->children[node_->count];
+                pos_ = node_->count - 1;
+            } else if (pos_) {
+                --pos_;
+            } else {
+                node* n = node_;
+                while (n->parent && !n->position)
+                    n = n->parent;
+                if (!n->parent)
+                    __builtin_trap(); // decremented begin()
+                node_ = n->parent;
+                pos_ = n->position - 1;
+            }
+            return *this;
+        }
+
+        basic_iterator operator++(int) noexcept
+        {
+            basic_iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        basic_iterator operator--(int) noexcept
+        {
+            basic_iterator tmp = *this;
+            --(*this);
+            return tmp;
+        }
+
+        bool operator==(const basic_iterator& other) const noexcept
+        {
+            return node_ == other.node_ && pos_ == other.pos_;
+        }
+
+        bool operator!=(const basic_iterator& other) const noexcept
+        {
+            return !(*this == other);
+        }
+
+      private:
+        friend class btree;
+        friend class basic_iterator<!Const>;
+        node* node_;
+        int pos_;
+
+        basic_iterator(node* n, int i) noexcept : node_(n), pos_(i)
+        {
+        }
+
+        // moves iterator at the end of a node up to the next value if
+        // there is one, otherwise it becomes end(), i.e. the root's end
+        void normalize() noexcept
+        {
+            node* n = node_;
+            while (n->parent && n->position == n->parent->count)
+                n = n->parent;
+            if (n->parent) {
+                node_ = n->parent;
+                pos_ = n->position;
+            } else {
+                node_ = n;
+                pos_ = n->count;
+            }
+        }
+    };
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    explicit btree(const Compare& comp = Compare()) noexcept
+      : root_(nullptr), size_(0), comp_(comp)
+    {
+    }
+
+    btree(const btree& other)
+      : root_(nullptr), size_(other.size_), comp_(other.comp_)
+    {
+        if (other.root_)
+            root_ = clone(other.root_, nullptr, 0);
+    }
+
+    btree(btree&& other) noexcept
+      : root_(other.root_), size_(other.size_), comp_(other.comp_)
+    {
+        other.root_ = nullptr;
+        other.size_ = 0;
+    }
+
+    ~btree()
+    {
+        clear();
+    }
+
+    btree& operator=(const btree& other)
+    {
+        if (this != &other) {
+            clear();
+            comp_ = other.comp_;
+            if (other.root_)
+                root_ = clone(other.root_, nullptr, 0);
+            size_ = other.size_;
+        }
+        return *this;
+    }
+
+    btree& operator=(btree&& other) noexcept
+    {
+        if (this != &other) {
+            clear();
+            root_ = other.root_;
+            size_ = other.size_;
+            comp_ = other.comp_;
+            other.root_ = nullptr;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    iterator begin() noexcept
+    {
+        if (!root_)
+            return end();
+        node* n = root_;
+        while (!n->leaf)
+            n = n->children[0];
+        return iterator(n, 0);
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return const_cast<btree*>(this)->begin();
+    }
+
+    iterator end() noexcept
+    {
+        return iterator(root_, root_ ? root_->count : 0);
+    }
+
+    iterator to_iterator(const_iterator it) noexcept
+    {
+        return iterator(it.node_, it.pos_);
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_cast<btree*>(this)->end();
+    }
+
+    bool empty() const noexcept
+    {
+        return !size_;
+    }
+
+    size_type size() const noexcept
+    {
+        return size_;
+    }
+
+    size_type max_size() const noexcept
+    {
+        return __PTRDIFF_MAX__ / sizeof(Value);
+    }
+
+    Compare key_comp() const
+    {
+        return comp_;
+    }
+
+    void clear() noexcept
+    {
+        if (root_)
+            destroy(root_);
+        root_ = nullptr;
+        size_ = 0;
+    }
+
+    void swap(btree& other) noexcept
+    {
+        ctl::swap(root_, other.root_);
+        ctl::swap(size_, other.size_);
+        ctl::swap(comp_, other.comp_);
+    }
+
+    template<typename K>
+    iterator find(const K& key) noexcept
+    {
+        for (node* n = root_; n;) {
+            int i = lower(n, key);
+            if (i < n->count && !comp_(key, KeyOf::get(*n->value(i))))
+                return iterator(n, i);
+            if (n->leaf)
+                break;
+            n = n->children[i];
+        }
+        return end();
+    }
+
+    template<typename K>
+    iterator lower_bound(const K& key) noexcept
+    {
+        iterator res = end();
+        for (node* n = root_; n;) {
+            int i = lower(n, key);
+            if (i < n->count)
+                res = iterator(n, i);
+            if (n->leaf)
+                break;
+            n = n->children[i];
+        }
+        return res;
+    }
+
+    template<typename K>
+    iterator upper_bound(const K& key) noexcept
+    {
+        iterator res = end();
+        for (node* n = root_; n;) {
+            int i = upper(n, key);
+            if (i < n->count)
+                res = iterator(n, i);
+            if (n->leaf)
+                break;
+            n = n->children[i];
+        }
+        return res;
+    }
+
+    // Inserts value unless an equivalent key exists.
+    ctl::pair<iterator, bool> insert_unique(Value&& value)
+    {
+        return try_insert(KeyOf::get(value),
+                          [&]() -> Value&& { return ctl::move(value); });
+    }
+
+    // Inserts value returned by make() unless key exists. Nothing gets
+    // constructed if it does, which is useful for try_emplace().
+    template<typename K, typename F>
+    ctl::pair<iterator, bool> try_insert(const K& key, F&& make)
+    {
+        if (!root_) {
+            root_ = new_node(true);
+            ::new (static_cast<void*>(root_->value(0))) Value(make());
+            root_->count = 1;
+            size_ = 1;
+            return { iterator(root_, 0), true };
+        }
+        node* n = root_;
+        int i;
+        for (;;) {
+            i = lower(n, key);
+            if (i < n->count && !comp_(key, KeyOf::get(*n->value(i))))
+                return { iterator(n, i), false };
+            if (n->leaf)
+                break;
+            n = n->children[i];
+        }
+        cursor c = insert_at(n, i, make(), nullptr);
+        ++size_;
+        return { iterator(c.n, c.i), true };
+    }
+
+    // Inserts value after all others, which must compare less than it.
+    // Since nodes are split unevenly when appending, nodes built this way
+    // end up mostly full, rather than being half full.
+    iterator append(Value&& value)
+    {
+        if (!root_)
+            return insert_unique(ctl::move(value)).first;
+        node* n = root_;
+        while (!n->leaf)
+            n = n->children[n->count];
+        cursor c = insert_at(n, n->count, ctl::move(value), nullptr);
+        ++size_;
+        return iterator(c.n, c.i);
+    }
+
+    // Returns true if value belongs after every existing element.
+    bool goes_last(const Value& value) noexcept
+    {
+        if (!root_)
+            return true;
+        node* n = root_;
+        while (!n->leaf)
+            n = n->children[n->count];
+        return comp_(KeyOf::get(*n->value(n->count - 1)), KeyOf::get(value));
+    }
+
+    iterator erase(const_iterator pos) noexcept
+    {
+        node* n = pos.node_;
+        int i = pos.pos_;
+        cursor t;
+        node* leaf;
+        if (n->leaf) {
+            n->value(i)->~Value();
+            for (int j = i + 1; j < n->count; ++j)
+                relocate(n, j - 1, n, j);
+            --n->count;
+            leaf = n;
+            t = { n, i };
+        } else {
+            // replace value with its successor, and erase that from leaf
+            leaf = n->children[i + 1];
+            while (!leaf->leaf)
+                leaf = leaf->children[0];
+            n->value(i)->~Value();
+            relocate(n, i, leaf, 0);
+            for (int j = 1; j < leaf->count; ++j)
+                relocate(leaf, j - 1, leaf, j);
+            --leaf->count;
+            t = { n, i };
+        }
+        --size_;
+        rebalance(leaf, t);
+        if (!root_)
+            return end();
+        iterator res(t.n, t.i);
+        if (t.i == t.n->count)
+            res.normalize();
+        return res;
+    }
+
+    template<typename K>
+    size_type erase_key(const K& key) noexcept
+    {
+        iterator it = find(key);
+        if (it == end())
+            return 0;
+        erase(it);
+        return 1;
+    }
+
+  private:
+    // index of first value not less than key
+    template<typename K>
+    int lower(node* n, const K& key) const noexcept
+    {
+        int lo = 0, hi = n->count;
+        while (lo < hi) {
+            int mid = (lo + hi) >> 1;
+            if (comp_(KeyOf::get(*n->value(mid)), key))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    // index of first value greater than key
+    template<typename K>
+    int upper(node* n, const K& key) const noexcept
+    {
+        int lo = 0, hi = n->count;
+        while (lo < hi) {
+            int mid = (lo + hi) >> 1;
+            if (!comp_(key, KeyOf::get(*n->value(mid))))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    static node* new_node(bool leaf)
+    {
+        node* n = static_cast<node*>(
+          ::operator new(leaf ? kLeafBytes : kInternalBytes));
+        n->parent = nullptr;
+        n->position = 0;
+        n->count = 0;
+        n->leaf = leaf;
+        return n;
+    }
+
+    static void free_node(node* n) noexcept
+    {
+        ::operator delete(n, n->leaf ? kLeafBytes : kInternalBytes);
+    }
+
+    static void destroy(node* n) noexcept
+    {
+        if (!n->leaf)
+            for (int i = 0; i <= n->count; ++i)
+                destroy(n->children[i]);
+        for (int i = 0; i < n->count; ++i)
+            n->value(i)->~Value();
+        free_node(n);
+    }
+
+    static node* clone(node* src, node* parent, int position)
+    {
+        node* n = new_node(src->leaf);
+        n->parent = parent;
+        n->position = position;
+        for (int i = 0; i < src->count; ++i) {
+            ::new (static_cast<void*>(n->value(i))) Value(*src->value(i));
+            n->count = i + 1;
+        }
+        if (!src->leaf)
+            for (int i = 0; i <= src->count; ++i)
+                n->children[i] = clone(src->children[i], n, i);
+        return n;
+    }
+
+    // moves value into uninitialized slot and destroys the moved value
+    static void relocate(node* dst, int di, node* src, int si) noexcept
+    {
+        ::new (static_cast<void*>(dst->value(di)))
+          Value(ctl::move(*src->value(si)));
+        src->value(si)->~Value();
+    }
+
+    static void set_child(node* n, int i, node* child) noexcept
+    {
+        n->children[i] = child;
+        child->parent = n;
+        child->position = i;
+    }
+
+    // inserts value at index i of node that has room, where `right` is
+    // the child that goes to the right of the value for internal nodes
+    static cursor insert_nonfull(node* n, int i, Value&& value, node* right)
+    {
+        for (int j = n->count; j > i; --j)
+            relocate(n, j, n, j - 1);
+        ::new (static_cast<void*>(n->value(i))) Value(ctl::move(value));
+        if (!n->leaf) {
+            for (int j = n->count + 1; j > i + 1; --j)
+                set_child(n, j, n->children[j - 1]);
+            set_child(n, i + 1, right);
+        }
+        ++n->count;
+        return { n, i };
+    }
+
+    cursor insert_at(node* n, int i, Value&& value, node* right)
+    {
+        if (n->count < kNodeValues)
+            return insert_nonfull(n, i, ctl::move(value), right);
+
+        // split full node, biased so that inserting at either end leaves
+        // the node that's not being inserted into completely full
+        int moved;
+        if (i == 0) {
+            moved = kNodeValues - 1;
+        } else if (i == kNodeValues) {
+            moved = 0;
+        } else {
+            moved = kNodeValues / 2;
+        }
+        int kept = kNodeValues - moved - 1;
+        node* sibling = new_node(n->leaf);
+        for (int j = 0; j < moved; ++j)
+            relocate(sibling, j, n, kept + 1 + j);
+        sibling->count = moved;
+        if (!n->leaf)
+            for (int j = 0; j <= moved; ++j)
+                set_child(sibling, j, n->children[kept + 1 + j]);
+        n->count = kept;
+        alignas(Value) unsigned char median_storage[sizeof(Value)];
+        Value* median = reinterpret_cast<Value*>(median_storage);
+        ::new (static_cast<void*>(median)) Value(ctl::move(*n->value(kept)));
+        n->value(kept)->~Value();
+
+        cursor res;
+        if (i <= kept) {
+            res = insert_nonfull(n, i, ctl::move(value), right);
+        } else {
+            res = insert_nonfull(sibling, i - kept - 1, ctl::move(value), right);
+        }
+
+        if (n == root_) {
+            node* root = new_node(false);
+            set_child(root, 0, n);
+            root_ = root;
+            insert_nonfull(root, 0, ctl::move(*median), sibling);
+        } else {
+            insert_at(n->parent, n->position, ctl::move(*median), sibling);
+        }
+        median->~Value();
+        return res;
+    }
+
+    // merges children i and i+1 of p along with the value between them
+    void merge(node* p, int i, cursor& t) noexcept
+    {
+        node* left = p->children[i];
+        node* right = p->children[i + 1];
+        int lc = left->count;
+        int rc = right->count;
+        relocate(left, lc, p, i);
+        for (int j = 0; j < rc; ++j)
+            relocate(left, lc + 1 + j, right, j);
+        if (!left->leaf)
+            for (int j = 0; j <= rc; ++j)
+                set_child(left, lc + 1 + j, right->children[j]);
+        left->count = lc + 1 + rc;
+        for (int j = i + 1; j < p->count; ++j)
+            relocate(p, j - 1, p, j);
+        for (int j = i + 1; j < p->count; ++j)
+            set_child(p, j, p->children[j + 1]);
+        --p->count;
+        free_node(right);
+        if (t.n == right) {
+            t = { left, lc + 1 + t.i };
+        } else if (t.n == p) {
+            if (t.i == i)
+                t = { left, lc };
+            else if (t.i > i)
+                --t.i;
+        }
+    }
+
+    // moves k values from left sibling into n by rotating through parent
+    void borrow_from_left(node* n, int k, cursor& t) noexcept
+    {
+        node* p = n->parent;
+        int pos = n->position;
+        node* left = p->children[pos - 1];
+        int lc = left->count;
+        int nc = n->count;
+        for (int j = nc - 1; j >= 0; --j)
+            relocate(n, j + k, n, j);
+        relocate(n, k - 1, p, pos - 1);
+        for (int j = 0; j < k - 1; ++j)
+            relocate(n, j, left, lc - k + 1 + j);
+        relocate(p, pos - 1, left, lc - k);
+        if (!n->leaf) {
+            for (int j = nc; j >= 0; --j)
+                set_child(n, j + k, n->children[j]);
+            for (int j = 0; j < k; ++j)
+                set_child(n, j, left->children[lc - k + 1 + j]);
+        }
+        left->count = lc - k;
+        n->count = nc + k;
+        if (t.n == n) {
+            t.i += k;
+        } else if (t.n == p && t.i == pos - 1) {
+            t = { n, k - 1 };
+        } else if (t.n == left && t.i >= lc - k) {
+            if (t.i == lc - k)
+                t = { p, pos - 1 };
+            else
+                t = { n, t.i - (lc - k + 1) };
+        }
+    }
+
+    // moves k values from right sibling into n by rotating through parent
+    void borrow_from_right(node* n, int k, cursor& t) noexcept
+    {
+        node* p = n->parent;
+        int pos = n->position;
+        node* right = p->children[pos + 1];
+        int rc = right->count;
+        int nc = n->count;
+        relocate(n, nc, p, pos);
+        for (int j = 0; j < k - 1; ++j)
+            relocate(n, nc + 1 + j, right, j);
+        relocate(p, pos, right, k - 1);
+        for (int j = k; j < rc; ++j)
+            relocate(right, j - k, right, j);
+        if (!n->leaf) {
+            for (int j = 0; j < k; ++j)
+                set_child(n, nc + 1 + j, right->children[j]);
+            for (int j = k; j <= rc; ++j)
+                set_child(right, j - k, right->children[j]);
+        }
+        right->count = rc - k;
+        n->count = nc + k;
+        if (t.n == p && t.i == pos) {
+            t = { n, nc };
+        } else if (t.n == right) {
+            if (t.i < k - 1)
+                t = { n, nc + 1 + t.i };
+            else if (t.i == k - 1)
+                t = { p, pos };
+            else
+                t.i -= k;
+        }
+    }
+
+    // restores invariants after n lost a value, while keeping track of
+    // where the position `t` ends up
+    void rebalance(node* n, cursor& t) noexcept
+    {
+        while (n != root_ && n->count < kMinNodeValues) {
+            node* p = n->parent;
+            int pos = n->position;
+            node* left = pos ? p->children[pos - 1] : nullptr;
+            node* right = pos < p->count ? p->children[pos + 1] : nullptr;
+            if (left && left->count + 1 + n->count <= kNodeValues) {
+                merge(p, pos - 1, t);
+                n = p;
+            } else if (right && n->count + 1 + right->count <= kNodeValues) {
+                merge(p, pos, t);
+                n = p;
+            } else if (left && (!right || left->count >= right->count)) {
+                borrow_from_left(n, (left->count - n->count + 1) / 2, t);
+                break;
+            } else {
+                borrow_from_right(n, (right->count - n->count + 1) / 2, t);
+                break;
+            }
+        }
+        if (!root_->count) {
+            node* old = root_;
+            if (root_->leaf) {
+                root_ = nullptr;
+                t = { nullptr, 0 };
+            } else {
+                root_ = root_->children[0];
+                root_->parent = nullptr;
+                root_->position = 0;
+                if (t.n == old)
+                    t = { root_, root_->count };
+            }
+            free_node(old);
+        }
+    }
+
+    node* root_;
+    size_type size_;
+    Compare comp_;
+};
+
+} // namespace __
+
+template<typename Key, typename Compare = ctl::less<Key>>
+class btree_set
+{
+    typedef __::btree<Key, Key, __::btree_identity<Key>, Compare> tree_type;
+
+    tree_type tree_;
+
+  public:
+    using key_type = Key;
+    using value_type = Key;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using key_compare = Compare;
+    using value_compare = Compare;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using iterator = typename tree_type::const_iterator;
+    using const_iterator = typename tree_type::const_iterator;
+    using reverse_iterator = ctl::reverse_iterator<iterator>;
+    using const_reverse_iterator = ctl::reverse_iterator<const_iterator>;
+
+    btree_set() = default;
+
+    explicit btree_set(const Compare& comp) : tree_(comp)
+    {
+    }
+
+    template<class InputIt>
+    btree_set(InputIt first, InputIt last, const Compare& comp = Compare())
+      : tree_(comp)
+    {
+        insert(first, last);
+    }
+
+    // Builds set from input that's already sorted without duplicates.
+    // This takes linear time and creates nodes that are mostly full.
+    template<class InputIt>
+    btree_set(ctl::sorted_unique_t,
+              InputIt first,
+              InputIt last,
+              const Compare& comp = Compare())
+      : tree_(comp)
+    {
+        for (; first != last; ++first)
+            tree_.append(value_type(*first));
+    }
+
+    btree_set(std::initializer_list<value_type> init,
+              const Compare& comp = Compare())
+      : tree_(comp)
+    {
+        insert(init);
+    }
+
+    btree_set(const btree_set& other) = default;
+    btree_set(btree_set&& other) noexcept = default;
+    btree_set& operator=(const btree_set& other) = default;
+    btree_set& operator=(btree_set&& other) noexcept = default;
+
+    btree_set& operator=(std::initializer_list<value_type> ilist)
+    {
+        clear();
+        insert(ilist);
+        return *this;
+    }
+
+    iterator begin() const noexcept
+    {
+        return tree_.begin();
+    }
+
+    const_iterator cbegin() const noexcept
+    {
+        return tree_.begin();
+    }
+
+    iterator end() const noexcept
+    {
+        return tree_.end();
+    }
+
+    const_iterator cend() const noexcept
+    {
+        return tree_.end();
+    }
+
+    reverse_iterator rbegin() const noexcept
+    {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator crbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+
+    reverse_iterator rend() const noexcept
+    {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator crend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    bool empty() const noexcept
+    {
+        return tree_.empty();
+    }
+
+    size_type size() const noexcept
+    {
+        return tree_.size();
+    }
+
+    size_type max_size() const noexcept
+    {
+        return tree_.max_size();
+    }
+
+    void clear() noexcept
+    {
+        tree_.clear();
+    }
+
+    ctl::pair<iterator, bool> insert(const value_type& value)
+    {
+        return tree_.insert_unique(value_type(value));
+    }
+
+    ctl::pair<iterator, bool> insert(value_type&& value)
+    {
+        return tree_.insert_unique(ctl::move(value));
+    }
+
+    // Inserting at end() in ascending order will append in O(1) moves.
+    iterator insert(const_iterator hint, const value_type& value)
+    {
+        return insert(hint, value_type(value));
+    }
+
+    iterator insert(const_iterator hint, value_type&& value)
+    {
+        if (hint == end() && tree_.goes_last(value))
+            return tree_.append(ctl::move(value));
+        return insert(ctl::move(value)).first;
+    }
+
+    template<class InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        for (; first != last; ++first)
+            insert(end(), *first);
+    }
+
+    void insert(std::initializer_list<value_type> ilist)
+    {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    template<class... Args>
+    ctl::pair<iterator, bool> emplace(Args&&... args)
+    {
+        return insert(value_type(ctl::forward<Args>(args)...));
+    }
+
+    template<class... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args)
+    {
+        return insert(hint, value_type(ctl::forward<Args>(args)...));
+    }
+
+    iterator erase(const_iterator pos) noexcept
+    {
+        return tree_.erase(pos);
+    }
+
+    iterator erase(const_iterator first, const_iterator last) noexcept
+    {
+        // erasing invalidates `last` so count how many to remove
+        size_type n = 0;
+        for (auto it = first; it != last; ++it)
+            ++n;
+        while (n--)
+            first = erase(first);
+        return first;
+    }
+
+    size_type erase(const key_type& key) noexcept
+    {
+        return tree_.erase_key(key);
+    }
+
+    void swap(btree_set& other) noexcept
+    {
+        tree_.swap(other.tree_);
+    }
+
+    iterator find(const key_type& key) const noexcept
+    {
+        return mut().find(key);
+    }
+
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator find(const K& key) const noexcept
+    {
+        return mut().find(key);
+    }
+
+    size_type count(const key_type& key) const noexcept
+    {
+        return find(key) != end();
+    }
+
+    bool contains(const key_type& key) const noexcept
+    {
+        return find(key) != end();
+    }
+
+    iterator lower_bound(const key_type& key) const noexcept
+    {
+        return mut().lower_bound(key);
+    }
+
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator lower_bound(const K& key) const noexcept
+    {
+        return mut().lower_bound(key);
+    }
+
+    iterator upper_bound(const key_type& key) const noexcept
+    {
+        return mut().upper_bound(key);
+    }
+
+    template<typename K, typename C = Compare, typename = typename C::is_transparent>
+    iterator upper_bound(const K& key) const noexcept
+    {
+        return mut().upper_bound(key);
+    }
+
+    ctl::pair<iterator, iterator> equal_range(const key_type& key) const noexcept
+    {
+        return { lower_bound(key), upper_bound(key) };
+    }
+
+    key_compare key_comp() const
+    {
+        return tree_.key_comp();
+    }
+
+    value_compare value_comp() const
+    {
+        return tree_.key_comp();
+    }
+
+    friend bool operator==(const btree_set& lhs, const btree_set& rhs)
+    {
+        if (lhs.size() != rhs.size())
+            return false;
+        for (auto i = lhs.begin(), j = rhs.begin(); i != lhs.end(); ++i, ++j)
+            if (!(*i == *j))
+                return false;
+        return true;
+    }
+
+    friend bool operator!=(const btree_set& lhs, const btree_set& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    friend bool operator<(const btree_set& lhs, const btree_set& rhs)
+    {
+        auto i = lhs.begin();
+        auto j = rhs.begin();
+        for (; i != lhs.end() && j != rhs.end(); ++i, ++j) {
+            if (lhs.tree_.key_comp()(*i, *j))
+                return true;
+            if (lhs.tree_.key_comp()(*j, *i))
+                return false;
+        }
+        return i == lhs.end() && j != rhs.end();
+    }
+
+    friend bool operator<=(const btree_set& lhs, const btree_set& rhs)
+    {
+        return !(rhs < lhs);
+    }
+
+    friend bool operator>(const btree_set& lhs, const btree_set& rhs)
+    {
+        return rhs < lhs;
+    }
+
+    friend bool operator>=(const btree_set& lhs, const btree_set& rhs)
+    {
+        return !(lhs < rhs);
+    }
+
+    friend void swap(btree_set& lhs, btree_set& rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+
+  private:
+    tree_type& mut() const noexcept
+    {
+        return const_cast<tree_type&>(tree_);
+    }
+};
+
+} // namespace ctl
+
+#endif // CTL_BTREE_SET_H_
@@ -0,0 +1,786 @@
+// -*-mode:c++;indent-tabs-mode:nil;c-basic-offset:4;tab-width:8;coding:utf-8-*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+#ifndef CTL_DEQUE_H_
+#define CTL_DEQUE_H_
+#include "allocator.h"
+#include "allocator_traits.h"
+#include "conditional.h"
+#include "copy.h"
+#include "enable_if.h"
+#include "equal.h"
+#include "initializer_list.h"
+#include "iterator.h"
+#include "lexicographical_compare.h"
+#include "move_backward.h"
+#include "move_iterator.h"
+#include "out_of_range.h"
+#include "require_input_iterator.h"
+#include "reverse_iterator.h"
+
+namespace ctl {
+
+namespace __ {
+
+// Returns number of elements per deque block, which is a power of two
+// so that indexing doesn't need division.
+template<typename T>
+constexpr size_t
+deque_block_size() noexcept
+{
+    size_t n = 16;
+    while (n * sizeof(T) < 512)
+        n <<= 1;
+    return n;
+}
+
+template<typename T, size_t B, bool Const>
+class deque_iterator
+{
+  public:
+    using iterator_category = ctl::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using pointer = ctl::conditional_t<Const, const T*, T*>;
+    using reference = ctl::conditional_t<Const, const T&, T&>;
+
+    deque_iterator() noexcept = default;
+
+    deque_iterator(T* const* map, size_t pos) noexcept : map_(map), pos_(pos)
+    {
+    }
+
+    template<bool C = Const, typename = ctl::enable_if_t<C>>
+    deque_iterator(const deque_iterator<T, B, false>& other) noexcept
+      : map_(other.map_), pos_(other.pos_)
+    {
+    }
+
+    reference operator*() const noexcept
+    {
+        return map_[pos_ / B][pos_ % B];
+    }
+
+    pointer operator->() const noexcept
+    {
+        return &**this;
+    }
+
+    reference operator[](difference_type n) const noexcept
+    {
+        return *(*this + n);
+    }
+
+    deque_iterator& operator++() noexcept
+    {
+        ++pos_;
+        return *this;
+    }
+
+    deque_iterator operator++(int) noexcept
+    {
+        deque_iterator tmp = *this;
+        ++pos_;
+        return tmp;
+    }
+
+    deque_iterator& operator--() noexcept
+    {
+        --pos_;
+        return *this;
+    }
+
+    deque_iterator operator--(int) noexcept
+    {
+        deque_iterator tmp = *this;
+        --pos_;
+        return tmp;
+    }
+
+    deque_iterator& operator+=(difference_type n) noexcept
+    {
+        pos_ += n;
+        return *this;
+    }
+
+    deque_iterator& operator-=(difference_type n) noexcept
+    {
+        pos_ -= n;
+        return *this;
+    }
+
+    friend deque_iterator operator+(deque_iterator it,
+                                    difference_type n) noexcept
+    {
+        return it += n;
+    }
+
+    friend deque_iterator operator+(difference_type n,
+                                    deque_iterator it) noexcept
+    {
+        return it += n;
+    }
+
+    friend deque_iterator operator-(deque_iterator it,
+                                    difference_type n) noexcept
+    {
+        return it -= n;
+    }
+
+    friend difference_type operator-(const deque_iterator& a,
+                                     const deque_iterator& b) noexcept
+    {
+        return a.pos_ - b.pos_;
+    }
+
+    friend bool operator==(const deque_iterator& a,
+                           const deque_iterator& b) noexcept
+    {
+        return a.pos_ == b.pos_;
+    }
+
+    friend bool operator!=(const deque_iterator& a,
+                           const deque_iterator& b) noexcept
+    {
+        return a.pos_ != b.pos_;
+    }
+
+    friend bool operator<(const deque_iterator& a,
+                          const deque_iterator& b) noexcept
+    {
+        return a.pos_ < b.pos_;
+    }
+
+    friend bool operator>(const deque_iterator& a,
+                          const deque_iterator& b) noexcept
+    {
+        return a.pos_ > b.pos_;
+    }
+
+    friend bool operator<=(const deque_iterator& a,
+                           const deque_iterator& b) noexcept
+    {
+        return a.pos_ <= b.pos_;
+    }
+
+    friend bool operator>=(const deque_iterator& a,
+                           const deque_iterator& b) noexcept
+    {
+        return a.pos_ >= b.pos_;
+    }
+
+  private:
+    template<typename, size_t, bool>
+    friend class deque_iterator;
+
+    T* const* map_ = nullptr;
+    size_t pos_ = 0;
+};
+
+} // namespace __
+
+// Double ended queue.
+//
+// Elements are stored in fixed size blocks of about 512 bytes, which
+// are tracked by an array of block pointers (the map) that leaves room
+// on both sides. Pushing or popping at either end is O(1) and doesn't
+// move other elements, so references to them stay valid. One emptied
+// block is kept around, so a deque used as a FIFO won't keep calling
+// the allocator as its contents slide from one block to the next.
+template<typename T, typename Allocator = ctl::allocator<T>>
+class deque
+{
+    static constexpr size_t B = __::deque_block_size<T>();
+
+    using alloc_traits = ctl::allocator_traits<Allocator>;
+    using map_allocator =
+      typename alloc_traits::template rebind_alloc<T*>::other;
+    using map_traits = ctl::allocator_traits<map_allocator>;
+
+  public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using iterator = __::deque_iterator<T, B, false>;
+    using const_iterator = __::deque_iterator<T, B, true>;
+    using reverse_iterator = ctl::reverse_iterator<iterator>;
+    using const_reverse_iterator = ctl::reverse_iterator<const_iterator>;
+
+    deque() noexcept(noexcept(Allocator())) : alloc_(), map_alloc_()
+    {
+    }
+
+    explicit deque(const Allocator& alloc) noexcept
+      : alloc_(alloc), map_alloc_(alloc)
+    {
+    }
+
+    deque(size_type count,
+          const T& value,
+          const Allocator& alloc = Allocator())
+      : alloc_(alloc), map_alloc_(alloc)
+    {
+        resize(count, value);
+    }
+
+    explicit deque(size_type count, const Allocator& alloc = Allocator())
+      : alloc_(alloc), map_alloc_(alloc)
+    {
+        resize(count);
+    }
+
+    template<class InputIt, typename = ctl::require_input_iterator<InputIt>>
+    deque(InputIt first, InputIt last, const Allocator& alloc = Allocator())
+      : alloc_(alloc), map_alloc_(alloc)
+    {
+        assign(first, last);
+    }
+
+    deque(std::initializer_list<T> init, const Allocator& alloc = Allocator())
+      : alloc_(alloc), map_alloc_(alloc)
+    {
+        assign(init.begin(), init.end());
+    }
+
+    deque(const deque& other)
+      : alloc_(alloc_traits::select_on_container_copy_construction(
+          other.alloc_))
+      , map_alloc_(alloc_)
+    {
+        assign(other.begin(), other.end());
+    }
+
+    deque(deque&& other) noexcept
+      : alloc_(ctl::move(other.alloc_)), map_alloc_(alloc_)
+    {
+        steal(other);
+    }
+
+    ~deque()
+    {
+        destroy();
+    }
+
+    deque& operator=(const deque& other)
+    {
+        if (this != &other)
+            assign(other.begin(), other.end());
+        return *this;
+    }
+
+    deque& operator=(deque&& other) noexcept
+    {
+        if (this != &other) {
+            destroy();
+            alloc_ = ctl::move(other.alloc_);
+            map_alloc_ = map_allocator(alloc_);
+            steal(other);
+        }
+        return *this;
+    }
+
+    deque& operator=(std::initializer_list<T> ilist)
+    {
+        assign(ilist.begin(), ilist.end());
+        return *this;
+    }
+
+    void assign(size_type count, const T& value)
+    {
+        clear();
+        resize(count, value);
+    }
+
+    template<class InputIt, typename = ctl::require_input_iterator<InputIt>>
+    void assign(InputIt first, InputIt last)
+    {
+        clear();
+        for (; first != last; ++first)
+            emplace_back(*first);
+    }
+
+    void assign(std::initializer_list<T> ilist)
+    {
+        assign(ilist.begin(), ilist.end());
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return alloc_;
+    }
+
+    reference at(size_type pos)
+    {
+        if (pos >= size_)
+            throw ctl::out_of_range();
+        return (*this)[pos];
+    }
+
+    const_reference at(size_type pos) const
+    {
+        if (pos >= size_)
+            throw ctl::out_of_range();
+        return (*this)[pos];
+    }
+
+    reference operator[](size_type pos) noexcept
+    {
+        return *slot(start_ + pos);
+    }
+
+    const_reference operator[](size_type pos) const noexcept
+    {
+        return *slot(start_ + pos);
+    }
+
+    reference front() noexcept
+    {
+        if (!size_)
+            __builtin_trap();
+        return *slot(start_);
+    }
+
+    const_reference front() const noexcept
+    {
+        if (!size_)
+            __builtin_trap();
+        return *slot(start_);
+    }
+
+    reference back() noexcept
+    {
+        if (!size_)
+            __builtin_trap();
+        return *slot(start_ + size_ - 1);
+    }
+
+    const_reference back() const noexcept
+    {
+        if (!size_)
+            __builtin_trap();
+        return *slot(start_ + size_ - 1);
+    }
+
+    iterator begin() noexcept
+    {
+        return iterator(map_, start_);
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(map_, start_);
+    }
+
+    const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+
+    iterator end() noexcept
+    {
+        return iterator(map_, start_ + size_);
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_iterator(map_, start_ + size_);
+    }
+
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    reverse_iterator rbegin() noexcept
+    {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator crbegin() const noexcept
+    {
+        return rbegin();
+    }
+
+    reverse_iterator rend() noexcept
+    {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    const_reverse_iterator crend() const noexcept
+    {
+        return rend();
+    }
+
+    bool empty() const noexcept
+    {
+        return !size_;
+    }
+
+    size_type size() const noexcept
+    {
+        return size_;
+    }
+
+    size_type max_size() const noexcept
+    {
+        return __PTRDIFF_MAX__ / sizeof(T);
+    }
+
+    // Frees the block that's kept around for reuse.
+    void shrink_to_fit() noexcept
+    {
+        if (spare_) {
+            alloc_traits::deallocate(alloc_, spare_, B);
+            spare_ = nullptr;
+        }
+    }
+
+    void clear() noexcept
+    {
+        while (size_)
+            pop_back();
+        start_ = map_size_ / 2 * B;
+    }
+
+    template<typename... Args>
+    reference emplace_back(Args&&... args)
+    {
+        if (start_ + size_ == map_size_ * B)
+            remap(0, 1);
+        size_t pos = start_ + size_;
+        T* p = claim(pos);
+        alloc_traits::construct(alloc_, p, ctl::forward<Args>(args)...);
+        ++size_;
+        return *p;
+    }
+
+    void push_back(const T& value)
+    {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value)
+    {
+        emplace_back(ctl::move(value));
+    }
+
+    template<typename... Args>
+    reference emplace_front(Args&&... args)
+    {
+        if (!start_)
+            remap(1, 0);
+        size_t pos = start_ - 1;
+        T* p = claim(pos);
+        alloc_traits::construct(alloc_, p, ctl::forward<Args>(args)...);
+        start_ = pos;
+        ++size_;
+        return *p;
+    }
+
+    void push_front(const T& value)
+    {
+        emplace_front(value);
+    }
+
+    void push_front(T&& value)
+    {
+        emplace_front(ctl::move(value));
+    }
+
+    void pop_back() noexcept
+    {
+        if (!size_)
+            __builtin_trap();
+        size_t pos = start_ + --size_;
+        alloc_traits::destroy(alloc_, slot(pos));
+        if (pos % B == 0 || !size_)
+            release(pos / B);
+    }
+
+    void pop_front() noexcept
+    {
+        if (!size_)
+            __builtin_trap();
+        size_t pos = start_++;
+        alloc_traits::destroy(alloc_, slot(pos));
+        if (!--size_ || start_ % B == 0)
+            release(pos / B);
+    }
+
+    template<typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args)
+    {
+        size_t i = pos - cbegin();
+        if (i > size_)
+            __builtin_trap();
+        if (i == 0) {
+            emplace_front(ctl::forward<Args>(args)...);
+        } else if (i == size_) {
+            emplace_back(ctl::forward<Args>(args)...);
+        } else {
+            // construct first in case args refers to one of our elements
+            T tmp(ctl::forward<Args>(args)...);
+            if (i < size_ / 2) {
+                emplace_front(ctl::move(front()));
+                ctl::copy(ctl::make_move_iterator(begin() + 2),
+                          ctl::make_move_iterator(begin() + i + 1),
+                          begin() + 1);
+            } else {
+                emplace_back(ctl::move(back()));
+                ctl::move_backward(begin() + i, end() - 2, end() - 1);
+            }
+            (*this)[i] = ctl::move(tmp);
+        }
+        return begin() + i;
+    }
+
+    iterator insert(const_iterator pos, const T& value)
+    {
+        return emplace(pos, value);
+    }
+
+    iterator insert(const_iterator pos, T&& value)
+    {
+        return emplace(pos, ctl::move(value));
+    }
+
+    iterator insert(const_iterator pos, size_type count, const T& value)
+    {
+        size_t i = pos - cbegin();
+        T tmp(value);
+        for (size_type k = 0; k < count; ++k)
+            emplace(begin() + i, tmp);
+        return begin() + i;
+    }
+
+    template<class InputIt, typename = ctl::require_input_iterator<InputIt>>
+    iterator insert(const_iterator pos, InputIt first, InputIt last)
+    {
+        size_t i = pos - cbegin();
+        for (size_t k = i; first != last; ++first, ++k)
+            emplace(begin() + k, *first);
+        return begin() + i;
+    }
+
+    iterator insert(const_iterator pos, std::initializer_list<T> ilist)
+    {
+        return insert(pos, ilist.begin(), ilist.end());
+    }
+
+    iterator erase(const_iterator pos) noexcept
+    {
+        return erase(pos, pos + 1);
+    }
+
+    // Removes elements, shifting whichever side of them is shorter.
+    iterator erase(const_iterator first, const_iterator last) noexcept
+    {
+        size_t i = first - cbegin();
+        size_t n = last - first;
+        if (i + n > size_)
+            __builtin_trap();
+        if (!n)
+            return begin() + i;
+        if (i < size_ - i - n) {
+            ctl::move_backward(begin(), begin() + i, begin() + i + n);
+            for (size_t k = 0; k < n; ++k)
+                pop_front();
+        } else {
+            ctl::copy(ctl::make_move_iterator(begin() + i + n),
+                      ctl::make_move_iterator(end()),
+                      begin() + i);
+            for (size_t k = 0; k < n; ++k)
+                pop_back();
+        }
+        return begin() + i;
+    }
+
+    void resize(size_type count)
+    {
+        while (size_ > count)
+            pop_back();
+        while (size_ < count)
+            emplace_back();
+    }
+
+    void resize(size_type count, const value_type& value)
+    {
+        while (size_ > count)
+            pop_back();
+        while (size_ < count)
+            emplace_back(value);
+    }
+
+    void swap(deque& other) noexcept
+    {
+        ctl::swap(alloc_, other.alloc_);
+        ctl::swap(map_alloc_, other.map_alloc_);
+        ctl::swap(map_, other.map_);
+        ctl::swap(map_size_, other.map_size_);
+        ctl::swap(start_, other.start_);
+        ctl::swap(size_, other.size_);
+        ctl::swap(spare_, other.spare_);
+    }
+
+    friend void swap(deque& a, deque& b) noexcept
+    {
+        a.swap(b);
+    }
+
+    friend bool operator==(const deque& a, const deque& b)
+    {
+        return a.size() == b.size() &&
+               ctl::equal(a.begin(), a.end(), b.begin());
+    }
+
+    friend bool operator!=(const deque& a, const deque& b)
+    {
+        return !(a == b);
+    }
+
+    friend bool operator<(const deque& a, const deque& b)
+    {
+        return ctl::lexicographical_compare(
+          a.begin(), a.end(), b.begin(), b.end());
+    }
+
+    friend bool operator<=(const deque& a, const deque& b)
+    {
+        return !(b < a);
+    }
+
+    friend bool operator>(const deque& a, const deque& b)
+    {
+        return b < a;
+    }
+
+    friend bool operator>=(const deque& a, const deque& b)
+    {
+        return !(a < b);
+    }
+
+  private:
+    T* slot(size_t pos) const noexcept
+    {
+        return map_[pos / B] + pos % B;
+    }
+
+    // Returns pointer to slot, allocating its block if needed.
+    T* claim(size_t pos)
+    {
+        T*& block = map_[pos / B];
+        if (!block) {
+            if (spare_) {
+                block = spare_;
+                spare_ = nullptr;
+            } else {
+                block = alloc_traits::allocate(alloc_, B);
+            }
+        }
+        return block + pos % B;
+    }
+
+    void release(size_t i) noexcept
+    {
+        T* block = map_[i];
+        map_[i] = nullptr;
+        if (!spare_)
+            spare_ = block;
+        else
+            alloc_traits::deallocate(alloc_, block, B);
+    }
+
+    // Makes room for adding blocks to the front or back of the map.
+    //
+    // If the map is less than half full, the blocks in use are shifted
+    // to its center. Otherwise a map twice as big is allocated.
+    void remap(size_t front, size_t back)
+    {
+        size_t first = start_ / B;
+        size_t last = size_ ? (start_ + size_ - 1) / B + 1 : first;
+        size_t used = last - first;
+        size_t need = used + front + back;
+        T** map = map_;
+        size_t map_size = map_size_;
+        if (need * 2 > map_size_) {
+            map_size = need * 2 > 8 ? need * 2 : 8;
+            map = map_traits::allocate(map_alloc_, map_size);
+            for (size_t i = 0; i < map_size; ++i)
+                map[i] = nullptr;
+        }
+        // blocks left outside the range by a constructor that threw
+        for (size_t i = 0; i < map_size_; ++i)
+            if (map_[i] && (i < first || i >= last))
+                release(i);
+        // when shifting within the same map, pick the direction that
+        // never overwrites a block pointer before it has been moved
+        size_t dest = (map_size - need) / 2 + front;
+        for (size_t k = 0; k < used; ++k) {
+            size_t i = dest < first ? k : used - 1 - k;
+            T* block = map_[first + i];
+            map_[first + i] = nullptr;
+            map[dest + i] = block;
+        }
+        if (map != map_) {
+            if (map_)
+                map_traits::deallocate(map_alloc_, map_, map_size_);
+            map_ = map;
+            map_size_ = map_size;
+        }
+        start_ = dest * B + start_ % B;
+    }
+
+    void steal(deque& other) noexcept
+    {
+        map_ = other.map_;
+        map_size_ = other.map_size_;
+        start_ = other.start_;
+        size_ = other.size_;
+        spare_ = other.spare_;
+        other.map_ = nullptr;
+        other.map_size_ = 0;
+        other.start_ = 0;
+        other.size_ = 0;
+        other.spare_ = nullptr;
+    }
+
+    void destroy() noexcept
+    {
+        clear();
+        shrink_to_fit();
+        if (map_) {
+            for (size_t i = 0; i < map_size_; ++i)
+                if (map_[i])
+                    alloc_traits::deallocate(alloc_, map_[i], B);
+            map_traits::deallocate(map_alloc_, map_, map_size_);
+            map_ = nullptr;
+            map_size_ = 0;
+        }
+    }
+
+    [[no_unique_address]] Allocator alloc_;
+    [[no_unique_address]] map_allocator map_alloc_;
+    T** map_ = nullptr;
+    size_t map_size_ = 0;
+    size_t start_ = 0;
+    size_t size_ = 0;
+    T* spare_ = nullptr;
+};
+
+} // namespace ctl
+
+#endif // CTL_DEQUE_H_
@@ -0,0 +1,69 @@
+// -*-mode:c++;indent-tabs-mode:nil;c-basic-offset:4;tab-width:8;coding:utf-8-*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+#ifndef CTL_EVENTCOUNT_H_
+#define CTL_EVENTCOUNT_H_
+#include "libc/cosmo.h"
+#include "libc/errno.h"
+#include "libc/sysv/consts/clock.h"
+#include "libc/thread/thread.h"
+
+namespace ctl {
+
+// Lets threads sleep until a lock-free data structure changes state.
+//
+// Waiters announce themselves, re-check their condition and only then
+// go to sleep on a futex, so notifying is just a fence and a load when
+// nobody is waiting. This is what the blocking operations of the ctl
+// concurrent queues are built on.
+class eventcount
+{
+  public:
+    eventcount() noexcept = default;
+    eventcount(const eventcount&) = delete;
+    eventcount& operator=(const eventcount&) = delete;
+
+    // Wakes all threads sleeping in await().
+    //
+    // This must be called after the change that waiters are waiting
+    // for has been made visible to them.
+    void notify_all() noexcept
+    {
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&waiters_, __ATOMIC_RELAXED)) {
+            __atomic_fetch_add(&epoch_, 1, __ATOMIC_RELEASE);
+            cosmo_futex_wake(&epoch_, __INT_MAX__, PTHREAD_PROCESS_PRIVATE);
+        }
+    }
+
+    // Blocks until ready() returns true or CLOCK_REALTIME deadline.
+    //
+    // @param abstime may be null to wait forever
+    // @return false if the deadline passed while ready() was false, or
+    //     if the calling thread was cancelled in masked mode
+    template<typename Predicate>
+    bool await(Predicate ready, const struct timespec* abstime = nullptr)
+    {
+        while (!ready()) {
+            __atomic_fetch_add(&waiters_, 1, __ATOMIC_SEQ_CST);
+            int epoch = __atomic_load_n(&epoch_, __ATOMIC_SEQ_CST);
+            if (ready()) {
+                __atomic_fetch_sub(&waiters_, 1, __ATOMIC_RELAXED);
+                return true;
+            }
+            int rc = cosmo_futex_wait(
+              &epoch_, epoch, PTHREAD_PROCESS_PRIVATE, CLOCK_REALTIME, abstime);
+            __atomic_fetch_sub(&waiters_, 1, __ATOMIC_RELAXED);
+            if (rc == -ETIMEDOUT || rc == -ECANCELED)
+                return ready();
+        }
+        return true;
+    }
+
+  private:
+    cosmo_futex_t epoch_ = 0;
+    int waiters_ = 0;
+};
+
+} // namespace ctl
+
+#endif // CTL_EVENTCOUNT_H_
@@ -0,0 +1,405 @@
+// -*-mode:c++;indent-tabs-mode:nil;c-basic-offset:4;tab-width:8;coding:utf-8-*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+#ifndef CTL_FUNCTION_H_
+#define CTL_FUNCTION_H_
+#include "exception.h"
+#include "function_ref.h"
+#include "new.h"
+
+namespace ctl {
+
+class bad_function_call : public exception
+{
+  public:
+    const char* what() const noexcept override
+    {
+        return "ctl::bad_function_call";
+    }
+};
+
+template<typename Signature>
+class function;
+
+template<typename Signature>
+class move_only_function;
+
+namespace __ {
+
+// Callables up to three words get stored inside the function object,
+// which covers function pointers, functor objects, and lambdas
+// that capture a few pointers or references without allocating.
+union function_storage
+{
+    void* heap;
+    void* buf[3];
+};
+
+template<typename R, typename... Args>
+struct function_ops
+{
+    R (*call)(function_storage&, Args&&...);
+    // These are null when a memcpy() of the storage does the same job.
+    void (*relocate)(function_storage&, function_storage&) noexcept;
+    void (*destroy)(function_storage&) noexcept;
+    // Null for move_only_function.
+    void (*copy)(function_storage&, const function_storage&);
+};
+
+template<typename F>
+inline constexpr bool function_is_inline =
+  sizeof(F) <= sizeof(function_storage) &&
+  alignof(F) <= alignof(function_storage) &&
+  __is_nothrow_constructible(F, F&&);
+
+template<typename F, typename R, typename... Args>
+struct function_handler
+{
+    static constexpr bool is_inline = function_is_inline<F>;
+
+    static F* get(function_storage& s) noexcept
+    {
+        if constexpr (is_inline)
+            return __builtin_launder(reinterpret_cast<F*>(s.buf));
+        else
+            return static_cast<F*>(s.heap);
+    }
+
+    static const F* get(const function_storage& s) noexcept
+    {
+        return get(const_cast<function_storage&>(s));
+    }
+
+    template<typename... Ts>
+    static void create(function_storage& s, Ts&&... ts)
+    {
+        if constexpr (is_inline)
+            ::new (static_cast<void*>(s.buf)) F(ctl::forward<Ts>(ts)...);
+        else
+            s.heap = new F(ctl::forward<Ts>(ts)...);
+    }
+
+    static R call(function_storage& s, Args&&... args)
+    {
+        if constexpr (ctl::is_void_v<R>)
+            (*get(s))(ctl::forward<Args>(args)...);
+        else
+            return (*get(s))(ctl::forward<Args>(args)...);
+    }
+
+    static void relocate(function_storage& dst, function_storage& src) noexcept
+    {
+        F* p = get(src);
+        ::new (static_cast<void*>(dst.buf)) F(ctl::move(*p));
+        p->~F();
+    }
+
+    static void destroy(function_storage& s) noexcept
+    {
+        if constexpr (is_inline)
+            get(s)->~F();
+        else
+            delete get(s);
+    }
+
+    static void copy(function_storage& dst, const function_storage& src)
+    {
+        create(dst, *get(src));
+    }
+
+    template<bool Copyable>
+    static constexpr function_ops<R, Args...> make_ops() noexcept
+    {
+        constexpr bool trivial = __is_trivially_copyable(F);
+        function_ops<R, Args...> ops = {};
+        ops.call = &call;
+        if constexpr (is_inline && !trivial)
+            ops.relocate = &relocate;
+        if constexpr (!is_inline || !__has_trivial_destructor(F))
+            ops.destroy = &destroy;
+        if constexpr (Copyable)
+            ops.copy = &copy;
+        return ops;
+    }
+
+    template<bool Copyable>
+    static constexpr function_ops<R, Args...> ops = make_ops<Copyable>();
+};
+
+template<typename F>
+bool
+is_null_callable(const F& f) noexcept
+{
+    if constexpr (is_function_pointer<F>::value)
+        return f == nullptr;
+    else
+        return false;
+}
+
+template<typename S>
+bool
+is_null_callable(const ctl::function<S>& f) noexcept
+{
+    return !f;
+}
+
+template<typename S>
+bool
+is_null_callable(const ctl::move_only_function<S>& f) noexcept
+{
+    return !f;
+}
+
+template<typename R, typename... Args>
+class function_base
+{
+  public:
+    explicit operator bool() const noexcept
+    {
+        return ops_ != nullptr;
+    }
+
+  protected:
+    function_base() noexcept = default;
+
+    ~function_base()
+    {
+        reset();
+    }
+
+    template<bool Copyable, typename F>
+    void assign(F&& f)
+    {
+        using D = ctl::decay_t<F>;
+        if (__::is_null_callable(f))
+            return;
+        function_handler<D, R, Args...>::create(storage_, ctl::forward<F>(f));
+        ops_ = &function_handler<D, R, Args...>::template ops<Copyable>;
+    }
+
+    void copy_from(const function_base& other)
+    {
+        if (other.ops_) {
+            other.ops_->copy(storage_, other.storage_);
+            ops_ = other.ops_;
+        }
+    }
+
+    void move_from(function_base& other) noexcept
+    {
+        if (other.ops_) {
+            if (other.ops_->relocate)
+                other.ops_->relocate(storage_, other.storage_);
+            else
+                __builtin_memcpy(&storage_, &other.storage_, sizeof(storage_));
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+    void reset() noexcept
+    {
+        if (ops_) {
+            if (ops_->destroy)
+                ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    void swap(function_base& other) noexcept
+    {
+        if (this == &other)
+            return;
+        function_base tmp;
+        tmp.move_from(other);
+        other.move_from(*this);
+        move_from(tmp);
+    }
+
+    R invoke(Args&&... args) const
+    {
+        return ops_->call(storage_, ctl::forward<Args>(args)...);
+    }
+
+    mutable function_storage storage_;
+    const function_ops<R, Args...>* ops_ = nullptr;
+};
+
+} // namespace __
+
+// Copyable type erased callable.
+//
+// Functors that are no bigger than three pointers and can be moved
+// without throwing are stored inline, so small lambdas never allocate.
+// Calling an empty function throws ctl::bad_function_call.
+template<typename R, typename... Args>
+class function<R(Args...)> : public __::function_base<R, Args...>
+{
+    using base = __::function_base<R, Args...>;
+
+  public:
+    using result_type = R;
+
+    function() noexcept = default;
+
+    function(nullptr_t) noexcept
+    {
+    }
+
+    function(const function& other)
+    {
+        base::copy_from(other);
+    }
+
+    function(function&& other) noexcept
+    {
+        base::move_from(other);
+    }
+
+    template<typename F>
+        requires(!ctl::is_same_v<ctl::decay_t<F>, function> &&
+                 __::callable_r<ctl::decay_t<F>, R, Args...>)
+    function(F&& f)
+    {
+        base::template assign<true>(ctl::forward<F>(f));
+    }
+
+    function& operator=(const function& other)
+    {
+        if (this != &other)
+            function(other).swap(*this);
+        return *this;
+    }
+
+    function& operator=(function&& other) noexcept
+    {
+        if (this != &other) {
+            base::reset();
+            base::move_from(other);
+        }
+        return *this;
+    }
+
+    function& operator=(nullptr_t) noexcept
+    {
+        base::reset();
+        return *this;
+    }
+
+    template<typename F>
+        requires(!ctl::is_same_v<ctl::decay_t<F>, function> &&
+                 __::callable_r<ctl::decay_t<F>, R, Args...>)
+    function& operator=(F&& f)
+    {
+        function(ctl::forward<F>(f)).swap(*this);
+        return *this;
+    }
+
+    R operator()(Args... args) const
+    {
+        if (!base::ops_)
+            throw ctl::bad_function_call();
+        return base::invoke(ctl::forward<Args>(args)...);
+    }
+
+    void swap(function& other) noexcept
+    {
+        base::swap(other);
+    }
+
+    friend void swap(function& a, function& b) noexcept
+    {
+        a.swap(b);
+    }
+
+    friend bool operator==(const function& f, nullptr_t) noexcept
+    {
+        return !f;
+    }
+};
+
+// Type erased callable that owns functors which can't be copied.
+//
+// This works like ctl::function, except it can hold lambdas capturing
+// things like ctl::unique_ptr. Calling it when empty is undefined, and
+// it traps rather than throwing.
+template<typename R, typename... Args>
+class move_only_function<R(Args...)> : public __::function_base<R, Args...>
+{
+    using base = __::function_base<R, Args...>;
+
+  public:
+    using result_type = R;
+
+    move_only_function() noexcept = default;
+
+    move_only_function(nullptr_t) noexcept
+    {
+    }
+
+    move_only_function(const move_only_function&) = delete;
+
+    move_only_function(move_only_function&& other) noexcept
+    {
+        base::move_from(other);
+    }
+
+    template<typename F>
+        requires(!ctl::is_same_v<ctl::decay_t<F>, move_only_function> &&
+                 __::callable_r<ctl::decay_t<F>, R, Args...>)
+    move_only_function(F&& f)
+    {
+        base::template assign<false>(ctl::forward<F>(f));
+    }
+
+    move_only_function& operator=(const move_only_function&) = delete;
+
+    move_only_function& operator=(move_only_function&& other) noexcept
+    {
+        if (this != &other) {
+            base::reset();
+            base::move_from(other);
+        }
+        return *this;
+    }
+
+    move_only_function& operator=(nullptr_t) noexcept
+    {
+        base::reset();
+        return *this;
+    }
+
+    template<typename F>
+        requires(!ctl::is_same_v<ctl::decay_t<F>, move_only_function> &&
+                 __::callable_r<ctl::decay_t<F>, R, Args...>)
+    move_only_function& operator=(F&& f)
+    {
+        move_only_function(ctl::forward<F>(f)).swap(*this);
+        return *this;
+    }
+
+    R operator()(Args... args)
+    {
+        if (!base::ops_)
+            __builtin_trap();
+        return base::invoke(ctl::forward<Args>(args)...);
+    }
+
+    void swap(move_only_function& other) noexcept
+    {
+        base::swap(other);
+    }
+
+    friend void swap(move_only_function& a, move_only_function& b) noexcept
+    {
+        a.swap(b);
+    }
+
+    friend bool operator==(const move_only_function& f, nullptr_t) noexcept
+    {
+        return !f;
+    }
+};
+
+} // namespace ctl
+
+#endif // CTL_FUNCTION_H_
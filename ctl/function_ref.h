@@ -0,0 +1,107 @@
+// -*-mode:c++;indent-tabs-mode:nil;c-basic-offset:4;tab-width:8;coding:utf-8-*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+#ifndef CTL_FUNCTION_REF_H_
+#define CTL_FUNCTION_REF_H_
+#include "addressof.h"
+#include "decay.h"
+#include "integral_constant.h"
+#include "is_same.h"
+#include "is_void.h"
+#include "remove_reference.h"
+#include "utility.h"
+
+namespace ctl {
+
+namespace __ {
+
+template<typename F, typename R, typename... Args>
+concept callable_r = requires(F& f, Args&&... args) {
+    static_cast<R>(f(ctl::forward<Args>(args)...));
+};
+
+template<typename F>
+struct is_function_pointer : ctl::false_type
+{};
+
+template<typename R, typename... Args>
+struct is_function_pointer<R (*)(Args...)> : ctl::true_type
+{};
+
+template<typename R, typename... Args>
+struct is_function_pointer<R (*)(Args...) noexcept> : ctl::true_type
+{};
+
+} // namespace __
+
+template<typename Signature>
+class function_ref;
+
+// Non-owning reference to a callable object.
+//
+// This is two words, and calling it costs one indirect call, so it's a
+// cheap way to accept callbacks without templates or heap allocations.
+// The referenced object must outlive the function_ref, which makes it
+// best suited to function parameters rather than being stored.
+template<typename R, typename... Args>
+class function_ref<R(Args...)>
+{
+  public:
+    template<typename F>
+        requires(!ctl::is_same_v<ctl::decay_t<F>, function_ref> &&
+                 __::callable_r<ctl::remove_reference_t<F>, R, Args...>)
+    function_ref(F&& f) noexcept
+    {
+        using D = ctl::decay_t<F>;
+        if constexpr (__::is_function_pointer<D>::value) {
+            bound_.fn = reinterpret_cast<void (*)()>(static_cast<D>(f));
+            call_ = &call_function<D>;
+        } else {
+            using T = ctl::remove_reference_t<F>;
+            bound_.obj = const_cast<void*>(
+              static_cast<const volatile void*>(ctl::addressof(f)));
+            call_ = &call_object<T>;
+        }
+    }
+
+    function_ref(const function_ref&) noexcept = default;
+    function_ref& operator=(const function_ref&) noexcept = default;
+
+    R operator()(Args... args) const
+    {
+        return call_(bound_, ctl::forward<Args>(args)...);
+    }
+
+  private:
+    union bound
+    {
+        void* obj;
+        void (*fn)();
+    };
+
+    template<typename T>
+    static R call_object(bound b, Args&&... args)
+    {
+        if constexpr (ctl::is_void_v<R>) {
+            (*static_cast<T*>(b.obj))(ctl::forward<Args>(args)...);
+        } else {
+            return (*static_cast<T*>(b.obj))(ctl::forward<Args>(args)...);
+        }
+    }
+
+    template<typename P>
+    static R call_function(bound b, Args&&... args)
+    {
+        if constexpr (ctl::is_void_v<R>) {
+            reinterpret_cast<P>(b.fn)(ctl::forward<Args>(args)...);
+        } else {
+            return reinterpret_cast<P>(b.fn)(ctl::forward<Args>(args)...);
+        }
+    }
+
+    bound bound_;
+    R (*call_)(bound, Args&&...);
+};
+
+} // namespace ctl
+
+#endif // CTL_FUNCTION_REF_H_
@@ -0,0 +1,137 @@
+// -*-mode:c++;indent-tabs-mode:nil;c-basic-offset:4;tab-width:8;coding:utf-8-*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+#ifndef CTL_HASH_H_
+#define CTL_HASH_H_
+#include "string_view.h"
+
+namespace ctl {
+
+class string;
+
+template<typename T>
+struct hash;
+
+namespace __ {
+
+// Integers hash to themselves like they do in the STL. It's up to the
+// hash table to mix the bits, which ctl::unordered_map does.
+template<typename T>
+struct integral_hash
+{
+    constexpr size_t operator()(T x) const noexcept
+    {
+        return static_cast<size_t>(x);
+    }
+};
+
+} // namespace __
+
+template<>
+struct hash<bool> : __::integral_hash<bool>
+{};
+
+template<>
+struct hash<char> : __::integral_hash<char>
+{};
+
+template<>
+struct hash<signed char> : __::integral_hash<signed char>
+{};
+
+template<>
+struct hash<unsigned char> : __::integral_hash<unsigned char>
+{};
+
+template<>
+struct hash<char16_t> : __::integral_hash<char16_t>
+{};
+
+template<>
+struct hash<char32_t> : __::integral_hash<char32_t>
+{};
+
+template<>
+struct hash<wchar_t> : __::integral_hash<wchar_t>
+{};
+
+template<>
+struct hash<short> : __::integral_hash<short>
+{};
+
+template<>
+struct hash<unsigned short> : __::integral_hash<unsigned short>
+{};
+
+template<>
+struct hash<int> : __::integral_hash<int>
+{};
+
+template<>
+struct hash<unsigned int> : __::integral_hash<unsigned int>
+{};
+
+template<>
+struct hash<long> : __::integral_hash<long>
+{};
+
+template<>
+struct hash<unsigned long> : __::integral_hash<unsigned long>
+{};
+
+template<>
+struct hash<long long> : __::integral_hash<long long>
+{};
+
+template<>
+struct hash<unsigned long long> : __::integral_hash<unsigned long long>
+{};
+
+template<typename T>
+struct hash<T*>
+{
+    size_t operator()(T* p) const noexcept
+    {
+        return reinterpret_cast<uintptr_t>(p);
+    }
+};
+
+template<>
+struct hash<double>
+{
+    size_t operator()(double x) const noexcept
+    {
+        size_t w;
+        x += 0.; // -0. and 0. must hash alike
+        __builtin_memcpy(&w, &x, sizeof(w));
+        return w;
+    }
+};
+
+template<>
+struct hash<float>
+{
+    size_t operator()(float x) const noexcept
+    {
+        return hash<double>()(x);
+    }
+};
+
+// Hashes strings using cosmo_hash(), which is seeded randomly at
+// startup so that remote parties can't predict collisions. Since these
+// accept anything that converts to string_view, it's safe to look up
+// ctl::string keys using a string_view or `const char *` when the key
+// equality function is transparent too, e.g. ctl::equal_to<>.
+template<>
+struct hash<string_view>
+{
+    typedef void is_transparent;
+    size_t operator()(string_view) const noexcept;
+};
+
+template<>
+struct hash<string> : hash<string_view>
+{};
+
+} // namespace ctl
+
+#endif // CTL_HASH_H_
@@ -0,0 +1,26 @@
+// -*-mode:c++;indent-tabs-mode:nil;c-basic-offset:4;tab-width:8;coding:utf-8-*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+#ifndef CTL_IS_TRIVIALLY_RELOCATABLE_H_
+#define CTL_IS_TRIVIALLY_RELOCATABLE_H_
+#include "integral_constant.h"
+
+namespace ctl {
+
+// Tells if moving T then destroying the source is the same as memcpy.
+//
+// This is true of trivially copyable types, but it's also true of most
+// types that own memory through pointers, e.g. ctl::string, as long as
+// they don't point into themselves. Such types may specialize this, so
+// containers can move them around using memcpy() and realloc_in_place().
+template<typename T>
+struct is_trivially_relocatable
+  : public ctl::integral_constant<bool, __is_trivially_copyable(T)>
+{};
+
+template<typename T>
+inline constexpr bool is_trivially_relocatable_v =
+  is_trivially_relocatable<T>::value;
+
+} // namespace ctl
+
+#endif // CTL_IS_TRIVIALLY_RELOCATABLE_H_
@@ -2,12 +2,16 @@
 // vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
 #ifndef CTL_MAP_H_
 #define CTL_MAP_H_
+#include "allocator.h"
 #include "out_of_range.h"
 #include "set.h"
 
 namespace ctl {
 
-template<typename Key, typename Value, typename Compare = ctl::less<Key>>
+template<typename Key,
+         typename Value,
+         typename Compare = ctl::less<Key>,
+         typename Allocator = ctl::allocator<ctl::pair<const Key, Value>>>
 class map
 {
     class EntryCompare
@@ -27,43 +31,53 @@ class map
         Compare comp_;
     };
 
-    ctl::set<ctl::pair<const Key, Value>, EntryCompare> data_;
+    typedef ctl::set<ctl::pair<const Key, Value>, EntryCompare, Allocator>
+      set_type;
+
+    set_type data_;
 
   public:
     using key_type = Key;
     using mapped_type = Value;
     using value_type = ctl::pair<const Key, Value>;
-    using size_type = typename ctl::set<value_type, EntryCompare>::size_type;
-    using difference_type =
-      typename ctl::set<value_type, EntryCompare>::difference_type;
+    using allocator_type = Allocator;
+    using size_type = typename set_type::size_type;
+    using difference_type = typename set_type::difference_type;
     using key_compare = Compare;
     using value_compare = EntryCompare;
-    using iterator = typename ctl::set<value_type, EntryCompare>::iterator;
-    using const_iterator =
-      typename ctl::set<value_type, EntryCompare>::const_iterator;
-    using reverse_iterator =
-      typename ctl::set<value_type, EntryCompare>::reverse_iterator;
-    using const_reverse_iterator =
-      typename ctl::set<value_type, EntryCompare>::const_reverse_iterator;
+    using iterator = typename set_type::iterator;
+    using const_iterator = typename set_type::const_iterator;
+    using reverse_iterator = typename set_type::reverse_iterator;
+    using const_reverse_iterator = typename set_type::const_reverse_iterator;
 
     map() : data_(EntryCompare())
     {
     }
 
-    explicit map(const Compare& comp) : data_(EntryCompare(comp))
+    explicit map(const Compare& comp, const Allocator& alloc = Allocator())
+      : data_(EntryCompare(comp), alloc)
+    {
+    }
+
+    explicit map(const Allocator& alloc) : data_(EntryCompare(), alloc)
     {
     }
 
     map(const map& other) = default;
     map(map&& other) noexcept = default;
-    map(std::initializer_list<value_type> init, const Compare& comp = Compare())
-      : data_(init, EntryCompare(comp))
+    map(std::initializer_list<value_type> init,
+        const Compare& comp = Compare(),
+        const Allocator& alloc = Allocator())
+      : data_(init, EntryCompare(comp), alloc)
     {
     }
 
     template<typename InputIt>
-    map(InputIt first, InputIt last, const Compare& comp = Compare())
-      : data_(first, last, EntryCompare(comp))
+    map(InputIt first,
+        InputIt last,
+        const Compare& comp = Compare(),
+        const Allocator& alloc = Allocator())
+      : data_(first, last, EntryCompare(comp), alloc)
     {
     }
 
@@ -71,10 +85,16 @@ class map
     map& operator=(map&& other) noexcept = default;
     map& operator=(std::initializer_list<value_type> ilist)
     {
-        data_ = ilist;
+        data_.clear();
+        data_.insert(ilist);
         return *this;
     }
 
+    allocator_type get_allocator() const noexcept
+    {
+        return data_.get_allocator();
+    }
+
     iterator begin() noexcept
     {
         return data_.begin();
@@ -348,6 +368,17 @@ class map
     }
 };
 
+namespace pmr {
+
+template<typename Key, typename Value, typename Compare = ctl::less<Key>>
+using map =
+  ctl::map<Key,
+           Value,
+           Compare,
+           polymorphic_allocator<ctl::pair<const Key, Value>>>;
+
+} // namespace pmr
+
 } // namespace ctl
 
 #endif // CTL_MAP_H_
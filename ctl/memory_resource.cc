@@ -0,0 +1,454 @@
+// -*- mode:c++; indent-tabs-mode:nil; c-basic-offset:4; coding:utf-8 -*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+//
+// Copyright 2024 Justine Alexandra Roberts Tunney
+//
+// Permission to use, copy, modify, and/or distribute this software for
+// any purpose with or without fee is hereby granted, provided that the
+// above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+// WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+// AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+// DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+// PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+// TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "memory_resource.h"
+#include "unique_lock.h"
+
+namespace ctl {
+
+namespace pmr {
+
+namespace {
+
+class new_delete_memory_resource : public memory_resource
+{
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        return ::operator new(bytes, ctl::align_val_t(alignment));
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        ::operator delete(p, bytes, ctl::align_val_t(alignment));
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+class null_memory_resource_t : public memory_resource
+{
+    void* do_allocate(size_t, size_t) override
+    {
+        throw ctl::bad_alloc();
+    }
+
+    void do_deallocate(void*, size_t, size_t) override
+    {
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+new_delete_memory_resource g_new_delete;
+null_memory_resource_t g_null;
+memory_resource* g_default;
+
+constexpr size_t kMinBufferSize = 1024;
+constexpr size_t kMinPoolChunkSize = 256;
+constexpr size_t kDefaultLargestBlock = 4096;
+constexpr size_t kDefaultMaxBlocks = 1024;
+constexpr size_t kMaxBlocks = 65536;
+
+inline char*
+align_up(char* p, size_t alignment) noexcept
+{
+    return (char*)(((uintptr_t)p + alignment - 1) & -alignment);
+}
+
+inline size_t
+round_up(size_t n, size_t alignment) noexcept
+{
+    return (n + alignment - 1) & -alignment;
+}
+
+// returns log2 of smallest power of two that's at least n
+inline int
+ceil_log2(size_t n) noexcept
+{
+    return n > 1 ? 64 - __builtin_clzll(n - 1) : 0;
+}
+
+} // namespace
+
+memory_resource::~memory_resource() = default;
+
+memory_resource*
+new_delete_resource() noexcept
+{
+    return &g_new_delete;
+}
+
+memory_resource*
+null_memory_resource() noexcept
+{
+    return &g_null;
+}
+
+memory_resource*
+get_default_resource() noexcept
+{
+    memory_resource* r = __atomic_load_n(&g_default, __ATOMIC_ACQUIRE);
+    return r ? r : &g_new_delete;
+}
+
+memory_resource*
+set_default_resource(memory_resource* r) noexcept
+{
+    memory_resource* old = __atomic_exchange_n(&g_default, r, __ATOMIC_ACQ_REL);
+    return old ? old : &g_new_delete;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// monotonic_buffer_resource
+
+struct monotonic_buffer_resource::chunk
+{
+    chunk* next;
+    size_t bytes;
+};
+
+monotonic_buffer_resource::monotonic_buffer_resource() noexcept
+  : monotonic_buffer_resource(get_default_resource())
+{
+}
+
+monotonic_buffer_resource::monotonic_buffer_resource(
+  memory_resource* upstream) noexcept
+  : monotonic_buffer_resource(kMinBufferSize, upstream)
+{
+}
+
+monotonic_buffer_resource::monotonic_buffer_resource(
+  size_t initial_size,
+  memory_resource* upstream) noexcept
+  : upstream_(upstream)
+  , initial_buffer_(nullptr)
+  , initial_size_(initial_size ? initial_size : kMinBufferSize)
+  , cur_(nullptr)
+  , end_(nullptr)
+  , next_size_(initial_size_)
+  , chunks_(nullptr)
+{
+}
+
+monotonic_buffer_resource::monotonic_buffer_resource(
+  void* buffer,
+  size_t buffer_size,
+  memory_resource* upstream) noexcept
+  : upstream_(upstream)
+  , initial_buffer_(buffer)
+  , initial_size_(buffer_size)
+  , cur_(static_cast<char*>(buffer))
+  , end_(static_cast<char*>(buffer) + buffer_size)
+  , next_size_(buffer_size > kMinBufferSize / 2 ? buffer_size * 2
+                                                : kMinBufferSize)
+  , chunks_(nullptr)
+{
+}
+
+monotonic_buffer_resource::~monotonic_buffer_resource()
+{
+    release();
+}
+
+void
+monotonic_buffer_resource::release() noexcept
+{
+    chunk* next;
+    for (chunk* c = chunks_; c; c = next) {
+        next = c->next;
+        upstream_->deallocate(c, c->bytes, alignof(chunk));
+    }
+    chunks_ = nullptr;
+    if (initial_buffer_) {
+        cur_ = static_cast<char*>(initial_buffer_);
+        end_ = cur_ + initial_size_;
+        next_size_ = initial_size_ > kMinBufferSize / 2 ? initial_size_ * 2
+                                                        : kMinBufferSize;
+    } else {
+        cur_ = nullptr;
+        end_ = nullptr;
+        next_size_ = initial_size_;
+    }
+}
+
+void*
+monotonic_buffer_resource::do_allocate(size_t bytes, size_t alignment)
+{
+    if (cur_) {
+        char* p = align_up(cur_, alignment);
+        if (p <= end_ && bytes <= (size_t)(end_ - p)) {
+            cur_ = p + bytes;
+            return p;
+        }
+    }
+    if (bytes > __SIZE_MAX__ / 4 - alignment)
+        throw ctl::bad_alloc();
+    size_t size = bytes + alignment;
+    if (size < next_size_)
+        size = next_size_;
+    size = round_up(size, alignof(chunk));
+    chunk* c = static_cast<chunk*>(
+      upstream_->allocate(sizeof(chunk) + size, alignof(chunk)));
+    c->next = chunks_;
+    c->bytes = sizeof(chunk) + size;
+    chunks_ = c;
+    cur_ = reinterpret_cast<char*>(c + 1);
+    end_ = cur_ + size;
+    if (size <= __SIZE_MAX__ / 4)
+        next_size_ = size * 2;
+    char* p = align_up(cur_, alignment);
+    cur_ = p + bytes;
+    return p;
+}
+
+void
+monotonic_buffer_resource::do_deallocate(void*, size_t, size_t)
+{
+}
+
+bool
+monotonic_buffer_resource::do_is_equal(
+  const memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// unsynchronized_pool_resource
+
+// footer placed after blocks so blocks are aligned to their size
+struct unsynchronized_pool_resource::chunk
+{
+    chunk* next;
+    size_t bytes;
+};
+
+// header placed before allocations too big for any pool
+struct unsynchronized_pool_resource::large
+{
+    large* prev;
+    large* next;
+    size_t offset;
+    size_t bytes;
+    size_t alignment;
+};
+
+unsynchronized_pool_resource::unsynchronized_pool_resource() noexcept
+  : unsynchronized_pool_resource(pool_options(), get_default_resource())
+{
+}
+
+unsynchronized_pool_resource::unsynchronized_pool_resource(
+  memory_resource* upstream) noexcept
+  : unsynchronized_pool_resource(pool_options(), upstream)
+{
+}
+
+unsynchronized_pool_resource::unsynchronized_pool_resource(
+  const pool_options& opts) noexcept
+  : unsynchronized_pool_resource(opts, get_default_resource())
+{
+}
+
+unsynchronized_pool_resource::unsynchronized_pool_resource(
+  const pool_options& opts,
+  memory_resource* upstream) noexcept
+  : upstream_(upstream), opts_(opts), large_(nullptr)
+{
+    if (!opts_.max_blocks_per_chunk)
+        opts_.max_blocks_per_chunk = kDefaultMaxBlocks;
+    if (opts_.max_blocks_per_chunk > kMaxBlocks)
+        opts_.max_blocks_per_chunk = kMaxBlocks;
+    if (!opts_.largest_required_pool_block)
+        opts_.largest_required_pool_block = kDefaultLargestBlock;
+    if (opts_.largest_required_pool_block > (size_t)1 << kMaxShift)
+        opts_.largest_required_pool_block = (size_t)1 << kMaxShift;
+    opts_.largest_required_pool_block =
+      (size_t)1 << ceil_log2(opts_.largest_required_pool_block);
+    if (opts_.largest_required_pool_block < (size_t)1 << kMinShift)
+        opts_.largest_required_pool_block = (size_t)1 << kMinShift;
+    for (int i = 0; i < kPools; ++i)
+        pools_[i] = { nullptr, nullptr, 0 };
+}
+
+unsynchronized_pool_resource::~unsynchronized_pool_resource()
+{
+    release();
+}
+
+void
+unsynchronized_pool_resource::release() noexcept
+{
+    for (int i = 0; i < kPools; ++i) {
+        size_t size = (size_t)1 << (i + kMinShift);
+        chunk* next;
+        for (chunk* c = pools_[i].chunks; c; c = next) {
+            next = c->next;
+            size_t payload = c->bytes - sizeof(chunk);
+            upstream_->deallocate((char*)c - payload, c->bytes, size);
+        }
+        pools_[i] = { nullptr, nullptr, 0 };
+    }
+    large* next;
+    for (large* b = large_; b; b = next) {
+        next = b->next;
+        upstream_->deallocate(
+          (char*)(b + 1) - b->offset, b->bytes, b->alignment);
+    }
+    large_ = nullptr;
+}
+
+// carves another chunk of blocks for pool i
+void
+unsynchronized_pool_resource::refill(int i)
+{
+    pool& p = pools_[i];
+    size_t size = (size_t)1 << (i + kMinShift);
+    size_t blocks = p.next_blocks;
+    if (!blocks) {
+        blocks = kMinPoolChunkSize / size;
+        if (!blocks)
+            blocks = 1;
+    }
+    if (blocks > opts_.max_blocks_per_chunk)
+        blocks = opts_.max_blocks_per_chunk;
+    size_t payload = blocks * size;
+    size_t bytes = payload + sizeof(chunk);
+    char* base = static_cast<char*>(upstream_->allocate(bytes, size));
+    chunk* c = reinterpret_cast<chunk*>(base + payload);
+    c->next = p.chunks;
+    c->bytes = bytes;
+    p.chunks = c;
+    for (size_t j = blocks; j-- > 0;) {
+        void* block = base + j * size;
+        *static_cast<void**>(block) = p.free;
+        p.free = block;
+    }
+    p.next_blocks = blocks * 2;
+}
+
+void*
+unsynchronized_pool_resource::do_allocate(size_t bytes, size_t alignment)
+{
+    size_t need = bytes > alignment ? bytes : alignment;
+    if (need <= opts_.largest_required_pool_block) {
+        int shift = ceil_log2(need);
+        int i = shift > kMinShift ? shift - kMinShift : 0;
+        pool& p = pools_[i];
+        if (!p.free)
+            refill(i);
+        void* block = p.free;
+        p.free = *static_cast<void**>(block);
+        return block;
+    }
+    // oversized allocations are tracked with a header so release() can
+    // free them, which has the form [padding][large][memory...]
+    if (alignment < alignof(large))
+        alignment = alignof(large);
+    size_t offset = round_up(sizeof(large), alignment);
+    if (bytes > __SIZE_MAX__ - offset)
+        throw ctl::bad_alloc();
+    char* base =
+      static_cast<char*>(upstream_->allocate(offset + bytes, alignment));
+    char* res = base + offset;
+    large* b = reinterpret_cast<large*>(res) - 1;
+    b->offset = offset;
+    b->bytes = offset + bytes;
+    b->alignment = alignment;
+    b->prev = nullptr;
+    b->next = large_;
+    if (large_)
+        large_->prev = b;
+    large_ = b;
+    return res;
+}
+
+void
+unsynchronized_pool_resource::do_deallocate(void* ptr,
+                                            size_t bytes,
+                                            size_t alignment)
+{
+    size_t need = bytes > alignment ? bytes : alignment;
+    if (need <= opts_.largest_required_pool_block) {
+        int shift = ceil_log2(need);
+        int i = shift > kMinShift ? shift - kMinShift : 0;
+        *static_cast<void**>(ptr) = pools_[i].free;
+        pools_[i].free = ptr;
+        return;
+    }
+    large* b = static_cast<large*>(ptr) - 1;
+    if (b->prev)
+        b->prev->next = b->next;
+    else
+        large_ = b->next;
+    if (b->next)
+        b->next->prev = b->prev;
+    upstream_->deallocate(
+      static_cast<char*>(ptr) - b->offset, b->bytes, b->alignment);
+}
+
+bool
+unsynchronized_pool_resource::do_is_equal(
+  const memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// synchronized_pool_resource
+
+void
+synchronized_pool_resource::release() noexcept
+{
+    ctl::unique_lock lock(lock_);
+    pool_.release();
+}
+
+void*
+synchronized_pool_resource::do_allocate(size_t bytes, size_t alignment)
+{
+    ctl::unique_lock lock(lock_);
+    return pool_.allocate(bytes, alignment);
+}
+
+void
+synchronized_pool_resource::do_deallocate(void* p,
+                                          size_t bytes,
+                                          size_t alignment)
+{
+    ctl::unique_lock lock(lock_);
+    pool_.deallocate(p, bytes, alignment);
+}
+
+bool
+synchronized_pool_resource::do_is_equal(
+  const memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+} // namespace pmr
+
+} // namespace ctl
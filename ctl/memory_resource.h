@@ -0,0 +1,333 @@
+// -*-mode:c++;indent-tabs-mode:nil;c-basic-offset:4;tab-width:8;coding:utf-8-*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+#ifndef CTL_MEMORY_RESOURCE_H_
+#define CTL_MEMORY_RESOURCE_H_
+#include "bad_alloc.h"
+#include "mutex.h"
+#include "new.h"
+#include "utility.h"
+
+namespace ctl {
+
+namespace pmr {
+
+class memory_resource
+{
+  public:
+    virtual ~memory_resource();
+
+    [[nodiscard]] void* allocate(size_t bytes,
+                                 size_t alignment = __BIGGEST_ALIGNMENT__)
+    {
+        return do_allocate(bytes, alignment);
+    }
+
+    void deallocate(void* p,
+                    size_t bytes,
+                    size_t alignment = __BIGGEST_ALIGNMENT__)
+    {
+        do_deallocate(p, bytes, alignment);
+    }
+
+    bool is_equal(const memory_resource& other) const noexcept
+    {
+        return do_is_equal(other);
+    }
+
+  private:
+    virtual void* do_allocate(size_t bytes, size_t alignment) = 0;
+    virtual void do_deallocate(void* p, size_t bytes, size_t alignment) = 0;
+    virtual bool do_is_equal(const memory_resource& other) const noexcept = 0;
+};
+
+inline bool
+operator==(const memory_resource& a, const memory_resource& b) noexcept
+{
+    return &a == &b || a.is_equal(b);
+}
+
+inline bool
+operator!=(const memory_resource& a, const memory_resource& b) noexcept
+{
+    return !(a == b);
+}
+
+// Returns resource that uses operator new and operator delete.
+memory_resource*
+new_delete_resource() noexcept;
+
+// Returns resource whose allocate() always throws ctl::bad_alloc.
+memory_resource*
+null_memory_resource() noexcept;
+
+// Returns resource used by default constructed polymorphic allocators.
+memory_resource*
+get_default_resource() noexcept;
+
+// Changes default resource, or restores new_delete_resource() if null.
+memory_resource*
+set_default_resource(memory_resource* r) noexcept;
+
+// Arena that hands out memory by bumping a pointer.
+//
+// Deallocating does nothing. Memory is only freed when release() is
+// called or the resource is destroyed, which makes it a good fit for
+// containers that live as long as some unit of work, e.g. a request.
+// When the current buffer runs out, a buffer that's twice as big gets
+// requested from the upstream resource. This class isn't thread safe.
+class monotonic_buffer_resource : public memory_resource
+{
+  public:
+    monotonic_buffer_resource() noexcept;
+    explicit monotonic_buffer_resource(memory_resource* upstream) noexcept;
+    explicit monotonic_buffer_resource(
+      size_t initial_size,
+      memory_resource* upstream = get_default_resource()) noexcept;
+    monotonic_buffer_resource(
+      void* buffer,
+      size_t buffer_size,
+      memory_resource* upstream = get_default_resource()) noexcept;
+    ~monotonic_buffer_resource() override;
+
+    monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
+    monotonic_buffer_resource& operator=(const monotonic_buffer_resource&) =
+      delete;
+
+    // Frees all memory that was obtained from the upstream resource.
+    void release() noexcept;
+
+    memory_resource* upstream_resource() const noexcept
+    {
+        return upstream_;
+    }
+
+  private:
+    struct chunk;
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const memory_resource& other) const noexcept override;
+
+    memory_resource* upstream_;
+    void* initial_buffer_;
+    size_t initial_size_;
+    char* cur_;
+    char* end_;
+    size_t next_size_;
+    chunk* chunks_;
+};
+
+struct pool_options
+{
+    // Maximum number of blocks requested from upstream at once.
+    size_t max_blocks_per_chunk = 0;
+    // Allocations bigger than this go directly to the upstream resource.
+    size_t largest_required_pool_block = 0;
+};
+
+// Resource that recycles blocks through free lists of fixed sizes.
+//
+// Requests are rounded up to a power of two size class, and each class
+// carves its blocks out of chunks obtained from the upstream resource.
+// Chunks grow geometrically up to pool_options::max_blocks_per_chunk.
+// Memory is returned upstream by release() or the destructor, with the
+// exception of oversized allocations, which are freed individually.
+// This class isn't thread safe; see synchronized_pool_resource.
+class unsynchronized_pool_resource : public memory_resource
+{
+  public:
+    unsynchronized_pool_resource() noexcept;
+    explicit unsynchronized_pool_resource(memory_resource* upstream) noexcept;
+    explicit unsynchronized_pool_resource(const pool_options& opts) noexcept;
+    unsynchronized_pool_resource(const pool_options& opts,
+                                 memory_resource* upstream) noexcept;
+    ~unsynchronized_pool_resource() override;
+
+    unsynchronized_pool_resource(const unsynchronized_pool_resource&) =
+      delete;
+    unsynchronized_pool_resource& operator=(
+      const unsynchronized_pool_resource&) = delete;
+
+    // Frees all memory that was obtained from the upstream resource.
+    void release() noexcept;
+
+    memory_resource* upstream_resource() const noexcept
+    {
+        return upstream_;
+    }
+
+    pool_options options() const noexcept
+    {
+        return opts_;
+    }
+
+  private:
+    static constexpr int kMinShift = 3;
+    static constexpr int kMaxShift = 20;
+    static constexpr int kPools = kMaxShift - kMinShift + 1;
+
+    struct chunk;
+    struct large;
+
+    struct pool
+    {
+        void* free;
+        chunk* chunks;
+        size_t next_blocks;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const memory_resource& other) const noexcept override;
+    void refill(int i);
+
+    memory_resource* upstream_;
+    pool_options opts_;
+    large* large_;
+    pool pools_[kPools];
+};
+
+// Thread safe version of unsynchronized_pool_resource.
+class synchronized_pool_resource : public memory_resource
+{
+  public:
+    synchronized_pool_resource() noexcept = default;
+
+    explicit synchronized_pool_resource(memory_resource* upstream) noexcept
+      : pool_(upstream)
+    {
+    }
+
+    explicit synchronized_pool_resource(const pool_options& opts) noexcept
+      : pool_(opts)
+    {
+    }
+
+    synchronized_pool_resource(const pool_options& opts,
+                               memory_resource* upstream) noexcept
+      : pool_(opts, upstream)
+    {
+    }
+
+    void release() noexcept;
+
+    memory_resource* upstream_resource() const noexcept
+    {
+        return pool_.upstream_resource();
+    }
+
+    pool_options options() const noexcept
+    {
+        return pool_.options();
+    }
+
+  private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const memory_resource& other) const noexcept override;
+
+    ctl::mutex lock_;
+    unsynchronized_pool_resource pool_;
+};
+
+// Allocator that defers to a memory_resource chosen at runtime.
+//
+// This lets containers of the same type draw memory from different
+// places, e.g. ctl::pmr::vector<int> from a monotonic_buffer_resource.
+// Unlike std::pmr, containers in ctl always move their allocator along
+// with the memory they own, and copies inherit the original's resource.
+template<typename T>
+class polymorphic_allocator
+{
+  public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+
+    polymorphic_allocator() noexcept : resource_(get_default_resource())
+    {
+    }
+
+    polymorphic_allocator(memory_resource* r) noexcept : resource_(r)
+    {
+    }
+
+    polymorphic_allocator(const polymorphic_allocator&) noexcept = default;
+
+    template<class U>
+    polymorphic_allocator(const polymorphic_allocator<U>& other) noexcept
+      : resource_(other.resource())
+    {
+    }
+
+    polymorphic_allocator& operator=(const polymorphic_allocator&) = default;
+
+    [[nodiscard]] T* allocate(size_type n)
+    {
+        if (n > __SIZE_MAX__ / sizeof(T))
+            throw ctl::bad_alloc();
+        return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_type n) noexcept
+    {
+        resource_->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    template<typename U, typename... Args>
+    void construct(U* p, Args&&... args)
+    {
+        ::new (static_cast<void*>(p)) U(ctl::forward<Args>(args)...);
+    }
+
+    template<typename U>
+    void destroy(U* p)
+    {
+        p->~U();
+    }
+
+    size_type max_size() const noexcept
+    {
+        return __SIZE_MAX__ / sizeof(T);
+    }
+
+    memory_resource* resource() const noexcept
+    {
+        return resource_;
+    }
+
+    template<typename U>
+    struct rebind
+    {
+        using other = polymorphic_allocator<U>;
+    };
+
+  private:
+    memory_resource* resource_;
+};
+
+template<class T, class U>
+bool
+operator==(const polymorphic_allocator<T>& a,
+           const polymorphic_allocator<U>& b) noexcept
+{
+    return *a.resource() == *b.resource();
+}
+
+template<class T, class U>
+bool
+operator!=(const polymorphic_allocator<T>& a,
+           const polymorphic_allocator<U>& b) noexcept
+{
+    return !(a == b);
+}
+
+} // namespace pmr
+
+} // namespace ctl
+
+#endif // CTL_MEMORY_RESOURCE_H_
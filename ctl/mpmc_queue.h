@@ -0,0 +1,234 @@
+// -*-mode:c++;indent-tabs-mode:nil;c-basic-offset:4;tab-width:8;coding:utf-8-*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+#ifndef CTL_MPMC_QUEUE_H_
+#define CTL_MPMC_QUEUE_H_
+#include "eventcount.h"
+#include "new.h"
+#include "utility.h"
+
+namespace ctl {
+
+// Bounded lock-free queue for any number of producers and consumers.
+//
+// Each cell holds a sequence number ahead of its value. A producer may
+// claim position p once cell p has sequence p, meaning the consumers
+// are done with it, and publishes its value by setting it to p + 1. A
+// consumer claims it when it sees p + 1 and frees it for the next lap
+// by setting p + capacity. Threads only contend on the head and tail
+// counters, which the _n variants advance once per batch of adjacent
+// cells. Values must be nothrow movable, since a claimed cell must be
+// released no matter what.
+template<typename T>
+class mpmc_queue
+{
+    static_assert(__is_nothrow_constructible(T, T&&) &&
+                  __is_nothrow_assignable(T&, T&&));
+    static constexpr size_t kLine = ctl::hardware_destructive_interference_size;
+
+  public:
+    using value_type = T;
+    using size_type = size_t;
+
+    // Creates queue, rounding capacity up to a power of two.
+    explicit mpmc_queue(size_t capacity)
+    {
+        size_t n = 2;
+        while (n < capacity)
+            n <<= 1;
+        mask_ = n - 1;
+        cells_ = static_cast<cell*>(
+          ::operator new(n * sizeof(cell), ctl::align_val_t(kLine)));
+        for (size_t i = 0; i < n; ++i)
+            cells_[i].seq = i;
+    }
+
+    ~mpmc_queue()
+    {
+        for (size_t i = head_; i != tail_; ++i)
+            cells_[i & mask_].value()->~T();
+        ::operator delete(
+          cells_, (mask_ + 1) * sizeof(cell), ctl::align_val_t(kLine));
+    }
+
+    mpmc_queue(const mpmc_queue&) = delete;
+    mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+    size_type capacity() const noexcept
+    {
+        return mask_ + 1;
+    }
+
+    // Returns number of items, counting ones still being pushed/popped.
+    size_type size() const noexcept
+    {
+        size_t head = __atomic_load_n(&head_, __ATOMIC_ACQUIRE);
+        size_t tail = __atomic_load_n(&tail_, __ATOMIC_ACQUIRE);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool empty() const noexcept
+    {
+        return !size();
+    }
+
+    // Adds item if there's room. Any thread may call this.
+    bool try_push(const T& value)
+    {
+        return try_push(T(value));
+    }
+
+    bool try_push(T&& value) noexcept
+    {
+        size_t pos;
+        if (!claim(tail_, 0, 1, pos))
+            return false;
+        cell& c = cells_[pos & mask_];
+        ::new (static_cast<void*>(c.data)) T(ctl::move(value));
+        __atomic_store_n(&c.seq, pos + 1, __ATOMIC_RELEASE);
+        not_empty_.notify_all();
+        return true;
+    }
+
+    // Moves up to n items from first and returns how many were added.
+    template<typename InputIt>
+    size_type try_push_n(InputIt first, size_type n) noexcept
+    {
+        size_t pos;
+        if (!(n = claim(tail_, 0, n, pos)))
+            return 0;
+        static_assert(
+          __is_nothrow_constructible(T, decltype(ctl::move(*first))));
+        for (size_t i = 0; i < n; ++i, ++first) {
+            cell& c = cells_[(pos + i) & mask_];
+            ::new (static_cast<void*>(c.data)) T(ctl::move(*first));
+            __atomic_store_n(&c.seq, pos + i + 1, __ATOMIC_RELEASE);
+        }
+        not_empty_.notify_all();
+        return n;
+    }
+
+    // Adds item, waiting for room as long as it takes or until abstime.
+    //
+    // @return false if the CLOCK_REALTIME deadline abstime passed
+    bool push(T&& value, const struct timespec* abstime = nullptr)
+    {
+        while (!try_push(ctl::move(value)))
+            if (!not_full_.await([this] { return !full(); }, abstime))
+                return false;
+        return true;
+    }
+
+    bool push(const T& value, const struct timespec* abstime = nullptr)
+    {
+        return push(T(value), abstime);
+    }
+
+    // Removes oldest item. Any thread may call this.
+    bool try_pop(T& out) noexcept
+    {
+        return try_pop_n(&out, 1);
+    }
+
+    // Moves up to n of the oldest items to out and returns the count.
+    template<typename OutputIt>
+    size_type try_pop_n(OutputIt out, size_type n) noexcept
+    {
+        size_t pos;
+        if (!(n = claim(head_, 1, n, pos)))
+            return 0;
+        for (size_t i = 0; i < n; ++i, ++out) {
+            cell& c = cells_[(pos + i) & mask_];
+            *out = ctl::move(*c.value());
+            c.value()->~T();
+            __atomic_store_n(&c.seq, pos + i + mask_ + 1, __ATOMIC_RELEASE);
+        }
+        not_full_.notify_all();
+        return n;
+    }
+
+    // Removes oldest item, waiting as long as it takes or until abstime.
+    //
+    // @return false if the CLOCK_REALTIME deadline abstime passed
+    bool pop(T& out, const struct timespec* abstime = nullptr)
+    {
+        while (!try_pop(out))
+            if (!not_empty_.await([this] { return available(head_, 1); },
+                                  abstime))
+                return false;
+        return true;
+    }
+
+  private:
+    struct cell
+    {
+        size_t seq;
+        alignas(T) char data[sizeof(T)];
+
+        T* value() noexcept
+        {
+            return __builtin_launder(reinterpret_cast<T*>(data));
+        }
+    };
+
+    // Returns false if the next cell for the given side is still owned
+    // by the other side, i.e. the queue is full or empty respectively.
+    bool available(const size_t& counter, size_t lag) const noexcept
+    {
+        size_t pos = __atomic_load_n(&counter, __ATOMIC_RELAXED);
+        cell& c = cells_[pos & mask_];
+        size_t seq = __atomic_load_n(&c.seq, __ATOMIC_ACQUIRE);
+        return (ptrdiff_t)(seq - (pos + lag)) >= 0;
+    }
+
+    bool full() const noexcept
+    {
+        return !available(tail_, 0);
+    }
+
+    // Claims up to n adjacent cells whose sequence is position + lag.
+    //
+    // Producers use lag 0 on the tail and consumers use lag 1 on the
+    // head. The first claimed position is stored to pos.
+    size_t claim(size_t& counter, size_t lag, size_t n, size_t& pos) noexcept
+    {
+        pos = __atomic_load_n(&counter, __ATOMIC_RELAXED);
+        for (;;) {
+            size_t k = 0;
+            while (k < n && k <= mask_) {
+                cell& c = cells_[(pos + k) & mask_];
+                size_t seq = __atomic_load_n(&c.seq, __ATOMIC_ACQUIRE);
+                if (seq != pos + k + lag)
+                    break;
+                ++k;
+            }
+            if (!k) {
+                // the cell is either still in use by the other side, or
+                // another thread claimed it after we loaded the counter
+                size_t seq = __atomic_load_n(&cells_[pos & mask_].seq,
+                                             __ATOMIC_ACQUIRE);
+                if ((ptrdiff_t)(seq - (pos + lag)) < 0)
+                    return 0;
+                pos = __atomic_load_n(&counter, __ATOMIC_RELAXED);
+                continue;
+            }
+            if (__atomic_compare_exchange_n(&counter,
+                                            &pos,
+                                            pos + k,
+                                            true,
+                                            __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED))
+                return k;
+        }
+    }
+
+    alignas(kLine) size_t tail_ = 0;
+    alignas(kLine) size_t head_ = 0;
+    alignas(kLine) cell* cells_;
+    size_t mask_;
+    eventcount not_empty_;
+    eventcount not_full_;
+};
+
+} // namespace ctl
+
+#endif // CTL_MPMC_QUEUE_H_
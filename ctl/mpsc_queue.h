@@ -0,0 +1,173 @@
+// -*-mode:c++;indent-tabs-mode:nil;c-basic-offset:4;tab-width:8;coding:utf-8-*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+#ifndef CTL_MPSC_QUEUE_H_
+#define CTL_MPSC_QUEUE_H_
+#include "eventcount.h"
+#include "new.h"
+#include "utility.h"
+
+namespace ctl {
+
+// Unbounded lock-free queue for many producers and a single consumer.
+//
+// Items live in a singly linked list of nodes. A producer swaps itself
+// in as the new tail with one atomic exchange and then links the old
+// tail to it, so pushing never waits on other threads. The consumer
+// owns the head, which is always a node whose value has already been
+// taken. The window between a producer's exchange and its link means a
+// pushed item may briefly be invisible to try_pop(). try_push_n() links
+// a whole chain of nodes with a single exchange.
+template<typename T>
+class mpsc_queue
+{
+    static constexpr size_t kLine = ctl::hardware_destructive_interference_size;
+
+  public:
+    using value_type = T;
+    using size_type = size_t;
+
+    mpsc_queue() : head_(new node(stub())), tail_(head_)
+    {
+    }
+
+    ~mpsc_queue()
+    {
+        node* n = head_;
+        for (node* next; (next = n->next); n = next) {
+            delete n;
+            next->value.~T();
+        }
+        delete n;
+    }
+
+    mpsc_queue(const mpsc_queue&) = delete;
+    mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+    // Returns true if the consumer has nothing to pop.
+    bool empty() const noexcept
+    {
+        return !__atomic_load_n(&head_->next, __ATOMIC_ACQUIRE);
+    }
+
+    // Adds item. Any thread may call this.
+    void push(const T& value)
+    {
+        node* n = new node(value);
+        link(n, n);
+    }
+
+    void push(T&& value)
+    {
+        node* n = new node(ctl::move(value));
+        link(n, n);
+    }
+
+    template<typename... Args>
+    void emplace(Args&&... args)
+    {
+        node* n = new node(ctl::forward<Args>(args)...);
+        link(n, n);
+    }
+
+    // Moves n items from first to the queue, all at once.
+    template<typename InputIt>
+    void push_n(InputIt first, size_type n)
+    {
+        if (!n)
+            return;
+        node* chain = new node(ctl::move(*first));
+        node* last = chain;
+        try {
+            while (--n) {
+                node* next = new node(ctl::move(*++first));
+                last->next = next;
+                last = next;
+            }
+        } catch (...) {
+            while (chain) {
+                node* next = chain->next;
+                chain->value.~T();
+                delete chain;
+                chain = next;
+            }
+            throw;
+        }
+        link(chain, last);
+    }
+
+    // Removes oldest item. Only the consumer may call this.
+    bool try_pop(T& out)
+    {
+        node* next = __atomic_load_n(&head_->next, __ATOMIC_ACQUIRE);
+        if (!next)
+            return false;
+        out = ctl::move(next->value);
+        next->value.~T();
+        delete head_;
+        head_ = next;
+        return true;
+    }
+
+    // Moves up to n of the oldest items to out and returns the count.
+    template<typename OutputIt>
+    size_type try_pop_n(OutputIt out, size_type n)
+    {
+        size_type i = 0;
+        for (; i < n; ++i, ++out)
+            if (!try_pop(*out))
+                break;
+        return i;
+    }
+
+    // Removes oldest item, waiting as long as it takes or until abstime.
+    //
+    // @return false if the CLOCK_REALTIME deadline abstime passed
+    bool pop(T& out, const struct timespec* abstime = nullptr)
+    {
+        while (!try_pop(out))
+            if (!not_empty_.await([this] { return !empty(); }, abstime))
+                return false;
+        return true;
+    }
+
+  private:
+    struct stub
+    {};
+
+    struct node
+    {
+        node* next = nullptr;
+        union
+        {
+            T value;
+        };
+
+        explicit node(stub) noexcept
+        {
+        }
+
+        template<typename... Args>
+        explicit node(Args&&... args) : value(ctl::forward<Args>(args)...)
+        {
+        }
+
+        ~node()
+        {
+        }
+    };
+
+    void link(node* first, node* last) noexcept
+    {
+        node* prev = __atomic_exchange_n(&tail_, last, __ATOMIC_ACQ_REL);
+        __atomic_store_n(&prev->next, first, __ATOMIC_RELEASE);
+        not_empty_.notify_all();
+    }
+
+    alignas(kLine) node* head_;
+    alignas(kLine) node* tail_;
+    alignas(kLine) eventcount not_empty_;
+};
+
+} // namespace ctl
+
+#endif // CTL_MPSC_QUEUE_H_
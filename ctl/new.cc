@@ -149,3 +149,16 @@ __weak_reference(void operator delete[](void*, size_t, ctl::align_val_t)
 
 __weak_reference(void operator delete(void*, void*) noexcept, _ctl_nop);
 __weak_reference(void operator delete[](void*, void*) noexcept, _ctl_nop);
+
+// clang-format on
+
+void*
+ctl::__::resize_in_place(void* p, size_t n) noexcept
+{
+    // memory from a user supplied operator new isn't ours to resize
+    void* (*alloc)(size_t, ctl::align_val_t, const ctl::nothrow_t&) noexcept =
+      ::operator new;
+    if ((void*)alloc != (void*)_ctl_alloc_nothrow)
+        return nullptr;
+    return realloc_in_place(p, n);
+}
@@ -20,6 +20,17 @@ struct nothrow_t
 
 inline constexpr nothrow_t nothrow{};
 
+// Minimum distance between objects written by different threads that
+// avoids false sharing of cache lines.
+inline constexpr size_t hardware_destructive_interference_size = 64;
+
+namespace __ {
+
+// Resizes memory from operator new without moving it, or returns null.
+void* resize_in_place(void*, size_t) noexcept;
+
+} // namespace __
+
 } // namespace ctl
 
 // XXX clang-format currently mutilates these for some reason.
@@ -0,0 +1,90 @@
+// -*-mode:c++;indent-tabs-mode:nil;c-basic-offset:4;tab-width:8;coding:utf-8-*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+#ifndef CTL_PARTIAL_SORT_H_
+#define CTL_PARTIAL_SORT_H_
+#include "iterator_traits.h"
+#include "less.h"
+#include "utility.h"
+
+namespace ctl {
+
+namespace detail {
+
+template<typename RandomIt, typename Compare>
+void
+sift_down(RandomIt first,
+          typename ctl::iterator_traits<RandomIt>::difference_type len,
+          typename ctl::iterator_traits<RandomIt>::difference_type hole,
+          Compare comp)
+{
+    auto value = ctl::move(*(first + hole));
+    for (;;) {
+        auto child = 2 * hole + 1;
+        if (child >= len)
+            break;
+        if (child + 1 < len && comp(*(first + child), *(first + child + 1)))
+            ++child;
+        if (!comp(value, *(first + child)))
+            break;
+        *(first + hole) = ctl::move(*(first + child));
+        hole = child;
+    }
+    *(first + hole) = ctl::move(value);
+}
+
+template<typename RandomIt, typename Compare>
+void
+make_heap(RandomIt first, RandomIt last, Compare comp)
+{
+    auto len = last - first;
+    for (auto i = len / 2; i-- > 0;)
+        sift_down(first, len, i, comp);
+}
+
+template<typename RandomIt, typename Compare>
+void
+sort_heap(RandomIt first, RandomIt last, Compare comp)
+{
+    for (auto len = last - first; len > 1;) {
+        --len;
+        ctl::swap(*first, *(first + len));
+        sift_down(first, len, 0, comp);
+    }
+}
+
+} // namespace detail
+
+// Rearranges elements so [first,middle) holds the smallest elements of
+// [first,last) in sorted order. The order of the remaining elements is
+// unspecified. This is a heap selection taking O(n log m) comparisons.
+template<typename RandomIt, typename Compare>
+void
+partial_sort(RandomIt first, RandomIt middle, RandomIt last, Compare comp)
+{
+    auto len = middle - first;
+    if (!len)
+        return;
+    detail::make_heap(first, middle, comp);
+    for (auto i = middle; i != last; ++i) {
+        if (comp(*i, *first)) {
+            ctl::swap(*i, *first);
+            detail::sift_down(first, len, 0, comp);
+        }
+    }
+    detail::sort_heap(first, middle, comp);
+}
+
+template<typename RandomIt>
+void
+partial_sort(RandomIt first, RandomIt middle, RandomIt last)
+{
+    partial_sort(
+      first,
+      middle,
+      last,
+      ctl::less<typename ctl::iterator_traits<RandomIt>::value_type>());
+}
+
+} // namespace ctl
+
+#endif // CTL_PARTIAL_SORT_H_
@@ -0,0 +1,457 @@
+// -*-mode:c++;indent-tabs-mode:nil;c-basic-offset:4;tab-width:8;coding:utf-8-*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+#ifndef CTL_RING_BUFFER_H_
+#define CTL_RING_BUFFER_H_
+#include "conditional.h"
+#include "enable_if.h"
+#include "initializer_list.h"
+#include "iterator.h"
+#include "new.h"
+#include "out_of_range.h"
+#include "reverse_iterator.h"
+#include "utility.h"
+
+namespace ctl {
+
+namespace __ {
+
+template<typename T, size_t N, bool Const>
+class ring_buffer_iterator
+{
+  public:
+    using iterator_category = ctl::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using pointer = ctl::conditional_t<Const, const T*, T*>;
+    using reference = ctl::conditional_t<Const, const T&, T&>;
+
+    ring_buffer_iterator() noexcept = default;
+
+    ring_buffer_iterator(pointer data, size_t pos) noexcept
+      : data_(data), pos_(pos)
+    {
+    }
+
+    template<bool C = Const, typename = ctl::enable_if_t<C>>
+    ring_buffer_iterator(
+      const ring_buffer_iterator<T, N, false>& other) noexcept
+      : data_(other.data_), pos_(other.pos_)
+    {
+    }
+
+    reference operator*() const noexcept
+    {
+        return data_[pos_ & (N - 1)];
+    }
+
+    pointer operator->() const noexcept
+    {
+        return &**this;
+    }
+
+    reference operator[](difference_type n) const noexcept
+    {
+        return data_[(pos_ + n) & (N - 1)];
+    }
+
+    ring_buffer_iterator& operator++() noexcept
+    {
+        ++pos_;
+        return *this;
+    }
+
+    ring_buffer_iterator operator++(int) noexcept
+    {
+        ring_buffer_iterator tmp = *this;
+        ++pos_;
+        return tmp;
+    }
+
+    ring_buffer_iterator& operator--() noexcept
+    {
+        --pos_;
+        return *this;
+    }
+
+    ring_buffer_iterator operator--(int) noexcept
+    {
+        ring_buffer_iterator tmp = *this;
+        --pos_;
+        return tmp;
+    }
+
+    ring_buffer_iterator& operator+=(difference_type n) noexcept
+    {
+        pos_ += n;
+        return *this;
+    }
+
+    ring_buffer_iterator& operator-=(difference_type n) noexcept
+    {
+        pos_ -= n;
+        return *this;
+    }
+
+    friend ring_buffer_iterator operator+(ring_buffer_iterator it,
+                                          difference_type n) noexcept
+    {
+        return it += n;
+    }
+
+    friend ring_buffer_iterator operator+(difference_type n,
+                                          ring_buffer_iterator it) noexcept
+    {
+        return it += n;
+    }
+
+    friend ring_buffer_iterator operator-(ring_buffer_iterator it,
+                                          difference_type n) noexcept
+    {
+        return it -= n;
+    }
+
+    friend difference_type operator-(const ring_buffer_iterator& a,
+                                     const ring_buffer_iterator& b) noexcept
+    {
+        return a.pos_ - b.pos_;
+    }
+
+    friend bool operator==(const ring_buffer_iterator& a,
+                           const ring_buffer_iterator& b) noexcept
+    {
+        return a.pos_ == b.pos_;
+    }
+
+    friend bool operator!=(const ring_buffer_iterator& a,
+                           const ring_buffer_iterator& b) noexcept
+    {
+        return a.pos_ != b.pos_;
+    }
+
+    friend bool operator<(const ring_buffer_iterator& a,
+                          const ring_buffer_iterator& b) noexcept
+    {
+        return a.pos_ - b.pos_ > (size_t)__PTRDIFF_MAX__;
+    }
+
+    friend bool operator>(const ring_buffer_iterator& a,
+                          const ring_buffer_iterator& b) noexcept
+    {
+        return b < a;
+    }
+
+    friend bool operator<=(const ring_buffer_iterator& a,
+                           const ring_buffer_iterator& b) noexcept
+    {
+        return !(b < a);
+    }
+
+    friend bool operator>=(const ring_buffer_iterator& a,
+                           const ring_buffer_iterator& b) noexcept
+    {
+        return !(a < b);
+    }
+
+  private:
+    template<typename, size_t, bool>
+    friend class ring_buffer_iterator;
+
+    pointer data_ = nullptr;
+    size_t pos_ = 0;
+};
+
+} // namespace __
+
+// Fixed capacity circular queue that never allocates memory.
+//
+// The N elements are stored inline, and N must be a power of two so
+// that wrapping around is a mask rather than a division. Adding items
+// to a full ring_buffer overwrites the ones on the opposite end, which
+// makes it handy for keeping the most recent N events, samples, etc.
+template<typename T, size_t N>
+class ring_buffer
+{
+    static_assert(N && !(N & (N - 1)), "capacity must be a power of two");
+
+  public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using iterator = __::ring_buffer_iterator<T, N, false>;
+    using const_iterator = __::ring_buffer_iterator<T, N, true>;
+    using reverse_iterator = ctl::reverse_iterator<iterator>;
+    using const_reverse_iterator = ctl::reverse_iterator<const_iterator>;
+
+    ring_buffer() noexcept
+    {
+    }
+
+    ring_buffer(std::initializer_list<T> init)
+    {
+        for (const T& value : init)
+            push_back(value);
+    }
+
+    ring_buffer(const ring_buffer& other)
+    {
+        for (const T& value : other)
+            push_back(value);
+    }
+
+    ring_buffer(ring_buffer&& other) noexcept
+    {
+        for (T& value : other)
+            push_back(ctl::move(value));
+        other.clear();
+    }
+
+    ~ring_buffer()
+    {
+        clear();
+    }
+
+    ring_buffer& operator=(const ring_buffer& other)
+    {
+        if (this != &other) {
+            clear();
+            for (const T& value : other)
+                push_back(value);
+        }
+        return *this;
+    }
+
+    ring_buffer& operator=(ring_buffer&& other) noexcept
+    {
+        if (this != &other) {
+            clear();
+            for (T& value : other)
+                push_back(ctl::move(value));
+            other.clear();
+        }
+        return *this;
+    }
+
+    reference at(size_type pos)
+    {
+        if (pos >= size_)
+            throw ctl::out_of_range();
+        return (*this)[pos];
+    }
+
+    const_reference at(size_type pos) const
+    {
+        if (pos >= size_)
+            throw ctl::out_of_range();
+        return (*this)[pos];
+    }
+
+    reference operator[](size_type pos) noexcept
+    {
+        return data_[(head_ + pos) & (N - 1)];
+    }
+
+    const_reference operator[](size_type pos) const noexcept
+    {
+        return data_[(head_ + pos) & (N - 1)];
+    }
+
+    reference front() noexcept
+    {
+        if (!size_)
+            __builtin_trap();
+        return (*this)[0];
+    }
+
+    const_reference front() const noexcept
+    {
+        if (!size_)
+            __builtin_trap();
+        return (*this)[0];
+    }
+
+    reference back() noexcept
+    {
+        if (!size_)
+            __builtin_trap();
+        return (*this)[size_ - 1];
+    }
+
+    const_reference back() const noexcept
+    {
+        if (!size_)
+            __builtin_trap();
+        return (*this)[size_ - 1];
+    }
+
+    iterator begin() noexcept
+    {
+        return iterator(data_, head_);
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(data_, head_);
+    }
+
+    const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+
+    iterator end() noexcept
+    {
+        return iterator(data_, head_ + size_);
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_iterator(data_, head_ + size_);
+    }
+
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    reverse_iterator rbegin() noexcept
+    {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+
+    reverse_iterator rend() noexcept
+    {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    bool empty() const noexcept
+    {
+        return !size_;
+    }
+
+    bool full() const noexcept
+    {
+        return size_ == N;
+    }
+
+    size_type size() const noexcept
+    {
+        return size_;
+    }
+
+    static constexpr size_type capacity() noexcept
+    {
+        return N;
+    }
+
+    static constexpr size_type max_size() noexcept
+    {
+        return N;
+    }
+
+    void clear() noexcept
+    {
+        while (size_)
+            pop_back();
+        head_ = 0;
+    }
+
+    // Appends item, overwriting the front item if full.
+    template<typename... Args>
+    reference emplace_back(Args&&... args)
+    {
+        if (size_ == N)
+            pop_front();
+        T* p = data_ + ((head_ + size_) & (N - 1));
+        ::new (static_cast<void*>(p)) T(ctl::forward<Args>(args)...);
+        ++size_;
+        return *p;
+    }
+
+    void push_back(const T& value)
+    {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value)
+    {
+        emplace_back(ctl::move(value));
+    }
+
+    // Prepends item, overwriting the back item if full.
+    template<typename... Args>
+    reference emplace_front(Args&&... args)
+    {
+        if (size_ == N)
+            pop_back();
+        T* p = data_ + ((head_ - 1) & (N - 1));
+        ::new (static_cast<void*>(p)) T(ctl::forward<Args>(args)...);
+        --head_;
+        ++size_;
+        return *p;
+    }
+
+    void push_front(const T& value)
+    {
+        emplace_front(value);
+    }
+
+    void push_front(T&& value)
+    {
+        emplace_front(ctl::move(value));
+    }
+
+    void pop_front() noexcept
+    {
+        if (!size_)
+            __builtin_trap();
+        data_[head_ & (N - 1)].~T();
+        ++head_;
+        --size_;
+    }
+
+    void pop_back() noexcept
+    {
+        if (!size_)
+            __builtin_trap();
+        --size_;
+        data_[(head_ + size_) & (N - 1)].~T();
+    }
+
+    void swap(ring_buffer& other) noexcept
+    {
+        ring_buffer tmp(ctl::move(other));
+        other = ctl::move(*this);
+        *this = ctl::move(tmp);
+    }
+
+    friend void swap(ring_buffer& a, ring_buffer& b) noexcept
+    {
+        a.swap(b);
+    }
+
+  private:
+    union
+    {
+        T data_[N];
+    };
+    size_t head_ = 0;
+    size_t size_ = 0;
+};
+
+} // namespace ctl
+
+#endif // CTL_RING_BUFFER_H_
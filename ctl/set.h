@@ -2,13 +2,17 @@
 // vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
 #ifndef CTL_SET_H_
 #define CTL_SET_H_
+#include "allocator.h"
+#include "allocator_traits.h"
 #include "initializer_list.h"
 #include "less.h"
 #include "pair.h"
 
 namespace ctl {
 
-template<typename Key, typename Compare = ctl::less<Key>>
+template<typename Key,
+         typename Compare = ctl::less<Key>,
+         typename Allocator = ctl::allocator<Key>>
 class set
 {
     struct rbtree
@@ -45,9 +49,13 @@ class set
         }
     };
 
+    using node_allocator = typename ctl::allocator_traits<
+      Allocator>::template rebind_alloc<rbtree>::other;
+
   public:
     using key_type = Key;
     using value_type = Key;
+    using allocator_type = Allocator;
     using size_type = size_t;
     using node_type = rbtree;
     using key_compare = Compare;
@@ -255,19 +263,33 @@ class set
     {
     }
 
-    explicit set(const Compare& comp) : root_(nullptr), size_(0), comp_(comp)
+    explicit set(const Compare& comp, const Allocator& alloc = Allocator())
+      : alloc_(alloc), root_(nullptr), size_(0), comp_(comp)
+    {
+    }
+
+    explicit set(const Allocator& alloc)
+      : alloc_(alloc), root_(nullptr), size_(0), comp_(Compare())
     {
     }
 
     template<class InputIt>
-    set(InputIt first, InputIt last, const Compare& comp = Compare())
-      : root_(nullptr), size_(0), comp_(comp)
+    set(InputIt first,
+        InputIt last,
+        const Compare& comp = Compare(),
+        const Allocator& alloc = Allocator())
+      : alloc_(alloc), root_(nullptr), size_(0), comp_(comp)
     {
         for (; first != last; ++first)
             insert(*first);
     }
 
-    set(const set& other) : root_(nullptr), size_(0)
+    set(const set& other)
+      : alloc_(ctl::allocator_traits<node_allocator>::
+                 select_on_container_copy_construction(other.alloc_))
+      , root_(nullptr)
+      , size_(0)
+      , comp_(other.comp_)
     {
         if (other.root_) {
             root_ = copier(other.root_);
@@ -275,14 +297,20 @@ class set
         }
     }
 
-    set(set&& other) noexcept : root_(other.root_), size_(other.size_)
+    set(set&& other) noexcept
+      : alloc_(ctl::move(other.alloc_))
+      , root_(other.root_)
+      , size_(other.size_)
+      , comp_(other.comp_)
     {
         other.root_ = nullptr;
         other.size_ = 0;
     }
 
-    set(std::initializer_list<value_type> init, const Compare& comp = Compare())
-      : root_(nullptr), size_(0), comp_(comp)
+    set(std::initializer_list<value_type> init,
+        const Compare& comp = Compare(),
+        const Allocator& alloc = Allocator())
+      : alloc_(alloc), root_(nullptr), size_(0), comp_(comp)
     {
         for (const auto& value : init)
             insert(value);
@@ -309,6 +337,7 @@ class set
     {
         if (this != &other) {
             clear();
+            alloc_ = other.alloc_;
             root_ = other.root_;
             size_ = other.size_;
             other.root_ = nullptr;
@@ -317,6 +346,11 @@ class set
         return *this;
     }
 
+    allocator_type get_allocator() const noexcept
+    {
+        return allocator_type(alloc_);
+    }
+
     bool empty() const noexcept
     {
         return size_ == 0;
@@ -400,12 +434,12 @@ class set
 
     ctl::pair<iterator, bool> insert(value_type&& value)
     {
-        return insert_node(new node_type(ctl::move(value)));
+        return insert_node(create_node(ctl::move(value)));
     }
 
     ctl::pair<iterator, bool> insert(const value_type& value)
     {
-        return insert_node(new node_type(value));
+        return insert_node(create_node(value));
     }
 
     iterator insert(const_iterator hint, const value_type& value)
@@ -464,6 +498,7 @@ class set
 
     void swap(set& other) noexcept
     {
+        ctl::swap(alloc_, other.alloc_);
         ctl::swap(root_, other.root_);
         ctl::swap(size_, other.size_);
     }
@@ -552,21 +587,39 @@ class set
         return node;
     }
 
-    static optimizesize void clearer(node_type* node) noexcept
+    node_type* create_node(const value_type& value)
+    {
+        node_type* node = alloc_.allocate(1);
+        try {
+            ::new (static_cast<void*>(node)) node_type(value);
+        } catch (...) {
+            alloc_.deallocate(node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    void destroy_node(node_type* node) noexcept
+    {
+        node->~node_type();
+        alloc_.deallocate(node, 1);
+    }
+
+    optimizesize void clearer(node_type* node) noexcept
     {
         node_type* right;
         for (; node; node = right) {
             right = node->right;
             clearer(node->left());
-            delete node;
+            destroy_node(node);
         }
     }
 
-    static optimizesize node_type* copier(const node_type* node)
+    optimizesize node_type* copier(const node_type* node)
     {
         if (node == nullptr)
             return nullptr;
-        node_type* new_node = new node_type(node->value);
+        node_type* new_node = create_node(node->value);
         new_node->left(copier(node->left()));
         new_node->right = copier(node->right);
         if (new_node->left())
@@ -648,7 +701,7 @@ class set
             } else if (comp_(current->value, node->value)) {
                 current = current->right;
             } else {
-                delete node; // already exists
+                destroy_node(node); // already exists
                 return { iterator(current), false };
             }
         }
@@ -698,7 +751,7 @@ class set
         }
         if (!y_original_color)
             rebalance_after_erase(x, x_parent);
-        delete node;
+        destroy_node(node);
         --size_;
     }
 
@@ -895,14 +948,16 @@ class set
             node->is_red(false);
     }
 
+    [[no_unique_address]] node_allocator alloc_;
     node_type* root_;
     size_type size_;
     Compare comp_;
 };
 
-template<class Key, typename Compare = ctl::less<Key>>
+template<class Key, typename Compare, typename Allocator>
 bool
-operator==(const set<Key, Compare>& lhs, const set<Key, Compare>& rhs)
+operator==(const set<Key, Compare, Allocator>& lhs,
+           const set<Key, Compare, Allocator>& rhs)
 {
     if (lhs.size() != rhs.size())
         return false;
@@ -915,9 +970,10 @@ operator==(const set<Key, Compare>& lhs, const set<Key, Compare>& rhs)
     return true;
 }
 
-template<class Key, typename Compare = ctl::less<Key>>
+template<class Key, typename Compare, typename Allocator>
 bool
-operator<(const set<Key, Compare>& lhs, const set<Key, Compare>& rhs)
+operator<(const set<Key, Compare, Allocator>& lhs,
+          const set<Key, Compare, Allocator>& rhs)
 {
     auto i = lhs.cbegin();
     auto j = rhs.cbegin();
@@ -930,37 +986,52 @@ operator<(const set<Key, Compare>& lhs, const set<Key, Compare>& rhs)
     return i == lhs.end() && j != rhs.end();
 }
 
-template<class Key, typename Compare = ctl::less<Key>>
+template<class Key, typename Compare, typename Allocator>
 bool
-operator!=(const set<Key, Compare>& lhs, const set<Key, Compare>& rhs)
+operator!=(const set<Key, Compare, Allocator>& lhs,
+           const set<Key, Compare, Allocator>& rhs)
 {
     return !(lhs == rhs);
 }
 
-template<class Key, typename Compare = ctl::less<Key>>
+template<class Key, typename Compare, typename Allocator>
 bool
-operator<=(const set<Key, Compare>& lhs, const set<Key, Compare>& rhs)
+operator<=(const set<Key, Compare, Allocator>& lhs,
+           const set<Key, Compare, Allocator>& rhs)
 {
     return !(rhs < lhs);
 }
 
-template<class Key, typename Compare = ctl::less<Key>>
+template<class Key, typename Compare, typename Allocator>
 bool
-operator>(const set<Key, Compare>& lhs, const set<Key, Compare>& rhs)
+operator>(const set<Key, Compare, Allocator>& lhs,
+          const set<Key, Compare, Allocator>& rhs)
 {
     return rhs < lhs;
 }
 
-template<class Key, typename Compare = ctl::less<Key>>
+template<class Key, typename Compare, typename Allocator>
 bool
-operator>=(const set<Key, Compare>& lhs, const set<Key, Compare>& rhs)
+operator>=(const set<Key, Compare, Allocator>& lhs,
+           const set<Key, Compare, Allocator>& rhs)
 {
     return !(lhs < rhs);
 }
 
-template<class Key, typename Compare = ctl::less<Key>>
+template<class Key, typename Compare, typename Allocator>
 void
-swap(set<Key, Compare>& lhs, set<Key, Compare>& rhs) noexcept;
+swap(set<Key, Compare, Allocator>& lhs,
+     set<Key, Compare, Allocator>& rhs) noexcept;
+
+namespace pmr {
+
+template<typename T>
+class polymorphic_allocator;
+
+template<typename Key, typename Compare = ctl::less<Key>>
+using set = ctl::set<Key, Compare, polymorphic_allocator<Key>>;
+
+} // namespace pmr
 
 } // namespace ctl
 
@@ -14,6 +14,9 @@
 void*
 operator new(size_t, void*) noexcept;
 
+// Nonzero once the process has created a thread.
+extern "C" char __isthreaded;
+
 namespace ctl {
 
 class bad_weak_ptr : public exception
@@ -39,21 +42,32 @@ struct ptr_ref<void>
     using type = void;
 };
 
+// Reference counts are only updated atomically once threads exist,
+// the same way libc elides its own locks. Nothing else can observe a
+// count before the first thread is created, and creating one sets the
+// __isthreaded flag before the new thread starts running.
+
 static inline __attribute__((always_inline)) void
 incref(size_t* r) noexcept
 {
-#ifdef NDEBUG
-    __atomic_fetch_add(r, 1, __ATOMIC_RELAXED);
-#else
-    ssize_t refs = __atomic_fetch_add(r, 1, __ATOMIC_RELAXED);
+    ssize_t refs;
+    if (__builtin_expect(!__isthreaded, 1))
+        refs = (*r)++;
+    else
+        refs = __atomic_fetch_add(r, 1, __ATOMIC_RELAXED);
+#ifndef NDEBUG
     if (refs < 0)
         __builtin_trap();
+#else
+    (void)refs;
 #endif
 }
 
 static inline __attribute__((always_inline)) bool
 decref(size_t* r) noexcept
 {
+    if (__builtin_expect(!__isthreaded, 1))
+        return !(*r)--;
     if (!__atomic_fetch_sub(r, 1, __ATOMIC_RELEASE)) {
         __atomic_thread_fence(__ATOMIC_ACQUIRE);
         return true;
@@ -0,0 +1,591 @@
+// -*-mode:c++;indent-tabs-mode:nil;c-basic-offset:4;tab-width:8;coding:utf-8-*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+#ifndef CTL_SMALL_VECTOR_H_
+#define CTL_SMALL_VECTOR_H_
+#include "allocator.h"
+#include "equal.h"
+#include "initializer_list.h"
+#include "iterator_traits.h"
+#include "lexicographical_compare.h"
+#include "out_of_range.h"
+#include "require_input_iterator.h"
+#include "reverse_iterator.h"
+#include "uninitialized_relocate_n.h"
+
+namespace ctl {
+
+// Vector that stores up to N elements inline before using the heap.
+//
+// This is useful for sequences that are usually short, e.g. the tokens
+// of a parsed line, since no memory gets allocated in the common case.
+// Moving an inline small_vector moves each element, rather than just a
+// pointer, so iterators are invalidated by moves as well as by growth.
+template<typename T, size_t N>
+class small_vector
+{
+    static_assert(N > 0, "small_vector needs inline capacity");
+
+  public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using iterator = pointer;
+    using const_iterator = const_pointer;
+    using reverse_iterator = ctl::reverse_iterator<iterator>;
+    using const_reverse_iterator = ctl::reverse_iterator<const_iterator>;
+
+    static constexpr size_type inline_capacity = N;
+
+    small_vector() noexcept : data_(inline_data()), size_(0), capacity_(N)
+    {
+    }
+
+    small_vector(size_type count, const T& value) : small_vector()
+    {
+        assign(count, value);
+    }
+
+    explicit small_vector(size_type count) : small_vector()
+    {
+        resize(count);
+    }
+
+    template<class InputIt, typename = ctl::require_input_iterator<InputIt>>
+    small_vector(InputIt first, InputIt last) : small_vector()
+    {
+        assign(first, last);
+    }
+
+    small_vector(std::initializer_list<T> init) : small_vector()
+    {
+        assign(init.begin(), init.end());
+    }
+
+    small_vector(const small_vector& other) : small_vector()
+    {
+        assign(other.begin(), other.end());
+    }
+
+    small_vector(small_vector&& other) noexcept : small_vector()
+    {
+        steal(other);
+    }
+
+    ~small_vector()
+    {
+        clear();
+        release();
+    }
+
+    small_vector& operator=(const small_vector& other)
+    {
+        if (this != &other)
+            assign(other.begin(), other.end());
+        return *this;
+    }
+
+    small_vector& operator=(small_vector&& other) noexcept
+    {
+        if (this != &other) {
+            clear();
+            release();
+            data_ = inline_data();
+            capacity_ = N;
+            steal(other);
+        }
+        return *this;
+    }
+
+    small_vector& operator=(std::initializer_list<T> ilist)
+    {
+        assign(ilist.begin(), ilist.end());
+        return *this;
+    }
+
+    void assign(size_type count, const T& value)
+    {
+        if (&value >= data_ && &value < data_ + size_) {
+            T tmp(value);
+            return assign(count, tmp);
+        }
+        clear();
+        reserve(count);
+        for (size_type i = 0; i < count; ++i)
+            ::new (static_cast<void*>(data_ + i)) T(value);
+        size_ = count;
+    }
+
+    template<class InputIt, typename = ctl::require_input_iterator<InputIt>>
+    void assign(InputIt first, InputIt last)
+    {
+        clear();
+        for (; first != last; ++first)
+            emplace_back(*first);
+    }
+
+    void assign(std::initializer_list<T> ilist)
+    {
+        assign(ilist.begin(), ilist.end());
+    }
+
+    reference at(size_type pos)
+    {
+        if (pos >= size_)
+            throw ctl::out_of_range();
+        return data_[pos];
+    }
+
+    const_reference at(size_type pos) const
+    {
+        if (pos >= size_)
+            throw ctl::out_of_range();
+        return data_[pos];
+    }
+
+    reference operator[](size_type pos)
+    {
+        if (pos >= size_)
+            __builtin_trap();
+        return data_[pos];
+    }
+
+    const_reference operator[](size_type pos) const
+    {
+        if (pos >= size_)
+            __builtin_trap();
+        return data_[pos];
+    }
+
+    reference front()
+    {
+        return data_[0];
+    }
+
+    const_reference front() const
+    {
+        return data_[0];
+    }
+
+    reference back()
+    {
+        return data_[size_ - 1];
+    }
+
+    const_reference back() const
+    {
+        return data_[size_ - 1];
+    }
+
+    T* data() noexcept
+    {
+        return data_;
+    }
+
+    const T* data() const noexcept
+    {
+        return data_;
+    }
+
+    iterator begin() noexcept
+    {
+        return data_;
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return data_;
+    }
+
+    const_iterator cbegin() const noexcept
+    {
+        return data_;
+    }
+
+    iterator end() noexcept
+    {
+        return data_ + size_;
+    }
+
+    const_iterator end() const noexcept
+    {
+        return data_ + size_;
+    }
+
+    const_iterator cend() const noexcept
+    {
+        return data_ + size_;
+    }
+
+    reverse_iterator rbegin() noexcept
+    {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator crbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+
+    reverse_iterator rend() noexcept
+    {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    const_reverse_iterator crend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    bool empty() const noexcept
+    {
+        return size_ == 0;
+    }
+
+    size_type size() const noexcept
+    {
+        return size_;
+    }
+
+    size_type max_size() const noexcept
+    {
+        return __PTRDIFF_MAX__ / sizeof(T);
+    }
+
+    size_type capacity() const noexcept
+    {
+        return capacity_;
+    }
+
+    // Returns true if elements are stored inside the object.
+    bool is_inline() const noexcept
+    {
+        return data_ == inline_data();
+    }
+
+    void reserve(size_type new_cap)
+    {
+        if (new_cap > capacity_)
+            reallocate(new_cap);
+    }
+
+    void shrink_to_fit()
+    {
+        if (is_inline() || size_ == capacity_)
+            return;
+        if (size_ <= N) {
+            T* old = data_;
+            size_type old_capacity = capacity_;
+            ctl::uninitialized_relocate_n(old, size_, inline_data());
+            data_ = inline_data();
+            capacity_ = N;
+            ctl::allocator<T>().deallocate(old, old_capacity);
+        } else {
+            reallocate(size_);
+        }
+    }
+
+    void clear() noexcept
+    {
+        for (size_type i = 0; i < size_; ++i)
+            data_[i].~T();
+        size_ = 0;
+    }
+
+    iterator insert(const_iterator pos, const T& value)
+    {
+        return emplace(pos, value);
+    }
+
+    iterator insert(const_iterator pos, T&& value)
+    {
+        return emplace(pos, ctl::move(value));
+    }
+
+    iterator insert(const_iterator pos, size_type count, const T& value)
+    {
+        T tmp(value);
+        size_type index = pos - begin();
+        open(index, count);
+        for (size_type i = 0; i < count; ++i)
+            ::new (static_cast<void*>(data_ + index + i)) T(tmp);
+        return begin() + index;
+    }
+
+    template<class InputIt, typename = ctl::require_input_iterator<InputIt>>
+    iterator insert(const_iterator pos, InputIt first, InputIt last)
+    {
+        size_type index = pos - begin();
+        size_type old_size = size_;
+        for (; first != last; ++first)
+            emplace_back(*first);
+        rotate(index, old_size);
+        return begin() + index;
+    }
+
+    iterator insert(const_iterator pos, std::initializer_list<T> ilist)
+    {
+        return insert(pos, ilist.begin(), ilist.end());
+    }
+
+    template<class... Args>
+    iterator emplace(const_iterator pos, Args&&... args)
+    {
+        size_type index = pos - begin();
+        if (index == size_) {
+            emplace_back(ctl::forward<Args>(args)...);
+        } else {
+            T tmp(ctl::forward<Args>(args)...);
+            open(index, 1);
+            ::new (static_cast<void*>(data_ + index)) T(ctl::move(tmp));
+        }
+        return begin() + index;
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        return erase(pos, pos + 1);
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        size_type index = first - begin();
+        size_type count = last - first;
+        for (size_type i = 0; i < count; ++i)
+            data_[index + i].~T();
+        ctl::uninitialized_relocate_n(data_ + index + count,
+                                      size_ - index - count,
+                                      data_ + index);
+        size_ -= count;
+        return begin() + index;
+    }
+
+    void push_back(const T& value)
+    {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value)
+    {
+        emplace_back(ctl::move(value));
+    }
+
+    template<class... Args>
+    reference emplace_back(Args&&... args)
+    {
+        if (size_ == capacity_) {
+            // args might refer to an element of this vector
+            T tmp(ctl::forward<Args>(args)...);
+            grow(size_ + 1);
+            ::new (static_cast<void*>(data_ + size_)) T(ctl::move(tmp));
+        } else {
+            ::new (static_cast<void*>(data_ + size_))
+              T(ctl::forward<Args>(args)...);
+        }
+        return data_[size_++];
+    }
+
+    void pop_back()
+    {
+        if (!empty())
+            data_[--size_].~T();
+    }
+
+    void resize(size_type count)
+    {
+        if (count > size_) {
+            reserve(count);
+            for (; size_ < count; ++size_)
+                ::new (static_cast<void*>(data_ + size_)) T();
+        } else {
+            while (size_ > count)
+                data_[--size_].~T();
+        }
+    }
+
+    void resize(size_type count, const value_type& value)
+    {
+        if (count > size_) {
+            T tmp(value);
+            reserve(count);
+            for (; size_ < count; ++size_)
+                ::new (static_cast<void*>(data_ + size_)) T(tmp);
+        } else {
+            while (size_ > count)
+                data_[--size_].~T();
+        }
+    }
+
+    void swap(small_vector& other) noexcept
+    {
+        small_vector tmp(ctl::move(other));
+        other = ctl::move(*this);
+        *this = ctl::move(tmp);
+    }
+
+  private:
+    T* inline_data() noexcept
+    {
+        return reinterpret_cast<T*>(buf_);
+    }
+
+    const T* inline_data() const noexcept
+    {
+        return reinterpret_cast<const T*>(buf_);
+    }
+
+    // takes elements of other, which must be a different vector, while
+    // this vector is empty and using its inline storage
+    void steal(small_vector& other) noexcept
+    {
+        if (other.is_inline()) {
+            ctl::uninitialized_relocate_n(other.data_, other.size_, data_);
+        } else {
+            data_ = other.data_;
+            capacity_ = other.capacity_;
+            other.data_ = other.inline_data();
+            other.capacity_ = N;
+        }
+        size_ = other.size_;
+        other.size_ = 0;
+    }
+
+    void release() noexcept
+    {
+        if (!is_inline())
+            ctl::allocator<T>().deallocate(data_, capacity_);
+    }
+
+    void grow(size_type min_capacity)
+    {
+        size_type c2 = capacity_ + (capacity_ >> 1);
+        reallocate(c2 > min_capacity ? c2 : min_capacity);
+    }
+
+    void reallocate(size_type new_capacity)
+    {
+        if (new_capacity > max_size())
+            throw ctl::bad_alloc();
+        if constexpr (ctl::is_trivially_relocatable_v<T>) {
+            if (!is_inline() &&
+                ctl::__::resize_in_place(data_, new_capacity * sizeof(T))) {
+                capacity_ = new_capacity;
+                return;
+            }
+        }
+        T* new_data = ctl::allocator<T>().allocate(new_capacity);
+        ctl::uninitialized_relocate_n(data_, size_, new_data);
+        release();
+        data_ = new_data;
+        capacity_ = new_capacity;
+    }
+
+    // makes room for count uninitialized elements at index
+    void open(size_type index, size_type count)
+    {
+        if (size_ + count > capacity_) {
+            size_type c2 = capacity_ + (capacity_ >> 1);
+            size_type new_capacity = c2 > size_ + count ? c2 : size_ + count;
+            if (new_capacity > max_size())
+                throw ctl::bad_alloc();
+            T* new_data = ctl::allocator<T>().allocate(new_capacity);
+            ctl::uninitialized_relocate_n(data_, index, new_data);
+            ctl::uninitialized_relocate_n(
+              data_ + index, size_ - index, new_data + index + count);
+            release();
+            data_ = new_data;
+            capacity_ = new_capacity;
+        } else {
+            ctl::uninitialized_relocate_n(
+              data_ + index, size_ - index, data_ + index + count);
+        }
+        size_ += count;
+    }
+
+    // moves elements appended at old_size to index
+    void rotate(size_type index, size_type old_size)
+    {
+        size_type count = size_ - old_size;
+        if (!count || index == old_size)
+            return;
+        T* tmp = ctl::allocator<T>().allocate(count);
+        ctl::uninitialized_relocate_n(data_ + old_size, count, tmp);
+        ctl::uninitialized_relocate_n(
+          data_ + index, old_size - index, data_ + index + count);
+        ctl::uninitialized_relocate_n(tmp, count, data_ + index);
+        ctl::allocator<T>().deallocate(tmp, count);
+    }
+
+    T* data_;
+    size_type size_;
+    size_type capacity_;
+    alignas(T) unsigned char buf_[N * sizeof(T)];
+};
+
+template<class T, size_t N>
+bool
+operator==(const small_vector<T, N>& lhs, const small_vector<T, N>& rhs)
+{
+    return lhs.size() == rhs.size() &&
+           ctl::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template<class T, size_t N>
+bool
+operator!=(const small_vector<T, N>& lhs, const small_vector<T, N>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template<class T, size_t N>
+bool
+operator<(const small_vector<T, N>& lhs, const small_vector<T, N>& rhs)
+{
+    return ctl::lexicographical_compare(
+      lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template<class T, size_t N>
+bool
+operator<=(const small_vector<T, N>& lhs, const small_vector<T, N>& rhs)
+{
+    return !(rhs < lhs);
+}
+
+template<class T, size_t N>
+bool
+operator>(const small_vector<T, N>& lhs, const small_vector<T, N>& rhs)
+{
+    return rhs < lhs;
+}
+
+template<class T, size_t N>
+bool
+operator>=(const small_vector<T, N>& lhs, const small_vector<T, N>& rhs)
+{
+    return !(lhs < rhs);
+}
+
+template<class T, size_t N>
+void
+swap(small_vector<T, N>& lhs, small_vector<T, N>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+} // namespace ctl
+
+#endif // CTL_SMALL_VECTOR_H_
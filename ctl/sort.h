@@ -2,22 +2,365 @@
 // vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
 #ifndef CTL_SORT_H_
 #define CTL_SORT_H_
+#include "is_trivial.h"
 #include "iterator_traits.h"
 #include "less.h"
-#include "partition.h"
+#include "pair.h"
+#include "partial_sort.h"
+#include "utility.h"
 
 namespace ctl {
 
 namespace detail {
 
+// Pattern-defeating quicksort, after Orson Peters (2021). It's introsort
+// with a few tricks that make sorted, reversed and duplicate-heavy input
+// take linear time, and it falls back to heapsort when too many of the
+// partitions it obtains are unbalanced, so it's O(n log n) worst case.
+
+inline constexpr int kSortInsertionThreshold = 24;
+inline constexpr int kSortNintherThreshold = 128;
+inline constexpr int kSortPartialInsertionLimit = 8;
+inline constexpr int kSortBlockSize = 64;
+
+template<typename RandomIt, typename Compare>
+void
+insertion_sort(RandomIt first, RandomIt last, Compare comp)
+{
+    if (first == last)
+        return;
+    for (auto i = first + 1; i != last; ++i) {
+        auto j = i;
+        auto k = i - 1;
+        if (comp(*j, *k)) {
+            auto value = ctl::move(*j);
+            do
+                *j-- = ctl::move(*k);
+            while (j != first && comp(value, *--k));
+            *j = ctl::move(value);
+        }
+    }
+}
+
+// Same as insertion_sort() except it assumes *(first - 1) exists and
+// isn't greater than any element in range, which avoids a bounds check.
+template<typename RandomIt, typename Compare>
+void
+unguarded_insertion_sort(RandomIt first, RandomIt last, Compare comp)
+{
+    if (first == last)
+        return;
+    for (auto i = first + 1; i != last; ++i) {
+        auto j = i;
+        auto k = i - 1;
+        if (comp(*j, *k)) {
+            auto value = ctl::move(*j);
+            do
+                *j-- = ctl::move(*k);
+            while (comp(value, *--k));
+            *j = ctl::move(value);
+        }
+    }
+}
+
+// Attempts insertion sort, giving up if more than a few elements need
+// to be moved. Returns true if range ended up being sorted.
+template<typename RandomIt, typename Compare>
+bool
+partial_insertion_sort(RandomIt first, RandomIt last, Compare comp)
+{
+    if (first == last)
+        return true;
+    typename ctl::iterator_traits<RandomIt>::difference_type moved = 0;
+    for (auto i = first + 1; i != last; ++i) {
+        auto j = i;
+        auto k = i - 1;
+        if (comp(*j, *k)) {
+            auto value = ctl::move(*j);
+            do
+                *j-- = ctl::move(*k);
+            while (j != first && comp(value, *--k));
+            *j = ctl::move(value);
+            moved += i - j;
+            if (moved > kSortPartialInsertionLimit)
+                return false;
+        }
+    }
+    return true;
+}
+
 template<typename RandomIt, typename Compare>
 void
-quicksort(RandomIt first, RandomIt last, Compare comp)
+sort2(RandomIt a, RandomIt b, Compare comp)
 {
-    if (first < last) {
-        auto pivot = ctl::partition(first, last, comp);
-        quicksort(first, pivot, comp);
-        quicksort(pivot + 1, last, comp);
+    if (comp(*b, *a))
+        ctl::swap(*a, *b);
+}
+
+template<typename RandomIt, typename Compare>
+void
+sort3(RandomIt a, RandomIt b, RandomIt c, Compare comp)
+{
+    sort2(a, b, comp);
+    sort2(b, c, comp);
+    sort2(a, b, comp);
+}
+
+// Partitions [first,last) around the pivot *first. Elements equal to
+// the pivot end up on the right. Returns the pivot position and whether
+// the range was already partitioned, i.e. no swaps were needed.
+template<typename RandomIt, typename Compare>
+ctl::pair<RandomIt, bool>
+partition_right(RandomIt first, RandomIt last, Compare comp)
+{
+    auto pivot = ctl::move(*first);
+    auto lo = first;
+    auto hi = last;
+    while (comp(*++lo, pivot))
+        ;
+    if (lo - 1 == first) {
+        while (lo < hi && !comp(*--hi, pivot))
+            ;
+    } else {
+        while (!comp(*--hi, pivot))
+            ;
+    }
+    bool already_partitioned = lo >= hi;
+    while (lo < hi) {
+        ctl::swap(*lo, *hi);
+        while (comp(*++lo, pivot))
+            ;
+        while (!comp(*--hi, pivot))
+            ;
+    }
+    auto pivot_pos = lo - 1;
+    *first = ctl::move(*pivot_pos);
+    *pivot_pos = ctl::move(pivot);
+    return { pivot_pos, already_partitioned };
+}
+
+// Block partition for cheap to move types, after Edelkamp and Weiss's
+// BlockQuicksort (2016). Comparison results are recorded into offset
+// buffers with branch free code, and then misplaced elements are swapped
+// in bulk, so a mispredicted branch isn't paid for every element.
+template<typename RandomIt, typename Compare>
+ctl::pair<RandomIt, bool>
+partition_right_branchless(RandomIt first, RandomIt last, Compare comp)
+{
+    auto pivot = ctl::move(*first);
+    auto lo = first;
+    auto hi = last;
+    while (comp(*++lo, pivot))
+        ;
+    if (lo - 1 == first) {
+        while (lo < hi && !comp(*--hi, pivot))
+            ;
+    } else {
+        while (!comp(*--hi, pivot))
+            ;
+    }
+    bool already_partitioned = lo >= hi;
+    if (!already_partitioned) {
+        ctl::swap(*lo, *hi);
+        ++lo;
+        alignas(64) unsigned char offsets_l[kSortBlockSize];
+        alignas(64) unsigned char offsets_r[kSortBlockSize];
+        auto base_l = lo;
+        auto base_r = hi;
+        size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+        while (lo < hi) {
+            // decide how many unknown elements each side should examine
+            size_t unknown = hi - lo;
+            size_t split_l = num_l ? 0 : num_r ? unknown : unknown / 2;
+            size_t split_r = num_r ? 0 : unknown - split_l;
+            if (split_l > kSortBlockSize)
+                split_l = kSortBlockSize;
+            if (split_r > kSortBlockSize)
+                split_r = kSortBlockSize;
+            for (size_t i = 0; i < split_l; ++i) {
+                offsets_l[num_l] = i;
+                num_l += !comp(*lo, pivot);
+                ++lo;
+            }
+            for (size_t i = 0; i < split_r;) {
+                offsets_r[num_r] = ++i;
+                num_r += comp(*--hi, pivot);
+            }
+            // swap misplaced pairs, using a cyclic permutation unless
+            // the counts are equal, since pairwise swaps keep reversed
+            // input linear time
+            size_t n = num_l < num_r ? num_l : num_r;
+            unsigned char* pl = offsets_l + start_l;
+            unsigned char* pr = offsets_r + start_r;
+            if (num_l == num_r) {
+                for (size_t i = 0; i < n; ++i)
+                    ctl::swap(*(base_l + pl[i]), *(base_r - pr[i]));
+            } else if (n) {
+                auto l = base_l + pl[0];
+                auto r = base_r - pr[0];
+                auto tmp = ctl::move(*l);
+                *l = ctl::move(*r);
+                for (size_t i = 1; i < n; ++i) {
+                    l = base_l + pl[i];
+                    *r = ctl::move(*l);
+                    r = base_r - pr[i];
+                    *l = ctl::move(*r);
+                }
+                *r = ctl::move(tmp);
+            }
+            num_l -= n;
+            num_r -= n;
+            start_l += n;
+            start_r += n;
+            if (!num_l) {
+                start_l = 0;
+                base_l = lo;
+            }
+            if (!num_r) {
+                start_r = 0;
+                base_r = hi;
+            }
+        }
+        // at most one side has leftovers, which go next to the boundary
+        if (num_l) {
+            unsigned char* pl = offsets_l + start_l;
+            while (num_l--)
+                ctl::swap(*(base_l + pl[num_l]), *--hi);
+            lo = hi;
+        }
+        if (num_r) {
+            unsigned char* pr = offsets_r + start_r;
+            while (num_r--) {
+                ctl::swap(*(base_r - pr[num_r]), *lo);
+                ++lo;
+            }
+        }
+    }
+    auto pivot_pos = lo - 1;
+    *first = ctl::move(*pivot_pos);
+    *pivot_pos = ctl::move(pivot);
+    return { pivot_pos, already_partitioned };
+}
+
+// Partitions [first,last) around the pivot *first, putting elements
+// equal to the pivot on the left. This is used when the pivot equals
+// the element preceding the range, in which case nothing in the range
+// can be less, so the entire left partition is done being sorted.
+template<typename RandomIt, typename Compare>
+RandomIt
+partition_left(RandomIt first, RandomIt last, Compare comp)
+{
+    auto pivot = ctl::move(*first);
+    auto lo = first;
+    auto hi = last;
+    while (comp(pivot, *--hi))
+        ;
+    if (hi + 1 == last) {
+        while (lo < hi && !comp(pivot, *++lo))
+            ;
+    } else {
+        while (!comp(pivot, *++lo))
+            ;
+    }
+    while (lo < hi) {
+        ctl::swap(*lo, *hi);
+        while (comp(pivot, *--hi))
+            ;
+        while (!comp(pivot, *++lo))
+            ;
+    }
+    *first = ctl::move(*hi);
+    *hi = ctl::move(pivot);
+    return hi;
+}
+
+template<bool Branchless, typename RandomIt, typename Compare>
+void
+pdqsort(RandomIt first,
+        RandomIt last,
+        Compare comp,
+        int bad_allowed,
+        bool leftmost)
+{
+    for (;;) {
+        auto size = last - first;
+        if (size < kSortInsertionThreshold) {
+            if (leftmost)
+                insertion_sort(first, last, comp);
+            else
+                unguarded_insertion_sort(first, last, comp);
+            return;
+        }
+
+        // choose pivot as median of 3 or pseudomedian of 9
+        auto half = size / 2;
+        if (size > kSortNintherThreshold) {
+            sort3(first, first + half, last - 1, comp);
+            sort3(first + 1, first + (half - 1), last - 2, comp);
+            sort3(first + 2, first + (half + 1), last - 3, comp);
+            sort3(first + (half - 1), first + half, first + (half + 1), comp);
+            ctl::swap(*first, *(first + half));
+        } else {
+            sort3(first + half, first, last - 1, comp);
+        }
+
+        // if the pivot equals the element before this range then every
+        // element equal to it can be skipped, which makes lots of equal
+        // keys take linear time
+        if (!leftmost && !comp(*(first - 1), *first)) {
+            first = partition_left(first, last, comp) + 1;
+            continue;
+        }
+
+        ctl::pair<RandomIt, bool> part;
+        if constexpr (Branchless)
+            part = partition_right_branchless(first, last, comp);
+        else
+            part = partition_right(first, last, comp);
+        auto pivot_pos = part.first;
+        auto l_size = pivot_pos - first;
+        auto r_size = last - (pivot_pos + 1);
+
+        if (l_size < size / 8 || r_size < size / 8) {
+            // unbalanced partitions are a sign of adversarial input, so
+            // give up and use heapsort if this happens too often
+            if (!--bad_allowed) {
+                ctl::partial_sort(first, last, last, comp);
+                return;
+            }
+            // otherwise shuffle some elements to break up patterns
+            if (l_size >= kSortInsertionThreshold) {
+                ctl::swap(*first, *(first + l_size / 4));
+                ctl::swap(*(pivot_pos - 1), *(pivot_pos - l_size / 4));
+                if (l_size > kSortNintherThreshold) {
+                    ctl::swap(*(first + 1), *(first + (l_size / 4 + 1)));
+                    ctl::swap(*(first + 2), *(first + (l_size / 4 + 2)));
+                    ctl::swap(*(pivot_pos - 2), *(pivot_pos - (l_size / 4 + 1)));
+                    ctl::swap(*(pivot_pos - 3), *(pivot_pos - (l_size / 4 + 2)));
+                }
+            }
+            if (r_size >= kSortInsertionThreshold) {
+                ctl::swap(*(pivot_pos + 1), *(pivot_pos + (1 + r_size / 4)));
+                ctl::swap(*(last - 1), *(last - r_size / 4));
+                if (r_size > kSortNintherThreshold) {
+                    ctl::swap(*(pivot_pos + 2), *(pivot_pos + (2 + r_size / 4)));
+                    ctl::swap(*(pivot_pos + 3), *(pivot_pos + (3 + r_size / 4)));
+                    ctl::swap(*(last - 2), *(last - (1 + r_size / 4)));
+                    ctl::swap(*(last - 3), *(last - (2 + r_size / 4)));
+                }
+            }
+        } else if (part.second &&
+                   partial_insertion_sort(first, pivot_pos, comp) &&
+                   partial_insertion_sort(pivot_pos + 1, last, comp)) {
+            // well balanced partition that needed no swaps, which means
+            // the input might already be sorted
+            return;
+        }
+
+        // recurse into the left side and iterate on the right side
+        pdqsort<Branchless>(first, pivot_pos, comp, bad_allowed, leftmost);
+        first = pivot_pos + 1;
+        leftmost = false;
     }
 }
 
@@ -27,7 +370,12 @@ template<typename RandomIt, typename Compare>
 void
 sort(RandomIt first, RandomIt last, Compare comp)
 {
-    detail::quicksort(first, last, comp);
+    using T = typename ctl::iterator_traits<RandomIt>::value_type;
+    auto size = last - first;
+    if (size < 2)
+        return;
+    int bad_allowed = 64 - __builtin_clzll(size);
+    detail::pdqsort<ctl::is_trivial_v<T>>(first, last, comp, bad_allowed, true);
 }
 
 template<typename RandomIt>
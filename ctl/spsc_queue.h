@@ -0,0 +1,192 @@
+// -*-mode:c++;indent-tabs-mode:nil;c-basic-offset:4;tab-width:8;coding:utf-8-*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+#ifndef CTL_SPSC_QUEUE_H_
+#define CTL_SPSC_QUEUE_H_
+#include "eventcount.h"
+#include "new.h"
+#include "utility.h"
+
+namespace ctl {
+
+// Bounded lock-free queue for one producer thread and one consumer.
+//
+// Each side keeps a private copy of the other side's index, so neither
+// needs to touch the other's cache line until it looks full or empty.
+// The _n variants move whole batches for the price of a single store.
+// Values must be nothrow move constructible.
+template<typename T>
+class spsc_queue
+{
+    static_assert(__is_nothrow_constructible(T, T&&));
+    static constexpr size_t kLine = ctl::hardware_destructive_interference_size;
+
+  public:
+    using value_type = T;
+    using size_type = size_t;
+
+    // Creates queue, rounding capacity up to a power of two.
+    explicit spsc_queue(size_t capacity)
+    {
+        size_t n = 2;
+        while (n < capacity)
+            n <<= 1;
+        mask_ = n - 1;
+        slots_ = static_cast<T*>(
+          ::operator new(n * sizeof(T), ctl::align_val_t(kLine)));
+    }
+
+    ~spsc_queue()
+    {
+        for (size_t i = head_; i != tail_; ++i)
+            slots_[i & mask_].~T();
+        ::operator delete(
+          slots_, (mask_ + 1) * sizeof(T), ctl::align_val_t(kLine));
+    }
+
+    spsc_queue(const spsc_queue&) = delete;
+    spsc_queue& operator=(const spsc_queue&) = delete;
+
+    size_type capacity() const noexcept
+    {
+        return mask_ + 1;
+    }
+
+    // Returns number of items, which is only a snapshot unless called by
+    // the producer or consumer.
+    size_type size() const noexcept
+    {
+        size_t head = __atomic_load_n(&head_, __ATOMIC_ACQUIRE);
+        return __atomic_load_n(&tail_, __ATOMIC_ACQUIRE) - head;
+    }
+
+    bool empty() const noexcept
+    {
+        return !size();
+    }
+
+    // Adds item if there's room. Only the producer may call this.
+    bool try_push(const T& value)
+    {
+        return try_push(T(value));
+    }
+
+    bool try_push(T&& value) noexcept
+    {
+        if (!reserve(1))
+            return false;
+        ::new (static_cast<void*>(slots_ + (tail_ & mask_)))
+          T(ctl::move(value));
+        publish(tail_ + 1);
+        return true;
+    }
+
+    // Moves up to n items from first and returns how many were added.
+    template<typename InputIt>
+    size_type try_push_n(InputIt first, size_type n)
+    {
+        size_t i = 0;
+        n = reserve(n);
+        try {
+            for (; i < n; ++i, ++first)
+                ::new (static_cast<void*>(slots_ + ((tail_ + i) & mask_)))
+                  T(ctl::move(*first));
+        } catch (...) {
+            if (i)
+                publish(tail_ + i);
+            throw;
+        }
+        if (n)
+            publish(tail_ + n);
+        return n;
+    }
+
+    // Adds item, waiting for room as long as it takes or until abstime.
+    //
+    // @return false if the CLOCK_REALTIME deadline abstime passed
+    bool push(T&& value, const struct timespec* abstime = nullptr)
+    {
+        while (!try_push(ctl::move(value)))
+            if (!not_full_.await([this] { return !full(); }, abstime))
+                return false;
+        return true;
+    }
+
+    bool push(const T& value, const struct timespec* abstime = nullptr)
+    {
+        return push(T(value), abstime);
+    }
+
+    // Removes oldest item. Only the consumer may call this.
+    bool try_pop(T& out) noexcept
+    {
+        return try_pop_n(&out, 1);
+    }
+
+    // Moves up to n of the oldest items to out and returns the count.
+    template<typename OutputIt>
+    size_type try_pop_n(OutputIt out, size_type n)
+    {
+        size_t head = head_;
+        if (tail_cache_ - head < n)
+            tail_cache_ = __atomic_load_n(&tail_, __ATOMIC_ACQUIRE);
+        if (tail_cache_ - head < n)
+            n = tail_cache_ - head;
+        for (size_t i = 0; i < n; ++i, ++out) {
+            T& slot = slots_[(head + i) & mask_];
+            *out = ctl::move(slot);
+            slot.~T();
+        }
+        if (n) {
+            __atomic_store_n(&head_, head + n, __ATOMIC_RELEASE);
+            not_full_.notify_all();
+        }
+        return n;
+    }
+
+    // Removes oldest item, waiting as long as it takes or until abstime.
+    //
+    // @return false if the CLOCK_REALTIME deadline abstime passed
+    bool pop(T& out, const struct timespec* abstime = nullptr)
+    {
+        while (!try_pop(out))
+            if (!not_empty_.await([this] { return !empty(); }, abstime))
+                return false;
+        return true;
+    }
+
+  private:
+    bool full() const noexcept
+    {
+        return tail_ - __atomic_load_n(&head_, __ATOMIC_ACQUIRE) > mask_;
+    }
+
+    // Returns how many of n slots the producer may fill right now.
+    size_t reserve(size_t n) noexcept
+    {
+        size_t room = mask_ + 1 - (tail_ - head_cache_);
+        if (room < n) {
+            head_cache_ = __atomic_load_n(&head_, __ATOMIC_ACQUIRE);
+            room = mask_ + 1 - (tail_ - head_cache_);
+        }
+        return room < n ? room : n;
+    }
+
+    void publish(size_t tail) noexcept
+    {
+        __atomic_store_n(&tail_, tail, __ATOMIC_RELEASE);
+        not_empty_.notify_all();
+    }
+
+    alignas(kLine) size_t tail_ = 0;
+    size_t head_cache_ = 0;
+    alignas(kLine) size_t head_ = 0;
+    size_t tail_cache_ = 0;
+    alignas(kLine) T* slots_;
+    size_t mask_;
+    eventcount not_empty_;
+    eventcount not_full_;
+};
+
+} // namespace ctl
+
+#endif // CTL_SPSC_QUEUE_H_
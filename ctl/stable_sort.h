@@ -0,0 +1,88 @@
+// -*-mode:c++;indent-tabs-mode:nil;c-basic-offset:4;tab-width:8;coding:utf-8-*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+#ifndef CTL_STABLE_SORT_H_
+#define CTL_STABLE_SORT_H_
+#include "allocator.h"
+#include "iterator_traits.h"
+#include "less.h"
+#include "sort.h"
+#include "utility.h"
+
+namespace ctl {
+
+namespace detail {
+
+inline constexpr int kStableSortInsertionThreshold = 32;
+
+// Sorts [first,last) using `buf` as scratch space for half the elements.
+// The left half gets moved out into the buffer, and then merged back in
+// with the right half, taking from the right only when it's strictly
+// less, so that equivalent elements keep their original order.
+template<typename RandomIt, typename T, typename Compare>
+void
+merge_sort(RandomIt first, RandomIt last, T* buf, Compare comp)
+{
+    auto size = last - first;
+    if (size <= kStableSortInsertionThreshold) {
+        insertion_sort(first, last, comp);
+        return;
+    }
+    auto middle = first + size / 2;
+    merge_sort(first, middle, buf, comp);
+    merge_sort(middle, last, buf, comp);
+    if (!comp(*middle, *(middle - 1)))
+        return;
+    T* b = buf;
+    for (auto i = first; i != middle; ++i, ++b)
+        ::new (static_cast<void*>(b)) T(ctl::move(*i));
+    T* e = b;
+    b = buf;
+    auto out = first;
+    auto r = middle;
+    while (b != e && r != last) {
+        if (comp(*r, *b))
+            *out++ = ctl::move(*r++);
+        else
+            *out++ = ctl::move(*b++);
+    }
+    while (b != e)
+        *out++ = ctl::move(*b++);
+    for (b = buf; b != e; ++b)
+        b->~T();
+}
+
+} // namespace detail
+
+// Sorts range, preserving the relative order of equivalent elements.
+// This is a merge sort that needs a temporary buffer for half of the
+// elements and performs O(n log n) comparisons.
+template<typename RandomIt, typename Compare>
+void
+stable_sort(RandomIt first, RandomIt last, Compare comp)
+{
+    using T = typename ctl::iterator_traits<RandomIt>::value_type;
+    auto size = last - first;
+    if (size <= detail::kStableSortInsertionThreshold) {
+        detail::insertion_sort(first, last, comp);
+        return;
+    }
+    ctl::allocator<T> alloc;
+    size_t n = size / 2;
+    T* buf = alloc.allocate(n);
+    detail::merge_sort(first, last, buf, comp);
+    alloc.deallocate(buf, n);
+}
+
+template<typename RandomIt>
+void
+stable_sort(RandomIt first, RandomIt last)
+{
+    stable_sort(
+      first,
+      last,
+      ctl::less<typename ctl::iterator_traits<RandomIt>::value_type>());
+}
+
+} // namespace ctl
+
+#endif // CTL_STABLE_SORT_H_
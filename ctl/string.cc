@@ -276,21 +276,13 @@ string::starts_with(const string_view s) const noexcept
 size_t
 string::find(const char ch, const size_t pos) const noexcept
 {
-    char* q;
-    if ((q = (char*)memchr(data(), ch, size())))
-        return q - data();
-    return npos;
+    return string_view(*this).find(ch, pos);
 }
 
 size_t
 string::find(const string_view s, const size_t pos) const noexcept
 {
-    char* q;
-    if (pos > size())
-        __builtin_trap();
-    if ((q = (char*)memmem(data() + pos, size() - pos, s.p, s.n)))
-        return q - data();
-    return npos;
+    return string_view(*this).find(s, pos);
 }
 
 string
@@ -392,63 +384,25 @@ string::append(const ctl::string_view& s, size_t pos, size_t count) noexcept
 size_t
 string::find_last_of(char c, size_t pos) const noexcept
 {
-    const char* b = data();
-    size_t n = size();
-    if (pos > n)
-        pos = n;
-    const char* p = (const char*)memrchr(b, c, pos);
-    return p ? p - b : npos;
+    return string_view(*this).find_last_of(c, pos);
 }
 
 size_t
 string::find_last_of(ctl::string_view set, size_t pos) const noexcept
 {
-    if (empty() || set.empty())
-        return npos;
-    bool lut[256] = {};
-    for (char c : set)
-        lut[c & 255] = true;
-    const char* b = data();
-    size_t last = size() - 1;
-    if (pos > last)
-        pos = last;
-    for (;;) {
-        if (lut[b[pos] & 255])
-            return pos;
-        if (!pos)
-            return npos;
-        --pos;
-    }
+    return string_view(*this).find_last_of(set, pos);
 }
 
 size_t
 string::find_first_of(char c, size_t pos) const noexcept
 {
-    size_t n = size();
-    if (pos >= n)
-        return npos;
-    const char* b = data();
-    const char* p = (const char*)memchr(b + pos, c, n - pos);
-    return p ? p - b : npos;
+    return string_view(*this).find_first_of(c, pos);
 }
 
 size_t
 string::find_first_of(ctl::string_view set, size_t pos) const noexcept
 {
-    if (set.empty())
-        return npos;
-    bool lut[256] = {};
-    for (char c : set)
-        lut[c & 255] = true;
-    const char* b = data();
-    size_t n = size();
-    for (;;) {
-        if (pos >= n)
-            return npos;
-        if (lut[b[pos] & 255])
-            return pos;
-        ++pos;
-    }
+    return string_view(*this).find_first_of(set, pos);
 }
 
 } // namespace ctl
@@ -2,6 +2,7 @@
 // vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
 #ifndef CTL_STRING_H_
 #define CTL_STRING_H_
+#include "is_trivially_relocatable.h"
 #include "reverse_iterator.h"
 #include "string_view.h"
 
@@ -442,6 +443,10 @@ static_assert(sizeof(string) == __::string_size);
 static_assert(sizeof(__::small_string) == __::string_size);
 static_assert(sizeof(__::big_string) == __::string_size);
 
+template<>
+struct is_trivially_relocatable<string> : public ctl::true_type
+{};
+
 ctl::string
 to_string(int) noexcept;
 
@@ -21,15 +21,144 @@
 #include <stdckdint.h>
 #include <string.h>
 
+#include "libc/nexgen32e/x86feature.h"
 #include "string.h"
+#include "third_party/intel/immintrin.internal.h"
 
 namespace ctl {
 
+namespace {
+
+// Set of bytes, stored as sixteen rows indexed by the low nibble. Bit
+// (c >> 4) & 7 of lo[c & 15] says if c is in the set when c < 0x80 and
+// hi[c & 15] covers the rest. This layout lets pshufb look up sixteen
+// bytes at once.
+struct byteset
+{
+    alignas(16) unsigned char lo[16];
+    alignas(16) unsigned char hi[16];
+
+    explicit byteset(const string_view set) noexcept : lo(), hi()
+    {
+        for (unsigned char c : set)
+            (c & 0x80 ? hi : lo)[c & 15] |= 1 << ((c >> 4) & 7);
+    }
+
+    bool contains(const unsigned char c) const noexcept
+    {
+        return ((c & 0x80 ? hi : lo)[c & 15] >> ((c >> 4) & 7)) & 1;
+    }
+};
+
+#if defined(__x86_64__) && !defined(__chibicc__)
+#pragma GCC push_options
+#pragma GCC target("ssse3")
+
+// Returns bitmask of which bytes in v are members of set.
+static inline unsigned
+byteset_match(const __m128i v, const __m128i lo, const __m128i hi)
+{
+    const __m128i bits =
+      _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const __m128i m8f = _mm_set1_epi8((char)0x8f);
+    // pshufb yields zero for indices with top bit set, so each row table
+    // only sees the bytes belonging to its half of the character space.
+    __m128i flip = _mm_xor_si128(v, _mm_set1_epi8(-128));
+    __m128i row = _mm_or_si128(_mm_shuffle_epi8(lo, _mm_and_si128(v, m8f)),
+                               _mm_shuffle_epi8(hi, _mm_and_si128(flip, m8f)));
+    __m128i bit = _mm_shuffle_epi8(
+      bits, _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(15)));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(row, bit), bit));
+}
+
+static size_t
+find_first_of_ssse3(const char* p, const size_t n, const byteset& set)
+{
+    __m128i lo = _mm_load_si128((const __m128i*)set.lo);
+    __m128i hi = _mm_load_si128((const __m128i*)set.hi);
+    size_t i = 0;
+    unsigned m;
+    for (; i + 16 <= n; i += 16)
+        if ((m = byteset_match(
+               _mm_loadu_si128((const __m128i*)(p + i)), lo, hi)))
+            return i + __builtin_ctz(m);
+    if (i == n)
+        return string_view::npos;
+    // rescan the final sixteen bytes, which have been partly checked
+    if (n >= 16) {
+        if ((m = byteset_match(
+               _mm_loadu_si128((const __m128i*)(p + n - 16)), lo, hi)))
+            return n - 16 + __builtin_ctz(m);
+        return string_view::npos;
+    }
+    for (; i < n; ++i)
+        if (set.contains(p[i]))
+            return i;
+    return string_view::npos;
+}
+
+static size_t
+find_last_of_ssse3(const char* p, size_t n, const byteset& set)
+{
+    __m128i lo = _mm_load_si128((const __m128i*)set.lo);
+    __m128i hi = _mm_load_si128((const __m128i*)set.hi);
+    size_t i = n;
+    unsigned m;
+    for (; i >= 16; i -= 16)
+        if ((m = byteset_match(
+               _mm_loadu_si128((const __m128i*)(p + i - 16)), lo, hi)))
+            return i - 16 + (31 - __builtin_clz(m));
+    if (!i)
+        return string_view::npos;
+    if (n >= 16) {
+        if ((m = byteset_match(_mm_loadu_si128((const __m128i*)p), lo, hi)))
+            return 31 - __builtin_clz(m);
+        return string_view::npos;
+    }
+    while (i--)
+        if (set.contains(p[i]))
+            return i;
+    return string_view::npos;
+}
+
+#pragma GCC pop_options
+#endif
+
+// Returns index of first byte in p[0,n) that's in set, or npos.
+static size_t
+find_first_of_impl(const char* p, const size_t n, const byteset& set)
+{
+#if defined(__x86_64__) && !defined(__chibicc__)
+    if (X86_HAVE(SSSE3))
+        return find_first_of_ssse3(p, n, set);
+#endif
+    for (size_t i = 0; i < n; ++i)
+        if (set.contains(p[i]))
+            return i;
+    return string_view::npos;
+}
+
+// Returns index of last byte in p[0,n) that's in set, or npos.
+static size_t
+find_last_of_impl(const char* p, size_t n, const byteset& set)
+{
+#if defined(__x86_64__) && !defined(__chibicc__)
+    if (X86_HAVE(SSSE3))
+        return find_last_of_ssse3(p, n, set);
+#endif
+    while (n--)
+        if (set.contains(p[n]))
+            return n;
+    return string_view::npos;
+}
+
+} // namespace
+
 size_t
 string_view::find(const char ch, const size_t pos) const noexcept
 {
     char* q;
-    if (n && (q = (char*)memchr(p, ch, n)))
+    if (pos < n && (q = (char*)memchr(p + pos, ch, n - pos)))
         return q - p;
     return npos;
 }
@@ -111,11 +240,12 @@ string_view::starts_with(const string_view s) const noexcept
 size_t
 string_view::find_last_of(char c, size_t pos) const noexcept
 {
+    if (empty())
+        return npos;
+    if (pos >= size())
+        pos = size() - 1;
     const char* b = data();
-    size_t n = size();
-    if (pos > n)
-        pos = n;
-    const char* p = (const char*)memrchr(b, c, pos);
+    const char* p = (const char*)memrchr(b, c, pos + 1);
     return p ? p - b : npos;
 }
 
@@ -124,20 +254,11 @@ string_view::find_last_of(ctl::string_view set, size_t pos) const noexcept
 {
     if (empty() || set.empty())
         return npos;
-    bool lut[256] = {};
-    for (char c : set)
-        lut[c & 255] = true;
-    const char* b = data();
-    size_t last = size() - 1;
-    if (pos > last)
-        pos = last;
-    for (;;) {
-        if (lut[b[pos] & 255])
-            return pos;
-        if (!pos)
-            return npos;
-        --pos;
-    }
+    if (pos >= size())
+        pos = size() - 1;
+    if (set.size() == 1)
+        return find_last_of(set[0], pos);
+    return find_last_of_impl(data(), pos + 1, byteset(set));
 }
 
 size_t
@@ -154,20 +275,12 @@ string_view::find_first_of(char c, size_t pos) const noexcept
 size_t
 string_view::find_first_of(ctl::string_view set, size_t pos) const noexcept
 {
-    if (set.empty())
+    if (set.empty() || pos >= size())
         return npos;
-    bool lut[256] = {};
-    for (char c : set)
-        lut[c & 255] = true;
-    const char* b = data();
-    size_t n = size();
-    for (;;) {
-        if (pos >= n)
-            return npos;
-        if (lut[b[pos] & 255])
-            return pos;
-        ++pos;
-    }
+    if (set.size() == 1)
+        return find_first_of(set[0], pos);
+    size_t i = find_first_of_impl(data() + pos, size() - pos, byteset(set));
+    return i == npos ? npos : pos + i;
 }
 
 } // namespace ctl
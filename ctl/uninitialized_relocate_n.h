@@ -0,0 +1,42 @@
+// -*-mode:c++;indent-tabs-mode:nil;c-basic-offset:4;tab-width:8;coding:utf-8-*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+#ifndef CTL_UNINITIALIZED_RELOCATE_N_H_
+#define CTL_UNINITIALIZED_RELOCATE_N_H_
+#include "is_trivially_relocatable.h"
+#include "utility.h"
+
+namespace ctl {
+
+// Moves n objects into uninitialized memory and destroys the originals.
+//
+// The ranges may overlap, like memmove(). Trivially relocatable types
+// are moved with memmove(), otherwise each object is move constructed.
+template<typename T, typename Size>
+T*
+uninitialized_relocate_n(T* first, Size n, T* d_first)
+{
+    if (n <= 0)
+        return d_first;
+    if (first == d_first)
+        return d_first + n;
+    if constexpr (ctl::is_trivially_relocatable_v<T>) {
+        __builtin_memmove(static_cast<void*>(d_first),
+                          static_cast<const void*>(first),
+                          n * sizeof(T));
+    } else if (d_first < first) {
+        for (Size i = 0; i < n; ++i) {
+            ::new (static_cast<void*>(d_first + i)) T(ctl::move(first[i]));
+            first[i].~T();
+        }
+    } else {
+        for (Size i = n; i-- > 0;) {
+            ::new (static_cast<void*>(d_first + i)) T(ctl::move(first[i]));
+            first[i].~T();
+        }
+    }
+    return d_first + n;
+}
+
+} // namespace ctl
+
+#endif // CTL_UNINITIALIZED_RELOCATE_N_H_
@@ -0,0 +1,430 @@
+// -*-mode:c++;indent-tabs-mode:nil;c-basic-offset:4;tab-width:8;coding:utf-8-*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+#ifndef CTL_UNORDERED_MAP_H_
+#define CTL_UNORDERED_MAP_H_
+#include "out_of_range.h"
+#include "unordered_set.h"
+
+namespace ctl {
+
+namespace __ {
+
+template<typename Key, typename Value>
+struct first_key
+{
+    static const Key& get(const ctl::pair<const Key, Value>& value) noexcept
+    {
+        return value.first;
+    }
+};
+
+} // namespace __
+
+template<typename Key,
+         typename Value,
+         typename Hash = ctl::hash<Key>,
+         typename KeyEqual = ctl::equal_to<Key>>
+class unordered_map
+{
+    typedef __::hashtable<ctl::pair<const Key, Value>,
+                          Key,
+                          __::first_key<Key, Value>,
+                          Hash,
+                          KeyEqual>
+      table_type;
+
+    table_type table_;
+
+  public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = ctl::pair<const Key, Value>;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using iterator = typename table_type::iterator;
+    using const_iterator = typename table_type::const_iterator;
+
+    unordered_map() = default;
+
+    explicit unordered_map(size_type bucket_count,
+                           const Hash& hash = Hash(),
+                           const KeyEqual& eq = KeyEqual())
+      : table_(hash, eq)
+    {
+        table_.reserve(bucket_count);
+    }
+
+    template<class InputIt>
+    unordered_map(InputIt first, InputIt last)
+    {
+        insert(first, last);
+    }
+
+    unordered_map(std::initializer_list<value_type> init)
+    {
+        insert(init);
+    }
+
+    unordered_map(const unordered_map& other) = default;
+    unordered_map(unordered_map&& other) noexcept = default;
+    unordered_map& operator=(const unordered_map& other) = default;
+    unordered_map& operator=(unordered_map&& other) noexcept = default;
+
+    unordered_map& operator=(std::initializer_list<value_type> ilist)
+    {
+        clear();
+        insert(ilist);
+        return *this;
+    }
+
+    iterator begin() noexcept
+    {
+        return table_.begin();
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return table_.begin();
+    }
+
+    const_iterator cbegin() const noexcept
+    {
+        return table_.begin();
+    }
+
+    iterator end() noexcept
+    {
+        return table_.end();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return table_.end();
+    }
+
+    const_iterator cend() const noexcept
+    {
+        return table_.end();
+    }
+
+    bool empty() const noexcept
+    {
+        return table_.empty();
+    }
+
+    size_type size() const noexcept
+    {
+        return table_.size();
+    }
+
+    size_type max_size() const noexcept
+    {
+        return table_.max_size();
+    }
+
+    size_type bucket_count() const noexcept
+    {
+        return table_.bucket_count();
+    }
+
+    float load_factor() const noexcept
+    {
+        return table_.load_factor();
+    }
+
+    float max_load_factor() const noexcept
+    {
+        return table_.max_load_factor();
+    }
+
+    void max_load_factor(float ml) noexcept
+    {
+        table_.max_load_factor(ml);
+    }
+
+    void reserve(size_type n)
+    {
+        table_.reserve(n);
+    }
+
+    void rehash(size_type n)
+    {
+        table_.rehash(n);
+    }
+
+    hasher hash_function() const
+    {
+        return table_.hash_function();
+    }
+
+    key_equal key_eq() const
+    {
+        return table_.key_eq();
+    }
+
+    void clear() noexcept
+    {
+        table_.clear();
+    }
+
+    Value& operator[](const Key& key)
+    {
+        return try_emplace(key).first->second;
+    }
+
+    Value& operator[](Key&& key)
+    {
+        return try_emplace(ctl::move(key)).first->second;
+    }
+
+    Value& at(const Key& key)
+    {
+        auto it = find(key);
+        if (it == end())
+            throw ctl::out_of_range();
+        return it->second;
+    }
+
+    const Value& at(const Key& key) const
+    {
+        auto it = find(key);
+        if (it == end())
+            throw ctl::out_of_range();
+        return it->second;
+    }
+
+    ctl::pair<iterator, bool> insert(const value_type& value)
+    {
+        return table_.insert_unique(value);
+    }
+
+    ctl::pair<iterator, bool> insert(value_type&& value)
+    {
+        return table_.insert_unique(ctl::move(value));
+    }
+
+    template<typename P>
+    ctl::pair<iterator, bool> insert(P&& value)
+    {
+        return insert(value_type(ctl::forward<P>(value)));
+    }
+
+    iterator insert(const_iterator hint, const value_type& value)
+    {
+        return insert(value).first;
+    }
+
+    iterator insert(const_iterator hint, value_type&& value)
+    {
+        return insert(ctl::move(value)).first;
+    }
+
+    template<typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        for (; first != last; ++first)
+            insert(*first);
+    }
+
+    void insert(std::initializer_list<value_type> ilist)
+    {
+        table_.reserve(size() + ilist.size());
+        for (const auto& value : ilist)
+            insert(value);
+    }
+
+    template<typename M>
+    ctl::pair<iterator, bool> insert_or_assign(const Key& key, M&& obj)
+    {
+        auto res = try_emplace(key, ctl::forward<M>(obj));
+        if (!res.second)
+            res.first->second = ctl::forward<M>(obj);
+        return res;
+    }
+
+    template<typename M>
+    ctl::pair<iterator, bool> insert_or_assign(Key&& key, M&& obj)
+    {
+        auto res = try_emplace(ctl::move(key), ctl::forward<M>(obj));
+        if (!res.second)
+            res.first->second = ctl::forward<M>(obj);
+        return res;
+    }
+
+    // Inserts value constructed from args if key doesn't exist. Unlike
+    // emplace() this won't construct anything if the key is present.
+    template<typename... Args>
+    ctl::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+    {
+        auto res = table_.find_or_prepare_insert(key);
+        if (res.second)
+            ::new (static_cast<void*>(table_.slot(res.first)))
+              value_type(key, Value(ctl::forward<Args>(args)...));
+        return { table_.iterator_at(res.first), res.second };
+    }
+
+    template<typename... Args>
+    ctl::pair<iterator, bool> try_emplace(Key&& key, Args&&... args)
+    {
+        auto res = table_.find_or_prepare_insert(key);
+        if (res.second)
+            ::new (static_cast<void*>(table_.slot(res.first)))
+              value_type(ctl::move(key), Value(ctl::forward<Args>(args)...));
+        return { table_.iterator_at(res.first), res.second };
+    }
+
+    template<typename... Args>
+    ctl::pair<iterator, bool> emplace(Args&&... args)
+    {
+        value_type value(ctl::forward<Args>(args)...);
+        return insert(ctl::move(value));
+    }
+
+    template<typename... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args)
+    {
+        return emplace(ctl::forward<Args>(args)...).first;
+    }
+
+    iterator erase(const_iterator pos) noexcept
+    {
+        return table_.erase(pos);
+    }
+
+    iterator erase(iterator pos) noexcept
+    {
+        return table_.erase(pos);
+    }
+
+    iterator erase(const_iterator first, const_iterator last) noexcept
+    {
+        while (first != last)
+            first = erase(first);
+        return table_.to_iterator(last);
+    }
+
+    size_type erase(const Key& key) noexcept
+    {
+        return table_.erase_key(key);
+    }
+
+    template<typename K,
+             typename H = Hash,
+             typename E = KeyEqual,
+             typename = __::transparent_t<H, E>>
+    size_type erase(const K& key) noexcept
+    {
+        return table_.erase_key(key);
+    }
+
+    void swap(unordered_map& other) noexcept
+    {
+        table_.swap(other.table_);
+    }
+
+    iterator find(const Key& key) noexcept
+    {
+        return table_.find(key);
+    }
+
+    const_iterator find(const Key& key) const noexcept
+    {
+        return table_.find(key);
+    }
+
+    template<typename K,
+             typename H = Hash,
+             typename E = KeyEqual,
+             typename = __::transparent_t<H, E>>
+    iterator find(const K& key) noexcept
+    {
+        return table_.find(key);
+    }
+
+    template<typename K,
+             typename H = Hash,
+             typename E = KeyEqual,
+             typename = __::transparent_t<H, E>>
+    const_iterator find(const K& key) const noexcept
+    {
+        return table_.find(key);
+    }
+
+    size_type count(const Key& key) const noexcept
+    {
+        return table_.contains(key);
+    }
+
+    template<typename K,
+             typename H = Hash,
+             typename E = KeyEqual,
+             typename = __::transparent_t<H, E>>
+    size_type count(const K& key) const noexcept
+    {
+        return table_.contains(key);
+    }
+
+    bool contains(const Key& key) const noexcept
+    {
+        return table_.contains(key);
+    }
+
+    template<typename K,
+             typename H = Hash,
+             typename E = KeyEqual,
+             typename = __::transparent_t<H, E>>
+    bool contains(const K& key) const noexcept
+    {
+        return table_.contains(key);
+    }
+
+    ctl::pair<iterator, iterator> equal_range(const Key& key)
+    {
+        auto it = find(key);
+        if (it == end())
+            return { it, it };
+        auto next = it;
+        return { it, ++next };
+    }
+
+    ctl::pair<const_iterator, const_iterator> equal_range(const Key& key) const
+    {
+        auto it = find(key);
+        if (it == end())
+            return { it, it };
+        auto next = it;
+        return { it, ++next };
+    }
+
+    friend bool operator==(const unordered_map& lhs, const unordered_map& rhs)
+    {
+        if (lhs.size() != rhs.size())
+            return false;
+        for (const auto& entry : lhs) {
+            auto it = rhs.find(entry.first);
+            if (it == rhs.end() || !(it->second == entry.second))
+                return false;
+        }
+        return true;
+    }
+
+    friend bool operator!=(const unordered_map& lhs, const unordered_map& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    friend void swap(unordered_map& lhs, unordered_map& rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+};
+
+} // namespace ctl
+
+#endif // CTL_UNORDERED_MAP_H_
@@ -0,0 +1,1000 @@
+// -*-mode:c++;indent-tabs-mode:nil;c-basic-offset:4;tab-width:8;coding:utf-8-*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+#ifndef CTL_UNORDERED_SET_H_
+#define CTL_UNORDERED_SET_H_
+#include "bad_alloc.h"
+#include "conditional.h"
+#include "enable_if.h"
+#include "equal_to.h"
+#include "hash.h"
+#include "initializer_list.h"
+#include "new.h"
+#include "pair.h"
+#include "void_t.h"
+
+namespace ctl {
+
+namespace __ {
+
+// Open addressing hash table in the style of Abseil's Swiss tables.
+//
+// Every slot has a control byte, which is either empty, deleted, or the
+// lowest 7 bits of the element's hash. Lookups scan a group of control
+// bytes at once, using SSE2 on x86 or 64-bit words elsewhere, and only
+// compare keys whose 7-bit tag matched. That means a failed lookup will
+// usually touch a single cache line and zero elements. Elements live in
+// one flat array, so iterators, pointers and references to elements are
+// invalidated whenever the table grows.
+
+enum : signed char
+{
+    kHashEmpty = -128,
+    kHashDeleted = -2,
+    kHashSentinel = -1,
+};
+
+// Bitmask over the lanes of a group, where each lane owns 1 << shift
+// bits, and only the highest bit of each lane may be set.
+template<int Shift>
+struct hash_mask
+{
+    unsigned long long bits;
+
+    explicit operator bool() const noexcept
+    {
+        return bits != 0;
+    }
+
+    size_t lowest() const noexcept
+    {
+        return __builtin_ctzll(bits) >> Shift;
+    }
+
+    size_t highest() const noexcept
+    {
+        return (63 - __builtin_clzll(bits)) >> Shift;
+    }
+
+    void next() noexcept
+    {
+        bits &= bits - 1;
+    }
+};
+
+#ifdef __x86_64__
+
+struct hash_group
+{
+    static constexpr size_t width = 16;
+    typedef signed char vector __attribute__((__vector_size__(16)));
+    typedef char vector_char __attribute__((__vector_size__(16)));
+    typedef hash_mask<0> mask;
+
+    vector ctrl;
+
+    explicit hash_group(const signed char* p) noexcept
+    {
+        __builtin_memcpy(&ctrl, p, sizeof(ctrl));
+    }
+
+    static mask to_mask(vector v) noexcept
+    {
+        return { (unsigned)__builtin_ia32_pmovmskb128((vector_char)v) };
+    }
+
+    mask match(signed char tag) const noexcept
+    {
+        return to_mask(ctrl == tag);
+    }
+
+    mask match_empty() const noexcept
+    {
+        return to_mask(ctrl == (signed char)kHashEmpty);
+    }
+
+    mask match_empty_or_deleted() const noexcept
+    {
+        return to_mask(ctrl < (signed char)kHashSentinel);
+    }
+};
+
+#else
+
+// On ARM a comparison of two 8-byte vectors is a single NEON `cmeq`
+// instruction. Afterwards the matching lanes can be read out of a GPR
+// without needing the `movemask` instruction that ARM doesn't have.
+struct hash_group
+{
+    static constexpr size_t width = 8;
+    typedef signed char vector __attribute__((__vector_size__(8)));
+    typedef hash_mask<3> mask;
+
+    vector ctrl;
+
+    explicit hash_group(const signed char* p) noexcept
+    {
+        __builtin_memcpy(&ctrl, p, sizeof(ctrl));
+    }
+
+    static mask to_mask(vector v) noexcept
+    {
+        unsigned long long w;
+        __builtin_memcpy(&w, &v, sizeof(w));
+        return { w & 0x8080808080808080ull };
+    }
+
+    mask match(signed char tag) const noexcept
+    {
+        return to_mask(ctrl == tag);
+    }
+
+    mask match_empty() const noexcept
+    {
+        return to_mask(ctrl == (signed char)kHashEmpty);
+    }
+
+    mask match_empty_or_deleted() const noexcept
+    {
+        return to_mask(ctrl < (signed char)kHashSentinel);
+    }
+};
+
+#endif
+
+// Control bytes of a table with no capacity. Its sentinel ends the
+// iteration and its empty bytes end any lookup.
+alignas(16) inline constexpr signed char hash_empty_group[16] = {
+    kHashSentinel, kHashEmpty, kHashEmpty, kHashEmpty, kHashEmpty, kHashEmpty,
+    kHashEmpty,    kHashEmpty, kHashEmpty, kHashEmpty, kHashEmpty, kHashEmpty,
+    kHashEmpty,    kHashEmpty, kHashEmpty, kHashEmpty,
+};
+
+// heterogeneous lookup is allowed if hash and equality are transparent
+template<typename Hash, typename KeyEqual>
+using transparent_t =
+  ctl::void_t<typename Hash::is_transparent, typename KeyEqual::is_transparent>;
+
+template<typename Key>
+struct identity_key
+{
+    static const Key& get(const Key& value) noexcept
+    {
+        return value;
+    }
+};
+
+template<typename Value, typename Key, typename KeyOf, typename Hash,
+         typename KeyEqual>
+class hashtable
+{
+    typedef hash_group group;
+
+  public:
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    template<bool Const>
+    class basic_iterator
+    {
+      public:
+        using value_type = Value;
+        using difference_type = ptrdiff_t;
+        using pointer = typename ctl::conditional<Const, const Value*,
+                                                  Value*>::type;
+        using reference = typename ctl::conditional<Const, const Value&,
+                                                    Value&>::type;
+
+        basic_iterator() noexcept : ctrl_(nullptr), slot_(nullptr)
+        {
+        }
+
+        // lets iterator convert to const_iterator
+        template<bool C = Const, typename = typename ctl::enable_if<C>::type>
+        basic_iterator(const basic_iterator<false>& other) noexcept
+          : ctrl_(other.ctrl_), slot_(other.slot_)
+        {
+        }
+
+        reference operator*() const noexcept
+        {
+            return *slot_;
+        }
+
+        pointer operator->() const noexcept
+        {
+            return slot_;
+        }
+
+        basic_iterator& operator++() noexcept
+        {
+            ++ctrl_;
+            ++slot_;
+            skip();
+            return *this;
+        }
+
+        basic_iterator operator++(int) noexcept
+        {
+            basic_iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        bool operator==(const basic_iterator& other) const noexcept
+        {
+            return ctrl_ == other.ctrl_;
+        }
+
+        bool operator!=(const basic_iterator& other) const noexcept
+        {
+            return ctrl_ != other.ctrl_;
+        }
+
+      private:
+        friend class hashtable;
+        friend class basic_iterator<!Const>;
+        signed char* ctrl_;
+        Value* slot_;
+
+        basic_iterator(signed char* ctrl, Value* slot) noexcept
+          : ctrl_(ctrl), slot_(slot)
+        {
+        }
+
+        void skip() noexcept
+        {
+            while (*ctrl_ < kHashSentinel) {
+                ++ctrl_;
+                ++slot_;
+            }
+        }
+    };
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    explicit hashtable(const Hash& hash = Hash(),
+                       const KeyEqual& eq = KeyEqual()) noexcept
+      : ctrl_(empty_ctrl()),
+        slots_(nullptr),
+        capacity_(0),
+        size_(0),
+        growth_left_(0),
+        hash_(hash),
+        eq_(eq)
+    {
+    }
+
+    hashtable(const hashtable& other)
+      : ctrl_(empty_ctrl()),
+        slots_(nullptr),
+        capacity_(0),
+        size_(0),
+        growth_left_(0),
+        hash_(other.hash_),
+        eq_(other.eq_)
+    {
+        reserve(other.size_);
+        for (const Value& value : other)
+            insert_unique(value);
+    }
+
+    hashtable(hashtable&& other) noexcept
+      : ctrl_(other.ctrl_),
+        slots_(other.slots_),
+        capacity_(other.capacity_),
+        size_(other.size_),
+        growth_left_(other.growth_left_),
+        hash_(other.hash_),
+        eq_(other.eq_)
+    {
+        other.reset();
+    }
+
+    ~hashtable()
+    {
+        destroy();
+    }
+
+    hashtable& operator=(const hashtable& other)
+    {
+        if (this != &other) {
+            clear();
+            hash_ = other.hash_;
+            eq_ = other.eq_;
+            reserve(other.size_);
+            for (const Value& value : other)
+                insert_unique(value);
+        }
+        return *this;
+    }
+
+    hashtable& operator=(hashtable&& other) noexcept
+    {
+        if (this != &other) {
+            destroy();
+            ctrl_ = other.ctrl_;
+            slots_ = other.slots_;
+            capacity_ = other.capacity_;
+            size_ = other.size_;
+            growth_left_ = other.growth_left_;
+            hash_ = other.hash_;
+            eq_ = other.eq_;
+            other.reset();
+        }
+        return *this;
+    }
+
+    iterator begin() noexcept
+    {
+        iterator it(ctrl_, slots_);
+        it.skip();
+        return it;
+    }
+
+    const_iterator begin() const noexcept
+    {
+        const_iterator it(ctrl_, slots_);
+        it.skip();
+        return it;
+    }
+
+    iterator end() noexcept
+    {
+        return iterator(ctrl_ + capacity_, slots_ + capacity_);
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_iterator(ctrl_ + capacity_, slots_ + capacity_);
+    }
+
+    bool empty() const noexcept
+    {
+        return !size_;
+    }
+
+    size_type size() const noexcept
+    {
+        return size_;
+    }
+
+    size_type max_size() const noexcept
+    {
+        return __PTRDIFF_MAX__ / (sizeof(Value) + 1);
+    }
+
+    size_type bucket_count() const noexcept
+    {
+        return capacity_;
+    }
+
+    float load_factor() const noexcept
+    {
+        return capacity_ ? (float)size_ / capacity_ : 0;
+    }
+
+    float max_load_factor() const noexcept
+    {
+        return 7 / 8.f;
+    }
+
+    void max_load_factor(float) noexcept
+    {
+    }
+
+    Hash hash_function() const
+    {
+        return hash_;
+    }
+
+    KeyEqual key_eq() const
+    {
+        return eq_;
+    }
+
+    void clear() noexcept
+    {
+        for (size_t i = 0; i < capacity_; ++i)
+            if (ctrl_[i] >= 0)
+                slots_[i].~Value();
+        if (capacity_) {
+            __builtin_memset(ctrl_, kHashEmpty, capacity_ + group::width);
+            ctrl_[capacity_] = kHashSentinel;
+        }
+        size_ = 0;
+        growth_left_ = capacity_to_growth(capacity_);
+    }
+
+    // Makes room for at least `n` elements without rehashing.
+    void reserve(size_type n)
+    {
+        if (n > size_ + growth_left_)
+            resize(growth_to_capacity(n));
+    }
+
+    // Rehashes to the smallest capacity that fits `n` or more elements,
+    // which may shrink the table, and clears out any deleted slots.
+    void rehash(size_type n)
+    {
+        if (n < size_)
+            n = size_;
+        if (!n && !size_) {
+            destroy();
+            reset();
+            return;
+        }
+        resize(growth_to_capacity(n));
+    }
+
+    template<typename K>
+    iterator find(const K& key) noexcept
+    {
+        size_t i = find_index(key, hash_key(key));
+        if (i == ~(size_t)0)
+            return end();
+        return iterator(ctrl_ + i, slots_ + i);
+    }
+
+    template<typename K>
+    const_iterator find(const K& key) const noexcept
+    {
+        size_t i = find_index(key, hash_key(key));
+        if (i == ~(size_t)0)
+            return end();
+        return const_iterator(ctrl_ + i, slots_ + i);
+    }
+
+    template<typename K>
+    bool contains(const K& key) const noexcept
+    {
+        return find_index(key, hash_key(key)) != ~(size_t)0;
+    }
+
+    // Looks up key, reserving a slot for it if it doesn't exist. When
+    // the second value is true, the caller must construct the element
+    // at the first value, using a key that compares equal to `key`.
+    template<typename K>
+    ctl::pair<size_t, bool> find_or_prepare_insert(const K& key)
+    {
+        size_t hash = hash_key(key);
+        size_t i = find_index(key, hash);
+        if (i != ~(size_t)0)
+            return { i, false };
+        return { prepare_insert(hash), true };
+    }
+
+    Value* slot(size_t i) noexcept
+    {
+        return slots_ + i;
+    }
+
+    iterator iterator_at(size_t i) noexcept
+    {
+        return iterator(ctrl_ + i, slots_ + i);
+    }
+
+    iterator to_iterator(const_iterator it) noexcept
+    {
+        return iterator(it.ctrl_, it.slot_);
+    }
+
+    template<typename V>
+    ctl::pair<iterator, bool> insert_unique(V&& value)
+    {
+        auto res = find_or_prepare_insert(KeyOf::get(value));
+        if (res.second)
+            ::new (static_cast<void*>(slots_ + res.first))
+              Value(ctl::forward<V>(value));
+        return { iterator_at(res.first), res.second };
+    }
+
+    iterator erase(const_iterator pos) noexcept
+    {
+        size_t i = pos.ctrl_ - ctrl_;
+        iterator next(ctrl_ + i, slots_ + i);
+        ++next;
+        erase_index(i);
+        return next;
+    }
+
+    template<typename K>
+    size_type erase_key(const K& key) noexcept
+    {
+        size_t i = find_index(key, hash_key(key));
+        if (i == ~(size_t)0)
+            return 0;
+        erase_index(i);
+        return 1;
+    }
+
+    void swap(hashtable& other) noexcept
+    {
+        ctl::swap(ctrl_, other.ctrl_);
+        ctl::swap(slots_, other.slots_);
+        ctl::swap(capacity_, other.capacity_);
+        ctl::swap(size_, other.size_);
+        ctl::swap(growth_left_, other.growth_left_);
+        ctl::swap(hash_, other.hash_);
+        ctl::swap(eq_, other.eq_);
+    }
+
+  private:
+    static signed char* empty_ctrl() noexcept
+    {
+        return const_cast<signed char*>(hash_empty_group);
+    }
+
+    // Mixes bits since ctl::hash is the identity function for integers,
+    // and we need the high bits to choose a group and low bits for tags.
+    template<typename K>
+    size_t hash_key(const K& key) const noexcept
+    {
+        unsigned __int128 m = hash_(key);
+        m *= 0x9e3779b97f4a7c15ull;
+        return (size_t)m ^ (size_t)(m >> 64);
+    }
+
+    // Capacity is always 2ⁿ-1 and up to 7/8 of slots may be used,
+    // except in tables smaller than a group, which can be filled.
+    static size_t capacity_to_growth(size_t capacity) noexcept
+    {
+        if (group::width == 8 && capacity == 7)
+            return 6;
+        return capacity - capacity / 8;
+    }
+
+    static size_t growth_to_capacity(size_t growth) noexcept
+    {
+        size_t capacity = 1;
+        while (capacity_to_growth(capacity) < growth)
+            capacity = capacity * 2 + 1;
+        return capacity;
+    }
+
+    // Returns index of element equal to key, or -1 if it doesn't exist.
+    // Groups of control bytes are visited using triangular probing.
+    template<typename K>
+    size_t find_index(const K& key, size_t hash) const noexcept
+    {
+        size_t pos = (hash >> 7) & capacity_;
+        signed char tag = hash & 127;
+        for (size_t step = 0;;) {
+            group g(ctrl_ + pos);
+            for (auto m = g.match(tag); m; m.next()) {
+                size_t i = (pos + m.lowest()) & capacity_;
+                if (eq_(KeyOf::get(slots_[i]), key))
+                    return i;
+            }
+            if (g.match_empty())
+                return ~(size_t)0;
+            step += group::width;
+            pos = (pos + step) & capacity_;
+        }
+    }
+
+    size_t find_first_non_full(size_t hash) const noexcept
+    {
+        size_t pos = (hash >> 7) & capacity_;
+        for (size_t step = 0;;) {
+            auto m = group(ctrl_ + pos).match_empty_or_deleted();
+            if (m)
+                return (pos + m.lowest()) & capacity_;
+            step += group::width;
+            pos = (pos + step) & capacity_;
+        }
+    }
+
+    // Sets control byte, as well as its clone past the sentinel, which
+    // lets a group load at the end of the table wrap around to the start.
+    void set_ctrl(size_t i, signed char c) noexcept
+    {
+        ctrl_[i] = c;
+        ctrl_[((i - (group::width - 1)) & capacity_) +
+              ((group::width - 1) & capacity_)] = c;
+    }
+
+    size_t prepare_insert(size_t hash)
+    {
+        size_t i = find_first_non_full(hash);
+        if (!growth_left_ && ctrl_[i] != kHashDeleted) {
+            if (capacity_ > group::width && size_ * 32 <= capacity_ * 25) {
+                resize(capacity_); // purge tombstones
+            } else {
+                resize(capacity_ * 2 + 1);
+            }
+            i = find_first_non_full(hash);
+        }
+        ++size_;
+        growth_left_ -= ctrl_[i] == kHashEmpty;
+        set_ctrl(i, hash & 127);
+        return i;
+    }
+
+    // A deleted slot can be marked empty again if no probe sequence could
+    // have ever seen a full group while passing it, i.e. there weren't a
+    // group's worth of consecutive non-empty slots around it.
+    void erase_index(size_t i) noexcept
+    {
+        slots_[i].~Value();
+        --size_;
+        size_t before = (i - group::width) & capacity_;
+        auto empty_after = group(ctrl_ + i).match_empty();
+        auto empty_before = group(ctrl_ + before).match_empty();
+        if (empty_before && empty_after &&
+            empty_after.lowest() + (group::width - 1 - empty_before.highest()) <
+              group::width) {
+            set_ctrl(i, kHashEmpty);
+            ++growth_left_;
+        } else {
+            set_ctrl(i, kHashDeleted);
+        }
+    }
+
+    static size_t slots_offset(size_t capacity) noexcept
+    {
+        return (capacity + group::width + alignof(Value) - 1) &
+               -alignof(Value);
+    }
+
+    static size_t alloc_size(size_t capacity) noexcept
+    {
+        return slots_offset(capacity) + capacity * sizeof(Value);
+    }
+
+    void resize(size_t new_capacity)
+    {
+        if (new_capacity > max_size())
+            throw ctl::bad_alloc();
+        void* mem = ::operator new(alloc_size(new_capacity),
+                                   ctl::align_val_t(alignof(Value)),
+                                   ctl::nothrow);
+        if (!mem)
+            throw ctl::bad_alloc();
+        signed char* old_ctrl = ctrl_;
+        Value* old_slots = slots_;
+        size_t old_capacity = capacity_;
+        ctrl_ = static_cast<signed char*>(mem);
+        slots_ = reinterpret_cast<Value*>(ctrl_ + slots_offset(new_capacity));
+        capacity_ = new_capacity;
+        __builtin_memset(ctrl_, kHashEmpty, new_capacity + group::width);
+        ctrl_[new_capacity] = kHashSentinel;
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (old_ctrl[i] >= 0) {
+                size_t hash = hash_key(KeyOf::get(old_slots[i]));
+                size_t j = find_first_non_full(hash);
+                set_ctrl(j, hash & 127);
+                ::new (static_cast<void*>(slots_ + j))
+                  Value(ctl::move(old_slots[i]));
+                old_slots[i].~Value();
+            }
+        }
+        growth_left_ = capacity_to_growth(new_capacity) - size_;
+        if (old_capacity)
+            ::operator delete(old_ctrl,
+                              alloc_size(old_capacity),
+                              ctl::align_val_t(alignof(Value)));
+    }
+
+    void destroy() noexcept
+    {
+        if (capacity_) {
+            for (size_t i = 0; i < capacity_; ++i)
+                if (ctrl_[i] >= 0)
+                    slots_[i].~Value();
+            ::operator delete(ctrl_,
+                              alloc_size(capacity_),
+                              ctl::align_val_t(alignof(Value)));
+        }
+    }
+
+    void reset() noexcept
+    {
+        ctrl_ = empty_ctrl();
+        slots_ = nullptr;
+        capacity_ = 0;
+        size_ = 0;
+        growth_left_ = 0;
+    }
+
+    signed char* ctrl_;
+    Value* slots_;
+    size_t capacity_;
+    size_t size_;
+    size_t growth_left_;
+    [[no_unique_address]] Hash hash_;
+    [[no_unique_address]] KeyEqual eq_;
+};
+
+} // namespace __
+
+template<typename Key,
+         typename Hash = ctl::hash<Key>,
+         typename KeyEqual = ctl::equal_to<Key>>
+class unordered_set
+{
+    typedef __::hashtable<Key, Key, __::identity_key<Key>, Hash, KeyEqual>
+      table_type;
+
+    table_type table_;
+
+  public:
+    using key_type = Key;
+    using value_type = Key;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using iterator = typename table_type::const_iterator;
+    using const_iterator = typename table_type::const_iterator;
+
+    unordered_set() = default;
+
+    explicit unordered_set(size_type bucket_count,
+                           const Hash& hash = Hash(),
+                           const KeyEqual& eq = KeyEqual())
+      : table_(hash, eq)
+    {
+        table_.reserve(bucket_count);
+    }
+
+    template<class InputIt>
+    unordered_set(InputIt first, InputIt last)
+    {
+        insert(first, last);
+    }
+
+    unordered_set(std::initializer_list<value_type> init)
+    {
+        insert(init);
+    }
+
+    unordered_set(const unordered_set& other) = default;
+    unordered_set(unordered_set&& other) noexcept = default;
+    unordered_set& operator=(const unordered_set& other) = default;
+    unordered_set& operator=(unordered_set&& other) noexcept = default;
+
+    unordered_set& operator=(std::initializer_list<value_type> ilist)
+    {
+        clear();
+        insert(ilist);
+        return *this;
+    }
+
+    iterator begin() const noexcept
+    {
+        return table_.begin();
+    }
+
+    const_iterator cbegin() const noexcept
+    {
+        return table_.begin();
+    }
+
+    iterator end() const noexcept
+    {
+        return table_.end();
+    }
+
+    const_iterator cend() const noexcept
+    {
+        return table_.end();
+    }
+
+    bool empty() const noexcept
+    {
+        return table_.empty();
+    }
+
+    size_type size() const noexcept
+    {
+        return table_.size();
+    }
+
+    size_type max_size() const noexcept
+    {
+        return table_.max_size();
+    }
+
+    size_type bucket_count() const noexcept
+    {
+        return table_.bucket_count();
+    }
+
+    float load_factor() const noexcept
+    {
+        return table_.load_factor();
+    }
+
+    float max_load_factor() const noexcept
+    {
+        return table_.max_load_factor();
+    }
+
+    void max_load_factor(float ml) noexcept
+    {
+        table_.max_load_factor(ml);
+    }
+
+    void reserve(size_type n)
+    {
+        table_.reserve(n);
+    }
+
+    void rehash(size_type n)
+    {
+        table_.rehash(n);
+    }
+
+    hasher hash_function() const
+    {
+        return table_.hash_function();
+    }
+
+    key_equal key_eq() const
+    {
+        return table_.key_eq();
+    }
+
+    void clear() noexcept
+    {
+        table_.clear();
+    }
+
+    ctl::pair<iterator, bool> insert(const value_type& value)
+    {
+        return table_.insert_unique(value);
+    }
+
+    ctl::pair<iterator, bool> insert(value_type&& value)
+    {
+        return table_.insert_unique(ctl::move(value));
+    }
+
+    iterator insert(const_iterator hint, const value_type& value)
+    {
+        return insert(value).first;
+    }
+
+    iterator insert(const_iterator hint, value_type&& value)
+    {
+        return insert(ctl::move(value)).first;
+    }
+
+    template<class InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        for (; first != last; ++first)
+            insert(*first);
+    }
+
+    void insert(std::initializer_list<value_type> ilist)
+    {
+        table_.reserve(size() + ilist.size());
+        for (const auto& value : ilist)
+            insert(value);
+    }
+
+    template<class... Args>
+    ctl::pair<iterator, bool> emplace(Args&&... args)
+    {
+        value_type value(ctl::forward<Args>(args)...);
+        return insert(ctl::move(value));
+    }
+
+    template<class... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args)
+    {
+        return emplace(ctl::forward<Args>(args)...).first;
+    }
+
+    iterator erase(const_iterator pos) noexcept
+    {
+        return table_.erase(pos);
+    }
+
+    iterator erase(const_iterator first, const_iterator last) noexcept
+    {
+        while (first != last)
+            first = erase(first);
+        return last;
+    }
+
+    size_type erase(const key_type& key) noexcept
+    {
+        return table_.erase_key(key);
+    }
+
+    template<typename K,
+             typename H = Hash,
+             typename E = KeyEqual,
+             typename = __::transparent_t<H, E>>
+    size_type erase(const K& key) noexcept
+    {
+        return table_.erase_key(key);
+    }
+
+    void swap(unordered_set& other) noexcept
+    {
+        table_.swap(other.table_);
+    }
+
+    iterator find(const key_type& key) const noexcept
+    {
+        return table_.find(key);
+    }
+
+    template<typename K,
+             typename H = Hash,
+             typename E = KeyEqual,
+             typename = __::transparent_t<H, E>>
+    iterator find(const K& key) const noexcept
+    {
+        return table_.find(key);
+    }
+
+    size_type count(const key_type& key) const noexcept
+    {
+        return table_.contains(key);
+    }
+
+    template<typename K,
+             typename H = Hash,
+             typename E = KeyEqual,
+             typename = __::transparent_t<H, E>>
+    size_type count(const K& key) const noexcept
+    {
+        return table_.contains(key);
+    }
+
+    bool contains(const key_type& key) const noexcept
+    {
+        return table_.contains(key);
+    }
+
+    template<typename K,
+             typename H = Hash,
+             typename E = KeyEqual,
+             typename = __::transparent_t<H, E>>
+    bool contains(const K& key) const noexcept
+    {
+        return table_.contains(key);
+    }
+
+    ctl::pair<iterator, iterator> equal_range(const key_type& key) const
+    {
+        auto it = find(key);
+        if (it == end())
+            return { it, it };
+        auto next = it;
+        return { it, ++next };
+    }
+
+    friend bool operator==(const unordered_set& lhs, const unordered_set& rhs)
+    {
+        if (lhs.size() != rhs.size())
+            return false;
+        for (const auto& value : lhs)
+            if (!rhs.contains(value))
+                return false;
+        return true;
+    }
+
+    friend bool operator!=(const unordered_set& lhs, const unordered_set& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    friend void swap(unordered_set& lhs, unordered_set& rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+};
+
+} // namespace ctl
+
+#endif // CTL_UNORDERED_SET_H_
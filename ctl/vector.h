@@ -9,6 +9,8 @@
 #include "equal.h"
 #include "fill_n.h"
 #include "initializer_list.h"
+#include "is_same.h"
+#include "is_trivially_relocatable.h"
 #include "iterator_traits.h"
 #include "lexicographical_compare.h"
 #include "max.h"
@@ -125,7 +127,9 @@ class vector
     ~vector()
     {
         clear();
-        ctl::allocator_traits<Allocator>::deallocate(alloc_, data_, capacity_);
+        if (data_)
+            ctl::allocator_traits<Allocator>::deallocate(
+              alloc_, data_, capacity_);
     }
 
     vector& operator=(const vector& other)
@@ -144,8 +148,9 @@ class vector
     {
         if (this != &other) {
             clear();
-            ctl::allocator_traits<Allocator>::deallocate(
-              alloc_, data_, capacity_);
+            if (data_)
+                ctl::allocator_traits<Allocator>::deallocate(
+                  alloc_, data_, capacity_);
             if (ctl::allocator_traits<
                   Allocator>::propagate_on_container_move_assignment::value)
                 alloc_ = ctl::move(other.alloc_);
@@ -507,6 +512,10 @@ class vector
 
     void reallocate(size_type new_capacity)
     {
+        if constexpr (ctl::is_trivially_relocatable_v<T>) {
+            relocate(new_capacity);
+            return;
+        }
         pointer new_data =
           ctl::allocator_traits<Allocator>::allocate(alloc_, new_capacity);
         size_type new_size = size_ < new_capacity ? size_ : new_capacity;
@@ -519,7 +528,42 @@ class vector
         }
         for (size_type i = 0; i < size_; ++i)
             ctl::allocator_traits<Allocator>::destroy(alloc_, data_ + i);
-        ctl::allocator_traits<Allocator>::deallocate(alloc_, data_, capacity_);
+        if (data_)
+            ctl::allocator_traits<Allocator>::deallocate(
+              alloc_, data_, capacity_);
+        data_ = new_data;
+        size_ = new_size;
+        capacity_ = new_capacity;
+    }
+
+    // reallocates vector of trivially relocatable elements, which lets
+    // us resize the memory in place, or otherwise memcpy() the elements
+    void relocate(size_type new_capacity)
+    {
+        size_type new_size = size_ < new_capacity ? size_ : new_capacity;
+        if constexpr (ctl::is_same_v<Allocator, ctl::allocator<T>>) {
+            if (data_ && new_capacity &&
+                new_capacity <= __SIZE_MAX__ / sizeof(T) &&
+                ctl::__::resize_in_place(data_, new_capacity * sizeof(T))) {
+                for (size_type i = new_size; i < size_; ++i)
+                    ctl::allocator_traits<Allocator>::destroy(alloc_,
+                                                              data_ + i);
+                size_ = new_size;
+                capacity_ = new_capacity;
+                return;
+            }
+        }
+        pointer new_data =
+          ctl::allocator_traits<Allocator>::allocate(alloc_, new_capacity);
+        for (size_type i = new_size; i < size_; ++i)
+            ctl::allocator_traits<Allocator>::destroy(alloc_, data_ + i);
+        if (new_size)
+            __builtin_memcpy(static_cast<void*>(new_data),
+                             static_cast<const void*>(data_),
+                             new_size * sizeof(T));
+        if (data_)
+            ctl::allocator_traits<Allocator>::deallocate(
+              alloc_, data_, capacity_);
         data_ = new_data;
         size_ = new_size;
         capacity_ = new_capacity;
@@ -575,6 +619,11 @@ operator>=(const vector<T, Alloc>& lhs, const vector<T, Alloc>& rhs)
     return !(lhs < rhs);
 }
 
+template<class T, class Alloc>
+struct is_trivially_relocatable<vector<T, Alloc>>
+  : public ctl::is_trivially_relocatable<Alloc>
+{};
+
 template<class T, class Alloc>
 void
 swap(vector<T, Alloc>& lhs,
@@ -595,6 +644,16 @@ vector(size_t,
        Alloc = Alloc())
   -> vector<typename ctl::allocator_traits<Alloc>::value_type, Alloc>;
 
+namespace pmr {
+
+template<typename T>
+class polymorphic_allocator;
+
+template<typename T>
+using vector = ctl::vector<T, polymorphic_allocator<T>>;
+
+} // namespace pmr
+
 } // namespace ctl
 
 #endif // CTL_VECTOR_H_
@@ -20,6 +20,7 @@ DSP_CORE_A_DIRECTDEPS =				\
 	LIBC_MEM				\
 	LIBC_NEXGEN32E				\
 	LIBC_STR				\
+	LIBC_SYSV				\
 	LIBC_TINYMATH
 
 DSP_CORE_A_DEPS :=				\
@@ -38,6 +39,10 @@ o/$(MODE)/dsp/core/c1331.o			\
 o/$(MODE)/dsp/core/magikarp.o			\
 o/$(MODE)/dsp/core/c93654369.o			\
 o/$(MODE)/dsp/core/float2short.o		\
+o/$(MODE)/dsp/core/float2pcm.o			\
+o/$(MODE)/dsp/core/mixaudio.o			\
+o/$(MODE)/dsp/core/pcm2float.o			\
+o/$(MODE)/dsp/core/resample.o			\
 o/$(MODE)/dsp/core/scalevolume.o: private	\
 		CFLAGS +=			\
 			$(MATHEMATICAL)
@@ -22,6 +22,11 @@ double rgb2stdpc(double, double) pureconst;
 double rgb2linpc(double, double) pureconst;
 double tv2pcgamma(double, double) pureconst;
 
+void float2pcm(size_t, int16_t *, const float *);
+void pcm2float(size_t, float *, const int16_t *);
+void mixaudio(size_t, float *, const float *, float);
+void scalevolumef(size_t, float *, float);
+
 #ifndef __cplusplus
 void sad16x8n(size_t n, short[n][8], const short[n][8]);
 void float2short(size_t n, short[n][8], const float[n][8]);
@@ -0,0 +1,41 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "dsp/core/core.h"
+
+/**
+ * Converts floating point audio samples to 16-bit pulse code modulation.
+ *
+ * Samples are clamped to [-1,1) and rounded to nearest. Unlike
+ * float2short() this accepts any number of unaligned samples.
+ *
+ * @param n is number of samples, which is frames × channels
+ * @param pcm receives `n` samples in range [-32768,32767]
+ * @param f has `n` samples in range [-1,1]
+ */
+__target_clones("avx2") void float2pcm(size_t n, int16_t *pcm,
+                                       const float *f) {
+  size_t i;
+  float x;
+  for (i = 0; i < n; ++i) {
+    x = f[i] * 32768;
+    x = x < -32768 ? -32768 : x;
+    x = x > 32767 ? 32767 : x;
+    pcm[i] = x + (x < 0 ? -.5f : .5f);
+  }
+}
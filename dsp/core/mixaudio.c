@@ -0,0 +1,45 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "dsp/core/core.h"
+
+/**
+ * Adds floating point audio samples scaled by volume.
+ *
+ * @param n is number of samples, which is frames × channels
+ * @param dst is where `src × gain` gets added
+ * @param gain is linear volume, e.g. 0.5 for -6 dB
+ */
+__target_clones("avx2") void mixaudio(size_t n, float *dst, const float *src,
+                                      float gain) {
+  size_t i;
+  for (i = 0; i < n; ++i)
+    dst[i] += src[i] * gain;
+}
+
+/**
+ * Changes volume of floating point audio samples.
+ *
+ * @param n is number of samples, which is frames × channels
+ * @param gain is linear volume, e.g. 2.0 for +6 dB
+ */
+__target_clones("avx2") void scalevolumef(size_t n, float *f, float gain) {
+  size_t i;
+  for (i = 0; i < n; ++i)
+    f[i] *= gain;
+}
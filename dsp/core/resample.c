@@ -0,0 +1,230 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "dsp/core/resample.h"
+#include "libc/errno.h"
+#include "libc/macros.h"
+#include "libc/math.h"
+#include "libc/mem/mem.h"
+#include "libc/str/str.h"
+
+/**
+ * @fileoverview polyphase audio resampler
+ *
+ * The output rate divided by the input rate is reduced to a fraction
+ * L/M, and each output frame is the dot product of TAPS input frames
+ * with one of L kaiser windowed sinc filters. The filters are computed
+ * once up front, and the dot products are done eight floats at a time.
+ */
+
+#define MAXPHASES 1024
+#define MINTAPS   32
+#define MAXTAPS   256
+#define BETA      8.
+
+typedef float resample_v8sf __attribute__((__vector_size__(32)));
+
+struct Resampler {
+  int channels;
+  int taps;
+  int phases;   // L
+  int step;     // M
+  int phase;    // fractional position of next output in [0,L)
+  size_t pos;   // integer position of next output in buf
+  size_t len;   // frames buffered per channel
+  size_t cap;   // frames allocated per channel
+  float *buf;   // channels × cap planar samples
+  float *coef;  // phases × taps filters
+};
+
+static double BesselI0(double x) {
+  int k;
+  double s, t;
+  for (s = t = 1, k = 1; t > 1e-12 * s; ++k) {
+    t *= (x / (2 * k)) * (x / (2 * k));
+    s += t;
+  }
+  return s;
+}
+
+static double Kaiser(double u) {
+  if (fabs(u) >= 1)
+    return 0;
+  return BesselI0(BETA * sqrt(1 - u * u)) / BesselI0(BETA);
+}
+
+static double Sinc(double x) {
+  if (!x)
+    return 1;
+  return sin(M_PI * x) / (M_PI * x);
+}
+
+static void DesignFilters(struct Resampler *r, double fc) {
+  int p, k;
+  double d, s, h[MAXTAPS];
+  for (p = 0; p < r->phases; ++p) {
+    for (s = k = 0; k < r->taps; ++k) {
+      d = k - (r->taps / 2 - 1) - (double)p / r->phases;
+      h[k] = fc * Sinc(fc * d) * Kaiser(d / (r->taps / 2));
+      s += h[k];
+    }
+    for (k = 0; k < r->taps; ++k)
+      r->coef[p * r->taps + k] = h[k] / s;  // unity gain at dc
+  }
+}
+
+static bool Reserve(struct Resampler *r, size_t frames) {
+  int c;
+  size_t cap;
+  float *buf;
+  if (frames <= r->cap)
+    return true;
+  cap = MAX(frames, r->cap * 2);
+  if (!(buf = malloc(r->channels * cap * sizeof(float))))
+    return false;
+  for (c = 0; c < r->channels; ++c)
+    memcpy(buf + c * cap, r->buf + c * r->cap, r->len * sizeof(float));
+  free(r->buf);
+  r->buf = buf;
+  r->cap = cap;
+  return true;
+}
+
+__target_clones("avx2") static size_t Produce(struct Resampler *r, float *out,
+                                              size_t outframes) {
+  int c, k;
+  size_t n, base;
+  const float *h, *x;
+  resample_v8sf a, u, v;
+  for (n = 0; n < outframes; ++n) {
+    base = r->pos - (r->taps / 2 - 1);
+    if (base + r->taps > r->len)
+      break;
+    h = r->coef + r->phase * r->taps;
+    for (c = 0; c < r->channels; ++c) {
+      x = r->buf + c * r->cap + base;
+      a = (resample_v8sf){0};
+      for (k = 0; k < r->taps; k += 8) {
+        memcpy(&u, x + k, sizeof(u));
+        memcpy(&v, h + k, sizeof(v));
+        a += u * v;
+      }
+      out[n * r->channels + c] =
+          ((a[0] + a[4]) + (a[1] + a[5])) + ((a[2] + a[6]) + (a[3] + a[7]));
+    }
+    r->phase += r->step;
+    r->pos += r->phase / r->phases;
+    r->phase %= r->phases;
+  }
+  return n;
+}
+
+/**
+ * Creates audio resampler.
+ *
+ * Rates which reduce to a fraction with a denominator above 1024 are
+ * approximated, changing pitch by at most 0.05%.
+ *
+ * @param channels is number of interleaved channels per frame
+ * @param inrate is sampling rate of input, e.g. 44100
+ * @param outrate is sampling rate of output, e.g. 48000
+ * @return new object, or NULL w/ errno
+ * @raise EINVAL if a parameter isn't positive
+ * @raise ENOMEM if we're out of memory
+ */
+struct Resampler *resampler_new(int channels, int inrate, int outrate) {
+  int g, L, M;
+  double fc;
+  struct Resampler *r;
+  if (channels <= 0 || inrate <= 0 || outrate <= 0) {
+    errno = EINVAL;
+    return 0;
+  }
+  for (L = outrate, M = inrate; M;) {
+    g = L % M;
+    L = M;
+    M = g;
+  }
+  g = L;
+  L = outrate / g;
+  M = inrate / g;
+  if (L > MAXPHASES) {
+    M = MAX(1, lround((double)M * MAXPHASES / L));
+    L = MAXPHASES;
+  }
+  if (!(r = calloc(1, sizeof(*r))))
+    return 0;
+  fc = L < M ? (double)L / M : 1;
+  r->channels = channels;
+  r->phases = L;
+  r->step = M;
+  r->taps = MIN(MAXTAPS, ROUNDUP((int)ceil(MINTAPS / fc), 8));
+  if (!(r->coef = malloc(L * r->taps * sizeof(float))) ||
+      !Reserve(r, r->taps * 2)) {
+    resampler_free(r);
+    return 0;
+  }
+  DesignFilters(r, fc * .95);
+  // start with silent history so first output lines up with first input
+  r->len = r->pos = r->taps / 2 - 1;
+  bzero(r->buf, r->channels * r->cap * sizeof(float));
+  return r;
+}
+
+/**
+ * Resamples audio.
+ *
+ * All input frames are consumed. Output frames that don't fit are kept
+ * for the next call, which may pass zero input frames to drain them.
+ * The output lags the input by half the filter length.
+ *
+ * @param out receives at most `outframes` interleaved frames
+ * @param in has `inframes` interleaved frames
+ * @return number of frames written to `out`, or -1 w/ errno
+ * @raise ENOMEM if we're out of memory
+ */
+ssize_t resampler_run(struct Resampler *r, float *out, size_t outframes,
+                      const float *in, size_t inframes) {
+  int c;
+  size_t i, n, drop;
+  if (!Reserve(r, r->len + inframes))
+    return -1;
+  for (c = 0; c < r->channels; ++c)
+    for (i = 0; i < inframes; ++i)
+      r->buf[c * r->cap + r->len + i] = in[i * r->channels + c];
+  r->len += inframes;
+  n = Produce(r, out, outframes);
+  drop = MIN(r->len, r->pos - (r->taps / 2 - 1));
+  for (c = 0; c < r->channels; ++c)
+    memmove(r->buf + c * r->cap, r->buf + c * r->cap + drop,
+            (r->len - drop) * sizeof(float));
+  r->len -= drop;
+  r->pos -= drop;
+  return n;
+}
+
+/**
+ * Destroys audio resampler.
+ */
+void resampler_free(struct Resampler *r) {
+  if (r) {
+    free(r->coef);
+    free(r->buf);
+    free(r);
+  }
+}
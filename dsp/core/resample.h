@@ -0,0 +1,13 @@
+#ifndef COSMOPOLITAN_DSP_CORE_RESAMPLE_H_
+#define COSMOPOLITAN_DSP_CORE_RESAMPLE_H_
+COSMOPOLITAN_C_START_
+
+struct Resampler;
+
+struct Resampler *resampler_new(int, int, int);
+ssize_t resampler_run(struct Resampler *, float *, size_t, const float *,
+                      size_t);
+void resampler_free(struct Resampler *);
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_DSP_CORE_RESAMPLE_H_ */
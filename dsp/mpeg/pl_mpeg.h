@@ -825,6 +825,9 @@ plm_samples_t *plm_audio_decode(plm_audio_t *self);
 
 #include <string.h>
 #include <stdlib.h>
+#ifdef __COSMOPOLITAN__
+#include "dsp/mpeg/pl_mpeg_simd.h"
+#endif
 
 #ifndef TRUE
 #define TRUE 1
@@ -3302,6 +3305,13 @@ void plm_video_process_macroblock(
 		return; // corrupt video
 	}
 
+#ifdef __COSMOPOLITAN__
+	if (plm_simd_predict) {
+		plm_simd_predict(d + di, s + si, dw, block_size, (interpolate << 2) | (odd_h << 1) | odd_v);
+		return;
+	}
+#endif
+
 	#define PLM_MB_CASE(INTERPOLATE, ODD_H, ODD_V, OP) \
 		case ((INTERPOLATE << 2) | (ODD_H << 1) | (ODD_V)): \
 			PLM_BLOCK_SET(d, di, dw, si, dw, block_size, OP); \
@@ -3481,6 +3491,13 @@ void plm_video_idct(int *block) {
 		b1, b3, b4, b6, b7, tmp1, tmp2, m0,
 		x0, x1, x2, x3, x4, y3, y4, y5, y6, y7;
 
+#ifdef __COSMOPOLITAN__
+	if (plm_simd_idct) {
+		plm_simd_idct(block);
+		return;
+	}
+#endif
+
 	// Transform columns
 	for (int i = 0; i < 8; ++i) {
 		b1 = block[4 * 8 + i];
@@ -3551,6 +3568,34 @@ void plm_video_idct(int *block) {
 	dest[d_index + DEST_OFFSET + GI] = plm_clamp(y - g); \
 	dest[d_index + DEST_OFFSET + BI] = plm_clamp(y + b);
 
+#ifdef __COSMOPOLITAN__
+#define PLM_SIMD_CONVERT_ROW(BYTES_PER_PIXEL, RI, GI, BI) \
+	if (plm_simd_ycbcr) { \
+		uint8_t rgb[6][PLM_SIMD_CHUNK * 2]; \
+		for (int col = 0; col < cols; col += PLM_SIMD_CHUNK) { \
+			int n = cols - col < PLM_SIMD_CHUNK ? cols - col : PLM_SIMD_CHUNK; \
+			uint8_t *d0 = dest + d_index + col * 2 * BYTES_PER_PIXEL; \
+			uint8_t *d1 = d0 + stride; \
+			plm_simd_ycbcr(rgb, \
+				frame->y.data + y_index + col * 2, \
+				frame->y.data + y_index + yw + col * 2, \
+				frame->cb.data + c_index + col, \
+				frame->cr.data + c_index + col, n); \
+			for (int x = 0; x < n * 2; x++) { \
+				d0[x * BYTES_PER_PIXEL + RI] = rgb[0][x]; \
+				d0[x * BYTES_PER_PIXEL + GI] = rgb[1][x]; \
+				d0[x * BYTES_PER_PIXEL + BI] = rgb[2][x]; \
+				d1[x * BYTES_PER_PIXEL + RI] = rgb[3][x]; \
+				d1[x * BYTES_PER_PIXEL + GI] = rgb[4][x]; \
+				d1[x * BYTES_PER_PIXEL + BI] = rgb[5][x]; \
+			} \
+		} \
+		continue; \
+	}
+#else
+#define PLM_SIMD_CONVERT_ROW(BYTES_PER_PIXEL, RI, GI, BI)
+#endif
+
 #define PLM_DEFINE_FRAME_CONVERT_FUNCTION(NAME, BYTES_PER_PIXEL, RI, GI, BI) \
 	void NAME(plm_frame_t *frame, uint8_t *dest, int stride) { \
 		int cols = frame->width >> 1; \
@@ -3561,6 +3606,7 @@ void plm_video_idct(int *block) {
 			int c_index = row * cw; \
 			int y_index = row * 2 * yw; \
 			int d_index = row * 2 * stride; \
+			PLM_SIMD_CONVERT_ROW(BYTES_PER_PIXEL, RI, GI, BI) \
 			for (int col = 0; col < cols; col++) { \
 				int y; \
 				int cr = frame->cr.data[c_index] - 128; \
@@ -3588,6 +3634,7 @@ PLM_DEFINE_FRAME_CONVERT_FUNCTION(plm_frame_to_abgr, 4, 3, 2, 1)
 
 
 #undef PLM_PUT_PIXEL
+#undef PLM_SIMD_CONVERT_ROW
 #undef PLM_DEFINE_FRAME_CONVERT_FUNCTION
 
 
@@ -0,0 +1,458 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "dsp/mpeg/pl_mpeg_simd.h"
+#include "libc/nexgen32e/x86feature.h"
+#include "libc/str/str.h"
+#include "third_party/aarch64/arm_neon.internal.h"
+#include "third_party/intel/immintrin.internal.h"
+
+// the kernels are written once using gcc vector extensions, which turn
+// into sse2 or neon code by default. on x86-64 the same code is built a
+// second time with avx2 enabled, which gets us pmulld, pshufb and vex
+// encodings. every kernel computes exactly what the scalar code does.
+
+void (*plm_simd_idct)(int[64]);
+void (*plm_simd_predict)(uint8_t *, const uint8_t *, int, int, int);
+void (*plm_simd_ycbcr)(uint8_t[6][PLM_SIMD_CHUNK * 2], const uint8_t *,
+                       const uint8_t *, const uint8_t *, const uint8_t *, int);
+
+#if (defined(__x86_64__) || defined(__aarch64__)) && !defined(__chibicc__)
+
+typedef int plm_i32x4 __attribute__((__vector_size__(16)));
+typedef uint8_t plm_u8x16 __attribute__((__vector_size__(16)));
+
+// one pass of plm_video_idct() over four columns at once, where vK
+// holds element K of each column. the row pass rounds and shifts.
+forceinline void plm_idct_pass(plm_i32x4 *v0, plm_i32x4 *v1,
+                                      plm_i32x4 *v2, plm_i32x4 *v3,
+                                      plm_i32x4 *v4, plm_i32x4 *v5,
+                                      plm_i32x4 *v6, plm_i32x4 *v7, int round,
+                                      int shift) {
+  plm_i32x4 b1, b3, b4, b6, b7, tmp1, tmp2, m0;
+  plm_i32x4 x0, x1, x2, x3, x4, y3, y4, y5, y6, y7;
+  b1 = *v4;
+  b3 = *v2 + *v6;
+  b4 = *v5 - *v3;
+  tmp1 = *v1 + *v7;
+  tmp2 = *v3 + *v5;
+  b6 = *v1 - *v7;
+  b7 = tmp1 + tmp2;
+  m0 = *v0;
+  x4 = ((b6 * 473 - b4 * 196 + 128) >> 8) - b7;
+  x0 = x4 - (((tmp1 - tmp2) * 362 + 128) >> 8);
+  x1 = m0 - b1;
+  x2 = (((*v2 - *v6) * 362 + 128) >> 8) - b3;
+  x3 = m0 + b1;
+  y3 = x1 + x2;
+  y4 = x3 + b3;
+  y5 = x1 - x2;
+  y6 = x3 - b3;
+  y7 = -x0 - ((b4 * 473 + b6 * 196 + 128) >> 8);
+  *v0 = (b7 + y4 + round) >> shift;
+  *v1 = (x4 + y3 + round) >> shift;
+  *v2 = (y5 - x0 + round) >> shift;
+  *v3 = (y6 - y7 + round) >> shift;
+  *v4 = (y6 + y7 + round) >> shift;
+  *v5 = (x0 + y5 + round) >> shift;
+  *v6 = (y3 - x4 + round) >> shift;
+  *v7 = (y4 - b7 + round) >> shift;
+}
+
+forceinline void plm_transpose4(plm_i32x4 *a, plm_i32x4 *b,
+                                       plm_i32x4 *c, plm_i32x4 *d) {
+  plm_i32x4 t0, t1, t2, t3;
+  t0 = __builtin_shuffle(*a, *b, (plm_i32x4){0, 4, 1, 5});
+  t1 = __builtin_shuffle(*a, *b, (plm_i32x4){2, 6, 3, 7});
+  t2 = __builtin_shuffle(*c, *d, (plm_i32x4){0, 4, 1, 5});
+  t3 = __builtin_shuffle(*c, *d, (plm_i32x4){2, 6, 3, 7});
+  *a = __builtin_shuffle(t0, t2, (plm_i32x4){0, 1, 4, 5});
+  *b = __builtin_shuffle(t0, t2, (plm_i32x4){2, 3, 6, 7});
+  *c = __builtin_shuffle(t1, t3, (plm_i32x4){0, 1, 4, 5});
+  *d = __builtin_shuffle(t1, t3, (plm_i32x4){2, 3, 6, 7});
+}
+
+// row r of the 8x8 block lives in lN and hN where lN is columns 0-3.
+// transposing it means transposing each 4x4 tile and then swapping
+// the tiles that aren't on the diagonal.
+#define PLM_TRANSPOSE8()                  \
+  do {                                    \
+    plm_i32x4 t_;                         \
+    plm_transpose4(&l0, &l1, &l2, &l3);   \
+    plm_transpose4(&h0, &h1, &h2, &h3);   \
+    plm_transpose4(&l4, &l5, &l6, &l7);   \
+    plm_transpose4(&h4, &h5, &h6, &h7);   \
+    t_ = h0, h0 = l4, l4 = t_;            \
+    t_ = h1, h1 = l5, l5 = t_;            \
+    t_ = h2, h2 = l6, l6 = t_;            \
+    t_ = h3, h3 = l7, l7 = t_;            \
+  } while (0)
+
+forceinline void plm_idct_vec(int block[64]) {
+  plm_i32x4 l0, l1, l2, l3, l4, l5, l6, l7;
+  plm_i32x4 h0, h1, h2, h3, h4, h5, h6, h7;
+  memcpy(&l0, block + 0, 16), memcpy(&h0, block + 4, 16);
+  memcpy(&l1, block + 8, 16), memcpy(&h1, block + 12, 16);
+  memcpy(&l2, block + 16, 16), memcpy(&h2, block + 20, 16);
+  memcpy(&l3, block + 24, 16), memcpy(&h3, block + 28, 16);
+  memcpy(&l4, block + 32, 16), memcpy(&h4, block + 36, 16);
+  memcpy(&l5, block + 40, 16), memcpy(&h5, block + 44, 16);
+  memcpy(&l6, block + 48, 16), memcpy(&h6, block + 52, 16);
+  memcpy(&l7, block + 56, 16), memcpy(&h7, block + 60, 16);
+  plm_idct_pass(&l0, &l1, &l2, &l3, &l4, &l5, &l6, &l7, 0, 0);
+  plm_idct_pass(&h0, &h1, &h2, &h3, &h4, &h5, &h6, &h7, 0, 0);
+  PLM_TRANSPOSE8();
+  plm_idct_pass(&l0, &l1, &l2, &l3, &l4, &l5, &l6, &l7, 128, 8);
+  plm_idct_pass(&h0, &h1, &h2, &h3, &h4, &h5, &h6, &h7, 128, 8);
+  PLM_TRANSPOSE8();
+  memcpy(block + 0, &l0, 16), memcpy(block + 4, &h0, 16);
+  memcpy(block + 8, &l1, 16), memcpy(block + 12, &h1, 16);
+  memcpy(block + 16, &l2, 16), memcpy(block + 20, &h2, 16);
+  memcpy(block + 24, &l3, 16), memcpy(block + 28, &h3, 16);
+  memcpy(block + 32, &l4, 16), memcpy(block + 36, &h4, 16);
+  memcpy(block + 40, &l5, 16), memcpy(block + 44, &h5, 16);
+  memcpy(block + 48, &l6, 16), memcpy(block + 52, &h6, 16);
+  memcpy(block + 56, &l7, 16), memcpy(block + 60, &h7, 16);
+}
+
+// (a + b + 1) >> 1 without overflowing bytes
+forceinline plm_u8x16 plm_avg2(plm_u8x16 a, plm_u8x16 b) {
+  return (a | b) - ((a ^ b) >> 1);
+}
+
+// (a + b + c + d + 2) >> 2 without overflowing bytes
+forceinline plm_u8x16 plm_avg4(plm_u8x16 a, plm_u8x16 b, plm_u8x16 c,
+                                      plm_u8x16 d) {
+  return (a >> 2) + (b >> 2) + (c >> 2) + (d >> 2) +
+         (((a & 3) + (b & 3) + (c & 3) + (d & 3) + 2) >> 2);
+}
+
+// loads one row of a 16x16 luma block, or two rows of an 8x8 chroma one
+forceinline plm_u8x16 plm_load(const uint8_t *p, int dw, int bs) {
+  plm_u8x16 v;
+  if (bs == 16) {
+    memcpy(&v, p, 16);
+  } else {
+    memcpy(&v, p, 8);
+    memcpy((char *)&v + 8, p + dw, 8);
+  }
+  return v;
+}
+
+forceinline void plm_store(uint8_t *p, int dw, int bs, plm_u8x16 v) {
+  if (bs == 16) {
+    memcpy(p, &v, 16);
+  } else {
+    memcpy(p, &v, 8);
+    memcpy(p + dw, (char *)&v + 8, 8);
+  }
+}
+
+forceinline void plm_predict_vec(uint8_t *d, const uint8_t *s, int dw,
+                                        int bs, int mode) {
+  plm_u8x16 p;
+  int y, step = bs == 16 ? 1 : 2;
+  for (y = 0; y < bs; y += step) {
+    switch (mode & 3) {
+      case 0:
+        p = plm_load(s, dw, bs);
+        break;
+      case 1:
+        p = plm_avg2(plm_load(s, dw, bs), plm_load(s + dw, dw, bs));
+        break;
+      case 2:
+        p = plm_avg2(plm_load(s, dw, bs), plm_load(s + 1, dw, bs));
+        break;
+      default:
+        p = plm_avg4(plm_load(s, dw, bs), plm_load(s + 1, dw, bs),
+                     plm_load(s + dw, dw, bs), plm_load(s + dw + 1, dw, bs));
+        break;
+    }
+    if (mode & 4)
+      p = plm_avg2(plm_load(d, dw, bs), p);
+    plm_store(d, dw, bs, p);
+    s += step * dw;
+    d += step * dw;
+  }
+}
+
+// expands the mode and block size into constants for the compiler
+#define PLM_PREDICT(d, s, dw, bs, mode)                    \
+  switch (bs << 3 | mode) {                                \
+    case 16 << 3 | 0:                                      \
+      plm_predict_vec(d, s, dw, 16, 0);                    \
+      break;                                               \
+    case 16 << 3 | 1:                                      \
+      plm_predict_vec(d, s, dw, 16, 1);                    \
+      break;                                               \
+    case 16 << 3 | 2:                                      \
+      plm_predict_vec(d, s, dw, 16, 2);                    \
+      break;                                               \
+    case 16 << 3 | 3:                                      \
+      plm_predict_vec(d, s, dw, 16, 3);                    \
+      break;                                               \
+    case 16 << 3 | 4:                                      \
+      plm_predict_vec(d, s, dw, 16, 4);                    \
+      break;                                               \
+    case 16 << 3 | 5:                                      \
+      plm_predict_vec(d, s, dw, 16, 5);                    \
+      break;                                               \
+    case 16 << 3 | 6:                                      \
+      plm_predict_vec(d, s, dw, 16, 6);                    \
+      break;                                               \
+    case 16 << 3 | 7:                                      \
+      plm_predict_vec(d, s, dw, 16, 7);                    \
+      break;                                               \
+    case 8 << 3 | 0:                                       \
+      plm_predict_vec(d, s, dw, 8, 0);                     \
+      break;                                               \
+    case 8 << 3 | 1:                                       \
+      plm_predict_vec(d, s, dw, 8, 1);                     \
+      break;                                               \
+    case 8 << 3 | 2:                                       \
+      plm_predict_vec(d, s, dw, 8, 2);                     \
+      break;                                               \
+    case 8 << 3 | 3:                                       \
+      plm_predict_vec(d, s, dw, 8, 3);                     \
+      break;                                               \
+    case 8 << 3 | 4:                                       \
+      plm_predict_vec(d, s, dw, 8, 4);                     \
+      break;                                               \
+    case 8 << 3 | 5:                                       \
+      plm_predict_vec(d, s, dw, 8, 5);                     \
+      break;                                               \
+    case 8 << 3 | 6:                                       \
+      plm_predict_vec(d, s, dw, 8, 6);                     \
+      break;                                               \
+    case 8 << 3 | 7:                                       \
+      plm_predict_vec(d, s, dw, 8, 7);                     \
+      break;                                               \
+    default:                                               \
+      __builtin_unreachable();                             \
+  }
+
+forceinline uint8_t plm_clamp1(int n) {
+  return n < 0 ? 0 : n > 255 ? 255 : n;
+}
+
+// converts eight chroma samples and the 2x16 luma samples they cover.
+// the conversion matrix has factors that don't fit in 16 bits, so they
+// get split up, e.g. (y*76309)>>16 == y+((y*10773)>>16), which lets the
+// luma math happen in 16-bit lanes while staying exact. final clamping
+// is done by the saturating narrow instruction.
+#ifdef __x86_64__
+
+forceinline void plm_ycbcr_put(uint8_t *p, __m128i lo, __m128i hi) {
+  _mm_storeu_si128((__m128i *)p, _mm_packus_epi16(lo, hi));
+}
+
+forceinline void plm_ycbcr8(uint8_t o[6][PLM_SIMD_CHUNK * 2],
+                                   const uint8_t *yp[2], const uint8_t *cb,
+                                   const uint8_t *cr, int i) {
+  int j;
+  __m128i z = _mm_setzero_si128();
+  __m128i k128 = _mm_set1_epi16(128);
+  __m128i vcr = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)cr), z);
+  __m128i vcb = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)cb), z);
+  vcr = _mm_sub_epi16(vcr, k128);
+  vcb = _mm_sub_epi16(vcb, k128);
+  // r = (cr<<16 + cr*39061) >> 16
+  __m128i kr = _mm_set_epi16(19530, 19531, 19530, 19531, 19530, 19531, 19530,
+                             19531);
+  __m128i r = _mm_packs_epi32(
+      _mm_srai_epi32(
+          _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(vcr, vcr), kr),
+                        _mm_unpacklo_epi16(z, vcr)),
+          16),
+      _mm_srai_epi32(
+          _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(vcr, vcr), kr),
+                        _mm_unpackhi_epi16(z, vcr)),
+          16));
+  // g = (cb*25674 - cr*12258 + cr<<16) >> 16
+  __m128i kg = _mm_set_epi16(-12258, 25674, -12258, 25674, -12258, 25674,
+                             -12258, 25674);
+  __m128i g = _mm_packs_epi32(
+      _mm_srai_epi32(
+          _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(vcb, vcr), kg),
+                        _mm_unpacklo_epi16(z, vcr)),
+          16),
+      _mm_srai_epi32(
+          _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(vcb, vcr), kg),
+                        _mm_unpackhi_epi16(z, vcr)),
+          16));
+  // b = (cb*1129 + cb<<17) >> 16
+  __m128i kb = _mm_set_epi16(0, 1129, 0, 1129, 0, 1129, 0, 1129);
+  __m128i cb2 = _mm_add_epi16(vcb, vcb);
+  __m128i b = _mm_packs_epi32(
+      _mm_srai_epi32(
+          _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(vcb, z), kb),
+                        _mm_unpacklo_epi16(z, cb2)),
+          16),
+      _mm_srai_epi32(
+          _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(vcb, z), kb),
+                        _mm_unpackhi_epi16(z, cb2)),
+          16));
+  __m128i r0 = _mm_unpacklo_epi16(r, r), r1 = _mm_unpackhi_epi16(r, r);
+  __m128i g0 = _mm_unpacklo_epi16(g, g), g1 = _mm_unpackhi_epi16(g, g);
+  __m128i b0 = _mm_unpacklo_epi16(b, b), b1 = _mm_unpackhi_epi16(b, b);
+  __m128i k16 = _mm_set1_epi16(16);
+  __m128i ky = _mm_set1_epi16(10773);
+  for (j = 0; j < 2; ++j) {
+    __m128i yv = _mm_loadu_si128((const __m128i *)(yp[j] + 2 * i));
+    __m128i y0 = _mm_sub_epi16(_mm_unpacklo_epi8(yv, z), k16);
+    __m128i y1 = _mm_sub_epi16(_mm_unpackhi_epi8(yv, z), k16);
+    y0 = _mm_add_epi16(y0, _mm_mulhi_epi16(y0, ky));
+    y1 = _mm_add_epi16(y1, _mm_mulhi_epi16(y1, ky));
+    plm_ycbcr_put(o[3 * j + 0] + 2 * i, _mm_add_epi16(y0, r0),
+                  _mm_add_epi16(y1, r1));
+    plm_ycbcr_put(o[3 * j + 1] + 2 * i, _mm_sub_epi16(y0, g0),
+                  _mm_sub_epi16(y1, g1));
+    plm_ycbcr_put(o[3 * j + 2] + 2 * i, _mm_add_epi16(y0, b0),
+                  _mm_add_epi16(y1, b1));
+  }
+}
+
+#else /* __aarch64__ */
+
+forceinline int16x8_t plm_chroma(int16x8_t c, int k) {
+  return vcombine_s16(
+      vmovn_s32(vshrq_n_s32(vmulq_n_s32(vmovl_s16(vget_low_s16(c)), k), 16)),
+      vmovn_s32(vshrq_n_s32(vmulq_n_s32(vmovl_high_s16(c), k), 16)));
+}
+
+forceinline void plm_ycbcr8(uint8_t o[6][PLM_SIMD_CHUNK * 2],
+                                   const uint8_t *yp[2], const uint8_t *cb,
+                                   const uint8_t *cr, int i) {
+  int j;
+  int16x8_t vcr = vreinterpretq_s16_u16(vsubl_u8(vld1_u8(cr), vdup_n_u8(128)));
+  int16x8_t vcb = vreinterpretq_s16_u16(vsubl_u8(vld1_u8(cb), vdup_n_u8(128)));
+  int16x8_t r = plm_chroma(vcr, 104597);
+  int16x8_t b = plm_chroma(vcb, 132201);
+  int16x8_t g = vcombine_s16(
+      vmovn_s32(vshrq_n_s32(
+          vmlaq_n_s32(vmulq_n_s32(vmovl_s16(vget_low_s16(vcb)), 25674),
+                      vmovl_s16(vget_low_s16(vcr)), 53278),
+          16)),
+      vmovn_s32(vshrq_n_s32(vmlaq_n_s32(vmulq_n_s32(vmovl_high_s16(vcb), 25674),
+                                        vmovl_high_s16(vcr), 53278),
+                            16)));
+  int16x8_t r0 = vzip1q_s16(r, r), r1 = vzip2q_s16(r, r);
+  int16x8_t g0 = vzip1q_s16(g, g), g1 = vzip2q_s16(g, g);
+  int16x8_t b0 = vzip1q_s16(b, b), b1 = vzip2q_s16(b, b);
+  for (j = 0; j < 2; ++j) {
+    uint8x16_t yv = vld1q_u8(yp[j] + 2 * i);
+    int16x8_t y0 =
+        vreinterpretq_s16_u16(vsubl_u8(vget_low_u8(yv), vdup_n_u8(16)));
+    int16x8_t y1 = vreinterpretq_s16_u16(vsubl_high_u8(yv, vdupq_n_u8(16)));
+    y0 = vaddq_s16(y0, vcombine_s16(
+                           vshrn_n_s32(vmull_n_s16(vget_low_s16(y0), 10773), 16),
+                           vshrn_n_s32(vmull_high_n_s16(y0, 10773), 16)));
+    y1 = vaddq_s16(y1, vcombine_s16(
+                           vshrn_n_s32(vmull_n_s16(vget_low_s16(y1), 10773), 16),
+                           vshrn_n_s32(vmull_high_n_s16(y1, 10773), 16)));
+    vst1q_u8(o[3 * j + 0] + 2 * i,
+             vcombine_u8(vqmovun_s16(vaddq_s16(y0, r0)),
+                         vqmovun_s16(vaddq_s16(y1, r1))));
+    vst1q_u8(o[3 * j + 1] + 2 * i,
+             vcombine_u8(vqmovun_s16(vsubq_s16(y0, g0)),
+                         vqmovun_s16(vsubq_s16(y1, g1))));
+    vst1q_u8(o[3 * j + 2] + 2 * i,
+             vcombine_u8(vqmovun_s16(vaddq_s16(y0, b0)),
+                         vqmovun_s16(vaddq_s16(y1, b1))));
+  }
+}
+
+#endif /* __x86_64__ */
+
+forceinline void plm_ycbcr_vec(uint8_t o[6][PLM_SIMD_CHUNK * 2],
+                                      const uint8_t *y0, const uint8_t *y1,
+                                      const uint8_t *cb, const uint8_t *cr,
+                                      int n) {
+  int i, j, k;
+  const uint8_t *yp[2] = {y0, y1};
+  for (i = 0; i + 8 <= n; i += 8)
+    plm_ycbcr8(o, yp, cb + i, cr + i, i);
+  for (; i < n; ++i) {
+    int vcr = cr[i] - 128;
+    int vcb = cb[i] - 128;
+    int r = (vcr * 104597) >> 16;
+    int g = (vcb * 25674 + vcr * 53278) >> 16;
+    int b = (vcb * 132201) >> 16;
+    for (j = 0; j < 2; ++j) {
+      for (k = 0; k < 2; ++k) {
+        int y = ((yp[j][2 * i + k] - 16) * 76309) >> 16;
+        o[3 * j + 0][2 * i + k] = plm_clamp1(y + r);
+        o[3 * j + 1][2 * i + k] = plm_clamp1(y - g);
+        o[3 * j + 2][2 * i + k] = plm_clamp1(y + b);
+      }
+    }
+  }
+}
+
+static void plm_idct_base(int block[64]) {
+  plm_idct_vec(block);
+}
+
+static void plm_predict_base(uint8_t *d, const uint8_t *s, int dw, int bs,
+                             int mode) {
+  PLM_PREDICT(d, s, dw, bs, mode);
+}
+
+static void plm_ycbcr_base(uint8_t o[6][PLM_SIMD_CHUNK * 2], const uint8_t *y0,
+                           const uint8_t *y1, const uint8_t *cb,
+                           const uint8_t *cr, int n) {
+  plm_ycbcr_vec(o, y0, y1, cb, cr, n);
+}
+
+#ifdef __x86_64__
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+static void plm_idct_avx2(int block[64]) {
+  plm_idct_vec(block);
+}
+
+static void plm_predict_avx2(uint8_t *d, const uint8_t *s, int dw, int bs,
+                             int mode) {
+  PLM_PREDICT(d, s, dw, bs, mode);
+}
+
+static void plm_ycbcr_avx2(uint8_t o[6][PLM_SIMD_CHUNK * 2], const uint8_t *y0,
+                           const uint8_t *y1, const uint8_t *cb,
+                           const uint8_t *cr, int n) {
+  plm_ycbcr_vec(o, y0, y1, cb, cr, n);
+}
+
+#pragma GCC pop_options
+#endif /* __x86_64__ */
+
+__attribute__((__constructor__)) static void plm_simd_init(void) {
+#ifdef __x86_64__
+  if (X86_HAVE(AVX2)) {
+    plm_simd_idct = plm_idct_avx2;
+    plm_simd_predict = plm_predict_avx2;
+    plm_simd_ycbcr = plm_ycbcr_avx2;
+    return;
+  }
+#endif
+  plm_simd_idct = plm_idct_base;
+  plm_simd_predict = plm_predict_base;
+  plm_simd_ycbcr = plm_ycbcr_base;
+}
+
+#endif /* (__x86_64__ || __aarch64__) && !__chibicc__ */
@@ -0,0 +1,26 @@
+#ifndef COSMOPOLITAN_DSP_MPEG_PL_MPEG_SIMD_H_
+#define COSMOPOLITAN_DSP_MPEG_PL_MPEG_SIMD_H_
+COSMOPOLITAN_C_START_
+
+/* chroma samples converted per plm_simd_ycbcr() call */
+#define PLM_SIMD_CHUNK 64
+
+/*
+ * Vectorized kernels for pl_mpeg.h, chosen at startup for the host cpu.
+ * Each pointer is null when no kernel is available, in which case the
+ * decoder runs its original scalar code. Outputs are bit identical.
+ */
+
+/* plm_video_idct() */
+extern void (*plm_simd_idct)(int[64]);
+
+/* plm_video_process_macroblock() where mode is interpolate<<2|h<<1|v */
+extern void (*plm_simd_predict)(uint8_t *, const uint8_t *, int, int, int);
+
+/* converts two luma rows to planar r,g,b for row 0 then r,g,b row 1 */
+extern void (*plm_simd_ycbcr)(uint8_t[6][PLM_SIMD_CHUNK * 2], const uint8_t *,
+                              const uint8_t *, const uint8_t *,
+                              const uint8_t *, int);
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_DSP_MPEG_PL_MPEG_SIMD_H_ */
@@ -12,6 +12,7 @@ DSP_PROG_BINS = $(DSP_PROG_COMS) $(DSP_PROG_COMS:%=%.dbg)
 
 DSP_PROG_DIRECTDEPS =				\
 	DSP_AUDIO				\
+	DSP_CORE				\
 	LIBC_CALLS				\
 	LIBC_FMT				\
 	LIBC_INTRIN				\
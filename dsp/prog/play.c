@@ -17,6 +17,7 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "dsp/audio/cosmoaudio/cosmoaudio.h"
+#include "dsp/core/resample.h"
 #include "libc/calls/struct/sigaction.h"
 #include "libc/errno.h"
 #include "libc/fmt/conv.h"
@@ -110,11 +111,9 @@ int main(int argc, char *argv[]) {
       if (flag_verbose)
         fprintf(stderr, "playing %s\n", fname);
 
-      // create decoder
+      // create decoder at the file's native sampling rate
       ma_decoder_config decoderConfig =
-          ma_decoder_config_init(ma_format_f32, flag_channels, flag_samprate);
-      decoderConfig.resampling.algorithm = ma_resample_algorithm_linear;
-      decoderConfig.resampling.linear.lpfOrder = 8;
+          ma_decoder_config_init(ma_format_f32, flag_channels, 0);
 
       // open input file
       ma_decoder decoder;
@@ -128,20 +127,44 @@ int main(int argc, char *argv[]) {
         goto exit;
       }
 
+      // convert to speaker rate with polyphase filter
+      struct Resampler *rs = 0;
+      if (decoder.outputSampleRate != flag_samprate &&
+          !(rs = resampler_new(flag_channels, decoder.outputSampleRate,
+                               flag_samprate))) {
+        perror(fname);
+        exit_code = 1;
+        ma_decoder_uninit(&decoder);
+        goto exit;
+      }
+
       // decode audio and transfer to speaker
       while (!gotsig) {
         float buf[512];
+        float out[2048];
         ma_uint64 got = 0;
         ma_uint64 max = sizeof(buf) / sizeof(*buf) / flag_channels;
         ma_decoder_read_pcm_frames(&decoder, buf, max, &got);
         if (!got)
           break;
-        int can = got;
-        cosmoaudio_poll(ca, NULL, &can);
-        cosmoaudio_write(ca, buf, got);
+        if (!rs) {
+          int can = got;
+          cosmoaudio_poll(ca, NULL, &can);
+          cosmoaudio_write(ca, buf, got);
+          continue;
+        }
+        ssize_t n;
+        ma_uint64 outmax = sizeof(out) / sizeof(*out) / flag_channels;
+        while ((n = resampler_run(rs, out, outmax, buf, got)) > 0) {
+          int can = n;
+          cosmoaudio_poll(ca, NULL, &can);
+          cosmoaudio_write(ca, out, n);
+          got = 0;  // drain rest of output
+        }
       }
 
       // cleanup
+      resampler_free(rs);
       ma_decoder_uninit(&decoder);
     }
   } while (!gotsig && flag_repeat);
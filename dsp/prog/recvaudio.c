@@ -20,6 +20,7 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <time.h>
+#include "dsp/core/core.h"
 #include "loudness.h"
 
 /**
@@ -43,14 +44,6 @@ void onsig(int sig) {
   g_done = 1;
 }
 
-short toshort(float x) {
-  return fmaxf(-1, fminf(1, x)) * 32767;
-}
-
-float tofloat(short x) {
-  return x / 32768.f;
-}
-
 int main(int argc, char* argv[]) {
 
   // listen on udp port for audio
@@ -107,8 +100,7 @@ int main(int argc, char* argv[]) {
 
     // write to speaker
     float buf32[CHUNK_FRAMES];
-    for (int i = 0; i < CHUNK_FRAMES; ++i)
-      buf32[i] = tofloat(buf16[i]);
+    pcm2float(CHUNK_FRAMES, buf32, buf16);
     cosmoaudio_poll(ca, 0, (int[]){CHUNK_FRAMES});
     cosmoaudio_write(ca, buf32, CHUNK_FRAMES);
 
@@ -21,6 +21,7 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <time.h>
+#include "dsp/core/core.h"
 #include "loudness.h"
 
 /**
@@ -44,14 +45,6 @@ void onsig(int sig) {
   g_done = 1;
 }
 
-short toshort(float x) {
-  return fmaxf(-1, fminf(1, x)) * 32767;
-}
-
-float tofloat(short x) {
-  return x / 32768.f;
-}
-
 uint32_t host2ip(const char* host) {
   uint32_t ip;
   if ((ip = inet_addr(host)) != -1u)
@@ -124,8 +117,7 @@ int main(int argc, char* argv[]) {
     cosmoaudio_poll(ca, (int[]){CHUNK_FRAMES}, 0);
     cosmoaudio_read(ca, buf32, CHUNK_FRAMES);
     short buf16[CHUNK_FRAMES];
-    for (int i = 0; i < CHUNK_FRAMES; ++i)
-      buf16[i] = toshort(buf32[i]);
+    float2pcm(CHUNK_FRAMES, buf16, buf32);
 
     // send to server
     if (write(client, buf16, CHUNK_FRAMES * sizeof(short)) == -1) {
@@ -31,6 +31,7 @@ DSP_SCALE_A_DIRECTDEPS =			\
 	LIBC_NEXGEN32E				\
 	LIBC_RUNTIME				\
 	LIBC_STR				\
+	LIBC_THREAD				\
 	LIBC_TINYMATH				\
 	LIBC_X
 
@@ -21,6 +21,7 @@
 #include "dsp/core/ituround.h"
 #include "dsp/core/q.h"
 #include "dsp/core/twixt8.h"
+#include "libc/cosmo.h"
 #include "libc/intrin/bsr.h"
 #include "libc/limits.h"
 #include "libc/log/check.h"
@@ -29,8 +30,10 @@
 #include "libc/math.h"
 #include "libc/mem/gc.h"
 #include "libc/mem/mem.h"
+#include "libc/nexgen32e/x86feature.h"
 #include "libc/str/str.h"
 #include "libc/testlib/testlib.h"
+#include "libc/thread/thread.h"
 #include "libc/x/x.h"
 #include "tool/viz/lib/knobs.h"
 
@@ -44,6 +47,10 @@
 #define M      14
 #define SQR(X) ((X) * (X))
 
+#define CHUNK            256      /* columns accumulated per tap */
+#define GYARADOS_THREADS 8        /* most row bands per image */
+#define GYARADOS_GRAIN   1000000L /* fewest multiply adds per band */
+
 struct SamplingSolution {
   int n, s;
   void *weights;
@@ -147,61 +154,161 @@ static int Sharpen(int ax, int bx, int cx) {
   return (-1 * ax + 6 * bx + -1 * cx + 2) / 4;
 }
 
-static void GyaradosImpl(long dyw, long dxw, int dst[dyw][dxw], long syw,
-                         long sxw, const int src[syw][sxw], long dyn, long dxn,
-                         long syn, long sxn, int tmp0[dyn][sxn],
-                         int tmp1[dyn][sxn], int tmp2[dyn][dxn], long yfn,
-                         long xfn, const short fyi[dyn][yfn],
-                         const short fyw[dyn][yfn], const short fxi[dxn][xfn],
-                         const short fxw[dxn][xfn], bool sharpen) {
-  long i;
-  int eax, dy, dx, sx;
-  for (sx = 0; sx < sxn; ++sx) {
-    for (dy = 0; dy < dyn; ++dy) {
-      for (eax = i = 0; i < yfn; ++i) {
-        eax += fyw[dy][i] * src[fyi[dy][i]][sx];
-      }
-      tmp0[dy][sx] = QRS(M, eax);
-    }
-  }
-  if (sharpen) {
-    for (dy = 0; dy < dyn; ++dy) {
-      for (sx = 0; sx < sxn; ++sx) {
-        tmp1[dy][sx] =
-            Sharpen(tmp0[MIN(dyn - 1, MAX(0, dy - 1))][sx], tmp0[dy][sx],
-                    tmp0[MIN(dyn - 1, MAX(0, dy + 1))][sx]);
-      }
-    }
-  } else {
-    for (dy = 0; dy < dyn; ++dy) {
-      for (sx = 0; sx < sxn; ++sx) {
-        tmp1[dy][sx] = tmp0[dy][sx];
+/*
+ * Applies one row of a sampling solution to a run of columns, i.e.
+ *
+ *     dst[x] = QRS(M, Σᵢ w[i] * src[idx[i]][x])
+ *
+ * Each tap is accumulated over a chunk of contiguous columns, so the
+ * inner loop vectorizes across columns, and taps with zero weight (the
+ * solution pads every row to the same width) are skipped. Both passes
+ * use this, since the horizontal pass runs on a transposed matrix.
+ */
+forceinline void ConvolveImpl(long n, int dst[n], long stride,
+                                     const int *src, long taps,
+                                     const short idx[taps],
+                                     const short w[taps]) {
+  long i, x, x0, xn;
+  const int *p;
+  int k, acc[CHUNK];
+  for (x0 = 0; x0 < n; x0 += CHUNK) {
+    xn = MIN(CHUNK, n - x0);
+    for (x = 0; x < xn; ++x)
+      acc[x] = 1 << (M - 1);
+    for (i = 0; i < taps; ++i) {
+      if ((k = w[i])) {
+        p = src + idx[i] * stride + x0;
+        for (x = 0; x < xn; ++x)
+          acc[x] += k * p[x];
       }
     }
+    for (x = 0; x < xn; ++x)
+      dst[x0 + x] = acc[x] >> M;
   }
-  for (dx = 0; dx < dxn; ++dx) {
+}
+
+static void ConvolveBase(long n, int dst[n], long stride, const int *src,
+                         long taps, const short idx[taps],
+                         const short w[taps]) {
+  ConvolveImpl(n, dst, stride, src, taps, idx, w);
+}
+
+#ifdef __x86_64__
+#pragma GCC push_options
+#pragma GCC target("avx2")
+static void ConvolveAvx2(long n, int dst[n], long stride, const int *src,
+                         long taps, const short idx[taps],
+                         const short w[taps]) {
+  ConvolveImpl(n, dst, stride, src, taps, idx, w);
+}
+#pragma GCC pop_options
+#endif
+
+static void (*Convolve)(long, int *, long, const int *, long, const short *,
+                        const short *) = ConvolveBase;
+
+__attribute__((__constructor__)) static void GyaradosInit(void) {
+#ifdef __x86_64__
+  if (X86_HAVE(AVX2))
+    Convolve = ConvolveAvx2;
+#endif
+}
+
+struct Gyarados {
+  long dyw, dxw, syw, sxw, dyn, dxn, syn, sxn, yfn, xfn, threads;
+  int *dst;
+  const int *src;
+  int *tmp0, *tmp1, *tmp2;
+  const short *fyi, *fyw, *fxi, *fxw;
+  bool sharpen;
+  pthread_barrier_t barrier;
+};
+
+struct GyaradosBand {
+  long i;
+  struct Gyarados *g;
+};
+
+static void GetBand(long n, long i, long k, long *lo, long *hi) {
+  *lo = n * i / k;
+  *hi = n * (i + 1) / k;
+}
+
+/*
+ * Runs one row band of each pass. Bands are cut along whichever axis
+ * a pass writes contiguously, and every band waits for the others in
+ * between passes, since each pass reads all of the previous output:
+ *
+ *   1. vertical convolution src[syn][sxn] → tmp0[dyn][sxn]
+ *   2. vertical sharpen and transpose tmp0 → tmp1[sxn][dyn]
+ *   3. horizontal convolution tmp1 → tmp2[dxn][dyn]
+ *   4. horizontal sharpen and transpose tmp2 → dst[dyn][dxn]
+ *
+ * The final pass may overwrite `src` as GyaradosUint8() requires.
+ */
+static void *GyaradosWorker(void *arg) {
+  struct GyaradosBand *b = arg;
+  struct Gyarados *g = b->g;
+  long lo, hi, dy, dx, sx, dyn, dxn, sxn;
+  const int *t;
+  dyn = g->dyn;
+  dxn = g->dxn;
+  sxn = g->sxn;
+  GetBand(dyn, b->i, g->threads, &lo, &hi);
+  for (dy = lo; dy < hi; ++dy)
+    Convolve(sxn, g->tmp0 + dy * sxn, g->sxw, g->src, g->yfn,
+             g->fyi + dy * g->yfn, g->fyw + dy * g->yfn);
+  pthread_barrier_wait(&g->barrier);
+  GetBand(sxn, b->i, g->threads, &lo, &hi);
+  for (sx = lo; sx < hi; ++sx) {
     for (dy = 0; dy < dyn; ++dy) {
-      for (eax = i = 0; i < xfn; ++i) {
-        eax += fxw[dx][i] * tmp1[dy][fxi[dx][i]];
-      }
-      tmp2[dy][dx] = QRS(M, eax);
+      t = g->tmp0 + sx;
+      g->tmp1[sx * dyn + dy] =
+          g->sharpen ? Sharpen(t[MAX(0, dy - 1) * sxn], t[dy * sxn],
+                               t[MIN(dyn - 1, dy + 1) * sxn])
+                     : t[dy * sxn];
     }
   }
-  if (sharpen) {
-    for (dx = 0; dx < dxn; ++dx) {
-      for (dy = 0; dy < dyn; ++dy) {
-        dst[dy][dx] =
-            Sharpen(tmp2[dy][MIN(dxn - 1, MAX(0, dx - 1))], tmp2[dy][dx],
-                    tmp2[dy][MIN(dxn - 1, MAX(0, dx + 1))]);
-      }
-    }
-  } else {
+  pthread_barrier_wait(&g->barrier);
+  GetBand(dxn, b->i, g->threads, &lo, &hi);
+  for (dx = lo; dx < hi; ++dx)
+    Convolve(dyn, g->tmp2 + dx * dyn, dyn, g->tmp1, g->xfn,
+             g->fxi + dx * g->xfn, g->fxw + dx * g->xfn);
+  pthread_barrier_wait(&g->barrier);
+  GetBand(dyn, b->i, g->threads, &lo, &hi);
+  for (dy = lo; dy < hi; ++dy) {
     for (dx = 0; dx < dxn; ++dx) {
-      for (dy = 0; dy < dyn; ++dy) {
-        dst[dy][dx] = tmp2[dy][dx];
-      }
+      t = g->tmp2 + dy;
+      g->dst[dy * g->dxw + dx] =
+          g->sharpen ? Sharpen(t[MAX(0, dx - 1) * dyn], t[dx * dyn],
+                               t[MIN(dxn - 1, dx + 1) * dyn])
+                     : t[dx * dyn];
     }
   }
+  return 0;
+}
+
+static long GetGyaradosThreads(struct Gyarados *g) {
+  long work;
+  work = g->dyn * g->sxn * g->yfn + g->dxn * g->dyn * g->xfn;
+  return MAX(1, MIN(MIN(GYARADOS_THREADS, cosmo_cpu_count()),
+                    work / GYARADOS_GRAIN));
+}
+
+static void GyaradosImpl(struct Gyarados *g) {
+  long i;
+  pthread_t th[GYARADOS_THREADS];
+  struct GyaradosBand b[GYARADOS_THREADS];
+  g->threads = GetGyaradosThreads(g);
+  pthread_barrier_init(&g->barrier, 0, g->threads);
+  for (i = 0; i < g->threads; ++i)
+    b[i] = (struct GyaradosBand){i, g};
+  for (i = 1; i < g->threads; ++i)
+    CHECK_EQ(0, pthread_create(th + i, 0, GyaradosWorker, b + i));
+  GyaradosWorker(b);
+  for (i = 1; i < g->threads; ++i)
+    pthread_join(th[i], 0);
+  pthread_barrier_destroy(&g->barrier);
 }
 
 /**
@@ -230,11 +337,28 @@ void *Gyarados(long dyw, long dxw, int dst[dyw][dxw], long syw, long sxw,
       CHECK_LE(dxn, 0x7fff);
       CHECK_LE(syn, 0x7fff);
       CHECK_LE(sxn, 0x7fff);
-      GyaradosImpl(dyw, dxw, dst, syw, sxw, src, dyn, dxn, syn, sxn,
-                   gc(xmemalign(64, sizeof(int) * dyn * sxn)),
-                   gc(xmemalign(64, sizeof(int) * dyn * sxn)),
-                   gc(xmemalign(64, sizeof(int) * dyn * dxn)), cy->s, cx->s,
-                   cy->indices, cy->weights, cx->indices, cx->weights, sharpen);
+      GyaradosImpl(&(struct Gyarados){
+          .dyw = dyw,
+          .dxw = dxw,
+          .syw = syw,
+          .sxw = sxw,
+          .dyn = dyn,
+          .dxn = dxn,
+          .syn = syn,
+          .sxn = sxn,
+          .yfn = cy->s,
+          .xfn = cx->s,
+          .dst = (int *)dst,
+          .src = (const int *)src,
+          .tmp0 = gc(xmemalign(64, sizeof(int) * dyn * sxn)),
+          .tmp1 = gc(xmemalign(64, sizeof(int) * dyn * sxn)),
+          .tmp2 = gc(xmemalign(64, sizeof(int) * dyn * dxn)),
+          .fyi = cy->indices,
+          .fyw = cy->weights,
+          .fxi = cx->indices,
+          .fxw = cx->weights,
+          .sharpen = sharpen,
+      });
     } else {
       ZeroMatrix(dyw, dxw, dst, dyn, dxn);
     }
@@ -10,6 +10,12 @@ struct TtyRgb rgb2ttyf2i_(ttyrgb_m128);
 struct TtyRgb rgb2ttyi2f_(int, int, int);
 struct TtyRgb rgb2ansi_(int, int, int);
 struct TtyRgb rgb2ansihash_(int, int, int);
+struct TtyRgb rgb2ttylut_(int, int, int);
+void rgb2ttylutn_(struct TtyRgb *, const uint8_t *, const uint8_t *,
+                  const uint8_t *, size_t);
+void rgb2xterm24n_(struct TtyRgb *, const uint8_t *, const uint8_t *,
+                   const uint8_t *, size_t);
+void rgb2ttylutreset_(void);
 struct TtyRgb rgb2xterm24_(int, int, int);
 struct TtyRgb rgb2xterm256gray_(ttyrgb_m128);
 struct TtyRgb tty2rgb_(struct TtyRgb);
@@ -20,6 +20,8 @@ typedef char *(*setfg_f)(char *, struct TtyRgb);
 typedef struct TtyRgb (*rgb2tty_f)(int, int, int);
 typedef struct TtyRgb (*rgb2ttyf_f)(ttyrgb_m128);
 typedef struct TtyRgb (*tty2rgb_f)(struct TtyRgb);
+typedef void (*rgb2ttyn_f)(struct TtyRgb *, const uint8_t *, const uint8_t *,
+                           const uint8_t *, size_t);
 typedef struct TtyRgb ttypalette_t[2][8];
 
 enum TtyQuantizationAlgorithm {
@@ -38,16 +40,23 @@ enum TtyQuantizationChannels {
   kTtyQuantRgb = 3,
 };
 
+enum TtyQuantizationMetric {
+  kTtyQuantEuclidean,
+  kTtyQuantPerceptual,
+};
+
 struct TtyQuant {
   enum TtyQuantizationAlgorithm alg;
   enum TtyBlocksSelection blocks;
   enum TtyQuantizationChannels chans;
+  enum TtyQuantizationMetric metric;
   unsigned min;
   unsigned max;
   setbg_f setbg;
   setfg_f setfg;
   setbgfg_f setbgfg;
   rgb2tty_f rgb2tty;
+  rgb2ttyn_f rgb2ttyn;
   rgb2ttyf_f rgb2ttyf;
   tty2rgb_f tty2rgb;
   tty2rgbf_f tty2rgbf;
@@ -67,14 +76,37 @@ extern const uint8_t kXtermCube[6];
 
 void ttyquantsetup(enum TtyQuantizationAlgorithm, enum TtyQuantizationChannels,
                    enum TtyBlocksSelection);
+void ttyquantmetric(enum TtyQuantizationMetric);
+
+/* unchanged cells worth resending to avoid moving the cursor */
+#define kTtyDeltaGap 3
+
+struct TtyCursor;
+
+struct TtyCell {
+  struct TtyRgb bg, fg;
+  uint8_t k;
+};
+
+struct TtyDelta {
+  int y, x;        /* screen position of top left cell */
+  unsigned yn, xn; /* cells in each grid */
+  bool dirty;      /* repaint every cell on next frame */
+  struct TtyCell *cur, *old;
+};
 
 extern char *ttyraster(char *, const struct TtyRgb *, size_t, size_t,
                        struct TtyRgb, struct TtyRgb);
+char *ttydelta(struct TtyDelta *, char *, struct TtyCursor *,
+               const struct TtyRgb *, size_t, size_t, struct TtyRgb,
+               struct TtyRgb);
+void ttydeltafree(struct TtyDelta *);
 
 #ifndef ttyquant
 #define ttyquant()    (&g_ttyquant_)
 #define TTYQUANT()    __veil("r", &g_ttyquant_)
 #define rgb2tty(...)  (ttyquant()->rgb2tty(__VA_ARGS__))
+#define rgb2ttyn(...) (ttyquant()->rgb2ttyn(__VA_ARGS__))
 #define tty2rgb(...)  (ttyquant()->tty2rgb(__VA_ARGS__))
 #define rgb2ttyf(...) (ttyquant()->rgb2ttyf(__VA_ARGS__))
 #define tty2rgbf(...) (ttyquant()->tty2rgbf(__VA_ARGS__))
@@ -0,0 +1,177 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "dsp/tty/internal.h"
+#include "dsp/tty/quant.h"
+#include "libc/limits.h"
+#include "libc/macros.h"
+#include "libc/nexgen32e/x86feature.h"
+#include "third_party/intel/immintrin.internal.h"
+
+/**
+ * @fileoverview Nearest palette color lookup table.
+ *
+ * Searching the palette for every pixel is the slow part of the ansi
+ * and xterm256 modes. We instead search once for each color of a 15-bit
+ * rgb cube and look pixels up by their high five bits per channel. The
+ * table is built on first use, and rebuilt after the palette changes.
+ */
+
+#define LUTBITS 5
+#define LUTSIZE (1 << (3 * LUTBITS))
+
+#define LUTINDEX(R, G, B)                                 \
+  ((R) >> (8 - LUTBITS) << (2 * LUTBITS) |                \
+   (G) >> (8 - LUTBITS) << LUTBITS | (B) >> (8 - LUTBITS))
+
+static bool g_ttylutok_;
+static uint8_t g_ttylut_[LUTSIZE + 3]; /* padded for 32-bit gathers */
+
+static void (*rgb2ttylutn_impl_)(struct TtyRgb *, const uint8_t *,
+                                 const uint8_t *, const uint8_t *, size_t);
+
+/* widens five bit channel to eight bits so 0 and 255 stay exact */
+static int Expand(int x) {
+  return x << (8 - LUTBITS) | x >> (2 * LUTBITS - 8);
+}
+
+static unsigned GetDistance(struct TtyRgb a, int r, int g, int b) {
+  int dr, dg, db, rm;
+  dr = a.r - r;
+  dg = a.g - g;
+  db = a.b - b;
+  if (ttyquant()->metric == kTtyQuantPerceptual) {
+    /* "redmean" weighs each channel by how well the eye discerns it
+       depending on how red the color is, which is nearly as good as a
+       trip through cielab for a fraction of the cost */
+    rm = (a.r + r) >> 1;
+    return ((512 + rm) * dr * dr >> 8) + 4 * dg * dg +
+           ((767 - rm) * db * db >> 8);
+  } else {
+    return dr * dr + dg * dg + db * db;
+  }
+}
+
+static void BuildLut(void) {
+  int r, g, b, i;
+  unsigned c, d, best, least;
+  for (i = 0; i < LUTSIZE; ++i) {
+    r = Expand(i >> (2 * LUTBITS));
+    g = Expand(i >> LUTBITS & ((1 << LUTBITS) - 1));
+    b = Expand(i & ((1 << LUTBITS) - 1));
+    least = UINT_MAX;
+    best = ttyquant()->min;
+    for (c = ttyquant()->min; c < ttyquant()->max; ++c) {
+      if ((d = GetDistance(g_ansi2rgb_[c], r, g, b)) < least) {
+        least = d;
+        best = c;
+      }
+    }
+    g_ttylut_[i] = best;
+  }
+  g_ttylutok_ = true;
+}
+
+static void EnsureLut(void) {
+  if (!g_ttylutok_) {
+    BuildLut();
+  }
+}
+
+/**
+ * Quantizes RGB to ANSI using lookup table.
+ */
+struct TtyRgb rgb2ttylut_(int r, int g, int b) {
+  EnsureLut();
+  r = MAX(MIN(r, 255), 0);
+  g = MAX(MIN(g, 255), 0);
+  b = MAX(MIN(b, 255), 0);
+  return (struct TtyRgb){r, g, b, g_ttylut_[LUTINDEX(r, g, b)]};
+}
+
+static void rgb2ttylutn_base(struct TtyRgb *p, const uint8_t *r,
+                             const uint8_t *g, const uint8_t *b, size_t n) {
+  size_t i;
+  for (i = 0; i < n; ++i) {
+    p[i] = (struct TtyRgb){r[i], g[i], b[i],
+                           g_ttylut_[LUTINDEX(r[i], g[i], b[i])]};
+  }
+}
+
+#ifdef __x86_64__
+#pragma GCC push_options
+#pragma GCC target("avx2")
+static void rgb2ttylutn_avx2(struct TtyRgb *p, const uint8_t *r,
+                             const uint8_t *g, const uint8_t *b, size_t n) {
+  size_t i;
+  __m256i x, y, z, k;
+  for (i = 0; i + 8 <= n; i += 8) {
+    x = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const void *)(r + i)));
+    y = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const void *)(g + i)));
+    z = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const void *)(b + i)));
+    k = _mm256_or_si256(
+        _mm256_or_si256(
+            _mm256_slli_epi32(_mm256_srli_epi32(x, 8 - LUTBITS), 2 * LUTBITS),
+            _mm256_slli_epi32(_mm256_srli_epi32(y, 8 - LUTBITS), LUTBITS)),
+        _mm256_srli_epi32(z, 8 - LUTBITS));
+    k = _mm256_i32gather_epi32((const int *)g_ttylut_, k, 1);
+    x = _mm256_or_si256(
+        _mm256_or_si256(x, _mm256_slli_epi32(y, 8)),
+        _mm256_or_si256(_mm256_slli_epi32(z, 16), _mm256_slli_epi32(k, 24)));
+    _mm256_storeu_si256((void *)(p + i), x);
+  }
+  rgb2ttylutn_base(p + i, r + i, g + i, b + i, n - i);
+}
+#pragma GCC pop_options
+#endif /* __x86_64__ */
+
+/**
+ * Quantizes planar RGB row to ANSI using lookup table.
+ */
+void rgb2ttylutn_(struct TtyRgb *p, const uint8_t *r, const uint8_t *g,
+                  const uint8_t *b, size_t n) {
+  EnsureLut();
+  rgb2ttylutn_impl_(p, r, g, b, n);
+}
+
+/**
+ * Quantizes planar RGB row to 24-bit color.
+ */
+void rgb2xterm24n_(struct TtyRgb *p, const uint8_t *r, const uint8_t *g,
+                   const uint8_t *b, size_t n) {
+  size_t i;
+  for (i = 0; i < n; ++i) {
+    p[i] = (struct TtyRgb){r[i], g[i], b[i], 0};
+  }
+}
+
+/**
+ * Forgets lookup table, e.g. after palette changes.
+ */
+void rgb2ttylutreset_(void) {
+  g_ttylutok_ = false;
+}
+
+__attribute__((__constructor__)) static void rgb2ttylut_init(void) {
+  rgb2ttylutn_impl_ = rgb2ttylutn_base;
+#ifdef __x86_64__
+  if (X86_HAVE(AVX2)) {
+    rgb2ttylutn_impl_ = rgb2ttylutn_avx2;
+  }
+#endif
+}
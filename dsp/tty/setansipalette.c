@@ -16,9 +16,11 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "dsp/tty/internal.h"
 #include "dsp/tty/quant.h"
 #include "libc/str/str.h"
 
 void setansipalette(ttypalette_t palette) {
   memcpy(g_ansi2rgb_, palette, sizeof(struct TtyRgb) * 2 * 8);
+  rgb2ttylutreset_();
 }
@@ -33,7 +33,8 @@ textstartup void ttyquantsetup(enum TtyQuantizationAlgorithm alg,
                                enum TtyBlocksSelection blocks) {
   switch (alg) {
     case kTtyQuantAnsi:
-      TTYQUANT()->rgb2tty = rgb2ansi_;
+      TTYQUANT()->rgb2tty = rgb2ttylut_;
+      TTYQUANT()->rgb2ttyn = rgb2ttylutn_;
       TTYQUANT()->rgb2ttyf = rgb2ttyf2i_;
       TTYQUANT()->tty2rgb = tty2rgb_;
       TTYQUANT()->tty2rgbf = tty2rgbf_;
@@ -45,6 +46,7 @@ textstartup void ttyquantsetup(enum TtyQuantizationAlgorithm alg,
       break;
     case kTtyQuantTrue:
       TTYQUANT()->rgb2tty = rgb2xterm24_;
+      TTYQUANT()->rgb2ttyn = rgb2xterm24n_;
       TTYQUANT()->rgb2ttyf = rgb2tty24f_;
       TTYQUANT()->tty2rgb = tty2rgb24_;
       TTYQUANT()->tty2rgbf = tty2rgbf24_;
@@ -55,7 +57,8 @@ textstartup void ttyquantsetup(enum TtyQuantizationAlgorithm alg,
       TTYQUANT()->max = 256;
       break;
     case kTtyQuantXterm256:
-      TTYQUANT()->rgb2tty = rgb2ansi_;
+      TTYQUANT()->rgb2tty = rgb2ttylut_;
+      TTYQUANT()->rgb2ttyn = rgb2ttylutn_;
       TTYQUANT()->rgb2ttyf = rgb2ttyf2i_;
       TTYQUANT()->tty2rgb = tty2rgb_;
       TTYQUANT()->tty2rgbf = tty2rgbf_;
@@ -71,6 +74,15 @@ textstartup void ttyquantsetup(enum TtyQuantizationAlgorithm alg,
   TTYQUANT()->chans = chans;
   TTYQUANT()->alg = alg;
   TTYQUANT()->blocks = blocks;
+  rgb2ttylutreset_();
+}
+
+/**
+ * Chooses how nearest palette colors are measured.
+ */
+void ttyquantmetric(enum TtyQuantizationMetric metric) {
+  TTYQUANT()->metric = metric;
+  rgb2ttylutreset_();
 }
 
 __attribute__((__constructor__)) textstartup void ttyquant_init(void) {
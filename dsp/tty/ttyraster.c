@@ -28,10 +28,12 @@
 #include "libc/log/log.h"
 #include "libc/macros.h"
 #include "libc/math.h"
+#include "libc/mem/mem.h"
 #include "libc/nexgen32e/x86feature.h"
 #include "libc/runtime/runtime.h"
 #include "libc/stdio/stdio.h"
 #include "libc/str/str.h"
+#include "libc/x/x.h"
 
 #define SQR(X)        ((X) * (X))
 #define DIST(X, Y)    ((X) - (Y))
@@ -754,6 +756,22 @@ static dontinline char *CopyRun(char *v, size_t n,
   return v;
 }
 
+static struct Pick PickBlock(const struct TtyRgb chun[hasatleast 4]) {
+  if (ttyquant()->alg == kTtyQuantTrue) {
+    if (ttyquant()->blocks == kTtyBlocksCp437) {
+      return PickBlockCp437True(chun[TL], chun[TR], chun[BL], chun[BR]);
+    } else {
+      return PickBlockUnicodeTrue(chun[TL], chun[TR], chun[BL], chun[BR]);
+    }
+  } else {
+    if (ttyquant()->blocks == kTtyBlocksCp437) {
+      return PickBlockCp437Ansi(chun[TL], chun[TR], chun[BL], chun[BR]);
+    } else {
+      return PickBlockUnicodeAnsi(chun[TL], chun[TR], chun[BL], chun[BR]);
+    }
+  }
+}
+
 /**
  * Maps 2×2 pixel chunks onto ANSI UNICODE cells.
  * @note h/t Nick Black for his quadrant blitting work on notcurses
@@ -772,19 +790,7 @@ char *ttyraster(char *v, const struct TtyRgb *c, size_t yn, size_t xn,
     }
     for (x = 0; x < xn; x += 2, c += 2) {
       CopyChunk(chun, c, xn);
-      if (ttyquant()->alg == kTtyQuantTrue) {
-        if (ttyquant()->blocks == kTtyBlocksCp437) {
-          p = PickBlockCp437True(chun[TL], chun[TR], chun[BL], chun[BR]);
-        } else {
-          p = PickBlockUnicodeTrue(chun[TL], chun[TR], chun[BL], chun[BR]);
-        }
-      } else {
-        if (ttyquant()->blocks == kTtyBlocksCp437) {
-          p = PickBlockCp437Ansi(chun[TL], chun[TR], chun[BL], chun[BR]);
-        } else {
-          p = PickBlockUnicodeAnsi(chun[TL], chun[TR], chun[BL], chun[BR]);
-        }
-      }
+      p = PickBlock(chun);
       v = CopyBlock(v, chun, p, &bg, &fg, &glyph);
       memcpy(lastchunk, chun, sizeof(chun));
     }
@@ -792,3 +798,140 @@ char *ttyraster(char *v, const struct TtyRgb *c, size_t yn, size_t xn,
   v = stpcpy(v, "\e[0m");
   return v;
 }
+
+/*
+ * Cells are stored in a canonical form so that they can be compared:
+ * a blank cell has no foreground, and its glyph index always selects
+ * from the first row of kGlyphs. Whether a cell gets drawn inverted is
+ * decided when it's copied out, based on the colors in effect.
+ */
+static struct TtyCell GetCell(const struct TtyRgb *c, size_t xn) {
+  struct Pick p;
+  struct TtyCell cell;
+  struct TtyRgb chun[4];
+  CopyChunk(chun, c, xn);
+  p = PickBlock(chun);
+  cell.bg = chun[p.bg];
+  if (p.fg == 0xff || ttyeq(chun[p.bg], chun[p.fg])) {
+    cell.k = 0;
+    cell.fg = cell.bg;
+  } else {
+    cell.k = p.k;
+    cell.fg = chun[p.fg];
+  }
+  return cell;
+}
+
+static bool CellEq(struct TtyCell a, struct TtyCell b) {
+  return a.k == b.k && ttyeq(a.bg, b.bg) && ttyeq(a.fg, b.fg);
+}
+
+static char *CopyCell(char *v, struct TtyCell cell, struct TtyRgb *bg,
+                      struct TtyRgb *fg) {
+  unsigned i = 0;
+  if (!cell.k) {
+    if (ttyeq(*bg, cell.bg)) {
+      /* nothing to set */
+    } else if (ttyeq(*fg, cell.bg)) {
+      i = 1;
+    } else {
+      v = setbg(v, (*bg = cell.bg));
+    }
+  } else if (ttyeq(*bg, cell.bg) && ttyeq(*fg, cell.fg)) {
+    /* nothing to set */
+  } else if (ttyeq(*bg, cell.fg) && ttyeq(*fg, cell.bg)) {
+    i = 1;
+  } else if (ttyeq(*bg, cell.bg)) {
+    v = setfg(v, (*fg = cell.fg));
+  } else if (ttyeq(*fg, cell.fg)) {
+    v = setbg(v, (*bg = cell.bg));
+  } else {
+    v = setbgfg(v, (*bg = cell.bg), (*fg = cell.fg));
+  }
+  return CopyGlyph(v, kGlyphs[i][cell.k]);
+}
+
+/**
+ * Maps 2×2 pixel chunks onto ANSI UNICODE cells that changed.
+ *
+ * This is ttyraster() for a picture that's redrawn in the same place,
+ * e.g. video. The cells of each frame are diffed against those of the
+ * previous one, and only runs of cells that differ are sent, joined by
+ * cursor movement. Runs separated by a few unchanged cells are merged,
+ * since resending them is cheaper than moving the cursor. Colors carry
+ * over from one run to the next rather than being reset on each line.
+ *
+ * The first call, and any call after `d->dirty` is set or the size has
+ * changed, paints every cell. Callers should set `dirty` after anything
+ * else draws over the picture or clears the screen.
+ *
+ * @param d has the screen position of the picture's top left cell, and
+ *     is otherwise zero initialized, and must be freed w/ ttydeltafree()
+ * @param cur must have the actual cursor position, and is updated
+ * @param bg and fg are the colors in effect
+ * @return v + written, like mempcpy()
+ * @note yn and xn need to be even
+ */
+char *ttydelta(struct TtyDelta *d, char *v, struct TtyCursor *cur,
+               const struct TtyRgb *c, size_t yn, size_t xn, struct TtyRgb bg,
+               struct TtyRgb fg) {
+  unsigned y, x, i, j, cyn, cxn;
+  struct TtyCell *row, *old, *t;
+  cyn = yn / 2;
+  cxn = xn / 2;
+  if (d->yn != cyn || d->xn != cxn) {
+    free(d->old);
+    free(d->cur);
+    d->cur = xmalloc(cyn * cxn * sizeof(struct TtyCell));
+    d->old = xmalloc(cyn * cxn * sizeof(struct TtyCell));
+    d->yn = cyn;
+    d->xn = cxn;
+    d->dirty = true;
+  }
+  for (y = 0; y < cyn; ++y) {
+    for (x = 0; x < cxn; ++x) {
+      d->cur[y * cxn + x] = GetCell(c + y * 2 * xn + x * 2, xn);
+    }
+  }
+  for (y = 0; y < cyn; ++y) {
+    row = d->cur + y * cxn;
+    old = d->old + y * cxn;
+    for (x = 0; x < cxn;) {
+      if (!d->dirty && CellEq(row[x], old[x])) {
+        ++x;
+        continue;
+      }
+      for (i = j = x; j < cxn && j - i <= kTtyDeltaGap; ++j) {
+        if (d->dirty || !CellEq(row[j], old[j])) {
+          i = j;
+        }
+      }
+      v = ttymove(cur, v, d->y + y, d->x + x);
+      for (; x <= i; ++x) {
+        v = CopyCell(v, row[x], &bg, &fg);
+        cur->x++;
+      }
+      if (x == cxn) {
+        /* the terminal might be wrapping */
+        *v++ = '\r';
+        cur->x = 0;
+      }
+    }
+  }
+  t = d->old;
+  d->old = d->cur;
+  d->cur = t;
+  d->dirty = false;
+  v = stpcpy(v, "\e[0m");
+  return v;
+}
+
+/**
+ * Frees memory allocated by ttydelta().
+ */
+void ttydeltafree(struct TtyDelta *d) {
+  free(d->old);
+  free(d->cur);
+  d->old = d->cur = 0;
+  d->yn = d->xn = 0;
+}
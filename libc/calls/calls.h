@@ -198,6 +198,7 @@ int euidaccess(const char *, int) libcesque __read_only(1);
 int eaccess(const char *, int) libcesque __read_only(1);
 int getcpu(unsigned *, unsigned *) libcesque __write_only(1) __write_only(2);
 int close_range(unsigned, unsigned, unsigned) libcesque;
+int pidfd_open(int, unsigned) libcesque;
 #endif
 
 #if defined(_COSMO_SOURCE) || defined(_BSD_SOURCE)
@@ -16,6 +16,7 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/internal.h"
 #include "libc/calls/syscall_support-nt.internal.h"
 #include "libc/errno.h"
 #include "libc/limits.h"
@@ -27,6 +28,7 @@
 
 textwindows int sys_chdir_nt16(char16_t path[hasatleast PATH_MAX],
                                uint32_t len) {
+  __statcache_drop();
 
   // the win32 SetCurrentDirectory() API wants us to put back a trailing
   // slash that was removed earlier, when __mkntpath() normalized things
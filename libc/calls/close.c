@@ -99,6 +99,11 @@ static int close_impl(int fd) {
         if (_weaken(sys_closesocket_nt))
           rc = _weaken(sys_closesocket_nt)(f);
       break;
+    case kFdEpoll:
+      if (!__vforked || f->was_created_during_vfork)
+        if (_weaken(sys_epoll_close_nt))
+          rc = _weaken(sys_epoll_close_nt)(f);
+      break;
 #endif
     default:
       rc = ebadf();
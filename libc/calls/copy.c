@@ -17,38 +17,75 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/calls/calls.h"
+#include "libc/errno.h"
 #include "libc/macros.h"
-#include "libc/runtime/runtime.h"
+
+static bool copyfd_fallback(int err) {
+  return err == EXDEV ||       // different partitions
+         err == EINVAL ||      // possible w/ ecryptfs, or not a pipe
+         err == ENOSYS ||      // not supported by the os
+         err == ENOTSUP ||     // no fs support for it, e.g. /zip
+         err == EOPNOTSUPP ||  // technically the same
+         err == EBADF;         // output is O_APPEND, or a /zip file
+}
 
 /**
- * Copies data between file descriptors the old fashioned way.
+ * Copies data between file descriptors.
+ *
+ * This uses the fastest way the host system offers that stays inside
+ * the kernel. It tries copy_file_range() first, which on Linux and
+ * FreeBSD can share extents between files (e.g. reflinks on btrfs and
+ * xfs). On Linux splice() is used next, if one side is a pipe. If none
+ * of these work, data is copied the old fashioned way with read() and
+ * write(). Both file positions are advanced, in every case.
  *
  * This function is intended for simple programs without signals. If
  * signals are in play, then `SA_RESTART` needs to be used.
  *
  * @param in is input file descriptor
- * @param out is input file descriptor
+ * @param out is output file descriptor
  * @param n is number of bytes to exchange, or -1 for until eof
  * @return bytes successfully exchanged, or -1 w/ errno
  */
 ssize_t copyfd(int in, int out, size_t n) {
   size_t i;
-  char buf[512];
-  ssize_t dr, dw;
-  for (i = 0; i < n; i += dr) {
+  char buf[4096];
+  ssize_t dr, dw, rc = 0;
+  int e = errno;
+
+  // copy_file_range() may report eof early on pseudo files like those
+  // in /proc, so if nothing was copied, the slow path gets to confirm
+  for (i = 0; i < n; i += rc)
+    if ((rc = copy_file_range(in, 0, out, 0, MIN(n - i, 0x7ffff000), 0)) <= 0)
+      break;
+  if (i < n && rc == -1 && !copyfd_fallback(errno))
+    return -1;
+  if (i && !rc)
+    return i;
+
+  // splice() needs a pipe on at least one side
+  if (i < n && rc == -1) {
+    errno = e;
+    for (; i < n; i += rc)
+      if ((rc = splice(in, 0, out, 0, MIN(n - i, 0x7ffff000), 0)) <= 0)
+        break;
+    if (i < n && rc == -1 && !copyfd_fallback(errno))
+      return -1;
+    if (!rc)
+      return i;
+  }
+
+  // copy through userspace
+  errno = e;
+  for (; i < n; i += dr) {
     dr = read(in, buf, MIN(n - i, sizeof(buf)));
     if (dr == -1)
       return -1;
     if (!dr)
       break;
-    dw = write(out, buf, dr);
-    if (dw == -1)
-      return -1;
-    if (dw != dr) {
-      // POSIX requires atomic IO up to PIPE_BUF
-      // The minimum permissible PIPE_BUF is 512
-      notpossible;
-    }
+    for (rc = 0; rc < dr; rc += dw)
+      if ((dw = write(out, buf + rc, dr - rc)) == -1)
+        return -1;
   }
   return i;
 }
@@ -0,0 +1,117 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/struct/rseq.h"
+#include "libc/cosmo.h"
+#include "libc/dce.h"
+#include "libc/intrin/atomic.h"
+
+//
+// per-cpu counter
+//
+// each cpu shard has its own cache line, so threads incrementing the
+// counter at the same time don't bounce the line between their cores.
+//
+// on x86-64 linux we go one step further and use a restartable sequence
+// to add to the slot of the current cpu with a plain add instruction,
+// which needs no lock prefix since the kernel restarts the sequence if
+// the thread gets preempted or migrated before the add. because plain
+// adds and atomic adds mustn't target the same slot, threads which are
+// running on a cpu numbered COSMO_SHARDS or higher, or weren't able to
+// register with rseq, atomically add to an extra overflow slot instead
+//
+
+static void cosmo_counter_add_init(cosmo_counter_t *, long);
+static void (*cosmo_counter_impl)(cosmo_counter_t *,
+                                  long) = cosmo_counter_add_init;
+
+static void cosmo_counter_add_shard(cosmo_counter_t *c, long delta) {
+  atomic_fetch_add_explicit(&c->_slots[cosmo_shard()]._value, delta,
+                            memory_order_relaxed);
+}
+
+#ifdef __x86_64__
+static void cosmo_counter_add_rseq(cosmo_counter_t *c, long delta) {
+  struct rseq *rs = __get_rseq();
+  asm goto("\
+	.pushsection .rodata.rseq,\"a\",@progbits\n\
+	.balign	32\n\
+3:	.long	0,0\n\
+	.quad	1f,2f-1f,4f\n\
+	.popsection\n\
+6:	lea	3b(%%rip),%%rax\n\
+	mov	%%rax,%0\n\
+1:	movslq	%1,%%rax\n\
+	cmp	%2,%%rax\n\
+	jae	%l[overflow]\n\
+	shl	$6,%%rax\n\
+	add	%3,(%4,%%rax)\n\
+2:	jmp	5f\n\
+	.byte	0x0f,0xb9,0x3d\n\
+	.long	%c5\n\
+4:	jmp	6b\n\
+5:"
+           : /* no outputs */
+           : "m"(rs->rseq_cs), "m"(rs->cpu_id), "i"(COSMO_SHARDS),
+             "r"(delta), "r"(c->_slots), "i"(RSEQ_SIG)
+           : "rax", "memory", "cc"
+           : overflow);
+  return;
+overflow:
+  atomic_fetch_add_explicit(&c->_slots[COSMO_SHARDS]._value, delta,
+                            memory_order_relaxed);
+}
+#endif
+
+static void cosmo_counter_add_init(cosmo_counter_t *c, long delta) {
+  void (*impl)(cosmo_counter_t *, long) = cosmo_counter_add_shard;
+#ifdef __x86_64__
+  if (IsLinux() && __get_rseq()->cpu_id >= 0)
+    impl = cosmo_counter_add_rseq;
+#endif
+  cosmo_counter_impl = impl;
+  impl(c, delta);
+}
+
+/**
+ * Adds value to per-cpu counter.
+ *
+ * This is cheaper than an atomic increment of a shared variable, since
+ * it only touches the cache line of the cpu the caller is running on.
+ * On x86-64 Linux 4.18+ it doesn't even need to lock the memory bus.
+ *
+ * @param c is counter which may be statically initialized or zeroed
+ * @param delta is added to the counter, and may be negative
+ */
+void cosmo_counter_add(cosmo_counter_t *c, long delta) {
+  cosmo_counter_impl(c, delta);
+}
+
+/**
+ * Returns sum of per-cpu counter.
+ *
+ * This has to visit every shard, so it's more expensive than adding to
+ * the counter. If other threads are adding at the same time, the result
+ * will include some subset of their contributions.
+ */
+long cosmo_counter_get(cosmo_counter_t *c) {
+  unsigned long sum = 0;
+  for (int i = 0; i < COSMO_SHARDS + 1; ++i)
+    sum += atomic_load_explicit(&c->_slots[i]._value, memory_order_relaxed);
+  return sum;
+}
@@ -29,6 +29,7 @@
 #include "libc/sysv/pib.h"
 
 textwindows bool32 sys_fchmod_nt_handle(intptr_t handle, uint32_t mode) {
+  __statcache_drop();
 
   // get current information
   struct NtFileBasicInfo fbi;
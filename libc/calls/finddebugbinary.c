@@ -18,6 +18,7 @@
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "ape/sections.internal.h"
 #include "libc/atomic.h"
+#include "libc/intrin/atomic.h"
 #include "libc/calls/blockcancel.internal.h"
 #include "libc/calls/calls.h"
 #include "libc/calls/syscall-sysv.internal.h"
@@ -39,6 +40,7 @@
 
 static struct {
   atomic_uint once;
+  atomic_bool done;
   const char *res;
   char buf[PATH_MAX];
 } g_comdbg;
@@ -94,24 +96,25 @@ static bool IsMyDebugBinary(const char *path) {
   return res;
 }
 
-static void FindDebugBinaryInit(void) {
+static const char *FindDebugBinaryImpl(void) {
   const char *comdbg;
   if (issetugid())
-    return;
-  if ((comdbg = getenv("COMDBG"))) {
-    g_comdbg.res = comdbg;
-    return;
-  }
+    return 0;
+  if ((comdbg = getenv("COMDBG")))
+    return comdbg;
   char *prog = GetProgramExecutableName();
   for (int i = 0; i < ARRAYLEN(kDbgExts); ++i) {
     strlcpy(g_comdbg.buf, prog, sizeof(g_comdbg.buf));
     strlcat(g_comdbg.buf, kDbgExts[i], sizeof(g_comdbg.buf));
-    if (IsMyDebugBinary(g_comdbg.buf)) {
-      g_comdbg.res = g_comdbg.buf;
-      return;
-    }
+    if (IsMyDebugBinary(g_comdbg.buf))
+      return g_comdbg.buf;
   }
-  g_comdbg.res = prog;
+  return prog;
+}
+
+static void FindDebugBinaryInit(void) {
+  g_comdbg.res = FindDebugBinaryImpl();
+  atomic_store_explicit(&g_comdbg.done, true, memory_order_release);
 }
 
 /**
@@ -121,15 +124,30 @@ static void FindDebugBinaryInit(void) {
  * debug binary, in case the automatic heuristics fail. What we look for
  * is GetProgramExecutableName() with ".dbg", ".com.dbg", etc. appended.
  *
+ * The search happens the first time this is called, which opens files,
+ * so signal handlers should use FindDebugBinaryCached() instead. It's
+ * called by pledge(), unveil(), and ShowCrashReports() ahead of time,
+ * so that crash reports can still name the file once it's sandboxed.
+ *
  * @return path to debug binary, or NULL if we couldn't find it
- * @asyncsignalsafe
  */
 const char *FindDebugBinary(void) {
   cosmo_once(&g_comdbg.once, FindDebugBinaryInit);
   return g_comdbg.res;
 }
 
-// pay startup cost to make this signal safe from the user's perspective
-__attribute__((__constructor__(10))) static void FindDebugBinaryCtor(void) {
-  cosmo_once(&g_comdbg.once, FindDebugBinaryInit);
+/**
+ * Returns path of binary with debug information, if it's been found.
+ *
+ * This is the same as FindDebugBinary() except it won't go looking if
+ * it hasn't been called yet, in which case `program_invocation_name`
+ * is returned instead.
+ *
+ * @return path to debug binary, or NULL if we couldn't find it
+ * @asyncsignalsafe
+ */
+const char *FindDebugBinaryCached(void) {
+  if (atomic_load_explicit(&g_comdbg.done, memory_order_acquire))
+    return g_comdbg.res;
+  return program_invocation_name;
 }
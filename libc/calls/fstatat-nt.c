@@ -78,10 +78,14 @@ textwindows int sys_fstatat_nt(int dirfd, const char *path, struct stat *st,
   if (__mkntpathat(dirfd, path, path16) == -1)
     return -1;
 
+  // answer from a recent listing of the directory, if enabled
+  int rc;
+  if ((rc = __statcache_nt(path16, st)) != 1)
+    return rc;
+
   // open the file. we optimistically request read access because (a) we
   // want to know if the file is readable, and (b) we'll need to read
   // the first two bytes later to determine if it's an executable.
-  int rc;
   int64_t fh;
   int mode = 0444;
   uint32_t dwDesiredAccess = kNtFileGenericRead;
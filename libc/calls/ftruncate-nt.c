@@ -16,6 +16,7 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/internal.h"
 #include "libc/calls/sig.internal.h"
 #include "libc/calls/struct/rlimit.h"
 #include "libc/calls/syscall-nt.internal.h"
@@ -41,6 +42,7 @@ static inline void RaiseSignal(int sig) {
 }
 
 textwindows int sys_ftruncate_nt(int64_t handle, uint64_t length) {
+  __statcache_drop();
 
   // check file size limit
   if (length > ~__get_pib()->rlimit[RLIMIT_FSIZE].rlim_cur) {
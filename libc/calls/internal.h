@@ -16,6 +16,7 @@ COSMOPOLITAN_C_START_
 #define kIoMotion ((const int8_t[3]){1, 0, 0})
 
 extern const struct Fd kEmptyFd;
+extern atomic_uint __statcache_gen;
 
 int __reservefd(int);
 int __reservefd_unlocked(int);
@@ -30,12 +31,15 @@ int64_t GetConsoleInputHandle(void);
 int64_t GetConsoleOutputHandle(void);
 void EchoConsoleNt(const char *, size_t, bool);
 int IsWindowsExecutable(int64_t, const char16_t *);
+int IsWindowsExecutableName(const char16_t *);
 void InterceptTerminalCommands(const char *, size_t);
 void sys_read_nt_wipe_keystrokes(void);
+void sys_poll_nt_wipe(void);
 int __generate_pid(atomic_ulong **);
+void __statcache_wipe(void);
 
 forceinline bool __isfdopen(int fd) {
-  if (fd < __get_pib()->fds.n) {
+  if (fd < atomic_load_explicit(&__get_pib()->fds.n, memory_order_acquire)) {
     char kind = __get_pib()->fds.p[fd].kind;
     return kind != kFdEmpty && kind != kFdReserved;
   } else {
@@ -44,7 +48,13 @@ forceinline bool __isfdopen(int fd) {
 }
 
 forceinline bool __isfdkind(int fd, int kind) {
-  return fd < __get_pib()->fds.n && __get_pib()->fds.p[fd].kind == kind;
+  return fd < atomic_load_explicit(&__get_pib()->fds.n, memory_order_acquire) &&
+         __get_pib()->fds.p[fd].kind == kind;
+}
+
+// forgets directory listings cached by stat() on windows
+forceinline void __statcache_drop(void) {
+  atomic_fetch_add_explicit(&__statcache_gen, 1, memory_order_release);
 }
 
 int _check_signal(bool);
@@ -0,0 +1,129 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/kevent.internal.h"
+#include "libc/assert.h"
+#include "libc/dce.h"
+
+// kevent() abstraction for FreeBSD, OpenBSD, NetBSD and XNU
+
+struct kevent_freebsd {
+  uintptr_t ident;
+  int16_t filter;
+  uint16_t flags;
+  uint32_t fflags;
+  int64_t data;
+  uint64_t udata;
+  uint64_t ext[4];
+};
+
+struct kevent_openbsd {
+  uintptr_t ident;
+  int16_t filter;
+  uint16_t flags;
+  uint32_t fflags;
+  int64_t data;
+  uint64_t udata;
+};
+
+struct kevent_netbsd {
+  uintptr_t ident;
+  uint32_t filter;
+  uint32_t flags;
+  uint32_t fflags;
+  int64_t data;
+  uint64_t udata;
+};
+
+struct kevent_xnu {  // kevent64_s
+  uint64_t ident;
+  int16_t filter;
+  uint16_t flags;
+  uint32_t fflags;
+  int64_t data;
+  uint64_t udata;
+  uint64_t ext[2];
+};
+
+static_assert(sizeof(struct kevent_freebsd) == KEVENT_MAX);
+static_assert(sizeof(struct kevent_xnu) <= KEVENT_MAX);
+
+size_t __kevent_size(void) {
+  if (IsFreebsd())
+    return sizeof(struct kevent_freebsd);
+  if (IsOpenbsd())
+    return sizeof(struct kevent_openbsd);
+  if (IsNetbsd())
+    return sizeof(struct kevent_netbsd);
+  return sizeof(struct kevent_xnu);
+}
+
+void __kevent_pack(void *p, const struct Kevent *k) {
+  if (IsFreebsd()) {
+    struct kevent_freebsd *e = p;
+    *e = (struct kevent_freebsd){k->ident, k->filter, k->flags, k->fflags, 0,
+                                 k->udata};
+  } else if (IsOpenbsd()) {
+    struct kevent_openbsd *e = p;
+    *e = (struct kevent_openbsd){k->ident, k->filter, k->flags, k->fflags, 0,
+                                 k->udata};
+  } else if (IsNetbsd()) {
+    struct kevent_netbsd *e = p;
+    *e = (struct kevent_netbsd){k->ident, k->filter, k->flags, k->fflags, 0,
+                                k->udata};
+  } else {
+    struct kevent_xnu *e = p;
+    *e = (struct kevent_xnu){k->ident, k->filter, k->flags, k->fflags, 0,
+                             k->udata};
+  }
+}
+
+void __kevent_unpack(struct Kevent *k, const void *p) {
+  if (IsFreebsd()) {
+    const struct kevent_freebsd *e = p;
+    *k = (struct Kevent){e->ident, e->filter, e->flags, e->fflags, e->udata};
+  } else if (IsOpenbsd()) {
+    const struct kevent_openbsd *e = p;
+    *k = (struct Kevent){e->ident, e->filter, e->flags, e->fflags, e->udata};
+  } else if (IsNetbsd()) {
+    const struct kevent_netbsd *e = p;
+    *k = (struct Kevent){e->ident, (int)e->filter, e->flags, e->fflags,
+                         e->udata};
+  } else {
+    const struct kevent_xnu *e = p;
+    *k = (struct Kevent){e->ident, e->filter, e->flags, e->fflags, e->udata};
+  }
+}
+
+int __kevent_call(int kq, const void *changes, int nchanges, void *events,
+                  int nevents, const struct timespec *timeout) {
+  if (IsXnu()) {
+    // kevent64(kq, changes, nchanges, events, nevents, flags, timeout)
+    return sys_kevent(kq, changes, nchanges, events, nevents, 0, timeout);
+  } else {
+    return sys_kevent(kq, changes, nchanges, events, nevents, timeout, 0);
+  }
+}
+
+// applies a single change so failures are reported through errno
+int __kevent_change(int kq, uint64_t ident, int filter, unsigned flags,
+                    unsigned fflags, uint64_t udata) {
+  char buf[KEVENT_MAX];
+  __kevent_pack(buf, &(struct Kevent){ident, filter, flags, fflags, udata});
+  return __kevent_call(kq, buf, 1, 0, 0, 0);
+}
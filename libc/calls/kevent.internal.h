@@ -0,0 +1,43 @@
+#ifndef COSMOPOLITAN_LIBC_CALLS_KEVENT_INTERNAL_H_
+#define COSMOPOLITAN_LIBC_CALLS_KEVENT_INTERNAL_H_
+#include "libc/calls/struct/timespec.h"
+#include "libc/dce.h"
+COSMOPOLITAN_C_START_
+
+#define EV_ADD     0x0001
+#define EV_DELETE  0x0002
+#define EV_ONESHOT 0x0010
+#define EV_CLEAR   0x0020
+#define EV_ERROR   0x4000
+#define EV_EOF     0x8000
+
+#define EVFILT_READ  (IsNetbsd() ? 0 : -1)
+#define EVFILT_WRITE (IsNetbsd() ? 1 : -2)
+#define EVFILT_PROC  (IsNetbsd() ? 4 : -5)
+
+#define NOTE_EXIT 0x80000000u
+
+#define KEVENT_MAX 64 /* bytes of largest kevent struct, i.e. freebsd */
+
+/* kernel independent kevent, see __kevent_pack() */
+struct Kevent {
+  uint64_t ident;
+  int filter;
+  unsigned flags;
+  unsigned fflags;
+  uint64_t udata;
+};
+
+int sys_kqueue(void);
+int sys_kevent(int, const void *, int, void *, int, const void *,
+               const void *);
+
+size_t __kevent_size(void);
+void __kevent_pack(void *, const struct Kevent *);
+void __kevent_unpack(struct Kevent *, const void *);
+int __kevent_call(int, const void *, int, void *, int,
+                  const struct timespec *);
+int __kevent_change(int, uint64_t, int, unsigned, unsigned, uint64_t);
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_LIBC_CALLS_KEVENT_INTERNAL_H_ */
@@ -17,6 +17,7 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/calls/calls.h"
+#include "libc/calls/internal.h"
 #include "libc/calls/syscall_support-nt.internal.h"
 #include "libc/intrin/strace.h"
 #include "libc/limits.h"
@@ -27,6 +28,7 @@
 
 textwindows int sys_linkat_nt(int olddirfd, const char *oldpath,  //
                               int newdirfd, const char *newpath) {
+  __statcache_drop();
 #pragma GCC push_options
 #pragma GCC diagnostic ignored "-Wframe-larger-than="
   struct {
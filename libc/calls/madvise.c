@@ -28,6 +28,9 @@
 /**
  * Advises kernel about memory intentions.
  *
+ * `MADV_HUGEPAGE` and `MADV_NOHUGEPAGE` control transparent huge pages
+ * on Linux. They're hints, so other platforms just report success.
+ *
  * @return 0 on success, or -1 w/ errno
  * @raise EINVAL if `advice` isn't valid
  * @raise EINVAL if `len` is negative
@@ -43,6 +46,9 @@ int madvise(void *addr, size_t len, int advice) {
     case MADV_SEQUENTIAL:
     case MADV_DONTNEED:
       break;
+    case MADV_HUGEPAGE:
+    case MADV_NOHUGEPAGE:
+      break;
     default:
       return einval();
   }
@@ -56,6 +62,9 @@ int madvise(void *addr, size_t len, int advice) {
   if ((uintptr_t)addr & (__pagesize - 1))
     return einval();
 
+  if (!IsLinux() && (advice == MADV_HUGEPAGE || advice == MADV_NOHUGEPAGE))
+    return 0;
+
   int rc = 0;
   if (!IsWindows()) {
     rc = sys_madvise(addr, len, advice);
@@ -276,6 +276,8 @@ textwindows int sys_open_nt(int dirfd, const char *file, uint32_t flags,
     mode = 0;
   if (mode & 07000)
     return eperm();
+  if ((flags & O_ACCMODE) != O_RDONLY || (flags & (O_CREAT | O_TRUNC)))
+    __statcache_drop();
   BLOCK_SIGNALS;
   if ((newfd = __reservefd(-1)) != -1) {
     if (sys_open_nt_dispatch(dirfd, file, flags, mode, newfd) != -1) {
@@ -259,6 +259,8 @@ int pledge(const char *promises, const char *execpromises) {
   unsigned long ipromises, iexecpromises;
   if (_weaken(GetSymbolTable))
     _weaken(GetSymbolTable)();
+  if (_weaken(FindDebugBinary))
+    _weaken(FindDebugBinary)();
   if (!promises) {
     // OpenBSD says NULL argument means it doesn't change, i.e.
     // pledge(0,0) on OpenBSD does nothing. The Cosmopolitan Libc
@@ -32,14 +32,26 @@
 #include "libc/intrin/weaken.h"
 #include "libc/macros.h"
 #include "libc/nt/console.h"
+#include "libc/nt/enum/accessmask.h"
+#include "libc/nt/enum/afd.h"
+#include "libc/nt/enum/filesharemode.h"
 #include "libc/nt/enum/filetype.h"
+#include "libc/nt/enum/ioctl.h"
+#include "libc/nt/enum/sio.h"
+#include "libc/nt/enum/status.h"
 #include "libc/nt/enum/wait.h"
 #include "libc/nt/errors.h"
 #include "libc/nt/events.h"
 #include "libc/nt/files.h"
 #include "libc/nt/ipc.h"
+#include "libc/nt/memory.h"
+#include "libc/nt/nt/file.h"
+#include "libc/nt/process.h"
 #include "libc/nt/runtime.h"
-#include "libc/nt/struct/pollfd.h"
+#include "libc/nt/struct/afd.h"
+#include "libc/nt/struct/iostatusblock.h"
+#include "libc/nt/struct/objectattributes.h"
+#include "libc/nt/struct/unicodestring.h"
 #include "libc/nt/synchronization.h"
 #include "libc/nt/thunk/msabi.h"
 #include "libc/nt/time.h"
@@ -66,16 +78,197 @@
 #define POLLPRI_    0x0400  // MSDN unsupported
 // </sync libc/sysv/consts.sh>
 
+// this many fds may be polled without using the heap
+#define POLL_NT_STACK 32
+
+// WaitForMultipleObjects() slots left after afd and signal events
+#define POLL_NT_WAITS 62
+
+// bytes of bookkeeping needed to poll n fds
+#define POLL_NT_AFDSIZE(n) \
+  (offsetof(struct NtAfdPollInfo, Handles) + \
+   (n) * sizeof(struct NtAfdPollHandleInfo))
+#define POLL_NT_SIZE(n) \
+  (2 * POLL_NT_AFDSIZE(n) + ((n) + 2) * sizeof(int64_t) + 2 * (n) * sizeof(int))
+
 __msabi extern typeof(WaitForMultipleObjects)
     *const __imp_WaitForMultipleObjects;
 
-textwindows static uint32_t sys_poll_nt_waitms(struct timespec deadline) {
+struct PollNt {
+  int sn;                         // number of sockets
+  int pn;                         // number of files, pipes, and consoles
+  int *sockindices;               // sn indices into caller's fds
+  int *fileindices;               // pn indices into caller's fds
+  int64_t *filehands;             // pn handles plus two wait slots
+  int64_t afd;                    // afd device handle
+  int64_t event;                  // signalled when afd request completes
+  uint32_t afdsize;               // size of each afd poll buffer
+  bool pending;                   // afd request is in flight
+  struct NtAfdPollInfo *sockin;   // sockets and events we care about
+  struct NtAfdPollInfo *sockout;  // sockets that have become ready
+  struct NtIoStatusBlock iosb;
+};
+
+static atomic_long sys_poll_nt_afd_handle;
+
+textwindows void sys_poll_nt_wipe(void) {
+  // our afd handle isn't inherited across fork
+  atomic_store_explicit(&sys_poll_nt_afd_handle, 0, memory_order_relaxed);
+}
+
+// Returns handle to the ancillary function driver.
+//
+// This is the same interface WSAPoll() uses under the hood to ask the
+// winsock kernel driver which sockets are ready. One request can watch
+// any number of sockets, and it completes asynchronously by signalling
+// an event, so we're able to wait on sockets, pipes, consoles, signals
+// all at the same time, without a timer based busy loop.
+textwindows static int64_t sys_poll_nt_afd(void) {
+  NtStatus st;
+  int64_t h, old;
+  struct NtIoStatusBlock iosb;
+  static char16_t name[] = u"\\Device\\Afd\\Cosmopolitan";
+  struct NtUnicodeString path = {sizeof(name) - 2, sizeof(name), name};
+  struct NtObjectAttributes attr = {sizeof(attr), 0, &path};
+  if ((h = atomic_load_explicit(&sys_poll_nt_afd_handle, memory_order_acquire)))
+    return h;
+  st = NtCreateFile(&h, kNtSynchronize, &attr, &iosb, 0, 0,
+                    kNtFileShareRead | kNtFileShareWrite, 1 /* FILE_OPEN */,
+                    0, 0, 0);
+  if (!NtSuccess(st)) {
+    SetLastError(RtlNtStatusToDosError(st));
+    return -1;
+  }
+  old = 0;
+  if (!atomic_compare_exchange_strong_explicit(&sys_poll_nt_afd_handle, &old,
+                                               h, memory_order_acq_rel,
+                                               memory_order_acquire)) {
+    CloseHandle(h);
+    h = old;
+  }
+  return h;
+}
+
+// Returns socket handle that afd knows about.
+//
+// Layered service providers may wrap the sockets winsock gives us. We
+// need to unwrap them, since afd is only able to poll the base socket.
+textwindows static int64_t sys_poll_nt_basehandle(int64_t h) {
+  uint32_t bytes;
+  int64_t base;
+  if (WSAIoctl(h, kNtSioBaseHandle, 0, 0, &base, sizeof(base), &bytes, 0,
+               0) != -1)
+    return base;
+  if (WSAIoctl(h, kNtSioBspHandlePoll, 0, 0, &base, sizeof(base), &bytes, 0,
+               0) != -1)
+    return base;
+  return h;
+}
+
+textwindows static uint32_t sys_poll_nt_afd_events(int events) {
+  uint32_t afd = kNtAfdPollDisconnect | kNtAfdPollAbort |
+                 kNtAfdPollLocalClose | kNtAfdPollConnectFail;
+  if (events & POLLRDNORM_)
+    afd |= kNtAfdPollReceive | kNtAfdPollAccept;
+  if (events & POLLRDBAND_)
+    afd |= kNtAfdPollReceiveExpedited;
+  if (events & POLLWRNORM_)
+    afd |= kNtAfdPollSend;
+  return afd;
+}
+
+textwindows static int sys_poll_nt_afd_revents(uint32_t afd, int events) {
+  int revents = 0;
+  if (afd & (kNtAfdPollReceive | kNtAfdPollAccept))
+    revents |= POLLRDNORM_;
+  if (afd & kNtAfdPollReceiveExpedited)
+    revents |= POLLRDBAND_;
+  if (afd & kNtAfdPollSend)
+    revents |= POLLWRNORM_;
+  if (afd & kNtAfdPollDisconnect)
+    revents |= POLLRDNORM_ | POLLHUP_;  // same as WSAPoll()
+  if (afd & kNtAfdPollAbort)
+    revents |= POLLHUP_;
+  if (afd & kNtAfdPollConnectFail)
+    revents |= POLLERR_;
+  if (afd & kNtAfdPollLocalClose)
+    revents |= POLLNVAL_;
+  return revents & (events | POLLERR_ | POLLHUP_ | POLLNVAL_);
+}
+
+// Submits afd request for socket readiness.
+//
+// If `block` is false then the request completes as soon as the kernel
+// has looked at each socket. Otherwise it stays in flight until one of
+// them becomes ready, or until it's canceled.
+textwindows static int sys_poll_nt_afd_start(struct PollNt *p, bool block) {
+  NtStatus st;
+  p->sockin->Timeout = block ? INT64_MAX : 0;
+  p->sockin->NumberOfHandles = p->sn;
+  p->sockin->Exclusive = false;
+  p->iosb.Status = kNtStatusPending;
+  st = NtDeviceIoControlFile(p->afd, p->event, 0, 0, &p->iosb, kNtIoctlAfdPoll,
+                             p->sockin, p->afdsize, p->sockout, p->afdsize);
+  if (st != kNtStatusPending && !NtSuccess(st)) {
+    SetLastError(RtlNtStatusToDosError(st));
+    return __winerr();
+  }
+  p->pending = true;
+  return 0;
+}
+
+// Waits for afd request to complete, canceling it if it hasn't.
+textwindows static void sys_poll_nt_afd_wait(struct PollNt *p) {
+  struct NtIoStatusBlock cancel;
+  if (!p->pending)
+    return;
+  if (WaitForSingleObject(p->event, 0)) {
+    NtCancelIoFileEx(p->afd, &p->iosb, &cancel);
+    WaitForSingleObject(p->event, -1u);
+  }
+  p->pending = false;
+}
+
+// Copies socket events out of completed afd request.
+textwindows static int sys_poll_nt_afd_harvest(struct PollNt *p,
+                                               struct pollfd *fds) {
+  int i, j, k, fi, ev, rc;
+  if (p->iosb.Status == kNtStatusCancelled)
+    return 0;
+  if (!NtSuccess(p->iosb.Status)) {
+    SetLastError(RtlNtStatusToDosError(p->iosb.Status));
+    return __winerr();
+  }
+  for (rc = j = k = 0; k < p->sockout->NumberOfHandles; ++k) {
+    // afd only hands back the sockets which are ready, and it does so in
+    // the order we gave them, so this search is normally linear overall
+    for (i = 0; i < p->sn; ++i) {
+      if (p->sockin->Handles[j].Handle == p->sockout->Handles[k].Handle)
+        break;
+      if (++j == p->sn)
+        j = 0;
+    }
+    if (i == p->sn)
+      continue;
+    fi = p->sockindices[j];
+    if (++j == p->sn)
+      j = 0;
+    ev = sys_poll_nt_afd_revents(p->sockout->Handles[k].Events,
+                                 fds[fi].events);
+    rc += ev && !fds[fi].revents;
+    fds[fi].revents |= ev;
+  }
+  return rc;
+}
+
+textwindows static uint32_t sys_poll_nt_waitms(struct timespec deadline,
+                                               bool rescan) {
   struct timespec now = sys_clock_gettime_monotonic_nt();
   if (timespec_cmp(now, deadline) < 0) {
     struct timespec remain = timespec_sub(deadline, now);
     int64_t millis = timespec_tomillis(remain);
     uint32_t waitfor = MIN(millis, 0xffffffffu);
-    return MIN(waitfor, POLL_INTERVAL_MS);
+    return rescan ? MIN(waitfor, POLL_INTERVAL_MS) : waitfor;
   } else {
     return 0;  // we timed out
   }
@@ -88,13 +281,11 @@ textwindows static uint32_t sys_poll_nt_waitms(struct timespec deadline) {
 // both signals and posix thread cancelation, while the poll is polling
 textwindows static int sys_poll_nt_actual(struct pollfd *fds, uint64_t nfds,
                                           struct timespec deadline,
-                                          sigset_t waitmask) {
-  int fileindices[64];
-  int sockindices[64];
-  int64_t filehands[64];
-  int i, rc, ev, kind, gotsocks;
-  struct sys_pollfd_nt sockfds[64];
-  uint32_t cm, fi, sn, pn, avail, waitfor, already_slept;
+                                          sigset_t waitmask,
+                                          struct PollNt *p) {
+  struct Fd *f;
+  int i, rc, ev, got;
+  uint32_t cm, fi, nh, pw, avail, waitfor;
 
   // ensure revents is cleared
   for (i = 0; i < nfds; ++i)
@@ -103,28 +294,25 @@ textwindows static int sys_poll_nt_actual(struct pollfd *fds, uint64_t nfds,
   // divide files from sockets
   // check for invalid file descriptors
   __fds_lock();
-  for (rc = sn = pn = i = 0; i < nfds; ++i) {
+  for (rc = i = 0; i < nfds; ++i) {
     if (fds[i].fd < 0)
       continue;
     if (__isfdopen(fds[i].fd)) {
-      kind = __get_pib()->fds.p[fds[i].fd].kind;
-      if (kind == kFdSocket) {
-        // we can use WSAPoll() for these fds
-        unassert(sn < ARRAYLEN(sockfds));
-        // WSAPoll whines if we pass POLLNVAL, POLLHUP, or POLLERR.
-        sockindices[sn] = i;
-        sockfds[sn].handle = __get_pib()->fds.p[fds[i].fd].handle;
-        sockfds[sn].events =
-            fds[i].events & (POLLRDNORM_ | POLLRDBAND_ | POLLWRNORM_);
-        sockfds[sn].revents = 0;
-        ++sn;
-      } else if (kind == kFdFile || kind == kFdConsole) {
+      f = __get_pib()->fds.p + fds[i].fd;
+      if (f->kind == kFdSocket) {
+        // we can use the afd driver for these fds
+        p->sockindices[p->sn] = i;
+        p->sockin->Handles[p->sn].Handle = f->handle;
+        p->sockin->Handles[p->sn].Events = sys_poll_nt_afd_events(fds[i].events);
+        p->sockin->Handles[p->sn].Status = 0;
+        ++p->sn;
+      } else if (f->kind == kFdFile || f->kind == kFdConsole) {
         // we can use WaitForMultipleObjects() for these fds
-        unassert(pn < ARRAYLEN(fileindices) - 1);  // last slot for signal event
-        fileindices[pn] = i;
-        filehands[pn] = __get_pib()->fds.p[fds[i].fd].handle;
-        ++pn;
-      } else if (kind == kFdDevNull || kind == kFdDevRandom || kind == kFdZip) {
+        p->fileindices[p->pn] = i;
+        p->filehands[p->pn] = f->handle;
+        ++p->pn;
+      } else if (f->kind == kFdDevNull || f->kind == kFdDevRandom ||
+                 f->kind == kFdZip) {
         // we can't wait on these kinds via win32
         if (fds[i].events & (POLLRDNORM_ | POLLWRNORM_)) {
           // the linux kernel does this irrespective of oflags
@@ -141,8 +329,21 @@ textwindows static int sys_poll_nt_actual(struct pollfd *fds, uint64_t nfds,
     rc += !!fds[i].revents;
   }
   __fds_unlock();
-  if (rc == -1)
-    return rc;
+
+  // prepare to ask the kernel about sockets
+  if (p->sn) {
+    for (i = 0; i < p->sn; ++i)
+      p->sockin->Handles[i].Handle =
+          sys_poll_nt_basehandle(p->sockin->Handles[i].Handle);
+    if ((p->afd = sys_poll_nt_afd()) == -1)
+      return __winerr();
+    if (!(p->event = CreateEvent(0, true, false, 0)))
+      return __winerr();
+  }
+
+  // the last two wait slots are for the afd and signal events. we can't
+  // wait on more files than that, so the rest get checked when we rescan
+  pw = MIN(p->pn, POLL_NT_WAITS);
 
   // perform poll operation
   for (;;) {
@@ -150,8 +351,8 @@ textwindows static int sys_poll_nt_actual(struct pollfd *fds, uint64_t nfds,
     // check input status of pipes / consoles without blocking
     // this ensures any socket fds won't starve them of events
     // we can't poll file handles, so we just mark those ready
-    for (i = 0; i < pn; ++i) {
-      fi = fileindices[i];
+    for (i = 0; i < p->pn; ++i) {
+      fi = p->fileindices[i];
       ev = fds[fi].events;
       ev &= POLLRDNORM_ | POLLWRNORM_;
       if ((__get_pib()->fds.p[fds[fi].fd].flags & O_ACCMODE) == O_RDONLY)
@@ -160,8 +361,8 @@ textwindows static int sys_poll_nt_actual(struct pollfd *fds, uint64_t nfds,
         ev &= ~POLLRDNORM_;
       if ((ev & POLLWRNORM_) && !(ev & POLLRDNORM_)) {
         fds[fi].revents = fds[fi].events & (POLLRDNORM_ | POLLWRNORM_);
-      } else if (GetFileType(filehands[i]) == kNtFileTypePipe) {
-        if (PeekNamedPipe(filehands[i], 0, 0, 0, &avail, 0)) {
+      } else if (GetFileType(p->filehands[i]) == kNtFileTypePipe) {
+        if (PeekNamedPipe(p->filehands[i], 0, 0, 0, &avail, 0)) {
           if (avail)
             fds[fi].revents = POLLRDNORM_;
         } else if (GetLastError() == kNtErrorHandleEof ||
@@ -170,7 +371,7 @@ textwindows static int sys_poll_nt_actual(struct pollfd *fds, uint64_t nfds,
         } else {
           fds[fi].revents = POLLERR_;
         }
-      } else if (GetConsoleMode(filehands[i], &cm)) {
+      } else if (GetConsoleMode(p->filehands[i], &cm)) {
         switch (CountConsoleInputBytes()) {
           case 0:
             fds[fi].revents = fds[fi].events & POLLWRNORM_;
@@ -189,111 +390,105 @@ textwindows static int sys_poll_nt_actual(struct pollfd *fds, uint64_t nfds,
     }
 
     // determine how long to wait
-    waitfor = sys_poll_nt_waitms(deadline);
+    // pipes and consoles need to be rescanned now and then, but sockets
+    // tell us when they're ready, so we can sleep until the deadline
+    waitfor = sys_poll_nt_waitms(deadline, p->pn);
 
     // check for events and/or readiness on sockets
     // we always do this due to issues with POLLOUT
-    if (sn) {
-      // if we need to wait, then we prefer to wait inside WSAPoll()
-      // this ensures network events are received in ~10µs not ~10ms
-      if (!rc && waitfor) {
-        if (__sigcheck(waitmask, false))
-          return -1;
-        already_slept = waitfor;
-      } else {
-        already_slept = 0;
-      }
-      if ((gotsocks = WSAPoll(sockfds, sn, already_slept)) == -1)
-        return __winsockerr();
-      if (gotsocks) {
-        for (i = 0; i < sn; ++i)
-          if (sockfds[i].revents) {
-            fds[sockindices[i]].revents = sockfds[i].revents;
-            ++rc;
-          }
-      } else if (already_slept) {
-        if (__sigcheck(waitmask, false))
+    // if we need to wait, the request stays in flight until we're done
+    if (p->sn) {
+      if (sys_poll_nt_afd_start(p, !rc && waitfor) == -1)
+        return -1;
+      if (rc || !waitfor) {
+        sys_poll_nt_afd_wait(p);
+        if ((got = sys_poll_nt_afd_harvest(p, fds)) == -1)
           return -1;
+        rc += got;
       }
-    } else {
-      already_slept = 0;
     }
 
     // return if we observed events
     if (rc || !waitfor)
       break;
 
-    // if nothing has happened and we haven't already waited in poll()
-    // then we can wait on consoles, pipes, and signals simultaneously
-    // this ensures low latency for apps like emacs which with no sock
-    // here we shall actually report that something can be written too
-    if (!already_slept) {
-      if (!(filehands[pn] = __interruptible_start(waitmask)))
-        return __winerr();
-      //!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!//
-      int sig = 0;
-      uint32_t wi = pn;
-      if (!_is_canceled() &&
-          !(_weaken(__sig_get) && (sig = _weaken(__sig_get)(waitmask))))
-        wi = __imp_WaitForMultipleObjects(pn + 1, filehands, 0, waitfor);
-      //!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!//
-      __interruptible_end();
-      if (wi == -1u)
-        // win32 wait failure
-        return __winerr();
-      if (wi == pn) {
-        // our signal event was signalled
-        int handler_was_called = 0;
-        if (sig)
-          handler_was_called = _weaken(__sig_relay)(sig, SI_KERNEL, waitmask);
-        if (_check_cancel() == -1)
-          return -1;
-        if (handler_was_called)
-          return eintr();
-      } else if ((wi ^ kNtWaitAbandoned) < pn) {
-        // this is possibly because a process or thread was killed
-        fds[fileindices[wi ^ kNtWaitAbandoned]].revents = POLLERR_;
-        ++rc;
-      } else if (wi < pn) {
-        fi = fileindices[wi];
-        // one of the handles we polled is ready for fi/o
-        if (GetConsoleMode(filehands[wi], &cm)) {
-          switch (CountConsoleInputBytes()) {
-            case 0:
-              // it's possible there was input and it was handled by the
-              // ICANON reader, and therefore should not be reported yet
-              if (fds[fi].events & POLLWRNORM_)
-                fds[fi].revents = POLLWRNORM_;
-              break;
-            case -1:
-              fds[fi].revents = POLLHUP_;
-              break;
-            default:
-              fds[fi].revents = fds[fi].events & (POLLRDNORM_ | POLLWRNORM_);
-              break;
-          }
-        } else if (GetFileType(filehands[wi]) == kNtFileTypePipe) {
-          if ((fds[fi].events & POLLRDNORM_) &&
-              (__get_pib()->fds.p[fds[fi].fd].flags & O_ACCMODE) != O_WRONLY) {
-            if (PeekNamedPipe(filehands[wi], 0, 0, 0, &avail, 0)) {
-              fds[fi].revents = fds[fi].events & (POLLRDNORM_ | POLLWRNORM_);
-            } else if (GetLastError() == kNtErrorHandleEof ||
-                       GetLastError() == kNtErrorBrokenPipe) {
-              fds[fi].revents = POLLHUP_;
-            } else {
-              fds[fi].revents = POLLERR_;
-            }
-          } else {
+    // nothing has happened yet, so wait on consoles, pipes, sockets, and
+    // signals simultaneously. this ensures network events are received
+    // in microseconds, and it gives low latency to apps like emacs too
+    nh = pw;
+    if (p->pending)
+      p->filehands[nh++] = p->event;
+    if (!(p->filehands[nh] = __interruptible_start(waitmask)))
+      return __winerr();
+    //!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!//
+    int sig = 0;
+    uint32_t wi = nh;
+    if (!_is_canceled() &&
+        !(_weaken(__sig_get) && (sig = _weaken(__sig_get)(waitmask))))
+      wi = __imp_WaitForMultipleObjects(nh + 1, p->filehands, 0, waitfor);
+    //!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!/!//
+    __interruptible_end();
+    if (p->pending) {
+      sys_poll_nt_afd_wait(p);
+      if ((got = sys_poll_nt_afd_harvest(p, fds)) == -1)
+        return -1;
+      rc += got;
+    }
+    if (wi == -1u)
+      // win32 wait failure
+      return __winerr();
+    if (wi == nh) {
+      // our signal event was signalled
+      int handler_was_called = 0;
+      if (sig)
+        handler_was_called = _weaken(__sig_relay)(sig, SI_KERNEL, waitmask);
+      if (_check_cancel() == -1)
+        return -1;
+      if (handler_was_called)
+        return eintr();
+    } else if ((wi ^ kNtWaitAbandoned) < pw) {
+      // this is possibly because a process or thread was killed
+      fds[p->fileindices[wi ^ kNtWaitAbandoned]].revents = POLLERR_;
+      ++rc;
+    } else if (wi < pw) {
+      fi = p->fileindices[wi];
+      // one of the handles we polled is ready for fi/o
+      if (GetConsoleMode(p->filehands[wi], &cm)) {
+        switch (CountConsoleInputBytes()) {
+          case 0:
+            // it's possible there was input and it was handled by the
+            // ICANON reader, and therefore should not be reported yet
+            if (fds[fi].events & POLLWRNORM_)
+              fds[fi].revents = POLLWRNORM_;
+            break;
+          case -1:
+            fds[fi].revents = POLLHUP_;
+            break;
+          default:
             fds[fi].revents = fds[fi].events & (POLLRDNORM_ | POLLWRNORM_);
+            break;
+        }
+      } else if (GetFileType(p->filehands[wi]) == kNtFileTypePipe) {
+        if ((fds[fi].events & POLLRDNORM_) &&
+            (__get_pib()->fds.p[fds[fi].fd].flags & O_ACCMODE) != O_WRONLY) {
+          if (PeekNamedPipe(p->filehands[wi], 0, 0, 0, &avail, 0)) {
+            fds[fi].revents = fds[fi].events & (POLLRDNORM_ | POLLWRNORM_);
+          } else if (GetLastError() == kNtErrorHandleEof ||
+                     GetLastError() == kNtErrorBrokenPipe) {
+            fds[fi].revents = POLLHUP_;
+          } else {
+            fds[fi].revents = POLLERR_;
           }
         } else {
           fds[fi].revents = fds[fi].events & (POLLRDNORM_ | POLLWRNORM_);
         }
-        rc += !!fds[fi].revents;
       } else {
-        // should only be possible on kNtWaitTimeout or semaphore abandoned
-        // keep looping for events and we'll catch timeout when appropriate
+        fds[fi].revents = fds[fi].events & (POLLRDNORM_ | POLLWRNORM_);
       }
+      rc += !!fds[fi].revents;
+    } else {
+      // our afd request completed, which we've already harvested, or
+      // it's kNtWaitTimeout in which case we'll check the clock above
     }
 
     // once again, return if we observed events
@@ -307,8 +502,10 @@ textwindows static int sys_poll_nt_actual(struct pollfd *fds, uint64_t nfds,
 textwindows static int sys_poll_nt_impl(struct pollfd *fds, uint64_t nfds,
                                         struct timespec deadline,
                                         const sigset_t waitmask) {
-  int i, n, rc, got = 0;
-  struct timespec now, next, target;
+  int rc;
+  char *m, *mem;
+  struct PollNt p = {0};
+  int64_t stack[(POLL_NT_SIZE(POLL_NT_STACK) + 7) / 8];
 
   // we normally don't check for signals until we decide to wait, since
   // it's nice to have functions like write() be unlikely to EINTR, but
@@ -317,34 +514,30 @@ textwindows static int sys_poll_nt_impl(struct pollfd *fds, uint64_t nfds,
   if (__sigcheck(waitmask, false))
     return -1;
 
-  // fast path
-  if (nfds <= 63)
-    return sys_poll_nt_actual(fds, nfds, deadline, waitmask);
-
-  // clumsy path
-  for (;;) {
-    for (i = 0; i < nfds; i += 63) {
-      n = nfds - i;
-      n = n > 63 ? 63 : n;
-      rc = sys_poll_nt_actual(fds + i, n, timespec_zero, waitmask);
-      if (rc == -1)
-        return -1;
-      got += rc;
-    }
-    if (got)
-      return got;
-    now = sys_clock_gettime_monotonic_nt();
-    if (timespec_cmp(now, deadline) >= 0)
-      return 0;
-    next = timespec_add(now, timespec_frommillis(POLL_INTERVAL_MS));
-    if (timespec_cmp(next, deadline) >= 0) {
-      target = deadline;
-    } else {
-      target = next;
-    }
-    if (_park_norestart(target, waitmask) == -1)
-      return -1;
+  // carve out our bookkeeping
+  if (nfds > 0x1000000)
+    return einval();
+  if (nfds <= POLL_NT_STACK) {
+    mem = (char *)stack;
+  } else if (!(mem = HeapAlloc(GetProcessHeap(), 0, POLL_NT_SIZE(nfds)))) {
+    return enomem();
   }
+  p.afdsize = POLL_NT_AFDSIZE(nfds);
+  m = mem;
+  p.sockin = (struct NtAfdPollInfo *)m, m += p.afdsize;
+  p.sockout = (struct NtAfdPollInfo *)m, m += p.afdsize;
+  p.filehands = (int64_t *)m, m += (nfds + 2) * sizeof(int64_t);
+  p.sockindices = (int *)m, m += nfds * sizeof(int);
+  p.fileindices = (int *)m;
+
+  rc = sys_poll_nt_actual(fds, nfds, deadline, waitmask, &p);
+
+  sys_poll_nt_afd_wait(&p);
+  if (p.event)
+    CloseHandle(p.event);
+  if (mem != (char *)stack)
+    HeapFree(GetProcessHeap(), 0, mem);
+  return rc;
 }
 
 textwindows int sys_poll_nt(struct pollfd *fds, uint64_t nfds,
@@ -80,8 +80,10 @@ textwindows static errno_t sys_posix_fadvise_nt_impl(int fd, uint64_t offset,
   if ((h2 = ReOpenFile(h1, perm, share, attr | kNtFileFlagOverlapped)) == -1)
     return __errno_windows2linux(GetLastError());
 
-  if (h2 != h1)
+  if (h2 != h1) {
     CloseHandle(h1);
+    __get_pib()->fds.p[fd].iocp = 0;
+  }
 
   __get_pib()->fds.p[fd].handle = h2;
   __get_pib()->fds.p[fd].flags = flags;
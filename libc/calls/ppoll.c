@@ -158,12 +158,11 @@ static int ppoll_impl(struct pollfd *fds, size_t nfds,
  * should just create a separate thread for each client. poll(), ppoll()
  * and select() aren't scalable i/o solutions on any platform.
  *
- * On Windows it's only possible to poll 64 file descriptors at a time;
- * it's a limitation imposed by WSAPoll(). Cosmopolitan Libc's ppoll()
- * polyfill can go higher in some cases; for example, It's possible to
- * poll 64 sockets and 64 pipes/terminals at the same time. Furthermore,
- * elements whose fd field is set to a negative number are ignored and
- * will not count against this limit.
+ * On Windows, sockets are polled using the same kernel driver request
+ * that WSAPoll() uses, so there's no limit on how many of them you may
+ * poll at once, and readiness is reported as soon as it happens. Pipes
+ * and terminals are waited upon too, but only the first 62 are able to
+ * wake us up; the rest get rescanned every 200 milliseconds.
  *
  * One of the use cases for poll() is to quickly check if a number of
  * file descriptors are valid. The canonical way to do this is to set
@@ -137,7 +137,9 @@ sys_readwrite_nt(int fd, void *data, size_t size, ssize_t offset,
     }
 
     // initiate asynchronous i/o operation with win32
-    struct NtOverlapped overlap = {.hEvent = event, .Pointer = offset};
+    // setting the low bit of the event handle keeps this completion from
+    // being queued if cosmo_ring() bound the handle to a completion port
+    struct NtOverlapped overlap = {.hEvent = event | 1, .Pointer = offset};
     bool32 ok = ReadOrWriteFile(handle, data, size, 0, &overlap);
     if (!ok && GetLastError() == kNtErrorIoPending) {
       if (f->flags & O_NONBLOCK) {
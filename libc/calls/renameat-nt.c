@@ -16,6 +16,7 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/internal.h"
 #include "libc/calls/syscall-nt.internal.h"
 #include "libc/calls/syscall_support-nt.internal.h"
 #include "libc/limits.h"
@@ -35,6 +36,7 @@ textwindows static bool IsDirectory(uint32_t dwFileAttrs) {
 
 textwindows int sys_renameat_nt(int olddirfd, const char *oldpath, int newdirfd,
                                 const char *newpath) {
+  __statcache_drop();
 
   // allocate memory
 #pragma GCC push_options
@@ -53,6 +53,7 @@ textwindows int sys_fcntl_nt_setfl(struct Fd *fd, unsigned flags) {
       if (hand != fd->handle) {
         CloseHandle(fd->handle);
         fd->handle = hand;
+        fd->iocp = 0;  // new file object isn't bound to a completion port
       }
     } else {
       return __winerr();
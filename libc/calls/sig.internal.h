@@ -13,6 +13,11 @@ COSMOPOLITAN_C_START_
 struct Signals {
   atomic_ulong count;
   atomic_bool stopped;
+  atomic_ulong injected;   /* windows threads suspended to call handler */
+  atomic_ulong deferred;   /* windows threads left to raise at safe point */
+  atomic_ulong coalesced;  /* merged with signal that was already pending */
+  atomic_ulong nanos;      /* total latency of injected signals */
+  atomic_ulong maxnanos;   /* worst latency of injected signals */
 };
 
 extern struct Signals __sig;
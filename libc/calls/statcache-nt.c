@@ -0,0 +1,345 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/atomic.h"
+#include "libc/calls/internal.h"
+#include "libc/calls/struct/sigset.internal.h"
+#include "libc/calls/struct/stat.h"
+#include "libc/calls/syscall_support-nt.internal.h"
+#include "libc/cosmotime.h"
+#include "libc/fmt/conv.h"
+#include "libc/fmt/wintime.internal.h"
+#include "libc/macros.h"
+#include "libc/nt/createfile.h"
+#include "libc/nt/enum/accessmask.h"
+#include "libc/nt/enum/creationdisposition.h"
+#include "libc/nt/enum/fileflagandattributes.h"
+#include "libc/nt/enum/fileinfobyhandleclass.h"
+#include "libc/nt/enum/filesharemode.h"
+#include "libc/nt/errors.h"
+#include "libc/nt/files.h"
+#include "libc/nt/memory.h"
+#include "libc/nt/runtime.h"
+#include "libc/nt/struct/byhandlefileinformation.h"
+#include "libc/nt/struct/fileidbothdirectoryinformation.h"
+#include "libc/nt/synchronization.h"
+#include "libc/runtime/runtime.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/s.h"
+#include "libc/sysv/errfuns.h"
+#include "libc/thread/thread.h"
+
+/**
+ * @fileoverview windows directory listing cache for stat()
+ *
+ * Opening a file on windows costs tens of microseconds, so programs
+ * like make that stat thousands of files are much slower than on unix.
+ * If the COSMO_STATCACHE environment variable is set to a number of
+ * milliseconds, then stat() will instead answer from a listing of the
+ * parent directory, fetched in one GetFileInformationByHandleEx() loop.
+ * Listings expire after that many milliseconds, and they're forgotten
+ * whenever this process changes the filesystem or reaps a child.
+ *
+ * Cached results differ from the slow path in that st_nlink is always
+ * one, and read permission is assumed. Reparse points, as well as files
+ * whose extension doesn't say whether they're executable, are left for
+ * the slow path to figure out.
+ */
+
+#define SLOTS   4
+#define MAXLIST (16 * 1024 * 1024)
+
+struct StatCacheDir {
+  char16_t *dir;     // parent directory path
+  char *buf;         // FILE_ID_BOTH_DIR_INFO records
+  uint32_t *table;   // record offsets plus one, by folded name hash
+  uint32_t mask;     // table size minus one
+  uint32_t serial;   // volume serial number
+  unsigned gen;      // __statcache_gen when fetched
+  uint64_t expires;  // GetTickCount64() deadline
+};
+
+static struct {
+  pthread_mutex_t lock;
+  int ttl;
+  unsigned next;
+  struct StatCacheDir dirs[SLOTS];
+} __statcache = {PTHREAD_MUTEX_INITIALIZER, -1};
+
+static int GetStatCacheTtl(void) {
+  const char *s;
+  if (__statcache.ttl == -1)
+    __statcache.ttl = (s = getenv("COSMO_STATCACHE")) ? MAX(0, atoi(s)) : 0;
+  return __statcache.ttl;
+}
+
+static inline char16_t FoldChar(char16_t c) {
+  return 'A' <= c && c <= 'Z' ? c + 32 : c;
+}
+
+static uint32_t HashName(const char16_t *s, size_t n) {
+  uint32_t h = 0x811c9dc5;
+  while (n--)
+    h = (h ^ FoldChar(*s++)) * 0x01000193;
+  return h;
+}
+
+static bool FoldEqual(const char16_t *a, const char16_t *b, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    if (FoldChar(a[i]) != FoldChar(b[i]))
+      return false;
+  return true;
+}
+
+// ascii names are the only ones whose absence we can vouch for, since
+// windows case folding and name normalization is out of our hands
+static bool IsPlainName(const char16_t *s, size_t n) {
+  if (!n || n > 255 || s[n - 1] == '.' || s[n - 1] == ' ')
+    return false;
+  for (size_t i = 0; i < n; ++i)
+    if (s[i] < 0x20 || s[i] >= 0x7f || strchr(":*?\"<>|", s[i]))
+      return false;
+  return true;
+}
+
+static void InsertRecord(struct StatCacheDir *d, uint32_t off,
+                         const char16_t *name, size_t len) {
+  uint32_t i = HashName(name, len);
+  while (d->table[i & d->mask])
+    ++i;
+  d->table[i & d->mask] = off + 1;
+}
+
+// listings live on the win32 heap, which fork() doesn't copy, so the
+// child process has __statcache_wipe() start it off with an empty cache
+textwindows static void *StatCacheAlloc(void *p, size_t n) {
+  if (p)
+    return HeapReAlloc(GetProcessHeap(), 0, p, n);
+  return HeapAlloc(GetProcessHeap(), 0, n);
+}
+
+textwindows static void StatCacheFree(void *p) {
+  if (p)
+    HeapFree(GetProcessHeap(), 0, p);
+}
+
+textwindows static void FreeStatCacheDir(struct StatCacheDir *d) {
+  StatCacheFree(d->dir);
+  StatCacheFree(d->buf);
+  StatCacheFree(d->table);
+  bzero(d, sizeof(*d));
+}
+
+// returns record after r in the GetFileInformationByHandleEx() results
+// which were saved to buf, where each batch starts on an 8-byte boundary
+static struct NtFileIdBothDirectoryInformation *NextRecord(
+    const char *buf, size_t n, struct NtFileIdBothDirectoryInformation *r) {
+  size_t o;
+  if (r->NextEntryOffset)
+    return (void *)((char *)r + r->NextEntryOffset);
+  o = ROUNDUP((char *)r->FileName + r->FileNameLength - buf, 8);
+  return o < n ? (void *)(buf + o) : 0;
+}
+
+textwindows static bool FillStatCacheDir(struct StatCacheDir *d,
+                                         const char16_t *dir, size_t dirlen,
+                                         unsigned gen) {
+  char *p;
+  int64_t h;
+  uint32_t m;
+  size_t n, c, k;
+  struct NtByHandleFileInformation wst;
+  struct NtFileIdBothDirectoryInformation *r;
+  if (!(d->dir = StatCacheAlloc(0, (dirlen + 1) * sizeof(char16_t))))
+    return false;
+  memcpy(d->dir, dir, dirlen * sizeof(char16_t));
+  d->dir[dirlen] = 0;
+  if ((h = CreateFile(dirlen ? d->dir : u".",
+                      kNtFileListDirectory | kNtFileReadAttributes,
+                      kNtFileShareRead | kNtFileShareWrite | kNtFileShareDelete,
+                      0, kNtOpenExisting, kNtFileFlagBackupSemantics, 0)) == -1)
+    return false;
+  if (!GetFileInformationByHandle(h, &wst))
+    goto Fail;
+  for (n = c = 0;;) {
+    if (c - n < 16384) {
+      if ((c = c ? c * 2 : 65536) > MAXLIST || !(p = StatCacheAlloc(d->buf, c)))
+        goto Fail;
+      d->buf = p;
+    }
+    if (!GetFileInformationByHandleEx(h, kNtFileIdBothDirectoryInfo,
+                                      d->buf + n, c - n)) {
+      if (GetLastError() == kNtErrorNoMoreFiles)
+        break;
+      goto Fail;
+    }
+    for (r = (void *)(d->buf + n); r->NextEntryOffset;)
+      r = (void *)((char *)r + r->NextEntryOffset);
+    n = ROUNDUP((char *)r->FileName + r->FileNameLength - d->buf, 8);
+  }
+  CloseHandle(h);
+  k = 0;
+  for (r = n ? (void *)d->buf : 0; r; r = NextRecord(d->buf, n, r))
+    k += 1 + !!r->ShortNameLength;
+  for (m = 16; m < k * 2;)
+    m *= 2;
+  if (!(d->table = StatCacheAlloc(0, m * sizeof(uint32_t))))
+    return false;
+  bzero(d->table, m * sizeof(uint32_t));
+  d->mask = m - 1;
+  for (r = n ? (void *)d->buf : 0; r; r = NextRecord(d->buf, n, r)) {
+    InsertRecord(d, (char *)r - d->buf, r->FileName, r->FileNameLength / 2);
+    if (r->ShortNameLength)
+      InsertRecord(d, (char *)r - d->buf, r->ShortName,
+                   r->ShortNameLength / 2);
+  }
+  d->serial = wst.dwVolumeSerialNumber;
+  d->gen = gen;
+  d->expires = GetTickCount64() + GetStatCacheTtl();
+  return true;
+Fail:
+  CloseHandle(h);
+  return false;
+}
+
+// finds record named s, preferring one whose case matches exactly
+static struct NtFileIdBothDirectoryInformation *FindRecord(
+    struct StatCacheDir *d, const char16_t *s, size_t n) {
+  uint32_t i, o;
+  struct NtFileIdBothDirectoryInformation *r, *res = 0;
+  for (i = HashName(s, n); (o = d->table[i & d->mask]); ++i) {
+    r = (void *)(d->buf + o - 1);
+    if (r->FileNameLength == n * 2 && FoldEqual(r->FileName, s, n)) {
+      if (!memcmp(r->FileName, s, n * 2))
+        return r;
+      res = r;
+    } else if (r->ShortNameLength == n * 2 && FoldEqual(r->ShortName, s, n)) {
+      res = r;
+    }
+  }
+  return res;
+}
+
+textwindows static int StatRecord(struct StatCacheDir *d,
+                                  struct NtFileIdBothDirectoryInformation *r,
+                                  const char16_t *path, struct stat *st) {
+  int exec;
+  if (r->FileAttributes & kNtFileAttributeReparsePoint)
+    return 1;
+  if (r->FileAttributes & kNtFileAttributeDirectory) {
+    exec = 1;
+  } else if ((exec = IsWindowsExecutableName(path)) == -1) {
+    return 1;
+  }
+  bzero(st, sizeof(*st));
+  st->st_blksize = 4096;
+  st->st_gid = st->st_uid = sys_getuid_nt();
+  st->st_mode = 0444;
+  if (exec)
+    st->st_mode |= 0111;
+  if (!(r->FileAttributes & kNtFileAttributeReadonly))
+    st->st_mode |= 0220;
+  if (r->FileAttributes & kNtFileAttributeDirectory) {
+    st->st_mode |= S_IFDIR;
+  } else {
+    st->st_mode |= S_IFREG;
+  }
+  st->st_flags = r->FileAttributes;
+  st->st_atim = WindowsTimeToTimeSpec(r->LastAccessTime);
+  st->st_mtim = WindowsTimeToTimeSpec(r->LastWriteTime);
+  st->st_birthtim = WindowsTimeToTimeSpec(r->CreationTime);
+  if (timespec_cmp(st->st_atim, st->st_mtim) > 0) {
+    st->st_ctim = st->st_atim;
+  } else {
+    st->st_ctim = st->st_mtim;
+  }
+  st->st_size = r->EndOfFile;
+  st->st_dev = d->serial;
+  st->st_ino = r->FileId;
+  st->st_nlink = 1;
+  st->st_blocks = ROUNDUP(st->st_size, st->st_blksize) / 512;
+  return 0;
+}
+
+/**
+ * Looks up file metadata in directory listing cache.
+ *
+ * @param path is utf-16 path from __mkntpathat()
+ * @return 0 on success, -1 w/ errno, or 1 if caller should stat() it
+ * @raise ENOENT if the parent directory listing doesn't have the name
+ */
+textwindows int __statcache_nt(const char16_t *path, struct stat *st) {
+  int rc;
+  unsigned gen;
+  uint64_t now;
+  const char16_t *name;
+  size_t i, dirlen, namelen;
+  struct StatCacheDir *d;
+  struct NtFileIdBothDirectoryInformation *r;
+  if (!GetStatCacheTtl())
+    return 1;
+  for (name = path, i = 0; path[i]; ++i)
+    if (path[i] == '\\' || path[i] == '/')
+      name = path + i + 1;
+  namelen = path + i - name;
+  if (!IsPlainName(name, namelen))
+    return 1;
+  if ((dirlen = name - path)) {
+    // c:\foo needs its slash kept, but dir\foo shouldn't
+    if (dirlen > 1 && path[dirlen - 2] != ':')
+      --dirlen;
+  }
+  rc = 1;
+  BLOCK_SIGNALS;
+  if (!pthread_mutex_trylock(&__statcache.lock)) {
+    gen = atomic_load_explicit(&__statcache_gen, memory_order_acquire);
+    now = GetTickCount64();
+    for (d = 0, i = 0; i < SLOTS; ++i) {
+      if (__statcache.dirs[i].dir && __statcache.dirs[i].gen == gen &&
+          __statcache.dirs[i].expires > now &&
+          !memcmp(__statcache.dirs[i].dir, path, dirlen * sizeof(char16_t)) &&
+          !__statcache.dirs[i].dir[dirlen]) {
+        d = __statcache.dirs + i;
+        break;
+      }
+    }
+    if (!d) {
+      d = __statcache.dirs + __statcache.next++ % SLOTS;
+      FreeStatCacheDir(d);
+      if (!FillStatCacheDir(d, path, dirlen, gen)) {
+        FreeStatCacheDir(d);
+        d = 0;
+      }
+    }
+    if (d) {
+      if ((r = FindRecord(d, name, namelen))) {
+        rc = StatRecord(d, r, path, st);
+      } else {
+        rc = enoent();
+      }
+    }
+    pthread_mutex_unlock(&__statcache.lock);
+  }
+  ALLOW_SIGNALS;
+  return rc;
+}
+
+textwindows void __statcache_wipe(void) {
+  pthread_mutex_wipe_np(&__statcache.lock);
+  bzero(__statcache.dirs, sizeof(__statcache.dirs));
+}
@@ -61,5 +61,9 @@ void __minicrash(int, siginfo_t *, void *) libcesque;
 char __is_stack_overflow(siginfo_t *, void *) libcesque;
 #endif
 
+#if defined(_COSMO_SOURCE) || defined(_GNU_SOURCE)
+int pidfd_send_signal(int, int, siginfo_t *, unsigned) libcesque;
+#endif
+
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_LIBC_CALLS_STRUCT_SIGINFO_H_ */
@@ -11,6 +11,7 @@ int sys_fstat_nt_char(int, struct stat *);
 int sys_fstat_nt_handle(int64_t, const char16_t *, struct stat *, int);
 int sys_fstatat_nt(int, const char *, struct stat *, int);
 int sys_lstat_nt(const char *, struct stat *);
+int __statcache_nt(const char16_t *, struct stat *);
 int sys_fstat_metal(int, struct stat *);
 
 const char *_DescribeStat(char[300], int, const struct stat *);
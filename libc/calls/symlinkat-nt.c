@@ -17,6 +17,7 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/assert.h"
+#include "libc/calls/internal.h"
 #include "libc/calls/struct/sigset.internal.h"
 #include "libc/calls/syscall-nt.internal.h"
 #include "libc/calls/syscall_support-nt.internal.h"
@@ -124,6 +125,7 @@ textwindows static int sys_symlinkat_nt_impl1(const char *target, int newdirfd,
 textwindows int sys_symlinkat_nt(const char *target, int newdirfd,
                                  const char *linkpath) {
   int rc;
+  __statcache_drop();
   BLOCK_SIGNALS;
   rc = sys_symlinkat_nt_impl1(target, newdirfd, linkpath);
   ALLOW_SIGNALS;
@@ -0,0 +1,72 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/cosmotime.h"
+#include "libc/nexgen32e/rdtsc.h"
+#include "libc/thread/tls.h"
+
+// how long a cached timestamp is reused, in rdtsc() units, which is
+// about a millisecond; that's still finer than kernel coarse clocks
+#define FRESH 3000000
+
+struct CoarseClock {
+  uint64_t tsc;
+  struct timespec ts;
+};
+
+static _Thread_local struct CoarseClock g_real;
+static _Thread_local struct CoarseClock g_mono;
+
+static struct timespec timespec_coarse(struct CoarseClock *c,
+                                       struct timespec now(void)) {
+  uint64_t tsc = rdtsc();
+  if (tsc - c->tsc >= FRESH || !c->tsc) {
+    c->ts = now();
+    c->tsc = tsc;
+  }
+  return c->ts;
+}
+
+/**
+ * Returns current wall time, cached for about a millisecond.
+ *
+ * This is the same as timespec_real() except it only asks the system
+ * for the time once it's been about a millisecond since the previous
+ * call on the calling thread. In between, the same timestamp is given
+ * back, at the cost of reading the cpu timestamp counter. That's good
+ * for things like http date headers, logging, and timeouts, which are
+ * done per request, on systems that don't offer a fast coarse clock.
+ *
+ * @see timespec_mono_coarse()
+ */
+struct timespec timespec_real_coarse(void) {
+  if (!__tls_enabled)
+    return timespec_real();
+  return timespec_coarse(&g_real, timespec_real);
+}
+
+/**
+ * Returns current monotonic time, cached for about a millisecond.
+ *
+ * @see timespec_real_coarse()
+ */
+struct timespec timespec_mono_coarse(void) {
+  if (!__tls_enabled)
+    return timespec_mono();
+  return timespec_coarse(&g_mono, timespec_mono);
+}
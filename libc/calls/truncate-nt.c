@@ -16,6 +16,7 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/internal.h"
 #include "libc/calls/struct/sigset.internal.h"
 #include "libc/calls/syscall-nt.internal.h"
 #include "libc/calls/syscall_support-nt.internal.h"
@@ -34,6 +35,7 @@ textwindows int sys_truncate_nt(const char *path, uint64_t length) {
   uint16_t path16[PATH_MAX];
   if (__mkntpath(path, path16) == -1)
     return -1;
+  __statcache_drop();
   BLOCK_SIGNALS;
   if ((fh = CreateFile(
            path16, kNtGenericWrite,
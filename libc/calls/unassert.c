@@ -40,7 +40,7 @@ void(unassert)(const char *expr, const char *file, int line) {
   FormatInt32(ibuf, line);
   tinyprint(2, file, ":", ibuf, ": ", __nocolor ? "" : "\e[31;1m", "unassert(",
             expr, ") failed", __nocolor ? "" : "\e[0m", " (cosmoaddr2line ",
-            FindDebugBinary(), " ",
+            FindDebugBinaryCached(), " ",
             DescribeBacktrace(__builtin_frame_address(0)), ")\n", NULL);
   __sig_unblock(m);
   notpossible;
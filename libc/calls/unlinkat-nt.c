@@ -16,6 +16,7 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/internal.h"
 #include "libc/calls/syscall_support-nt.internal.h"
 #include "libc/errno.h"
 #include "libc/limits.h"
@@ -28,6 +29,7 @@
 #include "libc/sysv/errno.h"
 
 textwindows int sys_unlinkat_nt(int dirfd, const char *path, int flags) {
+  __statcache_drop();
 
   // validate flags
   if (flags & ~AT_REMOVEDIR)
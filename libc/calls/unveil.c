@@ -33,12 +33,14 @@
 #include "libc/fmt/libgen.h"
 #include "libc/intrin/kprintf.h"
 #include "libc/intrin/strace.h"
+#include "libc/intrin/weaken.h"
 #include "libc/limits.h"
 #include "libc/macros.h"
 #include "libc/nexgen32e/vendor.internal.h"
 #include "libc/runtime/internal.h"
 #include "libc/runtime/runtime.h"
 #include "libc/runtime/stack.h"
+#include "libc/runtime/symbols.internal.h"
 #include "libc/str/str.h"
 #include "libc/sysv/consts/at.h"
 #include "libc/sysv/consts/audit.h"
@@ -428,6 +430,8 @@ int sys_unveil_linux(const char *path, const char *permissions) {
  */
 int unveil(const char *path, const char *permissions) {
   int e, rc;
+  if (_weaken(FindDebugBinary))
+    _weaken(FindDebugBinary)();
   e = errno;
   if ((path && kisdangerous(path)) ||
       (permissions && kisdangerous(permissions))) {
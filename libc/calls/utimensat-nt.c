@@ -100,6 +100,7 @@ static textwindows int sys_utimensat_nt_impl(int dirfd, const char *path,
 textwindows int sys_utimensat_nt(int dirfd, const char *path,
                                  const struct timespec ts[2], int flags) {
   int rc;
+  __statcache_drop();
   BLOCK_SIGNALS;
   rc = sys_utimensat_nt_impl(dirfd, path, ts, flags);
   ALLOW_SIGNALS;
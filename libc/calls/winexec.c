@@ -52,11 +52,9 @@ static uint32_t GetFileExtension(const char16_t *s) {
   return w;
 }
 
-// checks if file should be considered an executable on windows
-textwindows int IsWindowsExecutable(int64_t handle, const char16_t *path) {
-
-  // fast path known file extensions
-  // shaves away 100ms of gnu make latency in cosmo monorepo
+// checks if file extension says whether it's executable on windows
+// returns -1 if the file content needs to be inspected to find out
+textwindows int IsWindowsExecutableName(const char16_t *path) {
   uint32_t ext;
   if (!IsTiny() && (ext = GetFileExtension(path))) {
     if (ext == EXT("c") ||   // c code
@@ -72,6 +70,17 @@ textwindows int IsWindowsExecutable(int64_t handle, const char16_t *path) {
       return true;
     }
   }
+  return -1;
+}
+
+// checks if file should be considered an executable on windows
+textwindows int IsWindowsExecutable(int64_t handle, const char16_t *path) {
+
+  // fast path known file extensions
+  // shaves away 100ms of gnu make latency in cosmo monorepo
+  int rc;
+  if ((rc = IsWindowsExecutableName(path)) != -1)
+    return rc;
 
   // read first two bytes of file
   // access() and stat() aren't cancelation points
@@ -57,6 +57,9 @@ textwindows static ssize_t sys_write_nt_impl(int fd, void *data, size_t size,
 
   switch (f->kind) {
     case kFdFile:
+      __statcache_drop();
+      isconsole = false;
+      break;
     case kFdDevNull:
       isconsole = false;
       break;
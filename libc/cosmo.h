@@ -14,6 +14,18 @@ typedef _COSMO_ATOMIC(unsigned) cosmo_once_t;
 
 errno_t cosmo_once(cosmo_once_t *, void (*)(void));
 int cosmo_cpu_count(void) pureconst libcesque;
+
+struct CosmoCpu {
+  int cpu;     /* logical cpu number, e.g. for sched_setaffinity() */
+  int core;    /* lowest cpu on same physical core, or -1 */
+  int package; /* physical socket number, or -1 */
+  int node;    /* numa node number */
+  int l2;      /* lowest cpu sharing same l2 cache, or -1 */
+  int l3;      /* lowest cpu sharing same l3 cache (e.g. ccx), or -1 */
+};
+
+int cosmo_topology(struct CosmoCpu *, int) libcesque;
+
 void cosmo_warmup_directory(const char *, int);
 int systemvpe(const char *, char *const[], char *const[]) libcesque;
 char *GetProgramExecutableName(void) libcesque;
@@ -22,7 +34,14 @@ bool32 IsLinuxModern(void) libcesque;
 void AssertNoLocksAreHeld(void);
 void CheckForMemoryLeaks(void);
 double cosmo_entropy(const char *, size_t) libcesque;
+uint64_t cosmo_hash(const void *, size_t) libcesque nosideeffect;
+uint64_t cosmo_hash_seeded(const void *, size_t, uint64_t) libcesque
+    nosideeffect;
 
+void cosmo_f16_to_f32(float *, const uint16_t *, size_t) libcesque;
+void cosmo_f32_to_f16(uint16_t *, const float *, size_t) libcesque;
+void cosmo_bf16_to_f32(float *, const uint16_t *, size_t) libcesque;
+void cosmo_f32_to_bf16(uint16_t *, const float *, size_t) libcesque;
 int cosmo_demangle(char *, const char *, size_t) libcesque;
 int cosmo_is_mangled(const char *) libcesque;
 
@@ -52,6 +71,33 @@ void *cosmo_leak_untrack(void *);
 void cosmo_leak_finalize(void);
 int cosmo_leak_print(int (*)(void *));
 
+int cosmo_heapprof_start(unsigned, int, const char *) libcesque;
+int cosmo_heapprof_dump(int) libcesque;
+
+#define COSMO_PROFILE_FOLDED 1
+
+int cosmo_profile_start(unsigned, int, const char *) libcesque;
+int cosmo_profile_stop(void) libcesque;
+int cosmo_profile_dump(int) libcesque;
+
+#define COSMO_ARENA_THREADSAFE 1
+#define COSMO_ARENA_NODELOCAL  2
+
+struct CosmoArena;
+struct CosmoArena *cosmo_arena_new(size_t, int) libcesque;
+void cosmo_arena_free(struct CosmoArena *) libcesque;
+void *cosmo_arena_alloc(struct CosmoArena *, size_t, size_t) libcesque;
+void *cosmo_arena_mark(struct CosmoArena *) libcesque;
+void cosmo_arena_reset(struct CosmoArena *, void *) libcesque;
+
+#define COSMO_POOL_TRACKLEAKS 1
+
+struct CosmoPool;
+struct CosmoPool *cosmo_pool_new(size_t, size_t, int) libcesque;
+void cosmo_pool_free(struct CosmoPool *) libcesque;
+void *cosmo_pool_get(struct CosmoPool *) libcesque;
+void cosmo_pool_put(struct CosmoPool *, void *) libcesque;
+
 extern void *(*__dlmalloc)(size_t);
 extern void (*__dlfree)(void *);
 extern void *(*__dlcalloc)(size_t, size_t);
@@ -67,5 +113,69 @@ extern size_t (*__dlmalloc_usable_size)(void *);
 #define COSMO_SHARDS 32
 extern unsigned long (*cosmo_shard)(void);
 
+struct CosmoTaskPool;
+struct CosmoTaskPool *cosmo_taskpool_new(int) libcesque;
+void cosmo_taskpool_free(struct CosmoTaskPool *) libcesque;
+errno_t cosmo_taskpool_spawn(struct CosmoTaskPool *, void (*)(void *),
+                             void *) libcesque;
+void cosmo_taskpool_wait(struct CosmoTaskPool *) libcesque;
+void cosmo_parallel_for(struct CosmoTaskPool *, long, long, long,
+                        void (*)(long, long, void *), void *) libcesque;
+
+struct SortPair;
+int cosmo_parallel_sort_uint64(struct CosmoTaskPool *, uint64_t *,
+                               size_t) libcesque;
+int cosmo_parallel_sort_pairs(struct CosmoTaskPool *, struct SortPair *,
+                              size_t) libcesque;
+
+typedef struct cosmo_timer_s {
+  struct cosmo_timer_s *_next;
+  struct cosmo_timer_s *_prev;
+  uint64_t _expires;
+  int _state;
+} cosmo_timer_t;
+
+struct CosmoWheel;
+struct CosmoWheel *cosmo_wheel_new(uint64_t) libcesque;
+void cosmo_wheel_free(struct CosmoWheel *) libcesque;
+void cosmo_wheel_add(struct CosmoWheel *, cosmo_timer_t *, uint64_t) libcesque;
+bool32 cosmo_wheel_cancel(struct CosmoWheel *, cosmo_timer_t *) libcesque;
+cosmo_timer_t *cosmo_wheel_expire(struct CosmoWheel *, uint64_t) libcesque;
+int64_t cosmo_wheel_timeout(struct CosmoWheel *) libcesque;
+
+struct CosmoShmap;
+size_t cosmo_shmap_size(size_t, size_t) libcesque;
+struct CosmoShmap *cosmo_shmap_init(void *, size_t, size_t) libcesque;
+ssize_t cosmo_shmap_get(struct CosmoShmap *, const void *, size_t, void *,
+                        size_t) libcesque;
+int cosmo_shmap_put(struct CosmoShmap *, const void *, size_t, const void *,
+                    size_t) libcesque;
+bool32 cosmo_shmap_del(struct CosmoShmap *, const void *, size_t) libcesque;
+
+#define COSMO_BRLOCK_INITIALIZER {0}
+
+typedef struct cosmo_brlock_s {
+  _COSMO_ATOMIC(int) _writer;
+  struct {
+    _COSMO_ATOMIC(int) _readers __attribute__((__aligned__(64)));
+  } _slots[COSMO_SHARDS];
+} cosmo_brlock_t;
+
+unsigned cosmo_brlock_rdlock(cosmo_brlock_t *) libcesque;
+void cosmo_brlock_rdunlock(cosmo_brlock_t *, unsigned) libcesque;
+void cosmo_brlock_wrlock(cosmo_brlock_t *) libcesque;
+void cosmo_brlock_wrunlock(cosmo_brlock_t *) libcesque;
+
+#define COSMO_COUNTER_INITIALIZER {0}
+
+typedef struct cosmo_counter_s {
+  struct {
+    _COSMO_ATOMIC(long) _value __attribute__((__aligned__(64)));
+  } _slots[COSMO_SHARDS + 1];
+} cosmo_counter_t;
+
+void cosmo_counter_add(cosmo_counter_t *, long) libcesque;
+long cosmo_counter_get(cosmo_counter_t *) libcesque;
+
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_LIBC_COSMO_H_ */
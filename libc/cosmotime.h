@@ -17,7 +17,9 @@ COSMOPOLITAN_C_START_
 #define timespec_frommillis  __timespec_frommillis
 #define timespec_fromnanos   __timespec_fromnanos
 #define timespec_mono        __timespec_mono
+#define timespec_mono_coarse __timespec_mono_coarse
 #define timespec_real        __timespec_real
+#define timespec_real_coarse __timespec_real_coarse
 #define timespec_sleep       __timespec_sleep
 #define timespec_sleep_until __timespec_sleep_until
 #define timespec_sub         __timespec_sub
@@ -29,6 +31,8 @@ COSMOPOLITAN_C_START_
 
 struct timespec timespec_real(void) libcesque;
 struct timespec timespec_mono(void) libcesque;
+struct timespec timespec_real_coarse(void) libcesque;
+struct timespec timespec_mono_coarse(void) libcesque;
 struct timespec timespec_sleep(int, struct timespec) libcesque;
 int timespec_sleep_until(int, struct timespec) libcesque;
 
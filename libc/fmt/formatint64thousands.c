@@ -17,6 +17,7 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/fmt/itoa.h"
+#include "libc/nexgen32e/nexgen32e.h"
 
 /**
  * Converts unsigned 64-bit integer to string w/ commas.
@@ -25,22 +26,29 @@
  * @return pointer to nul byte
  */
 dontinline char *FormatUint64Thousands(char p[static 27], uint64_t x) {
-  size_t i;
-  char m[26];
-  i = 0;
-  do {
-    m[i++] = x % 10 + '0';
-    x = x / 10;
-  } while (x);
-  for (;;) {
-    *p++ = m[--i];
-    if (!i)
-      break;
-    if (!(i % 3))
-      *p++ = ',';
+  char *e;
+  unsigned y;
+  e = p + LengthUint64Thousands(x);
+  *e = '\0';
+  p = e;
+  while (x >= 1000) {
+    y = x % 1000;
+    x = x / 1000;
+    p -= 4;
+    p[0] = ',';
+    p[1] = '0' + y / 100;
+    __builtin_memcpy(p + 2, kDigitPairs + y % 100 * 2, 2);
   }
-  *p = '\0';
-  return p;
+  y = x;
+  if (y >= 100) {
+    p[-3] = '0' + y / 100;
+    __builtin_memcpy(p - 2, kDigitPairs + y % 100 * 2, 2);
+  } else if (y >= 10) {
+    __builtin_memcpy(p - 2, kDigitPairs + y * 2, 2);
+  } else {
+    p[-1] = '0' + y;
+  }
+  return e;
 }
 
 /**
@@ -0,0 +1,158 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/cosmo.h"
+#include "libc/nexgen32e/x86feature.h"
+#include "libc/str/str.h"
+
+/**
+ * @fileoverview bf16 array conversion
+ *
+ * This is integer math that the compiler is told to vectorize for the
+ * widest registers the cpu has. The avx512 bf16 instruction is not used
+ * because it flushes subnormals to zero, and we want the same numbers
+ * as the compiler runtime in brain16.c gives each scalar cast.
+ */
+
+typedef uint16_t bf16_v16hu __attribute__((__vector_size__(32)));
+typedef uint32_t bf16_v16su __attribute__((__vector_size__(64)));
+
+forceinline uint32_t bf16tofloat(uint32_t x) {
+  x <<= 16;
+  if ((x & 0x7fffffff) > 0x7f800000)
+    x |= 0x00400000;  // force nan to quiet
+  return x;
+}
+
+forceinline uint32_t floattobf16(uint32_t x) {
+  if ((x & 0x7fffffff) > 0x7f800000)
+    return (x | 0x00400000) >> 16;  // force nan to quiet
+  return (x + (0x7fff + ((x >> 16) & 1))) >> 16;
+}
+
+forceinline void bf16_to_f32_impl(float *d, const uint16_t *s,
+                                         size_t n) {
+  size_t i;
+  uint32_t w;
+  bf16_v16hu h;
+  bf16_v16su x;
+  for (i = 0; i + 16 <= n; i += 16) {
+    memcpy(&h, s + i, sizeof(h));
+    x = __builtin_convertvector(h, bf16_v16su) << 16;
+    x |= (bf16_v16su)((x & 0x7fffffff) > 0x7f800000) & 0x00400000;
+    memcpy(d + i, &x, sizeof(x));
+  }
+  for (; i < n; ++i) {
+    w = bf16tofloat(s[i]);
+    memcpy(d + i, &w, sizeof(w));
+  }
+}
+
+forceinline void f32_to_bf16_impl(uint16_t *d, const float *s,
+                                         size_t n) {
+  size_t i;
+  uint32_t w;
+  bf16_v16hu h;
+  bf16_v16su x, r, m;
+  for (i = 0; i + 16 <= n; i += 16) {
+    memcpy(&x, s + i, sizeof(x));
+    m = (bf16_v16su)((x & 0x7fffffff) > 0x7f800000);
+    r = (x + (0x7fff + ((x >> 16) & 1))) >> 16;
+    r = (r & ~m) | (((x | 0x00400000) >> 16) & m);
+    h = __builtin_convertvector(r, bf16_v16hu);
+    memcpy(d + i, &h, sizeof(h));
+  }
+  for (; i < n; ++i) {
+    memcpy(&w, s + i, sizeof(w));
+    d[i] = floattobf16(w);
+  }
+}
+
+static void bf16_to_f32_base(float *d, const uint16_t *s, size_t n) {
+  bf16_to_f32_impl(d, s, n);
+}
+
+static void f32_to_bf16_base(uint16_t *d, const float *s, size_t n) {
+  f32_to_bf16_impl(d, s, n);
+}
+
+#ifdef __x86_64__
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+static void bf16_to_f32_avx2(float *d, const uint16_t *s, size_t n) {
+  bf16_to_f32_impl(d, s, n);
+}
+static void f32_to_bf16_avx2(uint16_t *d, const float *s, size_t n) {
+  f32_to_bf16_impl(d, s, n);
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw")
+static void bf16_to_f32_avx512(float *d, const uint16_t *s, size_t n) {
+  bf16_to_f32_impl(d, s, n);
+}
+static void f32_to_bf16_avx512(uint16_t *d, const float *s, size_t n) {
+  f32_to_bf16_impl(d, s, n);
+}
+#pragma GCC pop_options
+
+#endif /* __x86_64__ */
+
+/**
+ * Converts array of brain16 numbers to float.
+ *
+ * This gives the same results as casting each `__bf16` to float, i.e.
+ * a shift, except signaling NaNs are made quiet. Neither array needs
+ * alignment and the source may be read-only memory, e.g. weights that
+ * are mapped from the zip executable. No memory is allocated, and the
+ * function may be called from a signal handler.
+ *
+ * @param d receives `n` floats
+ * @param s points to `n` brain16 numbers which must not overlap `d`
+ */
+void cosmo_bf16_to_f32(float *d, const uint16_t *s, size_t n) {
+#ifdef __x86_64__
+  if (X86_HAVE(AVX512F) && X86_HAVE(AVX512BW))
+    return bf16_to_f32_avx512(d, s, n);
+  if (X86_HAVE(AVX2))
+    return bf16_to_f32_avx2(d, s, n);
+#endif
+  bf16_to_f32_base(d, s, n);
+}
+
+/**
+ * Converts array of floats to brain16 numbers.
+ *
+ * Values round to nearest even, as they would when casting each float
+ * to `__bf16`, and NaNs stay NaN.
+ *
+ * @param d receives `n` brain16 numbers
+ * @param s points to `n` floats which must not overlap `d`
+ * @see cosmo_bf16_to_f32()
+ */
+void cosmo_f32_to_bf16(uint16_t *d, const float *s, size_t n) {
+#ifdef __x86_64__
+  if (X86_HAVE(AVX512F) && X86_HAVE(AVX512BW))
+    return f32_to_bf16_avx512(d, s, n);
+  if (X86_HAVE(AVX2))
+    return f32_to_bf16_avx2(d, s, n);
+#endif
+  f32_to_bf16_base(d, s, n);
+}
@@ -23,8 +23,11 @@
 #include "libc/cosmo.h"
 #include "libc/cosmotime.h"
 #include "libc/dce.h"
-#include "libc/intrin/kprintf.h"
+#include "libc/intrin/atomic.h"
+#include "libc/nexgen32e/kcpuids.h"
 #include "libc/nexgen32e/rdtsc.h"
+#include "libc/nexgen32e/x86feature.h"
+#include "libc/thread/tls.h"
 #ifdef __x86_64__
 
 /**
@@ -35,20 +38,41 @@
  *
  * Intel architecture guarantees that a mapping exists between rdtsc &
  * nanoseconds only if the cpu advertises invariant timestamps support
- * however this shouldn't matter for a monotonic clock since we really
- * don't want to have it tick while suspended. Sadly that shall happen
- * since nearly all x86 microprocessors support invariant tsc which is
- * why we try to avoid this fallback when possible.
+ * in which case we start off by assuming the tsc ticks at the base cpu
+ * frequency reported by cpuid, and then we measure the true rate over
+ * time against the realtime clock. Each time the rate is corrected we
+ * rebase the clock at the current time so it never jumps. Rates that
+ * disagree wildly with what we've measured before are ignored, since
+ * they're most likely due to clock_settime() or ntp. If the cpu lacks
+ * invariant tsc, or if a thread ever observes it going backwards by a
+ * meaningful amount, e.g. due to unsynchronized cores, we fall back to
+ * deriving this clock from the realtime clock.
  */
 
+#define FIXED 32  // fractional bits of nanoseconds per tick
+
 int sys_sysctl(int *, unsigned, void *, size_t *, void *, size_t) libcesque;
 
 static struct {
   atomic_uint once;
-  unsigned long base;
+  atomic_uint seq;         // odd while clock is being rebased
+  atomic_bool busy;        // a thread is measuring the tsc rate
+  atomic_bool unreliable;  // use realtime clock instead of tsc
+  atomic_ulong base_tsc;   // tsc when clock was last rebased
+  atomic_ulong base_ns;    // monotonic nanos at base_tsc
+  atomic_ulong mult;       // nanos per tick in fixed point
+  uint64_t guess;          // nanos per tick according to cpuid
+  uint64_t next_tsc;       // when we should measure the rate again
+  uint64_t interval;       // how many ticks go by between measurements
+  bool converged;          // interval has reached about a second
+  uint64_t ref_tsc;        // start of current measurement window
+  struct timespec ref_real;
   struct timespec boot;
+  struct timespec real0;
 } g_mono;
 
+static _Thread_local uint64_t g_last;
+
 static struct timespec get_uptime_xnu(void) {
   struct timeval booted;
   size_t n = sizeof(booted);
@@ -61,24 +85,118 @@ static struct timespec get_uptime_xnu(void) {
   return timespec_sub(now, timeval_totimespec(booted));
 }
 
+static struct timespec get_real(void) {
+  struct timespec ts;
+  if (IsXnu()) {
+    sys_clock_gettime_xnu(0, &ts);
+  } else {
+    clock_gettime(0, &ts);
+  }
+  return ts;
+}
+
+static uint64_t get_nanos(uint64_t tsc, uint64_t base_tsc, uint64_t base_ns,
+                          uint64_t mult) {
+  return base_ns + ((unsigned __int128)(tsc - base_tsc) * mult >> FIXED);
+}
+
 static void sys_clock_gettime_mono_init(void) {
+  unsigned mhz;
   if (IsXnu())
     g_mono.boot = get_uptime_xnu();
-  g_mono.base = rdtsc();
+  g_mono.real0 = g_mono.ref_real = get_real();
+  g_mono.ref_tsc = rdtsc();
+  atomic_init(&g_mono.base_tsc, g_mono.ref_tsc);
+  atomic_init(&g_mono.base_ns, timespec_tonanos(g_mono.boot));
+  // this is a crude approximation, that's worked reasonably well so far
+  // until we've had a chance to measure it, e.g. 3ghz is 1/3 nanos/tick
+  if (!(mhz = KCPUIDS(16H, EAX) & 0x7fff))
+    mhz = 3000;
+  g_mono.guess = (1000ull << FIXED) / mhz;
+  atomic_init(&g_mono.mult, g_mono.guess);
+  // take first measurement after ~10ms and gradually get less frequent
+  g_mono.interval = mhz * 10000ull;
+  g_mono.next_tsc = g_mono.ref_tsc + g_mono.interval;
+  atomic_init(&g_mono.unreliable, !X86_HAVE(INVTSC));
+}
+
+// measures tsc rate over the past interval and rebases clock on it
+static void sys_clock_gettime_mono_calibrate(uint64_t tsc) {
+  if (atomic_exchange_explicit(&g_mono.busy, true, memory_order_acquire))
+    return;
+  if ((int64_t)(tsc - g_mono.next_tsc) < 0)
+    goto Done;  // another thread already did it
+  struct timespec real = get_real();
+  uint64_t mult = atomic_load_explicit(&g_mono.mult, memory_order_relaxed);
+  uint64_t base_tsc =
+      atomic_load_explicit(&g_mono.base_tsc, memory_order_relaxed);
+  uint64_t base_ns =
+      atomic_load_explicit(&g_mono.base_ns, memory_order_relaxed);
+  int64_t ns = timespec_tonanos(timespec_sub(real, g_mono.ref_real));
+  uint64_t ticks = tsc - g_mono.ref_tsc;
+  if (ns > 0 && ticks) {
+    uint64_t measured = ((unsigned __int128)ns << FIXED) / ticks;
+    // a realtime clock step or a suspended process would spoil this
+    // measurement, so we only trust it within a factor of two of what
+    // cpuid told us, and within 0.1% of our rate once it's converged
+    uint64_t want = g_mono.converged ? mult : g_mono.guess;
+    uint64_t slop = g_mono.converged ? want / 1000 : want / 2;
+    if (want - slop <= measured && measured <= want + slop) {
+      atomic_fetch_add_explicit(&g_mono.seq, 1, memory_order_acquire);
+      atomic_store_explicit(&g_mono.base_ns,
+                            get_nanos(tsc, base_tsc, base_ns, mult),
+                            memory_order_relaxed);
+      atomic_store_explicit(&g_mono.base_tsc, tsc, memory_order_relaxed);
+      atomic_store_explicit(&g_mono.mult, measured, memory_order_relaxed);
+      atomic_fetch_add_explicit(&g_mono.seq, 1, memory_order_release);
+      mult = measured;
+    }
+  }
+  g_mono.ref_tsc = tsc;
+  g_mono.ref_real = real;
+  // measure every ~1 second once we've converged
+  if (g_mono.interval < ((1000000000ull << FIXED) / mult)) {
+    g_mono.interval *= 2;
+  } else {
+    g_mono.converged = true;
+  }
+  g_mono.next_tsc = tsc + g_mono.interval;
+Done:
+  atomic_store_explicit(&g_mono.busy, false, memory_order_release);
 }
 
 int sys_clock_gettime_mono(struct timespec *time) {
-  uint64_t nanos;
-  uint64_t cycles;
+  unsigned seq;
+  uint64_t tsc, nanos;
   cosmo_once(&g_mono.once, sys_clock_gettime_mono_init);
-  // ensure we get the full 64 bits of counting, which avoids wraparound
-  cycles = rdtsc() - g_mono.base;
-  // this is a crude approximation, that's worked reasonably well so far
-  // only the kernel knows the actual mapping between rdtsc and nanosecs
-  // which we could attempt to measure ourselves using clock_gettime but
-  // we'd need to impose 100 ms of startup latency for a guess this good
-  nanos = cycles / 3;
-  *time = timespec_add(g_mono.boot, timespec_fromnanos(nanos));
+  if (atomic_load_explicit(&g_mono.unreliable, memory_order_relaxed)) {
+    *time = timespec_add(g_mono.boot, timespec_subz(get_real(), g_mono.real0));
+    nanos = timespec_tonanos(*time);
+  } else {
+    tsc = rdtsc();
+    if ((int64_t)(tsc - g_mono.next_tsc) >= 0)
+      sys_clock_gettime_mono_calibrate(tsc);
+    do {
+      seq = atomic_load_explicit(&g_mono.seq, memory_order_acquire);
+      nanos = get_nanos(
+          tsc, atomic_load_explicit(&g_mono.base_tsc, memory_order_relaxed),
+          atomic_load_explicit(&g_mono.base_ns, memory_order_relaxed),
+          atomic_load_explicit(&g_mono.mult, memory_order_relaxed));
+    } while ((seq & 1) ||
+             seq != atomic_load_explicit(&g_mono.seq, memory_order_acquire));
+    *time = timespec_fromnanos(nanos);
+  }
+  // clock must never go backwards from the perspective of one thread
+  // if it goes backwards by more than a millisecond, then it could be
+  // that the tsc isn't synchronized across cores, so stop trusting it
+  if (__tls_enabled) {
+    if (nanos < g_last) {
+      if (g_last - nanos > 1000000)
+        atomic_store_explicit(&g_mono.unreliable, true, memory_order_relaxed);
+      *time = timespec_fromnanos((nanos = g_last));
+    }
+    g_last = nanos;
+  }
   return 0;
 }
 
@@ -90,7 +90,7 @@ textstartup void __init_fds(void) {
   if (fds->p == MAP_FAILED)
     _Exit(97);
   fds->c = fds_map_size;
-  fds->n = 3;
+  atomic_init(&fds->n, 3);
 
   // inherit standard i/o file descriptors
   if (IsMetal()) {
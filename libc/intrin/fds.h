@@ -11,7 +11,7 @@ COSMOPOLITAN_C_START_
 #define kFdConsole   4
 #define kFdSerial    5  // metal
 #define kFdZip       6  // unix + windows
-#define kFdEpoll     7  // epoll() deleted on 2024-09-01
+#define kFdEpoll     7  // windows epoll_create1() interest list
 #define kFdReserved  8
 #define kFdDevNull   9
 #define kFdDevRandom 10
@@ -42,15 +42,21 @@ struct Fd {
   int protocol;
   unsigned rcvtimeo;  // millis; 0 means wait forever
   unsigned sndtimeo;  // millis; 0 means wait forever
+  unsigned iocp;      // id of cosmo_ring whose port handle is bound to
   void *connect_op;
   struct Cursor *cursor;
   int64_t dev;  // lazily set by flocks on windows
   int64_t ino;  // lazily set by flocks on windows
 };
 
+// `p` is reserved up front and grows in place, so it never moves, and
+// `n` is published with release semantics once the memory beneath it
+// exists. that makes it safe for __isfdopen() and __isfdkind() to read
+// without the mutex. anything that captures other fields, e.g. handle,
+// must hold __fds_lock() since close() then open() can recycle a slot
 struct Fds {
   atomic_int f;  // lowest free slot
-  unsigned n;    // in fds
+  atomic_uint n; // in fds
   size_t c;      // in bytes
   struct Fd *p;
   struct Cursor *freed_cursors;
@@ -0,0 +1,154 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/cosmo.h"
+#include "libc/nexgen32e/x86feature.h"
+#include "libc/str/str.h"
+
+/**
+ * @fileoverview fp16 array conversion
+ */
+
+static inline float halftofloat(uint16_t h) {
+  union {
+    uint16_t i;
+    _Float16 f;
+  } u = {h};
+  return u.f;
+}
+
+static inline uint16_t floattohalf(float f) {
+  union {
+    _Float16 f;
+    uint16_t i;
+  } u = {f};
+  return u.i;
+}
+
+#ifdef __x86_64__
+
+typedef short f16c_v8hi __attribute__((__vector_size__(16)));
+typedef float f16c_v8sf __attribute__((__vector_size__(32)));
+
+#pragma GCC push_options
+#pragma GCC target("avx,f16c")
+
+static size_t cosmo_f16_to_f32_f16c(float *d, const uint16_t *s, size_t n) {
+  size_t i;
+  f16c_v8hi h;
+  f16c_v8sf f;
+  for (i = 0; i + 8 <= n; i += 8) {
+    memcpy(&h, s + i, sizeof(h));
+    f = __builtin_ia32_vcvtph2ps256(h);
+    memcpy(d + i, &f, sizeof(f));
+  }
+  return i;
+}
+
+static size_t cosmo_f32_to_f16_f16c(uint16_t *d, const float *s, size_t n) {
+  size_t i;
+  f16c_v8hi h;
+  f16c_v8sf f;
+  for (i = 0; i + 8 <= n; i += 8) {
+    memcpy(&f, s + i, sizeof(f));
+    h = __builtin_ia32_vcvtps2ph256(f, 0);  // round to nearest even
+    memcpy(d + i, &h, sizeof(h));
+  }
+  return i;
+}
+
+#pragma GCC pop_options
+
+#elif defined(__aarch64__)
+
+typedef _Float16 neon_v8hf __attribute__((__vector_size__(16)));
+typedef float neon_v8sf __attribute__((__vector_size__(32)));
+
+static size_t cosmo_f16_to_f32_neon(float *d, const uint16_t *s, size_t n) {
+  size_t i;
+  neon_v8hf h;
+  neon_v8sf f;
+  for (i = 0; i + 8 <= n; i += 8) {
+    memcpy(&h, s + i, sizeof(h));
+    f = __builtin_convertvector(h, neon_v8sf);  // fcvtl + fcvtl2
+    memcpy(d + i, &f, sizeof(f));
+  }
+  return i;
+}
+
+static size_t cosmo_f32_to_f16_neon(uint16_t *d, const float *s, size_t n) {
+  size_t i;
+  neon_v8hf h;
+  neon_v8sf f;
+  for (i = 0; i + 8 <= n; i += 8) {
+    memcpy(&f, s + i, sizeof(f));
+    h = __builtin_convertvector(f, neon_v8hf);  // fcvtn + fcvtn2
+    memcpy(d + i, &h, sizeof(h));
+  }
+  return i;
+}
+
+#endif
+
+/**
+ * Converts array of IEEE 754 binary16 numbers to float.
+ *
+ * This uses F16C on x86 and FCVTL on ARM, and gives the same results as
+ * converting each `_Float16` with a cast. Neither array needs alignment
+ * and the source may be read-only memory, e.g. weights mapped from the
+ * zip executable. No memory is allocated and the function may be called
+ * from a signal handler.
+ *
+ * @param d receives `n` floats
+ * @param s points to `n` halfs which must not overlap `d`
+ */
+void cosmo_f16_to_f32(float *d, const uint16_t *s, size_t n) {
+  size_t i = 0;
+#ifdef __x86_64__
+  if (X86_HAVE(F16C))
+    i = cosmo_f16_to_f32_f16c(d, s, n);
+#elif defined(__aarch64__)
+  i = cosmo_f16_to_f32_neon(d, s, n);
+#endif
+  for (; i < n; ++i)
+    d[i] = halftofloat(s[i]);
+}
+
+/**
+ * Converts array of floats to IEEE 754 binary16 numbers.
+ *
+ * Values round to nearest even, overflowing to infinity, as they would
+ * when casting each float to `_Float16`. The hardware paths keep NaN
+ * payload bits that fit, whereas the software conversion returns the
+ * canonical quiet NaN.
+ *
+ * @param d receives `n` halfs
+ * @param s points to `n` floats which must not overlap `d`
+ * @see cosmo_f16_to_f32()
+ */
+void cosmo_f32_to_f16(uint16_t *d, const float *s, size_t n) {
+  size_t i = 0;
+#ifdef __x86_64__
+  if (X86_HAVE(F16C))
+    i = cosmo_f32_to_f16_f16c(d, s, n);
+#elif defined(__aarch64__)
+  i = cosmo_f32_to_f16_neon(d, s, n);
+#endif
+  for (; i < n; ++i)
+    d[i] = floattohalf(s[i]);
+}
@@ -17,6 +17,7 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/fmt/itoa.h"
+#include "libc/nexgen32e/nexgen32e.h"
 
 /**
  * Converts unsigned 32-bit integer to string.
@@ -25,22 +26,21 @@
  * @return pointer to nul byte
  */
 dontinline char *FormatUint32(char p[hasatleast 12], uint32_t x) {
-  char t;
-  size_t i, a, b;
-  i = 0;
-  do {
-    p[i++] = x % 10 + '0';
-    x = x / 10;
-  } while (x > 0);
-  p[i] = '\0';
-  if (i) {
-    for (a = 0, b = i - 1; a < b; ++a, --b) {
-      t = p[a];
-      p[a] = p[b];
-      p[b] = t;
-    }
+  char *e;
+  e = p + LengthUint64(x);
+  *e = '\0';
+  p = e;
+  while (x >= 100) {
+    p -= 2;
+    __builtin_memcpy(p, kDigitPairs + x % 100 * 2, 2);
+    x /= 100;
   }
-  return p + i;
+  if (x >= 10) {
+    __builtin_memcpy(p - 2, kDigitPairs + x * 2, 2);
+  } else {
+    p[-1] = '0' + x;
+  }
+  return e;
 }
 
 /**
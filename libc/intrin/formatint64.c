@@ -17,30 +17,46 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/fmt/itoa.h"
+#include "libc/nexgen32e/nexgen32e.h"
 
 /**
  * Converts unsigned 64-bit integer to string.
  *
+ * The length is computed up front using LengthUint64() so digits can
+ * be written in place, back to front, two at a time using kDigitPairs.
+ * Work is split into eight digit chunks so the inner loop only needs
+ * 32-bit multiplications by the reciprocal of one hundred.
+ *
  * @param p needs at least 21 bytes
  * @return pointer to nul byte
  */
 dontinline char *FormatUint64(char p[static 21], uint64_t x) {
-  char t;
-  size_t i, a, b;
-  i = 0;
-  do {
-    p[i++] = x % 10 + '0';
-    x = x / 10;
-  } while (x > 0);
-  p[i] = '\0';
-  if (i) {
-    for (a = 0, b = i - 1; a < b; ++a, --b) {
-      t = p[a];
-      p[a] = p[b];
-      p[b] = t;
-    }
+  char *e;
+  uint32_t y;
+  e = p + LengthUint64(x);
+  *e = '\0';
+  p = e;
+  while (x >= 100000000) {
+    y = x % 100000000;
+    x = x / 100000000;
+    p -= 8;
+    __builtin_memcpy(p + 6, kDigitPairs + y % 100 * 2, 2), y /= 100;
+    __builtin_memcpy(p + 4, kDigitPairs + y % 100 * 2, 2), y /= 100;
+    __builtin_memcpy(p + 2, kDigitPairs + y % 100 * 2, 2), y /= 100;
+    __builtin_memcpy(p + 0, kDigitPairs + y * 2, 2);
+  }
+  y = x;
+  while (y >= 100) {
+    p -= 2;
+    __builtin_memcpy(p, kDigitPairs + y % 100 * 2, 2);
+    y /= 100;
+  }
+  if (y >= 10) {
+    __builtin_memcpy(p - 2, kDigitPairs + y * 2, 2);
+  } else {
+    p[-1] = '0' + y;
   }
-  return p + i;
+  return e;
 }
 
 /**
@@ -0,0 +1,60 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/cxxabi.h"
+#include "libc/intrin/klogring.h"
+#include "libc/intrin/kprintf.h"
+#include "libc/runtime/runtime.h"
+#include "libc/sysv/errfuns.h"
+
+/**
+ * Buffers kprintf() output in a lock-free ring.
+ *
+ * This is intended for high-rate debug logging, e.g. from signal
+ * handlers or function call tracing, where a write() system call for
+ * each message is too slow. Messages are appended with a single atomic
+ * compare-and-swap, and written out in batches when the ring becomes
+ * half full, when klogflush() is called, or at exit. Programs wanting
+ * output to appear promptly may call klogflush() from a thread.
+ *
+ * The ring is shared memory, so processes forked afterwards append to
+ * the same ring, and messages from all of them stay in order. If the
+ * ring fills up faster than it's drained, then messages are dropped,
+ * and their byte count is reported. Crash handlers that _Exit() should
+ * call klogflush() first. Messages longer than half the ring are never
+ * buffered.
+ *
+ * @param size is ring size in bytes, which must be a two power ≥4096
+ * @return 0 on success, or -1 w/ errno
+ * @raise EINVAL if `size` isn't a two power ≥4096
+ * @raise EBUSY if a ring was already created
+ * @raise ENOMEM if memory couldn't be mapped
+ */
+int klogring(size_t size) {
+  struct KlogRing *r;
+  if (size < 4096 || (size & (size - 1)))
+    return einval();
+  if (__klog_ring)
+    return ebusy();
+  if (!(r = _mapshared(sizeof(*r) + size)))
+    return -1;
+  r->mask = size - 1;
+  __cxa_atexit((void *)klogflush, 0, 0);
+  __klog_ring = r;
+  return 0;
+}
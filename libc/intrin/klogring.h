@@ -0,0 +1,20 @@
+#ifndef COSMOPOLITAN_LIBC_INTRIN_KLOGRING_H_
+#define COSMOPOLITAN_LIBC_INTRIN_KLOGRING_H_
+#include "libc/atomic.h"
+COSMOPOLITAN_C_START_
+
+/* each record is an 8-byte header holding its length plus one, which
+   becomes nonzero once committed, followed by data padded to 8 bytes */
+struct KlogRing {
+  atomic_ulong head;    /* bytes reserved by writers */
+  atomic_ulong tail;    /* bytes released by drainer */
+  atomic_ulong dropped; /* bytes discarded because ring was full */
+  atomic_int draining;
+  unsigned long mask;
+  char data[];
+};
+
+extern struct KlogRing *__klog_ring;
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_LIBC_INTRIN_KLOGRING_H_ */
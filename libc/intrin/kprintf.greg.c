@@ -25,6 +25,7 @@
 #include "libc/intrin/asmflag.h"
 #include "libc/intrin/atomic.h"
 #include "libc/intrin/getenv.h"
+#include "libc/intrin/klogring.h"
 #include "libc/intrin/kprintf.h"
 #include "libc/intrin/likely.h"
 #include "libc/intrin/maps.h"
@@ -368,7 +369,7 @@ ABI void _klog_serial(const char *b, size_t n) {
 }
 #endif /* __x86_64__ */
 
-ABI void klog(const char *b, size_t n) {
+ABI static void klogsys(const char *b, size_t n) {
 #ifdef __x86_64__
   long h;
   uint32_t wrote;
@@ -426,6 +427,108 @@ ABI void klog(const char *b, size_t n) {
 #endif
 }
 
+struct KlogRing *__klog_ring;
+
+ABI static void klogring_copy(struct KlogRing *r, unsigned long pos,
+                              const char *b, size_t n) {
+  size_t i;
+  for (i = 0; i < n; ++i)
+    r->data[(pos + i) & r->mask] = b[i];
+}
+
+// returns bytes in use after appending, or -1 if message was dropped
+ABI static long klogring_push(struct KlogRing *r, const char *b, size_t n) {
+  unsigned long h, t, need;
+  need = 8 + ((n + 7) & -8);
+  h = atomic_load_explicit(&r->head, memory_order_relaxed);
+  do {
+    t = atomic_load_explicit(&r->tail, memory_order_acquire);
+    if (h + need - t > r->mask + 1) {
+      atomic_fetch_add_explicit(&r->dropped, n, memory_order_relaxed);
+      return -1;
+    }
+  } while (!atomic_compare_exchange_weak_explicit(
+      &r->head, &h, h + need, memory_order_relaxed, memory_order_relaxed));
+  klogring_copy(r, h + 8, b, n);
+  atomic_store_explicit((atomic_ulong *)(r->data + (h & r->mask)), n + 1,
+                        memory_order_release);
+  return h + need - t;
+}
+
+/**
+ * Writes out messages buffered by klogring().
+ *
+ * Only one thread or process drains at a time. If another is already
+ * draining, then this returns immediately. Messages are written in the
+ * order their space was reserved, stopping at the first one that isn't
+ * finished being copied yet.
+ *
+ * @asyncsignalsafe
+ * @vforksafe
+ */
+ABI void klogflush(void) {
+  size_t i, k, n;
+  struct KlogRing *r;
+  char buf[1024];
+  unsigned long t, pos, hdr, need;
+  if (!(r = __klog_ring))
+    return;
+  if (atomic_exchange_explicit(&r->draining, 1, memory_order_acquire))
+    return;
+  k = 0;
+  t = atomic_load_explicit(&r->tail, memory_order_relaxed);
+  for (;;) {
+    pos = t & r->mask;
+    hdr = atomic_load_explicit((atomic_ulong *)(r->data + pos),
+                               memory_order_acquire);
+    if (!hdr)
+      break;
+    n = hdr - 1;
+    need = 8 + ((n + 7) & -8);
+    // batch small messages into a single system call
+    for (i = 0; i < n; ++i) {
+      if (k == sizeof(buf)) {
+        klogsys(buf, k);
+        k = 0;
+      }
+      buf[k++] = r->data[(pos + 8 + i) & r->mask];
+    }
+    // zero the record so stale bytes never look like a header
+    for (i = 0; i < need; ++i)
+      r->data[(pos + i) & r->mask] = 0;
+    t += need;
+    atomic_store_explicit(&r->tail, t, memory_order_release);
+  }
+  if (k)
+    klogsys(buf, k);
+  if ((n = atomic_exchange_explicit(&r->dropped, 0, memory_order_relaxed))) {
+    k = ksnprintf(buf, sizeof(buf), "klogring dropped %'zu bytes\n", n);
+    klogsys(buf, MIN(k, sizeof(buf) - 1));
+  }
+  atomic_store_explicit(&r->draining, 0, memory_order_release);
+}
+
+/**
+ * Writes data to kprintf() log.
+ *
+ * If klogring() was called, then data is appended to the shared ring,
+ * which gets drained whenever it becomes half full, or at exit.
+ *
+ * @asyncsignalsafe
+ * @vforksafe
+ */
+ABI void klog(const char *b, size_t n) {
+  long used;
+  struct KlogRing *r;
+  if ((r = __klog_ring) && n <= (r->mask + 1) / 2) {
+    if ((used = klogring_push(r, b, n)) == -1 || used > (r->mask + 1) / 2)
+      klogflush();
+    return;
+  }
+  klogflush();
+  klogsys(b, n);
+}
+
 ABI static size_t kformat(char *b, size_t n, const char *fmt, va_list va) {
   int si;
   wint_t t, u;
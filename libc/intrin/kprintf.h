@@ -8,6 +8,8 @@
 #define kvprintf     __kvprintf
 #define kvsnprintf   __kvsnprintf
 #define kloghandle   __kloghandle
+#define klogring     __klogring
+#define klogflush    __klogflush
 #define kisdangerous __kisdangerous
 #define uprintf      __uprintf
 #define uvprintf     __uvprintf
@@ -28,6 +30,8 @@ bool32 kisdangerous(const void *) libcesque;
 void klog(const char *, size_t) libcesque;
 void _klog_serial(const char *, size_t) libcesque;
 long kloghandle(void) libcesque;
+int klogring(size_t) libcesque;
+void klogflush(void) libcesque;
 
 void uprintf(const char *, ...) libcesque;
 void uvprintf(const char *, va_list) libcesque;
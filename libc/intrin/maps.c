@@ -127,20 +127,20 @@ uint64_t __maps_rand(void) {
   return (__maps.rand *= 15750249268501108917ull) >> 64;
 }
 
+// this doesn't need the lock since it hashes a weyl sequence
 void *__maps_randaddr(void) {
-  __maps_lock();
   uintptr_t addr;
+  addr = __maps_hash(atomic_fetch_add_explicit(
+      &__maps.randaddrs, 0x9e3779b97f4a7c15, memory_order_relaxed));
   if (IsXnuSilicon()) {
-    addr = __maps_rand();
     addr &= 0x3fffffffffff;
     addr |= 0x200000000000;
   } else {
-    addr = __maps_rand();  // 137gb total for random addresses
+    // 137gb total for random addresses
     addr &= 0x3fffffffff;  // 38 bit is below 39 bit rpi4 os vaspace
     addr |= 0x2000000000;  // 100gb above aarch64 base
   }
   addr &= -__gransize;
-  __maps_unlock();
   return (void *)addr;
 }
 
@@ -362,6 +362,7 @@ textstartup void __maps_init(void) {
   __maps.randlo = 2131259787901769494;
   __maps.randlo ^= __maps_hash((uintptr_t)__builtin_frame_address(0));
   __maps.randlo ^= __maps_hash(kStartTsc);
+  atomic_init(&__maps.randaddrs, __maps_hash(__maps.randlo));
 
   // initialize internal memory allocator
   __maps.balloc = __maps_randaddr();
@@ -405,12 +406,21 @@ void __maps_lock(void) {
   if (__tls_enabled) {
     MAPS_ASSERT(!__maps_held());
     pthread_mutex_lock(&__maps_lock_obj);
+    atomic_store_explicit(&__maps.seq,
+                          atomic_load_explicit(&__maps.seq,
+                                               memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
   }
 }
 
 void __maps_unlock(void) {
   if (__tls_enabled) {
     MAPS_ASSERT(__maps_held());
+    atomic_store_explicit(&__maps.seq,
+                          atomic_load_explicit(&__maps.seq,
+                                               memory_order_relaxed) + 1,
+                          memory_order_release);
     pthread_mutex_unlock(&__maps_lock_obj);
     MAPS_ASSERT(!__maps_held());
   }
@@ -418,6 +428,55 @@ void __maps_unlock(void) {
 
 void __maps_wipe(void) {
   pthread_mutex_wipe_np(&__maps_lock_obj);
+  atomic_store_explicit(&__maps.seq, 0, memory_order_relaxed);
+}
+
+// searches the tree without the lock using the __maps.seq seqlock. it
+// works because Map objects are never returned to the system, and the
+// tree links of a freed map are left alone, so a racing walk can only
+// ever land on some struct Map. we bound the depth in case a rotation
+// creates a cycle, and if the lock holder is our own interrupted self,
+// e.g. we crashed inside mmap(), we'll settle for a best effort answer
+static bool __maps_peek(const char *key, bool above, struct Map *out) {
+  for (int tries = 0;; ++tries) {
+    unsigned seq = atomic_load_explicit(&__maps.seq, memory_order_acquire);
+    if ((seq & 1) && tries < 10000) {
+      pthread_pause_np();
+      continue;
+    }
+    struct Tree *best = 0;
+    struct Tree *node = *(struct Tree *volatile *)&__maps.maps;
+    for (int depth = 0; node && depth < 128; ++depth) {
+      const char *addr = *(char *volatile *)&MAP_TREE_CONTAINER(node)->addr;
+      if (above ? addr > key : addr <= key) {
+        best = node;
+        node = above ? tree_get_left(node) : node->right;
+      } else {
+        node = above ? node->right : tree_get_left(node);
+      }
+    }
+    if (best)
+      __builtin_memcpy(out, MAP_TREE_CONTAINER(best), sizeof(*out));
+    atomic_thread_fence(memory_order_acquire);
+    if (tries >= 10000 ||
+        atomic_load_explicit(&__maps.seq, memory_order_relaxed) == seq)
+      return !!best;
+  }
+}
+
+/**
+ * Copies the mapping that contains `addr` without taking the lock.
+ */
+bool __maps_lookup(const void *addr, struct Map *out) {
+  return __maps_peek(addr, false, out) &&
+         (const char *)addr < out->addr + out->size;
+}
+
+/**
+ * Copies first mapping starting after `addr` without taking the lock.
+ */
+bool __maps_above(const void *addr, struct Map *out) {
+  return __maps_peek(addr, true, out);
 }
 
 #if MMAP_DEBUG
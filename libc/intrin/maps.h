@@ -55,10 +55,8 @@ struct Map {
   bool readonlyfile; /* windows nt only */
   unsigned visited;  /* checks and fork */
   intptr_t hand;     /* windows nt only */
-  union {
-    struct Tree tree;
-    struct Map *freed;
-  };
+  struct Tree tree;  /* never clobbered, see __maps_lookup() */
+  struct Map *freed;
 };
 
 struct MapSlab {
@@ -85,6 +83,8 @@ struct Maps {
   struct Tree *maps;
   char *balloc;
   bool32 once;
+  atomic_uint seq; /* odd while lock is held */
+  atomic_ulong randaddrs;
   _Atomic(char *) bolloc;
   _Atomic(struct Map *) freed;
   _Atomic(struct MapSlab *) slabs;
@@ -118,6 +118,8 @@ void __maps_insert(struct Map *);
 int __maps_untrack(char *, size_t);
 struct Map *__maps_alloc(void);
 struct Map *__maps_floor(const char *);
+bool __maps_lookup(const void *, struct Map *);
+bool __maps_above(const void *, struct Map *);
 bool __maps_track(char *, size_t, int, int);
 void __maps_stack(char *, int, int, size_t, int);
 int __maps_compare(const struct Tree *, const struct Tree *);
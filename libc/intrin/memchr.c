@@ -16,11 +16,35 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/nexgen32e/x86feature.h"
 #include "libc/str/str.h"
 #include "third_party/aarch64/arm_neon.internal.h"
 #include "third_party/intel/immintrin.internal.h"
 #ifndef __aarch64__
 
+#if defined(__x86_64__) && !defined(__chibicc__)
+#pragma GCC push_options
+#pragma GCC target("avx512bw")
+static void *memchr_avx512(const char *p, int c, size_t n) {
+  __m512i nv = _mm512_set1_epi8(c);
+  long skew = (intptr_t)p & 63;
+  uint64_t m = _mm512_cmpeq_epi8_mask(
+      _mm512_load_si512((const void *)((intptr_t)p & -64)), nv);
+  m >>= skew;
+  m <<= skew;
+  ssize_t i = -skew;
+  while (!m) {
+    i += 64;
+    if (i >= n)
+      return 0;
+    m = _mm512_cmpeq_epi8_mask(_mm512_load_si512((const void *)(p + i)), nv);
+  }
+  i += __builtin_ctzll(m);
+  return i < n ? (void *)(p + i) : 0;
+}
+#pragma GCC pop_options
+#endif
+
 /**
  * Returns pointer to first instance of character.
  *
@@ -34,6 +58,10 @@ void *memchr(const void *s, int c, size_t n) {
   if (!n)
     return 0;
   char *p = (char *)s;
+#if defined(__x86_64__) && !defined(__chibicc__)
+  if (X86_HAVE(AVX512BW))
+    return memchr_avx512(p, c, n);
+#endif
 #if defined(__AVX2__)
   __m256i nv = _mm256_set1_epi8(c);
   long skew = (intptr_t)p & 31;
@@ -17,10 +17,37 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/assert.h"
+#include "libc/nexgen32e/x86feature.h"
 #include "libc/str/str.h"
 #include "third_party/aarch64/arm_neon.internal.h"
 #include "third_party/intel/immintrin.internal.h"
 
+#if defined(__x86_64__) && !defined(__chibicc__)
+#pragma GCC push_options
+#pragma GCC target("avx512bw")
+static int memcmp_avx512(const unsigned char *p, const unsigned char *q,
+                         size_t n) {
+  size_t i;
+  uint64_t m;
+  __mmask64 k;
+  for (i = 0; n - i >= 64; i += 64)
+    if ((m = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512(p + i),
+                                     _mm512_loadu_si512(q + i))))
+      goto Differ;
+  if (i == n)
+    return 0;
+  // masked loads won't fault on bytes past the end
+  k = ((uint64_t)1 << (n - i)) - 1;
+  if (!(m = _mm512_cmpneq_epi8_mask(_mm512_maskz_loadu_epi8(k, p + i),
+                                    _mm512_maskz_loadu_epi8(k, q + i))))
+    return 0;
+Differ:
+  i += __builtin_ctzll(m);
+  return p[i] - q[i];
+}
+#pragma GCC pop_options
+#endif
+
 /**
  * Compares memory byte by byte.
  *
@@ -43,6 +70,8 @@ int memcmp(const void *a, const void *b, size_t n) {
   // perform optimized implementation
   size_t i = 0;
 #if defined(__x86_64__) && !defined(__chibicc__)
+  if (X86_HAVE(AVX512BW))
+    return memcmp_avx512(p, q, n);
   for (; n - i >= 16; i += 16) {
     unsigned m;
     if ((m = 0xffff ^ _mm_movemask_epi8(_mm_cmpeq_epi8(
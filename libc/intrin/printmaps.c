@@ -32,9 +32,9 @@
 // rise higher on expensive x86 machines with pml5t, if user uses it
 static int get_address_digits(int pagesz) {
   int max_bits = 0;
-  for (struct Tree *e = tree_first(__maps.maps); e; e = tree_next(e)) {
-    struct Map *map = MAP_TREE_CONTAINER(e);
-    char *end = map->addr + ((map->size + pagesz - 1) & -pagesz);
+  struct Map map;
+  for (char *key = 0; __maps_above(key, &map); key = map.addr) {
+    char *end = map.addr + ((map.size + pagesz - 1) & -pagesz);
     int bits = bsrll((uintptr_t)end) + 1;
     if (bits > max_bits)
       max_bits = bits;
@@ -44,22 +44,24 @@ static int get_address_digits(int pagesz) {
 
 /**
  * Prints memory mappings known to cosmo.
+ *
+ * This doesn't take the maps lock, so it's safe to call from a crash
+ * handler. If mappings change concurrently, output may be approximate.
  */
 void __print_maps(size_t limit) {
-  __maps_lock();
   char sb[16];
   char mappingbuf[8];
-  struct Map *last = 0;
+  struct Map map, last;
+  bool have_last = false;
   int pagesz = __pagesize;
   int gransz = __gransize;
   int digs = get_address_digits(pagesz);
-  for (struct Tree *e = tree_first(__maps.maps); e; e = tree_next(e)) {
-    struct Map *map = MAP_TREE_CONTAINER(e);
+  for (char *key = 0; __maps_above(key, &map); key = map.addr) {
 
     // show gaps between maps
-    if (last) {
-      char *beg = last->addr + ((last->size + gransz - 1) & -gransz);
-      char *end = map->addr;
+    if (have_last) {
+      char *beg = last.addr + ((last.size + gransz - 1) & -gransz);
+      char *end = map.addr;
       if (end > beg) {
         size_t gap = end - beg;
         sizefmt(sb, gap, 1024);
@@ -67,14 +69,15 @@ void __print_maps(size_t limit) {
       }
     }
     last = map;
+    have_last = true;
 
     // show mapping
-    kprintf("%0*lx-%0*lx %!s", digs, map->addr, digs, map->addr + map->size,
-            _DescribeMapping(mappingbuf, map->prot, map->flags));
-    sizefmt(sb, map->size, 1024);
+    kprintf("%0*lx-%0*lx %!s", digs, map.addr, digs, map.addr + map.size,
+            _DescribeMapping(mappingbuf, map.prot, map.flags));
+    sizefmt(sb, map.size, 1024);
     kprintf(" %!sb", sb);
     if (IsWindows()) {
-      switch (map->hand) {
+      switch (map.hand) {
         case MAPS_RESERVATION:
           kprintf(" reservation");
           break;
@@ -84,13 +87,13 @@ void __print_maps(size_t limit) {
           kprintf(" virtual");
           break;
         default:
-          kprintf(" hand=%ld", map->hand);
+          kprintf(" hand=%ld", map.hand);
           break;
       }
     }
-    if (map->iscow)
+    if (map.iscow)
       kprintf(" cow");
-    if (map->readonlyfile)
+    if (map.readonlyfile)
       kprintf(" readonlyfile");
     kprintf("\n");
 
@@ -102,5 +105,4 @@ void __print_maps(size_t limit) {
   // print summary
   kprintf("# %'zu bytes in %'zu mappings\n", __maps.pages * pagesz,
           __maps.count);
-  __maps_unlock();
 }
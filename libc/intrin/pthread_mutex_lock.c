@@ -52,8 +52,32 @@ static errno_t pthread_mutex_lock_normal_success(pthread_mutex_t *mutex,
   return 0;
 }
 
+// spins briefly on a contended lock before we resort to a system call
+// since critical sections are usually shorter than a futex round trip
+// the budget adapts to how long this particular lock took to acquire
+// recently, and spinning stops as soon as other waiters are parked,
+// because the owner will then hand the lock to one of them via futex
+static int pthread_mutex_spin_drepper(pthread_mutex_t *mutex) {
+  int n, val, spins, limit;
+  spins = atomic_load_explicit(&mutex->_spins, memory_order_relaxed);
+  limit = MIN(MUTEX_SPIN_MAX, spins * 2 + MUTEX_SPIN_MIN);
+  for (val = 1, n = 0; n < limit; ++n) {
+    pthread_pause_np();
+    val = atomic_load_explicit(&mutex->_futex, memory_order_relaxed);
+    if (val == 2)
+      break;
+    if (!val && atomic_compare_exchange_strong_explicit(
+                    &mutex->_futex, &val, 1, memory_order_acquire,
+                    memory_order_relaxed))
+      break;
+  }
+  atomic_store_explicit(&mutex->_spins, spins + (n - spins) / 8,
+                        memory_order_relaxed);
+  return val;
+}
+
 // see "take 3" algorithm in "futexes are tricky" by ulrich drepper
-// slightly improved to attempt acquiring multiple times b4 syscall
+// slightly improved to spin adaptively before making the syscall
 static int pthread_mutex_lock_drepper(pthread_mutex_t *mutex, uint64_t word,
                                       bool is_trylock) {
   int val = 0;
@@ -63,6 +87,8 @@ static int pthread_mutex_lock_drepper(pthread_mutex_t *mutex, uint64_t word,
   if (is_trylock)
     return EBUSY;
   LOCKTRACE("acquiring pthread_mutex_lock_drepper(%t)...", mutex);
+  if (val == 1 && !(val = pthread_mutex_spin_drepper(mutex)))
+    return pthread_mutex_lock_normal_success(mutex, word);
   if (val == 1)
     val = atomic_exchange_explicit(&mutex->_futex, 2, memory_order_acquire);
   BLOCK_CANCELATION;
@@ -16,9 +16,12 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/blockcancel.internal.h"
 #include "libc/calls/state.internal.h"
+#include "libc/cosmo.h"
 #include "libc/intrin/atomic.h"
 #include "libc/intrin/weaken.h"
+#include "libc/thread/lock.h"
 #include "libc/thread/thread.h"
 #include "third_party/nsync/mu.h"
 
@@ -38,18 +41,34 @@ errno_t pthread_rwlock_rdlock(pthread_rwlock_t *lk) {
   }
 #endif
 
-  // naive implementation
+  // futex implementation
+  // see pthread_rwlock_wrlock() for how the word is laid out
   uint32_t w = 0;
-  for (;;) {
-    if (w & 1)
-      for (;;)
-        if (~(w = atomic_load_explicit(&lk->_word, memory_order_relaxed)) & 1)
-          break;
-    // xxx: avoid writer starvation in pthread_rwlock_rdlock_test
-    while (atomic_load(&lk->_waiters))
-      pthread_yield_np();
-    if (atomic_compare_exchange_weak_explicit(
-            &lk->_word, &w, w + 2, memory_order_acquire, memory_order_relaxed))
-      return 0;
+  for (int n = 0;;) {
+    if (!(w & 1)) {
+      // xxx: avoid writer starvation in pthread_rwlock_rdlock_test
+      while (atomic_load(&lk->_waiters))
+        pthread_yield_np();
+      if (atomic_compare_exchange_weak_explicit(&lk->_word, &w, w + 4,
+                                                memory_order_acquire,
+                                                memory_order_relaxed))
+        return 0;
+      continue;
+    }
+    // spin briefly unless others have already given up and parked
+    if (n < MUTEX_SPIN_MAX && !(w & 2)) {
+      ++n;
+      pthread_pause_np();
+      w = atomic_load_explicit(&lk->_word, memory_order_relaxed);
+      continue;
+    }
+    if ((w & 2) || atomic_compare_exchange_weak_explicit(
+                       &lk->_word, &w, w | 2, memory_order_relaxed,
+                       memory_order_relaxed)) {
+      BLOCK_CANCELATION;
+      cosmo_futex_wait((cosmo_futex_t *)&lk->_word, w | 2, lk->_pshared, 0, 0);
+      ALLOW_CANCELATION;
+    }
+    w = atomic_load_explicit(&lk->_word, memory_order_relaxed);
   }
 }
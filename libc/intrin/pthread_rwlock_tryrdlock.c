@@ -48,7 +48,7 @@ errno_t pthread_rwlock_tryrdlock(pthread_rwlock_t *rwlock) {
   for (;;) {
     if (word & 1)
       return EBUSY;
-    if (atomic_compare_exchange_weak_explicit(&rwlock->_word, &word, word + 2,
+    if (atomic_compare_exchange_weak_explicit(&rwlock->_word, &word, word + 4,
                                               memory_order_acquire,
                                               memory_order_relaxed))
       return 0;
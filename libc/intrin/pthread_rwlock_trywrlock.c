@@ -43,10 +43,11 @@ errno_t pthread_rwlock_trywrlock(pthread_rwlock_t *rwlock) {
   }
 #endif
 
-  // naive implementation
-  uint32_t word = 0;
-  if (atomic_compare_exchange_strong_explicit(
-          &rwlock->_word, &word, 1, memory_order_acquire, memory_order_relaxed))
+  // futex implementation
+  uint32_t word = atomic_load_explicit(&rwlock->_word, memory_order_relaxed);
+  if (!(word & ~2u) && atomic_compare_exchange_strong_explicit(
+                           &rwlock->_word, &word, word | 1,
+                           memory_order_acquire, memory_order_relaxed))
     return 0;
   return EBUSY;
 }
@@ -17,9 +17,11 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/calls/state.internal.h"
+#include "libc/cosmo.h"
 #include "libc/errno.h"
 #include "libc/intrin/atomic.h"
 #include "libc/intrin/weaken.h"
+#include "libc/limits.h"
 #include "libc/thread/thread.h"
 #include "third_party/nsync/mu.h"
 
@@ -47,19 +49,28 @@ errno_t pthread_rwlock_unlock(pthread_rwlock_t *rwlock) {
   }
 #endif
 
-  // naive implementation
+  // futex implementation
+  // parked waiters get woken once the last owner has left
   uint32_t word = atomic_load_explicit(&rwlock->_word, memory_order_relaxed);
   for (;;) {
     if (word & 1) {
-      atomic_store_explicit(&rwlock->_word, 0, memory_order_release);
-      return 0;
-    } else if (word) {
-      if (atomic_compare_exchange_weak_explicit(&rwlock->_word, &word, word - 2,
+      word = atomic_exchange_explicit(&rwlock->_word, 0, memory_order_release);
+      break;
+    } else if (word & ~2u) {
+      uint32_t next = word - 4 == 2 ? 0 : word - 4;
+      if (atomic_compare_exchange_weak_explicit(&rwlock->_word, &word, next,
                                                 memory_order_release,
-                                                memory_order_relaxed))
-        return 0;
+                                                memory_order_relaxed)) {
+        if (next)
+          return 0;
+        break;
+      }
     } else {
       return EPERM;
     }
   }
+  if (word & 2)
+    cosmo_futex_wake((cosmo_futex_t *)&rwlock->_word, INT_MAX,
+                     rwlock->_pshared);
+  return 0;
 }
@@ -16,9 +16,12 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/blockcancel.internal.h"
 #include "libc/calls/state.internal.h"
+#include "libc/cosmo.h"
 #include "libc/intrin/atomic.h"
 #include "libc/intrin/weaken.h"
+#include "libc/thread/lock.h"
 #include "libc/thread/thread.h"
 #include "third_party/nsync/mu.h"
 
@@ -39,16 +42,39 @@ errno_t pthread_rwlock_wrlock(pthread_rwlock_t *rwlock) {
   }
 #endif
 
-  // naive implementation
+  // futex implementation
+  // bit 0 means write locked, bit 1 means someone's parked, and the
+  // remaining bits count readers
   uint32_t w = 0;
-  for (;;) {
-    if (atomic_compare_exchange_weak_explicit(
-            &rwlock->_word, &w, 1, memory_order_acquire, memory_order_relaxed))
-      return 0;
-    atomic_fetch_add(&rwlock->_waiters, 1);
-    for (;;)
-      if (!(w = atomic_load_explicit(&rwlock->_word, memory_order_relaxed)))
+  if (atomic_compare_exchange_strong_explicit(
+          &rwlock->_word, &w, 1, memory_order_acquire, memory_order_relaxed))
+    return 0;
+  atomic_fetch_add(&rwlock->_waiters, 1);
+  for (int n = 0;;) {
+    if (!(w & ~2u)) {
+      if (atomic_compare_exchange_weak_explicit(&rwlock->_word, &w, w | 1,
+                                                memory_order_acquire,
+                                                memory_order_relaxed))
         break;
-    atomic_fetch_sub(&rwlock->_waiters, 1);
+      continue;
+    }
+    // spin briefly unless others have already given up and parked
+    if (n < MUTEX_SPIN_MAX && !(w & 2)) {
+      ++n;
+      pthread_pause_np();
+      w = atomic_load_explicit(&rwlock->_word, memory_order_relaxed);
+      continue;
+    }
+    if ((w & 2) || atomic_compare_exchange_weak_explicit(
+                       &rwlock->_word, &w, w | 2, memory_order_relaxed,
+                       memory_order_relaxed)) {
+      BLOCK_CANCELATION;
+      cosmo_futex_wait((cosmo_futex_t *)&rwlock->_word, w | 2,
+                       rwlock->_pshared, 0, 0);
+      ALLOW_CANCELATION;
+    }
+    w = atomic_load_explicit(&rwlock->_word, memory_order_relaxed);
   }
+  atomic_fetch_sub(&rwlock->_waiters, 1);
+  return 0;
 }
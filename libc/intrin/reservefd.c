@@ -38,7 +38,7 @@
  */
 int __ensurefds_unlocked(int fd) {
   struct CosmoPib *pib = __get_pib();
-  if (fd < pib->fds.n)
+  if (fd < atomic_load_explicit(&pib->fds.n, memory_order_relaxed))
     return fd;
   while (fd >= pib->fds.c / sizeof(struct Fd)) {
     if (mmap((char *)pib->fds.p + pib->fds.c, __gransize,
@@ -48,7 +48,7 @@ int __ensurefds_unlocked(int fd) {
       return emfile();
     pib->fds.c += __gransize;
   }
-  pib->fds.n = fd + 1;
+  atomic_store_explicit(&pib->fds.n, fd + 1, memory_order_release);
   return fd;
 }
 
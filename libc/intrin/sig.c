@@ -43,6 +43,7 @@
 #include "libc/intrin/strace.h"
 #include "libc/intrin/weaken.h"
 #include "libc/log/libfatal.internal.h"
+#include "libc/nexgen32e/rdtsc.h"
 #include "libc/mem/alloca.h"
 #include "libc/nt/console.h"
 #include "libc/nt/enum/context.h"
@@ -92,6 +93,7 @@ __msabi extern typeof(SleepEx) *const __imp_SleepEx;
 struct SignalFrame {
   unsigned rva;
   unsigned flags;
+  uint64_t tsc;  // when __sig_killer() was called
   siginfo_t si;
   ucontext_t ctx;
 };
@@ -434,6 +436,16 @@ textwindows int __sig_relay(int sig, int sic, sigset_t waitmask) {
 textwindows wontreturn static void __sig_tramp(struct SignalFrame *sf) {
   int sig = sf->si.si_signo;
   struct CosmoTib *tib = __get_tls_win32();
+
+  // measure how long it took to take control of this thread
+  uint64_t ns = (rdtsc() - sf->tsc) / 3;
+  uint64_t max = atomic_load_explicit(&__sig.maxnanos, memory_order_relaxed);
+  atomic_fetch_add_explicit(&__sig.nanos, ns, memory_order_relaxed);
+  while (ns > max && !atomic_compare_exchange_weak_explicit(
+                         &__sig.maxnanos, &max, ns, memory_order_relaxed,
+                         memory_order_relaxed)) {
+  }
+
   for (;;) {
 
     // update the signal mask in preparation for signal handler
@@ -504,6 +516,7 @@ HAIRY optimizespeed void __sig_translate(ucontext_t *ctx,
 
 // sends signal to another specific thread which is ref'd
 textwindows static int __sig_killer(struct PosixThread *pt, int sig, int sic) {
+  uint64_t tsc = rdtsc();
   struct CosmoPib *pib = __get_pib();
   unsigned rva = pib->sighandrvas[sig - 1];
   unsigned flags = pib->sighandflags[sig - 1];
@@ -541,6 +554,29 @@ textwindows static int __sig_killer(struct PosixThread *pt, int sig, int sic) {
     return 0;
   }
 
+  // signals aren't queued, so if this one is already pending on the
+  // thread, e.g. because an itimer is firing faster than the handler
+  // can run, then it's already on its way and there's nothing to do.
+  if (atomic_load(&pt->tib->tib_sigpending) & (1ull << (sig - 1))) {
+    atomic_fetch_add_explicit(&__sig.coalesced, 1, memory_order_relaxed);
+    __sig_wake(pt);
+    return 0;
+  }
+
+  // if the thread is waiting inside a cancelation point, then it's at
+  // a safe point where it'll check for pending signals once woken, so
+  // we can avoid the expense of suspending it and rewriting its state.
+  // if it leaves the wait before it's woken, then the bit stays set a
+  // quantum until __sig_worker() sees it's no longer blocked and goes
+  // on to suspend it like any other thread
+  if (atomic_load(&pt->pt_blocker) &&
+      !(pt->pt_blkmask & (1ull << (sig - 1)))) {
+    atomic_fetch_or(&pt->tib->tib_sigpending, 1ull << (sig - 1));
+    atomic_fetch_add_explicit(&__sig.deferred, 1, memory_order_relaxed);
+    __sig_wake(pt);
+    return 0;
+  }
+
   // avoid race conditions and deadlocks with thread suspend process
   if (atomic_exchange(&pt->pt_intoff, 1)) {
     atomic_fetch_or(&pt->tib->tib_sigpending, 1ull << (sig - 1));
@@ -598,6 +634,7 @@ textwindows static int __sig_killer(struct PosixThread *pt, int sig, int sic) {
   __sig_translate(&sf->ctx, &nc);
   sf->rva = rva;
   sf->flags = flags;
+  sf->tsc = tsc;
   sf->si.si_code = sic;
   sf->si.si_signo = sig;
   *(uintptr_t *)(sp -= sizeof(uintptr_t)) = nc.Rip;
@@ -610,6 +647,7 @@ textwindows static int __sig_killer(struct PosixThread *pt, int sig, int sic) {
     return ESRCH;
   }
   ResumeThread(th);
+  atomic_fetch_add_explicit(&__sig.injected, 1, memory_order_relaxed);
   __sig_wake(pt);
   return 0;
 }
@@ -748,7 +786,7 @@ textwindows static void __sig_unmaskable(struct SignalFrame *sf) {
   STRACE("win32 vectored exception 0x%08Xu raising %G "
          "cosmoaddr2line %s %lx %s",
          sf->si.si_errno, sf->si.si_signo,
-         _weaken(FindDebugBinary) ? _weaken(FindDebugBinary)()
+         _weaken(FindDebugBinaryCached) ? _weaken(FindDebugBinaryCached)()
                                   : program_invocation_name,
          sf->ctx.uc_mcontext.gregs[REG_RIP],
          DescribeBacktrace(
@@ -914,7 +952,7 @@ HAIRY static uint32_t __sig_worker(void *arg) {
                STKSZ, PROT_READ | PROT_WRITE,
                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NOFORK);
   __maps_unlock();
-  for (;;) {
+  for (unsigned pass = 1;; ++pass) {
     __sig_worker_lock();
 
     // dequeue all pending signals and fire them off. if there's no
@@ -945,6 +983,9 @@ HAIRY static uint32_t __sig_worker(void *arg) {
     _pthread_unlock();
 
     // unblock stalled asynchronous signals in threads
+    // each thread is visited once per pass, since __sig_killer() might
+    // leave the bits we took pending again, e.g. for a blocked thread
+    // that's been woken to raise them itself, and we mustn't spin on it
     for (;;) {
       sigset_t deliverable;
       struct PosixThread *mark = 0;
@@ -954,6 +995,8 @@ HAIRY static uint32_t __sig_worker(void *arg) {
         struct PosixThread *pt = POSIXTHREAD_CONTAINER(e);
         if (atomic_load(&pt->pt_status) >= kPosixThreadTerminated)
           break;
+        if (pt->pt_sigpass == pass)
+          continue;
         for (;;) {
           sigset_t mask = atomic_load(&pt->tib->tib_sigmask);
           sigset_t pending = atomic_load(&pt->tib->tib_sigpending);
@@ -961,6 +1004,7 @@ HAIRY static uint32_t __sig_worker(void *arg) {
             break;
           if (atomic_compare_exchange_weak(&pt->tib->tib_sigpending, &pending,
                                            pending & ~deliverable)) {
+            pt->pt_sigpass = pass;
             _pthread_ref(pt);
             mark = pt;
             break;
@@ -58,8 +58,13 @@ COSMOPOLITAN_C_START_
   ((void)(SYSDEBUG && _TIMETRACE && strace_enabled(0) > 0 && \
           (__stracef(STRACE_PROLOGUE FMT "\n", ##__VA_ARGS__), 0)))
 
+extern bool __strace_summary;
+
 int strace_enabled(int);
 void __stracef(const char *, ...);
+void __strace_record(const char *, va_list);
+void __strace_summary_print(void);
+void __systrace_install(void);
 
 COSMOPOLITAN_C_END_
 #endif /* !(__ASSEMBLER__ + __LINKER__ + 0) */
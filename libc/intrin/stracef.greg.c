@@ -27,7 +27,11 @@ dontinstrument void __stracef(const char *fmt, ...) {
   if (strace_enabled(0) <= 0)
     return;
   va_start(v, fmt);
-  kvprintf(fmt, v);
+  if (__strace_summary) {
+    __strace_record(fmt, v);
+  } else {
+    kvprintf(fmt, v);
+  }
   va_end(v);
 }
 
@@ -0,0 +1,267 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/sig.internal.h"
+#include "libc/dce.h"
+#include "libc/intrin/atomic.h"
+#include "libc/intrin/bsr.h"
+#include "libc/intrin/kprintf.h"
+#include "libc/intrin/strace.h"
+#include "libc/macros.h"
+#include "libc/nexgen32e/rdtsc.h"
+#include "libc/runtime/runtime.h"
+#include "libc/str/str.h"
+#include "libc/thread/tls.h"
+
+#define SLOTS   256  // maximum number of distinct trace points
+#define PROBE   16   // linear probe distance in stats table
+#define BUCKETS 32   // power of two latency buckets in nanoseconds
+
+struct StraceStat {
+  _Atomic(const char *) fmt;
+  atomic_ulong calls;
+  atomic_ulong errors;
+  atomic_ulong nanos;
+  atomic_ulong maxnanos;
+  atomic_ulong hist[BUCKETS];
+};
+
+bool __strace_summary;
+static struct StraceStat g_stats[SLOTS];
+
+// finds return value, i.e. the first argument formatted after arrow
+dontinstrument static bool GetResult(const char *f, va_list va, long *rc) {
+  long x;
+  int c, type;
+  bool arrow = false;
+  while ((c = *f++)) {
+    if (c == (char)0xe2 && f[0] == (char)0x86 && f[1] == (char)0x92) {
+      arrow = true;
+      f += 2;
+      continue;
+    }
+    if (c != '%')
+      continue;
+    for (type = 0;; ++f) {
+      c = *f;
+      if (c == 'h') {
+        --type;
+      } else if (c == 'j' || c == 'l' || c == 'z') {
+        ++type;
+      } else if (c == '*') {
+        (void)va_arg(va, int);
+      } else if (!strchr(".-#`_,' +^!0123456789", c) || !c) {
+        break;
+      }
+    }
+    switch ((c = *f++)) {
+      case 'T':
+      case 'P':
+      case 'H':
+      case 'm':
+      case 'n':
+      case 'r':
+      case '%':
+        continue;
+      case 'd':
+      case 'u':
+      case 'x':
+      case 'X':
+      case 'o':
+      case 'b':
+      case 'c':
+      case 'C':
+      case 'G':
+        if (type > 0) {
+          x = va_arg(va, long);
+        } else {
+          x = va_arg(va, int);
+        }
+        break;
+      case 'p':
+      case 's':
+      case 't':
+        x = (intptr_t)va_arg(va, void *);
+        break;
+      default:
+        return false;
+    }
+    if (arrow) {
+      *rc = x;
+      return true;
+    }
+  }
+  return false;
+}
+
+dontinstrument static struct StraceStat *GetStat(const char *fmt) {
+  const char *expect;
+  struct StraceStat *s;
+  size_t h = (uintptr_t)fmt * 0x9e3779b97f4a7c15 >> 56;
+  for (int i = 0; i < PROBE; ++i) {
+    s = &g_stats[(h + i) & (SLOTS - 1)];
+    expect = atomic_load_explicit(&s->fmt, memory_order_relaxed);
+    if (expect == fmt)
+      return s;
+    if (!expect && atomic_compare_exchange_strong_explicit(
+                       &s->fmt, &expect, fmt, memory_order_relaxed,
+                       memory_order_relaxed))
+      return s;
+    if (expect == fmt)
+      return s;
+  }
+  return 0;
+}
+
+/**
+ * Tallies traced call for `--strace-summary`.
+ *
+ * This is called by __stracef() instead of formatting the message. The
+ * message is only counted if it reports the result of a call, i.e. it
+ * has an arrow. Latency is measured from when the last system call was
+ * started by the current thread, which systemfive() records if summary
+ * mode is enabled. Calls that never entered the kernel count as zero.
+ */
+dontinstrument void __strace_record(const char *fmt, va_list va) {
+  long rc;
+  va_list vb;
+  bool found;
+  struct CosmoTib *tib;
+  struct StraceStat *s;
+  uint64_t t, ns = 0, max;
+  va_copy(vb, va);
+  found = GetResult(fmt, vb, &rc);
+  va_end(vb);
+  if (!found || !(s = GetStat(fmt)))
+    return;
+  if (__tls_enabled && (t = (tib = __get_tls())->tib_systsc)) {
+    ns = (rdtsc() - t) / 3;
+    tib->tib_systsc = 0;
+  }
+  atomic_fetch_add_explicit(&s->calls, 1, memory_order_relaxed);
+  if (rc == -1)
+    atomic_fetch_add_explicit(&s->errors, 1, memory_order_relaxed);
+  atomic_fetch_add_explicit(&s->nanos, ns, memory_order_relaxed);
+  atomic_fetch_add_explicit(&s->hist[ns ? MIN(bsrl(ns) + 1, BUCKETS - 1) : 0],
+                            1, memory_order_relaxed);
+  max = atomic_load_explicit(&s->maxnanos, memory_order_relaxed);
+  while (ns > max && !atomic_compare_exchange_weak_explicit(
+                         &s->maxnanos, &max, ns, memory_order_relaxed,
+                         memory_order_relaxed)) {
+  }
+}
+
+// returns name of function in trace message, e.g. "read"
+dontinstrument static const char *GetName(const char *fmt, int *len) {
+  int n;
+  if (!strncmp(fmt, STRACE_PROLOGUE, sizeof(STRACE_PROLOGUE) - 1))
+    fmt += sizeof(STRACE_PROLOGUE) - 1;
+  if (!strncmp(fmt, "\e[2m", 4))
+    fmt += 4;
+  for (n = 0; ('a' <= fmt[n] && fmt[n] <= 'z') ||
+              ('A' <= fmt[n] && fmt[n] <= 'Z') ||
+              ('0' <= fmt[n] && fmt[n] <= '9') || fmt[n] == '_';
+       ++n) {
+  }
+  *len = n;
+  return fmt;
+}
+
+// returns upper bound of latency bucket containing nth fastest call
+dontinstrument static uint64_t GetPercentile(const uint64_t hist[BUCKETS],
+                                             uint64_t calls, int pct) {
+  uint64_t k = 0, want = (calls * pct + 99) / 100;
+  for (int b = 0; b < BUCKETS; ++b)
+    if ((k += hist[b]) >= want)
+      return b ? 1ull << b : 0;
+  return 0;
+}
+
+/**
+ * Prints table of traced calls for `--strace-summary`.
+ *
+ * Trace points that report the same function name are merged, and rows
+ * are sorted by total latency. Percentiles are the upper bounds of the
+ * power of two histogram buckets they fall into. On Windows, how many
+ * signals needed their target thread to be suspended is shown too, as
+ * well as the latency of doing so. This function can be called from a
+ * signal handler.
+ */
+dontinstrument void __strace_summary_print(void) {
+  const char *name, *name2;
+  int i, j, n, len, len2, best;
+  uint64_t calls, errors, nanos, max, hist[BUCKETS];
+  uint16_t rep[SLOTS];
+  uint64_t total[SLOTS];
+  bool done[SLOTS];
+  // group trace points by name
+  for (n = i = 0; i < SLOTS; ++i) {
+    rep[i] = SLOTS;
+    done[i] = true;
+    if (!atomic_load_explicit(&g_stats[i].fmt, memory_order_relaxed))
+      continue;
+    name = GetName(g_stats[i].fmt, &len);
+    for (rep[i] = i, j = 0; j < i; ++j) {
+      if (done[j] || rep[j] != j)
+        continue;
+      name2 = GetName(g_stats[j].fmt, &len2);
+      if (len == len2 && !memcmp(name, name2, len)) {
+        rep[i] = j;
+        break;
+      }
+    }
+    if (rep[i] == i) {
+      total[i] = 0;
+      done[i] = false;
+      ++n;
+    }
+    total[rep[i]] += g_stats[i].nanos;
+  }
+  kprintf("\n%-10s %10s %16s %10s %10s %10s %12s  %s\n", "calls", "errors",
+          "total ns", "avg ns", "p50 ns", "p99 ns", "max ns", "name");
+  // print groups in order of decreasing total latency
+  while (n--) {
+    for (best = -1, i = 0; i < SLOTS; ++i)
+      if (!done[i] && (best == -1 || total[i] > total[best]))
+        best = i;
+    done[best] = true;
+    calls = errors = nanos = max = 0;
+    bzero(hist, sizeof(hist));
+    for (i = best; i < SLOTS; ++i) {
+      if (rep[i] != best)
+        continue;
+      calls += g_stats[i].calls;
+      errors += g_stats[i].errors;
+      nanos += g_stats[i].nanos;
+      max = MAX(max, g_stats[i].maxnanos);
+      for (j = 0; j < BUCKETS; ++j)
+        hist[j] += g_stats[i].hist[j];
+    }
+    name = GetName(g_stats[best].fmt, &len);
+    kprintf("%-'10lu %'10lu %'16lu %'10lu %'10lu %'10lu %'12lu  %.*s\n",
+            calls, errors, nanos, calls ? nanos / calls : 0,
+            GetPercentile(hist, calls, 50), GetPercentile(hist, calls, 99),
+            max, len, name);
+  }
+  // windows signal delivery
+  if (IsWindows() && (__sig.injected || __sig.deferred || __sig.coalesced))
+    kprintf("\n%'lu signals injected (avg %'lu ns, max %'lu ns), "
+            "%'lu deferred to safe points, %'lu coalesced\n",
+            __sig.injected, __sig.injected ? __sig.nanos / __sig.injected : 0,
+            __sig.maxnanos, __sig.deferred, __sig.coalesced);
+}
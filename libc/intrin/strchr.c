@@ -20,6 +20,7 @@
 #include "libc/dce.h"
 #include "libc/nexgen32e/x86feature.h"
 #include "libc/str/str.h"
+#include "third_party/intel/immintrin.internal.h"
 #ifndef __aarch64__
 
 static inline const char *strchr_pure(const char *s, int c) {
@@ -56,6 +57,31 @@ static __vex const char *strchr_sse(const char *s, unsigned char c) {
     s = 0;
   return s;
 }
+
+#pragma GCC push_options
+#pragma GCC target("avx512bw")
+static const char *strchr_avx512(const char *s, unsigned char c) {
+  __m512i v;
+  uint64_t m;
+  const __m512i *p;
+  __m512i z = _mm512_setzero_si512();
+  __m512i n = _mm512_set1_epi8(c);
+  unsigned k = (uintptr_t)s & 63;
+  p = (const __m512i *)((uintptr_t)s & -64);
+  v = _mm512_load_si512(p);
+  m = _mm512_cmpeq_epi8_mask(v, z) | _mm512_cmpeq_epi8_mask(v, n);
+  m >>= k;
+  m <<= k;
+  while (!m) {
+    v = _mm512_load_si512(++p);
+    m = _mm512_cmpeq_epi8_mask(v, z) | _mm512_cmpeq_epi8_mask(v, n);
+  }
+  s = (const char *)p + __builtin_ctzll(m);
+  if (c && !*s)
+    s = 0;
+  return s;
+}
+#pragma GCC pop_options
 #endif
 
 static inline const char *strchr_x64(const char *p, uint64_t c) {
@@ -100,7 +126,9 @@ static inline const char *strchr_x64(const char *p, uint64_t c) {
 char *strchr(const char *s, int c) {
 #if defined(__x86_64__) && !defined(__chibicc__)
   const char *r;
-  if (X86_HAVE(SSE)) {
+  if (X86_HAVE(AVX512BW)) {
+    r = strchr_avx512(s, c);
+  } else if (X86_HAVE(SSE)) {
     r = strchr_sse(s, c);
   } else {
     r = strchr_pure(s, c);
@@ -16,10 +16,28 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/nexgen32e/x86feature.h"
 #include "libc/str/str.h"
 #include "third_party/intel/immintrin.internal.h"
 #ifndef __aarch64__
 
+#if defined(__x86_64__) && !defined(__chibicc__)
+#pragma GCC push_options
+#pragma GCC target("avx512bw")
+static size_t strlen_avx512(const char *s) {
+  __m512i zv = _mm512_setzero_si512();
+  const __m512i *v = (const __m512i *)((intptr_t)s & -64);
+  int skew = (intptr_t)s & 63;
+  uint64_t m = _mm512_cmpeq_epi8_mask(_mm512_load_si512(v), zv);
+  m >>= skew;
+  m <<= skew;
+  while (!m)
+    m = _mm512_cmpeq_epi8_mask(_mm512_load_si512(++v), zv);
+  return (const char *)v + __builtin_ctzll(m) - s;
+}
+#pragma GCC pop_options
+#endif
+
 static __vex size_t __strlen(const char *s) {
 #if defined(__AVX2__)
   __m256i zv = _mm256_setzero_si256();
@@ -75,6 +93,10 @@ static __vex size_t __strlen(const char *s) {
  * @asyncsignalsafe
  */
 size_t strlen(const char *s) {
+#if defined(__x86_64__) && !defined(__chibicc__)
+  if (X86_HAVE(AVX512BW))
+    return strlen_avx512(s);
+#endif
   return __strlen(s);
 }
 
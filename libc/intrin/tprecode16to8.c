@@ -28,17 +28,23 @@
 
 static axdx_t tprecode16to8_sse2(char *dst, size_t dstsize, const char16_t *src,
                                  axdx_t r) {
+  unsigned m;
   __m128i v1, v2, v3, vz;
   vz = _mm_setzero_si128();
-  while (r.ax + 8 < dstsize) {
+  while (r.ax + 8 < dstsize &&
+         ((uintptr_t)(src + r.dx) & 4095) <= 4096 - 16) {
     v1 = _mm_loadu_si128((__m128i *)(src + r.dx));
     v2 = _mm_cmpgt_epi16(v1, vz);
     v3 = _mm_cmpgt_epi16(v1, _mm_set1_epi16(0x7F));
     v2 = _mm_andnot_si128(v3, v2);
-    if (_mm_movemask_epi8(v2) != 0xFFFF)
+    m = _mm_movemask_epi8(v2) ^ 0xFFFF;
+    _mm_storel_epi64((__m128i *)(dst + r.ax), _mm_packs_epi16(v1, v1));
+    if (m) {
+      m = __builtin_ctz(m) >> 1;
+      r.ax += m;
+      r.dx += m;
       break;
-    v1 = _mm_packs_epi16(v1, v1);
-    _mm_storel_epi64((__m128i *)(dst + r.ax), v1);
+    }
     r.ax += 8;
     r.dx += 8;
   }
@@ -49,15 +55,22 @@ static axdx_t tprecode16to8_sse2(char *dst, size_t dstsize, const char16_t *src,
 
 static axdx_t tprecode16to8_neon(char *dst, size_t dstsize, const char16_t *src,
                                  axdx_t r) {
+  uint64_t m;
   uint16x8_t v1, v2, v3;
-  while (r.ax + 8 < dstsize) {
+  while (r.ax + 8 < dstsize &&
+         ((uintptr_t)(src + r.dx) & 4095) <= 4096 - 16) {
     v1 = vld1q_u16((const uint16_t *)(src + r.dx));
     v2 = vcgtq_u16(v1, vdupq_n_u16(0));
     v3 = vcgtq_u16(v1, vdupq_n_u16(0x7F));
     v2 = vbicq_u16(v2, v3);
-    if (vaddvq_u16(v2) != 8 * 0xFFFF)
-      break;
     vst1_u8((uint8_t *)(dst + r.ax), vqmovn_u16(v1));
+    if (vminvq_u16(v2) != 0xFFFF) {
+      m = ~vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(v2)), 0);
+      m = __builtin_ctzll(m) >> 3;
+      r.ax += m;
+      r.dx += m;
+      break;
+    }
     r.ax += 8;
     r.dx += 8;
   }
@@ -88,11 +101,9 @@ axdx_t tprecode16to8(char *dst, size_t dstsize, const char16_t *src) {
   for (;;) {
 #if !IsModeDbg()
 #if defined(__x86_64__)
-    if (!((uintptr_t)(src + r.dx) & 15))
-      r = tprecode16to8_sse2(dst, dstsize, src, r);
+    r = tprecode16to8_sse2(dst, dstsize, src, r);
 #elif defined(__aarch64__)
-    if (!((uintptr_t)(src + r.dx) & 15))
-      r = tprecode16to8_neon(dst, dstsize, src, r);
+    r = tprecode16to8_neon(dst, dstsize, src, r);
 #endif
 #endif
     if (!(x = src[r.dx++]))
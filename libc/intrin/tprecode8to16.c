@@ -31,17 +31,21 @@
 
 static inline axdx_t tprecode8to16_sse2(char16_t *dst, size_t dstsize,
                                         const char *src, axdx_t r) {
-  __m128i v1, v2, vz;
+  unsigned m;
+  __m128i v1, vz;
   vz = _mm_setzero_si128();
-  while (r.ax + 16 < dstsize) {
+  while (r.ax + 16 < dstsize &&
+         ((uintptr_t)(src + r.dx) & 4095) <= 4096 - 16) {
     v1 = _mm_loadu_si128((__m128i *)(src + r.dx));
-    v2 = _mm_cmpgt_epi8(v1, vz);
-    if (_mm_movemask_epi8(v2) != 0xFFFF)
+    m = _mm_movemask_epi8(_mm_cmpgt_epi8(v1, vz)) ^ 0xFFFF;
+    _mm_storeu_si128((__m128i *)(dst + r.ax), _mm_unpacklo_epi8(v1, vz));
+    _mm_storeu_si128((__m128i *)(dst + r.ax + 8), _mm_unpackhi_epi8(v1, vz));
+    if (m) {
+      m = __builtin_ctz(m);
+      r.ax += m;
+      r.dx += m;
       break;
-    __m128i lo = _mm_unpacklo_epi8(v1, vz);
-    __m128i hi = _mm_unpackhi_epi8(v1, vz);
-    _mm_storeu_si128((__m128i *)(dst + r.ax), lo);
-    _mm_storeu_si128((__m128i *)(dst + r.ax + 8), hi);
+    }
     r.ax += 16;
     r.dx += 16;
   }
@@ -52,16 +56,22 @@ static inline axdx_t tprecode8to16_sse2(char16_t *dst, size_t dstsize,
 
 static inline axdx_t tprecode8to16_neon(char16_t *dst, size_t dstsize,
                                         const char *src, axdx_t r) {
-  uint8x16_t v1;
-  while (r.ax + 16 < dstsize) {
+  uint64_t m;
+  uint8x16_t v1, v2;
+  while (r.ax + 16 < dstsize &&
+         ((uintptr_t)(src + r.dx) & 4095) <= 4096 - 16) {
     v1 = vld1q_u8((const uint8_t *)(src + r.dx));
-    uint8x16_t cmp = vcgtq_u8(v1, vdupq_n_u8(0));
-    if (vaddvq_u8(cmp) != 16 * 0xFF)
+    v2 = vcgtq_s8(vreinterpretq_s8_u8(v1), vdupq_n_s8(0));
+    vst1q_u16((uint16_t *)(dst + r.ax), vmovl_u8(vget_low_u8(v1)));
+    vst1q_u16((uint16_t *)(dst + r.ax + 8), vmovl_u8(vget_high_u8(v1)));
+    if (vminvq_u8(v2) != 0xFF) {
+      m = ~vget_lane_u64(
+          vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(v2), 4)), 0);
+      m = __builtin_ctzll(m) >> 2;
+      r.ax += m;
+      r.dx += m;
       break;
-    uint16x8_t lo = vmovl_u8(vget_low_u8(v1));
-    uint16x8_t hi = vmovl_u8(vget_high_u8(v1));
-    vst1q_u16((uint16_t *)(dst + r.ax), lo);
-    vst1q_u16((uint16_t *)(dst + r.ax + 8), hi);
+    }
     r.ax += 16;
     r.dx += 16;
   }
@@ -93,11 +103,9 @@ axdx_t tprecode8to16(char16_t *dst, size_t dstsize, const char *src) {
   for (;;) {
 #if !IsModeDbg()
 #if defined(__x86_64__)
-    if (!((uintptr_t)(src + r.dx) & 15))
-      r = tprecode8to16_sse2(dst, dstsize, src, r);
+    r = tprecode8to16_sse2(dst, dstsize, src, r);
 #elif defined(__aarch64__)
-    if (!((uintptr_t)(src + r.dx) & 15))
-      r = tprecode8to16_neon(dst, dstsize, src, r);
+    r = tprecode8to16_neon(dst, dstsize, src, r);
 #endif
 #endif
     x = src[r.dx++] & 0377;
@@ -0,0 +1,5 @@
+#ifndef COSMOPOLITAN_LIBC_ISYSTEM_SYS_EPOLL_H_
+#define COSMOPOLITAN_LIBC_ISYSTEM_SYS_EPOLL_H_
+#include "libc/calls/weirdtypes.h"
+#include "libc/sock/epoll.h"
+#endif /* COSMOPOLITAN_LIBC_ISYSTEM_SYS_EPOLL_H_ */
@@ -0,0 +1,6 @@
+#ifndef COSMOPOLITAN_LIBC_ISYSTEM_SYS_PIDFD_H_
+#define COSMOPOLITAN_LIBC_ISYSTEM_SYS_PIDFD_H_
+#include "libc/calls/calls.h"
+#include "libc/calls/struct/siginfo.h"
+#include "libc/sysv/consts/pidfd.h"
+#endif /* COSMOPOLITAN_LIBC_ISYSTEM_SYS_PIDFD_H_ */
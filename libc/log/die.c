@@ -50,7 +50,7 @@ relegated wontreturn void __die(void) {
   kprintf("%serror: %s on %s pid %d tid %d has perished%s\n"
           "cosmoaddr2line %s %s\n",
           __nocolor ? "" : "\e[1;31m", program_invocation_short_name, host,
-          getpid(), gettid(), __nocolor ? "" : "\e[0m", FindDebugBinary(),
+          getpid(), gettid(), __nocolor ? "" : "\e[0m", FindDebugBinaryCached(),
           DescribeBacktrace(__builtin_frame_address(0)));
   ShowBacktrace(2, __builtin_frame_address(0));
   _Exit(77);
@@ -0,0 +1,269 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/atomic.h"
+#include "libc/calls/calls.h"
+#include "libc/calls/struct/sigaction.h"
+#include "libc/cosmo.h"
+#include "libc/errno.h"
+#include "libc/intrin/atomic.h"
+#include "libc/intrin/kprintf.h"
+#include "libc/limits.h"
+#include "libc/log/profbuf.internal.h"
+#include "libc/nexgen32e/stackframe.h"
+#include "libc/runtime/runtime.h"
+#include "libc/stdio/rand.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/map.h"
+#include "libc/sysv/consts/o.h"
+#include "libc/sysv/consts/prot.h"
+#include "libc/sysv/consts/sa.h"
+#include "libc/sysv/errfuns.h"
+
+#define SLOTS 4096  // maximum number of live samples
+#define PROBE 8     // linear probe distance in sample table
+#define DEPTH 30    // maximum number of frames in backtrace
+
+#define EMPTY 0  // slot is unused
+#define BUSY  1  // slot is being written
+
+struct Sample {
+  _Atomic(uintptr_t) addr;
+  size_t size;
+  unsigned depth;
+  uintptr_t frames[DEPTH];
+};
+
+static struct HeapProf {
+  unsigned rate;
+  struct Sample *slots;
+  atomic_ulong dropped;
+  void *(*malloc)(size_t);
+  void (*free)(void *);
+  void *(*calloc)(size_t, size_t);
+  void *(*realloc)(void *, size_t);
+  void *(*memalign)(size_t, size_t);
+  char path[PATH_MAX];
+} g_heapprof;
+
+static _Thread_local unsigned g_countdown;
+
+static size_t HashAddress(uintptr_t p) {
+  return (p >> 4) * 0x9e3779b97f4a7c15 >> 52;
+}
+
+static bool ShouldSample(void) {
+  if (g_countdown) {
+    --g_countdown;
+    return false;
+  }
+  // pick gap uniformly from [0,2n-1) so mean interval is 1 in n, which
+  // avoids aliasing with programs that allocate in a periodic pattern
+  if (g_heapprof.rate > 1)
+    g_countdown = lemur64() % (2 * g_heapprof.rate - 1);
+  return true;
+}
+
+static void SaveSample(struct Sample *s, size_t n) {
+  struct StackFrame *sf;
+  s->size = n;
+  s->depth = 0;
+  for (sf = __builtin_frame_address(0); sf && s->depth < DEPTH; sf = sf->next) {
+    if (kisdangerous(sf))
+      break;
+    s->frames[s->depth++] = sf->addr;
+  }
+}
+
+static void *TrackSample(void *p, size_t n) {
+  struct Sample *s;
+  uintptr_t expect;
+  if (!p || !ShouldSample())
+    return p;
+  for (size_t h = HashAddress((uintptr_t)p), i = 0; i < PROBE; ++i) {
+    s = &g_heapprof.slots[(h + i) & (SLOTS - 1)];
+    expect = EMPTY;
+    if (atomic_compare_exchange_strong_explicit(&s->addr, &expect, BUSY,
+                                                memory_order_acquire,
+                                                memory_order_relaxed)) {
+      SaveSample(s, n);
+      atomic_store_explicit(&s->addr, (uintptr_t)p, memory_order_release);
+      return p;
+    }
+  }
+  atomic_fetch_add_explicit(&g_heapprof.dropped, 1, memory_order_relaxed);
+  return p;
+}
+
+static void UntrackSample(void *p) {
+  uintptr_t expect;
+  if (!p)
+    return;
+  for (size_t h = HashAddress((uintptr_t)p), i = 0; i < PROBE; ++i) {
+    expect = (uintptr_t)p;
+    if (atomic_compare_exchange_strong_explicit(
+            &g_heapprof.slots[(h + i) & (SLOTS - 1)].addr, &expect, EMPTY,
+            memory_order_relaxed, memory_order_relaxed))
+      return;
+  }
+}
+
+static void *HeapProfMalloc(size_t n) {
+  return TrackSample(g_heapprof.malloc(n), n);
+}
+
+static void *HeapProfCalloc(size_t n, size_t z) {
+  return TrackSample(g_heapprof.calloc(n, z), n * z);
+}
+
+static void *HeapProfMemalign(size_t a, size_t n) {
+  return TrackSample(g_heapprof.memalign(a, n), n);
+}
+
+static void *HeapProfRealloc(void *p, size_t n) {
+  void *q;
+  if ((q = g_heapprof.realloc(p, n))) {
+    UntrackSample(p);
+    TrackSample(q, n);
+  }
+  return q;
+}
+
+static void HeapProfFree(void *p) {
+  UntrackSample(p);
+  g_heapprof.free(p);
+}
+
+/**
+ * Writes sampled heap profile to file descriptor.
+ *
+ * The output is in the legacy text heap profile format that's accepted
+ * by `pprof`, e.g. `pprof --text o//prog heap.prof`. Each live sampled
+ * allocation is reported with its backtrace. Counts are scaled by the
+ * sampling rate so they estimate the true number of bytes in use.
+ *
+ * This function is asynchronous signal safe. Allocations that happen
+ * concurrently with the dump may be reported with a torn backtrace.
+ *
+ * @return 0 on success, or -1 w/ errno
+ * @raise EINVAL if cosmo_heapprof_start() wasn't called
+ */
+int cosmo_heapprof_dump(int fd) {
+  int e = errno;
+  struct Sample *s;
+  struct ProfBuffer b = {fd};
+  size_t objs = 0, bytes = 0;
+  if (!g_heapprof.slots)
+    return einval();
+  for (size_t i = 0; i < SLOTS; ++i) {
+    s = &g_heapprof.slots[i];
+    if (atomic_load_explicit(&s->addr, memory_order_acquire) > BUSY) {
+      objs += g_heapprof.rate;
+      bytes += s->size * g_heapprof.rate;
+    }
+  }
+  __profbuf_append(&b, "heap profile: %zu: %zu [%zu: %zu] @ heap\n", objs,
+                   bytes, objs, bytes);
+  for (size_t i = 0; i < SLOTS; ++i) {
+    s = &g_heapprof.slots[i];
+    if (atomic_load_explicit(&s->addr, memory_order_acquire) <= BUSY)
+      continue;
+    objs = g_heapprof.rate;
+    bytes = s->size * g_heapprof.rate;
+    __profbuf_append(&b, "%zu: %zu [%zu: %zu] @", objs, bytes, objs, bytes);
+    for (unsigned j = 0; j < s->depth && j < DEPTH; ++j)
+      __profbuf_append(&b, " %#lx", s->frames[j]);
+    __profbuf_append(&b, "\n");
+  }
+  __profbuf_append(&b, "\nMAPPED_LIBRARIES:\n");
+  __profbuf_maps(&b);
+  __profbuf_flush(&b);
+  errno = e;
+  return 0;
+}
+
+static void OnHeapProfSignal(int sig) {
+  int fd, e = errno;
+  if ((fd = open(g_heapprof.path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                 0644)) != -1) {
+    cosmo_heapprof_dump(fd);
+    close(fd);
+  }
+  errno = e;
+}
+
+/**
+ * Starts sampling memory allocations for heap profiling.
+ *
+ * Once started, one in every `rate` calls to malloc(), calloc(),
+ * realloc() and memalign() on average records a backtrace, which is
+ * kept until the memory is freed. Up to 4096 live samples are kept,
+ * after which further samples get dropped. The profile may be written
+ * at any time using cosmo_heapprof_dump().
+ *
+ * If `sig` is nonzero, then a handler is installed for that signal
+ * which writes the profile to `path`, e.g.
+ *
+ *     cosmo_heapprof_start(1000, SIGUSR2, "/tmp/prog.heap");
+ *
+ * can be inspected by running `kill -USR2 $pid` and then using `pprof`
+ * on the output file. Profiling can't be stopped once started.
+ *
+ * @param rate is the average number of allocations per sample
+ * @param sig is signal upon which profile gets dumped, or 0 for none
+ * @param path is where signal handler writes the profile
+ * @return 0 on success, or -1 w/ errno
+ * @raise EINVAL if `rate` is zero or `sig` is set without a `path`
+ * @raise ENAMETOOLONG if `path` is too long
+ * @raise EBUSY if profiler was already started
+ * @raise ENOMEM if sample table couldn't be allocated
+ */
+int cosmo_heapprof_start(unsigned rate, int sig, const char *path) {
+  struct Sample *slots;
+  if (!rate || (sig && !path))
+    return einval();
+  if (path && strlen(path) >= sizeof(g_heapprof.path))
+    return enametoolong();
+  if (g_heapprof.slots)
+    return ebusy();
+  if ((slots = mmap(0, SLOTS * sizeof(struct Sample), PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)
+    return -1;
+  if (path)
+    strcpy(g_heapprof.path, path);
+  g_heapprof.rate = rate;
+  g_heapprof.slots = slots;
+  g_heapprof.malloc = __dlmalloc;
+  g_heapprof.free = __dlfree;
+  g_heapprof.calloc = __dlcalloc;
+  g_heapprof.realloc = __dlrealloc;
+  g_heapprof.memalign = __dlmemalign;
+  // install free hooks first so no sampled pointer escapes untracked
+  __dlfree = HeapProfFree;
+  __dlrealloc = HeapProfRealloc;
+  atomic_thread_fence(memory_order_release);
+  __dlmalloc = HeapProfMalloc;
+  __dlcalloc = HeapProfCalloc;
+  __dlmemalign = HeapProfMemalign;
+  if (sig)
+    sigaction(sig,
+              &(struct sigaction){.sa_handler = OnHeapProfSignal,
+                                  .sa_flags = SA_RESTART},
+              0);
+  return 0;
+}
@@ -69,7 +69,7 @@ relegated dontinstrument void __minicrash(int sig, siginfo_t *si, void *arg) {
       __nocolor ? "" : "\e[1;31m", program_invocation_short_name, host,
       getpid(), gettid(), sig,
       __is_stack_overflow(si, ctx) ? " (stack overflow)" : "", si->si_code,
-      si->si_addr, __nocolor ? "" : "\e[0m", FindDebugBinary(),
+      si->si_addr, __nocolor ? "" : "\e[0m", FindDebugBinaryCached(),
       ctx ? ctx->uc_mcontext.PC : 0,
       DescribeBacktrace(ctx ? (struct StackFrame *)ctx->uc_mcontext.BP
                             : (struct StackFrame *)__builtin_frame_address(0)));
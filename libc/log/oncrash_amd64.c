@@ -75,7 +75,7 @@ static const char kFpuExceptions[6] forcealign(1) = "IDZOUP";
 
 relegated static void ShowFunctionCalls(ucontext_t *ctx) {
   kprintf(
-      "cosmoaddr2line %s %lx %s\n\n", FindDebugBinary(),
+      "cosmoaddr2line %s %lx %s\n\n", FindDebugBinaryCached(),
       ctx ? ctx->uc_mcontext.PC : 0,
       DescribeBacktrace(ctx ? (struct StackFrame *)ctx->uc_mcontext.BP
                             : (struct StackFrame *)__builtin_frame_address(0)));
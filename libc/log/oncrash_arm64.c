@@ -233,7 +233,7 @@ static relegated void __oncrash_impl(int sig, siginfo_t *si, ucontext_t *ctx) {
   Append(b, " %s %s %s %s\n", names.sysname, names.version, names.nodename,
          names.release);
   Append(
-      b, " cosmoaddr2line %s %lx %s\n", FindDebugBinary(),
+      b, " cosmoaddr2line %s %lx %s\n", FindDebugBinaryCached(),
       ctx ? ctx->uc_mcontext.PC : 0,
       DescribeBacktrace(ctx ? (struct StackFrame *)ctx->uc_mcontext.BP
                             : (struct StackFrame *)__builtin_frame_address(0)));
@@ -0,0 +1,92 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/log/profbuf.internal.h"
+#include "ape/sections.internal.h"
+#include "libc/calls/calls.h"
+#include "libc/errno.h"
+#include "libc/intrin/kprintf.h"
+#include "libc/macros.h"
+#include "libc/runtime/runtime.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/o.h"
+
+void __profbuf_flush(struct ProfBuffer *b) {
+  for (int j = 0; j < b->i;) {
+    ssize_t rc = write(b->fd, b->p + j, b->i - j);
+    if (rc > 0) {
+      j += rc;
+    } else if (rc == -1 && errno == EINTR) {
+      continue;
+    } else {
+      break;
+    }
+  }
+  b->i = 0;
+}
+
+void __profbuf_write(struct ProfBuffer *b, const void *p, size_t n) {
+  size_t m;
+  while (n) {
+    if (b->i == sizeof(b->p))
+      __profbuf_flush(b);
+    m = MIN(n, sizeof(b->p) - b->i);
+    memcpy(b->p + b->i, p, m);
+    p = (const char *)p + m;
+    b->i += m;
+    n -= m;
+  }
+}
+
+void __profbuf_append(struct ProfBuffer *b, const char *fmt, ...) {
+  int n;
+  va_list va;
+  if (b->i > (int)sizeof(b->p) - 256)
+    __profbuf_flush(b);
+  va_start(va, fmt);
+  n = kvsnprintf(b->p + b->i, sizeof(b->p) - b->i, fmt, va);
+  va_end(va);
+  if (n > 0)
+    b->i += MIN(n, (int)sizeof(b->p) - 1 - b->i);
+}
+
+/**
+ * Appends memory map of process, in the format of `/proc/self/maps`.
+ *
+ * This is needed by `pprof` to symbolize addresses. If the operating
+ * system doesn't have procfs, then only the executable gets reported.
+ */
+void __profbuf_maps(struct ProfBuffer *b) {
+  int fd;
+  ssize_t rc;
+  if ((fd = open("/proc/self/maps", O_RDONLY | O_CLOEXEC)) != -1) {
+    __profbuf_flush(b);
+    while ((rc = read(fd, b->p, sizeof(b->p))) > 0 ||
+           (rc == -1 && errno == EINTR)) {
+      if (rc > 0) {
+        b->i = rc;
+        __profbuf_flush(b);
+      }
+    }
+    close(fd);
+  } else if (__executable_start && _etext) {
+    __profbuf_append(b, "%012lx-%012lx r-xp 00000000 00:00 0 %s\n",
+                     (uintptr_t)__executable_start, (uintptr_t)_etext,
+                     GetProgramExecutableName());
+  }
+}
@@ -0,0 +1,18 @@
+#ifndef COSMOPOLITAN_LIBC_LOG_PROFBUF_INTERNAL_H_
+#define COSMOPOLITAN_LIBC_LOG_PROFBUF_INTERNAL_H_
+COSMOPOLITAN_C_START_
+
+/* small write buffer that's safe to use from signal handlers */
+struct ProfBuffer {
+  int fd;
+  int i;
+  char p[1024];
+};
+
+void __profbuf_flush(struct ProfBuffer *);
+void __profbuf_write(struct ProfBuffer *, const void *, size_t);
+void __profbuf_append(struct ProfBuffer *, const char *, ...);
+void __profbuf_maps(struct ProfBuffer *);
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_LIBC_LOG_PROFBUF_INTERNAL_H_ */
@@ -0,0 +1,338 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/atomic.h"
+#include "libc/calls/calls.h"
+#include "libc/calls/struct/itimerval.h"
+#include "libc/calls/struct/sigaction.h"
+#include "libc/calls/struct/siginfo.h"
+#include "libc/calls/ucontext.h"
+#include "libc/cosmo.h"
+#include "libc/errno.h"
+#include "libc/fmt/conv.h"
+#include "libc/intrin/atomic.h"
+#include "libc/intrin/kprintf.h"
+#include "libc/limits.h"
+#include "libc/log/profbuf.internal.h"
+#include "libc/nexgen32e/stackframe.h"
+#include "libc/runtime/runtime.h"
+#include "libc/runtime/symbols.internal.h"
+#include "libc/stdio/stdio.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/itimer.h"
+#include "libc/sysv/consts/map.h"
+#include "libc/sysv/consts/o.h"
+#include "libc/sysv/consts/prot.h"
+#include "libc/sysv/consts/sa.h"
+#include "libc/sysv/consts/sig.h"
+#include "libc/sysv/errfuns.h"
+
+#define SLOTS 8192  // maximum number of distinct backtraces
+#define PROBE 16    // linear probe distance in sample table
+#define DEPTH 32    // maximum number of frames in backtrace
+
+#define EMPTY 0  // slot is unused
+#define BUSY  1  // slot is being written
+
+struct Sample {
+  _Atomic(uint64_t) hash;
+  atomic_ulong count;
+  unsigned depth;
+  uintptr_t frames[DEPTH];
+};
+
+static struct Profile {
+  int pid;
+  int flags;
+  unsigned hz;
+  atomic_int inflight;
+  atomic_ulong dropped; /* samples that didn't fit table */
+  _Atomic(struct Sample *) slots;
+  char path[PATH_MAX];
+} g_profile;
+
+static uint64_t HashFrames(const uintptr_t *frames, unsigned depth) {
+  uint64_t h = depth;
+  for (unsigned i = 0; i < depth; ++i)
+    h = (h ^ frames[i]) * 0x9e3779b97f4a7c15;
+  return h > BUSY ? h : h + 2;
+}
+
+static void SaveSample(struct Sample *slots, const uintptr_t *frames,
+                       unsigned depth) {
+  uint64_t want, have;
+  struct Sample *s;
+  want = HashFrames(frames, depth);
+  for (size_t h = want >> 32, i = 0; i < PROBE; ++i) {
+    s = &slots[(h + i) & (SLOTS - 1)];
+    have = atomic_load_explicit(&s->hash, memory_order_acquire);
+    if (have == EMPTY &&
+        atomic_compare_exchange_strong_explicit(&s->hash, &have, BUSY,
+                                                memory_order_acquire,
+                                                memory_order_acquire)) {
+      s->depth = depth;
+      memcpy(s->frames, frames, depth * sizeof(*frames));
+      atomic_store_explicit(&s->count, 1, memory_order_relaxed);
+      atomic_store_explicit(&s->hash, want, memory_order_release);
+      return;
+    }
+    if (have == want && s->depth == depth &&
+        !memcmp(s->frames, frames, depth * sizeof(*frames))) {
+      atomic_fetch_add_explicit(&s->count, 1, memory_order_relaxed);
+      return;
+    }
+  }
+  atomic_fetch_add_explicit(&g_profile.dropped, 1, memory_order_relaxed);
+}
+
+static void OnSigprof(int sig, siginfo_t *si, void *arg) {
+  unsigned depth = 0;
+  ucontext_t *ctx = arg;
+  struct StackFrame *sf;
+  struct Sample *slots;
+  uintptr_t frames[DEPTH];
+  atomic_fetch_add(&g_profile.inflight, 1);
+  if ((slots = atomic_load(&g_profile.slots))) {
+#ifdef __x86_64__
+    frames[depth++] = ctx->uc_mcontext.rip;
+    sf = (struct StackFrame *)ctx->uc_mcontext.rbp;
+#elif defined(__aarch64__)
+    frames[depth++] = ctx->uc_mcontext.pc;
+    sf = (struct StackFrame *)ctx->uc_mcontext.regs[29];
+#endif
+    for (; sf && depth < DEPTH; sf = sf->next) {
+      if (kisdangerous(sf))
+        break;
+      frames[depth++] = sf->addr;
+    }
+    SaveSample(slots, frames, depth);
+  }
+  atomic_fetch_sub(&g_profile.inflight, 1);
+}
+
+static bool IsRecorded(struct Sample *s) {
+  return atomic_load_explicit(&s->hash, memory_order_acquire) > BUSY;
+}
+
+// writes legacy cpu profile format of gperftools, which pprof reads
+static void DumpPprof(struct ProfBuffer *b, struct Sample *slots) {
+  uintptr_t word[5] = {0, 3, 0, 1000000 / g_profile.hz, 0};
+  __profbuf_write(b, word, sizeof(word));
+  for (size_t i = 0; i < SLOTS; ++i) {
+    if (!IsRecorded(&slots[i]))
+      continue;
+    word[0] = atomic_load_explicit(&slots[i].count, memory_order_relaxed);
+    word[1] = slots[i].depth;
+    __profbuf_write(b, word, 2 * sizeof(*word));
+    __profbuf_write(b, slots[i].frames, slots[i].depth * sizeof(*word));
+  }
+  word[0] = 0;
+  word[1] = 1;
+  word[2] = 0;
+  __profbuf_write(b, word, 3 * sizeof(*word));
+  __profbuf_maps(b);
+}
+
+// writes one line per backtrace, like `main;foo;bar 42`, which can be
+// turned into a flame graph by tools like flamegraph.pl and speedscope
+static void DumpFolded(struct ProfBuffer *b, struct Sample *slots) {
+  int symbol;
+  uintptr_t pc;
+  const char *name;
+  struct SymbolTable *st;
+  st = GetSymbolTable();
+  for (size_t i = 0; i < SLOTS; ++i) {
+    if (!IsRecorded(&slots[i]))
+      continue;
+    for (unsigned j = slots[i].depth; j--;) {
+      // return addresses point past the call, so back up one byte to
+      // attribute them to the calling function, except for the pc
+      pc = slots[i].frames[j] - !!j;
+      if (st && (symbol = __get_symbol(st, pc)) != -1 &&
+          (name = __get_symbol_name(st, symbol))) {
+        __profbuf_append(b, "%s%s", name, j ? ";" : "");
+      } else {
+        __profbuf_append(b, "%#lx%s", pc, j ? ";" : "");
+      }
+    }
+    __profbuf_append(
+        b, " %lu\n",
+        atomic_load_explicit(&slots[i].count, memory_order_relaxed));
+  }
+}
+
+static int Dump(int fd, struct Sample *slots) {
+  int e = errno;
+  struct ProfBuffer b = {fd};
+  if (g_profile.flags & COSMO_PROFILE_FOLDED) {
+    DumpFolded(&b, slots);
+  } else {
+    DumpPprof(&b, slots);
+  }
+  __profbuf_flush(&b);
+  errno = e;
+  return 0;
+}
+
+/**
+ * Writes cpu profile collected so far to file descriptor.
+ *
+ * The format is whatever was chosen by cosmo_profile_start(). This
+ * must not be called concurrently with cosmo_profile_stop().
+ *
+ * @return 0 on success, or -1 w/ errno
+ * @raise EINVAL if profiler isn't running
+ */
+int cosmo_profile_dump(int fd) {
+  struct Sample *slots;
+  if (!(slots = atomic_load(&g_profile.slots)))
+    return einval();
+  return Dump(fd, slots);
+}
+
+/**
+ * Starts sampling cpu profiler.
+ *
+ * This arms `ITIMER_PROF` so that `SIGPROF` gets raised `hz` times per
+ * second of cpu time consumed by the process. Each time, the signal
+ * handler records a backtrace of the interrupted thread, by walking
+ * its frame pointers. Identical backtraces are counted together, and
+ * up to 8192 distinct ones are kept, after which further samples get
+ * dropped. When cosmo_profile_stop() is called, the profile is written
+ * to `path`, using the legacy cpu profile format that `pprof` accepts,
+ * e.g. `pprof --text o//prog.dbg prog.prof`. If `flags` has
+ * `COSMO_PROFILE_FOLDED` then folded stacks are written instead, e.g.
+ *
+ *     main;RunServer;HandleRequest;memcpy 42
+ *
+ * which can be turned into a flame graph using `flamegraph.pl`. This
+ * format is symbolized using GetSymbolTable(), so it's self contained.
+ *
+ * The profiler is also started at startup if the `COSMO_PROFILE` env
+ * var is set to a path, in which case the profile is written on exit.
+ * The sampling rate is taken from `COSMO_PROFILE_HZ`, and paths ending
+ * with `.folded` select that format. That only happens in programs that
+ * link this function, which can be forced using:
+ *
+ *     __static_yoink("cosmo_profile_start");
+ *
+ * The program must be built with frame pointers, which is the default
+ * with cosmocc. It's important to note that `SIGPROF` can interrupt
+ * system calls like nanosleep(), that fail with `EINTR` even when the
+ * signal handler has `SA_RESTART`. Windows has no cpu time alarm, so
+ * samples are taken there at the given rate of wall time instead.
+ *
+ * @param hz is number of samples per second, e.g. 100
+ * @param flags may have `COSMO_PROFILE_FOLDED`
+ * @param path is where cosmo_profile_stop() writes profile, or null
+ * @return 0 on success, or -1 w/ errno
+ * @raise EINVAL if `hz` is zero or more than one million
+ * @raise ENAMETOOLONG if `path` is too long
+ * @raise EBUSY if profiler is already running
+ * @raise ENOMEM if sample table couldn't be allocated
+ */
+int cosmo_profile_start(unsigned hz, int flags, const char *path) {
+  struct itimerval it;
+  struct Sample *slots;
+  if (!hz || hz > 1000000 || (flags & ~COSMO_PROFILE_FOLDED))
+    return einval();
+  if (path && strlen(path) >= sizeof(g_profile.path))
+    return enametoolong();
+  if (atomic_load(&g_profile.slots))
+    return ebusy();
+  if ((slots = mmap(0, SLOTS * sizeof(struct Sample), PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)
+    return -1;
+  if (path) {
+    strcpy(g_profile.path, path);
+  } else {
+    *g_profile.path = 0;
+  }
+  g_profile.hz = hz;
+  g_profile.flags = flags;
+  g_profile.pid = getpid();
+  atomic_store(&g_profile.dropped, 0);
+  atomic_store(&g_profile.slots, slots);
+  // the handler is never uninstalled, since a pending signal would kill
+  // the process if the default disposition got restored when stopping
+  sigaction(SIGPROF,
+            &(struct sigaction){.sa_sigaction = OnSigprof,
+                                .sa_flags = SA_SIGINFO | SA_RESTART},
+            0);
+  it.it_interval = (struct timeval){0, 1000000 / hz};
+  it.it_value = it.it_interval;
+  if (setitimer(ITIMER_PROF, &it, 0)) {
+    atomic_store(&g_profile.slots, 0);
+    munmap(slots, SLOTS * sizeof(struct Sample));
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * Stops sampling cpu profiler.
+ *
+ * This disarms the timer, and writes the profile to the path that was
+ * passed to cosmo_profile_start(), if any. Profiling may be started
+ * again afterwards.
+ *
+ * @return 0 on success, or -1 w/ errno
+ * @raise EINVAL if profiler isn't running
+ */
+int cosmo_profile_stop(void) {
+  int fd, rc = 0;
+  struct Sample *slots;
+  if (!atomic_load(&g_profile.slots))
+    return einval();
+  setitimer(ITIMER_PROF, &(struct itimerval){0}, 0);
+  if (!(slots = atomic_exchange(&g_profile.slots, 0)))
+    return einval();
+  // wait for signal handlers on other threads to let go of the table
+  while (atomic_load(&g_profile.inflight))
+    sched_yield();
+  if (*g_profile.path) {
+    if ((fd = open(g_profile.path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                   0644)) != -1) {
+      Dump(fd, slots);
+      rc = close(fd);
+    } else {
+      rc = -1;
+    }
+  }
+  munmap(slots, SLOTS * sizeof(struct Sample));
+  return rc;
+}
+
+static void cosmo_profile_atexit(void) {
+  // forked children inherit the table but not the timer, so they'd
+  // clobber the parent's profile with a copy of its earlier samples
+  if (getpid() == g_profile.pid)
+    cosmo_profile_stop();
+}
+
+__attribute__((__constructor__(90))) static void cosmo_profile_init(void) {
+  int flags = 0;
+  const char *path, *hz;
+  if (!(path = getenv("COSMO_PROFILE")) || !*path)
+    return;
+  if (endswith(path, ".folded"))
+    flags |= COSMO_PROFILE_FOLDED;
+  hz = getenv("COSMO_PROFILE_HZ");
+  if (!cosmo_profile_start(hz ? atoi(hz) : 100, flags, path))
+    atexit(cosmo_profile_atexit);
+}
@@ -119,6 +119,16 @@
 #define math_errhandling (MATH_ERRNO | MATH_ERREXCEPT)
 #endif
 
+/* lets gcc -ffast-math vectorize loops with libc/tinymath/mvec.c */
+#if defined(__FAST_MATH__) && defined(__GNUC__) && __GNUC__ >= 9 &&      \
+    !defined(__llvm__) && !defined(__chibicc__) &&                       \
+    (defined(__x86_64__) ||                                              \
+     (defined(__aarch64__) && !defined(__ARM_FEATURE_SVE)))
+#define __math_simd __attribute__((__simd__("notinbranch")))
+#else
+#define __math_simd
+#endif
+
 #ifdef __FP_FAST_FMA
 #define FP_FAST_FMA 1
 #endif
@@ -173,12 +183,12 @@ double atanh(double) libcesque;
 double cbrt(double) libcesque;
 double ceil(double) libcesque;
 double copysign(double, double) libcesque;
-double cos(double) libcesque;
+double cos(double) libcesque __math_simd;
 double cosh(double) libcesque;
 double drem(double, double) libcesque;
 double erf(double) libcesque;
 double erfc(double) libcesque;
-double exp(double) libcesque;
+double exp(double) libcesque __math_simd;
 double exp10(double) libcesque;
 double exp2(double) libcesque;
 double expm1(double) libcesque;
@@ -191,7 +201,7 @@ double fmin(double, double) libcesque;
 double fmod(double, double) libcesque;
 double hypot(double, double) libcesque;
 double ldexp(double, int) libcesque;
-double log(double) libcesque;
+double log(double) libcesque __math_simd;
 double log10(double) libcesque;
 double log1p(double) libcesque;
 double log2(double) libcesque;
@@ -209,7 +219,7 @@ double scalb(double, double) libcesque;
 double scalbln(double, long int) libcesque;
 double scalbn(double, int) libcesque;
 double significand(double) libcesque;
-double sin(double) libcesque;
+double sin(double) libcesque __math_simd;
 double sinh(double) libcesque;
 double sqrt(double) libcesque;
 double tan(double) libcesque;
@@ -230,14 +240,14 @@ float atanhf(float) libcesque;
 float cbrtf(float) libcesque;
 float ceilf(float) libcesque;
 float copysignf(float, float) libcesque;
-float cosf(float) libcesque;
+float cosf(float) libcesque __math_simd;
 float coshf(float) libcesque;
 float dremf(float, float) libcesque;
 float erfcf(float) libcesque;
 float erff(float) libcesque;
 float exp10f(float) libcesque;
 float exp2f(float) libcesque;
-float expf(float) libcesque;
+float expf(float) libcesque __math_simd;
 float expm1f(float) libcesque;
 float fabsf(float) libcesque;
 float fdimf(float, float) libcesque;
@@ -254,12 +264,12 @@ float log10f(float) libcesque;
 float log1pf(float) libcesque;
 float log2f(float) libcesque;
 float logbf(float) libcesque;
-float logf(float) libcesque;
+float logf(float) libcesque __math_simd;
 float nearbyintf(float) libcesque;
 float nextafterf(float, float) libcesque;
 float nexttowardf(float, long double) libcesque;
 float pow10f(float) libcesque;
-float powf(float, float) libcesque;
+float powf(float, float) libcesque __math_simd;
 float powif(float, int) libcesque;
 float remainderf(float, float) libcesque;
 float rintf(float) libcesque;
@@ -268,7 +278,7 @@ float scalbf(float, float) libcesque;
 float scalblnf(float, long int) libcesque;
 float scalbnf(float, int) libcesque;
 float significandf(float) libcesque;
-float sinf(float) libcesque;
+float sinf(float) libcesque __math_simd;
 float sinhf(float) libcesque;
 float sqrtf(float) libcesque;
 float tanf(float) libcesque;
@@ -20,9 +20,19 @@ int mergesort_r(void *, size_t, size_t,
                 int (*)(const void *, const void *, void *), void *);
 
 #ifdef _COSMO_SOURCE
+struct SortPair {
+  uint64_t key;
+  uint64_t val;
+};
+
 void djbsort(int32_t *, size_t) libcesque;
 int radix_sort_int32(int32_t *, size_t) libcesque;
 int radix_sort_int64(int64_t *, size_t) libcesque;
+int radix_sort_uint32(uint32_t *, size_t) libcesque;
+int radix_sort_uint64(uint64_t *, size_t) libcesque;
+int radix_sort_float(float *, size_t) libcesque;
+int radix_sort_double(double *, size_t) libcesque;
+int radix_sort_pairs(struct SortPair *, size_t) libcesque;
 double levenshtein(const char *, const char *) libcesque;
 #endif
 
@@ -0,0 +1,263 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/cosmo.h"
+#include "libc/dce.h"
+#include "libc/errno.h"
+#include "libc/macros.h"
+#include "libc/mem/mem.h"
+#include "libc/runtime/runtime.h"
+#include "libc/sysv/consts/map.h"
+#include "libc/sysv/consts/prot.h"
+#include "libc/thread/thread.h"
+
+#define DEFAULT_CHUNK (65536 - 64)
+
+#define MPOL_PREFERRED 1
+#define MAX_NUMNODES   1024
+
+long sys_mbind(void *, size_t, int, const unsigned long *, unsigned long,
+               unsigned);
+
+struct CosmoArenaChunk {
+  struct CosmoArenaChunk *prev;
+  size_t size;
+  size_t used;
+  _Alignas(16) char data[];
+};
+
+struct CosmoArena {
+  bool threadsafe;
+  bool nodelocal;
+  unsigned node;  // numa node of thread that created arena
+  size_t chunksize;
+  struct CosmoArenaChunk *top;
+  struct CosmoArenaChunk *spare;
+  pthread_mutex_t lock;
+};
+
+static void cosmo_arena_lock(struct CosmoArena *a) {
+  if (a->threadsafe)
+    pthread_mutex_lock(&a->lock);
+}
+
+static void cosmo_arena_unlock(struct CosmoArena *a) {
+  if (a->threadsafe)
+    pthread_mutex_unlock(&a->lock);
+}
+
+// maps chunk memory that prefers to live on the arena owner's numa node
+// which matters if other threads end up touching the pages first
+static struct CosmoArenaChunk *cosmo_arena_map(struct CosmoArena *a,
+                                               size_t n) {
+  void *p;
+  if ((p = mmap(0, n, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1,
+                0)) == MAP_FAILED)
+    return 0;
+  if (IsLinux() && a->node < MAX_NUMNODES) {
+    int e = errno;
+    unsigned long mask[MAX_NUMNODES / 64] = {0};
+    mask[a->node / 64] = 1ul << (a->node % 64);
+    sys_mbind(p, n, MPOL_PREFERRED, mask, MAX_NUMNODES + 1, 0);
+    errno = e;
+  }
+  return p;
+}
+
+static void cosmo_arena_release(struct CosmoArena *a,
+                                struct CosmoArenaChunk *c) {
+  if (!c)
+    return;
+  if (a->nodelocal) {
+    munmap(c, sizeof(struct CosmoArenaChunk) + c->size);
+  } else {
+    free(c);
+  }
+}
+
+static void cosmo_arena_pop(struct CosmoArena *a) {
+  struct CosmoArenaChunk *c = a->top;
+  a->top = c->prev;
+  if (!a->spare && c->size == a->chunksize) {
+    a->spare = c;  // keep one chunk around to avoid malloc churn
+  } else {
+    cosmo_arena_release(a, c);
+  }
+}
+
+static struct CosmoArenaChunk *cosmo_arena_grow(struct CosmoArena *a,
+                                                size_t need) {
+  struct CosmoArenaChunk *c;
+  if (a->spare && a->spare->size >= need) {
+    c = a->spare;
+    a->spare = 0;
+  } else {
+    size_t size = MAX(need, a->chunksize);
+    if (size > (size_t)-1 - sizeof(struct CosmoArenaChunk)) {
+      errno = ENOMEM;
+      return 0;
+    }
+    if (a->nodelocal) {
+      c = cosmo_arena_map(a, sizeof(struct CosmoArenaChunk) + size);
+    } else {
+      c = malloc(sizeof(struct CosmoArenaChunk) + size);
+    }
+    if (!c)
+      return 0;
+    c->size = size;
+  }
+  c->used = 0;
+  c->prev = a->top;
+  a->top = c;
+  return c;
+}
+
+/**
+ * Creates new arena allocator.
+ *
+ * Arenas hand out memory by bumping a pointer within chunks that are
+ * obtained from malloc(). Individual allocations are never freed and
+ * are instead released together using cosmo_arena_reset(). This is a
+ * good fit for things like request handlers, which create many small
+ * objects that all share the same lifetime.
+ *
+ * If `COSMO_ARENA_NODELOCAL` is passed, then chunks are mapped directly
+ * rather than obtained from malloc(), and on Linux they're asked to be
+ * placed on the NUMA node of the CPU that created the arena. A thread
+ * that's been pinned to a node using cosmo_topology() may use this to
+ * ensure its memory stays local. Elsewhere the system's first touch
+ * policy is relied upon.
+ *
+ * @param chunksize is bytes per chunk, or 0 for a default of ~64kb
+ * @param flags may have `COSMO_ARENA_THREADSAFE` so it can be shared
+ *     and `COSMO_ARENA_NODELOCAL` to prefer the creator's numa node
+ * @return new arena, or null w/ errno
+ * @raise EINVAL if `flags` has unknown bits
+ */
+struct CosmoArena *cosmo_arena_new(size_t chunksize, int flags) {
+  struct CosmoArena *a;
+  if (flags & ~(COSMO_ARENA_THREADSAFE | COSMO_ARENA_NODELOCAL)) {
+    errno = EINVAL;
+    return 0;
+  }
+  if (!(a = calloc(1, sizeof(struct CosmoArena))))
+    return 0;
+  a->threadsafe = !!(flags & COSMO_ARENA_THREADSAFE);
+  if ((a->nodelocal = !!(flags & COSMO_ARENA_NODELOCAL))) {
+    int e = errno;
+    if (getcpu(0, &a->node))
+      a->node = 0;
+    errno = e;
+  }
+  a->chunksize = chunksize ? ROUNDUP(chunksize, 16) : DEFAULT_CHUNK;
+  pthread_mutex_init(&a->lock, 0);
+  return a;
+}
+
+/**
+ * Destroys arena and all the memory it handed out.
+ *
+ * @param a may be null in which case this is a no-op
+ */
+void cosmo_arena_free(struct CosmoArena *a) {
+  if (a) {
+    while (a->top)
+      cosmo_arena_pop(a);
+    cosmo_arena_release(a, a->spare);
+    pthread_mutex_destroy(&a->lock);
+    free(a);
+  }
+}
+
+/**
+ * Allocates memory from arena.
+ *
+ * The returned memory is uninitialized. It remains valid until the
+ * arena is reset to a mark that was taken before this call, or until
+ * the arena is destroyed. Requests bigger than the chunk size get a
+ * dedicated chunk.
+ *
+ * @param n is number of bytes needed
+ * @param align is power of two alignment, or 0 for 16
+ * @return pointer to memory, or null w/ errno
+ * @raise ENOMEM if we ran out of memory
+ * @raise EINVAL if `align` isn't a power of two
+ */
+void *cosmo_arena_alloc(struct CosmoArena *a, size_t n, size_t align) {
+  char *p = 0;
+  uintptr_t b, e;
+  struct CosmoArenaChunk *c;
+  if (!align)
+    align = 16;
+  if (align & (align - 1)) {
+    errno = EINVAL;
+    return 0;
+  }
+  cosmo_arena_lock(a);
+  if ((c = a->top)) {
+    b = ROUNDUP((uintptr_t)c->data + c->used, align);
+    e = b + n;
+    if (b >= (uintptr_t)c->data && e >= b &&
+        e <= (uintptr_t)c->data + c->size) {
+      c->used = e - (uintptr_t)c->data;
+      p = (char *)b;
+    }
+  }
+  if (!p) {
+    if (n + (align - 1) < n) {
+      errno = ENOMEM;
+    } else if ((c = cosmo_arena_grow(a, n + (align - 1)))) {
+      b = ROUNDUP((uintptr_t)c->data, align);
+      c->used = b + n - (uintptr_t)c->data;
+      p = (char *)b;
+    }
+  }
+  cosmo_arena_unlock(a);
+  return p;
+}
+
+/**
+ * Returns checkpoint which may be passed to cosmo_arena_reset().
+ */
+void *cosmo_arena_mark(struct CosmoArena *a) {
+  void *m = 0;
+  cosmo_arena_lock(a);
+  if (a->top)
+    m = a->top->data + a->top->used;
+  cosmo_arena_unlock(a);
+  return m;
+}
+
+/**
+ * Releases all memory allocated since checkpoint.
+ *
+ * @param mark is from cosmo_arena_mark(), or null to release everything
+ */
+void cosmo_arena_reset(struct CosmoArena *a, void *mark) {
+  struct CosmoArenaChunk *c;
+  cosmo_arena_lock(a);
+  while ((c = a->top)) {
+    if (mark && c->data <= (char *)mark && (char *)mark <= c->data + c->size) {
+      c->used = (char *)mark - c->data;
+      break;
+    }
+    cosmo_arena_pop(a);
+  }
+  cosmo_arena_unlock(a);
+}
@@ -0,0 +1,60 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/intrin/kprintf.h"
+#include "libc/mem/mem.h"
+#include "third_party/dlmalloc/dlmalloc.h"
+
+/**
+ * Prints allocator statistics to standard error.
+ *
+ * One block is printed for each heap shard that's in use, showing how
+ * many bytes it obtained from the system, how much of that is in use,
+ * the number of free chunks and nonempty bins, and how many times its
+ * lock was contended. Totals are printed at the end. Chunks sitting in
+ * the thread caches of other threads are counted as in use.
+ */
+void malloc_stats(void) {
+  size_t i, n;
+  struct mallinfo mi;
+  struct MallocShardStats st[32];
+  size_t footprint = 0, inuse = 0, contended = 0;
+  n = dlmalloc_shard_stats(st, sizeof(st) / sizeof(*st));
+  for (i = 0; i < n; ++i) {
+    kprintf("Arena %zu:\n"
+            "system bytes     = %'12zu\n"
+            "in use bytes     = %'12zu\n"
+            "free chunks      = %'12zu\n"
+            "small bins       = %'12zu\n"
+            "tree bins        = %'12zu\n"
+            "lock contentions = %'12zu\n",
+            i, st[i].footprint, st[i].inuse, st[i].chunks, st[i].smallbins,
+            st[i].treebins, st[i].contended);
+    footprint += st[i].footprint;
+    inuse += st[i].inuse;
+    contended += st[i].contended;
+  }
+  mi = mallinfo();
+  kprintf("Total:\n"
+          "system bytes     = %'12zu\n"
+          "in use bytes     = %'12zu\n"
+          "lock contentions = %'12zu\n"
+          "rseq free chunks = %'12zu\n"
+          "rseq free bytes  = %'12zu\n",
+          footprint, inuse, contended, mi.smblks, mi.fsmblks);
+}
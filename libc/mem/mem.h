@@ -5,6 +5,9 @@
 #define M_GRANULARITY    (-2)
 #define M_MMAP_THRESHOLD (-3)
 #define M_RSEQ_MAX       (-4)
+#define M_HUGEPAGES      (-5)
+#define M_DECAY_MS       (-6)
+#define M_TCACHE         (-7)
 
 COSMOPOLITAN_C_START_
 /*───────────────────────────────────────────────────────────────────────────│─╗
@@ -45,6 +48,7 @@ struct mallinfo {
 };
 
 struct mallinfo mallinfo(void) libcesque;
+void malloc_stats(void) libcesque;
 
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_LIBC_MEM_MEM_H_ */
@@ -0,0 +1,258 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/atomic.h"
+#include "libc/cosmo.h"
+#include "libc/errno.h"
+#include "libc/intrin/atomic.h"
+#include "libc/intrin/weaken.h"
+#include "libc/limits.h"
+#include "libc/macros.h"
+#include "libc/mem/mem.h"
+#include "libc/str/str.h"
+#include "libc/thread/thread.h"
+
+#define POOL_BATCH  32     // objects moved between shards at once
+#define POOL_SLAB   65536  // preferred bytes per slab
+#define POOL_PTR    0x0000ffffffffffffull
+#define POOL_TAGINC 0x0001000000000000ull
+
+struct CosmoPoolObject {
+  struct CosmoPoolObject *next;  // next object in same batch
+  struct CosmoPoolObject *link;  // next batch on global stack
+};
+
+struct CosmoPoolSlab {
+  struct CosmoPoolSlab *next;
+};
+
+struct CosmoPoolShard {
+  _Alignas(64) atomic_uint lock;
+  unsigned count;
+  struct CosmoPoolObject *cur;
+  struct CosmoPoolObject *full;
+};
+
+struct CosmoPool {
+  size_t size;
+  size_t align;
+  size_t perslab;
+  bool trackleaks;
+  pthread_mutex_t lock;
+  struct CosmoPoolSlab *slabs;
+  char *bump;
+  char *end;
+  _Alignas(64) atomic_ulong batches;
+  struct CosmoPoolShard shards[COSMO_SHARDS];
+};
+
+static void cosmo_pool_lock(struct CosmoPoolShard *s) {
+  while (atomic_exchange_explicit(&s->lock, 1, memory_order_acquire))
+    while (atomic_load_explicit(&s->lock, memory_order_relaxed))
+      pthread_pause_np();
+}
+
+static void cosmo_pool_unlock(struct CosmoPoolShard *s) {
+  atomic_store_explicit(&s->lock, 0, memory_order_release);
+}
+
+// pushes full batch onto lock-free stack, where upper 16 bits of word
+// are a generation counter that prevents aba since the address space
+// of userspace on x86-64 and aarch64 only needs the lower 48 bits
+static void cosmo_pool_push(struct CosmoPool *p, struct CosmoPoolObject *b) {
+  unsigned long old, neu;
+  old = atomic_load_explicit(&p->batches, memory_order_relaxed);
+  do {
+    b->link = (struct CosmoPoolObject *)(old & POOL_PTR);
+    neu = (uintptr_t)b | ((old + POOL_TAGINC) & ~POOL_PTR);
+  } while (!atomic_compare_exchange_weak_explicit(
+      &p->batches, &old, neu, memory_order_release, memory_order_relaxed));
+}
+
+// pops full batch from lock-free stack. reading b->link is safe even
+// if another thread takes `b` first, because slabs are never unmapped
+// while the pool exists, and the generation tag will make us retry
+static struct CosmoPoolObject *cosmo_pool_pop(struct CosmoPool *p) {
+  unsigned long old, neu;
+  struct CosmoPoolObject *b;
+  old = atomic_load_explicit(&p->batches, memory_order_acquire);
+  do {
+    if (!(b = (struct CosmoPoolObject *)(old & POOL_PTR)))
+      return 0;
+    neu = (uintptr_t)b->link | ((old + POOL_TAGINC) & ~POOL_PTR);
+  } while (!atomic_compare_exchange_weak_explicit(
+      &p->batches, &old, neu, memory_order_acquire, memory_order_acquire));
+  return b;
+}
+
+// carves a fresh batch of objects out of the current slab
+static struct CosmoPoolObject *cosmo_pool_carve(struct CosmoPool *p) {
+  struct CosmoPoolSlab *slab;
+  struct CosmoPoolObject *b = 0, *o;
+  pthread_mutex_lock(&p->lock);
+  if (p->bump == p->end) {
+    if ((slab = malloc(sizeof(*slab) + p->align + p->size * p->perslab))) {
+      slab->next = p->slabs;
+      p->slabs = slab;
+      p->bump = (char *)ROUNDUP((uintptr_t)(slab + 1), p->align);
+      p->end = p->bump + p->size * p->perslab;
+    }
+  }
+  if (p->bump < p->end) {
+    for (int i = 0; i < POOL_BATCH; ++i) {
+      o = (struct CosmoPoolObject *)(p->end -= p->size);
+      o->next = b;
+      b = o;
+    }
+  }
+  pthread_mutex_unlock(&p->lock);
+  return b;
+}
+
+/**
+ * Creates new pool of fixed-size objects.
+ *
+ * Pools are the most efficient way to allocate many objects of the same
+ * size. Objects are carved out of large slabs that are obtained using
+ * malloc(), and freed objects are cached by cpu shard, so threads that
+ * allocate and free on the same core never share a cache line. When a
+ * shard accumulates too many free objects, they're transferred as one
+ * batch onto a lock-free stack, where other shards may claim them.
+ *
+ * Slabs are only returned to malloc() once the pool is destroyed, which
+ * means pools never shrink. Since slabs come from malloc(), leak checks
+ * like CheckForMemoryLeaks() will report pools that were never freed.
+ * If `flags` has `COSMO_POOL_TRACKLEAKS` and cosmo_leak_track() is
+ * linked, then each object is also tracked by the leak detector and it
+ * can tell you where an object that wasn't put back came from.
+ *
+ * @param size is number of bytes in each object
+ * @param align is power of two alignment, or 0 for 16
+ * @param flags may have `COSMO_POOL_TRACKLEAKS`
+ * @return new pool, or null w/ errno
+ * @raise EINVAL if `align` isn't a power of two
+ * @raise EINVAL if `flags` has unknown bits
+ * @raise ENOMEM if `size` is too large
+ */
+struct CosmoPool *cosmo_pool_new(size_t size, size_t align, int flags) {
+  struct CosmoPool *p;
+  if (!align)
+    align = 16;
+  if ((align & (align - 1)) || (flags & ~COSMO_POOL_TRACKLEAKS)) {
+    errno = EINVAL;
+    return 0;
+  }
+  if (size > (size_t)INT_MAX || align > 65536) {
+    errno = ENOMEM;
+    return 0;
+  }
+  if (!(p = memalign(_Alignof(struct CosmoPool), sizeof(struct CosmoPool))))
+    return 0;
+  bzero(p, sizeof(*p));
+  p->align = MAX(align, _Alignof(struct CosmoPoolObject));
+  p->size = ROUNDUP(MAX(size, sizeof(struct CosmoPoolObject)), p->align);
+  p->perslab = MAX(1, POOL_SLAB / (p->size * POOL_BATCH)) * POOL_BATCH;
+  p->trackleaks = !!(flags & COSMO_POOL_TRACKLEAKS);
+  pthread_mutex_init(&p->lock, 0);
+  return p;
+}
+
+/**
+ * Destroys pool and all the objects it handed out.
+ *
+ * @param p may be null in which case this is a no-op
+ */
+void cosmo_pool_free(struct CosmoPool *p) {
+  struct CosmoPoolSlab *slab;
+  if (p) {
+    while ((slab = p->slabs)) {
+      p->slabs = slab->next;
+      free(slab);
+    }
+    pthread_mutex_destroy(&p->lock);
+    free(p);
+  }
+}
+
+/**
+ * Allocates object from pool.
+ *
+ * The returned memory is uninitialized.
+ *
+ * @return object, or null w/ errno
+ * @raise ENOMEM if we ran out of memory
+ */
+void *cosmo_pool_get(struct CosmoPool *p) {
+  struct CosmoPoolShard *s;
+  struct CosmoPoolObject *o, *b = 0;
+  s = &p->shards[cosmo_shard()];
+  cosmo_pool_lock(s);
+  if (!s->cur) {
+    if (s->full) {
+      b = s->full;
+      s->full = 0;
+    } else if (!(b = cosmo_pool_pop(p))) {
+      cosmo_pool_unlock(s);
+      if (!(b = cosmo_pool_carve(p)))
+        return 0;
+      cosmo_pool_lock(s);
+      if (s->cur) {
+        cosmo_pool_push(p, b);
+        b = 0;
+      }
+    }
+    if (b) {
+      s->cur = b;
+      s->count = POOL_BATCH;
+    }
+  }
+  o = s->cur;
+  s->cur = o->next;
+  --s->count;
+  cosmo_pool_unlock(s);
+  if (p->trackleaks && _weaken(cosmo_leak_track))
+    _weaken(cosmo_leak_track)(o);
+  return o;
+}
+
+/**
+ * Returns object to pool.
+ *
+ * @param obj was returned by cosmo_pool_get() or may be null
+ */
+void cosmo_pool_put(struct CosmoPool *p, void *obj) {
+  struct CosmoPoolShard *s;
+  struct CosmoPoolObject *o;
+  if (!(o = obj))
+    return;
+  if (p->trackleaks && _weaken(cosmo_leak_untrack))
+    _weaken(cosmo_leak_untrack)(o);
+  s = &p->shards[cosmo_shard()];
+  cosmo_pool_lock(s);
+  if (s->count == POOL_BATCH) {
+    if (s->full)
+      cosmo_pool_push(p, s->full);
+    s->full = s->cur;
+    s->cur = 0;
+    s->count = 0;
+  }
+  o->next = s->cur;
+  s->cur = o;
+  ++s->count;
+  cosmo_pool_unlock(s);
+}
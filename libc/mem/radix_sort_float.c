@@ -0,0 +1,40 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/mem/alg.h"
+
+typedef uint32_t mayalias bits_t;
+
+/**
+ * Sorts array of single-precision floating point numbers.
+ *
+ * This has the same NaN and signed zero ordering as radix_sort_double().
+ *
+ * @return 0 on success, or -1 w/ errno if memory couldn't be allocated
+ */
+int radix_sort_float(float *A, size_t n) {
+  int rc;
+  size_t i;
+  bits_t *B = (bits_t *)A;
+  for (i = 0; i < n; ++i)
+    B[i] ^= -(B[i] >> 31) | 0x80000000;
+  rc = radix_sort_uint32((uint32_t *)B, n);
+  for (i = 0; i < n; ++i)
+    B[i] ^= ((B[i] >> 31) - 1) | 0x80000000;
+  return rc;
+}
@@ -0,0 +1,76 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/mem/alg.h"
+#include "libc/mem/mem.h"
+#include "libc/str/str.h"
+
+/**
+ * Sorts array of unsigned 64-bit integers.
+ *
+ * This is a least significant digit radix sort with 8-bit digits. All
+ * digit histograms are gathered in a single pass, and passes where all
+ * elements share the same digit are skipped, so arrays of small values
+ * only pay for the digits that actually vary.
+ *
+ * @return 0 on success, or -1 w/ errno if memory couldn't be allocated
+ */
+int radix_sort_uint64(uint64_t *A, size_t n) {
+  size_t i, d, t, sum;
+  size_t (*h)[256];
+  uint64_t *T, *src, *dst, *tmp, x;
+  if (n < 64) {
+    for (i = 1; i < n; ++i) {
+      x = A[i];
+      for (t = i; t && A[t - 1] > x; --t)
+        A[t] = A[t - 1];
+      A[t] = x;
+    }
+    return 0;
+  }
+  if (!(h = calloc(8, sizeof(*h))))
+    return -1;
+  if (!(T = malloc(n * sizeof(uint64_t)))) {
+    free(h);
+    return -1;
+  }
+  for (i = 0; i < n; ++i)
+    for (d = 0; d < 8; ++d)
+      h[d][A[i] >> (d * 8) & 255]++;
+  src = A;
+  dst = T;
+  for (d = 0; d < 8; ++d) {
+    if (h[d][src[0] >> (d * 8) & 255] == n)
+      continue;
+    for (sum = i = 0; i < 256; ++i) {
+      t = h[d][i];
+      h[d][i] = sum;
+      sum += t;
+    }
+    for (i = 0; i < n; ++i)
+      dst[h[d][src[i] >> (d * 8) & 255]++] = src[i];
+    tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+  if (src != A)
+    memcpy(A, src, n * sizeof(uint64_t));
+  free(T);
+  free(h);
+  return 0;
+}
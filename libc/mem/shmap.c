@@ -0,0 +1,241 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/atomic.h"
+#include "libc/cosmo.h"
+#include "libc/errno.h"
+#include "libc/intrin/atomic.h"
+#include "libc/macros.h"
+#include "libc/str/str.h"
+#include "libc/thread/thread.h"
+
+#define SHMAP_WAYS 8  // slots per group
+
+struct CosmoShmapGroup {
+  _Alignas(64) cosmo_futex_t lock;
+  uint32_t clock;  // bumped on each access, for lru eviction
+};
+
+struct CosmoShmapSlot {
+  uint64_t hash;    // zero if slot is empty
+  uint32_t keylen;  // bytes of key at start of data
+  uint32_t vallen;  // bytes of value after key
+  uint32_t stamp;   // group clock as of last access
+  char data[];
+};
+
+struct CosmoShmap {
+  _Alignas(64) size_t mask;  // groups minus one
+  size_t payload;             // max key plus value bytes
+  size_t stride;              // bytes per slot
+  struct CosmoShmapGroup group[];
+};
+
+// see "take 3" algorithm in "futexes are tricky" by ulrich drepper
+static void cosmo_shmap_lock(cosmo_futex_t *f) {
+  int val = 0;
+  if (atomic_compare_exchange_strong_explicit(f, &val, 1, memory_order_acquire,
+                                              memory_order_relaxed))
+    return;
+  if (val == 1)
+    val = atomic_exchange_explicit(f, 2, memory_order_acquire);
+  while (val) {
+    cosmo_futex_wait(f, 2, PTHREAD_PROCESS_SHARED, 0, 0);
+    val = atomic_exchange_explicit(f, 2, memory_order_acquire);
+  }
+}
+
+static void cosmo_shmap_unlock(cosmo_futex_t *f) {
+  if (atomic_fetch_sub_explicit(f, 1, memory_order_release) == 2) {
+    atomic_store_explicit(f, 0, memory_order_release);
+    cosmo_futex_wake(f, 1, PTHREAD_PROCESS_SHARED);
+  }
+}
+
+static size_t cosmo_shmap_groups(size_t entries) {
+  size_t n;
+  for (n = 1; n * SHMAP_WAYS < entries; n <<= 1) {
+  }
+  return n;
+}
+
+static size_t cosmo_shmap_stride(size_t payload) {
+  return ROUNDUP(sizeof(struct CosmoShmapSlot) + payload, 8);
+}
+
+static uint64_t cosmo_shmap_hash(const void *key, size_t keylen) {
+  uint64_t h;
+  if (!(h = cosmo_hash(key, keylen)))
+    h = 1;
+  return h;
+}
+
+static struct CosmoShmapSlot *cosmo_shmap_slot(struct CosmoShmap *m, size_t g,
+                                               int i) {
+  char *p = (char *)(m->group + m->mask + 1);
+  return (struct CosmoShmapSlot *)(p + (g * SHMAP_WAYS + i) * m->stride);
+}
+
+static struct CosmoShmapSlot *cosmo_shmap_find(struct CosmoShmap *m, size_t g,
+                                               uint64_t h, const void *key,
+                                               size_t keylen) {
+  for (int i = 0; i < SHMAP_WAYS; ++i) {
+    struct CosmoShmapSlot *s = cosmo_shmap_slot(m, g, i);
+    if (s->hash == h && s->keylen == keylen && !memcmp(s->data, key, keylen))
+      return s;
+  }
+  return 0;
+}
+
+/**
+ * Returns number of bytes needed to hold shared hash table.
+ *
+ * @param entries is desired capacity, which gets rounded up
+ * @param payload is max number of key plus value bytes per entry
+ * @see cosmo_shmap_init()
+ */
+size_t cosmo_shmap_size(size_t entries, size_t payload) {
+  size_t n = cosmo_shmap_groups(entries);
+  return sizeof(struct CosmoShmap) + n * sizeof(struct CosmoShmapGroup) +
+         n * SHMAP_WAYS * cosmo_shmap_stride(payload);
+}
+
+/**
+ * Creates hash table that can be shared between processes.
+ *
+ * This is a fixed size, set associative cache of byte string keys and
+ * values. Each key hashes to a group of eight slots that's guarded by
+ * a process shared futex, so workers forked by a server may read and
+ * write the same table concurrently with little contention. When every
+ * slot in a group is in use, storing a new key evicts whichever entry
+ * in that group was least recently accessed. Since eviction may happen
+ * at any time, this is a cache and not a database.
+ *
+ * The structure contains no pointers, so it works fine when mapped at
+ * different addresses. Memory must be allocated by the caller, before
+ * the processes that share it are forked:
+ *
+ *     size_t n = cosmo_shmap_size(10000, 256);
+ *     struct CosmoShmap *m = cosmo_shmap_init(_mapshared(n), 10000, 256);
+ *
+ * If a process dies while holding one of the locks (which are only held
+ * for the duration of a memcpy) then other processes will deadlock when
+ * accessing the same group.
+ *
+ * @param mem is at least `cosmo_shmap_size(entries, payload)` bytes
+ * @param entries is desired capacity, which gets rounded up
+ * @param payload is max number of key plus value bytes per entry
+ * @return `mem` as a hash table, or null w/ errno if `mem` is null
+ */
+struct CosmoShmap *cosmo_shmap_init(void *mem, size_t entries,
+                                    size_t payload) {
+  struct CosmoShmap *m;
+  if (!(m = mem)) {
+    errno = EINVAL;
+    return 0;
+  }
+  bzero(m, cosmo_shmap_size(entries, payload));
+  m->mask = cosmo_shmap_groups(entries) - 1;
+  m->payload = payload;
+  m->stride = cosmo_shmap_stride(payload);
+  return m;
+}
+
+/**
+ * Looks up value in shared hash table.
+ *
+ * If `bufsize` is smaller than the value, then only its first `bufsize`
+ * bytes are copied, and the return value may be used to detect this.
+ *
+ * @param buf receives the value
+ * @return byte length of value, or -1 w/ errno
+ * @raise ENOENT if `key` isn't in table
+ */
+ssize_t cosmo_shmap_get(struct CosmoShmap *m, const void *key, size_t keylen,
+                        void *buf, size_t bufsize) {
+  ssize_t rc;
+  struct CosmoShmapSlot *s;
+  uint64_t h = cosmo_shmap_hash(key, keylen);
+  struct CosmoShmapGroup *g = m->group + (h & m->mask);
+  cosmo_shmap_lock(&g->lock);
+  if ((s = cosmo_shmap_find(m, h & m->mask, h, key, keylen))) {
+    s->stamp = ++g->clock;
+    rc = s->vallen;
+    memcpy(buf, s->data + s->keylen, MIN(bufsize, s->vallen));
+  } else {
+    rc = -1;
+  }
+  cosmo_shmap_unlock(&g->lock);
+  if (rc == -1)
+    errno = ENOENT;
+  return rc;
+}
+
+/**
+ * Inserts or replaces value in shared hash table.
+ *
+ * @return 0 on success, or -1 w/ errno
+ * @raise EMSGSIZE if `keylen + vallen` exceeds table payload size
+ */
+int cosmo_shmap_put(struct CosmoShmap *m, const void *key, size_t keylen,
+                    const void *val, size_t vallen) {
+  struct CosmoShmapSlot *s, *t;
+  if (keylen > m->payload || vallen > m->payload - keylen) {
+    errno = EMSGSIZE;
+    return -1;
+  }
+  uint64_t h = cosmo_shmap_hash(key, keylen);
+  struct CosmoShmapGroup *g = m->group + (h & m->mask);
+  cosmo_shmap_lock(&g->lock);
+  if (!(s = cosmo_shmap_find(m, h & m->mask, h, key, keylen))) {
+    for (int i = 0; i < SHMAP_WAYS; ++i) {
+      t = cosmo_shmap_slot(m, h & m->mask, i);
+      if (!t->hash) {
+        s = t;
+        break;
+      }
+      // unsigned subtract so lru keeps working when clock wraps
+      if (!s || g->clock - t->stamp > g->clock - s->stamp)
+        s = t;
+    }
+    s->hash = h;
+    s->keylen = keylen;
+    memcpy(s->data, key, keylen);
+  }
+  s->vallen = vallen;
+  s->stamp = ++g->clock;
+  memcpy(s->data + keylen, val, vallen);
+  cosmo_shmap_unlock(&g->lock);
+  return 0;
+}
+
+/**
+ * Removes key from shared hash table.
+ *
+ * @return true if `key` was found and removed
+ */
+bool32 cosmo_shmap_del(struct CosmoShmap *m, const void *key, size_t keylen) {
+  struct CosmoShmapSlot *s;
+  uint64_t h = cosmo_shmap_hash(key, keylen);
+  struct CosmoShmapGroup *g = m->group + (h & m->mask);
+  cosmo_shmap_lock(&g->lock);
+  if ((s = cosmo_shmap_find(m, h & m->mask, h, key, keylen)))
+    s->hash = 0;
+  cosmo_shmap_unlock(&g->lock);
+  return !!s;
+}
@@ -4,6 +4,7 @@ COSMOPOLITAN_C_START_
 
 extern long kHalfCache3;
 extern const uint64_t kTens[20];
+extern const char kDigitPairs[200];
 extern const uint32_t kSha256[64];
 extern const uint64_t kSha512[80];
 extern const unsigned char kTensIndex[64];
@@ -3,6 +3,7 @@
 #include "libc/nt/struct/filetime.h"
 #include "libc/nt/struct/iocounters.h"
 #include "libc/nt/struct/memorystatusex.h"
+#include "libc/nt/struct/systemlogicalprocessorinformationex.h"
 #include "libc/nt/thunk/msabi.h"
 COSMOPOLITAN_C_START_
 /*                            ░░░░
@@ -31,6 +32,10 @@ COSMOPOLITAN_C_START_
 ╚────────────────────────────────────────────────────────────────────────────│*/
 
 uint32_t GetMaximumProcessorCount(uint16_t GroupNumber);
+bool32 GetLogicalProcessorInformationEx(
+    int RelationshipType,
+    struct NtSystemLogicalProcessorInformationEx *opt_out_Buffer,
+    uint32_t *in_out_ReturnedLength);
 int GetUserName(char16_t (*buf)[257], uint32_t *in_out_size);
 bool32 GlobalMemoryStatusEx(struct NtMemoryStatusEx *lpBuffer);
 int32_t GetExitCodeProcess(int64_t hProcess, uint32_t *lpExitCode);
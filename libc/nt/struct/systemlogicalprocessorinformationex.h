@@ -0,0 +1,60 @@
+#ifndef COSMOPOLITAN_LIBC_NT_STRUCT_SYSTEMLOGICALPROCESSORINFORMATIONEX_H_
+#define COSMOPOLITAN_LIBC_NT_STRUCT_SYSTEMLOGICALPROCESSORINFORMATIONEX_H_
+COSMOPOLITAN_C_START_
+
+#define kNtRelationProcessorCore    0
+#define kNtRelationNumaNode         1
+#define kNtRelationCache            2
+#define kNtRelationProcessorPackage 3
+#define kNtRelationGroup            4
+#define kNtRelationAll              0xffff
+
+#define kNtCacheUnified     0
+#define kNtCacheInstruction 1
+#define kNtCacheData        2
+#define kNtCacheTrace       3
+
+struct NtGroupAffinity {
+  uint64_t Mask;
+  uint16_t Group;
+  uint16_t Reserved[3];
+};
+
+struct NtProcessorRelationship {
+  uint8_t Flags;
+  uint8_t EfficiencyClass;
+  uint8_t Reserved[20];
+  uint16_t GroupCount;
+  struct NtGroupAffinity GroupMask[1]; /* [GroupCount] */
+};
+
+struct NtNumaNodeRelationship {
+  uint32_t NodeNumber;
+  uint8_t Reserved[18];
+  uint16_t GroupCount; /* zero before Windows 11 means one */
+  struct NtGroupAffinity GroupMask[1];
+};
+
+struct NtCacheRelationship {
+  uint8_t Level;
+  uint8_t Associativity;
+  uint16_t LineSize;
+  uint32_t CacheSize;
+  uint32_t Type; /* kNtCacheXXX */
+  uint8_t Reserved[18];
+  uint16_t GroupCount; /* zero before Windows 11 means one */
+  struct NtGroupAffinity GroupMask[1];
+};
+
+struct NtSystemLogicalProcessorInformationEx {
+  uint32_t Relationship; /* kNtRelationXXX */
+  uint32_t Size;         /* bytes of this variable length record */
+  union {
+    struct NtProcessorRelationship Processor;
+    struct NtNumaNodeRelationship NumaNode;
+    struct NtCacheRelationship Cache;
+  };
+};
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_LIBC_NT_STRUCT_SYSTEMLOGICALPROCESSORINFORMATIONEX_H_ */
@@ -225,13 +225,13 @@ textwindows char *__describe_fds(const struct Fd *fds, size_t fdslen,
     // get shared memory handle for the file offset pointer
     intptr_t shand = 0;
     if (f->cursor) {
-      struct Map *map;
-      if (!(map = __maps_floor((const char *)f->cursor->shared)) ||
-          map->addr != (const char *)f->cursor->shared) {
+      struct Map map;
+      if (!__maps_lookup(f->cursor->shared, &map) ||
+          map.addr != (const char *)f->cursor->shared) {
         errno = EFAULT;
         goto OnError;
       }
-      if (AppendHandle(&handles, map->hand, hCreatorProcess, &shand))
+      if (AppendHandle(&handles, map.hand, hCreatorProcess, &shand))
         goto OnError;
     }
 
@@ -117,6 +117,10 @@ textwindows static void sys_fork_nt_child(void) {
   if (_weaken(__flocks_wipe))
     _weaken(__flocks_wipe)();
 
+  // forget directory listings cached by stat()
+  if (_weaken(__statcache_wipe))
+    _weaken(__statcache_wipe)();
+
   // resurrect shared memory mappings
   struct Map *next;
   for (struct Map *map = __maps_first(); map; map = next) {
@@ -77,6 +77,10 @@ void __dlopen_lock(void);
 void __dlopen_unlock(void);
 void __dlopen_wipe(void);
 
+void __zipos_lock(void);
+void __zipos_unlock(void);
+void __zipos_wipe(void);
+
 // first and last and always
 // it is the lord of all locks
 // subordinate to no other lock
@@ -132,6 +136,8 @@ static void fork_prepare(void) {
     _weaken(__localtime_lock)();
   if (_weaken(__dlopen_lock))
     _weaken(__dlopen_lock)();
+  if (_weaken(__zipos_lock))
+    _weaken(__zipos_lock)();
   if (IsWindows()) {
     __sig_generate_lock();
     __sig_worker_lock();
@@ -180,6 +186,8 @@ static void fork_parent(void) {
     __sig_worker_unlock();
     __sig_generate_unlock();
   }
+  if (_weaken(__zipos_unlock))
+    _weaken(__zipos_unlock)();
   if (_weaken(__dlopen_unlock))
     _weaken(__dlopen_unlock)();
   if (_weaken(__localtime_unlock))
@@ -203,6 +211,8 @@ static void fork_child(int ppid_win32, int ppid_cosmo) {
   pthread_mutex_wipe_np(&__cxa_lock_obj);
   if (_weaken(cosmo_stack_wipe))
     _weaken(cosmo_stack_wipe)();
+  if (_weaken(__zipos_wipe))
+    _weaken(__zipos_wipe)();
   if (_weaken(__dlopen_wipe))
     _weaken(__dlopen_wipe)();
   if (_weaken(__localtime_wipe))
@@ -211,6 +221,8 @@ static void fork_child(int ppid_win32, int ppid_cosmo) {
     // we don't bother locking the proc/itimer/sig locks above since
     // their state is reset in the forked child. nothing to protect.
     sys_read_nt_wipe_keystrokes();
+    if (_weaken(sys_poll_nt_wipe))
+      _weaken(sys_poll_nt_wipe)();
     __proc_wipe_and_reset();
     __sig_generate_wipe();
     __sig_worker_wipe();
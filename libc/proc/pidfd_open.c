@@ -0,0 +1,81 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/calls/kevent.internal.h"
+#include "libc/calls/syscall-sysv.internal.h"
+#include "libc/dce.h"
+#include "libc/errno.h"
+#include "libc/intrin/strace.h"
+#include "libc/sysv/consts/f.h"
+#include "libc/sysv/consts/pidfd.h"
+#include "libc/sysv/errfuns.h"
+
+int sys_pidfd_open(int, unsigned);
+
+static int pidfd_open_bsd(int pid) {
+  int kq, e;
+  if ((kq = sys_kqueue()) == -1)
+    return -1;
+  if (__kevent_change(kq, pid, EVFILT_PROC, EV_ADD, NOTE_EXIT, 0)) {
+    e = errno;
+    sys_close(kq);
+    errno = e;
+    return -1;
+  }
+  fcntl(kq, F_SETFD, FD_CLOEXEC);
+  return kq;
+}
+
+/**
+ * Returns file descriptor that becomes readable when process exits.
+ *
+ * This makes it possible to supervise child processes with poll() or
+ * epoll_wait() alongside sockets, rather than handling `SIGCHLD`. Once
+ * the descriptor polls as readable, `pid` may be reaped using wait4()
+ * without blocking. The returned descriptor is always close-on-exec.
+ *
+ * On Linux 5.3+ this is a real pidfd. On FreeBSD, OpenBSD, NetBSD and
+ * XNU it's a kqueue with an `EVFILT_PROC` / `NOTE_EXIT` filter, which
+ * is pollable too, but it may only be polled and closed. Under BSD and
+ * XNU kqueues aren't inherited across fork(). Some BSD kernels refuse
+ * to watch a zombie process, in which case `ESRCH` is raised, and the
+ * caller should just try to reap it.
+ *
+ * @param pid is id of process to watch
+ * @param flags may have `PIDFD_NONBLOCK`, which is ignored on BSDs
+ * @return new file descriptor, or -1 w/ errno
+ * @raise EINVAL if `pid` isn't positive or `flags` is invalid
+ * @raise ESRCH if `pid` doesn't exist
+ * @raise ENOSYS on Windows, and Linux before 5.3
+ * @see pidfd_send_signal()
+ */
+int pidfd_open(int pid, unsigned flags) {
+  int rc;
+  if (pid <= 0 || (flags & ~PIDFD_NONBLOCK)) {
+    rc = einval();
+  } else if (IsLinux()) {
+    rc = sys_pidfd_open(pid, flags);
+  } else if (IsBsd()) {
+    rc = pidfd_open_bsd(pid);
+  } else {
+    rc = enosys();
+  }
+  STRACE("pidfd_open(%d, %#x) → %d% m", pid, flags, rc);
+  return rc;
+}
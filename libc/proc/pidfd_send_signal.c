@@ -0,0 +1,51 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/calls/struct/siginfo.h"
+#include "libc/dce.h"
+#include "libc/intrin/strace.h"
+#include "libc/sysv/errfuns.h"
+
+int sys_pidfd_send_signal(int, int, siginfo_t *, unsigned);
+
+/**
+ * Sends signal to process referred to by pidfd.
+ *
+ * Unlike kill() this can't accidentally signal an unrelated process in
+ * the event that the original one exited and its id was reused.
+ *
+ * @param pidfd was returned by pidfd_open()
+ * @param sig is signal number
+ * @param info may be null, otherwise see rt_sigqueueinfo()
+ * @param flags must be zero
+ * @return 0 on success, or -1 w/ errno
+ * @raise ESRCH if process has already exited
+ * @raise ENOSYS if not Linux 5.1+
+ */
+int pidfd_send_signal(int pidfd, int sig, siginfo_t *info, unsigned flags) {
+  int rc;
+  if (IsLinux()) {
+    rc = sys_pidfd_send_signal(pidfd, sig, info, flags);
+  } else {
+    rc = enosys();
+  }
+  STRACE("pidfd_send_signal(%d, %G, %p, %#x) → %d% m", pidfd, sig, info, flags,
+         rc);
+  return rc;
+}
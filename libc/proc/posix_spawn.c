@@ -41,6 +41,32 @@
 
 static atomic_bool has_vfork;  // i.e. not qemu/wsl/xnu/openbsd
 
+// closes inclusive range of fds in child, except for `keep`
+static int posix_spawn_close(unsigned lo, unsigned hi, int keep) {
+  unsigned k = keep;
+  if (keep >= 0 && lo <= k && k <= hi) {
+    if (k > lo && posix_spawn_close(lo, k - 1, -1))
+      return -1;
+    if (k == hi)
+      return 0;
+    lo = k + 1;
+  }
+  if (lo < hi) {
+    if ((IsLinux() || IsFreebsd()) && !sys_close_range(lo, hi, 0))
+      return 0;
+    if (hi == -1u) {
+      closefrom(lo);
+      return 0;
+    }
+  }
+  for (;;) {
+    if (close(lo) && errno != EBADF)
+      return -1;
+    if (lo++ == hi)
+      return 0;
+  }
+}
+
 /**
  * Spawns process, the POSIX way, e.g.
  *
@@ -149,6 +175,7 @@ static atomic_bool has_vfork;  // i.e. not qemu/wsl/xnu/openbsd
  * - posix_spawn_file_actions_adddup2()
  * - posix_spawn_file_actions_addopen()
  * - posix_spawn_file_actions_addclose()
+ * - posix_spawn_file_actions_addclosefrom_np()
  * - posix_spawn_file_actions_addchdir_np()
  * - posix_spawn_file_actions_addfchdir_np()
  *
@@ -247,7 +274,9 @@ errno_t posix_spawn(int *pid, const char *path,
     if (file_actions) {
       struct _posix_faction *a;
       for (a = *file_actions; a; a = a->next) {
-        if (!use_vfork && pfds[1] == a->fildes) {
+        if (!use_vfork && pfds[1] == a->fildes &&
+            a->action != _POSIX_SPAWN_CLOSE &&
+            a->action != _POSIX_SPAWN_CLOSEFROM) {
           int p2;
           if ((p2 = dup(pfds[1])) == -1)
             goto ChildFailed;
@@ -257,7 +286,12 @@ errno_t posix_spawn(int *pid, const char *path,
         }
         switch (a->action) {
           case _POSIX_SPAWN_CLOSE:
-            if (close(a->fildes))
+            if (posix_spawn_close(a->fildes, a->newfildes,
+                                  use_vfork ? -1 : pfds[1]))
+              goto ChildFailed;
+            break;
+          case _POSIX_SPAWN_CLOSEFROM:
+            if (posix_spawn_close(a->fildes, -1u, use_vfork ? -1 : pfds[1]))
               goto ChildFailed;
             break;
           case _POSIX_SPAWN_DUP2:
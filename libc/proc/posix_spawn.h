@@ -28,6 +28,8 @@ int posix_spawn_file_actions_init(posix_spawn_file_actions_t *) libcesque;
 int posix_spawn_file_actions_destroy(posix_spawn_file_actions_t *) libcesque;
 int posix_spawn_file_actions_addclose(posix_spawn_file_actions_t *,
                                       int) libcesque;
+int posix_spawn_file_actions_addclosefrom_np(posix_spawn_file_actions_t *,
+                                             int) libcesque;
 int posix_spawn_file_actions_adddup2(posix_spawn_file_actions_t *, int,
                                      int) libcesque;
 int posix_spawn_file_actions_addopen(posix_spawn_file_actions_t *, int,
@@ -5,11 +5,12 @@
 #include "libc/calls/struct/sigset.h"
 #include "libc/proc/posix_spawn.h"
 
-#define _POSIX_SPAWN_CLOSE  1
-#define _POSIX_SPAWN_DUP2   2
-#define _POSIX_SPAWN_OPEN   3
-#define _POSIX_SPAWN_CHDIR  4
-#define _POSIX_SPAWN_FCHDIR 5
+#define _POSIX_SPAWN_CLOSE     1
+#define _POSIX_SPAWN_DUP2      2
+#define _POSIX_SPAWN_OPEN      3
+#define _POSIX_SPAWN_CHDIR     4
+#define _POSIX_SPAWN_FCHDIR    5
+#define _POSIX_SPAWN_CLOSEFROM 6
 
 COSMOPOLITAN_C_START_
 
@@ -32,7 +33,7 @@ struct _posix_faction {
   int fildes;
   int oflag;
   union {
-    int newfildes;
+    int newfildes; /* or last fd of inclusive range for _POSIX_SPAWN_CLOSE */
     unsigned mode;
   };
   char *path;
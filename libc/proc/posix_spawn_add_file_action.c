@@ -24,10 +24,18 @@
 int __posix_spawn_add_file_action(posix_spawn_file_actions_t *l,
                                   struct _posix_faction a) {
   struct _posix_faction *ap;
+  while (*l && (*l)->next)
+    l = &(*l)->next;
+  // coalesce runs of consecutive closes, so it's one close_range() call
+  if (*l && (*l)->action == _POSIX_SPAWN_CLOSE &&
+      a.action == _POSIX_SPAWN_CLOSE && a.fildes == (*l)->newfildes + 1) {
+    (*l)->newfildes = a.fildes;
+    return 0;
+  }
   if (!(ap = malloc(sizeof(*ap))))
     return ENOMEM;
   *ap = a;
-  while (*l)
+  if (*l)
     l = &(*l)->next;
   *l = ap;
   return 0;
@@ -24,6 +24,11 @@
 /**
  * Add a close action to object.
  *
+ * It's not an error for `fildes` to not be open in the child. Closes
+ * of consecutive file descriptors get merged into a single action, so
+ * they can be performed by one close_range() system call on platforms
+ * that have it.
+ *
  * @param file_actions was initialized by posix_spawn_file_actions_init()
  * @return 0 on success, or errno on error
  * @raise ENOMEM if we require more vespene gas
@@ -37,5 +42,6 @@ int posix_spawn_file_actions_addclose(posix_spawn_file_actions_t *file_actions,
                                        (struct _posix_faction){
                                            .action = _POSIX_SPAWN_CLOSE,
                                            .fildes = fildes,
+                                           .newfildes = fildes,
                                        });
 }
@@ -0,0 +1,44 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/errno.h"
+#include "libc/proc/posix_spawn.h"
+#include "libc/proc/posix_spawn.internal.h"
+
+/**
+ * Add action to close all file descriptors greater than or equal to
+ * `fildes` in the spawned process.
+ *
+ * This uses close_range() on Linux and FreeBSD, and polyfills it with
+ * closefrom() elsewhere. The same function is offered by glibc.
+ *
+ * @param file_actions was initialized by posix_spawn_file_actions_init()
+ * @return 0 on success, or errno on error
+ * @raise ENOMEM if insufficient memory was available
+ * @raise EBADF if `fildes` is negative
+ */
+int posix_spawn_file_actions_addclosefrom_np(
+    posix_spawn_file_actions_t *file_actions, int fildes) {
+  if (fildes < 0)
+    return EBADF;
+  return __posix_spawn_add_file_action(file_actions,
+                                       (struct _posix_faction){
+                                           .action = _POSIX_SPAWN_CLOSEFROM,
+                                           .fildes = fildes,
+                                       });
+}
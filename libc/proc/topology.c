@@ -0,0 +1,402 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/calls/syscall_support-nt.internal.h"
+#include "libc/cosmo.h"
+#include "libc/dce.h"
+#include "libc/errno.h"
+#include "libc/intrin/kprintf.h"
+#include "libc/macros.h"
+#include "libc/mem/mem.h"
+#include "libc/nt/accounting.h"
+#include "libc/nt/errors.h"
+#include "libc/nt/runtime.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/o.h"
+#include "libc/sysv/errfuns.h"
+
+#define FIELD(x) offsetof(struct CosmoCpu, x)
+
+// parses next range of linux cpulist format, e.g. "0-3,8,10-11", or
+// freebsd topology_spec format, e.g. "0, 1, 2, 3", returning null at end
+static const char *cosmo_topology_range(const char *s, int *lo, int *hi) {
+  while (*s == ',' || *s == ' ' || *s == '\n')
+    ++s;
+  if (!('0' <= *s && *s <= '9'))
+    return 0;
+  for (*lo = 0; '0' <= *s && *s <= '9'; ++s)
+    *lo = *lo * 10 + (*s - '0');
+  *hi = *lo;
+  if (*s == '-')
+    for (*hi = 0, ++s; '0' <= *s && *s <= '9'; ++s)
+      *hi = *hi * 10 + (*s - '0');
+  return s;
+}
+
+// returns first number in list, or -1 if there is none
+static int cosmo_topology_first(const char *s) {
+  int lo, hi;
+  if (cosmo_topology_range(s, &lo, &hi))
+    return lo;
+  return -1;
+}
+
+static struct CosmoCpu *cosmo_topology_find(struct CosmoCpu *t, int n,
+                                            int cpu) {
+  for (int i = 0; i < n; ++i)
+    if (t[i].cpu == cpu)
+      return t + i;
+  return 0;
+}
+
+static void cosmo_topology_set(struct CosmoCpu *t, int n, int cpu,
+                               size_t field, int val) {
+  struct CosmoCpu *c;
+  if ((c = cosmo_topology_find(t, n, cpu)))
+    *(int *)((char *)c + field) = val;
+}
+
+// assigns field of each cpu in list to the list's lowest cpu, or `val`
+static void cosmo_topology_setlist(struct CosmoCpu *t, int n, const char *s,
+                                   size_t field, int val) {
+  int lo, hi;
+  if (val == -1)
+    val = cosmo_topology_first(s);
+  while ((s = cosmo_topology_range(s, &lo, &hi)))
+    for (; lo <= hi; ++lo)
+      cosmo_topology_set(t, n, lo, field, val);
+}
+
+static void cosmo_topology_default(struct CosmoCpu *t, int n) {
+  for (int i = 0; i < n; ++i)
+    t[i] = (struct CosmoCpu){i, -1, -1, 0, -1, -1};
+}
+
+static ssize_t cosmo_topology_slurp(const char *path, char *buf, size_t size) {
+  int fd;
+  ssize_t rc;
+  if ((fd = open(path, O_RDONLY | O_CLOEXEC)) == -1)
+    return -1;
+  rc = read(fd, buf, size - 1);
+  close(fd);
+  if (rc == -1)
+    return -1;
+  buf[rc] = 0;
+  return rc;
+}
+
+static int cosmo_topology_linux(struct CosmoCpu *t, int n) {
+  const char *s;
+  int i, j, m, lo, hi, cpu, level;
+  char path[80], buf[1024], nodes[256];
+  if (cosmo_topology_slurp("/sys/devices/system/cpu/online", buf,
+                           sizeof(buf)) == -1)
+    return -1;
+  for (m = 0, s = buf; (s = cosmo_topology_range(s, &lo, &hi));)
+    for (; lo <= hi; ++lo, ++m)
+      if (m < n)
+        t[m] = (struct CosmoCpu){lo, -1, -1, 0, -1, -1};
+  n = MIN(m, n);
+  for (i = 0; i < n; ++i) {
+    cpu = t[i].cpu;
+    ksnprintf(path, sizeof(path),
+              "/sys/devices/system/cpu/cpu%d/topology/physical_package_id",
+              cpu);
+    if (cosmo_topology_slurp(path, buf, sizeof(buf)) != -1)
+      t[i].package = cosmo_topology_first(buf);
+    ksnprintf(path, sizeof(path),
+              "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list",
+              cpu);
+    if (cosmo_topology_slurp(path, buf, sizeof(buf)) != -1)
+      t[i].core = cosmo_topology_first(buf);
+    for (j = 0; j < 8; ++j) {
+      ksnprintf(path, sizeof(path),
+                "/sys/devices/system/cpu/cpu%d/cache/index%d/type", cpu, j);
+      if (cosmo_topology_slurp(path, buf, sizeof(buf)) == -1)
+        break;
+      if (startswith(buf, "Instruction"))
+        continue;
+      ksnprintf(path, sizeof(path),
+                "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, j);
+      if (cosmo_topology_slurp(path, buf, sizeof(buf)) == -1)
+        continue;
+      if ((level = cosmo_topology_first(buf)) != 2 && level != 3)
+        continue;
+      ksnprintf(path, sizeof(path),
+                "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list",
+                cpu, j);
+      if (cosmo_topology_slurp(path, buf, sizeof(buf)) == -1)
+        continue;
+      if (level == 2) {
+        t[i].l2 = cosmo_topology_first(buf);
+      } else {
+        t[i].l3 = cosmo_topology_first(buf);
+      }
+    }
+  }
+  if (cosmo_topology_slurp("/sys/devices/system/node/online", nodes,
+                           sizeof(nodes)) != -1) {
+    for (s = nodes; (s = cosmo_topology_range(s, &lo, &hi));) {
+      for (; lo <= hi; ++lo) {
+        ksnprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+                  lo);
+        if (cosmo_topology_slurp(path, buf, sizeof(buf)) != -1)
+          cosmo_topology_setlist(t, n, buf, FIELD(node), lo);
+      }
+    }
+  }
+  return m;
+}
+
+// sysctlbyname() that works on freebsd and xnu without syslib
+static int cosmo_topology_sysctl(const char *name, void *p, size_t *n) {
+  int mib[2] = {0, 3};  // name2oid
+  int oid[24];
+  size_t len = sizeof(oid);
+  if (sysctl(mib, 2, oid, &len, (void *)name, strlen(name)) == -1)
+    return -1;
+  return sysctl(oid, len / sizeof(int), p, n, 0, 0);
+}
+
+// parses xml from kern.sched.topology_spec which looks like this:
+//
+//     <groups>
+//      <group level="1" cache-level="3">
+//       <cpu count="4" mask="f,0,0,0">0, 1, 2, 3</cpu>
+//       <children>
+//        <group level="2" cache-level="2">
+//         <cpu count="2" mask="3,0,0,0">0, 1</cpu>
+//         <flags><flag name="THREAD">THREAD group</flag>...</flags>
+//        </group>
+//        ...
+static void cosmo_topology_freebsd(struct CosmoCpu *t, int n) {
+  char *spec, *s, *p;
+  size_t len = 0;
+  int i, depth, level[8];
+  const char *list[8];
+  for (i = 0; i < n; ++i) {
+    size_t z = sizeof(int);
+    char name[32];
+    ksnprintf(name, sizeof(name), "dev.cpu.%d.%%domain", t[i].cpu);
+    cosmo_topology_sysctl(name, &t[i].node, &z);
+  }
+  if (cosmo_topology_sysctl("kern.sched.topology_spec", 0, &len) == -1)
+    return;
+  if (!(spec = malloc(len + 1)))
+    return;
+  if (cosmo_topology_sysctl("kern.sched.topology_spec", spec, &len) != -1) {
+    spec[len] = 0;
+    for (i = 0; i < n; ++i)
+      t[i].core = t[i].cpu;
+    for (depth = 0, s = spec; (s = strchr(s, '<')); ++s) {
+      if (startswith(s, "<group ")) {
+        if (depth < ARRAYLEN(level)) {
+          level[depth] = -1;
+          list[depth] = 0;
+          if ((p = strstr(s, "cache-level=\"")) && p < strchr(s, '>'))
+            level[depth] = cosmo_topology_first(p + 13);
+        }
+        ++depth;
+      } else if (startswith(s, "</group>")) {
+        if (depth)
+          --depth;
+      } else if (depth && depth <= ARRAYLEN(level)) {
+        if (startswith(s, "<cpu ")) {
+          if ((p = strchr(s, '>'))) {
+            list[depth - 1] = p + 1;
+            if (level[depth - 1] == 2)
+              cosmo_topology_setlist(t, n, p + 1, FIELD(l2), -1);
+            if (level[depth - 1] == 3)
+              cosmo_topology_setlist(t, n, p + 1, FIELD(l3), -1);
+          }
+        } else if (startswith(s, "<flag name=\"SMT\"") ||
+                   startswith(s, "<flag name=\"THREAD\"")) {
+          if (list[depth - 1])
+            cosmo_topology_setlist(t, n, list[depth - 1], FIELD(core), -1);
+        }
+      }
+    }
+  }
+  free(spec);
+}
+
+static void cosmo_topology_xnu(struct CosmoCpu *t, int n) {
+  size_t z;
+  int logical = 0, physical = 0, packages = 0;
+  uint64_t cacheconfig[8] = {0};
+  z = sizeof(int);
+  cosmo_topology_sysctl("hw.logicalcpu", &logical, &z);
+  z = sizeof(int);
+  cosmo_topology_sysctl("hw.physicalcpu", &physical, &z);
+  z = sizeof(int);
+  cosmo_topology_sysctl("hw.packages", &packages, &z);
+  z = sizeof(cacheconfig);
+  cosmo_topology_sysctl("hw.cacheconfig", cacheconfig, &z);
+  for (int i = 0; i < n; ++i) {
+    int cpu = t[i].cpu;
+    if (logical > 0 && physical > 0 && logical >= physical)
+      t[i].core = cpu - cpu % (logical / physical);
+    if (logical > 0 && packages > 0 && logical >= packages)
+      t[i].package = cpu / (logical / packages);
+    if (cacheconfig[2])
+      t[i].l2 = cpu - cpu % cacheconfig[2];
+    if (cacheconfig[3])
+      t[i].l3 = cpu - cpu % cacheconfig[3];
+  }
+}
+
+// returns lowest cpu in group affinity masks
+static textwindows int cosmo_topology_nt_first(
+    const struct NtGroupAffinity *g, int count) {
+  int first = -1;
+  for (int i = 0; i < count; ++i)
+    if (g[i].Mask) {
+      int cpu = g[i].Group * 64 + __builtin_ctzll(g[i].Mask);
+      if (first == -1 || cpu < first)
+        first = cpu;
+    }
+  return first;
+}
+
+// assigns field of each cpu in affinity masks to lowest cpu, or `val`
+static textwindows void cosmo_topology_nt_set(struct CosmoCpu *t, int n,
+                                              const struct NtGroupAffinity *g,
+                                              int count, size_t field,
+                                              int val) {
+  if (!count)
+    count = 1;  // GroupCount is reserved before windows 11
+  if (val == -1)
+    val = cosmo_topology_nt_first(g, count);
+  for (int i = 0; i < count; ++i)
+    for (int b = 0; b < 64; ++b)
+      if (g[i].Mask & (1ull << b))
+        cosmo_topology_set(t, n, g[i].Group * 64 + b, field, val);
+}
+
+static textwindows int cosmo_topology_nt(struct CosmoCpu *t, int n) {
+  uint32_t len = 0;
+  int m, package, group, bit;
+  uint64_t present[64] = {0};
+  char *buf, *p;
+  struct NtSystemLogicalProcessorInformationEx *r;
+  if (GetLogicalProcessorInformationEx(kNtRelationAll, 0, &len) ||
+      GetLastError() != kNtErrorInsufficientBuffer)
+    return __winerr();
+  if (!(buf = malloc(len)))
+    return -1;
+  if (!GetLogicalProcessorInformationEx(kNtRelationAll, (void *)buf, &len)) {
+    free(buf);
+    return __winerr();
+  }
+  for (p = buf; p < buf + len; p += r->Size) {
+    r = (struct NtSystemLogicalProcessorInformationEx *)p;
+    if (r->Relationship == kNtRelationProcessorCore)
+      for (int i = 0; i < r->Processor.GroupCount; ++i)
+        present[r->Processor.GroupMask[i].Group & 63] |=
+            r->Processor.GroupMask[i].Mask;
+  }
+  for (m = group = 0; group < 64; ++group)
+    for (bit = 0; bit < 64; ++bit)
+      if (present[group] & (1ull << bit)) {
+        if (m < n)
+          t[m] = (struct CosmoCpu){group * 64 + bit, -1, -1, 0, -1, -1};
+        ++m;
+      }
+  n = MIN(m, n);
+  for (package = 0, p = buf; p < buf + len; p += r->Size) {
+    r = (struct NtSystemLogicalProcessorInformationEx *)p;
+    switch (r->Relationship) {
+      case kNtRelationProcessorCore:
+        cosmo_topology_nt_set(t, n, r->Processor.GroupMask,
+                              r->Processor.GroupCount, FIELD(core), -1);
+        break;
+      case kNtRelationProcessorPackage:
+        cosmo_topology_nt_set(t, n, r->Processor.GroupMask,
+                              r->Processor.GroupCount, FIELD(package),
+                              package++);
+        break;
+      case kNtRelationNumaNode:
+        cosmo_topology_nt_set(t, n, r->NumaNode.GroupMask,
+                              r->NumaNode.GroupCount, FIELD(node),
+                              r->NumaNode.NodeNumber);
+        break;
+      case kNtRelationCache:
+        if (r->Cache.Type == kNtCacheInstruction)
+          break;
+        if (r->Cache.Level == 2)
+          cosmo_topology_nt_set(t, n, r->Cache.GroupMask, r->Cache.GroupCount,
+                                FIELD(l2), -1);
+        if (r->Cache.Level == 3)
+          cosmo_topology_nt_set(t, n, r->Cache.GroupMask, r->Cache.GroupCount,
+                                FIELD(l3), -1);
+        break;
+      default:
+        break;
+    }
+  }
+  free(buf);
+  return m;
+}
+
+/**
+ * Describes how CPUs share cores, caches, sockets, and memory.
+ *
+ * This is useful for pinning a worker pool to each L3 cache complex or
+ * NUMA node, using sched_setaffinity(). Each CPU appears once, in order
+ * of its logical number. CPUs sharing a physical core, L2 cache, or L3
+ * cache report the same lowest CPU number in the corresponding field,
+ * so grouping by that field yields the sharing groups. Fields that the
+ * host system doesn't disclose are reported as -1, except for `node`,
+ * which is 0 on machines that aren't NUMA.
+ *
+ * On Linux this reads sysfs, on Windows it uses the Win32 function
+ * GetLogicalProcessorInformationEx(), on FreeBSD it parses the sysctl
+ * `kern.sched.topology_spec`, and on XNU it consults `hw.cacheconfig`.
+ * Only CPU numbers are reported on OpenBSD and NetBSD.
+ *
+ *     int n = cosmo_topology(0, 0);
+ *     struct CosmoCpu *t = malloc(n * sizeof(*t));
+ *     n = MIN(n, cosmo_topology(t, n));
+ *
+ * @param t receives up to `n` entries, and may be null if `n` is 0
+ * @return number of CPUs in system, which may be more than `n`, or -1
+ *     w/ errno, in which case some entries may have been written
+ * @raise EINVAL if `n` is negative
+ */
+int cosmo_topology(struct CosmoCpu *t, int n) {
+  int m, e = errno;
+  if (n < 0)
+    return einval();
+  if (IsWindows())
+    return cosmo_topology_nt(t, n);
+  if (IsLinux() && (m = cosmo_topology_linux(t, n)) != -1) {
+    errno = e;
+    return m;
+  }
+  if ((m = cosmo_cpu_count()) == -1)
+    return -1;
+  n = MIN(m, n);
+  cosmo_topology_default(t, n);
+  if (IsFreebsd())
+    cosmo_topology_freebsd(t, n);
+  if (IsXnu())
+    cosmo_topology_xnu(t, n);
+  errno = e;
+  return m;
+}
@@ -101,6 +101,7 @@ textwindows static int __proc_reap_zombie(struct Proc *pr, int *wstatus,
     *wstatus = __proc_wstatus(pr->dwExitCode);
   if (opt_out_rusage)
     *opt_out_rusage = pr->ru;
+  __statcache_drop();
   dll_remove(&__proc.zombies, &pr->elem);
   pr->status = PROC_UNDEAD;
   dll_make_first(&__proc.undead, &pr->elem);
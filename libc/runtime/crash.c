@@ -56,7 +56,7 @@ static void kprintf_crash_handle(int sig, siginfo_t *si, void *arg) {
       ;
   ucontext_t *ctx = arg;
   kprintf("error: %G cosmoaddr2line %s %lx %s\n", si->si_signo,
-          _weaken(FindDebugBinary) ? _weaken(FindDebugBinary)()
+          _weaken(FindDebugBinaryCached) ? _weaken(FindDebugBinaryCached)()
                                    : program_invocation_name,
           ctx->uc_mcontext.PC,
           DescribeBacktrace((struct StackFrame *)ctx->uc_mcontext.BP));
@@ -0,0 +1,366 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/intrin/bsr.h"
+#include "libc/runtime/internal.h"
+#include "libc/serialize.h"
+#include "libc/str/str.h"
+
+/**
+ * @fileoverview table driven deflate decoder
+ *
+ * This sits between puff and zlib. Huffman codes are decoded with one
+ * lookup in a main table of 2^10 (or 2^8 for distances) entries, which
+ * may point to a subtable for the rare longer codes, and a 64-bit bit
+ * buffer gets refilled eight bytes at a time, so one refill covers the
+ * longest possible length and distance pair. Matches are copied eight
+ * bytes at a time when there's room. Since the whole output buffer is
+ * the window, no state needs to be allocated, and the tables live on
+ * the stack. It's enabled by __static_yoink("__fastinflate").
+ */
+
+#define LITLEN_BITS   10
+#define DIST_BITS     8
+#define PRECODE_BITS  7
+#define LITLEN_ENOUGH 1334  // see zlib's enough.c for 288 symbols
+#define DIST_ENOUGH   402   // see zlib's enough.c for 30 symbols
+
+// table entries are value<<16 | flags | extra<<8 | codebits
+#define F_LITERAL  0x1000
+#define F_LENGTH   0x2000  // value is base of length or distance
+#define F_END      0x4000
+#define F_SUBTABLE 0x8000  // value is subtable index, extra its bits
+
+static const uint16_t kLenBase[29] = {
+    3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+    31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+
+static const uint8_t kLenExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+    2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+
+static const uint16_t kDistBase[30] = {
+    1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+    33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+};
+
+static const uint8_t kDistExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+
+static const uint8_t kPrecodeOrder[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15,
+};
+
+static uint32_t GetLitlenResult(int sym) {
+  if (sym < 256)
+    return sym << 16 | F_LITERAL;
+  if (sym == 256)
+    return F_END;
+  if (sym < 286)
+    return kLenBase[sym - 257] << 16 | F_LENGTH | kLenExtra[sym - 257] << 8;
+  return 0;
+}
+
+static uint32_t GetDistResult(int sym) {
+  if (sym < 30)
+    return kDistBase[sym] << 16 | F_LENGTH | kDistExtra[sym] << 8;
+  return 0;
+}
+
+static uint32_t GetPrecodeResult(int sym) {
+  return sym << 16 | F_LITERAL;
+}
+
+// builds decode table for canonical huffman code, where entries are
+// indexed by the next bits of input, i.e. codewords bit reversed. an
+// incomplete code is only accepted when it's a single one bit code,
+// or when `incomplete` is set, and all of its codes fit in the main
+// table, so unused entries can simply be left invalid.
+static bool BuildTable(uint32_t *table, int bits, const uint8_t *lens, int n,
+                       uint32_t result(int), bool incomplete) {
+  uint16_t sorted[288];
+  uint32_t entry, prefix, start, end, used;
+  unsigned i, j, len, sym, cnt, code, bit, subbits;
+  int left, codes, maxlen, count[16] = {0}, offs[16];
+  for (sym = 0; sym < n; ++sym)
+    ++count[lens[sym]];
+  for (codes = maxlen = 0, left = 1, len = 1; len <= 15; ++len) {
+    left <<= 1;
+    if ((left -= count[len]) < 0)
+      return false;  // over-subscribed
+    if (count[len])
+      maxlen = len;
+    codes += count[len];
+  }
+  if (left) {
+    if (!(incomplete || (codes == 1 && maxlen == 1)) || maxlen > bits)
+      return false;
+    memset(table, 0, sizeof(*table) << bits);
+  }
+  if (!codes)
+    return true;
+  for (offs[1] = 0, len = 1; len < 15; ++len)
+    offs[len + 1] = offs[len] + count[len];
+  for (sym = 0; sym < n; ++sym)
+    if (lens[sym])
+      sorted[offs[lens[sym]]++] = sym;
+  for (len = 1; !count[len]; ++len) {
+  }
+  cnt = count[len];
+  code = 0;
+  prefix = -1;
+  start = 0;
+  end = 1u << bits;
+  for (i = 0;;) {
+    sym = sorted[i];
+    if (len <= bits) {
+      entry = result(sym) | len;
+      for (j = code; j < end; j += 1u << len)
+        table[j] = entry;
+    } else {
+      if ((code & ((1u << bits) - 1)) != prefix) {
+        prefix = code & ((1u << bits) - 1);
+        start = end;
+        subbits = len - bits;
+        for (used = cnt; used < 1u << subbits;)
+          used = (used << 1) + count[bits + ++subbits];
+        end = start + (1u << subbits);
+        table[prefix] = start << 16 | F_SUBTABLE | subbits << 8 | bits;
+      }
+      entry = result(sym) | (len - bits);
+      for (j = start + (code >> bits); j < end; j += 1u << (len - bits))
+        table[j] = entry;
+    }
+    if (++i == codes)
+      return true;
+    // increment bit reversed codeword
+    bit = 1u << bsr(code ^ ((1u << len) - 1));
+    code &= bit - 1;
+    code |= bit;
+    while (!--cnt)
+      cnt = count[++len] + 1;
+  }
+}
+
+/**
+ * Decompresses raw deflate data quickly.
+ *
+ * @param outsize is the size of the output buffer, which must be big
+ *     enough to hold all of the decompressed data
+ * @return 0 on success or nonzero on failure
+ */
+int __fastinflate(void *out, size_t outsize, const void *in, size_t insize) {
+  uint64_t bb;
+  size_t pad, len, dist;
+  uint8_t *op, *oe, *src, *end;
+  const uint8_t *ip, *ie;
+  unsigned i, n, bl, sym, rep, nlen, ndist, final;
+  uint32_t e, litlen[LITLEN_ENOUGH], dists[DIST_ENOUGH];
+  uint32_t precode[1 << PRECODE_BITS];
+  uint8_t lens[288 + 32];
+  op = out;
+  oe = op + outsize;
+  ip = in;
+  ie = ip + insize;
+  bb = bl = pad = 0;
+
+  // makes at least 56 bits available. near the end of input, zeroes get
+  // fed instead, and how many of those got consumed is checked at the end
+#define REFILL()                          \
+  if (ie - ip >= 8) {                     \
+    bb |= READ64LE(ip) << bl;             \
+    ip += (63 - bl) >> 3;                 \
+    bl |= 56;                             \
+  } else {                                \
+    for (; bl <= 56; bl += 8) {           \
+      if (ip < ie) {                      \
+        bb |= (uint64_t)*ip++ << bl;      \
+      } else if (++pad > 8) {             \
+        return -1; /* ran out of input */ \
+      }                                   \
+    }                                     \
+  }
+#define BITS(n) ((uint32_t)bb & ((1u << (n)) - 1))
+#define DROP(n) (bb >>= (n), bl -= (n))
+
+  do {
+    REFILL();
+    final = BITS(1);
+    sym = BITS(3) >> 1;
+    DROP(3);
+    if (sym == 0) {
+      // stored block, so give back the whole bytes left in bit buffer
+      DROP(bl & 7);
+      if ((bl >> 3) < pad)
+        return -1;
+      ip -= (bl >> 3) - pad;
+      bb = bl = pad = 0;
+      if (ie - ip < 4)
+        return -1;
+      len = READ16LE(ip);
+      if (len != (~READ16LE(ip + 2) & 0xffff))
+        return -1;
+      ip += 4;
+      if (len > ie - ip || len > oe - op)
+        return -1;
+      op = mempcpy(op, ip, len);
+      ip += len;
+      continue;
+    } else if (sym == 1) {
+      memset(lens, 8, 144);
+      memset(lens + 144, 9, 256 - 144);
+      memset(lens + 256, 7, 280 - 256);
+      memset(lens + 280, 8, 288 - 280);
+      memset(lens + 288, 5, 30);
+      BuildTable(litlen, LITLEN_BITS, lens, 288, GetLitlenResult, false);
+      BuildTable(dists, DIST_BITS, lens + 288, 30, GetDistResult, true);
+    } else if (sym == 2) {
+      REFILL();
+      nlen = BITS(5) + 257;
+      ndist = (bb >> 5 & 31) + 1;
+      n = (bb >> 10 & 15) + 4;
+      DROP(14);
+      if (nlen > 286 || ndist > 30)
+        return -1;
+      memset(lens, 0, 19);
+      for (i = 0; i < n; ++i) {
+        REFILL();
+        lens[kPrecodeOrder[i]] = BITS(3);
+        DROP(3);
+      }
+      if (!BuildTable(precode, PRECODE_BITS, lens, 19, GetPrecodeResult,
+                      false))
+        return -1;
+      for (n = nlen + ndist, i = 0; i < n;) {
+        REFILL();
+        e = precode[BITS(PRECODE_BITS)];
+        DROP(e & 255);
+        if ((sym = e >> 16) < 16) {
+          lens[i++] = sym;
+          continue;
+        } else if (sym == 16) {
+          if (!i)
+            return -1;
+          sym = lens[i - 1];
+          rep = 3 + BITS(2);
+          DROP(2);
+        } else if (sym == 17) {
+          sym = 0;
+          rep = 3 + BITS(3);
+          DROP(3);
+        } else {
+          sym = 0;
+          rep = 11 + BITS(7);
+          DROP(7);
+        }
+        if (rep > n - i)
+          return -1;
+        memset(lens + i, sym, rep);
+        i += rep;
+      }
+      if (!lens[256] ||
+          !BuildTable(litlen, LITLEN_BITS, lens, nlen, GetLitlenResult,
+                      false) ||
+          !BuildTable(dists, DIST_BITS, lens + nlen, ndist, GetDistResult,
+                      false))
+        return -1;
+    } else {
+      return -1;
+    }
+
+    // one refill covers 15+5 bits of length plus 15+13 bits of distance,
+    // or three literals, whose codes are never longer than the main table
+    for (;;) {
+      REFILL();
+      e = litlen[BITS(LITLEN_BITS)];
+      if (e & F_LITERAL) {
+        for (i = 0;;) {
+          DROP(e & 255);
+          if (op == oe)
+            return -1;
+          *op++ = e >> 16;
+          e = litlen[BITS(LITLEN_BITS)];
+          if (!(e & F_LITERAL) || ++i == 3)
+            break;
+        }
+        REFILL();
+        if (e & F_LITERAL)
+          continue;
+      }
+      if (e & F_SUBTABLE) {
+        DROP(LITLEN_BITS);
+        e = litlen[(e >> 16) + BITS(e >> 8 & 15)];
+      }
+      if (e & F_LITERAL) {
+        DROP(e & 255);
+        if (op == oe)
+          return -1;
+        *op++ = e >> 16;
+        continue;
+      }
+      if (e & F_END) {
+        DROP(e & 255);
+        break;
+      }
+      if (!(e & F_LENGTH))
+        return -1;
+      // extra bits come right after the code, so take both at once
+      n = (e & 255) + (e >> 8 & 15);
+      len = (e >> 16) + (BITS(n) >> (e & 255));
+      DROP(n);
+      e = dists[BITS(DIST_BITS)];
+      if (e & F_SUBTABLE) {
+        DROP(DIST_BITS);
+        e = dists[(e >> 16) + BITS(e >> 8 & 15)];
+      }
+      if (!(e & F_LENGTH))
+        return -1;
+      n = (e & 255) + (e >> 8 & 15);
+      dist = (e >> 16) + (BITS(n) >> (e & 255));
+      DROP(n);
+      if (dist > op - (uint8_t *)out || len > oe - op)
+        return -1;
+      src = op - dist;
+      end = op + len;
+      if (dist >= 8 && oe - end >= 8) {
+        // chunks may overshoot, which later writes will fix up
+        do {
+          memcpy(op, src, 8);
+          op += 8;
+          src += 8;
+        } while (op < end);
+        op = end;
+      } else if (dist == 1) {
+        memset(op, *src, len);
+        op = end;
+      } else {
+        do
+          *op++ = *src++;
+        while (op < end);
+      }
+    }
+  } while (!final);
+
+  // fail if zeroes we made up were consumed
+  return pad > (bl >> 3);
+}
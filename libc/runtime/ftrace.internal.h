@@ -0,0 +1,37 @@
+#ifndef COSMOPOLITAN_LIBC_RUNTIME_FTRACE_INTERNAL_H_
+#define COSMOPOLITAN_LIBC_RUNTIME_FTRACE_INTERNAL_H_
+COSMOPOLITAN_C_START_
+
+#define FTRACE_RING_MAGIC   0x42525446 /* FTRB */
+#define FTRACE_RING_ABI     1
+#define FTRACE_RING_RECORDS 4194304 /* default capacity (64mb) */
+
+/* one function call, as recorded by --ftrace when FTRACE_RING is set */
+struct FtraceRecord {
+  uint64_t tsc_depth; /* tsc since `tsc_base` << 16 | nesting level */
+  uint32_t addr;      /* function address relative to `addr_base` */
+  uint32_t tid;       /* thread id */
+};
+
+/* header of memory mapped ring buffer file, followed by records */
+struct FtraceRing {
+  uint32_t magic;              /* FTRACE_RING_MAGIC */
+  uint32_t abi;                /* FTRACE_RING_ABI */
+  uint64_t capacity;           /* number of records, power of two */
+  _Atomic(uint64_t) head;      /* number of records ever written */
+  int64_t addr_base;           /* of symbol table */
+  uint64_t tsc_base;           /* kStartTsc of the tracing process */
+  int32_t pid;                 /* of the tracing process */
+  uint32_t reserved[5];        /* pads header to 64 bytes */
+  struct FtraceRecord records[];
+};
+
+extern int __ftrace_sample;
+extern int __ftrace_maxdepth;
+extern struct FtraceRing *__ftrace_ring;
+
+int __ftrace_install(const char *);
+struct FtraceRing *ftrace_ring_open(const char *, size_t);
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_LIBC_RUNTIME_FTRACE_INTERNAL_H_ */
@@ -18,17 +18,89 @@
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/calls/calls.h"
 #include "libc/fmt/itoa.h"
+#include "libc/runtime/ftrace.internal.h"
 #include "libc/runtime/internal.h"
 #include "libc/runtime/runtime.h"
 #include "libc/runtime/stack.h"
 #include "libc/runtime/symbols.internal.h"
 
-textstartup int ftrace_install(void) {
-  if (GetSymbolTable()) {
-    ftrace_stackdigs = LengthInt64Thousands(GetStackSize());
-    return __hook(ftrace_hook, GetSymbolTable());
-  } else {
+// returns true if name matches pattern, where `*` matches anything
+static textstartup bool MatchGlob(const char *p, const char *pe,
+                                  const char *s) {
+  const char *star = 0, *back = 0;
+  while (*s) {
+    if (p < pe && *p == '*') {
+      star = ++p;
+      back = s;
+    } else if (p < pe && *p == *s) {
+      ++p;
+      ++s;
+    } else if (star) {
+      p = star;
+      s = ++back;
+    } else {
+      return false;
+    }
+  }
+  while (p < pe && *p == '*')
+    ++p;
+  return p == pe;
+}
+
+// returns true if name is selected by comma separated glob patterns,
+// where patterns starting with `-` exclude names that'd be included
+static textstartup bool IsSelected(const char *patterns, const char *name) {
+  const char *p, *pe;
+  bool exclude, included = false, anyinclude = false;
+  for (p = patterns; *p; p = *pe ? pe + 1 : pe) {
+    for (pe = p; *pe && *pe != ',';)
+      ++pe;
+    if ((exclude = *p == '-'))
+      ++p;
+    if (p == pe)
+      continue;
+    if (exclude) {
+      if (MatchGlob(p, pe, name))
+        return false;
+    } else {
+      anyinclude = true;
+      included |= MatchGlob(p, pe, name);
+    }
+  }
+  return included || !anyinclude;
+}
+
+/**
+ * Installs function call logging hooks.
+ *
+ * @param patterns may be null to hook all functions, or a comma
+ *     separated list of globs like `Lua*,-Lua_gc*` in which case only
+ *     selected functions are hooked, so the others have no overhead
+ * @return 0 on success, or -1 on error
+ */
+textstartup int __ftrace_install(const char *patterns) {
+  int rc;
+  uint64_t *select;
+  size_t i, selectsize;
+  struct SymbolTable *st;
+  if (!(st = GetSymbolTable())) {
     tinyprint(2, "error: --ftrace failed to open symbol table\n", NULL);
     return -1;
   }
+  ftrace_stackdigs = LengthInt64Thousands(GetStackSize());
+  if (!patterns)
+    return __hook(ftrace_hook, st, 0);
+  selectsize = (st->count + 63) / 64 * sizeof(uint64_t);
+  if (!(select = _mapanon(selectsize)))
+    return -1;
+  for (i = 0; i < st->count; ++i)
+    if (IsSelected(patterns, __get_symbol_name(st, i)))
+      select[i / 64] |= 1ull << (i % 64);
+  rc = __hook(ftrace_hook, st, select);
+  munmap(select, selectsize);
+  return rc;
+}
+
+textstartup int ftrace_install(void) {
+  return __ftrace_install(0);
 }
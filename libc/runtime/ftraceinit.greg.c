@@ -16,7 +16,10 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
 #include "libc/dce.h"
+#include "libc/fmt/conv.h"
+#include "libc/runtime/ftrace.internal.h"
 #include "libc/runtime/internal.h"
 #include "libc/runtime/runtime.h"
 #include "libc/runtime/symbols.internal.h"
@@ -25,6 +28,33 @@
 
 __static_yoink("zipos");
 
+// removes first `--ftrace=PATTERNS` argument and returns its value
+static textstartup const char *ftrace_intercept_patterns(void) {
+  int i, j;
+  const char *a, *f;
+  for (i = 1; i < __argc; ++i) {
+    for (a = __argv[i], f = "--ftrace="; *f && *a == *f; ++a, ++f) {
+    }
+    if (!*f) {
+      for (j = i; j < __argc; ++j)
+        __argv[j] = __argv[j + 1];
+      --__argc;
+      return a;
+    }
+  }
+  return 0;
+}
+
+static textstartup void ftrace_init_ring(void) {
+  const char *path, *records;
+  if (!(path = getenv("FTRACE_RING")))
+    return;
+  records = getenv("FTRACE_RING_RECORDS");
+  if (!(__ftrace_ring = ftrace_ring_open(
+            path, records ? atol(records) : FTRACE_RING_RECORDS)))
+    tinyprint(2, "error: --ftrace failed to create ", path, "\n", NULL);
+}
+
 /**
  * Enables plaintext function tracing if `--ftrace` flag is passed.
  *
@@ -35,14 +65,33 @@ __static_yoink("zipos");
  * `sed | sort | uniq -c | sort`. A compressed trace can be made by
  * appending `--ftrace 2>&1 | gzip -4 >trace.gz` to the CLI arguments.
  *
+ * Formatting text slows programs down quite a bit. If the environment
+ * variable `FTRACE_RING=PATH` is defined, then calls are instead logged
+ * as binary records into a file that's a ring buffer holding the most
+ * recent calls. `FTRACE_RING_RECORDS` may be used to change capacity.
+ * Use `o//tool/decode/ftrace` to turn it into text or a chrome trace.
+ *
+ * Tracing may be narrowed by passing `--ftrace=PATTERNS` instead, where
+ * PATTERNS is a comma separated list of globs, e.g. `Lua*,-Lua_gc*`,
+ * which chooses the functions that get hooked, so the rest run at full
+ * speed. `FTRACE_SAMPLE=N` logs only one in every N calls, and setting
+ * `FTRACE_DEPTH=N` ignores calls nested more than N levels deep.
+ *
  * @see libc/runtime/_init.S for documentation
  */
 textstartup int ftrace_init(void) {
+  const char *patterns = 0, *s;
   if (IsModeDbg() || strace_enabled(0) > 0) {
     GetSymbolTable();
   }
-  if (__intercept_flag(&__argc, __argv, "--ftrace")) {
-    ftrace_install();
+  if (__intercept_flag(&__argc, __argv, "--ftrace") ||
+      (patterns = ftrace_intercept_patterns())) {
+    if ((s = getenv("FTRACE_SAMPLE")))
+      __ftrace_sample = atoi(s);
+    if ((s = getenv("FTRACE_DEPTH")))
+      __ftrace_maxdepth = atoi(s);
+    if (!__ftrace_install(patterns))
+      ftrace_init_ring();
     ftrace_enabled(+1);
   }
   return __argc;
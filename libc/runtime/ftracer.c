@@ -19,10 +19,13 @@
 #include "libc/calls/calls.h"
 #include "libc/errno.h"
 #include "libc/fmt/itoa.h"
+#include "libc/intrin/atomic.h"
 #include "libc/intrin/cmpxchg.h"
 #include "libc/intrin/kprintf.h"
 #include "libc/macros.h"
+#include "libc/nexgen32e/rdtsc.h"
 #include "libc/nexgen32e/stackframe.h"
+#include "libc/runtime/ftrace.internal.h"
 #include "libc/runtime/internal.h"
 #include "libc/runtime/runtime.h"
 #include "libc/runtime/stack.h"
@@ -31,7 +34,7 @@
 #include "libc/thread/tls.h"
 
 /**
- * @fileoverview plain-text function call logging
+ * @fileoverview plain-text or binary function call logging
  */
 
 #define MAX_NESTING 512
@@ -42,7 +45,11 @@
 #define DETOUR_SKEW 8
 #endif
 
+int __ftrace_sample;    // log one in every n calls if >1
+int __ftrace_maxdepth;  // ignore calls nested deeper if >0
+
 static struct CosmoFtrace g_ftrace;
+static _Atomic(unsigned) g_ftrace_calls;
 
 __funline int GetNestingLevelImpl(struct StackFrame *frame) {
   int nesting = -1;
@@ -62,6 +69,29 @@ __funline int GetNestingLevel(struct CosmoFtrace *ft, struct StackFrame *sf) {
   return MIN(MAX_NESTING, nesting);
 }
 
+// returns true if call should be logged when sampling. the counter is
+// shared by threads and isn't incremented atomically, since it doesn't
+// matter if a few calls are skipped, but bouncing cache lines would.
+forceinline bool IsSampled(unsigned n) {
+  unsigned i = atomic_load_explicit(&g_ftrace_calls, memory_order_relaxed);
+  if (++i >= n)
+    i = 0;
+  atomic_store_explicit(&g_ftrace_calls, i, memory_order_relaxed);
+  return !i;
+}
+
+// appends binary record to memory mapped ring buffer file
+__funline void LogFunctionCall(struct FtraceRing *ring, uintptr_t fn,
+                               int depth, struct CosmoTib *tib) {
+  int tid = tib ? atomic_load_explicit(&tib->tib_ptid, memory_order_relaxed)
+                : 0;
+  uint64_t i = atomic_fetch_add_explicit(&ring->head, 1, memory_order_relaxed);
+  struct FtraceRecord *r = ring->records + (i & (ring->capacity - 1));
+  r->tsc_depth = (rdtsc() - ring->tsc_base) << 16 | depth;
+  r->addr = fn - ring->addr_base;
+  r->tid = tid;
+}
+
 /**
  * Prints name of function being called.
  *
@@ -72,6 +102,7 @@ __funline int GetNestingLevel(struct CosmoFtrace *ft, struct StackFrame *sf) {
  * @see ftrace_install()
  */
 __privileged void ftracer(void) {
+  int depth;
   long stackuse;
   uintptr_t fn, st;
   struct CosmoTib *tib;
@@ -84,6 +115,8 @@ __privileged void ftracer(void) {
   st = (uintptr_t)__argv - sizeof(uintptr_t);
   if (__ftrace <= 0)
     return;
+  if (__ftrace_sample > 1 && !IsSampled(__ftrace_sample))
+    return;
 
   // determine top of stack
   // main thread won't consider kernel provided argblock
@@ -133,8 +166,15 @@ __privileged void ftracer(void) {
   sf = sf->next;
   fn = sf->addr + DETOUR_SKEW;
   if (fn != ft->ft_lastaddr) {
-    kprintf("%rFUN %7P %7H %'18T %'*ld %*s%t\n", ftrace_stackdigs, stackuse,
-            GetNestingLevel(ft, sf) * 2, "", fn);
+    depth = GetNestingLevel(ft, sf);
+    if (__ftrace_maxdepth > 0 && depth > __ftrace_maxdepth)
+      return;
+    if (__ftrace_ring) {
+      LogFunctionCall(__ftrace_ring, fn, depth, __tls_enabled ? tib : 0);
+    } else {
+      kprintf("%rFUN %7P %7H %'18T %'*ld %*s%t\n", ftrace_stackdigs,
+              stackuse, depth * 2, "", fn);
+    }
     ft->ft_lastaddr = fn;
   }
 }
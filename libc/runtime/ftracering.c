@@ -0,0 +1,70 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/runtime/ftrace.internal.h"
+#include "libc/runtime/runtime.h"
+#include "libc/runtime/symbols.internal.h"
+#include "libc/sysv/consts/map.h"
+#include "libc/sysv/consts/o.h"
+#include "libc/sysv/consts/prot.h"
+
+struct FtraceRing *__ftrace_ring;
+
+/**
+ * Creates file for logging function calls in binary.
+ *
+ * The file is mapped into memory as a ring buffer of fixed size which
+ * `--ftrace` writes to without any system calls or formatting, so the
+ * most recent calls survive even if the process crashes or is killed.
+ * Forked children share the same buffer. It may be decoded using the
+ * `o//tool/decode/ftrace` program.
+ *
+ * @param path is name of file to create, which is truncated
+ * @param records is capacity, which is rounded up to a two power
+ * @return ring buffer, or null w/ errno
+ */
+textstartup struct FtraceRing *ftrace_ring_open(const char *path,
+                                                size_t records) {
+  int fd;
+  size_t size;
+  struct FtraceRing *ring;
+  struct SymbolTable *st;
+  if (records < 2)
+    records = 2;
+  if (records & (records - 1))
+    records = 2ul << (63 - __builtin_clzl(records));
+  size = sizeof(struct FtraceRing) + records * sizeof(struct FtraceRecord);
+  if ((fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) == -1)
+    return 0;
+  if (ftruncate(fd, size) ||
+      (ring = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) ==
+          MAP_FAILED) {
+    close(fd);
+    return 0;
+  }
+  close(fd);
+  st = GetSymbolTable();
+  ring->magic = FTRACE_RING_MAGIC;
+  ring->abi = FTRACE_RING_ABI;
+  ring->capacity = records;
+  ring->addr_base = st ? st->addr_base : 0;
+  ring->tsc_base = kStartTsc;
+  ring->pid = getpid();
+  return ring;
+}
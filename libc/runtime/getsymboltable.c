@@ -19,6 +19,8 @@
 #include "ape/sections.internal.h"
 #include "libc/assert.h"
 #include "libc/atomic.h"
+#include "libc/calls/calls.h"
+#include "libc/calls/struct/stat.h"
 #include "libc/cosmo.h"
 #include "libc/errno.h"
 #include "libc/intrin/promises.h"
@@ -30,6 +32,9 @@
 #include "libc/runtime/symbols.internal.h"
 #include "libc/runtime/zipos.internal.h"
 #include "libc/str/str.h"
+#include "libc/sysv/consts/map.h"
+#include "libc/sysv/consts/o.h"
+#include "libc/sysv/consts/prot.h"
 #include "libc/x/x.h"
 #include "libc/zip.h"
 #include "third_party/puff/puff.h"
@@ -52,6 +57,48 @@ static ssize_t GetZipFile(struct Zipos *zipos, const char *name) {
   return -1;
 }
 
+static void RelocateSymbolTable(struct SymbolTable *t) {
+  t->names = (uint32_t *)((char *)t + t->names_offset);
+  t->name_base = (char *)((char *)t + t->name_base_offset);
+}
+
+/**
+ * Maps uncompressed symbol table straight from the executable.
+ *
+ * This avoids copying or inflating anything, and lets the pages which
+ * hold the symbols and names be shared with the page cache across all
+ * processes running the same program. Only the page with the header
+ * becomes private, since its pointers need to be relocated.
+ */
+static struct SymbolTable *MapSymbolTable(struct Zipos *zipos, size_t off,
+                                          size_t size) {
+  int fd;
+  char *map;
+  size_t skew;
+  struct stat st;
+  struct SymbolTable *res = 0;
+  if (!zipos->path || size < sizeof(struct SymbolTable))
+    return 0;
+  if ((fd = open(zipos->path, O_RDONLY | O_CLOEXEC)) == -1)
+    return 0;
+  skew = off & (__gransize - 1);
+  if (!fstat(fd, &st) && st.st_ino == zipos->dev &&
+      (map = mmap(0, skew + size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                  off - skew)) != MAP_FAILED) {
+    res = (struct SymbolTable *)(map + skew);
+    if (res->magic == SYMBOLS_MAGIC && res->size <= size &&
+        res->names_offset < size && res->name_base_offset < size) {
+      RelocateSymbolTable(res);
+      mprotect(map, skew + size, PROT_READ);
+    } else {
+      munmap(map, skew + size);
+      res = 0;
+    }
+  }
+  close(fd);
+  return res;
+}
+
 /**
  * Reads symbol table from zip directory.
  * @note This code can't depend on dlmalloc()
@@ -59,29 +106,35 @@ static ssize_t GetZipFile(struct Zipos *zipos, const char *name) {
 static struct SymbolTable *GetSymbolTableFromZip(struct Zipos *zipos) {
   size_t size;
   ssize_t cf, lf;
+  const uint8_t *content;
   struct SymbolTable *res = 0;
   if ((cf = GetZipFile(zipos, ".symtab." _ARCH_NAME)) != -1 ||
       (cf = GetZipFile(zipos, ".symtab")) != -1) {
     lf = GetZipCfileOffset(zipos->map + cf);
     size = GetZipLfileUncompressedSize(zipos->map + lf);
-    if ((res = _mapanon(size))) {
-      switch (ZIP_LFILE_COMPRESSIONMETHOD(zipos->map + lf)) {
-        case kZipCompressionNone:
-          memcpy(res, (void *)ZIP_LFILE_CONTENT(zipos->map + lf), size);
+    content = ZIP_LFILE_CONTENT(zipos->map + lf);
+    switch (ZIP_LFILE_COMPRESSIONMETHOD(zipos->map + lf)) {
+      case kZipCompressionNone:
+        if ((res = MapSymbolTable(zipos, content - zipos->map, size)))
           break;
-        case kZipCompressionDeflate:
-          if (__inflate((void *)res, size,
-                        (void *)ZIP_LFILE_CONTENT(zipos->map + lf),
-                        GetZipLfileCompressedSize(zipos->map + lf))) {
+        if ((res = _mapanon(size))) {
+          memcpy(res, content, size);
+          RelocateSymbolTable(res);
+        }
+        break;
+      case kZipCompressionDeflate:
+        if ((res = _mapanon(size))) {
+          if (!__inflate((void *)res, size, content,
+                         GetZipLfileCompressedSize(zipos->map + lf))) {
+            RelocateSymbolTable(res);
+          } else {
             munmap(res, size);
             res = 0;
           }
-          break;
-        default:
-          munmap(res, size);
-          res = 0;
-          break;
-      }
+        }
+        break;
+      default:
+        break;
     }
   }
   STRACE("GetSymbolTableFromZip() → %p", res);
@@ -105,14 +158,8 @@ static void GetSymbolTableInit(void) {
   struct Zipos *z;
   int e = errno;
   if (!__symtab && !__isworker) {
-    if (_weaken(__zipos_get) && (z = _weaken(__zipos_get)())) {
-      if ((__symtab = GetSymbolTableFromZip(z))) {
-        __symtab->names =
-            (uint32_t *)((char *)__symtab + __symtab->names_offset);
-        __symtab->name_base =
-            (char *)((char *)__symtab + __symtab->name_base_offset);
-      }
-    }
+    if (_weaken(__zipos_get) && (z = _weaken(__zipos_get)()))
+      __symtab = GetSymbolTableFromZip(z);
     if (!__symtab) {
       __symtab = GetSymbolTableFromElf();
     }
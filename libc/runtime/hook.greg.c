@@ -110,9 +110,12 @@ __privileged static void HookFunction(code_t *func, void *dest) {
  *     must be sufficiently close in memory to the the program image, in
  *     order to meet ISA displacement requirements
  * @param st can be obtained using `GetSymbolTable()`
+ * @param select is optional bitmap of symbol table indices, in which
+ *     case only functions whose bit is set will be hooked
  * @see ape/ape.lds
  */
-__privileged int __hook(void *dest, struct SymbolTable *st) {
+__privileged int __hook(void *dest, struct SymbolTable *st,
+                        const uint64_t *select) {
   long i;
   code_t *p, *pe;
   intptr_t lowest;
@@ -124,6 +127,8 @@ __privileged int __hook(void *dest, struct SymbolTable *st) {
   for (i = 0; i < st->count; ++i) {
     if (st->symbols[i].x < 9)
       continue;
+    if (select && !(select[i / 64] >> (i % 64) & 1))
+      continue;
     if (st->addr_base + st->symbols[i].x < lowest)
       continue;
     if (st->addr_base + st->symbols[i].y >= (intptr_t)__privileged_start)
@@ -29,6 +29,13 @@
  *
  * This uses puff by default since it has a 2kb footprint. If zlib
  * proper is linked, then we favor that instead, since it's faster.
+ * Programs that don't want zlib's weight can say
+ *
+ *     __static_yoink("__fastinflate");
+ *
+ * to get a table driven decoder that's about five times as fast as
+ * puff, which is then used before either of the others, since it also
+ * doesn't need malloc().
  *
  * @param outsize needs to be known ahead of time by some other means
  * @return 0 on success or nonzero on failure
@@ -36,10 +43,12 @@
 int __inflate(void *out, size_t outsize, const void *in, size_t insize) {
   int rc;
   z_stream zs;
-  if (_weaken(inflateInit2) &&  //
-      _weaken(inflate) &&       //
-      _weaken(inflateEnd) &&    //
-      __runlevel >= RUNLEVEL_MALLOC) {
+  if (_weaken(__fastinflate)) {
+    rc = _weaken(__fastinflate)(out, outsize, in, insize);
+  } else if (_weaken(inflateInit2) &&  //
+             _weaken(inflate) &&       //
+             _weaken(inflateEnd) &&    //
+             __runlevel >= RUNLEVEL_MALLOC) {
     zs.next_in = in;
     zs.avail_in = insize;
     zs.total_in = insize;
@@ -0,0 +1,60 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/intrin/strace.h"
+#include "libc/nexgen32e/rdtsc.h"
+#include "libc/runtime/internal.h"
+#include "libc/runtime/runtime.h"
+
+typedef void init_f(int, char **, char **, unsigned long *);
+
+extern init_f *__init_array_start[] __attribute__((__weak__));
+extern init_f *__init_array_end[] __attribute__((__weak__));
+
+/**
+ * Calls static constructors, before main() is called.
+ *
+ * If `--strace` or `STRACE=1` is in play, then how long each one took
+ * is logged, followed by a summary of how much time elapsed since the
+ * process started. That's useful for finding out what's slowing down
+ * the startup of programs that are run many times by shell scripts.
+ * Addresses may be resolved using `cosmoaddr2line` if your executable
+ * hasn't loaded its symbol table yet. Times are in nanoseconds, using
+ * the same estimate as the timestamps printed by kprintf() `%T`.
+ */
+textstartup dontinstrument void __call_init_array(int argc, char **argv,
+                                                  char **envp,
+                                                  unsigned long *auxv) {
+  init_f **fp;
+  uint64_t t1, t2, t3;
+  if (!SYSDEBUG || strace_enabled(0) <= 0) {
+    for (fp = __init_array_start; fp < __init_array_end; ++fp)
+      (*fp)(argc, argv, envp, auxv);
+    return;
+  }
+  t3 = t1 = rdtsc();
+  for (fp = __init_array_start; fp < __init_array_end; ++fp) {
+    t2 = rdtsc();
+    (*fp)(argc, argv, envp, auxv);
+    t3 = rdtsc();
+    STRACE("startup: %t took %'lu ns", *fp, (t3 - t2) / 3);
+  }
+  STRACE("startup: %'lu ns in %d constructors, %'lu ns since process start",
+         (t3 - t1) / 3, (int)(__init_array_end - __init_array_start),
+         (t3 - kStartTsc) / 3);
+}
@@ -35,8 +35,10 @@ int GetDosArgv(const char16_t *, char *, size_t, char **, size_t);
 int GetDosEnviron(const char16_t *, char *, size_t, char **, size_t);
 bool __intercept_flag(int *, char *[], const char *);
 int __inflate(void *, size_t, const void *, size_t);
+int __fastinflate(void *, size_t, const void *, size_t);
 void __on_arithmetic_overflow(void);
 void __init_program_executable_name(void);
+void __call_init_array(int, char **, char **, unsigned long *);
 
 COSMOPOLITAN_C_END_
 #endif /* ANSI */
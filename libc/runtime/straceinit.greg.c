@@ -17,18 +17,51 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/calls/calls.h"
+#include "libc/calls/struct/sigaction.h"
+#include "libc/intrin/strace.h"
 #include "libc/intrin/getenv.h"
 #include "libc/intrin/safemacros.h"
 #include "libc/log/libfatal.internal.h"
 #include "libc/runtime/internal.h"
 #include "libc/runtime/runtime.h"
+#include "libc/sysv/consts/sa.h"
+#include "libc/sysv/consts/sig.h"
+
+static void __strace_summary_onsig(int sig) {
+  __strace_summary_print();
+}
+
+__attribute__((__constructor__(90))) static void __strace_summary_init(void) {
+  if (!__strace_summary)
+    return;
+  atexit(__strace_summary_print);
+  sigaction(SIGUSR2,
+            &(struct sigaction){.sa_handler = __strace_summary_onsig,
+                                .sa_flags = SA_RESTART},
+            0);
+}
 
 /**
  * Enables plaintext system call logging  if `--strace` flag is passed.
+ *
+ * If the `--strace-summary` flag is passed, or `STRACE_SUMMARY=1` is in
+ * the environment, then traced calls are tallied rather than printed,
+ * and a table of their counts, errors, and latencies is printed to
+ * stderr on exit, or whenever the process is sent `SIGUSR2`. This is a
+ * portable alternative to `strace -c` that perturbs timing less, since
+ * no i/o is performed while tracing.
  */
 textstartup int __strace_init(int argc, char **argv, char **envp, long *auxv) {
-  if (__intercept_flag(&argc, argv, "--strace") ||
-      __atoul(nulltoempty(__getenv(envp, "STRACE").s)))
+  if (__intercept_flag(&argc, argv, "--strace-summary") ||
+      __atoul(nulltoempty(__getenv(envp, "STRACE_SUMMARY").s))) {
+    __strace_summary = true;
+#ifdef __x86_64__
+    __systrace_install();
+#endif
+    strace_enabled(+1);
+  } else if (__intercept_flag(&argc, argv, "--strace") ||
+             __atoul(nulltoempty(__getenv(envp, "STRACE").s))) {
     strace_enabled(+1);
+  }
   return (__argc = argc);
 }
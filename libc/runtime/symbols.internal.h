@@ -28,10 +28,11 @@ struct SymbolTable {
 struct SymbolTable *GetSymbolTable(void);
 const char *FindComBinary(void);
 const char *FindDebugBinary(void);
+const char *FindDebugBinaryCached(void);
 const char *FindDebugBinaryFor(const char *, char *, size_t);
 struct SymbolTable *OpenSymbolTable(const char *);
 int CloseSymbolTable(struct SymbolTable **);
-int __hook(void *, struct SymbolTable *);
+int __hook(void *, struct SymbolTable *, const uint64_t *);
 int __get_symbol(struct SymbolTable *, intptr_t);
 char *__get_symbol_name(struct SymbolTable *, int);
 
@@ -0,0 +1,208 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/calls/struct/sigset.internal.h"
+#include "libc/intrin/atomic.h"
+#include "libc/intrin/dll.h"
+#include "libc/runtime/internal.h"
+#include "libc/runtime/runtime.h"
+#include "libc/runtime/zipos.internal.h"
+#include "libc/sysv/consts/map.h"
+#include "libc/sysv/consts/prot.h"
+#include "libc/sysv/errfuns.h"
+#include "libc/thread/thread.h"
+#include "libc/zip.h"
+
+/**
+ * @fileoverview Cache of decompressed zipos file content.
+ *
+ * Programs like Python and redbean tend to open the same compressed
+ * assets over and over again. Handles therefore share the decompressed
+ * content of each file, which is looked up by its central directory
+ * offset. Content is kept around after its last handle is closed, so
+ * opening it again costs nothing, until the idle content exceeds the
+ * cache budget, at which point the least recently opened is unmapped.
+ */
+
+#define kZiposCacheBudget  (64 * 1024 * 1024)
+#define kZiposCacheBuckets 256
+
+static struct {
+  pthread_mutex_t lock;
+  struct Dll *lru;
+  size_t idle;
+  struct ZiposContent *table[kZiposCacheBuckets];
+} __zipos_cache = {
+    PTHREAD_MUTEX_INITIALIZER,
+};
+
+static struct ZiposContent **__zipos_bucket(size_t cf) {
+  return __zipos_cache.table + (cf * 0x9e3779b97f4a7c15 >> 56);
+}
+
+static struct ZiposContent *__zipos_lookup(size_t cf) {
+  struct ZiposContent *c;
+  for (c = *__zipos_bucket(cf); c; c = c->hnext)
+    if (c->cfile == cf)
+      return c;
+  return 0;
+}
+
+static void __zipos_retain(struct ZiposContent *c) {
+  if (!c->refs++)
+    __zipos_cache.idle -= c->cost;
+  dll_remove(&__zipos_cache.lru, &c->elem);
+  dll_make_first(&__zipos_cache.lru, &c->elem);
+}
+
+static void __zipos_free(struct ZiposContent *c) {
+  if (c->stream)
+    __zipos_stream_close(c);
+  pthread_mutex_destroy(&c->lock);
+  munmap(c, c->mapsize);
+}
+
+static void __zipos_evict(void) {
+  struct Dll *e, *e2;
+  struct ZiposContent *c, **p;
+  for (e = dll_last(__zipos_cache.lru);
+       e && __zipos_cache.idle > kZiposCacheBudget; e = e2) {
+    e2 = dll_prev(__zipos_cache.lru, e);
+    c = DLL_CONTAINER(struct ZiposContent, elem, e);
+    if (c->refs)
+      continue;
+    p = __zipos_bucket(c->cfile);
+    while (*p != c)
+      p = &(*p)->hnext;
+    *p = c->hnext;
+    dll_remove(&__zipos_cache.lru, e);
+    __zipos_cache.idle -= c->cost;
+    __zipos_free(c);
+  }
+}
+
+static struct ZiposContent *__zipos_content_new(struct Zipos *zipos,
+                                                size_t cf) {
+  int method;
+  size_t lf, size, insize, mapsize;
+  const uint8_t *in;
+  struct ZiposContent *c;
+  lf = GetZipCfileOffset(zipos->map + cf);
+  size = GetZipLfileUncompressedSize(zipos->map + lf);
+  in = ZIP_LFILE_CONTENT(zipos->map + lf);
+  insize = GetZipLfileCompressedSize(zipos->map + lf);
+  mapsize = sizeof(struct ZiposContent) + size;
+  if ((c = mmap(0, mapsize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                -1, 0)) == MAP_FAILED)
+    return 0;
+  dll_init(&c->elem);
+  pthread_mutex_init(&c->lock, 0);
+  c->cfile = cf;
+  c->size = size;
+  c->mapsize = mapsize;
+  // the memory is reserved for the whole file, but pages are only
+  // committed once read() inflates its way up to them
+  method = ZIP_LFILE_COMPRESSIONMETHOD(zipos->map + lf);
+  if (!__zipos_stream_open(c, method, in, insize))
+    return c;
+  if (method == kZipCompressionZstd ? !__zipos_unzstd(c->data, size, in, insize)
+                                    : !__inflate(c->data, size, in, insize)) {
+    c->ready = size;
+    return c;
+  }
+  __zipos_free(c);
+  eio();
+  return 0;
+}
+
+/**
+ * Returns decompressed content of zip file, inflating it if needed.
+ *
+ * @param cf is central directory offset of DEFLATE or zstd compressed file
+ * @return content with reference added, or null w/ errno
+ */
+struct ZiposContent *__zipos_content_acquire(struct Zipos *zipos, size_t cf) {
+  struct ZiposContent *c, *c2;
+  BLOCK_SIGNALS;
+  pthread_mutex_lock(&__zipos_cache.lock);
+  if ((c = __zipos_lookup(cf)))
+    __zipos_retain(c);
+  pthread_mutex_unlock(&__zipos_cache.lock);
+  ALLOW_SIGNALS;
+  if (c)
+    return c;
+  // don't hold the cache lock while inflating
+  if (!(c = __zipos_content_new(zipos, cf)))
+    return 0;
+  BLOCK_SIGNALS;
+  pthread_mutex_lock(&__zipos_cache.lock);
+  if ((c2 = __zipos_lookup(cf))) {
+    // another thread opened the same file at the same time
+    __zipos_retain(c2);
+  } else {
+    c->hnext = *__zipos_bucket(cf);
+    *__zipos_bucket(cf) = c;
+    __zipos_retain(c);
+  }
+  pthread_mutex_unlock(&__zipos_cache.lock);
+  ALLOW_SIGNALS;
+  if (c2) {
+    __zipos_free(c);
+    c = c2;
+  }
+  return c;
+}
+
+/**
+ * Removes reference to content, which may be evicted from the cache.
+ */
+void __zipos_content_release(struct ZiposContent *c) {
+  BLOCK_SIGNALS;
+  pthread_mutex_lock(&__zipos_cache.lock);
+  if (!--c->refs) {
+    c->cost = atomic_load_explicit(&c->ready, memory_order_relaxed);
+    __zipos_cache.idle += c->cost;
+    __zipos_evict();
+  }
+  pthread_mutex_unlock(&__zipos_cache.lock);
+  ALLOW_SIGNALS;
+}
+
+// the cache lock is held while content locks are acquired, and both
+// are held across fork() so that inflating can resume in the child.
+void __zipos_lock(void) {
+  struct Dll *e;
+  pthread_mutex_lock(&__zipos_cache.lock);
+  for (e = dll_first(__zipos_cache.lru); e; e = dll_next(__zipos_cache.lru, e))
+    pthread_mutex_lock(&DLL_CONTAINER(struct ZiposContent, elem, e)->lock);
+}
+
+void __zipos_unlock(void) {
+  struct Dll *e;
+  for (e = dll_first(__zipos_cache.lru); e; e = dll_next(__zipos_cache.lru, e))
+    pthread_mutex_unlock(&DLL_CONTAINER(struct ZiposContent, elem, e)->lock);
+  pthread_mutex_unlock(&__zipos_cache.lock);
+}
+
+void __zipos_wipe(void) {
+  struct Dll *e;
+  for (e = dll_first(__zipos_cache.lru); e; e = dll_next(__zipos_cache.lru, e))
+    pthread_mutex_wipe_np(&DLL_CONTAINER(struct ZiposContent, elem, e)->lock);
+  pthread_mutex_wipe_np(&__zipos_cache.lock);
+}
@@ -86,16 +86,26 @@ static int __zipos_compare_names(const void *a, const void *b, void *c) {
 
 // creates binary searchable array of file offsets to cdir records
 static void __zipos_generate_index(struct Zipos *zipos) {
+  bool sorted;
   size_t c, i;
   zipos->records = GetZipCdirRecords(zipos->cdir);
   zipos->index = _mapanon(zipos->records * sizeof(size_t));
-  for (i = 0, c = GetZipCdirOffset(zipos->cdir); i < zipos->records;
-       ++i, c += ZIP_CFILE_HDRSIZE(zipos->map + c))
+  for (sorted = true, i = 0, c = GetZipCdirOffset(zipos->cdir);
+       i < zipos->records; ++i, c += ZIP_CFILE_HDRSIZE(zipos->map + c)) {
     zipos->index[i] = c;
-  // smoothsort() isn't the fastest algorithm, but it guarantees
-  // o(nlogn) won't smash the stack and doesn't depend on malloc
-  smoothsort_r(zipos->index, zipos->records, sizeof(size_t),
-               __zipos_compare_names, zipos);
+    if (sorted && i &&
+        __zipos_compare_names(zipos->index + i - 1, zipos->index + i,
+                              zipos) > 0)
+      sorted = false;
+  }
+  // the linker and apelink write the central directory sorted by name
+  // so normally there's nothing to do. if files were appended later by
+  // a tool like zip, we fall back to sorting. smoothsort() isn't the
+  // fastest algorithm, but it guarantees o(nlogn) won't smash the stack
+  // and doesn't depend on malloc
+  if (!sorted)
+    smoothsort_r(zipos->index, zipos->records, sizeof(size_t),
+                 __zipos_compare_names, zipos);
 }
 
 static void __zipos_init(void) {
@@ -104,7 +114,7 @@ static void __zipos_init(void) {
   struct stat st;
   int x, fd, err, msg;
   uint8_t *map, *cdir;
-  const char *progpath;
+  const char *progpath, *path;
   if (!(s = getenv("COSMOPOLITAN_DISABLE_ZIPOS"))) {
     // this environment variable may be a filename or file descriptor
     if ((progpath = secure_getenv("COSMOPOLITAN_INIT_ZIPOS")) &&
@@ -118,6 +128,9 @@ static void __zipos_init(void) {
         if (!progpath)
           progpath = GetProgramExecutableName();
         fd = open(progpath, O_RDONLY);
+        path = progpath;
+      } else {
+        path = 0;
       }
       if (fd != -1) {
         if (!fstat(fd, &st) && (map = mmap(0, st.st_size, PROT_READ, MAP_SHARED,
@@ -128,6 +141,7 @@ static void __zipos_init(void) {
             __zipos.map = map;
             __zipos.cdir = cdir;
             __zipos.dev = st.st_ino;
+            __zipos.path = path;
             __zipos.pagesz = pagesz;
             __zipos_generate_index(&__zipos);
             msg = kZipOk;
@@ -0,0 +1,240 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/struct/sigset.internal.h"
+#include "libc/errno.h"
+#include "libc/intrin/atomic.h"
+#include "libc/intrin/strace.h"
+#include "libc/intrin/weaken.h"
+#include "libc/limits.h"
+#include "libc/macros.h"
+#include "libc/mem/mem.h"
+#include "libc/runtime/internal.h"
+#include "libc/runtime/zipos.internal.h"
+#include "libc/sysv/errfuns.h"
+#include "libc/zip.h"
+#include "libc/thread/thread.h"
+#include "third_party/zlib/zlib.h"
+#include "third_party/zstd/zstd.h"
+
+/**
+ * @fileoverview Incremental decompression of zipos file content.
+ *
+ * Rather than inflating an entire DEFLATE entry when it's opened, we
+ * reserve memory for the uncompressed content and fill it in on demand,
+ * as read(), pread() and mmap() ask to see further into the file. Pages
+ * of anonymous memory aren't backed by physical memory until touched,
+ * so a program that only reads the header of a huge asset only pays for
+ * the parts it read. Since everything inflated so far is kept, seeking
+ * backwards is free, and seeking forwards only needs to inflate the gap.
+ * This requires zlib proper, since puff can only inflate all at once;
+ * without it, content falls back to being inflated when it's opened.
+ *
+ * Entries compressed with zstd (method 93) work the same way. There's
+ * no fallback for them in libc, so programs that embed such assets must
+ * link third_party/zstd, e.g. with `__static_yoink("ZSTD_isError")` and
+ * `__static_yoink("ZSTD_decompressStream")`, otherwise opening them
+ * fails with EIO.
+ */
+
+#define kZiposStreamMin   65536  // smaller files get inflated all at once
+#define kZiposStreamAhead 65536  // how far past the request to inflate
+
+struct ZiposStream {
+  int method;
+  z_stream zs;
+  ZSTD_DStream *zds;
+  ZSTD_inBuffer zin;
+  bool done;
+  bool failed;
+};
+
+static bool __zipos_have_zstd(void) {
+  return _weaken(ZSTD_createDStream) &&     //
+         _weaken(ZSTD_decompressStream) &&  //
+         _weaken(ZSTD_freeDStream) &&       //
+         _weaken(ZSTD_isError);
+}
+
+static bool __zipos_have_zlib(void) {
+  return _weaken(inflateInit2) &&  //
+         _weaken(inflate) &&       //
+         _weaken(inflateEnd);
+}
+
+static void __zipos_stream_end(struct ZiposStream *s) {
+  if (s->method == kZipCompressionZstd) {
+    _weaken(ZSTD_freeDStream)(s->zds);
+  } else {
+    _weaken(inflateEnd)(&s->zs);
+  }
+}
+
+/**
+ * Decompresses zstd frame all at once.
+ *
+ * @return 0 on success, or -1 w/ errno
+ */
+int __zipos_unzstd(void *out, size_t outsize, const void *in, size_t insize) {
+  size_t rc;
+  if (!_weaken(ZSTD_decompress) || !_weaken(ZSTD_isError))
+    return eio();
+  rc = _weaken(ZSTD_decompress)(out, outsize, in, insize);
+  if (_weaken(ZSTD_isError)(rc) || rc != outsize)
+    return eio();
+  return 0;
+}
+
+/**
+ * Prepares content for being inflated lazily.
+ *
+ * @param c has `size` bytes of `data` reserved for uncompressed content
+ * @param method is kZipCompressionDeflate or kZipCompressionZstd
+ * @return 0 on success, or -1 if caller should inflate it all at once
+ */
+int __zipos_stream_open(struct ZiposContent *c, int method, const void *in,
+                        size_t insize) {
+  struct ZiposStream *s;
+  if (c->size < kZiposStreamMin ||     //
+      insize > UINT_MAX ||             //
+      __runlevel < RUNLEVEL_MALLOC ||  //
+      !(method == kZipCompressionZstd ? __zipos_have_zstd()
+                                      : __zipos_have_zlib()) ||
+      !_weaken(malloc) ||  //
+      !_weaken(free))
+    return -1;
+  if (!(s = _weaken(malloc)(sizeof(*s))))
+    return -1;
+  s->method = method;
+  if (method == kZipCompressionZstd) {
+    if (!(s->zds = _weaken(ZSTD_createDStream)())) {
+      _weaken(free)(s);
+      return -1;
+    }
+    s->zin.src = in;
+    s->zin.size = insize;
+    s->zin.pos = 0;
+  } else {
+    s->zs.next_in = in;
+    s->zs.avail_in = insize;
+    s->zs.zalloc = Z_NULL;
+    s->zs.zfree = Z_NULL;
+    if (_weaken(inflateInit2)(&s->zs, -MAX_WBITS) != Z_OK) {
+      _weaken(free)(s);
+      return -1;
+    }
+  }
+  s->done = false;
+  s->failed = false;
+  c->stream = s;
+  return 0;
+}
+
+// decompresses up to `want` bytes to `out`, returning how many bytes
+// were produced, or -1 on error; `*done` is set at the end of stream
+static ssize_t __zipos_stream_step(struct ZiposStream *s, void *out,
+                                   size_t want, bool *done) {
+  int rc;
+  size_t zrc;
+  ZSTD_outBuffer zout;
+  if (s->method == kZipCompressionZstd) {
+    zout.dst = out;
+    zout.size = want;
+    zout.pos = 0;
+    zrc = _weaken(ZSTD_decompressStream)(s->zds, &zout, &s->zin);
+    if (_weaken(ZSTD_isError)(zrc)) {
+      STRACE("zipos zstd failed %zu", zrc);
+      return -1;
+    }
+    *done = !zrc;
+    return zout.pos;
+  } else {
+    s->zs.next_out = out;
+    s->zs.avail_out = want;
+    rc = _weaken(inflate)(&s->zs, Z_NO_FLUSH);
+    if (rc != Z_OK && rc != Z_STREAM_END) {
+      STRACE("zipos inflate failed %d", rc);
+      return -1;
+    }
+    *done = rc == Z_STREAM_END;
+    return want - s->zs.avail_out;
+  }
+}
+
+static int __zipos_stream_fill_impl(struct ZiposContent *c, size_t end) {
+  bool done;
+  ssize_t got;
+  size_t have, want;
+  struct ZiposStream *s = c->stream;
+  while ((have = atomic_load_explicit(&c->ready, memory_order_relaxed)) <
+         end) {
+    if (s->failed || s->done)
+      return eio();
+    want = MIN(c->size - have, ROUNDUP(end - have, kZiposStreamAhead));
+    want = MIN(want, UINT_MAX);
+    done = false;
+    got = __zipos_stream_step(s, c->data + have, want, &done);
+    if (got > 0) {
+      have += got;
+      atomic_store_explicit(&c->ready, have, memory_order_release);
+    }
+    if (done) {
+      __zipos_stream_end(s);
+      s->done = true;
+      if (have != c->size) {
+        STRACE("zipos entry inflated to %'zu bytes instead of %'zu", have,
+               c->size);
+        s->failed = true;
+      }
+    } else if (got <= 0) {
+      __zipos_stream_end(s);
+      s->failed = true;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Ensures the first `end` bytes of content have been inflated.
+ *
+ * @return 0 on success, or -1 w/ errno
+ * @asyncsignalsafe
+ */
+int __zipos_stream_fill(struct ZiposContent *c, size_t end) {
+  int rc;
+  end = MIN(end, c->size);
+  if (atomic_load_explicit(&c->ready, memory_order_acquire) >= end)
+    return 0;
+  BLOCK_SIGNALS;
+  pthread_mutex_lock(&c->lock);
+  rc = __zipos_stream_fill_impl(c, end);
+  pthread_mutex_unlock(&c->lock);
+  ALLOW_SIGNALS;
+  return rc;
+}
+
+/**
+ * Frees resources held by lazily inflated content.
+ */
+void __zipos_stream_close(struct ZiposContent *c) {
+  struct ZiposStream *s = c->stream;
+  if (!s->done && !s->failed)
+    __zipos_stream_end(s);
+  _weaken(free)(s);
+  c->stream = 0;
+}
@@ -18,14 +18,17 @@
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/calls/calls.h"
 #include "libc/calls/struct/iovec.h"
+#include "libc/calls/struct/stat.h"
 #include "libc/dce.h"
 #include "libc/errno.h"
 #include "libc/intrin/maps.h"
 #include "libc/intrin/strace.h"
+#include "libc/macros.h"
 #include "libc/runtime/internal.h"
 #include "libc/runtime/runtime.h"
 #include "libc/runtime/zipos.internal.h"
 #include "libc/sysv/consts/map.h"
+#include "libc/sysv/consts/o.h"
 #include "libc/sysv/consts/prot.h"
 #include "libc/sysv/consts/s.h"
 #include "libc/sysv/errfuns.h"
@@ -34,6 +37,42 @@
 #define IP(X)  (intptr_t)(X)
 #define VIP(X) (void *)IP(X)
 
+// maps the largest granule aligned prefix of an uncompressed file over
+// p straight from the executable, so memory can be shared with the page
+// cache rather than copied. this only works if the zip writer aligned
+// the content, e.g. `zipcopy -a`. returns number of bytes mapped, zero
+// if the caller needs to copy everything, or -1 if p was clobbered
+static ssize_t __zipos_mmap_direct(uint8_t *p, size_t size, int prot,
+                                   struct ZiposHandle *h, int64_t off) {
+  int fd;
+  size_t n;
+  ssize_t rc;
+  uint64_t fileoff;
+  struct stat st;
+  struct Zipos *z = h->zipos;
+  if (h->content || !z->path || off >= h->size)
+    return 0;
+  fileoff = h->mem - z->map + off;
+  if (fileoff & (__gransize - 1))
+    return 0;
+  if (!(n = ROUNDDOWN(MIN(size, h->size - off), __gransize)))
+    return 0;
+  if ((fd = open(z->path, O_RDONLY | O_CLOEXEC)) == -1)
+    return 0;
+  if (fstat(fd, &st) || st.st_ino != z->dev) {
+    rc = 0;  // executable was replaced since zipos was initialized
+  } else if (mmap(p, n, prot, MAP_PRIVATE | MAP_FIXED, fd, fileoff) == p) {
+    rc = n;
+  } else if (mmap(p, n, !IsXnu() ? prot | PROT_WRITE : PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) == p) {
+    rc = 0;
+  } else {
+    rc = -1;
+  }
+  close(fd);
+  return rc;
+}
+
 /**
  * Map zipos file into memory. See mmap.
  *
@@ -47,7 +86,10 @@
  *     tracking zipos mappings to prevent making it PROT_WRITE.
  * @param h is a zip store object
  * @param off specifies absolute byte index of h's file for mapping,
- *     it does not need to be 64kb aligned.
+ *     it does not need to be 64kb aligned. if the file is stored
+ *     without compression and `off` lands on a 64kb boundary of the
+ *     executable, then pages are mapped from the executable directly
+ *     instead of being copied.
  * @return virtual base address of new mapping, or MAP_FAILED w/ errno
  */
 void *__zipos_mmap(void *addr, size_t size, int prot, int flags,
@@ -83,12 +125,21 @@ void *__zipos_mmap(void *addr, size_t size, int prot, int flags,
   }
 
   do {
-    if (__zipos_read(h, &(struct iovec){outAddr, size}, 1, off) == -1) {
+    strace_enabled(-1);
+    ssize_t n = __zipos_mmap_direct(outAddr, size, prot, h, off);
+    strace_enabled(+1);
+    if (n == -1) {
+      strace_enabled(-1);
+      break;
+    } else if ((size_t)n == size) {
+      return outAddr;
+    } else if (__zipos_read(h, &(struct iovec){(char *)outAddr + n, size - n},
+                            1, off + n) == -1) {
       strace_enabled(-1);
       break;
     } else if (prot != tempProt) {
       strace_enabled(-1);
-      if (mprotect(outAddr, size, prot) == -1) {
+      if (mprotect((char *)outAddr + n, size - n, prot) == -1) {
         break;
       }
       strace_enabled(+1);
@@ -50,6 +50,8 @@ void __zipos_drop(struct ZiposHandle *h) {
   if (atomic_fetch_sub_explicit(&h->refs, 1, memory_order_release))
     return;
   atomic_thread_fence(memory_order_acquire);
+  if (h->content)
+    __zipos_content_release(h->content);
   munmap((char *)h, h->mapsize);
 }
 
@@ -129,14 +131,13 @@ static int __zipos_load(struct Zipos *zipos, size_t cf, int flags,
         h->mem = ZIP_LFILE_CONTENT(zipos->map + lf);
         break;
       case kZipCompressionDeflate:
-        if (!(h = __zipos_alloc(zipos, size)))
+      case kZipCompressionZstd:
+        if (!(h = __zipos_alloc(zipos, 0)))
           return -1;
-        if (!__inflate(h->data, size, ZIP_LFILE_CONTENT(zipos->map + lf),
-                       GetZipLfileCompressedSize(zipos->map + lf))) {
-          h->mem = h->data;
+        if ((h->content = __zipos_content_acquire(zipos, cf))) {
+          h->mem = h->content->data;
         } else {
           h->mem = 0;
-          eio();
         }
         break;
       default:
@@ -33,6 +33,7 @@
 static ssize_t __zipos_read_impl(struct ZiposHandle *h, const struct iovec *iov,
                                  size_t iovlen, ssize_t opt_offset) {
   int i;
+  size_t end;
   int64_t b, x, y, start_pos;
   if (h->cfile == ZIPOS_SYNTHETIC_DIRECTORY ||
       S_ISDIR(GetZipCfileMode(h->zipos->map + h->cfile)))
@@ -50,6 +51,15 @@ static ssize_t __zipos_read_impl(struct ZiposHandle *h, const struct iovec *iov,
   } else {
     x = y = opt_offset;
   }
+  if (h->content) {
+    for (end = x, i = 0; i < iovlen && end < h->size; ++i)
+      end += MIN(iov[i].iov_len, h->size - end);
+    if (__zipos_stream_fill(h->content, end) == -1) {
+      if (opt_offset == -1)
+        atomic_store_explicit(&h->pos, x, memory_order_release);
+      return -1;
+    }
+  }
   for (i = 0; i < iovlen && y < h->size; ++i, y += b) {
     b = MIN(iov[i].iov_len, h->size - y);
     if (b)
@@ -1,5 +1,7 @@
 #ifndef COSMOPOLITAN_LIBC_ZIPOS_ZIPOS_H_
 #define COSMOPOLITAN_LIBC_ZIPOS_ZIPOS_H_
+#include "libc/intrin/dll.h"
+#include "libc/thread/thread.h"
 COSMOPOLITAN_C_START_
 
 #define ZIPOS_PATH_MAX 1024
@@ -15,12 +17,28 @@ COSMOPOLITAN_C_START_
 struct stat;
 struct iovec;
 struct Zipos;
+struct ZiposStream;
 
 struct ZiposUri {
   uint32_t len;
   char path[ZIPOS_PATH_MAX];
 };
 
+/* decompressed file content shared by all handles that open it */
+struct ZiposContent {
+  struct Dll elem;             /* lru list, most recently opened first */
+  struct ZiposContent *hnext;  /* hash table chain */
+  struct ZiposStream *stream;  /* non-null if inflating on demand */
+  pthread_mutex_t lock;        /* serializes inflating */
+  size_t cfile;
+  size_t size;
+  size_t mapsize;
+  size_t refs; /* number of handles, guarded by the cache lock */
+  size_t cost; /* bytes charged to cache budget while refs is zero */
+  _ZIPOS_ATOMIC(size_t) ready; /* bytes of data that can be read */
+  uint8_t data[];
+};
+
 struct ZiposHandle {
   struct ZiposHandle *next;
   struct Zipos *zipos;
@@ -29,6 +47,7 @@ struct ZiposHandle {
   size_t cfile;
   _ZIPOS_ATOMIC(size_t) refs;
   _ZIPOS_ATOMIC(size_t) pos;
+  struct ZiposContent *content; /* non-null if file is compressed */
   uint8_t *mem;
   uint8_t data[];
 };
@@ -38,6 +57,7 @@ struct Zipos {
   uint8_t *map;
   uint8_t *cdir;
   uint64_t dev;
+  const char *path; /* for reopening executable, or null */
   size_t *index;
   size_t records;
 };
@@ -63,6 +83,15 @@ int64_t __zipos_seek(struct ZiposHandle *, int64_t, unsigned);
 int __zipos_notat(int, const char *);
 void *__zipos_mmap(void *, uint64_t, int32_t, int32_t, struct ZiposHandle *,
                    int64_t);
+int __zipos_stream_open(struct ZiposContent *, int, const void *, size_t);
+int __zipos_stream_fill(struct ZiposContent *, size_t);
+void __zipos_stream_close(struct ZiposContent *);
+int __zipos_unzstd(void *, size_t, const void *, size_t);
+struct ZiposContent *__zipos_content_acquire(struct Zipos *, size_t);
+void __zipos_content_release(struct ZiposContent *);
+void __zipos_lock(void);
+void __zipos_unlock(void);
+void __zipos_wipe(void);
 
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_LIBC_ZIPOS_ZIPOS_H_ */
@@ -0,0 +1,155 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/calls/kevent.internal.h"
+#include "libc/calls/struct/sigset.internal.h"
+#include "libc/cosmotime.h"
+#include "libc/dce.h"
+#include "libc/errno.h"
+#include "libc/macros.h"
+#include "libc/sock/epoll.internal.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/f.h"
+#include "libc/sysv/consts/sig.h"
+#include "libc/sysv/errfuns.h"
+
+// kqueue() translation of epoll for FreeBSD, OpenBSD, NetBSD and XNU
+
+#define EPOLL_BSD_BATCH 128
+
+// deletes filter, and returns 1 if it wasn't registered
+static int kevent_delete(int kq, int fd, int filter) {
+  int e = errno;
+  if (!__kevent_change(kq, fd, filter, EV_DELETE, 0, 0))
+    return 0;
+  if (errno == ENOENT) {
+    errno = e;
+    return 1;
+  }
+  return -1;
+}
+
+int sys_epoll_create1_bsd(int flags) {
+  int kq;
+  if ((kq = sys_kqueue()) != -1)
+    if (flags & EPOLL_CLOEXEC)
+      fcntl(kq, F_SETFD, FD_CLOEXEC);
+  return kq;
+}
+
+int sys_epoll_ctl_bsd(int epfd, int op, int fd, struct epoll_event *ev) {
+  int r, w;
+  unsigned flags;
+  uint64_t udata;
+  bool wantread, wantwrite;
+  if (op == EPOLL_CTL_DEL) {
+    if ((r = kevent_delete(epfd, fd, EVFILT_READ)) == -1)
+      return -1;
+    if ((w = kevent_delete(epfd, fd, EVFILT_WRITE)) == -1)
+      return -1;
+    if (r && w)
+      return enoent();
+    return 0;
+  }
+  udata = ev->data.u64;
+  flags = EV_ADD;
+  if (ev->events & EPOLLET)
+    flags |= EV_CLEAR;
+  if (ev->events & EPOLLONESHOT)
+    flags |= EV_ONESHOT;
+  wantread = ev->events & (EPOLLIN | EPOLLPRI | EPOLLRDNORM | EPOLLRDHUP);
+  wantwrite = ev->events & (EPOLLOUT | EPOLLWRNORM);
+  if (!wantread && !wantwrite && fcntl(fd, F_GETFD) == -1)
+    return -1;
+  if (wantread) {
+    if (__kevent_change(epfd, fd, EVFILT_READ, flags, 0, udata))
+      return -1;
+  } else if (op == EPOLL_CTL_MOD) {
+    if (kevent_delete(epfd, fd, EVFILT_READ) == -1)
+      return -1;
+  }
+  if (wantwrite) {
+    if (__kevent_change(epfd, fd, EVFILT_WRITE, flags, 0, udata)) {
+      if (wantread && op == EPOLL_CTL_ADD) {
+        int e = errno;
+        kevent_delete(epfd, fd, EVFILT_READ);
+        errno = e;
+      }
+      return -1;
+    }
+  } else if (op == EPOLL_CTL_MOD) {
+    if (kevent_delete(epfd, fd, EVFILT_WRITE) == -1)
+      return -1;
+  }
+  return 0;
+}
+
+int sys_epoll_wait_bsd(int epfd, struct epoll_event *events, int maxevents,
+                       int timeout_ms, const sigset_t *sigmask) {
+  int i, j, n, rc;
+  struct Kevent k;
+  uint32_t bits;
+  sigset_t oldmask;
+  struct timespec ts, *tsp;
+  uint64_t idents[EPOLL_BSD_BATCH];
+  char buf[EPOLL_BSD_BATCH * KEVENT_MAX];
+  if (timeout_ms >= 0) {
+    ts = timespec_frommillis(timeout_ms);
+    tsp = &ts;
+  } else {
+    tsp = 0;
+  }
+  if (sigmask)
+    sys_sigprocmask(SIG_SETMASK, sigmask, &oldmask);
+  rc = __kevent_call(epfd, 0, 0, buf, MIN(maxevents, EPOLL_BSD_BATCH), tsp);
+  if (sigmask)
+    sys_sigprocmask(SIG_SETMASK, &oldmask, 0);
+  if (rc <= 0)
+    return rc;
+
+  // kqueue reports reading and writing separately, but epoll_wait() is
+  // expected to return each file descriptor at most once
+  for (n = i = 0; i < rc; ++i) {
+    __kevent_unpack(&k, buf + i * __kevent_size());
+    if (k.flags & EV_ERROR) {
+      bits = EPOLLERR;
+    } else if (k.filter == EVFILT_READ) {
+      bits = EPOLLIN;
+      if (k.flags & EV_EOF)
+        bits |= EPOLLRDHUP | (k.fflags ? EPOLLERR : 0);
+    } else if (k.filter == EVFILT_WRITE) {
+      bits = EPOLLOUT;
+      if (k.flags & EV_EOF)
+        bits |= EPOLLHUP | (k.fflags ? EPOLLERR : 0);
+    } else {
+      continue;
+    }
+    for (j = 0; j < n; ++j)
+      if (idents[j] == k.ident)
+        break;
+    if (j == n) {
+      idents[n] = k.ident;
+      events[n].events = 0;
+      events[n].data.u64 = k.udata;
+      ++n;
+    }
+    events[j].events |= bits;
+  }
+  return n;
+}
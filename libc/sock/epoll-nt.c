@@ -0,0 +1,258 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/internal.h"
+#include "libc/calls/state.internal.h"
+#include "libc/cosmotime.h"
+#include "libc/dce.h"
+#include "libc/errno.h"
+#include "libc/intrin/fds.h"
+#include "libc/mem/mem.h"
+#include "libc/sock/epoll.internal.h"
+#include "libc/sock/struct/pollfd.h"
+#include "libc/sock/struct/pollfd.internal.h"
+#include "libc/sock/syscall_fd.internal.h"
+#include "libc/sysv/consts/o.h"
+#include "libc/sysv/consts/poll.h"
+#include "libc/sysv/errfuns.h"
+#include "libc/sysv/pib.h"
+#include "libc/thread/thread.h"
+#if SupportsWindows()
+
+// Windows has no readiness api that works on all kinds of handles, so
+// an epoll instance here is an interest list that's handed to poll().
+
+struct EpollItem {
+  int fd;
+  bool disarmed;  // EPOLLONESHOT fired and not rearmed yet
+  uint32_t events;
+  uint64_t data;
+};
+
+struct EpollNt {
+  pthread_mutex_t lock;
+  size_t n, c;
+  struct EpollItem *p;
+};
+
+static struct EpollNt *sys_epoll_get_nt(int epfd) {
+  if (!__isfdopen(epfd)) {
+    ebadf();
+    return 0;
+  }
+  if (!__isfdkind(epfd, kFdEpoll)) {
+    einval();
+    return 0;
+  }
+  return (struct EpollNt *)(intptr_t)__get_pib()->fds.p[epfd].handle;
+}
+
+static struct EpollItem *sys_epoll_find_nt(struct EpollNt *ep, int fd) {
+  for (size_t i = 0; i < ep->n; ++i)
+    if (ep->p[i].fd == fd)
+      return ep->p + i;
+  return 0;
+}
+
+static void sys_epoll_remove_nt(struct EpollNt *ep, struct EpollItem *it) {
+  *it = ep->p[--ep->n];
+}
+
+static int16_t sys_epoll_events2poll(uint32_t events) {
+  int16_t res = 0;
+  if (events & (EPOLLIN | EPOLLRDNORM | EPOLLRDHUP))
+    res |= POLLIN;
+  if (events & (EPOLLOUT | EPOLLWRNORM))
+    res |= POLLOUT;
+  if (events & EPOLLPRI)
+    res |= POLLPRI;
+  return res;
+}
+
+static uint32_t sys_epoll_poll2events(int16_t revents, uint32_t events) {
+  uint32_t res = 0;
+  if (revents & POLLIN)
+    res |= EPOLLIN;
+  if (revents & POLLOUT)
+    res |= EPOLLOUT;
+  if (revents & POLLPRI)
+    res |= EPOLLPRI;
+  if (revents & POLLERR)
+    res |= EPOLLERR;
+  if (revents & POLLHUP)
+    res |= EPOLLHUP | (events & EPOLLRDHUP);
+  return res & (events | EPOLLERR | EPOLLHUP);
+}
+
+textwindows int sys_epoll_create1_nt(int flags) {
+  int fd;
+  struct EpollNt *ep;
+  if (!(ep = calloc(1, sizeof(*ep))))
+    return -1;
+  if ((fd = __reservefd(-1)) == -1) {
+    free(ep);
+    return -1;
+  }
+  pthread_mutex_init(&ep->lock, 0);
+  __get_pib()->fds.p[fd].kind = kFdEpoll;
+  __get_pib()->fds.p[fd].flags =
+      O_RDWR | ((flags & EPOLL_CLOEXEC) ? O_CLOEXEC : 0);
+  __get_pib()->fds.p[fd].handle = (intptr_t)ep;
+  __get_pib()->fds.p[fd].was_created_during_vfork = __vforked;
+  return fd;
+}
+
+/**
+ * Destroys epoll instance on Windows.
+ *
+ * This function should only be called by close().
+ */
+textwindows int sys_epoll_close_nt(struct Fd *f) {
+  struct EpollNt *ep = (struct EpollNt *)(intptr_t)f->handle;
+  pthread_mutex_destroy(&ep->lock);
+  free(ep->p);
+  free(ep);
+  return 0;
+}
+
+textwindows int sys_epoll_ctl_nt(int epfd, int op, int fd,
+                                 struct epoll_event *ev) {
+  int rc = 0;
+  struct EpollNt *ep;
+  struct EpollItem *it;
+  if (!(ep = sys_epoll_get_nt(epfd)))
+    return -1;
+  if (!__isfdopen(fd))
+    return ebadf();
+  if (__isfdkind(fd, kFdEpoll))
+    return einval();
+  pthread_mutex_lock(&ep->lock);
+  it = sys_epoll_find_nt(ep, fd);
+  switch (op) {
+    case EPOLL_CTL_ADD:
+      if (it) {
+        rc = eexist();
+        break;
+      }
+      if (ep->n == ep->c) {
+        size_t c2 = ep->c ? ep->c * 2 : 16;
+        struct EpollItem *p2;
+        if (!(p2 = realloc(ep->p, c2 * sizeof(*p2)))) {
+          rc = -1;
+          break;
+        }
+        ep->p = p2;
+        ep->c = c2;
+      }
+      it = ep->p + ep->n++;
+      it->fd = fd;
+      // fallthrough
+    case EPOLL_CTL_MOD:
+      if (!it) {
+        rc = enoent();
+        break;
+      }
+      it->disarmed = false;
+      it->events = ev->events;
+      it->data = ev->data.u64;
+      break;
+    case EPOLL_CTL_DEL:
+      if (it) {
+        sys_epoll_remove_nt(ep, it);
+      } else {
+        rc = enoent();
+      }
+      break;
+    default:
+      __builtin_unreachable();
+  }
+  pthread_mutex_unlock(&ep->lock);
+  return rc;
+}
+
+textwindows int sys_epoll_wait_nt(int epfd, struct epoll_event *events,
+                                  int maxevents, int timeout_ms,
+                                  const sigset_t *sigmask) {
+  int rc, count;
+  uint32_t bits;
+  size_t i, n;
+  struct EpollNt *ep;
+  struct EpollItem *it;
+  struct pollfd *fds;
+  struct timespec ts, *tsp;
+  if (!(ep = sys_epoll_get_nt(epfd)))
+    return -1;
+  if (timeout_ms >= 0) {
+    ts = timespec_frommillis(timeout_ms);
+    tsp = &ts;
+  } else {
+    tsp = 0;
+  }
+  for (;;) {
+
+    // snapshot the interest list so epoll_ctl() may run while we block
+    fds = 0;
+    pthread_mutex_lock(&ep->lock);
+    if (ep->n && !(fds = malloc(ep->n * sizeof(*fds)))) {
+      pthread_mutex_unlock(&ep->lock);
+      return -1;
+    }
+    for (n = i = 0; i < ep->n; ++i) {
+      if (!ep->p[i].disarmed) {
+        fds[n].fd = ep->p[i].fd;
+        fds[n].events = sys_epoll_events2poll(ep->p[i].events);
+        fds[n].revents = 0;
+        ++n;
+      }
+    }
+    pthread_mutex_unlock(&ep->lock);
+
+    if ((rc = sys_poll_nt(fds, n, tsp, sigmask)) <= 0) {
+      free(fds);
+      return rc;
+    }
+
+    // items may have changed while we waited, so look each one back up
+    count = 0;
+    pthread_mutex_lock(&ep->lock);
+    for (i = 0; i < n && count < maxevents; ++i) {
+      if (!fds[i].revents)
+        continue;
+      if (!(it = sys_epoll_find_nt(ep, fds[i].fd)) || it->disarmed)
+        continue;
+      if (fds[i].revents & POLLNVAL) {
+        // linux forgets file descriptors when they're closed
+        sys_epoll_remove_nt(ep, it);
+        continue;
+      }
+      if (!(bits = sys_epoll_poll2events(fds[i].revents, it->events)))
+        continue;
+      if (it->events & EPOLLONESHOT)
+        it->disarmed = true;
+      events[count].events = bits;
+      events[count].data.u64 = it->data;
+      ++count;
+    }
+    pthread_mutex_unlock(&ep->lock);
+    free(fds);
+    if (count || tsp)
+      return count;
+  }
+}
+
+#endif /* __x86_64__ */
@@ -0,0 +1,187 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/sock/epoll.h"
+#include "libc/calls/calls.h"
+#include "libc/calls/cp.internal.h"
+#include "libc/calls/internal.h"
+#include "libc/calls/struct/sigset.internal.h"
+#include "libc/dce.h"
+#include "libc/errno.h"
+#include "libc/intrin/strace.h"
+#include "libc/sock/epoll.internal.h"
+#include "libc/sysv/consts/f.h"
+#include "libc/sysv/errfuns.h"
+
+/**
+ * Creates new epoll instance.
+ *
+ * Epoll lets a program wait on a large number of file descriptors at
+ * once, without the O(n) cost poll() pays on each call. It's the Linux
+ * kernel's own interface on Linux. On FreeBSD, OpenBSD, NetBSD and XNU
+ * it's translated to kqueue(). On Windows it's emulated in userspace
+ * on top of the poll() polyfill.
+ *
+ * Some things differ on the emulated platforms. On BSDs, adding a file
+ * descriptor twice, or modifying one that was never added, will succeed
+ * rather than raising `EEXIST` or `ENOENT`. `EPOLLONESHOT` disarms each
+ * direction separately. The descriptor isn't inherited across fork().
+ * On Windows `EPOLLET` behaves like level triggering.
+ *
+ * @param flags may have `EPOLL_CLOEXEC`
+ * @return epoll file descriptor, or -1 w/ errno
+ * @raise EINVAL if `flags` has unsupported bits
+ * @raise EMFILE if too many file descriptors are open
+ * @raise ENOSYS on bare metal
+ */
+int epoll_create1(int flags) {
+  int rc, e;
+  if (flags & ~EPOLL_CLOEXEC) {
+    rc = einval();
+  } else if (IsLinux()) {
+    e = errno;
+    rc = sys_epoll_create1(flags);
+#ifdef __x86_64__
+    if (rc == -1 && errno == ENOSYS) {
+      errno = e;
+      if ((rc = sys_epoll_create(1)) != -1 && (flags & EPOLL_CLOEXEC))
+        fcntl(rc, F_SETFD, FD_CLOEXEC);
+    }
+#endif
+  } else if (IsBsd()) {
+    rc = sys_epoll_create1_bsd(flags);
+  } else if (IsWindows()) {
+    rc = sys_epoll_create1_nt(flags);
+  } else {
+    rc = enosys();
+  }
+  STRACE("epoll_create1(%#x) → %d% m", flags, rc);
+  return rc;
+}
+
+/**
+ * Creates new epoll instance.
+ *
+ * @param size is ignored but must be greater than zero
+ * @return epoll file descriptor, or -1 w/ errno
+ * @see epoll_create1()
+ */
+int epoll_create(int size) {
+  if (size <= 0)
+    return einval();
+  return epoll_create1(0);
+}
+
+/**
+ * Controls which file descriptors an epoll instance watches.
+ *
+ * @param epfd is a file descriptor returned by epoll_create1()
+ * @param op is `EPOLL_CTL_ADD`, `EPOLL_CTL_MOD` or `EPOLL_CTL_DEL`
+ * @param fd is the file descriptor to watch, e.g. a socket
+ * @param ev has `events` which may have `EPOLLIN`, `EPOLLOUT`,
+ *     `EPOLLRDHUP`, `EPOLLET` and `EPOLLONESHOT`, and `data` which
+ *     is returned as is by epoll_wait(); it's ignored by DEL
+ * @return 0 on success, or -1 w/ errno
+ * @raise EBADF if `epfd` or `fd` isn't open
+ * @raise EINVAL if `epfd` isn't an epoll instance, or `op` is bad
+ * @raise EEXIST if `fd` was already added (not detected on BSDs)
+ * @raise ENOENT if `fd` was never added
+ * @raise EFAULT if `ev` is null when adding or modifying
+ */
+int epoll_ctl(int epfd, int op, int fd, struct epoll_event *ev) {
+  int rc;
+  struct epoll_event dummy = {0};
+  if (op != EPOLL_CTL_ADD && op != EPOLL_CTL_MOD && op != EPOLL_CTL_DEL) {
+    rc = einval();
+  } else if (op != EPOLL_CTL_DEL && !ev) {
+    rc = efault();
+  } else if (epfd == fd) {
+    rc = einval();
+  } else if (IsLinux()) {
+    rc = sys_epoll_ctl(epfd, op, fd, ev ? ev : &dummy);
+  } else if (IsBsd()) {
+    rc = sys_epoll_ctl_bsd(epfd, op, fd, ev);
+  } else if (IsWindows()) {
+    rc = sys_epoll_ctl_nt(epfd, op, fd, ev);
+  } else {
+    rc = enosys();
+  }
+  STRACE("epoll_ctl(%d, %d, %d, %#x) → %d% m", epfd, op, fd,
+         ev ? ev->events : 0, rc);
+  return rc;
+}
+
+/**
+ * Waits for events on epoll instance, with signal mask.
+ *
+ * @param epfd is a file descriptor returned by epoll_create1()
+ * @param events receives up to `maxevents` ready file descriptors
+ * @param timeout_ms if 0 means don't wait and negative waits forever
+ * @param sigmask may be null in which case no mask change happens; it
+ *     is applied atomically on Linux only
+ * @return number of `events` populated, 0 on timeout, or -1 w/ errno
+ * @raise EINVAL if `maxevents` isn't positive
+ * @raise EINTR if signal was delivered
+ * @raise ECANCELED if thread was cancelled in masked mode
+ * @cancelationpoint
+ * @norestart
+ */
+int epoll_pwait(int epfd, struct epoll_event *events, int maxevents,
+                int timeout_ms, const sigset_t *sigmask) {
+  int rc, e;
+  sigset_t mask;
+  BEGIN_CANCELATION_POINT;
+  if (maxevents <= 0) {
+    rc = einval();
+  } else if (IsLinux()) {
+    if (sigmask)
+      mask = __linux2mask(*sigmask);
+    e = errno;
+    rc = sys_epoll_pwait(epfd, events, maxevents, timeout_ms,
+                         sigmask ? &mask : 0, 8);
+#ifdef __x86_64__
+    if (rc == -1 && errno == ENOSYS && !sigmask) {
+      errno = e;
+      rc = sys_epoll_wait(epfd, events, maxevents, timeout_ms);
+    }
+#endif
+  } else if (IsBsd()) {
+    rc = sys_epoll_wait_bsd(epfd, events, maxevents, timeout_ms, sigmask);
+  } else if (IsWindows()) {
+    rc = sys_epoll_wait_nt(epfd, events, maxevents, timeout_ms, sigmask);
+  } else {
+    rc = enosys();
+  }
+  END_CANCELATION_POINT;
+  STRACE("epoll_pwait(%d, %p, %d, %d, %s) → %d% m", epfd, events, maxevents,
+         timeout_ms, DescribeSigset(0, sigmask), rc);
+  return rc;
+}
+
+/**
+ * Waits for events on epoll instance.
+ *
+ * @return number of `events` populated, 0 on timeout, or -1 w/ errno
+ * @cancelationpoint
+ * @norestart
+ * @see epoll_pwait()
+ */
+int epoll_wait(int epfd, struct epoll_event *events, int maxevents,
+               int timeout_ms) {
+  return epoll_pwait(epfd, events, maxevents, timeout_ms, 0);
+}
@@ -0,0 +1,54 @@
+#ifndef COSMOPOLITAN_LIBC_SOCK_EPOLL_H_
+#define COSMOPOLITAN_LIBC_SOCK_EPOLL_H_
+#include "libc/calls/struct/sigset.h"
+
+/* these use linux's numbering on every platform */
+#define EPOLLIN        0x00000001
+#define EPOLLPRI       0x00000002
+#define EPOLLOUT       0x00000004
+#define EPOLLERR       0x00000008
+#define EPOLLHUP       0x00000010
+#define EPOLLRDNORM    0x00000040
+#define EPOLLRDBAND    0x00000080
+#define EPOLLWRNORM    0x00000100
+#define EPOLLWRBAND    0x00000200
+#define EPOLLMSG       0x00000400
+#define EPOLLRDHUP     0x00002000
+#define EPOLLEXCLUSIVE 0x10000000
+#define EPOLLWAKEUP    0x20000000
+#define EPOLLONESHOT   0x40000000
+#define EPOLLET        0x80000000
+
+#define EPOLL_CTL_ADD 1
+#define EPOLL_CTL_DEL 2
+#define EPOLL_CTL_MOD 3
+
+#define EPOLL_CLOEXEC 0x00080000
+
+COSMOPOLITAN_C_START_
+
+typedef union epoll_data {
+  void *ptr;
+  int fd;
+  uint32_t u32;
+  uint64_t u64;
+} epoll_data_t;
+
+struct epoll_event {
+  uint32_t events;
+  epoll_data_t data;
+#ifdef __x86_64__
+} __attribute__((__packed__));
+#else
+};
+#endif
+
+int epoll_create(int) libcesque;
+int epoll_create1(int) libcesque;
+int epoll_ctl(int, int, int, struct epoll_event *) libcesque;
+int epoll_wait(int, struct epoll_event *, int, int) libcesque;
+int epoll_pwait(int, struct epoll_event *, int, int,
+                const sigset_t *) libcesque;
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_LIBC_SOCK_EPOLL_H_ */
@@ -0,0 +1,24 @@
+#ifndef COSMOPOLITAN_LIBC_SOCK_EPOLL_INTERNAL_H_
+#define COSMOPOLITAN_LIBC_SOCK_EPOLL_INTERNAL_H_
+#include "libc/calls/struct/sigset.h"
+#include "libc/calls/struct/timespec.h"
+#include "libc/sock/epoll.h"
+COSMOPOLITAN_C_START_
+
+int sys_epoll_create(int);
+int sys_epoll_create1(int);
+int sys_epoll_ctl(int, int, int, struct epoll_event *);
+int sys_epoll_wait(int, struct epoll_event *, int, int);
+int sys_epoll_pwait(int, struct epoll_event *, int, int, const sigset_t *,
+                    size_t);
+
+int sys_epoll_create1_bsd(int);
+int sys_epoll_ctl_bsd(int, int, int, struct epoll_event *);
+int sys_epoll_wait_bsd(int, struct epoll_event *, int, int, const sigset_t *);
+
+int sys_epoll_create1_nt(int);
+int sys_epoll_ctl_nt(int, int, int, struct epoll_event *);
+int sys_epoll_wait_nt(int, struct epoll_event *, int, int, const sigset_t *);
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_LIBC_SOCK_EPOLL_INTERNAL_H_ */
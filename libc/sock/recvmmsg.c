@@ -0,0 +1,102 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/cp.internal.h"
+#include "libc/calls/struct/timespec.h"
+#include "libc/calls/struct/timespec.internal.h"
+#include "libc/cosmotime.h"
+#include "libc/dce.h"
+#include "libc/errno.h"
+#include "libc/intrin/strace.h"
+#include "libc/macros.h"
+#include "libc/sock/struct/msghdr.h"
+#include "libc/sock/struct/msghdr.internal.h"
+#include "libc/sysv/consts/msg.h"
+#include "libc/sysv/errfuns.h"
+
+/**
+ * Receives multiple messages from a socket.
+ *
+ * This is useful for datagram sockets, where it lets you receive a batch
+ * of packets using a single system call. It's native on Linux. On other
+ * platforms it's polyfilled by calling recvmsg() in a loop. On Linux the
+ * `UDP_GRO` socket option may also be used, to have the kernel coalesce
+ * consecutive datagrams into a single larger message.
+ *
+ * When `MSG_WAITFORONE` is passed, only the first message is waited for
+ * and `MSG_DONTWAIT` is implied for the rest. Like Linux, the `timeout`
+ * is only checked after each message is received; it doesn't stop the
+ * blocking of the underlying receive operation.
+ *
+ * If an error happens after some messages were received, then the count
+ * of messages received so far is returned, and the error is left to be
+ * raised by the next call.
+ *
+ * @param vec is array of `vlen` messages, whose `msg_len` fields will
+ *     be set to the number of bytes received for each message
+ * @param vlen is clamped to 1024
+ * @param flags MSG_WAITFORONE, MSG_DONTWAIT, MSG_PEEK, etc.
+ * @param timeout is optional relative limit on how long to keep going
+ * @return number of messages received, or -1 w/ errno
+ * @raise EAGAIN if socket is nonblocking and nothing was received
+ * @raise EINTR if a signal was delivered before anything was received
+ * @cancelationpoint
+ * @restartable (unless SO_RCVTIMEO)
+ */
+int recvmmsg(int fd, struct mmsghdr *vec, unsigned vlen, int flags,
+             struct timespec *timeout) {
+  int e, rc;
+  unsigned i;
+  ssize_t got;
+  struct timespec deadline;
+  e = errno;
+  vlen = MIN(vlen, 1024);
+  if (IsLinux()) {
+    BEGIN_CANCELATION_POINT;
+    rc = sys_recvmmsg(fd, vec, vlen, flags, timeout);
+    END_CANCELATION_POINT;
+  } else {
+    rc = enosys();
+  }
+  if (rc == -1 && errno == ENOSYS) {  // not linux 2.6.33+
+    errno = e;
+    if (timeout)
+      deadline = timespec_add(timespec_mono(), *timeout);
+    for (i = 0; i < vlen; ++i) {
+      if ((got = recvmsg(fd, &vec[i].msg_hdr,
+                         (flags & ~MSG_WAITFORONE) |
+                             (i && (flags & MSG_WAITFORONE) ? MSG_DONTWAIT
+                                                            : 0))) == -1)
+        break;
+      vec[i].msg_len = got;
+      if (timeout && timespec_cmp(timespec_mono(), deadline) >= 0) {
+        ++i;
+        break;
+      }
+    }
+    if (i || !vlen) {
+      errno = e;
+      rc = i;
+    } else {
+      rc = -1;
+    }
+  }
+  STRACE("recvmmsg(%d, %p, %u, %#x, %s) → %d% m", fd, vec, vlen, flags,
+         DescribeTimespec(0, timeout), rc);
+  return rc;
+}
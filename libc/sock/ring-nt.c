@@ -0,0 +1,296 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/atomic.h"
+#include "libc/calls/internal.h"
+#include "libc/calls/struct/sigset.internal.h"
+#include "libc/calls/struct/timespec.internal.h"
+#include "libc/calls/syscall_support-nt.internal.h"
+#include "libc/cosmotime.h"
+#include "libc/dce.h"
+#include "libc/intrin/fds.h"
+#include "libc/macros.h"
+#include "libc/mem/mem.h"
+#include "libc/nt/enum/filetype.h"
+#include "libc/nt/enum/wait.h"
+#include "libc/nt/errors.h"
+#include "libc/nt/files.h"
+#include "libc/nt/iocp.h"
+#include "libc/nt/nt/file.h"
+#include "libc/nt/runtime.h"
+#include "libc/nt/struct/iovec.h"
+#include "libc/nt/thread.h"
+#include "libc/nt/winsock.h"
+#include "libc/sock/ring.internal.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/msg.h"
+#include "libc/sysv/errno.h"
+#include "libc/sysv/pib.h"
+#if SupportsWindows()
+
+#define kRingNtBatch 64  // completions dequeued per system call
+
+struct CosmoRingNtOp {
+  struct NtOverlapped overlap;
+  int64_t handle;
+  uint64_t data;
+  uint32_t flags;  // wsarecv() wants these to stay put
+  bool reading;    // whether a broken pipe means end of file
+  bool busy;       // whether kernel owns overlap
+};
+
+struct CosmoRingNt {
+  int64_t port;     // i/o completion port
+  unsigned id;      // what Fd::iocp is set to once bound to port
+  unsigned cap;     // number of ops
+  unsigned pending; // ops the kernel is working on
+  unsigned navail;  // number of free ops
+  unsigned *avail;  // indices of free ops
+  struct CosmoRingNtOp ops[];
+};
+
+static atomic_uint cosmo_ring_nt_ids;
+
+/**
+ * Creates i/o completion port backend for cosmo_ring on Windows.
+ */
+textwindows struct CosmoRingNt *cosmo_ring_new_nt(unsigned entries) {
+  unsigned i;
+  struct CosmoRingNt *nt;
+  if (!(nt = calloc(1, sizeof(*nt) + entries * (sizeof(*nt->ops) +
+                                                sizeof(*nt->avail)))))
+    return 0;
+  // the ring belongs to one thread, so only one thread services it
+  if (!(nt->port = CreateIoCompletionPort(-1, 0, 0, 1))) {
+    free(nt);
+    return 0;
+  }
+  // zero means unbound and -1 means the handle couldn't be bound
+  nt->id = atomic_fetch_add(&cosmo_ring_nt_ids, 1) % 0xfffffffe + 1;
+  nt->cap = entries;
+  nt->avail = (unsigned *)(nt->ops + entries);
+  for (i = 0; i < entries; ++i)
+    nt->avail[i] = entries - 1 - i;
+  nt->navail = entries;
+  return nt;
+}
+
+// a handle is bound to a completion port for as long as it's open. we
+// can't tell if it's already bound to a different one except by trying
+// so Fd::iocp remembers the outcome. dup() copies it, which is correct
+// since duplicated handles refer to the same kernel file object.
+textwindows static bool cosmo_ring_bind_nt(struct CosmoRingNt *nt,
+                                           struct Fd *f) {
+  if (f->iocp == nt->id)
+    return true;
+  if (f->iocp)
+    return false;
+  if (CreateIoCompletionPort(f->handle, nt->port, 0, 0) == nt->port) {
+    f->iocp = nt->id;
+    return true;
+  } else {
+    f->iocp = -1u;
+    return false;
+  }
+}
+
+/**
+ * Starts operation on completion port.
+ *
+ * @return true if completion will be delivered to port, or false if
+ *     caller should perform the operation inline instead
+ */
+textwindows bool cosmo_ring_queue_nt(struct CosmoRingNt *nt,
+                                     const struct CosmoRingOp *op) {
+  bool isdisk;
+  struct Fd *f;
+  uint32_t len;
+  bool32 pending;
+  struct CosmoRingNtOp *o;
+
+  // find out if this is something win32 can do asynchronously
+  if (!nt->navail || !__isfdopen(op->fd))
+    return false;
+  f = __get_pib()->fds.p + op->fd;
+  if (f->kind != kFdFile && f->kind != kFdSocket)
+    return false;
+  isdisk = f->kind == kFdFile && GetFileType(f->handle) == kNtFileTypeDisk;
+  switch (op->opcode) {
+    case COSMO_RING_READ:
+    case COSMO_RING_WRITE:
+      // we can't lock the file cursor for the lifetime of the operation
+      // therefore only pread() and pwrite() style i/o is offloaded. it's
+      // also left to the inline path to raise espipe on non-disk files
+      if (isdisk != (op->off != -1))
+        return false;
+      break;
+    case COSMO_RING_RECV:
+    case COSMO_RING_SEND:
+      if (isdisk)
+        return false;
+      if (f->kind == kFdFile ? op->flags
+                             : (op->flags & ~(op->opcode == COSMO_RING_RECV
+                                                  ? MSG_OOB | MSG_PEEK
+                                                  : MSG_OOB)))
+        return false;
+      break;
+    default:
+      return false;
+  }
+  if (!cosmo_ring_bind_nt(nt, f))
+    return false;
+
+  // initiate asynchronous i/o operation with win32
+  o = nt->ops + nt->avail[--nt->navail];
+  bzero(&o->overlap, sizeof(o->overlap));
+  o->overlap.Pointer = isdisk ? op->off : 0;
+  o->handle = f->handle;
+  o->data = op->data;
+  o->reading = op->opcode == COSMO_RING_READ || op->opcode == COSMO_RING_RECV;
+  o->flags = op->opcode == COSMO_RING_RECV || op->opcode == COSMO_RING_SEND
+                 ? op->flags
+                 : 0;
+  len = MIN(op->len, 0x7ffff000);
+  if (f->kind == kFdSocket) {
+    struct NtIovec iov = {len, op->buf};
+    if (o->reading) {
+      pending = !WSARecv(f->handle, &iov, 1, 0, &o->flags, &o->overlap, 0);
+    } else {
+      pending = !WSASend(f->handle, &iov, 1, 0, o->flags, &o->overlap, 0);
+    }
+    pending = pending || WSAGetLastError() == kNtErrorIoPending;
+  } else {
+    if (o->reading) {
+      pending = ReadFile(f->handle, op->buf, len, 0, &o->overlap);
+    } else {
+      pending = WriteFile(f->handle, op->buf, len, 0, &o->overlap);
+    }
+    pending = pending || GetLastError() == kNtErrorIoPending;
+  }
+
+  // nothing gets queued when an operation fails immediately. rather
+  // than translating the error ourselves, we let the inline path try
+  // again, so the usual errno and signal semantics apply.
+  if (!pending) {
+    nt->avail[nt->navail++] = o - nt->ops;
+    return false;
+  }
+  o->busy = true;
+  ++nt->pending;
+  return true;
+}
+
+textwindows static int cosmo_ring_dequeue_nt(struct CosmoRingNt *nt,
+                                             struct CosmoRingResult *out,
+                                             int max, uint32_t millis) {
+  int n = 0;
+  uint32_t i, got, err;
+  struct CosmoRingNtOp *o;
+  struct NtOverlappedEntry ents[kRingNtBatch];
+  if (!GetQueuedCompletionStatusEx(nt->port, ents, MIN(max, kRingNtBatch),
+                                   &got, millis, false)) {
+    if (GetLastError() == kNtWaitTimeout)
+      return 0;
+    return __winerr();
+  }
+  for (i = 0; i < got; ++i) {
+    // ignore completions of overlapped i/o that isn't ours, e.g. some
+    // other api in the process might not tag its event handle
+    o = (struct CosmoRingNtOp *)ents[i].lpOverlapped;
+    if (o < nt->ops || o >= nt->ops + nt->cap || !o->busy)
+      continue;
+    out[n].data = o->data;
+    if (!o->overlap.Internal) {
+      out[n].res = ents[i].dwNumberOfBytesTransferred;
+      out[n].err = 0;
+    } else {
+      err = RtlNtStatusToDosError(o->overlap.Internal);
+      if (o->reading &&
+          (err == kNtErrorHandleEof || err == kNtErrorBrokenPipe)) {
+        out[n].res = 0;
+        out[n].err = 0;
+      } else {
+        out[n].res = -1;
+        out[n].err = __errno_windows2linux(err);
+      }
+    }
+    o->busy = false;
+    nt->avail[nt->navail++] = o - nt->ops;
+    --nt->pending;
+    ++n;
+  }
+  return n;
+}
+
+/**
+ * Collects completions from port.
+ *
+ * Completion ports can't be waited upon at the same time as our signal
+ * event, so the wait is broken up into slices, which is what accept()
+ * does on Windows too.
+ *
+ * @param timeout is relative, or null to wait forever
+ * @return number of completions, or -1 w/ errno
+ */
+textwindows int cosmo_ring_reap_nt(struct CosmoRingNt *nt,
+                                   struct CosmoRingResult *out, int max,
+                                   const struct timespec *timeout) {
+  int rc;
+  sigset_t m;
+  uint32_t millis;
+  struct timespec now, deadline;
+  if (timeout && timespec_iszero(*timeout))
+    return cosmo_ring_dequeue_nt(nt, out, max, 0);
+  now = sys_clock_gettime_monotonic_nt();
+  deadline = timeout ? timespec_add(now, *timeout) : timespec_max;
+  m = __sig_block();
+  for (;;) {
+    millis = MIN(timespec_tomillis(timespec_subz(deadline, now)),
+                 POLL_INTERVAL_MS);
+    if ((rc = cosmo_ring_dequeue_nt(nt, out, max, millis)) || !nt->pending)
+      break;
+    now = sys_clock_gettime_monotonic_nt();
+    if (timespec_cmp(now, deadline) >= 0)
+      break;
+    if ((rc = __sigcheck(m, false)))
+      break;
+  }
+  __sig_unblock(m);
+  return rc;
+}
+
+/**
+ * Destroys completion port backend.
+ *
+ * Pending operations are canceled, since the kernel would otherwise be
+ * writing to our overlapped structures after they're freed.
+ */
+textwindows void cosmo_ring_free_nt(struct CosmoRingNt *nt) {
+  unsigned i;
+  struct CosmoRingResult res[kRingNtBatch];
+  for (i = 0; i < nt->cap; ++i)
+    if (nt->ops[i].busy)
+      CancelIoEx(nt->ops[i].handle, &nt->ops[i].overlap);
+  while (nt->pending)
+    if (cosmo_ring_dequeue_nt(nt, res, ARRAYLEN(res), -1u) == -1)
+      return;  // leak rather than risk corrupting memory
+  CloseHandle(nt->port);
+  free(nt);
+}
+
+#endif /* __x86_64__ */
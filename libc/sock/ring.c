@@ -0,0 +1,429 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/sock/ring.h"
+#include "libc/atomic.h"
+#include "libc/calls/calls.h"
+#include "libc/calls/cp.internal.h"
+#include "libc/dce.h"
+#include "libc/errno.h"
+#include "libc/intrin/atomic.h"
+#include "libc/intrin/strace.h"
+#include "libc/limits.h"
+#include "libc/macros.h"
+#include "libc/mem/mem.h"
+#include "libc/runtime/runtime.h"
+#include "libc/sock/ring.internal.h"
+#include "libc/sock/sock.h"
+#include "libc/sock/struct/sockaddr.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/map.h"
+#include "libc/sysv/consts/prot.h"
+#include "libc/sysv/errfuns.h"
+
+#define kRingTimeout UINT64_MAX  // user_data reserved for our timeouts
+
+struct CosmoRing {
+  int fd;             // io_uring fd, or -1 if ops are performed inline
+  unsigned cap;       // max operations awaiting reap
+  unsigned inflight;  // operations the kernel is working on
+  unsigned sqtail;    // our copy of the submission tail
+  unsigned sqmask;
+  unsigned cqmask;
+  atomic_uint *sqhead;
+  atomic_uint *sqtailp;
+  atomic_uint *cqhead;
+  atomic_uint *cqtail;
+  struct io_uring_sqe *sqes;
+  struct io_uring_cqe *cqes;
+  void *sqmap, *cqmap;
+  size_t sqmapsize, cqmapsize, sqessize;
+  unsigned char native[8];  // which COSMO_RING_xxx ops the kernel has
+  struct CosmoRingNt *nt;   // i/o completion port backend on windows
+  unsigned donehead;
+  unsigned donecount;
+  struct CosmoRingResult done[];  // completions of inline operations
+};
+
+static const unsigned char kRingOpcodes[] = {
+    [COSMO_RING_READ] = IORING_OP_READ,    //
+    [COSMO_RING_WRITE] = IORING_OP_WRITE,  //
+    [COSMO_RING_ACCEPT] = IORING_OP_ACCEPT,
+    [COSMO_RING_SEND] = IORING_OP_SEND,  //
+    [COSMO_RING_RECV] = IORING_OP_RECV,  //
+};
+
+static void cosmo_ring_unmap(struct CosmoRing *r) {
+  if (r->sqes)
+    munmap(r->sqes, r->sqessize);
+  if (r->cqmap)
+    munmap(r->cqmap, r->cqmapsize);
+  if (r->sqmap)
+    munmap(r->sqmap, r->sqmapsize);
+  close(r->fd);
+  r->fd = -1;
+}
+
+static bool cosmo_ring_setup(struct CosmoRing *r, unsigned entries) {
+  int i, e;
+  unsigned *array;
+  bool ok = false;
+  struct io_uring_probe *probe;
+  struct io_uring_params p = {0};
+  e = errno;
+  if ((r->fd = sys_io_uring_setup(entries, &p)) == -1)
+    goto Finish;
+  // we need IORING_OP_READ and friends, which are linux 5.6+ and come
+  // after the kernel started holding completions that overflow the cq
+  if (!(p.features & IORING_FEAT_NODROP))
+    goto Finish;
+  if (!(probe = calloc(1, sizeof(*probe))))
+    goto Finish;
+  if (sys_io_uring_register(r->fd, IORING_REGISTER_PROBE, probe,
+                            ARRAYLEN(probe->ops)) != -1) {
+    for (i = 1; i < ARRAYLEN(kRingOpcodes); ++i)
+      if (kRingOpcodes[i] < probe->ops_len &&
+          (probe->ops[kRingOpcodes[i]].flags & IO_URING_OP_SUPPORTED))
+        r->native[i] = true;
+  }
+  free(probe);
+  if (!r->native[COSMO_RING_READ])
+    goto Finish;
+  r->sqmapsize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  r->cqmapsize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  r->sqessize = p.sq_entries * sizeof(struct io_uring_sqe);
+  if ((r->sqmap = mmap(0, r->sqmapsize, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING)) ==
+      MAP_FAILED) {
+    r->sqmap = 0;
+    goto Finish;
+  }
+  if ((r->cqmap = mmap(0, r->cqmapsize, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING)) ==
+      MAP_FAILED) {
+    r->cqmap = 0;
+    goto Finish;
+  }
+  if ((r->sqes = mmap(0, r->sqessize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES)) ==
+      MAP_FAILED) {
+    r->sqes = 0;
+    goto Finish;
+  }
+  r->sqhead = (atomic_uint *)((char *)r->sqmap + p.sq_off.head);
+  r->sqtailp = (atomic_uint *)((char *)r->sqmap + p.sq_off.tail);
+  r->sqmask = *(unsigned *)((char *)r->sqmap + p.sq_off.ring_mask);
+  r->sqtail = atomic_load_explicit(r->sqtailp, memory_order_relaxed);
+  array = (unsigned *)((char *)r->sqmap + p.sq_off.array);
+  for (i = 0; i < p.sq_entries; ++i)
+    array[i] = i;
+  r->cqhead = (atomic_uint *)((char *)r->cqmap + p.cq_off.head);
+  r->cqtail = (atomic_uint *)((char *)r->cqmap + p.cq_off.tail);
+  r->cqmask = *(unsigned *)((char *)r->cqmap + p.cq_off.ring_mask);
+  r->cqes = (struct io_uring_cqe *)((char *)r->cqmap + p.cq_off.cqes);
+  ok = true;
+Finish:
+  if (!ok && r->fd != -1)
+    cosmo_ring_unmap(r);
+  errno = e;
+  return ok;
+}
+
+/**
+ * Creates batched i/o ring.
+ *
+ * This lets you hand the kernel many reads, writes, accepts, sends and
+ * receives using a single system call, and later collect the results in
+ * the same way. On Linux 5.6+ it's backed by io_uring, with operations
+ * running asynchronously. On Windows it's backed by an i/o completion
+ * port, which asynchronously performs reads, writes, sends and receives
+ * on sockets and pipes, as well as reads and writes on files when they
+ * have an explicit offset. Everywhere else, as well as on Linux kernels
+ * where io_uring isn't available or has been disabled, each operation
+ * is simply performed by cosmo_ring_submit() using the normal system
+ * call, and its result is queued for cosmo_ring_reap().
+ *
+ * That means the same code runs everywhere, but note that operations
+ * on blocking file descriptors may block cosmo_ring_submit() when it's
+ * not native. Use nonblocking sockets, or poll() first, if it matters.
+ *
+ * A ring must only be used by one thread at a time. It shouldn't be
+ * used across fork(), since the child would share it with the parent.
+ *
+ * @param entries is number of ops that may be submitted before reaping
+ * @return new ring, or null w/ errno
+ * @raise EINVAL if `entries` is zero or greater than 4096
+ * @raise ENOMEM if we require more vespene gas
+ */
+struct CosmoRing *cosmo_ring_new(unsigned entries) {
+  struct CosmoRing *r;
+  if (!entries || entries > 4096) {
+    einval();
+    return 0;
+  }
+  if (!(r = calloc(1, sizeof(*r) + entries * sizeof(*r->done))))
+    return 0;
+  r->fd = -1;
+  r->cap = entries;
+  if (IsLinux())
+    cosmo_ring_setup(r, entries);
+  if (IsWindows())
+    r->nt = cosmo_ring_new_nt(entries);
+  STRACE("cosmo_ring_new(%u) → %p [fd=%d]", entries, r, r->fd);
+  return r;
+}
+
+/**
+ * Returns true if ring is backed by io_uring or a completion port.
+ */
+bool32 cosmo_ring_is_native(const struct CosmoRing *r) {
+  return r->fd != -1 || r->nt;
+}
+
+/**
+ * Destroys batched i/o ring.
+ *
+ * Any operations still in flight will be left to complete on their own
+ * so memory they reference must stay valid until they're reaped. On
+ * Windows they're canceled instead, and this waits for them to finish.
+ */
+void cosmo_ring_free(struct CosmoRing *r) {
+  if (!r)
+    return;
+  if (r->fd != -1)
+    cosmo_ring_unmap(r);
+  if (IsWindows() && r->nt)
+    cosmo_ring_free_nt(r->nt);
+  free(r);
+}
+
+static void cosmo_ring_inline(struct CosmoRing *r, const struct CosmoRingOp *op) {
+  int e;
+  ssize_t rc;
+  int64_t off;
+  struct CosmoRingResult *res;
+  e = errno;
+  switch (op->opcode) {
+    case COSMO_RING_READ:
+      if (op->off == -1) {
+        rc = read(op->fd, op->buf, op->len);
+      } else {
+        rc = pread(op->fd, op->buf, op->len, op->off);
+      }
+      break;
+    case COSMO_RING_WRITE:
+      if (op->off == -1) {
+        rc = write(op->fd, op->buf, op->len);
+      } else {
+        rc = pwrite(op->fd, op->buf, op->len, op->off);
+      }
+      break;
+    case COSMO_RING_ACCEPT:
+      rc = accept4(op->fd, op->buf, op->addrlen, op->flags);
+      break;
+    case COSMO_RING_SEND:
+      rc = send(op->fd, op->buf, op->len, op->flags);
+      break;
+    case COSMO_RING_RECV:
+      rc = recv(op->fd, op->buf, op->len, op->flags);
+      break;
+    case COSMO_RING_SENDFILE:
+      off = op->off;
+      rc = sendfile(op->fd, op->infd, op->off == -1 ? 0 : &off, op->len);
+      break;
+    default:
+      __builtin_unreachable();
+  }
+  res = r->done + (r->donehead + r->donecount++) % r->cap;
+  res->data = op->data;
+  res->res = rc;
+  res->err = rc == -1 ? errno : 0;
+  errno = e;
+}
+
+static void cosmo_ring_queue(struct CosmoRing *r, const struct CosmoRingOp *op) {
+  struct io_uring_sqe *sqe;
+  sqe = r->sqes + (r->sqtail & r->sqmask);
+  bzero(sqe, sizeof(*sqe));
+  sqe->opcode = kRingOpcodes[op->opcode];
+  sqe->fd = op->fd;
+  sqe->addr = (uintptr_t)op->buf;
+  sqe->len = MIN(op->len, 0x7ffff000);
+  sqe->user_data = op->data;
+  if (op->opcode == COSMO_RING_ACCEPT) {
+    sqe->off = (uintptr_t)op->addrlen;
+    sqe->len = 0;
+  } else if (op->opcode == COSMO_RING_READ || op->opcode == COSMO_RING_WRITE) {
+    sqe->off = op->off;
+  }
+  if (op->opcode != COSMO_RING_READ && op->opcode != COSMO_RING_WRITE)
+    sqe->op_flags = op->flags;
+  atomic_store_explicit(r->sqtailp, ++r->sqtail, memory_order_release);
+}
+
+static unsigned cosmo_ring_unsubmitted(struct CosmoRing *r) {
+  return r->sqtail - atomic_load_explicit(r->sqhead, memory_order_acquire);
+}
+
+static int cosmo_ring_enter(struct CosmoRing *r, unsigned wait) {
+  return sys_io_uring_enter(r->fd, cosmo_ring_unsubmitted(r), wait,
+                            wait ? IORING_ENTER_GETEVENTS : 0, 0, 0);
+}
+
+/**
+ * Submits batch of operations.
+ *
+ * Memory referenced by each operation must remain valid until its
+ * completion is reaped. Completions may arrive in any order.
+ *
+ * @param ops is array of `n` operations
+ * @return number of ops submitted, which is less than `n` when the
+ *     ring is full, in which case you need to call cosmo_ring_reap()
+ * @raise EINVAL if an opcode is invalid and it's the first op
+ * @raise EBUSY if kernel is overloaded and nothing could be submitted
+ */
+int cosmo_ring_submit(struct CosmoRing *r, const struct CosmoRingOp *ops,
+                      int n) {
+  int i;
+  for (i = 0; i < n; ++i) {
+    if (ops[i].opcode < COSMO_RING_READ ||
+        ops[i].opcode > COSMO_RING_SENDFILE) {
+      if (!i)
+        return einval();
+      break;
+    }
+    if (r->inflight + r->donecount >= r->cap)
+      break;
+    if (r->fd != -1 && ops[i].opcode < ARRAYLEN(r->native) &&
+        r->native[ops[i].opcode]) {
+      if (cosmo_ring_unsubmitted(r) > r->sqmask &&
+          cosmo_ring_enter(r, 0) == -1) {
+        if (!i)
+          return -1;
+        break;
+      }
+      cosmo_ring_queue(r, ops + i);
+      ++r->inflight;
+    } else if (IsWindows() && r->nt && cosmo_ring_queue_nt(r->nt, ops + i)) {
+      ++r->inflight;
+    } else {
+      cosmo_ring_inline(r, ops + i);
+    }
+  }
+  // if the kernel wants us to back off, what we queued stays in the
+  // ring and will be submitted by our next call into the kernel
+  if (r->fd != -1 && cosmo_ring_unsubmitted(r))
+    cosmo_ring_enter(r, 0);
+  return i;
+}
+
+static int cosmo_ring_harvest(struct CosmoRing *r,
+                              struct CosmoRingResult *out, int max) {
+  int rc;
+  unsigned head, tail;
+  struct io_uring_cqe *cqe;
+  int n = 0;
+  while (n < max && r->donecount) {
+    out[n++] = r->done[r->donehead];
+    r->donehead = (r->donehead + 1) % r->cap;
+    --r->donecount;
+  }
+  if (IsWindows() && r->nt) {
+    if (n < max && r->inflight &&
+        (rc = cosmo_ring_reap_nt(r->nt, out + n, max - n,
+                                 &(struct timespec){0})) > 0) {
+      r->inflight -= rc;
+      n += rc;
+    }
+    return n;
+  }
+  if (r->fd == -1)
+    return n;
+  head = atomic_load_explicit(r->cqhead, memory_order_relaxed);
+  tail = atomic_load_explicit(r->cqtail, memory_order_acquire);
+  for (; n < max && head != tail; ++head) {
+    cqe = r->cqes + (head & r->cqmask);
+    if (cqe->user_data == kRingTimeout)
+      continue;
+    out[n].data = cqe->user_data;
+    if (cqe->res < 0) {
+      out[n].res = -1;
+      out[n].err = -cqe->res;
+    } else {
+      out[n].res = cqe->res;
+      out[n].err = 0;
+    }
+    --r->inflight;
+    ++n;
+  }
+  atomic_store_explicit(r->cqhead, head, memory_order_release);
+  return n;
+}
+
+/**
+ * Collects results of completed operations.
+ *
+ * @param out receives up to `max` completions
+ * @param timeout is relative; null waits for at least one completion,
+ *     and zero simply collects whatever's already finished
+ * @return number of completions, or -1 w/ errno, which is 0 when there
+ *     are no operations in flight or the timeout elapsed
+ * @raise EINVAL if `max` isn't positive
+ * @raise EINTR if a signal was delivered while waiting
+ * @raise ECANCELED if thread was cancelled in masked mode
+ * @cancelationpoint
+ * @norestart
+ */
+int cosmo_ring_reap(struct CosmoRing *r, struct CosmoRingResult *out, int max,
+                    const struct timespec *timeout) {
+  int rc;
+  struct timespec ts;
+  struct io_uring_sqe *sqe;
+  if (max <= 0)
+    return einval();
+  if ((rc = cosmo_ring_harvest(r, out, max)) || !r->inflight ||
+      (timeout && !timeout->tv_sec && !timeout->tv_nsec))
+    return rc;
+  BEGIN_CANCELATION_POINT;
+  if (IsWindows() && r->nt) {
+    if ((rc = cosmo_ring_reap_nt(r->nt, out, max, timeout)) > 0)
+      r->inflight -= rc;
+    goto Finish;
+  }
+  if (timeout) {
+    // this timer completes when anything else does, or when it expires.
+    // the kernel copies the timespec when we enter, so it can be local
+    if (cosmo_ring_unsubmitted(r) > r->sqmask)
+      cosmo_ring_enter(r, 0);
+    ts = *timeout;
+    sqe = r->sqes + (r->sqtail & r->sqmask);
+    bzero(sqe, sizeof(*sqe));
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = (uintptr_t)&ts;
+    sqe->len = 1;
+    sqe->off = 1;
+    sqe->user_data = kRingTimeout;
+    atomic_store_explicit(r->sqtailp, ++r->sqtail, memory_order_release);
+  }
+  if ((rc = cosmo_ring_enter(r, 1)) != -1)
+    rc = cosmo_ring_harvest(r, out, max);
+Finish:
+  END_CANCELATION_POINT;
+  return rc;
+}
@@ -0,0 +1,42 @@
+#ifndef COSMOPOLITAN_LIBC_SOCK_RING_H_
+#define COSMOPOLITAN_LIBC_SOCK_RING_H_
+#include "libc/calls/struct/timespec.h"
+COSMOPOLITAN_C_START_
+
+#define COSMO_RING_READ     1
+#define COSMO_RING_WRITE    2
+#define COSMO_RING_ACCEPT   3
+#define COSMO_RING_SEND     4
+#define COSMO_RING_RECV     5
+#define COSMO_RING_SENDFILE 6
+
+struct CosmoRing;
+
+struct CosmoRingOp {
+  int opcode;         /* COSMO_RING_READ, etc. */
+  int fd;             /* descriptor the operation is performed upon */
+  void *buf;          /* data, or struct sockaddr for accept */
+  size_t len;         /* bytes of data */
+  int64_t off;        /* file offset, or -1 for current file position */
+  int flags;          /* MSG_xxx for send/recv, SOCK_xxx for accept */
+  int infd;           /* file being sent for sendfile */
+  uint32_t *addrlen;  /* in/out size of buf for accept, or null */
+  uint64_t data;      /* passed through to the completion */
+};
+
+struct CosmoRingResult {
+  uint64_t data; /* CosmoRingOp::data */
+  int64_t res;   /* bytes transferred, accepted fd, or -1 */
+  int err;       /* errno if res is -1, otherwise 0 */
+};
+
+struct CosmoRing *cosmo_ring_new(unsigned) libcesque;
+int cosmo_ring_submit(struct CosmoRing *, const struct CosmoRingOp *,
+                      int) libcesque;
+int cosmo_ring_reap(struct CosmoRing *, struct CosmoRingResult *, int,
+                    const struct timespec *) libcesque;
+bool32 cosmo_ring_is_native(const struct CosmoRing *) libcesque;
+void cosmo_ring_free(struct CosmoRing *) libcesque;
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_LIBC_SOCK_RING_H_ */
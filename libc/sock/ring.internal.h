@@ -0,0 +1,109 @@
+#ifndef COSMOPOLITAN_LIBC_SOCK_RING_INTERNAL_H_
+#define COSMOPOLITAN_LIBC_SOCK_RING_INTERNAL_H_
+#include "libc/sock/ring.h"
+COSMOPOLITAN_C_START_
+
+#define IORING_OFF_SQ_RING 0x00000000
+#define IORING_OFF_CQ_RING 0x08000000
+#define IORING_OFF_SQES    0x10000000
+
+#define IORING_ENTER_GETEVENTS 1
+#define IORING_FEAT_NODROP     2
+#define IORING_REGISTER_PROBE  8
+#define IO_URING_OP_SUPPORTED  1
+
+#define IORING_OP_TIMEOUT 11
+#define IORING_OP_ACCEPT  13
+#define IORING_OP_READ    22
+#define IORING_OP_WRITE   23
+#define IORING_OP_SEND    26
+#define IORING_OP_RECV    27
+
+struct io_sqring_offsets {
+  uint32_t head;
+  uint32_t tail;
+  uint32_t ring_mask;
+  uint32_t ring_entries;
+  uint32_t flags;
+  uint32_t dropped;
+  uint32_t array;
+  uint32_t resv1;
+  uint64_t user_addr;
+};
+
+struct io_cqring_offsets {
+  uint32_t head;
+  uint32_t tail;
+  uint32_t ring_mask;
+  uint32_t ring_entries;
+  uint32_t overflow;
+  uint32_t cqes;
+  uint32_t flags;
+  uint32_t resv1;
+  uint64_t user_addr;
+};
+
+struct io_uring_params {
+  uint32_t sq_entries;
+  uint32_t cq_entries;
+  uint32_t flags;
+  uint32_t sq_thread_cpu;
+  uint32_t sq_thread_idle;
+  uint32_t features;
+  uint32_t wq_fd;
+  uint32_t resv[3];
+  struct io_sqring_offsets sq_off;
+  struct io_cqring_offsets cq_off;
+};
+
+struct io_uring_sqe {
+  uint8_t opcode;
+  uint8_t flags;
+  uint16_t ioprio;
+  int32_t fd;
+  uint64_t off;  /* or addr2 */
+  uint64_t addr; /* or splice_off_in */
+  uint32_t len;
+  uint32_t op_flags; /* rw_flags, msg_flags, accept_flags, etc. */
+  uint64_t user_data;
+  uint16_t buf_index;
+  uint16_t personality;
+  int32_t splice_fd_in;
+  uint64_t addr3;
+  uint64_t __pad2[1];
+};
+
+struct io_uring_cqe {
+  uint64_t user_data;
+  int32_t res;
+  uint32_t flags;
+};
+
+struct io_uring_probe_op {
+  uint8_t op;
+  uint8_t resv;
+  uint16_t flags;
+  uint32_t resv2;
+};
+
+struct io_uring_probe {
+  uint8_t last_op;
+  uint8_t ops_len;
+  uint16_t resv;
+  uint32_t resv2[3];
+  struct io_uring_probe_op ops[256];
+};
+
+int sys_io_uring_setup(uint32_t, struct io_uring_params *);
+int sys_io_uring_enter(int, uint32_t, uint32_t, uint32_t, const void *, size_t);
+int sys_io_uring_register(int, uint32_t, void *, uint32_t);
+
+struct CosmoRingNt;
+struct CosmoRingNt *cosmo_ring_new_nt(unsigned);
+bool cosmo_ring_queue_nt(struct CosmoRingNt *, const struct CosmoRingOp *);
+int cosmo_ring_reap_nt(struct CosmoRingNt *, struct CosmoRingResult *, int,
+                       const struct timespec *);
+void cosmo_ring_free_nt(struct CosmoRingNt *);
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_LIBC_SOCK_RING_INTERNAL_H_ */
@@ -20,6 +20,7 @@
 #include "libc/atomic.h"
 #include "libc/calls/calls.h"
 #include "libc/calls/internal.h"
+#include "libc/calls/sig.internal.h"
 #include "libc/calls/struct/sigset.internal.h"
 #include "libc/calls/syscall-sysv.internal.h"
 #include "libc/cosmo.h"
@@ -41,6 +42,8 @@
 #include "libc/sock/syscall_fd.internal.h"
 #include "libc/sock/wsaid.internal.h"
 #include "libc/stdio/sysparam.h"
+#include "libc/sysv/consts/sicode.h"
+#include "libc/sysv/consts/sig.h"
 #include "libc/sysv/errfuns.h"
 #include "libc/sysv/pib.h"
 
@@ -60,59 +63,80 @@ static void transmitfile_init(void) {
   g_transmitfile.lpTransmitFile = __get_wsaid(&TransmitfileGuid);
 }
 
+struct SendfileArgs {
+  int64_t file;
+  int64_t offset;
+  uint32_t size;
+};
+
+textwindows static int sys_sendfile_nt_start(int64_t handle,
+                                             struct NtOverlapped *overlap,
+                                             uint32_t *flags, void *arg) {
+  struct SendfileArgs *args = arg;
+  overlap->Pointer = args->offset;
+  return g_transmitfile.lpTransmitFile(handle, args->file, args->size, 0,
+                                       overlap, 0, 0)
+             ? 0
+             : -1;
+}
+
 textwindows dontinline static ssize_t sys_sendfile_nt(
     int outfd, int infd, int64_t *opt_in_out_inoffset, uint32_t uptobytes) {
   ssize_t rc;
-  uint32_t flags = 0;
-  bool locked = false;
-  int64_t ih, oh, eof, offset;
+  int64_t eof, offset;
+  sigset_t waitmask;
+  struct Fd *f, *sock;
   struct NtByHandleFileInformation wst;
   if (!__isfdkind(infd, kFdFile) || !__get_pib()->fds.p[infd].cursor)
     return ebadf();
   if (!__isfdkind(outfd, kFdSocket))
     return ebadf();
-  ih = __get_pib()->fds.p[infd].handle;
-  oh = __get_pib()->fds.p[outfd].handle;
+  if (opt_in_out_inoffset && *opt_in_out_inoffset < 0)
+    return einval();
+  f = __get_pib()->fds.p + infd;
+  sock = __get_pib()->fds.p + outfd;
+  cosmo_once(&g_transmitfile.once, transmitfile_init);
+  waitmask = __sig_block();
   if (opt_in_out_inoffset) {
     offset = *opt_in_out_inoffset;
   } else {
-    locked = true;
-    __cursor_lock(__get_pib()->fds.p[infd].cursor);
-    offset = __get_pib()->fds.p[infd].cursor->shared->pointer;
+    __cursor_lock(f->cursor);
+    offset = f->cursor->shared->pointer;
   }
-  if (GetFileInformationByHandle(ih, &wst)) {
-    // TransmitFile() returns EINVAL if `uptobytes` goes past EOF.
+  if (GetFileInformationByHandle(f->handle, &wst)) {
+    // TransmitFile() returns EINVAL if `uptobytes` goes past EOF, and it
+    // sends the whole file if it's zero, so we must check for EOF first
     eof = (uint64_t)wst.nFileSizeHigh << 32 | wst.nFileSizeLow;
-    if (offset + uptobytes > eof) {
-      uptobytes = eof - offset;
+    if (offset < eof) {
+      uptobytes = MIN(uptobytes, eof - offset);
+      // unlike the old synchronous approach, this can be interrupted by
+      // signals, canceled, or time out via SO_SNDTIMEO. we don't ask it
+      // to be nonblocking, for the same reasons as send()
+      rc = __winsock_block(sock->handle, 0, false, sock->sndtimeo, waitmask,
+                           sys_sendfile_nt_start,
+                           &(struct SendfileArgs){f->handle, offset,
+                                                  uptobytes});
+    } else {
+      rc = 0;
     }
-  } else {
-    if (locked)
-      __cursor_unlock(__get_pib()->fds.p[infd].cursor);
-    return ebadf();
-  }
-  struct NtOverlapped ov = {.hEvent = WSACreateEvent(), .Pointer = offset};
-  cosmo_once(&g_transmitfile.once, transmitfile_init);
-  if (ov.hEvent &&
-      (g_transmitfile.lpTransmitFile(oh, ih, uptobytes, 0, &ov, 0, 0) ||
-       WSAGetLastError() == kNtErrorIoPending ||
-       WSAGetLastError() == WSAEINPROGRESS)) {
-    if (WSAGetOverlappedResult(oh, &ov, &uptobytes, true, &flags)) {
-      rc = uptobytes;
+    if (rc != -1) {
       if (opt_in_out_inoffset) {
         *opt_in_out_inoffset = offset + rc;
       } else {
-        __get_pib()->fds.p[infd].cursor->shared->pointer = offset + rc;
+        f->cursor->shared->pointer = offset + rc;
       }
-    } else {
-      rc = __winsockerr();
     }
   } else {
-    rc = __winsockerr();
+    rc = ebadf();
+  }
+  if (!opt_in_out_inoffset)
+    __cursor_unlock(f->cursor);
+  __sig_unblock(waitmask);
+  if (rc == -1 && (errno == ESHUTDOWN ||      // WSAESHUTDOWN
+                   errno == ECONNABORTED)) {  // WSAECONNABORTED
+    errno = EPIPE;
+    __sig_raise(SIGPIPE, SI_KERNEL);
   }
-  if (locked)
-    __cursor_unlock(__get_pib()->fds.p[infd].cursor);
-  WSACloseEvent(ov.hEvent);
   return rc;
 }
 
@@ -161,6 +185,8 @@ static ssize_t sys_sendfile_bsd(int outfd, int infd,
  *     block until everything's sent, whereas others won't; the behavior of
  *     zero is undefined; this value may overlap the end of file in which
  *     case what remains is sent; this is silently reduced to `0x7ffff000`
+ *     and on Windows it's performed by TransmitFile() which may be
+ *     interrupted by signals, or time out if `SO_SNDTIMEO` is set
  * @return number of bytes transmitted which may be fewer than requested in
  *     which case caller must be prepared to call sendfile() again
  * @raise ESPIPE on Linux RHEL7+ if offset is used but `infd` isn't seekable,
@@ -194,9 +220,7 @@ ssize_t sendfile(int outfd, int infd, int64_t *opt_in_out_inoffset,
   } else if (IsFreebsd() || IsXnu()) {
     rc = sys_sendfile_bsd(outfd, infd, opt_in_out_inoffset, uptobytes);
   } else if (IsWindows()) {
-    BLOCK_SIGNALS;
     rc = sys_sendfile_nt(outfd, infd, opt_in_out_inoffset, uptobytes);
-    ALLOW_SIGNALS;
   } else {
     rc = enosys();
   }
@@ -0,0 +1,80 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/cp.internal.h"
+#include "libc/dce.h"
+#include "libc/errno.h"
+#include "libc/intrin/strace.h"
+#include "libc/macros.h"
+#include "libc/sock/struct/msghdr.h"
+#include "libc/sock/struct/msghdr.internal.h"
+#include "libc/sysv/errfuns.h"
+
+/**
+ * Sends multiple messages on a socket.
+ *
+ * This is useful for datagram sockets, where it lets you send a batch
+ * of packets using a single system call. It's native on Linux. On other
+ * platforms it's polyfilled by calling sendmsg() in a loop. On Linux the
+ * `UDP_SEGMENT` socket option can be used to go further, by having each
+ * message be split into equal sized datagrams by the kernel, or device.
+ *
+ * If an error happens after some messages were sent, then the count of
+ * messages sent so far is returned, and the error is left to be raised
+ * by the next call.
+ *
+ * @param vec is array of `vlen` messages, whose `msg_len` fields will
+ *     be set to the number of bytes sent for each message
+ * @param vlen is clamped to 1024
+ * @param flags MSG_DONTWAIT, MSG_NOSIGNAL, etc.
+ * @return number of messages sent, or -1 w/ errno
+ * @raise EAGAIN if socket is nonblocking and nothing could be sent
+ * @raise EINTR if a signal was delivered before anything was sent
+ * @cancelationpoint
+ * @restartable (unless SO_RCVTIMEO)
+ */
+int sendmmsg(int fd, struct mmsghdr *vec, unsigned vlen, int flags) {
+  int e, rc;
+  ssize_t sent;
+  unsigned i;
+  e = errno;
+  vlen = MIN(vlen, 1024);
+  if (IsLinux()) {
+    BEGIN_CANCELATION_POINT;
+    rc = sys_sendmmsg(fd, vec, vlen, flags);
+    END_CANCELATION_POINT;
+  } else {
+    rc = enosys();
+  }
+  if (rc == -1 && errno == ENOSYS) {  // not linux 3.0+
+    errno = e;
+    for (i = 0; i < vlen; ++i) {
+      if ((sent = sendmsg(fd, &vec[i].msg_hdr, flags)) == -1)
+        break;
+      vec[i].msg_len = sent;
+    }
+    if (i || !vlen) {
+      errno = e;
+      rc = i;
+    } else {
+      rc = -1;
+    }
+  }
+  STRACE("sendmmsg(%d, %p, %u, %#x) → %d% m", fd, vec, vlen, flags, rc);
+  return rc;
+}
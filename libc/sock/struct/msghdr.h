@@ -1,6 +1,7 @@
 #ifndef COSMOPOLITAN_LIBC_SOCK_STRUCT_MSGHDR_H_
 #define COSMOPOLITAN_LIBC_SOCK_STRUCT_MSGHDR_H_
 #include "libc/calls/struct/iovec.h"
+#include "libc/calls/struct/timespec.h"
 COSMOPOLITAN_C_START_
 
 struct msghdr {            /* Linux+NT ABI */
@@ -13,8 +14,15 @@ struct msghdr {            /* Linux+NT ABI */
   uint32_t msg_flags;      /* MSG_XXX */
 };
 
+struct mmsghdr {          /* Linux ABI */
+  struct msghdr msg_hdr;  /* message to send or receive */
+  uint32_t msg_len;       /* bytes transferred */
+};
+
 ssize_t recvmsg(int, struct msghdr *, int);
 ssize_t sendmsg(int, const struct msghdr *, int);
+int recvmmsg(int, struct mmsghdr *, unsigned, int, struct timespec *);
+int sendmmsg(int, struct mmsghdr *, unsigned, int);
 
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_LIBC_SOCK_STRUCT_MSGHDR_H_ */
@@ -15,6 +15,8 @@ struct msghdr_bsd {
 
 ssize_t sys_sendmsg(int, const struct msghdr *, int);
 ssize_t sys_recvmsg(int, struct msghdr *, int);
+int sys_sendmmsg(int, struct mmsghdr *, unsigned, int);
+int sys_recvmmsg(int, struct mmsghdr *, unsigned, int, struct timespec *);
 bool __asan_is_valid_msghdr(const struct msghdr *);
 
 COSMOPOLITAN_C_END_
@@ -9,6 +9,7 @@ COSMOPOLITAN_C_START_
 int sys_accept_nt(struct Fd *, struct sockaddr_storage *, int);
 int sys_bind_nt(struct Fd *, const void *, uint32_t);
 int sys_closesocket_nt(struct Fd *);
+int sys_epoll_close_nt(struct Fd *);
 int sys_ioctlsocket_nt(struct Fd *);
 int sys_connect_nt(struct Fd *, const void *, uint32_t);
 int sys_getpeername_nt(struct Fd *, void *, uint32_t *);
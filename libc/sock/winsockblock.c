@@ -84,7 +84,8 @@ __winsock_block(int64_t handle, uint32_t flags, bool nonblock,
     if (!(event = CreateEventTls()))
       return __winerr();
 
-    struct NtOverlapped overlap = {.hEvent = event};
+    // the low bit keeps completion ports bound by cosmo_ring() out of it
+    struct NtOverlapped overlap = {.hEvent = event | 1};
     bool32 ok = !StartSocketOp(handle, &overlap, &flags, arg);
     if (!ok && WSAGetLastError() == kNtErrorIoPending) {
       if (nonblock) {
@@ -31,6 +31,19 @@ ssize_t vappendf(char **, const char *, va_list) libcesque;
 ssize_t kappendf(char **, const char *, ...) libcesque;
 ssize_t kvappendf(char **, const char *, va_list) libcesque;
 
+#if defined(__GNUC__) && !defined(__STRICT_ANSI__)
+/* literal formats without directives or arguments are just copied */
+#define __appendf_literal(b, fmt, f, ...)                              \
+  (__builtin_constant_p(fmt) && sizeof(#__VA_ARGS__) == 1 &&           \
+           !__builtin_strchr(fmt, '%')                                 \
+       ? __appendd(b, fmt, __builtin_strlen(fmt))                      \
+       : (f)(b, fmt, ##__VA_ARGS__))
+#define __appendf(b, fmt, ...) \
+  __appendf_literal(b, fmt, __appendf, ##__VA_ARGS__)
+#define __kappendf(b, fmt, ...) \
+  __appendf_literal(b, fmt, __kappendf, ##__VA_ARGS__)
+#endif
+
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_LIBC_STDIO_APPEND_H_ */
 #endif /* _COSMO_SOURCE */
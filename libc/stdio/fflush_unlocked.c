@@ -38,6 +38,8 @@ int fflush_unlocked(FILE *f) {
       _weaken(free)(f->getln);
     f->getln = 0;
   }
+  if (f->bufmode == _IOTBF)
+    return __stdio_tbf_flush(f);
   if (f->fd != -1) {
     if (f->beg && !f->end && (f->oflags & O_ACCMODE) != O_RDONLY) {
       ssize_t rc;
@@ -43,9 +43,9 @@
 char *fgetln(FILE *stream, size_t *len) {
   char *res;
   ssize_t rc;
-  size_t n = 0;
   FLOCKFILE(stream);
-  if ((rc = getdelim_unlocked(&stream->getln, &n, '\n', stream)) > 0) {
+  if ((rc = getdelim_unlocked(&stream->getln, &stream->getlnsize, '\n',
+                              stream)) > 0) {
     if (len)
       *len = rc;
     res = stream->getln;
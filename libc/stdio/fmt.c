@@ -53,6 +53,7 @@
 #include "libc/math.h"
 #include "libc/mem/mem.h"
 #include "libc/mem/reverse.internal.h"
+#include "libc/nexgen32e/nexgen32e.h"
 #include "libc/runtime/fenv.h"
 #include "libc/runtime/internal.h"
 #include "libc/serialize.h"
@@ -257,7 +258,24 @@ static int __fmt_ntoa2(int out(const char *, void *, size_t), void *arg,
   // a value of 0 with precision 0 when # mandates that one be printed
   if (!value && log2base != 3)
     flags &= ~FLAGS_HASH;
-  if (value || !(flags & FLAGS_PRECISION)) {
+  if (!log2base && value <= UINT64_MAX && !(flags & FLAGS_GROUPING) &&
+      (value || !(flags & FLAGS_PRECISION))) {
+    // common case of %d and %u: peel off two decimal digits per divide
+    // since it halves the number of multiplications by the reciprocal.
+    uint64_t x = value;
+    while (x >= 100) {
+      digit = x % 100 * 2;
+      x /= 100;
+      buf[len++] = kDigitPairs[digit + 1];
+      buf[len++] = kDigitPairs[digit];
+    }
+    if (x >= 10) {
+      buf[len++] = kDigitPairs[x * 2 + 1];
+      buf[len++] = kDigitPairs[x * 2];
+    } else {
+      buf[len++] = '0' + x;
+    }
+  } else if (value || !(flags & FLAGS_PRECISION)) {
     count = 0;
     do {
       if (!log2base) {
@@ -562,6 +580,157 @@ static int __fmt_stoa(int out(const char *, void *, size_t), void *arg,
   return 0;
 }
 
+static uint128_t __fmt_pow10(int n) {
+  static const uint64_t kPow10[20] = {
+      1ull,
+      10ull,
+      100ull,
+      1000ull,
+      10000ull,
+      100000ull,
+      1000000ull,
+      10000000ull,
+      100000000ull,
+      1000000000ull,
+      10000000000ull,
+      100000000000ull,
+      1000000000000ull,
+      10000000000000ull,
+      100000000000000ull,
+      1000000000000000ull,
+      10000000000000000ull,
+      100000000000000000ull,
+      1000000000000000000ull,
+      10000000000000000000ull,
+  };
+  if (n < 20)
+    return kPow10[n];
+  return (uint128_t)kPow10[19] * kPow10[n - 19];
+}
+
+// computes floor(m * 2^e * 10^s) and whether it should be rounded up
+// using exact 128-bit integer math, or returns false if it won't fit
+static bool __fmt_scale(uint64_t m, int e, int s, uint64_t *out, int *up) {
+  uint128_t num, den, q, r;
+  if (s >= 0) {
+    if (s > 22)
+      return false;
+    num = (uint128_t)m * __fmt_pow10(s);
+    if (e >= 0) {
+      // m * 2^e * 10^s is an integer
+      if (e >= 64 || (num >> (64 - e)))
+        return false;
+      *out = num << e;
+      *up = 0;
+      return true;
+    }
+    if (-e >= 127)
+      return false;
+    den = (uint128_t)1 << -e;
+  } else {
+    if (-s > 38)
+      return false;
+    den = __fmt_pow10(-s);
+    if (e >= 0) {
+      if (e > 74)
+        return false;
+      num = (uint128_t)m << e;
+    } else {
+      if (-e >= 64 || (den >> (63 + e)))
+        return false;
+      num = m;
+      den <<= -e;
+    }
+  }
+  q = num / den;
+  r = num % den;
+  if (q >> 64)
+    return false;
+  // round half to even like dtoa()
+  r <<= 1;
+  *out = q;
+  *up = r > den || (r == den && (q & 1));
+  return true;
+}
+
+// does the common work of dtoa() modes 2 and 3 without bignums
+//
+// the result is identical to dtoa(), which rounds correctly with ties
+// going to even, because exact integer arithmetic is used. if numbers
+// need more than 128 bits of precision, then null is returned and the
+// caller should fall back to dtoa()
+static char *__fmt_dtoa_fast(double x, int mode, int ndigits, int *decpt,
+                             int *sign, char **rve, char buf[32]) {
+  union {
+    double d;
+    uint64_t u;
+  } u = {x};
+  uint64_t m, q;
+  int e, k, n, i, up;
+  if (FLT_ROUNDS != 1)
+    return 0;
+  e = u.u >> 52 & 0x7ff;
+  m = u.u & 0x000fffffffffffff;
+  if (e == 0x7ff)
+    return 0;
+  if (!e && !m) {
+    *sign = u.u >> 63;
+    *decpt = 1;
+    buf[0] = '0';
+    buf[1] = 0;
+    *rve = buf + 1;
+    return buf;
+  }
+  if (e) {
+    m |= 0x0010000000000000;
+  } else {
+    e = 1;
+  }
+  e -= 1075;
+  if (mode == 3) {
+    if (!__fmt_scale(m, e, ndigits, &q, &up))
+      return 0;
+    if ((q += up) >= 10000000000000000000ull || !q)
+      return 0;
+    for (n = 1; n < 19 && q >= __fmt_pow10(n); ++n) {
+    }
+    k = n - ndigits;
+  } else {
+    if (ndigits < 1 || ndigits > 17)
+      return 0;
+    n = ndigits;
+    // estimate k = floor(log10(x))
+    k = ((e + 63 - __builtin_clzll(m)) * 78913) >> 18;
+    for (i = 0;; ++i) {
+      if (i == 3 || !__fmt_scale(m, e, n - 1 - k, &q, &up))
+        return 0;
+      if (q >= __fmt_pow10(n)) {
+        ++k;
+      } else if (q < __fmt_pow10(n - 1)) {
+        --k;
+      } else {
+        break;
+      }
+    }
+    if ((q += up) == __fmt_pow10(n)) {
+      q /= 10;
+      ++k;
+    }
+    k += 1;
+  }
+  *sign = u.u >> 63;
+  *decpt = k;
+  for (i = n; i--;) {
+    buf[i] = '0' + q % 10;
+    q /= 10;
+  }
+  while (n > 1 && buf[n - 1] == '0')
+    --n;
+  buf[n] = 0;
+  *rve = buf + n;
+  return buf;
+}
+
 static void __fmt_dfpbits(union U *u, struct FPBits *b) {
   int ex, i;
   b->fpi = kFpiDbl;
@@ -879,7 +1048,7 @@ int __fmt(void *fn, void *arg, const char *format, va_list va, size_t *wrote) {
   unsigned char signbit, log2base;
   int c, k, i1, bw, rc, bex, prec1, decpt;
   int (*out)(const char *, void *, size_t);
-  char *se, *s0, *s, *q, qchar, special[8];
+  char *se, *s0, *s, *q, qchar, special[8], dtoabuf[32];
   int d, w, n, sign, prec, flags, width, lasterr;
 
   x = 0;
@@ -1196,12 +1365,15 @@ int __fmt(void *fn, void *arg, const char *format, va_list va, size_t *wrote) {
           prec = 6;
         if (!longdouble) {
           x = va_arg(va, double);
-          s = s0 = dtoa(x, 3, prec, &decpt, &fpb.sign, &se);
-          if (decpt == 9999) {
-            if (s && s[0] == 'N') {
-              fpb.kind = STRTOG_NaN;
-            } else {
-              fpb.kind = STRTOG_Infinite;
+          if (!(s = s0 = __fmt_dtoa_fast(x, 3, prec, &decpt, &fpb.sign, &se,
+                                         dtoabuf))) {
+            s = s0 = dtoa(x, 3, prec, &decpt, &fpb.sign, &se);
+            if (decpt == 9999) {
+              if (s && s[0] == 'N') {
+                fpb.kind = STRTOG_NaN;
+              } else {
+                fpb.kind = STRTOG_Infinite;
+              }
             }
           }
         } else {
@@ -1214,7 +1386,7 @@ int __fmt(void *fn, void *arg, const char *format, va_list va, size_t *wrote) {
           return -1;
         if (decpt == 9999 || decpt == -32768) {
         FormatDecpt9999Or32768:
-          if (s0)
+          if (s0 && s0 != dtoabuf)
             freedtoa(s0);
           bzero(special, sizeof(special));
           s = q = special;
@@ -1302,7 +1474,7 @@ int __fmt(void *fn, void *arg, const char *format, va_list va, size_t *wrote) {
         }
         while (--width >= 0)
           __FMT_PUT(' ');
-        if (s0)
+        if (s0 && s0 != dtoabuf)
           freedtoa(s0);
         break;
 
@@ -1314,12 +1486,15 @@ int __fmt(void *fn, void *arg, const char *format, va_list va, size_t *wrote) {
           prec = 1;
         if (!longdouble) {
           x = va_arg(va, double);
-          s = s0 = dtoa(x, 2, prec, &decpt, &fpb.sign, &se);
-          if (decpt == 9999) {
-            if (s && s[0] == 'N') {
-              fpb.kind = STRTOG_NaN;
-            } else {
-              fpb.kind = STRTOG_Infinite;
+          if (!(s = s0 = __fmt_dtoa_fast(x, 2, prec, &decpt, &fpb.sign, &se,
+                                         dtoabuf))) {
+            s = s0 = dtoa(x, 2, prec, &decpt, &fpb.sign, &se);
+            if (decpt == 9999) {
+              if (s && s[0] == 'N') {
+                fpb.kind = STRTOG_NaN;
+              } else {
+                fpb.kind = STRTOG_Infinite;
+              }
             }
           }
         } else {
@@ -1362,12 +1537,15 @@ int __fmt(void *fn, void *arg, const char *format, va_list va, size_t *wrote) {
           prec = 0;
         if (!longdouble) {
           x = va_arg(va, double);
-          s = s0 = dtoa(x, 2, prec + 1, &decpt, &fpb.sign, &se);
-          if (decpt == 9999) {
-            if (s && s[0] == 'N') {
-              fpb.kind = STRTOG_NaN;
-            } else {
-              fpb.kind = STRTOG_Infinite;
+          if (!(s = s0 = __fmt_dtoa_fast(x, 2, prec + 1, &decpt, &fpb.sign,
+                                         &se, dtoabuf))) {
+            s = s0 = dtoa(x, 2, prec + 1, &decpt, &fpb.sign, &se);
+            if (decpt == 9999) {
+              if (s && s[0] == 'N') {
+                fpb.kind = STRTOG_NaN;
+              } else {
+                fpb.kind = STRTOG_Infinite;
+              }
             }
           }
         } else {
@@ -1442,7 +1620,8 @@ int __fmt(void *fn, void *arg, const char *format, va_list va, size_t *wrote) {
         while (--width >= 0) {
           __FMT_PUT(' ');
         }
-        freedtoa(s0);
+        if (s0 != dtoabuf)
+          freedtoa(s0);
         break;
 
       case 'A':
@@ -27,6 +27,7 @@
 #include "libc/stdio/stdio.h"
 #include "libc/str/str.h"
 #include "libc/sysv/consts/o.h"
+#include "libc/sysv/consts/posix.h"
 #include "libc/sysv/errfuns.h"
 
 static ssize_t readvall(FILE *f, struct iovec *iov, int iovlen, size_t need) {
@@ -157,6 +158,12 @@ size_t fread_unlocked(void *buf, size_t stride, size_t count, FILE *f) {
   } else {
     iov[1].iov_base = NULL;
     iov[1].iov_len = 0;
+    // the caller is reading directly into their own memory, in chunks
+    // bigger than our buffer, so ask the kernel to read ahead further
+    if (!f->readahead && n >= f->size) {
+      f->readahead = 1;
+      posix_fadvise(f->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
   }
   rc = readvall(f, iov, 2, need);
   if (rc == -1)
@@ -54,6 +54,7 @@ FILE *freopen(const char *pathname, const char *mode, FILE *stream) {
         stream->oflags = flags;
         stream->beg = 0;
         stream->end = 0;
+        stream->readahead = 0;
         res = stream;
       } else {
         res = NULL;
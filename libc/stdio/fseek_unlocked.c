@@ -24,6 +24,7 @@
 #include "libc/stdio/stdio.h"
 #include "libc/str/str.h"
 #include "libc/sysv/consts/o.h"
+#include "libc/sysv/consts/posix.h"
 
 /**
  * Repositions open file stream.
@@ -51,6 +52,11 @@ int fseek_unlocked(FILE *f, int64_t offset, int whence) {
       f->beg = 0;
       f->end = 0;
       res = 0;
+      // seeking suggests the access pattern isn't sequential after all
+      if (f->readahead) {
+        f->readahead = 0;
+        posix_fadvise(f->fd, 0, 0, POSIX_FADV_NORMAL);
+      }
     } else {
       f->state = errno == ESPIPE ? EBADF : errno;
       res = -1;
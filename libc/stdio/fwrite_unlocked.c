@@ -114,6 +114,10 @@ size_t fwrite_unlocked(const void *data, size_t stride, size_t count, FILE *f) {
   if (!n)
     return 0;
 
+  // hand off to calling thread's line buffer
+  if (f->bufmode == _IOTBF)
+    return __stdio_tbf_write(f, data, n) ? 0 : count;
+
   // extend open_memstream() buffer
   if (f->memstream_bufp) {
     size_t need;
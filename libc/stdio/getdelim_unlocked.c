@@ -18,6 +18,7 @@
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/calls/calls.h"
 #include "libc/errno.h"
+#include "libc/macros.h"
 #include "libc/mem/mem.h"
 #include "libc/stdio/internal.h"
 #include "libc/stdio/stdio.h"
@@ -49,7 +50,9 @@ ssize_t getdelim_unlocked(char **s, size_t *n, int delim, FILE *f) {
     if ((p = memchr(f->buf + f->beg, delim, m)))
       m = p + 1 - (f->buf + f->beg);
     if (i + m + 1 > *n) {
-      n2 = i + m + 1;
+      // grow geometrically so long lines spanning many refills of the
+      // stream buffer don't get reallocated and copied on every one
+      n2 = MAX(i + m + 1, *n + (*n >> 1));
       s2 = realloc(*s, n2);
       if (s2) {
         *s = s2;
@@ -13,10 +13,11 @@
 COSMOPOLITAN_C_START_
 
 struct FILE {
-  char bufmode;  /* _IOFBF, _IOLBF, or _IONBF */
+  char bufmode;  /* _IOFBF, _IOLBF, _IONBF, or _IOTBF */
   char freethis; /* fclose() should free(this) */
   char freebuf;  /* fclose() should free(this->buf) */
   char forking;  /* used by fork() implementation */
+  char readahead; /* fread() told kernel we're reading sequentially */
   int oflags;    /* O_RDONLY, etc. */
   int state;     /* 0=OK, -1=EOF, >0=errno */
   int fd;        /* ≥0=fd, -1=closed|buffer */
@@ -30,6 +31,7 @@ struct FILE {
   pthread_mutex_t lock;
   struct Dll elem;
   char *getln;
+  size_t getlnsize;
   size_t *memstream_sizep;
 };
 
@@ -47,16 +49,20 @@ void __stdio_unref(FILE *);
 void __stdio_unref_unlocked(FILE *);
 bool __stdio_isok(FILE *);
 FILE *__stdio_alloc(void);
+int __stdio_tbf_write(FILE *, const void *, size_t);
+int __stdio_tbf_flush(FILE *);
 
 /* use these in stdio wrapper functions that are cancelation points */
-#define FLOCKFILE(f)                                     \
-  struct _pthread_cleanup_buffer cb;                     \
-  if (__isthreaded >= 2) {                               \
-    flockfile(f);                                        \
-    __pthread_cleanup_push(&cb, (void *)funlockfile, f); \
+/* streams in _IOTBF mode only touch thread local state so skip lock */
+#define FLOCKFILE(f)                                           \
+  struct _pthread_cleanup_buffer cb;                           \
+  bool cb_locked = __isthreaded >= 2 && (f)->bufmode != _IOTBF; \
+  if (cb_locked) {                                             \
+    flockfile(f);                                              \
+    __pthread_cleanup_push(&cb, (void *)funlockfile, f);       \
   }
-#define FUNLOCKFILE(f)   \
-  if (__isthreaded >= 2) \
+#define FUNLOCKFILE(f) \
+  if (cb_locked)       \
   __pthread_cleanup_pop(&cb, 1)
 
 COSMOPOLITAN_C_END_
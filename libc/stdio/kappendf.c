@@ -30,7 +30,7 @@
  * @note O(1) amortized buffer growth
  * @see kprintf()
  */
-ssize_t kappendf(char **b, const char *fmt, ...) {
+ssize_t(kappendf)(char **b, const char *fmt, ...) {
   int n;
   va_list va;
   va_start(va, fmt);
@@ -1,204 +1,394 @@
-/*-*- mode:c;indent-tabs-mode:t;c-basic-offset:8;tab-width:8;coding:utf-8   -*-│
-│ vi: set noet ft=c ts=8 sw=8 fenc=utf-8                                   :vi │
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
 ╞══════════════════════════════════════════════════════════════════════════════╡
-│ Copyright (c) 1991, 1993                                                     │
-│      The Regents of the University of California.  All rights reserved.      │
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
 │                                                                              │
-│ Redistribution and use in source and binary forms, with or without           │
-│ modification, are permitted provided that the following conditions           │
-│ are met:                                                                     │
-│  1. Redistributions of source code must retain the above copyright           │
-│     notice, this list of conditions and the following disclaimer.            │
-│  2. Redistributions in binary form must reproduce the above copyright        │
-│     notice, this list of conditions and the following disclaimer in the      │
-│     documentation and/or other materials provided with the distribution.     │
-│  3. Neither the name of the University nor the names of its contributors     │
-│     may be used to endorse or promote products derived from this software    │
-│     without specific prior written permission.                               │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
 │                                                                              │
-│ THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND      │
-│ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE        │
-│ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   │
-│ ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE     │
-│ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL   │
-│ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS      │
-│ OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)        │
-│ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT   │
-│ LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY    │
-│ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF       │
-│ SUCH DAMAGE.                                                                 │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/dce.h"
 #include "libc/macros.h"
 #include "libc/mem/alg.h"
 #include "libc/str/str.h"
-__static_yoink("openbsd_sorting_notice");
-// clang-format off
-
-#define SWAPTYPE_BYTEV	1
-#define SWAPTYPE_INTV	2
-#define SWAPTYPE_LONGV	3
-#define SWAPTYPE_INT	4
-#define SWAPTYPE_LONG	5
-
-#define CMPPAR		int (*cmp)(const void *, const void *, void *),void *arg
-#define CMPARG		cmp, arg
-#define CMP(a, b)	cmp(a, b, arg)
-#define min(a, b)	(a) < (b) ? a : b
-
-static inline char	*med3(char *, char *, char *, CMPPAR);
-static inline void	 swapfunc(char *, char *, size_t, int);
-
-#define TYPE_ALIGNED(TYPE, a, es)			\
-	(((char *)a - (char *)0) % sizeof(TYPE) == 0 && es % sizeof(TYPE) == 0)
-
-#define swapcode(TYPE, parmi, parmj, n) { 		\
-	size_t i = (n) / sizeof (TYPE); 		\
-	TYPE *pi = (TYPE *) (parmi); 			\
-	TYPE *pj = (TYPE *) (parmj); 			\
-	do { 						\
-		TYPE	t = *pi;			\
-		*pi++ = *pj;				\
-		*pj++ = t;				\
-	} while (--i > 0);				\
+
+__notice(pdqsort_notice, "\
+pdqsort (zlib License)\n\
+Copyright 2021 Orson Peters");
+
+// pattern-defeating quicksort
+//
+// this is orson peters' pdqsort adapted for untyped arrays. it's an
+// introsort that partitions with blocks of offsets so that deciding
+// which side an element belongs on doesn't need a branch, it notices
+// when a partition did no work and tries finishing it off with a
+// bounded insertion sort, it switches to a partitioner that collects
+// elements equal to the pivot when the pivot equals its predecessor,
+// and it shuffles elements around when a partition was unbalanced so
+// that patterns which defeat median-of-three pivoting can't persist.
+//
+// see arxiv.org/abs/2106.05123
+
+#define INSERTION_THRESHOLD 24
+#define NINTHER_THRESHOLD   128
+#define PARTIAL_LIMIT       8
+#define BLOCK_SIZE          64
+
+#define SWAP_BYTES 0
+#define SWAP_LONGS 1
+#define SWAP_INT   2
+#define SWAP_LONG  3
+#define SWAP_PAIR  4
+
+struct QsortContext {
+  size_t es;
+  int swaptype;
+  int (*cmp)(const void *, const void *, void *);
+  void *arg;
+};
+
+#define CMP(a, b) q->cmp(a, b, q->arg)
+#define LESS(a, b) (CMP(a, b) < 0)
+
+static void qsort_swapfunc(char *a, char *b, size_t n, int swaptype) {
+  if (swaptype == SWAP_BYTES) {
+    do {
+      char t = *a;
+      *a++ = *b;
+      *b++ = t;
+    } while (--n);
+  } else {
+    long *x = (long *)a;
+    long *y = (long *)b;
+    n /= sizeof(long);
+    do {
+      long t = *x;
+      *x++ = *y;
+      *y++ = t;
+    } while (--n);
+  }
+}
+
+static inline void qsort_swap(struct QsortContext *q, char *a, char *b) {
+  switch (q->swaptype) {
+    case SWAP_INT: {
+      int t = *(int *)a;
+      *(int *)a = *(int *)b;
+      *(int *)b = t;
+      break;
+    }
+    case SWAP_LONG: {
+      long t = *(long *)a;
+      *(long *)a = *(long *)b;
+      *(long *)b = t;
+      break;
+    }
+    case SWAP_PAIR: {
+      long t0 = ((long *)a)[0];
+      long t1 = ((long *)a)[1];
+      ((long *)a)[0] = ((long *)b)[0];
+      ((long *)a)[1] = ((long *)b)[1];
+      ((long *)b)[0] = t0;
+      ((long *)b)[1] = t1;
+      break;
+    }
+    default:
+      qsort_swapfunc(a, b, q->es, q->swaptype);
+      break;
+  }
+}
+
+static inline void qsort_sort2(struct QsortContext *q, char *a, char *b) {
+  if (LESS(b, a))
+    qsort_swap(q, a, b);
+}
+
+static inline void qsort_sort3(struct QsortContext *q, char *a, char *b,
+                               char *c) {
+  qsort_sort2(q, a, b);
+  qsort_sort2(q, b, c);
+  qsort_sort2(q, a, b);
+}
+
+// sorts [begin,end) using insertion sort. if it isn't the leftmost
+// range then the element before begin is known to be no greater than
+// anything in the range, which lets the inner loop skip bounds checks
+static void qsort_insertion(struct QsortContext *q, char *begin, char *end,
+                            bool leftmost) {
+  char *cur, *p;
+  size_t es = q->es;
+  for (cur = begin + es; cur < end; cur += es) {
+    if (leftmost) {
+      for (p = cur; p > begin && LESS(p, p - es); p -= es)
+        qsort_swap(q, p, p - es);
+    } else {
+      for (p = cur; LESS(p, p - es); p -= es)
+        qsort_swap(q, p, p - es);
+    }
+  }
+}
+
+// attempts insertion sort on [begin,end), giving up once more than a
+// few elements have been moved. returns true if range is now sorted
+static bool qsort_partial_insertion(struct QsortContext *q, char *begin,
+                                    char *end) {
+  char *cur, *p;
+  size_t limit = 0;
+  size_t es = q->es;
+  if (begin == end)
+    return true;
+  for (cur = begin + es; cur < end; cur += es) {
+    if (limit > PARTIAL_LIMIT)
+      return false;
+    for (p = cur; p > begin && LESS(p, p - es); p -= es) {
+      qsort_swap(q, p, p - es);
+      ++limit;
+    }
+  }
+  return true;
+}
+
+// partitions [begin,end) around pivot *begin so elements equal to the
+// pivot go on the right. returns pivot position. `*out_already` is set
+// if no elements needed to be swapped
+static char *qsort_partition_right(struct QsortContext *q, char *begin,
+                                   char *end, bool *out_already) {
+  size_t es = q->es;
+  char *pivot = begin;
+  char *first = begin;
+  char *last = end;
+  char *base_l, *base_r;
+  size_t i, num, num_l, num_r, start_l, start_r;
+  size_t num_unknown, left_split, right_split;
+  unsigned char offsets_l[BLOCK_SIZE];
+  unsigned char offsets_r[BLOCK_SIZE];
+
+  // find first element >= pivot, which exists due to median-of-three
+  while (LESS(first += es, pivot)) {
+  }
+
+  // find last element < pivot, which needs a guard if there's nothing
+  // before first that's less than the pivot
+  if (first - es == begin) {
+    while (first < last && !LESS(last -= es, pivot)) {
+    }
+  } else {
+    while (!LESS(last -= es, pivot)) {
+    }
+  }
+
+  if ((*out_already = first >= last)) {
+    qsort_swap(q, begin, first - es);
+    return first - es;
+  }
+
+  qsort_swap(q, first, last);
+  first += es;
+
+  // block partitioning from "blockquicksort: avoiding branch
+  // mispredictions in quicksort" by edelkamp and weiss. offsets of
+  // misplaced elements are collected by adding the comparison result
+  // to the count rather than branching on it
+  base_l = first;
+  base_r = last;
+  num_l = num_r = start_l = start_r = 0;
+  while (first < last) {
+    num_unknown = (last - first) / es;
+    left_split = num_l ? 0 : num_r ? num_unknown : num_unknown / 2;
+    right_split = num_r ? 0 : num_unknown - left_split;
+    if (left_split > BLOCK_SIZE)
+      left_split = BLOCK_SIZE;
+    if (right_split > BLOCK_SIZE)
+      right_split = BLOCK_SIZE;
+    for (i = 0; i < left_split; ++i) {
+      offsets_l[num_l] = i;
+      num_l += !LESS(first, pivot);
+      first += es;
+    }
+    for (i = 0; i < right_split;) {
+      offsets_r[num_r] = ++i;
+      num_r += LESS(last -= es, pivot);
+    }
+    num = MIN(num_l, num_r);
+    for (i = 0; i < num; ++i)
+      qsort_swap(q, base_l + offsets_l[start_l + i] * es,
+                 base_r - offsets_r[start_r + i] * es);
+    num_l -= num;
+    num_r -= num;
+    start_l += num;
+    start_r += num;
+    if (!num_l) {
+      start_l = 0;
+      base_l = first;
+    }
+    if (!num_r) {
+      start_r = 0;
+      base_r = last;
+    }
+  }
+
+  // move whatever's left of the unfinished block to the middle
+  if (num_l) {
+    while (num_l--)
+      qsort_swap(q, base_l + offsets_l[start_l + num_l] * es, last -= es);
+    first = last;
+  }
+  if (num_r) {
+    while (num_r--) {
+      qsort_swap(q, base_r - offsets_r[start_r + num_r] * es, first);
+      first += es;
+    }
+  }
+
+  qsort_swap(q, begin, first - es);
+  return first - es;
 }
 
-static inline void
-swapfunc(char *a, char *b, size_t n, int swaptype)
-{
-	switch (swaptype) {
-	case SWAPTYPE_INT:
-	case SWAPTYPE_INTV:
-		swapcode(int, a, b, n);
-		break;
-	case SWAPTYPE_LONG:
-	case SWAPTYPE_LONGV:
-		swapcode(long, a, b, n);
-		break;
-	default:
-		swapcode(char, a, b, n);
-		break;
-	}
+// partitions [begin,end) around pivot *begin so elements equal to the
+// pivot go on the left. this is used when the element before begin is
+// equal to the pivot, in which case the left side is already sorted
+static char *qsort_partition_left(struct QsortContext *q, char *begin,
+                                  char *end) {
+  size_t es = q->es;
+  char *pivot = begin;
+  char *first = begin;
+  char *last = end;
+  while (LESS(pivot, last -= es)) {
+  }
+  if (last + es == end) {
+    while (first < last && !LESS(pivot, first += es)) {
+    }
+  } else {
+    while (!LESS(pivot, first += es)) {
+    }
+  }
+  while (first < last) {
+    qsort_swap(q, first, last);
+    while (LESS(pivot, last -= es)) {
+    }
+    while (!LESS(pivot, first += es)) {
+    }
+  }
+  qsort_swap(q, begin, last);
+  return last;
 }
 
-#define swap(a, b)	do {				\
-	switch (swaptype) {				\
-	case SWAPTYPE_INT: {				\
-		int t = *(int *)(a);			\
-		*(int *)(a) = *(int *)(b);		\
-		*(int *)(b) = t;			\
-		break;					\
-	    }						\
-	case SWAPTYPE_LONG: {				\
-		long t = *(long *)(a);			\
-		*(long *)(a) = *(long *)(b);		\
-		*(long *)(b) = t;			\
-		break;					\
-	    }						\
-	default:					\
-		swapfunc(a, b, es, swaptype);		\
-	}						\
-} while (0)
-
-#define vecswap(a, b, n) 	if ((n) > 0) swapfunc(a, b, n, swaptype)
-
-static inline char *
-med3(char *a, char *b, char *c, CMPPAR)
-{
-	return CMP(a, b) < 0 ?
-	       (CMP(b, c) < 0 ? b : (CMP(a, c) < 0 ? c : a ))
-	      :(CMP(b, c) > 0 ? b : (CMP(a, c) < 0 ? a : c ));
+static void qsort_pdq(struct QsortContext *q, char *begin, char *end,
+                      int bad_allowed, bool leftmost) {
+  bool already;
+  char *pivot_pos;
+  size_t es = q->es;
+  size_t n, s2, l_size, r_size, k;
+  for (;;) {
+    n = (end - begin) / es;
+    if (n < INSERTION_THRESHOLD) {
+      qsort_insertion(q, begin, end, leftmost);
+      return;
+    }
+
+    // choose pivot as median of three, or pseudomedian of nine
+    s2 = n / 2;
+    if (n > NINTHER_THRESHOLD) {
+      qsort_sort3(q, begin, begin + s2 * es, end - es);
+      qsort_sort3(q, begin + es, begin + (s2 - 1) * es, end - 2 * es);
+      qsort_sort3(q, begin + 2 * es, begin + (s2 + 1) * es, end - 3 * es);
+      qsort_sort3(q, begin + (s2 - 1) * es, begin + s2 * es,
+                  begin + (s2 + 1) * es);
+      qsort_swap(q, begin, begin + s2 * es);
+    } else {
+      qsort_sort3(q, begin + s2 * es, begin, end - es);
+    }
+
+    // if the pivot equals the element before this range, then there
+    // can't be anything smaller than the pivot here, so we put all the
+    // elements equal to it on the left and only process the rest
+    if (!leftmost && !LESS(begin - es, begin)) {
+      begin = qsort_partition_left(q, begin, end) + es;
+      continue;
+    }
+
+    pivot_pos = qsort_partition_right(q, begin, end, &already);
+    l_size = (pivot_pos - begin) / es;
+    r_size = (end - (pivot_pos + es)) / es;
+
+    if (l_size < n / 8 || r_size < n / 8) {
+      // bad partition. fall back to heapsort if happening too often
+      // otherwise shuffle elements to break up the pattern
+      if (!--bad_allowed)
+        if (!heapsort_r(begin, n, es, q->cmp, q->arg))
+          return;
+      if (l_size >= INSERTION_THRESHOLD) {
+        k = l_size / 4;
+        qsort_swap(q, begin, begin + k * es);
+        qsort_swap(q, pivot_pos - es, pivot_pos - k * es);
+        if (l_size > NINTHER_THRESHOLD) {
+          qsort_swap(q, begin + es, begin + (k + 1) * es);
+          qsort_swap(q, begin + 2 * es, begin + (k + 2) * es);
+          qsort_swap(q, pivot_pos - 2 * es, pivot_pos - (k + 1) * es);
+          qsort_swap(q, pivot_pos - 3 * es, pivot_pos - (k + 2) * es);
+        }
+      }
+      if (r_size >= INSERTION_THRESHOLD) {
+        k = r_size / 4;
+        qsort_swap(q, pivot_pos + es, pivot_pos + (1 + k) * es);
+        qsort_swap(q, end - es, end - k * es);
+        if (r_size > NINTHER_THRESHOLD) {
+          qsort_swap(q, pivot_pos + 2 * es, pivot_pos + (2 + k) * es);
+          qsort_swap(q, pivot_pos + 3 * es, pivot_pos + (3 + k) * es);
+          qsort_swap(q, end - 2 * es, end - (1 + k) * es);
+          qsort_swap(q, end - 3 * es, end - (2 + k) * es);
+        }
+      }
+    } else if (already &&
+               qsort_partial_insertion(q, begin, pivot_pos) &&
+               qsort_partial_insertion(q, pivot_pos + es, end)) {
+      // if no elements were moved then the input might be sorted
+      return;
+    }
+
+    // recurse into smaller side and loop on the larger one so the
+    // stack doesn't grow more than logarithmically
+    if (l_size < r_size) {
+      qsort_pdq(q, begin, pivot_pos, bad_allowed, leftmost);
+      begin = pivot_pos + es;
+      leftmost = false;
+    } else {
+      qsort_pdq(q, pivot_pos + es, end, bad_allowed, false);
+      end = pivot_pos;
+    }
+  }
 }
 
-static void
-introsort(char *a, size_t n, size_t es, size_t maxdepth, int swaptype, CMPPAR)
-{
-	char *pa, *pb, *pc, *pd, *pl, *pm, *pn;
-	int cmp_result;
-	size_t r, s;
-
-loop:	if (n < 7) {
-		for (pm = a + es; pm < a + n * es; pm += es)
-			for (pl = pm; pl > a && CMP(pl - es, pl) > 0;
-			     pl -= es)
-				swap(pl, pl - es);
-		return;
-	}
-	if (maxdepth == 0) {
-		if (heapsort_r(a, n, es, CMPARG) == 0)
-			return;
-	}
-	maxdepth--;
-	pm = a + (n / 2) * es;
-	if (n > 7) {
-		pl = a;
-		pn = a + (n - 1) * es;
-		if (n > 40) {
-			s = (n / 8) * es;
-			pl = med3(pl, pl + s, pl + 2 * s, CMPARG);
-			pm = med3(pm - s, pm, pm + s, CMPARG);
-			pn = med3(pn - 2 * s, pn - s, pn, CMPARG);
-		}
-		pm = med3(pl, pm, pn, CMPARG);
-	}
-	swap(a, pm);
-	pa = pb = a + es;
-	pc = pd = a + (n - 1) * es;
-	for (;;) {
-		while (pb <= pc && (cmp_result = CMP(pb, a)) <= 0) {
-			if (cmp_result == 0) {
-				swap(pa, pb);
-				pa += es;
-			}
-			pb += es;
-		}
-		while (pb <= pc && (cmp_result = CMP(pc, a)) >= 0) {
-			if (cmp_result == 0) {
-				swap(pc, pd);
-				pd -= es;
-			}
-			pc -= es;
-		}
-		if (pb > pc)
-			break;
-		swap(pb, pc);
-		pb += es;
-		pc -= es;
-	}
-
-	pn = a + n * es;
-	r = min(pa - a, pb - pa);
-	vecswap(a, pb - r, r);
-	r = min(pd - pc, pn - pd - es);
-	vecswap(pb, pn - r, r);
-	/*
-	 * To save stack space we sort the smaller side of the partition first
-	 * using recursion and eliminate tail recursion for the larger side.
-	 */
-	r = pb - pa;
-	s = pd - pc;
-	if (r < s) {
-		/* Recurse for 1st side, iterate for 2nd side. */
-		if (s > es) {
-			if (r > es) {
-				introsort(a, r / es, es, maxdepth,
-				    swaptype, CMPARG);
-			}
-			a = pn - s;
-			n = s / es;
-			goto loop;
-		}
-	} else {
-		/* Recurse for 2nd side, iterate for 1st side. */
-		if (r > es) {
-			if (s > es) {
-				introsort(pn - s, s / es, es, maxdepth,
-				    swaptype, CMPARG);
-			}
-			n = r / es;
-			goto loop;
-		}
-	}
+// returns true if array was already sorted, or reverse sorted, in
+// which case it's been reversed. this costs only a few comparisons
+// on input that isn't a single run
+static bool qsort_run(struct QsortContext *q, char *a, size_t n) {
+  size_t i, es = q->es;
+  char *p, *e = a + n * es;
+  if (n < 2)
+    return true;
+  if (!LESS(a + es, a)) {
+    for (p = a + es; p + es < e && !LESS(p + es, p); p += es) {
+    }
+    return p + es == e;
+  } else {
+    for (p = a + es; p + es < e && LESS(p + es, p); p += es) {
+    }
+    if (p + es != e)
+      return false;
+    for (i = 0; i < n / 2; ++i)
+      qsort_swap(q, a + i * es, e - (i + 1) * es);
+    return true;
+  }
 }
 
 /**
@@ -211,54 +401,51 @@ loop:	if (n < 7) {
  * @param arg is passed to callback
  * @see qsort()
  */
-void
-qsort_r(void *a, size_t n, size_t es,
-	int (*cmp)(const void *, const void *, void *), void *arg)
-{
-	size_t i, maxdepth = 0;
-	int swaptype;
-
-	/* smoothsort is slower than quicksort but it's secure, and
-	   it doesn't schlep in heapsort, malloc, and libunwind. */
-	if (IsTiny())
-		return smoothsort_r(a, n, es, cmp, arg);
-
-	/* Approximate 2*ceil(lg(n + 1)) */
-	for (i = n; i > 0; i >>= 1)
-		maxdepth++;
-	maxdepth *= 2;
-
-	if (TYPE_ALIGNED(long, a, es))
-		swaptype = es == sizeof(long) ? SWAPTYPE_LONG : SWAPTYPE_LONGV;
-	else if (sizeof(int) != sizeof(long) && TYPE_ALIGNED(int, a, es))
-		swaptype = es == sizeof(int) ? SWAPTYPE_INT : SWAPTYPE_INTV;
-	else
-		swaptype = SWAPTYPE_BYTEV;
-
-	introsort(a, n, es, maxdepth, swaptype, CMPARG);
+void qsort_r(void *a, size_t n, size_t es,
+             int cmp(const void *, const void *, void *), void *arg) {
+  size_t i;
+  int bad_allowed;
+  struct QsortContext q;
+
+  // smoothsort is slower than quicksort but it's secure, and
+  // it doesn't schlep in heapsort, malloc, and libunwind.
+  if (IsTiny())
+    return smoothsort_r(a, n, es, cmp, arg);
+
+  if (!es)
+    return;
+  q.es = es;
+  q.cmp = cmp;
+  q.arg = arg;
+  if ((uintptr_t)a % sizeof(long) || es % sizeof(long)) {
+    if (es == sizeof(int) && !((uintptr_t)a % sizeof(int)))
+      q.swaptype = SWAP_INT;
+    else
+      q.swaptype = SWAP_BYTES;
+  } else if (es == sizeof(long)) {
+    q.swaptype = SWAP_LONG;
+  } else if (es == 2 * sizeof(long)) {
+    q.swaptype = SWAP_PAIR;
+  } else {
+    q.swaptype = SWAP_LONGS;
+  }
+
+  if (qsort_run(&q, a, n))
+    return;
+  for (bad_allowed = 0, i = n; i; i >>= 1)
+    ++bad_allowed;
+  qsort_pdq(&q, a, (char *)a + n * es, bad_allowed, true);
 }
 
 /**
  * Sorts array.
  *
- * This implementation uses the Quicksort routine from Bentley &
- * McIlroy's "Engineering a Sort Function", 1992, Bell Labs.
- *
- * This version differs from Bentley & McIlroy in the following ways:
- * 
- * 1. The partition value is swapped into a[0] instead of being stored
- *    out of line.
- *
- * 2. The swap function can swap 32-bit aligned elements on 64-bit
- *    platforms instead of swapping them as byte-aligned.
- *
- * 3. It uses David Musser's introsort algorithm to fall back to
- *    heapsort(3) when the recursion depth reaches 2*lg(n + 1). This
- *    avoids quicksort's quadratic behavior for pathological input
- *    without appreciably changing the average run time.
- *
- * 4. Tail recursion is eliminated when sorting the larger of two
- *    subpartitions to save stack space.
+ * This implementation uses Orson Peters' pattern-defeating quicksort,
+ * which is an introsort that falls back to heapsort(3) rather than
+ * going quadratic on pathological input. It partitions with blocks of
+ * offsets to avoid branching on the comparison result, runs in linear
+ * time on sorted or reverse sorted input, and handles input with many
+ * duplicate elements efficiently.
  *
  * @param a is base of array
  * @param n is item count
@@ -269,8 +456,7 @@ qsort_r(void *a, size_t n, size_t es,
  * @see qsort_r()
  * @see djbsort()
  */
-void
-qsort(void *a, size_t n, size_t es, int (*cmp)(const void *, const void *))
-{
-	qsort_r(a, n, es, (void *)cmp, 0);
+void qsort(void *a, size_t n, size_t es,
+           int cmp(const void *, const void *)) {
+  qsort_r(a, n, es, (void *)cmp, 0);
 }
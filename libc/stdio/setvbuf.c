@@ -20,6 +20,7 @@
 #include "libc/runtime/runtime.h"
 #include "libc/stdio/internal.h"
 #include "libc/stdio/stdio.h"
+#include "libc/sysv/consts/o.h"
 #include "libc/sysv/errfuns.h"
 
 /**
@@ -31,16 +32,26 @@
  * this implementation ensures that buffering behavior matches the
  * specified mode exactly.
  *
- * @param mode may be _IOFBF, _IOLBF, or _IONBF
+ * @param mode may be _IOFBF, _IOLBF, _IONBF, or _IOTBF which is line
+ *     buffering where each thread has a buffer of its own, so whole lines
+ *     from different threads don't interleave and writing to the stream
+ *     needn't acquire its lock; the stream must be write-only and outlive
+ *     any thread holding a partial line, which is flushed on thread exit
  * @param buf may optionally be non-NULL to set the stream's underlying
  *     buffer which the caller still owns and won't free, otherwise the
  *     existing buffer is used
  * @param size is ignored if buf is NULL
  * @return 0 on success or -1 on error
+ * @raise EINVAL if `mode` is `_IOTBF` and `f` isn't a write-only file
  */
 int setvbuf(FILE *f, char *buf, int mode, size_t size) {
+  if (mode == _IOTBF &&
+      (f->fd == -1 || (f->oflags & O_ACCMODE) != O_WRONLY))
+    return einval();
   flockfile(f);
   if (f->fd != -1) {
+    if ((mode == _IOTBF) != (f->bufmode == _IOTBF))
+      fflush_unlocked(f);
     if (mode == _IONBF) {
       if (f->freebuf)
         free(f->buf);
@@ -5,6 +5,7 @@
 #define _IOFBF 0  /* fully buffered */
 #define _IOLBF 1  /* line buffered */
 #define _IONBF 2  /* no buffering */
+#define _IOTBF 3  /* line buffered per thread (cosmo) */
 
 #define L_tmpnam     20
 #define L_ctermid    20
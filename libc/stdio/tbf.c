@@ -0,0 +1,158 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/calls/struct/iovec.h"
+#include "libc/errno.h"
+#include "libc/mem/mem.h"
+#include "libc/stdio/internal.h"
+#include "libc/str/str.h"
+#include "libc/thread/thread.h"
+
+/**
+ * @fileoverview per-thread line buffering for stdio streams
+ *
+ * When setvbuf() puts a stream in `_IOTBF` mode, each thread collects
+ * its output in a buffer of its own, and only complete lines are sent
+ * to the file descriptor, using a single writev() call which combines
+ * the pending fragment with the new data. The FILE lock isn't taken.
+ * Lines therefore never interleave, so long as each line fits within
+ * BUFSIZ, and the kernel writes it atomically, which is the case with
+ * pipes for lines under PIPE_BUF and files opened with O_APPEND.
+ */
+
+struct StdioThreadBuffer {
+  FILE *f;
+  int fd;
+  size_t n;
+  char p[BUFSIZ];
+};
+
+static pthread_key_t __stdio_tbf_key;
+static pthread_once_t __stdio_tbf_once = PTHREAD_ONCE_INIT;
+static _Thread_local struct StdioThreadBuffer *__stdio_tbf;
+
+static int __stdio_tbf_writev(int fd, struct iovec *iov, int iovlen) {
+  ssize_t rc;
+  size_t wrote;
+  for (;;) {
+    while (iovlen && !iov->iov_len) {
+      --iovlen;
+      ++iov;
+    }
+    if (!iovlen)
+      return 0;
+    if ((rc = writev(fd, iov, iovlen)) == -1)
+      return -1;
+    for (wrote = rc; wrote && wrote >= iov->iov_len; --iovlen, ++iov)
+      wrote -= iov->iov_len;
+    if (iovlen) {
+      iov->iov_base += wrote;
+      iov->iov_len -= wrote;
+    }
+  }
+}
+
+static int __stdio_tbf_drain(struct StdioThreadBuffer *b) {
+  struct iovec iov[1] = {{b->p, b->n}};
+  b->n = 0;
+  return __stdio_tbf_writev(b->fd, iov, 1);
+}
+
+static void __stdio_tbf_destroy(void *arg) {
+  struct StdioThreadBuffer *b = arg;
+  __stdio_tbf_drain(b);
+  __stdio_tbf = 0;
+  free(b);
+}
+
+static void __stdio_tbf_init(void) {
+  pthread_key_create(&__stdio_tbf_key, __stdio_tbf_destroy);
+}
+
+static struct StdioThreadBuffer *__stdio_tbf_get(FILE *f) {
+  struct StdioThreadBuffer *b;
+  if (!(b = __stdio_tbf)) {
+    pthread_once(&__stdio_tbf_once, __stdio_tbf_init);
+    if (!(b = malloc(sizeof(*b))))
+      return 0;
+    b->f = 0;
+    b->n = 0;
+    pthread_setspecific(__stdio_tbf_key, b);
+    __stdio_tbf = b;
+  }
+  if (b->f != f) {
+    // a thread may only hold one partial line at a time
+    if (b->n && __stdio_tbf_drain(b) == -1)
+      return 0;
+    b->f = f;
+    b->fd = f->fd;
+  }
+  return b;
+}
+
+/**
+ * Appends data to calling thread's buffer for stream.
+ *
+ * @return 0 on success, or -1 w/ errno and stream error state set
+ */
+int __stdio_tbf_write(FILE *f, const void *data, size_t n) {
+  size_t k;
+  const char *p;
+  struct iovec iov[2];
+  struct StdioThreadBuffer *b;
+  if (!(b = __stdio_tbf_get(f))) {
+    f->state = errno;
+    return -1;
+  }
+  // send everything through the last newline, unless what's left over
+  // won't fit in the buffer, in which case a long line is split anyway
+  k = (p = memrchr(data, '\n', n)) ? p + 1 - (const char *)data : 0;
+  if (n - k > sizeof(b->p) - (k ? 0 : b->n))
+    k = n;
+  if (k) {
+    iov[0].iov_base = b->p;
+    iov[0].iov_len = b->n;
+    iov[1].iov_base = (void *)data;
+    iov[1].iov_len = k;
+    b->n = 0;
+    if (__stdio_tbf_writev(b->fd, iov, 2) == -1) {
+      f->state = errno;
+      return -1;
+    }
+  }
+  memcpy(b->p + b->n, (const char *)data + k, n - k);
+  b->n += n - k;
+  return 0;
+}
+
+/**
+ * Writes out calling thread's partial line for stream.
+ *
+ * @return 0 on success, or EOF w/ errno and stream error state set
+ */
+int __stdio_tbf_flush(FILE *f) {
+  struct StdioThreadBuffer *b;
+  if ((b = __stdio_tbf) && b->f == f && b->n) {
+    if (__stdio_tbf_drain(b) == -1) {
+      f->state = errno;
+      return EOF;
+    }
+  }
+  return 0;
+}
@@ -51,13 +51,15 @@ $(LIBC_STR_A).pkg:						\
 $(LIBC_STR_A_OBJS): private COPTS += -Wframe-larger-than=4096 -Walloca-larger-than=4096
 
 ifeq ($(ARCH), x86_64)
-o/$(MODE)/libc/str/crc32c.o: private				\
+o/$(MODE)/libc/str/crc32c.o					\
+o/$(MODE)/libc/str/crc32ieee.o: private				\
 		TARGET_ARCH =					\
 			-msse4.1 -mcrc32 -mpclmul
 endif
 
 ifeq ($(ARCH), aarch64)
-o/$(MODE)/libc/str/crc32c.o: private				\
+o/$(MODE)/libc/str/crc32c.o					\
+o/$(MODE)/libc/str/crc32ieee.o: private				\
 		TARGET_ARCH =					\
 			-march=armv8.1-a+crc+aes
 endif
@@ -0,0 +1,127 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/atomic.h"
+#include "libc/cosmo.h"
+#include "libc/intrin/atomic.h"
+#include "libc/serialize.h"
+#include "libc/stdio/rand.h"
+
+// based on wyhash final4 by Wang Yi which is released to public domain
+// https://github.com/wangyi-fudan/wyhash
+
+static const uint64_t kWySecret[4] = {
+    0x2d358dccaa6c78a5,
+    0x8bb84b93962eacc9,
+    0x4b33a62ed433d4a3,
+    0x4d5a2da51de1aa47,
+};
+
+static atomic_ulong g_cosmo_hash_seed;
+
+static inline uint64_t wymix(uint64_t a, uint64_t b) {
+  uint128_t r = (uint128_t)a * b;
+  return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+static inline uint64_t wyr3(const unsigned char *p, size_t k) {
+  return (uint64_t)p[0] << 16 | (uint64_t)p[k >> 1] << 8 | p[k - 1];
+}
+
+/**
+ * Computes fast non-cryptographic 64-bit hash with explicit seed.
+ *
+ * This goes about as fast as memory bandwidth allows on large inputs
+ * and takes a few nanoseconds on short keys. Results are stable for a
+ * given seed on all platforms, so they may be stored. If an attacker
+ * could choose the keys of your hash table, then use cosmo_hash() or
+ * HighwayHash64() with a secret key instead.
+ *
+ * @param data points to the data
+ * @param size is the byte size of data
+ * @param seed is arbitrary
+ * @see cosmo_hash()
+ */
+uint64_t cosmo_hash_seeded(const void *data, size_t size, uint64_t seed) {
+  uint64_t a, b;
+  const unsigned char *p = data;
+  seed ^= wymix(seed ^ kWySecret[0], kWySecret[1]);
+  if (size <= 16) {
+    if (size >= 4) {
+      a = (uint64_t)READ32LE(p) << 32 | READ32LE(p + ((size >> 3) << 2));
+      b = (uint64_t)READ32LE(p + size - 4) << 32 |
+          READ32LE(p + size - 4 - ((size >> 3) << 2));
+    } else if (size) {
+      a = wyr3(p, size);
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t i = size;
+    if (i >= 48) {
+      uint64_t see1 = seed;
+      uint64_t see2 = seed;
+      do {
+        seed = wymix(READ64LE(p) ^ kWySecret[1], READ64LE(p + 8) ^ seed);
+        see1 = wymix(READ64LE(p + 16) ^ kWySecret[2], READ64LE(p + 24) ^ see1);
+        see2 = wymix(READ64LE(p + 32) ^ kWySecret[3], READ64LE(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i >= 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = wymix(READ64LE(p) ^ kWySecret[1], READ64LE(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = READ64LE(p + i - 16);
+    b = READ64LE(p + i - 8);
+  }
+  uint128_t r = (uint128_t)(a ^ kWySecret[1]) * (b ^ seed);
+  a = r;
+  b = r >> 64;
+  return wymix(a ^ kWySecret[0] ^ size, b ^ kWySecret[1]);
+}
+
+/**
+ * Computes fast non-cryptographic 64-bit hash.
+ *
+ * This is cosmo_hash_seeded() keyed with a random seed that's chosen
+ * the first time it's called, and stays the same for the lifetime of
+ * the process and any children it forks. It's intended for in-memory
+ * hash tables, where it makes flooding attacks harder. The result must
+ * not be stored or sent to other processes.
+ *
+ * @param data points to the data
+ * @param size is the byte size of data
+ * @threadsafe
+ */
+uint64_t cosmo_hash(const void *data, size_t size) {
+  uint64_t seed;
+  seed = atomic_load_explicit(&g_cosmo_hash_seed, memory_order_relaxed);
+  if (!seed) {
+    uint64_t want = _rand64() | 1;
+    if (atomic_compare_exchange_strong_explicit(&g_cosmo_hash_seed, &seed, want,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed))
+      seed = want;
+  }
+  return cosmo_hash_seeded(data, size, seed);
+}
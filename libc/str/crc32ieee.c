@@ -0,0 +1,311 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/nexgen32e/crc32.h"
+#include "libc/nexgen32e/x86feature.h"
+#include "libc/runtime/runtime.h"
+#include "libc/serialize.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/auxv.h"
+#include "libc/sysv/consts/hwcap.h"
+#include "third_party/aarch64/arm_acle.internal.h"
+#include "third_party/aarch64/arm_neon.internal.h"
+#include "third_party/intel/immintrin.internal.h"
+
+// "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction"
+//  V. Gopal, E. Ozturk, et al., 2009, http://intel.ly/2ySEwL0
+
+#define POLYNOMIAL 0xedb88320u
+
+#if defined(__x86_64__) && !defined(__chibicc__)
+
+// folds 256-byte blocks four zmm registers at a time
+// @param len is at least 256 and a multiple of 64
+#pragma GCC push_options
+#pragma GCC target("avx512f,vpclmulqdq")
+static uint32_t crc32ieee_avx512(uint32_t crc, const uint8_t *buf,
+                                 size_t len) {
+  __m512i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+  __m128i a0, a1, a2, a3;
+  x1 = _mm512_loadu_si512((const __m512i *)(buf + 0x00));
+  x2 = _mm512_loadu_si512((const __m512i *)(buf + 0x40));
+  x3 = _mm512_loadu_si512((const __m512i *)(buf + 0x80));
+  x4 = _mm512_loadu_si512((const __m512i *)(buf + 0xC0));
+  x1 = _mm512_xor_si512(x1, _mm512_castsi128_si512(_mm_cvtsi32_si128(crc)));
+  x0 = _mm512_set4_epi64(0x01322d1430, 0x011542778a, 0x01322d1430,
+                         0x011542778a);
+  buf += 256;
+  len -= 256;
+  while (len >= 256) {
+    x5 = _mm512_clmulepi64_epi128(x1, x0, 0x00);
+    x6 = _mm512_clmulepi64_epi128(x2, x0, 0x00);
+    x7 = _mm512_clmulepi64_epi128(x3, x0, 0x00);
+    x8 = _mm512_clmulepi64_epi128(x4, x0, 0x00);
+    x1 = _mm512_clmulepi64_epi128(x1, x0, 0x11);
+    x2 = _mm512_clmulepi64_epi128(x2, x0, 0x11);
+    x3 = _mm512_clmulepi64_epi128(x3, x0, 0x11);
+    x4 = _mm512_clmulepi64_epi128(x4, x0, 0x11);
+    y5 = _mm512_loadu_si512((const __m512i *)(buf + 0x00));
+    y6 = _mm512_loadu_si512((const __m512i *)(buf + 0x40));
+    y7 = _mm512_loadu_si512((const __m512i *)(buf + 0x80));
+    y8 = _mm512_loadu_si512((const __m512i *)(buf + 0xC0));
+    x1 = _mm512_ternarylogic_epi64(x1, x5, y5, 0x96);
+    x2 = _mm512_ternarylogic_epi64(x2, x6, y6, 0x96);
+    x3 = _mm512_ternarylogic_epi64(x3, x7, y7, 0x96);
+    x4 = _mm512_ternarylogic_epi64(x4, x8, y8, 0x96);
+    buf += 256;
+    len -= 256;
+  }
+  x0 = _mm512_set4_epi64(0x01c6e41596, 0x0154442bd4, 0x01c6e41596,
+                         0x0154442bd4);
+  x5 = _mm512_clmulepi64_epi128(x1, x0, 0x00);
+  x1 = _mm512_clmulepi64_epi128(x1, x0, 0x11);
+  x1 = _mm512_ternarylogic_epi64(x1, x2, x5, 0x96);
+  x5 = _mm512_clmulepi64_epi128(x1, x0, 0x00);
+  x1 = _mm512_clmulepi64_epi128(x1, x0, 0x11);
+  x1 = _mm512_ternarylogic_epi64(x1, x3, x5, 0x96);
+  x5 = _mm512_clmulepi64_epi128(x1, x0, 0x00);
+  x1 = _mm512_clmulepi64_epi128(x1, x0, 0x11);
+  x1 = _mm512_ternarylogic_epi64(x1, x4, x5, 0x96);
+  while (len >= 64) {
+    x2 = _mm512_loadu_si512((const __m512i *)buf);
+    x5 = _mm512_clmulepi64_epi128(x1, x0, 0x00);
+    x1 = _mm512_clmulepi64_epi128(x1, x0, 0x11);
+    x1 = _mm512_ternarylogic_epi64(x1, x2, x5, 0x96);
+    buf += 64;
+    len -= 64;
+  }
+  a0 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+  a1 = _mm512_extracti32x4_epi32(x1, 0);
+  a2 = _mm512_extracti32x4_epi32(x1, 1);
+  a3 = _mm_clmulepi64_si128(a1, a0, 0x00);
+  a1 = _mm_clmulepi64_si128(a1, a0, 0x11);
+  a1 = _mm_xor_si128(a1, a3);
+  a1 = _mm_xor_si128(a1, a2);
+  a2 = _mm512_extracti32x4_epi32(x1, 2);
+  a3 = _mm_clmulepi64_si128(a1, a0, 0x00);
+  a1 = _mm_clmulepi64_si128(a1, a0, 0x11);
+  a1 = _mm_xor_si128(a1, a3);
+  a1 = _mm_xor_si128(a1, a2);
+  a2 = _mm512_extracti32x4_epi32(x1, 3);
+  a3 = _mm_clmulepi64_si128(a1, a0, 0x00);
+  a1 = _mm_clmulepi64_si128(a1, a0, 0x11);
+  a1 = _mm_xor_si128(a1, a3);
+  a1 = _mm_xor_si128(a1, a2);
+  a2 = _mm_clmulepi64_si128(a1, a0, 0x10);
+  a3 = _mm_setr_epi32(~0, 0, ~0, 0);
+  a1 = _mm_srli_si128(a1, 8);
+  a1 = _mm_xor_si128(a1, a2);
+  a0 = _mm_set_epi64x(0, 0x0163cd6124);
+  a2 = _mm_srli_si128(a1, 4);
+  a1 = _mm_and_si128(a1, a3);
+  a1 = _mm_clmulepi64_si128(a1, a0, 0x00);
+  a1 = _mm_xor_si128(a1, a2);
+  a0 = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+  a2 = _mm_and_si128(a1, a3);
+  a2 = _mm_clmulepi64_si128(a2, a0, 0x10);
+  a2 = _mm_and_si128(a2, a3);
+  a2 = _mm_clmulepi64_si128(a2, a0, 0x00);
+  a1 = _mm_xor_si128(a1, a2);
+  return _mm_extract_epi32(a1, 1);
+}
+#pragma GCC pop_options
+
+// folds 64-byte blocks four xmm registers at a time
+// @param len is at least 64 and a multiple of 16
+static uint32_t crc32ieee_pclmul(uint32_t crc, const uint8_t *buf,
+                                 size_t len) {
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+  x1 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+  x2 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+  x3 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+  x4 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+  x0 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+  buf += 64;
+  len -= 64;
+  while (len >= 64) {
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+    x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+    y5 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+    y6 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+    y7 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+    y8 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+    x1 = _mm_xor_si128(x1, x5);
+    x2 = _mm_xor_si128(x2, x6);
+    x3 = _mm_xor_si128(x3, x7);
+    x4 = _mm_xor_si128(x4, x8);
+    x1 = _mm_xor_si128(x1, y5);
+    x2 = _mm_xor_si128(x2, y6);
+    x3 = _mm_xor_si128(x3, y7);
+    x4 = _mm_xor_si128(x4, y8);
+    buf += 64;
+    len -= 64;
+  }
+  x0 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(x1, x2);
+  x1 = _mm_xor_si128(x1, x5);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(x1, x3);
+  x1 = _mm_xor_si128(x1, x5);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(x1, x4);
+  x1 = _mm_xor_si128(x1, x5);
+  while (len >= 16) {
+    x2 = _mm_loadu_si128((const __m128i *)buf);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(x1, x2);
+    x1 = _mm_xor_si128(x1, x5);
+    buf += 16;
+    len -= 16;
+  }
+  x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+  x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+  x1 = _mm_srli_si128(x1, 8);
+  x1 = _mm_xor_si128(x1, x2);
+  x0 = _mm_set_epi64x(0, 0x0163cd6124);
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, x3);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+  x0 = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+  x2 = _mm_and_si128(x1, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+  x2 = _mm_and_si128(x2, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+  return _mm_extract_epi32(x1, 1);
+}
+
+#endif /* __x86_64__ */
+
+/**
+ * Computes 32-bit ITU-T V.42 Cyclic Redundancy Check.
+ *
+ *     x^32+x^26+x^23+x^22+x^16+x^12+x^11+x^10+x^8+x^7+x^5+x^4+x^2+x+1
+ *     0b11101101101110001000001100100000
+ *
+ * This is the same checksum as zlib crc32_z() but it's available to
+ * programs that don't link zlib. On x86 large buffers are folded with
+ * VPCLMULQDQ or PCLMULQDQ. On ARM we use the CRC32 instructions, with
+ * four interleaved streams that are recombined using PMULL.
+ *
+ * @param init is the initial hash value
+ * @param data points to the data
+ * @param size is the byte size of data
+ * @return eax is the new hash value
+ * @note Used by ZIP, PNG, Ethernet, etc.
+ */
+uint32_t crc32ieee(uint32_t init, const void *data, size_t size) {
+
+  static struct {
+    bool once;
+    bool have;
+    bool pmul;
+    bool wide;
+    uint32_t tab[256];
+  } crc32;
+  if (!crc32.once) {
+#if defined(__aarch64__)
+    long hwcap = getauxval(AT_HWCAP);
+    crc32.have = !!(hwcap & HWCAP_CRC32);
+    crc32.pmul = !!(hwcap & HWCAP_PMULL);
+#elif defined(__x86_64__) && !defined(__chibicc__)
+    crc32.pmul = X86_HAVE(PCLMUL) && X86_HAVE(SSE4_1);
+    crc32.wide = crc32.pmul && X86_HAVE(AVX512F) && X86_HAVE(VPCLMULQDQ);
+#endif
+    if (!crc32.have)
+      crc32init(crc32.tab, POLYNOMIAL);
+    crc32.once = 1;
+  }
+
+  size_t n = size;
+  uint64_t h = ~init;
+  const unsigned char *p = (const unsigned char *)data;
+
+#if defined(__aarch64__)
+  if (crc32.have) {
+    if (crc32.pmul) {
+      // constants are x^(256*8*k) mod P bit reflected for k=1,2,3
+      while (n >= 256 * 4 + 8) {
+        uint32_t a = h;
+        uint32_t b = 0;
+        uint32_t c = 0;
+        uint32_t d = 0;
+        for (int i = 0; i < 32; ++i) {
+          a = __crc32d(a, READ64LE(p + i * 8 + 256 * 0));
+          b = __crc32d(b, READ64LE(p + i * 8 + 256 * 1));
+          c = __crc32d(c, READ64LE(p + i * 8 + 256 * 2));
+          d = __crc32d(d, READ64LE(p + i * 8 + 256 * 3));
+        }
+        h = __crc32d(d, READ64LE(p + 256 * 4));
+        h ^= __crc32d(0, vmull_p64(c, 0xce3371cbu));
+        h ^= __crc32d(0, vmull_p64(b, 0x1072db28u));
+        h ^= __crc32d(0, vmull_p64(a, 0x1423c53au));
+        p += 256 * 4 + 8;
+        n -= 256 * 4 + 8;
+      }
+    }
+    while (n >= 8) {
+      h = __crc32d(h, READ64LE(p));
+      p += 8;
+      n -= 8;
+    }
+    if (n & 4) {
+      h = __crc32w(h, READ32LE(p));
+      p += 4;
+    }
+    if (n & 2) {
+      h = __crc32h(h, READ16LE(p));
+      p += 2;
+    }
+    if (n & 1)
+      h = __crc32b(h, *p);
+    return ~h;
+  }
+
+#elif defined(__x86_64__) && !defined(__chibicc__)
+  if (crc32.wide && n >= 256) {
+    size_t m = n & -64;
+    h = crc32ieee_avx512(h, p, m);
+    p += m;
+    n -= m;
+  }
+  if (crc32.pmul && n >= 64) {
+    size_t m = n & -16;
+    h = crc32ieee_pclmul(h, p, m);
+    p += m;
+    n -= m;
+  }
+#endif
+
+  for (size_t i = 0; i < n; ++i)
+    h = h >> 8 ^ crc32.tab[(h & 0xff) ^ p[i]];
+  return ~h;
+}
@@ -16,7 +16,10 @@
 │ limitations under the License.                                               │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/str/highwayhash64.h"
+#include "libc/nexgen32e/x86feature.h"
 #include "libc/serialize.h"
+#include "third_party/aarch64/arm_neon.internal.h"
+#include "third_party/intel/immintrin.internal.h"
 
 __notice(highwayhash_notice, "\
 HighwayHash (Apache 2.0)\n\
@@ -94,17 +97,15 @@ static void Rotate32By(uint64_t count, uint64_t lanes[4]) {
   }
 }
 
-static void HighwayHashUpdateRemainder(const uint8_t *bytes,
+static void HighwayHashRemainderPacket(const uint8_t *bytes,
                                        const size_t size_mod32,
-                                       HighwayHashState *state) {
+                                       uint8_t packet[32]) {
   int i;
   const size_t size_mod4 = size_mod32 & 3;
   const uint8_t *remainder = bytes + (size_mod32 & ~3);
-  uint8_t packet[32] = {0};
-  for (i = 0; i < 4; ++i) {
-    state->v0[i] += ((uint64_t)size_mod32 << 32) + size_mod32;
+  for (i = 0; i < 32; ++i) {
+    packet[i] = 0;
   }
-  Rotate32By(size_mod32, state->v1);
   for (i = 0; i < remainder - bytes; i++) {
     packet[i] = bytes[i];
   }
@@ -119,6 +120,18 @@ static void HighwayHashUpdateRemainder(const uint8_t *bytes,
       packet[16 + 2] = remainder[size_mod4 - 1];
     }
   }
+}
+
+static void HighwayHashUpdateRemainder(const uint8_t *bytes,
+                                       const size_t size_mod32,
+                                       HighwayHashState *state) {
+  int i;
+  uint8_t packet[32];
+  for (i = 0; i < 4; ++i) {
+    state->v0[i] += ((uint64_t)size_mod32 << 32) + size_mod32;
+  }
+  Rotate32By(size_mod32, state->v1);
+  HighwayHashRemainderPacket(bytes, size_mod32, packet);
   HighwayHashUpdatePacket(packet, state);
 }
 
@@ -153,6 +166,149 @@ static void ProcessAll(const uint8_t *data, size_t size, const uint64_t key[4],
     HighwayHashUpdateRemainder(data + i, size & 31, state);
 }
 
+#if defined(__x86_64__) && !defined(__chibicc__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+// same algorithm with each of v0, v1, mul0 and mul1 held in one ymm
+// register, so the four lanes advance together and zipper merge is a
+// single vpshufb within each 128-bit half
+typedef struct {
+  __m256i v0, v1, mul0, mul1;
+} HighwayHashAvx2;
+
+static inline __m256i HighwayHashZipperAvx2(__m256i v) {
+  return _mm256_shuffle_epi8(
+      v, _mm256_set_epi64x(0x070806090d0a040b, 0x000f010e05020c03,
+                           0x070806090d0a040b, 0x000f010e05020c03));
+}
+
+static inline void HighwayHashUpdateAvx2(__m256i lanes, HighwayHashAvx2 *s) {
+  s->v1 = _mm256_add_epi64(s->v1, _mm256_add_epi64(s->mul0, lanes));
+  s->mul0 = _mm256_xor_si256(
+      s->mul0, _mm256_mul_epu32(s->v1, _mm256_srli_epi64(s->v0, 32)));
+  s->v0 = _mm256_add_epi64(s->v0, s->mul1);
+  s->mul1 = _mm256_xor_si256(
+      s->mul1, _mm256_mul_epu32(s->v0, _mm256_srli_epi64(s->v1, 32)));
+  s->v0 = _mm256_add_epi64(s->v0, HighwayHashZipperAvx2(s->v1));
+  s->v1 = _mm256_add_epi64(s->v1, HighwayHashZipperAvx2(s->v0));
+}
+
+static uint64_t HighwayHash64Avx2(const uint8_t *data, size_t size,
+                                  const uint64_t key[4]) {
+  size_t i;
+  HighwayHashAvx2 s;
+  __m256i k = _mm256_loadu_si256((const __m256i *)key);
+  s.mul0 = _mm256_set_epi64x(0x243f6a8885a308d3, 0x13198a2e03707344,
+                             0xa4093822299f31d0, 0xdbe6d5d5fe4cce2f);
+  s.mul1 = _mm256_set_epi64x(0x452821e638d01377, 0xbe5466cf34e90c6c,
+                             0xc0acf169b5f18a8c, 0x3bd39e10cb0ef593);
+  s.v0 = _mm256_xor_si256(s.mul0, k);
+  s.v1 = _mm256_xor_si256(s.mul1, _mm256_shuffle_epi32(k, 0xb1));
+  for (i = 0; i + 32 <= size; i += 32)
+    HighwayHashUpdateAvx2(_mm256_loadu_si256((const __m256i *)(data + i)), &s);
+  if (size & 31) {
+    uint8_t packet[32];
+    __m128i n = _mm_cvtsi32_si128(size & 31);
+    __m128i m = _mm_cvtsi32_si128(32 - (size & 31));
+    s.v0 = _mm256_add_epi32(s.v0, _mm256_set1_epi32(size & 31));
+    s.v1 = _mm256_or_si256(_mm256_sll_epi32(s.v1, n), _mm256_srl_epi32(s.v1, m));
+    HighwayHashRemainderPacket(data + i, size & 31, packet);
+    HighwayHashUpdateAvx2(_mm256_loadu_si256((const __m256i *)packet), &s);
+  }
+  for (i = 0; i < 4; i++)
+    HighwayHashUpdateAvx2(
+        _mm256_permute4x64_epi64(_mm256_shuffle_epi32(s.v0, 0xb1), 0x4e), &s);
+  return _mm_cvtsi128_si64(_mm256_castsi256_si128(_mm256_add_epi64(
+      _mm256_add_epi64(s.v0, s.v1), _mm256_add_epi64(s.mul0, s.mul1))));
+}
+
+#pragma GCC pop_options
+#endif /* __x86_64__ */
+
+#ifdef __aarch64__
+
+// same algorithm with each state vector split into two 128-bit neon
+// registers, so zipper merge is a single tbl per register
+typedef struct {
+  uint64x2_t v0[2], v1[2], mul0[2], mul1[2];
+} HighwayHashNeon;
+
+static inline uint64x2_t HighwayHashZipperNeon(uint64x2_t v) {
+  static const uint8_t kZipper[16] = {3,  12, 2, 5,  14, 1, 15, 0,
+                                      11, 4,  10, 13, 9, 6, 8,  7};
+  return vreinterpretq_u64_u8(
+      vqtbl1q_u8(vreinterpretq_u8_u64(v), vld1q_u8(kZipper)));
+}
+
+static inline void HighwayHashUpdateNeon(const uint64x2_t lanes[2],
+                                         HighwayHashNeon *s) {
+  for (int j = 0; j < 2; ++j) {
+    s->v1[j] = vaddq_u64(s->v1[j], vaddq_u64(s->mul0[j], lanes[j]));
+    s->mul0[j] = veorq_u64(
+        s->mul0[j], vmull_u32(vmovn_u64(s->v1[j]), vshrn_n_u64(s->v0[j], 32)));
+    s->v0[j] = vaddq_u64(s->v0[j], s->mul1[j]);
+    s->mul1[j] = veorq_u64(
+        s->mul1[j], vmull_u32(vmovn_u64(s->v0[j]), vshrn_n_u64(s->v1[j], 32)));
+    s->v0[j] = vaddq_u64(s->v0[j], HighwayHashZipperNeon(s->v1[j]));
+    s->v1[j] = vaddq_u64(s->v1[j], HighwayHashZipperNeon(s->v0[j]));
+  }
+}
+
+static inline uint64x2_t HighwayHashSwap32Neon(uint64x2_t v) {
+  return vreinterpretq_u64_u32(vrev64q_u32(vreinterpretq_u32_u64(v)));
+}
+
+static uint64_t HighwayHash64Neon(const uint8_t *data, size_t size,
+                                  const uint64_t key[4]) {
+  size_t i;
+  HighwayHashNeon s;
+  uint64x2_t lanes[2];
+  static const uint64_t kMul0[4] = {0xdbe6d5d5fe4cce2f, 0xa4093822299f31d0,
+                                    0x13198a2e03707344, 0x243f6a8885a308d3};
+  static const uint64_t kMul1[4] = {0x3bd39e10cb0ef593, 0xc0acf169b5f18a8c,
+                                    0xbe5466cf34e90c6c, 0x452821e638d01377};
+  for (int j = 0; j < 2; ++j) {
+    uint64x2_t k = vld1q_u64(key + j * 2);
+    s.mul0[j] = vld1q_u64(kMul0 + j * 2);
+    s.mul1[j] = vld1q_u64(kMul1 + j * 2);
+    s.v0[j] = veorq_u64(s.mul0[j], k);
+    s.v1[j] = veorq_u64(s.mul1[j], HighwayHashSwap32Neon(k));
+  }
+  for (i = 0; i + 32 <= size; i += 32) {
+    lanes[0] = vreinterpretq_u64_u8(vld1q_u8(data + i));
+    lanes[1] = vreinterpretq_u64_u8(vld1q_u8(data + i + 16));
+    HighwayHashUpdateNeon(lanes, &s);
+  }
+  if (size & 31) {
+    uint8_t packet[32];
+    int32x4_t n = vdupq_n_s32(size & 31);
+    int32x4_t m = vdupq_n_s32((int)(size & 31) - 32);
+    uint32x4_t add = vdupq_n_u32(size & 31);
+    for (int j = 0; j < 2; ++j) {
+      uint32x4_t v1 = vreinterpretq_u32_u64(s.v1[j]);
+      s.v0[j] = vreinterpretq_u64_u32(
+          vaddq_u32(vreinterpretq_u32_u64(s.v0[j]), add));
+      s.v1[j] =
+          vreinterpretq_u64_u32(vorrq_u32(vshlq_u32(v1, n), vshlq_u32(v1, m)));
+    }
+    HighwayHashRemainderPacket(data + i, size & 31, packet);
+    lanes[0] = vreinterpretq_u64_u8(vld1q_u8(packet));
+    lanes[1] = vreinterpretq_u64_u8(vld1q_u8(packet + 16));
+    HighwayHashUpdateNeon(lanes, &s);
+  }
+  for (i = 0; i < 4; i++) {
+    lanes[0] = HighwayHashSwap32Neon(s.v0[1]);
+    lanes[1] = HighwayHashSwap32Neon(s.v0[0]);
+    HighwayHashUpdateNeon(lanes, &s);
+  }
+  return vgetq_lane_u64(vaddq_u64(vaddq_u64(s.v0[0], s.v1[0]),
+                                  vaddq_u64(s.mul0[0], s.mul1[0])),
+                        0);
+}
+
+#endif /* __aarch64__ */
+
 /**
  * Computes Highway Hash.
  *
@@ -168,6 +324,12 @@ static void ProcessAll(const uint8_t *data, size_t size, const uint64_t key[4],
  *
  */
 uint64_t HighwayHash64(const void *data, size_t size, const uint64_t key[4]) {
+#if defined(__x86_64__) && !defined(__chibicc__)
+  if (X86_HAVE(AVX2))
+    return HighwayHash64Avx2(data, size, key);
+#elif defined(__aarch64__)
+  return HighwayHash64Neon(data, size, key);
+#endif
   HighwayHashState state;
   ProcessAll(data, size, key, &state);
   return HighwayHashFinalize64(&state);
@@ -18,7 +18,10 @@
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/dce.h"
 #include "libc/intrin/likely.h"
+#include "libc/nexgen32e/x86feature.h"
 #include "libc/str/str.h"
+#include "third_party/aarch64/arm_neon.internal.h"
+#include "third_party/intel/immintrin.internal.h"
 
 static const char kUtf8Dispatch[] = {
     0, 0, 1, 1, 1, 1, 1, 1,  // 0300 utf8-2
@@ -31,6 +34,155 @@ static const char kUtf8Dispatch[] = {
     0, 0, 0, 0, 0, 0, 0, 0,  // 0370
 };
 
+// the simd paths classify each byte by looking up the high nibble of
+// the previous byte, the low nibble of the previous byte, and the high
+// nibble of the current byte in three sixteen entry tables. each table
+// entry is a set of ways the pair might be invalid, so the pair is bad
+// iff all three lookups have a bit in common. surrogates and code points
+// above U+10FFFF aren't flagged since the scalar code accepts them too.
+#define TOO_SHORT  0001  // lead or ascii byte followed by lead or ascii
+#define TOO_LONG   0002  // ascii byte followed by continuation
+#define OVERLONG_3 0004  // e0 followed by 80..9f
+#define TOO_LARGE  0010  // f5..ff followed by 90..bf
+#define OVERLONG_2 0040  // c0..c1 followed by continuation
+#define TOO_LARGE2 0100  // f5..ff followed by 80..8f
+#define OVERLONG_4 0100  // f0 followed by 80..8f
+#define TWO_CONTS  0200  // continuation followed by continuation
+#define CARRY      (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+#define UTF8_BYTE_1_HIGH                                              \
+  TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,         \
+      TOO_LONG, TOO_LONG, TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS, \
+      TOO_SHORT | OVERLONG_2, TOO_SHORT, TOO_SHORT | OVERLONG_3,      \
+      TOO_SHORT | TOO_LARGE | TOO_LARGE2 | OVERLONG_4
+
+#define UTF8_BYTE_1_LOW                                                    \
+  CARRY | OVERLONG_2 | OVERLONG_3 | OVERLONG_4, CARRY | OVERLONG_2, CARRY, \
+      CARRY, CARRY, CARRY | TOO_LARGE | TOO_LARGE2,                        \
+      CARRY | TOO_LARGE | TOO_LARGE2, CARRY | TOO_LARGE | TOO_LARGE2,      \
+      CARRY | TOO_LARGE | TOO_LARGE2, CARRY | TOO_LARGE | TOO_LARGE2,      \
+      CARRY | TOO_LARGE | TOO_LARGE2, CARRY | TOO_LARGE | TOO_LARGE2,      \
+      CARRY | TOO_LARGE | TOO_LARGE2, CARRY | TOO_LARGE | TOO_LARGE2,      \
+      CARRY | TOO_LARGE | TOO_LARGE2, CARRY | TOO_LARGE | TOO_LARGE2
+
+#define UTF8_BYTE_2_HIGH                                                     \
+  TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,          \
+      TOO_SHORT, TOO_SHORT,                                                  \
+      TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE2 |          \
+          OVERLONG_4,                                                        \
+      TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,            \
+      TOO_LONG | OVERLONG_2 | TWO_CONTS | TOO_LARGE,                         \
+      TOO_LONG | OVERLONG_2 | TWO_CONTS | TOO_LARGE, TOO_SHORT, TOO_SHORT, \
+      TOO_SHORT, TOO_SHORT
+
+#if defined(__x86_64__) && !defined(__chibicc__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+static inline __m256i isutf8_prev_avx2(__m256i x, __m256i prev, int n) {
+  __m256i t = _mm256_permute2x128_si256(prev, x, 0x21);
+  switch (n) {
+    case 1:
+      return _mm256_alignr_epi8(x, t, 15);
+    case 2:
+      return _mm256_alignr_epi8(x, t, 14);
+    default:
+      return _mm256_alignr_epi8(x, t, 13);
+  }
+}
+
+static inline __m256i isutf8_check_avx2(__m256i x, __m256i prev) {
+  __m256i nib = _mm256_set1_epi8(15);
+  __m256i p1 = isutf8_prev_avx2(x, prev, 1);
+  __m256i sc = _mm256_and_si256(
+      _mm256_and_si256(
+          _mm256_shuffle_epi8(
+              _mm256_setr_epi8(UTF8_BYTE_1_HIGH, UTF8_BYTE_1_HIGH),
+              _mm256_and_si256(_mm256_srli_epi16(p1, 4), nib)),
+          _mm256_shuffle_epi8(
+              _mm256_setr_epi8(UTF8_BYTE_1_LOW, UTF8_BYTE_1_LOW),
+              _mm256_and_si256(p1, nib))),
+      _mm256_shuffle_epi8(_mm256_setr_epi8(UTF8_BYTE_2_HIGH, UTF8_BYTE_2_HIGH),
+                          _mm256_and_si256(_mm256_srli_epi16(x, 4), nib)));
+  // third and fourth bytes of a sequence must be continuations, which
+  // is the only time TWO_CONTS is okay, so it gets flipped over there
+  __m256i must = _mm256_and_si256(
+      _mm256_or_si256(_mm256_subs_epu8(isutf8_prev_avx2(x, prev, 2),
+                                       _mm256_set1_epi8(0xe0 - 0x80)),
+                      _mm256_subs_epu8(isutf8_prev_avx2(x, prev, 3),
+                                       _mm256_set1_epi8(0xf0 - 0x80))),
+      _mm256_set1_epi8(0x80));
+  return _mm256_xor_si256(must, sc);
+}
+
+static bool isutf8_avx2(const char *p, size_t n) {
+  char tail[32];
+  size_t i, m;
+  __m256i x, e, prev = _mm256_setzero_si256();
+  for (i = 0; i + 32 <= n; i += 32) {
+    x = _mm256_loadu_si256((const __m256i *)(p + i));
+    if (!_mm256_movemask_epi8(_mm256_or_si256(x, prev))) {
+      prev = x;
+      continue;
+    }
+    e = isutf8_check_avx2(x, prev);
+    if (!_mm256_testz_si256(e, e))
+      return false;
+    prev = x;
+  }
+  // nul padding also catches a sequence cut short by the end of input
+  m = n - i;
+  bzero(tail, sizeof(tail));
+  memcpy(tail, p + i, m);
+  x = _mm256_loadu_si256((const __m256i *)tail);
+  e = isutf8_check_avx2(x, prev);
+  return _mm256_testz_si256(e, e);
+}
+
+#pragma GCC pop_options
+#endif /* __x86_64__ */
+
+#ifdef __aarch64__
+
+static inline uint8x16_t isutf8_check_neon(uint8x16_t x, uint8x16_t prev) {
+  static const uint8_t kByte1High[16] = {UTF8_BYTE_1_HIGH};
+  static const uint8_t kByte1Low[16] = {UTF8_BYTE_1_LOW};
+  static const uint8_t kByte2High[16] = {UTF8_BYTE_2_HIGH};
+  uint8x16_t p1 = vextq_u8(prev, x, 15);
+  uint8x16_t sc = vandq_u8(
+      vandq_u8(vqtbl1q_u8(vld1q_u8(kByte1High), vshrq_n_u8(p1, 4)),
+               vqtbl1q_u8(vld1q_u8(kByte1Low), vandq_u8(p1, vdupq_n_u8(15)))),
+      vqtbl1q_u8(vld1q_u8(kByte2High), vshrq_n_u8(x, 4)));
+  uint8x16_t must = vandq_u8(
+      vorrq_u8(vqsubq_u8(vextq_u8(prev, x, 14), vdupq_n_u8(0xe0 - 0x80)),
+               vqsubq_u8(vextq_u8(prev, x, 13), vdupq_n_u8(0xf0 - 0x80))),
+      vdupq_n_u8(0x80));
+  return veorq_u8(must, sc);
+}
+
+static bool isutf8_neon(const char *p, size_t n) {
+  size_t i, m;
+  uint8_t tail[16];
+  uint8x16_t x, prev = vdupq_n_u8(0);
+  for (i = 0; i + 16 <= n; i += 16) {
+    x = vld1q_u8((const uint8_t *)(p + i));
+    if (vmaxvq_u8(vorrq_u8(x, prev)) < 0200) {
+      prev = x;
+      continue;
+    }
+    if (vmaxvq_u8(isutf8_check_neon(x, prev)))
+      return false;
+    prev = x;
+  }
+  m = n - i;
+  bzero(tail, sizeof(tail));
+  memcpy(tail, p + i, m);
+  x = vld1q_u8(tail);
+  return !vmaxvq_u8(isutf8_check_neon(x, prev));
+}
+
+#endif /* __aarch64__ */
+
 /**
  * Returns true if text is utf-8.
  *
@@ -54,6 +206,13 @@ bool32 isutf8(const void *data, size_t size) {
   if (size == -1)
     size = data ? strlen(data) : 0;
   p = data;
+#if defined(__x86_64__) && !defined(__chibicc__)
+  if (size >= 64 && X86_HAVE(AVX2))
+    return isutf8_avx2(p, size);
+#elif defined(__aarch64__)
+  if (size >= 32)
+    return isutf8_neon(p, size);
+#endif
   e = p + size;
   while (p < e) {
 #if defined(__x86_64__) && !defined(__chibicc__)
@@ -81,8 +81,114 @@ dontinline relegated static bool memmem_sse2(const unsigned char **h,
   *h = p;
   return false;
 }
+
+// the "generic simd" algorithm compares the first and last byte of the
+// needle at every position of a block at once, so a full comparison is
+// only made for the few positions where both happen to be equal
+#pragma GCC push_options
+#pragma GCC target("avx512bw")
+static bool memmem_avx512_short(const unsigned char **h,
+                                const unsigned char *e,
+                                const unsigned char *n, size_t l) {
+  const unsigned char *p = *h;
+  __m512i fv = _mm512_set1_epi8(n[0]);
+  __m512i lv = _mm512_set1_epi8(n[l - 1]);
+  for (; e - p >= l + 63; p += 64) {
+    uint64_t m = _mm512_cmpeq_epi8_mask(
+                     _mm512_loadu_si512((const void *)p), fv) &
+                 _mm512_cmpeq_epi8_mask(
+                     _mm512_loadu_si512((const void *)(p + l - 1)), lv);
+    for (; m; m &= m - 1) {
+      if (!memcmp(p + __builtin_ctzll(m) + 1, n + 1, l - 2)) {
+        *h = p + __builtin_ctzll(m);
+        return true;
+      }
+    }
+  }
+  *h = p;
+  return false;
+}
+#pragma GCC pop_options
+#pragma GCC push_options
+#pragma GCC target("avx2")
+static bool memmem_avx2_short(const unsigned char **h, const unsigned char *e,
+                              const unsigned char *n, size_t l) {
+  const unsigned char *p = *h;
+  __m256i fv = _mm256_set1_epi8(n[0]);
+  __m256i lv = _mm256_set1_epi8(n[l - 1]);
+  for (; e - p >= l + 31; p += 32) {
+    unsigned m = _mm256_movemask_epi8(_mm256_and_si256(
+        _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)p), fv),
+        _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + l - 1)),
+                          lv)));
+    for (; m; m &= m - 1) {
+      if (!memcmp(p + __builtin_ctz(m) + 1, n + 1, l - 2)) {
+        *h = p + __builtin_ctz(m);
+        return true;
+      }
+    }
+  }
+  *h = p;
+  return false;
+}
+#pragma GCC pop_options
+static bool memmem_sse2_short(const unsigned char **h, const unsigned char *e,
+                              const unsigned char *n, size_t l) {
+  const unsigned char *p = *h;
+  __m128i fv = _mm_set1_epi8(n[0]);
+  __m128i lv = _mm_set1_epi8(n[l - 1]);
+  for (; e - p >= l + 15; p += 16) {
+    unsigned m = _mm_movemask_epi8(_mm_and_si128(
+        _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), fv),
+        _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + l - 1)), lv)));
+    for (; m; m &= m - 1) {
+      if (!memcmp(p + __builtin_ctz(m) + 1, n + 1, l - 2)) {
+        *h = p + __builtin_ctz(m);
+        return true;
+      }
+    }
+  }
+  *h = p;
+  return false;
+}
 #endif  // __x86_64__
 
+// searches for needle of 2 to 32 bytes, which takes linear time since
+// each candidate position costs at most one small memcmp()
+static void *memmem_short(const unsigned char *h, const unsigned char *e,
+                          const unsigned char *n, size_t l) {
+#if defined(__x86_64__) && !defined(__chibicc__)
+  bool found;
+  if (X86_HAVE(AVX512BW) && !IsModeDbg()) {
+    found = memmem_avx512_short(&h, e, n, l);
+  } else if (X86_HAVE(AVX2) && !IsModeDbg()) {
+    found = memmem_avx2_short(&h, e, n, l);
+  } else {
+    found = memmem_sse2_short(&h, e, n, l);
+  }
+  if (found)
+    return (void *)h;
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  uint8x16_t fv = vdupq_n_u8(n[0]);
+  uint8x16_t lv = vdupq_n_u8(n[l - 1]);
+  for (; e - h >= l + 15; h += 16) {
+    uint64_t m = vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(
+            vreinterpretq_u16_u8(vandq_u8(vceqq_u8(vld1q_u8(h), fv),
+                                          vceqq_u8(vld1q_u8(h + l - 1), lv))),
+            4)),
+        0) & 0x8888888888888888;
+    for (; m; m &= m - 1)
+      if (!memcmp(h + (__builtin_ctzll(m) >> 2) + 1, n + 1, l - 2))
+        return (void *)(h + (__builtin_ctzll(m) >> 2));
+  }
+#endif
+  for (; e - h >= l; ++h)
+    if (h[0] == n[0] && h[l - 1] == n[l - 1] && !memcmp(h + 1, n + 1, l - 2))
+      return (void *)h;
+  return 0;
+}
+
 /**
  * Searches for fixed-length substring in memory region.
  *
@@ -109,6 +215,8 @@ void *memmem(const void *haystack, size_t haystacklen,  //
     return 0;
   if (l == 1)
     return memchr(h, *n, k);
+  if (l <= 32)
+    return memmem_short(h, h + k, n, l);
 
   // use 2x slower algorithm if needle might cause stack overflow
   size_t need = sizeof(unsigned) * l;
@@ -109,6 +109,20 @@ char *strstr(const char *haystack, const char *needle) {
   const unsigned char *n = (const unsigned char *)needle;
   size_t l = strlen(needle);
 
+  // short needles are searched a page at a time by memmem() which uses
+  // simd to filter candidates on the first and last bytes of needle
+  if (l <= 32) {
+    for (;;) {
+      char *r;
+      size_t k = strnlen((const char *)h, 4096 + l - 1);
+      if ((r = memmem(h, k, n, l)))
+        return r;
+      if (k < 4096 + l - 1)
+        return 0;
+      h += 4096;
+    }
+  }
+
   // use 2x slower algorithm if needle might cause stack overflow
   size_t need = sizeof(unsigned) * l;
 #ifdef MODE_DBG
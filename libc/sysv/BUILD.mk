@@ -47,6 +47,7 @@ LIBC_SYSV_A_FILES :=					\
 	libc/sysv/syscon.S				\
 	libc/sysv/syslib.S				\
 	libc/sysv/syscount.S				\
+	libc/sysv/systrace.S				\
 	libc/sysv/restorert.S				\
 	libc/sysv/syscall2.S				\
 	libc/sysv/syscall3.S				\
@@ -196,6 +197,8 @@ o/$(MODE)/libc/sysv/syslib.o: libc/sysv/syslib.S
 	@$(COMPILE) -AOBJECTIFY.S $(OBJECTIFY.S) $(OUTPUT_OPTION) $<
 o/$(MODE)/libc/sysv/syscount.o: libc/sysv/syscount.S
 	@$(COMPILE) -AOBJECTIFY.S $(OBJECTIFY.S) $(OUTPUT_OPTION) $<
+o/$(MODE)/libc/sysv/systrace.o: libc/sysv/systrace.S
+	@$(COMPILE) -AOBJECTIFY.S $(OBJECTIFY.S) $(OUTPUT_OPTION) $<
 o/$(MODE)/libc/sysv/syscall2.o: libc/sysv/syscall2.S
 	@$(COMPILE) -AOBJECTIFY.S $(OBJECTIFY.S) $(OUTPUT_OPTION) $<
 o/$(MODE)/libc/sysv/syscall3.o: libc/sysv/syscall3.S
@@ -321,11 +321,13 @@ syscon	poll	POLLRDHUP				0x2000			0x2000			0x10			0x10			0x10			0x10			0x10			2
 #
 #	group	name					GNU/Systemd		GNU/Systemd (Aarch64)	XNU's Not UNIX!		MacOS (Arm64)		FreeBSD			OpenBSD			NetBSD			The New Technology	Commentary
 syscon	so	SOL_SOCKET				1			1			0xffff			0xffff			0xffff			0xffff			0xffff			0xffff			# yes it's actually 0xffff; bsd+nt consensus (todo: what's up with ipproto_icmp overlap)
+syscon	so	SOL_TLS					282			282			0			0			0			0			0			0			# kernel tls offload; linux only; setsockopt(sock, SOL_TLS, TLS_TX, ...) after TCP_ULP "tls"
 syscon	so	SO_DEBUG				1			1			1			1			1			1			1			1			# debugging is enabled; consensus
 syscon	so	SO_TYPE					3			3			0x1008			0x1008			0x1008			0x1008			0x1008			0x1008			# bsd consensus
 syscon	so	SO_ERROR				4			4			0x1007			0x1007			0x1007			0x1007			0x1007			0x1007			# takes int pointer and stores/clears the pending error code; bsd consensus
 syscon	so	SO_ACCEPTCONN				30			30			2			2			2			2			2			2			# takes int pointer and stores boolean indicating if listen() was called on fd; bsd consensus
 syscon	so	SO_REUSEPORT				15			15			512			512			512			512			512			0			# bsd consensus; no windows support
+syscon	so	SO_REUSEPORT_LB				15			15			0			0			0x10000			0			0			0			# load balances connections across listening sockets bound to the same address; linux reuseport does this implicitly
 syscon	so	SO_REUSEADDR				2			2			4			4			4			4			4			-5			# SO_EXCLUSIVEADDRUSE on Windows (see third_party/python/Lib/test/support/__init__.py)
 syscon	so	SO_KEEPALIVE				9			9			8			8			8			8			8			8			# bsd consensus
 syscon	so	SO_DONTROUTE				5			5			16			16			16			16			16			16			# bsd consensus
@@ -378,6 +380,8 @@ syscon	tcp	TCP_REPAIR				19			19			0			0			0			0			0			0			# what is it
 syscon	tcp	TCP_REPAIR_OPTIONS			22			22			0			0			0			0			0			0			# what is it
 syscon	tcp	TCP_REPAIR_QUEUE			20			20			0			0			0			0			0			0			# what is it
 syscon	tcp	TCP_THIN_LINEAR_TIMEOUTS		16			16			0			0			0			0			0			0			# what is it
+syscon	udp	UDP_SEGMENT				103			103			0			0			0			0			0			0			# setsockopt(sock, SOL_UDP, UDP_SEGMENT, &gso_size, 4) sends one big buffer as many datagrams; linux 4.18+
+syscon	udp	UDP_GRO					104			104			0			0			0			0			0			0			# setsockopt(sock, SOL_UDP, UDP_GRO, &one, 4) coalesces received datagrams; cmsg carries segment size; linux 5.0+
 
 #	IPPROTO_IP (or SOL_IP) socket options
 #
@@ -763,6 +767,7 @@ syscon	msg	MSG_NOSIGNAL				0x4000			0x4000			0x80000			0x80000			0x020000		0x040
 syscon	msg	MSG_TRUNC				0x20			0x20			0x10			0x10			0x10			0x10			0x10			0x0100			# bsd consensus
 syscon	msg	MSG_CTRUNC				8			8			0x20			0x20			0x20			0x20			0x20			0x0200			# bsd consensus
 syscon	msg	MSG_FASTOPEN				0x20000000		0x20000000		-1			-1			-1			-1			-1			-1			#
+syscon	msg	MSG_WAITFORONE				0x10000			0x10000			0x40000000		0x40000000		0x80000			0x1000			0x2000			0x20000000		# recvmmsg: return after first message; polyfilled outside linux
 
 #	getpriority() / setpriority() magnums (a.k.a. nice)
 #
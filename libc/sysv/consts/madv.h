@@ -6,5 +6,7 @@
 #define MADV_SEQUENTIAL 2
 #define MADV_WILLNEED   3
 #define MADV_DONTNEED   4
+#define MADV_HUGEPAGE   14 /* linux only; ignored elsewhere */
+#define MADV_NOHUGEPAGE 15 /* linux only; ignored elsewhere */
 
 #endif /* COSMOPOLITAN_LIBC_SYSV_CONSTS_MADV_H_ */
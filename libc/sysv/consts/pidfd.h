@@ -0,0 +1,7 @@
+#ifndef COSMOPOLITAN_LIBC_SYSV_CONSTS_PIDFD_H_
+#define COSMOPOLITAN_LIBC_SYSV_CONSTS_PIDFD_H_
+#include "libc/sysv/consts/o.h"
+
+#define PIDFD_NONBLOCK O_NONBLOCK
+
+#endif /* COSMOPOLITAN_LIBC_SYSV_CONSTS_PIDFD_H_ */
@@ -46,5 +46,12 @@ extern const int SO_SNDLOWAT;
 extern const int SO_REUSEPORT;
 #define SO_REUSEPORT SO_REUSEPORT
 
+/*
+ * this is nonzero on platforms where the kernel distributes incoming
+ * connections among listening sockets which share the same address.
+ */
+extern const int SO_REUSEPORT_LB;
+#define SO_REUSEPORT_LB SO_REUSEPORT_LB
+
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_LIBC_SYSV_CONSTS_SO_H_ */
@@ -12,7 +12,9 @@
 COSMOPOLITAN_C_START_
 
 extern const int SOL_SOCKET;
+extern const int SOL_TLS;
 #define SOL_SOCKET SOL_SOCKET
+#define SOL_TLS    SOL_TLS
 
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_LIBC_SYSV_CONSTS_SOL_H_ */
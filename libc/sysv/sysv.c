@@ -21,6 +21,7 @@
 #include "libc/errno.h"
 #include "libc/intrin/atomic.h"
 #include "libc/intrin/weaken.h"
+#include "libc/nexgen32e/rdtsc.h"
 #include "libc/sysv/errfuns.h"
 #include "libc/sysv/errno.h"
 #include "libc/thread/posixthread.internal.h"
@@ -116,6 +117,10 @@ dontinline long systemfive_cancellable(void) {
  */
 long systemfive(void) {
 
+  // let --strace-summary measure how long the system call takes
+  if (cosmo_tls_register && __get_tls()->tib_strace > 0)
+    __get_tls()->tib_systsc = rdtsc();
+
   // handle special cases
   if (IsLinux() || IsFreebsd()) {
     if (IsFreebsd())
@@ -1,23 +1,70 @@
 #ifndef COSMOPOLITAN_LIBC_TESTLIB_BENCHMARK_H_
 #define COSMOPOLITAN_LIBC_TESTLIB_BENCHMARK_H_
 #include "libc/cosmotime.h"
+#include "libc/mem/mem.h"
+#include "libc/nexgen32e/rdtsc.h"
+#include "libc/runtime/runtime.h"
 #include "libc/stdio/stdio.h"
 COSMOPOLITAN_C_START_
 
 #define X(x) __expropriate(x)
 #define V(x) __veil("r", x)
 
-#define BENCHMARK(ITERATIONS, WORK_PER_RUN, CODE)                     \
-  do {                                                                \
-    struct timespec start = timespec_real();                          \
-    for (int __i = 0; __i < ITERATIONS; ++__i) {                      \
-      asm volatile("" ::: "memory");                                  \
-      CODE;                                                           \
-    }                                                                 \
-    long ns = timespec_tonanos(timespec_sub(timespec_real(), start)); \
-    _print_benchmark_result(ns, WORK_PER_RUN, ITERATIONS, #CODE);     \
+#ifndef BENCHMARK_SAMPLES
+#define BENCHMARK_SAMPLES 64
+#endif
+
+/**
+ * Runs CODE ITERATIONS times and prints how long it took.
+ *
+ * The iterations are timed in up to BENCHMARK_SAMPLES batches so the
+ * median and 99th percentile batch can be reported alongside the mean.
+ * If the `BENCHMARK_JSON` environment variable is set, then one JSON
+ * object is printed per line instead, which `tool/scripts/benchcmp`
+ * can compare against a baseline.
+ */
+#define BENCHMARK(ITERATIONS, WORK_PER_RUN, CODE)                      \
+  do {                                                                 \
+    int __n = ITERATIONS, __s = 0;                                     \
+    int __batch = (__n + BENCHMARK_SAMPLES - 1) / BENCHMARK_SAMPLES;   \
+    double __ns[BENCHMARK_SAMPLES];                                    \
+    size_t __heap = mallinfo().arena;                                  \
+    uint64_t __tsc = rdtsc();                                          \
+    struct timespec start = timespec_real();                           \
+    for (int __b = 0; __b < __n; __b += __batch) {                     \
+      int __e = __n - __b < __batch ? __n : __b + __batch;             \
+      struct timespec __t = timespec_real();                           \
+      for (int __i = __b; __i < __e; ++__i) {                          \
+        asm volatile("" ::: "memory");                                 \
+        CODE;                                                          \
+      }                                                                \
+      __ns[__s++] = (double)timespec_tonanos(                          \
+                        timespec_sub(timespec_real(), __t)) /          \
+                    (__e - __b);                                       \
+    }                                                                  \
+    long ns = timespec_tonanos(timespec_sub(timespec_real(), start));  \
+    __tsc = rdtsc() - __tsc;                                           \
+    _report_benchmark_result(ns, __ns, __s, __tsc,                     \
+                             mallinfo().arena - __heap, WORK_PER_RUN,  \
+                             ITERATIONS, #CODE);                       \
   } while (0)
 
+static const char* _benchmark_time_unit(double* time_value) {
+  double time_per_op = *time_value;
+  if (time_per_op >= 1e6) {
+    *time_value = time_per_op / 1e6;
+    return "ms";
+  } else if (time_per_op >= 1e3) {
+    *time_value = time_per_op / 1e3;
+    return "µs";
+  } else if (time_per_op >= .01) {
+    return "ns";
+  } else {
+    *time_value = time_per_op * 1e3;
+    return "ps";
+  }
+}
+
 static void _print_benchmark_result(double total_nanos, double work_per_run,
                                     int iterations, const char* code) {
   double time_per_op = total_nanos / (work_per_run * iterations);
@@ -42,19 +89,8 @@ static void _print_benchmark_result(double total_nanos, double work_per_run,
   }
 
   // Determine time unit
-  if (time_per_op >= 1e6) {
-    time_value = time_per_op / 1e6;
-    time_unit = "ms";
-  } else if (time_per_op >= 1e3) {
-    time_value = time_per_op / 1e3;
-    time_unit = "µs";
-  } else if (time_per_op >= .01) {
-    time_value = time_per_op;
-    time_unit = "ns";
-  } else {
-    time_value = time_per_op * 1e3;
-    time_unit = "ps";
-  }
+  time_value = time_per_op;
+  time_unit = _benchmark_time_unit(&time_value);
 
   // Determine work unit
   const char* work_unit;
@@ -76,5 +112,58 @@ static void _print_benchmark_result(double total_nanos, double work_per_run,
          code);
 }
 
+static void _print_benchmark_json(const char* s) {
+  putchar('"');
+  for (; *s; ++s) {
+    if (*s == '"' || *s == '\\') {
+      putchar('\\');
+      putchar(*s);
+    } else if ((unsigned char)*s < ' ') {
+      putchar(' ');
+    } else {
+      putchar(*s);
+    }
+  }
+  putchar('"');
+}
+
+static void _report_benchmark_result(double total_nanos, double* samples,
+                                     int count, double cycles, long heap,
+                                     double work_per_run, int iterations,
+                                     const char* code) {
+  int i, j;
+  double x, ops, p50, p99;
+
+  // sort batch timings to find percentiles
+  for (i = 1; i < count; ++i) {
+    x = samples[i];
+    for (j = i; j && samples[j - 1] > x; --j)
+      samples[j] = samples[j - 1];
+    samples[j] = x;
+  }
+  p50 = count ? samples[count / 2] / work_per_run : 0;
+  p99 = count ? samples[(count * 99 - 1) / 100] / work_per_run : 0;
+  ops = work_per_run * iterations;
+
+  if (!getenv("BENCHMARK_JSON")) {
+    const char* unit;
+    _print_benchmark_result(total_nanos, work_per_run, iterations, code);
+    unit = _benchmark_time_unit(&p50);
+    printf("%8.2f %-2s median", p50, unit);
+    unit = _benchmark_time_unit(&p99);
+    printf("%8.2f %-2s p99 %10.1f cycles %ld heap bytes\n", p99, unit,
+           cycles / ops, heap);
+    return;
+  }
+
+  printf("{\"name\":");
+  _print_benchmark_json(code);
+  printf(",\"iterations\":%d,\"work\":%.17g,\"ns_per_op\":%.17g"
+         ",\"ns_median\":%.17g,\"ns_p99\":%.17g,\"cycles_per_op\":%.17g"
+         ",\"work_per_sec\":%.17g,\"heap_bytes\":%ld}\n",
+         iterations, work_per_run, total_nanos / ops, p50, p99, cycles / ops,
+         ops / (total_nanos * 1e-9), heap);
+}
+
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_LIBC_TESTLIB_BENCHMARK_H_ */
@@ -20,8 +20,34 @@
 #include "libc/intrin/safemacros.h"
 #include "libc/math.h"
 #include "libc/runtime/runtime.h"
+#include "libc/stdio/stdio.h"
+
+// when BENCHMARK_JSON is set, results are printed to stdout as one json
+// object per line, using the same keys as the BENCHMARK() macro, so the
+// output can be compared across commits with tool/scripts/benchcmp
+static void __testlib_ezbenchjson(const char *form, size_t n, double c1,
+                                  double c2) {
+  const char *s;
+  printf("{\"name\":\"");
+  for (s = form; *s; ++s) {
+    if (*s == '"' || *s == '\\')
+      putchar('\\');
+    putchar((unsigned char)*s < ' ' ? ' ' : *s);
+  }
+  printf("\",\"work\":%zu,\"ns_per_op\":%.17g,\"cycles_per_op\":%.17g", n,
+         c1 / 3, c1);
+  if (c2)
+    printf(",\"cycles_strict\":%.17g", c2);
+  if (n)
+    printf(",\"work_per_sec\":%.17g", n / (c1 / 3) * 1e9);
+  printf("}\n");
+}
 
 void __testlib_ezbenchreport(const char *form, double c1, double c2) {
+  if (getenv("BENCHMARK_JSON")) {
+    __testlib_ezbenchjson(form, 0, c1, c2);
+    return;
+  }
   kprintf(" *     %-19s l: %,9luc %,9luns   m: %,9luc %,9luns\n", form,
           lrint(c1), lrint(c1 / 3), lrint(c2), lrint(c2 / 3));
 }
@@ -31,6 +57,10 @@ void __testlib_ezbenchreport_n(const char *form, char z, size_t n, double c) {
   uint64_t bps;
   char msg[128];
   ksnprintf(msg, sizeof(msg), "%s %c=%d", form, z, n);
+  if (getenv("BENCHMARK_JSON")) {
+    __testlib_ezbenchjson(msg, n, c, 0);
+    return;
+  }
   cn = max(lrint(c / 3), 1);
   if (!n) {
     kprintf("\n");
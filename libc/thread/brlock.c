@@ -0,0 +1,122 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/blockcancel.internal.h"
+#include "libc/cosmo.h"
+#include "libc/intrin/atomic.h"
+#include "libc/limits.h"
+#include "libc/thread/lock.h"
+#include "libc/thread/thread.h"
+
+//
+// big reader lock
+//
+// readers only touch the cache line of their own cpu shard, so taking
+// a read lock costs one uncontended atomic increment. writers have to
+// visit every shard, so this lock is meant for data that's read often
+// and changed rarely, e.g. configuration and routing tables.
+//
+// _writer is 0 when unlocked, 1 when write locked, and 2 if there are
+// also threads parked on it. readers announce themselves on a shard and
+// then check _writer, while the writer sets _writer and then checks the
+// shards, so sequential consistency ensures at least one sees the other
+//
+
+static void cosmo_brlock_park(cosmo_brlock_t *lk) {
+  int w = atomic_load_explicit(&lk->_writer, memory_order_relaxed);
+  for (int n = 0; w; ++n) {
+    if (n < MUTEX_SPIN_MAX && w == 1) {
+      pthread_pause_np();
+    } else if (w == 2 || atomic_compare_exchange_weak_explicit(
+                             &lk->_writer, &w, 2, memory_order_relaxed,
+                             memory_order_relaxed)) {
+      BLOCK_CANCELATION;
+      cosmo_futex_wait(&lk->_writer, 2, 0, 0, 0);
+      ALLOW_CANCELATION;
+    }
+    w = atomic_load_explicit(&lk->_writer, memory_order_relaxed);
+  }
+}
+
+/**
+ * Acquires read lock on big reader lock.
+ *
+ * Many threads may hold the read lock at once. This is cheap unless a
+ * writer is active, in which case the caller waits for it to finish.
+ * Read locks aren't recursive while writers are waiting.
+ *
+ * @return token which must be passed to cosmo_brlock_rdunlock()
+ */
+unsigned cosmo_brlock_rdlock(cosmo_brlock_t *lk) {
+  unsigned s;
+  for (;;) {
+    s = cosmo_shard();
+    atomic_fetch_add(&lk->_slots[s]._readers, 1);
+    if (!atomic_load(&lk->_writer))
+      return s;
+    cosmo_brlock_rdunlock(lk, s);
+    cosmo_brlock_park(lk);
+  }
+}
+
+/**
+ * Releases read lock on big reader lock.
+ *
+ * @param token is what cosmo_brlock_rdlock() returned, since the calling
+ *     thread might have migrated to a different cpu in the meantime
+ */
+void cosmo_brlock_rdunlock(cosmo_brlock_t *lk, unsigned token) {
+  if (atomic_fetch_sub(&lk->_slots[token]._readers, 1) == 1 &&
+      atomic_load(&lk->_writer))
+    cosmo_futex_wake(&lk->_slots[token]._readers, 1, 0);
+}
+
+/**
+ * Acquires write lock on big reader lock.
+ *
+ * This waits for any existing readers to leave every shard, so it's
+ * considerably more expensive than pthread_rwlock_wrlock().
+ */
+void cosmo_brlock_wrlock(cosmo_brlock_t *lk) {
+  int w, r;
+  for (;;) {
+    w = 0;
+    if (atomic_compare_exchange_strong(&lk->_writer, &w, 1))
+      break;
+    cosmo_brlock_park(lk);
+  }
+  for (int s = 0; s < COSMO_SHARDS; ++s) {
+    for (int n = 0; (r = atomic_load(&lk->_slots[s]._readers)); ++n) {
+      if (n < MUTEX_SPIN_MAX) {
+        pthread_pause_np();
+      } else {
+        BLOCK_CANCELATION;
+        cosmo_futex_wait(&lk->_slots[s]._readers, r, 0, 0, 0);
+        ALLOW_CANCELATION;
+      }
+    }
+  }
+}
+
+/**
+ * Releases write lock on big reader lock.
+ */
+void cosmo_brlock_wrunlock(cosmo_brlock_t *lk) {
+  if (atomic_exchange_explicit(&lk->_writer, 0, memory_order_release) == 2)
+    cosmo_futex_wake(&lk->_writer, INT_MAX, 0);
+}
@@ -26,6 +26,7 @@
 #include "libc/cosmo.h"
 #include "libc/cosmotime.h"
 #include "libc/intrin/maps.h"
+#include "libc/macros.h"
 #include "libc/intrin/strace.h"
 #include "libc/nt/enum/processcreationflags.h"
 #include "libc/nt/thread.h"
@@ -57,32 +58,33 @@ textwindows dontinstrument static uint32_t __itimer_worker(void *arg) {
       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NOFORK);
   __maps_unlock();
   for (;;) {
-    bool dosignal = false;
-    struct timeval now, waituntil;
+    bool dosignal[ARRAYLEN(__itimer.it)] = {0};
+    struct timeval now, waituntil = timeval_max;
     __itimer_lock();
     now = timeval_real();
-    if (timeval_iszero(__itimer.it.it_value)) {
-      waituntil = timeval_max;
-    } else {
-      if (timeval_cmp(now, __itimer.it.it_value) < 0) {
-        waituntil = __itimer.it.it_value;
-      } else {
-        if (timeval_iszero(__itimer.it.it_interval)) {
-          __itimer.it.it_value = timeval_zero;
-          waituntil = timeval_max;
+    for (int i = 0; i < ARRAYLEN(__itimer.it); ++i) {
+      struct itimerval *it = &__itimer.it[i];
+      if (timeval_iszero(it->it_value))
+        continue;
+      if (timeval_cmp(now, it->it_value) >= 0) {
+        if (timeval_iszero(it->it_interval)) {
+          it->it_value = timeval_zero;
         } else {
           do {
-            __itimer.it.it_value =
-                timeval_add(__itimer.it.it_value, __itimer.it.it_interval);
-          } while (timeval_cmp(now, __itimer.it.it_value) > 0);
-          waituntil = __itimer.it.it_value;
+            it->it_value = timeval_add(it->it_value, it->it_interval);
+          } while (timeval_cmp(now, it->it_value) > 0);
         }
-        dosignal = true;
+        dosignal[i] = true;
       }
+      if (!timeval_iszero(it->it_value) &&
+          timeval_cmp(it->it_value, waituntil) < 0)
+        waituntil = it->it_value;
     }
     __itimer_unlock();
-    if (dosignal)
+    if (dosignal[0])
       __sig_generate(SIGALRM, SI_TIMER);
+    if (dosignal[1])
+      __sig_generate(SIGPROF, SI_TIMER);
     __itimer_lock();
     struct timespec deadline = timeval_totimespec(waituntil);
     pthread_cond_timedwait(&__itimer.cond, &__itimer.lock, &deadline);
@@ -101,13 +103,17 @@ textwindows intptr_t __itimer_worker_handle(void) {
   return __itimer.thread;
 }
 
+// ITIMER_PROF is approximated using the wall clock, since there's no
+// cheap way to be notified when the process has consumed cpu time
 textwindows int sys_setitimer_nt(int which, const struct itimerval *neu,
                                  struct itimerval *old) {
-  struct itimerval config;
+  struct itimerval config, *it;
   cosmo_once(&__itimer.once, __itimer_setup);
-  if (which != ITIMER_REAL || (neu && (!timeval_isvalid(neu->it_value) ||
-                                       !timeval_isvalid(neu->it_interval))))
+  if ((which != ITIMER_REAL && which != ITIMER_PROF) ||
+      (neu && (!timeval_isvalid(neu->it_value) ||
+               !timeval_isvalid(neu->it_interval))))
     return einval();
+  it = &__itimer.it[which == ITIMER_PROF];
   if (neu)
     // POSIX defines setitimer() with the restrict keyword but let's
     // accommodate the usage setitimer(ITIMER_REAL, &it, &it) anyway
@@ -115,13 +121,13 @@ textwindows int sys_setitimer_nt(int which, const struct itimerval *neu,
   BLOCK_SIGNALS;
   __itimer_lock();
   if (old) {
-    old->it_interval = __itimer.it.it_interval;
-    old->it_value = timeval_subz(__itimer.it.it_value, timeval_real());
+    old->it_interval = it->it_interval;
+    old->it_value = timeval_subz(it->it_value, timeval_real());
   }
   if (neu) {
     if (!timeval_iszero(config.it_value))
       config.it_value = timeval_add(config.it_value, timeval_real());
-    __itimer.it = config;
+    *it = config;
     pthread_cond_signal(&__itimer.cond);
   }
   __itimer_unlock();
@@ -10,7 +10,7 @@ struct IntervalTimer {
   atomic_uint once;
   intptr_t thread;
   pthread_cond_t cond;
-  struct itimerval it;
+  struct itimerval it[2]; /* ITIMER_REAL, ITIMER_PROF */
 };
 
 extern struct IntervalTimer __itimer;
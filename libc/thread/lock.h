@@ -23,6 +23,9 @@ COSMOPOLITAN_C_START_
 // 0b0000000000000000000000000000000000000000000000000000000000000000
 //
 
+#define MUTEX_SPIN_MIN 10   // pause iterations granted to a new lock
+#define MUTEX_SPIN_MAX 100  // upper bound on adaptive spinning
+
 #define MUTEX_DEPTH_MIN 0x00000020ull
 #define MUTEX_DEPTH_MAX 0x000007e0ull
 
@@ -0,0 +1,194 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/thread/mpsc.h"
+#include "libc/atomic.h"
+#include "libc/cosmo.h"
+#include "libc/errno.h"
+#include "libc/intrin/atomic.h"
+#include "libc/macros.h"
+#include "libc/mem/mem.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/clock.h"
+#include "libc/thread/thread.h"
+
+/**
+ * @fileoverview bounded lock-free multi-producer single-consumer queue
+ *
+ * Each slot holds a sequence number ahead of its payload. A producer
+ * claims position `p` by compare-and-swapping the tail, but only after
+ * it sees slot `p & mask` has sequence `p`, meaning the consumer has
+ * finished with whatever was there last lap. Once the payload has been
+ * copied in, the producer publishes it by setting the sequence to
+ * `p + 1`, which is still pending the consumer reads. The consumer
+ * then frees the slot for the next lap by setting it to `p + count`.
+ * Threads only ever touch the cache line of the slot they're on, so
+ * pushes from different threads don't contend on anything except the
+ * tail counter.
+ */
+
+#define SEQ(q, i) \
+  ((atomic_uint *)((q)->mpsc_slots + (size_t)((i) & (q)->mpsc_mask) * \
+                                         (q)->mpsc_stride))
+#define DATA(q, i) ((char *)SEQ(q, i) + 16)
+
+static bool mpsc_ready(mpsc_t *q, unsigned want) {
+  unsigned head = atomic_load_explicit(&q->mpsc_head, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(&q->mpsc_tail, memory_order_relaxed);
+  return tail - head >= want &&
+         atomic_load_explicit(SEQ(q, head), memory_order_acquire) == head + 1;
+}
+
+/**
+ * Creates queue.
+ *
+ * @param count is maximum number of items, rounded up to a power of two
+ * @param size is the number of bytes in each item
+ * @return 0 on success, or errno on error
+ * @raise EINVAL if `count` or `size` is zero or too large
+ * @raise ENOMEM if memory couldn't be allocated
+ */
+errno_t mpsc_init(mpsc_t *q, unsigned count, size_t size) {
+  unsigned i, n;
+  bzero(q, sizeof(*q));
+  if (!count || count > 0x40000000u || !size || size > 0x10000000u)
+    return EINVAL;
+  for (n = 1; n < count; n <<= 1) {
+  }
+  count = n;
+  q->mpsc_mask = count - 1;
+  q->mpsc_stride = ROUNDUP(16 + size, 16);
+  if (!(q->mpsc_slots = memalign(64, (size_t)count * q->mpsc_stride)))
+    return ENOMEM;
+  for (i = 0; i < count; ++i)
+    atomic_init(SEQ(q, i), i);
+  return 0;
+}
+
+/**
+ * Destroys queue.
+ */
+void mpsc_destroy(mpsc_t *q) {
+  free(q->mpsc_slots);
+  q->mpsc_slots = 0;
+}
+
+/**
+ * Adds item to queue.
+ *
+ * This function may be called by any number of threads at once. It
+ * doesn't block, and wakes up the consumer once it's ready to proceed
+ * if it's sleeping in mpsc_wait().
+ *
+ * @return true if `item` was copied, or false if queue is full
+ */
+bool mpsc_push(mpsc_t *q, const void *item) {
+  int want;
+  unsigned pos, seq;
+  pos = atomic_load_explicit(&q->mpsc_tail, memory_order_relaxed);
+  for (;;) {
+    seq = atomic_load_explicit(SEQ(q, pos), memory_order_acquire);
+    if (seq == pos) {
+      if (atomic_compare_exchange_weak_explicit(&q->mpsc_tail, &pos, pos + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed))
+        break;
+    } else if ((int)(seq - pos) < 0) {
+      return false;
+    } else {
+      pos = atomic_load_explicit(&q->mpsc_tail, memory_order_relaxed);
+    }
+  }
+  memcpy(DATA(q, pos), item, q->mpsc_stride - 16);
+  atomic_store_explicit(SEQ(q, pos), pos + 1, memory_order_release);
+  atomic_thread_fence(memory_order_seq_cst);
+  if ((want = atomic_load_explicit(&q->mpsc_waiting, memory_order_relaxed)) &&
+      mpsc_ready(q, want) &&
+      atomic_compare_exchange_strong_explicit(&q->mpsc_waiting, &want, 0,
+                                              memory_order_relaxed,
+                                              memory_order_relaxed))
+    cosmo_futex_wake(&q->mpsc_waiting, 1, PTHREAD_PROCESS_PRIVATE);
+  return true;
+}
+
+/**
+ * Removes oldest item from queue.
+ *
+ * Only one thread may call this function at a time.
+ *
+ * @return true if item was copied to `out`, or false if queue is empty
+ *     or the oldest item is still being copied by its producer
+ */
+bool mpsc_pop(mpsc_t *q, void *out) {
+  unsigned pos = atomic_load_explicit(&q->mpsc_head, memory_order_relaxed);
+  if (atomic_load_explicit(SEQ(q, pos), memory_order_acquire) != pos + 1)
+    return false;
+  memcpy(out, DATA(q, pos), q->mpsc_stride - 16);
+  atomic_store_explicit(SEQ(q, pos), pos + q->mpsc_mask + 1,
+                        memory_order_release);
+  atomic_store_explicit(&q->mpsc_head, pos + 1, memory_order_relaxed);
+  return true;
+}
+
+/**
+ * Returns number of items in queue.
+ *
+ * This includes items whose producers are still copying them, so the
+ * result is only exact when no pushes are in flight.
+ */
+unsigned mpsc_count(mpsc_t *q) {
+  unsigned head = atomic_load_explicit(&q->mpsc_head, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(&q->mpsc_tail, memory_order_relaxed);
+  return tail - head;
+}
+
+/**
+ * Waits for queue to have items.
+ *
+ * This returns once the consumer may pop at least one item and `want`
+ * items have been pushed, or when `abstime` passes. Only the consumer
+ * may call this function.
+ *
+ * @param want is number of items to wait for, which is clamped to the
+ *     range [1,count]
+ * @param abstime is absolute `CLOCK_REALTIME` deadline, or null to wait
+ *     forever
+ * @return 0 on success, or errno on error
+ * @raise ETIMEDOUT if `abstime` passed
+ * @raise ECANCELED if calling thread was cancelled in masked mode
+ * @cancelationpoint
+ */
+errno_t mpsc_wait(mpsc_t *q, unsigned want, const struct timespec *abstime) {
+  int rc;
+  want = MAX(1, MIN(want, q->mpsc_mask + 1));
+  for (;;) {
+    if (mpsc_ready(q, want))
+      return 0;
+    atomic_store_explicit(&q->mpsc_waiting, want, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (mpsc_ready(q, want)) {
+      atomic_store_explicit(&q->mpsc_waiting, 0, memory_order_relaxed);
+      return 0;
+    }
+    rc = cosmo_futex_wait(&q->mpsc_waiting, want, PTHREAD_PROCESS_PRIVATE,
+                          CLOCK_REALTIME, abstime);
+    atomic_store_explicit(&q->mpsc_waiting, 0, memory_order_relaxed);
+    if (rc == -ETIMEDOUT || rc == -ECANCELED)
+      return mpsc_ready(q, want) ? 0 : -rc;
+  }
+}
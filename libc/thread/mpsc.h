@@ -0,0 +1,29 @@
+#ifndef COSMOPOLITAN_LIBC_THREAD_MPSC_H_
+#define COSMOPOLITAN_LIBC_THREAD_MPSC_H_
+#include "libc/calls/struct/timespec.h"
+COSMOPOLITAN_C_START_
+
+#ifndef __cplusplus
+#define _MPSC_ATOMIC(x) _Atomic(x)
+#else
+#define _MPSC_ATOMIC(x) x
+#endif
+
+typedef struct {
+  _Alignas(64) _MPSC_ATOMIC(unsigned) mpsc_tail; /* next push position */
+  _Alignas(64) _MPSC_ATOMIC(unsigned) mpsc_head; /* next pop position */
+  _Alignas(64) _MPSC_ATOMIC(int) mpsc_waiting;   /* items consumer wants */
+  unsigned mpsc_mask;
+  unsigned mpsc_stride;
+  char *mpsc_slots;
+} mpsc_t;
+
+errno_t mpsc_init(mpsc_t *, unsigned, size_t) libcesque;
+void mpsc_destroy(mpsc_t *) libcesque;
+bool mpsc_push(mpsc_t *, const void *) libcesque;
+bool mpsc_pop(mpsc_t *, void *) libcesque;
+unsigned mpsc_count(mpsc_t *) libcesque;
+errno_t mpsc_wait(mpsc_t *, unsigned, const struct timespec *) libcesque;
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_LIBC_THREAD_MPSC_H_ */
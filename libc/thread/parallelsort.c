@@ -0,0 +1,181 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/cosmo.h"
+#include "libc/intrin/atomic.h"
+#include "libc/mem/alg.h"
+#include "libc/mem/mem.h"
+#include "libc/str/str.h"
+
+//
+// parallel radix sort
+//
+// the array is cut into chunks which histogram the most significant
+// varying byte of their keys in parallel. those histograms are turned
+// into per-chunk bucket offsets, the chunks scatter their elements to
+// a temporary buffer in parallel (which keeps it stable), and finally
+// each bucket is radix sorted and copied back on its own task.
+//
+
+#define SERIAL_THRESHOLD (1 << 20)
+#define CHUNKS 64
+
+struct ParallelSort {
+  char *A;
+  char *T;
+  size_t n;
+  size_t size;
+  int shift;
+  atomic_int failed;
+  uint64_t first;
+  uint64_t diff[CHUNKS];
+  size_t off[CHUNKS][256];
+  size_t bucket[257];
+};
+
+static inline uint64_t parallel_sort_key(struct ParallelSort *s, size_t i) {
+  uint64_t key;
+  memcpy(&key, s->A + i * s->size, sizeof(key));
+  return key;
+}
+
+static int parallel_sort_serial(char *A, size_t n, size_t size) {
+  if (size == sizeof(uint64_t))
+    return radix_sort_uint64((uint64_t *)A, n);
+  return radix_sort_pairs((struct SortPair *)A, n);
+}
+
+static void parallel_sort_diff(long c, long e, void *arg) {
+  size_t i, j;
+  uint64_t diff;
+  struct ParallelSort *s = arg;
+  for (; c < e; ++c) {
+    diff = 0;
+    i = s->n * c / CHUNKS;
+    j = s->n * (c + 1) / CHUNKS;
+    for (; i < j; ++i)
+      diff |= parallel_sort_key(s, i) ^ s->first;
+    s->diff[c] = diff;
+  }
+}
+
+static void parallel_sort_count(long c, long e, void *arg) {
+  size_t i, j;
+  struct ParallelSort *s = arg;
+  for (; c < e; ++c) {
+    i = s->n * c / CHUNKS;
+    j = s->n * (c + 1) / CHUNKS;
+    for (; i < j; ++i)
+      s->off[c][parallel_sort_key(s, i) >> s->shift & 255]++;
+  }
+}
+
+static void parallel_sort_scatter(long c, long e, void *arg) {
+  size_t i, j;
+  struct ParallelSort *s = arg;
+  for (; c < e; ++c) {
+    i = s->n * c / CHUNKS;
+    j = s->n * (c + 1) / CHUNKS;
+    for (; i < j; ++i)
+      memcpy(s->T + s->off[c][parallel_sort_key(s, i) >> s->shift & 255]++ *
+                        s->size,
+             s->A + i * s->size, s->size);
+  }
+}
+
+static void parallel_sort_bucket(long b, long e, void *arg) {
+  size_t i, n;
+  struct ParallelSort *s = arg;
+  for (; b < e; ++b) {
+    i = s->bucket[b];
+    n = s->bucket[b + 1] - i;
+    if (parallel_sort_serial(s->T + i * s->size, n, s->size) == -1)
+      s->failed = 1;
+    memcpy(s->A + i * s->size, s->T + i * s->size, n * s->size);
+  }
+}
+
+static int parallel_sort(struct CosmoTaskPool *p, void *A, size_t n,
+                         size_t size) {
+  int c, b;
+  size_t t, sum;
+  uint64_t diff;
+  struct ParallelSort *s;
+  if (!p || n < SERIAL_THRESHOLD)
+    return parallel_sort_serial(A, n, size);
+  if (!(s = calloc(1, sizeof(*s))))
+    return -1;
+  if (!(s->T = malloc(n * size))) {
+    free(s);
+    return -1;
+  }
+  s->A = A;
+  s->n = n;
+  s->size = size;
+  s->first = parallel_sort_key(s, 0);
+  cosmo_parallel_for(p, 0, CHUNKS, 1, parallel_sort_diff, s);
+  for (diff = c = 0; c < CHUNKS; ++c)
+    diff |= s->diff[c];
+  if (!diff) {
+    free(s->T);
+    free(s);
+    return 0;
+  }
+  s->shift = 63 - __builtin_clzll(diff);
+  s->shift = s->shift < 7 ? 0 : s->shift - 7;
+  cosmo_parallel_for(p, 0, CHUNKS, 1, parallel_sort_count, s);
+  for (sum = b = 0; b < 256; ++b) {
+    s->bucket[b] = sum;
+    for (c = 0; c < CHUNKS; ++c) {
+      t = s->off[c][b];
+      s->off[c][b] = sum;
+      sum += t;
+    }
+  }
+  s->bucket[256] = sum;
+  cosmo_parallel_for(p, 0, CHUNKS, 1, parallel_sort_scatter, s);
+  cosmo_parallel_for(p, 0, 256, 1, parallel_sort_bucket, s);
+  b = s->failed ? -1 : 0;
+  free(s->T);
+  free(s);
+  return b;
+}
+
+/**
+ * Sorts array of unsigned 64-bit integers using thread pool.
+ *
+ * Small arrays, or a null pool, fall back to radix_sort_uint64().
+ *
+ * @return 0 on success, or -1 w/ errno if memory couldn't be allocated
+ */
+int cosmo_parallel_sort_uint64(struct CosmoTaskPool *p, uint64_t *A,
+                               size_t n) {
+  return parallel_sort(p, A, n, sizeof(*A));
+}
+
+/**
+ * Stably sorts array of key/value pairs by key using thread pool.
+ *
+ * Small arrays, or a null pool, fall back to radix_sort_pairs().
+ *
+ * @return 0 on success, or -1 w/ errno if memory couldn't be allocated
+ */
+int cosmo_parallel_sort_pairs(struct CosmoTaskPool *p, struct SortPair *A,
+                              size_t n) {
+  return parallel_sort(p, A, n, sizeof(*A));
+}
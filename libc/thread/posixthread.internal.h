@@ -88,6 +88,7 @@ struct PosixThread {
   intptr_t pt_exiter[5];
   pthread_attr_t pt_attr;
   atomic_bool pt_intoff;
+  unsigned pt_sigpass;  // last __sig_worker() sweep that visited thread
 };
 
 typedef void (*atfork_f)(void);
@@ -101,6 +101,8 @@ void _pthread_free(struct PosixThread *pt) {
   }
 
   // free heap memory associated with thread
+  tcache_destroy(pt->tib->tib_tcache);
+  pt->tib->tib_tcache = 0;
   tmspace_release(pt->tib->tib_malloc);
   if (pt->pt_flags & PT_OWNSIGALTSTACK)
     free(pt->pt_attr.__sigaltstackaddr);
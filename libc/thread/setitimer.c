@@ -59,6 +59,9 @@
  *
  * Timers are not inherited across fork.
  *
+ * On Windows, only ITIMER_REAL and ITIMER_PROF are supported, and the
+ * latter is measured using wall time rather than cpu time.
+ *
  * @param which can be ITIMER_REAL, ITIMER_VIRTUAL, etc.
  * @param newvalue specifies the interval ({0,0} means one-shot) and
  *     duration ({0,0} means disarm) in microseconds ∈ [0,999999] and
@@ -0,0 +1,370 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/cosmo.h"
+#include "libc/errno.h"
+#include "libc/intrin/atomic.h"
+#include "libc/limits.h"
+#include "libc/macros.h"
+#include "libc/mem/mem.h"
+#include "libc/stdio/rand.h"
+#include "libc/str/str.h"
+#include "libc/thread/thread.h"
+
+#define DEQUE_SIZE 4096  // must be two power
+
+struct CosmoTask {
+  void (*func)(void *);
+  void *arg;
+  _Atomic(struct CosmoTask *) next;
+};
+
+// chase-lev work stealing deque
+// see "correct and efficient work-stealing for weak memory models"
+struct CosmoTaskDeque {
+  _Alignas(64) atomic_long top;
+  _Alignas(64) atomic_long bottom;
+  _Atomic(struct CosmoTask *) tasks[DEQUE_SIZE];
+};
+
+struct CosmoTaskWorker {
+  struct CosmoTaskPool *pool;
+  pthread_t th;
+  unsigned rand;
+  struct CosmoTaskDeque deque;
+};
+
+struct CosmoTaskPool {
+  int count;
+  int started;
+  atomic_bool shutdown;
+  atomic_int sleepers;
+  cosmo_futex_t epoch;
+  cosmo_futex_t pending;
+  pthread_mutex_t lock;
+  _Atomic(struct CosmoTask *) inject;
+  _Atomic(struct CosmoTask *) *inject_tail;
+  struct CosmoTaskWorker *workers;
+};
+
+static _Thread_local struct CosmoTaskWorker *g_worker;
+
+static bool cosmo_task_push(struct CosmoTaskDeque *q, struct CosmoTask *t) {
+  long b = atomic_load_explicit(&q->bottom, memory_order_relaxed);
+  long a = atomic_load_explicit(&q->top, memory_order_acquire);
+  if (b - a >= DEQUE_SIZE)
+    return false;
+  atomic_store_explicit(&q->tasks[b & (DEQUE_SIZE - 1)], t,
+                        memory_order_relaxed);
+  atomic_store_explicit(&q->bottom, b + 1, memory_order_release);
+  return true;
+}
+
+static struct CosmoTask *cosmo_task_take(struct CosmoTaskDeque *q) {
+  struct CosmoTask *t;
+  long b = atomic_load_explicit(&q->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit(&q->bottom, b, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  long a = atomic_load_explicit(&q->top, memory_order_relaxed);
+  if (a > b) {
+    atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+    return 0;
+  }
+  t = atomic_load_explicit(&q->tasks[b & (DEQUE_SIZE - 1)],
+                           memory_order_relaxed);
+  if (a == b) {
+    if (!atomic_compare_exchange_strong_explicit(&q->top, &a, a + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed))
+      t = 0;
+    atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+  }
+  return t;
+}
+
+static struct CosmoTask *cosmo_task_steal(struct CosmoTaskDeque *q) {
+  struct CosmoTask *t;
+  long a = atomic_load_explicit(&q->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  long b = atomic_load_explicit(&q->bottom, memory_order_acquire);
+  if (a >= b)
+    return 0;
+  t = atomic_load_explicit(&q->tasks[a & (DEQUE_SIZE - 1)],
+                           memory_order_relaxed);
+  if (!atomic_compare_exchange_strong_explicit(&q->top, &a, a + 1,
+                                               memory_order_seq_cst,
+                                               memory_order_relaxed))
+    return 0;
+  return t;
+}
+
+static bool cosmo_task_visible(struct CosmoTaskPool *p) {
+  if (atomic_load_explicit(&p->inject, memory_order_relaxed))
+    return true;
+  for (int i = 0; i < p->count; ++i)
+    if (atomic_load(&p->workers[i].deque.bottom) >
+        atomic_load(&p->workers[i].deque.top))
+      return true;
+  return false;
+}
+
+static struct CosmoTask *cosmo_task_find(struct CosmoTaskPool *p) {
+  struct CosmoTask *t;
+  struct CosmoTaskWorker *w;
+  if ((w = g_worker) && w->pool == p && (t = cosmo_task_take(&w->deque)))
+    return t;
+  if (atomic_load_explicit(&p->inject, memory_order_relaxed)) {
+    pthread_mutex_lock(&p->lock);
+    if ((t = p->inject) && !(p->inject = t->next))
+      p->inject_tail = &p->inject;
+    pthread_mutex_unlock(&p->lock);
+    if (t)
+      return t;
+  }
+  unsigned r = w && w->pool == p ? (w->rand = w->rand * 1664525 + 1013904223)
+                                 : _rand64();
+  for (int i = 0; i < p->count; ++i) {
+    struct CosmoTaskWorker *v = p->workers + (r + i) % p->count;
+    if (v != w && (t = cosmo_task_steal(&v->deque)))
+      return t;
+  }
+  return 0;
+}
+
+static void cosmo_task_run(struct CosmoTaskPool *p, struct CosmoTask *t) {
+  t->func(t->arg);
+  free(t);
+  if (atomic_fetch_sub(&p->pending, 1) == 1)
+    cosmo_futex_wake(&p->pending, INT_MAX, PTHREAD_PROCESS_PRIVATE);
+}
+
+static void *cosmo_task_worker(void *arg) {
+  int epoch;
+  struct CosmoTask *t;
+  struct CosmoTaskWorker *w = arg;
+  struct CosmoTaskPool *p = w->pool;
+  g_worker = w;
+  for (;;) {
+    if ((t = cosmo_task_find(p))) {
+      cosmo_task_run(p, t);
+      continue;
+    }
+    epoch = atomic_load(&p->epoch);
+    if (atomic_load(&p->shutdown))
+      break;
+    atomic_fetch_add(&p->sleepers, 1);
+    if (!cosmo_task_visible(p))
+      cosmo_futex_wait(&p->epoch, epoch, PTHREAD_PROCESS_PRIVATE, 0, 0);
+    atomic_fetch_sub(&p->sleepers, 1);
+  }
+  g_worker = 0;
+  return 0;
+}
+
+static void cosmo_task_notify(struct CosmoTaskPool *p) {
+  atomic_fetch_add(&p->epoch, 1);
+  if (atomic_load(&p->sleepers))
+    cosmo_futex_wake(&p->epoch, 1, PTHREAD_PROCESS_PRIVATE);
+}
+
+/**
+ * Creates pool of worker threads.
+ *
+ * Each worker owns a deque of tasks. Tasks spawned by a worker are
+ * pushed onto its own deque, where they're run in lifo order while
+ * they're still hot in cache, and idle workers steal from the other
+ * end of a random victim's deque. Tasks spawned by other threads are
+ * put on a shared queue. Workers sleep on a futex when there's nothing
+ * left to steal.
+ *
+ * @param threads is number of workers, or 0 for cosmo_cpu_count()
+ * @return new pool, or null w/ errno
+ * @raise EINVAL if `threads` is negative
+ * @raise EAGAIN if threads couldn't be created
+ */
+struct CosmoTaskPool *cosmo_taskpool_new(int threads) {
+  errno_t err;
+  struct CosmoTaskPool *p;
+  if (threads < 0) {
+    errno = EINVAL;
+    return 0;
+  }
+  if (!threads)
+    threads = MAX(1, cosmo_cpu_count());
+  if (!(p = calloc(1, sizeof(struct CosmoTaskPool))))
+    return 0;
+  if (!(p->workers = memalign(_Alignof(struct CosmoTaskWorker),
+                              threads * sizeof(struct CosmoTaskWorker)))) {
+    free(p);
+    return 0;
+  }
+  bzero(p->workers, threads * sizeof(struct CosmoTaskWorker));
+  pthread_mutex_init(&p->lock, 0);
+  p->inject_tail = &p->inject;
+  p->count = threads;
+  for (int i = 0; i < threads; ++i) {
+    p->workers[i].pool = p;
+    p->workers[i].rand = i;
+  }
+  for (; p->started < threads; ++p->started) {
+    if ((err = pthread_create(&p->workers[p->started].th, 0,
+                              cosmo_task_worker, p->workers + p->started))) {
+      cosmo_taskpool_free(p);
+      errno = err;
+      return 0;
+    }
+  }
+  return p;
+}
+
+/**
+ * Waits for tasks to finish and destroys pool.
+ *
+ * @param p may be null in which case this is a no-op
+ */
+void cosmo_taskpool_free(struct CosmoTaskPool *p) {
+  if (p) {
+    cosmo_taskpool_wait(p);
+    atomic_store(&p->shutdown, true);
+    atomic_fetch_add(&p->epoch, 1);
+    cosmo_futex_wake(&p->epoch, INT_MAX, PTHREAD_PROCESS_PRIVATE);
+    for (int i = 0; i < p->started; ++i)
+      pthread_join(p->workers[i].th, 0);
+    pthread_mutex_destroy(&p->lock);
+    free(p->workers);
+    free(p);
+  }
+}
+
+/**
+ * Schedules function to be called by pool.
+ *
+ * If the calling thread is a worker of `p` and its deque is full, then
+ * `func` is simply called right away.
+ *
+ * @return 0 on success, or errno on error
+ * @raise ENOMEM if we're out of memory
+ */
+errno_t cosmo_taskpool_spawn(struct CosmoTaskPool *p, void func(void *),
+                             void *arg) {
+  struct CosmoTask *t;
+  struct CosmoTaskWorker *w;
+  if (!(t = malloc(sizeof(struct CosmoTask))))
+    return ENOMEM;
+  t->func = func;
+  t->arg = arg;
+  t->next = 0;
+  atomic_fetch_add(&p->pending, 1);
+  if ((w = g_worker) && w->pool == p) {
+    if (!cosmo_task_push(&w->deque, t)) {
+      cosmo_task_run(p, t);
+      return 0;
+    }
+  } else {
+    pthread_mutex_lock(&p->lock);
+    *p->inject_tail = t;
+    p->inject_tail = &t->next;
+    pthread_mutex_unlock(&p->lock);
+  }
+  cosmo_task_notify(p);
+  return 0;
+}
+
+/**
+ * Waits for all tasks scheduled on pool to finish.
+ *
+ * The calling thread helps run tasks while it waits. This can't be used
+ * from within a task, since then it'd be waiting on itself. Tasks that
+ * need to fork and join should use cosmo_parallel_for() instead.
+ */
+void cosmo_taskpool_wait(struct CosmoTaskPool *p) {
+  int n;
+  struct CosmoTask *t;
+  while ((n = atomic_load(&p->pending))) {
+    if ((t = cosmo_task_find(p))) {
+      cosmo_task_run(p, t);
+    } else {
+      cosmo_futex_wait(&p->pending, n, PTHREAD_PROCESS_PRIVATE, 0, 0);
+    }
+  }
+}
+
+struct CosmoParallelFor {
+  void (*func)(long, long, void *);
+  void *arg;
+  long end;
+  long grain;
+  atomic_long next;
+  cosmo_futex_t active;
+};
+
+static void cosmo_parallel_for_chunks(struct CosmoParallelFor *f) {
+  long i;
+  while ((i = atomic_fetch_add(&f->next, f->grain)) < f->end)
+    f->func(i, MIN(f->end - i, f->grain) + i, f->arg);
+}
+
+static void cosmo_parallel_for_helper(void *arg) {
+  struct CosmoParallelFor *f = arg;
+  cosmo_parallel_for_chunks(f);
+  if (atomic_fetch_sub(&f->active, 1) == 1)
+    cosmo_futex_wake(&f->active, INT_MAX, PTHREAD_PROCESS_PRIVATE);
+}
+
+/**
+ * Calls `func(i, j, arg)` over subranges of `[begin,end)` in parallel.
+ *
+ * Up to one helper task per worker is spawned, and each one claims
+ * `grain` sized chunks of the range until it runs out. The calling
+ * thread claims chunks too, and then runs other tasks on the pool
+ * until the helpers are done. This may be nested, i.e. `func` may call
+ * cosmo_parallel_for() on the same pool. If helpers can't be spawned
+ * then the caller does all the work.
+ *
+ * @param grain is iterations per chunk, or 0 to pick automatically
+ */
+void cosmo_parallel_for(struct CosmoTaskPool *p, long begin, long end,
+                        long grain, void func(long, long, void *), void *arg) {
+  int n;
+  long chunks;
+  struct CosmoTask *t;
+  struct CosmoParallelFor f;
+  if (begin >= end)
+    return;
+  if (grain <= 0)
+    grain = MAX(1, (end - begin) / (p->count * 4));
+  chunks = (end - begin - 1) / grain + 1;
+  f.func = func;
+  f.arg = arg;
+  f.end = end;
+  f.grain = grain;
+  f.next = begin;
+  f.active = MIN(p->count, chunks - 1);
+  for (n = f.active; n; --n)
+    if (cosmo_taskpool_spawn(p, cosmo_parallel_for_helper, &f))
+      atomic_fetch_sub(&f.active, 1);
+  cosmo_parallel_for_chunks(&f);
+  while ((n = atomic_load(&f.active))) {
+    if ((t = cosmo_task_find(p))) {
+      cosmo_task_run(p, t);
+    } else {
+      cosmo_futex_wait(&f.active, n, PTHREAD_PROCESS_PRIVATE, 0, 0);
+    }
+  }
+}
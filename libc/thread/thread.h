@@ -83,7 +83,8 @@ typedef struct pthread_mutex_s {
   void *_nsync[2];
   int (*_lock)(struct pthread_mutex_s *);
   int (*_unlock)(struct pthread_mutex_s *);
-  void *_extra;
+  _PTHREAD_ATOMIC(int) _spins;
+  int _extra;
 } pthread_mutex_t;
 
 typedef struct pthread_mutexattr_s {
@@ -10,7 +10,7 @@
 #ifdef MODE_DBG
 #define PTHREAD_KEYS_FAST 0
 #else
-#define PTHREAD_KEYS_FAST 37
+#define PTHREAD_KEYS_FAST 36
 #endif
 
 #if !(__ASSEMBLER__ + __LINKER__ + 0)
@@ -51,9 +51,11 @@ struct CosmoTib {
   intptr_t tib_events[2];
   void *tib_sigjmpbuf;
   void *tib_vfork;
-  void *tib_keys_static[37];
+  void *tib_keys_static[36];
+  void *tib_tcache;               /* dlmalloc thread cache */
   void **tib_keys_dynamic;
-  void *tib_locks[64];
+  void *tib_locks[63];
+  uint64_t tib_systsc;            /* 0x3d8 tsc when syscall began */
   char tib_rseq[32];
 } __attribute__((__aligned__(64)));
 
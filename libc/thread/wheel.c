@@ -0,0 +1,276 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/cosmo.h"
+#include "libc/limits.h"
+#include "libc/macros.h"
+#include "libc/mem/mem.h"
+#include "libc/thread/thread.h"
+
+/**
+ * @fileoverview hierarchical timer wheel
+ *
+ * Timers are bucketed by how far away their deadline is. The first of
+ * the four levels has a slot for each of the next 64 ticks, the second
+ * has a slot for each of the next 64 spans of 64 ticks, and so on, so
+ * arming and canceling a timer is O(1). Whenever the first level wraps
+ * around, the next slot of the level above it gets cascaded, i.e. its
+ * timers are redistributed into the finer grained levels beneath it.
+ */
+
+#define BITS   6
+#define SLOTS  (1 << BITS)
+#define LEVELS 4
+#define SPAN   (1ull << (BITS * LEVELS))  // farthest deadline w/o cascade
+
+#define UNARMED 0
+#define ARMED   1
+#define EXPIRED 2
+
+struct CosmoWheel {
+  pthread_mutex_t lock;
+  uint64_t now;   // next tick that hasn't been processed
+  uint64_t last;  // most recent tick passed to cosmo_wheel_expire()
+  size_t count;   // number of timers that are armed
+  cosmo_timer_t expired;
+  cosmo_timer_t slots[LEVELS][SLOTS];
+};
+
+static void cosmo_wheel_init(cosmo_timer_t *head) {
+  head->_next = head;
+  head->_prev = head;
+}
+
+static void cosmo_wheel_link(cosmo_timer_t *head, cosmo_timer_t *t) {
+  t->_next = head;
+  t->_prev = head->_prev;
+  head->_prev->_next = t;
+  head->_prev = t;
+}
+
+static void cosmo_wheel_unlink(cosmo_timer_t *t) {
+  t->_prev->_next = t->_next;
+  t->_next->_prev = t->_prev;
+}
+
+static void cosmo_wheel_place(struct CosmoWheel *w, cosmo_timer_t *t) {
+  int level;
+  uint64_t when = t->_expires;
+  if (when < w->now)
+    when = w->now;
+  if (when - w->now >= SPAN)
+    when = w->now + SPAN - 1;
+  for (level = 0; level < LEVELS - 1; ++level)
+    if (when - w->now < 1ull << (BITS * (level + 1)))
+      break;
+  cosmo_wheel_link(&w->slots[level][(when >> (BITS * level)) & (SLOTS - 1)],
+                   t);
+}
+
+// moves timers in slot down into the lower levels of the wheel
+static void cosmo_wheel_cascade(struct CosmoWheel *w, cosmo_timer_t *head) {
+  cosmo_timer_t *t;
+  while ((t = head->_next) != head) {
+    cosmo_wheel_unlink(t);
+    cosmo_wheel_place(w, t);
+  }
+}
+
+// moves timers that are due at or before `now` onto expired list
+static void cosmo_wheel_advance(struct CosmoWheel *w, uint64_t now) {
+  cosmo_timer_t *t, *head;
+  while (w->now <= now) {
+    if (!w->count) {
+      w->now = now + 1;
+      break;
+    }
+    unsigned i = w->now & (SLOTS - 1);
+    if (!i) {
+      for (int level = 1; level < LEVELS; ++level) {
+        unsigned j = (w->now >> (BITS * level)) & (SLOTS - 1);
+        cosmo_wheel_cascade(w, &w->slots[level][j]);
+        if (j)
+          break;
+      }
+    }
+    head = &w->slots[0][i];
+    while ((t = head->_next) != head) {
+      cosmo_wheel_unlink(t);
+      if (t->_expires <= w->now) {
+        cosmo_wheel_link(&w->expired, t);
+        t->_state = EXPIRED;
+        --w->count;
+      } else {
+        cosmo_wheel_place(w, t);  // deadline was farther than SPAN
+      }
+    }
+    ++w->now;
+  }
+}
+
+/**
+ * Creates new timer wheel.
+ *
+ * A timer wheel tracks a large number of deadlines, e.g. per connection
+ * timeouts in a server, where timers get armed and canceled much more
+ * often than they actually expire. Time is measured in ticks, which are
+ * whatever unit the caller wants, e.g. milliseconds of timespec_mono().
+ * All the functions that operate on a wheel are thread safe.
+ *
+ * @param now is the current tick
+ * @return new wheel, or null w/ errno
+ * @raise ENOMEM if we ran out of memory
+ */
+struct CosmoWheel *cosmo_wheel_new(uint64_t now) {
+  struct CosmoWheel *w;
+  if (!(w = malloc(sizeof(*w))))
+    return 0;
+  pthread_mutex_init(&w->lock, 0);
+  w->now = now;
+  w->last = now;
+  w->count = 0;
+  cosmo_wheel_init(&w->expired);
+  for (int i = 0; i < LEVELS; ++i)
+    for (int j = 0; j < SLOTS; ++j)
+      cosmo_wheel_init(&w->slots[i][j]);
+  return w;
+}
+
+/**
+ * Destroys timer wheel.
+ *
+ * Timers that are still armed are simply forgotten.
+ *
+ * @param w may be null in which case this is a no-op
+ */
+void cosmo_wheel_free(struct CosmoWheel *w) {
+  if (w) {
+    pthread_mutex_destroy(&w->lock);
+    free(w);
+  }
+}
+
+/**
+ * Arms timer to expire at `expires` tick.
+ *
+ * The timer must be zero initialized before it's first used. If it's
+ * already armed, or it's expired but hasn't been returned by
+ * cosmo_wheel_expire() yet, then it's rearmed with the new deadline.
+ * Deadlines in the past expire the next time the wheel is advanced.
+ *
+ * @param t is usually embedded in the caller's per connection state
+ */
+void cosmo_wheel_add(struct CosmoWheel *w, cosmo_timer_t *t,
+                     uint64_t expires) {
+  pthread_mutex_lock(&w->lock);
+  if (t->_state != UNARMED)
+    cosmo_wheel_unlink(t);
+  if (t->_state != ARMED)
+    ++w->count;
+  t->_state = ARMED;
+  t->_expires = expires;
+  cosmo_wheel_place(w, t);
+  pthread_mutex_unlock(&w->lock);
+}
+
+/**
+ * Disarms timer.
+ *
+ * @return true if `t` was armed, or expired but not yet returned by
+ *     cosmo_wheel_expire(), otherwise false
+ */
+bool32 cosmo_wheel_cancel(struct CosmoWheel *w, cosmo_timer_t *t) {
+  bool res;
+  pthread_mutex_lock(&w->lock);
+  if ((res = t->_state != UNARMED)) {
+    cosmo_wheel_unlink(t);
+    if (t->_state == ARMED)
+      --w->count;
+    t->_state = UNARMED;
+  }
+  pthread_mutex_unlock(&w->lock);
+  return res;
+}
+
+/**
+ * Returns next timer whose deadline is at or before `now`.
+ *
+ * Event loops should call this in a loop once they've woken up, until
+ * it returns null. The returned timer is disarmed, so it may be freed
+ * or armed again by the caller.
+ *
+ * @param now is the current tick, which shouldn't go backwards
+ * @return expired timer, or null if none are due
+ */
+cosmo_timer_t *cosmo_wheel_expire(struct CosmoWheel *w, uint64_t now) {
+  cosmo_timer_t *t;
+  pthread_mutex_lock(&w->lock);
+  if (now > w->last)
+    w->last = now;
+  cosmo_wheel_advance(w, now);
+  if ((t = w->expired._next) != &w->expired) {
+    cosmo_wheel_unlink(t);
+    t->_state = UNARMED;
+  } else {
+    t = 0;
+  }
+  pthread_mutex_unlock(&w->lock);
+  return t;
+}
+
+/**
+ * Returns number of ticks an event loop may sleep.
+ *
+ * This is a lower bound on how long it'll be until the next timer is
+ * due, relative to the most recent tick passed to cosmo_wheel_expire()
+ * and it's exact for deadlines less than 64 ticks away. When the
+ * wheel has timers far off in the future, the event loop may wake up
+ * before any of them are due, which just helps cascade the wheel.
+ *
+ * @return ticks to sleep, or -1 if no timers are armed
+ */
+int64_t cosmo_wheel_timeout(struct CosmoWheel *w) {
+  int64_t res = -1;
+  pthread_mutex_lock(&w->lock);
+  if (w->expired._next != &w->expired) {
+    res = 0;
+  } else if (w->count) {
+    res = INT64_MAX;
+    for (unsigned i = 0; i < SLOTS; ++i) {
+      cosmo_timer_t *head = &w->slots[0][(w->now + i) & (SLOTS - 1)];
+      if (head->_next != head) {
+        res = w->now + i - w->last;
+        break;
+      }
+    }
+    // timers in higher levels can't expire until they're cascaded
+    for (int level = 1; level < LEVELS; ++level) {
+      uint64_t cur = w->now >> (BITS * level);
+      uint64_t rem = w->now & ((1ull << (BITS * level)) - 1);
+      for (unsigned d = !!rem; d <= SLOTS; ++d) {
+        cosmo_timer_t *head = &w->slots[level][(cur + d) & (SLOTS - 1)];
+        if (head->_next != head) {
+          res = MIN(res, (int64_t)(((cur + d) << (BITS * level)) - w->last));
+          break;
+        }
+      }
+    }
+  }
+  pthread_mutex_unlock(&w->lock);
+  return res;
+}
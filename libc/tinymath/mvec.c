@@ -0,0 +1,164 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/math.h"
+__static_yoink("fdlibm_notice");
+
+/**
+ * @fileoverview Vector Math Library
+ *
+ * These are the libmvec functions GCC calls when it vectorizes a loop
+ * over a function that <math.h> declares with the simd attribute, i.e.
+ * exp(), log(), sin(), cos() and their float variants, plus powf(). The
+ * names follow the Vector Function ABI, e.g. _ZGVdN4v_exp() takes four
+ * doubles in a ymm register, where the letter says the isa:
+ *
+ * - b is sse2 with 128-bit vectors
+ * - c is avx with 256-bit vectors
+ * - d is avx2 with 256-bit vectors
+ * - e is avx512f with 512-bit vectors
+ * - n is arm64 advanced simd with 64-bit or 128-bit vectors
+ *
+ * The polynomials are the ones fdlibm uses, and are evaluated in double
+ * precision for the float functions too. Results are within a couple of
+ * ulp of the scalar functions, but errno is never set.
+ */
+
+#if defined(__x86_64__) || defined(__aarch64__)
+
+#define MVEC_SIGN 0x8000000000000000
+
+typedef long mvec_i2 __attribute__((__vector_size__(16)));
+typedef long mvec_i4 __attribute__((__vector_size__(32)));
+typedef long mvec_i8 __attribute__((__vector_size__(64)));
+typedef double mvec_d2 __attribute__((__vector_size__(16)));
+typedef double mvec_d4 __attribute__((__vector_size__(32)));
+typedef double mvec_d8 __attribute__((__vector_size__(64)));
+typedef float mvec_f2 __attribute__((__vector_size__(8)));
+typedef float mvec_f4 __attribute__((__vector_size__(16)));
+typedef float mvec_f8 __attribute__((__vector_size__(32)));
+typedef float mvec_f16 __attribute__((__vector_size__(64)));
+
+#define MVEC_DEFINE(ISA, DN, FN, VD, VF, W)                        \
+  MVEC_ABI VD _ZGV##ISA##N##DN##v_exp(VD x) {                      \
+    return mvec_exp_##W(x);                                        \
+  }                                                                \
+  MVEC_ABI VD _ZGV##ISA##N##DN##v_log(VD x) {                      \
+    return mvec_log_##W(x);                                        \
+  }                                                                \
+  MVEC_ABI VD _ZGV##ISA##N##DN##v_sin(VD x) {                      \
+    return mvec_sin_##W(x);                                        \
+  }                                                                \
+  MVEC_ABI VD _ZGV##ISA##N##DN##v_cos(VD x) {                      \
+    return mvec_cos_##W(x);                                        \
+  }                                                                \
+  MVEC_ABI VF _ZGV##ISA##N##FN##v_expf(VF x) {                     \
+    return mvec_expf_##W(x);                                       \
+  }                                                                \
+  MVEC_ABI VF _ZGV##ISA##N##FN##v_logf(VF x) {                     \
+    return mvec_logf_##W(x);                                       \
+  }                                                                \
+  MVEC_ABI VF _ZGV##ISA##N##FN##v_sinf(VF x) {                     \
+    return mvec_sinf_##W(x);                                       \
+  }                                                                \
+  MVEC_ABI VF _ZGV##ISA##N##FN##v_cosf(VF x) {                     \
+    return mvec_cosf_##W(x);                                       \
+  }                                                                \
+  MVEC_ABI VF _ZGV##ISA##N##FN##vv_powf(VF x, VF y) {              \
+    return mvec_powf_##W(x, y);                                    \
+  }
+
+#define VD      mvec_d2
+#define VI      mvec_i2
+#define VF      mvec_f4
+#define VFH     mvec_f2
+#define NAME(x) mvec_##x##_2
+#include "libc/tinymath/mvec.inc"
+#undef VD
+#undef VI
+#undef VF
+#undef VFH
+#undef NAME
+
+#ifdef __x86_64__
+
+#define MVEC_ABI
+
+MVEC_DEFINE(b, 2, 4, mvec_d2, mvec_f4, 2)
+
+#pragma GCC push_options
+#pragma GCC target("avx")
+#define VD      mvec_d4
+#define VI      mvec_i4
+#define VF      mvec_f8
+#define VFH     mvec_f4
+#define NAME(x) mvec_##x##_4
+#include "libc/tinymath/mvec.inc"
+#undef VD
+#undef VI
+#undef VF
+#undef VFH
+#undef NAME
+MVEC_DEFINE(c, 4, 8, mvec_d4, mvec_f8, 4)
+#pragma GCC target("avx2")
+MVEC_DEFINE(d, 4, 8, mvec_d4, mvec_f8, 4)
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#define VD      mvec_d8
+#define VI      mvec_i8
+#define VF      mvec_f16
+#define VFH     mvec_f8
+#define NAME(x) mvec_##x##_8
+#include "libc/tinymath/mvec.inc"
+#undef VD
+#undef VI
+#undef VF
+#undef VFH
+#undef NAME
+MVEC_DEFINE(e, 8, 16, mvec_d8, mvec_f16, 8)
+#pragma GCC pop_options
+
+#else /* __aarch64__ */
+
+#define MVEC_ABI __attribute__((__aarch64_vector_pcs__))
+
+MVEC_DEFINE(n, 2, 4, mvec_d2, mvec_f4, 2)
+
+// gcc also vectorizes floats with the 64-bit registers
+#define MVEC_HALF(F)                                           \
+  MVEC_ABI mvec_f2 _ZGVnN2v_##F##f(mvec_f2 x) {                \
+    return __builtin_convertvector(                            \
+        mvec_##F##_2(__builtin_convertvector(x, mvec_d2)),     \
+        mvec_f2);                                              \
+  }
+MVEC_HALF(exp)
+MVEC_HALF(log)
+MVEC_HALF(sin)
+MVEC_HALF(cos)
+
+MVEC_ABI mvec_f2 _ZGVnN2vv_powf(mvec_f2 x, mvec_f2 y) {
+  return __builtin_convertvector(
+      mvec_pow_2(__builtin_convertvector(x, mvec_d2),
+                 __builtin_convertvector(y, mvec_d2)),
+      mvec_f2);
+}
+
+#endif /* __x86_64__ */
+#endif /* __x86_64__ || __aarch64__ */
@@ -59,6 +59,7 @@
 #define kZipEra1989 10 /* PKZIP 1.0 */
 #define kZipEra1993 20 /* PKZIP 2.0: deflate/subdir/etc. support */
 #define kZipEra2001 45 /* PKZIP 4.5: kZipExtraZip64 support */
+#define kZipEra2020 63 /* PKZIP 6.3.7: zstd support */
 
 #define kZipIattrText 1 /* first bit set */
 
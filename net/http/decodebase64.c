@@ -16,10 +16,14 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/dce.h"
 #include "libc/macros.h"
 #include "libc/mem/mem.h"
+#include "libc/nexgen32e/x86feature.h"
 #include "libc/str/str.h"
 #include "net/http/escape.h"
+#include "third_party/aarch64/arm_neon.internal.h"
+#include "third_party/intel/immintrin.internal.h"
 
 static const signed char kBase64[256] = {
     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 0x00
@@ -40,6 +44,51 @@ static const signed char kBase64[256] = {
     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 0xf0
 };
 
+#if defined(__x86_64__) && !defined(__chibicc__)
+#pragma GCC push_options
+#pragma GCC target("ssse3")
+// decodes 16 chars into 12 bytes at a time while the input is clean
+// returns as soon as a block has whitespace, padding, or junk in it
+// stores 16 bytes so only runs while at least 32 chars of input remain
+static char *DecodeBase64Ssse3(char *q, const char **pp, const char *pe) {
+  const char *p = *pp;
+  __m128i v, x, m, ok;
+  for (; pe - p >= 32; p += 16, q += 12) {
+    v = _mm_loadu_si128((const __m128i *)p);
+    m = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)),
+                      _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), v));
+    ok = m;
+    x = _mm_and_si128(m, _mm_sub_epi8(v, _mm_set1_epi8('A')));
+    m = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('a' - 1)),
+                      _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), v));
+    ok = _mm_or_si128(ok, m);
+    x = _mm_or_si128(x, _mm_and_si128(m, _mm_sub_epi8(v, _mm_set1_epi8(71))));
+    m = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                      _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), v));
+    ok = _mm_or_si128(ok, m);
+    x = _mm_or_si128(x, _mm_and_si128(m, _mm_add_epi8(v, _mm_set1_epi8(4))));
+    m = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('+')),
+                     _mm_cmpeq_epi8(v, _mm_set1_epi8('-')));
+    ok = _mm_or_si128(ok, m);
+    x = _mm_or_si128(x, _mm_and_si128(m, _mm_set1_epi8(62)));
+    m = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('/')),
+                     _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+    ok = _mm_or_si128(ok, m);
+    x = _mm_or_si128(x, _mm_and_si128(m, _mm_set1_epi8(63)));
+    if (_mm_movemask_epi8(ok) != 0xFFFF)
+      break;
+    x = _mm_maddubs_epi16(x, _mm_set1_epi32(0x01400140));
+    x = _mm_madd_epi16(x, _mm_set1_epi32(0x00011000));
+    x = _mm_shuffle_epi8(x, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13,
+                                          12, -1, -1, -1, -1));
+    _mm_storeu_si128((__m128i *)q, x);
+  }
+  *pp = p;
+  return q;
+}
+#pragma GCC pop_options
+#endif
+
 /**
  * Decodes base64 ascii representation to binary.
  *
@@ -65,6 +114,31 @@ char *DecodeBase64(const char *data, size_t size, size_t *out_size) {
     p = data;
     pe = p + size;
     for (;;) {
+#if defined(__x86_64__) && !defined(__chibicc__)
+      if (X86_HAVE(SSSE3) && !IsModeDbg())
+        q = DecodeBase64Ssse3(q, &p, pe);
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+      // kBase64 entries for junk and padding have the high bit set
+      for (; pe - p >= 64; p += 64, q += 48) {
+        uint8x16x4_t lo = vld1q_u8_x4((const uint8_t *)kBase64);
+        uint8x16x4_t hi = vld1q_u8_x4((const uint8_t *)kBase64 + 64);
+        uint8x16x4_t v = vld4q_u8((const uint8_t *)p);
+        uint8x16_t bad = vdupq_n_u8(0);
+        uint8x16x3_t o;
+        for (int k = 0; k < 4; ++k) {
+          uint8x16_t c = v.val[k];
+          v.val[k] = vqtbx4q_u8(vqtbl4q_u8(lo, c), hi,
+                                vsubq_u8(c, vdupq_n_u8(64)));
+          bad = vorrq_u8(bad, vorrq_u8(v.val[k], c));
+        }
+        if (vmaxvq_u8(bad) & 0x80)
+          break;
+        o.val[0] = vorrq_u8(vshlq_n_u8(v.val[0], 2), vshrq_n_u8(v.val[1], 4));
+        o.val[1] = vorrq_u8(vshlq_n_u8(v.val[1], 4), vshrq_n_u8(v.val[2], 2));
+        o.val[2] = vorrq_u8(vshlq_n_u8(v.val[2], 6), v.val[3]);
+        vst3q_u8((uint8_t *)q, o);
+      }
+#endif
       do {
         if (p == pe)
           goto Done;
@@ -16,12 +16,49 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/dce.h"
 #include "libc/mem/mem.h"
+#include "libc/nexgen32e/x86feature.h"
 #include "libc/str/str.h"
 #include "net/http/escape.h"
+#include "third_party/aarch64/arm_neon.internal.h"
+#include "third_party/intel/immintrin.internal.h"
 
 #define CHARS "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"
 
+#if defined(__x86_64__) && !defined(__chibicc__)
+#pragma GCC push_options
+#pragma GCC target("ssse3")
+// turns 12 bytes into 16 sextets and then 16 ascii chars at a time
+// loads 16 bytes so stops while at least 16 bytes of input remain
+static char *EncodeBase64Ssse3(char *q, const unsigned char **pp,
+                               const unsigned char *pe) {
+  const unsigned char *p = *pp;
+  __m128i v, t, lo, hi, lut;
+  lut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                      '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                      '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+  for (; pe - p >= 16; p += 12, q += 16) {
+    v = _mm_loadu_si128((const __m128i *)p);
+    v = _mm_shuffle_epi8(
+        v, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    hi = _mm_mulhi_epu16(_mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00)),
+                         _mm_set1_epi32(0x04000040));
+    lo = _mm_mullo_epi16(_mm_and_si128(v, _mm_set1_epi32(0x003f03f0)),
+                         _mm_set1_epi32(0x01000010));
+    v = _mm_or_si128(hi, lo);
+    t = _mm_subs_epu8(v, _mm_set1_epi8(51));
+    t = _mm_or_si128(t, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), v),
+                                      _mm_set1_epi8(13)));
+    v = _mm_add_epi8(_mm_shuffle_epi8(lut, t), v);
+    _mm_storeu_si128((__m128i *)q, v);
+  }
+  *pp = p;
+  return q;
+}
+#pragma GCC pop_options
+#endif
+
 /**
  * Encodes binary to base64 ascii representation.
  *
@@ -41,7 +78,40 @@ char *EncodeBase64(const void *data, size_t size, size_t *out_size) {
     n += 3 - size % 3;
   n /= 3, n *= 4;
   if ((r = malloc(n + 1))) {
-    for (q = r, p = (void *)data, pe = p + size; p < pe; p += 3) {
+    q = r;
+    p = data;
+    pe = p + size;
+#if defined(__x86_64__) && !defined(__chibicc__)
+    if (X86_HAVE(SSSE3) && !IsModeDbg())
+      q = EncodeBase64Ssse3(q, &p, pe);
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    uint8x16x4_t lut = vld1q_u8_x4((const uint8_t *)CHARS);
+    for (; pe - p >= 48; p += 48, q += 64) {
+      uint8x16x3_t v = vld3q_u8(p);
+      uint8x16x4_t o;
+      o.val[0] = vshrq_n_u8(v.val[0], 2);
+      o.val[1] = vandq_u8(
+          vorrq_u8(vshlq_n_u8(v.val[0], 4), vshrq_n_u8(v.val[1], 4)),
+          vdupq_n_u8(077));
+      o.val[2] = vandq_u8(
+          vorrq_u8(vshlq_n_u8(v.val[1], 2), vshrq_n_u8(v.val[2], 6)),
+          vdupq_n_u8(077));
+      o.val[3] = vandq_u8(v.val[2], vdupq_n_u8(077));
+      o.val[0] = vqtbl4q_u8(lut, o.val[0]);
+      o.val[1] = vqtbl4q_u8(lut, o.val[1]);
+      o.val[2] = vqtbl4q_u8(lut, o.val[2]);
+      o.val[3] = vqtbl4q_u8(lut, o.val[3]);
+      vst4q_u8((uint8_t *)q, o);
+    }
+#endif
+    for (; pe - p >= 3; p += 3, q += 4) {
+      w = p[0] << 020 | p[1] << 010 | p[2];
+      q[0] = CHARS[(w >> 18) & 077];
+      q[1] = CHARS[(w >> 12) & 077];
+      q[2] = CHARS[(w >> 6) & 077];
+      q[3] = CHARS[w & 077];
+    }
+    for (; p < pe; p += 3) {
       w = p[0] << 020;
       if (p + 1 < pe)
         w |= p[1] << 010;
@@ -16,10 +16,84 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/dce.h"
 #include "libc/mem/mem.h"
+#include "libc/nexgen32e/x86feature.h"
 #include "libc/str/str.h"
 #include "libc/x/x.h"
 #include "net/http/escape.h"
+#include "third_party/aarch64/arm_neon.internal.h"
+#include "third_party/intel/immintrin.internal.h"
+
+#if defined(__x86_64__) && !defined(__chibicc__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+static size_t SkipHtmlAvx2(const char *p, size_t i, size_t n) {
+  unsigned m;
+  __m256i v;
+  for (; n - i >= 32; i += 32) {
+    v = _mm256_loadu_si256((const __m256i *)(p + i));
+    if ((m = _mm256_movemask_epi8(_mm256_or_si256(
+             _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('&')),
+                             _mm256_cmpeq_epi8(v, _mm256_set1_epi8('<'))),
+             _mm256_or_si256(
+                 _mm256_cmpeq_epi8(v, _mm256_set1_epi8('>')),
+                 _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                                 _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\''))))))))
+      return i + __builtin_ctz(m);
+  }
+  return i;
+}
+#pragma GCC pop_options
+static size_t SkipHtmlSse2(const char *p, size_t i, size_t n) {
+  unsigned m;
+  __m128i v;
+  for (; n - i >= 16; i += 16) {
+    v = _mm_loadu_si128((const __m128i *)(p + i));
+    if ((m = _mm_movemask_epi8(_mm_or_si128(
+             _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('&')),
+                          _mm_cmpeq_epi8(v, _mm_set1_epi8('<'))),
+             _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('>')),
+                          _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                                       _mm_cmpeq_epi8(v, _mm_set1_epi8('\''))))))))
+      return i + __builtin_ctz(m);
+  }
+  return i;
+}
+#endif
+
+// returns index of first byte in p[i,n) that needs an html entity
+static size_t SkipHtml(const char *p, size_t i, size_t n) {
+#if defined(__x86_64__) && !defined(__chibicc__)
+  if (X86_HAVE(AVX2) && !IsModeDbg()) {
+    i = SkipHtmlAvx2(p, i, n);
+  } else {
+    i = SkipHtmlSse2(p, i, n);
+  }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  uint8x16_t v;
+  uint64_t m;
+  for (; n - i >= 16; i += 16) {
+    v = vld1q_u8((const uint8_t *)(p + i));
+    if ((m = vget_lane_u64(
+             vreinterpret_u64_u8(vshrn_n_u16(
+                 vreinterpretq_u16_u8(vorrq_u8(
+                     vorrq_u8(vceqq_u8(v, vdupq_n_u8('&')),
+                              vceqq_u8(v, vdupq_n_u8('<'))),
+                     vorrq_u8(vceqq_u8(v, vdupq_n_u8('>')),
+                              vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')),
+                                       vceqq_u8(v, vdupq_n_u8('\'')))))),
+                 4)),
+             0)))
+      return i + (__builtin_ctzll(m) >> 2);
+  }
+#endif
+  for (; i < n; ++i)
+    if (p[i] == '&' || p[i] == '<' || p[i] == '>' || p[i] == '"' ||
+        p[i] == '\'')
+      break;
+  return i;
+}
 
 /**
  * Escapes HTML entities.
@@ -31,7 +105,7 @@
  */
 char *EscapeHtml(const char *p, size_t n, size_t *z) {
   int c;
-  size_t i;
+  size_t i, j;
   char *q, *r;
   if (z)
     *z = 0;
@@ -39,6 +113,11 @@ char *EscapeHtml(const char *p, size_t n, size_t *z) {
     n = p ? strlen(p) : 0;
   if ((q = r = malloc(n * 6 + 1))) {
     for (i = 0; i < n; ++i) {
+      if ((j = SkipHtml(p, i, n)) > i) {
+        q = mempcpy(q, p + i, j - i);
+        if ((i = j) == n)
+          break;
+      }
       switch ((c = p[i])) {
         case '&':
           q[0] = '&';
@@ -79,6 +79,14 @@ char *EscapeJsStringLiteral(char **r, size_t *y, const char *p, size_t n,
   if (q) {
     for (i = 0; i < n;) {
       x = p[i++] & 0xff;
+      if (x < 0200 && !kEscapeLiteral[x]) {
+        // copy runs that don't need escaping in bulk
+        for (j = i; j < n && !(p[j] & 0200) && !kEscapeLiteral[p[j] & 0177];)
+          ++j;
+        q = mempcpy(q, p + i - 1, j - i + 1);
+        i = j;
+        continue;
+      }
       if (x >= 0300) {
         a = ThomPikeByte(x);
         m = ThomPikeLen(x) - 1;
@@ -16,23 +16,30 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/str/str.h"
 #include "net/http/url.h"
 
 /**
  * Escapes URL component using generic table w/ stpcpy() api.
+ *
+ * Runs of bytes that don't need escaping are copied in bulk.
  */
 char *EscapeUrlView(char *p, struct UrlView *v, const char T[256]) {
   int c;
-  size_t i;
+  size_t i, j;
   for (i = 0; i < v->n; ++i) {
-    if (!T[(c = v->p[i] & 0xFF)]) {
-      *p++ = c;
-    } else {
-      p[0] = '%';
-      p[1] = "0123456789ABCDEF"[(c & 0xF0) >> 4];
-      p[2] = "0123456789ABCDEF"[(c & 0x0F) >> 0];
-      p += 3;
+    for (j = i; j < v->n && !T[v->p[j] & 0xFF]; ++j) {
     }
+    if (j > i) {
+      p = mempcpy(p, v->p + i, j - i);
+      if ((i = j) == v->n)
+        break;
+    }
+    c = v->p[i] & 0xFF;
+    p[0] = '%';
+    p[1] = "0123456789ABCDEF"[(c & 0xF0) >> 4];
+    p[2] = "0123456789ABCDEF"[(c & 0x0F) >> 0];
+    p += 3;
   }
   return p;
 }
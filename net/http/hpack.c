@@ -0,0 +1,385 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "net/http/hpack.h"
+#include "libc/mem/mem.h"
+#include "libc/str/str.h"
+#include "libc/sysv/errfuns.h"
+
+/**
+ * @fileoverview HPACK header compression for HTTP/2.
+ * @see RFC7541
+ */
+
+#define kHpackEntryOverhead 32
+
+static struct HpackEntry *GetHpackSlot(const struct HpackTable *t, size_t k) {
+  return t->p + (t->i + k) % t->c;
+}
+
+static void EvictHpackEntry(struct HpackTable *t) {
+  struct HpackEntry *e;
+  e = GetHpackSlot(t, --t->n);
+  t->size -= e->namelen + e->valuelen + kHpackEntryOverhead;
+  free(e->p);
+  e->p = 0;
+}
+
+static void ShrinkHpackTable(struct HpackTable *t, size_t maxsize) {
+  while (t->n && t->size > maxsize)
+    EvictHpackEntry(t);
+}
+
+/**
+ * Initializes dynamic table for one direction of a connection.
+ *
+ * @param limit is SETTINGS_HEADER_TABLE_SIZE which is 4096 by default
+ */
+void InitHpackTable(struct HpackTable *t, size_t limit) {
+  bzero(t, sizeof(*t));
+  t->maxsize = limit;
+  t->limit = limit;
+}
+
+/**
+ * Frees dynamic table entries.
+ */
+void DestroyHpackTable(struct HpackTable *t) {
+  ShrinkHpackTable(t, 0);
+  free(t->p);
+  bzero(t, sizeof(*t));
+}
+
+/**
+ * Looks up header by its one-based index in the combined address space,
+ * where 1..61 is the static table and 62+ is the dynamic table newest
+ * first. Returned pointers are valid until the table is next modified.
+ */
+bool GetHpackEntry(const struct HpackTable *t, uint64_t x,
+                   struct HpackHeader *h) {
+  struct HpackEntry *e;
+  if (!x)
+    return false;
+  if (x <= 61) {
+    h->name = kHpackStaticTable[x - 1].name;
+    h->namelen = kHpackStaticTable[x - 1].namelen;
+    h->value = kHpackStaticTable[x - 1].value;
+    h->valuelen = kHpackStaticTable[x - 1].valuelen;
+    return true;
+  }
+  if ((x -= 62) >= t->n)
+    return false;
+  e = GetHpackSlot(t, x);
+  h->name = e->p;
+  h->namelen = e->namelen;
+  h->value = e->p + e->namelen;
+  h->valuelen = e->valuelen;
+  return true;
+}
+
+/**
+ * Inserts header at front of dynamic table, evicting old entries.
+ *
+ * The name and value are copied before anything is evicted, so they may
+ * point into the table itself. An entry larger than the table empties it
+ * and isn't added, as RFC7541 § 4.4 requires.
+ *
+ * @return 0 on success, or -1 w/ errno
+ */
+int AddHpackEntry(struct HpackTable *t, const char *name, size_t namelen,
+                  const char *value, size_t valuelen) {
+  char *q;
+  size_t k, c, size;
+  struct HpackEntry *e, *p;
+  size = namelen + valuelen + kHpackEntryOverhead;
+  if (size > t->maxsize) {
+    ShrinkHpackTable(t, 0);
+    return 0;
+  }
+  if (!(q = malloc(namelen + valuelen + 1)))
+    return -1;
+  memcpy(q, name, namelen);
+  memcpy(q + namelen, value, valuelen);
+  q[namelen + valuelen] = 0;
+  ShrinkHpackTable(t, t->maxsize - size);
+  if (t->n == t->c) {
+    c = t->c ? t->c * 2 : 16;
+    if (!(p = calloc(c, sizeof(*p)))) {
+      free(q);
+      return -1;
+    }
+    for (k = 0; k < t->n; ++k)
+      p[k] = *GetHpackSlot(t, k);
+    free(t->p);
+    t->p = p;
+    t->c = c;
+    t->i = 0;
+  }
+  t->i = (t->i + t->c - 1) % t->c;
+  e = t->p + t->i;
+  e->p = q;
+  e->namelen = namelen;
+  e->valuelen = valuelen;
+  t->size += size;
+  t->n++;
+  return 0;
+}
+
+/**
+ * Decodes prefixed integer per RFC7541 § 5.1.
+ *
+ * @param prefix is number of low bits in first byte, e.g. 7
+ * @return bytes consumed, 0 if more input is needed, or -1 w/ errno
+ */
+ssize_t DecodeHpackInt(const char *p, size_t n, int prefix, uint64_t *x) {
+  int b, s;
+  size_t i;
+  uint64_t m, v;
+  if (!n)
+    return 0;
+  m = (1u << prefix) - 1;
+  if ((v = p[0] & m) < m) {
+    *x = v;
+    return 1;
+  }
+  for (s = 0, i = 1; i < n; ++i, s += 7) {
+    b = p[i] & 255;
+    if (s > 56)
+      return ebadmsg();
+    v += (uint64_t)(b & 127) << s;
+    if (!(b & 128)) {
+      *x = v;
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Encodes prefixed integer per RFC7541 § 5.1.
+ *
+ * @param prefix is number of low bits in first byte, e.g. 7
+ * @param flags are the high bits of first byte, e.g. 0x80
+ * @return pointer to end of output, which needs at most 11 bytes
+ */
+char *EncodeHpackInt(char *p, int prefix, int flags, uint64_t x) {
+  uint64_t m;
+  m = (1u << prefix) - 1;
+  if (x < m) {
+    *p++ = flags | x;
+    return p;
+  }
+  *p++ = flags | m;
+  for (x -= m; x >= 128; x >>= 7)
+    *p++ = 128 | (x & 127);
+  *p++ = x;
+  return p;
+}
+
+/**
+ * Decodes Huffman string per RFC7541 § 5.2.
+ *
+ * Padding must be the most significant bits of EOS and shorter than a
+ * byte. Output is guaranteed to fit in `n * 8 / 5 + 1` bytes, and will
+ * be nul terminated when there's room.
+ *
+ * @return bytes written, or -1 w/ errno
+ */
+ssize_t DecodeHpackHuffman(const char *p, size_t n, char *out, size_t cap) {
+  size_t i, j;
+  uint32_t code, k;
+  int b, bit, len;
+  const struct HpackHuffmanLength *l;
+  for (code = len = j = i = 0; i < n; ++i) {
+    b = p[i] & 255;
+    for (bit = 7; bit >= 0; --bit) {
+      code = code << 1 | ((b >> bit) & 1);
+      ++len;
+      l = kHpackHuffmanLength + len;
+      if (l->count && (k = code - l->first) < l->count) {
+        if (j == cap)
+          return ebadmsg();
+        out[j++] = kHpackHuffmanSymbol[l->index + k];
+        code = len = 0;
+      } else if (len >= 30) {
+        return ebadmsg();  // eos or no such code
+      }
+    }
+  }
+  if (len > 7 || code != (1u << len) - 1)
+    return ebadmsg();
+  if (j < cap)
+    out[j] = 0;
+  return j;
+}
+
+/**
+ * Returns number of bytes Huffman encoding `s` would consume.
+ */
+size_t GetHpackHuffmanSize(const char *s, size_t n) {
+  size_t i, bits;
+  for (bits = i = 0; i < n; ++i)
+    bits += kHpackHuffmanBits[s[i] & 255];
+  return (bits + 7) / 8;
+}
+
+/**
+ * Huffman encodes string per RFC7541 § 5.2.
+ *
+ * @param p needs GetHpackHuffmanSize(s, n) bytes
+ * @return pointer to end of output
+ */
+char *EncodeHpackHuffman(char *p, const char *s, size_t n) {
+  int c, bits;
+  size_t i;
+  uint64_t w;
+  for (w = bits = i = 0; i < n; ++i) {
+    c = s[i] & 255;
+    w = w << kHpackHuffmanBits[c] | kHpackHuffmanCode[c];
+    bits += kHpackHuffmanBits[c];
+    while (bits >= 8)
+      *p++ = w >> (bits -= 8);
+  }
+  if (bits)
+    *p++ = w << (8 - bits) | (0xff >> bits);
+  return p;
+}
+
+static ssize_t DecodeHpackString(const char *p, size_t n, const char **s,
+                                 size_t *len, char **tmp) {
+  ssize_t i, m;
+  uint64_t x;
+  if ((i = DecodeHpackInt(p, n, 7, &x)) <= 0 || x > n - i)
+    return ebadmsg();
+  if (p[0] & 0x80) {
+    if (!(*tmp = malloc(x * 8 / 5 + 1)))
+      return -1;
+    if ((m = DecodeHpackHuffman(p + i, x, *tmp, x * 8 / 5 + 1)) == -1)
+      return -1;
+    *s = *tmp;
+    *len = m;
+  } else {
+    *s = p + i;
+    *len = x;
+  }
+  return i + x;
+}
+
+/**
+ * Decodes complete header block per RFC7541 § 6.
+ *
+ * The callback is invoked for each header field in order. Its pointers
+ * are only valid for the duration of the call and strings aren't nul
+ * terminated. Any error leaves the dynamic table in an unknown state so
+ * the connection must be failed with COMPRESSION_ERROR.
+ *
+ * @param p is concatenated HEADERS and CONTINUATION fragments
+ * @param cb may return -1 to stop decoding
+ * @return 0 on success, or -1 w/ errno
+ */
+int DecodeHpack(struct HpackTable *t, const char *p, size_t n,
+                int (*cb)(void *, const struct HpackHeader *), void *arg) {
+  int b, rc;
+  ssize_t i;
+  uint64_t x;
+  bool canresize;
+  char *name, *value;
+  struct HpackHeader h;
+  for (canresize = true; n; p += i, n -= i) {
+    b = p[0] & 255;
+    if (b & 0x80) {
+      if ((i = DecodeHpackInt(p, n, 7, &x)) <= 0 || !GetHpackEntry(t, x, &h))
+        return ebadmsg();
+      if (cb(arg, &h) == -1)
+        return -1;
+      canresize = false;
+    } else if ((b & 0xe0) == 0x20) {
+      if ((i = DecodeHpackInt(p, n, 5, &x)) <= 0 || !canresize ||
+          x > t->limit)
+        return ebadmsg();
+      ShrinkHpackTable(t, (t->maxsize = x));
+    } else {
+      name = value = 0;
+      i = DecodeHpackInt(p, n, (b & 0x40) ? 6 : 4, &x);
+      if (i <= 0) {
+        rc = ebadmsg();
+      } else if (x) {
+        rc = GetHpackEntry(t, x, &h) ? 0 : ebadmsg();
+      } else if ((rc = DecodeHpackString(p + i, n - i, &h.name, &h.namelen,
+                                         &name)) != -1) {
+        i += rc;
+        rc = 0;
+      }
+      if (!rc && (rc = DecodeHpackString(p + i, n - i, &h.value, &h.valuelen,
+                                         &value)) != -1) {
+        i += rc;
+        rc = 0;
+      }
+      if (!rc)
+        rc = cb(arg, &h);
+      if (!rc && (b & 0x40))
+        rc = AddHpackEntry(t, h.name, h.namelen, h.value, h.valuelen);
+      free(value);
+      free(name);
+      if (rc == -1)
+        return -1;
+      canresize = false;
+    }
+  }
+  return 0;
+}
+
+static char *EncodeHpackString(char *p, const char *s, size_t n) {
+  size_t m;
+  if ((m = GetHpackHuffmanSize(s, n)) < n) {
+    p = EncodeHpackInt(p, 7, 0x80, m);
+    return EncodeHpackHuffman(p, s, n);
+  } else {
+    p = EncodeHpackInt(p, 7, 0, n);
+    return mempcpy(p, s, n);
+  }
+}
+
+/**
+ * Encodes header field without touching any dynamic table.
+ *
+ * Static table matches are used when available. Otherwise the field is
+ * sent as a literal without indexing, which keeps the encoder stateless
+ * at the cost of some compression. Names must already be lowercase.
+ *
+ * @param p needs `namelen + valuelen + 24` bytes
+ * @return pointer to end of output
+ */
+char *EncodeHpackHeader(char *p, const char *name, size_t namelen,
+                        const char *value, size_t valuelen) {
+  int i, x;
+  for (x = i = 0; i < 61; ++i) {
+    if (kHpackStaticTable[i].namelen == namelen &&
+        !memcmp(kHpackStaticTable[i].name, name, namelen)) {
+      if (kHpackStaticTable[i].valuelen == valuelen &&
+          !memcmp(kHpackStaticTable[i].value, value, valuelen))
+        return EncodeHpackInt(p, 7, 0x80, i + 1);
+      if (!x)
+        x = i + 1;
+    }
+  }
+  p = EncodeHpackInt(p, 4, 0, x);
+  if (!x)
+    p = EncodeHpackString(p, name, namelen);
+  return EncodeHpackString(p, value, valuelen);
+}
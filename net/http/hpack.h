@@ -0,0 +1,60 @@
+#ifndef COSMOPOLITAN_NET_HTTP_HPACK_H_
+#define COSMOPOLITAN_NET_HTTP_HPACK_H_
+COSMOPOLITAN_C_START_
+
+struct HpackHeader {
+  const char *name;
+  size_t namelen;
+  const char *value;
+  size_t valuelen;
+};
+
+struct HpackStatic {
+  const char name[28];
+  unsigned char namelen;
+  const char value[14];
+  unsigned char valuelen;
+};
+
+struct HpackHuffmanLength {
+  uint32_t first;
+  uint8_t index;
+  uint8_t count;
+};
+
+struct HpackTable {
+  size_t size;     /* sum of entry sizes per rfc7541 § 4.1 */
+  size_t maxsize;  /* current limit set by dynamic table size updates */
+  size_t limit;    /* upper bound from SETTINGS_HEADER_TABLE_SIZE */
+  size_t i, n, c;  /* ring of entries where p[i] is the newest */
+  struct HpackEntry {
+    char *p; /* name immediately followed by value */
+    size_t namelen;
+    size_t valuelen;
+  } *p;
+};
+
+extern const struct HpackStatic kHpackStaticTable[61];
+extern const uint32_t kHpackHuffmanCode[256];
+extern const uint8_t kHpackHuffmanBits[256];
+extern const uint8_t kHpackHuffmanSymbol[256];
+extern const struct HpackHuffmanLength kHpackHuffmanLength[31];
+
+void InitHpackTable(struct HpackTable *, size_t) libcesque;
+void DestroyHpackTable(struct HpackTable *) libcesque;
+bool GetHpackEntry(const struct HpackTable *, uint64_t,
+                   struct HpackHeader *) libcesque;
+int AddHpackEntry(struct HpackTable *, const char *, size_t, const char *,
+                  size_t) libcesque;
+ssize_t DecodeHpackInt(const char *, size_t, int, uint64_t *) libcesque;
+char *EncodeHpackInt(char *, int, int, uint64_t) libcesque;
+ssize_t DecodeHpackHuffman(const char *, size_t, char *, size_t) libcesque;
+size_t GetHpackHuffmanSize(const char *, size_t) libcesque;
+char *EncodeHpackHuffman(char *, const char *, size_t) libcesque;
+int DecodeHpack(struct HpackTable *, const char *, size_t,
+                int (*)(void *, const struct HpackHeader *), void *) libcesque;
+char *EncodeHpackHeader(char *, const char *, size_t, const char *,
+                        size_t) libcesque;
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_NET_HTTP_HPACK_H_ */
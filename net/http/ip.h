@@ -29,6 +29,12 @@ struct Cidr {
   int cidr;
 };
 
+struct IpTrie {
+  uint32_t *root;
+  uint32_t (*chunks)[256];
+  size_t n, c;
+};
+
 int64_t ParseIp(const char *, size_t) libcesque;
 struct Cidr ParseCidr(const char *, size_t) libcesque;
 bool IsDodIp(uint32_t) libcesque;
@@ -46,6 +52,9 @@ bool IsAnonymousIp(uint32_t) libcesque;
 int CategorizeIp(uint32_t) libcesque;
 const char *GetIpCategoryName(int) libcesque;
 bool IsCloudflareIp(uint32_t) libcesque;
+int AddIpTrie(struct IpTrie *, uint32_t, int, int) libcesque;
+int LookupIpTrie(const struct IpTrie *, uint32_t) libcesque;
+void FreeIpTrie(struct IpTrie *) libcesque;
 
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_NET_HTTP_IP_H_ */
@@ -0,0 +1,136 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/errno.h"
+#include "libc/mem/mem.h"
+#include "libc/str/str.h"
+#include "net/http/ip.h"
+
+/**
+ * @fileoverview longest prefix match table for IPv4 networks
+ *
+ * This is a DIR-16-8-8 multibit trie. The first 16 bits of an address
+ * index a root array, and the next two octets index 256-entry chunks,
+ * which are only created beneath networks longer than /16. Lookups are
+ * at most three loads. Each leaf remembers the prefix length that set
+ * it, so that networks may be added in any order, and longer prefixes
+ * always win over shorter ones.
+ */
+
+#define CHUNK   0x80000000u
+#define LEN(e)  ((e) >> 16 & 63)
+#define LEAF(v, len) ((unsigned)(len) << 16 | (v))
+
+static int AddIpTrieChunk(struct IpTrie *t, uint32_t e) {
+  int i;
+  if (t->n == t->c) {
+    size_t c = t->c ? t->c * 2 : 16;
+    uint32_t(*p)[256] = realloc(t->chunks, c * sizeof(*t->chunks));
+    if (!p)
+      return -1;
+    t->chunks = p;
+    t->c = c;
+  }
+  for (i = 0; i < 256; ++i)
+    t->chunks[t->n][i] = e;
+  return t->n++;
+}
+
+static void FillIpTrie(struct IpTrie *t, uint32_t *e, int n, int len,
+                       uint32_t leaf) {
+  int i;
+  for (i = 0; i < n; ++i) {
+    if (e[i] & CHUNK) {
+      FillIpTrie(t, t->chunks[e[i] & ~CHUNK], 256, len, leaf);
+    } else if (LEN(e[i]) <= len) {
+      e[i] = leaf;
+    }
+  }
+}
+
+/**
+ * Adds IPv4 network to longest prefix match table.
+ *
+ * Adding the same network twice replaces its value.
+ *
+ * @param t should be zero initialized before first use
+ * @param ip is network address whose host bits are ignored
+ * @param cidr is number of network bits on interval [0,32]
+ * @param value is nonzero integer on interval [1,65535]
+ * @return 0 on success, or -1 w/ errno
+ * @raise EINVAL if `cidr` or `value` is out of range
+ * @raise ENOMEM if we ran out of memory
+ */
+int AddIpTrie(struct IpTrie *t, uint32_t ip, int cidr, int value) {
+  int i, k;
+  long c, x;
+  uint32_t *e, leaf;
+  if (!(0 <= cidr && cidr <= 32) || !(1 <= value && value <= 65535)) {
+    errno = EINVAL;
+    return -1;
+  }
+  if (!t->root && !(t->root = calloc(65536, sizeof(*t->root))))
+    return -1;
+  if (cidr < 32)
+    ip &= ~(0xffffffffu >> cidr);
+  leaf = LEAF(value, cidr);
+  c = -1;  // chunk holding entry, or -1 for root
+  x = ip >> 16;
+  for (i = 16;; i += 8) {
+    e = c == -1 ? t->root + x : t->chunks[c] + x;
+    if (cidr <= i) {
+      FillIpTrie(t, e, 1 << (i - cidr), cidr, leaf);
+      return 0;
+    }
+    if (!(*e & CHUNK)) {
+      if ((k = AddIpTrieChunk(t, *e)) == -1)
+        return -1;
+      e = c == -1 ? t->root + x : t->chunks[c] + x;  // chunks moved
+      *e = CHUNK | k;
+    }
+    c = *e & ~CHUNK;
+    x = ip >> (24 - i) & 255;
+  }
+}
+
+/**
+ * Returns value of longest network in table containing IPv4 address.
+ *
+ * @return value passed to AddIpTrie(), or 0 if nothing matched
+ */
+int LookupIpTrie(const struct IpTrie *t, uint32_t ip) {
+  uint32_t e;
+  if (!t->root)
+    return 0;
+  e = t->root[ip >> 16];
+  if (e & CHUNK) {
+    e = t->chunks[e & ~CHUNK][ip >> 8 & 255];
+    if (e & CHUNK)
+      e = t->chunks[e & ~CHUNK][ip & 255];
+  }
+  return e & 0xffff;
+}
+
+/**
+ * Frees memory used by longest prefix match table.
+ */
+void FreeIpTrie(struct IpTrie *t) {
+  free(t->chunks);
+  free(t->root);
+  bzero(t, sizeof(*t));
+}
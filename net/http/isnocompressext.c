@@ -24,6 +24,7 @@
 #include "net/http/http.h"
 
 static const char kNoCompressExts[][8] = {
+    "br",    //
     "bz2",   //
     "gif",   //
     "gz",    //
@@ -36,6 +37,7 @@ static const char kNoCompressExts[][8] = {
     "webp",  //
     "xz",    //
     "zip",   //
+    "zst",   //
 };
 
 static bool BisectNoCompressExts(uint64_t ext) {
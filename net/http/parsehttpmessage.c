@@ -18,9 +18,11 @@
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/assert.h"
 #include "libc/ctype.h"
+#include "libc/dce.h"
 #include "libc/limits.h"
 #include "libc/mem/alg.h"
 #include "libc/mem/mem.h"
+#include "libc/nexgen32e/x86feature.h"
 #include "libc/serialize.h"
 #include "libc/stdio/stdio.h"
 #include "libc/str/str.h"
@@ -28,6 +30,94 @@
 #include "libc/sysv/errfuns.h"
 #include "libc/x/x.h"
 #include "net/http/http.h"
+#include "third_party/aarch64/arm_neon.internal.h"
+#include "third_party/intel/immintrin.internal.h"
+
+// the fast paths below skip over bytes `x` that aren't `x < lo` (other
+// than `x == ok`) nor c1 control codes, i.e. the bytes for which loops
+// in the state machine would have done nothing but advance
+
+#if defined(__x86_64__) && !defined(__chibicc__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+static size_t SkipHttpTextAvx2(const char *p, size_t i, size_t n, int lo,
+                               int ok) {
+  unsigned m;
+  __m256i v, x;
+  __m256i flip = _mm256_set1_epi8(0x80);
+  __m256i vlo = _mm256_set1_epi8(lo ^ 0x80);
+  __m256i vok = _mm256_set1_epi8(ok);
+  __m256i c1a = _mm256_set1_epi8((0x7F ^ 0x80) - 1);
+  __m256i c1b = _mm256_set1_epi8(0xA0 ^ 0x80);
+  for (; n - i >= 32; i += 32) {
+    v = _mm256_loadu_si256((const __m256i *)(p + i));
+    x = _mm256_xor_si256(v, flip);
+    if ((m = _mm256_movemask_epi8(_mm256_or_si256(
+             _mm256_andnot_si256(_mm256_cmpeq_epi8(v, vok),
+                                 _mm256_cmpgt_epi8(vlo, x)),
+             _mm256_and_si256(_mm256_cmpgt_epi8(x, c1a),
+                              _mm256_cmpgt_epi8(c1b, x))))))
+      return i + __builtin_ctz(m);
+  }
+  return i;
+}
+#pragma GCC pop_options
+static size_t SkipHttpTextSse2(const char *p, size_t i, size_t n, int lo,
+                               int ok) {
+  unsigned m;
+  __m128i v, x;
+  __m128i flip = _mm_set1_epi8(0x80);
+  __m128i vlo = _mm_set1_epi8(lo ^ 0x80);
+  __m128i vok = _mm_set1_epi8(ok);
+  __m128i c1a = _mm_set1_epi8((0x7F ^ 0x80) - 1);
+  __m128i c1b = _mm_set1_epi8(0xA0 ^ 0x80);
+  for (; n - i >= 16; i += 16) {
+    v = _mm_loadu_si128((const __m128i *)(p + i));
+    x = _mm_xor_si128(v, flip);
+    if ((m = _mm_movemask_epi8(
+             _mm_or_si128(_mm_andnot_si128(_mm_cmpeq_epi8(v, vok),
+                                           _mm_cmpgt_epi8(vlo, x)),
+                          _mm_and_si128(_mm_cmpgt_epi8(x, c1a),
+                                        _mm_cmpgt_epi8(c1b, x))))))
+      return i + __builtin_ctz(m);
+  }
+  return i;
+}
+#endif
+
+static size_t SkipHttpText(const char *p, size_t i, size_t n, int lo,
+                           int ok) {
+  int ch;
+#if defined(__x86_64__) && !defined(__chibicc__)
+  if (X86_HAVE(AVX2) && !IsModeDbg()) {
+    i = SkipHttpTextAvx2(p, i, n, lo, ok);
+  } else {
+    i = SkipHttpTextSse2(p, i, n, lo, ok);
+  }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  uint8x16_t v;
+  uint64_t m;
+  for (; n - i >= 16; i += 16) {
+    v = vld1q_u8((const uint8_t *)(p + i));
+    if ((m = vget_lane_u64(
+             vreinterpret_u64_u8(vshrn_n_u16(
+                 vreinterpretq_u16_u8(vorrq_u8(
+                     vbicq_u8(vcltq_u8(v, vdupq_n_u8(lo)),
+                              vceqq_u8(v, vdupq_n_u8(ok))),
+                     vandq_u8(vcgeq_u8(v, vdupq_n_u8(0x7F)),
+                              vcltq_u8(v, vdupq_n_u8(0xA0))))),
+                 4)),
+             0)))
+      return i + (__builtin_ctzll(m) >> 2);
+  }
+#endif
+  for (; i < n; ++i) {
+    ch = p[i] & 255;
+    if ((ch < lo && ch != ok) || (0x7F <= ch && ch < 0xA0))
+      break;
+  }
+  return i;
+}
 
 /**
  * Initializes HTTP message parser.
@@ -95,7 +185,9 @@ void ResetHttpMessage(struct HttpMessage *r, int type) {
  *
  * This parser takes about 400 nanoseconds to parse a 403 byte Chrome
  * HTTP request under MODE=rel on a Core i9 which is about three cycles
- * per byte or a gigabyte per second of throughput per core.
+ * per byte or a gigabyte per second of throughput per core. Long URIs,
+ * status messages, and header values are skipped over 16 or 32 bytes
+ * at a time using SSE2, AVX2, or NEON.
  *
  * @param p needs to have at least `c` bytes available
  * @param n is how many bytes have been received off the network so far
@@ -146,6 +238,9 @@ int ParseHttpMessage(struct HttpMessage *r, const char *p, size_t n, size_t c) {
         }
         break;
       case kHttpStateUri:
+        if ((r->i = SkipHttpText(p, r->i, n, '!', '!')) == n)
+          break;
+        ch = p[r->i] & 255;
         for (;;) {
           if (ch == ' ' || ch == '\r' || ch == '\n') {
             if (r->i == r->a)
@@ -210,6 +305,9 @@ int ParseHttpMessage(struct HttpMessage *r, const char *p, size_t n, size_t c) {
         }
         break;
       case kHttpStateMessage:
+        if ((r->i = SkipHttpText(p, r->i, n, ' ', ' ')) == n)
+          break;
+        ch = p[r->i] & 255;
         for (;;) {
           if (ch == '\r' || ch == '\n') {
             r->message.a = r->a;
@@ -264,6 +362,9 @@ int ParseHttpMessage(struct HttpMessage *r, const char *p, size_t n, size_t c) {
         r->t = kHttpStateValue;
         // fallthrough
       case kHttpStateValue:
+        if ((r->i = SkipHttpText(p, r->i, n, ' ', '\t')) == n)
+          break;
+        ch = p[r->i] & 255;
         for (;;) {
           if (ch == '\r' || ch == '\n') {
             i = r->i;
@@ -28,9 +28,52 @@
 struct UrlParser {
   char *p, *q;
   const char *s;
-  unsigned c, i, n, f;
+  unsigned c, i, n, f, cap;
 };
 
+// appends byte to current field
+//
+// when views are being returned, the byte is already at `p` since the
+// input is known to not need decoding, so we merely extend the slice
+static void EmitChar(struct UrlParser *u, int c) {
+  if (u->f & kUrlView) {
+    ++u->p;
+  } else {
+    *u->p++ = c;
+  }
+}
+
+// starts new field after a delimiter has been consumed
+static void EndField(struct UrlParser *u) {
+  if (u->f & kUrlView)
+    u->p = (char *)u->s + u->i;
+  u->q = u->p;
+}
+
+// returns true if every field of `s` is a verbatim slice of it
+static bool IsUrlViewable(const char *s, size_t n, int f) {
+  size_t i;
+  if (n >= 2 && s[n - 2] == '/' && s[n - 1] == '/')
+    return false;  // e.g. `//` which parses to a synthesized path
+  for (i = 0; i < n; ++i) {
+    switch (s[i] & 255) {
+      case '%':
+      case '[':
+      case ']':
+        return false;
+      case '+':
+        if (f & kUrlPlus)
+          return false;
+        break;
+      default:
+        if ((s[i] & 0200) && (f & kUrlLatin1))
+          return false;
+        break;
+    }
+  }
+  return true;
+}
+
 static void EmitLatin1(char **p, int c) {
   (*p)[0] = 0300 | c >> 6;
   (*p)[1] = 0200 | (c & 077);
@@ -39,10 +82,13 @@ static void EmitLatin1(char **p, int c) {
 
 static bool EmitKey(struct UrlParser *u, struct UrlParams *h) {
   struct UrlParam *p;
-  if ((p = realloc(h->p, ++h->n * sizeof(*h->p)))) {
-    p[h->n - 1].key.p = u->q;
-    p[h->n - 1].key.n = u->p - u->q;
-    u->q = u->p;
+  if (h->n < u->cap || (p = realloc(h->p, (h->n + 1) * sizeof(*h->p)))) {
+    if (h->n < u->cap)
+      p = h->p;
+    p[h->n].key.p = u->q;
+    p[h->n].key.n = u->p - u->q;
+    ++h->n;
+    EndField(u);
     h->p = p;
     return true;
   } else {
@@ -61,7 +107,7 @@ static void EmitVal(struct UrlParser *u, struct UrlParams *h, bool t) {
   } else {
     h->p[h->n - 1].val.p = u->q;
     h->p[h->n - 1].val.n = u->p - u->q;
-    u->q = u->p;
+    EndField(u);
   }
 }
 
@@ -81,18 +127,20 @@ static bool ParseScheme(struct UrlParser *u, struct Url *h) {
     if (u->c == '/') {
       if (u->i == 1 && u->i < u->n && u->s[u->i] == '/') {
         ++u->i;
+        EndField(u);
         return true;
       } else {
-        *u->p++ = '/';
+        EmitChar(u, '/');
         return false;
       }
     } else if (u->c == ':' && u->i > 1) {
       h->scheme.p = u->q;
       h->scheme.n = u->p - u->q;
-      u->q = u->p;
+      EndField(u);
       if (u->i < u->n && u->s[u->i] == '/') {
         if (u->i + 1 < u->n && u->s[u->i + 1] == '/') {
           u->i += 2;
+          EndField(u);
           return true;
         } else {
           return false;
@@ -104,7 +152,7 @@ static bool ParseScheme(struct UrlParser *u, struct Url *h) {
     } else if (u->c == '#' || u->c == '?') {
       h->path.p = u->q;
       h->path.n = u->p - u->q;
-      u->q = u->p;
+      EndField(u);
       return false;
     } else if (u->c == '%') {
       ParseEscape(u);
@@ -113,7 +161,7 @@ static bool ParseScheme(struct UrlParser *u, struct Url *h) {
       EmitLatin1(&u->p, u->c);
       return false;
     } else {
-      *u->p++ = u->c;
+      EmitChar(u, u->c);
       if (u->i == 1) {
         if (!(('A' <= u->c && u->c <= 'Z') || ('a' <= u->c && u->c <= 'z'))) {
           return false;
@@ -142,7 +190,7 @@ static void ParseAuthority(struct UrlParser *u, struct Url *h) {
     } else if (u->c == ']') {
       t = 1;
     } else if (u->c == ':' && t > 0) {
-      *u->p++ = ':';
+      EmitChar(u, ':');
       c = u->p;
       ++t;
     } else if (u->c == '@') {
@@ -157,13 +205,13 @@ static void ParseAuthority(struct UrlParser *u, struct Url *h) {
         h->user.p = u->q;
         h->user.n = u->p - u->q;
       }
-      u->q = u->p;
+      EndField(u);
     } else if (u->c == '%') {
       ParseEscape(u);
     } else if (u->c >= 0200 && (u->f & kUrlLatin1)) {
       EmitLatin1(&u->p, u->c);
     } else {
-      *u->p++ = u->c;
+      EmitChar(u, u->c);
     }
   }
   if (t == 2) {
@@ -176,9 +224,11 @@ static void ParseAuthority(struct UrlParser *u, struct Url *h) {
     h->host.p = u->q;
     h->host.n = u->p - u->q;
   }
-  u->q = u->p;
   if (u->c == '/') {
-    *u->p++ = u->c;
+    u->q = u->p;
+    EmitChar(u, '/');
+  } else {
+    EndField(u);
   }
 }
 
@@ -194,18 +244,24 @@ static void ParsePath(struct UrlParser *u, struct UrlView *h) {
     } else if (u->c >= 0200 && (u->f & kUrlLatin1)) {
       EmitLatin1(&u->p, u->c);
     } else {
-      *u->p++ = u->c;
+      EmitChar(u, u->c);
     }
   }
   h->p = u->q;
   h->n = u->p - u->q;
-  u->q = u->p;
+  EndField(u);
 }
 
 static void ParseQuery(struct UrlParser *u, struct UrlParams *h) {
+  size_t i;
   bool t = false;
-  if (!h->p)
-    h->p = malloc(0);
+  if (!h->p) {
+    // reserve a param for each `&` so we only need to malloc() once
+    for (u->cap = 1, i = u->i; i < u->n; ++i)
+      u->cap += u->s[i] == '&';
+    if (!(h->p = malloc(u->cap * sizeof(*h->p))))
+      u->cap = 0;
+  }
   while (u->i < u->n) {
     u->c = u->s[u->i++] & 255;
     if (u->c == '#') {
@@ -213,7 +269,7 @@ static void ParseQuery(struct UrlParser *u, struct UrlParams *h) {
     } else if (u->c == '%') {
       ParseEscape(u);
     } else if (u->c == '+') {
-      *u->p++ = (u->f & kUrlPlus) ? ' ' : '+';
+      EmitChar(u, (u->f & kUrlPlus) ? ' ' : '+');
     } else if (u->c == '&') {
       EmitVal(u, h, t);
       t = false;
@@ -221,12 +277,12 @@ static void ParseQuery(struct UrlParser *u, struct UrlParams *h) {
       if (!t) {
         t = EmitKey(u, h);
       } else {
-        *u->p++ = '=';
+        EmitChar(u, '=');
       }
     } else if (u->c >= 0200 && (u->f & kUrlLatin1)) {
       EmitLatin1(&u->p, u->c);
     } else {
-      *u->p++ = u->c;
+      EmitChar(u, u->c);
     }
   }
   EmitVal(u, h, t);
@@ -240,7 +296,7 @@ static void ParseFragment(struct UrlParser *u, struct UrlView *h) {
     } else if (u->c >= 0200 && (u->f & kUrlLatin1)) {
       EmitLatin1(&u->p, u->c);
     } else {
-      *u->p++ = u->c;
+      EmitChar(u, u->c);
     }
   }
   h->p = u->q;
@@ -279,6 +335,8 @@ static void ParseFragment(struct UrlParser *u, struct UrlView *h) {
  * @param f is flags which may have:
  *     - `FLAGS_PLUS` to turn `+` into space in query params
  *     - `FLAGS_LATIN1` to transcode ISO-8859-1 input into UTF-8
+ *     - `kUrlView` to return slices of `s` if nothing needs decoding,
+ *       in which case NULL is returned and `s` must outlive `h`
  * @return memory backing UrlView needing free (and h.params.p too)
  * @see URI Generic Syntax RFC3986 RFC2396
  * @see EncodeUrl()
@@ -292,10 +350,18 @@ char *ParseUrl(const char *s, size_t n, struct Url *h, int f) {
   u.c = 0;
   u.s = s;
   u.n = n;
-  u.f = f;
+  u.f = f & ~kUrlView;
+  u.cap = 0;
+  u.p = 0;
   bzero(h, sizeof(*h));
-  if ((m = malloc((f & kUrlLatin1) ? u.n * 2 : u.n))) {
+  if ((f & kUrlView) && IsUrlViewable(s, n, f)) {
+    u.f |= kUrlView;
+    m = 0;
+    u.q = u.p = (char *)s;
+  } else if ((m = malloc((f & kUrlLatin1) ? u.n * 2 : u.n))) {
     u.q = u.p = m;
+  }
+  if (u.p) {
     if (ParseScheme(&u, h))
       ParseAuthority(&u, h);
     if (u.c != '#' && u.c != '?')
@@ -338,6 +404,7 @@ char *ParseParams(const char *s, size_t n, struct UrlParams *h) {
   u.n = n;
   u.c = '?';
   u.f = kUrlPlus;
+  u.cap = 0;
   if ((m = malloc(u.n))) {
     u.q = u.p = m;
     ParseQuery(&u, h);
@@ -379,6 +446,7 @@ char *ParseHost(const char *s, size_t n, struct Url *h) {
   u.s = s;
   u.n = n;
   u.f = kUrlLatin1;
+  u.cap = 0;
   if ((m = malloc(u.n * 2))) {
     u.q = u.p = m;
     ParseAuthority(&u, h);
@@ -17,7 +17,13 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "net/http/tokenbucket.h"
+#include "libc/cosmotime.h"
 #include "libc/intrin/atomic.h"
+#include "libc/serialize.h"
+#include "libc/str/str.h"
+#include "libc/thread/thread.h"
+
+#define kTokenBucketProbes 8
 
 /**
  * Atomically increments all signed bytes in array, without overflowing.
@@ -92,3 +98,220 @@ int CountTokens(atomic_schar *b, uint32_t x, int c) {
   uint32_t i = x >> (32 - c);
   return atomic_load_explicit(b + i, memory_order_relaxed);
 }
+
+/**
+ * Returns number of bytes needed to hold token buckets for `n` clients.
+ *
+ * @param n is desired number of buckets, which gets rounded up
+ * @see InitTokenBuckets()
+ */
+size_t GetTokenBucketsSize(size_t n) {
+  size_t m;
+  for (m = kTokenBucketProbes; m * kTokenBucketShards < n; m <<= 1) {
+  }
+  return sizeof(struct TokenBuckets) +
+         m * kTokenBucketShards * sizeof(struct TokenBucketSlot);
+}
+
+/**
+ * Initializes token buckets keyed by ipv4 or ipv6 network prefix.
+ *
+ * Unlike the flat byte array used by AcquireToken(), this structure
+ * only remembers clients who've been seen recently, and each bucket is
+ * refilled lazily based on timestamps, so there's no need to run a
+ * background replenisher that sweeps memory. When a neighborhood of the
+ * table is full, the bucket with the most tokens is forgotten, since a
+ * bucket that's refilled to 127 tokens holds no information.
+ *
+ * The structure contains no pointers and uses spin locks, each guarding
+ * a shard of the table, so it may live in memory shared between forked
+ * processes. Memory for it must be allocated by the caller:
+ *
+ *     size_t n = GetTokenBucketsSize(65536);
+ *     struct TokenBuckets *tb = _mapshared(n);
+ *     InitTokenBuckets(tb, 65536, 24, 64, timespec_fromseconds(1));
+ *
+ * @param tb is memory of at least `GetTokenBucketsSize(n)` bytes
+ * @param n is desired number of buckets, which gets rounded up
+ * @param cidr4 is ipv4 prefix length which is 0..32
+ * @param cidr6 is ipv6 prefix length which is 0..128
+ * @param interval is how often each bucket gains one token
+ */
+void InitTokenBuckets(struct TokenBuckets *tb, size_t n, int cidr4, int cidr6,
+                      struct timespec interval) {
+  size_t m;
+  for (m = kTokenBucketProbes; m * kTokenBucketShards < n; m <<= 1) {
+  }
+  bzero(tb, sizeof(*tb) + m * kTokenBucketShards * sizeof(*tb->slot));
+  tb->cidr4 = cidr4;
+  tb->cidr6 = cidr6;
+  tb->mask = m - 1;
+  tb->interval = timespec_tonanos(interval);
+  if (tb->interval < 1)
+    tb->interval = 1;
+}
+
+static void LockTokenBucketShard(atomic_uint *lock) {
+  for (;;) {
+    if (!atomic_exchange_explicit(lock, 1, memory_order_acquire))
+      return;
+    while (atomic_load_explicit(lock, memory_order_relaxed))
+      pthread_pause_np();
+  }
+}
+
+static void UnlockTokenBucketShard(atomic_uint *lock) {
+  atomic_store_explicit(lock, 0, memory_order_release);
+}
+
+static uint64_t HashTokenBucketKey(uint64_t hi, uint64_t lo) {
+  uint64_t h = hi * 0x9e3779b97f4a7c15 ^ lo;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccd;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53;
+  h ^= h >> 33;
+  return h;
+}
+
+static uint64_t MaskTokenBucketWord(uint64_t x, int bits) {
+  if (bits <= 0)
+    return 0;
+  if (bits >= 64)
+    return x;
+  return x & -(1ull << (64 - bits));
+}
+
+// brings bucket up to date with clock and returns its tokens
+static int RefillTokenBucket(struct TokenBuckets *tb,
+                             struct TokenBucketSlot *s, int64_t now) {
+  int64_t k;
+  if (now > s->last && (k = (now - s->last) / tb->interval)) {
+    if (k >= 127 - s->tokens) {
+      s->tokens = 127;
+      s->last = now;
+    } else {
+      s->tokens += k;
+      s->last += k * tb->interval;
+    }
+  }
+  return s->tokens;
+}
+
+static int UseTokenBucket(struct TokenBuckets *tb, uint64_t hi, uint64_t lo,
+                          struct timespec ts, bool acquire) {
+  int t, best;
+  uint32_t i, j;
+  uint64_t h = HashTokenBucketKey(hi, lo);
+  int64_t now = timespec_tonanos(ts);
+  struct TokenBucketShard *shard = tb->shard + (h & (kTokenBucketShards - 1));
+  struct TokenBucketSlot *slots, *s, *victim = 0;
+  slots = tb->slot + (h & (kTokenBucketShards - 1)) * (tb->mask + 1);
+  LockTokenBucketShard(&shard->lock);
+  for (best = -1, i = 0; i < kTokenBucketProbes; ++i) {
+    j = ((h >> 32) + i) & tb->mask;
+    s = slots + j;
+    if (!s->used) {
+      if (best < 128) {
+        best = 128;
+        victim = s;
+      }
+      continue;
+    }
+    if (s->hi == hi && s->lo == lo)
+      goto Found;
+    if ((t = RefillTokenBucket(tb, s, now)) > best) {
+      best = t;
+      victim = s;
+    }
+  }
+  if (!acquire) {
+    UnlockTokenBucketShard(&shard->lock);
+    return 127;
+  }
+  s = victim;
+  s->hi = hi;
+  s->lo = lo;
+  s->last = now;
+  s->tokens = 127;
+  s->used = true;
+Found:
+  t = RefillTokenBucket(tb, s, now);
+  if (acquire && t > 0)
+    --s->tokens;
+  UnlockTokenBucketShard(&shard->lock);
+  return t;
+}
+
+static int UseTokenBucket4(struct TokenBuckets *tb, uint32_t ip,
+                           struct timespec now, bool acquire) {
+  uint64_t lo = MaskTokenBucketWord((uint64_t)ip << 32, tb->cidr4) >> 32;
+  return UseTokenBucket(tb, 0, 0xffff00000000 | lo, now, acquire);
+}
+
+static int UseTokenBucket6(struct TokenBuckets *tb, const uint8_t ip[16],
+                           struct timespec now, bool acquire) {
+  uint64_t hi = READ64BE(ip);
+  uint64_t lo = READ64BE(ip + 8);
+  if (!hi && lo >> 32 == 0xffff)
+    return UseTokenBucket4(tb, lo, now, acquire);
+  return UseTokenBucket(tb, MaskTokenBucketWord(hi, tb->cidr6),
+                        MaskTokenBucketWord(lo, tb->cidr6 - 64), now,
+                        acquire);
+}
+
+/**
+ * Decrements token bucket for ipv4 client if it's positive.
+ *
+ * This has the same contract as AcquireToken(). Return values greater
+ * than zero mean a token was acquired. Values less than or equal zero
+ * mean the bucket is empty. Clients we haven't seen recently start off
+ * with 127 tokens.
+ *
+ * @param tb is token buckets created by InitTokenBuckets()
+ * @param ip is ipv4 address
+ * @param now is monotonic time such as timespec_mono()
+ * @return tokens in bucket before acquiring
+ */
+int AcquireToken4(struct TokenBuckets *tb, uint32_t ip, struct timespec now) {
+  return UseTokenBucket4(tb, ip, now, true);
+}
+
+/**
+ * Decrements token bucket for ipv6 client if it's positive.
+ *
+ * IPv4-mapped addresses, e.g. `::ffff:1.2.3.4`, share their bucket with
+ * the ipv4 address they represent.
+ *
+ * @param tb is token buckets created by InitTokenBuckets()
+ * @param ip is ipv6 address in network byte order
+ * @param now is monotonic time such as timespec_mono()
+ * @return tokens in bucket before acquiring
+ */
+int AcquireToken6(struct TokenBuckets *tb, const uint8_t ip[16],
+                  struct timespec now) {
+  return UseTokenBucket6(tb, ip, now, true);
+}
+
+/**
+ * Returns current number of tokens in bucket for ipv4 client.
+ *
+ * @param tb is token buckets created by InitTokenBuckets()
+ * @param ip is ipv4 address
+ * @param now is monotonic time such as timespec_mono()
+ */
+int CountTokens4(struct TokenBuckets *tb, uint32_t ip, struct timespec now) {
+  return UseTokenBucket4(tb, ip, now, false);
+}
+
+/**
+ * Returns current number of tokens in bucket for ipv6 client.
+ *
+ * @param tb is token buckets created by InitTokenBuckets()
+ * @param ip is ipv6 address in network byte order
+ * @param now is monotonic time such as timespec_mono()
+ */
+int CountTokens6(struct TokenBuckets *tb, const uint8_t ip[16],
+                 struct timespec now) {
+  return UseTokenBucket6(tb, ip, now, false);
+}
@@ -1,11 +1,44 @@
 #ifndef COSMOPOLITAN_NET_HTTP_TOKENBUCKET_H_
 #define COSMOPOLITAN_NET_HTTP_TOKENBUCKET_H_
 #include "libc/atomic.h"
+#include "libc/calls/struct/timespec.h"
 COSMOPOLITAN_C_START_
 
+#define kTokenBucketShards 64
+
+struct TokenBucketShard {
+  _Alignas(64) atomic_uint lock;
+};
+
+struct TokenBucketSlot {
+  uint64_t hi, lo;  // masked ipv6 prefix, ipv4 is ::ffff:0:0/96 mapped
+  int64_t last;     // nanos of last refill
+  int tokens;       // 0..127 as of `last`
+  bool used;
+};
+
+struct TokenBuckets {
+  int cidr4;         // ipv4 prefix length, e.g. 24
+  int cidr6;         // ipv6 prefix length, e.g. 64
+  uint32_t mask;     // slots per shard minus one
+  int64_t interval;  // nanos per token
+  struct TokenBucketShard shard[kTokenBucketShards];
+  struct TokenBucketSlot slot[];
+};
+
 void ReplenishTokens(atomic_uint_fast64_t *, size_t) libcesque;
 int AcquireToken(atomic_schar *, uint32_t, int) libcesque;
 int CountTokens(atomic_schar *, uint32_t, int) libcesque;
 
+size_t GetTokenBucketsSize(size_t) libcesque;
+void InitTokenBuckets(struct TokenBuckets *, size_t, int, int,
+                      struct timespec) libcesque;
+int AcquireToken4(struct TokenBuckets *, uint32_t, struct timespec) libcesque;
+int AcquireToken6(struct TokenBuckets *, const uint8_t[16],
+                  struct timespec) libcesque;
+int CountTokens4(struct TokenBuckets *, uint32_t, struct timespec) libcesque;
+int CountTokens6(struct TokenBuckets *, const uint8_t[16],
+                 struct timespec) libcesque;
+
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_NET_HTTP_TOKENBUCKET_H_ */
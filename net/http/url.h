@@ -4,6 +4,7 @@
 #define kUrlPlus   1
 #define kUrlLatin1 2
 #define kUrlOpaque 4
+#define kUrlView   8
 
 COSMOPOLITAN_C_START_
 
@@ -193,6 +193,7 @@ static int PerformFetch(char **response_data, const char *urlarg, int tries) {
                                 MBEDTLS_SSL_PRESET_DEFAULT);
     mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_REQUIRED);
     mbedtls_ssl_conf_ca_chain(&conf, GetSslRoots(), 0);
+    mbedtls_ssl_conf_verify_cache(&conf, VerifyCache, 0);
     mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &drbg);
     if (mbedtls_ssl_setup(&ssl, &conf))
       goto OutOfMemory;
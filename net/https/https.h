@@ -48,6 +48,8 @@ void ProgramPrivateKey(struct Certs *, const char *, size_t);
 void CertsDestroy(struct Certs *);
 void AppendCert(struct Certs *, mbedtls_x509_crt *, mbedtls_pk_context *);
 int TlsRoute(void *, mbedtls_ssl_context *, const unsigned char *, size_t);
+int VerifyCache(void *, const mbedtls_x509_crt *, const mbedtls_x509_crt *,
+                const char *, int);
 
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_NET_HTTPS_HTTPS_H_ */
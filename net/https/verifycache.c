@@ -0,0 +1,121 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/serialize.h"
+#include "libc/str/str.h"
+#include "libc/thread/thread.h"
+#include "libc/time.h"
+#include "net/https/https.h"
+#include "third_party/mbedtls/sha256.h"
+
+#define VERIFY_CACHE_SIZE 64
+#define VERIFY_CACHE_TTL  3600
+
+static struct {
+  pthread_mutex_t lock;
+  unsigned next;
+  struct VerifyCacheEntry {
+    int64_t expires;
+    unsigned char key[32];
+  } entry[VERIFY_CACHE_SIZE];
+} g_verify_cache = {PTHREAD_MUTEX_INITIALIZER};
+
+static void HashChain(unsigned char key[32], const mbedtls_x509_crt *chain,
+                      const mbedtls_x509_crt *ca, const char *host) {
+  unsigned char b[8];
+  mbedtls_sha256_context ctx;
+  mbedtls_sha256_init(&ctx);
+  mbedtls_sha256_starts_ret(&ctx, false);
+  WRITE64LE(b, (uintptr_t)ca);
+  mbedtls_sha256_update_ret(&ctx, b, 8);
+  if (host) {
+    mbedtls_sha256_update_ret(&ctx, (const unsigned char *)host,
+                              strlen(host) + 1);
+  }
+  for (; chain && chain->raw.p; chain = chain->next) {
+    WRITE64LE(b, chain->raw.len);
+    mbedtls_sha256_update_ret(&ctx, b, 8);
+    mbedtls_sha256_update_ret(&ctx, chain->raw.p, chain->raw.len);
+  }
+  mbedtls_sha256_finish_ret(&ctx, key);
+  mbedtls_sha256_free(&ctx);
+}
+
+static int64_t GetChainExpiry(const mbedtls_x509_crt *chain, int64_t now) {
+  struct tm tm;
+  int64_t t, expires = now + VERIFY_CACHE_TTL;
+  for (; chain && chain->raw.p; chain = chain->next) {
+    bzero(&tm, sizeof(tm));
+    tm.tm_year = chain->valid_to.year - 1900;
+    tm.tm_mon = chain->valid_to.mon - 1;
+    tm.tm_mday = chain->valid_to.day;
+    tm.tm_hour = chain->valid_to.hour;
+    tm.tm_min = chain->valid_to.min;
+    tm.tm_sec = chain->valid_to.sec;
+    if ((t = timegm(&tm)) < expires) {
+      expires = t;
+    }
+  }
+  return expires;
+}
+
+/**
+ * Remembers certificate chains that passed verification.
+ *
+ * This is a callback for mbedtls_ssl_conf_verify_cache() which lets
+ * clients that connect to the same hosts repeatedly skip the public
+ * key operations of chain verification. Entries are keyed on the DER
+ * of every certificate the peer sent, the trust anchor list, and the
+ * hostname, and expire after an hour or once any certificate in the
+ * chain expires, whichever comes first. The cache holds a small fixed
+ * number of entries per process and evicts them round robin.
+ *
+ * @param store is 0 to look up `chain` or 1 to insert it
+ * @return 0 if `chain` is cached or was stored, otherwise -1
+ * @threadsafe
+ */
+int VerifyCache(void *ctx, const mbedtls_x509_crt *chain,
+                const mbedtls_x509_crt *ca, const char *host, int store) {
+  int i, rc;
+  int64_t now;
+  unsigned char key[32];
+  now = time(0);
+  HashChain(key, chain, ca, host);
+  rc = -1;
+  pthread_mutex_lock(&g_verify_cache.lock);
+  for (i = 0; i < VERIFY_CACHE_SIZE; ++i) {
+    if (g_verify_cache.entry[i].expires > now &&
+        !timingsafe_bcmp(g_verify_cache.entry[i].key, key, 32)) {
+      break;
+    }
+  }
+  if (!store) {
+    if (i < VERIFY_CACHE_SIZE) {
+      rc = 0;
+    }
+  } else {
+    if (i == VERIFY_CACHE_SIZE) {
+      i = g_verify_cache.next++ % VERIFY_CACHE_SIZE;
+    }
+    memcpy(g_verify_cache.entry[i].key, key, 32);
+    g_verify_cache.entry[i].expires = GetChainExpiry(chain, now);
+    rc = 0;
+  }
+  pthread_mutex_unlock(&g_verify_cache.lock);
+  return rc;
+}
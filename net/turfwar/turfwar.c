@@ -43,8 +43,10 @@
 #include "libc/limits.h"
 #include "libc/log/log.h"
 #include "libc/macros.h"
+#include "libc/mem/alg.h"
 #include "libc/mem/gc.h"
 #include "libc/mem/mem.h"
+#include "libc/nexgen32e/crc32.h"
 #include "libc/nexgen32e/stackframe.h"
 #include "libc/paths.h"
 #include "libc/runtime/runtime.h"
@@ -69,6 +71,7 @@
 #include "libc/sysv/consts/sol.h"
 #include "libc/sysv/consts/tcp.h"
 #include "libc/sysv/consts/timer.h"
+#include "libc/thread/mpsc.h"
 #include "libc/thread/thread.h"
 #include "libc/thread/thread2.h"
 #include "libc/time.h"
@@ -102,7 +105,8 @@
 #define KEEPALIVE_MS      10000   // max time to keep idle conn open
 #define MELTALIVE_MS      1000    // panic keepalive under heavy load
 #define CHECKPOINT_MS     5000    // how often to checkpoint db
-#define CLAIM_BATCH_MS    10      // how often to process claims
+#define CLAIM_DELAY_MS    50      // max time claim waits for group commit
+#define CLAIM_GROUP_MIN   1000    // pending claims that trigger a commit
 #define SCORE_H_UPDATE_MS 30000   // how often to regenerate /score/hour
 #define SCORE_D_UPDATE_MS 300000  // how often to regenerate /score/day
 #define SCORE_W_UPDATE_MS 300000  // how often to regenerate /score/week
@@ -111,12 +115,13 @@
 #define CONCERN_LOAD      .90     // avoid keepalive, upon this connection load
 #define PANIC_LOAD        .98     // meltdown if this percent of pool connected
 #define PANIC_MSGS        10      // msgs per conn can't exceed it in meltdown
-#define QUEUE_MAX         15000   // maximum pending claim items in queue
+#define QUEUE_MAX         16384   // maximum pending claim items in queue
 #define BATCH_MAX         3000    // max claims to insert per transaction
 #define NICK_MAX          40      // max length of user nickname string
 #define TB_INTERVAL       1000    // millis between token replenishes
 #define MAX_MESSAGES      16      // max http messages per connection
 #define TB_CIDR           27      // token bucket cidr specificity
+#define TB_CLIENTS        1048576 // token bucket networks to remember
 #define SOCK_MAX          100     // max length of socket queue
 #define MSG_BUF           512     // small response lookaside
 #define DETECT_LEAKS      0       // malloc leak detector
@@ -124,9 +129,6 @@
 
 #define BUF_SIZE 65536
 
-#define TB_BYTES (1u << TB_CIDR)
-#define TB_WORDS (TB_BYTES / 8)
-
 #define GETOPTS "idvp:w:k:W:U:G:"
 #define USAGE \
   "\
@@ -237,16 +239,22 @@ struct Data {
   size_t n;
 };
 
-struct Asset {
-  atomic_bool ready;
+// immutable rendition of an asset
+struct Version {
   int cash;
-  char *path;
-  pthread_rwlock_t lock;
   const char *type;
   struct Data data;
   struct Data gzip;
   struct timespec mtim;
   char lastmodified[32];
+  long retired;          // epoch that superseded this version
+  struct Version *next;  // next on retired list
+};
+
+// web asset whose current version is swapped out by Publish()
+struct Asset {
+  char *path;
+  _Atomic(struct Version *) current;
 };
 
 struct Blackhole {
@@ -292,11 +300,8 @@ struct File ecdsacert;
 struct File ecdsakey;
 
 // threads
-pthread_t scorer, claimer, replenisher;
+pthread_t scorer, claimer;
 pthread_t scorer_hour, scorer_day, scorer_week, scorer_month;
-alignas(64) pthread_mutex_t report_lock = PTHREAD_MUTEX_INITIALIZER;
-alignas(64) pthread_cond_t checkpoint_cond = PTHREAD_COND_INITIALIZER;
-alignas(64) pthread_mutex_t checkpoint_lock = PTHREAD_MUTEX_INITIALIZER;
 
 // lifecycle vars
 struct timespec g_started;
@@ -337,6 +342,11 @@ struct Counter g_checkpointfails;
 atomic_long g_walpages;
 atomic_long g_walprocessed;
 atomic_long g_lastbatchsize;
+atomic_long g_queuedepth;
+atomic_long g_maxqueuedepth;
+atomic_long g_commitmicros;
+atomic_long g_lastcommitmicros;
+atomic_long g_maxcommitmicros;
 
 struct Counter g_readeof;
 struct Counter g_readfail;
@@ -394,10 +404,7 @@ struct SortedInts {
   int *p;
 };
 
-union TokenBucket {
-  atomic_schar *b;
-  atomic_uint_fast64_t *w;
-} g_tok;
+struct TokenBuckets *g_tok;
 
 // http worker objects
 struct Worker {
@@ -410,6 +417,7 @@ struct Worker {
   bool got_first_recv;
   struct sockaddr_in addr;
   atomic_bool dead;
+  alignas(64) atomic_long epoch;  // nonzero while reading an asset
   atomic_int msgcount;
   atomic_int connected;
   struct timespec startread;
@@ -441,19 +449,74 @@ struct Assets {
   struct Asset favicon;
 } g_asset;
 
+struct Claim {
+  uint32_t ip;
+  int64_t created;
+  char name[NICK_MAX + 1];
+};
+
 // queues /claim to ClaimWorker()
-struct Claims {
-  int pos;
-  int count;
+mpsc_t g_claims;
+
+// read-copy-update state for assets
+alignas(64) atomic_long g_epoch = 1;
+alignas(64) _Atomic(struct Version *) g_retired;
+struct Version *g_retiring;  // owned by Supervisor()
+
+// score windows of the leaderboard
+#define BOARD_ALL     0
+#define BOARD_HOUR    1
+#define BOARD_DAY     2
+#define BOARD_WEEK    3
+#define BOARD_MONTH   4
+#define BOARD_WINDOWS 5
+
+static const long kBoardWindow[BOARD_WINDOWS] = {
+    -1, 60L * 60, 60L * 60 * 24, 60L * 60 * 24 * 7, 60L * 60 * 24 * 30,
+};
+
+// in-memory leaderboard that ClaimWorker() updates as batches commit
+//
+// each window maps (nick, ip >> 24) to a count of land. claims from
+// the past month are also kept in a fifo ordered by creation time so
+// a window slides forward by uncounting the events that fell off its
+// end, unless that ip has since changed hands. this lets the /score
+// endpoints render from memory; the land table is only scanned once
+// at startup, or again if we ran out of memory and the board is stale
+struct Board {
   pthread_mutex_t mu;
-  pthread_cond_t non_full;
-  pthread_cond_t non_empty;
-  struct Claim {
-    uint32_t ip;
-    int64_t created;
-    char name[NICK_MAX + 1];
-  } data[QUEUE_MAX];
-} g_claims;
+  bool stale;
+  struct Nicks {
+    size_t n, c, mask;
+    int *slot;                   // open addressed ids, or zero if empty
+    char (*name)[NICK_MAX + 1];  // indexed by nick id, starting at one
+  } nicks;
+  struct Owners {
+    size_t n, mask;
+    struct Owner {
+      uint32_t ip;
+      int nick;       // zero if empty
+      int64_t event;  // sequence number in events, or -1 if not recent
+    } *p;
+  } owners;
+  struct Events {
+    size_t n, c;
+    int64_t base;  // sequence number of p[0]
+    struct Event {
+      uint32_t ip;
+      int nick;
+      int64_t created;
+    } *p;
+  } events;
+  int64_t cursor[BOARD_WINDOWS];  // oldest event each window counts
+  struct Tally {
+    size_t n, mask;
+    struct TallySlot {
+      uint64_t key;  // nick << 8 | ip >> 24, or zero if empty
+      long count;
+    } *p;
+  } tally[BOARD_WINDOWS];
+} g_board = {.mu = PTHREAD_MUTEX_INITIALIZER};
 
 void AddCounter(struct Counter *counter, long amt) {
   atomic_fetch_add_explicit(&counter->x[cosmo_shard()].x, amt,
@@ -826,7 +889,7 @@ char *FormatUnixHttpDateTime(char *s, int64_t t) {
 // this function is non-generalized for just http so
 // it needs 25 cycles rather than 709 cycles so cool
 char *FormatDate(char *p) {
-  return FormatUnixHttpDateTime(p, timespec_real().tv_sec);
+  return FormatUnixHttpDateTime(p, timespec_real_coarse().tv_sec);
 }
 
 void unlock_mutex(void *arg) {
@@ -835,52 +898,46 @@ void unlock_mutex(void *arg) {
     pthread_mutex_unlock(lock);
 }
 
-// inserts ip:name claim into blocking message queue
-// may be interrupted by absolute deadline
-// may be cancelled by server shutdown
-bool AddClaim(struct Claims *q, const struct Claim *v) {
-  bool wake = false;
-  bool added = false;
-  pthread_mutex_lock(&q->mu);
-  pthread_cleanup_push(unlock_mutex, &q->mu);
-  if (q->count != ARRAYLEN(q->data)) {
-    int i = q->pos + q->count;
-    if (ARRAYLEN(q->data) <= i)
-      i -= ARRAYLEN(q->data);
-    memcpy(q->data + i, v, sizeof(*v));
-    if (!q->count)
-      wake = true;
-    q->count++;
-    added = true;
-  }
-  pthread_cleanup_pop(true);
-  if (wake)
-    pthread_cond_broadcast(&q->non_empty);
-  return added;
+// inserts ip:name claim into lock-free message queue
+// returns false if the queue is full
+bool AddClaim(mpsc_t *q, const struct Claim *v) {
+  unsigned depth;
+  if (!mpsc_push(q, v))
+    return false;
+  if ((depth = mpsc_count(q)) > g_maxqueuedepth)
+    g_maxqueuedepth = depth;
+  return true;
 }
 
-// removes batch of ip:name claims from blocking message queue
+// removes batch of ip:name claims from lock-free message queue
 // has no deadline or cancellation; enqueued must be processed
-int GetClaims(struct Claims *q, struct Claim *out, int len) {
+//
+// once a claim arrives, this waits a little for others to join it so
+// they can share one transaction. the group is flushed as soon as it
+// reaches CLAIM_GROUP_MIN claims, or when the first one has waited as
+// long as the last commit took, but never more than CLAIM_DELAY_MS so
+// under light load claims are committed right away. claims that piled
+// up during the previous commit are flushed immediately, so under a
+// spike the batches grow to absorb it
+int GetClaims(mpsc_t *q, struct Claim *out, int len) {
   int got = 0;
-  pthread_mutex_lock(&q->mu);
-  pthread_cleanup_push(unlock_mutex, &q->mu);
+  long delay_us;
+  struct timespec deadline;
   pthread_setcancelstate(PTHREAD_CANCEL_MASKED, 0);
-  while (!q->count && !is_shutting_down)
-    if (pthread_cond_timedwait(&q->non_empty, &q->mu, 0))
-      break;  // must be ECANCELED
-  pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, 0);
-  while (got < len && q->count) {
-    memcpy(out + got, q->data + q->pos, sizeof(*out));
-    if (q->count == ARRAYLEN(q->data))
-      pthread_cond_broadcast(&q->non_full);
-    ++got;
-    q->pos++;
-    q->count--;
-    if (q->pos == ARRAYLEN(q->data))
-      q->pos = 0;
+  if (!mpsc_count(q) && !mpsc_wait(q, 1, 0) && !is_shutting_down) {
+    delay_us = MIN(g_lastcommitmicros, CLAIM_DELAY_MS * 1000L);
+    deadline = timespec_add(timespec_real(), timespec_frommicros(delay_us));
+    mpsc_wait(q, CLAIM_GROUP_MIN, &deadline);
   }
-  pthread_cleanup_pop(true);
+  while (got < len) {
+    if (mpsc_pop(q, out + got)) {
+      ++got;
+    } else if (got || mpsc_wait(q, 1, 0)) {
+      break;  // drained, or cancelled while empty
+    }
+  }
+  pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, 0);
+  g_queuedepth = mpsc_count(q);
   return got;
 }
 
@@ -891,7 +948,7 @@ static bool GetNick(char *inbuf, struct HttpMessage *msg, struct Claim *v) {
   void *f[2] = {0};
   bool found = false;
   f[0] = ParseUrl(inbuf + msg->uri.a, msg->uri.b - msg->uri.a, &url,
-                  kUrlPlus | kUrlLatin1);
+                  kUrlPlus | kUrlLatin1 | kUrlView);
   f[1] = url.params.p;
   for (i = 0; i < url.params.n; ++i) {
     if (SlicesEqual("name", 4, url.params.p[i].key.p, url.params.p[i].key.n) &&
@@ -997,6 +1054,7 @@ void OnHttpWorkerCancel(void *arg) {
   CertsDestroy(&w->sslcerts);
   free(w->preload);
   free(w->msgbuf);
+  w->epoch = 0;
   --g_worker_threads;
   w->dead = true;
 }
@@ -1319,13 +1377,18 @@ void ServeStatusz(struct Worker *w, char *outbuf, uint32_t ip) {
   p = Statusz(p, "messages", GetCounter(&g_messages));
   p = Statusz(p, "connections", GetCounter(&g_connections));
   p = Statusz(p, "worker_threads", g_worker_threads);
-  p = Statusz(p, "yourtokens", CountTokens(g_tok.b, ip, TB_CIDR));
+  p = Statusz(p, "yourtokens", CountTokens4(g_tok, ip, timespec_mono()));
   p = Statusz(p, "banned", GetCounter(&g_banned));
   p = Statusz(p, "evil", GetCounter(&g_evil));
   p = Statusz(p, "workers", g_workers);
   p = Statusz(p, "batches", g_batches);
   p = Statusz(p, "checkpoints", g_checkpoint_count);
   p = Statusz(p, "lastbatchsize", g_lastbatchsize);
+  p = Statusz(p, "queuedepth", g_queuedepth);
+  p = Statusz(p, "maxqueuedepth", g_maxqueuedepth);
+  p = Statusz(p, "commitmicros", g_commitmicros);
+  p = Statusz(p, "lastcommitmicros", g_lastcommitmicros);
+  p = Statusz(p, "maxcommitmicros", g_maxcommitmicros);
   p = Statusz(p, "walpages", g_walpages);
   p = Statusz(p, "walprocessed", g_walprocessed);
   p = Statusz(p, "accepts", GetCounter(&g_accepts));
@@ -1486,7 +1549,7 @@ void *HttpWorker(void *arg) {
     ip = ntohl(w->addr.sin_addr.s_addr);
     if (!IsLoopbackIp(ip) &&  //
         !ContainsInt(&g_whitelisted, ip) &&
-        (tok = AcquireToken(g_tok.b, ip, TB_CIDR)) < 4) {
+        (tok = AcquireToken4(g_tok, ip, timespec_mono_coarse())) < 4) {
       Blackhole(ip);
       IncrementCounter(&g_banned);
       IncrementCounter(&g_ratelimits);
@@ -1533,7 +1596,7 @@ void *HttpWorker(void *arg) {
       if (w->msgcount > 1 &&    //
           !IsLoopbackIp(ip) &&  //
           !ContainsInt(&g_whitelisted, ip) &&
-          (tok = AcquireToken(g_tok.b, ip, TB_CIDR)) < 32) {
+          (tok = AcquireToken4(g_tok, ip, timespec_mono_coarse())) < 32) {
         if (tok > 4) {
           LOG("%s rate limiting client\n", ipbuf, msg->version);
           WriteStr(w, "HTTP/1.1 429 Too Many Requests\r\n"
@@ -1615,19 +1678,21 @@ void *HttpWorker(void *arg) {
 
       // wait for server initialization
       while (a)
-        if (a->ready)
+        if (atomic_load_explicit(&a->current, memory_order_relaxed))
           break;
 
       // assert serving
       if (a) {
+        struct Version *ver;
         struct iovec iov[2];
         IncrementCounter(&g_assetrequests);
-        comp = a->gzip.n < a->data.n &&
-               HeaderHas(msg, inbuf, kHttpAcceptEncoding, "gzip", 4);
         ////////////////////////////////////////
-        pthread_rwlock_rdlock(&a->lock);
+        w->epoch = g_epoch;
+        ver = atomic_load(&a->current);
+        comp = ver->gzip.n < ver->data.n &&
+               HeaderHas(msg, inbuf, kHttpAcceptEncoding, "gzip", 4);
         if (HasHeader(kHttpIfModifiedSince) &&
-            a->mtim.tv_sec <=
+            ver->mtim.tv_sec <=
                 ParseHttpDateTime(HeaderData(kHttpIfModifiedSince),
                                   HeaderLength(kHttpIfModifiedSince))) {
           p = stpcpy(outbuf,
@@ -1638,12 +1703,12 @@ void *HttpWorker(void *arg) {
           if (must_close)
             p = stpcpy(p, "\r\nConnection: close");
           p = stpcpy(p, "\r\nLast-Modified: ");
-          p = stpcpy(p, a->lastmodified);
+          p = stpcpy(p, ver->lastmodified);
           p = stpcpy(p, "\r\nContent-Type: ");
-          p = stpcpy(p, a->type);
+          p = stpcpy(p, ver->type);
           p = stpcpy(p, "\r\nCache-Control: ");
           ksnprintf(cashbuf, sizeof(cashbuf), "max-age=%d, must-revalidate",
-                    a->cash);
+                    ver->cash);
           p = stpcpy(p, cashbuf);
           p = stpcpy(p, "\r\n\r\n");
           outmsglen = p - outbuf;
@@ -1656,17 +1721,17 @@ void *HttpWorker(void *arg) {
           if (must_close)
             p = stpcpy(p, "\r\nConnection: close");
           p = stpcpy(p, "\r\nLast-Modified: ");
-          p = stpcpy(p, a->lastmodified);
+          p = stpcpy(p, ver->lastmodified);
           p = stpcpy(p, "\r\nContent-Type: ");
-          p = stpcpy(p, a->type);
+          p = stpcpy(p, ver->type);
           p = stpcpy(p, "\r\nCache-Control: ");
           ksnprintf(cashbuf, sizeof(cashbuf), "max-age=%d, must-revalidate",
-                    a->cash);
+                    ver->cash);
           p = stpcpy(p, cashbuf);
           if (comp)
             p = stpcpy(p, "\r\nContent-Encoding: gzip");
           p = stpcpy(p, "\r\nContent-Length: ");
-          d = comp ? a->gzip : a->data;
+          d = comp ? ver->gzip : ver->data;
           p = FormatInt32(p, d.n);
           p = stpcpy(p, "\r\n\r\n");
           iov[0].iov_base = outbuf;
@@ -1676,7 +1741,7 @@ void *HttpWorker(void *arg) {
           outmsglen = iov[0].iov_len + iov[1].iov_len;
           sent = Writev(w, iov, 2);
         }
-        pthread_rwlock_unlock(&a->lock);
+        atomic_store_explicit(&w->epoch, 0, memory_order_release);
         ////////////////////////////////////////
 
       } else if (UrlStartsWith("/ip")) {
@@ -1896,70 +1961,112 @@ struct Data Gzip(struct Data data) {
   return res;
 }
 
+void FreeVersion(struct Version *v) {
+  if (v) {
+    free(v->data.p);
+    free(v->gzip.p);
+    free(v);
+  }
+}
+
+// atomically replaces current version of asset
+//
+// http workers serve assets without taking any locks. each one sets
+// its struct Worker epoch to the global epoch before it loads the
+// pointer, and clears it once the response is written. the version
+// being replaced is therefore tagged with the epoch at the time of
+// the swap, and it can be freed as soon as no worker is reading with
+// an epoch that old, which Reclaim() checks from time to time
+void Publish(struct Asset *a, struct Version *v) {
+  struct Version *old;
+  if ((old = atomic_exchange(&a->current, v))) {
+    old->retired = atomic_fetch_add(&g_epoch, 1);
+    old->next = atomic_load_explicit(&g_retired, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(
+        &g_retired, &old->next, old, memory_order_release,
+        memory_order_relaxed)) {
+    }
+  }
+}
+
+// frees retired asset versions whose grace period has elapsed
+// the force flag may be passed once http workers have been joined
+void Reclaim(bool force) {
+  long e, oldest;
+  struct Version *v, *next, **pp;
+  for (v = atomic_exchange_explicit(&g_retired, 0, memory_order_acquire); v;
+       v = next) {
+    next = v->next;
+    v->next = g_retiring;
+    g_retiring = v;
+  }
+  oldest = LONG_MAX;
+  if (!force)
+    for (int i = 0; i < g_workers; ++i)
+      if ((e = g_worker[i].epoch) && e < oldest)
+        oldest = e;
+  for (pp = &g_retiring; (v = *pp);) {
+    if (v->retired < oldest) {
+      *pp = v->next;
+      FreeVersion(v);
+    } else {
+      pp = &v->next;
+    }
+  }
+}
+
 // slurps asset off disk once during startup
-struct Asset LoadAsset(const char *path, const char *type, int cash) {
+void LoadAsset(struct Asset *a, const char *path, const char *type,
+               int cash) {
   struct stat st;
-  struct Asset a = {0};
-  pthread_rwlock_init(&a.lock, 0);
+  struct Version *v;
+  npassert((v = calloc(1, sizeof(*v))));
   npassert(!stat(path, &st));
-  npassert((a.data.p = xslurp(path, &a.data.n)));
-  a.type = type;
-  a.cash = cash;
-  npassert((a.path = strdup(path)));
-  a.mtim = st.st_mtim;
-  npassert((a.gzip = Gzip(a.data)).p);
-  FormatUnixHttpDateTime(a.lastmodified, a.mtim.tv_sec);
-  a.ready = true;
-  return a;
+  npassert((v->data.p = xslurp(path, &v->data.n)));
+  v->type = type;
+  v->cash = cash;
+  npassert((a->path = strdup(path)));
+  v->mtim = st.st_mtim;
+  npassert((v->gzip = Gzip(v->data)).p);
+  FormatUnixHttpDateTime(v->lastmodified, v->mtim.tv_sec);
+  Publish(a, v);
 }
 
 // reslurps asset off disk if its mtim changed
 bool ReloadAsset(struct Asset *a) {
   int fd;
-  void *f[2];
   ssize_t rc;
   struct stat st;
-  char lastmodified[32];
-  struct Data data = {0};
-  struct Data gzip = {0};
+  struct Version *v = 0;
+  // only the supervisor publishes these, so this can't be reclaimed
+  struct Version *cur = atomic_load_explicit(&a->current, memory_order_relaxed);
   CHECK_SYS((fd = open(a->path, O_RDONLY)));
   CHECK_SYS(fstat(fd, &st));
-  if (timespec_cmp(st.st_mtim, a->mtim) > 0) {
-    FormatUnixHttpDateTime(lastmodified, st.st_mtim.tv_sec);
-    CHECK_MEM((data.p = malloc(st.st_size)));
-    CHECK_SYS((rc = read(fd, data.p, st.st_size)));
-    data.n = st.st_size;
+  if (timespec_cmp(st.st_mtim, cur->mtim) > 0) {
+    CHECK_MEM((v = calloc(1, sizeof(*v))));
+    v->type = cur->type;
+    v->cash = cur->cash;
+    v->mtim = st.st_mtim;
+    FormatUnixHttpDateTime(v->lastmodified, st.st_mtim.tv_sec);
+    CHECK_MEM((v->data.p = malloc(st.st_size)));
+    CHECK_SYS((rc = read(fd, v->data.p, st.st_size)));
+    v->data.n = st.st_size;
     if (rc != st.st_size)
       goto OnError;
-    CHECK_MEM((gzip = Gzip(data)).p);
-    //!//!//!//!//!//!//!//!//!//!//!//!//!/
-    pthread_rwlock_wrlock(&a->lock);
-    f[0] = a->data.p;
-    f[1] = a->gzip.p;
-    a->data = data;
-    a->gzip = gzip;
-    a->mtim = st.st_mtim;
-    memcpy(a->lastmodified, lastmodified, 32);
-    pthread_rwlock_unlock(&a->lock);
-    //!//!//!//!//!//!//!//!//!//!//!//!//!/
-    a->ready = true;
-    free(f[0]);
-    free(f[1]);
+    CHECK_MEM((v->gzip = Gzip(v->data)).p);
+    Publish(a, v);
   }
   close(fd);
   return true;
 OnError:
-  free(data.p);
-  free(gzip.p);
+  FreeVersion(v);
   close(fd);
   return false;
 }
 
 void FreeAsset(struct Asset *a) {
-  pthread_rwlock_destroy(&a->lock);
   free(a->path);
-  free(a->data.p);
-  free(a->gzip.p);
+  FreeVersion(atomic_exchange(&a->current, 0));
 }
 
 void OnCtrlC(int sig) {
@@ -2017,131 +2124,351 @@ void GetOpts(int argc, char *argv[]) {
 }
 
 // atomically swaps out asset with newer version
-void Update(struct Asset *a, bool gen(struct Asset *, long, long), long x,
+void Update(struct Asset *a, bool gen(struct Version *, long, long), long x,
             long y) {
-  struct Asset t;
+  struct Version *v;
+  pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, 0);
+  if ((v = calloc(1, sizeof(*v)))) {
+    if (gen(v, x, y)) {
+      Publish(a, v);
+    } else {
+      free(v);
+    }
+  }
+  pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, 0);
+}
 
-  // serialize report operations
-  if (g_online)
-    pthread_mutex_lock(&report_lock);
-  pthread_cleanup_push(unlock_mutex, g_online ? &report_lock : 0);
+static size_t HashBoardKey(uint64_t x) {
+  return (x * 0x9e3779b97f4a7c15) >> 32;
+}
 
-  if (g_online) {
-    // wait until after the next checkpoint
-    long cc = g_checkpoint_count;
-    pthread_mutex_lock(&checkpoint_lock);
-    pthread_cleanup_push(unlock_mutex, &checkpoint_lock);
-    while (g_checkpoint_count == cc)
-      pthread_cond_wait(&checkpoint_cond, &checkpoint_lock);
-    pthread_cleanup_pop(true);
+// returns nick id of name, or zero if out of memory
+static int InternNick(struct Board *b, const char *s) {
+  void *p;
+  int *slot;
+  size_t i, j, c, mask;
+  struct Nicks *t = &b->nicks;
+  if (t->n + 1 >= t->c) {
+    c = t->c ? t->c << 1 : 256;
+    if (!(p = realloc(t->name, c * sizeof(*t->name))))
+      goto OnError;
+    t->name = p;
+    t->c = c;
   }
+  if ((t->n + 1) * 4 >= (t->mask + 1) * 3) {
+    mask = t->mask ? t->mask << 1 | 1 : 255;
+    if (!(slot = calloc(mask + 1, sizeof(*slot))))
+      goto OnError;
+    for (i = 1; i <= t->n; ++i) {
+      j = crc32c(0, t->name[i], strlen(t->name[i])) & mask;
+      while (slot[j])
+        j = (j + 1) & mask;
+      slot[j] = i;
+    }
+    free(t->slot);
+    t->slot = slot;
+    t->mask = mask;
+  }
+  for (i = crc32c(0, s, strlen(s)) & t->mask; t->slot[i];
+       i = (i + 1) & t->mask) {
+    if (!strcmp(t->name[t->slot[i]], s))
+      return t->slot[i];
+  }
+  strlcpy(t->name[++t->n], s, sizeof(*t->name));
+  return t->slot[i] = t->n;
+OnError:
+  b->stale = true;
+  return 0;
+}
 
-  pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, 0);
-  if (gen(&t, x, y)) {
-    void *f[2];
-    //!//!//!//!//!//!//!//!//!//!//!//!//!/
-    pthread_rwlock_wrlock(&a->lock);
-    f[0] = a->data.p;
-    f[1] = a->gzip.p;
-    a->data = t.data;
-    a->gzip = t.gzip;
-    a->mtim = t.mtim;
-    a->type = t.type;
-    a->cash = t.cash;
-    memcpy(a->lastmodified, t.lastmodified, 32);
-    pthread_rwlock_unlock(&a->lock);
-    //!//!//!//!//!//!//!//!//!//!//!//!//!/
-    a->ready = true;
-    free(f[0]);
-    free(f[1]);
+// returns owner of ip, which has nick zero if it was just created
+static struct Owner *GetOwner(struct Board *b, uint32_t ip) {
+  size_t i, j, mask;
+  struct Owner *p;
+  struct Owners *t = &b->owners;
+  if ((t->n + 1) * 4 >= (t->mask + 1) * 3) {
+    mask = t->mask ? t->mask << 1 | 1 : 4095;
+    if (!(p = calloc(mask + 1, sizeof(*p)))) {
+      b->stale = true;
+      return 0;
+    }
+    for (i = 0; t->p && i <= t->mask; ++i) {
+      if (t->p[i].nick) {
+        for (j = HashBoardKey(t->p[i].ip) & mask; p[j].nick;
+             j = (j + 1) & mask) {
+        }
+        p[j] = t->p[i];
+      }
+    }
+    free(t->p);
+    t->p = p;
+    t->mask = mask;
   }
-  pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, 0);
+  for (i = HashBoardKey(ip) & t->mask; t->p[i].nick; i = (i + 1) & t->mask)
+    if (t->p[i].ip == ip)
+      return t->p + i;
+  t->p[i].ip = ip;
+  t->p[i].event = -1;
+  ++t->n;
+  return t->p + i;
+}
+
+// adds delta to the count of land nick holds in ip's /8
+static void AddTally(struct Board *b, int w, int nick, uint32_t ip,
+                     long delta) {
+  uint64_t key;
+  size_t i, j, mask;
+  struct TallySlot *p;
+  struct Tally *t = b->tally + w;
+  if ((t->n + 1) * 4 >= (t->mask + 1) * 3) {
+    mask = t->mask ? t->mask << 1 | 1 : 255;
+    if (!(p = calloc(mask + 1, sizeof(*p)))) {
+      b->stale = true;
+      return;
+    }
+    for (i = 0; t->p && i <= t->mask; ++i) {
+      if (t->p[i].key) {
+        for (j = HashBoardKey(t->p[i].key) & mask; p[j].key;
+             j = (j + 1) & mask) {
+        }
+        p[j] = t->p[i];
+      }
+    }
+    free(t->p);
+    t->p = p;
+    t->mask = mask;
+  }
+  key = (uint64_t)nick << 8 | ip >> 24;
+  for (i = HashBoardKey(key) & t->mask; t->p[i].key && t->p[i].key != key;
+       i = (i + 1) & t->mask) {
+  }
+  if (!t->p[i].key) {
+    t->p[i].key = key;
+    ++t->n;
+  }
+  t->p[i].count += delta;
+}
+
+// records ip changing hands, in time windows too if created isn't -1
+static void MoveLand(struct Board *b, uint32_t ip, const char *name,
+                     int64_t created) {
+  int w, nick;
+  struct Owner *o;
+  struct Events *q = &b->events;
+  if (!(nick = InternNick(b, name)) || !(o = GetOwner(b, ip)))
+    return;
+  if (o->nick) {
+    AddTally(b, BOARD_ALL, o->nick, ip, -1);
+    if (o->event != -1)
+      for (w = BOARD_HOUR; w < BOARD_WINDOWS; ++w)
+        if (o->event >= b->cursor[w])
+          AddTally(b, w, o->nick, ip, -1);
+  }
+  o->nick = nick;
+  o->event = -1;
+  AddTally(b, BOARD_ALL, nick, ip, +1);
+  if (created == -1)
+    return;
+  if (q->n == q->c) {
+    void *p;
+    size_t c = q->c ? q->c << 1 : 4096;
+    if (!(p = realloc(q->p, c * sizeof(*q->p)))) {
+      b->stale = true;
+      return;
+    }
+    q->p = p;
+    q->c = c;
+  }
+  q->p[q->n] = (struct Event){ip, nick, created};
+  o->event = q->base + q->n++;
+  for (w = BOARD_HOUR; w < BOARD_WINDOWS; ++w)
+    AddTally(b, w, nick, ip, +1);
+}
+
+// slides time windows forward, uncounting land claimed too long ago
+static void ExpireBoard(struct Board *b, int64_t now) {
+  int w;
+  size_t drop;
+  struct Event *e;
+  struct Owner *o;
+  struct Events *q = &b->events;
+  for (w = BOARD_HOUR; w < BOARD_WINDOWS; ++w) {
+    for (; b->cursor[w] < q->base + (int64_t)q->n; ++b->cursor[w]) {
+      e = q->p + (b->cursor[w] - q->base);
+      if (e->created >= now - kBoardWindow[w])
+        break;
+      if (!(o = GetOwner(b, e->ip)) || o->event != b->cursor[w])
+        continue;  // superseded by a later claim
+      AddTally(b, w, e->nick, e->ip, -1);
+      if (w == BOARD_MONTH)
+        o->event = -1;
+    }
+  }
+  // forget events that even the widest window no longer counts
+  if ((drop = b->cursor[BOARD_MONTH] - q->base) > q->n / 2) {
+    memmove(q->p, q->p + drop, (q->n - drop) * sizeof(*q->p));
+    q->base += drop;
+    q->n -= drop;
+  }
+}
 
-  // release report lock
-  pthread_cleanup_pop(true);
+void FreeBoard(struct Board *b) {
+  int w;
+  free(b->nicks.slot);
+  free(b->nicks.name);
+  free(b->owners.p);
+  free(b->events.p);
+  for (w = 0; w < BOARD_WINDOWS; ++w)
+    free(b->tally[w].p);
+  b->stale = false;
+  bzero(&b->nicks, sizeof(b->nicks));
+  bzero(&b->owners, sizeof(b->owners));
+  bzero(&b->events, sizeof(b->events));
+  bzero(b->cursor, sizeof(b->cursor));
+  bzero(b->tally, sizeof(b->tally));
+}
+
+// scans the land table into the leaderboard, which must be locked
+bool LoadBoard(struct Board *b) {
+  int rc;
+  sqlite3 *db = 0;
+  const char *text;
+  sqlite3_stmt *stmt = 0;
+  int64_t now = timespec_real().tv_sec;
+  FreeBoard(b);
+  CHECK_SQL(DbOpen("db.sqlite3", &db));
+  CHECK_SQL(sqlite3_exec(db, "BEGIN TRANSACTION", 0, 0, 0));
+  CHECK_DB(DbPrepare(db, &stmt,
+                     "SELECT ip, nick\n"
+                     "FROM land\n"
+                     "WHERE created IS NULL\n"
+                     "   OR created < ?1"));
+  CHECK_DB(sqlite3_bind_int64(stmt, 1, now - kBoardWindow[BOARD_MONTH]));
+  while ((rc = DbStep(stmt)) != SQLITE_DONE) {
+    if (rc != SQLITE_ROW)
+      CHECK_DB(rc);
+    if ((text = (const char *)sqlite3_column_text(stmt, 1)))
+      MoveLand(b, sqlite3_column_int64(stmt, 0), text, -1);
+  }
+  CHECK_DB(sqlite3_finalize(stmt));
+  CHECK_DB(DbPrepare(db, &stmt,
+                     "SELECT ip, nick, created\n"
+                     "FROM land\n"
+                     "WHERE created NOT NULL\n"
+                     "  AND created >= ?1\n"
+                     "ORDER BY created"));
+  CHECK_DB(sqlite3_bind_int64(stmt, 1, now - kBoardWindow[BOARD_MONTH]));
+  while ((rc = DbStep(stmt)) != SQLITE_DONE) {
+    if (rc != SQLITE_ROW)
+      CHECK_DB(rc);
+    if ((text = (const char *)sqlite3_column_text(stmt, 1)))
+      MoveLand(b, sqlite3_column_int64(stmt, 0), text,
+               sqlite3_column_int64(stmt, 2));
+  }
+  CHECK_SQL(sqlite3_exec(db, "END TRANSACTION", 0, 0, 0));
+  CHECK_DB(sqlite3_finalize(stmt));
+  CHECK_SQL(sqlite3_close(db));
+  ExpireBoard(b, now);
+  LOG("%H loaded %'zu plots of land owned by %'zu nicks\n", b->owners.n,
+      b->nicks.n);
+  return !b->stale;
+OnError:
+  sqlite3_finalize(stmt);
+  sqlite3_close(db);
+  b->stale = true;
+  return false;
+}
+
+struct Score {
+  int nick, octet;
+  long count;
+};
+
+static int CompareScores(const void *x, const void *y, void *arg) {
+  int c;
+  const struct Score *a = x, *b = y;
+  char(*name)[NICK_MAX + 1] = arg;
+  if (a->nick != b->nick && (c = strcmp(name[a->nick], name[b->nick])))
+    return c;
+  return a->octet - b->octet;
 }
 
 // generator function for the big board
-bool GenerateScore(struct Asset *out, long secs, long cash) {
-  int rc;
+bool GenerateScore(struct Version *out, long window, long cash) {
+  int last = 0;
   char *sb = 0;
-  sqlite3 *db = 0;
+  size_t i, n;
+  struct Tally *t;
   size_t sblen = 0;
-  struct Asset a = {0};
-  sqlite3_stmt *stmt = 0;
-  bool namestate = false;
-  char name1[NICK_MAX + 1] = {0};
-  char name2[NICK_MAX + 1];
-  DEBUG("GenerateScore %ld\n", secs);
+  bool locked = false;
+  const char *name;
+  struct Version a = {0};
+  struct Score *v = 0;
+  struct Board *b = &g_board;
+  DEBUG("GenerateScore %ld\n", window);
   a.type = "application/json";
   a.cash = cash;
+  pthread_mutex_lock(&b->mu);
+  locked = true;
+  if (b->stale) {
+    LOG("%H reloading scoreboard...\n");
+    if (!LoadBoard(b))
+      goto OnError;
+  }
   a.mtim = timespec_real();
   FormatUnixHttpDateTime(a.lastmodified, a.mtim.tv_sec);
+  ExpireBoard(b, a.mtim.tv_sec);
+  t = b->tally + window;
+  CHECK_MEM((v = malloc((t->n + 1) * sizeof(*v))));
+  for (n = i = 0; t->p && i <= t->mask; ++i)
+    if (t->p[i].count > 0)
+      v[n++] = (struct Score){t->p[i].key >> 8, t->p[i].key & 255,
+                              t->p[i].count};
+  qsort_r(v, n, sizeof(*v), CompareScores, b->nicks.name);
   CHECK_SYS(appends(&a.data.p, "{\n"));
   CHECK_SYS(appendf(&a.data.p, "\"now\":[%ld,%ld],\n", a.mtim.tv_sec,
                     a.mtim.tv_nsec));
   CHECK_SYS(appends(&a.data.p, "\"score\":{\n"));
-  CHECK_SQL(DbOpen("db.sqlite3", &db));
-  if (secs == -1) {
-    CHECK_DB(DbPrepare(db, &stmt,
-                       "SELECT nick, (ip >> 24), COUNT(*)\n"
-                       "FROM land\n"
-                       "GROUP BY nick, (ip >> 24)"));
-  } else {
-    CHECK_DB(DbPrepare(db, &stmt,
-                       "SELECT nick, (ip >> 24), COUNT(*)\n"
-                       " FROM land\n"
-                       "WHERE created NOT NULL\n"
-                       "  AND created >= ?1\n"
-                       "GROUP BY nick, (ip >> 24)"));
-    CHECK_DB(sqlite3_bind_int64(stmt, 1, a.mtim.tv_sec - secs));
-  }
-  // be sure to always use transactions with sqlite as in always
-  // otherwise.. you can use --strace to see the fcntl bloodbath
-  CHECK_SQL(sqlite3_exec(db, "BEGIN TRANSACTION", 0, 0, 0));
-  while ((rc = DbStep(stmt)) != SQLITE_DONE) {
-    if (rc != SQLITE_ROW)
-      CHECK_DB(rc);
-    strlcpy(name2, (void *)sqlite3_column_text(stmt, 0), sizeof(name2));
-    if (!IsValidNick(name2, -1))
+  for (i = 0; i < n; ++i) {
+    name = b->nicks.name[v[i].nick];
+    if (!IsValidNick(name, -1))
       continue;
-    if (strcmp(name1, name2)) {
+    if (v[i].nick != last) {
       // name changed
-      if (namestate)
+      if (last)
         CHECK_SYS(appends(&a.data.p, "],\n"));
-      namestate = true;
-      CHECK_SYS(appendf(
-          &a.data.p, "\"%s\":[\n",
-          EscapeJsStringLiteral(&sb, &sblen, strcpy(name1, name2), -1, 0)));
+      last = v[i].nick;
+      CHECK_SYS(appendf(&a.data.p, "\"%s\":[\n",
+                        EscapeJsStringLiteral(&sb, &sblen, name, -1, 0)));
     } else {
       // name repeated
       CHECK_SYS(appends(&a.data.p, ",\n"));
     }
-    CHECK_SYS(appendf(&a.data.p, "  [%ld,%ld]", sqlite3_column_int64(stmt, 1),
-                      sqlite3_column_int64(stmt, 2)));
+    CHECK_SYS(appendf(&a.data.p, "  [%d,%ld]", v[i].octet, v[i].count));
   }
-  CHECK_SQL(sqlite3_exec(db, "END TRANSACTION", 0, 0, 0));
-  if (namestate)
+  pthread_mutex_unlock(&b->mu);
+  locked = false;
+  if (last)
     CHECK_SYS(appends(&a.data.p, "]\n"));
   CHECK_SYS(appends(&a.data.p, "}}\n"));
-  CHECK_DB(sqlite3_finalize(stmt));
-  CHECK_SQL(sqlite3_close(db));
   a.data.n = appendz(a.data.p).i;
   a.gzip = Gzip(a.data);
   free(sb);
+  free(v);
   *out = a;
   return true;
 OnError:
-  sqlite3_finalize(stmt);
-  sqlite3_close(db);
+  if (locked)
+    pthread_mutex_unlock(&b->mu);
   free(a.data.p);
   free(sb);
+  free(v);
   return false;
 }
 
 void *GenerateScoreAllTime(void *arg) {
   LOG("%H regenerating score...\n");
-  Update(&g_asset.score, GenerateScore, -1, MS2CASH(SCORE_UPDATE_MS));
+  Update(&g_asset.score, GenerateScore, BOARD_ALL, MS2CASH(SCORE_UPDATE_MS));
   return 0;
 }
 
@@ -2156,7 +2483,7 @@ void *ScoreWorker(void *arg) {
 
 void *GenerateScoreHour(void *arg) {
   LOG("%H regenerating hour score...\n");
-  Update(&g_asset.score_hour, GenerateScore, 60L * 60,
+  Update(&g_asset.score_hour, GenerateScore, BOARD_HOUR,
          MS2CASH(SCORE_H_UPDATE_MS));
   return 0;
 }
@@ -2172,7 +2499,7 @@ void *ScoreHourWorker(void *arg) {
 
 void *GenerateScoreDay(void *arg) {
   LOG("%H regenerating day score...\n");
-  Update(&g_asset.score_day, GenerateScore, 60L * 60 * 24,
+  Update(&g_asset.score_day, GenerateScore, BOARD_DAY,
          MS2CASH(SCORE_D_UPDATE_MS));
   return 0;
 }
@@ -2188,7 +2515,7 @@ void *ScoreDayWorker(void *arg) {
 
 void *GenerateScoreWeek(void *arg) {
   LOG("%H regenerating week score...\n");
-  Update(&g_asset.score_week, GenerateScore, 60L * 60 * 24 * 7,
+  Update(&g_asset.score_week, GenerateScore, BOARD_WEEK,
          MS2CASH(SCORE_W_UPDATE_MS));
   return 0;
 }
@@ -2204,7 +2531,7 @@ void *ScoreWeekWorker(void *arg) {
 
 void *GenerateScoreMonth(void *arg) {
   LOG("%H regenerating month score...\n");
-  Update(&g_asset.score_month, GenerateScore, 60L * 60 * 24 * 30,
+  Update(&g_asset.score_month, GenerateScore, BOARD_MONTH,
          MS2CASH(SCORE_M_UPDATE_MS));
   return 0;
 }
@@ -2226,7 +2553,7 @@ void InitRecent(void) {
   size_t sblen = 0;
   const char *text;
   sqlite3_stmt *stmt = 0;
-  struct Asset *a, t = {0};
+  struct Version *v, t = {0};
   CHECK_SQL(DbOpen("db.sqlite3", &db));
   CHECK_DB(DbPrepare(db, &stmt,
                      "SELECT ip, nick, created\n"
@@ -2259,18 +2586,10 @@ void InitRecent(void) {
   t.data.n = appendz(t.data.p).i;
   CHECK_MEM((t.gzip = Gzip(t.data)).p);
   // deploy json
-  a = &g_asset.recent;
-  //!//!//!//!//!//!//!//!//!//!//!//!//!/
-  pthread_rwlock_wrlock(&a->lock);
-  a->data = t.data;
-  a->gzip = t.gzip;
-  a->mtim = t.mtim;
-  a->type = "application/json";
-  a->cash = 0;
-  memcpy(a->lastmodified, t.lastmodified, 32);
-  pthread_rwlock_unlock(&a->lock);
-  //!//!//!//!//!//!//!//!//!//!//!//!//!/
-  a->ready = true;
+  t.type = "application/json";
+  CHECK_MEM((v = malloc(sizeof(*v))));
+  *v = t;
+  Publish(&g_asset.recent, v);
   sqlite3_finalize(stmt);
   sqlite3_close(db);
   free(sb);
@@ -2283,17 +2602,17 @@ OnError:
 // this helps us avoid over 9000 threads having fcntl bloodbath
 void *ClaimWorker(void *arg) {
   bool once;
-  void *f[2];
   sqlite3 *db;
   int i, n, rc;
   char *sb = 0;
   size_t sblen = 0;
   const char *text;
   sqlite3_stmt *stmt;
-  struct Asset *a, t = {0};
+  struct Version *ver, t = {0};
   sqlite3_stmt *recent_stmt;
   struct timespec last_checkpoint = timespec_real();
   struct Claim *v = gc(calloc(BATCH_MAX, sizeof(struct Claim)));
+  bool *moved = gc(calloc(BATCH_MAX, sizeof(bool)));
   pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, 0);
   pthread_setname_np(pthread_self(), "ClaimWorker");
 StartOver:
@@ -2315,12 +2634,14 @@ StartOver:
                      "ORDER BY created DESC\n"
                      "LIMIT 50"));
   while ((n = GetClaims(&g_claims, v, BATCH_MAX))) {
+    struct timespec started = timespec_mono();
     CHECK_SQL(sqlite3_exec(db, "BEGIN TRANSACTION", 0, 0, 0));
     for (i = 0; i < n; ++i) {
       CHECK_DB(sqlite3_bind_int64(stmt, 1, v[i].ip));
       CHECK_DB(sqlite3_bind_text(stmt, 2, v[i].name, -1, SQLITE_TRANSIENT));
       CHECK_DB(sqlite3_bind_int64(stmt, 3, v[i].created));
       CHECK_DB((rc = DbStep(stmt)) == SQLITE_DONE ? SQLITE_OK : rc);
+      moved[i] = sqlite3_changes(db) > 0;
       CHECK_DB(sqlite3_reset(stmt));
     }
     CHECK_SQL(sqlite3_exec(db, "COMMIT TRANSACTION", 0, 0, 0));
@@ -2328,6 +2649,18 @@ StartOver:
     AddCounter(&g_claimsprocessed, n);
     g_lastbatchsize = n;
     ++g_batches;
+    long micros = timespec_tomicros(timespec_sub(timespec_mono(), started));
+    g_lastcommitmicros = micros;
+    g_commitmicros += micros;
+    if (micros > g_maxcommitmicros)
+      g_maxcommitmicros = micros;
+
+    // apply the rows that changed hands to the leaderboard
+    pthread_mutex_lock(&g_board.mu);
+    for (i = 0; i < n; ++i)
+      if (moved[i])
+        MoveLand(&g_board, v[i].ip, v[i].name, v[i].created);
+    pthread_mutex_unlock(&g_board.mu);
 
     // regenerate /recent json
     t.mtim = timespec_real();
@@ -2355,23 +2688,11 @@ StartOver:
     t.data.n = appendz(t.data.p).i;
     CHECK_MEM((t.gzip = Gzip(t.data)).p);
     // deploy json
-    a = &g_asset.recent;
-    //!//!//!//!//!//!//!//!//!//!//!//!//!/
-    pthread_rwlock_wrlock(&a->lock);
-    f[0] = a->data.p;
-    f[1] = a->gzip.p;
-    a->data = t.data;
-    a->gzip = t.gzip;
-    a->mtim = t.mtim;
-    a->type = "application/json";
-    a->cash = 0;
-    memcpy(a->lastmodified, t.lastmodified, 32);
-    pthread_rwlock_unlock(&a->lock);
-    //!//!//!//!//!//!//!//!//!//!//!//!//!/
-    a->ready = true;
+    t.type = "application/json";
+    CHECK_MEM((ver = malloc(sizeof(*ver))));
+    *ver = t;
+    Publish(&g_asset.recent, ver);
     bzero(&t, sizeof(t));
-    free(f[0]);
-    free(f[1]);
 
     // force database checkpoint
     struct timespec now = timespec_real();
@@ -2383,26 +2704,13 @@ StartOver:
       if (rc == SQLITE_OK) {
         g_walpages = ckpt_log;
         g_walprocessed = ckpt_ckpt;
-        if (ckpt_log == ckpt_ckpt) {
-          // if the write ahead log successfully flushed then the
-          // background scoreboard generating threads may proceed
-          pthread_mutex_lock(&checkpoint_lock);
+        if (ckpt_log == ckpt_ckpt)
           ++g_checkpoint_count;
-          pthread_cond_signal(&checkpoint_cond);
-          pthread_mutex_unlock(&checkpoint_lock);
-        }
       } else {
         IncrementCounter(&g_checkpointfails);
       }
       last_checkpoint = timespec_real();
     }
-
-    // don't go too fast
-    if (!is_shutting_down) {
-      pthread_setcancelstate(PTHREAD_CANCEL_MASKED, 0);
-      usleep(CLAIM_BATCH_MS * 1000);
-      pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, 0);
-    }
   }
   CHECK_DB(sqlite3_finalize(recent_stmt));
   CHECK_DB(sqlite3_finalize(stmt));
@@ -2416,17 +2724,6 @@ OnError:
   goto StartOver;
 }
 
-// worker for refilling token buckets
-void *ReplenishWorker(void *arg) {
-  pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, 0);
-  pthread_setname_np(pthread_self(), "Replenisher");
-  for (struct timespec ts = timespec_real();;
-       ts = timespec_add(ts, timespec_frommillis(TB_INTERVAL))) {
-    clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &ts, 0);
-    ReplenishTokens(g_tok.w, TB_WORDS);
-  }
-}
-
 void SpawnWorker(intptr_t i) {
   sigset_t thmask;
   pthread_attr_t attr;
@@ -2483,6 +2780,9 @@ void *Supervisor(void *arg) {
     ReloadAsset(&g_asset.user);
     ReloadAsset(&g_asset.favicon);
 
+    // free old versions of assets nobody is reading anymore
+    Reclaim(false);
+
     // check if server is about to explode
     if (g_workers > 1 &&
         1. / g_workers * GetCounter(&g_connections) > PANIC_LOAD)
@@ -2781,16 +3081,13 @@ int main(int argc, char *argv[]) {
   pthread_attr_setsigaltstacksize_np(&attr, sysconf(_SC_MINSIGSTKSZ) + 32768);
 
   // generate scoreboards
-  npassert(!pthread_create(&scorer, &attr, GenerateScoreAllTime, 0));
-  npassert(!pthread_create(&scorer_hour, &attr, GenerateScoreHour, 0));
-  npassert(!pthread_create(&scorer_day, &attr, GenerateScoreDay, 0));
-  npassert(!pthread_create(&scorer_week, &attr, GenerateScoreWeek, 0));
-  npassert(!pthread_create(&scorer_month, &attr, GenerateScoreMonth, 0));
-  npassert(!pthread_join(scorer, 0));
-  npassert(!pthread_join(scorer_hour, 0));
-  npassert(!pthread_join(scorer_day, 0));
-  npassert(!pthread_join(scorer_week, 0));
-  npassert(!pthread_join(scorer_month, 0));
+  LOG("%H loading scoreboard...\n");
+  npassert(LoadBoard(&g_board));
+  GenerateScoreAllTime(0);
+  GenerateScoreHour(0);
+  GenerateScoreDay(0);
+  GenerateScoreWeek(0);
+  GenerateScoreMonth(0);
 
   // create server sockets
   Listen();
@@ -2828,9 +3125,13 @@ int main(int argc, char *argv[]) {
     npassert(2 == open("turfwar.log", O_CREAT | O_WRONLY | O_APPEND, 0644));
   }
 
-  // fill token buckets
-  g_tok.b = malloc(TB_BYTES);
-  memset(g_tok.b, 127, TB_BYTES);
+  // create claims queue
+  npassert(!mpsc_init(&g_claims, QUEUE_MAX, sizeof(struct Claim)));
+
+  // create token buckets, which refill themselves lazily
+  unassert((g_tok = malloc(GetTokenBucketsSize(TB_CLIENTS))));
+  InitTokenBuckets(g_tok, TB_CLIENTS, TB_CIDR, 64,
+                   timespec_frommillis(TB_INTERVAL));
 
   // server lifecycle locks
   g_started = timespec_real();
@@ -2838,10 +3139,11 @@ int main(int argc, char *argv[]) {
   // load static assets into memory and pre-zip them
   update_time();
   InitRecent();
-  g_asset.index = LoadAsset("index.html", "text/html; charset=utf-8", 900);
-  g_asset.about = LoadAsset("about.html", "text/html; charset=utf-8", 900);
-  g_asset.user = LoadAsset("user.html", "text/html; charset=utf-8", 900);
-  g_asset.favicon = LoadAsset("favicon.ico", "image/vnd.microsoft.icon", 86400);
+  LoadAsset(&g_asset.index, "index.html", "text/html; charset=utf-8", 900);
+  LoadAsset(&g_asset.about, "about.html", "text/html; charset=utf-8", 900);
+  LoadAsset(&g_asset.user, "user.html", "text/html; charset=utf-8", 900);
+  LoadAsset(&g_asset.favicon, "favicon.ico", "image/vnd.microsoft.icon",
+            86400);
 
   // sandbox ourselves
   __pledge_mode = PLEDGE_PENALTY_RETURN_EPERM;
@@ -2866,7 +3168,6 @@ int main(int argc, char *argv[]) {
   npassert(!pthread_create(&scorer_day, &attr, ScoreDayWorker, 0));
   npassert(!pthread_create(&scorer_week, &attr, ScoreWeekWorker, 0));
   npassert(!pthread_create(&scorer_month, &attr, ScoreMonthWorker, 0));
-  npassert(!pthread_create(&replenisher, &attr, ReplenishWorker, 0));
   npassert(!pthread_create(&claimer, &attr, ClaimWorker, 0));
   unassert((g_worker = calloc(g_workers, sizeof(*g_worker))));
   for (int id = 0, si = 0; id < g_workers; ++id, ++si) {
@@ -2887,7 +3188,6 @@ int main(int argc, char *argv[]) {
   pthread_cancel(scorer_hour);
   pthread_cancel(scorer_week);
   pthread_cancel(scorer_month);
-  pthread_cancel(replenisher);
 
   LOG("%H joining services...\n");
   npassert(!pthread_join(scorer, 0));
@@ -2895,7 +3195,6 @@ int main(int argc, char *argv[]) {
   npassert(!pthread_join(scorer_hour, 0));
   npassert(!pthread_join(scorer_week, 0));
   npassert(!pthread_join(scorer_month, 0));
-  npassert(!pthread_join(replenisher, 0));
 
   // cancel read() so that keepalive clients finish faster
   LOG("%H interrupting workers...\n");
@@ -2914,7 +3213,7 @@ int main(int argc, char *argv[]) {
   pthread_cancel(claimer);
   LOG("%H waiting for claims worker...\n");
   unassert(!pthread_join(claimer, 0));
-  unassert(!g_claims.count);
+  unassert(!mpsc_count(&g_claims));
 
   // perform some sanity checks
   unassert(GetCounter(&g_claimsprocessed) == GetCounter(&g_claimsenqueued));
@@ -2922,6 +3221,7 @@ int main(int argc, char *argv[]) {
   // free memory
   LOG("%H freeing memory...\n");
   pthread_attr_destroy(&attr);
+  Reclaim(true);
   FreeAsset(&g_asset.user);
   FreeAsset(&g_asset.about);
   FreeAsset(&g_asset.index);
@@ -2932,12 +3232,14 @@ int main(int argc, char *argv[]) {
   FreeAsset(&g_asset.score_month);
   FreeAsset(&g_asset.recent);
   FreeAsset(&g_asset.favicon);
+  FreeBoard(&g_board);
+  mpsc_destroy(&g_claims);
   free(rsacert.data);
   free(rsakey.data);
   free(ecdsacert.data);
   free(ecdsakey.data);
   free(g_worker);
-  free(g_tok.b);
+  free(g_tok);
 
   time_destroy();
 
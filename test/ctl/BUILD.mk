@@ -10,6 +10,7 @@ TEST_CTL_COMS = $(TEST_CTL_OBJS:%.o=%)
 TEST_CTL_BINS = $(TEST_CTL_COMS) $(TEST_CTL_COMS:%=%.dbg)
 TEST_CTL_CHECKS = $(TEST_CTL_COMS:%=%.runs)
 TEST_CTL_TESTS = $(TEST_CTL_COMS:%=%.ok)
+TEST_CTL_BENCHES = $(filter %_bench.bench,$(TEST_CTL_COMS:%=%.bench))
 
 TEST_CTL_DIRECTDEPS =				\
 	CTL					\
@@ -0,0 +1,221 @@
+// -*- mode:c++; indent-tabs-mode:nil; c-basic-offset:4; coding:utf-8 -*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+//
+// Copyright 2024 Justine Alexandra Roberts Tunney
+//
+// Permission to use, copy, modify, and/or distribute this software for
+// any purpose with or without fee is hereby granted, provided that the
+// above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+// WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+// AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+// DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+// PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+// TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "ctl/btree_map.h"
+#include "ctl/btree_set.h"
+#include "ctl/string.h"
+#include "ctl/vector.h"
+#include "libc/cosmo.h"
+
+// #include <map>
+// #include <set>
+// #include <string>
+// #include <vector>
+// #define ctl std
+
+int
+rand32(void)
+{
+    /* Knuth, D.E., "The Art of Computer Programming," Vol 2,
+       Seminumerical Algorithms, Third Edition, Addison-Wesley, 1998,
+       p. 106 (line 26) & p. 108 */
+    static unsigned long long lcg = 1;
+    lcg *= 6364136223846793005;
+    lcg += 1442695040888963407;
+    return lcg >> 32;
+}
+
+int
+main()
+{
+
+    {
+        // Test construction and basic operations
+        ctl::btree_set<int> s;
+        if (!s.empty() || s.size() != 0)
+            return 1;
+        if (s.begin() != s.end() || s.find(1) != s.end())
+            return 2;
+        s.insert(3);
+        s.insert(1);
+        s.insert(2);
+        if (s.size() != 3 || *s.begin() != 1 || *s.rbegin() != 3)
+            return 3;
+        if (s.insert(2).second)
+            return 4;
+        if (!s.contains(2) || s.count(4))
+            return 5;
+    }
+
+    {
+        // Test many values so the tree grows several levels deep
+        ctl::btree_set<int> s;
+        for (int i = 0; i < 10000; ++i)
+            s.insert((i * 7919) % 10000);
+        if (s.size() != 10000)
+            return 6;
+        int i = 0;
+        for (int x : s)
+            if (x != i++)
+                return 7;
+        for (auto it = s.rbegin(); it != s.rend(); ++it)
+            if (*it != --i)
+                return 8;
+        if (*s.lower_bound(5000) != 5000 || *s.upper_bound(5000) != 5001)
+            return 9;
+        if (s.lower_bound(10000) != s.end())
+            return 10;
+    }
+
+    {
+        // Test erasing returns iterator to the next value
+        ctl::btree_set<int> s;
+        for (int i = 0; i < 5000; ++i)
+            s.insert(i);
+        for (auto it = s.begin(); it != s.end();) {
+            if (*it % 3)
+                it = s.erase(it);
+            else
+                ++it;
+        }
+        if (s.size() != 1667)
+            return 11;
+        int i = 0;
+        for (int x : s) {
+            if (x != i)
+                return 12;
+            i += 3;
+        }
+        for (int i = 0; i < 5000; i += 2)
+            s.erase(i);
+        for (int x : s)
+            if (x % 6 != 3)
+                return 13;
+        auto first = s.lower_bound(1000);
+        auto last = s.lower_bound(2000);
+        auto it = s.erase(first, last);
+        if (*it != 2001 || s.contains(1005) || !s.contains(999))
+            return 14;
+        while (!s.empty())
+            s.erase(s.begin());
+        if (s.begin() != s.end())
+            return 15;
+    }
+
+    {
+        // Test random insert and erase against sorted vector
+        ctl::btree_set<int> s;
+        ctl::vector<int> v;
+        for (int i = 0; i < 20000; ++i) {
+            int x = rand32() % 1000;
+            auto j = v.begin();
+            while (j != v.end() && *j < x)
+                ++j;
+            bool present = j != v.end() && *j == x;
+            if (rand32() % 3) {
+                if (s.insert(x).second == present)
+                    return 16;
+                if (!present)
+                    v.insert(j, x);
+            } else {
+                if (s.erase(x) != present)
+                    return 17;
+                if (present)
+                    v.erase(j);
+            }
+        }
+        if (s.size() != v.size())
+            return 18;
+        auto j = v.begin();
+        for (int x : s)
+            if (x != *j++)
+                return 19;
+    }
+
+    {
+        // Test bulk loading from sorted input
+        ctl::vector<int> v;
+        for (int i = 0; i < 1000; ++i)
+            v.push_back(i * 2);
+        ctl::btree_set<int> s(ctl::sorted_unique, v.begin(), v.end());
+        if (s.size() != 1000)
+            return 20;
+        for (int i = 0; i < 1000; ++i)
+            if (!s.contains(i * 2) || s.contains(i * 2 + 1))
+                return 21;
+        auto j = v.begin();
+        for (int x : s)
+            if (x != *j++)
+                return 22;
+    }
+
+    {
+        // Test map operations
+        ctl::btree_map<int, ctl::string> m;
+        m[2] = "two";
+        m[1] = "one";
+        if (m.size() != 2 || m.begin()->second != "one")
+            return 23;
+        auto res = m.try_emplace(1, "uno");
+        if (res.second || res.first->second != "one")
+            return 24;
+        res = m.insert_or_assign(1, "uno");
+        if (res.second || m.at(1) != "uno")
+            return 25;
+        for (int i = 0; i < 1000; ++i)
+            m[i] = ctl::to_string(i);
+        if (m.size() != 1000 || m.at(500) != "500")
+            return 26;
+        for (int i = 0; i < 1000; i += 2)
+            m.erase(i);
+        int i = 1;
+        for (const auto& e : m) {
+            if (e.first != i || e.second != ctl::to_string(i))
+                return 27;
+            i += 2;
+        }
+        auto r = m.equal_range(501);
+        if (r.first->first != 501 || r.second->first != 503)
+            return 28;
+    }
+
+    {
+        // Test copy, move and comparison
+        ctl::btree_map<int, int> a;
+        for (int i = 0; i < 500; ++i)
+            a[i] = i * i;
+        ctl::btree_map<int, int> b(a);
+        if (!(a == b))
+            return 29;
+        b[0] = 1;
+        if (a == b)
+            return 30;
+        ctl::btree_map<int, int> c(ctl::move(b));
+        if (!b.empty() || c.size() != 500 || c[0] != 1)
+            return 31;
+        c = a;
+        if (!(c == a))
+            return 32;
+        ctl::btree_set<int> x{ 1, 2, 3 };
+        ctl::btree_set<int> y{ 1, 2, 4 };
+        if (!(x < y) || x == y || !(y > x))
+            return 33;
+    }
+
+    CheckForMemoryLeaks();
+}
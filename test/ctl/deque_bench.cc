@@ -0,0 +1,107 @@
+// -*- mode:c++; indent-tabs-mode:nil; c-basic-offset:4; coding:utf-8 -*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+//
+// Copyright 2024 Justine Alexandra Roberts Tunney
+//
+// Permission to use, copy, modify, and/or distribute this software for
+// any purpose with or without fee is hereby granted, provided that the
+// above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+// WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+// AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+// DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+// PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+// TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "ctl/deque.h"
+#include "ctl/ring_buffer.h"
+#include "ctl/vector.h"
+#include "libc/calls/struct/rusage.h"
+#include "libc/cosmo.h"
+#include "libc/mem/mem.h"
+#include "libc/stdio/stdio.h"
+#include "libc/sysv/consts/rusage.h"
+#include "libc/testlib/benchmark.h"
+
+// #include <deque>
+// #include <vector>
+// #define ctl std
+
+#include "libc/mem/tinymalloc.inc"
+
+void
+eat(long x)
+{
+}
+
+void (*pEat)(long) = eat;
+
+int
+main()
+{
+
+    {
+        // fifo with a small working set, which vector can't do in O(1)
+        long x = 0;
+        ctl::deque<long> d;
+        for (long i = 0; i < 100; ++i)
+            d.push_back(i);
+        BENCHMARK(1000000, 1, {
+            d.push_back(x);
+            x += d.front();
+            d.pop_front();
+        });
+        ctl::vector<long> v;
+        for (long i = 0; i < 100; ++i)
+            v.push_back(i);
+        BENCHMARK(1000000, 1, {
+            v.push_back(x);
+            x += v.front();
+            v.erase(v.begin());
+        });
+        ctl::ring_buffer<long, 128> r;
+        for (long i = 0; i < 100; ++i)
+            r.push_back(i);
+        BENCHMARK(1000000, 1, {
+            r.push_back(x);
+            x += r.front();
+            r.pop_front();
+        });
+        pEat(x);
+    }
+
+    {
+        // growing at both ends
+        ctl::deque<long> d;
+        BENCHMARK(1000000, 1, d.push_back(1));
+        BENCHMARK(1000000, 1, d.push_front(1));
+        BENCHMARK(2000000, 1, d.pop_back());
+        ctl::vector<long> v;
+        BENCHMARK(1000000, 1, v.push_back(1));
+    }
+
+    {
+        // random access
+        long x = 0;
+        ctl::deque<long> d;
+        for (long i = 0; i < 100000; ++i)
+            d.push_front(i);
+        BENCHMARK(1000000, 1, x += d[x & 65535]);
+        BENCHMARK(1, d.size(), {
+            for (long y : d)
+                x += y;
+        });
+        pEat(x);
+    }
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    printf("%,10d kb peak rss\n", ru.ru_maxrss);
+
+    malloc_trim(0);
+
+    CheckForMemoryLeaks();
+}
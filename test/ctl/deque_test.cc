@@ -0,0 +1,320 @@
+// -*- mode:c++; indent-tabs-mode:nil; c-basic-offset:4; coding:utf-8 -*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+//
+// Copyright 2024 Justine Alexandra Roberts Tunney
+//
+// Permission to use, copy, modify, and/or distribute this software for
+// any purpose with or without fee is hereby granted, provided that the
+// above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+// WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+// AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+// DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+// PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+// TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "ctl/deque.h"
+#include "ctl/ring_buffer.h"
+#include "ctl/string.h"
+#include "libc/cosmo.h"
+#include "libc/stdio/rand.h"
+
+// #include <deque>
+// #include <string>
+// #define ctl std
+
+static int counter;
+
+struct NonTrivial
+{
+    int value;
+
+    NonTrivial(int v) : value(v)
+    {
+        ++counter;
+    }
+
+    NonTrivial(const NonTrivial& other) : value(other.value)
+    {
+        ++counter;
+    }
+
+    NonTrivial(NonTrivial&& other) : value(other.value)
+    {
+        ++counter;
+    }
+
+    ~NonTrivial()
+    {
+        --counter;
+    }
+
+    NonTrivial& operator=(const NonTrivial& other)
+    {
+        value = other.value;
+        return *this;
+    }
+};
+
+int
+main()
+{
+
+    {
+        // Test pushing and popping at both ends
+        ctl::deque<int> d;
+        if (!d.empty() || d.size())
+            return 1;
+        for (int i = 0; i < 1000; ++i) {
+            d.push_back(i);
+            d.push_front(-i - 1);
+        }
+        if (d.size() != 2000 || d.front() != -1000 || d.back() != 999)
+            return 2;
+        for (int i = 0; i < 2000; ++i)
+            if (d[i] != i - 1000)
+                return 3;
+        for (int i = 0; i < 500; ++i) {
+            d.pop_front();
+            d.pop_back();
+        }
+        if (d.size() != 1000 || d.front() != -500 || d.back() != 499)
+            return 4;
+    }
+
+    {
+        // Test references stay valid when growing at either end
+        ctl::deque<int> d = { 1, 2, 3 };
+        int* p = &d[1];
+        for (int i = 0; i < 10000; ++i) {
+            d.push_back(i);
+            d.push_front(i);
+        }
+        if (p != &d[10001] || *p != 2)
+            return 5;
+    }
+
+    {
+        // Test deque used as a fifo doesn't retain memory
+        ctl::deque<ctl::string> d;
+        for (int i = 0; i < 100000; ++i) {
+            d.push_back("hello");
+            if (d.size() > 3)
+                d.pop_front();
+        }
+        if (d.size() != 3 || d.front() != "hello")
+            return 6;
+    }
+
+    {
+        // Test iterators
+        ctl::deque<int> d;
+        for (int i = 0; i < 300; ++i)
+            d.push_front(i);
+        int n = 299;
+        for (int x : d)
+            if (x != n--)
+                return 7;
+        if (d.end() - d.begin() != 300)
+            return 8;
+        if (*(d.begin() + 150) != 149 || d.begin()[299] != 0)
+            return 9;
+        if (*d.rbegin() != 0 || !(d.begin() < d.end()))
+            return 10;
+        ctl::deque<int>::const_iterator it = d.begin();
+        if (it != d.cbegin() || *it != 299)
+            return 11;
+    }
+
+    {
+        // Test insert and erase in the middle
+        ctl::deque<int> d = { 1, 5 };
+        d.insert(d.begin() + 1, 3);
+        d.insert(d.begin() + 1, 2);
+        d.insert(d.begin() + 3, 4);
+        for (int i = 0; i < 5; ++i)
+            if (d[i] != i + 1)
+                return 12;
+        d.insert(d.begin(), 2, 0);
+        int a[] = { 7, 8, 9 };
+        auto it = d.insert(d.begin() + 2, a, a + 3);
+        if (d.size() != 10 || *it != 7 || d[4] != 9 || d[5] != 1)
+            return 13;
+        it = d.erase(d.begin(), d.begin() + 5);
+        if (it != d.begin() || d.size() != 5 || d[0] != 1 || d[4] != 5)
+            return 14;
+        it = d.erase(d.begin() + 2);
+        if (*it != 4 || d.size() != 4 || d[1] != 2 || d[2] != 4)
+            return 15;
+    }
+
+    {
+        // Test copy, move, swap and comparison
+        ctl::deque<ctl::string> a = { "a", "b" };
+        ctl::deque<ctl::string> b = { "x", "y", "z" };
+        ctl::deque<ctl::string> c(a);
+        if (c != a)
+            return 16;
+        ctl::deque<ctl::string> d(ctl::move(b));
+        if (!b.empty() || d.size() != 3 || d[2] != "z")
+            return 17;
+        a.swap(d);
+        if (a.size() != 3 || d.size() != 2 || a[0] != "x" || d[1] != "b")
+            return 18;
+        d = a;
+        if (d != a || !(c < d))
+            return 19;
+        b = ctl::move(a);
+        if (!a.empty() || b.size() != 3)
+            return 20;
+    }
+
+    {
+        // Test resize and clear
+        ctl::deque<int> d;
+        d.resize(1000, 7);
+        if (d.size() != 1000 || d[999] != 7)
+            return 21;
+        d.resize(10);
+        if (d.size() != 10 || d.back() != 7)
+            return 22;
+        d.clear();
+        d.shrink_to_fit();
+        if (!d.empty())
+            return 23;
+        d.push_back(1);
+        if (d.size() != 1 || d.front() != 1)
+            return 24;
+    }
+
+    {
+        // Test non-trivial types are constructed and destroyed properly
+        counter = 0;
+        {
+            ctl::deque<NonTrivial> d;
+            for (int i = 0; i < 100; ++i)
+                d.emplace_back(i);
+            for (int i = 0; i < 100; ++i)
+                d.emplace_front(-i);
+            d.erase(d.begin() + 50, d.begin() + 150);
+            d.insert(d.begin() + 20, NonTrivial(1000));
+            if (d.size() != 101 || counter != 101)
+                return 25;
+            if (d[20].value != 1000 || d[51].value != 50)
+                return 26;
+            ctl::deque<NonTrivial> e(ctl::move(d));
+            if (counter != 101 || e.size() != 101)
+                return 27;
+        }
+        if (counter != 0)
+            return 28;
+    }
+
+    {
+        // Test against random operations
+        ctl::deque<int> d;
+        int shadow[4096];
+        int lo = 2048, hi = 2048;
+        for (int i = 0; i < 100000; ++i) {
+            switch (rand() % 4) {
+                case 0:
+                    if (hi < 4096) {
+                        d.push_back(i);
+                        shadow[hi++] = i;
+                    }
+                    break;
+                case 1:
+                    if (lo > 0) {
+                        d.push_front(i);
+                        shadow[--lo] = i;
+                    }
+                    break;
+                case 2:
+                    if (lo < hi) {
+                        d.pop_back();
+                        --hi;
+                    }
+                    break;
+                case 3:
+                    if (lo < hi) {
+                        d.pop_front();
+                        ++lo;
+                    }
+                    break;
+            }
+            if ((int)d.size() != hi - lo)
+                return 29;
+            if (lo < hi && d.front() != shadow[lo])
+                return 30;
+            if (lo < hi && d.back() != shadow[hi - 1])
+                return 30;
+        }
+        for (int i = lo; i < hi; ++i)
+            if (d[i - lo] != shadow[i])
+                return 31;
+    }
+
+    {
+        // Test ring buffer overwrites oldest items when full
+        ctl::ring_buffer<int, 4> r;
+        if (!r.empty() || r.full() || r.capacity() != 4)
+            return 32;
+        for (int i = 0; i < 10; ++i)
+            r.push_back(i);
+        if (!r.full() || r.size() != 4 || r.front() != 6 || r.back() != 9)
+            return 33;
+        int n = 6;
+        for (int x : r)
+            if (x != n++)
+                return 34;
+        r.push_front(100);
+        if (r.front() != 100 || r.back() != 8 || r[1] != 6)
+            return 35;
+        r.pop_front();
+        r.pop_back();
+        if (r.size() != 2 || r[0] != 6 || r[1] != 7)
+            return 36;
+        if (r.end() - r.begin() != 2 || *r.rbegin() != 7)
+            return 37;
+    }
+
+    {
+        // Test ring buffer with non-trivial types
+        counter = 0;
+        {
+            ctl::ring_buffer<NonTrivial, 8> r;
+            for (int i = 0; i < 100; ++i)
+                r.emplace_back(i);
+            if (counter != 8 || r.front().value != 92)
+                return 38;
+            ctl::ring_buffer<NonTrivial, 8> s(r);
+            if (counter != 16 || s.back().value != 99)
+                return 39;
+            s.clear();
+            if (counter != 8 || !s.empty())
+                return 40;
+            s = ctl::move(r);
+            if (counter != 8 || !r.empty() || s.size() != 8)
+                return 41;
+        }
+        if (counter != 0)
+            return 42;
+    }
+
+    {
+        // Test ring buffer of strings
+        ctl::ring_buffer<ctl::string, 2> r = { "a", "b", "c" };
+        if (r.size() != 2 || r[0] != "b" || r[1] != "c")
+            return 43;
+        ctl::ring_buffer<ctl::string, 2> s;
+        s.push_back("x");
+        r.swap(s);
+        if (r.size() != 1 || r[0] != "x" || s[1] != "c")
+            return 44;
+    }
+
+    CheckForMemoryLeaks();
+}
@@ -0,0 +1,186 @@
+// -*- mode:c++; indent-tabs-mode:nil; c-basic-offset:4; coding:utf-8 -*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+//
+// Copyright 2024 Justine Alexandra Roberts Tunney
+//
+// Permission to use, copy, modify, and/or distribute this software for
+// any purpose with or without fee is hereby granted, provided that the
+// above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+// WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+// AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+// DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+// PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+// TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "ctl/function.h"
+#include "ctl/string.h"
+#include "ctl/unique_ptr.h"
+#include "libc/cosmo.h"
+
+// #include <functional>
+// #include <memory>
+// #include <string>
+// #define ctl std
+
+static int counter;
+
+struct Counted
+{
+    long pad[8];
+    int value;
+
+    Counted(int v) : value(v)
+    {
+        ++counter;
+    }
+
+    Counted(const Counted& other) : value(other.value)
+    {
+        ++counter;
+    }
+
+    Counted(Counted&& other) : value(other.value)
+    {
+        ++counter;
+    }
+
+    ~Counted()
+    {
+        --counter;
+    }
+
+    int operator()(int x) const
+    {
+        return value + x;
+    }
+};
+
+static int
+add1(int x)
+{
+    return x + 1;
+}
+
+static int
+apply(ctl::function_ref<int(int)> f, int x)
+{
+    return f(x);
+}
+
+int
+main()
+{
+    {
+        ctl::function<int(int)> f;
+        if (f || !(f == nullptr))
+            return 1;
+        f = add1;
+        if (!f || f(1) != 2)
+            return 2;
+        int (*null)(int) = nullptr;
+        f = null;
+        if (f)
+            return 3;
+    }
+
+    {
+        int a = 10;
+        ctl::function<int(int)> f = [a](int x) { return a + x; };
+        ctl::function<int(int)> g = f;
+        if (f(1) != 11 || g(2) != 12)
+            return 4;
+        ctl::function<int(int)> h = ctl::move(f);
+        if (f || h(3) != 13)
+            return 5;
+        f.swap(h);
+        if (!f || h || f(4) != 14)
+            return 6;
+    }
+
+    {
+        bool thrown = false;
+        ctl::function<void()> f;
+        try {
+            f();
+        } catch (const ctl::bad_function_call&) {
+            thrown = true;
+        }
+        if (!thrown)
+            return 7;
+    }
+
+    {
+        // large functors go on the heap and are copied deeply
+        {
+            ctl::function<int(int)> f = Counted(5);
+            if (counter != 1 || f(1) != 6)
+                return 8;
+            ctl::function<int(int)> g = f;
+            if (counter != 2 || g(2) != 7)
+                return 9;
+            ctl::function<int(int)> h = ctl::move(g);
+            if (counter != 2 || g || h(3) != 8)
+                return 10;
+            f = nullptr;
+            if (counter != 1)
+                return 11;
+            f.swap(h);
+            if (counter != 1 || f(4) != 9)
+                return 12;
+        }
+        if (counter != 0)
+            return 13;
+    }
+
+    {
+        ctl::string s = "hello";
+        ctl::function<ctl::string(const ctl::string&)> f =
+          [s](const ctl::string& t) { return s + t; };
+        ctl::function<ctl::string(const ctl::string&)> g = f;
+        f = nullptr;
+        if (g(" world") != "hello world")
+            return 14;
+    }
+
+    {
+        auto p = ctl::make_unique<int>(42);
+        ctl::move_only_function<int()> f = [p = ctl::move(p)] { return *p; };
+        if (!f || f() != 42)
+            return 15;
+        ctl::move_only_function<int()> g = ctl::move(f);
+        if (f || g() != 42)
+            return 16;
+        g = nullptr;
+        if (g)
+            return 17;
+    }
+
+    {
+        int n = 0;
+        auto inc = [&n](int x) { return n += x; };
+        if (apply(inc, 2) != 2 || apply(inc, 3) != 5 || n != 5)
+            return 18;
+        if (apply(add1, 1) != 2)
+            return 19;
+        ctl::function<int(int)> f = add1;
+        if (apply(f, 2) != 3)
+            return 20;
+    }
+
+    {
+        if (sizeof(ctl::function<void()>) != 4 * sizeof(void*))
+            return 21;
+        ctl::function<void(int&)> f = [](int& x) { ++x; };
+        int x = 0;
+        f(x);
+        f(x);
+        if (x != 2)
+            return 22;
+    }
+
+    CheckForMemoryLeaks();
+}
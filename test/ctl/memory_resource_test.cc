@@ -0,0 +1,161 @@
+// -*- mode:c++; indent-tabs-mode:nil; c-basic-offset:4; coding:utf-8 -*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+//
+// Copyright 2024 Justine Alexandra Roberts Tunney
+//
+// Permission to use, copy, modify, and/or distribute this software for
+// any purpose with or without fee is hereby granted, provided that the
+// above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+// WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+// AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+// DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+// PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+// TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "ctl/map.h"
+#include "ctl/memory_resource.h"
+#include "ctl/set.h"
+#include "ctl/vector.h"
+#include "libc/cosmo.h"
+
+// #include <map>
+// #include <memory_resource>
+// #include <set>
+// #include <vector>
+// #define ctl std
+
+// counts memory that's outstanding from the upstream resource
+struct counting_resource : public ctl::pmr::memory_resource
+{
+    long bytes = 0;
+    long blocks = 0;
+
+    void* do_allocate(size_t n, size_t a) override
+    {
+        bytes += n;
+        blocks += 1;
+        return ctl::pmr::new_delete_resource()->allocate(n, a);
+    }
+
+    void do_deallocate(void* p, size_t n, size_t a) override
+    {
+        bytes -= n;
+        blocks -= 1;
+        ctl::pmr::new_delete_resource()->deallocate(p, n, a);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+int
+main()
+{
+    counting_resource upstream;
+
+    {
+        // Test monotonic arena bumps within its buffer
+        char buf[256];
+        ctl::pmr::monotonic_buffer_resource arena(buf, sizeof(buf), &upstream);
+        char* p = (char*)arena.allocate(100, 1);
+        if (p != buf || upstream.blocks)
+            return 1;
+        char* q = (char*)arena.allocate(8, 8);
+        if (q < p + 100 || (uintptr_t)q % 8)
+            return 2;
+        if (!arena.allocate(500) || upstream.blocks != 1)
+            return 3;
+        arena.release();
+        if (upstream.blocks || arena.allocate(1, 1) != buf)
+            return 4;
+    }
+
+    {
+        // Test containers allocate from the arena and free in one shot
+        ctl::pmr::monotonic_buffer_resource arena(&upstream);
+        ctl::pmr::vector<int> v(&arena);
+        ctl::pmr::set<int> s(&arena);
+        ctl::pmr::map<int, int> m(&arena);
+        for (int i = 0; i < 1000; ++i) {
+            v.push_back(i);
+            s.insert(i % 100);
+            m[i] = i * 2;
+        }
+        if (v[999] != 999 || s.size() != 100 || m[500] != 1000)
+            return 5;
+        if (v.get_allocator().resource() != &arena ||
+            s.get_allocator().resource() != &arena ||
+            m.get_allocator().resource() != &arena)
+            return 6;
+        ctl::pmr::map<int, int> m2(m);
+        if (m2.get_allocator().resource() != &arena || m2 != m)
+            return 7;
+        if (!upstream.blocks)
+            return 8;
+    }
+    if (upstream.blocks || upstream.bytes)
+        return 9;
+
+    {
+        // Test pool recycles blocks and releases everything it holds
+        ctl::pmr::unsynchronized_pool_resource pool(&upstream);
+        void* a = pool.allocate(24);
+        pool.deallocate(a, 24);
+        void* b = pool.allocate(32);
+        if (a != b)
+            return 10;
+        void* big = pool.allocate(100000, 64);
+        if ((uintptr_t)big % 64)
+            return 11;
+        pool.deallocate(big, 100000, 64);
+        long before = upstream.blocks;
+        for (int i = 0; i < 1000; ++i)
+            pool.deallocate(pool.allocate(i % 500 + 1), i % 500 + 1);
+        if (upstream.blocks > before + 10 || !pool.allocate(100000))
+            return 12;
+        pool.release();
+        if (upstream.blocks || upstream.bytes)
+            return 13;
+    }
+
+    {
+        // Test pool options get rounded to a power of two
+        ctl::pmr::pool_options opts;
+        opts.largest_required_pool_block = 100;
+        ctl::pmr::synchronized_pool_resource pool(opts, &upstream);
+        if (pool.options().largest_required_pool_block != 128)
+            return 14;
+        ctl::pmr::vector<int> v(&pool);
+        for (int i = 0; i < 100; ++i)
+            v.push_back(i);
+        if (v[99] != 99)
+            return 15;
+    }
+    if (upstream.blocks || upstream.bytes)
+        return 16;
+
+    {
+        // Test default resource
+        if (ctl::pmr::get_default_resource() !=
+            ctl::pmr::new_delete_resource())
+            return 17;
+        ctl::pmr::set_default_resource(&upstream);
+        {
+            ctl::pmr::vector<int> v;
+            v.push_back(1);
+            if (!upstream.blocks)
+                return 18;
+        }
+        ctl::pmr::set_default_resource(nullptr);
+        if (upstream.blocks)
+            return 19;
+    }
+
+    CheckForMemoryLeaks();
+}
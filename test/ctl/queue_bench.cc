@@ -0,0 +1,199 @@
+// -*- mode:c++; indent-tabs-mode:nil; c-basic-offset:4; coding:utf-8 -*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+//
+// Copyright 2024 Justine Alexandra Roberts Tunney
+//
+// Permission to use, copy, modify, and/or distribute this software for
+// any purpose with or without fee is hereby granted, provided that the
+// above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+// WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+// AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+// DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+// PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+// TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "ctl/mpmc_queue.h"
+#include "ctl/mpsc_queue.h"
+#include "ctl/spsc_queue.h"
+#include "libc/calls/struct/timespec.h"
+#include "libc/cosmo.h"
+#include "libc/cosmotime.h"
+#include "libc/dce.h"
+#include "libc/testlib/benchmark.h"
+#include "libc/thread/thread.h"
+
+#include "libc/mem/tinymalloc.inc"
+
+#if IsModeDbg()
+#define ITEMS 10000 // because qemu in dbg mode is very slow
+#else
+#define ITEMS 1000000
+#endif
+
+#define PINGS (ITEMS / 10)
+
+template<typename Queue>
+struct job
+{
+    Queue* q;
+    long items;
+    long batch;
+};
+
+template<typename Queue>
+void*
+producer(void* arg)
+{
+    job<Queue>* j = static_cast<job<Queue>*>(arg);
+    long buf[64];
+    for (long i = 0; i < j->items;) {
+        long n = j->batch < j->items - i ? j->batch : j->items - i;
+        for (long k = 0; k < n; ++k)
+            buf[k] = i + k;
+        long k = j->q->try_push_n(buf, n);
+        for (; k < n; ++k)
+            j->q->push(buf[k]);
+        i += n;
+    }
+    return nullptr;
+}
+
+template<>
+void*
+producer<ctl::mpsc_queue<long>>(void* arg)
+{
+    auto j = static_cast<job<ctl::mpsc_queue<long>>*>(arg);
+    long buf[64];
+    for (long i = 0; i < j->items;) {
+        long n = j->batch < j->items - i ? j->batch : j->items - i;
+        for (long k = 0; k < n; ++k)
+            buf[k] = i + k;
+        j->q->push_n(buf, n);
+        i += n;
+    }
+    return nullptr;
+}
+
+template<typename Queue>
+void*
+consumer(void* arg)
+{
+    job<Queue>* j = static_cast<job<Queue>*>(arg);
+    long buf[64];
+    for (long i = 0; i < j->items;) {
+        long n = j->batch < j->items - i ? j->batch : j->items - i;
+        long k = j->q->try_pop_n(buf, n);
+        if (!k) {
+            j->q->pop(buf[0]);
+            k = 1;
+        }
+        i += k;
+    }
+    return nullptr;
+}
+
+// Measures items per second moving through q under contention.
+template<typename Queue>
+void
+throughput(Queue& q, int producers, int consumers, long batch, const char* name)
+{
+    pthread_t th[64];
+    job<Queue> pj = { &q, ITEMS / producers, batch };
+    job<Queue> cj = { &q, ITEMS / consumers, batch };
+    struct timespec start = timespec_real();
+    for (int i = 0; i < producers; ++i)
+        pthread_create(th + i, 0, producer<Queue>, &pj);
+    for (int i = 0; i < consumers; ++i)
+        pthread_create(th + producers + i, 0, consumer<Queue>, &cj);
+    for (int i = 0; i < producers + consumers; ++i)
+        pthread_join(th[i], 0);
+    long ns = timespec_tonanos(timespec_sub(timespec_real(), start));
+    _print_benchmark_result(ns, ITEMS, 1, name);
+}
+
+template<typename Queue>
+struct pingpong
+{
+    Queue ping{ 16 };
+    Queue pong{ 16 };
+    bool spin;
+};
+
+template<typename Queue>
+void*
+ponger(void* arg)
+{
+    pingpong<Queue>* p = static_cast<pingpong<Queue>*>(arg);
+    long x;
+    for (long i = 0; i < PINGS; ++i) {
+        if (p->spin)
+            while (!p->ping.try_pop(x))
+                pthread_yield_np();
+        else
+            p->ping.pop(x);
+        p->pong.push(x);
+    }
+    return nullptr;
+}
+
+// Measures round trip time of an item bouncing between two threads.
+template<typename Queue>
+void
+latency(bool spin, const char* name)
+{
+    pthread_t th;
+    long x;
+    pingpong<Queue> p;
+    p.spin = spin;
+    pthread_create(&th, 0, ponger<Queue>, &p);
+    struct timespec start = timespec_real();
+    for (long i = 0; i < PINGS; ++i) {
+        p.ping.push(i);
+        if (spin)
+            while (!p.pong.try_pop(x))
+                pthread_yield_np();
+        else
+            p.pong.pop(x);
+    }
+    long ns = timespec_tonanos(timespec_sub(timespec_real(), start));
+    pthread_join(th, 0);
+    _print_benchmark_result(ns, PINGS, 1, name);
+}
+
+int
+main()
+{
+    {
+        ctl::spsc_queue<long> q(1024);
+        throughput(q, 1, 1, 1, "spsc 1:1");
+        throughput(q, 1, 1, 64, "spsc 1:1 batch 64");
+    }
+
+    {
+        ctl::mpmc_queue<long> q(1024);
+        throughput(q, 1, 1, 1, "mpmc 1:1");
+        throughput(q, 1, 1, 64, "mpmc 1:1 batch 64");
+        throughput(q, 4, 4, 1, "mpmc 4:4");
+        throughput(q, 4, 4, 16, "mpmc 4:4 batch 16");
+        throughput(q, 8, 1, 1, "mpmc 8:1");
+    }
+
+    {
+        ctl::mpsc_queue<long> q;
+        throughput(q, 1, 1, 1, "mpsc 1:1");
+        throughput(q, 4, 1, 1, "mpsc 4:1");
+        throughput(q, 4, 1, 16, "mpsc 4:1 batch 16");
+        throughput(q, 8, 1, 1, "mpsc 8:1");
+    }
+
+    latency<ctl::spsc_queue<long>>(true, "spsc round trip spinning");
+    latency<ctl::spsc_queue<long>>(false, "spsc round trip blocking");
+    latency<ctl::mpmc_queue<long>>(true, "mpmc round trip spinning");
+    latency<ctl::mpmc_queue<long>>(false, "mpmc round trip blocking");
+
+    CheckForMemoryLeaks();
+}
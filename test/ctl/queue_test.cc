@@ -0,0 +1,222 @@
+// -*- mode:c++; indent-tabs-mode:nil; c-basic-offset:4; coding:utf-8 -*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+//
+// Copyright 2024 Justine Alexandra Roberts Tunney
+//
+// Permission to use, copy, modify, and/or distribute this software for
+// any purpose with or without fee is hereby granted, provided that the
+// above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+// WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+// AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+// DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+// PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+// TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "ctl/mpmc_queue.h"
+#include "ctl/mpsc_queue.h"
+#include "ctl/spsc_queue.h"
+#include "ctl/string.h"
+#include "libc/calls/struct/timespec.h"
+#include "libc/cosmo.h"
+#include "libc/cosmotime.h"
+#include "libc/thread/thread.h"
+
+#define THREADS    4
+#define ITERATIONS 20000
+
+ctl::spsc_queue<long> spsc(64);
+ctl::mpmc_queue<long> mpmc(64);
+ctl::mpsc_queue<long> mpsc;
+long consumed[THREADS * ITERATIONS];
+
+void*
+spsc_producer(void* arg)
+{
+    long batch[7];
+    for (long i = 0; i < ITERATIONS;) {
+        long n = 0;
+        for (; n < 7 && i + n < ITERATIONS; ++n)
+            batch[n] = i + n;
+        long k = spsc.try_push_n(batch, n);
+        if (!k)
+            spsc.push(i++);
+        else
+            i += k;
+    }
+    return nullptr;
+}
+
+void*
+mpmc_producer(void* arg)
+{
+    long base = (long)arg * ITERATIONS;
+    for (long i = 0; i < ITERATIONS; i += 2) {
+        long pair[2] = { base + i, base + i + 1 };
+        for (long k = mpmc.try_push_n(pair, 2); k < 2; ++k)
+            mpmc.push(pair[k]);
+    }
+    return nullptr;
+}
+
+void*
+mpmc_consumer(void* arg)
+{
+    long x;
+    for (long i = 0; i < ITERATIONS; ++i) {
+        mpmc.pop(x);
+        __atomic_fetch_add(&consumed[x], 1, __ATOMIC_RELAXED);
+    }
+    return nullptr;
+}
+
+void*
+mpsc_producer(void* arg)
+{
+    long base = (long)arg * ITERATIONS;
+    for (long i = 0; i < ITERATIONS; i += 4) {
+        if (i & 4) {
+            long batch[4];
+            for (long j = 0; j < 4; ++j)
+                batch[j] = base + i + j;
+            mpsc.push_n(batch, 4);
+        } else {
+            for (long j = 0; j < 4; ++j)
+                mpsc.push(base + i + j);
+        }
+    }
+    return nullptr;
+}
+
+int
+main()
+{
+    {
+        ctl::spsc_queue<ctl::string> q(3);
+        ctl::string s;
+        if (q.capacity() != 4 || !q.empty() || q.try_pop(s))
+            return 1;
+        for (int i = 0; i < 4; ++i)
+            if (!q.try_push(ctl::string(40, 'a' + i)))
+                return 2;
+        if (q.try_push(ctl::string("x")) || q.size() != 4)
+            return 3;
+        ctl::string out[3];
+        if (q.try_pop_n(out, 3) != 3 || out[2] != ctl::string(40, 'c'))
+            return 4;
+        ctl::string in[4] = { "e", "f", "g", "h" };
+        if (q.try_push_n(in, 4) != 3 || q.size() != 4)
+            return 5;
+        if (!q.try_pop(s) || s != ctl::string(40, 'd'))
+            return 6;
+        // leave items behind to check the destructor frees them
+    }
+
+    {
+        ctl::mpmc_queue<ctl::string> q(4);
+        ctl::string s;
+        if (q.capacity() != 4 || q.try_pop(s))
+            return 7;
+        ctl::string in[5] = { "a", "b", "c", "d", "e" };
+        if (q.try_push_n(in, 5) != 4 || q.try_push(ctl::string("x")))
+            return 8;
+        ctl::string out[2];
+        if (q.try_pop_n(out, 2) != 2 || out[0] != "a" || out[1] != "b")
+            return 9;
+        if (!q.try_push(ctl::string(40, 'z')) || q.size() != 3)
+            return 10;
+        if (!q.try_pop(s) || s != "c")
+            return 11;
+    }
+
+    {
+        ctl::mpsc_queue<ctl::string> q;
+        ctl::string s;
+        if (!q.empty() || q.try_pop(s))
+            return 12;
+        q.push(ctl::string(40, 'a'));
+        q.emplace(3, 'b');
+        ctl::string in[2] = { "c", "d" };
+        q.push_n(in, 2);
+        ctl::string out[3];
+        if (q.try_pop_n(out, 3) != 3 || out[0] != ctl::string(40, 'a') ||
+            out[1] != "bbb" || out[2] != "c")
+            return 13;
+        q.push(ctl::string(40, 'e'));
+    }
+
+    {
+        long x;
+        struct timespec deadline =
+          timespec_add(timespec_real(), timespec_frommillis(10));
+        if (spsc.pop(x, &deadline) || mpmc.pop(x, &deadline) ||
+            mpsc.pop(x, &deadline))
+            return 14;
+        for (int i = 0; i < 64; ++i)
+            mpmc.push(i);
+        if (mpmc.push(64, &deadline) || mpmc.size() != 64)
+            return 15;
+        for (long i = 0; i < 64; ++i)
+            if (!mpmc.pop(x) || x != i)
+                return 16;
+    }
+
+    {
+        pthread_t th;
+        if (pthread_create(&th, 0, spsc_producer, 0))
+            return 17;
+        long x, buf[5];
+        for (long i = 0; i < ITERATIONS;) {
+            long k = spsc.try_pop_n(buf, 5);
+            for (long j = 0; j < k; ++j)
+                if (buf[j] != i++)
+                    return 18;
+            if (!k) {
+                spsc.pop(x);
+                if (x != i++)
+                    return 19;
+            }
+        }
+        pthread_join(th, 0);
+        if (!spsc.empty())
+            return 20;
+    }
+
+    {
+        pthread_t th[THREADS * 2];
+        for (long i = 0; i < THREADS; ++i)
+            if (pthread_create(th + i, 0, mpmc_producer, (void*)i) ||
+                pthread_create(th + THREADS + i, 0, mpmc_consumer, 0))
+                return 21;
+        for (int i = 0; i < THREADS * 2; ++i)
+            pthread_join(th[i], 0);
+        for (int i = 0; i < THREADS * ITERATIONS; ++i)
+            if (consumed[i] != 1)
+                return 22;
+        if (!mpmc.empty())
+            return 23;
+    }
+
+    {
+        pthread_t th[THREADS];
+        long next[THREADS] = {};
+        for (long i = 0; i < THREADS; ++i)
+            if (pthread_create(th + i, 0, mpsc_producer, (void*)i))
+                return 24;
+        for (long i = 0, x; i < THREADS * ITERATIONS; ++i) {
+            mpsc.pop(x);
+            long t = x / ITERATIONS;
+            if (x % ITERATIONS != next[t]++)
+                return 25;
+        }
+        for (int i = 0; i < THREADS; ++i)
+            pthread_join(th[i], 0);
+        if (!mpsc.empty())
+            return 26;
+    }
+
+    CheckForMemoryLeaks();
+}
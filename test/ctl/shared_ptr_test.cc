@@ -20,6 +20,7 @@
 #include "ctl/shared_ptr.h"
 #include "ctl/vector.h"
 #include "libc/cosmo.h"
+#include "libc/thread/thread.h"
 
 // #include <memory>
 // #include <vector>
@@ -104,6 +105,19 @@ struct Tree : ctl::weak_self_base
     }
 };
 
+void*
+CopyShared(void* arg)
+{
+    auto& x = *static_cast<shared_ptr<DestructG>*>(arg);
+    weak_ptr<DestructG> w(x);
+    for (int i = 0; i < 100000; ++i) {
+        auto y = x;
+        auto z = w.lock();
+        weak_ptr<DestructG> v(y);
+    }
+    return nullptr;
+}
+
 int
 main()
 {
@@ -305,8 +319,25 @@ main()
             return 27;
     }
 
-    // TODO(mrdomino): exercise threads / races. The reference count should be
-    // atomically maintained.
+    {
+        // Counts are plain integers until a thread exists, after which
+        // they must be maintained atomically.
+        g = 0;
+        auto x = make_shared<DestructG>();
+        auto y = x;
+        pthread_t th[4];
+        for (int i = 0; i < 4; ++i)
+            if (pthread_create(th + i, 0, CopyShared, &x))
+                return 28;
+        for (int i = 0; i < 4; ++i)
+            pthread_join(th[i], 0);
+        if (x.use_count() != 2 || g)
+            return 29;
+        y.reset();
+        x.reset();
+        if (g != 1)
+            return 30;
+    }
 
     CheckForMemoryLeaks();
     return 0;
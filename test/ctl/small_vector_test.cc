@@ -0,0 +1,151 @@
+// -*- mode:c++; indent-tabs-mode:nil; c-basic-offset:4; coding:utf-8 -*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+//
+// Copyright 2024 Justine Alexandra Roberts Tunney
+//
+// Permission to use, copy, modify, and/or distribute this software for
+// any purpose with or without fee is hereby granted, provided that the
+// above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+// WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+// AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+// DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+// PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+// TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "ctl/small_vector.h"
+#include "ctl/string.h"
+#include "libc/cosmo.h"
+
+// #include <string>
+// #include <vector>
+// #define ctl std
+
+static int counter;
+
+struct NonTrivial
+{
+    int value;
+
+    NonTrivial(int v) : value(v)
+    {
+        ++counter;
+    }
+
+    NonTrivial(const NonTrivial& other) : value(other.value)
+    {
+        ++counter;
+    }
+
+    NonTrivial(NonTrivial&& other) : value(other.value)
+    {
+        ++counter;
+    }
+
+    ~NonTrivial()
+    {
+        --counter;
+    }
+
+    NonTrivial& operator=(const NonTrivial& other)
+    {
+        value = other.value;
+        return *this;
+    }
+};
+
+int
+main()
+{
+
+    {
+        // Test elements stay inline until capacity is exceeded
+        ctl::small_vector<int, 4> v;
+        if (!v.empty() || v.capacity() != 4 || !v.is_inline())
+            return 1;
+        for (int i = 0; i < 4; ++i)
+            v.push_back(i);
+        if (!v.is_inline() || v.size() != 4)
+            return 2;
+        v.push_back(4);
+        if (v.is_inline() || v.size() != 5 || v.capacity() < 5)
+            return 3;
+        for (int i = 0; i < 5; ++i)
+            if (v[i] != i)
+                return 4;
+        v.resize(2);
+        v.shrink_to_fit();
+        if (!v.is_inline() || v.size() != 2 || v[1] != 1)
+            return 5;
+    }
+
+    {
+        // Test insert and erase
+        ctl::small_vector<int, 2> v = { 1, 5 };
+        v.insert(v.begin() + 1, 3);
+        v.insert(v.begin() + 1, 2);
+        v.insert(v.begin() + 3, 4);
+        for (int i = 0; i < 5; ++i)
+            if (v[i] != i + 1)
+                return 6;
+        v.insert(v.begin(), 2, 0);
+        if (v.size() != 7 || v[0] || v[1] || v[2] != 1)
+            return 7;
+        int a[] = { 7, 8, 9 };
+        v.insert(v.begin() + 2, a, a + 3);
+        if (v.size() != 10 || v[2] != 7 || v[4] != 9 || v[5] != 1)
+            return 8;
+        auto it = v.erase(v.begin(), v.begin() + 5);
+        if (it != v.begin() || v.size() != 5 || v[0] != 1 || v[4] != 5)
+            return 9;
+        v.push_back(v[0]);
+        if (v.back() != 1)
+            return 10;
+    }
+
+    {
+        // Test copy, move and swap of inline and heap vectors
+        ctl::small_vector<ctl::string, 2> a = { "a", "b" };
+        ctl::small_vector<ctl::string, 2> b = { "x", "y", "z" };
+        ctl::small_vector<ctl::string, 2> c(a);
+        if (c != a || !c.is_inline())
+            return 11;
+        ctl::small_vector<ctl::string, 2> d(ctl::move(b));
+        if (!b.empty() || d.size() != 3 || d[2] != "z")
+            return 12;
+        a.swap(d);
+        if (a.size() != 3 || d.size() != 2 || a[0] != "x" || d[1] != "b")
+            return 13;
+        d = ctl::move(a);
+        if (d.size() != 3 || !a.empty() || !a.is_inline())
+            return 14;
+        if (!(c < d))
+            return 15;
+    }
+
+    {
+        // Test non-trivial types are constructed and destroyed properly
+        counter = 0;
+        {
+            ctl::small_vector<NonTrivial, 3> v;
+            for (int i = 0; i < 10; ++i)
+                v.emplace_back(i);
+            v.erase(v.begin() + 2, v.begin() + 6);
+            v.insert(v.begin(), NonTrivial(-1));
+            if (v.size() != 7 || counter != 7)
+                return 16;
+            if (v[0].value != -1 || v[3].value != 6 || v[6].value != 9)
+                return 17;
+            ctl::small_vector<NonTrivial, 3> w(ctl::move(v));
+            if (counter != 7 || w.size() != 7)
+                return 18;
+        }
+        if (counter != 0)
+            return 19;
+    }
+
+    CheckForMemoryLeaks();
+}
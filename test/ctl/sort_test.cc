@@ -17,11 +17,16 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #include "ctl/is_sorted.h"
+#include "ctl/partial_sort.h"
 #include "ctl/sort.h"
+#include "ctl/stable_sort.h"
 #include "ctl/string.h"
 #include "ctl/vector.h"
 #include "libc/cosmo.h"
+#include "libc/dce.h"
+#include "libc/mem/alg.h"
 #include "libc/stdio/rand.h"
+#include "libc/testlib/benchmark.h"
 
 // #include <algorithm>
 // #include <string>
@@ -97,6 +102,172 @@ test_sort_reverse()
     return 0;
 }
 
+// Test sorted and duplicate-heavy input don't go quadratic
+int
+test_sort_patterns_linear()
+{
+    const int SIZE = 100000;
+    ctl::vector<int> v(SIZE);
+    long comparisons = 0;
+    auto counting_less = [&](int a, int b) {
+        ++comparisons;
+        return a < b;
+    };
+    for (int i = 0; i < SIZE; ++i)
+        v[i] = i;
+    ctl::sort(v.begin(), v.end(), counting_less);
+    if (!is_sorted(v.begin(), v.end(), ctl::less<int>()))
+        return 7;
+    if (comparisons > SIZE * 4)
+        return 8;
+    comparisons = 0;
+    for (int i = 0; i < SIZE; ++i)
+        v[i] = SIZE - i;
+    ctl::sort(v.begin(), v.end(), counting_less);
+    if (!is_sorted(v.begin(), v.end(), ctl::less<int>()))
+        return 9;
+    if (comparisons > SIZE * 4)
+        return 10;
+    comparisons = 0;
+    for (int i = 0; i < SIZE; ++i)
+        v[i] = rand() % 3;
+    ctl::sort(v.begin(), v.end(), counting_less);
+    if (!is_sorted(v.begin(), v.end(), ctl::less<int>()))
+        return 11;
+    if (comparisons > SIZE * 8)
+        return 12;
+    return 0;
+}
+
+// Test sorting every small size and shape
+int
+test_sort_small()
+{
+    for (int n = 0; n < 200; ++n) {
+        for (int shape = 0; shape < 4; ++shape) {
+            ctl::vector<long> v(n);
+            for (int i = 0; i < n; ++i) {
+                switch (shape) {
+                    case 0:
+                        v[i] = rand();
+                        break;
+                    case 1:
+                        v[i] = i % 7;
+                        break;
+                    case 2:
+                        v[i] = i < n / 2 ? i : n - i;
+                        break;
+                    default:
+                        v[i] = -i;
+                        break;
+                }
+            }
+            ctl::sort(v.begin(), v.end());
+            if (!is_sorted(v.begin(), v.end(), ctl::less<long>()))
+                return 13;
+        }
+    }
+    return 0;
+}
+
+// Test stable_sort keeps equivalent elements in their original order
+int
+test_stable_sort()
+{
+    struct Item
+    {
+        int key;
+        int order;
+    };
+    const int SIZE = 10000;
+    ctl::vector<Item> v(SIZE);
+    for (int i = 0; i < SIZE; ++i)
+        v[i] = { rand() % 100, i };
+    ctl::stable_sort(v.begin(), v.end(), [](const Item& a, const Item& b) {
+        return a.key < b.key;
+    });
+    for (int i = 1; i < SIZE; ++i) {
+        if (v[i - 1].key > v[i].key)
+            return 14;
+        if (v[i - 1].key == v[i].key && v[i - 1].order > v[i].order)
+            return 15;
+    }
+    ctl::vector<ctl::string> s = { "bb", "a", "ccc", "dd", "e", "fff", "g" };
+    ctl::stable_sort(
+      s.begin(), s.end(), [](const ctl::string& a, const ctl::string& b) {
+          return a.size() < b.size();
+      });
+    if (s[0] != "a" || s[1] != "e" || s[2] != "g" || s[3] != "bb" ||
+        s[4] != "dd" || s[5] != "ccc" || s[6] != "fff")
+        return 16;
+    return 0;
+}
+
+// Test partial_sort puts the smallest elements first in order
+int
+test_partial_sort()
+{
+    const int SIZE = 10000;
+    ctl::vector<int> v(SIZE);
+    for (int i = 0; i < SIZE; ++i)
+        v[i] = (i * 7919) % SIZE;
+    ctl::partial_sort(v.begin(), v.begin() + 100, v.end());
+    for (int i = 0; i < 100; ++i)
+        if (v[i] != i)
+            return 17;
+    ctl::partial_sort(v.begin(), v.end(), v.end());
+    for (int i = 0; i < SIZE; ++i)
+        if (v[i] != i)
+            return 18;
+    ctl::partial_sort(v.begin(), v.begin(), v.end());
+    return 0;
+}
+
+int
+compare_ints(const void* a, const void* b)
+{
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+void
+benchmark_sort()
+{
+#if IsModeDbg()
+    const int SIZE = 1000;
+#else
+    const int SIZE = 100000;
+#endif
+    ctl::vector<int> data(SIZE), v(SIZE);
+    for (int i = 0; i < SIZE; ++i)
+        data[i] = rand();
+    BENCHMARK(10, SIZE, {
+        v = data;
+        ctl::sort(v.begin(), v.end());
+    });
+    BENCHMARK(10, SIZE, {
+        v = data;
+        ctl::stable_sort(v.begin(), v.end());
+    });
+    BENCHMARK(10, SIZE, {
+        v = data;
+        qsort(v.data(), SIZE, sizeof(int), compare_ints);
+    });
+    for (int i = 0; i < SIZE; ++i)
+        data[i] = i;
+    BENCHMARK(10, SIZE, {
+        v = data;
+        ctl::sort(v.begin(), v.end());
+    });
+    for (int i = 0; i < SIZE; ++i)
+        data[i] = rand() % 16;
+    BENCHMARK(10, SIZE, {
+        v = data;
+        ctl::sort(v.begin(), v.end());
+    });
+}
+
 int
 main()
 {
@@ -126,5 +297,23 @@ main()
     if (result != 0)
         return result;
 
+    result = test_sort_patterns_linear();
+    if (result != 0)
+        return result;
+
+    result = test_sort_small();
+    if (result != 0)
+        return result;
+
+    result = test_stable_sort();
+    if (result != 0)
+        return result;
+
+    result = test_partial_sort();
+    if (result != 0)
+        return result;
+
+    benchmark_sort();
+
     CheckForMemoryLeaks();
 }
@@ -135,5 +135,27 @@ main()
         BENCHMARK(ITERATIONS, 1, { ctl::string s(big_trunc); });
     }
 
+    {
+        // searches scan 4kb of text for a needle near the very end
+        volatile size_t sink;
+        ctl::string text;
+        for (int i = 0; i < 4096; ++i)
+            text.append("abcdefghijklmnopqrstuvwxyz       "[i % 33]);
+        text[4000] = '\n';
+        text[4010] = '"';
+        ctl::string other(text);
+        other[4090] = '!';
+        const ctl::string_view view(text);
+        const int n = ITERATIONS / 100;
+        BENCHMARK(n, 4096, { sink = view.find('\n'); });
+        BENCHMARK(n, 4096, { sink = view.find("\n\"", 0); });
+        BENCHMARK(n, 4096, { sink = view.find_first_of("\n\""); });
+        BENCHMARK(n, 4096, { sink = view.find_first_of("\"<>&"); });
+        BENCHMARK(n, 4096, { sink = view.find_last_of("\t\r"); });
+        BENCHMARK(n, 4096, { sink = text.find_first_of("\n\""); });
+        BENCHMARK(n, 4096, { sink = text.compare(other); });
+        (void)sink;
+    }
+
     CheckForMemoryLeaks();
 }
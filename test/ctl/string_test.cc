@@ -468,5 +468,41 @@ main()
             return 126;
     }
 
+    {
+        String s = "hello";
+        if (s.find('l', 3) != 3)
+            return 127;
+        if (s.find('h', 1) != String::npos)
+            return 128;
+        if (s.find_last_of('l', 2) != 2)
+            return 129;
+        if (s.find_last_of('o', 3) != String::npos)
+            return 130;
+    }
+
+    {
+        // exercise the vectorized paths with sets on both sides of 0x80
+        String s(100, '.');
+        s[37] = ',';
+        s[70] = '\xff';
+        s[90] = ';';
+        if (s.find_first_of(",;\xff") != 37)
+            return 131;
+        if (s.find_first_of(",;\xff", 38) != 70)
+            return 132;
+        if (s.find_first_of("\xff;", 71) != 90)
+            return 133;
+        if (s.find_first_of(",;\xff", 91) != String::npos)
+            return 134;
+        if (s.find_last_of(",;\xff") != 90)
+            return 135;
+        if (s.find_last_of(",\xff", 89) != 70)
+            return 136;
+        if (s.find_last_of(",;", 36) != String::npos)
+            return 137;
+        if (s.find_first_of("\x80\x7f") != String::npos)
+            return 138;
+    }
+
     CheckForMemoryLeaks();
 }
@@ -0,0 +1,218 @@
+// -*- mode:c++; indent-tabs-mode:nil; c-basic-offset:4; coding:utf-8 -*-
+// vi: set et ft=cpp ts=4 sts=4 sw=4 fenc=utf-8 :vi
+//
+// Copyright 2024 Justine Alexandra Roberts Tunney
+//
+// Permission to use, copy, modify, and/or distribute this software for
+// any purpose with or without fee is hereby granted, provided that the
+// above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+// WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+// AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+// DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+// PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+// TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "ctl/string.h"
+#include "ctl/unordered_map.h"
+#include "ctl/unordered_set.h"
+#include "libc/cosmo.h"
+
+// #include <string>
+// #include <unordered_map>
+// #include <unordered_set>
+// #define ctl std
+
+int
+rand32(void)
+{
+    /* Knuth, D.E., "The Art of Computer Programming," Vol 2,
+       Seminumerical Algorithms, Third Edition, Addison-Wesley, 1998,
+       p. 106 (line 26) & p. 108 */
+    static unsigned long long lcg = 1;
+    lcg *= 6364136223846793005;
+    lcg += 1442695040888963407;
+    return lcg >> 32;
+}
+
+int
+main()
+{
+
+    {
+        // Test construction and basic operations
+        ctl::unordered_map<int, int> m;
+        if (!m.empty() || m.size() != 0)
+            return 1;
+        if (m.find(1) != m.end())
+            return 2;
+        if (m.begin() != m.end())
+            return 3;
+        m[1] = 10;
+        m[2] = 20;
+        m[3] = 30;
+        if (m.size() != 3)
+            return 4;
+        if (m.count(2) != 1 || m.count(4) != 0)
+            return 5;
+        if (m.at(3) != 30)
+            return 6;
+    }
+
+    {
+        // Test insert, try_emplace and insert_or_assign
+        ctl::unordered_map<int, ctl::string> m;
+        auto res = m.insert({ 1, "one" });
+        if (!res.second || res.first->second != "one")
+            return 7;
+        res = m.insert({ 1, "uno" });
+        if (res.second || res.first->second != "one")
+            return 8;
+        res = m.try_emplace(1, "eins");
+        if (res.second || res.first->second != "one")
+            return 9;
+        res = m.try_emplace(2, "two");
+        if (!res.second || m[2] != "two")
+            return 10;
+        res = m.insert_or_assign(1, "uno");
+        if (res.second || m[1] != "uno")
+            return 11;
+    }
+
+    {
+        // Test erase
+        ctl::unordered_map<int, int> m;
+        for (int i = 0; i < 100; ++i)
+            m[i] = i;
+        for (int i = 0; i < 100; i += 2)
+            if (m.erase(i) != 1)
+                return 12;
+        if (m.erase(0) != 0)
+            return 13;
+        if (m.size() != 50)
+            return 14;
+        for (int i = 0; i < 100; ++i)
+            if (m.contains(i) != (i & 1))
+                return 15;
+        for (auto it = m.begin(); it != m.end();)
+            it = m.erase(it);
+        if (!m.empty())
+            return 16;
+    }
+
+    {
+        // Test iteration visits every element exactly once
+        ctl::unordered_map<int, int> m;
+        for (int i = 0; i < 1000; ++i)
+            m[i * 7] = i;
+        int count = 0;
+        long sum = 0;
+        for (const auto& entry : m) {
+            if (entry.first != entry.second * 7)
+                return 17;
+            sum += entry.second;
+            ++count;
+        }
+        if (count != 1000 || sum != 999 * 1000 / 2)
+            return 18;
+    }
+
+    {
+        // Test many insertions and deletions leave no stale entries
+        ctl::unordered_map<unsigned, unsigned> m;
+        ctl::unordered_set<unsigned> s;
+        for (int i = 0; i < 100000; ++i) {
+            unsigned k = rand32() % 5000;
+            if (rand32() & 1) {
+                m[k] = k;
+                s.insert(k);
+            } else {
+                m.erase(k);
+                s.erase(k);
+            }
+            if (m.size() != s.size())
+                return 19;
+        }
+        for (unsigned k = 0; k < 5000; ++k)
+            if (m.contains(k) != s.contains(k))
+                return 20;
+    }
+
+    {
+        // Test copy, move and comparison
+        ctl::unordered_map<ctl::string, int> m1{ { "a", 1 }, { "b", 2 } };
+        ctl::unordered_map<ctl::string, int> m2(m1);
+        if (m1 != m2)
+            return 21;
+        m2["b"] = 3;
+        if (m1 == m2)
+            return 22;
+        ctl::unordered_map<ctl::string, int> m3(ctl::move(m2));
+        if (m3.size() != 2 || !m2.empty() || m3["b"] != 3)
+            return 23;
+        m1 = m3;
+        if (m1 != m3)
+            return 24;
+        m2 = ctl::move(m1);
+        if (m2 != m3 || !m1.empty())
+            return 25;
+    }
+
+    {
+        // Test reserve doesn't rehash while inserting
+        ctl::unordered_map<int, int> m;
+        m.reserve(1000);
+        auto buckets = m.bucket_count();
+        for (int i = 0; i < 1000; ++i)
+            m[i] = i;
+        if (m.bucket_count() != buckets)
+            return 26;
+        if (m.load_factor() > m.max_load_factor())
+            return 27;
+        m.clear();
+        if (!m.empty() || m.bucket_count() != buckets)
+            return 28;
+        m.rehash(0);
+        if (m.bucket_count() != 0)
+            return 29;
+    }
+
+    {
+        // Test heterogeneous lookup
+        ctl::unordered_map<ctl::string, int, ctl::hash<ctl::string>,
+                           ctl::equal_to<>>
+          m;
+        m["hello"] = 1;
+        m["world"] = 2;
+        if (m.find("hello") == m.end())
+            return 30;
+        if (!m.contains(ctl::string_view("world")))
+            return 31;
+        if (m.count("nope"))
+            return 32;
+        if (m.erase("hello") != 1 || m.size() != 1)
+            return 33;
+    }
+
+    {
+        // Test unordered_set
+        ctl::unordered_set<int> s{ 5, 3, 1, 4, 2 };
+        if (s.size() != 5)
+            return 34;
+        if (s.insert(3).second)
+            return 35;
+        int sum = 0;
+        for (int x : s)
+            sum += x;
+        if (sum != 15)
+            return 36;
+        ctl::unordered_set<int> t{ 1, 2, 3, 4, 5 };
+        if (s != t)
+            return 37;
+    }
+
+    CheckForMemoryLeaks();
+}
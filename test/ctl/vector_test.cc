@@ -451,5 +451,25 @@ main()
             return 91;
     }
 
+    {
+        // Test growing vectors of trivially relocatable types
+        ctl::vector<ctl::string> v;
+        for (int i = 0; i < 1000; ++i)
+            v.push_back(ctl::string(i % 7 + (i & 1) * 30, 'a' + i % 26));
+        for (int i = 0; i < 1000; ++i)
+            if (v[i] != ctl::string(i % 7 + (i & 1) * 30, 'a' + i % 26))
+                return 92;
+        v.resize(10);
+        v.shrink_to_fit();
+        if (v.capacity() != 10 || v[9] != ctl::string(32, 'j'))
+            return 93;
+        ctl::vector<ctl::vector<int>> vv;
+        for (int i = 0; i < 100; ++i)
+            vv.emplace_back(i, i);
+        for (int i = 0; i < 100; ++i)
+            if (vv[i].size() != (size_t)i || (i && vv[i].back() != i))
+                return 94;
+    }
+
     CheckForMemoryLeaks();
 }
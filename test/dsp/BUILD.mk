@@ -3,5 +3,6 @@
 
 .PHONY:			o/$(MODE)/test/dsp
 o/$(MODE)/test/dsp:	o/$(MODE)/test/dsp/core		\
+			o/$(MODE)/test/dsp/mpeg		\
 			o/$(MODE)/test/dsp/scale	\
 			o/$(MODE)/test/dsp/tty
@@ -0,0 +1,122 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "dsp/core/resample.h"
+#include "dsp/core/core.h"
+#include "libc/errno.h"
+#include "libc/limits.h"
+#include "libc/macros.h"
+#include "libc/math.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/testlib.h"
+
+#define INRATE  44100
+#define OUTRATE 48000
+#define FRAMES  8192
+
+float in[FRAMES * 2];
+float out[FRAMES * 2];
+
+// returns signal to noise ratio in decibels of resampled 1khz tone
+static double ToneSnr(int inrate, int outrate) {
+  int i, m, n;
+  double s, e, w;
+  struct Resampler *r;
+  m = (long)FRAMES * inrate / MAX(inrate, outrate);
+  ASSERT_NE(NULL, (r = resampler_new(1, inrate, outrate)));
+  for (i = 0; i < m; ++i)
+    in[i] = sin(2 * M_PI * 1000 * i / inrate) * .5;
+  n = resampler_run(r, out, FRAMES, in, m);
+  resampler_free(r);
+  ASSERT_GT(n, FRAMES / 2 * MIN(inrate, outrate) / MAX(inrate, outrate));
+  // skip the start, where the filter sees silence before the tone
+  for (s = e = 0, i = n / 4; i < n; ++i) {
+    w = sin(2 * M_PI * 1000 * i / outrate) * .5;
+    s += w * w;
+    e += (out[i] - w) * (out[i] - w);
+  }
+  return 10 * log10(s / e);
+}
+
+TEST(resampler_new, badArgs_einval) {
+  ASSERT_EQ(NULL, resampler_new(0, 44100, 48000));
+  ASSERT_EQ(EINVAL, errno);
+  ASSERT_EQ(NULL, resampler_new(2, 44100, 0));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(resampler_run, upsample_preservesTone) {
+  ASSERT_LDBL_GT(ToneSnr(44100, 48000), 70);
+  ASSERT_LDBL_GT(ToneSnr(8000, 48000), 70);
+}
+
+TEST(resampler_run, downsample_preservesTone) {
+  ASSERT_LDBL_GT(ToneSnr(48000, 44100), 70);
+  ASSERT_LDBL_GT(ToneSnr(48000, 16000), 70);
+}
+
+TEST(resampler_run, smallOutputBuffer_drainsOnLaterCalls) {
+  int i, n, got;
+  struct Resampler *r;
+  ASSERT_NE(NULL, (r = resampler_new(2, 8000, 48000)));
+  for (i = 0; i < FRAMES / 8 * 2; ++i)
+    in[i] = i & 1 ? -.25 : .25;
+  n = resampler_run(r, out, 100, in, FRAMES / 8);
+  ASSERT_EQ(100, n);
+  while ((got = resampler_run(r, out + n * 2, 100, 0, 0)) > 0)
+    n += got;
+  resampler_free(r);
+  ASSERT_GT(n, FRAMES / 8 * 5);
+  ASSERT_LT(n, FRAMES / 8 * 6);
+  ASSERT_LDBL_LT(fabs(out[n - 2] - .25), .001);
+  ASSERT_LDBL_LT(fabs(out[n - 1] + .25), .001);
+}
+
+TEST(float2pcm, roundsAndClamps) {
+  float f[8] = {-2, -1, -.5f / 32768, .5f / 32768, 1.5f / 32768, 0, .5, 1};
+  int16_t p[8];
+  float2pcm(8, p, f);
+  EXPECT_EQ(INT16_MIN, p[0]);
+  EXPECT_EQ(INT16_MIN, p[1]);
+  EXPECT_EQ(-1, p[2]);
+  EXPECT_EQ(1, p[3]);
+  EXPECT_EQ(2, p[4]);
+  EXPECT_EQ(0, p[5]);
+  EXPECT_EQ(16384, p[6]);
+  EXPECT_EQ(INT16_MAX, p[7]);
+}
+
+TEST(pcm2float, roundTrips) {
+  int i;
+  int16_t p[4] = {INT16_MIN, -1, 1, INT16_MAX}, q[4];
+  pcm2float(4, in, p);
+  EXPECT_EQ(-1, in[0]);
+  float2pcm(4, q, in);
+  for (i = 0; i < 4; ++i)
+    EXPECT_EQ(p[i], q[i]);
+}
+
+BENCH(resampler_run, bench) {
+  struct Resampler *r = resampler_new(2, INRATE, OUTRATE);
+  EZBENCH2("resample 4096 stereo frames", donothing,
+           resampler_run(r, out, FRAMES, in, FRAMES / 2));
+  resampler_free(r);
+  EZBENCH2("float2pcm 16384", donothing,
+           float2pcm(FRAMES * 2, (int16_t *)out, in));
+  EZBENCH2("mixaudio 16384", donothing, mixaudio(FRAMES * 2, out, in, .5f));
+}
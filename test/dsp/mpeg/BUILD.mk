@@ -0,0 +1,54 @@
+#-*-mode:makefile-gmake;indent-tabs-mode:t;tab-width:8;coding:utf-8-*-┐
+#── vi: set noet ft=make ts=8 sw=8 fenc=utf-8 :vi ────────────────────┘
+
+PKGS += TEST_DSP_MPEG
+
+TEST_DSP_MPEG_SRCS := $(wildcard test/dsp/mpeg/*.c)
+TEST_DSP_MPEG_SRCS_TEST = $(filter %_test.c,$(TEST_DSP_MPEG_SRCS))
+TEST_DSP_MPEG_BINS = $(TEST_DSP_MPEG_COMS) $(TEST_DSP_MPEG_COMS:%=%.dbg)
+
+TEST_DSP_MPEG_OBJS =					\
+	$(TEST_DSP_MPEG_SRCS:%.c=o/$(MODE)/%.o)
+
+TEST_DSP_MPEG_COMS =					\
+	$(TEST_DSP_MPEG_SRCS:%.c=o/$(MODE)/%)
+
+TEST_DSP_MPEG_TESTS =					\
+	$(TEST_DSP_MPEG_SRCS_TEST:%.c=o/$(MODE)/%.ok)
+
+TEST_DSP_MPEG_CHECKS =					\
+	$(TEST_DSP_MPEG_SRCS_TEST:%.c=o/$(MODE)/%.runs)
+
+TEST_DSP_MPEG_DIRECTDEPS =				\
+	DSP_MPEG					\
+	LIBC_CALLS					\
+	LIBC_INTRIN					\
+	LIBC_LOG					\
+	LIBC_MEM					\
+	LIBC_NEXGEN32E					\
+	LIBC_RUNTIME					\
+	LIBC_STDIO					\
+	LIBC_STR					\
+	LIBC_TESTLIB					\
+	LIBC_TINYMATH					\
+
+TEST_DSP_MPEG_DEPS :=					\
+	$(call uniq,$(foreach x,$(TEST_DSP_MPEG_DIRECTDEPS),$($(x))))
+
+o/$(MODE)/test/dsp/mpeg/mpeg.pkg:				\
+		$(TEST_DSP_MPEG_OBJS)			\
+		$(foreach x,$(TEST_DSP_MPEG_DIRECTDEPS),$($(x)_A).pkg)
+
+o/$(MODE)/test/dsp/mpeg/%.dbg:				\
+		$(TEST_DSP_MPEG_DEPS)			\
+		o/$(MODE)/test/dsp/mpeg/%.o		\
+		o/$(MODE)/test/dsp/mpeg/mpeg.pkg		\
+		$(LIBC_TESTMAIN)			\
+		$(CRT)					\
+		$(APE_NO_MODIFY_SELF)
+	@$(APELINK)
+
+.PHONY: o/$(MODE)/test/dsp/mpeg
+o/$(MODE)/test/dsp/mpeg:					\
+		$(TEST_DSP_MPEG_BINS)			\
+		$(TEST_DSP_MPEG_CHECKS)
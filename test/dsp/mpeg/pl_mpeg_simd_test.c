@@ -0,0 +1,159 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "dsp/mpeg/pl_mpeg_simd.h"
+#include "dsp/mpeg/pl_mpeg.h"
+#include "libc/mem/gc.h"
+#include "libc/mem/mem.h"
+#include "libc/stdio/rand.h"
+#include "libc/str/str.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/testlib.h"
+
+void plm_video_idct(int *);
+
+void (*idct)(int[64]);
+void (*predict)(uint8_t *, const uint8_t *, int, int, int);
+void (*ycbcr)(uint8_t[6][PLM_SIMD_CHUNK * 2], const uint8_t *, const uint8_t *,
+              const uint8_t *, const uint8_t *, int);
+
+void SetUpOnce(void) {
+  idct = plm_simd_idct;
+  predict = plm_simd_predict;
+  ycbcr = plm_simd_ycbcr;
+}
+
+void TearDown(void) {
+  plm_simd_idct = idct;
+  plm_simd_predict = predict;
+  plm_simd_ycbcr = ycbcr;
+}
+
+// plm_video_process_macroblock() without the plm_video_t
+static void Predict(uint8_t *d, const uint8_t *s, int dw, int bs, int mode) {
+  int x, y, v;
+  const uint8_t *p;
+  for (y = 0; y < bs; ++y) {
+    for (x = 0; x < bs; ++x) {
+      p = s + y * dw + x;
+      switch (mode & 3) {
+        case 0:
+          v = p[0];
+          break;
+        case 1:
+          v = (p[0] + p[dw] + 1) >> 1;
+          break;
+        case 2:
+          v = (p[0] + p[1] + 1) >> 1;
+          break;
+        default:
+          v = (p[0] + p[1] + p[dw] + p[dw + 1] + 2) >> 2;
+          break;
+      }
+      if (mode & 4)
+        v = (d[y * dw + x] + v + 1) >> 1;
+      d[y * dw + x] = v;
+    }
+  }
+}
+
+TEST(pl_mpeg_simd, idct) {
+  int i, j, a[64], b[64];
+  if (!idct)
+    return;
+  for (i = 0; i < 10000; ++i) {
+    for (j = 0; j < 64; ++j)
+      a[j] = b[j] = (j < 8 || i & 1) ? (int)(rand() % 4096) - 2048 : 0;
+    plm_simd_idct = 0;
+    plm_video_idct(a);
+    plm_simd_idct = idct;
+    plm_video_idct(b);
+    ASSERT_EQ(0, memcmp(a, b, sizeof(a)));
+  }
+}
+
+TEST(pl_mpeg_simd, predict) {
+  int i, j, bs, mode;
+  uint8_t s[48 * 48], a[48 * 48], b[48 * 48];
+  if (!predict)
+    return;
+  for (i = 0; i < 1000; ++i) {
+    for (j = 0; j < sizeof(s); ++j) {
+      s[j] = rand();
+      a[j] = b[j] = rand();
+    }
+    bs = i & 1 ? 16 : 8;
+    mode = (i >> 1) & 7;
+    Predict(a + 49, s + 50, 48, bs, mode);
+    predict(b + 49, s + 50, 48, bs, mode);
+    ASSERT_EQ(0, memcmp(a, b, sizeof(a)), "bs=%d mode=%d", bs, mode);
+  }
+}
+
+TEST(pl_mpeg_simd, frameToBgra_oddChunkSizes) {
+  int i, stride;
+  uint8_t *a, *b;
+  plm_frame_t f = {0};
+  if (!ycbcr)
+    return;
+  f.width = 2 * 149;
+  f.height = 2 * 17;
+  f.y.width = f.width + 16;
+  f.cb.width = f.cr.width = f.width / 2 + 8;
+  f.y.data = gc(malloc(f.y.width * f.height));
+  f.cb.data = gc(malloc(f.cb.width * f.height / 2));
+  f.cr.data = gc(malloc(f.cr.width * f.height / 2));
+  for (i = 0; i < f.y.width * f.height; ++i)
+    f.y.data[i] = rand();
+  for (i = 0; i < f.cb.width * f.height / 2; ++i) {
+    f.cb.data[i] = rand();
+    f.cr.data[i] = rand();
+  }
+  stride = f.width * 7 + 12;
+  a = gc(calloc(stride, f.height));
+  b = gc(calloc(stride, f.height));
+  plm_simd_ycbcr = 0;
+  plm_frame_to_bgra(&f, a, stride);
+  plm_frame_to_rgb(&f, a + 4 * f.width, stride);
+  plm_simd_ycbcr = ycbcr;
+  plm_frame_to_bgra(&f, b, stride);
+  plm_frame_to_rgb(&f, b + 4 * f.width, stride);
+  ASSERT_EQ(0, memcmp(a, b, stride * f.height));
+}
+
+BENCH(pl_mpeg_simd, bench) {
+  int block[64] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  plm_frame_t f = {0};
+  f.width = f.y.width = 640;
+  f.height = 480;
+  f.cb.width = f.cr.width = 320;
+  f.y.data = gc(calloc(640, 480));
+  f.cb.data = gc(calloc(320, 240));
+  f.cr.data = gc(calloc(320, 240));
+  uint8_t *rgba = gc(malloc(640 * 480 * 4));
+  EZBENCH2("plm_video_idct", donothing, plm_video_idct(block));
+  EZBENCH2("plm_frame_to_bgra 640x480", donothing,
+           plm_frame_to_bgra(&f, rgba, 640 * 4));
+  plm_simd_idct = 0;
+  plm_simd_ycbcr = 0;
+  EZBENCH2("plm_video_idct [scalar]", donothing, plm_video_idct(block));
+  EZBENCH2("plm_frame_to_bgra 640x480 [scalar]", donothing,
+           plm_frame_to_bgra(&f, rgba, 640 * 4));
+  plm_simd_idct = idct;
+  plm_simd_ycbcr = ycbcr;
+}
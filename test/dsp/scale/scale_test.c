@@ -171,6 +171,27 @@ pqpppppppppppppppppoooooooooooooooooooooooppppppppppppppppprp",
                gc(bingblit(32, 61, M[0], 16, 61)));
 }
 
+TEST(gyarados, testHdImage_rowBandsAgree) {
+  long y, x;
+  unsigned char(*A)[1080][1920] = gc(malloc(1080 * 1920));
+  unsigned char(*B)[1080][1920] = gc(malloc(1080 * 1920));
+  for (y = 0; y < 1080; ++y) {
+    for (x = 0; x < 1920; ++x) {
+      A[0][y][x] = x * 7;
+      B[0][y][x] = y * 7;
+    }
+  }
+  EzGyarados(1, 1080, 1920, A, 1, 1080, 1920, A, 0, 1, 540, 960, 1080, 1920,
+             2, 2, 0, 0);
+  EzGyarados(1, 1080, 1920, B, 1, 1080, 1920, B, 0, 1, 540, 960, 1080, 1920,
+             2, 2, 0, 0);
+  for (y = 1; y < 540; ++y) {
+    ASSERT_EQ(0, memcmp(A[0][0], A[0][y], 960), "y=%ld", y);
+    for (x = 1; x < 960; ++x)
+      ASSERT_EQ(B[0][y][0], B[0][y][x], "y=%ld x=%ld", y, x);
+  }
+}
+
 TEST(Magikarp2xY, testDecimateY) {
   static unsigned char M[1][32][61], G[1][16][61], D[1][16][61];
   memcpy(M, kDieWelle, sizeof(M));
@@ -0,0 +1,87 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "dsp/tty/quant.h"
+#include "libc/stdio/rand.h"
+#include "libc/str/str.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/testlib.h"
+
+uint8_t r[1001], g[1001], b[1001];
+struct TtyRgb p[1001];
+
+void SetUp(void) {
+  int i;
+  for (i = 0; i < 1001; ++i) {
+    r[i] = rand();
+    g[i] = rand();
+    b[i] = rand();
+  }
+}
+
+void TearDown(void) {
+  ttyquantmetric(kTtyQuantEuclidean);
+}
+
+static void CheckRowMatchesPixels(void) {
+  int i;
+  struct TtyRgb q;
+  rgb2ttyn(p, r, g, b, 1001);
+  for (i = 0; i < 1001; ++i) {
+    q = rgb2tty(r[i], g[i], b[i]);
+    ASSERT_EQ(0, memcmp(&q, p + i, sizeof(q)), "i=%d", i);
+  }
+}
+
+TEST(rgb2ttyn, xterm256_matchesRgb2tty) {
+  ttyquantsetup(kTtyQuantXterm256, kTtyQuantRgb, kTtyBlocksUnicode);
+  CheckRowMatchesPixels();
+  ttyquantmetric(kTtyQuantPerceptual);
+  CheckRowMatchesPixels();
+}
+
+TEST(rgb2ttyn, ansi_matchesRgb2tty) {
+  ttyquantsetup(kTtyQuantAnsi, kTtyQuantRgb, kTtyBlocksUnicode);
+  CheckRowMatchesPixels();
+  ttyquantsetup(kTtyQuantXterm256, kTtyQuantRgb, kTtyBlocksUnicode);
+}
+
+TEST(rgb2ttyn, true_passesThrough) {
+  ttyquantsetup(kTtyQuantTrue, kTtyQuantRgb, kTtyBlocksUnicode);
+  rgb2ttyn(p, r, g, b, 1);
+  EXPECT_EQ(r[0], p[0].r);
+  EXPECT_EQ(g[0], p[0].g);
+  EXPECT_EQ(b[0], p[0].b);
+  ttyquantsetup(kTtyQuantXterm256, kTtyQuantRgb, kTtyBlocksUnicode);
+}
+
+TEST(rgb2tty, xterm256_extremesAreExact) {
+  ttyquantsetup(kTtyQuantXterm256, kTtyQuantRgb, kTtyBlocksUnicode);
+  EXPECT_EQ(16, rgb2tty(0, 0, 0).xt);
+  EXPECT_EQ(231, rgb2tty(255, 255, 255).xt);
+  EXPECT_EQ(196, rgb2tty(255, 0, 0).xt);
+  EXPECT_EQ(196, rgb2tty(300, -5, 0).xt);
+}
+
+BENCH(rgb2ttyn, bench) {
+  ttyquantsetup(kTtyQuantXterm256, kTtyQuantRgb, kTtyBlocksUnicode);
+  EZBENCH2("rgb2ttyn xterm256 [1001]", donothing, rgb2ttyn(p, r, g, b, 1001));
+  ttyquantsetup(kTtyQuantTrue, kTtyQuantRgb, kTtyBlocksUnicode);
+  EZBENCH2("rgb2ttyn true [1001]", donothing, rgb2ttyn(p, r, g, b, 1001));
+  ttyquantsetup(kTtyQuantXterm256, kTtyQuantRgb, kTtyBlocksUnicode);
+}
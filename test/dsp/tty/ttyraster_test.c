@@ -17,6 +17,7 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "dsp/tty/quant.h"
+#include "dsp/tty/tty.h"
 #include "libc/testlib/ezbench.h"
 #include "libc/testlib/testlib.h"
 #include "net/http/csscolor.h"
@@ -92,6 +93,41 @@ TEST(ttyraster_cp437, testSide) {
   EXPECT_STREQ("\e[48;2;3;3;3;38;2;139;0;0m▌\e[0m", vtbuf);
 }
 
+TEST(ttydelta, testUnchangedFrame_onlyResets) {
+  struct TtyCursor cur = {0};
+  struct TtyDelta d = {0};
+  unsigned px[2][4] = {
+      {DARKRED, DARKRED, DARKRED, DARKRED},
+      {DARKRED, DARKRED, DARKRED, DARKRED},
+  };
+  ttyraster_true_setup();
+  ttydelta(&d, vtbuf, &cur, (void *)px, 2, 4, kBlack, kBlack);
+  EXPECT_STREQ("\e[48;2;139;0;0m  \r\e[0m", vtbuf);
+  ttydelta(&d, vtbuf, &cur, (void *)px, 2, 4, kBlack, kBlack);
+  EXPECT_STREQ("\e[0m", vtbuf);
+  d.dirty = true;
+  ttydelta(&d, vtbuf, &cur, (void *)px, 2, 4, kBlack, kBlack);
+  EXPECT_STREQ("\e[48;2;139;0;0m  \r\e[0m", vtbuf);
+  ttydeltafree(&d);
+}
+
+TEST(ttydelta, testChangedCell_movesCursorToIt) {
+  struct TtyCursor cur = {0};
+  struct TtyDelta d = {0};
+  unsigned px[2][4] = {
+      {DARKRED, DARKRED, DARKRED, DARKRED},
+      {DARKRED, DARKRED, DARKRED, DARKRED},
+  };
+  ttyraster_true_setup();
+  ttydelta(&d, vtbuf, &cur, (void *)px, 2, 4, kBlack, kBlack);
+  px[0][3] = GRAY1;
+  ttydelta(&d, vtbuf, &cur, (void *)px, 2, 4, kBlack, kBlack);
+  EXPECT_STREQ("\e[C\e[48;2;139;0;0;38;2;3;3;3m▝\r\e[0m", vtbuf);
+  EXPECT_EQ(0, cur.y);
+  EXPECT_EQ(0, cur.x);
+  ttydeltafree(&d);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 void ttyraster_xterm256_setup(void) {
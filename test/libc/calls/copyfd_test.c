@@ -0,0 +1,63 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/o.h"
+#include "libc/testlib/testlib.h"
+
+void SetUpOnce(void) {
+  testlib_enable_tmp_setup_teardown();
+}
+
+TEST(copyfd, fileToFile_advancesBothPositions) {
+  char buf[8] = {0};
+  ASSERT_SYS(0, 3, creat("a", 0644));
+  ASSERT_SYS(0, 6, write(3, "abcdef", 6));
+  ASSERT_SYS(0, 0, close(3));
+  ASSERT_SYS(0, 3, open("a", O_RDONLY));
+  ASSERT_SYS(0, 4, creat("b", 0644));
+  ASSERT_SYS(0, 1, lseek(3, 1, SEEK_SET));
+  ASSERT_SYS(0, 3, copyfd(3, 4, 3));
+  ASSERT_SYS(0, 4, lseek(3, 0, SEEK_CUR));
+  ASSERT_SYS(0, 3, lseek(4, 0, SEEK_CUR));
+  ASSERT_SYS(0, 2, copyfd(3, 4, -1));
+  ASSERT_SYS(0, 0, copyfd(3, 4, -1));
+  ASSERT_SYS(0, 0, close(4));
+  ASSERT_SYS(0, 0, close(3));
+  ASSERT_SYS(0, 3, open("b", O_RDONLY));
+  ASSERT_SYS(0, 5, read(3, buf, sizeof(buf)));
+  ASSERT_STREQ("bcdef", buf);
+  ASSERT_SYS(0, 0, close(3));
+}
+
+TEST(copyfd, fileToPipe) {
+  int p[2];
+  char buf[8] = {0};
+  ASSERT_SYS(0, 3, creat("a", 0644));
+  ASSERT_SYS(0, 5, write(3, "hello", 5));
+  ASSERT_SYS(0, 0, close(3));
+  ASSERT_SYS(0, 3, open("a", O_RDONLY));
+  ASSERT_SYS(0, 0, pipe(p));
+  ASSERT_SYS(0, 5, copyfd(3, p[1], -1));
+  ASSERT_SYS(0, 0, close(p[1]));
+  ASSERT_SYS(0, 5, read(p[0], buf, sizeof(buf)));
+  ASSERT_STREQ("hello", buf);
+  ASSERT_SYS(0, 0, close(p[0]));
+  ASSERT_SYS(0, 0, close(3));
+}
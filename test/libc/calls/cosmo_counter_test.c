@@ -0,0 +1,61 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/cosmo.h"
+#include "libc/intrin/atomic.h"
+#include "libc/testlib/benchmark.h"
+#include "libc/testlib/testlib.h"
+#include "libc/thread/thread.h"
+
+#define THREADS    8
+#define ITERATIONS 100000
+
+cosmo_counter_t counter = COSMO_COUNTER_INITIALIZER;
+
+void *Adder(void *arg) {
+  for (int i = 0; i < ITERATIONS; ++i) {
+    cosmo_counter_add(&counter, 1);
+    if (!(i % 1000))
+      pthread_yield_np();
+  }
+  return 0;
+}
+
+TEST(cosmo_counter, test) {
+  pthread_t t[THREADS];
+  for (int i = 0; i < THREADS; ++i)
+    ASSERT_EQ(0, pthread_create(t + i, 0, Adder, 0));
+  for (int i = 0; i < THREADS; ++i)
+    EXPECT_EQ(0, pthread_join(t[i], 0));
+  EXPECT_EQ(THREADS * ITERATIONS, cosmo_counter_get(&counter));
+}
+
+TEST(cosmo_counter, negative) {
+  cosmo_counter_t c = COSMO_COUNTER_INITIALIZER;
+  EXPECT_EQ(0, cosmo_counter_get(&c));
+  cosmo_counter_add(&c, 5);
+  cosmo_counter_add(&c, -7);
+  EXPECT_EQ(-2, cosmo_counter_get(&c));
+}
+
+BENCH(cosmo_counter, bench) {
+  _Atomic(long) x = 0;
+  cosmo_counter_t c = COSMO_COUNTER_INITIALIZER;
+  BENCHMARK(1000, 1, cosmo_counter_add(&c, 1));
+  BENCHMARK(1000, 1, atomic_fetch_add(&x, 1));
+}
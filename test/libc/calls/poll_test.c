@@ -388,3 +388,24 @@ TEST(poll, pipein_pollinout_timeout) {
   EXPECT_SYS(0, 0, close(pipefds[1]));
   EXPECT_SYS(0, 0, close(pipefds[0]));
 }
+
+TEST(poll, manySockets_reportsTheOneThatsReady) {
+  int i, n = 200, (*sv)[2];
+  struct pollfd *fds;
+  sv = gc(xcalloc(n, sizeof(*sv)));
+  fds = gc(xcalloc(n, sizeof(*fds)));
+  for (i = 0; i < n; ++i) {
+    ASSERT_SYS(0, 0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv[i]));
+    fds[i].fd = sv[i][0];
+    fds[i].events = POLLIN;
+  }
+  EXPECT_SYS(0, 0, poll(fds, n, 0));
+  EXPECT_SYS(0, 1, write(sv[n - 3][1], "x", 1));
+  EXPECT_SYS(0, 1, poll(fds, n, -1));
+  for (i = 0; i < n; ++i)
+    EXPECT_EQ(i == n - 3 ? POLLIN : 0, fds[i].revents & POLLIN);
+  for (i = 0; i < n; ++i) {
+    EXPECT_SYS(0, 0, close(sv[i][1]));
+    EXPECT_SYS(0, 0, close(sv[i][0]));
+  }
+}
@@ -0,0 +1,87 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/calls/struct/stat.h"
+#include "libc/dce.h"
+#include "libc/errno.h"
+#include "libc/runtime/runtime.h"
+#include "libc/stdio/stdio.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/o.h"
+#include "libc/sysv/consts/s.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/testlib.h"
+
+// stat() on windows consults directory listings when this is set, and
+// these tests make sure it still notices what this process has changed
+
+void SetUpOnce(void) {
+  setenv("COSMO_STATCACHE", "60000", true);
+  testlib_enable_tmp_setup_teardown();
+}
+
+TEST(statcache, seesCreateWriteAndUnlink) {
+  int fd;
+  struct stat st;
+  ASSERT_SYS(ENOENT, -1, stat("hi.c", &st));
+  ASSERT_SYS(0, 3, (fd = creat("hi.c", 0644)));
+  EXPECT_SYS(0, 0, stat("hi.c", &st));
+  EXPECT_TRUE(S_ISREG(st.st_mode));
+  EXPECT_EQ(0, st.st_size);
+  EXPECT_SYS(0, 5, write(fd, "hello", 5));
+  EXPECT_SYS(0, 0, stat("hi.c", &st));
+  EXPECT_EQ(5, st.st_size);
+  EXPECT_SYS(0, 0, close(fd));
+  EXPECT_SYS(0, 0, unlink("hi.c"));
+  EXPECT_SYS(ENOENT, -1, stat("hi.c", &st));
+}
+
+TEST(statcache, seesDirectoriesAndRenames) {
+  struct stat st;
+  ASSERT_SYS(0, 0, mkdir("d", 0755));
+  ASSERT_SYS(0, 0, close(creat("d/a.o", 0644)));
+  EXPECT_SYS(0, 0, stat("d", &st));
+  EXPECT_TRUE(S_ISDIR(st.st_mode));
+  EXPECT_SYS(0, 0, stat("d/a.o", &st));
+  EXPECT_SYS(0, 0, rename("d/a.o", "d/b.o"));
+  EXPECT_SYS(ENOENT, -1, stat("d/a.o", &st));
+  EXPECT_SYS(0, 0, stat("d/b.o", &st));
+  EXPECT_SYS(ENOTDIR, -1, stat("d/b.o/c", &st));
+}
+
+TEST(statcache, matchesFstat) {
+  int fd;
+  struct stat st1, st2;
+  ASSERT_SYS(0, 3, (fd = open("x.h", O_CREAT | O_RDWR, 0644)));
+  EXPECT_SYS(0, 3, write(fd, "abc", 3));
+  EXPECT_SYS(0, 0, fstat(fd, &st1));
+  EXPECT_SYS(0, 0, stat("x.h", &st2));
+  EXPECT_EQ(st1.st_dev, st2.st_dev);
+  EXPECT_EQ(st1.st_ino, st2.st_ino);
+  EXPECT_EQ(st1.st_size, st2.st_size);
+  EXPECT_EQ(st1.st_mode, st2.st_mode);
+  EXPECT_SYS(0, 0, close(fd));
+}
+
+BENCH(statcache, bench) {
+  struct stat st;
+  ASSERT_SYS(0, 0, close(creat("hi.c", 0644)));
+  EZBENCH2("stat hit", donothing, stat("hi.c", &st));
+  EZBENCH2("stat miss", donothing, stat("lo.c", &st));
+}
@@ -18,6 +18,7 @@
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/calls/struct/timespec.h"
 #include "libc/calls/struct/timeval.h"
+#include "libc/cosmotime.h"
 #include "libc/limits.h"
 #include "libc/stdio/rand.h"
 #include "libc/testlib/testlib.h"
@@ -106,3 +107,17 @@ TEST(timespec_sub, math) {
     EXPECT_TRUE(!timespec_cmp(x, timespec_add(timespec_sub(x, y), y)));
   }
 }
+
+TEST(timespec_real_coarse, isCloseToRealTime) {
+  struct timespec t = timespec_real_coarse();
+  EXPECT_LT(timespec_tomillis(timespec_subz(timespec_real(), t)), 100);
+  timespec_sleep(0, timespec_frommillis(5));
+  EXPECT_GT(timespec_cmp(timespec_real_coarse(), t), 0);
+}
+
+TEST(timespec_mono_coarse, isCloseToMonotonicTime) {
+  struct timespec t = timespec_mono_coarse();
+  EXPECT_LT(timespec_tomillis(timespec_subz(timespec_mono(), t)), 100);
+  timespec_sleep(0, timespec_frommillis(5));
+  EXPECT_GT(timespec_cmp(timespec_mono_coarse(), t), 0);
+}
@@ -19,6 +19,8 @@
 #include "libc/fmt/conv.h"
 #include "libc/fmt/itoa.h"
 #include "libc/limits.h"
+#include "libc/stdio/stdio.h"
+#include "libc/str/str.h"
 #include "libc/testlib/ezbench.h"
 #include "libc/testlib/testlib.h"
 
@@ -48,6 +50,25 @@ TEST(FormatUint64, test) {
   EXPECT_STREQ("9223372036854775808", buf);
 }
 
+TEST(FormatUint64, powersOfTen_matchesPrintf) {
+  char a[21], b[21], *e;
+  uint64_t x;
+  for (x = 1;; x *= 10) {
+    for (uint64_t y = x - 1; y <= x + 1; ++y) {
+      e = FormatUint64(a, y);
+      ASSERT_EQ(strlen(a), e - a);
+      snprintf(b, sizeof(b), "%lu", y);
+      ASSERT_STREQ(b, a);
+      e = FormatUint32(a, y);
+      ASSERT_EQ(strlen(a), e - a);
+      snprintf(b, sizeof(b), "%u", (uint32_t)y);
+      ASSERT_STREQ(b, a);
+    }
+    if (x > UINT64_MAX / 10)
+      break;
+  }
+}
+
 BENCH(itoa64radix10, bench) {
   char b[21];
   EZBENCH2("itoa64radix10", donothing, FormatUint64(b, UINT64_MAX));
@@ -0,0 +1,120 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/cosmo.h"
+#include "libc/math.h"
+#include "libc/mem/gc.h"
+#include "libc/mem/mem.h"
+#include "libc/stdio/rand.h"
+#include "libc/str/str.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/testlib.h"
+
+#define N 100003
+
+float f[N + 1];
+uint16_t h[65536 + 1];
+
+static float RandomFloat(void) {
+  float x;
+  uint32_t u = _rand64();
+  if (u & 1)
+    u &= 0x8fffffff;  // mostly in range of binary16
+  memcpy(&x, &u, 4);
+  return x;
+}
+
+TEST(cosmo_f16_to_f32, allHalfs_matchCast) {
+  int i;
+  float x;
+  _Float16 y;
+  for (i = 0; i < 65536; ++i)
+    h[i + 1] = i;
+  cosmo_f16_to_f32(f + 1, h + 1, 65536);  // misaligned on purpose
+  for (i = 0; i < 65536; ++i) {
+    memcpy(&y, h + i + 1, 2);
+    x = y;
+    ASSERT_EQ(0, memcmp(&x, f + i + 1, 4));
+  }
+}
+
+TEST(cosmo_f32_to_f16, randomFloats_matchCast) {
+  int i;
+  uint16_t w;
+  _Float16 y;
+  uint16_t *o = gc(malloc(N * sizeof(uint16_t)));
+  for (i = 0; i < N; ++i)
+    f[i] = RandomFloat();
+  cosmo_f32_to_f16(o, f, N);
+  for (i = 0; i < N; ++i) {
+    y = f[i];
+    memcpy(&w, &y, 2);
+    if (isnan(f[i]))
+      ASSERT_EQ(0x7c00, o[i] & 0x7c00);
+    else
+      ASSERT_EQ(w, o[i]);
+  }
+}
+
+TEST(cosmo_bf16_to_f32, allBrains_matchCast) {
+  int i;
+  float x;
+  __bf16 y;
+  for (i = 0; i < 65536; ++i)
+    h[i + 1] = i;
+  cosmo_bf16_to_f32(f + 1, h + 1, 65536);
+  for (i = 0; i < 65536; ++i) {
+    memcpy(&y, h + i + 1, 2);
+    x = y;
+    ASSERT_EQ(0, memcmp(&x, f + i + 1, 4));
+  }
+}
+
+TEST(cosmo_f32_to_bf16, randomFloats_matchCast) {
+  int i;
+  uint16_t w;
+  __bf16 y;
+  uint16_t *o = gc(malloc(N * sizeof(uint16_t)));
+  for (i = 0; i < N; ++i)
+    f[i] = RandomFloat();
+  cosmo_f32_to_bf16(o, f, N);
+  for (i = 0; i < N; ++i) {
+    y = f[i];
+    memcpy(&w, &y, 2);
+    ASSERT_EQ(w, o[i]);
+  }
+}
+
+BENCH(cosmo_f16_to_f32, bench) {
+  int i;
+  _Float16 y;
+  EZBENCH2("cosmo_f16_to_f32 64k", donothing,
+           cosmo_f16_to_f32(f, h, 65536));
+  EZBENCH2("cosmo_f32_to_f16 64k", donothing,
+           cosmo_f32_to_f16(h, f, 65536));
+  EZBENCH2("cosmo_bf16_to_f32 64k", donothing,
+           cosmo_bf16_to_f32(f, h, 65536));
+  EZBENCH2("cosmo_f32_to_bf16 64k", donothing,
+           cosmo_f32_to_bf16(h, f, 65536));
+  EZBENCH2("_Float16 cast 64k", donothing, ({
+             for (i = 0; i < 65536; ++i) {
+               memcpy(&y, h + i, 2);
+               f[i] = y;
+             }
+           }));
+}
@@ -0,0 +1,69 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/cosmo.h"
+#include "libc/errno.h"
+#include "libc/mem/mem.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/o.h"
+#include "libc/testlib/testlib.h"
+
+static char buf[65536];
+
+void SetUpOnce(void) {
+  testlib_enable_tmp_setup_teardown();
+  ASSERT_SYS(0, 0, cosmo_heapprof_start(1, 0, 0));
+}
+
+static const char *Dump(void) {
+  ssize_t n;
+  ASSERT_SYS(0, 3, creat("heap.prof", 0644));
+  ASSERT_SYS(0, 0, cosmo_heapprof_dump(3));
+  ASSERT_SYS(0, 0, close(3));
+  ASSERT_SYS(0, 3, open("heap.prof", O_RDONLY));
+  n = read(3, buf, sizeof(buf) - 1);
+  ASSERT_NE(-1, n);
+  buf[n] = 0;
+  ASSERT_SYS(0, 0, close(3));
+  return buf;
+}
+
+TEST(cosmo_heapprof_start, onlyOnce) {
+  ASSERT_SYS(EBUSY, -1, cosmo_heapprof_start(1, 0, 0));
+}
+
+TEST(cosmo_heapprof_dump, reportsLiveAllocations) {
+  char *p = malloc(12345);
+  ASSERT_NE(NULL, p);
+  ASSERT_TRUE(startswith(Dump(), "heap profile: "));
+  ASSERT_NE(NULL, strstr(buf, "\n1: 12345 [1: 12345] @ 0x"));
+  ASSERT_NE(NULL, strstr(buf, "\nMAPPED_LIBRARIES:\n"));
+  free(p);
+  ASSERT_EQ(NULL, strstr(Dump(), "\n1: 12345 ["));
+}
+
+TEST(cosmo_heapprof_dump, followsRealloc) {
+  char *p = malloc(4321);
+  ASSERT_NE(NULL, p);
+  p = realloc(p, 54321);
+  ASSERT_NE(NULL, p);
+  ASSERT_EQ(NULL, strstr(Dump(), "\n1: 4321 ["));
+  ASSERT_NE(NULL, strstr(buf, "\n1: 54321 ["));
+  free(p);
+}
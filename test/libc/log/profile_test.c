@@ -0,0 +1,85 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/cosmo.h"
+#include "libc/cosmotime.h"
+#include "libc/errno.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/o.h"
+#include "libc/testlib/testlib.h"
+
+static char buf[65536];
+
+void SetUpOnce(void) {
+  testlib_enable_tmp_setup_teardown();
+}
+
+static dontinline void Spin(void) {
+  static volatile unsigned x;
+  struct timespec deadline;
+  deadline = timespec_add(timespec_real(), timespec_frommillis(300));
+  while (timespec_cmp(timespec_real(), deadline) < 0)
+    for (int i = 0; i < 10000; ++i)
+      x = x * 31 + i;
+}
+
+static ssize_t Slurp(const char *path) {
+  ssize_t n;
+  ASSERT_SYS(0, 3, open(path, O_RDONLY));
+  n = read(3, buf, sizeof(buf) - 1);
+  ASSERT_NE(-1, n);
+  buf[n] = 0;
+  ASSERT_SYS(0, 0, close(3));
+  return n;
+}
+
+TEST(cosmo_profile_start, badArguments) {
+  ASSERT_SYS(EINVAL, -1, cosmo_profile_start(0, 0, "cpu.prof"));
+  ASSERT_SYS(EINVAL, -1, cosmo_profile_start(2000000, 0, "cpu.prof"));
+  ASSERT_SYS(EINVAL, -1, cosmo_profile_start(100, 0x80, "cpu.prof"));
+}
+
+TEST(cosmo_profile_stop, notRunning) {
+  ASSERT_SYS(EINVAL, -1, cosmo_profile_stop());
+  ASSERT_SYS(EINVAL, -1, cosmo_profile_dump(1));
+}
+
+TEST(cosmo_profile_start, writesPprofHeader) {
+  uintptr_t *w = (uintptr_t *)buf;
+  ASSERT_SYS(0, 0, cosmo_profile_start(1000, 0, "cpu.prof"));
+  ASSERT_SYS(EBUSY, -1, cosmo_profile_start(1000, 0, "cpu.prof"));
+  Spin();
+  ASSERT_SYS(0, 0, cosmo_profile_stop());
+  ASSERT_GT(Slurp("cpu.prof"), 5 * sizeof(uintptr_t));
+  ASSERT_EQ(0, w[0]);
+  ASSERT_EQ(3, w[1]);
+  ASSERT_EQ(0, w[2]);
+  ASSERT_EQ(1000, w[3]);
+  ASSERT_EQ(0, w[4]);
+  ASSERT_NE(0, w[5]);  // first sample has a count
+}
+
+TEST(cosmo_profile_start, writesFoldedStacks) {
+  ASSERT_SYS(0, 0,
+             cosmo_profile_start(1000, COSMO_PROFILE_FOLDED, "cpu.folded"));
+  Spin();
+  ASSERT_SYS(0, 0, cosmo_profile_stop());
+  Slurp("cpu.folded");
+  ASSERT_NE(NULL, strstr(buf, "Spin"));
+}
@@ -0,0 +1,105 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/cosmo.h"
+#include "libc/errno.h"
+#include "libc/str/str.h"
+#include "libc/testlib/testlib.h"
+
+struct CosmoArena *a;
+
+void SetUp(void) {
+  ASSERT_NE(NULL, (a = cosmo_arena_new(256, 0)));
+}
+
+void TearDown(void) {
+  cosmo_arena_free(a);
+}
+
+TEST(cosmo_arena_new, badFlags_einval) {
+  ASSERT_EQ(NULL, cosmo_arena_new(0, -1));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(cosmo_arena_alloc, bumpsWithinChunk) {
+  char *p, *q;
+  ASSERT_NE(NULL, (p = cosmo_arena_alloc(a, 10, 1)));
+  ASSERT_NE(NULL, (q = cosmo_arena_alloc(a, 10, 1)));
+  ASSERT_EQ(p + 10, q);
+}
+
+TEST(cosmo_arena_alloc, honorsAlignment) {
+  ASSERT_NE(NULL, cosmo_arena_alloc(a, 1, 1));
+  ASSERT_EQ(0, (uintptr_t)cosmo_arena_alloc(a, 1, 0) & 15);
+  ASSERT_EQ(0, (uintptr_t)cosmo_arena_alloc(a, 1, 64) & 63);
+  ASSERT_EQ(NULL, cosmo_arena_alloc(a, 1, 3));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(cosmo_arena_alloc, bigRequestGetsOwnChunk) {
+  char *p;
+  ASSERT_NE(NULL, (p = cosmo_arena_alloc(a, 10000, 0)));
+  memset(p, 1, 10000);
+  ASSERT_NE(NULL, (p = cosmo_arena_alloc(a, 100, 0)));
+  memset(p, 2, 100);
+}
+
+TEST(cosmo_arena_alloc, overflow_enomem) {
+  ASSERT_EQ(NULL, cosmo_arena_alloc(a, -1, 16));
+  ASSERT_EQ(ENOMEM, errno);
+}
+
+TEST(cosmo_arena_reset, rewindsToMark) {
+  char *p, *q, *m;
+  ASSERT_NE(NULL, cosmo_arena_alloc(a, 8, 1));
+  m = cosmo_arena_mark(a);
+  ASSERT_NE(NULL, (p = cosmo_arena_alloc(a, 8, 1)));
+  for (int i = 0; i < 100; ++i)
+    ASSERT_NE(NULL, cosmo_arena_alloc(a, 100, 1));
+  cosmo_arena_reset(a, m);
+  ASSERT_NE(NULL, (q = cosmo_arena_alloc(a, 8, 1)));
+  ASSERT_EQ(p, q);
+}
+
+TEST(cosmo_arena_reset, nullReleasesEverything) {
+  for (int i = 0; i < 100; ++i)
+    ASSERT_NE(NULL, cosmo_arena_alloc(a, 100, 1));
+  cosmo_arena_reset(a, 0);
+  ASSERT_EQ(NULL, cosmo_arena_mark(a));
+}
+
+TEST(cosmo_arena_new, threadsafe) {
+  struct CosmoArena *b;
+  ASSERT_NE(NULL, (b = cosmo_arena_new(0, COSMO_ARENA_THREADSAFE)));
+  ASSERT_NE(NULL, cosmo_arena_alloc(b, 100, 0));
+  cosmo_arena_free(b);
+}
+
+TEST(cosmo_arena_new, nodelocal) {
+  char *p;
+  struct CosmoArena *b;
+  ASSERT_NE(NULL, (b = cosmo_arena_new(0, COSMO_ARENA_NODELOCAL)));
+  ASSERT_NE(NULL, (p = cosmo_arena_alloc(b, 100, 0)));
+  memset(p, 1, 100);
+  ASSERT_NE(NULL, (p = cosmo_arena_alloc(b, 200000, 0)));
+  memset(p, 2, 200000);
+  cosmo_arena_reset(b, 0);
+  ASSERT_NE(NULL, (p = cosmo_arena_alloc(b, 100, 0)));
+  memset(p, 3, 100);
+  cosmo_arena_free(b);
+}
@@ -0,0 +1,93 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/cosmo.h"
+#include "libc/errno.h"
+#include "libc/str/str.h"
+#include "libc/testlib/testlib.h"
+#include "libc/thread/thread.h"
+
+struct CosmoPool *p;
+
+void SetUp(void) {
+  ASSERT_NE(NULL, (p = cosmo_pool_new(40, 0, 0)));
+}
+
+void TearDown(void) {
+  cosmo_pool_free(p);
+}
+
+TEST(cosmo_pool_new, badArgs_einval) {
+  ASSERT_EQ(NULL, cosmo_pool_new(8, 3, 0));
+  ASSERT_EQ(EINVAL, errno);
+  ASSERT_EQ(NULL, cosmo_pool_new(8, 0, -1));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(cosmo_pool_get, honorsAlignment) {
+  struct CosmoPool *q;
+  ASSERT_NE(NULL, (q = cosmo_pool_new(1, 64, 0)));
+  for (int i = 0; i < 100; ++i)
+    ASSERT_EQ(0, (uintptr_t)cosmo_pool_get(q) & 63);
+  cosmo_pool_free(q);
+}
+
+TEST(cosmo_pool_get, objectsDontOverlap) {
+  char *v[1000];
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_NE(NULL, (v[i] = cosmo_pool_get(p)));
+    memset(v[i], i, 40);
+  }
+  for (int i = 0; i < 1000; ++i)
+    for (int j = 0; j < 40; ++j)
+      ASSERT_EQ((char)i, v[i][j]);
+  for (int i = 0; i < 1000; ++i)
+    cosmo_pool_put(p, v[i]);
+}
+
+TEST(cosmo_pool_put, null_isIgnored) {
+  cosmo_pool_put(p, 0);
+}
+
+void *Worker(void *arg) {
+  char *v[200];
+  for (int r = 0; r < 1000; ++r) {
+    int n = r % 200;
+    for (int i = 0; i < n; ++i) {
+      v[i] = cosmo_pool_get(p);
+      memset(v[i], (intptr_t)arg, 40);
+    }
+    for (int i = 0; i < n; ++i) {
+      if (v[i][39] != (char)(intptr_t)arg)
+        return (void *)1;
+      cosmo_pool_put(p, v[i]);
+    }
+  }
+  return 0;
+}
+
+TEST(cosmo_pool, threads) {
+  void *rc;
+  pthread_t th[8];
+  for (intptr_t i = 0; i < 8; ++i)
+    ASSERT_EQ(0, pthread_create(th + i, 0, Worker, (void *)i));
+  for (int i = 0; i < 8; ++i) {
+    ASSERT_EQ(0, pthread_join(th[i], &rc));
+    ASSERT_EQ(NULL, rc);
+  }
+}
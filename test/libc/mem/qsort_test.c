@@ -182,6 +182,69 @@ TEST(qsort, equivalence_reverse) {
   ASSERT_EQ(0, memcmp(b, c, n * sizeof(long)));
 }
 
+int CompareKey(const void *a, const void *b) {
+  unsigned x, y;
+  memcpy(&x, a, sizeof(x));
+  memcpy(&y, b, sizeof(y));
+  if (x < y)
+    return -1;
+  if (x > y)
+    return +1;
+  return 0;
+}
+
+unsigned MakeKey(int pattern, size_t i, size_t n) {
+  switch (pattern) {
+    case 0:
+      return lemur64();
+    case 1:
+      return i;
+    case 2:
+      return n - i;
+    case 3:
+      return lemur64() % 4;
+    case 4:
+      return i < n / 2 ? i : n - i;
+    case 5:
+      return i + lemur64() % 3;
+    case 6:
+      return 7;
+    default:
+      return i % 2 ? i : n - i;
+  }
+}
+
+TEST(qsort, patterns) {
+  char *a, *b;
+  int pattern, k;
+  size_t i, j, n, es;
+  static const size_t kSizes[] = {1, 2, 3, 10, 23, 24, 25, 129, 1000, 5000};
+  static const size_t kWidths[] = {4, 8, 12, 16, 24};
+  for (pattern = 0; pattern < 8; ++pattern) {
+    for (i = 0; i < ARRAYLEN(kSizes); ++i) {
+      for (k = 0; k < ARRAYLEN(kWidths); ++k) {
+        n = kSizes[i];
+        es = kWidths[k];
+        a = malloc(n * es);
+        b = malloc(n * es);
+        for (j = 0; j < n * es; ++j)
+          a[j] = lemur64();
+        for (j = 0; j < n; ++j) {
+          unsigned key = MakeKey(pattern, j, n);
+          memcpy(a + j * es, &key, sizeof(key));
+        }
+        memcpy(b, a, n * es);
+        qsort(a, n, es, CompareKey);
+        mergesort(b, n, es, CompareKey);
+        for (j = 0; j < n; ++j)
+          ASSERT_EQ(0, CompareKey(a + j * es, b + j * es));
+        free(b);
+        free(a);
+      }
+    }
+  }
+}
+
 BENCH(qsort, bench) {
   size_t i;
   size_t n = 1000;
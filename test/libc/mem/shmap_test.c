@@ -0,0 +1,138 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/cosmo.h"
+#include "libc/errno.h"
+#include "libc/fmt/itoa.h"
+#include "libc/runtime/runtime.h"
+#include "libc/str/str.h"
+#include "libc/testlib/benchmark.h"
+#include "libc/testlib/testlib.h"
+
+size_t n;
+struct CosmoShmap *m;
+
+void SetUp(void) {
+  n = cosmo_shmap_size(64, 32);
+  ASSERT_NE(NULL, (m = cosmo_shmap_init(_mapshared(n), 64, 32)));
+}
+
+void TearDown(void) {
+  ASSERT_SYS(0, 0, munmap(m, n));
+}
+
+TEST(cosmo_shmap_init, null_einval) {
+  ASSERT_EQ(NULL, cosmo_shmap_init(0, 64, 32));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(cosmo_shmap_get, missing_enoent) {
+  char buf[8];
+  ASSERT_SYS(ENOENT, -1, cosmo_shmap_get(m, "k", 1, buf, sizeof(buf)));
+}
+
+TEST(cosmo_shmap_put, test) {
+  char buf[8];
+  ASSERT_SYS(0, 0, cosmo_shmap_put(m, "key", 3, "hello", 5));
+  ASSERT_SYS(0, 5, cosmo_shmap_get(m, "key", 3, buf, sizeof(buf)));
+  ASSERT_EQ(0, memcmp(buf, "hello", 5));
+  ASSERT_SYS(0, 0, cosmo_shmap_put(m, "key", 3, "hi", 2));
+  ASSERT_SYS(0, 2, cosmo_shmap_get(m, "key", 3, buf, sizeof(buf)));
+  ASSERT_EQ(0, memcmp(buf, "hi", 2));
+  ASSERT_SYS(0, 0, cosmo_shmap_put(m, "", 0, "", 0));
+  ASSERT_SYS(0, 0, cosmo_shmap_get(m, "", 0, buf, sizeof(buf)));
+}
+
+TEST(cosmo_shmap_get, smallBuffer_truncatesButReturnsLength) {
+  char buf[3];
+  ASSERT_SYS(0, 0, cosmo_shmap_put(m, "k", 1, "hello", 5));
+  ASSERT_SYS(0, 5, cosmo_shmap_get(m, "k", 1, buf, sizeof(buf)));
+  ASSERT_EQ(0, memcmp(buf, "hel", 3));
+}
+
+TEST(cosmo_shmap_put, tooBig_emsgsize) {
+  char big[33] = {0};
+  ASSERT_SYS(0, 0, cosmo_shmap_put(m, big, 16, big, 16));
+  ASSERT_SYS(EMSGSIZE, -1, cosmo_shmap_put(m, big, 16, big, 17));
+  ASSERT_SYS(EMSGSIZE, -1, cosmo_shmap_put(m, big, 33, "", 0));
+  ASSERT_SYS(EMSGSIZE, -1, cosmo_shmap_put(m, big, 1, big, -1));
+}
+
+TEST(cosmo_shmap_del, test) {
+  char buf[8];
+  ASSERT_FALSE(cosmo_shmap_del(m, "k", 1));
+  ASSERT_SYS(0, 0, cosmo_shmap_put(m, "k", 1, "v", 1));
+  ASSERT_TRUE(cosmo_shmap_del(m, "k", 1));
+  ASSERT_SYS(ENOENT, -1, cosmo_shmap_get(m, "k", 1, buf, sizeof(buf)));
+  ASSERT_FALSE(cosmo_shmap_del(m, "k", 1));
+}
+
+TEST(cosmo_shmap_put, overflow_evictsLeastRecentlyUsed) {
+  int i, hits;
+  char key[21], buf[21];
+  // first key is touched often, so it should survive being flooded
+  ASSERT_SYS(0, 0, cosmo_shmap_put(m, "hot", 3, "1", 1));
+  for (i = 0; i < 10000; ++i) {
+    FormatInt32(key, i);
+    ASSERT_SYS(0, 0, cosmo_shmap_put(m, key, strlen(key), key, strlen(key)));
+    ASSERT_SYS(0, 1, cosmo_shmap_get(m, "hot", 3, buf, sizeof(buf)));
+  }
+  for (hits = i = 0; i < 10000; ++i) {
+    FormatInt32(key, i);
+    if (cosmo_shmap_get(m, key, strlen(key), buf, sizeof(buf)) != -1) {
+      ASSERT_EQ(0, memcmp(buf, key, strlen(key)));
+      ++hits;
+    }
+  }
+  ASSERT_GT(hits, 32);
+  ASSERT_LT(hits, 64);
+  ASSERT_TRUE(cosmo_shmap_del(m, "hot", 3));
+}
+
+TEST(cosmo_shmap, processes) {
+  int i, j, ws, pid, rc;
+  char key[21], buf[21];
+  for (i = 0; i < 4; ++i) {
+    ASSERT_NE(-1, (pid = fork()));
+    if (!pid) {
+      rc = 0;
+      for (j = 0; j < 20000; ++j) {
+        FormatInt32(key, j % 100);
+        cosmo_shmap_put(m, key, strlen(key), key, strlen(key));
+        if ((rc = cosmo_shmap_get(m, key, strlen(key), buf, sizeof(buf))) !=
+            -1)
+          if (rc != strlen(key) || memcmp(buf, key, rc))
+            _Exit(1);
+      }
+      _Exit(0);
+    }
+  }
+  for (i = 0; i < 4; ++i) {
+    ASSERT_NE(-1, wait(&ws));
+    ASSERT_TRUE(WIFEXITED(ws));
+    ASSERT_EQ(0, WEXITSTATUS(ws));
+  }
+}
+
+BENCH(cosmo_shmap, bench) {
+  char buf[8];
+  cosmo_shmap_put(m, "key", 3, "value", 5);
+  BENCHMARK(100000, 1, cosmo_shmap_get(m, "key", 3, buf, sizeof(buf)));
+  BENCHMARK(100000, 1, cosmo_shmap_put(m, "key", 3, "value", 5));
+}
@@ -39,6 +39,7 @@ TEST_LIBC_NEXGEN32E_DIRECTDEPS =				\
 	LIBC_TESTLIB						\
 	LIBC_X							\
 	TOOL_VIZ_LIB						\
+	THIRD_PARTY_LZ4CLI					\
 	THIRD_PARTY_XED
 
 TEST_LIBC_NEXGEN32E_DEPS :=					\
@@ -0,0 +1,111 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "third_party/lz4cli/lz4stream.h"
+#include "libc/calls/calls.h"
+#include "libc/errno.h"
+#include "libc/mem/mem.h"
+#include "libc/nexgen32e/lz4.h"
+#include "libc/stdio/rand.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/o.h"
+#include "libc/testlib/testlib.h"
+
+void SetUpOnce(void) {
+  testlib_enable_tmp_setup_teardown();
+}
+
+static int Reopen(int fd) {
+  ASSERT_SYS(0, 0, close(fd));
+  return open("frame.lz4", O_RDONLY);
+}
+
+static size_t ReadAll(struct Lz4Reader *r, char *buf, size_t size) {
+  ssize_t rc;
+  size_t got = 0;
+  while ((rc = lz4reader_read(r, buf + got, size - got)) > 0)
+    got += rc;
+  return got;
+}
+
+TEST(lz4writer, badBlockSize_einval) {
+  errno = 0;
+  ASSERT_EQ(NULL, lz4writer_open(1, 3, 1));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(lz4reader, oneLetterWithContentSize) {
+  // printf a | lz4 -9 --content-size --no-frame-crc | hexdump -C
+  static const char kLz4Data[] = {
+      0x04, 0x22, 0x4d, 0x18, 0x68, 0x40, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x2c, 0x01, 0x00, 0x00, 0x80, 0x61, 0x00, 0x00, 0x00, 0x00};
+  char buf[8];
+  struct Lz4Reader *r;
+  int fd = open("frame.lz4", O_RDWR | O_CREAT | O_TRUNC, 0644);
+  ASSERT_SYS(0, sizeof(kLz4Data), write(fd, kLz4Data, sizeof(kLz4Data)));
+  fd = Reopen(fd);
+  ASSERT_NE(NULL, (r = lz4reader_open(fd)));
+  ASSERT_EQ(1, ReadAll(r, buf, sizeof(buf)));
+  ASSERT_EQ('a', buf[0]);
+  lz4reader_close(r);
+  ASSERT_SYS(0, 0, close(fd));
+}
+
+TEST(lz4reader, corruptHeaderChecksum_ebadmsg) {
+  static const char kLz4Data[] = {0x04, 0x22, 0x4d, 0x18, 0x60,
+                                  0x40, 0x83, 0x00, 0x00, 0x00, 0x00};
+  char buf[8];
+  struct Lz4Reader *r;
+  int fd = open("frame.lz4", O_RDWR | O_CREAT | O_TRUNC, 0644);
+  ASSERT_SYS(0, sizeof(kLz4Data), write(fd, kLz4Data, sizeof(kLz4Data)));
+  fd = Reopen(fd);
+  ASSERT_NE(NULL, (r = lz4reader_open(fd)));
+  ASSERT_SYS(EBADMSG, -1, lz4reader_read(r, buf, sizeof(buf)));
+  lz4reader_close(r);
+  ASSERT_SYS(0, 0, close(fd));
+}
+
+TEST(lz4writer, roundTrip_concatenatedFramesWithThreads) {
+  int i, fd;
+  char *a, *b;
+  size_t n = 3 * 65536 + 1234;
+  struct Lz4Writer *w;
+  struct Lz4Reader *r;
+  a = malloc(n);
+  b = malloc(n * 2 + 1);
+  for (i = 0; i < n; ++i)
+    a[i] = i % 7 == 0 ? rand() : 'x';
+  fd = open("frame.lz4", O_RDWR | O_CREAT | O_TRUNC, 0644);
+  ASSERT_NE(NULL, (w = lz4writer_open(fd, LZ4_BLOCKMAXSIZE_64KB, 3)));
+  ASSERT_EQ(1000, lz4writer_write(w, a, 1000));
+  ASSERT_EQ(0, lz4writer_flush(w));
+  ASSERT_EQ(n - 1000, lz4writer_write(w, a + 1000, n - 1000));
+  ASSERT_EQ(0, lz4writer_close(w));
+  ASSERT_NE(NULL, (w = lz4writer_open(fd, LZ4_BLOCKMAXSIZE_256KB, 1)));
+  ASSERT_EQ(n, lz4writer_write(w, a, n));
+  ASSERT_EQ(0, lz4writer_close(w));
+  fd = Reopen(fd);
+  ASSERT_NE(NULL, (r = lz4reader_open(fd)));
+  ASSERT_EQ(n * 2, ReadAll(r, b, n * 2 + 1));
+  ASSERT_EQ(0, memcmp(a, b, n));
+  ASSERT_EQ(0, memcmp(a, b + n, n));
+  lz4reader_close(r);
+  ASSERT_SYS(0, 0, close(fd));
+  free(b);
+  free(a);
+}
@@ -32,6 +32,7 @@ TEST_LIBC_PROC_DIRECTDEPS =						\
 	LIBC_PROC							\
 	LIBC_RUNTIME							\
 	LIBC_LOG							\
+	LIBC_SOCK							\
 	LIBC_STDIO							\
 	LIBC_STR							\
 	LIBC_SYSV							\
@@ -0,0 +1,55 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/cosmo.h"
+#include "libc/errno.h"
+#include "libc/mem/gc.h"
+#include "libc/mem/mem.h"
+#include "libc/testlib/testlib.h"
+
+TEST(cosmo_topology, badArgs_einval) {
+  ASSERT_SYS(EINVAL, -1, cosmo_topology(0, -1));
+}
+
+TEST(cosmo_topology, test) {
+  int i, j, n, m;
+  struct CosmoCpu *t;
+  ASSERT_GT((n = cosmo_topology(0, 0)), 0);
+  t = gc(malloc(n * sizeof(*t)));
+  ASSERT_SYS(0, n, (m = cosmo_topology(t, n)));
+  for (i = 0; i < n; ++i) {
+    if (i)
+      ASSERT_GT(t[i].cpu, t[i - 1].cpu);
+    ASSERT_GE(t[i].node, 0);
+    ASSERT_GE(t[i].package, -1);
+    // sharing groups are named by their lowest member, which must exist
+    ASSERT_LE(t[i].core, t[i].cpu);
+    ASSERT_LE(t[i].l2, t[i].cpu);
+    ASSERT_LE(t[i].l3, t[i].cpu);
+    for (j = 0; j < n; ++j)
+      if (t[j].cpu == t[i].core)
+        break;
+    ASSERT_TRUE(t[i].core == -1 || j < n);
+  }
+}
+
+TEST(cosmo_topology, truncates) {
+  struct CosmoCpu t[1] = {{-7}};
+  ASSERT_GE(cosmo_topology(t, 1), 1);
+  ASSERT_NE(-7, t[0].cpu);
+}
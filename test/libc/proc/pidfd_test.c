@@ -0,0 +1,89 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/calls/struct/siginfo.h"
+#include "libc/dce.h"
+#include "libc/errno.h"
+#include "libc/runtime/runtime.h"
+#include "libc/sock/struct/pollfd.h"
+#include "libc/sysv/consts/poll.h"
+#include "libc/sysv/consts/sig.h"
+#include "libc/sysv/consts/w.h"
+#include "libc/testlib/testlib.h"
+
+int pid, ws, pfd, fds[2];
+
+void SetUp(void) {
+  ASSERT_SYS(0, 0, pipe(fds));
+  ASSERT_NE(-1, (pid = fork()));
+  if (!pid) {
+    char b;
+    close(fds[1]);
+    read(fds[0], &b, 1);
+    _Exit(42);
+  }
+  close(fds[0]);
+  if ((pfd = pidfd_open(pid, 0)) == -1) {
+    ASSERT_EQ(ENOSYS, errno);
+    errno = 0;
+  }
+}
+
+void TearDown(void) {
+  close(fds[1]);
+  if (pid > 0)
+    waitpid(pid, 0, 0);
+  if (pfd != -1)
+    ASSERT_SYS(0, 0, close(pfd));
+}
+
+TEST(pidfd_open, badArgs_einval) {
+  ASSERT_SYS(EINVAL, -1, pidfd_open(0, 0));
+  ASSERT_SYS(EINVAL, -1, pidfd_open(-1, 0));
+  ASSERT_SYS(EINVAL, -1, pidfd_open(pid, -1));
+}
+
+TEST(pidfd_open, pollsReadableWhenProcessExits) {
+  if (pfd == -1)
+    return;
+  struct pollfd p = {pfd, POLLIN};
+  ASSERT_SYS(0, 0, poll(&p, 1, 0));
+  ASSERT_SYS(0, 1, write(fds[1], "x", 1));
+  ASSERT_SYS(0, 1, poll(&p, 1, -1));
+  ASSERT_TRUE(!!(p.revents & POLLIN));
+  ASSERT_SYS(0, pid, waitpid(pid, &ws, 0));
+  ASSERT_TRUE(WIFEXITED(ws));
+  ASSERT_EQ(42, WEXITSTATUS(ws));
+  pid = 0;
+}
+
+TEST(pidfd_send_signal, test) {
+  if (pfd == -1)
+    return;
+  if (!IsLinux()) {
+    ASSERT_SYS(ENOSYS, -1, pidfd_send_signal(pfd, SIGKILL, 0, 0));
+    return;
+  }
+  ASSERT_SYS(0, 0, pidfd_send_signal(pfd, SIGKILL, 0, 0));
+  ASSERT_SYS(0, pid, waitpid(pid, &ws, 0));
+  ASSERT_TRUE(WIFSIGNALED(ws));
+  ASSERT_EQ(SIGKILL, WTERMSIG(ws));
+  pid = 0;
+  ASSERT_SYS(ESRCH, -1, pidfd_send_signal(pfd, SIGKILL, 0, 0));
+}
@@ -37,12 +37,14 @@
 #include "libc/limits.h"
 #include "libc/mem/gc.h"
 #include "libc/mem/mem.h"
+#include "libc/proc/posix_spawn.internal.h"
 #include "libc/proc/proc.h"
 #include "libc/runtime/internal.h"
 #include "libc/runtime/runtime.h"
 #include "libc/stdio/stdio.h"
 #include "libc/str/str.h"
 #include "libc/sysv/consts/auxv.h"
+#include "libc/sysv/consts/f.h"
 #include "libc/sysv/consts/o.h"
 #include "libc/sysv/consts/rusage.h"
 #include "libc/sysv/consts/sa.h"
@@ -99,6 +101,12 @@ __attribute__((__constructor__)) static void init(void) {
   switch (atoi(nulltoempty(getenv("THE_DOGE")))) {
     case 42:
       exit(42);
+    case 43:
+      if (fcntl(100, F_GETFD) != -1 || fcntl(101, F_GETFD) != -1)
+        exit(1);
+      if (fcntl(2, F_GETFD) == -1)
+        exit(2);
+      exit(43);
     default:
       break;
   }
@@ -163,6 +171,46 @@ TEST(posix_spawn, pipe) {
   ASSERT_EQ(0, posix_spawn_file_actions_destroy(&fa));
 }
 
+void SpawnSelfExpect43(posix_spawn_file_actions_t *fa, short flags) {
+  int ws, pid;
+  posix_spawnattr_t attr;
+  char *prog = GetProgramExecutableName();
+  char *args[] = {prog, NULL};
+  char *envs[] = {"THE_DOGE=43", NULL};
+  ASSERT_SYS(0, 100, dup2(2, 100));
+  ASSERT_SYS(0, 101, dup2(2, 101));
+  ASSERT_EQ(0, posix_spawnattr_init(&attr));
+  ASSERT_EQ(0, posix_spawnattr_setflags(&attr, flags));
+  ASSERT_EQ(0, posix_spawn(&pid, prog, fa, &attr, args, envs));
+  ASSERT_NE(-1, waitpid(pid, &ws, 0));
+  EXPECT_TRUE(WIFEXITED(ws));
+  EXPECT_EQ(43, WEXITSTATUS(ws));
+  ASSERT_EQ(0, posix_spawnattr_destroy(&attr));
+  ASSERT_SYS(0, 0, close(101));
+  ASSERT_SYS(0, 0, close(100));
+}
+
+TEST(posix_spawn, closeRange) {
+  posix_spawn_file_actions_t fa;
+  ASSERT_EQ(0, posix_spawn_file_actions_init(&fa));
+  for (int fd = 99; fd < 200; ++fd)
+    ASSERT_EQ(0, posix_spawn_file_actions_addclose(&fa, fd));
+  ASSERT_EQ(NULL, fa->next);  // got coalesced
+  ASSERT_EQ(199, fa->newfildes);
+  SpawnSelfExpect43(&fa, 0);
+  SpawnSelfExpect43(&fa, POSIX_SPAWN_USEVFORK);
+  ASSERT_EQ(0, posix_spawn_file_actions_destroy(&fa));
+}
+
+TEST(posix_spawn, closefrom) {
+  posix_spawn_file_actions_t fa;
+  ASSERT_EQ(0, posix_spawn_file_actions_init(&fa));
+  ASSERT_EQ(0, posix_spawn_file_actions_addclosefrom_np(&fa, 3));
+  SpawnSelfExpect43(&fa, 0);
+  SpawnSelfExpect43(&fa, POSIX_SPAWN_USEVFORK);
+  ASSERT_EQ(0, posix_spawn_file_actions_destroy(&fa));
+}
+
 TEST(posix_spawn, chdir) {
   int ws, pid, p[2];
   char buf[16] = {0};
@@ -370,6 +418,27 @@ void VforkExecveWait(const char *prog) {
   ASSERT_EQ(42, WEXITSTATUS(ws));
 }
 
+void PosixSpawnFileActionsWait(const char *prog) {
+  int ws, pid;
+  posix_spawnattr_t attr;
+  posix_spawn_file_actions_t fa;
+  char *args[] = {(char *)prog, 0};
+  char *envs[] = {0};
+  ASSERT_EQ(0, posix_spawnattr_init(&attr));
+  ASSERT_EQ(0, posix_spawnattr_setflags(&attr, POSIX_SPAWN_USEVFORK));
+  ASSERT_EQ(0, posix_spawn_file_actions_init(&fa));
+  ASSERT_EQ(0, posix_spawn_file_actions_addopen(&fa, 0, "/dev/null", O_RDONLY,
+                                                0644));
+  ASSERT_EQ(0, posix_spawn_file_actions_adddup2(&fa, 2, 1));
+  ASSERT_EQ(0, posix_spawn_file_actions_addclosefrom_np(&fa, 3));
+  ASSERT_EQ(0, posix_spawn(&pid, prog, &fa, &attr, args, envs));
+  ASSERT_NE(-1, waitpid(pid, &ws, 0));
+  ASSERT_TRUE(WIFEXITED(ws));
+  ASSERT_EQ(42, WEXITSTATUS(ws));
+  ASSERT_EQ(0, posix_spawn_file_actions_destroy(&fa));
+  ASSERT_EQ(0, posix_spawnattr_destroy(&attr));
+}
+
 void PosixSpawnWait(const char *prog) {
   int ws, pid;
   char *args[] = {(char *)prog, 0};
@@ -395,6 +464,8 @@ BENCH(posix_spawn, bench) {
           GetSize("life"), GetSize("life.elf"));
   ForkExecveWait("./life");
   EZBENCH2("posix_spawn life", donothing, PosixSpawnWait("./life"));
+  EZBENCH2("posix_spawn fa life", donothing,
+           PosixSpawnFileActionsWait("./life"));
   EZBENCH2("vfork life", donothing, VforkExecveWait("./life"));
   EZBENCH2("fork life", donothing, ForkExecveWait("./life"));
   if (IsWindows()) {
@@ -39,6 +39,7 @@ TEST_LIBC_RUNTIME_DIRECTDEPS =						\
 	LIBC_TINYMATH							\
 	LIBC_X								\
 	TOOL_BUILD_LIB							\
+	THIRD_PARTY_PUFF						\
 	THIRD_PARTY_XED							\
 	THIRD_PARTY_ZLIB
 
@@ -0,0 +1,124 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/mem/gc.h"
+#include "libc/mem/mem.h"
+#include "libc/runtime/internal.h"
+#include "libc/stdio/rand.h"
+#include "libc/str/str.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/hyperion.h"
+#include "libc/testlib/testlib.h"
+#include "third_party/puff/puff.h"
+#include "third_party/zlib/zlib.h"
+
+static size_t Deflate(void *out, size_t outsize, const void *in, size_t n,
+                      int level, int strategy) {
+  z_stream zs = {0};
+  ASSERT_EQ(Z_OK, deflateInit2(&zs, level, Z_DEFLATED, -MAX_WBITS,
+                               DEF_MEM_LEVEL, strategy));
+  zs.next_in = (void *)in;
+  zs.avail_in = n;
+  zs.next_out = out;
+  zs.avail_out = outsize;
+  ASSERT_EQ(Z_STREAM_END, deflate(&zs, Z_FINISH));
+  ASSERT_EQ(Z_OK, deflateEnd(&zs));
+  return zs.total_out;
+}
+
+static void Generate(char *p, size_t n) {
+  size_t i;
+  int kind = _rand64() % 4;
+  for (i = 0; i < n; ++i) {
+    switch (kind) {
+      case 0:
+        p[i] = _rand64();
+        break;
+      case 1:
+        p[i] = "abcdefgh"[_rand64() % 8];
+        break;
+      case 2:
+        p[i] = i && _rand64() % 64 ? p[i - 1] : _rand64();
+        break;
+      default:
+        p[i] = i > 64 && _rand64() % 4 ? p[i - 1 - _rand64() % 64]
+                                       : 'a' + _rand64() % 26;
+        break;
+    }
+  }
+}
+
+TEST(__fastinflate, hyperion) {
+  char *z = gc(malloc(kHyperionSize * 2));
+  char *o = gc(malloc(kHyperionSize));
+  size_t n = Deflate(z, kHyperionSize * 2, kHyperion, kHyperionSize, 6,
+                     Z_DEFAULT_STRATEGY);
+  ASSERT_EQ(0, __fastinflate(o, kHyperionSize, z, n));
+  ASSERT_EQ(0, memcmp(o, kHyperion, kHyperionSize));
+}
+
+TEST(__fastinflate, randomInputs_agreeWithZlib) {
+  size_t i, n, m;
+  int strategies[] = {Z_DEFAULT_STRATEGY, Z_FILTERED, Z_HUFFMAN_ONLY, Z_RLE,
+                      Z_FIXED};
+  char *p = gc(malloc(65536));
+  char *z = gc(malloc(65536 * 2));
+  char *o = gc(malloc(65536));
+  for (i = 0; i < 500; ++i) {
+    n = _rand64() % 65536;
+    Generate(p, n);
+    m = Deflate(z, 65536 * 2, p, n, _rand64() % 10, strategies[_rand64() % 5]);
+    ASSERT_EQ(0, __fastinflate(o, n, z, m));
+    ASSERT_EQ(0, memcmp(o, p, n));
+  }
+}
+
+TEST(__fastinflate, truncated_fails) {
+  char *z = gc(malloc(kHyperionSize * 2));
+  char *o = gc(malloc(kHyperionSize));
+  size_t n = Deflate(z, kHyperionSize * 2, kHyperion, kHyperionSize, 6,
+                     Z_DEFAULT_STRATEGY);
+  ASSERT_NE(0, __fastinflate(o, kHyperionSize, z, n / 2));
+  ASSERT_NE(0, __fastinflate(o, kHyperionSize, z, n - 1));
+  ASSERT_NE(0, __fastinflate(o, kHyperionSize - 1, z, n));
+}
+
+TEST(__fastinflate, garbage_doesntCrash) {
+  int i, j;
+  char z[256], o[1024];
+  for (i = 0; i < 10000; ++i) {
+    for (j = 0; j < sizeof(z); ++j)
+      z[j] = _rand64();
+    __fastinflate(o, sizeof(o), z, _rand64() % sizeof(z));
+  }
+}
+
+BENCH(__fastinflate, bench) {
+  unsigned long dl, sl;
+  char *z = gc(malloc(kHyperionSize * 2));
+  char *o = gc(malloc(kHyperionSize));
+  size_t n = Deflate(z, kHyperionSize * 2, kHyperion, kHyperionSize, 6,
+                     Z_DEFAULT_STRATEGY);
+  EZBENCH2("__fastinflate", donothing,
+           __fastinflate(o, kHyperionSize, z, n));
+  EZBENCH2("_puff", donothing, ({
+             dl = kHyperionSize;
+             sl = n;
+             _puff((void *)o, &dl, (void *)z, &sl);
+           }));
+}
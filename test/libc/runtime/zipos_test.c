@@ -19,6 +19,7 @@
 #include "libc/calls/calls.h"
 #include "libc/calls/struct/stat.h"
 #include "libc/errno.h"
+#include "libc/intrin/fds.h"
 #include "libc/limits.h"
 #include "libc/mem/gc.h"
 #include "libc/mem/mem.h"
@@ -26,13 +27,16 @@
 #include "libc/runtime/zipos.internal.h"
 #include "libc/str/str.h"
 #include "libc/sysv/consts/o.h"
+#include "libc/sysv/pib.h"
 #include "libc/testlib/hyperion.h"
+#include "libc/testlib/moby.h"
 #include "libc/testlib/subprocess.h"
 #include "libc/testlib/testlib.h"
 #include "libc/thread/thread.h"
 
 __static_yoink("zipos");
 __static_yoink("libc/testlib/hyperion.txt");
+__static_yoink("libc/testlib/moby.txt");
 __static_yoink("_Cz_inflate");
 __static_yoink("_Cz_inflateInit2");
 __static_yoink("_Cz_inflateEnd");
@@ -184,3 +188,58 @@ TEST(zipos, ultraPosixAtomicSeekRead) {
   EXPECT_EQ(960, lseek(3, 0, SEEK_CUR));
   ASSERT_SYS(0, 0, close(3));
 }
+
+TEST(zipos, bigFile_onlyInflatesWhatGetsRead) {
+  char buf[512];
+  struct ZiposHandle *h;
+  ASSERT_SYS(0, 3, open("/zip/libc/testlib/moby.txt", O_RDONLY));
+  h = (struct ZiposHandle *)__get_pib()->fds.p[3].handle;
+  ASSERT_EQ(kMobySize, h->size);
+  EXPECT_SYS(0, 512, read(3, buf, 512));
+  EXPECT_EQ(0, memcmp(buf, kMoby, 512));
+  ASSERT_NE(NULL, h->content);
+  if (h->content->stream)
+    EXPECT_LT(h->content->ready, kMobySize);
+  EXPECT_SYS(0, 512, pread(3, buf, 512, kMobySize - 512));
+  EXPECT_EQ(0, memcmp(buf, kMoby + kMobySize - 512, 512));
+  EXPECT_EQ(kMobySize, h->content->ready);
+  EXPECT_SYS(0, 512, read(3, buf, 512));
+  EXPECT_EQ(0, memcmp(buf, kMoby + 512, 512));
+  EXPECT_SYS(0, 0, pread(3, buf, 512, kMobySize));
+  EXPECT_SYS(0, 0, close(3));
+}
+
+void *MobyWorker(void *arg) {
+  char buf[1000];
+  int fd = (intptr_t)arg;
+  for (size_t off = 0; off + sizeof(buf) < kMobySize; off += 100000) {
+    ASSERT_SYS(0, sizeof(buf), pread(fd, buf, sizeof(buf), off));
+    ASSERT_EQ(0, memcmp(buf, kMoby + off, sizeof(buf)));
+  }
+  return 0;
+}
+
+TEST(zipos, bigFile_threadsShareHandle) {
+  int i, n = 8;
+  pthread_t t[8];
+  ASSERT_SYS(0, 3, open("/zip/libc/testlib/moby.txt", O_RDONLY));
+  for (i = 0; i < n; ++i)
+    ASSERT_SYS(0, 0, pthread_create(t + i, 0, MobyWorker, (void *)3));
+  for (i = 0; i < n; ++i)
+    EXPECT_SYS(0, 0, pthread_join(t[i], 0));
+  EXPECT_SYS(0, 0, close(3));
+}
+
+TEST(zipos, contentIsSharedBetweenHandles) {
+  struct ZiposContent *c;
+  ASSERT_SYS(0, 3, open("/zip/libc/testlib/moby.txt", O_RDONLY));
+  ASSERT_SYS(0, 4, open("/zip/libc/testlib/moby.txt", O_RDONLY));
+  c = ((struct ZiposHandle *)__get_pib()->fds.p[3].handle)->content;
+  ASSERT_NE(NULL, c);
+  EXPECT_EQ(c, ((struct ZiposHandle *)__get_pib()->fds.p[4].handle)->content);
+  EXPECT_SYS(0, 0, close(4));
+  EXPECT_SYS(0, 0, close(3));
+  ASSERT_SYS(0, 3, open("/zip/libc/testlib/moby.txt", O_RDONLY));
+  EXPECT_EQ(c, ((struct ZiposHandle *)__get_pib()->fds.p[3].handle)->content);
+  EXPECT_SYS(0, 0, close(3));
+}
@@ -0,0 +1,124 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/sock/epoll.h"
+#include "libc/calls/calls.h"
+#include "libc/dce.h"
+#include "libc/errno.h"
+#include "libc/sock/sock.h"
+#include "libc/sysv/consts/af.h"
+#include "libc/sysv/consts/sock.h"
+#include "libc/testlib/testlib.h"
+
+int ep, fds[2];
+
+void SetUp(void) {
+  ASSERT_NE(-1, (ep = epoll_create1(EPOLL_CLOEXEC)));
+  ASSERT_SYS(0, 0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+}
+
+void TearDown(void) {
+  ASSERT_SYS(0, 0, close(fds[1]));
+  ASSERT_SYS(0, 0, close(fds[0]));
+  ASSERT_SYS(0, 0, close(ep));
+}
+
+TEST(epoll_create, badSize_einval) {
+  ASSERT_SYS(EINVAL, -1, epoll_create(0));
+  ASSERT_SYS(EINVAL, -1, epoll_create1(-1));
+}
+
+TEST(epoll_wait, nothingReady_timesOut) {
+  struct epoll_event ev = {EPOLLIN, {.u64 = 42}}, got[4];
+  ASSERT_SYS(0, 0, epoll_ctl(ep, EPOLL_CTL_ADD, fds[0], &ev));
+  ASSERT_SYS(0, 0, epoll_wait(ep, got, 4, 0));
+  ASSERT_SYS(EINVAL, -1, epoll_wait(ep, got, 0, 0));
+}
+
+TEST(epoll_wait, readable) {
+  struct epoll_event ev = {EPOLLIN, {.u64 = 42}}, got[4];
+  ASSERT_SYS(0, 0, epoll_ctl(ep, EPOLL_CTL_ADD, fds[0], &ev));
+  ASSERT_SYS(0, 1, write(fds[1], "x", 1));
+  ASSERT_SYS(0, 1, epoll_wait(ep, got, 4, -1));
+  EXPECT_EQ(EPOLLIN, got[0].events & (EPOLLIN | EPOLLOUT));
+  EXPECT_EQ(42, got[0].data.u64);
+}
+
+TEST(epoll_wait, readableAndWritable_reportedOnce) {
+  struct epoll_event ev = {EPOLLIN | EPOLLOUT, {.fd = fds[0]}}, got[4];
+  ASSERT_SYS(0, 0, epoll_ctl(ep, EPOLL_CTL_ADD, fds[0], &ev));
+  ASSERT_SYS(0, 1, write(fds[1], "x", 1));
+  ASSERT_SYS(0, 1, epoll_wait(ep, got, 4, -1));
+  EXPECT_EQ(EPOLLIN | EPOLLOUT, got[0].events & (EPOLLIN | EPOLLOUT));
+  EXPECT_EQ(fds[0], got[0].data.fd);
+}
+
+TEST(epoll_ctl, modify) {
+  struct epoll_event ev = {EPOLLIN, {.u64 = 1}}, got[4];
+  ASSERT_SYS(0, 0, epoll_ctl(ep, EPOLL_CTL_ADD, fds[0], &ev));
+  ASSERT_SYS(0, 0, epoll_wait(ep, got, 4, 0));
+  ev = (struct epoll_event){EPOLLOUT, {.u64 = 2}};
+  ASSERT_SYS(0, 0, epoll_ctl(ep, EPOLL_CTL_MOD, fds[0], &ev));
+  ASSERT_SYS(0, 1, epoll_wait(ep, got, 4, 0));
+  EXPECT_EQ(EPOLLOUT, got[0].events & (EPOLLIN | EPOLLOUT));
+  EXPECT_EQ(2, got[0].data.u64);
+}
+
+TEST(epoll_ctl, delete) {
+  struct epoll_event ev = {EPOLLOUT}, got[4];
+  ASSERT_SYS(0, 0, epoll_ctl(ep, EPOLL_CTL_ADD, fds[0], &ev));
+  ASSERT_SYS(0, 0, epoll_ctl(ep, EPOLL_CTL_DEL, fds[0], 0));
+  ASSERT_SYS(0, 0, epoll_wait(ep, got, 4, 0));
+  ASSERT_SYS(ENOENT, -1, epoll_ctl(ep, EPOLL_CTL_DEL, fds[0], 0));
+}
+
+TEST(epoll_ctl, addTwice_eexist) {
+  struct epoll_event ev = {EPOLLIN};
+  if (IsBsd())
+    return;  // kqueue can't tell
+  ASSERT_SYS(0, 0, epoll_ctl(ep, EPOLL_CTL_ADD, fds[0], &ev));
+  ASSERT_SYS(EEXIST, -1, epoll_ctl(ep, EPOLL_CTL_ADD, fds[0], &ev));
+}
+
+TEST(epoll_ctl, badArgs) {
+  struct epoll_event ev = {EPOLLIN};
+  ASSERT_SYS(EINVAL, -1, epoll_ctl(ep, 31337, fds[0], &ev));
+  ASSERT_SYS(EFAULT, -1, epoll_ctl(ep, EPOLL_CTL_ADD, fds[0], 0));
+  ASSERT_SYS(EBADF, -1, epoll_ctl(ep, EPOLL_CTL_ADD, -1, &ev));
+}
+
+TEST(epoll_wait, oneshot_disarmsUntilModified) {
+  struct epoll_event ev = {EPOLLIN | EPOLLONESHOT}, got[4];
+  ASSERT_SYS(0, 0, epoll_ctl(ep, EPOLL_CTL_ADD, fds[0], &ev));
+  ASSERT_SYS(0, 1, write(fds[1], "x", 1));
+  ASSERT_SYS(0, 1, epoll_wait(ep, got, 4, -1));
+  ASSERT_SYS(0, 0, epoll_wait(ep, got, 4, 0));
+  ASSERT_SYS(0, 0, epoll_ctl(ep, EPOLL_CTL_MOD, fds[0], &ev));
+  ASSERT_SYS(0, 1, epoll_wait(ep, got, 4, -1));
+}
+
+TEST(epoll_wait, peerClosed_reportsHangup) {
+  int fd;
+  struct epoll_event ev = {EPOLLIN | EPOLLRDHUP}, got[4];
+  ASSERT_SYS(0, 0, epoll_ctl(ep, EPOLL_CTL_ADD, fds[0], &ev));
+  ASSERT_NE(-1, (fd = dup(fds[1])));
+  ASSERT_SYS(0, 0, close(fds[1]));
+  ASSERT_SYS(0, 1, epoll_wait(ep, got, 4, -1));
+  EXPECT_NE(0, got[0].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP));
+  fds[1] = fd;
+}
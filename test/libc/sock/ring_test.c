@@ -0,0 +1,172 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/sock/ring.h"
+#include "libc/calls/calls.h"
+#include "libc/errno.h"
+#include "libc/sock/sock.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/af.h"
+#include "libc/sysv/consts/msg.h"
+#include "libc/sysv/consts/o.h"
+#include "libc/sysv/consts/sock.h"
+#include "libc/testlib/testlib.h"
+
+struct CosmoRing *r;
+struct CosmoRingResult res[8];
+
+void SetUpOnce(void) {
+  testlib_enable_tmp_setup_teardown();
+}
+
+void SetUp(void) {
+  ASSERT_NE(NULL, (r = cosmo_ring_new(4)));
+}
+
+void TearDown(void) {
+  cosmo_ring_free(r);
+}
+
+// waits for exactly n completions
+static void Reap(int n) {
+  int got, rc;
+  for (got = 0; got < n; got += rc)
+    ASSERT_LT(0, (rc = cosmo_ring_reap(r, res + got, n - got, 0)));
+}
+
+TEST(cosmo_ring_new, badEntries_einval) {
+  ASSERT_EQ(NULL, cosmo_ring_new(0));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(cosmo_ring_reap, nothingSubmitted_returnsZero) {
+  struct timespec zero = {0};
+  ASSERT_EQ(0, cosmo_ring_reap(r, res, 8, 0));
+  ASSERT_EQ(0, cosmo_ring_reap(r, res, 8, &zero));
+  ASSERT_EQ(-1, cosmo_ring_reap(r, res, 0, 0));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(cosmo_ring_submit, badOpcode_einval) {
+  struct CosmoRingOp op = {.opcode = 666};
+  ASSERT_EQ(-1, cosmo_ring_submit(r, &op, 1));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(cosmo_ring, sendThenRecv) {
+  int sv[2];
+  char buf[8] = {0};
+  ASSERT_SYS(0, 0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+  struct CosmoRingOp ops[] = {
+      {COSMO_RING_SEND, sv[1], "hello", 5, .data = 1},
+      {COSMO_RING_RECV, sv[0], buf, sizeof(buf), .data = 2},
+  };
+  ASSERT_EQ(2, cosmo_ring_submit(r, ops, 2));
+  Reap(2);
+  EXPECT_EQ(5, res[0].res);
+  EXPECT_EQ(5, res[1].res);
+  EXPECT_EQ(3, res[0].data + res[1].data);
+  EXPECT_STREQ("hello", buf);
+  ASSERT_SYS(0, 0, close(sv[1]));
+  ASSERT_SYS(0, 0, close(sv[0]));
+}
+
+TEST(cosmo_ring, mixedWithPlainIo) {
+  int sv[2];
+  char buf[8] = {0};
+  ASSERT_SYS(0, 0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+  struct CosmoRingOp op = {COSMO_RING_RECV, sv[0], buf, 2, .data = 1};
+  ASSERT_SYS(0, 2, write(sv[1], "hi", 2));
+  ASSERT_EQ(1, cosmo_ring_submit(r, &op, 1));
+  Reap(1);
+  ASSERT_EQ(2, res[0].res);
+  // on windows the ring may have bound the handle to its completion
+  // port, which mustn't change how normal system calls behave on it
+  ASSERT_SYS(0, 3, write(sv[1], "yo!", 3));
+  ASSERT_SYS(0, 3, read(sv[0], buf, 3));
+  ASSERT_EQ(0, memcmp(buf, "yo!", 3));
+  ASSERT_SYS(0, 2, write(sv[1], "ok", 2));
+  ASSERT_EQ(1, cosmo_ring_submit(r, &op, 1));
+  Reap(1);
+  ASSERT_EQ(2, res[0].res);
+  ASSERT_EQ(0, memcmp(buf, "ok", 2));
+  ASSERT_SYS(0, 0, close(sv[1]));
+  ASSERT_SYS(0, 0, close(sv[0]));
+}
+
+TEST(cosmo_ring, writeThenPread) {
+  int fd;
+  char buf[4] = {0};
+  ASSERT_SYS(0, 3, (fd = open("x", O_RDWR | O_CREAT | O_TRUNC, 0644)));
+  struct CosmoRingOp op = {COSMO_RING_WRITE, fd, "abcdef", 6, .off = -1};
+  ASSERT_EQ(1, cosmo_ring_submit(r, &op, 1));
+  Reap(1);
+  ASSERT_EQ(6, res[0].res);
+  op = (struct CosmoRingOp){COSMO_RING_READ, fd, buf, 3, .off = 2, .data = 7};
+  ASSERT_EQ(1, cosmo_ring_submit(r, &op, 1));
+  Reap(1);
+  ASSERT_EQ(3, res[0].res);
+  ASSERT_EQ(7, res[0].data);
+  ASSERT_STREQ("cde", buf);
+  ASSERT_SYS(0, 0, close(fd));
+}
+
+TEST(cosmo_ring, badFd_reportsErrno) {
+  char buf[1];
+  struct CosmoRingOp op = {COSMO_RING_READ, 666, buf, 1, .off = -1};
+  ASSERT_EQ(1, cosmo_ring_submit(r, &op, 1));
+  Reap(1);
+  ASSERT_EQ(-1, res[0].res);
+  ASSERT_EQ(EBADF, res[0].err);
+}
+
+TEST(cosmo_ring, full_submitsPartially) {
+  int sv[2];
+  struct CosmoRingOp ops[6];
+  ASSERT_SYS(0, 0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+  for (int i = 0; i < 6; ++i)
+    ops[i] = (struct CosmoRingOp){COSMO_RING_SEND, sv[1], "x", 1, .data = i};
+  ASSERT_EQ(4, cosmo_ring_submit(r, ops, 6));
+  Reap(4);
+  ASSERT_EQ(2, cosmo_ring_submit(r, ops + 4, 2));
+  Reap(2);
+  ASSERT_SYS(0, 0, close(sv[1]));
+  ASSERT_SYS(0, 0, close(sv[0]));
+}
+
+TEST(cosmo_ring_reap, timeout_returnsZero) {
+  int sv[2];
+  char buf[1];
+  struct timespec ts = {0, 10000000};
+  ASSERT_SYS(0, 0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+  // inline recv would block submit, whereas io_uring waits for us
+  struct CosmoRingOp op = {COSMO_RING_RECV, sv[0], buf, 1,
+                           .flags = cosmo_ring_is_native(r) ? 0 : MSG_DONTWAIT};
+  ASSERT_EQ(1, cosmo_ring_submit(r, &op, 1));
+  if (cosmo_ring_is_native(r)) {
+    ASSERT_EQ(0, cosmo_ring_reap(r, res, 8, &ts));
+    ASSERT_SYS(0, 1, write(sv[1], "x", 1));
+    Reap(1);
+    ASSERT_EQ(1, res[0].res);
+  } else {
+    Reap(1);
+    ASSERT_EQ(EAGAIN, res[0].err);
+  }
+  ASSERT_SYS(0, 0, close(sv[1]));
+  ASSERT_SYS(0, 0, close(sv[0]));
+}
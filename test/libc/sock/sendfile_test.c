@@ -84,6 +84,8 @@ TEST(sendfile, testSeeking) {
     ASSERT_SYS(0, 500, sendfile(4, 5, &inoffset, -1));
     ASSERT_EQ(8, GetFileOffset(5));
     ASSERT_EQ(512, inoffset);
+    ASSERT_SYS(0, 0, sendfile(4, 5, &inoffset, -1));
+    ASSERT_EQ(512, inoffset);
     inoffset = -1;
     ASSERT_SYS(EINVAL, -1, sendfile(4, 5, &inoffset, -1));
     _Exit(0);
@@ -0,0 +1,93 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/calls/struct/iovec.h"
+#include "libc/errno.h"
+#include "libc/sock/sock.h"
+#include "libc/sock/struct/msghdr.h"
+#include "libc/sock/struct/sockaddr.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/af.h"
+#include "libc/sysv/consts/inaddr.h"
+#include "libc/sysv/consts/ipproto.h"
+#include "libc/sysv/consts/msg.h"
+#include "libc/sysv/consts/sock.h"
+#include "libc/testlib/testlib.h"
+
+int rx, tx;
+
+void SetUp(void) {
+  struct sockaddr_in addr = {AF_INET, 0, {htonl(INADDR_LOOPBACK)}};
+  uint32_t addrlen = sizeof(addr);
+  ASSERT_NE(-1, (rx = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)));
+  ASSERT_NE(-1, (tx = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)));
+  ASSERT_SYS(0, 0, bind(rx, (struct sockaddr *)&addr, sizeof(addr)));
+  ASSERT_SYS(0, 0, getsockname(rx, (struct sockaddr *)&addr, &addrlen));
+  ASSERT_SYS(0, 0, connect(tx, (struct sockaddr *)&addr, sizeof(addr)));
+}
+
+void TearDown(void) {
+  ASSERT_SYS(0, 0, close(tx));
+  ASSERT_SYS(0, 0, close(rx));
+}
+
+TEST(sendmmsg, recvmmsg_batch) {
+  const char *out[3] = {"a", "bb", "c"};
+  char in[4][8] = {0};
+  struct iovec oiov[3], iiov[4];
+  struct mmsghdr omsg[3] = {0}, imsg[4] = {0};
+  for (int i = 0; i < 3; ++i) {
+    oiov[i].iov_base = (void *)out[i];
+    oiov[i].iov_len = strlen(out[i]);
+    omsg[i].msg_hdr.msg_iov = oiov + i;
+    omsg[i].msg_hdr.msg_iovlen = 1;
+  }
+  for (int i = 0; i < 4; ++i) {
+    iiov[i].iov_base = in[i];
+    iiov[i].iov_len = sizeof(in[i]);
+    imsg[i].msg_hdr.msg_iov = iiov + i;
+    imsg[i].msg_hdr.msg_iovlen = 1;
+  }
+  ASSERT_EQ(3, sendmmsg(tx, omsg, 3, 0));
+  EXPECT_EQ(1, omsg[0].msg_len);
+  EXPECT_EQ(2, omsg[1].msg_len);
+  EXPECT_EQ(1, omsg[2].msg_len);
+  int got = 0, rc;
+  while (got < 3) {
+    ASSERT_LT(0, (rc = recvmmsg(rx, imsg + got, 4 - got, MSG_WAITFORONE, 0)));
+    got += rc;
+  }
+  EXPECT_EQ(1, imsg[0].msg_len);
+  EXPECT_EQ(2, imsg[1].msg_len);
+  EXPECT_EQ(1, imsg[2].msg_len);
+  EXPECT_STREQ("a", in[0]);
+  EXPECT_STREQ("bb", in[1]);
+  EXPECT_STREQ("c", in[2]);
+}
+
+TEST(recvmmsg, nothingWaiting_eagain) {
+  char buf[8];
+  struct iovec iov = {buf, sizeof(buf)};
+  struct mmsghdr msg = {{.msg_iov = &iov, .msg_iovlen = 1}};
+  ASSERT_SYS(EAGAIN, -1, recvmmsg(rx, &msg, 1, MSG_DONTWAIT, 0));
+}
+
+TEST(sendmmsg, zero_returnsZero) {
+  ASSERT_SYS(0, 0, sendmmsg(tx, 0, 0, 0));
+}
@@ -19,6 +19,7 @@
 #include "libc/calls/calls.h"
 #include "libc/calls/struct/sched_param.h"
 #include "libc/dce.h"
+#include "libc/fmt/conv.h"
 #include "libc/macros.h"
 #include "libc/math.h"
 #include "libc/mem/gc.h"
@@ -26,6 +27,7 @@
 #include "libc/nexgen32e/vendor.internal.h"
 #include "libc/runtime/internal.h"
 #include "libc/runtime/stack.h"
+#include "libc/stdio/rand.h"
 #include "libc/stdio/stdio.h"
 #include "libc/str/str.h"
 #include "libc/sysv/consts/clone.h"
@@ -35,6 +37,8 @@
 #include "libc/testlib/testlib.h"
 #include "libc/thread/thread.h"
 #include "libc/x/x.h"
+#include "libc/x/xasprintf.h"
+#include "third_party/gdtoa/gdtoa.h"
 
 #define DUB(i) (union Dub){i}.x
 
@@ -102,6 +106,88 @@ TEST(printf, double) {
   }
 }
 
+static double RandomDouble(void) {
+  uint64_t r = lemur64();
+  switch (r & 3) {
+    case 0:
+      return DUB(lemur64());
+    case 1:
+      return (double)(lemur64() % 100000000) / (1 + lemur64() % 100000);
+    case 2:
+      return (double)(lemur64() % 1000) / 8;  // exact ties
+    default:
+      return ldexp(lemur64() >> 11, (int)(lemur64() % 200) - 150);
+  }
+}
+
+// formats `%.*e` using digits from dtoa() mode 2
+static void FormatExpo(char *p, double x, int prec) {
+  char *s, *s0, *se;
+  int i, n, decpt, sign;
+  s = s0 = dtoa(x, 2, prec + 1, &decpt, &sign, &se);
+  n = se - s;
+  if (sign)
+    *p++ = '-';
+  *p++ = *s;
+  if (prec)
+    *p++ = '.';
+  for (i = 1; i <= prec; ++i)
+    *p++ = i < n ? s[i] : '0';
+  sprintf(p, "e%c%02d", decpt - 1 < 0 ? '-' : '+', abs(decpt - 1));
+  freedtoa(s0);
+}
+
+// formats `%.*f` using digits from dtoa() mode 3
+static void FormatFixed(char *p, double x, int prec) {
+  char *s, *s0, *se;
+  int i, n, decpt, sign;
+  s = s0 = dtoa(x, 3, prec, &decpt, &sign, &se);
+  n = se - s;
+  if (sign)
+    *p++ = '-';
+  if (decpt <= 0)
+    *p++ = '0';
+  for (i = 0; i < decpt; ++i)
+    *p++ = i < n ? s[i] : '0';
+  if (prec)
+    *p++ = '.';
+  for (i = decpt; i < decpt + prec; ++i)
+    *p++ = 0 <= i && i < n ? s[i] : '0';
+  *p = 0;
+  freedtoa(s0);
+}
+
+TEST(printf, fixedPrecisionMatchesDtoa) {
+  int i, prec;
+  double x;
+  char want[400];
+  char got[400];
+  for (i = 0; i < 100000; ++i) {
+    if (!isfinite((x = RandomDouble())))
+      continue;
+    prec = lemur64() % 18;
+    FormatExpo(want, x, prec);
+    snprintf(got, sizeof(got), "%.*e", prec, x);
+    ASSERT_STREQ(want, got);
+    prec = lemur64() % 12;
+    if (fabs(x) < 1e30) {
+      FormatFixed(want, x, prec);
+      snprintf(got, sizeof(got), "%.*f", prec, x);
+      ASSERT_STREQ(want, got);
+    }
+  }
+}
+
+TEST(printf, roundsHalfToEven) {
+  EXPECT_STREQ("0 2 2 4", gc(xasprintf("%.0f %.0f %.0f %.0f", .5, 1.5, 2.5,
+                                       3.5)));
+  EXPECT_STREQ("0.12 0.38 -0.62", gc(xasprintf("%.2f %.2f %.2f", .125, .375,
+                                               -.625)));
+  EXPECT_STREQ("1.2e+00 1e+01", gc(xasprintf("%.1e %.0e", 1.25, 9.5)));
+  EXPECT_STREQ("0.10000000000000001", gc(xasprintf("%.17g", .1)));
+  EXPECT_STREQ("9.9999999999999992e+22", gc(xasprintf("%.17g", 1e23)));
+}
+
 #if LDBL_MANT_DIG == 64
 
 static const struct {
@@ -160,6 +160,21 @@ TEST(appendd, testMemFail_doesntFreeExistingAllocation) {
   free(b);
 }
 
+TEST(appendf, literalFormat_matchesFormattedPath) {
+  char *b = 0, *c = 0;
+  const char *fmt = "hello\n";
+  ASSERT_EQ(6, appendf(&b, "hello\n"));
+  ASSERT_EQ(6, appendf(&c, fmt));
+  ASSERT_EQ(4, appendf(&b, "100%%"));
+  ASSERT_EQ(4, (appendf)(&c, "100%%"));
+  ASSERT_EQ(2, kappendf(&b, "hi"));
+  ASSERT_EQ(2, (kappendf)(&c, "hi"));
+  EXPECT_STREQ("hello\n100%hi", b);
+  EXPECT_STREQ(c, b);
+  free(c);
+  free(b);
+}
+
 TEST(appendd, nontrivialAmountOfMemory) {
   char *b = 0;
   int i, n = 40000;
@@ -173,6 +188,7 @@ TEST(appendd, nontrivialAmountOfMemory) {
 BENCH(vappendf, bench) {
   char *b = 0;
   EZBENCH2("appendf", donothing, appendf(&b, "hello"));
+  EZBENCH2("(appendf)", donothing, (appendf)(&b, "hello"));
   EZBENCH2("kappendf", donothing, kappendf(&b, "hello"));
   free(b), b = 0;
   EZBENCH2("appends", donothing, appends(&b, "hello"));
@@ -0,0 +1,75 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/cosmo.h"
+#include "libc/stdio/rand.h"
+#include "libc/str/str.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/hyperion.h"
+#include "libc/testlib/testlib.h"
+
+TEST(cosmo_hash_seeded, vectors) {
+  EXPECT_EQ(0x93228a4de0eec5a2, cosmo_hash_seeded("", 0, 0));
+  EXPECT_EQ(0xc5bac3db178713c4, cosmo_hash_seeded("a", 1, 1));
+  EXPECT_EQ(0xa97f2f7b1d9b3314, cosmo_hash_seeded("abc", 3, 2));
+  EXPECT_EQ(0x786d1f1df3801df4, cosmo_hash_seeded("message digest", 14, 3));
+  EXPECT_EQ(0xdca5a8138ad37c87,
+            cosmo_hash_seeded("abcdefghijklmnopqrstuvwxyz", 26, 4));
+}
+
+TEST(cosmo_hash_seeded, alignmentDoesntMatter) {
+  char buf[200 + 8];
+  for (int i = 0; i < sizeof(buf); ++i)
+    buf[i] = rand();
+  for (int n = 0; n <= 200; ++n) {
+    uint64_t want = cosmo_hash_seeded(buf, n, 123);
+    for (int o = 1; o < 8; ++o) {
+      memmove(buf + o, buf + o - 1, n);
+      ASSERT_EQ(want, cosmo_hash_seeded(buf + o, n, 123));
+    }
+    memmove(buf, buf + 7, n);
+  }
+}
+
+TEST(cosmo_hash_seeded, everyByteMatters) {
+  char buf[100] = {0};
+  for (int n = 1; n <= sizeof(buf); ++n) {
+    uint64_t h = cosmo_hash_seeded(buf, n, 0);
+    for (int i = 0; i < n; ++i) {
+      buf[i] ^= 1;
+      ASSERT_NE(h, cosmo_hash_seeded(buf, n, 0));
+      buf[i] ^= 1;
+    }
+    ASSERT_NE(h, cosmo_hash_seeded(buf, n - 1, 0));
+  }
+}
+
+TEST(cosmo_hash, isStableWithinProcess) {
+  uint64_t h = cosmo_hash(kHyperion, kHyperionSize);
+  EXPECT_EQ(h, cosmo_hash(kHyperion, kHyperionSize));
+  EXPECT_NE(h, cosmo_hash_seeded(kHyperion, kHyperionSize, 0));
+}
+
+BENCH(cosmo_hash, bench) {
+  EZBENCH_N("cosmo_hash", 5,
+            __expropriate(cosmo_hash(__veil("r", "hello"), 5)));
+  EZBENCH_N("cosmo_hash", 32,
+            __expropriate(cosmo_hash(__veil("r", kHyperion), 32)));
+  EZBENCH_N("cosmo_hash", kHyperionSize,
+            __expropriate(cosmo_hash(__veil("r", kHyperion), kHyperionSize)));
+}
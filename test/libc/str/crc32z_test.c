@@ -382,6 +382,29 @@ TEST(crc32_z, test) {
   EXPECT_EQ(0xe9ded8e6, crc32_z(0, p, kHyperionSize));
 }
 
+TEST(crc32ieee, fuzz) {
+  static char buf[4096 + 16];
+  for (int i = 0; i < sizeof(buf); ++i)
+    buf[i] = rand();
+  for (int n = 0; n < 4096; n += 1 + (n >= 512) * 7) {
+    for (int i = 0; i < 4; ++i) {
+      int x = lemur64();
+      int o = lemur64() & 15;
+      ASSERT_EQ(crc32_reference(x, buf + o, n), crc32ieee(x, buf + o, n));
+    }
+  }
+}
+
+TEST(crc32ieee, test) {
+  EXPECT_EQ(0, crc32ieee(0, 0, 0));
+  EXPECT_EQ(0xcbf43926, crc32ieee(0, "123456789", 9));
+  EXPECT_EQ(0xc386e7e4, crc32ieee(0, hyperion, strlen(hyperion)));
+  EXPECT_EQ(0xc386e7e4, crc32ieee(crc32ieee(0, FANATICS, strlen(FANATICS)),
+                                  hyperion + strlen(FANATICS),
+                                  strlen(hyperion) - strlen(FANATICS)));
+  EXPECT_EQ(0xe9ded8e6, crc32ieee(0, kHyperion, kHyperionSize));
+}
+
 #define BENCHMARK_GBPS(ITERATIONS, BYTES_PER_RUN, CODE)              \
   do {                                                               \
     struct timespec start = timespec_real();                         \
@@ -401,6 +424,8 @@ BENCH(crc32_z, bench) {
   volatile unsigned vv = 0;
   BENCHMARK_GBPS(100, kHyperionSize,
                  vv += crc32_z(0, kHyperion, kHyperionSize));
+  BENCHMARK_GBPS(100, kHyperionSize,
+                 vv += crc32ieee(0, kHyperion, kHyperionSize));
   BENCHMARK_GBPS(100, kHyperionSize,
                  vv += crc32_bloated(0, kHyperion, kHyperionSize));
   BENCHMARK_GBPS(100, kHyperionSize,
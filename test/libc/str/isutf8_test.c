@@ -17,6 +17,7 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/calls/calls.h"
+#include "libc/macros.h"
 #include "libc/mem/mem.h"
 #include "libc/runtime/runtime.h"
 #include "libc/runtime/symbols.internal.h"
@@ -48,6 +49,25 @@ TEST(isutf8, bad) {
   ASSERT_FALSE(isutf8("\377\200\200\200\200", -1));  // thompson-pike varint
 }
 
+TEST(isutf8, longInputs_agreeWithShortOnes) {
+  int i, j;
+  char b[200];
+  static const char *const kSeqs[] = {
+      "\303\251",         "\344\270\255",     "\360\237\230\200",
+      "\355\240\200",     "\364\220\200\200", "\300\200",
+      "\340\200\200",     "\360\200\200\200", "\365\200\200\200",
+      "\200",             "\303",             "\360\237\230",
+  };
+  for (i = 0; i < ARRAYLEN(kSeqs); ++i) {
+    for (j = 0; j + strlen(kSeqs[i]) <= sizeof(b); ++j) {
+      memset(b, 'a', sizeof(b));
+      memcpy(b + j, kSeqs[i], strlen(kSeqs[i]));
+      ASSERT_EQ(isutf8(kSeqs[i], -1), isutf8(b, sizeof(b)));
+      ASSERT_EQ(isutf8(kSeqs[i], -1), isutf8(b, j + strlen(kSeqs[i])));
+    }
+  }
+}
+
 TEST(isutf8, oob) {
   int n;
   char *p;
@@ -17,6 +17,8 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/bsdstdlib.h"
+#include "libc/macros.h"
+#include "libc/math.h"
 #include "libc/mem/alg.h"
 #include "libc/mem/gc.h"
 #include "libc/mem/mem.h"
@@ -126,6 +128,97 @@ TEST(radix_sort_int64, test) {
   ASSERT_EQ(0, memcmp(b, a, n * sizeof(long)));
 }
 
+int CompareUint64(const void *a, const void *b) {
+  const uint64_t *x = a;
+  const uint64_t *y = b;
+  if (*x < *y)
+    return -1;
+  if (*x > *y)
+    return +1;
+  return 0;
+}
+
+TEST(radix_sort_uint64, test) {
+  size_t n = 5000;
+  uint64_t *a = gc(calloc(n, sizeof(uint64_t)));
+  uint64_t *b = gc(calloc(n, sizeof(uint64_t)));
+  arc4random_buf(a, n * sizeof(uint64_t));
+  memcpy(b, a, n * sizeof(uint64_t));
+  qsort(a, n, sizeof(uint64_t), CompareUint64);
+  radix_sort_uint64(b, n);
+  ASSERT_EQ(0, memcmp(b, a, n * sizeof(uint64_t)));
+}
+
+TEST(radix_sort_uint64, smallKeys) {
+  size_t i, n = 5000;
+  uint64_t *a = gc(calloc(n, sizeof(uint64_t)));
+  uint64_t *b = gc(calloc(n, sizeof(uint64_t)));
+  for (i = 0; i < n; ++i)
+    a[i] = b[i] = rand() % 1000;
+  qsort(a, n, sizeof(uint64_t), CompareUint64);
+  radix_sort_uint64(b, n);
+  ASSERT_EQ(0, memcmp(b, a, n * sizeof(uint64_t)));
+}
+
+TEST(radix_sort_pairs, isStable) {
+  size_t i, n = 5000;
+  struct SortPair *a = gc(calloc(n, sizeof(struct SortPair)));
+  for (i = 0; i < n; ++i) {
+    a[i].key = rand() % 50;
+    a[i].val = i;
+  }
+  radix_sort_pairs(a, n);
+  for (i = 1; i < n; ++i) {
+    ASSERT_LE(a[i - 1].key, a[i].key);
+    if (a[i - 1].key == a[i].key)
+      ASSERT_LT(a[i - 1].val, a[i].val);
+  }
+}
+
+int CompareDouble(const void *a, const void *b) {
+  const double *x = a;
+  const double *y = b;
+  if (*x < *y)
+    return -1;
+  if (*x > *y)
+    return +1;
+  return 0;
+}
+
+TEST(radix_sort_double, test) {
+  size_t i, n = 5000;
+  double *a = gc(calloc(n, sizeof(double)));
+  double *b = gc(calloc(n, sizeof(double)));
+  for (i = 0; i < n; ++i)
+    a[i] = b[i] = (double)(int64_t)lemur64() / (1ull << (rand() % 60));
+  qsort(a, n, sizeof(double), CompareDouble);
+  radix_sort_double(b, n);
+  ASSERT_EQ(0, memcmp(b, a, n * sizeof(double)));
+}
+
+TEST(radix_sort_double, signedZerosAndNans) {
+  double a[] = {0., -0., NAN, -NAN, -1., 1., INFINITY, -INFINITY};
+  radix_sort_double(a, ARRAYLEN(a));
+  ASSERT_TRUE(isnan(a[0]) && signbit(a[0]));
+  ASSERT_EQ(-INFINITY, a[1]);
+  ASSERT_EQ(-1., a[2]);
+  ASSERT_TRUE(a[3] == 0 && signbit(a[3]));
+  ASSERT_TRUE(a[4] == 0 && !signbit(a[4]));
+  ASSERT_EQ(1., a[5]);
+  ASSERT_EQ(INFINITY, a[6]);
+  ASSERT_TRUE(isnan(a[7]) && !signbit(a[7]));
+}
+
+TEST(radix_sort_float, test) {
+  size_t i, n = 5000;
+  float *a = gc(calloc(n, sizeof(float)));
+  for (i = 0; i < n; ++i)
+    a[i] = (float)(int32_t)lemur64() / (1u << (rand() % 30));
+  radix_sort_float(a, n);
+  for (i = 1; i < n; ++i)
+    ASSERT_LE(a[i - 1], a[i]);
+}
+
 BENCH(_longsort, bench) {
   printf("\n");
   size_t n = 5000;
@@ -180,6 +180,19 @@ TEST(memmem, fuzz) {
   }
 }
 
+TEST(memmem, fuzzSmallAlphabet) {
+  char a[300], b[40];
+  for (int i = 0; i < 10000; ++i) {
+    int n = lemur64() % sizeof(a);
+    int m = lemur64() % sizeof(b);
+    for (int j = 0; j < n; ++j)
+      a[j] = 'a' + lemur64() % 3;
+    for (int j = 0; j < m; ++j)
+      b[j] = 'a' + lemur64() % 3;
+    ASSERT_EQ(memmem_naive(a, n, b, m), memmem(a, n, b, m));
+  }
+}
+
 TEST(memmem, safety) {
   int pagesz = sysconf(_SC_PAGESIZE);
   char *map = (char *)mmap(0, pagesz * 2, PROT_READ | PROT_WRITE,
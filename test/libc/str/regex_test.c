@@ -98,6 +98,29 @@ TEST(regex, testUnicodeCharacterClass) {
   regfree(&rx);
 }
 
+TEST(regex, testSkipsCharactersThatCantBeginMatch) {
+  regex_t rx;
+  regmatch_t m[2];
+  EXPECT_EQ(REG_OK, regcomp(&rx, "\\<[nm]eed(le|ly)", REG_EXTENDED));
+  EXPECT_EQ(REG_OK, regexec(&rx, "xxx xneedle needly", 2, m, 0));
+  EXPECT_EQ(12, m[0].rm_so);
+  EXPECT_EQ(18, m[0].rm_eo);
+  EXPECT_EQ(16, m[1].rm_so);
+  EXPECT_EQ(REG_OK, regexec(&rx, "→ meedle", 2, m, 0));
+  EXPECT_EQ(4, m[0].rm_so);
+  EXPECT_EQ(REG_NOMATCH, regexec(&rx, "xxxxxxxxxxxxxxxx", 0, 0, 0));
+  regfree(&rx);
+  EXPECT_EQ(REG_OK, regcomp(&rx, "^b", REG_EXTENDED | REG_NEWLINE));
+  EXPECT_EQ(REG_OK, regexec(&rx, "aaa\nbbb", 1, m, 0));
+  EXPECT_EQ(4, m[0].rm_so);
+  EXPECT_EQ(REG_NOMATCH, regexec(&rx, "aaa\nabb", 0, 0, 0));
+  regfree(&rx);
+  EXPECT_EQ(REG_OK, regcomp(&rx, "B", REG_EXTENDED | REG_ICASE));
+  EXPECT_EQ(REG_OK, regexec(&rx, "aaab", 1, m, 0));
+  EXPECT_EQ(3, m[0].rm_so);
+  regfree(&rx);
+}
+
 void A(void) {
   regex_t rx;
   regcomp(&rx, "^[-._0-9A-Za-z]*$", REG_EXTENDED);
@@ -136,6 +136,17 @@ TEST(strstr, safety) {
   munmap(map, pagesz * 2);
 }
 
+TEST(strstr, matchStraddlesSearchWindow) {
+  char *p = gc(calloc(1, 10001));
+  memset(p, 'a', 10000);
+  for (int i = 4080; i < 4100; ++i) {
+    memcpy(p + i, "abcdefghijklmnopqrstuvwxyz", 26);
+    ASSERT_EQ(p + i, strstr(p, "bcdefghijklmnopqrstuvwxyz"));
+    memset(p + i, 'a', 26);
+  }
+  ASSERT_EQ(NULL, strstr(p, "ab"));
+}
+
 TEST(strstr, breakit) {
   char *p;
   p = gc(calloc(1, 32));
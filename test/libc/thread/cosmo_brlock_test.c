@@ -0,0 +1,78 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/atomic.h"
+#include "libc/cosmo.h"
+#include "libc/intrin/atomic.h"
+#include "libc/testlib/testlib.h"
+#include "libc/thread/thread.h"
+
+#define READERS    8
+#define WRITERS    2
+#define ITERATIONS 1000
+
+atomic_bool done;
+atomic_int writers;
+int foo;
+int bar;
+cosmo_brlock_t lock = COSMO_BRLOCK_INITIALIZER;
+
+void *Reader(void *arg) {
+  while (!atomic_load_explicit(&done, memory_order_relaxed)) {
+    unsigned token = cosmo_brlock_rdlock(&lock);
+    int x = foo;
+    pthread_yield_np();
+    int y = bar;
+    ASSERT_EQ(x, y);
+    cosmo_brlock_rdunlock(&lock, token);
+  }
+  return 0;
+}
+
+void *Writer(void *arg) {
+  for (int i = 0; i < ITERATIONS; ++i) {
+    cosmo_brlock_wrlock(&lock);
+    ++foo;
+    pthread_yield_np();
+    ++bar;
+    cosmo_brlock_wrunlock(&lock);
+  }
+  if (atomic_fetch_add(&writers, 1) + 1 == WRITERS)
+    done = true;
+  return 0;
+}
+
+TEST(cosmo_brlock, test) {
+  pthread_t t[READERS + WRITERS];
+  for (int i = 0; i < READERS + WRITERS; ++i)
+    ASSERT_EQ(0, pthread_create(t + i, 0, i < READERS ? Reader : Writer, 0));
+  for (int i = 0; i < READERS + WRITERS; ++i)
+    EXPECT_EQ(0, pthread_join(t[i], 0));
+  EXPECT_EQ(WRITERS * ITERATIONS, foo);
+  EXPECT_EQ(WRITERS * ITERATIONS, bar);
+}
+
+TEST(cosmo_brlock, readersShareLock) {
+  cosmo_brlock_t lk = COSMO_BRLOCK_INITIALIZER;
+  unsigned a = cosmo_brlock_rdlock(&lk);
+  unsigned b = cosmo_brlock_rdlock(&lk);
+  cosmo_brlock_rdunlock(&lk, b);
+  cosmo_brlock_rdunlock(&lk, a);
+  cosmo_brlock_wrlock(&lk);
+  cosmo_brlock_wrunlock(&lk);
+}
@@ -0,0 +1,71 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/cosmo.h"
+#include "libc/mem/alg.h"
+#include "libc/mem/gc.h"
+#include "libc/mem/mem.h"
+#include "libc/stdio/rand.h"
+#include "libc/str/str.h"
+#include "libc/testlib/testlib.h"
+
+struct CosmoTaskPool *pool;
+
+void SetUp(void) {
+  ASSERT_NE(NULL, (pool = cosmo_taskpool_new(4)));
+}
+
+void TearDown(void) {
+  cosmo_taskpool_free(pool);
+}
+
+TEST(cosmo_parallel_sort_uint64, test) {
+  size_t i, n = 3000000;
+  uint64_t *a = gc(malloc(n * sizeof(uint64_t)));
+  uint64_t *b = gc(malloc(n * sizeof(uint64_t)));
+  for (i = 0; i < n; ++i)
+    a[i] = b[i] = lemur64() >> (i % 40);
+  radix_sort_uint64(a, n);
+  ASSERT_EQ(0, cosmo_parallel_sort_uint64(pool, b, n));
+  ASSERT_EQ(0, memcmp(b, a, n * sizeof(uint64_t)));
+}
+
+TEST(cosmo_parallel_sort_pairs, isStable) {
+  size_t i, n = 3000000;
+  struct SortPair *a = gc(malloc(n * sizeof(struct SortPair)));
+  for (i = 0; i < n; ++i) {
+    a[i].key = lemur64() % 1000;
+    a[i].val = i;
+  }
+  ASSERT_EQ(0, cosmo_parallel_sort_pairs(pool, a, n));
+  for (i = 1; i < n; ++i) {
+    ASSERT_LE(a[i - 1].key, a[i].key);
+    if (a[i - 1].key == a[i].key)
+      ASSERT_LT(a[i - 1].val, a[i].val);
+  }
+}
+
+TEST(cosmo_parallel_sort_uint64, allEqual) {
+  size_t i, n = 2000000;
+  uint64_t *a = gc(malloc(n * sizeof(uint64_t)));
+  for (i = 0; i < n; ++i)
+    a[i] = 7;
+  ASSERT_EQ(0, cosmo_parallel_sort_uint64(pool, a, n));
+  for (i = 0; i < n; ++i)
+    ASSERT_EQ(7, a[i]);
+}
@@ -0,0 +1,81 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/atomic.h"
+#include "libc/cosmo.h"
+#include "libc/errno.h"
+#include "libc/intrin/atomic.h"
+#include "libc/testlib/testlib.h"
+
+atomic_long sum;
+struct CosmoTaskPool *pool;
+
+void SetUp(void) {
+  sum = 0;
+  ASSERT_NE(NULL, (pool = cosmo_taskpool_new(4)));
+}
+
+void TearDown(void) {
+  cosmo_taskpool_free(pool);
+}
+
+void Leaf(void *arg) {
+  atomic_fetch_add(&sum, (intptr_t)arg);
+}
+
+void Spawner(void *arg) {
+  for (int i = 0; i < 100; ++i)
+    ASSERT_EQ(0, cosmo_taskpool_spawn(pool, Leaf, (void *)1));
+}
+
+void Inner(long i, long j, void *arg) {
+  for (; i < j; ++i)
+    atomic_fetch_add(&sum, i);
+}
+
+void Outer(long i, long j, void *arg) {
+  for (; i < j; ++i)
+    cosmo_parallel_for(pool, 0, 100, 7, Inner, 0);
+}
+
+TEST(cosmo_taskpool_new, negative_einval) {
+  ASSERT_EQ(NULL, cosmo_taskpool_new(-1));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(cosmo_taskpool_spawn, tasksMaySpawnTasks) {
+  for (int i = 0; i < 100; ++i)
+    ASSERT_EQ(0, cosmo_taskpool_spawn(pool, Spawner, 0));
+  cosmo_taskpool_wait(pool);
+  ASSERT_EQ(100 * 100, sum);
+}
+
+TEST(cosmo_parallel_for, coversRange) {
+  cosmo_parallel_for(pool, 0, 100, 0, Inner, 0);
+  ASSERT_EQ(4950, sum);
+}
+
+TEST(cosmo_parallel_for, emptyRange) {
+  cosmo_parallel_for(pool, 5, 5, 0, Inner, 0);
+  ASSERT_EQ(0, sum);
+}
+
+TEST(cosmo_parallel_for, nested) {
+  cosmo_parallel_for(pool, 0, 1000, 0, Outer, 0);
+  ASSERT_EQ(1000 * 4950, sum);
+}
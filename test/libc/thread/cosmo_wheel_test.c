@@ -0,0 +1,117 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/cosmo.h"
+#include "libc/mem/gc.h"
+#include "libc/mem/mem.h"
+#include "libc/stdio/rand.h"
+#include "libc/testlib/testlib.h"
+
+struct CosmoWheel *w;
+
+void SetUp(void) {
+  ASSERT_NE(NULL, (w = cosmo_wheel_new(1000)));
+}
+
+void TearDown(void) {
+  cosmo_wheel_free(w);
+}
+
+TEST(cosmo_wheel_expire, empty) {
+  ASSERT_EQ(-1, cosmo_wheel_timeout(w));
+  ASSERT_EQ(NULL, cosmo_wheel_expire(w, 100000));
+}
+
+TEST(cosmo_wheel_expire, firesAtDeadline) {
+  cosmo_timer_t t = {0};
+  cosmo_wheel_add(w, &t, 1010);
+  ASSERT_EQ(10, cosmo_wheel_timeout(w));
+  ASSERT_EQ(NULL, cosmo_wheel_expire(w, 1009));
+  ASSERT_EQ(1, cosmo_wheel_timeout(w));
+  ASSERT_EQ(&t, cosmo_wheel_expire(w, 1010));
+  ASSERT_EQ(NULL, cosmo_wheel_expire(w, 1010));
+  ASSERT_EQ(-1, cosmo_wheel_timeout(w));
+}
+
+TEST(cosmo_wheel_expire, pastDeadline_firesImmediately) {
+  cosmo_timer_t t = {0};
+  cosmo_wheel_add(w, &t, 5);
+  ASSERT_EQ(0, cosmo_wheel_timeout(w));
+  ASSERT_EQ(&t, cosmo_wheel_expire(w, 1000));
+}
+
+TEST(cosmo_wheel_cancel, works) {
+  cosmo_timer_t t = {0};
+  ASSERT_FALSE(cosmo_wheel_cancel(w, &t));
+  cosmo_wheel_add(w, &t, 2000);
+  ASSERT_TRUE(cosmo_wheel_cancel(w, &t));
+  ASSERT_FALSE(cosmo_wheel_cancel(w, &t));
+  ASSERT_EQ(-1, cosmo_wheel_timeout(w));
+  ASSERT_EQ(NULL, cosmo_wheel_expire(w, 3000));
+}
+
+TEST(cosmo_wheel_add, rearm_movesDeadline) {
+  cosmo_timer_t t = {0};
+  cosmo_wheel_add(w, &t, 1005);
+  cosmo_wheel_add(w, &t, 1500);
+  ASSERT_EQ(NULL, cosmo_wheel_expire(w, 1499));
+  ASSERT_EQ(&t, cosmo_wheel_expire(w, 1500));
+}
+
+TEST(cosmo_wheel_timeout, isLowerBound) {
+  cosmo_timer_t t = {0};
+  cosmo_wheel_add(w, &t, 1000 + 100000);
+  int64_t ms = cosmo_wheel_timeout(w);
+  ASSERT_GT(ms, 0);
+  ASSERT_LE(ms, 100000);
+}
+
+TEST(cosmo_wheel_expire, farFuture_cascadesCorrectly) {
+  cosmo_timer_t t = {0};
+  uint64_t when = 1000 + (1ull << 26);  // farther than the wheel spans
+  cosmo_wheel_add(w, &t, when);
+  ASSERT_EQ(NULL, cosmo_wheel_expire(w, when - 1));
+  ASSERT_EQ(&t, cosmo_wheel_expire(w, when));
+}
+
+TEST(cosmo_wheel_expire, fuzz) {
+  int n = 1000;
+  uint64_t now = 1000;
+  cosmo_timer_t *t = gc(calloc(n, sizeof(*t)));
+  uint64_t *when = gc(calloc(n, sizeof(*when)));
+  for (int i = 0; i < n; ++i) {
+    when[i] = now + lemur64() % (1 << (lemur64() % 20));
+    cosmo_wheel_add(w, t + i, when[i]);
+  }
+  for (int i = 0; i < n; i += 2)
+    ASSERT_TRUE(cosmo_wheel_cancel(w, t + i));
+  int fired = 0;
+  while (fired < n / 2) {
+    int64_t ms = cosmo_wheel_timeout(w);
+    ASSERT_GE(ms, 0);
+    now += ms;
+    cosmo_timer_t *e;
+    while ((e = cosmo_wheel_expire(w, now))) {
+      int i = e - t;
+      ASSERT_EQ(1, i & 1);
+      ASSERT_EQ(when[i], now);
+      ++fired;
+    }
+  }
+  ASSERT_EQ(-1, cosmo_wheel_timeout(w));
+}
@@ -0,0 +1,87 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/thread/mpsc.h"
+#include "libc/cosmotime.h"
+#include "libc/errno.h"
+#include "libc/testlib/testlib.h"
+#include "libc/thread/thread.h"
+
+#define THREADS    8
+#define ITERATIONS 20000
+
+mpsc_t q;
+
+TEST(mpsc, fifo) {
+  int i, x;
+  ASSERT_EQ(0, mpsc_init(&q, 3, sizeof(int)));
+  ASSERT_FALSE(mpsc_pop(&q, &x));
+  for (i = 0; i < 4; ++i)
+    ASSERT_TRUE(mpsc_push(&q, &i));
+  ASSERT_FALSE(mpsc_push(&q, &i));
+  ASSERT_EQ(4, mpsc_count(&q));
+  for (i = 0; i < 4; ++i) {
+    ASSERT_TRUE(mpsc_pop(&q, &x));
+    ASSERT_EQ(i, x);
+    ASSERT_TRUE(mpsc_push(&q, &i));
+  }
+  ASSERT_EQ(4, mpsc_count(&q));
+  mpsc_destroy(&q);
+}
+
+TEST(mpsc, wait_timesOut) {
+  int x = 1;
+  struct timespec deadline;
+  ASSERT_EQ(0, mpsc_init(&q, 16, sizeof(int)));
+  deadline = timespec_add(timespec_real(), timespec_frommillis(10));
+  ASSERT_EQ(ETIMEDOUT, mpsc_wait(&q, 1, &deadline));
+  ASSERT_EQ(ETIMEDOUT, mpsc_wait(&q, 1, &deadline));
+  ASSERT_TRUE(mpsc_push(&q, &x));
+  ASSERT_EQ(0, mpsc_wait(&q, 1, 0));
+  mpsc_destroy(&q);
+}
+
+void *Producer(void *arg) {
+  long v[2] = {(long)arg};
+  for (v[1] = 0; v[1] < ITERATIONS;)
+    if (mpsc_push(&q, v))
+      ++v[1];
+    else
+      pthread_yield_np();
+  return 0;
+}
+
+TEST(mpsc, torture) {
+  int i;
+  long v[2];
+  pthread_t th[THREADS];
+  long next[THREADS] = {0};
+  ASSERT_EQ(0, mpsc_init(&q, 64, sizeof(v)));
+  for (i = 0; i < THREADS; ++i)
+    ASSERT_EQ(0, pthread_create(th + i, 0, Producer, (void *)(long)i));
+  for (i = 0; i < THREADS * ITERATIONS; ++i) {
+    while (!mpsc_pop(&q, v))
+      ASSERT_EQ(0, mpsc_wait(&q, 1, 0));
+    ASSERT_EQ(next[v[0]]++, v[1]);
+  }
+  for (i = 0; i < THREADS; ++i)
+    ASSERT_EQ(0, pthread_join(th[i], 0));
+  ASSERT_FALSE(mpsc_pop(&q, v));
+  ASSERT_EQ(0, mpsc_count(&q));
+  mpsc_destroy(&q);
+}
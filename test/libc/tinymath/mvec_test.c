@@ -0,0 +1,186 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/limits.h"
+#include "libc/math.h"
+#include "libc/stdio/rand.h"
+#include "libc/str/str.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/testlib.h"
+
+// the 128-bit variants share their kernels with the wider ones
+
+typedef double v2df __attribute__((__vector_size__(16)));
+typedef float v4sf __attribute__((__vector_size__(16)));
+
+#ifdef __x86_64__
+#define MVEC(x) _ZGVbN##x
+#define MVEC_ABI
+#elif defined(__aarch64__)
+#define MVEC(x) _ZGVnN##x
+#define MVEC_ABI __attribute__((__aarch64_vector_pcs__))
+#endif
+
+#ifdef MVEC
+
+MVEC_ABI v2df MVEC(2v_exp)(v2df);
+MVEC_ABI v2df MVEC(2v_log)(v2df);
+MVEC_ABI v2df MVEC(2v_sin)(v2df);
+MVEC_ABI v2df MVEC(2v_cos)(v2df);
+MVEC_ABI v4sf MVEC(4v_expf)(v4sf);
+MVEC_ABI v4sf MVEC(4v_logf)(v4sf);
+MVEC_ABI v4sf MVEC(4v_sinf)(v4sf);
+MVEC_ABI v4sf MVEC(4v_cosf)(v4sf);
+MVEC_ABI v4sf MVEC(4vv_powf)(v4sf, v4sf);
+
+static long UlpsApart(double a, double b) {
+  int64_t x, y;
+  if (isnan(a) || isnan(b))
+    return isnan(a) && isnan(b) ? 0 : LONG_MAX;
+  memcpy(&x, &a, 8);
+  memcpy(&y, &b, 8);
+  if (x < 0)
+    x = INT64_MIN - x;
+  if (y < 0)
+    y = INT64_MIN - y;
+  return x > y ? x - y : y - x;
+}
+
+static long UlpsApartf(float a, float b) {
+  int32_t x, y;
+  if (isnan(a) || isnan(b))
+    return isnan(a) && isnan(b) ? 0 : LONG_MAX;
+  memcpy(&x, &a, 4);
+  memcpy(&y, &b, 4);
+  if (x < 0)
+    x = INT32_MIN - x;
+  if (y < 0)
+    y = INT32_MIN - y;
+  return x > y ? (long)x - y : (long)y - x;
+}
+
+static double Uniform(double lo, double hi) {
+  return lo + (hi - lo) * _real1(_rand64());
+}
+
+static double AnyDouble(void) {
+  double x;
+  uint64_t u = _rand64();
+  memcpy(&x, &u, 8);
+  return x;
+}
+
+static const double kSpecial[] = {
+    0.,      -0.,     1.,      -1.,    INFINITY, -INFINITY, NAN,
+    1e-310,  5e-324,  709.78,  -745.1, 1e300,    -1e300,    M_PI_2,
+    M_PI,    1e6,     -1e22,   100.,   -100.,    .5,        2.,
+};
+
+#define CHECK1(VF, F, GEN, ULPS)                                      \
+  for (i = 0; i < 100000; ++i) {                                     \
+    x = (v2df){GEN, GEN};                                            \
+    y = VF(x);                                                       \
+    for (j = 0; j < 2; ++j)                                          \
+      ASSERT_LE(UlpsApart(y[j], F(x[j])), ULPS);                     \
+  }
+
+TEST(mvec, exp) {
+  int i, j;
+  v2df x, y;
+  CHECK1(MVEC(2v_exp), exp, Uniform(-750, 720), 2);
+  CHECK1(MVEC(2v_exp), exp, kSpecial[i % ARRAYLEN(kSpecial)], 1);
+}
+
+TEST(mvec, log) {
+  int i, j;
+  v2df x, y;
+  CHECK1(MVEC(2v_log), log, fabs(AnyDouble()), 2);
+  CHECK1(MVEC(2v_log), log, Uniform(.5, 2), 2);
+  CHECK1(MVEC(2v_log), log, kSpecial[i % ARRAYLEN(kSpecial)], 1);
+}
+
+TEST(mvec, sin) {
+  int i, j;
+  v2df x, y;
+  CHECK1(MVEC(2v_sin), sin, Uniform(-1e6, 1e6), 2);
+  CHECK1(MVEC(2v_sin), sin, AnyDouble(), 2);
+  CHECK1(MVEC(2v_sin), sin, kSpecial[i % ARRAYLEN(kSpecial)], 1);
+}
+
+TEST(mvec, cos) {
+  int i, j;
+  v2df x, y;
+  CHECK1(MVEC(2v_cos), cos, Uniform(-1e6, 1e6), 2);
+  CHECK1(MVEC(2v_cos), cos, AnyDouble(), 2);
+  CHECK1(MVEC(2v_cos), cos, kSpecial[i % ARRAYLEN(kSpecial)], 1);
+}
+
+TEST(mvec, floats) {
+  int i, j;
+  v4sf x, e, l, s, c;
+  for (i = 0; i < 100000; ++i) {
+    for (j = 0; j < 4; ++j)
+      x[j] = i & 1 ? kSpecial[(i + j) % ARRAYLEN(kSpecial)]
+                   : Uniform(-110, 110);
+    e = MVEC(4v_expf)(x);
+    l = MVEC(4v_logf)(x);
+    s = MVEC(4v_sinf)(x);
+    c = MVEC(4v_cosf)(x);
+    for (j = 0; j < 4; ++j) {
+      ASSERT_LE(UlpsApartf(e[j], expf(x[j])), 1);
+      ASSERT_LE(UlpsApartf(l[j], logf(x[j])), 1);
+      ASSERT_LE(UlpsApartf(s[j], sinf(x[j])), 1);
+      ASSERT_LE(UlpsApartf(c[j], cosf(x[j])), 1);
+    }
+  }
+}
+
+TEST(mvec, powf) {
+  int i, j;
+  float w;
+  v4sf x, y, z;
+  for (i = 0; i < 100000; ++i) {
+    x = (v4sf){Uniform(-10, 10), Uniform(0, 3), (int)Uniform(-5, 5), 1e-3};
+    y = (v4sf){Uniform(-40, 40), (int)Uniform(-50, 50), (int)Uniform(-30, 30),
+               Uniform(-5, 5)};
+    z = MVEC(4vv_powf)(x, y);
+    for (j = 0; j < 4; ++j)
+      ASSERT_LE(UlpsApartf(z[j], powf(x[j], y[j])), 1);
+  }
+  for (i = 0; i < ARRAYLEN(kSpecial); ++i) {
+    for (j = 0; j < ARRAYLEN(kSpecial); ++j) {
+      x = (v4sf){kSpecial[i]};
+      y = (v4sf){kSpecial[j]};
+      z = MVEC(4vv_powf)(x, y);
+      w = powf(x[0], y[0]);
+      ASSERT_LE(UlpsApartf(z[0], w), 1);
+      if (!isnan(w))
+        ASSERT_EQ(!!signbit(w), !!signbit(z[0]));
+    }
+  }
+}
+
+BENCH(mvec, bench) {
+  v2df x = {.7, .8};
+  EZBENCH2("exp", donothing, exp(.7));
+  EZBENCH2("exp [2 lanes]", donothing, MVEC(2v_exp)(x));
+  EZBENCH2("sin", donothing, sin(.7));
+  EZBENCH2("sin [2 lanes]", donothing, MVEC(2v_sin)(x));
+}
+
+#endif /* MVEC */
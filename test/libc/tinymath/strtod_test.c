@@ -18,10 +18,13 @@
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/fmt/conv.h"
 #include "libc/macros.h"
+#include "libc/math.h"
 #include "libc/mem/gc.h"
 #include "libc/mem/mem.h"
 #include "libc/runtime/fenv.h"
+#include "libc/stdio/rand.h"
 #include "libc/stdio/stdio.h"
+#include "libc/str/str.h"
 #include "libc/testlib/ezbench.h"
 #include "libc/testlib/testlib.h"
 #include "libc/x/xasprintf.h"
@@ -421,6 +424,28 @@ TEST(strtod, testTowardzero) {
   }
 }
 
+TEST(strtod, roundTrip) {
+  char buf[32];
+  for (int i = 0; i < 100000; ++i) {
+    union Pun u = {.i = lemur64()};
+    if (!isfinite(u.x))
+      continue;
+    snprintf(buf, sizeof(buf), "%.17g", u.x);
+    ASSERT_EQ(u.i, HEX(strtod(buf, 0)));
+  }
+}
+
+TEST(strtod, matchesDoubleConversion) {
+  char buf[48];
+  for (int i = 0; i < 100000; ++i) {
+    int n = 1 + lemur64() % 19;
+    for (int j = 0; j < n; ++j)
+      buf[j] = '0' + lemur64() % 10;
+    snprintf(buf + n, sizeof(buf) - n, "e%d", (int)(lemur64() % 700) - 350);
+    ASSERT_EQ(HEX(StringToDouble(buf, strlen(buf), 0)), HEX(strtod(buf, 0)));
+  }
+}
+
 BENCH(strtod, bench) {
   char buf[128];
   EZBENCH2("strtod", donothing, strtod("-1.79769313486231e+308", 0));
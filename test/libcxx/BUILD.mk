@@ -46,6 +46,8 @@ $(TEST_LIBCXX_OBJS): private OVERRIDE_CXXFLAGS += -fexceptions -frtti
 
 o/$(MODE)/test/libcxx/openmp_test.o: private CXXFLAGS += -fopenmp -O3
 o/$(MODE)/test/libcxx/openmp_test.runs: private QUOTA += -C100
+o/$(MODE)/test/libcxx/openmp_overhead_test.o: private CXXFLAGS += -fopenmp -O3
+o/$(MODE)/test/libcxx/openmp_overhead_test.runs: private QUOTA += -C100
 
 .PHONY: o/$(MODE)/test/libcxx
 o/$(MODE)/test/libcxx:					\
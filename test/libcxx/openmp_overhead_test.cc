@@ -0,0 +1,87 @@
+/*-*-mode:c++;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8-*-│
+│ vi: set et ft=cpp ts=2 sts=2 sw=2 fenc=utf-8                             :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include <omp.h>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+// measures fork/join cost of tiny parallel loops
+//
+// the first round lets idle workers spin for KMP_BLOCKTIME, and the
+// second round sets the blocktime to zero, so every region has to wake
+// its workers up from a futex. each region is also checked for having
+// computed the right answer, since a lost wakeup would hang or miscount
+
+#define REGIONS 2000
+#define ITEMS   1024
+
+static long nanos(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static void check(long got, long want, const char *what) {
+  if (got != want) {
+    fprintf(stderr, "%s: got %ld but wanted %ld\n", what, got, want);
+    exit(1);
+  }
+}
+
+static void bench(const char *policy) {
+  static int a[ITEMS];
+  long t, sum, want = 0;
+  for (int i = 0; i < ITEMS; ++i)
+    want += (a[i] = i);
+
+  t = nanos();
+  for (int r = 0; r < REGIONS; ++r) {
+    sum = 0;
+#pragma omp parallel reduction(+ : sum)
+    sum += 1;
+    check(sum, omp_get_max_threads(), "parallel region");
+  }
+  printf("%8ld ns %s parallel region\n", (nanos() - t) / REGIONS, policy);
+
+  t = nanos();
+  for (int r = 0; r < REGIONS; ++r) {
+    sum = 0;
+#pragma omp parallel for reduction(+ : sum)
+    for (int i = 0; i < ITEMS; ++i)
+      sum += a[i];
+    check(sum, want, "parallel for reduction");
+  }
+  printf("%8ld ns %s parallel for reduction over %d ints\n",
+         (nanos() - t) / REGIONS, policy, ITEMS);
+
+  t = nanos();
+#pragma omp parallel
+  for (int r = 0; r < REGIONS; ++r) {
+#pragma omp barrier
+  }
+  printf("%8ld ns %s barrier\n", (nanos() - t) / REGIONS, policy);
+}
+
+int main(int argc, char *argv[]) {
+  printf("%d threads, %d places, proc_bind=%d\n", omp_get_max_threads(),
+         omp_get_num_places(), (int)omp_get_proc_bind());
+  bench("spinning");
+  kmp_set_blocktime(0);
+  bench("sleeping");
+}
@@ -86,6 +86,34 @@ TEST(Base64, RoundTrip) {
   }
 }
 
+TEST(Base64, LongRoundTrip_matchesMbedtls) {
+  size_t k, olen;
+  char x[300], y[401], z[404];
+  for (i = 0; i < 1000; ++i) {
+    n = rand() % sizeof(x);
+    arc4random_buf(x, n);
+    p = EncodeBase64(x, n, &m);
+    ASSERT_EQ(0, mbedtls_base64_encode((void *)y, sizeof(y), &olen,
+                                       (void *)x, n));
+    ASSERT_EQ(olen, m);
+    ASSERT_EQ(0, memcmp(y, p, m));
+    k = m / 8 * 4;
+    memcpy(z, p, k);
+    memcpy(z + k, "\r\n", 2);
+    memcpy(z + k + 2, p + k, m - k);
+    z[m + 2] = '\0';
+    q = DecodeBase64(p, m, &m);
+    ASSERT_EQ(n, m);
+    ASSERT_EQ(0, memcmp(x, q, n));
+    free(q);
+    q = DecodeBase64(z, -1, &m);
+    ASSERT_EQ(n, m);
+    ASSERT_EQ(0, memcmp(x, q, n));
+    free(q);
+    free(p);
+  }
+}
+
 TEST(Base64, Fuzz) {
   for (i = 0; i < 1000; ++i) {
     n = rand() % 32;
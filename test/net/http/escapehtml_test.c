@@ -41,6 +41,13 @@ TEST(escapehtml, testLargeGrowth) {
   EXPECT_STREQ("&quot;&quot;&quot;", gc(escapehtml("\"\"\"")));
 }
 
+TEST(escapehtml, testLongRuns_copiedVerbatim) {
+  EXPECT_STREQ("the quick brown fox jumps over the lazy dog &amp; "
+               "the quick brown fox jumps over the lazy &lt;dog&gt;",
+               gc(escapehtml("the quick brown fox jumps over the lazy dog & "
+                             "the quick brown fox jumps over the lazy <dog>")));
+}
+
 TEST(escapehtml, testEmpty) {
   EXPECT_STREQ("", gc(escapehtml("")));
 }
@@ -0,0 +1,192 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "net/http/hpack.h"
+#include "libc/mem/mem.h"
+#include "libc/stdio/stdio.h"
+#include "libc/str/str.h"
+#include "libc/testlib/testlib.h"
+
+struct HpackTable t;
+char got[16][64];
+int count;
+
+void SetUp(void) {
+  count = 0;
+  InitHpackTable(&t, 4096);
+}
+
+void TearDown(void) {
+  DestroyHpackTable(&t);
+}
+
+int OnHeader(void *arg, const struct HpackHeader *h) {
+  snprintf(got[count++], sizeof(got[0]), "%.*s: %.*s", (int)h->namelen,
+           h->name, (int)h->valuelen, h->value);
+  return 0;
+}
+
+TEST(DecodeHpackInt, rfc7541_c1) {
+  uint64_t x;
+  EXPECT_EQ(1, DecodeHpackInt("\x0a", 1, 5, &x));
+  EXPECT_EQ(10, x);
+  EXPECT_EQ(3, DecodeHpackInt("\x1f\x9a\x0a", 3, 5, &x));
+  EXPECT_EQ(1337, x);
+  EXPECT_EQ(1, DecodeHpackInt("\x2a", 1, 8, &x));
+  EXPECT_EQ(42, x);
+}
+
+TEST(DecodeHpackInt, truncated_needsMoreData) {
+  uint64_t x;
+  EXPECT_EQ(0, DecodeHpackInt("\x1f\x9a", 2, 5, &x));
+}
+
+TEST(DecodeHpackInt, overflow_isError) {
+  uint64_t x;
+  EXPECT_EQ(-1, DecodeHpackInt("\x7f\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff",
+                               11, 7, &x));
+}
+
+TEST(EncodeHpackInt, rfc7541_c1) {
+  char b[11];
+  EXPECT_EQ(1, EncodeHpackInt(b, 5, 0, 10) - b);
+  EXPECT_EQ(0x0a, b[0] & 255);
+  EXPECT_EQ(3, EncodeHpackInt(b, 5, 0, 1337) - b);
+  EXPECT_EQ(0x1f, b[0] & 255);
+  EXPECT_EQ(0x9a, b[1] & 255);
+  EXPECT_EQ(0x0a, b[2] & 255);
+}
+
+TEST(DecodeHpackHuffman, wwwExampleCom) {
+  char b[32];
+  EXPECT_EQ(15, DecodeHpackHuffman("\xf1\xe3\xc2\xe5\xf2\x3a\x6b\xa0\xab\x90"
+                                   "\xf4\xff",
+                                   12, b, sizeof(b)));
+  EXPECT_STREQ("www.example.com", b);
+}
+
+TEST(DecodeHpackHuffman, badPadding_isError) {
+  char b[32];
+  EXPECT_EQ(-1, DecodeHpackHuffman("\xf1\xe3\xc2\xe5\xf2\x3a\x6b\xa0\xab\x90"
+                                   "\xf4\xfe",
+                                   12, b, sizeof(b)));
+}
+
+TEST(DecodeHpackHuffman, longPadding_isError) {
+  char b[32];
+  EXPECT_EQ(-1, DecodeHpackHuffman("\xff", 1, b, sizeof(b)));
+}
+
+TEST(EncodeHpackHuffman, roundTrip) {
+  int c;
+  char s[256], b[1024], d[512];
+  for (c = 0; c < 256; ++c)
+    s[c] = c;
+  EXPECT_EQ(GetHpackHuffmanSize(s, 256), EncodeHpackHuffman(b, s, 256) - b);
+  EXPECT_EQ(256, DecodeHpackHuffman(b, GetHpackHuffmanSize(s, 256), d,
+                                    sizeof(d)));
+  EXPECT_EQ(0, memcmp(s, d, 256));
+}
+
+TEST(DecodeHpack, rfc7541_c2_1_literalWithIndexing) {
+  const char s[] = "\x40\x0a"
+                   "custom-key"
+                   "\x0d"
+                   "custom-header";
+  EXPECT_EQ(0, DecodeHpack(&t, s, sizeof(s) - 1, OnHeader, 0));
+  EXPECT_EQ(1, count);
+  EXPECT_STREQ("custom-key: custom-header", got[0]);
+  EXPECT_EQ(1, t.n);
+  EXPECT_EQ(55, t.size);
+}
+
+TEST(DecodeHpack, rfc7541_c2_2_literalWithoutIndexing) {
+  const char s[] = "\x04\x0c/sample/path";
+  EXPECT_EQ(0, DecodeHpack(&t, s, sizeof(s) - 1, OnHeader, 0));
+  EXPECT_STREQ(":path: /sample/path", got[0]);
+  EXPECT_EQ(0, t.n);
+}
+
+TEST(DecodeHpack, rfc7541_c4_huffmanRequests) {
+  const char r1[] = "\x82\x86\x84\x41\x8c\xf1\xe3\xc2\xe5\xf2\x3a\x6b\xa0\xab"
+                    "\x90\xf4\xff";
+  const char r2[] = "\x82\x86\x84\xbe\x58\x86\xa8\xeb\x10\x64\x9c\xbf";
+  EXPECT_EQ(0, DecodeHpack(&t, r1, sizeof(r1) - 1, OnHeader, 0));
+  EXPECT_EQ(4, count);
+  EXPECT_STREQ(":method: GET", got[0]);
+  EXPECT_STREQ(":scheme: http", got[1]);
+  EXPECT_STREQ(":path: /", got[2]);
+  EXPECT_STREQ(":authority: www.example.com", got[3]);
+  EXPECT_EQ(57, t.size);
+  count = 0;
+  EXPECT_EQ(0, DecodeHpack(&t, r2, sizeof(r2) - 1, OnHeader, 0));
+  EXPECT_EQ(5, count);
+  EXPECT_STREQ(":authority: www.example.com", got[3]);
+  EXPECT_STREQ("cache-control: no-cache", got[4]);
+  EXPECT_EQ(110, t.size);
+}
+
+TEST(DecodeHpack, eviction) {
+  InitHpackTable(&t, 64);
+  const char s[] = "\x40\x01"
+                   "a"
+                   "\x01"
+                   "b"
+                   "\x40\x01"
+                   "c"
+                   "\x01"
+                   "d"
+                   "\xbe";
+  EXPECT_EQ(0, DecodeHpack(&t, s, sizeof(s) - 1, OnHeader, 0));
+  EXPECT_EQ(3, count);
+  EXPECT_STREQ("c: d", got[2]);
+  EXPECT_EQ(1, t.n);
+}
+
+TEST(DecodeHpack, badIndex_isError) {
+  EXPECT_EQ(-1, DecodeHpack(&t, "\x80", 1, OnHeader, 0));
+  EXPECT_EQ(-1, DecodeHpack(&t, "\xbe", 1, OnHeader, 0));
+}
+
+TEST(DecodeHpack, sizeUpdateAfterHeader_isError) {
+  EXPECT_EQ(0, DecodeHpack(&t, "\x3f\xe1\x1f", 3, OnHeader, 0));
+  EXPECT_EQ(-1, DecodeHpack(&t, "\x82\x3f\xe1\x1f", 4, OnHeader, 0));
+}
+
+TEST(DecodeHpack, sizeUpdateAboveLimit_isError) {
+  EXPECT_EQ(-1, DecodeHpack(&t, "\x3f\xe2\x1f", 3, OnHeader, 0));
+}
+
+TEST(DecodeHpack, truncatedString_isError) {
+  EXPECT_EQ(-1, DecodeHpack(&t, "\x04\x0c/sample", 9, OnHeader, 0));
+}
+
+TEST(EncodeHpackHeader, roundTrip) {
+  char b[128], *p = b;
+  p = EncodeHpackHeader(p, ":method", 7, "GET", 3);
+  EXPECT_EQ(1, p - b);
+  EXPECT_EQ(0x82, b[0] & 255);
+  p = EncodeHpackHeader(p, ":status", 7, "418", 3);
+  p = EncodeHpackHeader(p, "x-powered-by", 12, "redbean", 7);
+  EXPECT_EQ(0, DecodeHpack(&t, b, p - b, OnHeader, 0));
+  EXPECT_EQ(3, count);
+  EXPECT_STREQ(":method: GET", got[0]);
+  EXPECT_STREQ(":status: 418", got[1]);
+  EXPECT_STREQ("x-powered-by: redbean", got[2]);
+  EXPECT_EQ(0, t.n);
+}
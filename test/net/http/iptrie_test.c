@@ -0,0 +1,71 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/errno.h"
+#include "libc/testlib/ezbench.h"
+#include "libc/testlib/testlib.h"
+#include "net/http/ip.h"
+
+struct IpTrie t;
+
+void TearDown(void) {
+  FreeIpTrie(&t);
+}
+
+TEST(LookupIpTrie, empty_returnsZero) {
+  EXPECT_EQ(0, LookupIpTrie(&t, 0x0a000001));
+}
+
+TEST(LookupIpTrie, longestPrefixWins_regardlessOfOrder) {
+  ASSERT_EQ(0, AddIpTrie(&t, 0x0a0a0a00, 24, 3));
+  ASSERT_EQ(0, AddIpTrie(&t, 0x0a000000, 8, 1));
+  ASSERT_EQ(0, AddIpTrie(&t, 0x0a0a0000, 16, 2));
+  ASSERT_EQ(0, AddIpTrie(&t, 0x0a0a0a07, 32, 4));
+  EXPECT_EQ(1, LookupIpTrie(&t, 0x0a010203));
+  EXPECT_EQ(2, LookupIpTrie(&t, 0x0a0a0b01));
+  EXPECT_EQ(3, LookupIpTrie(&t, 0x0a0a0a01));
+  EXPECT_EQ(4, LookupIpTrie(&t, 0x0a0a0a07));
+  EXPECT_EQ(0, LookupIpTrie(&t, 0x0b0a0a07));
+}
+
+TEST(LookupIpTrie, hostBitsIgnored) {
+  ASSERT_EQ(0, AddIpTrie(&t, 0xc0a80001, 16, 7));
+  EXPECT_EQ(7, LookupIpTrie(&t, 0xc0a8ffff));
+  EXPECT_EQ(0, LookupIpTrie(&t, 0xc0a90000));
+}
+
+TEST(LookupIpTrie, defaultRoute) {
+  ASSERT_EQ(0, AddIpTrie(&t, 0, 0, 9));
+  ASSERT_EQ(0, AddIpTrie(&t, 0x7f000000, 8, 5));
+  EXPECT_EQ(9, LookupIpTrie(&t, 0xffffffff));
+  EXPECT_EQ(5, LookupIpTrie(&t, 0x7f000001));
+}
+
+TEST(AddIpTrie, badArgs_einval) {
+  EXPECT_EQ(-1, AddIpTrie(&t, 0, 33, 1));
+  EXPECT_EQ(EINVAL, errno);
+  EXPECT_EQ(-1, AddIpTrie(&t, 0, 8, 0));
+  EXPECT_EQ(-1, AddIpTrie(&t, 0, 8, 65536));
+}
+
+BENCH(LookupIpTrie, bench) {
+  int i;
+  for (i = 0; i < 4096; ++i)
+    AddIpTrie(&t, i * 0x9e3779b9u, 12 + i % 21, 1);
+  EZBENCH2("LookupIpTrie", donothing, LookupIpTrie(&t, 0x0a0a0a07));
+}
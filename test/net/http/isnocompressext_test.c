@@ -25,4 +25,8 @@ TEST(IsNoCompressExt, test) {
   EXPECT_FALSE(IsNoCompressExt("dog", -1));
   EXPECT_TRUE(IsNoCompressExt("dog.mp4", -1));
   EXPECT_FALSE(IsNoCompressExt("dog.mp4mp4mp4", -1));
+  EXPECT_TRUE(IsNoCompressExt("app.js.br", -1));
+  EXPECT_TRUE(IsNoCompressExt("app.js.zst", -1));
+  EXPECT_TRUE(IsNoCompressExt("app.js.gz", -1));
+  EXPECT_FALSE(IsNoCompressExt("app.js", -1));
 }
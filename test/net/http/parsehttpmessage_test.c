@@ -243,6 +243,38 @@ Accept-Language: en-US,en;q=0.9\r\n\
   EXPECT_STREQ("", gc(slice(m, req->headers[kHttpExpect])));
 }
 
+TEST(ParseHttpMessage, testFragmented_resumesWhereItLeftOff) {
+  size_t i;
+  struct HttpMessage whole;
+  static const char m[] = "\
+GET /tool/net/redbean.png?dkdkdkdkdkdkdkdkdkdkdkdkdkdkdkdkdkdkdkdkdkdk HTTP/1.1\r\n\
+Host: 10.10.10.124:8080\r\n\
+User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/89.0.4389.90 Safari/537.36\r\n\
+Accept: image/avif,image/webp,image/apng,image/svg+xml,image/*,*/*;q=0.8\r\n\
+Accept: text/html\r\n\
+X-Whatever:  \tvalue with trailing whitespace \t\r\n\
+\r\n";
+  InitHttpMessage(&whole, kHttpRequest);
+  ASSERT_EQ(strlen(m), ParseHttpMessage(&whole, m, strlen(m), strlen(m)));
+  InitHttpMessage(req, kHttpRequest);
+  for (i = 1; i < strlen(m); ++i) {
+    ASSERT_EQ(0, ParseHttpMessage(req, m, i, strlen(m)));
+    ASSERT_EQ(i, req->i);  // each byte is only ever looked at once
+  }
+  ASSERT_EQ(strlen(m), ParseHttpMessage(req, m, i, strlen(m)));
+  EXPECT_EQ(0, memcmp(whole.headers, req->headers, sizeof(req->headers)));
+  EXPECT_EQ(whole.uri.a, req->uri.a);
+  EXPECT_EQ(whole.uri.b, req->uri.b);
+  EXPECT_EQ(whole.method, req->method);
+  EXPECT_EQ(whole.version, req->version);
+  ASSERT_EQ(whole.xheaders.n, req->xheaders.n);
+  EXPECT_EQ(0, memcmp(whole.xheaders.p, req->xheaders.p,
+                      req->xheaders.n * sizeof(*req->xheaders.p)));
+  EXPECT_STREQ("value with trailing whitespace",
+               gc(slice(m, req->xheaders.p[req->xheaders.n - 1].v)));
+  DestroyHttpMessage(&whole);
+}
+
 TEST(ParseHttpMessage, testExtendedHeaders) {
   static const char m[] = "\
 GET /foo?bar%20hi HTTP/1.0\r\n\
@@ -69,6 +69,54 @@ TEST(tokenbucket, test) {
   ASSERT_EQ(127, AcquireToken(tok.b, 0x08080808, TB_CIDR));
 }
 
+#define SEC(x) timespec_fromseconds(x)
+
+TEST(TokenBuckets, ipv4) {
+  struct TokenBuckets *tb;
+  ASSERT_NE(NULL, (tb = malloc(GetTokenBucketsSize(1000))));
+  InitTokenBuckets(tb, 1000, 24, 64, SEC(1));
+  ASSERT_EQ(127, CountTokens4(tb, 0x7f000001, SEC(1)));
+  ASSERT_EQ(127, AcquireToken4(tb, 0x7f000001, SEC(1)));
+  ASSERT_EQ(126, AcquireToken4(tb, 0x7f0000ff, SEC(1)));  // same /24
+  ASSERT_EQ(127, AcquireToken4(tb, 0x7f000101, SEC(1)));  // different /24
+  for (int i = 0; i < 125; ++i)
+    AcquireToken4(tb, 0x7f000001, SEC(1));
+  ASSERT_EQ(0, AcquireToken4(tb, 0x7f000001, SEC(1)));
+  ASSERT_EQ(0, CountTokens4(tb, 0x7f000001, SEC(1)));
+  ASSERT_EQ(2, CountTokens4(tb, 0x7f000001, SEC(3)));
+  ASSERT_EQ(2, AcquireToken4(tb, 0x7f000001, SEC(3)));
+  ASSERT_EQ(127, CountTokens4(tb, 0x7f000001, SEC(1000)));
+  free(tb);
+}
+
+TEST(TokenBuckets, ipv6) {
+  struct TokenBuckets *tb;
+  uint8_t a[16] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 1, 1, 2, 3, 4, 5, 6, 7, 8};
+  uint8_t b[16] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 1, 9, 9, 9, 9, 9, 9, 9, 9};
+  uint8_t c[16] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 2, 1, 2, 3, 4, 5, 6, 7, 8};
+  uint8_t m[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff, 127, 0, 0, 1};
+  ASSERT_NE(NULL, (tb = malloc(GetTokenBucketsSize(1000))));
+  InitTokenBuckets(tb, 1000, 24, 64, SEC(1));
+  ASSERT_EQ(127, AcquireToken6(tb, a, SEC(1)));
+  ASSERT_EQ(126, AcquireToken6(tb, b, SEC(1)));  // same /64
+  ASSERT_EQ(127, AcquireToken6(tb, c, SEC(1)));  // different /64
+  ASSERT_EQ(127, AcquireToken6(tb, m, SEC(1)));  // ipv4-mapped
+  ASSERT_EQ(126, AcquireToken4(tb, 0x7f000001, SEC(1)));
+  free(tb);
+}
+
+TEST(TokenBuckets, manyClients_evictsFullestBuckets) {
+  struct TokenBuckets *tb;
+  ASSERT_NE(NULL, (tb = malloc(GetTokenBucketsSize(1000))));
+  InitTokenBuckets(tb, 1000, 32, 64, SEC(1));
+  for (int i = 0; i < 127; ++i)
+    AcquireToken4(tb, 0x08080808, SEC(1));
+  for (uint32_t i = 0; i < 100000; ++i)
+    AcquireToken4(tb, i, SEC(1));
+  ASSERT_EQ(0, CountTokens4(tb, 0x08080808, SEC(1)));
+  free(tb);
+}
+
 void NaiveReplenishTokens(atomic_schar *b, size_t n) {
   for (size_t i = 0; i < n; ++i) {
     int x = atomic_load_explicit(b + i, memory_order_relaxed);
@@ -147,6 +147,73 @@ TEST(mbedtls, selfTest) {
 }
 #endif /* MBEDTLS_SELF_TEST */
 
+TEST(chacha20, multiblock_matchesHacl) {
+  // sizes straddle the 4, 8, and 16 block vector paths
+  int i, n;
+  uint32_t ctr;
+  uint8_t key[32], nonce[12];
+  uint8_t in[1200], want[1200], got[1200];
+  for (i = 0; i < 200; ++i) {
+    n = _rand64() % sizeof(in);
+    ctr = i & 1 ? -(_rand64() % 20) : _rand64();
+    arc4random_buf(key, sizeof(key));
+    arc4random_buf(nonce, sizeof(nonce));
+    arc4random_buf(in, n);
+    Hacl_Chacha20_chacha20_encrypt(n, want, in, key, nonce, ctr);
+    ASSERT_EQ(0, mbedtls_chacha20_crypt(key, nonce, ctr, n, in, got));
+    ASSERT_EQ(0, memcmp(want, got, n));
+  }
+}
+
+TEST(gcm, stitched_matchesBlockwise) {
+  // 16-byte updates never reach the multi-block path
+  int i, bits, mode;
+  size_t j, k, n;
+  mbedtls_gcm_context ctx;
+  uint8_t key[32], iv[12], aad[20], tag1[16], tag2[16];
+  uint8_t in[1200], want[1200], got[1200];
+  for (i = 0; i < 60; ++i) {
+    bits = 128 + 64 * (i % 3);
+    mode = i & 1 ? MBEDTLS_GCM_ENCRYPT : MBEDTLS_GCM_DECRYPT;
+    n = _rand64() % sizeof(in);
+    arc4random_buf(key, sizeof(key));
+    arc4random_buf(iv, sizeof(iv));
+    arc4random_buf(aad, sizeof(aad));
+    arc4random_buf(in, n);
+    mbedtls_gcm_init(&ctx);
+    ASSERT_EQ(0, mbedtls_gcm_setkey(&ctx, MBEDTLS_CIPHER_ID_AES, key, bits));
+    ASSERT_EQ(0, mbedtls_gcm_starts(&ctx, mode, iv, 12, aad, sizeof(aad)));
+    for (j = 0; j < n; j += k) {
+      k = MIN(16, n - j);
+      ASSERT_EQ(0, mbedtls_gcm_update(&ctx, k, in + j, want + j));
+    }
+    ASSERT_EQ(0, mbedtls_gcm_finish(&ctx, tag1, 16));
+    ASSERT_EQ(0, mbedtls_gcm_starts(&ctx, mode, iv, 12, aad, sizeof(aad)));
+    ASSERT_EQ(0, mbedtls_gcm_update(&ctx, n, in, got));
+    ASSERT_EQ(0, mbedtls_gcm_finish(&ctx, tag2, 16));
+    mbedtls_gcm_free(&ctx);
+    ASSERT_EQ(0, memcmp(want, got, n));
+    ASSERT_EQ(0, memcmp(tag1, tag2, 16));
+  }
+}
+
+TEST(poly1305, matchesHacl) {
+  int i, n;
+  uint8_t key[32], in[1200], want[16], got[16];
+  for (i = 0; i < 200; ++i) {
+    n = _rand64() % sizeof(in);
+    arc4random_buf(key, sizeof(key));
+    if (i & 1) {
+      memset(in, 255, n);
+    } else {
+      arc4random_buf(in, n);
+    }
+    Hacl_MAC_Poly1305_mac(want, in, n, key);
+    ASSERT_EQ(0, mbedtls_poly1305_mac(key, in, n, got));
+    ASSERT_EQ(0, memcmp(want, got, 16));
+  }
+}
+
 static void P256_MPI(mbedtls_mpi *N) {
   memcpy(N->p, rng, 8 * 8);
   ASSERT_EQ(0, mbedtls_mpi_mod_mpi(N, N, &grp.P));
@@ -190,6 +257,63 @@ BENCH(p384, bench) {
 #endif
 }
 
+#ifdef MBEDTLS_ECP_C
+TEST(p256, builtinComb_matchesComputedComb) {
+  int i;
+  mbedtls_ecp_point Q, R1, R2;
+  mbedtls_mpi k, k3, three;
+  mbedtls_ecp_group_init(&grp);
+  mbedtls_ecp_point_init(&Q);
+  mbedtls_ecp_point_init(&R1);
+  mbedtls_ecp_point_init(&R2);
+  mbedtls_mpi_init(&k);
+  mbedtls_mpi_init(&k3);
+  mbedtls_mpi_init(&three);
+  ASSERT_EQ(0, mbedtls_ecp_group_load(&grp, MBEDTLS_ECP_DP_SECP256R1));
+  ASSERT_EQ(0, mbedtls_mpi_lset(&three, 3));
+  ASSERT_EQ(0, mbedtls_ecp_mul(&grp, &Q, &three, &grp.G, GetEntropy, 0));
+  // k×3G uses a table computed for 3G, whereas 3k×G uses the built-in one
+  for (i = 0; i < 100; ++i) {
+    ASSERT_EQ(0, mbedtls_mpi_fill_random(&k, 32, GetEntropy, 0));
+    ASSERT_EQ(0, mbedtls_mpi_mod_mpi(&k, &k, &grp.N));
+    ASSERT_EQ(0, mbedtls_mpi_mul_mpi(&k3, &k, &three));
+    ASSERT_EQ(0, mbedtls_mpi_mod_mpi(&k3, &k3, &grp.N));
+    ASSERT_EQ(0, mbedtls_ecp_mul(&grp, &R1, &k, &Q, GetEntropy, 0));
+    ASSERT_EQ(0, mbedtls_ecp_mul(&grp, &R2, &k3, &grp.G, GetEntropy, 0));
+    ASSERT_EQ(0, mbedtls_ecp_point_cmp(&R1, &R2));
+  }
+  ASSERT_EQ(0, grp.T_size);  // built-in table isn't copied into group
+  mbedtls_mpi_free(&three);
+  mbedtls_mpi_free(&k3);
+  mbedtls_mpi_free(&k);
+  mbedtls_ecp_point_free(&R2);
+  mbedtls_ecp_point_free(&R1);
+  mbedtls_ecp_point_free(&Q);
+  mbedtls_ecp_group_free(&grp);
+}
+
+BENCH(p256, mul) {
+  mbedtls_mpi k;
+  mbedtls_ecp_point Q, R;
+  mbedtls_ecp_group_init(&grp);
+  mbedtls_ecp_point_init(&Q);
+  mbedtls_ecp_point_init(&R);
+  mbedtls_mpi_init(&k);
+  mbedtls_ecp_group_load(&grp, MBEDTLS_ECP_DP_SECP256R1);
+  mbedtls_mpi_fill_random(&k, 32, GetEntropy, 0);
+  mbedtls_mpi_mod_mpi(&k, &k, &grp.N);
+  mbedtls_ecp_mul(&grp, &Q, &k, &grp.G, GetEntropy, 0);
+  EZBENCH2("P-256 k×G", donothing,
+           mbedtls_ecp_mul(&grp, &R, &k, &grp.G, GetEntropy, 0));
+  EZBENCH2("P-256 k×Q", donothing,
+           mbedtls_ecp_mul(&grp, &R, &k, &Q, GetEntropy, 0));
+  mbedtls_mpi_free(&k);
+  mbedtls_ecp_point_free(&R);
+  mbedtls_ecp_point_free(&Q);
+  mbedtls_ecp_group_free(&grp);
+}
+#endif
+
 TEST(md, test) {
   uint8_t d[16];
   uint8_t want[16] = {0x90, 0x01, 0x50, 0x98, 0x3C, 0xD2, 0x4F, 0xB0,
@@ -243,6 +367,26 @@ TEST(sha256, test) {
   EXPECT_EQ(0, memcmp(want, d, 32));
 }
 
+TEST(sha256, multi_matchesSingle) {
+  // counts and sizes straddle the lane widths and padding boundaries
+  int i, n;
+  size_t sizes[40];
+  const void *inputs[40];
+  uint8_t in[40][300], want[32], got[40][32];
+  for (n = 0; n <= 40; ++n) {
+    for (i = 0; i < n; ++i) {
+      sizes[i] = _rand64() % sizeof(in[i]);
+      inputs[i] = in[i];
+      arc4random_buf(in[i], sizes[i]);
+    }
+    ASSERT_EQ(0, mbedtls_sha256_multi(inputs, sizes, n, got));
+    for (i = 0; i < n; ++i) {
+      mbedtls_sha256_ret(in[i], sizes[i], want, 0);
+      ASSERT_EQ(0, memcmp(want, got[i], 32));
+    }
+  }
+}
+
 TEST(sha384, test) {
   uint8_t d[70];
   uint8_t want[48] = {
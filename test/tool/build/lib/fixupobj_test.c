@@ -0,0 +1,45 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "tool/build/lib/fixupobj.h"
+#include "libc/x/x.h"
+#include "libc/testlib/testlib.h"
+
+char err[512];
+
+void SetUpOnce(void) {
+  testlib_enable_tmp_setup_teardown();
+}
+
+TEST(FixupObject, missingFile_fails) {
+  ASSERT_EQ(-1, FixupObject("nope.o", false, err, sizeof(err)));
+  EXPECT_STARTSWITH("nope.o: open failed", err);
+}
+
+TEST(FixupObject, emptyFile_isLeftAlone) {
+  ASSERT_NE(-1, xbarf("empty.o", "", 0));
+  ASSERT_EQ(0, FixupObject("empty.o", false, err, sizeof(err)));
+}
+
+TEST(FixupObject, notElf_fails) {
+  ASSERT_NE(-1, xbarf("junk.o", "hello there", -1));
+  ASSERT_EQ(-1, FixupObject("junk.o", false, err, sizeof(err)));
+  EXPECT_STREQ("junk.o: not an elf64 binary", err);
+  ASSERT_EQ(-1, FixupObject("junk.o", true, err, sizeof(err)));
+  EXPECT_STREQ("junk.o: not an elf64 binary", err);
+}
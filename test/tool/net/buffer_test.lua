@@ -0,0 +1,113 @@
+-- Copyright 2025 Justine Alexandra Roberts Tunney
+--
+-- Permission to use, copy, modify, and/or distribute this software for
+-- any purpose with or without fee is hereby granted, provided that the
+-- above copyright notice and this permission notice appear in all copies.
+--
+-- THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+-- WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+-- WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+-- AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+-- DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+-- PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+-- TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+-- PERFORMANCE OF THIS SOFTWARE.
+
+tmpdir = "%s/o/tmp/buffer_test.%d" % {os.getenv('TMPDIR'), unix.getpid()}
+
+local function Path(name)
+   return tmpdir .. '/' .. name
+end
+
+local function BufferTest()
+
+   -- appending and slicing
+   b = unix.Buffer()
+   assert(#b == 0)
+   assert(tostring(b) == '')
+   assert(b:append('hello', ' ', 'world') == b)
+   assert(#b == 11)
+   assert(tostring(b) == 'hello world')
+   for _, r in ipairs{{1, 5}, {7}, {-5}, {-5, -2}, {0, 3}, {4, 2}, {2, 99}} do
+      assert(tostring(b:sub(table.unpack(r))) == ('hello world'):sub(table.unpack(r)))
+   end
+   assert(EncodeLua(b) == 'unix.Buffer(11)')
+
+   -- slices don't change when their parent is appended to or cleared
+   s = b:sub(1, 5)
+   t = b:sub(7)
+   b:append('!')
+   assert(tostring(b) == 'hello world!')
+   assert(tostring(t) == 'world')
+   t:append('?')
+   assert(tostring(t) == 'world?')
+   assert(tostring(b) == 'hello world!')
+   b:clear()
+   assert(#b == 0)
+   b:append('x')
+   assert(tostring(s) == 'hello')
+   assert(tostring(b) == 'x')
+
+   -- buffers may be appended to themselves
+   b = unix.Buffer('ab')
+   b:append(b, b:sub(1, 1))
+   assert(tostring(b) == 'ababa')
+
+   -- big appends
+   b = unix.Buffer(4)
+   for i = 1, 1000 do
+      b:append('abc123')
+   end
+   assert(tostring(b) == 'abc123' * 1000)
+
+   -- closing frees memory early
+   b:close()
+   assert(not pcall(function() return #b end))
+
+   -- reading and writing
+   data = 'abc123' * 5000
+   fd = assert(unix.open(Path('foo'), unix.O_RDWR | unix.O_CREAT, 0644))
+   assert(assert(unix.write(fd, unix.Buffer(data))) == #data)
+   b = unix.Buffer()
+   assert(assert(unix.read(fd, b, 10, 0)) == 10)
+   assert(assert(unix.read(fd, b, 100000, 10)) == #data - 10)
+   assert(assert(unix.read(fd, b, 100, #data)) == 0)
+   assert(tostring(b) == data)
+   assert(assert(unix.write(fd, b:sub(1, 3), 1)) == 3)
+   assert(assert(unix.read(fd, 6, 0)) == 'aabc23')
+
+   -- mapping files
+   m = assert(unix.mapbuffer(fd))
+   assert(#m == #data)
+   assert(tostring(m:sub(1, 6)) == 'aabc23')
+   m = assert(unix.mapbuffer(fd, 3, 5000))
+   assert(tostring(m) == data:sub(5001, 5003))
+   m:append('!')
+   assert(tostring(m) == data:sub(5001, 5003) .. '!')
+   assert(unix.close(fd))
+
+   -- slurping into a buffer
+   assert(Barf(Path('foo'), data))
+   b = unix.Buffer('>')
+   assert(Slurp(Path('foo'), b) == b)
+   assert(tostring(b) == '>' .. data)
+   assert(tostring(Slurp(Path('foo'), 2, 3, unix.Buffer())) == 'bc')
+   assert(tostring(Slurp(Path('foo'), -3, unix.Buffer())) == data:sub(-3))
+
+end
+
+local function main()
+   assert(unix.makedirs(tmpdir))
+   unix.unveil(tmpdir, "rwc")
+   unix.unveil(nil, nil)
+   assert(unix.pledge("stdio rpath wpath cpath"))
+   ok, err = pcall(BufferTest)
+   if ok then
+      assert(unix.rmrf(tmpdir))
+   else
+      print(err)
+      error('BufferTest failed (%s)' % {tmpdir})
+   end
+end
+
+main()
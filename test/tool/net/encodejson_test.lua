@@ -100,6 +100,11 @@ x.c = 'c'
 x.a = 'a'
 x.b = 'b'
 assert(EncodeJson(x) == '{"a":"a","b":"b","c":"c"}')
+assert(EncodeJson({ab=1, a=2, ["a\""]=3, b={d=4, c={f=5, e=6}}}) ==
+       '{"a":2,"a\\"":3,"ab":1,"b":{"c":{"e":6,"f":5},"d":4}}')
+x = ('hello world '):rep(100)
+assert(EncodeJson({x, x .. '<', x}) ==
+       '["' .. x .. '","' .. x .. '\\u003c","' .. x .. '"]')
 
 assert(EncodeJson(0, {maxdepth=1}))
 val, err = EncodeJson(0, {maxdepth=0})
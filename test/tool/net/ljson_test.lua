@@ -56,6 +56,19 @@ assert(not DecodeJson('"\xc0\x80"'))
 assert(not DecodeJson('"\xc1\x80"'))
 assert(DecodeJson('"\xc2\x80"'))
 
+-- long runs take the vectorized string and whitespace scanners
+s = ('abcdefghijklmnopqrstuvwxyz0123456789'):rep(3)
+assert(assert(DecodeJson('"' .. s .. '"')) == s)
+assert(assert(DecodeJson('"' .. s .. '\\n' .. s .. '"')) == s .. '\n' .. s)
+assert(assert(DecodeJson('"' .. s .. 'Ā' .. s .. '"')) == s .. 'Ā' .. s)
+assert(assert(DecodeJson('[' .. (' '):rep(70) .. '1\n\t\r' .. (' '):rep(40) .. ']'))[1] == 1)
+res, err = DecodeJson('"' .. s .. '\x01' .. s .. '"')
+assert(not res)
+assert(err == 'non-del c0 control code in string')
+res, err = DecodeJson('"' .. s)
+assert(not res)
+assert(err == 'unexpected eof in string')
+
 assert(EncodeJson(assert(DecodeJson[[ -9223372036854775808  ]])) == '-9223372036854775808')  -- minimum 64-bit integer
 assert(EncodeJson(assert(DecodeJson[[  9223372036854775807  ]])) ==  '9223372036854775807')  -- maximum 64-bit integer
 assert(EncodeJson(assert(DecodeJson[[  9223372036854775808  ]])) ==  '9223372036854776000')  -- switches to double due to integer overflow
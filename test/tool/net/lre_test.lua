@@ -48,6 +48,21 @@ p,e = re.search("notfound", "fanatics have their dreams wherewith they weave")
 assert(not p)
 assert(e:errno() == re.NOMATCH)
 
+-- cached compiles are keyed by flags too
+assert(re.search("HELLO", "hello", re.ICASE) == "hello")
+assert(not re.search("HELLO", "hello"))
+assert(re.search("HELLO", "hello", re.ICASE) == "hello")
+
+-- cache evicts old entries without losing any
+for i = 1,100 do
+   assert(re.search("x" .. i .. "y", "ax" .. i .. "yb") == "x" .. i .. "y")
+end
+for i = 100,1,-1 do
+   assert(re.search("x" .. i .. "y", "ax" .. i .. "yb") == "x" .. i .. "y")
+end
+collectgarbage()
+assert(re.search("x1y", "x1y") == "x1y")
+
 ----------------------------------------------------------------------------------------------------
 -- BENCHMARKS
 
@@ -30,3 +30,36 @@ assert(ProgramContentType("1") == nil)
 ProgramContentType("1", "text/x-foo")
 assert(ProgramContentType("1"), "text/x-foo")
 assert(ProgramContentType("file.1"), "text/x-foo")
+
+-- test string interning for every hash tail length, short and long
+t = {}
+for n = 0, 70 do
+   for c = 0, 255, 51 do
+      k = ("x"):rep(n) .. string.char(c) .. ("y"):rep(n % 9)
+      assert(t[k] == nil)
+      t[k] = n * 256 + c
+   end
+end
+for n = 0, 70 do
+   for c = 0, 255, 51 do
+      k = ("x"):rep(n) .. string.char(c) .. ("y"):rep(n % 9)
+      assert(t[k] == n * 256 + c)
+   end
+end
+
+-- test collectgarbage("freeze") keeps values stored into frozen objects
+frozen = {}
+for i = 1, 1000 do
+   frozen[i] = {tostring(i)}
+end
+assert(collectgarbage("freeze") > 0)
+for round = 1, 3 do
+   for i = 1, 1000, 7 do
+      frozen[i][2] = {round}
+   end
+   collectgarbage()
+   for i = 1, 1000, 7 do
+      assert(frozen[i][1] == tostring(i))
+      assert(frozen[i][2][1] == round)
+   end
+end
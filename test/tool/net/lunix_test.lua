@@ -146,6 +146,43 @@ function UnixTest()
    table.sort(t)
    assert(EncodeLua(t) == '{".", "..", "foo"}');
 
+   -- scheduler
+   s = unix.scheduler()
+   r1, w1 = assert(unix.pipe(unix.O_NONBLOCK))
+   r2, w2 = assert(unix.pipe(unix.O_NONBLOCK))
+   got = {}
+   s:spawn(function()
+      for i = 1, 10 do
+         assert(s:write(w1, "ping%d" % {i}))
+         assert(assert(s:read(r2)) == "pong%d" % {i})
+      end
+      table.insert(got, "a")
+   end)
+   s:spawn(function(tag)
+      for i = 1, 10 do
+         assert(assert(s:read(r1)) == "ping%d" % {i})
+         assert(s:write(w2, "pong%d" % {i}))
+      end
+      table.insert(got, tag)
+   end, "b")
+   s:spawn(function()
+      assert(s:wait(r1, unix.POLLIN, 1) == 0)
+      s:sleep(1)
+      table.insert(got, "c")
+   end)
+   assert(s:count() == 3)
+   assert(s:run())
+   assert(s:count() == 0)
+   table.sort(got)
+   assert(table.concat(got) == "abc")
+   s:spawn(function() error("oops") end)
+   ok, err = pcall(s.run, s)
+   assert(not ok and err:find("oops"))
+   assert(not pcall(s.yield, s))
+   for _, fd in ipairs({r1, w1, r2, w2}) do
+      assert(unix.close(fd))
+   end
+
 end
 
 function main()
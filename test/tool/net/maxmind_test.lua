@@ -0,0 +1,91 @@
+-- Copyright 2025 Justine Alexandra Roberts Tunney
+--
+-- Permission to use, copy, modify, and/or distribute this software for
+-- any purpose with or without fee is hereby granted, provided that the
+-- above copyright notice and this permission notice appear in all copies.
+--
+-- THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+-- WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+-- WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+-- AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+-- DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR
+-- PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+-- TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+-- PERFORMANCE OF THIS SOFTWARE.
+
+maxmind = require 'maxmind'
+
+tmpdir = "%s/o/tmp/maxmind_test.%d" % {os.getenv('TMPDIR'), unix.getpid()}
+
+local function Path(name)
+   return tmpdir .. '/' .. name
+end
+
+local function Str(s)
+   return string.char(0x40 | #s) .. s
+end
+
+local function U16(x)
+   return string.char(0xa1, x)
+end
+
+-- returns ipv4 database with 24-bit records mapping 10.0.0.0/8 to
+-- {name="ten"} and everything else to nothing
+local function MakeIpv4Database()
+   local NODES = 8
+   local EMPTY = NODES
+   local DATA = NODES + 16
+   local tree = {}
+   for i = 0, NODES - 1 do
+      local bit = (10 >> (7 - i)) & 1
+      local next = i + 1 < NODES and i + 1 or DATA
+      local left, right = EMPTY, EMPTY
+      if bit == 1 then right = next else left = next end
+      tree[#tree + 1] = string.pack('>I3I3', left, right)
+   end
+   return table.concat(tree) ..
+      ('\0' * 16) ..
+      '\xe1' .. Str('name') .. Str('ten') ..
+      '\xab\xcd\xefMaxMind.com' ..
+      '\xe9' ..
+      Str('node_count') .. '\xc1' .. string.char(NODES) ..
+      Str('record_size') .. U16(24) ..
+      Str('ip_version') .. U16(4) ..
+      Str('database_type') .. Str('Test') ..
+      Str('languages') .. '\x00\x04' ..
+      Str('binary_format_major_version') .. U16(2) ..
+      Str('binary_format_minor_version') .. '\xa0' ..
+      Str('build_epoch') .. '\x01\x02\x01' ..
+      Str('description') .. '\xe0'
+end
+
+local function MaxmindTest()
+   assert(Barf(Path('test.mmdb'), MakeIpv4Database()))
+   local db = maxmind.open(Path('test.mmdb'))
+   for i = 1, 2 do  -- second pass is answered by the lookup cache
+      assert(db:lookup(ParseIp('11.0.0.1')) == nil)
+      assert(db:lookup(ParseIp('9.255.255.255')) == nil)
+      local r = assert(db:lookup(ParseIp('10.1.2.3')))
+      assert(r:get('name') == 'ten')
+      assert(r:netmask() == 8)
+      r = assert(db:lookup(ParseIp('10.255.0.7')))
+      assert(r:get('name') == 'ten')
+      assert(r:netmask() == 8)
+   end
+end
+
+local function main()
+   assert(unix.makedirs(tmpdir))
+   unix.unveil(tmpdir, "rwc")
+   unix.unveil(nil, nil)
+   assert(unix.pledge("stdio rpath wpath cpath"))
+   ok, err = pcall(MaxmindTest)
+   if ok then
+      assert(unix.rmrf(tmpdir))
+   else
+      print(err)
+      error('MaxmindTest failed (%s)' % {tmpdir})
+   end
+end
+
+main()
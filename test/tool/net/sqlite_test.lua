@@ -29,3 +29,43 @@ local st = assert(db:prepare("select * from foo"))
 assert(st:readonly() == true)
 st = assert(db:prepare("insert into foo (a) values (1)"))
 assert(st:readonly() == false)
+
+assert(db:cache_statements(2) == 0)
+assert(db:exec("insert into foo (a) values (2)") == 0)
+assert(db:exec("insert into foo (a) values (3); insert into foo (a) values (4)") == 0)
+for i = 1, 3 do
+  local n = 0
+  for a in db:urows("select a from foo where a > 1") do
+    n = n + 1
+  end
+  assert(n == 3)
+  st = assert(db:prepare("select a from foo where a = ?"))
+  assert(st:bind_parameter_count() == 1)
+  assert(st:step() == sqlite3.DONE) -- cached statements come back unbound
+  assert(st:reset() == sqlite3.OK)
+  assert(st:bind(1, 4) == sqlite3.OK)
+  assert(st:step() == sqlite3.ROW)
+  assert(st:get_value(0) == 4)
+  assert(st:finalize() == sqlite3.OK)
+end
+assert(db:cache_statements(0) == 2)
+
+-- the zipos vfs serves read-only databases out of a memory mapping
+local tmpdir = "%s/o/tmp/sqlite_test.%d" % {os.getenv('TMPDIR'), unix.getpid()}
+assert(unix.makedirs(tmpdir))
+local path = tmpdir .. '/zipos.db'
+db = assert(sqlite3.open(path))
+assert(db:exec("create table foo(a); insert into foo (a) values (1), (2), (3)") == 0)
+assert(db:close() == sqlite3.OK)
+db = assert(sqlite3.open("file:" .. path .. "?vfs=zipos",
+  sqlite3.OPEN_URI + sqlite3.OPEN_READWRITE))
+assert(db:readonly() == true)
+local n = 0
+for a in db:urows("select a from foo") do
+  n = n + a
+end
+assert(n == 6)
+assert(db:exec("insert into foo (a) values (4)") == sqlite3.READONLY)
+assert(db:close() == sqlite3.OK)
+assert(sqlite3.open("/zip/nonexistent.db") == nil)
+assert(unix.rmrf(tmpdir))
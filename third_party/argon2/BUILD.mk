@@ -25,7 +25,8 @@ THIRD_PARTY_ARGON2_A_DIRECTDEPS =				\
 	LIBC_STDIO						\
 	LIBC_RUNTIME						\
 	LIBC_SYSV_CALLS						\
-	LIBC_STR
+	LIBC_STR						\
+	LIBC_THREAD
 
 THIRD_PARTY_ARGON2_A_DEPS :=					\
 	$(call uniq,$(foreach x,$(THIRD_PARTY_ARGON2_A_DIRECTDEPS),$($(x))))
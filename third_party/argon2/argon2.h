@@ -3,8 +3,6 @@
 #include "libc/limits.h"
 #include "libc/literal.h"
 
-#define ARGON2_NO_THREADS
-
 COSMOPOLITAN_C_START_
 
 /*
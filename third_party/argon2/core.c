@@ -16,6 +16,7 @@
 │                                                                              │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/mem/mem.h"
+#include "libc/thread/thread.h"
 #include "third_party/argon2/blake2-impl.h"
 #include "third_party/argon2/blake2.h"
 #include "third_party/argon2/core.h"
@@ -256,35 +257,33 @@ static int fill_memory_blocks_st(argon2_instance_t *instance) {
     return ARGON2_OK;
 }
 
-#if !defined(ARGON2_NO_THREADS)
-
-#ifdef _WIN32
-static unsigned __stdcall fill_segment_thr(void *thread_data)
-#else
-static void *fill_segment_thr(void *thread_data)
-#endif
-{
+/* Fills every threads'th lane of the slice, starting at pos.lane */
+static void *fill_segment_thr(void *thread_data) {
     argon2_thread_data *my_data = thread_data;
-    fill_segment(my_data->instance_ptr, my_data->pos);
-    argon2_thread_exit();
+    const argon2_instance_t *instance = my_data->instance_ptr;
+    argon2_position_t position = my_data->pos;
+    for (; position.lane < instance->lanes;
+         position.lane += instance->threads) {
+        fill_segment(instance, position);
+    }
     return 0;
 }
 
 /* Multi-threaded version for p > 1 case */
 static int fill_memory_blocks_mt(argon2_instance_t *instance) {
-    uint32_t r, s;
-    argon2_thread_handle_t *thread = NULL;
+    uint32_t r, s, t, tt;
+    pthread_t *thread = NULL;
     argon2_thread_data *thr_data = NULL;
     int rc = ARGON2_OK;
 
     /* 1. Allocating space for threads */
-    thread = calloc(instance->lanes, sizeof(argon2_thread_handle_t));
+    thread = calloc(instance->threads, sizeof(pthread_t));
     if (thread == NULL) {
         rc = ARGON2_MEMORY_ALLOCATION_ERROR;
         goto fail;
     }
 
-    thr_data = calloc(instance->lanes, sizeof(argon2_thread_data));
+    thr_data = calloc(instance->threads, sizeof(argon2_thread_data));
     if (thr_data == NULL) {
         rc = ARGON2_MEMORY_ALLOCATION_ERROR;
         goto fail;
@@ -292,46 +291,31 @@ static int fill_memory_blocks_mt(argon2_instance_t *instance) {
 
     for (r = 0; r < instance->passes; ++r) {
         for (s = 0; s < ARGON2_SYNC_POINTS; ++s) {
-            uint32_t l, ll;
-
-            /* 2. Calling threads */
-            for (l = 0; l < instance->lanes; ++l) {
-                argon2_position_t position;
-
-                /* 2.1 Join a thread if limit is exceeded */
-                if (l >= instance->threads) {
-                    if (argon2_thread_join(thread[l - instance->threads])) {
-                        rc = ARGON2_THREAD_FAIL;
-                        goto fail;
-                    }
-                }
-
-                /* 2.2 Create thread */
-                position.pass = r;
-                position.lane = l;
-                position.slice = (uint8_t)s;
-                position.index = 0;
-                thr_data[l].instance_ptr =
-                    instance; /* preparing the thread input */
-                memcpy(&(thr_data[l].pos), &position,
-                       sizeof(argon2_position_t));
-                if (argon2_thread_create(&thread[l], &fill_segment_thr,
-                                         (void *)&thr_data[l])) {
+            /* 2. Segments of one slice never reference each other, so
+               they're spread across threads, and the calling thread
+               takes the first share itself */
+            for (t = 0; t < instance->threads; ++t) {
+                thr_data[t].instance_ptr = instance;
+                thr_data[t].pos.pass = r;
+                thr_data[t].pos.lane = t;
+                thr_data[t].pos.slice = (uint8_t)s;
+                thr_data[t].pos.index = 0;
+            }
+            for (t = 1; t < instance->threads; ++t) {
+                if (pthread_create(&thread[t], NULL, fill_segment_thr,
+                                   &thr_data[t])) {
                     /* Wait for already running threads */
-                    for (ll = 0; ll < l; ++ll)
-                        argon2_thread_join(thread[ll]);
+                    for (tt = 1; tt < t; ++tt)
+                        pthread_join(thread[tt], NULL);
                     rc = ARGON2_THREAD_FAIL;
                     goto fail;
                 }
-
-                /* fill_segment(instance, position); */
-                /*Non-thread equivalent of the lines above */
             }
+            fill_segment_thr(&thr_data[0]);
 
             /* 3. Joining remaining threads */
-            for (l = instance->lanes - instance->threads; l < instance->lanes;
-                 ++l) {
-                if (argon2_thread_join(thread[l])) {
+            for (t = 1; t < instance->threads; ++t) {
+                if (pthread_join(thread[t], NULL)) {
                     rc = ARGON2_THREAD_FAIL;
                     goto fail;
                 }
@@ -349,8 +333,6 @@ fail:
     return rc;
 }
 
-#endif /* ARGON2_NO_THREADS */
-
 /**
  * Function that fills the entire memory t_cost times based on the first two
  * blocks in each lane
@@ -361,12 +343,8 @@ int fill_memory_blocks(argon2_instance_t *instance) {
 	if (instance == NULL || instance->lanes == 0) {
 	    return ARGON2_INCORRECT_PARAMETER;
     }
-#if defined(ARGON2_NO_THREADS)
-    return fill_memory_blocks_st(instance);
-#else
     return instance->threads == 1 ?
 			fill_memory_blocks_st(instance) : fill_memory_blocks_mt(instance);
-#endif
 }
 
 /**
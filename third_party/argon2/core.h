@@ -79,6 +79,8 @@ void fill_first_blocks(uint8_t *, const argon2_instance_t *);
 int initialize(argon2_instance_t *, argon2_context *);
 void finalize(const argon2_context *, argon2_instance_t *);
 void fill_segment(const argon2_instance_t *, argon2_position_t);
+void fill_block_ssse3(const block *, const block *, block *, int);
+void fill_block_avx2(const block *, const block *, block *, int);
 int fill_memory_blocks(argon2_instance_t *);
 
 COSMOPOLITAN_C_END_
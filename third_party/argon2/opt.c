@@ -0,0 +1,110 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:4;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=4 sts=4 sw=4 fenc=utf-8                               :vi │
+╚──────────────────────────────────────────────────────────────────────────────╝
+│                                                                              │
+│ Argon2 reference source code package - reference C implementations           │
+│                                                                              │
+│ Copyright 2015                                                               │
+│ Daniel Dinu, Dmitry Khovratovich, Jean-Philippe Aumasson, and Samuel Neves   │
+│                                                                              │
+│ You may use this work under the terms of a Creative Commons CC0 1.0          │
+│ License/Waiver or the Apache Public License 2.0, at your option. The         │
+│ terms of these licenses can be found at:                                     │
+│                                                                              │
+│ - CC0 1.0 Universal : https://creativecommons.org/publicdomain/zero/1.0      │
+│ - Apache 2.0        : https://www.apache.org/licenses/LICENSE-2.0            │
+│                                                                              │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "third_party/argon2/core.h"
+#if defined(__x86_64__) && !defined(__chibicc__)
+#include "third_party/argon2/blamka-round-opt.h"
+#pragma GCC push_options
+#pragma GCC target("ssse3")
+
+/*
+ * SIMD versions of fill_block() in ref.c, which the reference code calls
+ * when the cpu supports them. The output is bit for bit identical, only
+ * the BlaMka permutation runs on two (SSSE3) or four (AVX2) words at once.
+ */
+
+optimizespeed void fill_block_ssse3(const block *prev_block,
+                                    const block *ref_block, block *next_block,
+                                    int with_xor) {
+    __m128i state[ARGON2_OWORDS_IN_BLOCK];
+    __m128i block_XY[ARGON2_OWORDS_IN_BLOCK];
+    unsigned i;
+
+    for (i = 0; i < ARGON2_OWORDS_IN_BLOCK; i++) {
+        state[i] = _mm_xor_si128(
+            _mm_loadu_si128((const __m128i *)prev_block->v + i),
+            _mm_loadu_si128((const __m128i *)ref_block->v + i));
+        if (with_xor) {
+            block_XY[i] = _mm_xor_si128(
+                state[i], _mm_loadu_si128((const __m128i *)next_block->v + i));
+        } else {
+            block_XY[i] = state[i];
+        }
+    }
+
+    for (i = 0; i < 8; ++i) {
+        BLAKE2_ROUND(state[8 * i + 0], state[8 * i + 1], state[8 * i + 2],
+                     state[8 * i + 3], state[8 * i + 4], state[8 * i + 5],
+                     state[8 * i + 6], state[8 * i + 7]);
+    }
+
+    for (i = 0; i < 8; ++i) {
+        BLAKE2_ROUND(state[8 * 0 + i], state[8 * 1 + i], state[8 * 2 + i],
+                     state[8 * 3 + i], state[8 * 4 + i], state[8 * 5 + i],
+                     state[8 * 6 + i], state[8 * 7 + i]);
+    }
+
+    for (i = 0; i < ARGON2_OWORDS_IN_BLOCK; i++) {
+        _mm_storeu_si128((__m128i *)next_block->v + i,
+                         _mm_xor_si128(state[i], block_XY[i]));
+    }
+}
+
+#pragma GCC target("avx2")
+
+optimizespeed void fill_block_avx2(const block *prev_block,
+                                   const block *ref_block, block *next_block,
+                                   int with_xor) {
+    __m256i state[ARGON2_HWORDS_IN_BLOCK];
+    __m256i block_XY[ARGON2_HWORDS_IN_BLOCK];
+    unsigned i;
+
+    for (i = 0; i < ARGON2_HWORDS_IN_BLOCK; i++) {
+        state[i] = _mm256_xor_si256(
+            _mm256_loadu_si256((const __m256i *)prev_block->v + i),
+            _mm256_loadu_si256((const __m256i *)ref_block->v + i));
+        if (with_xor) {
+            block_XY[i] = _mm256_xor_si256(
+                state[i],
+                _mm256_loadu_si256((const __m256i *)next_block->v + i));
+        } else {
+            block_XY[i] = state[i];
+        }
+    }
+
+    /* columns: each register pair is one 16 word row of the block */
+    for (i = 0; i < 4; ++i) {
+        BLAKE2_ROUND_1(state[8 * i + 0], state[8 * i + 4], state[8 * i + 1],
+                       state[8 * i + 5], state[8 * i + 2], state[8 * i + 6],
+                       state[8 * i + 3], state[8 * i + 7]);
+    }
+
+    /* rows: each register holds two words of two adjacent rounds */
+    for (i = 0; i < 4; ++i) {
+        BLAKE2_ROUND_2(state[0 + i], state[4 + i], state[8 + i],
+                       state[12 + i], state[16 + i], state[20 + i],
+                       state[24 + i], state[28 + i]);
+    }
+
+    for (i = 0; i < ARGON2_HWORDS_IN_BLOCK; i++) {
+        _mm256_storeu_si256((__m256i *)next_block->v + i,
+                            _mm256_xor_si256(state[i], block_XY[i]));
+    }
+}
+
+#pragma GCC pop_options
+#endif /* __x86_64__ */
@@ -16,6 +16,7 @@
 │                                                                              │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/log/libfatal.internal.h"
+#include "libc/nexgen32e/x86feature.h"
 #include "third_party/argon2/argon2.h"
 #include "third_party/argon2/blake2-impl.h"
 #include "third_party/argon2/blake2.h"
@@ -55,6 +56,17 @@ static optimizespeed void fill_block(const block *prev_block,
     block blockR, block_tmp;
     unsigned i;
 
+#if defined(__x86_64__) && !defined(__chibicc__)
+    if (X86_HAVE(AVX2)) {
+        fill_block_avx2(prev_block, ref_block, next_block, with_xor);
+        return;
+    }
+    if (X86_HAVE(SSSE3)) {
+        fill_block_ssse3(prev_block, ref_block, next_block, with_xor);
+        return;
+    }
+#endif
+
     if (with_xor) {
         for (i = 0; i < ARGON2_QWORDS_IN_BLOCK; ++i) {
             block_tmp.v[i] = (blockR.v[i] = prev_block->v[i] ^ ref_block->v[i]) ^ next_block->v[i];
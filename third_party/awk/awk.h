@@ -81,11 +81,13 @@ extern Awkfloat *RSTART;
 extern Awkfloat *RLENGTH;
 
 extern bool	CSV;		/* true for csv input */
+extern bool	ttyout;		/* true if stdout is a terminal */
 
 extern char	*record;	/* points to $0 */
 extern int	lineno;		/* line number in awk program */
 extern int	errorflag;	/* 1 if error has occurred */
 extern bool	donefld;	/* true if record broken into fields */
+extern int	splitfld;	/* fields split so far if !donefld */
 extern bool	donerec;	/* true if record is valid (no fld has changed */
 extern int	dbg;
 
@@ -107,10 +109,13 @@ typedef struct Cell {
 
 typedef struct Array {		/* symbol table array */
 	int	nelem;		/* elements in table right now */
-	int	size;		/* size of tab */
-	Cell	**tab;		/* hash table pointers */
+	int	ndead;		/* slots holding &deadcell */
+	int	size;		/* size of tab, a power of 2 */
+	Cell	**tab;		/* open addressed, linearly probed */
 } Array;
 
+extern Cell	deadcell;	/* marks tab slots of deleted elements */
+
 #define	NSYMTAB	50	/* initial size of a symbol table */
 extern Array	*symtab;
 
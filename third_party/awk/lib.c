@@ -192,6 +192,7 @@ int getrec(char **pbuf, int *pbufsize, bool isrecord)	/* get next input record *
 					fldtab[0]->tval |= NUM;
 				}
 				donefld = false;
+				splitfld = 0;
 				donerec = true;
 				savefs();
 			}
@@ -374,6 +375,196 @@ void setclvar(char *s)	/* set var=value from s */
 }
 
 
+/*
+ * splitting $0 on blanks or on a single character is done lazily, only
+ * far enough to reach the highest field that's been asked for, so that
+ * a program printing $1 of a long record doesn't pay for the rest. the
+ * fields[] array gets filled in order, and we remember where we stopped.
+ */
+int	splitfld;		/* fields split so far, while !donefld */
+static char	*splitrec;	/* where in $0 splitting stopped */
+static char	*splitfr;	/* where in fields[] splitting stopped */
+
+static void fldalloc(int n)	/* make fields[] big enough for n chars */
+{
+	if (n > fieldssize) {
+		xfree(fields);
+		if ((fields = (char *) malloc(n+2)) == NULL) /* possibly 2 final \0s */
+			FATAL("out of space for fields in fldbld %d", n);
+		fieldssize = n;
+	}
+}
+
+#if defined(__x86_64__) && !defined(__chibicc__)
+typedef char fldxmm_t __attribute__((__vector_size__(16), __aligned__(16)));
+#endif
+
+__attribute__((__no_sanitize_address__))
+static char *fldblank(char *r)	/* find next blank, tab, newline, or \0 */
+{
+#if defined(__x86_64__) && !defined(__chibicc__)
+	/* aligned loads never cross into a page that isn't there */
+	unsigned k, m;
+	const fldxmm_t *p;
+	fldxmm_t v;
+	fldxmm_t z = {0};
+	fldxmm_t sp = {' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' '};
+	fldxmm_t ht = {'\t','\t','\t','\t','\t','\t','\t','\t','\t','\t','\t','\t','\t','\t','\t','\t'};
+	fldxmm_t nl = {'\n','\n','\n','\n','\n','\n','\n','\n','\n','\n','\n','\n','\n','\n','\n','\n'};
+
+	k = (uintptr_t)r & 15;
+	p = (const fldxmm_t *)((uintptr_t)r & -16);
+	v = *p;
+	m = __builtin_ia32_pmovmskb128((v == z) | (v == sp) | (v == ht) | (v == nl));
+	m >>= k;
+	m <<= k;
+	while (!m) {
+		v = *++p;
+		m = __builtin_ia32_pmovmskb128((v == z) | (v == sp) | (v == ht) | (v == nl));
+	}
+	return (char *)p + __builtin_ctz(m);
+#else
+	while (*r != ' ' && *r != '\t' && *r != '\n' && *r != '\0')
+		r++;
+	return r;
+#endif
+}
+
+static void fldnum(Cell *p)	/* mark field p numeric if it looks it */
+{
+	double result;
+
+	if (is_number(p->sval, & result)) {
+		p->fval = result;
+		p->tval |= NUM;
+	}
+}
+
+static void fldset(int i, char *fr)	/* point $i at fr in fields[] */
+{
+	if (i > nfields)
+		growfldtab(i);
+	if (freeable(fldtab[i]))
+		xfree(fldtab[i]->sval);
+	fldtab[i]->sval = fr;
+	fldtab[i]->tval = FLD | STR | DONTFREE;
+}
+
+static void flddone(int i)	/* record is broken into i fields */
+{
+	Cell *p;
+	int j;
+
+	if (i > nfields)
+		FATAL("record `%.30s...' has too many fields; can't happen", fldtab[0]->sval);
+	cleanfld(i+1, lastfld);	/* clean out junk from previous record */
+	lastfld = i;
+	splitfld = 0;
+	donefld = true;
+	setfval(nfloc, (Awkfloat) lastfld);
+	donerec = true; /* restore */
+	if (dbg) {
+		for (j = 0; j <= lastfld; j++) {
+			p = fldtab[j];
+			printf("field %d (%s): |%s|\n", j, p->nval, p->sval);
+		}
+	}
+}
+
+/*
+ * splits fields out of $0 until there are at least n of them or the
+ * record runs out. returns false if this record can't be split lazily,
+ * e.g. FS is a regular expression, so the caller must use fldbld().
+ */
+static bool fldbldn(int n)
+{
+	char *r, *fr, *e, sep;
+	int i, rtest;
+
+	if (inputFS == NULL)	/* make sure we have a copy of FS */
+		savefs();
+	sep = *inputFS;
+	if (CSV || sep == 0 || inputFS[1] != 0)
+		return false;
+	if (splitfld == 0) {	/* first time for this record */
+		if (!isstr(fldtab[0]))
+			getsval(fldtab[0]);
+		if ((fldtab[0]->tval & (CONVC|CONVO)) && n != INT_MAX)
+			return false;	/* $0 might get reformatted under us */
+		r = fldtab[0]->sval;
+		fldalloc(strlen(r));
+		fr = fields;
+		if (sep != ' ' && *r == 0) {	/* if 0, it's a null field */
+			*fr = 0;
+			flddone(0);
+			return true;
+		}
+	} else {
+		r = splitrec;
+		fr = splitfr;
+	}
+	i = splitfld;
+	if (sep == ' ') {	/* default whitespace */
+		for (;;) {
+			while (*r == ' ' || *r == '\t' || *r == '\n')
+				r++;
+			if (*r == 0)
+				break;
+			if (i >= n)
+				goto stop;
+			fldset(++i, fr);
+			e = fldblank(r);
+			memcpy(fr, r, e - r);
+			fr += e - r;
+			*fr++ = 0;
+			r = e;
+			fldnum(fldtab[i]);
+		}
+	} else {
+		/* subtle case: if length(FS) == 1 && length(RS > 0)
+		 * \n is NOT a field separator (cf awk book 61,84).
+		 * this variable is tested in the inner while loop.
+		 */
+		rtest = '\n';  /* normal case */
+		if (strlen(*RS) > 0)
+			rtest = '\0';
+		for (;;) {
+			if (i >= n)
+				goto stop;
+			fldset(++i, fr);
+			if (rtest)	/* \n is always a separator */
+				e = r + strcspn(r, (char[]){ sep, '\n', '\0' });
+			else
+				e = strchrnul(r, sep);
+			memcpy(fr, r, e - r);
+			fr += e - r;
+			*fr++ = 0;
+			r = e;
+			fldnum(fldtab[i]);
+			if (*r++ == 0)
+				break;
+		}
+	}
+	*fr = 0;
+	flddone(i);
+	return true;
+stop:
+	if (i > lastfld)
+		lastfld = i;	/* so the next flddone() cleans them */
+	splitfld = i;
+	splitrec = r;
+	splitfr = fr;
+	return true;
+}
+
+void fldget(Cell *vp)	/* split $0 at least as far as field vp */
+{
+	int n = atoi(vp->nval);
+
+	if (n > splitfld && !fldbldn(n))
+		fldbld();
+}
+
 void fldbld(void)	/* create fields from current record */
 {
 	/* this relies on having fields[] the same length as $0 */
@@ -385,41 +576,17 @@ void fldbld(void)	/* create fields from current record */
 
 	if (donefld)
 		return;
+	if (fldbldn(INT_MAX))
+		return;
 	if (!isstr(fldtab[0]))
 		getsval(fldtab[0]);
 	r = fldtab[0]->sval;
 	n = strlen(r);
-	if (n > fieldssize) {
-		xfree(fields);
-		if ((fields = (char *) malloc(n+2)) == NULL) /* possibly 2 final \0s */
-			FATAL("out of space for fields in fldbld %d", n);
-		fieldssize = n;
-	}
+	fldalloc(n);
 	fr = fields;
 	i = 0;	/* number of fields accumulated here */
-	if (inputFS == NULL)	/* make sure we have a copy of FS */
-		savefs();
 	if (!CSV && strlen(inputFS) > 1) {	/* it's a regular expression */
 		i = refldbld(r, inputFS);
-	} else if (!CSV && (sep = *inputFS) == ' ') {	/* default whitespace */
-		for (i = 0; ; ) {
-			while (*r == ' ' || *r == '\t' || *r == '\n')
-				r++;
-			if (*r == 0)
-				break;
-			i++;
-			if (i > nfields)
-				growfldtab(i);
-			if (freeable(fldtab[i]))
-				xfree(fldtab[i]->sval);
-			fldtab[i]->sval = fr;
-			fldtab[i]->tval = FLD | STR | DONTFREE;
-			do
-				*fr++ = *r++;
-			while (*r != ' ' && *r != '\t' && *r != '\n' && *r != '\0');
-			*fr++ = 0;
-		}
-		*fr = 0;
 	} else if (CSV) {	/* CSV processing.  no error handling */
 		if (*r != 0) {
 			for (;;) {
@@ -470,52 +637,12 @@ void fldbld(void)	/* create fields from current record */
 			fldtab[i]->tval = FLD | STR;
 		}
 		*fr = 0;
-	} else if (*r != 0) {	/* if 0, it's a null field */
-		/* subtle case: if length(FS) == 1 && length(RS > 0)
-		 * \n is NOT a field separator (cf awk book 61,84).
-		 * this variable is tested in the inner while loop.
-		 */
-		int rtest = '\n';  /* normal case */
-		if (strlen(*RS) > 0)
-			rtest = '\0';
-		for (;;) {
-			i++;
-			if (i > nfields)
-				growfldtab(i);
-			if (freeable(fldtab[i]))
-				xfree(fldtab[i]->sval);
-			fldtab[i]->sval = fr;
-			fldtab[i]->tval = FLD | STR | DONTFREE;
-			while (*r != sep && *r != rtest && *r != '\0')	/* \n is always a separator */
-				*fr++ = *r++;
-			*fr++ = 0;
-			if (*r++ == 0)
-				break;
-		}
-		*fr = 0;
 	}
-	if (i > nfields)
-		FATAL("record `%.30s...' has too many fields; can't happen", r);
-	cleanfld(i+1, lastfld);	/* clean out junk from previous record */
-	lastfld = i;
-	donefld = true;
-	for (j = 1; j <= lastfld; j++) {
-		double result;
-
+	for (j = 1; j <= i; j++) {
 		p = fldtab[j];
-		if(is_number(p->sval, & result)) {
-			p->fval = result;
-			p->tval |= NUM;
-		}
-	}
-	setfval(nfloc, (Awkfloat) lastfld);
-	donerec = true; /* restore */
-	if (dbg) {
-		for (j = 0; j <= lastfld; j++) {
-			p = fldtab[j];
-			printf("field %d (%s): |%s|\n", j, p->nval, p->sval);
-		}
+		fldnum(p);
 	}
+	flddone(i);
 }
 
 void cleanfld(int n1, int n2)	/* clean out fields n1 .. n2 inclusive */
@@ -32,6 +32,7 @@ const char	*version = "version 20240311";
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include <unistd.h>
 #include "awk.h"
 
 extern	char	**environ;
@@ -54,6 +55,8 @@ bool	CSV = false;	/* true for csv input */
 
 bool	safe = false;	/* true => "safe" mode */
 
+bool	ttyout = false;	/* true if stdout is a terminal */
+
 size_t	awk_mb_cur_max = 1;
 
 static noreturn void fpecatch(int n
@@ -117,6 +120,9 @@ int _awk(int argc, char *argv[])
 	const char *fs = NULL;
 	char *fn, *vn;
 
+	/* output that isn't going to a person is only flushed when full */
+	if (!(ttyout = isatty(1)))
+		setvbuf(stdout, NULL, _IOFBF, 0);
 	setlocale(LC_CTYPE, "");
 	setlocale(LC_NUMERIC, "C"); /* for parsing cmdline & prog */
 	awk_mb_cur_max = MB_CUR_MAX;
@@ -125,6 +125,7 @@ extern	int	readrec(char **buf, int *bufsize, FILE *inf, bool isnew);
 extern	char	*getargv(int);
 extern	void	setclvar(char *);
 extern	void	fldbld(void);
+extern	void	fldget(Cell *);
 extern	void	cleanfld(int, int);
 extern	void	newfld(int);
 extern	void	setlastfld(int);
@@ -42,6 +42,7 @@ THIS SOFTWARE.
 
 static void stdinit(void);
 static void flush_all(void);
+static void flush_output(void);
 static char *wide_char_to_byte_str(int rune, size_t *outlen);
 
 #if 1
@@ -155,7 +156,7 @@ Cell *execute(Node *u)	/* execute a node of the parse tree */
 		if (isvalue(a)) {
 			x = (Cell *) (a->narg[0]);
 			if (isfld(x) && !donefld)
-				fldbld();
+				fldget(x);
 			else if (isrec(x) && !donerec)
 				recbld();
 			return(x);
@@ -165,7 +166,7 @@ Cell *execute(Node *u)	/* execute a node of the parse tree */
 		proc = proctab[a->nobj-FIRSTTOKEN];
 		x = (*proc)(a->narg, a->nobj);
 		if (isfld(x) && !donefld)
-			fldbld();
+			fldget(x);
 		else if (isrec(x) && !donerec)
 			recbld();
 		if (isexpr(a))
@@ -413,7 +414,8 @@ Cell *awkgetline(Node **a, int n)	/* get next line from specific input */
 	if ((buf = (char *) malloc(bufsize)) == NULL)
 		FATAL("out of memory in getline");
 
-	fflush(stdout);	/* in case someone is waiting for a prompt */
+	if (ttyout)
+		fflush(stdout);	/* in case someone is waiting for a prompt */
 	r = gettemp();
 	if (a[1] != NULL) {		/* getline < file */
 		x = execute(a[2]);		/* filename */
@@ -1434,7 +1436,8 @@ Cell *awkprintf(Node **a, int n)		/* printf */
 		fp = redirect(ptoi(a[1]), a[2]);
 		/* fputs(buf, fp); */
 		fwrite(buf, len, 1, fp);
-		fflush(fp);
+		if (ttyout)
+			fflush(fp);
 		if (ferror(fp))
 			FATAL("write error on %s", filename(fp));
 	}
@@ -1943,7 +1946,7 @@ Cell *forstat(Node **a, int n)	/* for (a[0]; a[1]; a[2]) a[3] */
 
 Cell *instat(Node **a, int n)	/* for (a[0] in a[1]) a[2] */
 {
-	Cell *x, *vp, *arrayp, *cp, *ncp;
+	Cell *x, *vp, *arrayp, *cp;
 	Array *tp;
 	int i;
 
@@ -1955,20 +1958,19 @@ Cell *instat(Node **a, int n)	/* for (a[0] in a[1]) a[2] */
 	tp = (Array *) arrayp->sval;
 	tempfree(arrayp);
 	for (i = 0; i < tp->size; i++) {	/* this routine knows too much */
-		for (cp = tp->tab[i]; cp != NULL; cp = ncp) {
-			setsval(vp, cp->nval);
-			ncp = cp->cnext;
-			x = execute(a[2]);
-			if (isbreak(x)) {
-				tempfree(vp);
-				return True;
-			}
-			if (isnext(x) || isexit(x) || isret(x)) {
-				tempfree(vp);
-				return(x);
-			}
-			tempfree(x);
+		if ((cp = tp->tab[i]) == NULL || cp == &deadcell)
+			continue;
+		setsval(vp, cp->nval);
+		x = execute(a[2]);
+		if (isbreak(x)) {
+			tempfree(vp);
+			return True;
+		}
+		if (isnext(x) || isexit(x) || isret(x)) {
+			tempfree(vp);
+			return(x);
 		}
+		tempfree(x);
 	}
 	return True;
 }
@@ -2110,7 +2112,7 @@ Cell *bltin(Node **a, int n)	/* builtin functions. a[0] is type, a[1] is arg lis
 		}
 		break;
 	case FSYSTEM:
-		fflush(stdout);		/* in case something is buffered already */
+		flush_output();		/* in case something is buffered already */
 		estatus = status = system(getsval(x));
 		if (status != -1) {
 			if (WIFEXITED(status)) {
@@ -2199,7 +2201,7 @@ Cell *printstat(Node **a, int n)	/* print a[0] */
 		else
 			fputs(getsval(ofsloc), fp);
 	}
-	if (a[1] != NULL)
+	if (a[1] != NULL && ttyout)
 		fflush(fp);
 	if (ferror(fp))
 		FATAL("write error on %s", filename(fp));
@@ -2285,7 +2287,7 @@ FILE *openfile(int a, const char *us, bool *pnewflag)
 		nfiles = nnf;
 		files = nf;
 	}
-	fflush(stdout);	/* force a semblance of order */
+	flush_output();	/* force a semblance of order */
 	m = a;
 	if (a == GT) {
 		fp = fopen(s, "w");
@@ -2401,6 +2403,15 @@ static void flush_all(void)
 			fflush(files[i].fp);
 }
 
+static void flush_output(void)	/* since print only flushes for a tty */
+{
+	size_t i;
+
+	for (i = 0; i < nfiles; i++)
+		if (files[i].fp && (files[i].mode == GT || files[i].mode == '|'))
+			fflush(files[i].fp);
+}
+
 void backsub(char **pb_ptr, const char **sptr_ptr);
 
 Cell *dosub(Node **a, int subop)        /* sub and gsub */
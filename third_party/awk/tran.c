@@ -30,10 +30,12 @@ THIS SOFTWARE.
 #include <stdlib.h>
 #include "awk.h"
 
-#define	FULLTAB	2	/* rehash when table gets this x full */
-#define	GROWTAB 4	/* grow table by this factor */
+#define	FULLTAB	2	/* rehash when table gets 1/FULLTAB full */
+#define	GROWTAB 2	/* grow table by this factor */
+#define	MINTAB	8	/* smallest table size */
 
 Array	*symtab;	/* main symbol table */
+Cell	deadcell;	/* marks tab slots of deleted elements */
 
 char	**FS;		/* initial field sep */
 char	**RS;		/* initial record sep */
@@ -157,20 +159,24 @@ Array *makesymtab(int n)	/* make a new symbol table */
 {
 	Array *ap;
 	Cell **tp;
+	int size;
 
+	for (size = MINTAB; size < n; size *= 2)	/* size is a power of 2 */
+		;
 	ap = (Array *) malloc(sizeof(*ap));
-	tp = (Cell **) calloc(n, sizeof(*tp));
+	tp = (Cell **) calloc(size, sizeof(*tp));
 	if (ap == NULL || tp == NULL)
 		FATAL("out of space in makesymtab");
 	ap->nelem = 0;
-	ap->size = n;
+	ap->ndead = 0;
+	ap->size = size;
 	ap->tab = tp;
 	return(ap);
 }
 
 void freesymtab(Cell *ap)	/* free a symbol table */
 {
-	Cell *cp, *temp;
+	Cell *cp;
 	Array *tp;
 	int i;
 
@@ -180,14 +186,13 @@ void freesymtab(Cell *ap)	/* free a symbol table */
 	if (tp == NULL)
 		return;
 	for (i = 0; i < tp->size; i++) {
-		for (cp = tp->tab[i]; cp != NULL; cp = temp) {
-			xfree(cp->nval);
-			if (freeable(cp))
-				xfree(cp->sval);
-			temp = cp->cnext;	/* avoids freeing then using */
-			free(cp);
-			tp->nelem--;
-		}
+		if ((cp = tp->tab[i]) == NULL || cp == &deadcell)
+			continue;
+		xfree(cp->nval);
+		if (freeable(cp))
+			xfree(cp->sval);
+		free(cp);
+		tp->nelem--;
 		tp->tab[i] = NULL;
 	}
 	if (tp->nelem != 0)
@@ -199,29 +204,27 @@ void freesymtab(Cell *ap)	/* free a symbol table */
 void freeelem(Cell *ap, const char *s)	/* free elem s from ap (i.e., ap["s"] */
 {
 	Array *tp;
-	Cell *p, *prev = NULL;
-	int h;
+	Cell *p;
+	int h, mask;
 
 	tp = (Array *) ap->sval;
-	h = hash(s, tp->size);
-	for (p = tp->tab[h]; p != NULL; prev = p, p = p->cnext)
-		if (strcmp(s, p->nval) == 0) {
-			if (prev == NULL)	/* 1st one */
-				tp->tab[h] = p->cnext;
-			else			/* middle somewhere */
-				prev->cnext = p->cnext;
+	mask = tp->size - 1;
+	for (h = hash(s, tp->size); (p = tp->tab[h]) != NULL; h = (h + 1) & mask)
+		if (p != &deadcell && strcmp(s, p->nval) == 0) {
+			tp->tab[h] = &deadcell;	/* keeps probe sequences intact */
 			if (freeable(p))
 				xfree(p->sval);
 			free(p->nval);
 			free(p);
 			tp->nelem--;
+			tp->ndead++;
 			return;
 		}
 }
 
 Cell *setsymtab(const char *n, const char *s, Awkfloat f, unsigned t, Array *tp)
 {
-	int h;
+	int h, mask;
 	Cell *p;
 
 	if (n != NULL && (p = lookup(n, tp)) != NULL) {
@@ -238,56 +241,65 @@ Cell *setsymtab(const char *n, const char *s, Awkfloat f, unsigned t, Array *tp)
 	p->tval = t;
 	p->csub = CUNK;
 	p->ctype = OCELL;
-	tp->nelem++;
-	if (tp->nelem > FULLTAB * tp->size)
+	if (FULLTAB * (tp->nelem + tp->ndead + 1) > tp->size)
 		rehash(tp);
-	h = hash(n, tp->size);
-	p->cnext = tp->tab[h];
+	mask = tp->size - 1;
+	for (h = hash(p->nval, tp->size); tp->tab[h] != NULL; h = (h + 1) & mask)
+		if (tp->tab[h] == &deadcell) {	/* n isn't here, so reuse it */
+			tp->ndead--;
+			break;
+		}
 	tp->tab[h] = p;
+	tp->nelem++;
 	DPRINTF("setsymtab set %p: n=%s s=\"%s\" f=%g t=%o\n",
 		(void*)p, p->nval, p->sval, p->fval, p->tval);
 	return(p);
 }
 
 int hash(const char *s, int n)	/* form hash value for string s */
-{
+{				/* n must be a power of 2 */
 	unsigned hashval;
 
-	for (hashval = 0; *s != '\0'; s++)
-		hashval = (*s + 31 * hashval);
-	return hashval % n;
+	for (hashval = 2166136261; *s != '\0'; s++)	/* fnv-1a */
+		hashval = (hashval ^ (unsigned char)*s) * 16777619;
+	hashval ^= hashval >> 16;	/* mix high bits into the mask */
+	return hashval & (n - 1);
 }
 
-void rehash(Array *tp)	/* rehash items in small table into big one */
+void rehash(Array *tp)	/* rehash items into a table with room to grow */
 {
-	int i, nh, nsz;
-	Cell *cp, *op, **np;
+	int i, h, nsz, mask;
+	Cell *cp, **np;
 
-	nsz = GROWTAB * tp->size;
+	/* growing to at most 1/4 full means clearing out deleted slots */
+	/* alone won't have us back here after just a few more inserts */
+	for (nsz = tp->size; 2 * FULLTAB * (tp->nelem + 1) > nsz; nsz *= GROWTAB)
+		;
 	np = (Cell **) calloc(nsz, sizeof(*np));
-	if (np == NULL)		/* can't do it, but can keep running. */
-		return;		/* someone else will run out later. */
+	if (np == NULL)
+		FATAL("out of space in rehash");
+	mask = nsz - 1;
 	for (i = 0; i < tp->size; i++) {
-		for (cp = tp->tab[i]; cp; cp = op) {
-			op = cp->cnext;
-			nh = hash(cp->nval, nsz);
-			cp->cnext = np[nh];
-			np[nh] = cp;
-		}
+		if ((cp = tp->tab[i]) == NULL || cp == &deadcell)
+			continue;
+		for (h = hash(cp->nval, nsz); np[h] != NULL; h = (h + 1) & mask)
+			;
+		np[h] = cp;
 	}
 	free(tp->tab);
 	tp->tab = np;
 	tp->size = nsz;
+	tp->ndead = 0;
 }
 
 Cell *lookup(const char *s, Array *tp)	/* look for s in tp */
 {
 	Cell *p;
-	int h;
+	int h, mask;
 
-	h = hash(s, tp->size);
-	for (p = tp->tab[h]; p != NULL; p = p->cnext)
-		if (strcmp(s, p->nval) == 0)
+	mask = tp->size - 1;
+	for (h = hash(s, tp->size); (p = tp->tab[h]) != NULL; h = (h + 1) & mask)
+		if (p != &deadcell && strcmp(s, p->nval) == 0)
 			return(p);	/* found it */
 	return(NULL);			/* not found */
 }
@@ -300,6 +312,8 @@ Awkfloat setfval(Cell *vp, Awkfloat f)	/* set float val of a Cell */
 	if ((vp->tval & (NUM | STR)) == 0)
 		funnyvar(vp, "assign to");
 	if (isfld(vp)) {
+		if (!donefld)
+			fldbld();	/* NF must be right */
 		donerec = false;	/* mark $0 invalid */
 		fldno = atoi(vp->nval);
 		if (fldno > *NF)
@@ -311,6 +325,7 @@ Awkfloat setfval(Cell *vp, Awkfloat f)	/* set float val of a Cell */
 		DPRINTF("setfval: setting NF to %g\n", f);
 	} else if (isrec(vp)) {
 		donefld = false;	/* mark $1... invalid */
+		splitfld = 0;
 		donerec = true;
 		savefs();
 	} else if (vp == ofsloc) {
@@ -353,6 +368,8 @@ char *setsval(Cell *vp, const char *s)	/* set string val of a Cell */
 	if (CSV && (vp == fsloc))
 		WARNING("danger: don't set FS when --csv is in effect");
 	if (isfld(vp)) {
+		if (!donefld)
+			fldbld();	/* NF must be right */
 		donerec = false;	/* mark $0 invalid */
 		fldno = atoi(vp->nval);
 		if (fldno > *NF)
@@ -360,6 +377,7 @@ char *setsval(Cell *vp, const char *s)	/* set string val of a Cell */
 		DPRINTF("setting field %d to %s (%p)\n", fldno, s, (const void*)s);
 	} else if (isrec(vp)) {
 		donefld = false;	/* mark $1... invalid */
+		splitfld = 0;
 		donerec = true;
 		savefs();
 	} else if (vp == ofsloc) {
@@ -390,7 +408,7 @@ Awkfloat getfval(Cell *vp)	/* get float val of a Cell */
 	if ((vp->tval & (NUM | STR)) == 0)
 		funnyvar(vp, "read value of");
 	if (isfld(vp) && !donefld)
-		fldbld();
+		fldget(vp);
 	else if (isrec(vp) && !donerec)
 		recbld();
 	if (!isnum(vp)) {	/* not a number */
@@ -428,7 +446,7 @@ static char *get_str_val(Cell *vp, char **fmt)        /* get string val of a Cel
 	if ((vp->tval & (NUM | STR)) == 0)
 		funnyvar(vp, "read value of");
 	if (isfld(vp) && ! donefld)
-		fldbld();
+		fldget(vp);
 	else if (isrec(vp) && ! donerec)
 		recbld();
 
@@ -3,6 +3,7 @@
 #include "libc/calls/struct/sigaction.h"
 #include "libc/calls/struct/siginfo.h"
 #include "libc/calls/ucontext.h"
+#include "libc/cosmo.h"
 #include "libc/fmt/libgen.h"
 #include "libc/mem/gc.h"
 #include "libc/runtime/runtime.h"
@@ -52,6 +53,7 @@ static bool opt_cc1;
 static bool opt_hash_hash_hash;
 static bool opt_static;
 static bool opt_save_temps;
+static int opt_jobs;
 static char *opt_MF;
 static char *opt_MT;
 static char *opt_o;
@@ -68,6 +70,10 @@ static char *output_file;
 static StringArray input_paths;
 char **chibicc_tmpfiles;
 
+static bool in_job;
+static bool jobs_failed;
+static int jobs_running;
+
 static const char kChibiccVersion[] = "\
 chibicc (cosmopolitan) 9.0.0\n\
 copyright 2019 rui ueyama\n\
@@ -327,6 +333,10 @@ static void parse_args(int argc, char **argv) {
       output_file = argv[++i];
     } else if (!strcmp(argv[i], "-idirafter")) {
       strarray_push(&idirafter, argv[i++]);
+    } else if (!strcmp(argv[i], "-j")) {
+      opt_jobs = cosmo_cpu_count();
+    } else if (startswith(argv[i], "-j")) {
+      opt_jobs = atoi(argv[i] + 2);
     } else if (!strcmp(argv[i], "-static")) {
       opt_static = true;
       strarray_push(&ld_extra_args, "-static");
@@ -422,7 +432,7 @@ static bool NeedsShellQuotes(const char *s) {
 }
 
 static bool run_subprocess(char **argv) {
-  int rc, ws;
+  int rc, ws, pid;
   size_t i, j;
   if (opt_verbose) {
     for (i = 0; argv[i]; i++) {
@@ -443,17 +453,56 @@ static bool run_subprocess(char **argv) {
     }
     fputc('\n', stderr);
   }
-  if (!vfork()) {
+  if (!(pid = vfork())) {
     // Child process. Run a new command.
     execvp(argv[0], argv);
     _Exit(1);
   }
   // Wait for the child process to finish.
-  do rc = wait(&ws);
+  do rc = waitpid(pid, &ws, 0);
   while (rc == -1 && errno == EINTR);
   return WIFEXITED(ws) && WEXITSTATUS(ws) == 0;
 }
 
+static void reap_job(void) {
+  int rc, ws;
+  do rc = wait(&ws);
+  while (rc == -1 && errno == EINTR);
+  if (rc == -1) return;
+  --jobs_running;
+  if (!WIFEXITED(ws) || WEXITSTATUS(ws)) jobs_failed = true;
+}
+
+static void wait_jobs(void) {
+  while (jobs_running) reap_job();
+  handle_exit(!jobs_failed);
+}
+
+// Forks a worker for compiling one translation unit when -j is used.
+//
+// The compiler keeps its state in globals, so each worker getting its
+// own process is what lets translation units build at the same time.
+// Returns true in the parent, which should move on to the next input.
+static bool start_job(void) {
+  int pid;
+  if (opt_jobs <= 1) return false;
+  while (jobs_running >= opt_jobs) reap_job();
+  if (jobs_failed) wait_jobs();
+  fflush(stdout);
+  fflush(stderr);
+  if ((pid = fork()) == -1) error("fork failed: %s", strerror(errno));
+  if (!pid) {
+    in_job = true;
+    return false;
+  }
+  ++jobs_running;
+  return true;
+}
+
+static void finish_job(void) {
+  if (in_job) _Exit(0);
+}
+
 static bool run_cc1(int argc, char **argv, char *input, char *output) {
   char **args = calloc(argc + 10, sizeof(char *));
   memcpy(args, argv, argc * sizeof(char *));
@@ -786,24 +835,31 @@ int chibicc(int argc, char **argv) {
     }
     // Compile
     if (opt_S) {
+      if (start_job()) continue;
       handle_exit(run_cc1(argc, argv, input, output));
+      finish_job();
       continue;
     }
     // Compile and assemble
     if (opt_c) {
       char *tmp = create_tmpfile();
+      if (start_job()) continue;
       handle_exit(run_cc1(argc, argv, input, tmp));
       assemble(tmp, output);
+      finish_job();
       continue;
     }
     // Compile, assemble and link
     char *tmp1 = create_tmpfile();
     char *tmp2 = create_tmpfile();
+    strarray_push(&ld_args, tmp2);
+    if (start_job()) continue;
     handle_exit(run_cc1(argc, argv, input, tmp1));
     assemble(tmp1, tmp2);
-    strarray_push(&ld_args, tmp2);
+    finish_job();
     continue;
   }
+  wait_jobs();
   if (ld_args.len > 0) {
     run_linker(&ld_args, opt_o ? opt_o : "a.out");
   }
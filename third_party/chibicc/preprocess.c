@@ -31,6 +31,7 @@
 #include "libc/assert.h"
 #include "third_party/chibicc/kw.h"
 
+typedef struct CachedFile CachedFile;
 typedef struct CondIncl CondIncl;
 typedef struct Hideset Hideset;
 typedef struct MacroArg MacroArg;
@@ -63,6 +64,13 @@ struct Hideset {
   char *name;
 };
 
+// Tokens of an #include file that might get included again.
+struct CachedFile {
+  Token *tok;
+  int64_t size;
+  struct timespec mtim;
+};
+
 HashMap macros;
 
 static CondIncl *cond_incl;
@@ -741,6 +749,33 @@ static char *detect_include_guard(Token *tok) {
   return NULL;
 }
 
+// Tokenizes an #include file, reusing the tokens from an earlier
+// inclusion if the file's size and mtime haven't changed. Sharing is
+// safe because append() copies file tokens before they're expanded.
+static Token *tokenize_include(char *path) {
+  struct stat st;
+  CachedFile *cf;
+  static HashMap token_cache;
+  if (stat(path, &st)) return NULL;
+  if ((cf = hashmap_get(&token_cache, path)) && cf->size == st.st_size &&
+      cf->mtim.tv_sec == st.st_mtim.tv_sec &&
+      cf->mtim.tv_nsec == st.st_mtim.tv_nsec) {
+    cf->tok->file->line_delta = 0;
+    cf->tok->file->display_name = cf->tok->file->name;
+    return cf->tok;
+  }
+  Token *tok = tokenize_file(path);
+  if (!tok) return NULL;
+  if (!cf) {
+    cf = calloc(1, sizeof(CachedFile));
+    hashmap_put(&token_cache, path, cf);
+  }
+  cf->tok = tok;
+  cf->size = st.st_size;
+  cf->mtim = st.st_mtim;
+  return tok;
+}
+
 static Token *include_file(Token *tok, char *path, Token *filename_tok) {
   // Check for "#pragma once"
   if (hashmap_get(&pragma_once, path)) return tok;
@@ -750,7 +785,7 @@ static Token *include_file(Token *tok, char *path, Token *filename_tok) {
   static HashMap include_guards;
   char *guard_name = hashmap_get(&include_guards, path);
   if (guard_name && hashmap_get(&macros, guard_name)) return tok;
-  Token *tok2 = tokenize_file(path);
+  Token *tok2 = tokenize_include(path);
   if (!tok2)
     error_tok(filename_tok, "%s: cannot open file: %s", path, strerror(errno));
   guard_name = detect_include_guard(tok2);
@@ -4,6 +4,8 @@
 #include "libc/calls/calls.h"
 #include "libc/calls/struct/cpuset.h"
 #include "libc/calls/struct/rseq.h"
+#include "libc/calls/struct/sigset.h"
+#include "libc/calls/struct/timespec.h"
 #include "libc/calls/syscall-sysv.internal.h"
 #include "libc/cosmo.h"
 #include "libc/dce.h"
@@ -15,6 +17,7 @@
 #include "libc/intrin/kprintf.h"
 #include "libc/intrin/likely.h"
 #include "libc/intrin/maps.h"
+#include "libc/intrin/popcnt.h"
 #include "libc/intrin/weaken.h"
 #include "libc/macros.h"
 #include "libc/mem/mem.h"
@@ -24,9 +27,11 @@
 #include "libc/runtime/sysconf.h"
 #include "libc/stdckdint.h"
 #include "libc/str/str.h"
+#include "libc/sysv/consts/madv.h"
 #include "libc/sysv/consts/map.h"
 #include "libc/sysv/consts/mremap.h"
 #include "libc/sysv/consts/prot.h"
+#include "libc/sysv/consts/sig.h"
 #include "libc/thread/posixthread.internal.h"
 #include "libc/thread/thread.h"
 #include "libc/thread/tls.h"
@@ -144,7 +149,7 @@ static void* sys_alloc(mstate m, size_t nb) {
   }
 
   if (tbase == CMFAIL) {  /* Try MMAP */
-    char* mp = _mapanon(asize);
+    char* mp = dlmalloc_mapanon(asize);
     if (mp != CMFAIL) {
       tbase = mp;
       tsize = asize;
@@ -703,6 +708,8 @@ static mstate init_user_mstate(char* tbase, size_t tsize) {
   mstate m = (mstate)(chunk2mem(msp));
   // bzero(m, msize);  // avoid latency of wiping ~1024 bytes
   (void)INITIAL_LOCK(&m->mutex);
+  m->contended = 0;
+  m->acquired = 0;
   msp->head = (msize|INUSE_BITS);
   m->seg.base = m->least_addr = tbase;
   m->seg.size = m->footprint = m->max_footprint = tsize;
@@ -728,7 +735,7 @@ mspace create_mspace(size_t capacity, int locked) {
     size_t rs = ((capacity == 0)? mparams.granularity :
                  (capacity + TOP_FOOT_SIZE + msize));
     size_t tsize = granularity_align(rs);
-    char* tbase = (char*)_mapanon(tsize);
+    char* tbase = (char*)dlmalloc_mapanon(tsize);
     if (tbase != CMFAIL) {
       m = init_user_mstate(tbase, tsize);
       m->seg.sflags = USE_MMAP_BIT;
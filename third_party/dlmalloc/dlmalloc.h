@@ -373,9 +373,22 @@ void dlmalloc_post_fork_child(void) libcesque;
 
 void dlmalloc_abort(void) relegated wontreturn;
 
+struct MallocShardStats {
+  size_t footprint;  /* bytes obtained from system */
+  size_t inuse;      /* bytes in allocated chunks */
+  size_t free;       /* bytes in free chunks */
+  size_t chunks;     /* number of free chunks */
+  size_t smallbins;  /* nonempty bins for chunks under 256 bytes */
+  size_t treebins;   /* nonempty bins for larger chunks */
+  size_t contended;  /* lock acquisitions that had to wait */
+};
+
+size_t dlmalloc_shard_stats(struct MallocShardStats *, size_t) libcesque;
+
 typedef void *(*tmspace_get_f)(void);
 tmspace_get_f tmspace_acquire(void);
 void tmspace_release(tmspace_get_f);
+void tcache_destroy(void *);
 
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_THIRD_PARTY_DLMALLOC_DLMALLOC_H_ */
@@ -370,6 +370,7 @@ Bigint *__gdtoa_set_ones(Bigint *, int);
 Bigint *__gdtoa_sum(Bigint *, Bigint *);
 
 ULong __gdtoa_any_on(Bigint *, int);
+bool __gdtoa_lemire(uint64_t, int, double *);
 char *__gdtoa_add_nanbits(char *, size_t, ULong *, int);
 char *__gdtoa_g__fmt(char *, char *, char *, int, ULong, size_t);
 double __gdtoa_b2d(Bigint *, int *);
@@ -310,6 +310,16 @@ dig_done:
 			goto ret;
 		}
 	}
+	if (nd <= DBL_DIG + 2 && Rounding == 1) {
+		/* all nd digits are in y and z so try eisel-lemire */
+		uint64_t w = y;
+		for (i = 9; i < nd; i++)
+			w *= 10;
+		if (nd > 9)
+			w += z;
+		if (__gdtoa_lemire(w, e, &dval(&rv)))
+			goto ret;
+	}
 	e1 += nd - k;
 	scale = 0;
 	if (Rounding >= 2) {
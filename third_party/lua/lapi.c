@@ -1496,6 +1496,10 @@ LUA_API int lua_gc (lua_State *L, int what, ...) {
       luaC_changemode(L, KGC_INC);
       break;
     }
+    case LUA_GCFREEZE: {
+      res = luaC_freeze(L);
+      break;
+    }
     default: res = -1;  /* invalid option */
   }
   va_end(argp);
@@ -222,8 +222,29 @@ static int iscleared (global_State *g, const GCObject *o) {
 ** be done is generational mode, as its sweep does not distinguish
 ** whites from deads.)
 */
+/*
+** [jart] A frozen object is never traversed, so once something stores
+** a reference in it, make it an ordinary object that's kept alive as a
+** root of every future cycle. Returns false if 'o' is now white and the
+** barrier has nothing left to do.
+*/
+static int thaw (lua_State *L, GCObject *o) {
+  global_State *g = G(L);
+  luaM_growvector(L, g->frozenroots, g->nfrozenroots, g->sizefrozenroots,
+                  GCObject *, MAX_INT, "frozen roots");
+  g->frozenroots[g->nfrozenroots++] = o;
+  resetbit(o->marked, FROZENBIT);
+  if (keepinvariant(g))
+    return 1;
+  makewhite(g, o);  /* will be marked as a root in the next cycle */
+  return 0;
+}
+
+
 void luaC_barrier_ (lua_State *L, GCObject *o, GCObject *v) {
   global_State *g = G(L);
+  if (isfrozen(o) && (!thaw(L, o) || !iswhite(v)))
+    return;
   lua_assert(isblack(o) && iswhite(v) && !isdead(g, v) && !isdead(g, o));
   if (keepinvariant(g)) {  /* must keep invariant? */
     reallymarkobject(g, v);  /* restore invariant */
@@ -246,6 +267,8 @@ void luaC_barrier_ (lua_State *L, GCObject *o, GCObject *v) {
 */
 void luaC_barrierback_ (lua_State *L, GCObject *o) {
   global_State *g = G(L);
+  if (isfrozen(o) && !thaw(L, o))
+    return;
   lua_assert(isblack(o) && !isdead(g, o));
   lua_assert((g->gckind == KGC_GEN) == (isold(o) && getage(o) != G_TOUCHED1));
   if (getage(o) == G_TOUCHED2)  /* already in gray list? */
@@ -268,6 +291,53 @@ void luaC_fix (lua_State *L, GCObject *o) {
 }
 
 
+static int freezelist (global_State *g, GCObject *o) {
+  int n = 0;
+  lu_byte age = (g->gckind == KGC_GEN) ? G_OLD : G_NEW;
+  for (; o != NULL; o = o->next) {
+    if (isfrozen(o))
+      continue;  /* frozen by a previous call */
+    else if (o->tt == LUA_VTHREAD)  /* stacks change without barriers */
+      g->frozenroots[g->nfrozenroots++] = o;
+    else if (o->tt == LUA_VUPVAL && upisopen(gco2upv(o)))
+      continue;  /* open upvalues are always gray */
+    else {
+      o->marked = cast_byte((o->marked & ~maskgcbits) | bitmask(BLACKBIT) |
+                            bitmask(FROZENBIT) | age);
+      n++;
+    }
+  }
+  return n;
+}
+
+
+/*
+** [jart] Collects garbage and then freezes every surviving object, so
+** that future collections neither visit nor write to them, e.g. so the
+** heap built by a server before it forks stays shared copy-on-write.
+** Frozen objects are never freed until the state is closed, and one
+** is thawed by the barrier the first time a reference is stored in it.
+** Threads are kept as roots instead, since their stacks aren't guarded
+** by barriers. Returns the number of objects frozen.
+*/
+int luaC_freeze (lua_State *L) {
+  global_State *g = G(L);
+  int i, n = 0;
+  GCObject *o;
+  luaC_fullgc(L, 0);
+  /* previously thawed objects get frozen again, so only keep threads */
+  g->nfrozenroots = 0;
+  for (i = 0; i < 2; i++)
+    for (o = i ? g->finobj : g->allgc; o != NULL; o = o->next)
+      if (o->tt == LUA_VTHREAD)
+        n++;
+  g->frozenroots = luaM_reallocvector(L, g->frozenroots, g->sizefrozenroots,
+                                      n, GCObject *);
+  g->sizefrozenroots = n;
+  return freezelist(g, g->allgc) + freezelist(g, g->finobj);
+}
+
+
 /*
 ** create a new collectable object (with given type, size, and offset)
 ** and link it to 'allgc' list.
@@ -356,6 +426,16 @@ static void markmt (global_State *g) {
 }
 
 
+/*
+** [jart] mark threads and thawed objects that frozen objects refer to
+*/
+static void markfrozenroots (global_State *g) {
+  int i;
+  for (i = 0; i < g->nfrozenroots; i++)
+    markobject(g, g->frozenroots[i]);
+}
+
+
 /*
 ** mark all objects in list of being-finalized
 */
@@ -422,6 +502,7 @@ static void restartcollection (global_State *g) {
   markobject(g, g->mainthread);
   markvalue(g, &g->l_registry);
   markmt(g);
+  markfrozenroots(g);
   markbeingfnz(g);  /* mark any finalizing object left from previous cycle */
 }
 
@@ -845,7 +926,9 @@ static GCObject **sweeplist (lua_State *L, GCObject **p, int countin,
   for (i = 0; *p != NULL && i < countin; i++) {
     GCObject *curr = *p;
     int marked = curr->marked;
-    if (isdeadm(ow, marked)) {  /* is 'curr' dead? */
+    if (testbit(marked, FROZENBIT))  /* [jart] don't touch frozen objects */
+      p = &curr->next;
+    else if (isdeadm(ow, marked)) {  /* is 'curr' dead? */
       *p = curr->next;  /* remove 'curr' from list */
       freeobj(L, curr);  /* erase 'curr' */
     }
@@ -1095,7 +1178,12 @@ static void sweep2old (lua_State *L, GCObject **p) {
   GCObject *curr;
   global_State *g = G(L);
   while ((curr = *p) != NULL) {
-    if (iswhite(curr)) {  /* is 'curr' dead? */
+    if (isfrozen(curr)) {  /* [jart] frozen objects are already black */
+      if (getage(curr) != G_OLD)
+        setage(curr, G_OLD);
+      p = &curr->next;
+    }
+    else if (iswhite(curr)) {  /* is 'curr' dead? */
       lua_assert(isdead(g, curr));
       *p = curr->next;  /* remove 'curr' from list */
       freeobj(L, curr);  /* erase 'curr' */
@@ -1170,8 +1258,12 @@ static GCObject **sweepgen (lua_State *L, global_State *g, GCObject **p,
 */
 static void whitelist (global_State *g, GCObject *p) {
   int white = luaC_white(g);
-  for (; p != NULL; p = p->next)
-    p->marked = cast_byte((p->marked & ~maskgcbits) | white);
+  for (; p != NULL; p = p->next) {
+    if (!isfrozen(p))
+      p->marked = cast_byte((p->marked & ~maskgcbits) | white);
+    else if (getage(p) != G_NEW)  /* [jart] frozen objects stay black */
+      setage(p, G_NEW);
+  }
 }
 
 
@@ -1550,6 +1642,7 @@ static lu_mem atomic (lua_State *L) {
   /* registry and global metatables may be changed by API */
   markvalue(g, &g->l_registry);
   markmt(g);  /* mark global metatables */
+  markfrozenroots(g);
   work += propagateall(g);  /* empties 'gray' list */
   /* remark occasional upvalues of (maybe) dead threads */
   work += remarkupvals(g);
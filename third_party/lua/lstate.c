@@ -28,6 +28,7 @@
 #define lstate_c
 #define LUA_CORE
 
+#include "libc/stdio/rand.h"
 #include "libc/str/str.h"
 #include "libc/time.h"
 #include "third_party/lua/lapi.h"
@@ -76,8 +77,8 @@ typedef struct LG {
 
 /*
 ** Compute an initial seed with some level of randomness.
-** Rely on Address Space Layout Randomization (if present) and
-** current time.
+** Rely on the system entropy pool, Address Space Layout Randomization
+** (if present) and current time.
 */
 #define addbuff(b,p,e) \
   { size_t t = cast_sizet(e); \
@@ -85,7 +86,7 @@ typedef struct LG {
 
 static unsigned int luai_makeseed (lua_State *L) {
   char buff[3 * sizeof(size_t)];
-  unsigned int h = cast_uint(time(NULL));
+  unsigned int h = cast_uint(time(NULL) ^ _rand64());
   int p = 0;
   addbuff(buff, p, L);  /* heap variable */
   addbuff(buff, p, &h);  /* local variable */
@@ -292,6 +293,7 @@ static void close_state (lua_State *L) {
     luai_userstateclose(L);
   }
   luaM_freearray(L, G(L)->strt.hash, G(L)->strt.size);
+  luaM_freearray(L, G(L)->frozenroots, G(L)->sizefrozenroots);
   freestack(L);
   lua_assert(gettotalbytes(g) == sizeof(LG));
   (*g->frealloc)(g->ud, fromstate(L), sizeof(LG), 0);  /* free main block */
@@ -413,6 +415,8 @@ LUA_API lua_State *lua_newstate (lua_Alloc f, void *ud) {
   g->gcstopem = 0;
   g->gcemergency = 0;
   g->finobj = g->tobefnz = g->fixedgc = NULL;
+  g->frozenroots = NULL;
+  g->nfrozenroots = g->sizefrozenroots = 0;
   g->firstold1 = g->survival = g->old1 = g->reallyold = NULL;
   g->finobjsur = g->finobjold1 = g->finobjrold = NULL;
   g->sweepgc = NULL;
@@ -274,6 +274,9 @@ typedef struct global_State {
   GCObject *allweak;  /* list of all-weak tables */
   GCObject *tobefnz;  /* list of userdata to be GC */
   GCObject *fixedgc;  /* list of objects not to be collected */
+  GCObject **frozenroots;  /* [jart] thawed objects and threads */
+  int nfrozenroots;  /* number of elements in 'frozenroots' */
+  int sizefrozenroots;  /* size of 'frozenroots' */
   /* fields for generational collector */
   GCObject *survival;  /* start of objects that survived one GC cycle */
   GCObject *old1;  /* start of old1 objects */
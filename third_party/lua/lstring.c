@@ -58,11 +58,47 @@ int luaS_eqlngstr (TString *a, TString *b) {
 }
 
 
+/*
+** Hashes a string a word at a time. Each 64-bit word is folded in with
+** a multiply and xorshift, strings shorter than eight bytes are read as
+** two overlapping halves, and the tail of longer strings is read as one
+** overlapping word, so every byte is hashed and no read goes past the
+** end of the string.
+*/
+#define HASHMUL 0x9e3779b97f4a7c15ull
+
+static uint64_t hashword (uint64_t h, uint64_t w) {
+  h = (h ^ w) * HASHMUL;
+  return h ^ (h >> 29);
+}
+
+static uint64_t loadword (const char *p) {
+  uint64_t w;
+  memcpy(&w, p, sizeof(w));
+  return w;
+}
+
+static uint32_t loadhalf (const char *p) {
+  uint32_t w;
+  memcpy(&w, p, sizeof(w));
+  return w;
+}
+
 unsigned int luaS_hash (const char *str, size_t l, unsigned int seed) {
-  unsigned int h = seed ^ cast_uint(l);
-  for (; l > 0; l--)
-    h ^= ((h<<5) + (h>>2) + cast_byte(str[l - 1]));
-  return h;
+  uint64_t h = hashword(seed, l);
+  if (l >= 8) {
+    const char *e = str + l - 8;
+    for (; str < e; str += 8)
+      h = hashword(h, loadword(str));
+    h = hashword(h, loadword(e));
+  }
+  else if (l >= 4)
+    h = hashword(h, (uint64_t)loadhalf(str) << 32 | loadhalf(str + l - 4));
+  else if (l > 0)
+    h = hashword(h, cast_byte(str[0]) << 16 | cast_byte(str[l >> 1]) << 8 |
+                    cast_byte(str[l - 1]));
+  h *= HASHMUL;
+  return cast_uint(h >> 32 ^ h);
 }
 
 
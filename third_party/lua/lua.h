@@ -336,6 +336,7 @@ LUA_API void (lua_warning)  (lua_State *L, const char *msg, int tocont);
 #define LUA_GCISRUNNING		9
 #define LUA_GCGEN		10
 #define LUA_GCINC		11
+#define LUA_GCFREEZE		12  /* [jart] see luaC_freeze */
 
 LUA_API int (lua_gc) (lua_State *L, int what, ...);
 
@@ -18,16 +18,18 @@
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/assert.h"
 #include "libc/fmt/itoa.h"
-#include "libc/serialize.h"
 #include "libc/intrin/likely.h"
 #include "libc/log/log.h"
 #include "libc/log/rop.internal.h"
+#include "libc/macros.h"
+#include "libc/mem/alg.h"
 #include "libc/mem/gc.h"
 #include "libc/mem/mem.h"
 #include "libc/runtime/runtime.h"
 #include "libc/runtime/stack.h"
+#include "libc/serialize.h"
+#include "libc/stdckdint.h"
 #include "libc/stdio/append.h"
-#include "libc/stdio/strlist.internal.h"
 #include "libc/str/str.h"
 #include "libc/sysv/consts/auxv.h"
 #include "net/http/escape.h"
@@ -35,40 +37,134 @@
 #include "third_party/lua/cosmo.h"
 #include "third_party/lua/lauxlib.h"
 #include "third_party/lua/lua.h"
-#include "third_party/lua/cosmo.h"
 #include "third_party/lua/visitor.h"
 
-static int Serialize(lua_State *, char **, int, struct Serializer *, int);
+// buffers bigger than this aren't kept around between calls
+#define JSONKEEP (1024 * 1024)
+
+struct JsonBuf {
+  char *p;
+  size_t i;
+  size_t n;
+};
+
+struct JsonSpan {
+  size_t i;
+  size_t n;
+};
+
+// output and escape buffers are reused by each thread between calls,
+// so encoding a typical response doesn't touch malloc() until output
+// is copied to the caller's append buffer at the very end
+static _Thread_local struct JsonCache {
+  bool busy;
+  struct JsonBuf out;
+  char *strbuf;
+  size_t strbuflen;
+} g_json;
+
+static int Serialize(lua_State *, struct JsonBuf *, int, struct Serializer *,
+                     int);
 
-static int SerializeNull(lua_State *L, char **buf) {
-  RETURN_ON_ERROR(appendw(buf, READ32LE("null")));
+static dontinline int GrowJson(struct JsonBuf *b, size_t n) {
+  char *p;
+  size_t m;
+  if (ckd_add(&m, b->i, n))
+    return -1;
+  m = MAX(m, b->n + (b->n >> 1));
+  m = MAX(m, 256);
+  if (!(p = realloc(b->p, m)))
+    return -1;
+  b->p = p;
+  b->n = m;
+  return 0;
+}
+
+static inline int ReserveJson(struct JsonBuf *b, size_t n) {
+  return LIKELY(b->n - b->i >= n) ? 0 : GrowJson(b, n);
+}
+
+static inline int PutJson(struct JsonBuf *b, const void *p, size_t n) {
+  RETURN_ON_ERROR(ReserveJson(b, n));
+  memcpy(b->p + b->i, p, n);
+  b->i += n;
   return 0;
 OnError:
   return -1;
 }
 
-static int SerializeBoolean(lua_State *L, char **buf, int idx) {
-  RETURN_ON_ERROR(appendw(
-      buf, lua_toboolean(L, idx) ? READ32LE("true") : READ64LE("false\0\0")));
+static inline int PutJsonChar(struct JsonBuf *b, char c) {
+  RETURN_ON_ERROR(ReserveJson(b, 1));
+  b->p[b->i++] = c;
   return 0;
 OnError:
   return -1;
 }
 
-static int SerializeNumber(lua_State *L, char **buf, int idx) {
-  char ibuf[128];
+static int SerializeIndent(struct JsonBuf *b, struct Serializer *z,
+                           int depth) {
+  int i;
+  size_t n = strlen(z->conf.indent);
+  RETURN_ON_ERROR(ReserveJson(b, 1 + n * depth));
+  b->p[b->i++] = '\n';
+  for (i = 0; i < depth; ++i) {
+    memcpy(b->p + b->i, z->conf.indent, n);
+    b->i += n;
+  }
+  return 0;
+OnError:
+  return -1;
+}
+
+static int SerializeStart(struct JsonBuf *b, struct Serializer *z, int depth,
+                          bool multi) {
+  RETURN_ON_ERROR(PutJsonChar(b, '{'));
+  if (multi) {
+    RETURN_ON_ERROR(SerializeIndent(b, z, depth + 1));
+  }
+  return 0;
+OnError:
+  return -1;
+}
+
+static int SerializeEnd(struct JsonBuf *b, struct Serializer *z, int depth,
+                        bool multi) {
+  if (multi) {
+    RETURN_ON_ERROR(SerializeIndent(b, z, depth));
+  }
+  RETURN_ON_ERROR(PutJsonChar(b, '}'));
+  return 0;
+OnError:
+  return -1;
+}
+
+static int SerializeNull(lua_State *L, struct JsonBuf *b) {
+  return PutJson(b, "null", 4);
+}
+
+static int SerializeBoolean(lua_State *L, struct JsonBuf *b, int idx) {
+  if (lua_toboolean(L, idx)) {
+    return PutJson(b, "true", 4);
+  } else {
+    return PutJson(b, "false", 5);
+  }
+}
+
+static int SerializeNumber(lua_State *L, struct JsonBuf *b, int idx) {
+  char *p;
+  RETURN_ON_ERROR(ReserveJson(b, 128));
+  p = b->p + b->i;
   if (lua_isinteger(L, idx)) {
-    RETURN_ON_ERROR(appendd(
-        buf, ibuf, FormatInt64(ibuf, luaL_checkinteger(L, idx)) - ibuf));
+    b->i = FormatInt64(p, luaL_checkinteger(L, idx)) - b->p;
   } else {
-    RETURN_ON_ERROR(appends(buf, DoubleToJson(ibuf, lua_tonumber(L, idx))));
+    b->i += strlen(DoubleToJson(p, lua_tonumber(L, idx)));
   }
   return 0;
 OnError:
   return -1;
 }
 
-static int SerializeString(lua_State *L, char **buf, int idx,
+static int SerializeString(lua_State *L, struct JsonBuf *b, int idx,
                            struct Serializer *z) {
   size_t m;
   const char *s;
@@ -76,97 +172,128 @@ static int SerializeString(lua_State *L, char **buf, int idx,
   if (!(s = EscapeJsStringLiteral(&z->strbuf, &z->strbuflen, s, m, &m))) {
     goto OnError;
   }
-  RETURN_ON_ERROR(appendw(buf, '"'));
-  RETURN_ON_ERROR(appendd(buf, s, m));
-  RETURN_ON_ERROR(appendw(buf, '"'));
+  RETURN_ON_ERROR(ReserveJson(b, m + 2));
+  b->p[b->i++] = '"';
+  memcpy(b->p + b->i, s, m);
+  b->i += m;
+  b->p[b->i++] = '"';
   return 0;
 OnError:
   return -1;
 }
 
-static int SerializeArray(lua_State *L, char **buf, struct Serializer *z,
-                          int depth, size_t tbllen) {
+static int SerializeArray(lua_State *L, struct JsonBuf *b,
+                          struct Serializer *z, int depth, size_t tbllen) {
   size_t i;
-  RETURN_ON_ERROR(appendw(buf, '['));
+  RETURN_ON_ERROR(PutJsonChar(b, '['));
   for (i = 1; i <= tbllen; i++) {
     lua_rawgeti(L, -1, i);  // +2
-    if (i > 1) RETURN_ON_ERROR(appendw(buf, ','));
-    RETURN_ON_ERROR(Serialize(L, buf, -1, z, depth + 1));
+    if (i > 1) RETURN_ON_ERROR(PutJsonChar(b, ','));
+    RETURN_ON_ERROR(Serialize(L, b, -1, z, depth + 1));
     lua_pop(L, 1);
   }
-  RETURN_ON_ERROR(appendw(buf, ']'));
+  RETURN_ON_ERROR(PutJsonChar(b, ']'));
   return 0;
 OnError:
   return -1;
 }
 
-static int SerializeObject(lua_State *L, char **buf, struct Serializer *z,
-                           int depth, bool multi) {
+static int SerializeObject(lua_State *L, struct JsonBuf *b,
+                           struct Serializer *z, int depth, bool multi) {
   bool comma = false;
-  RETURN_ON_ERROR(SerializeObjectStart(buf, z, depth, multi));
+  RETURN_ON_ERROR(SerializeStart(b, z, depth, multi));
   lua_pushnil(L);            // +2
   while (lua_next(L, -2)) {  // +3
     if (lua_type(L, -2) == LUA_TSTRING) {
       if (comma) {
-        RETURN_ON_ERROR(appendw(buf, ','));
+        RETURN_ON_ERROR(PutJsonChar(b, ','));
         if (multi) {
-          RETURN_ON_ERROR(SerializeObjectIndent(buf, z, depth + 1));
+          RETURN_ON_ERROR(SerializeIndent(b, z, depth + 1));
         }
       } else {
         comma = true;
       }
-      RETURN_ON_ERROR(SerializeString(L, buf, -2, z));
-      RETURN_ON_ERROR(appendw(buf, z->conf.pretty ? READ16LE(": ") : ':'));
-      RETURN_ON_ERROR(Serialize(L, buf, -1, z, depth + 1));
+      RETURN_ON_ERROR(SerializeString(L, b, -2, z));
+      RETURN_ON_ERROR(PutJson(b, ": ", z->conf.pretty ? 2 : 1));
+      RETURN_ON_ERROR(Serialize(L, b, -1, z, depth + 1));
       lua_pop(L, 1);
     } else {
       z->reason = "json objects must only use string keys";
       goto OnError;
     }
   }
-  RETURN_ON_ERROR(SerializeObjectEnd(buf, z, depth, multi));
+  RETURN_ON_ERROR(SerializeEnd(b, z, depth, multi));
   return 0;
 OnError:
   return -1;
 }
 
-static int SerializeSorted(lua_State *L, char **buf, struct Serializer *z,
-                           int depth, bool multi) {
-  int i;
-  struct StrList sl = {0};
+// orders the same way strcmp() would, since encoded json has no nuls
+static int CompareJsonSpans(const void *a, const void *b, void *arg) {
+  int c;
+  const char *p = arg;
+  const struct JsonSpan *x = a, *y = b;
+  if ((c = memcmp(p + x->i, p + y->i, MIN(x->n, y->n))))
+    return c;
+  return (x->n > y->n) - (x->n < y->n);
+}
+
+// serializes each `"key":value` pair to the end of the output buffer,
+// sorts their spans, then writes them back in order with delimiters
+static int SerializeSorted(lua_State *L, struct JsonBuf *b,
+                           struct Serializer *z, int depth, bool multi) {
+  char *tmp = 0;
+  size_t i, n = 0, c = 0, start;
+  struct JsonSpan *spans = 0, *p;
+  start = b->i;
   lua_pushnil(L);
   while (lua_next(L, -2)) {
     if (lua_type(L, -2) == LUA_TSTRING) {
-      RETURN_ON_ERROR(i = AppendStrList(&sl));
-      RETURN_ON_ERROR(SerializeString(L, sl.p + i, -2, z));
-      RETURN_ON_ERROR(appendw(sl.p + i, z->conf.pretty ? READ16LE(": ") : ':'));
-      RETURN_ON_ERROR(Serialize(L, sl.p + i, -1, z, depth + 1));
+      if (n == c) {
+        c = c ? c + (c >> 1) : 8;
+        if (!(p = realloc(spans, c * sizeof(*spans))))
+          goto OnError;
+        spans = p;
+      }
+      spans[n].i = b->i;
+      RETURN_ON_ERROR(SerializeString(L, b, -2, z));
+      RETURN_ON_ERROR(PutJson(b, ": ", z->conf.pretty ? 2 : 1));
+      RETURN_ON_ERROR(Serialize(L, b, -1, z, depth + 1));
+      spans[n].n = b->i - spans[n].i;
+      ++n;
       lua_pop(L, 1);
     } else {
       z->reason = "json objects must only use string keys";
       goto OnError;
     }
   }
-  SortStrList(&sl);
-  RETURN_ON_ERROR(SerializeObjectStart(buf, z, depth, multi));
-  for (i = 0; i < sl.i; ++i) {
+  if (n > 1)
+    qsort_r(spans, n, sizeof(*spans), CompareJsonSpans, b->p);
+  if (!(tmp = malloc(b->i - start + 1)))
+    goto OnError;
+  memcpy(tmp, b->p + start, b->i - start);
+  b->i = start;
+  RETURN_ON_ERROR(SerializeStart(b, z, depth, multi));
+  for (i = 0; i < n; ++i) {
     if (i) {
-      RETURN_ON_ERROR(appendw(buf, ','));
+      RETURN_ON_ERROR(PutJsonChar(b, ','));
       if (multi) {
-        RETURN_ON_ERROR(SerializeObjectIndent(buf, z, depth + 1));
+        RETURN_ON_ERROR(SerializeIndent(b, z, depth + 1));
       }
     }
-    RETURN_ON_ERROR(appends(buf, sl.p[i]));
+    RETURN_ON_ERROR(PutJson(b, tmp + (spans[i].i - start), spans[i].n));
   }
-  RETURN_ON_ERROR(SerializeObjectEnd(buf, z, depth, multi));
-  FreeStrList(&sl);
+  RETURN_ON_ERROR(SerializeEnd(b, z, depth, multi));
+  free(spans);
+  free(tmp);
   return 0;
 OnError:
-  FreeStrList(&sl);
+  free(spans);
+  free(tmp);
   return -1;
 }
 
-static int SerializeTable(lua_State *L, char **buf, int idx,
+static int SerializeTable(lua_State *L, struct JsonBuf *b, int idx,
                           struct Serializer *z, int depth) {
   int rc;
   bool multi;
@@ -190,13 +317,13 @@ static int SerializeTable(lua_State *L, char **buf, int idx,
       lua_pop(L, 1);
     }
     if (isarray) {
-      RETURN_ON_ERROR(SerializeArray(L, buf, z, depth, n));
+      RETURN_ON_ERROR(SerializeArray(L, b, z, depth, n));
     } else {
       multi = z->conf.pretty && LuaHasMultipleItems(L);
       if (z->conf.sorted) {
-        RETURN_ON_ERROR(SerializeSorted(L, buf, z, depth, multi));
+        RETURN_ON_ERROR(SerializeSorted(L, b, z, depth, multi));
       } else {
-        RETURN_ON_ERROR(SerializeObject(L, buf, z, depth, multi));
+        RETURN_ON_ERROR(SerializeObject(L, b, z, depth, multi));
       }
     }
     LuaPopVisit(&z->visited);
@@ -210,20 +337,20 @@ OnError:
   return -1;
 }
 
-static int Serialize(lua_State *L, char **buf, int idx, struct Serializer *z,
-                     int depth) {
+static int Serialize(lua_State *L, struct JsonBuf *b, int idx,
+                     struct Serializer *z, int depth) {
   if (depth < z->conf.maxdepth) {
     switch (lua_type(L, idx)) {
       case LUA_TNIL:
-        return SerializeNull(L, buf);
+        return SerializeNull(L, b);
       case LUA_TBOOLEAN:
-        return SerializeBoolean(L, buf, idx);
+        return SerializeBoolean(L, b, idx);
       case LUA_TSTRING:
-        return SerializeString(L, buf, idx, z);
+        return SerializeString(L, b, idx, z);
       case LUA_TNUMBER:
-        return SerializeNumber(L, buf, idx);
+        return SerializeNumber(L, b, idx);
       case LUA_TTABLE:
-        return SerializeTable(L, buf, idx, z, depth);
+        return SerializeTable(L, b, idx, z, depth);
       default:
         z->reason = "unsupported lua type";
         return -1;
@@ -265,15 +392,45 @@ static int Serialize(lua_State *L, char **buf, int idx, struct Serializer *z,
 int LuaEncodeJsonData(lua_State *L, char **buf, int idx,
                       struct EncoderConfig conf) {
   int rc;
+  bool cached;
+  struct JsonBuf local = {0}, *b;
   struct Serializer z = {
     .reason = "out of memory", 
     .bsp = GetStackBottom() + 4096,
     .conf = conf,
   };
   if (lua_checkstack(L, conf.maxdepth * 3 + LUA_MINSTACK)) {
-    rc = Serialize(L, buf, idx, &z, 0);
+    // a __gc finalizer could call us while we're encoding
+    if ((cached = !g_json.busy)) {
+      g_json.busy = true;
+      b = &g_json.out;
+      z.strbuf = g_json.strbuf;
+      z.strbuflen = g_json.strbuflen;
+    } else {
+      b = &local;
+    }
+    b->i = 0;
+    if ((rc = Serialize(L, b, idx, &z, 0)) != -1 &&
+        appendd(buf, b->p, b->i) == -1) {
+      z.reason = "out of memory";
+      rc = -1;
+    }
     free(z.visited.p);
-    free(z.strbuf);
+    if (cached && b->n <= JSONKEEP && z.strbuflen <= JSONKEEP) {
+      g_json.strbuf = z.strbuf;
+      g_json.strbuflen = z.strbuflen;
+    } else {
+      free(b->p);
+      free(z.strbuf);
+      b->p = 0;
+      b->n = 0;
+      if (cached) {
+        g_json.strbuf = 0;
+        g_json.strbuflen = 0;
+      }
+    }
+    if (cached)
+      g_json.busy = false;
     if (rc == -1) {
       lua_pushnil(L);
       lua_pushstring(L, z.reason);
@@ -43,7 +43,7 @@ int LuaParseUrl(lua_State *L) {
   const char *p;
   p = luaL_checklstring(L, 1, &n);
   f = luaL_optinteger(L, 2, 0);
-  m = ParseUrl(p, n, &h, f);
+  m = ParseUrl(p, n, &h, f | kUrlView);
   lua_newtable(L);
   LuaSetUrlView(L, &h.scheme, "scheme");
   LuaSetUrlView(L, &h.user, "user");
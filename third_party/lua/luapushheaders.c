@@ -16,29 +16,30 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
-#include "libc/mem/mem.h"
-#include "net/http/escape.h"
 #include "net/http/http.h"
 #include "third_party/lua/cosmo.h"
 #include "third_party/lua/lua.h"
 
 int LuaPushHeaders(lua_State *L, struct HttpMessage *m, const char *b) {
-  char *s;
-  size_t i, h;
+  size_t i, h, n;
   struct HttpHeader *x;
-  lua_newtable(L);
+  for (n = m->xheaders.n, h = 0; h < kHttpHeadersMax; ++h)
+    n += !!m->headers[h].a;
+  lua_createtable(L, 0, n);
   for (h = 0; h < kHttpHeadersMax; ++h) {
     if (m->headers[h].a) {
+      lua_pushstring(L, GetHttpHeaderName(h));
       LuaPushHeader(L, m, b, h);
-      lua_setfield(L, -2, GetHttpHeaderName(h));
+      lua_rawset(L, -3);
     }
   }
+  // repeats of well-known headers were already folded in above
   for (i = 0; i < m->xheaders.n; ++i) {
     x = m->xheaders.p + i;
-    if ((h = GetHttpHeader(b + x->v.a, x->v.b - x->v.a)) == -1) {
+    if (GetHttpHeader(b + x->k.a, x->k.b - x->k.a) == -1) {
+      LuaPushLatin1(L, b + x->k.a, x->k.b - x->k.a);
       LuaPushLatin1(L, b + x->v.a, x->v.b - x->v.a);
-      lua_setfield(L, -2, (s = DecodeLatin1(b + x->k.a, x->k.b - x->k.a, 0)));
-      free(s);
+      lua_rawset(L, -3);
     }
   }
   return 1;
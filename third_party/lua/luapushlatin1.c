@@ -24,7 +24,14 @@
 
 void LuaPushLatin1(lua_State *L, const char *s, size_t n) {
   char *t;
-  size_t m;
+  size_t i, m;
+  for (i = 0; i < n; ++i)
+    if (s[i] & 0200)
+      break;
+  if (i == n) {
+    lua_pushlstring(L, s, n);  // ascii is the same in utf-8
+    return;
+  }
   t = DecodeLatin1(s, n, &m);
   lua_pushlstring(L, t, m);
   free(t);
@@ -23,15 +23,15 @@
 
 void LuaPushUrlParams(lua_State *L, struct UrlParams *h) {
   size_t i;
-  lua_newtable(L);
+  lua_createtable(L, h->n, 0);
   for (i = 0; i < h->n; ++i) {
-    lua_newtable(L);
+    lua_createtable(L, 2, 0);
     lua_pushlstring(L, h->p[i].key.p, h->p[i].key.n);
-    lua_seti(L, -2, 1);
+    lua_rawseti(L, -2, 1);
     if (h->p[i].val.p) {
       lua_pushlstring(L, h->p[i].val.p, h->p[i].val.n);
-      lua_seti(L, -2, 2);
+      lua_rawseti(L, -2, 2);
     }
-    lua_seti(L, -2, i + 1);
+    lua_rawseti(L, -2, i + 1);
   }
 }
@@ -1336,24 +1336,38 @@ static int LuaUnixFtruncate(lua_State *L) {
 // unix.read(fd:int[, bufsiz:str[, offset:int]])
 //     ├─→ data:str
 //     └─→ nil, unix.Errno
+// unix.read(fd:int, buffer:unix.Buffer[, bufsiz:str[, offset:int]])
+//     ├─→ gotbytes:int
+//     └─→ nil, unix.Errno
 static int LuaUnixRead(lua_State *L) {
   char *buf;
   size_t got;
   ssize_t rc;
   int fd, olderr;
+  bool isbuffer;
   lua_Integer bufsiz, offset;
   olderr = errno;
   fd = luaL_checkinteger(L, 1);
-  bufsiz = luaL_optinteger(L, 2, BUFSIZ);
-  offset = luaL_optinteger(L, 3, -1);
+  isbuffer = LuaUnixIsBuffer(L, 2);
+  bufsiz = luaL_optinteger(L, 2 + isbuffer, BUFSIZ);
+  offset = luaL_optinteger(L, 3 + isbuffer, -1);
   bufsiz = MIN(bufsiz, 0x7ffff000);
-  buf = LuaAllocOrDie(L, bufsiz);
+  if (isbuffer) {
+    // read directly into the end of the buffer
+    buf = LuaUnixBufferReserve(L, 2, bufsiz);
+  } else {
+    buf = LuaAllocOrDie(L, bufsiz);
+  }
   if (offset == -1) {
     rc = read(fd, buf, bufsiz);
   } else {
     rc = pread(fd, buf, bufsiz, offset);
   }
-  if (rc != -1) {
+  if (isbuffer) {
+    if (rc != -1)
+      LuaUnixBufferCommit(L, 2, rc);
+    return SysretInteger(L, "read", olderr, rc);
+  } else if (rc != -1) {
     got = rc;
     lua_pushlstring(L, buf, got);
     free(buf);
@@ -1364,7 +1378,7 @@ static int LuaUnixRead(lua_State *L) {
   }
 }
 
-// unix.write(fd:int, data:str[, offset:int])
+// unix.write(fd:int, data:str|unix.Buffer[, offset:int])
 //     ├─→ wrotebytes:int
 //     └─→ nil, unix.Errno
 static int LuaUnixWrite(lua_State *L) {
@@ -1375,7 +1389,7 @@ static int LuaUnixWrite(lua_State *L) {
   lua_Integer offset;
   olderr = errno;
   fd = luaL_checkinteger(L, 1);
-  data = luaL_checklstring(L, 2, &size);
+  data = LuaUnixCheckBytes(L, 2, &size);
   offset = luaL_optinteger(L, 3, -1);
   if (offset == -1) {
     rc = write(fd, data, size);
@@ -3318,6 +3332,347 @@ static int LuaUnixMapshared(lua_State *L) {
   return 1;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// unix.Buffer object
+
+// bytes which are shared by a buffer and all the slices taken of it
+struct BufferStore {
+  int refs;
+  size_t mapsize;  // nonzero if p came from mmap() rather than malloc()
+  size_t n, c;
+  char *p;
+};
+
+struct UnixBuffer {
+  struct BufferStore *s;
+  size_t i, n;  // our view is s->p[i,i+n)
+};
+
+static struct BufferStore *NewBufferStore(lua_State *L, char *p, size_t c,
+                                          size_t mapsize) {
+  struct BufferStore *s;
+  s = LuaAllocOrDie(L, sizeof(*s));
+  s->refs = 1;
+  s->mapsize = mapsize;
+  s->n = 0;
+  s->c = c;
+  s->p = p;
+  return s;
+}
+
+static void UnrefBufferStore(struct BufferStore *s) {
+  if (--s->refs)
+    return;
+  if (s->mapsize) {
+    npassert(!munmap(s->p, s->mapsize));
+  } else {
+    free(s->p);
+  }
+  free(s);
+}
+
+static struct UnixBuffer *PushBuffer(lua_State *L, struct BufferStore *s,
+                                     size_t i, size_t n) {
+  struct UnixBuffer *b;
+  b = lua_newuserdatauv(L, sizeof(*b), 1);
+  luaL_setmetatable(L, "unix.Buffer");
+  b->s = s;
+  b->i = i;
+  b->n = n;
+  return b;
+}
+
+static struct UnixBuffer *GetBuffer(lua_State *L, int i) {
+  struct UnixBuffer *b;
+  b = luaL_checkudata(L, i, "unix.Buffer");
+  if (!b->s) {
+    luaL_argerror(L, i, "unix.Buffer is closed");
+    __builtin_unreachable();
+  }
+  return b;
+}
+
+/**
+ * Returns true if Lua stack item `i` is a unix.Buffer.
+ */
+bool LuaUnixIsBuffer(lua_State *L, int i) {
+  return !!luaL_testudata(L, i, "unix.Buffer");
+}
+
+/**
+ * Returns bytes of Lua stack item `i`, which may be a string or a
+ * unix.Buffer. Buffers aren't copied, so the result is only valid
+ * until the buffer is next changed.
+ */
+const char *LuaUnixCheckBytes(lua_State *L, int i, size_t *n) {
+  struct UnixBuffer *b;
+  if (lua_type(L, i) == LUA_TUSERDATA) {
+    b = GetBuffer(L, i);
+    *n = b->n;
+    return b->s->p + b->i;
+  } else {
+    return luaL_checklstring(L, i, n);
+  }
+}
+
+/**
+ * Same as LuaUnixCheckBytes() except `d` is returned for none or nil.
+ */
+const char *LuaUnixOptBytes(lua_State *L, int i, const char *d, size_t *n) {
+  if (lua_isnoneornil(L, i)) {
+    if (n)
+      *n = d ? strlen(d) : 0;
+    return d;
+  } else {
+    return LuaUnixCheckBytes(L, i, n);
+  }
+}
+
+/**
+ * Returns pointer to `n` writable bytes at end of unix.Buffer `i`.
+ *
+ * The bytes become part of the buffer once LuaUnixBufferCommit() is
+ * called. Slices and mappings are copied here the first time they're
+ * appended to, so the bytes other slices see never change.
+ */
+char *LuaUnixBufferReserve(lua_State *L, int i, size_t n) {
+  char *p;
+  size_t c;
+  struct UnixBuffer *b;
+  struct BufferStore *s;
+  b = GetBuffer(L, i);
+  s = b->s;
+  if (n > 0x7ffff000) {
+    luaL_error(L, "buffer too big");
+    __builtin_unreachable();
+  }
+  if (s->mapsize || b->i + b->n != s->n) {
+    c = MAX(64, b->n + n);
+    p = LuaAllocOrDie(L, c);
+    memcpy(p, s->p + b->i, b->n);
+    s = NewBufferStore(L, p, c, 0);
+    s->n = b->n;
+    UnrefBufferStore(b->s);
+    b->s = s;
+    b->i = 0;
+  } else if (s->c - s->n < n) {
+    c = MAX(s->n + n, s->c + (s->c >> 1));
+    p = LuaAllocOrDie(L, c);
+    memcpy(p, s->p, s->n);
+    free(s->p);
+    s->p = p;
+    s->c = c;
+  }
+  return s->p + s->n;
+}
+
+/**
+ * Appends `n` bytes written to LuaUnixBufferReserve() memory.
+ */
+void LuaUnixBufferCommit(lua_State *L, int i, size_t n) {
+  struct UnixBuffer *b;
+  b = GetBuffer(L, i);
+  npassert(b->s->n + n <= b->s->c);
+  b->s->n += n;
+  b->n += n;
+}
+
+/**
+ * Pushes unix.Buffer that takes ownership of malloc() memory `p`.
+ *
+ * @param c is number of bytes allocated at `p`
+ * @param i is offset of the buffer's contents within `p`
+ * @param n is length of the buffer's contents
+ */
+void LuaUnixPushBuffer(lua_State *L, char *p, size_t c, size_t i, size_t n) {
+  struct BufferStore *s;
+  npassert(i + n <= c);
+  s = NewBufferStore(L, p, c, 0);
+  s->n = i + n;
+  PushBuffer(L, s, i, n);
+}
+
+// unix.Buffer([capacity:int|data:str])
+//     └─→ unix.Buffer
+static int LuaUnixBuffer(lua_State *L) {
+  char *p;
+  size_t n, c;
+  const char *s;
+  if (lua_type(L, 1) == LUA_TSTRING) {
+    s = lua_tolstring(L, 1, &n);
+    c = MAX(64, n);
+  } else {
+    s = 0;
+    n = 0;
+    c = luaL_optinteger(L, 1, 0);
+    if (c > 0x7ffff000) {
+      luaL_argerror(L, 1, "capacity too big");
+      __builtin_unreachable();
+    }
+    c = MAX(64, c);
+  }
+  p = LuaAllocOrDie(L, c);
+  if (n)
+    memcpy(p, s, n);
+  LuaUnixPushBuffer(L, p, c, 0, n);
+  return 1;
+}
+
+// unix.mapbuffer(fd:int[, size:int[, offset:int]])
+//     ├─→ unix.Buffer
+//     └─→ nil, unix.Errno
+static int LuaUnixMapbuffer(lua_State *L) {
+  char *p;
+  int fd, olderr;
+  struct stat st;
+  size_t n, skew, pagesz;
+  lua_Integer size, offset;
+  olderr = errno;
+  fd = luaL_checkinteger(L, 1);
+  offset = luaL_optinteger(L, 3, 0);
+  if (offset < 0) {
+    luaL_argerror(L, 3, "offset is negative");
+    __builtin_unreachable();
+  }
+  if (lua_isnoneornil(L, 2)) {
+    if (fstat(fd, &st) == -1)
+      return LuaUnixSysretErrno(L, "fstat", olderr);
+    size = MAX(0, st.st_size - offset);
+  } else if ((size = luaL_checkinteger(L, 2)) < 0) {
+    luaL_argerror(L, 2, "size is negative");
+    __builtin_unreachable();
+  }
+  if (!size) {
+    LuaUnixPushBuffer(L, LuaAllocOrDie(L, 64), 64, 0, 0);
+    return 1;
+  }
+  pagesz = sysconf(_SC_PAGESIZE);
+  skew = offset & (pagesz - 1);
+  n = skew + size;
+  if ((p = mmap(0, n, PROT_READ, MAP_PRIVATE, fd, offset - skew)) ==
+      MAP_FAILED) {
+    return LuaUnixSysretErrno(L, "mmap", olderr);
+  }
+  PushBuffer(L, NewBufferStore(L, p, n, n), skew, size)->s->n = n;
+  return 1;
+}
+
+// unix.Buffer:append(data:str|unix.Buffer, ...)
+//     └─→ unix.Buffer
+static int LuaUnixBufferAppend(lua_State *L) {
+  char *p;
+  int i, n;
+  size_t m;
+  const char *s;
+  GetBuffer(L, 1);
+  for (n = lua_gettop(L), i = 2; i <= n; ++i) {
+    LuaUnixCheckBytes(L, i, &m);
+    p = LuaUnixBufferReserve(L, 1, m);
+    s = LuaUnixCheckBytes(L, i, &m);  // reserving may have moved a slice
+    memcpy(p, s, m);
+    LuaUnixBufferCommit(L, 1, m);
+  }
+  lua_settop(L, 1);
+  return 1;
+}
+
+// unix.Buffer:sub(i:int[, j:int])
+//     └─→ unix.Buffer
+static int LuaUnixBufferSub(lua_State *L) {
+  struct UnixBuffer *b;
+  lua_Integer i, j, n;
+  b = GetBuffer(L, 1);
+  n = b->n;
+  i = luaL_checkinteger(L, 2);
+  j = luaL_optinteger(L, 3, -1);
+  if (i < 0)
+    i = MAX(0, n + i + 1);
+  if (j < 0)
+    j = n + j + 1;
+  i = MAX(1, i);
+  j = MIN(n, j);
+  if (i > j) {
+    i = 1;
+    j = 0;
+  }
+  ++b->s->refs;
+  PushBuffer(L, b->s, b->i + i - 1, j - i + 1);
+  return 1;
+}
+
+// unix.Buffer:clear()
+//     └─→ unix.Buffer
+static int LuaUnixBufferClear(lua_State *L) {
+  struct UnixBuffer *b;
+  b = GetBuffer(L, 1);
+  if (b->s->refs == 1 && !b->s->mapsize) {
+    b->s->n = 0;
+    b->i = 0;
+  }
+  b->n = 0;
+  lua_settop(L, 1);
+  return 1;
+}
+
+// unix.Buffer:close()
+static int LuaUnixBufferClose(lua_State *L) {
+  struct UnixBuffer *b;
+  b = luaL_checkudata(L, 1, "unix.Buffer");
+  if (b->s) {
+    UnrefBufferStore(b->s);
+    b->s = 0;
+    b->n = 0;
+  }
+  return 0;
+}
+
+static int LuaUnixBufferLen(lua_State *L) {
+  lua_pushinteger(L, GetBuffer(L, 1)->n);
+  return 1;
+}
+
+static int LuaUnixBufferTostring(lua_State *L) {
+  struct UnixBuffer *b;
+  b = GetBuffer(L, 1);
+  lua_pushlstring(L, b->s->p + b->i, b->n);
+  return 1;
+}
+
+static int LuaUnixBufferRepr(lua_State *L) {
+  char s[128];
+  struct UnixBuffer *b;
+  b = luaL_checkudata(L, 1, "unix.Buffer");
+  snprintf(s, sizeof(s), "unix.Buffer(%zu)", b->n);
+  lua_pushstring(L, s);
+  return 1;
+}
+
+static const luaL_Reg kLuaUnixBufferMeth[] = {
+    {"append", LuaUnixBufferAppend},  //
+    {"sub", LuaUnixBufferSub},        //
+    {"clear", LuaUnixBufferClear},    //
+    {"close", LuaUnixBufferClose},    //
+    {0},                              //
+};
+
+static const luaL_Reg kLuaUnixBufferMeta[] = {
+    {"__len", LuaUnixBufferLen},            //
+    {"__tostring", LuaUnixBufferTostring},  //
+    {"__repr", LuaUnixBufferRepr},          //
+    {"__close", LuaUnixBufferClose},        //
+    {"__gc", LuaUnixBufferClose},           //
+    {0},                                    //
+};
+
+static void LuaUnixBufferObj(lua_State *L) {
+  luaL_newmetatable(L, "unix.Buffer");
+  luaL_setfuncs(L, kLuaUnixBufferMeta, 0);
+  luaL_newlibtable(L, kLuaUnixBufferMeth);
+  luaL_setfuncs(L, kLuaUnixBufferMeth, 0);
+  lua_setfield(L, -2, "__index");
+  lua_pop(L, 1);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // unix.Sigset object
 
@@ -3567,6 +3922,387 @@ static void LuaUnixDirObj(lua_State *L) {
   lua_pop(L, 1);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// unix.Scheduler object
+
+struct LuaUnixTask {
+  lua_State *co;     // coroutine, or null once finished
+  int ref;           // registry reference keeping `co` alive
+  int fd;            // descriptor being waited upon, or -1
+  short events;      // poll() events wanted for `fd`
+  bool ready;        // resume on next iteration of run loop
+  int nargs;         // values pushed on `co` for next resume
+  int64_t deadline;  // monotonic nanos when to give up waiting, or 0
+};
+
+struct LuaUnixScheduler {
+  int cur;  // index of task being resumed, or -1
+  size_t n, c;
+  struct LuaUnixTask *p;
+};
+
+static struct LuaUnixScheduler *GetUnixSchedulerSelf(lua_State *L) {
+  return luaL_checkudata(L, 1, "unix.Scheduler");
+}
+
+static struct LuaUnixTask *GetCurrentTaskOrDie(lua_State *L) {
+  struct LuaUnixScheduler *s;
+  s = GetUnixSchedulerSelf(L);
+  if (s->cur != -1 && s->p[s->cur].co == L) return s->p + s->cur;
+  luaL_error(L, "must be called from a task of this unix.Scheduler");
+  __builtin_unreachable();
+}
+
+static int64_t GetSchedulerDeadline(lua_Integer millis) {
+  return timespec_tonanos(timespec_mono()) + MAX(0, millis) * 1000000;
+}
+
+static void WakeTask(struct LuaUnixTask *t, int revents) {
+  t->fd = -1;
+  t->ready = true;
+  t->deadline = 0;
+  lua_pushinteger(t->co, revents);
+  t->nargs = 1;
+}
+
+static void RemoveFinishedTasks(lua_State *L, struct LuaUnixScheduler *s) {
+  size_t i, j;
+  for (i = j = 0; i < s->n; ++i) {
+    if (s->p[i].co) {
+      s->p[j++] = s->p[i];
+    } else {
+      luaL_unref(L, LUA_REGISTRYINDEX, s->p[i].ref);
+    }
+  }
+  s->n = j;
+}
+
+static int SchedulerWaitForFd(lua_State *L, int fd, int events,
+                              lua_KContext ctx, lua_KFunction k) {
+  struct LuaUnixTask *t;
+  t = GetCurrentTaskOrDie(L);
+  t->fd = fd;
+  t->events = events;
+  return lua_yieldk(L, 0, ctx, k);
+}
+
+static int ReturnNothing(lua_State *L, int status, lua_KContext ctx) {
+  return 0;
+}
+
+static int ReturnRevents(lua_State *L, int status, lua_KContext ctx) {
+  return 1;
+}
+
+// unix.scheduler()
+//     └─→ unix.Scheduler
+static int LuaUnixScheduler(lua_State *L) {
+  struct LuaUnixScheduler *s;
+  s = lua_newuserdatauv(L, sizeof(*s), 0);
+  luaL_setmetatable(L, "unix.Scheduler");
+  bzero(s, sizeof(*s));
+  s->cur = -1;
+  return 1;
+}
+
+// unix.Scheduler:spawn(func:function, ...)
+//     └─→ co:thread
+static int LuaUnixSchedulerSpawn(lua_State *L) {
+  int i, n;
+  lua_State *co;
+  struct LuaUnixTask *p;
+  struct LuaUnixScheduler *s;
+  s = GetUnixSchedulerSelf(L);
+  luaL_checktype(L, 2, LUA_TFUNCTION);
+  n = lua_gettop(L);
+  if (s->n == s->c) {
+    if (!(p = realloc(s->p, (s->c + (s->c >> 1) + 8) * sizeof(*p)))) {
+      luaL_error(L, "out of memory");
+      __builtin_unreachable();
+    }
+    s->p = p;
+    s->c += (s->c >> 1) + 8;
+  }
+  co = lua_newthread(L);
+  for (i = 2; i <= n; ++i) {
+    lua_pushvalue(L, i);
+  }
+  lua_xmove(L, co, n - 1);
+  lua_pushvalue(L, -1);
+  p = s->p + s->n++;
+  p->co = co;
+  p->ref = luaL_ref(L, LUA_REGISTRYINDEX);
+  p->fd = -1;
+  p->events = 0;
+  p->ready = true;
+  p->nargs = n - 2;
+  p->deadline = 0;
+  return 1;
+}
+
+// unix.Scheduler:wait(fd:int, events:int[, timeoutms:int])
+//     └─→ revents:int
+static int LuaUnixSchedulerWait(lua_State *L) {
+  int fd, events;
+  struct LuaUnixTask *t;
+  fd = luaL_checkinteger(L, 2);
+  events = luaL_checkinteger(L, 3);
+  t = GetCurrentTaskOrDie(L);
+  if (!lua_isnoneornil(L, 4)) {
+    t->deadline = GetSchedulerDeadline(luaL_checkinteger(L, 4));
+  }
+  return SchedulerWaitForFd(L, fd, events, 0, ReturnRevents);
+}
+
+// unix.Scheduler:sleep(millis:int)
+static int LuaUnixSchedulerSleep(lua_State *L) {
+  struct LuaUnixTask *t;
+  lua_Integer millis;
+  millis = luaL_checkinteger(L, 2);
+  t = GetCurrentTaskOrDie(L);
+  t->deadline = GetSchedulerDeadline(millis);
+  return lua_yieldk(L, 0, 0, ReturnNothing);
+}
+
+// unix.Scheduler:yield()
+static int LuaUnixSchedulerYield(lua_State *L) {
+  GetCurrentTaskOrDie(L)->ready = true;
+  return lua_yieldk(L, 0, 0, ReturnNothing);
+}
+
+static int SchedulerRead(lua_State *L, int status, lua_KContext ctx) {
+  char *buf;
+  ssize_t rc;
+  int fd, olderr;
+  lua_Integer bufsiz;
+  lua_settop(L, 3);
+  olderr = errno;
+  fd = luaL_checkinteger(L, 2);
+  bufsiz = luaL_optinteger(L, 3, BUFSIZ);
+  bufsiz = MIN(bufsiz, 0x7ffff000);
+  buf = LuaAllocOrDie(L, bufsiz);
+  rc = read(fd, buf, bufsiz);
+  if (rc != -1) {
+    lua_pushlstring(L, buf, rc);
+    free(buf);
+    return 1;
+  }
+  free(buf);
+  if (errno == EAGAIN) {
+    errno = olderr;
+    return SchedulerWaitForFd(L, fd, POLLIN, 0, SchedulerRead);
+  }
+  return LuaUnixSysretErrno(L, "read", olderr);
+}
+
+// unix.Scheduler:read(fd:int[, bufsiz:int])
+//     ├─→ data:str
+//     └─→ nil, unix.Errno
+static int LuaUnixSchedulerRead(lua_State *L) {
+  return SchedulerRead(L, LUA_OK, 0);
+}
+
+static int SchedulerWrite(lua_State *L, int status, lua_KContext ctx) {
+  ssize_t rc;
+  int fd, olderr;
+  size_t size, wrote;
+  const char *data;
+  lua_settop(L, 3);
+  olderr = errno;
+  fd = luaL_checkinteger(L, 2);
+  data = luaL_checklstring(L, 3, &size);
+  for (wrote = ctx; wrote < size; wrote += rc) {
+    if ((rc = write(fd, data + wrote, size - wrote)) == -1) {
+      if (errno == EAGAIN) {
+        errno = olderr;
+        return SchedulerWaitForFd(L, fd, POLLOUT, wrote, SchedulerWrite);
+      }
+      return LuaUnixSysretErrno(L, "write", olderr);
+    }
+  }
+  lua_pushinteger(L, wrote);
+  return 1;
+}
+
+// unix.Scheduler:write(fd:int, data:str)
+//     ├─→ wrotebytes:int
+//     └─→ nil, unix.Errno
+static int LuaUnixSchedulerWrite(lua_State *L) {
+  return SchedulerWrite(L, LUA_OK, 0);
+}
+
+static int SchedulerAccept(lua_State *L, int status, lua_KContext ctx) {
+  uint32_t addrsize;
+  struct sockaddr_storage ss;
+  int clientfd, serverfd, olderr, flags;
+  lua_settop(L, 3);
+  olderr = errno;
+  addrsize = sizeof(ss);
+  serverfd = luaL_checkinteger(L, 2);
+  flags = luaL_optinteger(L, 3, 0);
+  clientfd = accept4(serverfd, (struct sockaddr *)&ss, &addrsize, flags);
+  if (clientfd != -1) {
+    lua_pushinteger(L, clientfd);
+    return 1 + PushSockaddr(L, &ss);
+  }
+  if (errno == EAGAIN) {
+    errno = olderr;
+    return SchedulerWaitForFd(L, serverfd, POLLIN, 0, SchedulerAccept);
+  }
+  return LuaUnixSysretErrno(L, "accept", olderr);
+}
+
+// unix.Scheduler:accept(serverfd:int[, flags:int])
+//     ├─→ clientfd:int, ip:uint32, port:uint16
+//     ├─→ clientfd:int, unixpath:str
+//     └─→ nil, unix.Errno
+static int LuaUnixSchedulerAccept(lua_State *L) {
+  return SchedulerAccept(L, LUA_OK, 0);
+}
+
+static void ResumeTask(lua_State *L, struct LuaUnixScheduler *s, size_t i) {
+  lua_State *co;
+  int status, nargs, nres;
+  co = s->p[i].co;
+  nargs = s->p[i].nargs;
+  s->p[i].ready = false;
+  s->p[i].nargs = 0;
+  s->cur = i;
+  status = lua_resume(co, L, nargs, &nres);
+  s->cur = -1;
+  if (status == LUA_YIELD) {
+    lua_pop(co, nres);
+    if (s->p[i].fd == -1 && !s->p[i].deadline) {
+      // task called coroutine.yield() rather than a scheduler method
+      s->p[i].ready = true;
+    }
+  } else if (status == LUA_OK) {
+    s->p[i].co = 0;
+  } else {
+    lua_xmove(co, L, 1);
+    s->p[i].co = 0;
+    RemoveFinishedTasks(L, s);
+    lua_error(L);
+  }
+}
+
+// unix.Scheduler:run()
+//     ├─→ true
+//     └─→ nil, unix.Errno
+static int LuaUnixSchedulerRun(lua_State *L) {
+  size_t i, j, n;
+  int64_t now, wait;
+  struct pollfd *fds;
+  struct timespec ts;
+  struct LuaUnixTask *t;
+  struct LuaUnixScheduler *s;
+  int olderr = errno;
+  s = GetUnixSchedulerSelf(L);
+  if (s->cur != -1) {
+    luaL_error(L, "unix.Scheduler is already running");
+  }
+  while (s->n) {
+    wait = -1;
+    now = timespec_tonanos(timespec_mono());
+    for (n = i = 0; i < s->n; ++i) {
+      t = s->p + i;
+      if (t->ready) {
+        wait = 0;
+      } else {
+        n += t->fd != -1;
+        if (t->deadline && (wait == -1 || t->deadline - now < wait)) {
+          wait = MAX(0, t->deadline - now);
+        }
+      }
+    }
+    fds = LuaAllocOrDie(L, (n + 1) * sizeof(*fds));
+    for (j = i = 0; i < s->n; ++i) {
+      t = s->p + i;
+      if (!t->ready && t->fd != -1) {
+        fds[j].fd = t->fd;
+        fds[j].events = t->events;
+        fds[j].revents = 0;
+        ++j;
+      }
+    }
+    ts = timespec_fromnanos(wait);
+    if (ppoll(fds, n, wait == -1 ? 0 : &ts, 0) == -1) {
+      if (errno != EINTR) {
+        free(fds);
+        return LuaUnixSysretErrno(L, "poll", olderr);
+      }
+      errno = olderr;
+      n = 0;
+    }
+    now = timespec_tonanos(timespec_mono());
+    for (j = i = 0; i < s->n; ++i) {
+      t = s->p + i;
+      if (t->ready) continue;
+      if (t->fd != -1 && j < n && fds[j++].revents) {
+        WakeTask(t, fds[j - 1].revents);
+      } else if (t->deadline && now >= t->deadline) {
+        WakeTask(t, 0);
+      }
+    }
+    free(fds);
+    for (n = s->n, i = 0; i < n; ++i) {
+      if (s->p[i].ready) {
+        ResumeTask(L, s, i);
+      }
+    }
+    RemoveFinishedTasks(L, s);
+  }
+  lua_pushboolean(L, true);
+  return 1;
+}
+
+// unix.Scheduler:count()
+//     └─→ tasks:int
+static int LuaUnixSchedulerCount(lua_State *L) {
+  lua_pushinteger(L, GetUnixSchedulerSelf(L)->n);
+  return 1;
+}
+
+static int LuaUnixSchedulerGc(lua_State *L) {
+  size_t i;
+  struct LuaUnixScheduler *s;
+  s = GetUnixSchedulerSelf(L);
+  for (i = 0; i < s->n; ++i) {
+    luaL_unref(L, LUA_REGISTRYINDEX, s->p[i].ref);
+  }
+  free(s->p);
+  bzero(s, sizeof(*s));
+  s->cur = -1;
+  return 0;
+}
+
+static const luaL_Reg kLuaUnixSchedulerMeth[] = {
+    {"accept", LuaUnixSchedulerAccept},  //
+    {"count", LuaUnixSchedulerCount},    //
+    {"read", LuaUnixSchedulerRead},      //
+    {"run", LuaUnixSchedulerRun},        //
+    {"sleep", LuaUnixSchedulerSleep},    //
+    {"spawn", LuaUnixSchedulerSpawn},    //
+    {"wait", LuaUnixSchedulerWait},      //
+    {"write", LuaUnixSchedulerWrite},    //
+    {"yield", LuaUnixSchedulerYield},    //
+    {0},                                 //
+};
+
+static const luaL_Reg kLuaUnixSchedulerMeta[] = {
+    {"__gc", LuaUnixSchedulerGc},  //
+    {0},                           //
+};
+
+static void LuaUnixSchedulerObj(lua_State *L) {
+  luaL_newmetatable(L, "unix.Scheduler");
+  luaL_setfuncs(L, kLuaUnixSchedulerMeta, 0);
+  luaL_newlibtable(L, kLuaUnixSchedulerMeth);
+  luaL_setfuncs(L, kLuaUnixSchedulerMeth, 0);
+  lua_setfield(L, -2, "__index");
+  lua_pop(L, 1);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // UNIX module
 
@@ -3578,6 +4314,7 @@ static const luaL_Reg kLuaUnix[] = {
     {"S_ISLNK", LuaUnixSislnk},           // is st:mode() a symbolic link?
     {"S_ISREG", LuaUnixSisreg},           // is st:mode() a regular file?
     {"S_ISSOCK", LuaUnixSissock},         // is st:mode() a socket?
+    {"Buffer", LuaUnixBuffer},            // creates mutable byte buffer
     {"Sigset", LuaUnixSigset},            // creates signal bitmask
     {"WEXITSTATUS", LuaUnixWexitstatus},  // gets exit status from wait status
     {"WIFEXITED", LuaUnixWifexited},      // gets exit code from wait status
@@ -3640,6 +4377,7 @@ static const luaL_Reg kLuaUnix[] = {
     {"lseek", LuaUnixLseek},              // seek in file
     {"major", LuaUnixMajor},              // extract device info
     {"makedirs", LuaUnixMakedirs},        // make directory and parents too
+    {"mapbuffer", LuaUnixMapbuffer},      // mmap(MAP_PRIVATE) file as buffer
     {"mapshared", LuaUnixMapshared},      // mmap(MAP_SHARED) w/ mutex+atomics
     {"minor", LuaUnixMinor},              // extract device info
     {"mkdir", LuaUnixMkdir},              // make directory
@@ -3662,6 +4400,7 @@ static const luaL_Reg kLuaUnix[] = {
     {"rmdir", LuaUnixRmdir},              // remove empty directory
     {"rmrf", LuaUnixRmrf},                // remove file recursively
     {"sched_yield", LuaUnixSchedYield},   // relinquish scheduled quantum
+    {"scheduler", LuaUnixScheduler},      // cooperative coroutine scheduler
     {"send", LuaUnixSend},                // send tcp to some address
     {"sendto", LuaUnixSendto},            // send udp to some address
     {"setenv", LuaUnixSetenv},            // set environment variable
@@ -3726,9 +4465,11 @@ int LuaUnix(lua_State *L) {
   LuaUnixRusageObj(L);
   LuaUnixStatfsObj(L);
   LuaUnixMemoryObj(L);
+  LuaUnixBufferObj(L);
   LuaUnixErrnoObj(L);
   LuaUnixStatObj(L);
   LuaUnixDirObj(L);
+  LuaUnixSchedulerObj(L);
   lua_newtable(L);
   lua_setglobal(L, "__signal_handlers");
 
@@ -11,6 +11,12 @@ struct UnixErrno {
 
 int LuaUnix(lua_State *);
 int LuaUnixSysretErrno(lua_State *, const char *, int);
+bool LuaUnixIsBuffer(lua_State *, int);
+const char *LuaUnixCheckBytes(lua_State *, int, size_t *);
+const char *LuaUnixOptBytes(lua_State *, int, const char *, size_t *);
+char *LuaUnixBufferReserve(lua_State *, int, size_t);
+void LuaUnixBufferCommit(lua_State *, int, size_t);
+void LuaUnixPushBuffer(lua_State *, char *, size_t, size_t, size_t);
 
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_THIRD_PARTY_LUA_LUNIX_H_ */
@@ -10,12 +10,16 @@
 # SEE ALSO
 #
 #   libc/nexgen32e/lz4cpy.c
+#   third_party/lz4cli/lz4stream.h
 
 PKGS += THIRD_PARTY_LZ4CLI
 
 THIRD_PARTY_LZ4CLI_ARTIFACTS += THIRD_PARTY_LZ4CLI_A
 THIRD_PARTY_LZ4CLI_A = o/$(MODE)/third_party/lz4cli/lz4.a
-THIRD_PARTY_LZ4CLI_A_OBJS = o/$(MODE)/third_party/lz4cli/lz4.o
+THIRD_PARTY_LZ4CLI_A_OBJS =				\
+	o/$(MODE)/third_party/lz4cli/lz4.o		\
+	o/$(MODE)/third_party/lz4cli/lz4stream.o	\
+	o/$(MODE)/third_party/lz4cli/xxhash.o
 THIRD_PARTY_LZ4CLI = $(THIRD_PARTY_LZ4CLI_A_DEPS) $(THIRD_PARTY_LZ4CLI_A)
 
 THIRD_PARTY_LZ4CLI_FILES := $(wildcard third_party/lz4cli/*)
@@ -44,9 +48,12 @@ o/$(MODE)/third_party/lz4cli/datagen.o: private		\
 		-DSTACK_FRAME_UNLIMITED
 
 THIRD_PARTY_LZ4CLI_A_DIRECTDEPS =			\
+	LIBC_CALLS					\
 	LIBC_INTRIN					\
 	LIBC_MEM					\
-	LIBC_STR
+	LIBC_STR					\
+	LIBC_SYSV					\
+	LIBC_THREAD
 
 THIRD_PARTY_LZ4CLI_A_DEPS :=				\
 	$(call uniq,$(foreach x,$(THIRD_PARTY_LZ4CLI_A_DIRECTDEPS),$($(x))))
@@ -0,0 +1,485 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "third_party/lz4cli/lz4stream.h"
+#include "libc/calls/calls.h"
+#include "libc/calls/struct/iovec.h"
+#include "libc/cosmo.h"
+#include "libc/errno.h"
+#include "libc/macros.h"
+#include "libc/mem/mem.h"
+#include "libc/nexgen32e/lz4.h"
+#include "libc/serialize.h"
+#include "libc/str/str.h"
+#include "libc/sysv/errfuns.h"
+#include "third_party/lz4cli/lz4.h"
+#include "third_party/lz4cli/xxhash.h"
+
+/**
+ * @fileoverview LZ4 frame streams.
+ *
+ * The writer emits frames whose blocks are independent and carry no
+ * checksums, so each batch of blocks can be compressed in parallel
+ * and written out in order. The reader accepts anything the reference
+ * lz4 command produces, i.e. linked blocks, block checksums, content
+ * checksums, skippable frames and concatenated frames. Only frames
+ * which need an external dictionary aren't supported.
+ *
+ * Unlike lz4decode() the reader is safe to use on untrusted input.
+ */
+
+#define LZ4_DICTSIZE 65536
+
+struct Lz4Block {
+  size_t n;   // bytes of input
+  int z;      // bytes of output, or -1 if stored uncompressed
+  char *src;  // holds blocksize bytes
+  char *dst;  // holds LZ4_compressBound(blocksize) bytes
+};
+
+struct Lz4Writer {
+  int fd;
+  int bd;      // LZ4_BLOCKMAXSIZE_xxx
+  int count;   // number of blocks buffered per batch
+  int full;    // number of blocks which are full
+  bool began;  // frame descriptor was written
+  size_t blocksize;
+  struct CosmoTaskPool *pool;
+  struct Lz4Block *blocks;
+  struct iovec *iov;
+};
+
+struct Lz4Reader {
+  int fd;
+  int flg;  // flags of current frame, or -1 if between frames
+  size_t blocksize;
+  size_t bufsize;
+  size_t i, n;  // unread output is out[i..n)
+  char *in;
+  char *out;
+  XXH32_state_t *xxh;
+  size_t dictlen;
+  char dict[LZ4_DICTSIZE];  // last 64kb of output for linked blocks
+};
+
+static size_t lz4_blocksize(int bd) {
+  return (size_t)1 << (bd * 2 + 8);
+}
+
+static ssize_t lz4_read_all(int fd, void *buf, size_t size) {
+  ssize_t rc;
+  size_t got;
+  for (got = 0; got < size; got += rc) {
+    if ((rc = read(fd, (char *)buf + got, size - got)) == -1) {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+    if (!rc)
+      break;
+  }
+  return got;
+}
+
+// reads exactly size bytes, treating eof as a malformed stream
+static int lz4_read_exact(int fd, void *buf, size_t size) {
+  ssize_t rc;
+  if ((rc = lz4_read_all(fd, buf, size)) == -1)
+    return -1;
+  if (rc != size)
+    return ebadmsg();
+  return 0;
+}
+
+static int lz4_writev_all(int fd, struct iovec *iov, int n) {
+  ssize_t rc;
+  while (n) {
+    if ((rc = writev(fd, iov, MIN(n, 512))) == -1) {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+    for (; n && rc >= iov->iov_len; --n, ++iov)
+      rc -= iov->iov_len;
+    if (n) {
+      iov->iov_base = (char *)iov->iov_base + rc;
+      iov->iov_len -= rc;
+    }
+  }
+  return 0;
+}
+
+static void lz4writer_compress(long i, long j, void *arg) {
+  struct Lz4Block *b, *blocks = arg;
+  for (; i < j; ++i) {
+    b = blocks + i;
+    b->z = LZ4_compress_default(b->src, b->dst, b->n, LZ4_compressBound(b->n));
+    if (b->z <= 0 || b->z >= b->n)
+      b->z = -1;
+  }
+}
+
+// compresses first n blocks and writes them out
+static int lz4writer_drain(struct Lz4Writer *w, int n) {
+  int i, m;
+  struct Lz4Block *b;
+  unsigned char words[256 + 4][4];
+  unsigned char *p, hdr[7];
+  if (w->pool && n > 1) {
+    cosmo_parallel_for(w->pool, 0, n, 1, lz4writer_compress, w->blocks);
+  } else {
+    lz4writer_compress(0, n, w->blocks);
+  }
+  m = 0;
+  if (!w->began) {
+    WRITE32LE(hdr, LZ4_MAGICNUMBER);
+    hdr[4] = 1 << 6 | 1 << 5;  // version 1 with independent blocks
+    hdr[5] = w->bd << 4;
+    hdr[6] = XXH32(hdr + 4, 2, 0) >> 8;
+    w->iov[m++] = (struct iovec){hdr, sizeof(hdr)};
+    w->began = true;
+  }
+  for (i = 0; i < n; ++i) {
+    b = w->blocks + i;
+    p = words[i];
+    if (b->z == -1) {
+      WRITE32LE(p, b->n | 0x80000000);
+      w->iov[m++] = (struct iovec){p, 4};
+      w->iov[m++] = (struct iovec){b->src, b->n};
+    } else {
+      WRITE32LE(p, b->z);
+      w->iov[m++] = (struct iovec){p, 4};
+      w->iov[m++] = (struct iovec){b->dst, b->z};
+    }
+    b->n = 0;
+  }
+  w->full = 0;
+  return lz4_writev_all(w->fd, w->iov, m);
+}
+
+static void lz4writer_free(struct Lz4Writer *w) {
+  int i;
+  cosmo_taskpool_free(w->pool);
+  if (w->blocks) {
+    for (i = 0; i < w->count; ++i) {
+      free(w->blocks[i].src);
+      free(w->blocks[i].dst);
+    }
+  }
+  free(w->blocks);
+  free(w->iov);
+  free(w);
+}
+
+/**
+ * Creates LZ4 frame encoder.
+ *
+ * Data is buffered until a batch of `threads` blocks is full, at which
+ * point the blocks are compressed concurrently and written in order.
+ * Each block in the batch costs about twice the block size in memory.
+ *
+ * @param fd is file descriptor to which frame gets written, which is
+ *     owned by the caller and isn't closed by lz4writer_close()
+ * @param bd is one of LZ4_BLOCKMAXSIZE_64KB, LZ4_BLOCKMAXSIZE_256KB,
+ *     LZ4_BLOCKMAXSIZE_1MB, or LZ4_BLOCKMAXSIZE_4MB
+ * @param threads is number of blocks to compress at once, where 1 means
+ *     compress on the calling thread, and 0 means cosmo_cpu_count()
+ * @return new writer, or null w/ errno
+ * @raise EINVAL if `bd` or `threads` is invalid
+ */
+struct Lz4Writer *lz4writer_open(int fd, int bd, int threads) {
+  int i;
+  struct Lz4Writer *w;
+  if (bd < LZ4_BLOCKMAXSIZE_64KB || bd > LZ4_BLOCKMAXSIZE_4MB ||
+      threads < 0) {
+    einval();
+    return 0;
+  }
+  if (!threads)
+    threads = cosmo_cpu_count();
+  threads = MIN(MAX(threads, 1), 256);
+  if (!(w = calloc(1, sizeof(*w))))
+    return 0;
+  w->fd = fd;
+  w->bd = bd;
+  w->count = threads;
+  w->blocksize = lz4_blocksize(bd);
+  if (!(w->blocks = calloc(threads, sizeof(*w->blocks))) ||
+      !(w->iov = calloc(threads * 2 + 1, sizeof(*w->iov))))
+    goto Failure;
+  for (i = 0; i < threads; ++i)
+    if (!(w->blocks[i].src = malloc(w->blocksize)) ||
+        !(w->blocks[i].dst = malloc(LZ4_compressBound(w->blocksize))))
+      goto Failure;
+  if (threads > 1 && !(w->pool = cosmo_taskpool_new(threads)))
+    goto Failure;
+  return w;
+Failure:
+  lz4writer_free(w);
+  return 0;
+}
+
+/**
+ * Appends data to LZ4 frame.
+ *
+ * @return `size` on success, or -1 w/ errno if a batch of blocks
+ *     couldn't be written, in which case the frame is incomplete
+ */
+ssize_t lz4writer_write(struct Lz4Writer *w, const void *data, size_t size) {
+  size_t i, m;
+  struct Lz4Block *b;
+  for (i = 0; i < size; i += m) {
+    b = w->blocks + w->full;
+    m = MIN(size - i, w->blocksize - b->n);
+    memcpy(b->src + b->n, (const char *)data + i, m);
+    if ((b->n += m) == w->blocksize && ++w->full == w->count)
+      if (lz4writer_drain(w, w->full) == -1)
+        return -1;
+  }
+  return size;
+}
+
+/**
+ * Writes buffered data, ending the current block early.
+ *
+ * This is useful when shipping logs, since it makes everything that's
+ * been written so far decodable by a reader on the other end.
+ *
+ * @return 0 on success, or -1 w/ errno
+ */
+int lz4writer_flush(struct Lz4Writer *w) {
+  int n = w->full + !!w->blocks[w->full].n;
+  if (!n && w->began)
+    return 0;
+  return lz4writer_drain(w, n);
+}
+
+/**
+ * Finishes LZ4 frame and frees writer.
+ *
+ * @return 0 on success, or -1 w/ errno
+ */
+int lz4writer_close(struct Lz4Writer *w) {
+  int rc = 0;
+  static const unsigned char kEndMark[4];
+  if (!w)
+    return 0;
+  if (lz4writer_flush(w) == -1 ||
+      lz4_writev_all(w->fd, &(struct iovec){(void *)kEndMark, 4}, 1) == -1)
+    rc = -1;
+  lz4writer_free(w);
+  return rc;
+}
+
+/**
+ * Creates LZ4 frame decoder.
+ *
+ * @param fd is file descriptor from which frames are read, which is
+ *     owned by the caller and isn't closed by lz4reader_close()
+ * @return new reader, or null w/ errno
+ */
+struct Lz4Reader *lz4reader_open(int fd) {
+  struct Lz4Reader *r;
+  if (!(r = malloc(sizeof(*r))))
+    return 0;
+  bzero(r, offsetof(struct Lz4Reader, dict));
+  r->fd = fd;
+  r->flg = -1;
+  if (!(r->xxh = XXH32_createState())) {
+    free(r);
+    enomem();
+    return 0;
+  }
+  return r;
+}
+
+static int lz4reader_skip(struct Lz4Reader *r, size_t size) {
+  ssize_t rc;
+  char buf[512];
+  for (; size; size -= rc) {
+    if ((rc = lz4_read_all(r->fd, buf, MIN(size, sizeof(buf)))) == -1)
+      return -1;
+    if (!rc)
+      return ebadmsg();
+  }
+  return 0;
+}
+
+// reads next frame descriptor, returning 1 on success or 0 on eof
+static int lz4reader_frame(struct Lz4Reader *r) {
+  ssize_t rc;
+  uint32_t magic;
+  size_t n, blocksize;
+  char *in, *out;
+  unsigned char hdr[4 + 2 + 8 + 4 + 1];
+  for (;;) {
+    if ((rc = lz4_read_all(r->fd, hdr, 4)) == -1)
+      return -1;
+    if (!rc)
+      return 0;
+    if (rc != 4)
+      return ebadmsg();
+    magic = LZ4_MAGIC(hdr);
+    if ((magic & LZ4_SKIPPABLEMASK) == LZ4_SKIPPABLE0) {
+      if (lz4_read_exact(r->fd, hdr, 4) == -1 ||
+          lz4reader_skip(r, READ32LE(hdr)) == -1)
+        return -1;
+      continue;
+    }
+    if (magic != LZ4_MAGICNUMBER)
+      return ebadmsg();
+    if (lz4_read_exact(r->fd, hdr + 4, 2) == -1)
+      return -1;
+    if (LZ4_FRAME_VERSION(hdr) != 1 || LZ4_FRAME_RESERVED1(hdr) ||
+        LZ4_FRAME_RESERVED2(hdr) || LZ4_FRAME_RESERVED3(hdr) ||
+        LZ4_FRAME_BLOCKMAXSIZE(hdr) < LZ4_BLOCKMAXSIZE_64KB)
+      return ebadmsg();
+    if (LZ4_FRAME_DICTIONARYIDFLAG(hdr))
+      return enotsup();
+    n = LZ4_FRAME_HEADERSIZE(hdr);
+    if (lz4_read_exact(r->fd, hdr + 6, n - 6) == -1)
+      return -1;
+    if (hdr[n - 1] != (unsigned char)(XXH32(hdr + 4, n - 5, 0) >> 8))
+      return ebadmsg();
+    blocksize = lz4_blocksize(LZ4_FRAME_BLOCKMAXSIZE(hdr));
+    if (blocksize > r->bufsize) {
+      if (!(in = realloc(r->in, blocksize)))
+        return -1;
+      r->in = in;
+      if (!(out = realloc(r->out, blocksize)))
+        return -1;
+      r->out = out;
+      r->bufsize = blocksize;
+    }
+    r->blocksize = blocksize;
+    r->flg = hdr[4];
+    r->dictlen = 0;
+    XXH32_reset(r->xxh, 0);
+    return 1;
+  }
+}
+
+// keeps last 64kb of output around, since linked blocks refer to it
+static void lz4reader_remember(struct Lz4Reader *r, const char *p, size_t n) {
+  size_t keep;
+  if (n >= LZ4_DICTSIZE) {
+    memcpy(r->dict, p + n - LZ4_DICTSIZE, LZ4_DICTSIZE);
+    r->dictlen = LZ4_DICTSIZE;
+  } else {
+    keep = MIN(r->dictlen, LZ4_DICTSIZE - n);
+    memmove(r->dict, r->dict + r->dictlen - keep, keep);
+    memcpy(r->dict + keep, p, n);
+    r->dictlen = keep + n;
+  }
+}
+
+// decodes next block, returning 1 on success or 0 on eof
+static int lz4reader_block(struct Lz4Reader *r) {
+  int rc, m;
+  bool stored;
+  uint32_t size;
+  unsigned char word[4];
+  for (;;) {
+    if (r->flg == -1 && (rc = lz4reader_frame(r)) <= 0)
+      return rc;
+    if (lz4_read_exact(r->fd, word, 4) == -1)
+      return -1;
+    if (!(size = READ32LE(word))) {
+      if ((r->flg >> 2) & 1) {
+        if (lz4_read_exact(r->fd, word, 4) == -1)
+          return -1;
+        if (READ32LE(word) != XXH32_digest(r->xxh))
+          return ebadmsg();
+      }
+      r->flg = -1;
+      continue;
+    }
+    stored = size >> 31;
+    size &= 0x7fffffff;
+    if (size > r->blocksize)
+      return ebadmsg();
+    if (lz4_read_exact(r->fd, stored ? r->out : r->in, size) == -1)
+      return -1;
+    if ((r->flg >> 4) & 1) {
+      if (lz4_read_exact(r->fd, word, 4) == -1)
+        return -1;
+      if (READ32LE(word) != XXH32(stored ? r->out : r->in, size, 0))
+        return ebadmsg();
+    }
+    if (stored) {
+      m = size;
+    } else if ((r->flg >> 5) & 1) {
+      m = LZ4_decompress_safe(r->in, r->out, size, r->blocksize);
+    } else {
+      m = LZ4_decompress_safe_usingDict(r->in, r->out, size, r->blocksize,
+                                        r->dict, r->dictlen);
+    }
+    if (m < 0)
+      return ebadmsg();
+    if (!((r->flg >> 5) & 1))
+      lz4reader_remember(r, r->out, m);
+    if ((r->flg >> 2) & 1)
+      XXH32_update(r->xxh, r->out, m);
+    r->i = 0;
+    r->n = m;
+    if (m)
+      return 1;
+  }
+}
+
+/**
+ * Reads decompressed data from LZ4 frames.
+ *
+ * Frames that are concatenated are decoded as one stream. This returns
+ * short counts once some data has been copied and the current block is
+ * exhausted, so that readers on pipes won't block needlessly.
+ *
+ * @return bytes read, 0 on eof, or -1 w/ errno
+ * @raise EBADMSG if stream is corrupted or truncated
+ * @raise ENOTSUP if frame needs an external dictionary
+ */
+ssize_t lz4reader_read(struct Lz4Reader *r, void *buf, size_t size) {
+  int rc;
+  size_t m, got;
+  for (got = 0; got < size; got += m) {
+    if (r->i == r->n) {
+      if (got)
+        break;
+      if ((rc = lz4reader_block(r)) == -1)
+        return -1;
+      if (!rc)
+        break;
+    }
+    m = MIN(size - got, r->n - r->i);
+    memcpy((char *)buf + got, r->out + r->i, m);
+    r->i += m;
+  }
+  return got;
+}
+
+/**
+ * Frees LZ4 frame decoder.
+ */
+void lz4reader_close(struct Lz4Reader *r) {
+  if (!r)
+    return;
+  XXH32_freeState(r->xxh);
+  free(r->out);
+  free(r->in);
+  free(r);
+}
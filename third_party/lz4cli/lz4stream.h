@@ -0,0 +1,18 @@
+#ifndef COSMOPOLITAN_THIRD_PARTY_LZ4CLI_LZ4STREAM_H_
+#define COSMOPOLITAN_THIRD_PARTY_LZ4CLI_LZ4STREAM_H_
+COSMOPOLITAN_C_START_
+
+struct Lz4Reader;
+struct Lz4Writer;
+
+struct Lz4Writer *lz4writer_open(int, int, int);
+ssize_t lz4writer_write(struct Lz4Writer *, const void *, size_t);
+int lz4writer_flush(struct Lz4Writer *);
+int lz4writer_close(struct Lz4Writer *);
+
+struct Lz4Reader *lz4reader_open(int);
+ssize_t lz4reader_read(struct Lz4Reader *, void *, size_t);
+void lz4reader_close(struct Lz4Reader *);
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_THIRD_PARTY_LZ4CLI_LZ4STREAM_H_ */
@@ -65,6 +65,8 @@ struct file
                                            has been performed.  */
     FILE_TIMESTAMP touched;     /* Set if file was created in order for
                                    Landlock LSM to sandbox it.  */
+    unsigned long duration;     /* Microseconds it last took to build.  */
+    unsigned long weight;       /* Microseconds on its critical path.  */
     unsigned int considered;    /* equal to 'considered' if file has been
                                    considered on current scan of goal chain */
     int command_flags;          /* Flags OR'd in for cmds; see commands.h.  */
@@ -113,6 +115,8 @@ struct file
                                    diagnostics has been issued (dontcare). */
     unsigned int was_shuffled:1; /* Did we already shuffle 'deps'? used when
                                     --shuffle passes through the graph.  */
+    unsigned int was_weighed:1; /* Did we already compute 'weight'? used when
+                                   --shuffle=longest sorts the graph.  */
     unsigned int snapped:1;     /* True if the deps of this file have been
                                    secondary expanded.  */
   };
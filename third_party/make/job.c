@@ -232,6 +232,7 @@ pid2str (pid_t pid)
 static void free_child (struct child *);
 static void start_job_command (struct child *child);
 static int load_too_high (void);
+static int memory_too_high (struct child *);
 static int job_next_command (struct child *);
 static int start_waiting_job (struct child *);
 
@@ -243,6 +244,10 @@ struct child *children = 0;
 
 unsigned int job_slots_used = 0;
 
+/* [jart] Sum of .MEMORY limits of the children currently running.  */
+
+static unsigned long memory_used = 0;
+
 /* Nonzero if the 'good' standard input is in use.  */
 
 static int good_stdin_used = 0;
@@ -1288,6 +1293,8 @@ reap_children (int block, int err)
       /* There is now another slot open.  */
       if (job_slots_used > 0)
         job_slots_used -= c->jobslot;
+      if (c->jobslot)
+        memory_used -= c->memory;
 
       /* Remove the child from the chain and free it.  */
       if (lastc == 0)
@@ -1832,10 +1839,21 @@ start_waiting_job (struct child *c)
 
   c->remote = start_remote_job_p (1);
 
+  /* Figure out how much memory this job is allowed to use.  */
+  {
+    const char *s;
+    long bytes;
+    if ((s = get_target_variable (STRING_SIZE_TUPLE (".MEMORY"), f, 0))
+        && (bytes = sizetol (s, 1024)) > 0)
+      c->memory = bytes;
+    else
+      c->memory = 0;
+  }
+
   /* If we are running at least one job already and the load average
      is too high, make this one wait.  */
   if (!c->remote
-      && ((job_slots_used > 0 && load_too_high ())
+      && ((job_slots_used > 0 && (load_too_high () || memory_too_high (c)))
 #ifdef WINDOWS32
           || process_table_full ()
 #endif
@@ -1865,6 +1883,7 @@ start_waiting_job (struct child *c)
           ++job_slots_used;
           assert (c->jobslot == 0);
           c->jobslot = 1;
+          memory_used += c->memory;
         }
       children = c;
       unblock_sigs ();
@@ -2383,6 +2402,26 @@ load_too_high (void)
 #endif
 }
 
+/* [jart] Return nonzero if starting C would let the .MEMORY limits of
+   running jobs add up to more than the physical memory of the system.
+   This keeps -j$(nproc) from going into swap, or getting OOM killed,
+   when many targets with large budgets (e.g. LTO links) become ready
+   at the same time.  Jobs without a .MEMORY variable aren't counted.  */
+
+static int
+memory_too_high (struct child *c)
+{
+  unsigned long total;
+
+  total = (unsigned long) get_sysinfo ()->totalram * get_sysinfo ()->mem_unit;
+  if (!c->memory || !total || memory_used + c->memory <= total)
+    return 0;
+
+  DB (DB_JOBS, ("Memory reserved = %lu + %lu (physical = %lu)\n",
+                memory_used, c->memory, total));
+  return 1;
+}
+
 /* Start jobs that are waiting for the load to be lower.  */
 
 void
@@ -58,6 +58,8 @@ struct child
 
     pid_t pid;                  /* Child process's ID number.  */
 
+    unsigned long memory;       /* Bytes of .MEMORY reserved by this job.  */
+
     unsigned int  remote:1;     /* Nonzero if executing remotely.  */
     unsigned int  noerror:1;    /* Nonzero if commands contained a '-'.  */
     unsigned int  good_stdin:1; /* Nonzero if this child has a good stdin.  */
@@ -362,7 +362,7 @@ static const char *const usage[] =
     N_("\
   -R, --no-builtin-variables  Disable the built-in variable settings.\n"),
     N_("\
-  --shuffle[={SEED|random|reverse|none}]\n\
+  --shuffle[={SEED|random|reverse|longest|none}]\n\
                               Perform shuffle of prerequisites and goals.\n"),
     N_("\
   -s, --silent, --quiet       Don't echo recipes.\n"),
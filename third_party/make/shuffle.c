@@ -20,11 +20,13 @@ this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 #include "filedef.h"
 #include "dep.h"
+#include "variable.h"
 
 /* Supported shuffle modes.  */
 static void random_shuffle_array (void ** a, size_t len);
 static void reverse_shuffle_array (void ** a, size_t len);
 static void identity_shuffle_array (void ** a, size_t len);
+static void longest_shuffle_array (void ** a, size_t len);
 
 /* The way goals and rules are shuffled during update.  */
 enum shuffle_mode
@@ -38,6 +40,8 @@ enum shuffle_mode
     /* identity order. Differs from SM_NONE by explicitly populating
        the traversal order.  */
     sm_identity,
+    /* [jart] Prerequisites with the longest history first.  */
+    sm_longest,
   };
 
 /* Shuffle configuration.  */
@@ -74,6 +78,12 @@ shuffle_set_mode (const char *cmdarg)
       config.shuffler = identity_shuffle_array;
       strcpy (config.strval, "identity");
     }
+  else if (strcasecmp (cmdarg, "longest") == 0)
+    {
+      config.mode = sm_longest;
+      config.shuffler = longest_shuffle_array;
+      strcpy (config.strval, "longest");
+    }
   else if (strcasecmp (cmdarg, "none") == 0)
     {
       config.mode = sm_none;
@@ -146,6 +156,123 @@ identity_shuffle_array (void **a UNUSED, size_t len UNUSED)
   /* No-op!  */
 }
 
+/* [jart] Load how long targets took to build last time.
+
+   This reads the telemetry that tool/build/compile appends to the file
+   named by $(COMPILE_LOG), which has one tab separated line per command
+   in the form: target action start end cpu rss cached exitcode.  Times
+   are in microseconds.  Cache hits and failures are skipped so they'll
+   never replace a real measurement.  The most recent record wins.  */
+static void
+load_durations (void)
+{
+  FILE *fp;
+  char *path;
+  char *line = NULL;
+  size_t size = 0;
+
+  path = allocated_variable_expand ("$(COMPILE_LOG)");
+  if (!*path || !(fp = fopen (path, "r")))
+    {
+      free (path);
+      return;
+    }
+
+  while (getline (&line, &size, fp) > 0)
+    {
+      int i;
+      char *f[8];
+      char *p = line;
+      struct file *file;
+      long long beg, end;
+
+      for (i = 0; i < 8; ++i)
+        {
+          f[i] = p;
+          if (!(p = strpbrk (p, i < 7 ? "\t" : "\n")))
+            break;
+          *p++ = '\0';
+        }
+      if (i < 7 || strcmp (f[6], "0") || strcmp (f[7], "0"))
+        continue;
+      beg = strtoll (f[2], NULL, 10);
+      end = strtoll (f[3], NULL, 10);
+      if (end > beg && (file = lookup_file (f[0])))
+        file->duration = end - beg;
+    }
+
+  free (line);
+  fclose (fp);
+  free (path);
+}
+
+/* [jart] Return how long building F and the slowest chain of things
+   it depends upon is expected to take.  This is the critical path in
+   microseconds, which is zero for files that have no history.  */
+static unsigned long
+file_weight (struct file *f)
+{
+  struct dep *dep;
+  unsigned long w, most = 0;
+
+  if (!f)
+    return 0;
+
+  /* Avoid repeated walks and loops.  */
+  if (f->was_weighed)
+    return f->weight;
+  f->was_weighed = 1;
+
+  for (dep = f->deps; dep; dep = dep->next)
+    if ((w = file_weight (dep->file)) > most)
+      most = w;
+
+  f->weight = f->duration + most;
+  return f->weight;
+}
+
+struct weighed_dep
+  {
+    void *dep;
+    size_t index;
+    unsigned long weight;
+  };
+
+static int
+weighed_dep_cmp (const void *x, const void *y)
+{
+  const struct weighed_dep *a = x;
+  const struct weighed_dep *b = y;
+  if (a->weight != b->weight)
+    return a->weight > b->weight ? -1 : 1;
+  return a->index < b->index ? -1 : a->index > b->index;
+}
+
+/* Shuffle array elements so the longest critical paths start first,
+   which keeps big links from being the last thing the build does.
+   Ties keep their original order.  */
+static void
+longest_shuffle_array (void **a, size_t len)
+{
+  size_t i;
+  struct weighed_dep *w;
+
+  w = xmalloc (sizeof (struct weighed_dep) * len);
+  for (i = 0; i < len; i++)
+    {
+      w[i].dep = a[i];
+      w[i].index = i;
+      w[i].weight = file_weight (((struct dep *)a[i])->file);
+    }
+
+  qsort (w, len, sizeof (struct weighed_dep), weighed_dep_cmp);
+
+  for (i = 0; i < len; i++)
+    a[i] = w[i].dep;
+
+  free (w);
+}
+
 /* Shuffle list of dependencies by populating '->shuf'
    field in each 'struct dep'.  */
 static void
@@ -229,6 +356,17 @@ shuffle_deps_recursive (struct dep *deps)
   if (config.mode == sm_random)
     make_seed (config.seed);
 
+  /* Read build history once, now that the makefiles have been read.  */
+  if (config.mode == sm_longest)
+    {
+      static int loaded;
+      if (!loaded)
+        {
+          load_durations ();
+          loaded = 1;
+        }
+    }
+
   shuffle_deps (deps);
 
   /* Shuffle dependencies. */
@@ -59,10 +59,29 @@ o/$(MODE)/third_party/mbedtls/bigmul6.o: private			\
 			CFLAGS +=					\
 				-O2
 
+o/$(MODE)/third_party/mbedtls/chacha20-simd.o				\
+o/$(MODE)/third_party/mbedtls/sha256-mb.o: private			\
+			CFLAGS +=					\
+				-O3
+
 ifeq ($(ARCH), x86_64)
 o/$(MODE)/third_party/mbedtls/shiftright-avx.o: private			\
 			CFLAGS +=					\
 				-O3 -mavx
+o/$(MODE)/third_party/mbedtls/chacha20-avx2.o				\
+o/$(MODE)/third_party/mbedtls/sha256-mb-avx2.o: private		\
+			CFLAGS +=					\
+				-O3 -mavx2
+o/$(MODE)/third_party/mbedtls/chacha20-avx512.o				\
+o/$(MODE)/third_party/mbedtls/sha256-mb-avx512.o: private		\
+			CFLAGS +=					\
+				-O3 -mavx512f
+o/$(MODE)/third_party/mbedtls/aesni-gcm.o: private			\
+			CFLAGS +=					\
+				-O3 -maes -mpclmul -mssse3
+o/$(MODE)/third_party/mbedtls/aesni-gcm-vaes.o: private		\
+			CFLAGS +=					\
+				-O3 -mavx2 -mvaes -mvpclmulqdq
 endif
 
 o/$(MODE)/third_party/mbedtls/zeroize.o: private			\
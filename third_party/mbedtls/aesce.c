@@ -16,7 +16,9 @@
 │ limitations under the License.                                               │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "third_party/mbedtls/aesce.h"
+#include "libc/serialize.h"
 #include "libc/str/str.h"
+#include "third_party/mbedtls/gcm.h"
 #include "third_party/aarch64/arm_neon.internal.h"
 __static_yoink("mbedtls_notice");
 
@@ -390,6 +392,78 @@ void mbedtls_aesce_gcm_mult(unsigned char c[16],
     vst1q_u8(&c[0], vc);
 }
 
+/*
+ * Computes H^1..H^16 for mbedtls_aesce_gcm_crypt(), stored bit reversed
+ */
+void mbedtls_aesce_gcm_powers(uint64_t hp[16][2], const unsigned char h[16])
+{
+    uint8x16_t x, y;
+    x = y = vrbitq_u8(vld1q_u8(&h[0]));
+    vst1q_u8((unsigned char *) hp[0], x);
+    for (int i = 1; i < 16; i++) {
+        y = poly_mult_reduce(poly_mult_128(y, x));
+        vst1q_u8((unsigned char *) hp[i], y);
+    }
+}
+
+/*
+ * Stitched AES-CTR and GHASH over whole groups of four blocks
+ *
+ * The four counter blocks go through the AES rounds side by side, and
+ * their GHASH products with H^4..H^1 are summed unreduced so only one
+ * reduction is needed per group. Returns the number of bytes done.
+ */
+size_t mbedtls_aesce_gcm_crypt(int mode, const unsigned char *rk, int nr,
+                               const uint64_t hp[16][2], unsigned char y[16],
+                               unsigned char x[16], size_t len,
+                               const unsigned char *in, unsigned char *out)
+{
+    int i, r;
+    size_t done;
+    uint32_t ctr;
+    uint32x4_t t;
+    uint8x16_t b[4], g[4], h[4], acc;
+    uint8x16x3_t p, q;
+    for (i = 0; i < 4; i++) {
+        h[i] = vld1q_u8((const unsigned char *) hp[3 - i]);
+    }
+    acc = vrbitq_u8(vld1q_u8(&x[0]));
+    t = vreinterpretq_u32_u8(vld1q_u8(&y[0]));
+    ctr = READ32BE(&y[12]);
+    for (done = 0; len - done >= 64; done += 64) {
+        for (i = 0; i < 4; i++) {
+            b[i] = vreinterpretq_u8_u32(
+                vsetq_lane_u32(__builtin_bswap32(++ctr), t, 3));
+        }
+        for (r = 0; r < nr - 1; r++) {
+            for (i = 0; i < 4; i++) {
+                b[i] = vaesmcq_u8(vaeseq_u8(b[i], vld1q_u8(rk + r * 16)));
+            }
+        }
+        for (i = 0; i < 4; i++) {
+            b[i] = vaeseq_u8(b[i], vld1q_u8(rk + (nr - 1) * 16));
+            b[i] = veorq_u8(b[i], vld1q_u8(rk + nr * 16));
+            g[i] = vld1q_u8(in + done + i * 16);
+            b[i] = veorq_u8(b[i], g[i]);
+            vst1q_u8(out + done + i * 16, b[i]);
+            if (mode == MBEDTLS_GCM_ENCRYPT) {
+                g[i] = b[i];
+            }
+        }
+        p = poly_mult_128(veorq_u8(acc, vrbitq_u8(g[0])), h[0]);
+        for (i = 1; i < 4; i++) {
+            q = poly_mult_128(vrbitq_u8(g[i]), h[i]);
+            p.val[0] = veorq_u8(p.val[0], q.val[0]);
+            p.val[1] = veorq_u8(p.val[1], q.val[1]);
+            p.val[2] = veorq_u8(p.val[2], q.val[2]);
+        }
+        acc = poly_mult_reduce(p);
+    }
+    vst1q_u8(&x[0], vrbitq_u8(acc));
+    WRITE32BE(&y[12], ctr);
+    return done;
+}
+
 #endif /* MBEDTLS_GCM_C */
 
 #if defined(MBEDTLS_POP_TARGET_PRAGMA)
@@ -33,6 +33,37 @@ int mbedtls_aesce_crypt_ecb(mbedtls_aes_context *ctx, int mode,
 void mbedtls_aesce_gcm_mult(unsigned char c[16], const unsigned char a[16],
                             const unsigned char b[16]);
 
+/**
+ * \brief          Internal precomputation of H^1..H^16 for
+ *                 mbedtls_aesce_gcm_crypt()
+ *
+ * \param hp       Receives the powers in an implementation-defined format
+ * \param h        The GHASH subkey, i.e. the zero block encrypted
+ */
+void mbedtls_aesce_gcm_powers(uint64_t hp[16][2], const unsigned char h[16]);
+
+/**
+ * \brief          Internal stitched AES-CTR and GHASH over whole groups
+ *                 of four blocks
+ *
+ * \param mode     MBEDTLS_GCM_ENCRYPT or MBEDTLS_GCM_DECRYPT
+ * \param rk       AES encryption round keys
+ * \param nr       Number of rounds
+ * \param hp       Powers of H from mbedtls_aesce_gcm_powers()
+ * \param y        Counter block, whose last 32 bits are advanced
+ * \param x        GHASH accumulator
+ * \param len      Number of bytes available
+ * \param input    Input buffer
+ * \param output   Output buffer
+ *
+ * \return         Number of bytes processed, a multiple of 64
+ */
+size_t mbedtls_aesce_gcm_crypt(int mode, const unsigned char *rk, int nr,
+                               const uint64_t hp[16][2], unsigned char y[16],
+                               unsigned char x[16], size_t len,
+                               const unsigned char *input,
+                               unsigned char *output);
+
 /**
  * \brief           Internal round key inversion. This function computes
  *                  decryption round keys from the encryption round keys.
@@ -0,0 +1,122 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#ifdef __x86_64__
+#include "third_party/mbedtls/aesni.h"
+#include "third_party/mbedtls/gcm.h"
+#include "third_party/mbedtls/aesni-gcm.inc"
+
+// Stitched AES-CTR + GHASH for VAES and VPCLMULQDQ.
+//
+// This is mbedtls_aesni_gcm_crypt() with every xmm register widened to
+// a ymm holding two consecutive blocks, so sixteen blocks are in flight
+// per iteration instead of eight. The two lanes of the unreduced GHASH
+// sum are folded together before the one reduction.
+
+#define MULADD256(lo, mid, hi, a, h)           \
+  lo ^= _mm256_clmulepi64_epi128(a, h, 0x00),  \
+  hi ^= _mm256_clmulepi64_epi128(a, h, 0x11),  \
+  mid ^= _mm256_clmulepi64_epi128(a, h, 0x01) ^ \
+         _mm256_clmulepi64_epi128(a, h, 0x10)
+
+static inline __m128i mbedtls_aesni_gcm_fold(__m256i x) {
+  return _mm256_castsi256_si128(x) ^ _mm256_extracti128_si256(x, 1);
+}
+
+/**
+ * Encrypts or decrypts whole groups of sixteen blocks.
+ *
+ * @see mbedtls_aesni_gcm_crypt()
+ * @return number of bytes processed, which is a multiple of 256
+ */
+size_t mbedtls_aesni_gcm_crypt_vaes(int mode, const unsigned char *rk, int nr,
+                                    const uint64_t hp[16][2],
+                                    unsigned char y[16], unsigned char x[16],
+                                    size_t len, const unsigned char *in,
+                                    unsigned char *out) {
+  int i, r;
+  bool pending;
+  size_t done;
+  __m256i k[15], h[8], c[8], g[8];
+  __m256i ctr, mask, lo, mid, hi;
+  __m128i acc;
+  for (i = 0; i <= nr; ++i)
+    k[i] = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i *)rk + i));
+  for (i = 0; i < 8; ++i)
+    h[i] = _mm256_set_m128i(_mm_loadu_si128((const __m128i *)hp[14 - 2 * i]),
+                            _mm_loadu_si128((const __m128i *)hp[15 - 2 * i]));
+  mask = _mm256_broadcastsi128_si256(MASK);
+  ctr = _mm256_broadcastsi128_si256(
+      _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)y), MASK));
+  acc = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)x), MASK);
+  pending = false;
+  for (done = 0; len - done >= 256; done += 256) {
+    for (i = 0; i < 8; ++i) {
+      c[i] = _mm256_add_epi32(
+          ctr, _mm256_set_epi32(0, 0, 0, 2 * i + 2, 0, 0, 0, 2 * i + 1));
+      c[i] = _mm256_shuffle_epi8(c[i], mask) ^ k[0];
+    }
+    ctr = _mm256_add_epi32(ctr, _mm256_set_epi32(0, 0, 0, 16, 0, 0, 0, 16));
+    if (mode == MBEDTLS_GCM_DECRYPT) {
+      for (i = 0; i < 8; ++i)
+        g[i] = _mm256_shuffle_epi8(
+            _mm256_loadu_si256((const __m256i *)(in + done) + i), mask);
+      pending = true;
+    }
+    if (pending) {
+      g[0] ^= _mm256_zextsi128_si256(acc);
+      lo = mid = hi = (__m256i){0};
+    }
+    for (r = 1; r < nr; ++r) {
+      for (i = 0; i < 8; ++i)
+        c[i] = _mm256_aesenc_epi128(c[i], k[r]);
+      if (pending && r <= 8)
+        MULADD256(lo, mid, hi, g[r - 1], h[r - 1]);
+    }
+    if (pending)
+      acc = mbedtls_aesni_gcm_reduce(mbedtls_aesni_gcm_fold(lo),
+                                     mbedtls_aesni_gcm_fold(mid),
+                                     mbedtls_aesni_gcm_fold(hi));
+    for (i = 0; i < 8; ++i) {
+      c[i] = _mm256_aesenclast_epi128(c[i], k[nr]);
+      c[i] ^= _mm256_loadu_si256((const __m256i *)(in + done) + i);
+      _mm256_storeu_si256((__m256i *)(out + done) + i, c[i]);
+    }
+    if (mode == MBEDTLS_GCM_ENCRYPT) {
+      for (i = 0; i < 8; ++i)
+        g[i] = _mm256_shuffle_epi8(c[i], mask);
+      pending = true;
+    }
+  }
+  if (mode == MBEDTLS_GCM_ENCRYPT && pending) {
+    g[0] ^= _mm256_zextsi128_si256(acc);
+    lo = mid = hi = (__m256i){0};
+    for (i = 0; i < 8; ++i)
+      MULADD256(lo, mid, hi, g[i], h[i]);
+    acc = mbedtls_aesni_gcm_reduce(mbedtls_aesni_gcm_fold(lo),
+                                   mbedtls_aesni_gcm_fold(mid),
+                                   mbedtls_aesni_gcm_fold(hi));
+  }
+  _mm_storeu_si128((__m128i *)y,
+                   _mm_shuffle_epi8(_mm256_castsi256_si128(ctr), MASK));
+  _mm_storeu_si128((__m128i *)x, _mm_shuffle_epi8(acc, MASK));
+  return done;
+}
+
+#endif /* __x86_64__ */
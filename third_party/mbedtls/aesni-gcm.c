@@ -0,0 +1,125 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#ifdef __x86_64__
+#include "third_party/mbedtls/aesni.h"
+#include "third_party/mbedtls/gcm.h"
+#include "third_party/mbedtls/aesni-gcm.inc"
+
+// Stitched AES-CTR + GHASH for AES-NI and PCLMULQDQ.
+//
+// Eight blocks are authenticated per iteration by multiplying them by H^8
+// down to H^1 and summing the unreduced 256-bit products, so there's a
+// single reduction per 128 bytes. The multiplies are issued between the
+// AES rounds of the next eight counter blocks, which keeps both the AES
+// and the carryless multiply units busy.
+
+/**
+ * Computes H^1 through H^16 for mbedtls_aesni_gcm_crypt().
+ *
+ * @param hp receives byte swapped powers, lowest first
+ * @param h is the hash subkey, i.e. zero block under the key
+ */
+void mbedtls_aesni_gcm_powers(uint64_t hp[16][2], const unsigned char h[16]) {
+  int i;
+  __m128i x, y;
+  x = y = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)h), MASK);
+  _mm_storeu_si128((__m128i *)hp[0], x);
+  for (i = 1; i < 16; ++i) {
+    y = mbedtls_aesni_gcm_mul(y, x);
+    _mm_storeu_si128((__m128i *)hp[i], y);
+  }
+}
+
+/**
+ * Encrypts or decrypts whole groups of eight blocks.
+ *
+ * @param mode is MBEDTLS_GCM_ENCRYPT or MBEDTLS_GCM_DECRYPT
+ * @param rk is AES-NI encryption key schedule
+ * @param nr is number of AES rounds
+ * @param hp is from mbedtls_aesni_gcm_powers()
+ * @param y is counter block whose last 32 bits get advanced
+ * @param x is GHASH accumulator, in the same order as ctx->buf
+ * @return number of bytes processed, which is a multiple of 128
+ */
+size_t mbedtls_aesni_gcm_crypt(int mode, const unsigned char *rk, int nr,
+                               const uint64_t hp[16][2], unsigned char y[16],
+                               unsigned char x[16], size_t len,
+                               const unsigned char *in, unsigned char *out) {
+  int i, r;
+  bool pending;
+  size_t done;
+  __m128i k[15], h[8], c[8], g[8];
+  __m128i ctr, acc, lo, mid, hi;
+  for (i = 0; i <= nr; ++i)
+    k[i] = _mm_loadu_si128((const __m128i *)rk + i);
+  for (i = 0; i < 8; ++i)
+    h[i] = _mm_loadu_si128((const __m128i *)hp[7 - i]);
+  ctr = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)y), MASK);
+  acc = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)x), MASK);
+  pending = false;
+  for (done = 0; len - done >= 128; done += 128) {
+    for (i = 0; i < 8; ++i) {
+      c[i] = _mm_add_epi32(ctr, _mm_set_epi32(0, 0, 0, i + 1));
+      c[i] = _mm_shuffle_epi8(c[i], MASK) ^ k[0];
+    }
+    ctr = _mm_add_epi32(ctr, _mm_set_epi32(0, 0, 0, 8));
+    if (mode == MBEDTLS_GCM_DECRYPT) {
+      // ciphertext is already at hand, so hash it in this pass
+      for (i = 0; i < 8; ++i)
+        g[i] = _mm_shuffle_epi8(
+            _mm_loadu_si128((const __m128i *)(in + done) + i), MASK);
+      pending = true;
+    }
+    // otherwise we're hashing the ciphertext of the previous pass
+    if (pending) {
+      g[0] ^= acc;
+      lo = mid = hi = (__m128i){0};
+    }
+    for (r = 1; r < nr; ++r) {
+      for (i = 0; i < 8; ++i)
+        c[i] = _mm_aesenc_si128(c[i], k[r]);
+      if (pending && r <= 8)
+        MULADD(lo, mid, hi, g[r - 1], h[r - 1]);
+    }
+    if (pending)
+      acc = mbedtls_aesni_gcm_reduce(lo, mid, hi);
+    for (i = 0; i < 8; ++i) {
+      c[i] = _mm_aesenclast_si128(c[i], k[nr]);
+      c[i] ^= _mm_loadu_si128((const __m128i *)(in + done) + i);
+      _mm_storeu_si128((__m128i *)(out + done) + i, c[i]);
+    }
+    if (mode == MBEDTLS_GCM_ENCRYPT) {
+      for (i = 0; i < 8; ++i)
+        g[i] = _mm_shuffle_epi8(c[i], MASK);
+      pending = true;
+    }
+  }
+  if (mode == MBEDTLS_GCM_ENCRYPT && pending) {
+    g[0] ^= acc;
+    lo = mid = hi = (__m128i){0};
+    for (i = 0; i < 8; ++i)
+      MULADD(lo, mid, hi, g[i], h[i]);
+    acc = mbedtls_aesni_gcm_reduce(lo, mid, hi);
+  }
+  _mm_storeu_si128((__m128i *)y, _mm_shuffle_epi8(ctr, MASK));
+  _mm_storeu_si128((__m128i *)x, _mm_shuffle_epi8(acc, MASK));
+  return done;
+}
+
+#endif /* __x86_64__ */
@@ -9,6 +9,9 @@ COSMOPOLITAN_C_START_
 
 int mbedtls_aesni_crypt_ecb( mbedtls_aes_context *, int, const unsigned char[16], unsigned char[16] );
 void mbedtls_aesni_gcm_mult( unsigned char[16], const uint64_t[2] );
+void mbedtls_aesni_gcm_powers( uint64_t[16][2], const unsigned char[16] );
+size_t mbedtls_aesni_gcm_crypt( int, const unsigned char *, int, const uint64_t[16][2], unsigned char[16], unsigned char[16], size_t, const unsigned char *, unsigned char * );
+size_t mbedtls_aesni_gcm_crypt_vaes( int, const unsigned char *, int, const uint64_t[16][2], unsigned char[16], unsigned char[16], size_t, const unsigned char *, unsigned char * );
 void mbedtls_aesni_inverse_key( unsigned char *, const unsigned char *, int );
 int mbedtls_aesni_setkey_enc( unsigned char *, const unsigned char *, size_t );
 
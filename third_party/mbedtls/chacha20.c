@@ -16,9 +16,11 @@
 │ limitations under the License.                                               │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "third_party/mbedtls/chacha20.h"
+#include "libc/nexgen32e/x86feature.h"
 #include "libc/serialize.h"
 #include "libc/stdio/stdio.h"
 #include "libc/str/str.h"
+#include "third_party/mbedtls/chacha20_internal.h"
 #include "third_party/mbedtls/common.h"
 #include "third_party/mbedtls/error.h"
 #include "third_party/mbedtls/platform.h"
@@ -119,6 +121,32 @@ static void chacha20_block( const uint32_t s[16], unsigned char k[64] )
     P += s[15]; p = WRITE32LE(p, P);
 }
 
+/**
+ * \brief               Encrypts as many whole blocks as the widest
+ *                      available vector unit can do in one go.
+ *
+ * \param s             The ChaCha20 state, whose counter is advanced.
+ * \param in            The input buffer.
+ * \param out           The output buffer.
+ * \param size          The number of bytes available.
+ *
+ * \return              The number of bytes processed, which is a
+ *                      multiple of the block size and may be zero.
+ */
+static size_t chacha20_blocks( uint32_t s[16], const unsigned char *in,
+                               unsigned char *out, size_t size )
+{
+    size_t n = 0;
+#ifdef __x86_64__
+    if( X86_HAVE( AVX512F ) )
+        n += mbedtls_chacha20_blocks16_avx512( s, in, out, size );
+    if( X86_HAVE( AVX2 ) )
+        n += mbedtls_chacha20_blocks8_avx2( s, in + n, out + n, size - n );
+#endif
+    n += mbedtls_chacha20_blocks4( s, in + n, out + n, size - n );
+    return( n );
+}
+
 /**
  * \brief           This function initializes the specified ChaCha20 context.
  *
@@ -295,7 +323,15 @@ int mbedtls_chacha20_update( mbedtls_chacha20_context *ctx,
         size--;
     }
 
-    /* Process full blocks */
+    /* Process full blocks, several at a time when vectors allow */
+    if( size >= 4U * CHACHA20_BLOCK_SIZE_BYTES )
+    {
+        i = chacha20_blocks( ctx->state, input + offset, output + offset, size );
+        offset += i;
+        size   -= i;
+    }
+
+    /* Process remaining full blocks */
     while( size >= CHACHA20_BLOCK_SIZE_BYTES )
     {
         /* Generate new keystream block and increment counter */
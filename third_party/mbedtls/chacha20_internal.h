@@ -0,0 +1,13 @@
+#ifndef COSMOPOLITAN_THIRD_PARTY_MBEDTLS_CHACHA20_INTERNAL_H_
+#define COSMOPOLITAN_THIRD_PARTY_MBEDTLS_CHACHA20_INTERNAL_H_
+COSMOPOLITAN_C_START_
+
+size_t mbedtls_chacha20_blocks4(uint32_t[16], const unsigned char *,
+                                unsigned char *, size_t);
+size_t mbedtls_chacha20_blocks8_avx2(uint32_t[16], const unsigned char *,
+                                     unsigned char *, size_t);
+size_t mbedtls_chacha20_blocks16_avx512(uint32_t[16], const unsigned char *,
+                                        unsigned char *, size_t);
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_THIRD_PARTY_MBEDTLS_CHACHA20_INTERNAL_H_ */
@@ -810,7 +810,7 @@
  *
  * Comment this macro to disable support for key export
  */
-/*#define MBEDTLS_SSL_EXPORT_KEYS*/
+#define MBEDTLS_SSL_EXPORT_KEYS
 
 /**
  * \def MBEDTLS_SSL_SERVER_NAME_INDICATION
@@ -2084,6 +2084,13 @@ static int ecp_select_comb( const mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
 {
     int ret = MBEDTLS_ERR_THIS_CORRUPTION;
     unsigned char ii, j;
+#ifdef MBEDTLS_ECP_DP_SECP256R1_ENABLED
+    if ( grp->modp == ecp_mod_p256 ) {
+        MBEDTLS_MPI_CHK( mbedtls_p256_select_comb( grp, R, T, T_size, i ) );
+        MBEDTLS_MPI_CHK( ecp_safe_invert_jac( grp, R, i >> 7 ) );
+        return( 0 );
+    }
+#endif
     /* Ignore the "sign" bit and scale down */
     ii =  ( i & 0x7Fu ) >> 1;
     /* Read the whole table to thwart cache-based timing attacks */
@@ -2302,6 +2309,30 @@ static unsigned char ecp_pick_window_size( const mbedtls_ecp_group *grp,
     return( w );
 }
 
+/*
+ * Return the comb table compiled in for P, and its window size, if P is
+ * the base point of a curve that has one
+ */
+static mbedtls_ecp_point *ecp_builtin_comb( const mbedtls_ecp_group *grp,
+                                            const mbedtls_ecp_point *P,
+                                            unsigned char *w )
+{
+    const mbedtls_ecp_point *T = NULL;
+    unsigned char tw = 0;
+#ifdef MBEDTLS_ECP_DP_SECP256R1_ENABLED
+    if( grp->modp == ecp_mod_p256 )
+    {
+        T = mbedtls_p256_comb_table();
+        tw = MBEDTLS_P256_COMB_W;
+    }
+#endif
+    if( !T || mbedtls_mpi_cmp_mpi( &P->X, &T->X ) != 0 ||
+              mbedtls_mpi_cmp_mpi( &P->Y, &T->Y ) != 0 )
+        return( NULL );
+    *w = tw;
+    return( (mbedtls_ecp_point *)T );
+}
+
 /*
  * Multiplication using the comb method - for curves in short Weierstrass form
  *
@@ -2324,7 +2355,7 @@ static int ecp_mul_comb( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
     int ret = MBEDTLS_ERR_THIS_CORRUPTION;
     unsigned char w, p_eq_g, i;
     size_t d;
-    unsigned char T_size = 0, T_ok = 0;
+    unsigned char T_size = 0, T_ok = 0, T_builtin = 0;
     mbedtls_ecp_point *T = NULL;
 #if !defined(MBEDTLS_ECP_NO_INTERNAL_RNG)
     ecp_drbg_context drbg_ctx;
@@ -2366,8 +2397,14 @@ static int ecp_mul_comb( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
 #endif
     /* Pick window size and deduce related sizes */
     w = ecp_pick_window_size( grp, p_eq_g );
+    if( p_eq_g && ( T = ecp_builtin_comb( grp, P, &w ) ) )
+        T_builtin = 1;
     T_size = 1U << ( w - 1 );
     d = ( grp->nbits + w - 1 ) / w;
+    /* Pre-computed table: is it compiled in? won't be deleted on exit */
+    if( T_builtin )
+        T_ok = 1;
+    else
     /* Pre-computed table: do we have it already for the base point? */
     if( p_eq_g && grp->T )
     {
@@ -2424,6 +2461,9 @@ cleanup:
     /* does T belong to the group? */
     if( T == grp->T )
         T = NULL;
+    /* is T compiled in? */
+    if( T_builtin )
+        T = NULL;
     /* does T belong to the restart context? */
 #if defined(MBEDTLS_ECP_RESTARTABLE)
     if( rs_ctx && rs_ctx->rsm && ret == MBEDTLS_ERR_ECP_IN_PROGRESS && T )
@@ -558,3 +558,81 @@ int mbedtls_p256_normalize_jac( const mbedtls_ecp_group *grp,
     mbedtls_mpi_lset( &pt->Z, 1 );
     return( 0 );
 }
+
+static inline uint64_t
+mbedtls_p256_limb( const mbedtls_mpi *A, size_t i )
+{
+    return( i < A->n ? A->p[i] : 0 );
+}
+
+/**
+ * Selects R = T[(i & 0x7F) >> 1] by reading the whole table.
+ *
+ * This is the constant-time table lookup of the comb method, which is
+ * done with masks on raw limbs, rather than calling the conditional
+ * assignment of the bignum library twice for each entry.
+ */
+int mbedtls_p256_select_comb( const mbedtls_ecp_group *G,
+                              mbedtls_ecp_point *R,
+                              const mbedtls_ecp_point T[],
+                              unsigned char T_size,
+                              unsigned char i )
+{
+    int ret;
+    size_t k;
+    unsigned char j, ii;
+    uint64_t m, X[4] = {0}, Y[4] = {0};
+    (void)G;
+    if( R->X.n < 4 && ( ret = mbedtls_mpi_grow( &R->X, 4 ) ) ) return ret;
+    if( R->Y.n < 4 && ( ret = mbedtls_mpi_grow( &R->Y, 4 ) ) ) return ret;
+    ii = ( i & 0x7Fu ) >> 1;
+    for( j = 0; j < T_size; j++ )
+    {
+        m = -(uint64_t)( j == ii );
+        for( k = 0; k < 4; k++ )
+        {
+            X[k] = Select( mbedtls_p256_limb( &T[j].X, k ), X[k], m );
+            Y[k] = Select( mbedtls_p256_limb( &T[j].Y, k ), Y[k], m );
+        }
+    }
+    mbedtls_p256_cop( R->X.p, X );
+    mbedtls_p256_cop( R->Y.p, Y );
+    bzero( R->X.p + 4, ( R->X.n - 4 ) * 8 );
+    bzero( R->Y.p + 4, ( R->Y.n - 4 ) * 8 );
+    R->X.s = 1;
+    R->Y.s = 1;
+    return( 0 );
+}
+
+#include "third_party/mbedtls/ecp256comb.inc"
+
+#define P(i)                                    \
+    { { 1, 4, (uint64_t *)kP256Comb[i] },       \
+      { 1, 4, (uint64_t *)kP256Comb[i] + 4 },   \
+      { 1, 0, 0 } }
+
+static const mbedtls_ecp_point kP256CombPoints[64] = {
+    P(0),  P(1),  P(2),  P(3),  P(4),  P(5),  P(6),  P(7),
+    P(8),  P(9),  P(10), P(11), P(12), P(13), P(14), P(15),
+    P(16), P(17), P(18), P(19), P(20), P(21), P(22), P(23),
+    P(24), P(25), P(26), P(27), P(28), P(29), P(30), P(31),
+    P(32), P(33), P(34), P(35), P(36), P(37), P(38), P(39),
+    P(40), P(41), P(42), P(43), P(44), P(45), P(46), P(47),
+    P(48), P(49), P(50), P(51), P(52), P(53), P(54), P(55),
+    P(56), P(57), P(58), P(59), P(60), P(61), P(62), P(63),
+};
+
+#undef P
+
+/**
+ * Returns comb table of secp256r1 generator for window of 7 bits.
+ *
+ * The table is compiled in, so multiplying G doesn't need each group
+ * to build its own table first, and the window can be larger than the
+ * one ecp_mul_comb() would pick for a table it has to compute. Points
+ * must not be modified or freed.
+ */
+const mbedtls_ecp_point *mbedtls_p256_comb_table( void )
+{
+    return( kP256CombPoints );
+}
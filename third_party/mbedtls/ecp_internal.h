@@ -247,6 +247,13 @@ int mbedtls_p256_normalize_jac( const mbedtls_ecp_group *,
                                 mbedtls_ecp_point * );
 int mbedtls_p256_normalize_jac_many( const mbedtls_ecp_group *,
                                      mbedtls_ecp_point *[], size_t );
+int mbedtls_p256_select_comb( const mbedtls_ecp_group *,
+                              mbedtls_ecp_point *,
+                              const mbedtls_ecp_point[],
+                              unsigned char, unsigned char );
+const mbedtls_ecp_point *mbedtls_p256_comb_table( void );
+
+#define MBEDTLS_P256_COMB_W 7 /* window of mbedtls_p256_comb_table() */
 
 int mbedtls_p384_double_jac( const mbedtls_ecp_group *,
                              const mbedtls_ecp_point *,
@@ -22,7 +22,10 @@
 #include "libc/nexgen32e/x86feature.h"
 #include "libc/runtime/runtime.h"
 #include "libc/str/str.h"
+#include "libc/sysv/consts/auxv.h"
+#include "libc/sysv/consts/hwcap.h"
 #include "third_party/mbedtls/aes.h"
+#include "third_party/mbedtls/aesce.h"
 #include "third_party/mbedtls/aesni.h"
 #include "third_party/mbedtls/cipher.h"
 #include "third_party/mbedtls/common.h"
@@ -86,6 +89,24 @@ void mbedtls_gcm_init( mbedtls_gcm_context *ctx )
     mbedtls_platform_zeroize( ctx, sizeof( mbedtls_gcm_context ) );
 }
 
+#if defined(MBEDTLS_AESCE_C) && defined(__aarch64__)
+/*
+ * Returns nonzero if both AES and PMULL instructions are available.
+ */
+static int gcm_uses_pmull( void )
+{
+    static char once;
+    static char result;
+    if( !once )
+    {
+        result = mbedtls_aes_uses_hardware() &&
+                 ( getauxval( AT_HWCAP ) & HWCAP_PMULL );
+        once = 1;
+    }
+    return( result );
+}
+#endif /* MBEDTLS_AESCE_C && __aarch64__ */
+
 /*
  * Precompute small multiples of H, that is set
  *      HH[i] || HL[i] = H times i,
@@ -110,6 +131,15 @@ static int gcm_gen_table( mbedtls_gcm_context *ctx )
     if (X86_HAVE(AES) && X86_HAVE(PCLMUL)) {
         ctx->H8[0] = vl;
         ctx->H8[1] = vh;
+        mbedtls_aesni_gcm_powers( ctx->HP, h );
+        return 0;
+    }
+#endif
+#if defined(MBEDTLS_AESCE_C) && defined(__aarch64__)
+    /* With PMULL support, we need h and its powers, not the table */
+    if( gcm_uses_pmull() ) {
+        memcpy( ctx->H8, h, 16 );
+        mbedtls_aesce_gcm_powers( ctx->HP, h );
         return 0;
     }
 #endif
@@ -211,6 +241,12 @@ static void gcm_mult( mbedtls_gcm_context *ctx,  unsigned char x[16] )
         return;
     }
 #endif /* MBEDTLS_AESNI_C && MBEDTLS_HAVE_X86_64 */
+#if defined(MBEDTLS_AESCE_C) && defined(__aarch64__)
+    if( LIKELY( gcm_uses_pmull() ) ) {
+        mbedtls_aesce_gcm_mult( x, x, (const unsigned char *) ctx->H8 );
+        return;
+    }
+#endif /* MBEDTLS_AESCE_C && __aarch64__ */
     lo = x[15] & 0xf;
     zh = ctx->HH[lo];
     zl = ctx->HL[lo];
@@ -236,6 +272,44 @@ static void gcm_mult( mbedtls_gcm_context *ctx,  unsigned char x[16] )
     PUT_UINT64_BE( zl, x, 8 );
 }
 
+/*
+ * Encrypts and authenticates runs of whole blocks in a single stitched
+ * pass, when the cipher is AES and the cpu can do both halves of the job
+ * in hardware. Returns the number of bytes processed, which may be zero.
+ */
+static size_t gcm_stitched( mbedtls_gcm_context *ctx, size_t length,
+                            const unsigned char *input,
+                            unsigned char *output )
+{
+    size_t n = 0;
+    const mbedtls_aes_context *aes;
+    if( ctx->cipher != MBEDTLS_CIPHER_ID_AES )
+        return( 0 );
+    aes = ctx->cipher_ctx.cipher_ctx;
+#if defined(MBEDTLS_AESNI_C) && defined(MBEDTLS_HAVE_X86_64)
+    if( X86_HAVE(AES) && X86_HAVE(PCLMUL) ) {
+        if( X86_HAVE(AVX2) && X86_HAVE(VAES) && X86_HAVE(VPCLMULQDQ) )
+            n += mbedtls_aesni_gcm_crypt_vaes( ctx->mode,
+                                               (const unsigned char *) aes->rk,
+                                               aes->nr, ctx->HP, ctx->y,
+                                               ctx->buf, length, input,
+                                               output );
+        n += mbedtls_aesni_gcm_crypt( ctx->mode,
+                                      (const unsigned char *) aes->rk,
+                                      aes->nr, ctx->HP, ctx->y, ctx->buf,
+                                      length - n, input + n, output + n );
+    }
+#endif /* MBEDTLS_AESNI_C && MBEDTLS_HAVE_X86_64 */
+#if defined(MBEDTLS_AESCE_C) && defined(__aarch64__)
+    if( gcm_uses_pmull() )
+        n += mbedtls_aesce_gcm_crypt( ctx->mode,
+                                      (const unsigned char *) aes->rk,
+                                      aes->nr, ctx->HP, ctx->y, ctx->buf,
+                                      length, input, output );
+#endif /* MBEDTLS_AESCE_C && __aarch64__ */
+    return( n );
+}
+
 /**
  * \brief           This function starts a GCM encryption or decryption
  *                  operation.
@@ -367,7 +441,8 @@ int mbedtls_gcm_update( mbedtls_gcm_context *ctx,
     ctx->len += length;
     p = input;
     q = ctx->buf;
-    for( j = 0; j + 16 <= length; j += 16 ){
+    for( j = gcm_stitched( ctx, length, input, output );
+         j + 16 <= length; j += 16 ){
         for( i = 16; i > 12; i-- )
             if( ++ctx->y[i - 1] != 0 )
                 break;
@@ -19,6 +19,7 @@ typedef struct mbedtls_gcm_context {
     unsigned char buf[16];                /*!< The buf working value. */
     int mode;                             /*!< The operation to perform: #MBEDTLS_GCM_ENCRYPT or #MBEDTLS_GCM_DECRYPT. */
     uint64_t H8[2];                       /*!< For AES-NI. */
+    uint64_t HP[16][2];                   /*!< H^1..H^16 for stitched AES-GCM. */
     uint64_t HL[16];                      /*!< Precalculated HTable low. */
     uint64_t HH[16];                      /*!< Precalculated HTable high. */
     mbedtls_cipher_id_t cipher;           /*!< The cipher being used. */
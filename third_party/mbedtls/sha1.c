@@ -26,6 +26,7 @@
 #include "third_party/mbedtls/error.h"
 #include "third_party/mbedtls/md.h"
 #include "third_party/mbedtls/platform.h"
+#include "third_party/mbedtls/shace.h"
 __static_yoink("mbedtls_notice");
 
 /**
@@ -108,6 +109,13 @@ int mbedtls_internal_sha1_process( mbedtls_sha1_context *ctx,
     SHA1_VALIDATE_RET( ctx != NULL );
     SHA1_VALIDATE_RET( (const unsigned char *)data != NULL );
 
+#ifdef __aarch64__
+    if( mbedtls_shace_has_sha1() )
+    {
+        mbedtls_shace_sha1_process( ctx->state, data, 1 );
+        return( 0 );
+    }
+#endif
     if( X86_HAVE( SHA ) )
     {
         sha1_transform_ni( ctx->state, data, 1 );
@@ -393,6 +401,15 @@ int mbedtls_sha1_update_ret( mbedtls_sha1_context *ctx,
 
     if( ilen >= 64 )
     {
+#ifdef __aarch64__
+        if( mbedtls_shace_has_sha1() )
+        {
+            mbedtls_shace_sha1_process( ctx->state, input, ilen / 64 );
+            input += ROUNDDOWN( ilen, 64 );
+            ilen  -= ROUNDDOWN( ilen, 64 );
+        }
+        else
+#endif
         if( X86_HAVE( SHA ) )
         {
             sha1_transform_ni( ctx->state, input, ilen / 64 );
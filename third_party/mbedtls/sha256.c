@@ -26,6 +26,8 @@
 #include "third_party/mbedtls/endian.h"
 #include "third_party/mbedtls/error.h"
 #include "third_party/mbedtls/md.h"
+#include "third_party/mbedtls/sha256_internal.h"
+#include "third_party/mbedtls/shace.h"
 __static_yoink("mbedtls_notice");
 
 /**
@@ -165,6 +167,13 @@ int mbedtls_internal_sha256_process( mbedtls_sha256_context *ctx,
     SHA256_VALIDATE_RET( ctx != NULL );
     SHA256_VALIDATE_RET( (const unsigned char *)data != NULL );
 
+#ifdef __aarch64__
+    if( mbedtls_shace_has_sha256() )
+    {
+        mbedtls_shace_sha256_process( ctx->state, data, 1 );
+        return( 0 );
+    }
+#endif
     if( X86_HAVE( SHA ) &&
         X86_HAVE( SSE2 ) &&
         X86_HAVE( SSSE3 ) )
@@ -297,6 +306,15 @@ int mbedtls_sha256_update_ret( mbedtls_sha256_context *ctx,
 
     if( ilen >= 64 )
     {
+#ifdef __aarch64__
+        if( mbedtls_shace_has_sha256() )
+        {
+            mbedtls_shace_sha256_process( ctx->state, input, ilen / 64 );
+            input += ROUNDDOWN( ilen, 64 );
+            ilen  -= ROUNDDOWN( ilen, 64 );
+        }
+        else
+#endif
         if( X86_HAVE( SHA ) &&
             X86_HAVE( SSE2 ) &&
             X86_HAVE( SSSE3 ) )
@@ -456,6 +474,159 @@ exit:
     return( ret );
 }
 
+typedef struct mbedtls_sha256_lane
+{
+    const unsigned char *input; /*!< The message being hashed.      */
+    size_t full;                /*!< Its number of whole blocks.    */
+    size_t done;                /*!< Blocks compressed so far.      */
+    size_t total;               /*!< Blocks including padding.      */
+    size_t index;               /*!< Which output gets the digest.  */
+    unsigned char pad[128];     /*!< The last one or two blocks.    */
+}
+mbedtls_sha256_lane;
+
+static const uint32_t sha256_iv[8] = {
+    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+    0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19,
+};
+
+static void sha256_lane_start( mbedtls_sha256_lane *lane, uint32_t *state,
+                               int lanes, const void *input, size_t ilen,
+                               size_t index )
+{
+    int j;
+    size_t r = ilen & 63;
+    lane->input = input;
+    lane->full = ilen / 64;
+    lane->done = 0;
+    lane->total = lane->full + ( r < 56 ? 1 : 2 );
+    lane->index = index;
+    mbedtls_platform_zeroize( lane->pad, sizeof( lane->pad ) );
+    if( r )
+        memcpy( lane->pad, lane->input + lane->full * 64, r );
+    lane->pad[r] = 0x80;
+    r = ( lane->total - lane->full ) * 64;
+    PUT_UINT32_BE( (uint32_t)( ilen >> 29 ), lane->pad, r - 8 );
+    PUT_UINT32_BE( (uint32_t)( ilen <<  3 ), lane->pad, r - 4 );
+    for( j = 0; j < 8; j++ )
+        state[j * lanes] = sha256_iv[j];
+}
+
+static void sha256_multi_lanes( void kernel( uint32_t *,
+                                             const unsigned char *const * ),
+                                int lanes,
+                                const void *const *inputs,
+                                const size_t *ilens,
+                                size_t count,
+                                unsigned char (*outputs)[32] )
+{
+    static const unsigned char idle[64];
+    uint32_t state[8 * 16];
+    const unsigned char *blocks[16];
+    mbedtls_sha256_lane lane[16];
+    size_t next;
+    int i, j, active;
+
+    for( active = 0; active < lanes && active < count; active++ )
+        sha256_lane_start( lane + active, state + active, lanes,
+                           inputs[active], ilens[active], active );
+    for( i = active; i < lanes; i++ )
+        lane[i].done = lane[i].total = 0;
+    next = active;
+
+    while( active )
+    {
+        for( i = 0; i < lanes; i++ )
+        {
+            if( lane[i].done == lane[i].total )
+                blocks[i] = idle;
+            else if( lane[i].done < lane[i].full )
+                blocks[i] = lane[i].input + lane[i].done * 64;
+            else
+                blocks[i] = lane[i].pad + ( lane[i].done - lane[i].full ) * 64;
+        }
+        kernel( state, blocks );
+        for( i = 0; i < lanes; i++ )
+        {
+            if( lane[i].done == lane[i].total ||
+                ++lane[i].done < lane[i].total )
+                continue;
+            for( j = 0; j < 8; j++ )
+                PUT_UINT32_BE( state[j * lanes + i],
+                               outputs[lane[i].index], j * 4 );
+            if( next < count )
+            {
+                sha256_lane_start( lane + i, state + i, lanes,
+                                   inputs[next], ilens[next], next );
+                next++;
+            }
+            else
+            {
+                active--;
+            }
+        }
+    }
+}
+
+/**
+ * \brief          This function calculates the SHA-256 checksums of
+ *                 many independent buffers.
+ *
+ *                 When SHA-NI or the ARMv8 SHA-256 instructions are
+ *                 available each buffer is simply hashed in turn.
+ *                 Otherwise the buffers are hashed several at a time,
+ *                 with each one occupying a lane of the widest vector
+ *                 unit available. A lane moves on to the next buffer
+ *                 as soon as it finishes, so buffers of differing
+ *                 lengths are fine, although this is most helpful for
+ *                 many small buffers.
+ *
+ * \param inputs   The buffers holding the data. Each one must be
+ *                 readable for the corresponding length.
+ * \param ilens    The length of each buffer in Bytes.
+ * \param count    The number of buffers.
+ * \param outputs  The SHA-256 checksum results, one per buffer.
+ *
+ * \return         \c 0 on success.
+ */
+int mbedtls_sha256_multi( const void *const *inputs,
+                          const size_t *ilens,
+                          size_t count,
+                          unsigned char (*outputs)[32] )
+{
+    size_t i;
+    int ret;
+    SHA256_VALIDATE_RET( count == 0 || inputs != NULL );
+    SHA256_VALIDATE_RET( count == 0 || ilens != NULL );
+    SHA256_VALIDATE_RET( count == 0 || outputs != NULL );
+#ifdef __x86_64__
+    if( count < 2 || ( X86_HAVE( SHA ) &&
+                       X86_HAVE( SSE2 ) &&
+                       X86_HAVE( SSSE3 ) ) )
+#else
+    if( count < 2 || mbedtls_shace_has_sha256() )
+#endif
+    {
+        for( i = 0; i < count; i++ )
+            if( ( ret = mbedtls_sha256_ret( inputs[i], ilens[i],
+                                            outputs[i], 0 ) ) != 0 )
+                return( ret );
+        return( 0 );
+    }
+#ifdef __x86_64__
+    if( X86_HAVE( AVX512F ) && count > 8 )
+        sha256_multi_lanes( mbedtls_sha256_multi16_avx512, 16,
+                            inputs, ilens, count, outputs );
+    else if( X86_HAVE( AVX2 ) && count > 4 )
+        sha256_multi_lanes( mbedtls_sha256_multi8_avx2, 8,
+                            inputs, ilens, count, outputs );
+    else
+#endif
+        sha256_multi_lanes( mbedtls_sha256_multi4, 4,
+                            inputs, ilens, count, outputs );
+    return( 0 );
+}
+
 dontinstrument int mbedtls_sha256_ret_224( const void *input, size_t ilen, unsigned char *output )
 {
     return mbedtls_sha256_ret( input, ilen, output, true );
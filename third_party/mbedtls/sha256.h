@@ -32,6 +32,7 @@ int mbedtls_internal_sha256_process( mbedtls_sha256_context *, const unsigned ch
 int mbedtls_sha256_ret( const void *, size_t, unsigned char[32], int );
 int mbedtls_sha256_ret_224( const void *, size_t , unsigned char * );
 int mbedtls_sha256_ret_256( const void *, size_t , unsigned char * );
+int mbedtls_sha256_multi( const void *const *, const size_t *, size_t, unsigned char (*)[32] );
 int mbedtls_sha256_self_test( int );
 
 /**
@@ -0,0 +1,11 @@
+#ifndef COSMOPOLITAN_THIRD_PARTY_MBEDTLS_SHA256_INTERNAL_H_
+#define COSMOPOLITAN_THIRD_PARTY_MBEDTLS_SHA256_INTERNAL_H_
+COSMOPOLITAN_C_START_
+
+void mbedtls_sha256_multi4(uint32_t[32], const unsigned char *const[4]);
+void mbedtls_sha256_multi8_avx2(uint32_t[64], const unsigned char *const[8]);
+void mbedtls_sha256_multi16_avx512(uint32_t[128],
+                                   const unsigned char *const[16]);
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_THIRD_PARTY_MBEDTLS_SHA256_INTERNAL_H_ */
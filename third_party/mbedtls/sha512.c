@@ -27,6 +27,7 @@
 #include "third_party/mbedtls/error.h"
 #include "third_party/mbedtls/md.h"
 #include "third_party/mbedtls/platform.h"
+#include "third_party/mbedtls/shace.h"
 __static_yoink("mbedtls_notice");
 
 /**
@@ -164,6 +165,13 @@ int mbedtls_internal_sha512_process( mbedtls_sha512_context *ctx,
     SHA512_VALIDATE_RET( ctx != NULL );
     SHA512_VALIDATE_RET( (const unsigned char *)data != NULL );
 
+#ifdef __aarch64__
+    if( mbedtls_shace_has_sha512() )
+    {
+        mbedtls_shace_sha512_process( ctx->state, data, 1 );
+        return 0;
+    }
+#endif
     if( !IsTiny() && X86_HAVE(AVX2) )
     {
         sha512_transform_rorx(ctx, data, 1);
@@ -275,6 +283,14 @@ int mbedtls_sha512_update_ret( mbedtls_sha512_context *ctx,
         ilen  -= fill;
         left = 0;
     }
+#ifdef __aarch64__
+    if( ilen >= 128 && mbedtls_shace_has_sha512() )
+    {
+        mbedtls_shace_sha512_process( ctx->state, input, ilen / 128 );
+        input += ROUNDDOWN(ilen, 128);
+        ilen  -= ROUNDDOWN(ilen, 128);
+    }
+#endif
     if (!IsTiny() && ilen >= 128 && X86_HAVE(AVX2)) {
         sha512_transform_rorx(ctx, input, ilen / 128);
         input += ROUNDDOWN(ilen, 128);
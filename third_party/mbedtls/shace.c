@@ -0,0 +1,180 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#ifdef __aarch64__
+#include "third_party/mbedtls/shace.h"
+#include "libc/nexgen32e/nexgen32e.h"
+#include "libc/runtime/runtime.h"
+#include "libc/sysv/consts/auxv.h"
+#include "libc/sysv/consts/hwcap.h"
+#include "third_party/aarch64/arm_neon.internal.h"
+
+// SHA-1, SHA-256 and SHA-512 using the ARMv8 cryptography extensions.
+//
+// Each function compresses `blocks` consecutive blocks into the state,
+// which has the same layout as the mbedtls contexts. Callers must first
+// check the corresponding mbedtls_shace_has_*() function. As with the
+// AES code, a zero auxv is taken to mean an OS that doesn't report the
+// hwcaps, e.g. Apple, whose chips all have SHA-1 and SHA-256.
+
+static unsigned long shace_hwcap(void) {
+  static char once;
+  static unsigned long hwcap;
+  if (!once) {
+    hwcap = getauxval(AT_HWCAP);
+    once = 1;
+  }
+  return hwcap;
+}
+
+int mbedtls_shace_has_sha1(void) {
+  unsigned long hwcap = shace_hwcap();
+  return !hwcap || (hwcap & (HWCAP_ASIMD | HWCAP_SHA1)) ==
+                       (HWCAP_ASIMD | HWCAP_SHA1);
+}
+
+int mbedtls_shace_has_sha256(void) {
+  unsigned long hwcap = shace_hwcap();
+  return !hwcap || (hwcap & (HWCAP_ASIMD | HWCAP_SHA2)) ==
+                       (HWCAP_ASIMD | HWCAP_SHA2);
+}
+
+int mbedtls_shace_has_sha512(void) {
+  unsigned long hwcap = shace_hwcap();
+  return (hwcap & (HWCAP_ASIMD | HWCAP_SHA512)) ==
+         (HWCAP_ASIMD | HWCAP_SHA512);
+}
+
+#pragma GCC push_options
+#pragma GCC target("arch=armv8-a+crypto")
+
+static inline uint32x4_t shace_load32(const unsigned char *p) {
+  return vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(p)));
+}
+
+void mbedtls_shace_sha1_process(uint32_t state[5], const unsigned char *data,
+                                size_t blocks) {
+  static const uint32_t k[4] = {0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC,
+                                0xCA62C1D6};
+  int i;
+  uint32_t e, e0, e1;
+  uint32x4_t abcd, abcd0, t, m[4];
+  abcd = vld1q_u32(state);
+  e = state[4];
+  for (; blocks--; data += 64) {
+    abcd0 = abcd;
+    e0 = e;
+    for (i = 0; i < 4; ++i)
+      m[i] = shace_load32(data + i * 16);
+    for (i = 0; i < 20; ++i) {
+      t = vaddq_u32(m[i & 3], vdupq_n_u32(k[i / 5]));
+      e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+      if (i < 5) {
+        abcd = vsha1cq_u32(abcd, e, t);
+      } else if (i >= 10 && i < 15) {
+        abcd = vsha1mq_u32(abcd, e, t);
+      } else {
+        abcd = vsha1pq_u32(abcd, e, t);
+      }
+      e = e1;
+      if (i < 16)
+        m[i & 3] = vsha1su1q_u32(
+            vsha1su0q_u32(m[i & 3], m[(i + 1) & 3], m[(i + 2) & 3]),
+            m[(i + 3) & 3]);
+    }
+    abcd = vaddq_u32(abcd, abcd0);
+    e += e0;
+  }
+  vst1q_u32(state, abcd);
+  state[4] = e;
+}
+
+void mbedtls_shace_sha256_process(uint32_t state[8], const unsigned char *data,
+                                  size_t blocks) {
+  int i;
+  uint32x4_t s0, s1, a0, a1, t, u, m[4];
+  s0 = vld1q_u32(state);
+  s1 = vld1q_u32(state + 4);
+  for (; blocks--; data += 64) {
+    a0 = s0;
+    a1 = s1;
+    for (i = 0; i < 4; ++i)
+      m[i] = shace_load32(data + i * 16);
+    for (i = 0; i < 16; ++i) {
+      t = vaddq_u32(m[i & 3], vld1q_u32(kSha256 + i * 4));
+      u = s0;
+      s0 = vsha256hq_u32(s0, s1, t);
+      s1 = vsha256h2q_u32(s1, u, t);
+      if (i < 12)
+        m[i & 3] = vsha256su1q_u32(vsha256su0q_u32(m[i & 3], m[(i + 1) & 3]),
+                                   m[(i + 2) & 3], m[(i + 3) & 3]);
+    }
+    s0 = vaddq_u32(s0, a0);
+    s1 = vaddq_u32(s1, a1);
+  }
+  vst1q_u32(state, s0);
+  vst1q_u32(state + 4, s1);
+}
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("arch=armv8.2-a+sha3")
+
+// see the dround macro in linux's arch/arm64/crypto/sha512-ce-core.S
+// each call does two rounds, after which the role of each register
+// shifts over by one, i.e. the new (ab,cd,ef,gh) is (gh,ab,cd,ef)
+void mbedtls_shace_sha512_process(uint64_t state[8], const unsigned char *data,
+                                  size_t blocks) {
+  int i, j;
+  uint64x2_t s[4], a[4], t, v0, v1, x, m[8];
+  for (i = 0; i < 4; ++i)
+    s[i] = vld1q_u64(state + i * 2);
+  for (; blocks--; data += 128) {
+    for (i = 0; i < 4; ++i)
+      a[i] = s[i];
+    for (i = 0; i < 8; ++i)
+      m[i] = vreinterpretq_u64_u8(vrev64q_u8(vld1q_u8(data + i * 16)));
+    for (i = 0; i < 40; ++i) {
+      t = vaddq_u64(m[i & 7], vld1q_u64(kSha512 + i * 2));
+      t = vaddq_u64(vextq_u64(t, t, 1), a[3]);
+      v0 = vextq_u64(a[2], a[3], 1);
+      v1 = vextq_u64(a[1], a[2], 1);
+      t = vsha512hq_u64(t, v0, v1);
+      x = vsha512h2q_u64(t, a[1], a[0]);
+      a[3] = a[2];
+      a[2] = vaddq_u64(a[1], t);
+      a[1] = a[0];
+      a[0] = x;
+      if (i < 32) {
+        j = i & 7;
+        m[j] = vsha512su1q_u64(vsha512su0q_u64(m[j], m[(j + 1) & 7]),
+                               m[(j + 7) & 7],
+                               vextq_u64(m[(j + 4) & 7], m[(j + 5) & 7], 1));
+      }
+    }
+    for (i = 0; i < 4; ++i)
+      s[i] = vaddq_u64(s[i], a[i]);
+  }
+  for (i = 0; i < 4; ++i)
+    vst1q_u64(state + i * 2, s[i]);
+}
+
+#pragma GCC pop_options
+
+#endif /* __aarch64__ */
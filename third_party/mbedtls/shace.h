@@ -0,0 +1,13 @@
+#ifndef COSMOPOLITAN_THIRD_PARTY_MBEDTLS_SHACE_H_
+#define COSMOPOLITAN_THIRD_PARTY_MBEDTLS_SHACE_H_
+COSMOPOLITAN_C_START_
+
+int mbedtls_shace_has_sha1(void);
+int mbedtls_shace_has_sha256(void);
+int mbedtls_shace_has_sha512(void);
+void mbedtls_shace_sha1_process(uint32_t[5], const unsigned char *, size_t);
+void mbedtls_shace_sha256_process(uint32_t[8], const unsigned char *, size_t);
+void mbedtls_shace_sha512_process(uint64_t[8], const unsigned char *, size_t);
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_THIRD_PARTY_MBEDTLS_SHACE_H_ */
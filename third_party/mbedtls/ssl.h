@@ -882,6 +882,10 @@ struct mbedtls_ssl_config
     /** Callback to customize X.509 certificate chain verification          */
     int (*f_vrfy)(void *, mbedtls_x509_crt *, int, uint32_t *);
     void *p_vrfy;                   /*!< context for X.509 verify calllback */
+    /** Callback to remember chains that already passed verification       */
+    int (*f_vcache)(void *, const mbedtls_x509_crt *,
+                    const mbedtls_x509_crt *, const char *, int);
+    void *p_vcache;                 /*!< context for verify cache callback  */
 #endif
 #if defined(MBEDTLS_KEY_EXCHANGE_SOME_PSK_ENABLED)
     /** Callback to retrieve PSK key from identity                          */
@@ -1481,6 +1485,7 @@ void mbedtls_ssl_conf_sni( mbedtls_ssl_config *, int (*)(void *, mbedtls_ssl_con
 void mbedtls_ssl_conf_srtp_mki_value_supported( mbedtls_ssl_config *, int );
 void mbedtls_ssl_conf_transport( mbedtls_ssl_config *, int );
 void mbedtls_ssl_conf_verify( mbedtls_ssl_config *, int (*)(void *, mbedtls_x509_crt *, int, uint32_t *), void * );
+void mbedtls_ssl_conf_verify_cache( mbedtls_ssl_config *, int (*)(void *, const mbedtls_x509_crt *, const mbedtls_x509_crt *, const char *, int), void * );
 void mbedtls_ssl_config_free( mbedtls_ssl_config * );
 void mbedtls_ssl_config_init( mbedtls_ssl_config * );
 void mbedtls_ssl_free( mbedtls_ssl_context * );
@@ -2227,6 +2227,7 @@ static int ssl_parse_certificate_verify( mbedtls_ssl_context *ssl,
     const mbedtls_ssl_ciphersuite_t *ciphersuite_info =
         ssl->handshake->ciphersuite_info;
     int have_ca_chain = 0;
+    int use_vcache;
     int (*f_vrfy)(void *, mbedtls_x509_crt *, int, uint32_t *);
     void *p_vrfy;
     if( authmode == MBEDTLS_SSL_VERIFY_NONE )
@@ -2280,13 +2281,29 @@ static int ssl_parse_certificate_verify( mbedtls_ssl_context *ssl,
         }
         if( ca_chain != NULL )
             have_ca_chain = 1;
-        ret = mbedtls_x509_crt_verify_restartable(
-            chain,
-            ca_chain, ca_crl,
-            ssl->conf->cert_profile,
-            ssl->hostname,
-            &ssl->session_negotiate->verify_result,
-            f_vrfy, p_vrfy, rs_ctx );
+        use_vcache = ssl->conf->f_vcache != NULL && f_vrfy == NULL &&
+                     ca_chain != NULL && ca_crl == NULL;
+        if( use_vcache &&
+            !ssl->conf->f_vcache( ssl->conf->p_vcache, chain, ca_chain,
+                                  ssl->hostname, 0 ) )
+        {
+            MBEDTLS_SSL_DEBUG_MSG( 3, ( "X.509 CRT chain found in verify cache" ) );
+            ssl->session_negotiate->verify_result = 0;
+            ret = 0;
+        }
+        else
+        {
+            ret = mbedtls_x509_crt_verify_restartable(
+                chain,
+                ca_chain, ca_crl,
+                ssl->conf->cert_profile,
+                ssl->hostname,
+                &ssl->session_negotiate->verify_result,
+                f_vrfy, p_vrfy, rs_ctx );
+            if( use_vcache && ret == 0 )
+                ssl->conf->f_vcache( ssl->conf->p_vcache, chain, ca_chain,
+                                     ssl->hostname, 1 );
+        }
     }
     if( ret != 0 )
     {
@@ -3697,6 +3714,35 @@ void mbedtls_ssl_conf_verify( mbedtls_ssl_config *conf,
     conf->f_vrfy      = f_vrfy;
     conf->p_vrfy      = p_vrfy;
 }
+
+/**
+ * \brief          Set the verification cache callback (Optional).
+ *
+ *                 If set, the callback is first invoked with store set
+ *                 to 0 to look up the peer's chain, and should return
+ *                 0 if that exact chain, trust anchor and hostname were
+ *                 verified before and the result hasn't expired. When
+ *                 the lookup misses, the chain is verified normally and
+ *                 on success the callback is invoked again with store
+ *                 set to 1. The cache is never consulted when a verify
+ *                 callback or a CRL is configured, since those could
+ *                 change the outcome. Secondary checks, e.g. key usage,
+ *                 are always performed.
+ *
+ * \param conf     The SSL configuration to use.
+ * \param f_vcache The cache callback to use during CRT verification.
+ * \param p_vcache The opaque context to be passed to the callback.
+ */
+void mbedtls_ssl_conf_verify_cache( mbedtls_ssl_config *conf,
+                                    int (*f_vcache)(void *,
+                                                    const mbedtls_x509_crt *,
+                                                    const mbedtls_x509_crt *,
+                                                    const char *, int),
+                                    void *p_vcache )
+{
+    conf->f_vcache    = f_vcache;
+    conf->p_vcache    = p_vcache;
+}
 #endif /* MBEDTLS_X509_CRT_PARSE_C */
 
 /**
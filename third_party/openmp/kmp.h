@@ -3043,6 +3043,9 @@ typedef struct KMP_ALIGN_CACHE kmp_base_info {
   kmp_cond_align_t th_suspend_cv;
   kmp_mutex_align_t th_suspend_mx;
   std::atomic<int> th_suspend_init_count;
+#ifdef __COSMOPOLITAN__
+  std::atomic<int> th_suspend_seq; // bumped by resume; sleepers futex on it
+#endif
 #endif
 
 #if USE_ITT_BUILD
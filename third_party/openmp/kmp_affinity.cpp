@@ -27,6 +27,9 @@
 #define HWLOC_GROUP_KIND_WINDOWS_PROCESSOR_GROUP 220
 #endif
 #include <ctype.h>
+#ifdef __COSMOPOLITAN__
+#include <cosmo.h>
+#endif
 
 // The machine topology
 kmp_topology_t *__kmp_topology = nullptr;
@@ -1955,6 +1958,89 @@ static bool __kmp_affinity_create_hwloc_map(kmp_i18n_id_t *const msg_id) {
 }
 #endif // KMP_USE_HWLOC
 
+#ifdef __COSMOPOLITAN__
+// Create the topology map using cosmo_topology(), which asks the host OS
+// how logical CPUs share cores, L3 caches and sockets. This works the same
+// way on every platform where pthread_setaffinity_np() is supported, and
+// unlike the x2APIC method it doesn't need to migrate the current thread
+// onto every CPU in order to run cpuid there.
+static bool __kmp_affinity_create_cosmo_map(kmp_i18n_id_t *const msg_id) {
+  *msg_id = kmp_i18n_null;
+  if (!KMP_AFFINITY_CAPABLE())
+    return false;
+
+  int n = cosmo_topology(NULL, 0);
+  if (n <= 0)
+    return false;
+  struct CosmoCpu *cpus =
+      (struct CosmoCpu *)__kmp_allocate(sizeof(struct CosmoCpu) * n);
+  int m = cosmo_topology(cpus, n);
+  if (m < n)
+    n = m;
+
+  // Only describe levels that the OS actually told us about, since layers
+  // whose ids are all the same get removed by canonicalize() anyway.
+  bool have_core = false, have_l3 = false;
+  for (int i = 0; i < n; ++i) {
+    if (cpus[i].core != -1)
+      have_core = true;
+    if (cpus[i].l3 != -1)
+      have_l3 = true;
+  }
+  if (n <= 0 || !have_core) {
+    __kmp_free(cpus);
+    return false;
+  }
+  int depth = 0;
+  kmp_hw_t types[4];
+  types[depth++] = KMP_HW_SOCKET;
+  if (have_l3)
+    types[depth++] = KMP_HW_L3;
+  types[depth++] = KMP_HW_CORE;
+  types[depth++] = KMP_HW_THREAD;
+
+  if (__kmp_affinity.flags.verbose) {
+    KMP_INFORM(AffInfoStr, "KMP_AFFINITY", "Decoding cosmo_topology()");
+  }
+
+  __kmp_topology = kmp_topology_t::allocate(__kmp_avail_proc, depth, types);
+  int avail_ct = 0;
+  for (int i = 0; i < n; ++i) {
+    const struct CosmoCpu *c = cpus + i;
+    // Skip this proc if it is not included in the machine model.
+    if ((size_t)c->cpu >= __kmp_affin_mask_size * CHAR_BIT ||
+        !KMP_CPU_ISSET(c->cpu, __kmp_affin_fullMask)) {
+      continue;
+    }
+    if (avail_ct == __kmp_avail_proc)
+      break;
+    kmp_hw_thread_t &hw_thread = __kmp_topology->at(avail_ct++);
+    hw_thread.clear();
+    hw_thread.os_id = c->cpu;
+    int idx = 0;
+    hw_thread.ids[idx++] = c->package != -1 ? c->package : 0;
+    if (have_l3)
+      hw_thread.ids[idx++] = c->l3 != -1 ? c->l3 : c->cpu;
+    hw_thread.ids[idx++] = c->core != -1 ? c->core : c->cpu;
+    hw_thread.ids[idx++] = c->cpu;
+  }
+  __kmp_free(cpus);
+
+  if (avail_ct != __kmp_avail_proc) {
+    kmp_topology_t::deallocate(__kmp_topology);
+    __kmp_topology = nullptr;
+    return false;
+  }
+  __kmp_topology->sort_ids();
+  if (!__kmp_topology->check_ids()) {
+    kmp_topology_t::deallocate(__kmp_topology);
+    __kmp_topology = nullptr;
+    return false;
+  }
+  return true;
+}
+#endif // __COSMOPOLITAN__
+
 // If we don't know how to retrieve the machine's processor topology, or
 // encounter an error in doing so, this routine is called to form a "flat"
 // mapping of os thread id's <-> processor id's.
@@ -4424,6 +4510,15 @@ static bool __kmp_aux_affinity_initialize_topology(kmp_affinity_t &affinity) {
     }
 #endif
 
+#ifdef __COSMOPOLITAN__
+    if (!success) {
+      success = __kmp_affinity_create_cosmo_map(&msg_id);
+      if (!success && verbose && msg_id != kmp_i18n_null) {
+        KMP_INFORM(AffInfoStr, env_var, __kmp_i18n_catgets(msg_id));
+      }
+    }
+#endif
+
 #if KMP_ARCH_X86 || KMP_ARCH_X86_64
     if (!success) {
       success = __kmp_affinity_create_x2apicid_map(&msg_id);
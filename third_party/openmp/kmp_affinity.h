@@ -192,7 +192,7 @@ public:
 #endif /* KMP_USE_HWLOC */
 
 #if KMP_OS_LINUX || KMP_OS_FREEBSD
-#if KMP_OS_LINUX
+#if KMP_OS_LINUX && !defined(__COSMOPOLITAN__)
 /* On some of the older OS's that we build on, these constants aren't present
    in <asm/unistd.h> #included from <sys.syscall.h>. They must be the same on
    all systems of the same arch where they are defined, and they cannot change.
@@ -311,7 +311,7 @@ public:
 #else
 #error Unknown or unsupported architecture
 #endif /* KMP_ARCH_* */
-#elif KMP_OS_FREEBSD
+#elif KMP_OS_FREEBSD || defined(__COSMOPOLITAN__)
 #include <pthread.h>
 #endif
 class KMPNativeAffinity : public KMPAffinity {
@@ -1154,8 +1154,19 @@ __kmp_init_indirect_csptr(kmp_critical_name *crit, ident_t const *loc,
 
 #if KMP_USE_FUTEX
 
+#ifdef __COSMOPOLITAN__
+#include <cosmo.h>
+#define KMP_FUTEX_WAIT(addr, val)                                              \
+  cosmo_futex_wait((int *)(addr), val, false, 0, NULL)
+#define KMP_FUTEX_WAKE(addr, n) cosmo_futex_wake((int *)(addr), n, false)
+#else
 #include <sys/syscall.h>
 #include <unistd.h>
+#define KMP_FUTEX_WAIT(addr, val)                                              \
+  syscall(__NR_futex, addr, FUTEX_WAIT, val, NULL, NULL, 0)
+#define KMP_FUTEX_WAKE(addr, n)                                                \
+  syscall(__NR_futex, addr, FUTEX_WAKE, n, NULL, NULL, 0)
+#endif
 #ifndef FUTEX_WAIT
 #define FUTEX_WAIT 0
 #endif
@@ -1184,8 +1195,7 @@ __kmp_init_indirect_csptr(kmp_critical_name *crit, ident_t const *loc,
         poll_val |= KMP_LOCK_BUSY(1, futex);                                   \
       }                                                                        \
       kmp_int32 rc;                                                            \
-      if ((rc = syscall(__NR_futex, &(ftx->lk.poll), FUTEX_WAIT, poll_val,     \
-                        NULL, NULL, 0)) != 0) {                                \
+      if ((rc = KMP_FUTEX_WAIT(&(ftx->lk.poll), poll_val)) != 0) {             \
         continue;                                                              \
       }                                                                        \
       gtid_code |= 1;                                                          \
@@ -1215,8 +1225,7 @@ __kmp_init_indirect_csptr(kmp_critical_name *crit, ident_t const *loc,
     kmp_int32 poll_val =                                                       \
         KMP_XCHG_FIXED32(&(ftx->lk.poll), KMP_LOCK_FREE(futex));               \
     if (KMP_LOCK_STRIP(poll_val) & 1) {                                        \
-      syscall(__NR_futex, &(ftx->lk.poll), FUTEX_WAKE,                         \
-              KMP_LOCK_BUSY(1, futex), NULL, NULL, 0);                         \
+      KMP_FUTEX_WAKE(&(ftx->lk.poll), KMP_LOCK_BUSY(1, futex));                \
     }                                                                          \
     KMP_MB();                                                                  \
     KMP_YIELD_OVERSUB();                                                       \
@@ -19,6 +19,7 @@
 #include "kmp_stats.h"
 #include "kmp_str.h"
 #include "kmp_wait_release.h"
+#include "libc/cosmo.h"
 #include "libc/intrin/kprintf.h"
 #include "kmp_wrapper_getpid.h"
 
@@ -1490,7 +1491,22 @@ static inline void __kmp_suspend_template(int th_gtid, C *flag) {
       KMP_DEBUG_ASSERT(th->th.th_sleep_loc);
       KMP_DEBUG_ASSERT(flag->get_type() == th->th.th_sleep_loc_type);
 
-#if USE_SUSPEND_TIMEOUT
+#ifdef __COSMOPOLITAN__
+      // Sleep on a futex rather than the condition variable, so that the
+      // waker can drop the suspend mutex before waking us up. Otherwise we
+      // would wake up only to block again trying to reacquire the mutex,
+      // which shows up as fork/join latency for fine-grained loops.
+      int seq = KMP_ATOMIC_LD_ACQ(&th->th.th_suspend_seq);
+      KF_TRACE(15, ("__kmp_suspend_template: T#%d about to perform"
+                    " cosmo_futex_wait\n",
+                    th_gtid));
+      __kmp_unlock_suspend_mx(th);
+      status = -cosmo_futex_wait((int *)&th->th.th_suspend_seq, seq, false, 0,
+                                 NULL);
+      __kmp_lock_suspend_mx(th);
+      if (status == EAGAIN || status == ECANCELED)
+        status = 0;
+#elif USE_SUSPEND_TIMEOUT
       struct timespec now;
       struct timeval tval;
       int msecs;
@@ -1677,9 +1693,15 @@ static inline void __kmp_resume_template(int target_gtid, C *flag) {
                  target_gtid, buffer);
   }
 #endif
+#ifdef __COSMOPOLITAN__
+  KMP_ATOMIC_INC(&th->th.th_suspend_seq);
+  __kmp_unlock_suspend_mx(th);
+  cosmo_futex_wake((int *)&th->th.th_suspend_seq, 1, false);
+#else
   status = pthread_cond_signal(&th->th.th_suspend_cv.c_cond);
   KMP_CHECK_SYSFAIL("pthread_cond_signal", status);
   __kmp_unlock_suspend_mx(th);
+#endif
   KF_TRACE(30, ("__kmp_resume_template: T#%d exiting after signaling wake up"
                 " for T#%d\n",
                 gtid, target_gtid));
@@ -3904,6 +3904,28 @@ $(THIRD_PARTY_PYTHON_STAGE2_A_DATA_OBJS): private ZIPOBJ_FLAGS += -P.python -C3
 $(THIRD_PARTY_PYTHON_PYTEST_A_PYS_OBJS): private PYFLAGS += -P.python -C3
 $(THIRD_PARTY_PYTHON_PYTEST_A_DATA_OBJS): private ZIPOBJ_FLAGS += -P.python -C3
 
+# modules imported by every interpreter startup store their bytecode
+# without compression so the importer can unmarshal it in place
+THIRD_PARTY_PYTHON_STAGE2_A_PYS_STARTUP =				\
+	third_party/python/Lib/_bootlocale.py				\
+	third_party/python/Lib/_collections_abc.py			\
+	third_party/python/Lib/_sitebuiltins.py				\
+	third_party/python/Lib/_weakrefset.py				\
+	third_party/python/Lib/abc.py					\
+	third_party/python/Lib/codecs.py				\
+	third_party/python/Lib/encodings/__init__.py			\
+	third_party/python/Lib/encodings/aliases.py			\
+	third_party/python/Lib/encodings/latin_1.py			\
+	third_party/python/Lib/encodings/utf_8.py			\
+	third_party/python/Lib/genericpath.py				\
+	third_party/python/Lib/io.py					\
+	third_party/python/Lib/os.py					\
+	third_party/python/Lib/posixpath.py				\
+	third_party/python/Lib/site.py					\
+	third_party/python/Lib/stat.py					\
+
+$(THIRD_PARTY_PYTHON_STAGE2_A_PYS_STARTUP:%.py=o/$(MODE)/%.o): private PYFLAGS += -c
+
 o/$(MODE)/third_party/python/Python/ceval.o: private QUOTA = -C64 -L300
 o/$(MODE)/third_party/python/Objects/unicodeobject.o: private QUOTA += -C64 -L300
 
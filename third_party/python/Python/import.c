@@ -14,9 +14,11 @@
 #include "libc/mem/alg.h"
 #include "libc/mem/gc.h"
 #include "libc/mem/mem.h"
+#include "libc/runtime/zipos.internal.h"
 #include "libc/sysv/consts/o.h"
 #include "libc/sysv/consts/s.h"
 #include "libc/x/x.h"
+#include "libc/zip.h"
 #include "third_party/python/Include/Python-ast.h"
 #include "third_party/python/Include/abstract.h"
 #include "third_party/python/Include/bltinmodule.h"
@@ -2391,8 +2393,69 @@ typedef struct {
   Py_ssize_t namelen;
   Py_ssize_t pathlen;
   Py_ssize_t present;
+  Py_ssize_t cfile; /* central directory offset in zip store, or -1 */
 } SourcelessFileLoader;
 
+/* finds bytecode in the zip store without the overhead of stat(), and
+ * without walking parent directories when it isn't there, since most
+ * lookups for modules that aren't in the zip store are misses */
+static Py_ssize_t FindZipPyc(const char *path) {
+  ssize_t cf;
+  struct Zipos *zipos;
+  struct ZiposUri uri;
+  if (!(zipos = __zipos_get())) return -1;
+  if (__zipos_parseuri(path, &uri) == -1) return -1;
+  if ((cf = __zipos_scan(zipos, &uri)) == -1) return -1;
+  if (cf == ZIPOS_SYNTHETIC_DIRECTORY) return -1;
+  if (S_ISDIR(GetZipCfileMode(zipos->map + cf))) return -1;
+  return cf;
+}
+
+/* unmarshals bytecode in place if it was stored without compression,
+ * otherwise it's read from the inflated content shared with zipos, so
+ * no file descriptor or stdio buffer is needed either way */
+static PyObject *LoadZipPyc(const char *name, Py_ssize_t cf) {
+  size_t lf, size;
+  const char *data;
+  int32_t magic;
+  PyObject *res = NULL;
+  struct ZiposContent *content = NULL;
+  struct Zipos *zipos = __zipos_get();
+  lf = GetZipCfileOffset(zipos->map + cf);
+  size = GetZipLfileUncompressedSize(zipos->map + lf);
+  switch (ZIP_LFILE_COMPRESSIONMETHOD(zipos->map + lf)) {
+    case kZipCompressionNone:
+      data = (const char *)ZIP_LFILE_CONTENT(zipos->map + lf);
+      break;
+    case kZipCompressionDeflate:
+    case kZipCompressionZstd:
+      if (!(content = __zipos_content_acquire(zipos, cf)) ||
+          __zipos_stream_fill(content, size) == -1) {
+        PyErr_Format(PyExc_ImportError, "failed to inflate %s\n", name);
+        goto exit;
+      }
+      data = (const char *)content->data;
+      break;
+    default:
+      PyErr_Format(PyExc_ImportError, "bad compression method in %s\n", name);
+      goto exit;
+  }
+  if (size < 4 || (magic = READ32LE(data)) != PyImport_GetMagicNumber()) {
+    PyErr_Format(PyExc_ImportError, "bad magic number in %s: %d\n", name,
+                 size < 4 ? 0 : magic);
+    goto exit;
+  }
+  if (size < 12) {
+    PyErr_Format(PyExc_ImportError, "reached EOF while reading header in %s\n",
+                 name);
+    goto exit;
+  }
+  res = PyMarshal_ReadObjectFromString(data + 12, size - 12);
+exit:
+  if (content) __zipos_content_release(content);
+  return res;
+}
+
 static PyTypeObject SourcelessFileLoaderType;
 #define SourcelessFileLoaderCheck(o) (Py_TYPE(o) == &SourcelessFileLoaderType)
 
@@ -2406,6 +2469,7 @@ static SourcelessFileLoader *SFLObject_new(PyObject *cls, PyObject *args,
   obj->namelen = 0;
   obj->pathlen = 0;
   obj->present = 0;
+  obj->cfile = -1;
   return obj;
 }
 
@@ -2446,6 +2510,7 @@ static int SFLObject_init(SourcelessFileLoader *self, PyObject *args,
       self->name = strndup(name, namelen);
       self->path = strndup(path, pathlen);
       self->present = 0;
+      self->cfile = -1;
   }
   return result;
 }
@@ -2500,6 +2565,11 @@ static PyObject *SFLObject_get_code(SourcelessFileLoader *self, PyObject *arg) {
                  self->name, name);
     goto exit;
   }
+  if (self->cfile == -1) self->cfile = FindZipPyc(self->path);
+  if (self->cfile != -1) {
+    res = LoadZipPyc(name, self->cfile);
+    goto exit;
+  }
   self->present = self->present || !stat(self->path, &stinfo);
   if (!self->present || !(fp = fopen(self->path, "rb"))) {
     PyErr_Format(PyExc_ImportError, "%s does not exist\n", self->path);
@@ -2739,8 +2809,7 @@ static PyObject *CosmoImporter_find_spec(PyObject *cls, PyObject **args,
   int inside_zip = 0;
   int is_package = 0;
   int is_available = 0;
-
-  struct stat stinfo;
+  Py_ssize_t cf = -1;
 
   if (!_PyArg_ParseStackAndKeywords(args, nargs, kwargs, &_parser, &fullname,
                                     &path, &target)) {
@@ -2790,11 +2859,11 @@ static PyObject *CosmoImporter_find_spec(PyObject *cls, PyObject **args,
     if (newpath[i] == '.') newpath[i] = '/';
   }
 
-  is_available = inside_zip || !stat(newpath, &stinfo);
+  is_available = inside_zip || (cf = FindZipPyc(newpath)) != -1;
   if (is_package || !is_available) {
     memccpy(newpath + sizeof(basepath) + cnamelen - 1, "/__init__.pyc", '\0',
             newpathsize);
-    is_available = is_available || !stat(newpath, &stinfo);
+    is_available = is_available || (cf = FindZipPyc(newpath)) != -1;
     is_package = 1;
   }
 
@@ -2811,6 +2880,7 @@ static PyObject *CosmoImporter_find_spec(PyObject *cls, PyObject **args,
     loader->pathlen = newpathlen;
     loader->present = 1; /* this means we avoid atleast one stat call (the one
                             in SFLObject_get_code) */
+    loader->cfile = cf;   /* and the zip store lookup too */
     return _PyObject_CallMethodIdObjArgs(interp->importlib,
                                          &PyId__get_zipstore_spec, fullname,
                                          (PyObject *)loader, (PyObject *)origin,
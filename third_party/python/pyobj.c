@@ -89,6 +89,7 @@ FLAGS\n\
   -r           insert executable repl.c main\n\
   -t           insert unit test framework\n\
   -0           zip uncompressed\n\
+  -c           zip bytecode uncompressed, to unmarshal it in place\n\
   -n           do nothing\n\
   -h           help\n\
 \n"
@@ -228,6 +229,7 @@ static struct stat st;
 static PyObject *code;
 static PyObject *marsh;
 static bool nocompress;
+static bool nocompresspyc;
 static bool isunittest;
 static bool insertrunner;
 static bool insertlauncher;
@@ -243,7 +245,7 @@ GetOpts(int argc, char *argv[])
 {
     int opt;
     path_prefix = ".python";
-    while ((opt = getopt(argc, argv, "hnmtr0Bb:O:o:C:P:Y:")) != -1) {
+    while ((opt = getopt(argc, argv, "hnmtr0cBb:O:o:C:P:Y:")) != -1) {
         switch (opt) {
         case 'B':
             binonly = true;
@@ -254,6 +256,9 @@ GetOpts(int argc, char *argv[])
         case '0':
             nocompress = true;
             break;
+        case 'c':
+            nocompresspyc = true;
+            break;
         case 'r':
             insertrunner = true;
             insertlauncher = false;
@@ -657,7 +662,7 @@ Objectify(void)
     }
     elfwriter_zip(elf, gc(xstrcat("pyc:", modname)), gc(xstrcat(zipfile, 'c')),
                   strlen(zipfile) + 1, pycdata, pycsize, st.st_mode, timestamp,
-                  timestamp, timestamp, nocompress);
+                  timestamp, timestamp, nocompress || nocompresspyc);
     elfwriter_align(elf, 1, 0);
     elfwriter_startsection(elf, ".yoink", SHT_PROGBITS, 0);
     if (!(rc = AnalyzeModule(modname))) {
@@ -2714,6 +2714,51 @@ tre_ast_to_tnfa(tre_ast_node_t *node, tre_tnfa_transition_t *transitions,
  while (/*CONSTCOND*/0)
 
 
+/* Marks the ASCII characters that can't begin a match.  The parallel
+   matcher uses this table to skip over such characters, when it isn't
+   tracking any partial match, without running the automaton on them.
+   Characters outside ASCII aren't marked since they must be decoded.
+   Assertions are ignored, which only makes the table more permissive.
+   No table is made if the regex can match the empty string.  */
+static void
+tre_compute_firstpos_chars(tre_tnfa_t *tnfa)
+{
+  tre_tnfa_transition_t *init, *trans;
+  tre_cint_t c, hi;
+  char *skip;
+  int any;
+
+  for (init = tnfa->initial; init->state != NULL; init++)
+    if (init->state == tnfa->final)
+      return;
+
+  skip = xmalloc(128);
+  if (skip == NULL)
+    return;	/* It's only an optimization. */
+  skip[0] = 0;
+  for (c = 1; c < 128; c++)
+    skip[c] = 1;
+
+  for (init = tnfa->initial; init->state != NULL; init++)
+    for (trans = init->state; trans->state != NULL; trans++)
+      {
+	hi = trans->code_max < 127 ? trans->code_max : 127;
+	for (c = trans->code_min; c <= hi; c++)
+	  skip[c] = 0;
+      }
+
+  for (any = 0, c = 1; c < 128; c++)
+    any |= skip[c];
+  if (!any)
+    {
+      xfree(skip);
+      return;
+    }
+
+  tnfa->firstpos_chars = skip;
+}
+
+
 /**
  * Compiles regular expression, e.g.
  *
@@ -2921,6 +2966,7 @@ regcomp(regex_t *restrict preg, const char *restrict regex, int cflags)
   tnfa->final = transitions + offs[tree->lastpos[0].position];
   tnfa->num_states = parse_ctx.position;
   tnfa->cflags = cflags;
+  tre_compute_firstpos_chars(tnfa);
 
   tre_mem_destroy(mem);
   tre_stack_destroy(stack);
@@ -293,6 +293,22 @@ tre_tnfa_run_parallel(const tre_tnfa_t *tnfa, const void *string,
   reach_next_i = reach_next;
   while (1)
     {
+      /* If nothing is in flight and the characters ahead can't begin a
+	 match, skip over them without running the automaton.  They're
+	 all ASCII, so `prev_c' is simply the last byte that's skipped. */
+      if (match_eo < 0 && reach_next_i == reach_next && tnfa->firstpos_chars
+	  && (tre_cint_t)next_c < 128 && tnfa->firstpos_chars[next_c])
+	{
+	  const unsigned char *q = (const unsigned char *)str_byte;
+	  while (*q < 128 && tnfa->firstpos_chars[*q])
+	    q++;
+	  next_c = q[-1];
+	  pos = (const char *)q - (const char *)string - 1;
+	  pos_add_next = 1;
+	  str_byte = (const char *)q;
+	  GET_NEXT_WCHAR();
+	}
+
       /* If no match found yet, add the initial states to `reach_next'. */
       if (match_eo < 0)
 	{
@@ -0,0 +1,316 @@
+/*
+** 2026-10-15
+**
+** The author disclaims copyright to this source code.  In place of
+** a legal notice, here is a blessing:
+**
+**    May you do good and not evil.
+**    May you find forgiveness for yourself and forgive others.
+**    May you share freely, never taking more than you give.
+**
+******************************************************************************
+**
+** This file implements a read-only VFS named "zipos" that lets SQLite
+** query databases which were embedded in the zip structure of an APE
+** executable (i.e. paths beginning with /zip/) without extracting them
+** first.
+**
+** The whole database file is mapped into memory when it's opened. If
+** the zip entry is STORED and its content was aligned by the zip writer
+** (e.g. `zip -0` followed by `zipcopy -a`) then the cosmopolitan zipos
+** mmap() implementation maps pages straight from the executable, so the
+** kernel page cache gets shared by every process serving the database.
+** Otherwise the content is copied or inflated into anonymous memory just
+** once per open.
+**
+** Pages are served to the pager using xFetch(), which is only consulted
+** when the connection has a nonzero mmap_size, so connections should run
+** something like `PRAGMA mmap_size=2147418112` after opening.
+**
+** Files are reported as SQLITE_IOCAP_IMMUTABLE, so SQLite won't lock them
+** or look for hot journals and WAL files. Write access is downgraded to
+** read-only. Temporary files, e.g. for sorting, are delegated to the VFS
+** which was the default when this one got registered.
+*/
+#include "libc/calls/calls.h"
+#include "libc/calls/struct/stat.h"
+#include "libc/runtime/runtime.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/map.h"
+#include "libc/sysv/consts/o.h"
+#include "libc/sysv/consts/prot.h"
+#include "third_party/sqlite3/extensions.h"
+#include "third_party/sqlite3/sqlite3.h"
+
+/* Access to the lower-level VFS used for temporary files, randomness,
+** sleeping, etc.
+*/
+#define ORIGVFS(p)  ((sqlite3_vfs*)((p)->pAppData))
+
+/* An open zipvfs file
+**
+** If the file couldn't be mapped, then aMap is null and reads are made
+** with pread() on fd instead. Otherwise fd is -1.
+*/
+typedef struct ZipvfsFile ZipvfsFile;
+struct ZipvfsFile {
+  sqlite3_file base;        /* Subclass.  MUST BE FIRST! */
+  const unsigned char *aMap;  /* Content of the file, or null */
+  sqlite3_int64 szMap;      /* Number of bytes mapped at aMap */
+  sqlite3_int64 szFile;     /* Size of the file in bytes */
+  int fd;                   /* File descriptor if unmapped, otherwise -1 */
+};
+
+static int zipvfsClose(sqlite3_file *pFile){
+  ZipvfsFile *p = (ZipvfsFile*)pFile;
+  if( p->aMap ) munmap((void*)p->aMap, p->szMap);
+  if( p->fd!=-1 ) close(p->fd);
+  return SQLITE_OK;
+}
+
+static int zipvfsRead(
+  sqlite3_file *pFile,
+  void *zBuf,
+  int iAmt,
+  sqlite3_int64 iOfst
+){
+  ZipvfsFile *p = (ZipvfsFile*)pFile;
+  sqlite3_int64 nGot;
+  if( iOfst>=p->szFile ){
+    nGot = 0;
+  }else if( p->aMap ){
+    nGot = p->szFile - iOfst;
+    if( nGot>iAmt ) nGot = iAmt;
+    memcpy(zBuf, p->aMap + iOfst, nGot);
+  }else{
+    nGot = pread(p->fd, zBuf, iAmt, iOfst);
+    if( nGot<0 ) return SQLITE_IOERR_READ;
+  }
+  if( nGot<iAmt ){
+    memset((char*)zBuf + nGot, 0, iAmt - nGot);
+    return SQLITE_IOERR_SHORT_READ;
+  }
+  return SQLITE_OK;
+}
+
+static int zipvfsWrite(
+  sqlite3_file *pFile,
+  const void *zBuf,
+  int iAmt,
+  sqlite3_int64 iOfst
+){
+  return SQLITE_READONLY;
+}
+
+static int zipvfsTruncate(sqlite3_file *pFile, sqlite3_int64 size){
+  return SQLITE_READONLY;
+}
+
+static int zipvfsSync(sqlite3_file *pFile, int flags){
+  return SQLITE_OK;
+}
+
+static int zipvfsFileSize(sqlite3_file *pFile, sqlite3_int64 *pSize){
+  *pSize = ((ZipvfsFile*)pFile)->szFile;
+  return SQLITE_OK;
+}
+
+static int zipvfsLock(sqlite3_file *pFile, int eLock){
+  return SQLITE_OK;
+}
+
+static int zipvfsUnlock(sqlite3_file *pFile, int eLock){
+  return SQLITE_OK;
+}
+
+static int zipvfsCheckReservedLock(sqlite3_file *pFile, int *pResOut){
+  *pResOut = 0;
+  return SQLITE_OK;
+}
+
+static int zipvfsFileControl(sqlite3_file *pFile, int op, void *pArg){
+  if( op==SQLITE_FCNTL_VFSNAME ){
+    *(char**)pArg = sqlite3_mprintf("zipos");
+    return SQLITE_OK;
+  }
+  return SQLITE_NOTFOUND;
+}
+
+static int zipvfsSectorSize(sqlite3_file *pFile){
+  return 512;
+}
+
+static int zipvfsDeviceCharacteristics(sqlite3_file *pFile){
+  return SQLITE_IOCAP_IMMUTABLE;
+}
+
+/*
+** Return a pointer to iAmt bytes of the file starting at iOfst. This
+** is zero copy, since the mapping lives until the file is closed.
+*/
+static int zipvfsFetch(
+  sqlite3_file *pFile,
+  sqlite3_int64 iOfst,
+  int iAmt,
+  void **pp
+){
+  ZipvfsFile *p = (ZipvfsFile*)pFile;
+  if( p->aMap && iOfst+iAmt<=p->szFile ){
+    *pp = (void*)(p->aMap + iOfst);
+  }else{
+    *pp = 0;
+  }
+  return SQLITE_OK;
+}
+
+static int zipvfsUnfetch(sqlite3_file *pFile, sqlite3_int64 iOfst, void *p){
+  return SQLITE_OK;
+}
+
+static const sqlite3_io_methods zipvfs_io_methods = {
+  3,                              /* iVersion */
+  zipvfsClose,                    /* xClose */
+  zipvfsRead,                     /* xRead */
+  zipvfsWrite,                    /* xWrite */
+  zipvfsTruncate,                 /* xTruncate */
+  zipvfsSync,                     /* xSync */
+  zipvfsFileSize,                 /* xFileSize */
+  zipvfsLock,                     /* xLock */
+  zipvfsUnlock,                   /* xUnlock */
+  zipvfsCheckReservedLock,        /* xCheckReservedLock */
+  zipvfsFileControl,              /* xFileControl */
+  zipvfsSectorSize,               /* xSectorSize */
+  zipvfsDeviceCharacteristics,    /* xDeviceCharacteristics */
+  0,                              /* xShmMap */
+  0,                              /* xShmLock */
+  0,                              /* xShmBarrier */
+  0,                              /* xShmUnmap */
+  zipvfsFetch,                    /* xFetch */
+  zipvfsUnfetch                   /* xUnfetch */
+};
+
+static int zipvfsOpen(
+  sqlite3_vfs *pVfs,
+  const char *zName,
+  sqlite3_file *pFile,
+  int flags,
+  int *pOutFlags
+){
+  ZipvfsFile *p = (ZipvfsFile*)pFile;
+  struct stat st;
+  void *pMap;
+  int fd;
+  if( zName==0 || (flags & SQLITE_OPEN_MAIN_DB)==0 ){
+    return ORIGVFS(pVfs)->xOpen(ORIGVFS(pVfs), zName, pFile, flags, pOutFlags);
+  }
+  memset(p, 0, sizeof(*p));
+  p->fd = -1;
+  if( (fd = open(zName, O_RDONLY|O_CLOEXEC))==-1 ){
+    return SQLITE_CANTOPEN;
+  }
+  if( fstat(fd, &st) ){
+    close(fd);
+    return SQLITE_CANTOPEN;
+  }
+  p->szFile = st.st_size;
+  if( p->szFile>0
+   && (pMap = mmap(0, p->szFile, PROT_READ, MAP_PRIVATE, fd, 0))!=MAP_FAILED
+  ){
+    p->aMap = pMap;
+    p->szMap = p->szFile;
+    close(fd);
+  }else{
+    p->fd = fd;
+  }
+  if( pOutFlags ){
+    *pOutFlags = (flags & ~(SQLITE_OPEN_READWRITE|SQLITE_OPEN_CREATE))
+               | SQLITE_OPEN_READONLY;
+  }
+  pFile->pMethods = &zipvfs_io_methods;
+  return SQLITE_OK;
+}
+
+static int zipvfsDelete(sqlite3_vfs *pVfs, const char *zName, int syncDir){
+  return ORIGVFS(pVfs)->xDelete(ORIGVFS(pVfs), zName, syncDir);
+}
+
+static int zipvfsAccess(
+  sqlite3_vfs *pVfs,
+  const char *zName,
+  int flags,
+  int *pResOut
+){
+  return ORIGVFS(pVfs)->xAccess(ORIGVFS(pVfs), zName, flags, pResOut);
+}
+
+static int zipvfsFullPathname(
+  sqlite3_vfs *pVfs,
+  const char *zName,
+  int nOut,
+  char *zOut
+){
+  return ORIGVFS(pVfs)->xFullPathname(ORIGVFS(pVfs), zName, nOut, zOut);
+}
+
+static int zipvfsRandomness(sqlite3_vfs *pVfs, int nByte, char *zBufOut){
+  return ORIGVFS(pVfs)->xRandomness(ORIGVFS(pVfs), nByte, zBufOut);
+}
+
+static int zipvfsSleep(sqlite3_vfs *pVfs, int nMicro){
+  return ORIGVFS(pVfs)->xSleep(ORIGVFS(pVfs), nMicro);
+}
+
+static int zipvfsCurrentTime(sqlite3_vfs *pVfs, double *pTimeOut){
+  return ORIGVFS(pVfs)->xCurrentTime(ORIGVFS(pVfs), pTimeOut);
+}
+
+static int zipvfsGetLastError(sqlite3_vfs *pVfs, int a, char *b){
+  return ORIGVFS(pVfs)->xGetLastError(ORIGVFS(pVfs), a, b);
+}
+
+static int zipvfsCurrentTimeInt64(sqlite3_vfs *pVfs, sqlite3_int64 *p){
+  return ORIGVFS(pVfs)->xCurrentTimeInt64(ORIGVFS(pVfs), p);
+}
+
+static sqlite3_vfs zipvfs_vfs = {
+  2,                            /* iVersion */
+  0,                            /* szOsFile (set when registered) */
+  1024,                         /* mxPathname */
+  0,                            /* pNext */
+  "zipos",                      /* zName */
+  0,                            /* pAppData (set when registered) */
+  zipvfsOpen,                   /* xOpen */
+  zipvfsDelete,                 /* xDelete */
+  zipvfsAccess,                 /* xAccess */
+  zipvfsFullPathname,           /* xFullPathname */
+  0,                            /* xDlOpen */
+  0,                            /* xDlError */
+  0,                            /* xDlSym */
+  0,                            /* xDlClose */
+  zipvfsRandomness,             /* xRandomness */
+  zipvfsSleep,                  /* xSleep */
+  zipvfsCurrentTime,            /* xCurrentTime */
+  zipvfsGetLastError,           /* xGetLastError */
+  zipvfsCurrentTimeInt64        /* xCurrentTimeInt64 */
+};
+
+/*
+** Register the "zipos" VFS, unless it's already been registered. This
+** must be called after sqlite3_initialize(). It doesn't become the new
+** default VFS, so databases need to be opened with sqlite3_open_v2()
+** passing "zipos" as the zVfs argument, or with a `vfs=zipos` URI.
+*/
+int sqlite3_zipvfs_register(void){
+  sqlite3_vfs *pOrig;
+  if( sqlite3_vfs_find("zipos")==&zipvfs_vfs ) return SQLITE_OK;
+  if( (pOrig = sqlite3_vfs_find(0))==0 ) return SQLITE_ERROR;
+  zipvfs_vfs.pAppData = pOrig;
+  zipvfs_vfs.szOsFile = pOrig->szOsFile;
+  if( zipvfs_vfs.szOsFile<(int)sizeof(ZipvfsFile) ){
+    zipvfs_vfs.szOsFile = sizeof(ZipvfsFile);
+  }
+  if( zipvfs_vfs.mxPathname<pOrig->mxPathname ){
+    zipvfs_vfs.mxPathname = pOrig->mxPathname;
+  }
+  return sqlite3_vfs_register(&zipvfs_vfs, 0);
+}
@@ -19,6 +19,10 @@
 #include "ape/ape.h"
 #include "libc/assert.h"
 #include "libc/calls/calls.h"
+#include "libc/calls/struct/iovec.h"
+#include "libc/calls/struct/stat.h"
+#include "libc/calls/struct/timespec.h"
+#include "libc/cosmo.h"
 #include "libc/ctype.h"
 #include "libc/dce.h"
 #include "libc/dos.h"
@@ -29,10 +33,13 @@
 #include "libc/elf/struct/phdr.h"
 #include "libc/fmt/conv.h"
 #include "libc/fmt/itoa.h"
+#include "libc/intrin/atomic.h"
 #include "libc/limits.h"
 #include "libc/macho.h"
 #include "libc/macros.h"
+#include "libc/mem/alg.h"
 #include "libc/mem/mem.h"
+#include "libc/nexgen32e/crc32.h"
 #include "libc/nt/pedef.internal.h"
 #include "libc/nt/struct/imageimportbyname.internal.h"
 #include "libc/nt/struct/imageimportdescriptor.internal.h"
@@ -45,6 +52,7 @@
 #include "libc/stdio/stdio.h"
 #include "libc/stdio/sysparam.h"
 #include "libc/str/str.h"
+#include "libc/sysv/consts/at.h"
 #include "libc/sysv/consts/map.h"
 #include "libc/sysv/consts/o.h"
 #include "libc/sysv/consts/prot.h"
@@ -78,8 +86,14 @@
   "\n"                                                         \
   "  -o OUTPUT  set output path\n"                             \
   "\n"                                                         \
+  "  -u         only touch OUTPUT if it'd be unchanged\n"      \
+  "\n"                                                         \
   "  -s         never embed symbol table\n"                    \
   "\n"                                                         \
+  "  -a         align stored zip assets of 64kb or more on\n"  \
+  "             64kb boundaries so zipos can mmap() them\n"    \
+  "             without copying them into memory\n"            \
+  "\n"                                                         \
   "  -l PATH    bundle ape loader executable [repeatable]\n"   \
   "             if no ape loaders are specified then your\n"   \
   "             executable will self-modify its header on\n"   \
@@ -159,6 +173,9 @@
 
 #define BLAKE2B256_DIGEST_LENGTH 32
 
+#define kWriteChunk (4 * 1024 * 1024)  // split big writes for parallelism
+#define kBatchMax   256                // most iovecs passed to pwritev()
+
 #define ALIGN(p, a) (char *)ROUNDUP((uintptr_t)(p), (a))
 
 enum Strategy {
@@ -202,6 +219,9 @@ struct Input {
   struct NtImageNtHeaders *pe;
   struct OffsetRelocs offsetrelocs;
   struct MachoLoadSegment *first_macho_load;
+  unsigned char *symtab_lfile;
+  unsigned char *symtab_cfile;
+  uint8_t digest[BLAKE2B256_DIGEST_LENGTH];
 };
 
 struct Inputs {
@@ -223,6 +243,8 @@ struct Loader {
   char *ddarg_skip2;
   char *ddarg_size2;
   const char *kernel;
+  void *compressed_data;
+  size_t compressed_size;
 };
 
 struct Loaders {
@@ -238,14 +260,37 @@ struct Asset {
 struct Assets {
   int n;
   struct Asset *p;
+  int *table; /* open addressed index of p by name, or -1 if empty */
+  size_t mask;
   size_t total_centraldir_bytes;
   size_t total_local_file_bytes;
 };
 
+struct Write {
+  const void *data;
+  size_t size;
+  uint64_t offset;
+};
+
+struct Writes {
+  size_t n;
+  struct Write *p;
+};
+
+struct Batch {
+  size_t first;
+  int count;
+};
+
 static int outfd;
+static bool want_update;
+static struct Writes writes;
+static atomic_bool output_changed;
+static struct CosmoTaskPool *pool;
 static long hashes;
 static const char *prog;
 static bool want_stripped;
+static bool want_aligned_zips;
 static int support_vector;
 static int macholoadcount;
 static const char *outpath;
@@ -358,17 +403,22 @@ static bool IsBinary(const char *p, size_t n) {
   return false;
 }
 
-static void HashInput(const void *data, size_t size) {
+static void HashData(Hacl_Hash_Blake2b_state_t *state, const void *data,
+                     size_t size) {
   const uint8_t *bytes = data;
   uint32_t amt, chunk_size = 0x7ffff000;
-  Hacl_Hash_Blake2b_update(hasher, &size, sizeof(size));
+  Hacl_Hash_Blake2b_update(state, &size, sizeof(size));
   for (size_t i = 0; i < size; i += amt) {
     amt = MIN(size - i, chunk_size);
-    Hacl_Hash_Blake2b_update(hasher, bytes + i, amt);
-    ++hashes;
+    Hacl_Hash_Blake2b_update(state, bytes + i, amt);
   }
 }
 
+static void HashInput(const void *data, size_t size) {
+  HashData(hasher, data, size);
+  ++hashes;
+}
+
 static void HashInputString(const char *str) {
   HashInput(str, strlen(str));
 }
@@ -398,14 +448,143 @@ static char *LoadSourceCode(const char *path) {
   return text;
 }
 
+// runs func(i, j, arg) over [begin,end) on the task pool if we have one
+static void ParallelFor(long begin, long end, void func(long, long, void *),
+                        void *arg) {
+  if (pool) {
+    cosmo_parallel_for(pool, begin, end, 1, func, arg);
+  } else {
+    func(begin, end, arg);
+  }
+}
+
+// schedules data to be written to the output file by FlushWrites()
+//
+// nothing is copied, so `data` needs to stay valid and unchanged until
+// the output is written. big writes are split so they can be parallel.
 static void Pwrite(const void *data, size_t size, uint64_t offset) {
+  size_t n;
+  for (; size; data = (const char *)data + n, offset += n, size -= n) {
+    n = MIN(size, kWriteChunk);
+    writes.p = Realloc(writes.p, (writes.n + 1) * sizeof(*writes.p));
+    writes.p[writes.n].data = data;
+    writes.p[writes.n].size = n;
+    writes.p[writes.n].offset = offset;
+    ++writes.n;
+  }
+}
+
+static int CompareWrites(const void *a, const void *b) {
+  const struct Write *x = a;
+  const struct Write *y = b;
+  return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+static void WriteBatches(long i, long j, void *arg) {
+  int n;
   ssize_t rc;
-  const char *p, *e;
-  for (p = data, e = p + size; p < e; p += (size_t)rc, offset += (size_t)rc) {
-    if ((rc = pwrite(outfd, p, e - p, offset)) == -1) {
+  uint64_t off;
+  struct iovec *v, iov[kBatchMax];
+  struct Batch *batches = arg;
+  for (; i < j; ++i) {
+    struct Write *w = writes.p + batches[i].first;
+    for (n = 0; n < batches[i].count; ++n) {
+      iov[n].iov_base = (void *)w[n].data;
+      iov[n].iov_len = w[n].size;
+    }
+    off = w->offset;
+    for (v = iov; n;) {
+      if ((rc = pwritev(outfd, v, n, off)) <= 0)
+        DieSys(outpath);
+      off += rc;
+      for (; n && (size_t)rc >= v->iov_len; --n)
+        rc -= v++->iov_len;
+      if (n) {
+        v->iov_base = (char *)v->iov_base + rc;
+        v->iov_len -= rc;
+      }
+    }
+  }
+}
+
+// checks that scheduled writes [i,j) match the old output, along with
+// the holes after them, which would otherwise be filled with zeroes
+static void CompareOutput(long i, long j, void *arg) {
+  uint64_t k, end, next;
+  const unsigned char *old = arg;
+  for (; i < j && !atomic_load_explicit(&output_changed, memory_order_relaxed);
+       ++i) {
+    struct Write *w = writes.p + i;
+    end = w->offset + w->size;
+    next = i + 1 < writes.n ? writes.p[i + 1].offset : end;
+    if (memcmp(old + w->offset, w->data, w->size))
+      atomic_store(&output_changed, true);
+    for (k = end; k < next; ++k)
+      if (old[k])
+        atomic_store(&output_changed, true);
+  }
+}
+
+static bool IsOutputUnchanged(uint64_t size) {
+  int fd;
+  void *map;
+  struct stat st;
+  if ((fd = open(outpath, O_RDONLY)) == -1)
+    return false;
+  if (fstat(fd, &st) || st.st_size != size || !size) {
+    close(fd);
+    return false;
+  }
+  if ((map = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+    close(fd);
+    return false;
+  }
+  ParallelFor(0, writes.n, CompareOutput, map);
+  munmap(map, size);
+  close(fd);
+  return !atomic_load(&output_changed);
+}
+
+// writes output file all at once
+//
+// the file is sized up front, so threads never race to extend it, and
+// contiguous writes are coalesced into batches handed to pwritev(). we
+// don't mmap() the output, since running out of disk space would then
+// raise SIGBUS rather than ENOSPC.
+static void FlushWrites(void) {
+  size_t i, n;
+  uint64_t size;
+  struct Batch *batches;
+  qsort(writes.p, writes.n, sizeof(*writes.p), CompareWrites);
+  for (size = i = 0; i < writes.n; ++i) {
+    if (writes.p[i].offset < size)
+      Die(outpath, "overlapping writes to output file");
+    size = writes.p[i].offset + writes.p[i].size;
+  }
+  if (want_update && IsOutputUnchanged(size)) {
+    if (utimensat(AT_FDCWD, outpath, 0, 0))
       DieSys(outpath);
+    return;
+  }
+  batches = Malloc((writes.n + 1) * sizeof(*batches));
+  for (n = i = 0; i < writes.n; ++i) {
+    if (n && batches[n - 1].count < kBatchMax &&
+        writes.p[i - 1].offset + writes.p[i - 1].size == writes.p[i].offset) {
+      ++batches[n - 1].count;
+    } else {
+      batches[n].first = i;
+      batches[n].count = 1;
+      ++n;
     }
   }
+  if ((outfd = creat(outpath, 0755)) == -1)
+    DieSys(outpath);
+  if (ftruncate(outfd, size))
+    DieSys(outpath);
+  ParallelFor(0, n, WriteBatches, batches);
+  if (close(outfd))
+    DieSys(outpath);
+  free(batches);
 }
 
 static void LogElfPhdrs(FILE *f, Elf64_Phdr *p, size_t n) {
@@ -640,12 +819,49 @@ static bool IsSymbolWorthyOfSymtab(Elf64_Sym *sym) {
                               ELF64_ST_TYPE(sym->st_info) == STT_OBJECT);
 }
 
+static bool IsZipFileNameEqual(unsigned char *lfile1, unsigned char *lfile2) {
+  return ZIP_LFILE_NAMESIZE(lfile1) == ZIP_LFILE_NAMESIZE(lfile2) &&
+         !memcmp(ZIP_LFILE_NAME(lfile1), ZIP_LFILE_NAME(lfile2),
+                 ZIP_LFILE_NAMESIZE(lfile1));
+}
+
+static uint32_t HashZipAssetName(unsigned char *lfile) {
+  return crc32c(0, ZIP_LFILE_NAME(lfile), ZIP_LFILE_NAMESIZE(lfile));
+}
+
+// returns slot in assets.table where an asset with this name lives, or
+// the empty slot where it should go; the table is never more than half
+// full so this always terminates
+static int *FindZipAssetSlot(unsigned char *lfile) {
+  size_t i, step;
+  int *slot;
+  for (i = HashZipAssetName(lfile), step = 0;; i += ++step) {
+    slot = assets.table + (i & assets.mask);
+    if (*slot == -1 || IsZipFileNameEqual(lfile, assets.p[*slot].lfile))
+      return slot;
+  }
+}
+
+static void GrowZipAssetTable(void) {
+  int i;
+  size_t n = assets.mask ? (assets.mask + 1) * 2 : 64;
+  free(assets.table);
+  assets.table = Malloc(n * sizeof(*assets.table));
+  memset(assets.table, -1, n * sizeof(*assets.table));
+  assets.mask = n - 1;
+  for (i = 0; i < assets.n; ++i)
+    *FindZipAssetSlot(assets.p[i].lfile) = i;
+}
+
 static void AppendZipAsset(unsigned char *lfile, unsigned char *cfile) {
   if (assets.n == 65534)
     Die(outpath, "fat binary has >65534 zip assets");
+  if ((assets.n + 1) * 2 > assets.mask + 1)
+    GrowZipAssetTable();
   assets.p = Realloc(assets.p, (assets.n + 1) * sizeof(*assets.p));
   assets.p[assets.n].cfile = cfile;
   assets.p[assets.n].lfile = lfile;
+  *FindZipAssetSlot(lfile) = assets.n;
   assets.total_local_file_bytes += ZIP_LFILE_SIZE(lfile);
   assets.total_centraldir_bytes += ZIP_CFILE_HDRSIZE(cfile);
   ++assets.n;
@@ -669,24 +885,67 @@ static void *Compress(const void *data, size_t size, size_t *out_size, int wb) {
   return res;
 }
 
-static void *Deflate(const void *data, size_t size, size_t *out_size) {
-  return Compress(data, size, out_size, -MAX_WBITS);
-}
-
 static void *Gzip(const void *data, size_t size, size_t *out_size) {
   return Compress(data, size, out_size, MAX_WBITS + 16);
 }
 
-static void LoadSymbols(Elf64_Ehdr *e, Elf64_Off size, const char *path) {
-  const char *name = ConvertElfMachineToSymtabName(e);
+static void CompressLoaders(long i, long j, void *arg) {
+  for (; i < j; ++i) {
+    struct Loader *ldr = loaders.p + i;
+    if (ldr->used) {
+      ldr->compressed_data = Gzip(ldr->map, ldr->size, &ldr->compressed_size);
+    }
+  }
+}
+
+// creates serialized copy of symbol table whose string pool only holds
+// the names of symbols that were kept, rather than the whole elf strtab
+static struct SymbolTable *CompactSymbolTable(struct SymbolTable *st) {
+  size_t i, n, m, tsz;
+  for (m = 2, i = 0; i < st->count; ++i)
+    m += strlen(st->name_base + st->names[i]) + 1;
+  tsz = sizeof(struct SymbolTable);
+  tsz += sizeof(struct Symbol) * st->count;
+  tsz += sizeof(uint32_t) * st->count;
+  tsz += m;
+  struct SymbolTable *t = Malloc(tsz);
+  bzero(t, tsz);
+  t->magic = st->magic;
+  t->abi = st->abi;
+  t->count = st->count;
+  t->size = tsz;
+  t->mapsize = tsz;
+  t->addr_base = st->addr_base;
+  t->addr_end = st->addr_end;
+  t->names_offset =
+      sizeof(struct SymbolTable) + sizeof(struct Symbol) * st->count;
+  t->name_base_offset = t->names_offset + sizeof(uint32_t) * st->count;
+  memcpy(t->symbols, st->symbols, sizeof(struct Symbol) * st->count);
+  uint32_t *names = (uint32_t *)((char *)t + t->names_offset);
+  char *name_base = (char *)t + t->name_base_offset;
+  for (m = 1, i = 0; i < st->count; ++i) {
+    const char *s = st->name_base + st->names[i];
+    n = strlen(s) + 1;
+    memcpy(name_base + m, s, n);
+    names[i] = m;
+    m += n;
+  }
+  return t;
+}
+
+static void LoadSymbols(struct Input *in) {
+  const char *path = in->path;
+  const char *name = ConvertElfMachineToSymtabName(in->elf);
   size_t name_size = strlen(name);
-  struct SymbolTable *st = OpenSymbolTable(path);
-  if (!st)
+  struct SymbolTable *elf = OpenSymbolTable(path);
+  if (!elf)
     Die(path, "could not load elf symbol table");
-  st->names = 0;      // make this deterministic
-  st->name_base = 0;  // ready for serialization
-  size_t data_size;
-  void *data = Deflate(st, st->size, &data_size);
+  // store symbols uncompressed so the runtime can mmap() them in place
+  // and binary search them directly, without having to inflate a copy
+  struct SymbolTable *st = CompactSymbolTable(elf);
+  CloseSymbolTable(&elf);
+  size_t data_size = st->size;
+  void *data = st;
   uint32_t crc = crc32_z(0, st, st->size);
   size_t cfile_size = kZipCfileHdrMinSize + name_size;
   unsigned char *cfile = Malloc(cfile_size);
@@ -696,7 +955,7 @@ static void LoadSymbols(Elf64_Ehdr *e, Elf64_Off size, const char *path) {
             kZipOsUnix << 8 | kZipCosmopolitanVersion);
   WRITE16LE(cfile + kZipCfileOffsetVersionNeeded, kZipEra2001);
   WRITE16LE(cfile + kZipCfileOffsetGeneralflag, kZipGflagUtf8);
-  WRITE16LE(cfile + kZipCfileOffsetCompressionmethod, kZipCompressionDeflate);
+  WRITE16LE(cfile + kZipCfileOffsetCompressionmethod, kZipCompressionNone);
   WRITE16LE(cfile + kZipCfileOffsetLastmodifieddate, DOS_DATE(2023, 7, 29));
   WRITE16LE(cfile + kZipCfileOffsetLastmodifiedtime, DOS_TIME(0, 0, 0));
   WRITE32LE(cfile + kZipCfileOffsetCompressedsize, data_size);
@@ -711,7 +970,7 @@ static void LoadSymbols(Elf64_Ehdr *e, Elf64_Off size, const char *path) {
   WRITE32LE(lfile, kZipLfileHdrMagic);
   WRITE16LE(lfile + kZipLfileOffsetVersionNeeded, kZipEra2001);
   WRITE16LE(lfile + kZipLfileOffsetGeneralflag, kZipGflagUtf8);
-  WRITE16LE(lfile + kZipLfileOffsetCompressionmethod, kZipCompressionDeflate);
+  WRITE16LE(lfile + kZipLfileOffsetCompressionmethod, kZipCompressionNone);
   WRITE16LE(lfile + kZipLfileOffsetLastmodifieddate, DOS_DATE(2023, 7, 29));
   WRITE16LE(lfile + kZipLfileOffsetLastmodifiedtime, DOS_TIME(0, 0, 0));
   WRITE32LE(lfile + kZipLfileOffsetCompressedsize, data_size);
@@ -722,7 +981,8 @@ static void LoadSymbols(Elf64_Ehdr *e, Elf64_Off size, const char *path) {
   memcpy(lfile + kZipLfileHdrMinSize + name_size, data, data_size);
   unassert(ZIP_LFILE_SIZE(lfile) == lfile_size);
   free(data);
-  AppendZipAsset(lfile, cfile);
+  in->symtab_lfile = lfile;
+  in->symtab_cfile = cfile;
 }
 
 // resolves portable executable relative virtual address
@@ -997,7 +1257,7 @@ static void SetLoaderKernel(const char *kernel) {
 static void GetOpts(int argc, char *argv[]) {
   int opt, bits;
   bool got_support_vector = false;
-  while ((opt = getopt(argc, argv, "hvgsGBo:l:k:S:M:V:")) != -1) {
+  while ((opt = getopt(argc, argv, "hvagsuGBo:l:k:S:M:V:")) != -1) {
     switch (opt) {
       case 'o':
         outpath = optarg;
@@ -1006,6 +1266,10 @@ static void GetOpts(int argc, char *argv[]) {
         HashInputString("-s");
         want_stripped = true;
         break;
+      case 'a':
+        HashInputString("-a");
+        want_aligned_zips = true;
+        break;
       case 'V':
         HashInputString("-V");
         HashInputString(optarg);
@@ -1042,6 +1306,9 @@ static void GetOpts(int argc, char *argv[]) {
         HashInputString("-G");
         dont_path_lookup_ape_loader = true;
         break;
+      case 'u':
+        want_update = true;
+        break;
       case 'M':
         HashInputString("-M");
         macos_silicon_loader_source_path = optarg;
@@ -1632,10 +1899,40 @@ static void OpenInput(const char *path) {
     DieSys(path);
   if (!IsElf64Binary(in->elf, in->size))
     Die(path, "not an elf64 binary");
-  HashInput(in->map, in->size);
   close(fd);
 }
 
+// digests each input file on its own thread, before ValidateElfImage()
+// gets a chance to touch its program headers. the digests are hashed
+// afterwards, in command line order, so the output stays reproducible
+static void DigestInputs(long i, long j, void *arg) {
+  Hacl_Hash_Blake2b_state_t *state;
+  for (; i < j; ++i) {
+    struct Input *in = inputs.p + i;
+    if (!(state = Hacl_Hash_Blake2b_malloc_256()))
+      DieOom();
+    HashData(state, in->map, in->size);
+    Hacl_Hash_Blake2b_digest(state, in->digest);
+    Hacl_Hash_Blake2b_free(state);
+  }
+}
+
+static void ValidateInputs(long i, long j, void *arg) {
+  for (; i < j; ++i) {
+    struct Input *in = inputs.p + i;
+    ValidateElfImage(in->elf, in->size, in->path, false);
+  }
+}
+
+static void LoadInputSymbols(long i, long j, void *arg) {
+  for (; i < j; ++i) {
+    struct Input *in = inputs.p + i;
+    if (GetElfSymbol(in, "__zipos_get")) {
+      LoadSymbols(in);
+    }
+  }
+}
+
 static char *GenerateScriptIfMachine(char *p, struct Input *in) {
   if (in->elf->e_machine == EM_NEXGEN32E) {
     return stpcpy(p, "if [ \"$m\" = x86_64 ] || [ \"$m\" = amd64 ]; then\n");
@@ -1746,12 +2043,6 @@ static bool IsZipFileNamed(unsigned char *lfile, const char *name) {
          !memcmp(ZIP_LFILE_NAME(lfile), name, ZIP_LFILE_NAMESIZE(lfile));
 }
 
-static bool IsZipFileNameEqual(unsigned char *lfile1, unsigned char *lfile2) {
-  return ZIP_LFILE_NAMESIZE(lfile1) == ZIP_LFILE_NAMESIZE(lfile2) &&
-         !memcmp(ZIP_LFILE_NAME(lfile1), ZIP_LFILE_NAME(lfile2),
-                 ZIP_LFILE_NAMESIZE(lfile1));
-}
-
 static bool IsZipFileContentEqual(unsigned char *lfile1,
                                   unsigned char *lfile2) {
   return ZIP_LFILE_CRC32(lfile1) == ZIP_LFILE_CRC32(lfile2) &&
@@ -1762,20 +2053,17 @@ static bool IsZipFileContentEqual(unsigned char *lfile1,
 }
 
 static bool HasZipAsset(unsigned char *lfile) {
-  int i;
-  for (i = 0; i < assets.n; ++i) {
-    if (IsZipFileNameEqual(lfile, assets.p[i].lfile)) {
-      if (IsZipFileContentEqual(lfile, assets.p[i].lfile)) {
-        return true;
-      } else {
-        Die(outpath, "multiple ELF files define assets at the same ZIP path, "
-                     "but these duplicated assets can't be merged because they "
-                     "don't have exactly the same content; perhaps the build "
-                     "system is in an inconsistent state");
-      }
-    }
-  }
-  return false;
+  int *slot;
+  if (!assets.n)
+    return false;
+  if (*(slot = FindZipAssetSlot(lfile)) == -1)
+    return false;
+  if (!IsZipFileContentEqual(lfile, assets.p[*slot].lfile))
+    Die(outpath, "multiple ELF files define assets at the same ZIP path, "
+                 "but these duplicated assets can't be merged because they "
+                 "don't have exactly the same content; perhaps the build "
+                 "system is in an inconsistent state");
+  return true;
 }
 
 static unsigned char *GetZipEndOfCentralDirectory(struct Input *in) {
@@ -1840,6 +2128,27 @@ static void IndexZipAssetsFromElf(struct Input *in) {
   }
 }
 
+// orders assets the same way as the zipos index, so that programs don't
+// need to sort the central directory at startup
+static int CompareZipAssets(const void *a, const void *b) {
+  const struct Asset *x = a;
+  const struct Asset *y = b;
+  int xn = ZIP_CFILE_NAMESIZE(x->cfile);
+  int yn = ZIP_CFILE_NAMESIZE(y->cfile);
+  int rc = memcmp(ZIP_CFILE_NAME(x->cfile), ZIP_CFILE_NAME(y->cfile),
+                  MIN(xn, yn));
+  return rc ? rc : xn - yn;
+}
+
+// returns output offset of local file so its content is aligned
+static Elf64_Off AlignZipAsset(unsigned char *lfile, Elf64_Off off) {
+  if (want_aligned_zips &&
+      ZIP_LFILE_COMPRESSIONMETHOD(lfile) == kZipCompressionNone &&
+      ZIP_LFILE_COMPRESSEDSIZE(lfile) >= 65536)
+    off += -(off + ZIP_LFILE_HDRSIZE(lfile)) & 65535;
+  return off;
+}
+
 static void CopyZips(Elf64_Off offset) {
   int i;
   for (i = 0; i < inputs.n; ++i) {
@@ -1851,31 +2160,35 @@ static void CopyZips(Elf64_Off offset) {
   if (!assets.n) {
     return;  // nothing to do
   }
-  if (offset + assets.total_local_file_bytes + assets.total_centraldir_bytes +
-          kZipCdirHdrMinSize >
+  qsort(assets.p, assets.n, sizeof(*assets.p), CompareZipAssets);
+  Elf64_Off midpoint = offset;
+  for (i = 0; i < assets.n; ++i) {
+    unsigned char *lfile = assets.p[i].lfile;
+    midpoint = AlignZipAsset(lfile, midpoint) + ZIP_LFILE_SIZE(lfile);
+  }
+  if (midpoint + assets.total_centraldir_bytes + kZipCdirHdrMinSize >
       INT_MAX) {
     Die(outpath, "more than 2gb of zip files not supported yet");
   }
   Elf64_Off lp = offset;
-  Elf64_Off midpoint = offset + assets.total_local_file_bytes;
   Elf64_Off cp = midpoint;
   for (i = 0; i < assets.n; ++i) {
     unsigned char *cfile = assets.p[i].cfile;
-    WRITE32LE(cfile + kZipCfileOffsetOffset, lp);
     unsigned char *lfile = assets.p[i].lfile;
+    lp = AlignZipAsset(lfile, lp);
+    WRITE32LE(cfile + kZipCfileOffsetOffset, lp);
     Pwrite(lfile, ZIP_LFILE_SIZE(lfile), lp);
     lp += ZIP_LFILE_SIZE(lfile);
     Pwrite(cfile, ZIP_CFILE_HDRSIZE(cfile), cp);
     cp += ZIP_CFILE_HDRSIZE(cfile);
   }
   unassert(lp == midpoint);
-  unsigned char eocd[kZipCdirHdrMinSize] = {0};
+  static unsigned char eocd[kZipCdirHdrMinSize];
   WRITE32LE(eocd, kZipCdirHdrMagic);
   WRITE32LE(eocd + kZipCdirRecordsOnDiskOffset, assets.n);
   WRITE32LE(eocd + kZipCdirRecordsOffset, assets.n);
   WRITE32LE(eocd + kZipCdirSizeOffset, assets.total_centraldir_bytes);
-  WRITE32LE(eocd + kZipCdirOffsetOffset,
-            offset + assets.total_local_file_bytes);
+  WRITE32LE(eocd + kZipCdirOffsetOffset, midpoint);
   Pwrite(eocd, sizeof(eocd), cp);
 }
 
@@ -1900,6 +2213,9 @@ int main(int argc, char *argv[]) {
   // process flags
   GetOpts(argc, argv);
 
+  // linking is i/o and compression bound, so spread it across cores
+  pool = cosmo_taskpool_new(0);
+
   // determine strategy
   //
   // if we're only targeting a single architecture, and we're not
@@ -1951,18 +2267,22 @@ int main(int argc, char *argv[]) {
     }
   }
 
-  // validate input files
+  // hash input files
+  ParallelFor(0, inputs.n, DigestInputs, 0);
   for (i = 0; i < inputs.n; ++i) {
-    struct Input *in = inputs.p + i;
-    ValidateElfImage(in->elf, in->size, in->path, false);
+    HashInput(inputs.p[i].digest, sizeof(inputs.p[i].digest));
   }
 
+  // validate input files
+  ParallelFor(0, inputs.n, ValidateInputs, 0);
+
   // load symbols
   if (!want_stripped) {
+    ParallelFor(0, inputs.n, LoadInputSymbols, 0);
     for (i = 0; i < inputs.n; ++i) {
       struct Input *in = inputs.p + i;
-      if (GetElfSymbol(in, "__zipos_get")) {
-        LoadSymbols(in->elf, in->size, in->path);
+      if (in->symtab_lfile) {
+        AppendZipAsset(in->symtab_lfile, in->symtab_cfile);
       }
     }
   }
@@ -2011,7 +2331,10 @@ int main(int argc, char *argv[]) {
       p = stpcpy(p, custom_sh_code);
       *p++ = '\n';
     }
-    p = stpcpy(p, "o=$(command -v \"$0\")\n");
+    // avoid forking a subshell when $0 is already a path, because the
+    // fork costs more than everything else this script does on reruns
+    p = stpcpy(p, "case $0 in */*) o=\"$0\";; "
+                  "*) o=$(command -v \"$0\");; esac\n");
 
     // run this program using the systemwide ape loader if it exists
     if (loaders.n) {
@@ -2297,10 +2620,10 @@ int main(int argc, char *argv[]) {
   }
   prologue_bytes = p - prologue;
 
-  // write the output file
-  if ((outfd = creat(outpath, 0755)) == -1) {
-    DieSys(outpath);
-  }
+  // compress the ape loaders we're embedding
+  ParallelFor(0, loaders.n, CompressLoaders, 0);
+
+  // lay out the output file
   offset = prologue_bytes;
   for (i = 0; i < inputs.n; ++i) {
     offset = ThirdPass(offset, inputs.p + i);
@@ -2308,13 +2631,12 @@ int main(int argc, char *argv[]) {
 
   // concatenate ape loader binaries
   for (i = 0; i < loaders.n; ++i) {
-    char *compressed_data;
     size_t compressed_size;
     struct Loader *loader;
     loader = loaders.p + i;
     if (!loader->used)
       continue;
-    compressed_data = Gzip(loader->map, loader->size, &compressed_size);
+    compressed_size = loader->compressed_size;
     if (loader->ddarg_skip1) {
       FixupWordAsDecimal(loader->ddarg_skip1, offset);
     }
@@ -2327,23 +2649,21 @@ int main(int argc, char *argv[]) {
     if (loader->ddarg_size2) {
       FixupWordAsDecimal(loader->ddarg_size2, compressed_size);
     }
-    Pwrite(compressed_data, compressed_size, offset);
+    Pwrite(loader->compressed_data, compressed_size, offset);
     offset += compressed_size;
-    free(compressed_data);
   }
 
   // concatenate ape loader source code
+  char *compressed_source = 0;
   if (macos_silicon_loader_source_path) {
-    char *compressed_data;
     size_t compressed_size;
-    compressed_data =
+    compressed_source =
         Gzip(macos_silicon_loader_source_text,
              strlen(macos_silicon_loader_source_text), &compressed_size);
     FixupWordAsDecimal(macos_silicon_loader_source_ddarg_skip, offset);
     FixupWordAsDecimal(macos_silicon_loader_source_ddarg_size, compressed_size);
-    Pwrite(compressed_data, compressed_size, offset);
+    Pwrite(compressed_source, compressed_size, offset);
     offset += compressed_size;
-    free(compressed_data);
   }
 
   // add the zip files
@@ -2352,10 +2672,13 @@ int main(int argc, char *argv[]) {
   // write the header
   Pwrite(prologue, prologue_bytes, 0);
 
-  // finish output
-  if (close(outfd))
-    DieSys(outpath);
+  // write the output file
+  FlushWrites();
 
   // free memory
+  free(compressed_source);
+  for (i = 0; i < loaders.n; ++i)
+    free(loaders.p[i].compressed_data);
+  cosmo_taskpool_free(pool);
   Hacl_Hash_Blake2b_free(hasher);
 }
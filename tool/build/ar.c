@@ -273,58 +273,21 @@ static void MakeArHeader(struct ar_hdr *h,  //
   memcpy(h->ar_fmag, ARFMAG, sizeof(h->ar_fmag));
 }
 
-// copies data between file descriptors until end of file
+// copies data between file descriptors
 // - assumes signal handlers aren't in play
-// - uses copy_file_range() if possible
-// - returns number of bytes exchanged
+// - uses copy_file_range() or splice() if possible
 // - dies if operation fails
 static void CopyFileOrDie(const char *inpath, int infd,    //
                           const char *outpath, int outfd,  //
                           size_t offset, size_t size) {
-  char buf[512];
-  size_t exchanged;
-  enum { CFR, RW } mode;
-  ssize_t want, got, wrote;
+  ssize_t got;
   if (offset)
     if (lseek(infd, offset, SEEK_SET) == -1)
       SysDie(inpath, "lseek");
-  for (mode = CFR; size; size -= exchanged) {
-    if (mode == CFR) {
-      want = 4194304;
-      if (want > size)
-        want = size;
-      got = copy_file_range(infd, 0, outfd, 0, want, 0);
-      if (!got)
-        Die(inpath, "unexpected eof");
-      if (got != -1) {
-        exchanged = got;
-      } else if (errno == EXDEV ||       // different partitions
-                 errno == EINVAL ||      // possible w/ ecryptfs
-                 errno == ENOSYS ||      // not linux or freebsd
-                 errno == ENOTSUP ||     // probably a /zip file
-                 errno == EOPNOTSUPP) {  // technically the same
-        exchanged = 0;
-        mode = RW;
-      } else {
-        SysDie(inpath, "copy_file_range");
-      }
-    } else {
-      want = sizeof(buf);
-      if (want > size)
-        want = size;
-      got = read(infd, buf, want);
-      if (!got)
-        Die(inpath, "unexpected eof");
-      if (got == -1)
-        SysDie(inpath, "read");
-      wrote = write(outfd, buf, got);
-      if (wrote == -1)
-        SysDie(outpath, "write");
-      if (wrote != got)
-        Die(outpath, "posix violated");
-      exchanged = wrote;
-    }
-  }
+  if ((got = copyfd(infd, outfd, size)) == -1)
+    SysDie(outpath, "copyfd");
+  if (got != size)
+    Die(inpath, "unexpected eof");
 }
 
 static void AppendName(const char *name, struct Args *names,
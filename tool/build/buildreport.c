@@ -0,0 +1,518 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/errno.h"
+#include "libc/fmt/conv.h"
+#include "libc/limits.h"
+#include "libc/macros.h"
+#include "libc/mem/alg.h"
+#include "libc/mem/mem.h"
+#include "libc/runtime/runtime.h"
+#include "libc/stdio/stdio.h"
+#include "libc/str/str.h"
+#include "libc/x/x.h"
+#include "third_party/getopt/getopt.internal.h"
+
+/**
+ * @fileoverview Build Performance Report.
+ */
+
+#define VERSION                     \
+  "buildreport v1.0\n"              \
+  "copyright 2024 justine tunney\n" \
+  "https://github.com/jart/cosmopolitan\n"
+
+#define MANUAL                                                   \
+  " [FLAGS] LOG...\n"                                            \
+  "\n"                                                           \
+  "DESCRIPTION\n"                                                \
+  "\n"                                                           \
+  "  Summarizes the COMPILE_LOG records written by the\n"        \
+  "  compile command, e.g.\n"                                    \
+  "\n"                                                           \
+  "      rm -f /tmp/build.log\n"                                 \
+  "      make -j COMPILE_LOG=/tmp/build.log\n"                   \
+  "      buildreport -t /tmp/build.json /tmp/build.log\n"        \
+  "\n"                                                           \
+  "  This prints the critical path of the build, which is\n"     \
+  "  the chain of commands that had to run one after the\n"      \
+  "  other, plus the slowest targets. Records for the same\n"    \
+  "  target are merged, e.g. an object and its fixupobj\n"       \
+  "  pass. Logs don't know the dependency graph, so unless\n"    \
+  "  -d is passed, it's assumed each target waited on the\n"     \
+  "  target which most recently finished before it started.\n"   \
+  "\n"                                                           \
+  "FLAGS\n"                                                      \
+  "\n"                                                           \
+  "  -h         show usage\n"                                    \
+  "  -v         show version\n"                                  \
+  "  -n COUNT   number of slowest targets shown [default 20]\n"  \
+  "  -d DEPS    load make style `TARGET: DEP...` rules that\n"   \
+  "             say which targets wait on others [repeatable]\n" \
+  "  -t TRACE   write chrome://tracing or perfetto json file\n"  \
+  "\n"
+
+struct Record {
+  char *target;
+  char *action;
+  long start;
+  long end;
+  long cpu;
+  long rss;
+  bool cached;
+  int exitcode;
+};
+
+struct Records {
+  long n;
+  struct Record *p;
+};
+
+struct Node {
+  char *target;
+  long start;
+  long end;
+  long cpu;
+  long rss;
+  int records;
+  int cached;
+  long pred;
+};
+
+struct Nodes {
+  long n;
+  struct Node *p;
+};
+
+struct Edge {
+  long from;
+  long to;
+};
+
+struct Edges {
+  long n;
+  struct Edge *p;
+};
+
+static int topcount = 20;
+static const char *prog;
+static const char *tracepath;
+static struct Edges edges;
+static struct Nodes nodes;
+static struct Records records;
+static char **depfiles;
+static int depfilecount;
+
+[[noreturn]] static void Die(const char *thing, const char *reason) {
+  tinyprint(2, thing, ": ", reason, "\n", NULL);
+  exit(1);
+}
+
+[[noreturn]] static void DieSys(const char *thing) {
+  perror(thing);
+  exit(1);
+}
+
+[[noreturn]] static void DieOom(void) {
+  Die(prog, "out of memory");
+}
+
+[[noreturn]] static void ShowUsage(int rc, int fd) {
+  tinyprint(fd, VERSION, "\nUSAGE\n\n  ", prog, MANUAL, NULL);
+  exit(rc);
+}
+
+static void *Malloc(size_t n) {
+  void *p;
+  if (!(p = malloc(n)))
+    DieOom();
+  return p;
+}
+
+static void *Realloc(void *p, size_t n) {
+  if (!(p = realloc(p, n)))
+    DieOom();
+  return p;
+}
+
+static void GetOpts(int argc, char *argv[]) {
+  int opt;
+  while ((opt = getopt(argc, argv, "hvn:d:t:")) != -1) {
+    switch (opt) {
+      case 'n':
+        topcount = atoi(optarg);
+        break;
+      case 'd':
+        depfiles = Realloc(depfiles, (depfilecount + 1) * sizeof(*depfiles));
+        depfiles[depfilecount++] = optarg;
+        break;
+      case 't':
+        tracepath = optarg;
+        break;
+      case 'v':
+        tinyprint(1, VERSION, NULL);
+        exit(0);
+      case 'h':
+        ShowUsage(0, 1);
+      default:
+        ShowUsage(1, 2);
+    }
+  }
+  if (optind == argc) {
+    Die(prog, "missing log argument");
+  }
+}
+
+static char *Slurp(const char *path) {
+  char *s;
+  if (!(s = xslurp(path, 0)))
+    DieSys(path);
+  return s;
+}
+
+// splits fields of a COMPILE_LOG line in place, see tool/build/compile.c
+static bool ParseRecord(char *line, struct Record *r) {
+  int i;
+  char *f[8];
+  for (i = 0; i < 8; ++i) {
+    f[i] = line;
+    if (i < 7) {
+      if (!(line = strchr(line, '\t')))
+        return false;
+      *line++ = 0;
+    }
+  }
+  r->target = f[0];
+  r->action = f[1];
+  r->start = atol(f[2]);
+  r->end = atol(f[3]);
+  r->cpu = atol(f[4]);
+  r->rss = atol(f[5]);
+  r->cached = !!atoi(f[6]);
+  r->exitcode = atoi(f[7]);
+  return *r->target && r->end >= r->start;
+}
+
+static void LoadLog(const char *path) {
+  long lineno;
+  struct Record r;
+  char *s, *line;
+  s = Slurp(path);
+  for (lineno = 1; (line = strsep(&s, "\n")); ++lineno) {
+    if (!*line)
+      continue;
+    if (!ParseRecord(line, &r)) {
+      fprintf(stderr, "%s:%ld: warning: ignoring malformed record\n", path,
+              lineno);
+      continue;
+    }
+    records.p = Realloc(records.p, (records.n + 1) * sizeof(*records.p));
+    records.p[records.n++] = r;
+  }
+}
+
+static int CompareRecordsByTarget(const void *a, const void *b) {
+  const struct Record *x = a;
+  const struct Record *y = b;
+  return strcmp(x->target, y->target);
+}
+
+// merges records for the same target into nodes sorted by name
+static void BuildNodes(void) {
+  long i;
+  struct Node *n;
+  struct Record *r;
+  qsort(records.p, records.n, sizeof(*records.p), CompareRecordsByTarget);
+  nodes.p = Malloc(records.n * sizeof(*nodes.p));
+  for (i = 0; i < records.n; ++i) {
+    r = records.p + i;
+    if (nodes.n && !strcmp(nodes.p[nodes.n - 1].target, r->target)) {
+      n = nodes.p + nodes.n - 1;
+      n->start = MIN(n->start, r->start);
+      n->end = MAX(n->end, r->end);
+      n->cpu += r->cpu;
+      n->rss = MAX(n->rss, r->rss);
+      n->records += 1;
+      n->cached += r->cached;
+    } else {
+      n = nodes.p + nodes.n++;
+      n->target = r->target;
+      n->start = r->start;
+      n->end = r->end;
+      n->cpu = r->cpu;
+      n->rss = r->rss;
+      n->records = 1;
+      n->cached = r->cached;
+    }
+    n->pred = -1;
+  }
+}
+
+static long FindNode(const char *target) {
+  int c;
+  long l, r, m;
+  l = 0;
+  r = nodes.n;
+  while (l < r) {
+    m = l + (r - l) / 2;
+    if (!(c = strcmp(nodes.p[m].target, target)))
+      return m;
+    if (c < 0) {
+      l = m + 1;
+    } else {
+      r = m;
+    }
+  }
+  return -1;
+}
+
+static void AppendEdge(long from, long to) {
+  if (from == to)
+    return;
+  edges.p = Realloc(edges.p, (edges.n + 1) * sizeof(*edges.p));
+  edges.p[edges.n++] = (struct Edge){from, to};
+}
+
+// loads make rules, where recipe lines, comments, and variable
+// assignments are ignored, and only logged targets are remembered
+static void LoadDeps(const char *path) {
+  int ntargets;
+  long targets[16];
+  char *s, *p, *q, *word, *text;
+  bool isrhs;
+  s = text = Slurp(path);
+  for (p = s; (q = strchr(p, '\\')); p = q + 1)
+    if (q[1] == '\n')
+      q[0] = q[1] = ' ';
+  while ((p = strsep(&s, "\n"))) {
+    if (*p == '\t' || *p == '#')
+      continue;
+    if (!(q = strchr(p, ':')) || q[1] == '=' || q[1] == ':')
+      continue;
+    ntargets = 0;
+    for (isrhs = false; (word = strsep(&p, " \t"));) {
+      if (!*word || !strcmp(word, "|"))
+        continue;
+      if (!isrhs) {
+        size_t n = strlen(word);
+        if ((isrhs = word[n - 1] == ':'))
+          word[n - 1] = 0;
+        if (*word && ntargets < ARRAYLEN(targets))
+          targets[ntargets++] = FindNode(word);
+        continue;
+      }
+      long to = FindNode(word);
+      if (to == -1)
+        continue;
+      for (int i = 0; i < ntargets; ++i)
+        if (targets[i] != -1)
+          AppendEdge(targets[i], to);
+    }
+  }
+  free(text);
+}
+
+static int CompareEdges(const void *a, const void *b) {
+  const struct Edge *x = a;
+  const struct Edge *y = b;
+  return (x->from > y->from) - (x->from < y->from);
+}
+
+static int CompareNodesByEnd(const void *a, const void *b) {
+  const struct Node *x = nodes.p + *(const long *)a;
+  const struct Node *y = nodes.p + *(const long *)b;
+  return (x->end > y->end) - (x->end < y->end);
+}
+
+static int CompareNodesByWallDescending(const void *a, const void *b) {
+  const struct Node *x = nodes.p + *(const long *)a;
+  const struct Node *y = nodes.p + *(const long *)b;
+  long xw = x->end - x->start;
+  long yw = y->end - y->start;
+  return (xw < yw) - (xw > yw);
+}
+
+// figures out which target each target was waiting on
+//
+// when dependencies are known, it's the dependency which finished last.
+// otherwise we guess it's whichever target finished most recently when
+// the target started, which is where make would have unblocked it.
+static void LinkNodes(const long *byend) {
+  long i, j, l, r, m;
+  if (depfilecount) {
+    qsort(edges.p, edges.n, sizeof(*edges.p), CompareEdges);
+    for (i = 0; i < edges.n; i = j) {
+      struct Node *n = nodes.p + edges.p[i].from;
+      for (j = i; j < edges.n && edges.p[j].from == edges.p[i].from; ++j) {
+        struct Node *d = nodes.p + edges.p[j].to;
+        if (d->end > n->end)
+          continue;
+        if (n->pred == -1 || d->end > nodes.p[n->pred].end)
+          n->pred = edges.p[j].to;
+      }
+    }
+  } else {
+    for (i = 0; i < nodes.n; ++i) {
+      l = 0;
+      r = nodes.n;
+      while (l < r) {
+        m = l + (r - l) / 2;
+        if (nodes.p[byend[m]].end <= nodes.p[i].start) {
+          l = m + 1;
+        } else {
+          r = m;
+        }
+      }
+      while (l && byend[l - 1] == i)
+        --l;
+      if (l)
+        nodes.p[i].pred = byend[l - 1];
+    }
+  }
+}
+
+static void PrintReport(const long *byend) {
+  long i, k, t0, t1, len, *path;
+  if (!nodes.n)
+    Die(prog, "no records found");
+  t0 = LONG_MAX;
+  t1 = LONG_MIN;
+  for (i = 0; i < records.n; ++i) {
+    t0 = MIN(t0, records.p[i].start);
+    t1 = MAX(t1, records.p[i].end);
+  }
+  printf("build took %,ldµs running %,ld commands for %,ld targets\n",
+         t1 - t0, records.n, nodes.n);
+
+  // walk critical path backwards from the target that finished last,
+  // bounding the steps in case the rules we were given have a cycle
+  path = Malloc(nodes.n * sizeof(*path));
+  for (k = 0, i = byend[nodes.n - 1]; i != -1 && k < nodes.n;
+       i = nodes.p[i].pred)
+    path[k++] = i;
+  for (len = i = 0; i < k; ++i)
+    len += nodes.p[path[i]].end - nodes.p[path[i]].start;
+  printf("\ncritical path is %,ldµs of work over %,ld targets\n\n", len, k);
+  printf("%14s %14s %12s  %s\n", "start", "wall", "idle", "target");
+  for (i = k; i--;) {
+    struct Node *n = nodes.p + path[i];
+    long idle = i + 1 < k ? n->start - nodes.p[path[i + 1]].end : 0;
+    printf("%,14ld %,14ld %,12ld  %s%s\n", n->start - t0, n->end - n->start,
+           MAX(idle, 0), n->target, n->cached == n->records ? " (cached)" : "");
+  }
+  free(path);
+
+  // list slowest targets
+  long *bywall = Malloc(nodes.n * sizeof(*bywall));
+  for (i = 0; i < nodes.n; ++i)
+    bywall[i] = i;
+  qsort(bywall, nodes.n, sizeof(*bywall), CompareNodesByWallDescending);
+  printf("\nslowest targets\n\n");
+  printf("%14s %14s %10s  %s\n", "wall", "cpu", "rss", "target");
+  for (i = 0; i < nodes.n && i < topcount; ++i) {
+    struct Node *n = nodes.p + bywall[i];
+    printf("%,14ld %,14ld %,9ldk  %s\n", n->end - n->start, n->cpu, n->rss,
+           n->target);
+  }
+  free(bywall);
+}
+
+static int CompareRecordsByStart(const void *a, const void *b) {
+  const struct Record *x = a;
+  const struct Record *y = b;
+  return (x->start > y->start) - (x->start < y->start);
+}
+
+static void PrintJsonString(FILE *f, const char *s) {
+  int c;
+  fputc('"', f);
+  for (; (c = *s++ & 255);) {
+    if (c == '"' || c == '\\') {
+      fputc('\\', f);
+      fputc(c, f);
+    } else if (c < ' ') {
+      fprintf(f, "\\u%04x", c);
+    } else {
+      fputc(c, f);
+    }
+  }
+  fputc('"', f);
+}
+
+// writes trace event format json, where concurrent commands are put
+// on separate rows, so it's easy to see when the build was starved
+static void WriteTrace(const char *path) {
+  FILE *f;
+  long i, j, t0, *lanes = 0;
+  long nlanes = 0;
+  if (!(f = fopen(path, "w")))
+    DieSys(path);
+  qsort(records.p, records.n, sizeof(*records.p), CompareRecordsByStart);
+  t0 = records.n ? records.p[0].start : 0;
+  fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+  for (i = 0; i < records.n; ++i) {
+    struct Record *r = records.p + i;
+    for (j = 0; j < nlanes && lanes[j] > r->start; ++j) {
+    }
+    if (j == nlanes)
+      lanes = Realloc(lanes, ++nlanes * sizeof(*lanes));
+    lanes[j] = r->end;
+    fputs(i ? ",\n{\"name\":" : "{\"name\":", f);
+    PrintJsonString(f, r->target);
+    fputs(",\"cat\":", f);
+    PrintJsonString(f, r->action);
+    fprintf(f,
+            ",\"ph\":\"X\",\"pid\":1,\"tid\":%ld,\"ts\":%ld,\"dur\":%ld,"
+            "\"args\":{\"cpu_us\":%ld,\"rss_kb\":%ld,\"cached\":%s,"
+            "\"exitcode\":%d}}",
+            j + 1, r->start - t0, r->end - r->start, r->cpu, r->rss,
+            r->cached ? "true" : "false", r->exitcode);
+  }
+  fputs("\n]}\n", f);
+  if (fclose(f))
+    DieSys(path);
+  free(lanes);
+}
+
+int main(int argc, char *argv[]) {
+  long i, *byend;
+
+  prog = argv[0];
+  if (!prog)
+    prog = "buildreport";
+  GetOpts(argc, argv);
+
+  for (i = optind; i < argc; ++i)
+    LoadLog(argv[i]);
+  BuildNodes();
+  for (i = 0; i < depfilecount; ++i)
+    LoadDeps(depfiles[i]);
+
+  byend = Malloc((nodes.n + 1) * sizeof(*byend));
+  for (i = 0; i < nodes.n; ++i)
+    byend[i] = i;
+  qsort(byend, nodes.n, sizeof(*byend), CompareNodesByEnd);
+  LinkNodes(byend);
+  PrintReport(byend);
+  free(byend);
+
+  if (tracepath)
+    WriteTrace(tracepath);
+  return 0;
+}
@@ -51,6 +51,7 @@
 #include "libc/runtime/runtime.h"
 #include "libc/serialize.h"
 #include "libc/stdio/append.h"
+#include "libc/str/blake2.h"
 #include "libc/str/str.h"
 #include "libc/sysv/consts/at.h"
 #include "libc/sysv/consts/auxv.h"
@@ -58,6 +59,7 @@
 #include "libc/sysv/consts/itimer.h"
 #include "libc/sysv/consts/o.h"
 #include "libc/sysv/consts/posix.h"
+#include "libc/sysv/consts/rusage.h"
 #include "libc/sysv/consts/s.h"
 #include "libc/sysv/consts/sa.h"
 #include "libc/sysv/consts/sig.h"
@@ -65,7 +67,9 @@
 #include "libc/thread/thread.h"
 #include "libc/time.h"
 #include "libc/x/x.h"
+#include "libc/x/xasprintf.h"
 #include "third_party/getopt/getopt.internal.h"
+#include "tool/build/lib/fixupobj.h"
 
 #ifndef NDEBUG
 __static_yoink("zipos");
@@ -109,6 +113,7 @@ DESCRIPTION\n\
 FLAGS\n\
 \n\
   -t           touch target on success\n\
+  -f           run fixupobj on output in-process on success\n\
   -T TARGET    specifies target name for V=0 logging\n\
   -A ACTION    specifies short command name for V=0 logging\n\
   -V NUMBER    specifies compiler version\n\
@@ -134,6 +139,8 @@ ENVIRONMENT\n\
   V=4          print command w/ wall+cpu+mem usage\n\
   V=5          print output when exitcode is zero\n\
   COLUMNS=INT  explicitly set terminal width for output truncation\n\
+  COMPILE_CACHE=DIR  reuse objects compiled from same preprocessed code\n\
+  COMPILE_LOG=PATH   append timing record per command (see buildreport)\n\
   TERM=dumb    disable ansi x3.64 sequences and thousands separators\n\
 \n"
 
@@ -157,6 +164,8 @@ bool wantframe;
 bool wantubsan;
 bool wantfentry;
 bool wantrecord;
+bool fixupobj;
+bool cachehit;
 bool fulloutput;
 bool touchtarget;
 bool noworkaround;
@@ -191,7 +200,10 @@ char *command;
 char *movepath;
 char *shortened;
 char *colorflag;
+char *cachedir;
+char *logpath;
 char ccpath[PATH_MAX];
+char cachepath[PATH_MAX];
 
 struct stat st;
 struct Strings env;
@@ -199,6 +211,7 @@ struct Strings args;
 struct sigaction sa;
 struct rusage usage;
 struct timespec start;
+struct timespec began;
 struct timespec finish;
 struct itimerval timer;
 struct timespec signalled;
@@ -815,8 +828,6 @@ void ReportResources(void) {
 
 bool MovePreservingDestinationInode(const char *from, const char *to) {
   bool res;
-  ssize_t rc;
-  size_t remain;
   struct stat st;
   int fdin, fdout;
   if ((fdin = open(from, O_RDONLY)) == -1) {
@@ -829,30 +840,7 @@ bool MovePreservingDestinationInode(const char *from, const char *to) {
   }
   posix_fadvise(fdin, 0, st.st_size, POSIX_FADV_SEQUENTIAL);
   ftruncate(fdout, st.st_size);
-  for (res = true, remain = st.st_size; remain;) {
-    rc = copy_file_range(fdin, 0, fdout, 0, remain, 0);
-    if (rc != -1) {
-      remain -= rc;
-    } else if (errno == EXDEV ||    // different partitions
-               errno == EINVAL ||   // possible w/ ecryptfs
-               errno == ENOSYS ||   // not linux or freebsd
-               errno == ENOTSUP ||  // no fs support for it
-               errno == EOPNOTSUPP) {
-      if (lseek(fdin, 0, SEEK_SET) == -1) {
-        res = false;
-        break;
-      }
-      if (lseek(fdout, 0, SEEK_SET) == -1) {
-        res = false;
-        break;
-      }
-      res = copyfd(fdin, fdout, -1) != -1;
-      break;
-    } else {
-      res = false;
-      break;
-    }
-  }
+  res = copyfd(fdin, fdout, st.st_size) == st.st_size;
   close(fdin);
   close(fdout);
   return res;
@@ -881,6 +869,169 @@ char *MakeTmpOut(const char *path) {
   return tmpout;
 }
 
+bool IsCacheable(void) {
+  int i;
+  bool wantobject = false;
+  if (!iscc || !movepath)
+    return false;
+  for (i = 1; i < args.n; ++i) {
+    if (!strcmp(args.p[i], "-c")) {
+      wantobject = true;
+    } else if (!strcmp(args.p[i], "-E") || !strcmp(args.p[i], "-S") ||
+               !strcmp(args.p[i], "-") || startswith(args.p[i], "-M") ||
+               startswith(args.p[i], "-save-temps") ||
+               startswith(args.p[i], "-gsplit-dwarf") ||
+               (args.p[i][0] != '-' && endswith(args.p[i], ".s"))) {
+      return false;  // has outputs we wouldn't save, or no preprocessor
+    }
+  }
+  return wantobject;
+}
+
+bool HashFile(struct Blake2b *b, const char *path) {
+  int fd;
+  ssize_t rc;
+  if ((fd = open(path, O_RDONLY)) == -1)
+    return false;
+  while ((rc = read(fd, buf, sizeof(buf))) > 0)
+    BLAKE2B256_Update(b, buf, rc);
+  close(fd);
+  return !rc;
+}
+
+// computes path of object in compile cache
+//
+// the key is a hash of the compiler binary, its flags, and the output
+// of running the same command with -E instead of -c. the preprocessed
+// code includes line markers, so the source paths are part of the key
+// which matters since they end up in the debug info of the object.
+bool GetCachePath(void) {
+  int i, ws;
+  char *p, *ppout;
+  struct Blake2b b;
+  struct Strings saveargs;
+  struct Strings ppargs = {0};
+  uint8_t digest[BLAKE2B256_DIGEST_LENGTH];
+  ppout = xstrcat(tmpout, ".i");
+  for (i = 0; i < args.n; ++i) {
+    if (!strcmp(args.p[i], "-c")) {
+      AddStr(&ppargs, "-E");
+    } else if (i && !strcmp(args.p[i - 1], "-o")) {
+      AddStr(&ppargs, ppout);
+    } else {
+      AddStr(&ppargs, args.p[i]);
+    }
+  }
+  saveargs = args;
+  args = ppargs;
+  ws = Launch();
+  args = saveargs;
+  gotalrm = 0;
+  appendr(&output, 0);
+  BLAKE2B256_Init(&b);
+  if (ws || !HashFile(&b, cmd) || !HashFile(&b, ppout)) {
+    unlink(ppout);
+    free(ppout);
+    free(ppargs.p);
+    return false;
+  }
+  unlink(ppout);
+  free(ppout);
+  free(ppargs.p);
+  for (i = 1; i < args.n; ++i) {
+    if (!strcmp(args.p[i - 1], "-o") ||
+        startswith(args.p[i], "-fdiagnostics-color="))
+      continue;  // these don't change the object
+    BLAKE2B256_Update(&b, args.p[i], strlen(args.p[i]) + 1);
+  }
+  BLAKE2B256_Final(&b, digest);
+  if (strlen(cachedir) + 1 + 2 + 1 + 62 + 2 >= sizeof(cachepath))
+    return false;
+  p = stpcpy(cachepath, cachedir);
+  for (i = 0; i < BLAKE2B256_DIGEST_LENGTH; ++i) {
+    if (i == 0 || i == 1)
+      *p++ = '/';
+    *p++ = "0123456789abcdef"[digest[i] >> 4];
+    *p++ = "0123456789abcdef"[digest[i] & 15];
+  }
+  stpcpy(p, ".o");
+  return true;
+}
+
+// applies fixups to the object the command created, which saves us
+// from having to launch a separate fixupobj process for each object
+bool FixupOutput(void) {
+  const char *path;
+  char err[512];
+  if (!(path = movepath ? tmpout : outpath ? outpath : target)) {
+    appends(&output, "\nfixupobj needs an output file\n");
+    return false;
+  }
+  if (FixupObject(path, false, err, sizeof(err))) {
+    appendw(&output, '\n');
+    appends(&output, err);
+    appendw(&output, '\n');
+    return false;
+  }
+  return true;
+}
+
+// appends a line to the COMPILE_LOG file describing this command
+//
+//     TARGET ACTION START END CPU RSS CACHED EXITCODE
+//
+// fields are separated by tabs. times are microseconds, where start
+// and end are since the unix epoch. cpu and rss cover every process
+// we waited on, e.g. the preprocessor run to compute a cache key. a
+// single write() is used with O_APPEND, so that the concurrent jobs
+// of a parallel make can't interleave their records.
+void AppendToLog(int exitcode) {
+  int fd;
+  char *p, *rec;
+  struct rusage ru;
+  struct timespec now;
+  const char *name, *verb;
+  clock_gettime(CLOCK_REALTIME, &now);
+  if (getrusage(RUSAGE_CHILDREN, &ru))
+    bzero(&ru, sizeof(ru));
+  name = target ? target : outpath ? outpath : cmd;
+  verb = action ? action : "BUILD";
+  if (!(rec = malloc(strlen(name) + strlen(verb) + 6 * 21 + 8)))
+    return;
+  p = stpcpy(rec, name);
+  *p++ = '\t';
+  p = stpcpy(p, verb);
+  *p++ = '\t';
+  p = FormatInt64(p, GetTimespecMicros(began));
+  *p++ = '\t';
+  p = FormatInt64(p, GetTimespecMicros(now));
+  *p++ = '\t';
+  p = FormatInt64(p, GetTimevalMicros(ru.ru_utime) +
+                         GetTimevalMicros(ru.ru_stime));
+  *p++ = '\t';
+  p = FormatInt64(p, ru.ru_maxrss);
+  *p++ = '\t';
+  *p++ = '0' + cachehit;
+  *p++ = '\t';
+  p = FormatInt64(p, exitcode);
+  *p++ = '\n';
+  if ((fd = open(logpath, O_WRONLY | O_APPEND | O_CREAT, 0644)) != -1) {
+    write(fd, rec, p - rec);
+    close(fd);
+  }
+  free(rec);
+}
+
+void StoreInCache(void) {
+  char *tmp;
+  if (makedirs(xdirname(cachepath), 0755))
+    return;
+  tmp = xasprintf("%s.%d.tmp", cachepath, getpid());
+  if (!MovePreservingDestinationInode(tmpout, tmp) || rename(tmp, cachepath))
+    unlink(tmp);
+  free(tmp);
+}
+
 int main(int argc, char *argv[]) {
   uint64_t us;
   bool isineditor;
@@ -906,7 +1057,11 @@ int main(int argc, char *argv[]) {
   memquota = 2048L * 1024 * 1024;  // bytes
   if ((s = getenv("V")))
     verbose = atoi(s);
-  while ((opt = getopt(argc, argv, "hnstvwA:C:F:L:M:O:P:T:V:S:")) != -1) {
+  if ((s = getenv("COMPILE_CACHE")) && *s)
+    cachedir = s;
+  if ((s = getenv("COMPILE_LOG")) && *s)
+    logpath = s;
+  while ((opt = getopt(argc, argv, "fhnstvwA:C:F:L:M:O:P:T:V:S:")) != -1) {
     switch (opt) {
       case 'n':
         exit(0);
@@ -925,6 +1080,9 @@ int main(int argc, char *argv[]) {
       case 't':
         touchtarget = true;
         break;
+      case 'f':
+        fixupobj = true;
+        break;
       case 'w':
         noworkaround = true;
         break;
@@ -1280,13 +1438,30 @@ int main(int argc, char *argv[]) {
     sigaction(SIGALRM, &sa, 0);
   }
 
-  // run command
-  ws = Launch();
+  // run command, unless its object is in the compile cache
+  clock_gettime(CLOCK_REALTIME, &began);
+  if (cachedir && IsCacheable() && GetCachePath() &&
+      MovePreservingDestinationInode(cachepath, tmpout)) {
+    ws = 0;
+    cachehit = true;
+  } else {
+    ws = Launch();
+    if (*cachepath && !ws)
+      StoreInCache();
+  }
 
   // propagate exit
   if (ws != -1) {
     if (WIFEXITED(ws)) {
       if (!(exitcode = WEXITSTATUS(ws)) || exitcode == 254) {
+        if (fixupobj && !FixupOutput()) {
+          exitcode = 1;
+          touchtarget = false;
+          if (movepath) {
+            unlink(tmpout);
+            movepath = 0;
+          }
+        }
         if (touchtarget && target) {
           MakeDirs(xdirname(target), 0755);
           if (Touch(target, 0644)) {
@@ -1509,6 +1684,10 @@ int main(int argc, char *argv[]) {
     ReportResources();
   }
 
+  // record timing for build reports
+  if (logpath)
+    AppendToLog(exitcode);
+
   // flush output
   if (WriteAllUntilSignalledOrError(2, output, appendz(output).i) == -1) {
     if (errno == EINTR) {
@@ -16,9 +16,22 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/calls/struct/stat.h"
+#include "libc/cosmo.h"
+#include "libc/errno.h"
+#include "libc/fmt/conv.h"
+#include "libc/macros.h"
+#include "libc/mem/mem.h"
+#include "libc/nexgen32e/crc32.h"
 #include "libc/runtime/runtime.h"
 #include "libc/stdio/stdio.h"
 #include "libc/str/str.h"
+#include "libc/sysv/consts/map.h"
+#include "libc/sysv/consts/o.h"
+#include "libc/sysv/consts/prot.h"
+#include "libc/thread/thread.h"
+#include "third_party/getopt/getopt.internal.h"
 
 /**
  * @fileoverview scalable diff tool
@@ -26,48 +39,386 @@
  * The normal `diff` command can take hours to diff text files that are
  * hundreds of megabytes in size. This tool is a useful replacement for
  * use cases like comparing a log of CPU registers.
+ *
+ * Both files are memory mapped, then split into lines by threads which
+ * each scan a slice of the file with memchr() and hash lines w/ crc32c.
+ * Lines are aligned using histogram diff, which anchors each region on
+ * its least frequent common line and recurses on both sides. Regions
+ * are handed out to threads. Lines whose text occurs more than MAXCHAIN
+ * times in a region are never used as anchors.
+ *
+ * Each hunk is printed as `# line N differed!` where N is the line of
+ * FILE1, followed by `> ` lines only in FILE1 and `< ` lines only in
+ * FILE2, surrounded by context. Exit status is 1 if files differ.
  */
 
-char line1[4096];
-char line2[4096];
+#define USAGE \
+  " [-a] [-C LINES] [-t THREADS] FILE1 FILE2\n\
+\n\
+FLAGS\n\
+\n\
+  -a    print all common lines\n\
+  -C N  print N lines of context (default 3)\n\
+  -t N  use N threads (default is cpu count)\n\
+\n"
 
-int main(int argc, char *argv[]) {
-  int line;
-  char *l1, *l2;
-  FILE *f1, *f2;
-  if (argc < 3) {
-    fprintf(stderr, "usage: %s FILE1 FILE2\n", argv[0]);
-    exit(1);
+#define MAXCHAIN  64
+#define SMALL     65536
+#define MINSCAN   (1024 * 1024)
+
+struct File {
+  const char *path;
+  const char *map;
+  size_t size;
+  size_t lines;
+  size_t *off;  // lines+1 offsets into map
+  uint64_t *hash;
+};
+
+struct Slice {
+  pthread_t th;
+  struct File *f;
+  size_t beg;
+  size_t end;
+  size_t line;
+};
+
+struct Region {
+  size_t a0, a1, b0, b1;
+};
+
+struct Slot {
+  uint64_t hash;
+  size_t first;
+  size_t count;
+};
+
+struct Worker {
+  pthread_t th;
+  struct Region *todo;
+  size_t todo_n, todo_c;
+  struct Slot *slots;
+  size_t slots_c;
+  size_t *next;
+  size_t next_c;
+};
+
+bool opt_all;
+int opt_threads;
+long opt_context = 3;
+
+struct File A, B;
+ssize_t *match;  // line of B matching each line of A or -1
+
+pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+struct Region *queue;
+size_t queue_n, queue_c;
+int busy;
+char obuf[1024 * 1024];
+
+[[noreturn]] void Die(const char *thing, const char *reason) {
+  fprintf(stderr, "%s: %s\n", thing, reason);
+  exit(2);
+}
+
+void *Grow(void *p, size_t *c, size_t need, size_t z) {
+  if (need > *c) {
+    *c = MAX(need, *c + (*c >> 1) + 16);
+    if (!(p = realloc(p, *c * z)))
+      Die("fastdiff", "out of memory");
+  }
+  return p;
+}
+
+void OpenFile(struct File *f, const char *path) {
+  int fd;
+  struct stat st;
+  f->path = path;
+  if ((fd = open(path, O_RDONLY)) == -1 || fstat(fd, &st))
+    Die(path, strerror(errno));
+  f->size = st.st_size;
+  f->map = "";
+  if (f->size && (f->map = mmap(0, f->size, PROT_READ, MAP_PRIVATE, fd, 0)) ==
+                     MAP_FAILED)
+    Die(path, strerror(errno));
+  close(fd);
+}
+
+size_t LineLength(struct File *f, size_t i) {
+  size_t n = f->off[i + 1] - f->off[i];
+  if (n && f->map[f->off[i + 1] - 1] == '\n')
+    --n;
+  return n;
+}
+
+// counts lines starting in slice, or records them if offsets are ready
+void *ScanSlice(void *arg) {
+  size_t n, i;
+  const char *p, *q, *e;
+  struct Slice *s = arg;
+  struct File *f = s->f;
+  p = f->map + s->beg;
+  e = f->map + s->end;
+  for (i = s->line; p < e; p = q + 1, ++i) {
+    if (!(q = memchr(p, '\n', e - p)))
+      q = e - 1;
+    if (f->off) {
+      n = q + 1 - p - (*q == '\n');
+      f->off[i] = p - f->map;
+      f->hash[i] = (uint64_t)n << 32 | crc32c(0, p, n);
+    }
+  }
+  s->line = i - s->line;
+  return 0;
+}
+
+void RunSlices(struct Slice *s, int n) {
+  int i, err;
+  if (n == 1)
+    return (void)ScanSlice(s);
+  for (i = 0; i < n; ++i)
+    if ((err = pthread_create(&s[i].th, 0, ScanSlice, s + i)))
+      Die("pthread_create", strerror(err));
+  for (i = 0; i < n; ++i)
+    pthread_join(s[i].th, 0);
+}
+
+void SplitLines(struct File *f) {
+  int i, n;
+  const char *q;
+  size_t total, count;
+  struct Slice s[64];
+  n = MAX(1, MIN(MIN(opt_threads, ARRAYLEN(s)), f->size / MINSCAN));
+  for (i = 0; i < n; ++i) {
+    s[i].f = f;
+    s[i].beg = i ? s[i - 1].end : 0;
+    s[i].end = f->size * (i + 1) / n;
+    if (s[i].end < s[i].beg)
+      s[i].end = s[i].beg;
+    if (i == n - 1) {
+      s[i].end = f->size;
+    } else if (s[i].end && s[i].end < f->size) {
+      // slices begin on line boundaries
+      q = memchr(f->map + s[i].end - 1, '\n', f->size - s[i].end + 1);
+      s[i].end = q ? q + 1 - f->map : f->size;
+    }
+    s[i].line = 0;
+  }
+  RunSlices(s, n);
+  for (total = i = 0; i < n; ++i) {
+    count = s[i].line;
+    s[i].line = total;
+    total += count;
   }
-  if (!(f1 = fopen(argv[1], "r"))) {
-    perror(argv[1]);
-    exit(1);
+  f->lines = total;
+  if (!(f->off = malloc((total + 1) * sizeof(*f->off))) ||
+      !(f->hash = malloc((total + 1) * sizeof(*f->hash))))
+    Die("fastdiff", "out of memory");
+  f->off[total] = f->size;
+  RunSlices(s, n);
+}
+
+bool Same(struct File *f, size_t i, struct File *g, size_t j) {
+  size_t n;
+  return f->hash[i] == g->hash[j] &&
+         (n = LineLength(f, i)) == LineLength(g, j) &&
+         !memcmp(f->map + f->off[i], g->map + g->off[j], n);
+}
+
+void Submit(struct Worker *w, struct Region r) {
+  if ((r.a1 - r.a0) + (r.b1 - r.b0) >= SMALL) {
+    pthread_mutex_lock(&lock);
+    queue = Grow(queue, &queue_c, queue_n + 1, sizeof(*queue));
+    queue[queue_n++] = r;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&lock);
+  } else {
+    w->todo = Grow(w->todo, &w->todo_c, w->todo_n + 1, sizeof(*w->todo));
+    w->todo[w->todo_n++] = r;
   }
-  if (!(f2 = fopen(argv[2], "r"))) {
-    perror(argv[2]);
-    exit(1);
+}
+
+struct Slot *Lookup(struct Worker *w, size_t mask, struct File *f, size_t i) {
+  size_t k;
+  struct Slot *s;
+  for (k = f->hash[i];; ++k) {
+    s = w->slots + (k & mask);
+    if (!s->count || Same(&A, s->first, f, i))
+      return s;
   }
-  for (line = 1;; ++line) {
-    l1 = fgets(line1, sizeof(line1), f1);
-    l2 = fgets(line2, sizeof(line2), f2);
-    if (!l1 && !l2) {
-      exit(0);
+}
+
+// aligns region on its rarest common line, then queues both sides
+void Histogram(struct Worker *w, struct Region r) {
+  struct Slot *s;
+  size_t i, j, k, x, y, n, mask, skip;
+  size_t bestcount, bestlen, besta, bestb;
+  while (r.a0 < r.a1 && r.b0 < r.b1 && Same(&A, r.a0, &B, r.b0))
+    match[r.a0++] = r.b0++;
+  while (r.a0 < r.a1 && r.b0 < r.b1 && Same(&A, r.a1 - 1, &B, r.b1 - 1))
+    match[--r.a1] = --r.b1;
+  if (r.a0 == r.a1 || r.b0 == r.b1)
+    return;
+  n = r.a1 - r.a0;
+  mask = 1;
+  while (mask < n * 2)
+    mask <<= 1;
+  w->slots = Grow(w->slots, &w->slots_c, mask, sizeof(*w->slots));
+  w->next = Grow(w->next, &w->next_c, n, sizeof(*w->next));
+  bzero(w->slots, mask * sizeof(*w->slots));
+  --mask;
+  for (i = r.a1; i-- > r.a0;) {
+    s = Lookup(w, mask, &A, i);
+    w->next[i - r.a0] = s->count ? s->first : -1;
+    s->first = i;
+    s->count++;
+  }
+  bestcount = MAXCHAIN + 1;
+  bestlen = besta = bestb = 0;
+  for (j = r.b0; j < r.b1; j = skip) {
+    skip = j + 1;
+    s = Lookup(w, mask, &B, j);
+    if (!s->count || s->count > bestcount)
+      continue;
+    for (i = s->first; i != -1; i = w->next[i - r.a0]) {
+      for (x = i, y = j; x > r.a0 && y > r.b0 && Same(&A, x - 1, &B, y - 1);)
+        --x, --y;
+      for (k = i + 1 - x; x + k < r.a1 && y + k < r.b1 &&
+                          Same(&A, x + k, &B, y + k);)
+        ++k;
+      skip = MAX(skip, y + k);  // lines within this run can't do better
+      if (s->count < bestcount || k > bestlen) {
+        bestcount = s->count;
+        bestlen = k;
+        besta = x;
+        bestb = y;
+      }
     }
-    if (l1)
-      chomp(l1);
-    if (l2)
-      chomp(l2);
-    if (!l1 || !l2) {
-      printf("> %s\n", l1 ? l1 : "EOF");
-      printf("< %s\n", l2 ? l2 : "EOF");
-      exit(0);
+  }
+  if (!bestlen)
+    return;  // nothing in common, or only very common lines
+  for (k = 0; k < bestlen; ++k)
+    match[besta + k] = bestb + k;
+  Submit(w, (struct Region){r.a0, besta, r.b0, bestb});
+  Submit(w, (struct Region){besta + bestlen, r.a1, bestb + bestlen, r.b1});
+}
+
+void *Worker(void *arg) {
+  struct Region r;
+  struct Worker *w = arg;
+  pthread_mutex_lock(&lock);
+  for (;;) {
+    while (!queue_n && busy)
+      pthread_cond_wait(&cond, &lock);
+    if (!queue_n)
+      break;
+    r = queue[--queue_n];
+    ++busy;
+    pthread_mutex_unlock(&lock);
+    Histogram(w, r);
+    while (w->todo_n) {
+      r = w->todo[--w->todo_n];
+      Histogram(w, r);
     }
-    if (!strcmp(l1, l2)) {
-      printf("%s\n", l1);
+    pthread_mutex_lock(&lock);
+    if (!--busy)
+      pthread_cond_broadcast(&cond);
+  }
+  pthread_mutex_unlock(&lock);
+  free(w->todo);
+  free(w->slots);
+  free(w->next);
+  return 0;
+}
+
+void Align(void) {
+  int i, err;
+  struct Worker *w;
+  if (!(match = malloc(A.lines * sizeof(*match))))
+    Die("fastdiff", "out of memory");
+  memset(match, -1, A.lines * sizeof(*match));
+  queue = Grow(queue, &queue_c, 1, sizeof(*queue));
+  queue[queue_n++] = (struct Region){0, A.lines, 0, B.lines};
+  w = calloc(opt_threads, sizeof(*w));
+  for (i = 0; i < opt_threads; ++i)
+    if ((err = pthread_create(&w[i].th, 0, Worker, w + i)))
+      Die("pthread_create", strerror(err));
+  for (i = 0; i < opt_threads; ++i)
+    pthread_join(w[i].th, 0);
+  free(w);
+}
+
+void PrintLine(const char *prefix, struct File *f, size_t i) {
+  fputs(prefix, stdout);
+  fwrite(f->map + f->off[i], 1, LineLength(f, i), stdout);
+  fputc('\n', stdout);
+}
+
+void PrintCommon(size_t i, size_t j) {
+  for (; i < j; ++i)
+    PrintLine("", &A, i);
+}
+
+bool PrintDiff(void) {
+  bool differ = false;
+  size_t i, j, x, y, p, t;
+  for (p = i = j = 0; i < A.lines || j < B.lines;) {
+    if (i < A.lines && match[i] == j) {
+      ++i, ++j;
+      continue;
+    }
+    for (x = i; x < A.lines && match[x] == -1; ++x) {
+    }
+    y = x < A.lines ? match[x] : B.lines;
+    if (opt_all) {
+      PrintCommon(p, i);
     } else {
-      printf("# line %d differed!\n", line);
-      printf("> %s\n", l1);
-      printf("< %s\n", l2);
+      t = differ ? MIN(p + opt_context, i) : p;
+      PrintCommon(p, t);
+      PrintCommon(MAX(t, i - MIN(i, opt_context)), i);
     }
+    differ = true;
+    printf("# line %zu differed!\n", i + 1);
+    for (; i < x; ++i)
+      PrintLine("> ", &A, i);
+    for (; j < y; ++j)
+      PrintLine("< ", &B, j);
+    p = i;
+  }
+  if (differ || opt_all)
+    PrintCommon(p, opt_all ? A.lines : MIN(p + opt_context, A.lines));
+  return differ;
+}
+
+int main(int argc, char *argv[]) {
+  int opt;
+  opt_threads = cosmo_cpu_count();
+  while ((opt = getopt(argc, argv, "aC:t:h")) != -1) {
+    switch (opt) {
+      case 'a':
+        opt_all = true;
+        break;
+      case 'C':
+        opt_context = MAX(0, atol(optarg));
+        break;
+      case 't':
+        opt_threads = MAX(1, atoi(optarg));
+        break;
+      default:
+        fprintf(stderr, "usage: %s%s", argv[0], USAGE);
+        exit(opt == 'h' ? 0 : 2);
+    }
+  }
+  if (argc - optind != 2) {
+    fprintf(stderr, "usage: %s%s", argv[0], USAGE);
+    exit(2);
   }
+  setvbuf(stdout, obuf, _IOFBF, sizeof(obuf));
+  OpenFile(&A, argv[optind]);
+  OpenFile(&B, argv[optind + 1]);
+  SplitLines(&A);
+  SplitLines(&B);
+  Align();
+  return PrintDiff();
 }
@@ -45,6 +45,7 @@
 #include "libc/zip.h"
 #include "third_party/getopt/getopt.internal.h"
 #include "third_party/zlib/zlib.h"
+#include "third_party/zstd/zstd.h"
 
 /**
  * @fileoverview Fast ZIP Archive Creator
@@ -117,6 +118,7 @@ fasterzip [FLAGS...] [-a alignment] [-n suffixes] [PATH...]\n\
   -S   sort new names in archive    -p   parallelism number of threads\n\
   -a   align content on two power   -n   don't compress these suffixes\n\
   -y   store symbolic links as the link instead of the referenced file\n\
+  -Z   compress using zstandard (method 93) rather than deflate\n\
   -x   exclude input file paths that match glob pattern (repeatable)\n\
 \n";
 
@@ -175,6 +177,7 @@ static int flag_junk;
 static int flag_level = Z_DEFAULT_COMPRESSION;
 static int flag_verbose;
 static int flag_threads;
+static bool flag_zstd;
 static bool flag_symbolic;
 static bool flag_sortnames;
 static bool flag_recursive;
@@ -406,7 +409,7 @@ static void AddFile(const char *path, const struct stat *st) {
       S_ISDIR(file->mode) || !ShouldCompressName(file->name)) {
     file->comp = kZipCompressionNone;
   } else {
-    file->comp = kZipCompressionDeflate;
+    file->comp = flag_zstd ? kZipCompressionZstd : kZipCompressionDeflate;
   }
   if (strlen(file->name) > 65535)
     Die(file->name, "name too long to be stored in zip archive");
@@ -685,6 +688,38 @@ static void RunDeflate(z_stream *zs, bool last) {
   }
 }
 
+static ZSTD_CCtx *NewZstd(size_t size) {
+  ZSTD_CCtx *zc;
+  int level = flag_level < 0 ? ZSTD_CLEVEL_DEFAULT : flag_level * 19 / 9;
+  if (!(zc = ZSTD_createCCtx()))
+    DieOom();
+  unassert(!ZSTD_isError(
+      ZSTD_CCtx_setParameter(zc, ZSTD_c_compressionLevel, level)));
+  unassert(!ZSTD_isError(ZSTD_CCtx_setPledgedSrcSize(zc, size)));
+  // output of zstd's multithreaded mode is identical for any number of
+  // workers, so this is chosen by size alone to keep it deterministic
+  if (size > HUNK)
+    ZSTD_CCtx_setParameter(zc, ZSTD_c_nbWorkers, cosmo_cpu_count());
+  return zc;
+}
+
+static size_t RunZstd(ZSTD_CCtx *zc, const void *data, size_t size, bool last,
+                      uint8_t *cdbuf, int dfd, const char *dpath) {
+  size_t rc, compsize = 0;
+  ZSTD_inBuffer in = {data, size, 0};
+  do {
+    ZSTD_outBuffer out = {cdbuf, CHUNK, 0};
+    rc = ZSTD_compressStream2(zc, &out, &in,
+                              last ? ZSTD_e_end : ZSTD_e_continue);
+    if (ZSTD_isError(rc))
+      Die(dpath, ZSTD_getErrorName(rc));
+    if (write(dfd, cdbuf, out.pos) != out.pos)
+      DieSys(dpath);
+    compsize += out.pos;
+  } while (last ? rc : in.pos < in.size);
+  return compsize;
+}
+
 static char *StrCat(const char *a, const char *b) {
   char *p;
   size_t n, m;
@@ -792,7 +827,7 @@ static void *Kompressor(void *arg) {
 
     // check for huge file
     if (S_ISREG(file->mode) && file->size > HUNK &&
-        file->comp != kZipCompressionNone) {
+        file->comp == kZipCompressionDeflate) {
 
       // open input
       int fd;
@@ -854,9 +889,14 @@ static void *Kompressor(void *arg) {
       if ((dfd = mkstemp(file->dpath)) == -1)
         DieSys(file->dpath);
 
-      // initialize zlib in raw deflate mode
+      // initialize zlib in raw deflate mode, or zstd
       z_stream zs;
-      NewDeflate(&zs, -MAX_WBITS);
+      ZSTD_CCtx *zc = 0;
+      if (file->comp == kZipCompressionZstd) {
+        zc = NewZstd(file->size);
+      } else {
+        NewDeflate(&zs, -MAX_WBITS);
+      }
 
       // copy file
       size_t need;
@@ -876,6 +916,10 @@ static void *Kompressor(void *arg) {
           // copy uncompressed data to output
           if (write(dfd, iobuf, need) != need)
             DieSys(file->dpath);
+        } else if (zc) {
+          // compress chunk with zstd and write to output
+          compsize += RunZstd(zc, iobuf, need, i + need >= file->size, cdbuf,
+                              dfd, file->dpath);
         } else {
           // compress chunk and write to output
           zs.avail_in = need;
@@ -893,7 +937,11 @@ static void *Kompressor(void *arg) {
       }
 
       // cleanup
-      unassert(deflateEnd(&zs) == Z_OK);
+      if (zc) {
+        ZSTD_freeCCtx(zc);
+      } else {
+        unassert(deflateEnd(&zs) == Z_OK);
+      }
       if (close(dfd))
         DieSys(file->dpath);
       if (close(fd))
@@ -902,7 +950,7 @@ static void *Kompressor(void *arg) {
         file->cat = BINARY;
 
       // throw away compressed file if it's bigger
-      if (file->comp == kZipCompressionDeflate && compsize > file->size) {
+      if (file->comp != kZipCompressionNone && compsize > file->size) {
         unlink(file->dpath);
         file->delete = false;
         file->dpath = file->path;
@@ -957,7 +1005,7 @@ int main(int argc, char *argv[]) {
 
   // parse flags
   int opt;
-  while ((opt = getopt(argc, argv, "@0123456789vjryqSDNa:n:p:x:")) != -1) {
+  while ((opt = getopt(argc, argv, "@0123456789vjryqSDNZa:n:p:x:")) != -1) {
     switch (opt) {
       case '0':
       case '1':
@@ -980,6 +1028,9 @@ int main(int argc, char *argv[]) {
       case 'y':
         flag_symbolic = true;
         break;
+      case 'Z':
+        flag_zstd = true;
+        break;
       case 'r':
         flag_recursive = true;
         break;
@@ -1232,12 +1283,17 @@ int main(int argc, char *argv[]) {
       eattrs |= kNtFileAttributeReadonly;
     eattrs |= FixMode(file->mode) << 16;
 
+    // zstd needs a newer version to extract
+    int era = kZipEra2001;
+    if (file->comp == kZipCompressionZstd)
+      era = kZipEra2020;
+
     // write local file header
     uint8_t *lochdr = Malloc(hdrlen);
     uint8_t *p = lochdr;
 
     p = ZIP_WRITE32(p, kZipLfileHdrMagic);
-    p = ZIP_WRITE16(p, kZipEra2001);
+    p = ZIP_WRITE16(p, era);
     p = ZIP_WRITE16(p, gflags);
     p = ZIP_WRITE16(p, file->comp);
     p = ZIP_WRITE16(p, file->mtime);
@@ -1269,8 +1325,8 @@ int main(int argc, char *argv[]) {
     p = cdirhdr;
 
     p = ZIP_WRITE32(p, kZipCfileHdrMagic);
-    p = ZIP_WRITE16(p, kZipOsUnix << 8 | kZipEra2001);  // version made by
-    p = ZIP_WRITE16(p, kZipEra2001);  // version needed to extract
+    p = ZIP_WRITE16(p, kZipOsUnix << 8 | era);  // version made by
+    p = ZIP_WRITE16(p, era);                    // version needed to extract
     p = ZIP_WRITE16(p, gflags);
     p = ZIP_WRITE16(p, file->comp);
     p = ZIP_WRITE16(p, file->mtime);
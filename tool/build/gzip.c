@@ -17,16 +17,22 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "libc/calls/calls.h"
+#include "libc/cosmo.h"
 #include "libc/errno.h"
+#include "libc/fmt/conv.h"
 #include "libc/fmt/magnumstrs.internal.h"
 #include "libc/limits.h"
+#include "libc/macros.h"
 #include "libc/mem/mem.h"
 #include "libc/runtime/runtime.h"
+#include "libc/serialize.h"
 #include "libc/stdio/stdio.h"
 #include "libc/str/str.h"
 #include "libc/sysv/consts/ex.h"
 #include "libc/sysv/consts/exit.h"
+#include "libc/sysv/consts/o.h"
 #include "libc/sysv/consts/ok.h"
+#include "libc/thread/thread.h"
 #include "third_party/getopt/getopt.internal.h"
 #include "third_party/zlib/zlib.h"
 
@@ -56,8 +62,12 @@ FLAGS\n\
   -L    filtered strategy (advanced)\n\
   -R    run length strategy (advanced)\n\
   -H    huffman only strategy (advanced)\n\
+  -p N  compress using N threads (default is cpu count)\n\
+  -b K  compress blocks of K kilobytes per thread (default 128)\n\
 \n"
 
+#define DICT 32768
+
 bool opt_keep;
 bool opt_force;
 char opt_level;
@@ -66,6 +76,8 @@ char opt_strategy;
 bool opt_exclusive;
 bool opt_usestdout;
 bool opt_decompress;
+int opt_threads;
+size_t opt_blocksize = 128 * 1024;
 
 const char *prog;
 char databuf[32768];
@@ -80,7 +92,7 @@ char pathbuf[PATH_MAX];
 
 void GetOpts(int argc, char *argv[]) {
   int opt;
-  while ((opt = getopt(argc, argv, "?hfcdakxALFRHF0123456789")) != -1) {
+  while ((opt = getopt(argc, argv, "?hfcdakxALFRHF0123456789p:b:")) != -1) {
     switch (opt) {
       case 'k':
         opt_keep = true;
@@ -124,6 +136,12 @@ void GetOpts(int argc, char *argv[]) {
       case '9':
         opt_level = opt;
         break;
+      case 'p':
+        opt_threads = MAX(1, atoi(optarg));
+        break;
+      case 'b':
+        opt_blocksize = MAX(32, atoi(optarg)) * 1024L;
+        break;
       case 'h':
       case '?':
         PrintUsage(EXIT_SUCCESS, stdout);
@@ -133,28 +151,185 @@ void GetOpts(int argc, char *argv[]) {
   }
 }
 
-void Compress(const char *inpath) {
-  FILE *input;
+struct Block {
+  pthread_t th;
+  bool last;
+  int rc;
+  uLong crc;
+  size_t dictlen;
+  size_t inlen;
+  size_t outlen;
+  size_t outcap;
+  unsigned char *in;
+  unsigned char *out;
+};
+
+int GetLevel(void) {
+  return opt_level ? opt_level - '0' : Z_DEFAULT_COMPRESSION;
+}
+
+int GetStrategy(void) {
+  switch (opt_strategy) {
+    case 'F':
+      return Z_FIXED;
+    case 'f':
+      return Z_FILTERED;
+    case 'R':
+      return Z_RLE;
+    case 'h':
+      return Z_HUFFMAN_ONLY;
+    default:
+      return Z_DEFAULT_STRATEGY;
+  }
+}
+
+// compresses block as raw deflate that splices onto the previous one,
+// by priming its window with the prior 32kb of input like pigz does
+void *Deflater(void *arg) {
+  z_stream zs = {0};
+  struct Block *b = arg;
+  b->crc = crc32(0, b->in, b->inlen);
+  if ((b->rc = deflateInit2(&zs, GetLevel(), Z_DEFLATED, -15, 8,
+                            GetStrategy())) != Z_OK)
+    return 0;
+  if (b->dictlen)
+    deflateSetDictionary(&zs, b->in - b->dictlen, b->dictlen);
+  zs.next_in = b->in;
+  zs.avail_in = b->inlen;
+  zs.next_out = b->out;
+  zs.avail_out = b->outcap;
+  b->rc = deflate(&zs, b->last ? Z_FINISH : Z_SYNC_FLUSH);
+  if (b->rc == (b->last ? Z_STREAM_END : Z_OK) && !zs.avail_in) {
+    b->rc = Z_OK;
+  } else if (b->rc >= Z_OK) {
+    b->rc = Z_BUF_ERROR;
+  }
+  b->outlen = b->outcap - zs.avail_out;
+  deflateEnd(&zs);
+  return 0;
+}
+
+void WriteAll(int fd, const void *p, size_t n, const char *outpath) {
+  ssize_t rc;
+  for (; n; p = (const char *)p + rc, n -= rc) {
+    if ((rc = write(fd, p, n)) == -1) {
+      fputs(outpath, stderr);
+      fputs(": write failed: ", stderr);
+      const char *s = _strerdoc(errno);
+      fputs(s ? s : "EUNKNOWN", stderr);
+      fputs("\n", stderr);
+      _Exit(1);
+    }
+  }
+}
+
+size_t ReadFully(FILE *input, const char *inpath, void *p, size_t n) {
+  size_t got = fread(p, 1, n, input);
+  if (got < n && ferror(input)) {
+    fputs(inpath, stderr);
+    fputs(": read failed: ", stderr);
+    const char *s = _strerdoc(ferror(input));
+    fputs(s ? s : "EUNKNOWN", stderr);
+    fputs("\n", stderr);
+    _Exit(1);
+  }
+  return got;
+}
+
+// writes a single gzip member whose blocks are deflated in parallel
+void CompressParallel(FILE *input, const char *inpath, int fd,
+                      const char *outpath) {
+  int c, err;
+  bool eof = false;
+  uLong crc = crc32(0, 0, 0);
+  unsigned char hdr[10], *buf;
+  size_t i, n, k, nblocks, dictlen = 0, total = 0;
+  size_t batch = opt_threads * opt_blocksize;
+  size_t outcap = opt_blocksize + (opt_blocksize >> 12) +
+                  (opt_blocksize >> 14) + (opt_blocksize >> 25) + 64;
+  struct Block *blocks = calloc(opt_threads, sizeof(struct Block));
+  if (!blocks || !(buf = malloc(DICT + batch))) {
+    fputs(prog, stderr);
+    fputs(": out of memory\n", stderr);
+    _Exit(1);
+  }
+  for (i = 0; i < opt_threads; ++i) {
+    blocks[i].outcap = outcap;
+    if (!(blocks[i].out = malloc(outcap))) {
+      fputs(prog, stderr);
+      fputs(": out of memory\n", stderr);
+      _Exit(1);
+    }
+  }
+  hdr[0] = 0x1f;
+  hdr[1] = 0x8b;
+  hdr[2] = Z_DEFLATED;
+  hdr[3] = 0;  // flags
+  WRITE32LE(hdr + 4, 0);
+  hdr[8] = opt_level == '9' ? 2 : opt_level == '1' ? 4 : 0;
+  hdr[9] = 3;  // unix
+  WriteAll(fd, hdr, sizeof(hdr), outpath);
+  while (!eof) {
+    n = ReadFully(input, inpath, buf + DICT, batch);
+    if (n < batch || (c = fgetc(input)) == EOF) {
+      eof = true;
+    } else {
+      ungetc(c, input);
+    }
+    nblocks = MAX(1, (n + opt_blocksize - 1) / opt_blocksize);
+    for (i = 0; i < nblocks; ++i) {
+      blocks[i].in = buf + DICT + i * opt_blocksize;
+      blocks[i].inlen = MIN(opt_blocksize, n - i * opt_blocksize);
+      blocks[i].dictlen = MIN(DICT, dictlen + i * opt_blocksize);
+      blocks[i].last = eof && i == nblocks - 1;
+    }
+    if (nblocks == 1) {
+      Deflater(blocks);
+    } else {
+      for (i = 0; i < nblocks; ++i) {
+        if ((err = pthread_create(&blocks[i].th, 0, Deflater, blocks + i))) {
+          fputs(prog, stderr);
+          fputs(": pthread_create failed: ", stderr);
+          const char *s = _strerdoc(err);
+          fputs(s ? s : "EUNKNOWN", stderr);
+          fputs("\n", stderr);
+          _Exit(1);
+        }
+      }
+      for (i = 0; i < nblocks; ++i)
+        pthread_join(blocks[i].th, 0);
+    }
+    for (i = 0; i < nblocks; ++i) {
+      if (blocks[i].rc != Z_OK) {
+        fputs(outpath, stderr);
+        fputs(": deflate failed: ", stderr);
+        fputs(zError(blocks[i].rc), stderr);
+        fputs("\n", stderr);
+        _Exit(1);
+      }
+      WriteAll(fd, blocks[i].out, blocks[i].outlen, outpath);
+      crc = crc32_combine(crc, blocks[i].crc, blocks[i].inlen);
+      total += blocks[i].inlen;
+    }
+    // keep the tail of this batch to prime the next one
+    k = MIN(DICT, dictlen + n);
+    memmove(buf + DICT - k, buf + DICT + n - k, k);
+    dictlen = k;
+  }
+  WRITE32LE(hdr, crc);
+  WRITE32LE(hdr + 4, total);
+  WriteAll(fd, hdr, 8, outpath);
+  for (i = 0; i < opt_threads; ++i)
+    free(blocks[i].out);
+  free(blocks);
+  free(buf);
+}
+
+void CompressSerial(FILE *input, const char *inpath) {
   gzFile output;
   int rc, errnum;
-  FILE *closeme = 0;
   const char *outpath;
   char *p, openflags[5];
-  if ((!inpath || opt_usestdout) && (!isatty(1) || opt_force)) {
-    opt_usestdout = true;
-  } else {
-    fputs(prog, stderr);
-    fputs(": compressed data not written to a terminal."
-          " Use -f to force compression.\n",
-          stderr);
-    exit(1);
-  }
-  if (inpath) {
-    input = closeme = fopen(inpath, "rb");
-  } else {
-    inpath = "/dev/stdin";
-    input = stdin;
-  }
   p = openflags;
   *p++ = opt_append ? 'a' : 'w';
   *p++ = 'b';
@@ -202,6 +377,63 @@ void Compress(const char *inpath) {
       _Exit(1);
     }
   } while (rc == sizeof(databuf));
+  if (gzclose(output)) {
+    fputs(outpath, stderr);
+    fputs(": gzclose failed\n", stderr);
+    _Exit(1);
+  }
+}
+
+void Compress(const char *inpath) {
+  int fd;
+  FILE *input;
+  FILE *closeme = 0;
+  const char *outpath;
+  if ((!inpath || opt_usestdout) && (!isatty(1) || opt_force)) {
+    opt_usestdout = true;
+  } else {
+    fputs(prog, stderr);
+    fputs(": compressed data not written to a terminal."
+          " Use -f to force compression.\n",
+          stderr);
+    exit(1);
+  }
+  if (inpath) {
+    input = closeme = fopen(inpath, "rb");
+  } else {
+    inpath = "/dev/stdin";
+    input = stdin;
+  }
+  if (opt_threads > 1) {
+    if (opt_usestdout) {
+      fd = 1;
+      outpath = "/dev/stdout";
+    } else {
+      if (strlen(inpath) + 3 + 1 > PATH_MAX)
+        _Exit(2);
+      stpcpy(stpcpy(pathbuf, inpath), ".gz");
+      outpath = pathbuf;
+      if ((fd = open(outpath,
+                     O_WRONLY | O_CREAT | (opt_append ? O_APPEND : O_TRUNC) |
+                         (opt_exclusive ? O_EXCL : 0),
+                     0644)) == -1) {
+        fputs(outpath, stderr);
+        fputs(": open failed: ", stderr);
+        const char *s = _strerdoc(errno);
+        fputs(s ? s : "EUNKNOWN", stderr);
+        fputs("\n", stderr);
+        exit(1);
+      }
+    }
+    CompressParallel(input, inpath, fd, outpath);
+    if (fd != 1 && close(fd)) {
+      fputs(outpath, stderr);
+      fputs(": close failed\n", stderr);
+      _Exit(1);
+    }
+  } else {
+    CompressSerial(input, inpath);
+  }
   if (closeme) {
     if (fclose(closeme)) {
       fputs(inpath, stderr);
@@ -209,11 +441,6 @@ void Compress(const char *inpath) {
       _Exit(1);
     }
   }
-  if (gzclose(output)) {
-    fputs(outpath, stderr);
-    fputs(": gzclose failed\n", stderr);
-    _Exit(1);
-  }
   if (!opt_keep && !opt_usestdout && (opt_force || !access(inpath, W_OK))) {
     unlink(inpath);
   }
@@ -306,6 +533,8 @@ int main(int argc, char *argv[]) {
   if (!prog)
     prog = "gzip";
   GetOpts(argc, argv);
+  if (!opt_threads)
+    opt_threads = cosmo_cpu_count();
   if (opt_decompress) {
     if (optind == argc) {
       Decompress(0);
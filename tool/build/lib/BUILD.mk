@@ -33,6 +33,7 @@ TOOL_BUILD_LIB_A_OBJS =					\
 
 TOOL_BUILD_LIB_A_DIRECTDEPS =				\
 	LIBC_CALLS					\
+	LIBC_ELF					\
 	LIBC_FMT					\
 	LIBC_INTRIN					\
 	LIBC_LOG					\
@@ -54,6 +55,7 @@ TOOL_BUILD_LIB_A_DIRECTDEPS =				\
 	THIRD_PARTY_MBEDTLS				\
 	THIRD_PARTY_XED					\
 	THIRD_PARTY_ZLIB				\
+	THIRD_PARTY_ZSTD				\
 	THIRD_PARTY_TZ
 
 TOOL_BUILD_LIB_A_DEPS :=				\
@@ -53,6 +53,15 @@ struct ElfWriter {
   struct Interner *shstrtab;
 };
 
+struct ElfWriterZipContent {
+  uint32_t crc;
+  uint16_t method;
+  size_t compsize;
+  unsigned char *compdata; /* malloc'd raw deflate stream, or null */
+};
+
+struct CosmoTaskPool;
+
 struct ElfWriter *elfwriter_open(const char *, int, int) __wur;
 void elfwriter_cargoculting(struct ElfWriter *);
 void elfwriter_close(struct ElfWriter *);
@@ -74,6 +83,14 @@ void elfwriter_setsection(struct ElfWriter *, struct ElfWriterSymRef, uint16_t);
 void elfwriter_zip(struct ElfWriter *, const char *, const char *, size_t,
                    const void *, size_t, uint32_t, struct timespec,
                    struct timespec, struct timespec, bool);
+void elfwriter_zip_compress(struct ElfWriterZipContent *,
+                            struct CosmoTaskPool *, const char *, size_t,
+                            const void *, size_t, int);
+void elfwriter_zip_emit(struct ElfWriter *, const struct ElfWriterZipContent *,
+                        const char *, const char *, size_t, const void *,
+                        size_t, uint32_t, struct timespec, struct timespec,
+                        struct timespec);
+void elfwriter_zip_destroy(struct ElfWriterZipContent *);
 
 COSMOPOLITAN_C_END_
 #endif /* COSMOPOLITAN_TOOL_BUILD_LIB_ELFWRITER_H_ */
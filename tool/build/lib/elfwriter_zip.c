@@ -22,6 +22,7 @@
 #include "libc/fmt/wintime.internal.h"
 #include "libc/limits.h"
 #include "libc/log/check.h"
+#include "libc/macros.h"
 #include "libc/mem/gc.h"
 #include "libc/mem/mem.h"
 #include "libc/nexgen32e/crc32.h"
@@ -37,14 +38,18 @@
 #include "libc/zip.h"
 #include "net/http/http.h"
 #include "third_party/zlib/zlib.h"
+#include "third_party/zstd/zstd.h"
 #include "tool/build/lib/elfwriter.h"
 
 #define ZIP_CFILE_HDR_SIZE (kZipCfileHdrMinSize + 36)
+#define ZIP_DEFLATE_BLOCK  (1024 * 1024)
+#define ZIP_ZSTD_LEVEL     19
 
 static bool ShouldCompress(const char *name, size_t namesize,
                            const unsigned char *data, size_t datasize,
-                           bool nocompress) {
-  return !nocompress && datasize >= 64 && !IsNoCompressExt(name, namesize) &&
+                           int method) {
+  return method != kZipCompressionNone && datasize >= 64 &&
+         !IsNoCompressExt(name, namesize) &&
          (datasize < 1000 || cosmo_entropy((void *)data, 1000) < 7);
 }
 
@@ -57,7 +62,9 @@ static void GetDosLocalTime(int64_t utcunixts, uint16_t *out_time,
 }
 
 static int DetermineVersionNeededToExtract(int method) {
-  if (method == kZipCompressionDeflate) {
+  if (method == kZipCompressionZstd) {
+    return kZipEra2020;
+  } else if (method == kZipCompressionDeflate) {
     return kZipEra1993;
   } else {
     return kZipEra1989;
@@ -138,20 +145,163 @@ static void EmitZipCdirHdr(unsigned char *p, const void *name, size_t namesize,
   p = WRITE64LE(p, ct);
 }
 
+struct DeflateBlock {
+  uint32_t crc;
+  size_t size;
+  size_t compsize;
+  unsigned char *compdata;
+};
+
+struct DeflateJob {
+  const unsigned char *data;
+  size_t size;
+  struct DeflateBlock *blocks;
+};
+
+static size_t Deflate(unsigned char *out, size_t outsize,
+                      const unsigned char *data, size_t size,
+                      const unsigned char *dict, size_t dictsize, int flush) {
+  z_stream zs;
+  CHECK_EQ(Z_OK, deflateInit2(memset(&zs, 0, sizeof(zs)),
+                              Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+                              MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY));
+  if (dictsize)
+    CHECK_EQ(Z_OK, deflateSetDictionary(&zs, dict, dictsize));
+  zs.next_in = data;
+  zs.avail_in = size;
+  zs.next_out = out;
+  zs.avail_out = outsize;
+  if (flush == Z_FINISH) {
+    CHECK_EQ(Z_STREAM_END, deflate(&zs, Z_FINISH));
+  } else {
+    CHECK_EQ(Z_OK, deflate(&zs, flush));
+    CHECK_EQ(0, zs.avail_in);
+    CHECK_NE(0, zs.avail_out);
+  }
+  CHECK_NE(Z_STREAM_ERROR, deflateEnd(&zs));
+  return zs.total_out;
+}
+
+// compresses [i,j) blocks of a big entry, pigz style: each block is
+// primed with the 32kb of input before it and all but the last block
+// end on a sync flush, so concatenating them is a valid deflate stream
+static void DeflateBlocks(long i, long j, void *arg) {
+  size_t off, dictsize;
+  struct DeflateBlock *b;
+  struct DeflateJob *job = arg;
+  for (; i < j; ++i) {
+    b = job->blocks + i;
+    off = i * ZIP_DEFLATE_BLOCK;
+    b->size = MIN(job->size - off, ZIP_DEFLATE_BLOCK);
+    dictsize = MIN(off, 1u << MAX_WBITS);
+    b->crc = crc32_z(0, job->data + off, b->size);
+    b->compdata = xmalloc(compressBound(b->size) + 16);
+    b->compsize = Deflate(b->compdata, compressBound(b->size) + 16,
+                          job->data + off, b->size, job->data + off - dictsize,
+                          dictsize,
+                          off + b->size < job->size ? Z_SYNC_FLUSH : Z_FINISH);
+  }
+}
+
 /**
- * Embeds zip file in elf object.
+ * Computes content of zip file entry.
+ *
+ * DEFLATE entries larger than `ZIP_DEFLATE_BLOCK` are split into blocks
+ * which are compressed in parallel on `pool`. Where blocks start depends
+ * on the size of the data alone, so the output doesn't change with the
+ * number of threads, or if `pool` is null and everything runs on the
+ * calling thread. Entries compressed with zstd are a single frame.
+ *
+ * @param pool may be null to compress on calling thread
+ * @param method is kZipCompressionDeflate, kZipCompressionZstd, or
+ *     kZipCompressionNone to store the data without compression; the
+ *     entry is stored anyway if compressing it wouldn't make it smaller
+ * @see elfwriter_zip_destroy()
  */
-void elfwriter_zip(struct ElfWriter *elf, const char *symbol, const char *cname,
-                   size_t namesize, const void *data, size_t size,
-                   uint32_t mode, struct timespec mtim, struct timespec atim,
-                   struct timespec ctim, bool nocompress) {
-  z_stream zs;
+void elfwriter_zip_compress(struct ElfWriterZipContent *z,
+                            struct CosmoTaskPool *pool, const char *name,
+                            size_t namesize, const void *data, size_t size,
+                            int method) {
+  size_t i, n;
+  struct DeflateJob job;
+  CHECK_LE(size, UINT32_MAX);
+  bzero(z, sizeof(*z));
+  if (!ShouldCompress(name, namesize, data, size, method)) {
+    z->crc = crc32_z(0, data, size);
+    z->method = kZipCompressionNone;
+    z->compsize = size;
+    return;
+  }
+  if (method == kZipCompressionZstd) {
+    z->crc = crc32_z(0, data, size);
+    z->compdata = xmalloc(ZSTD_compressBound(size));
+    z->compsize = ZSTD_compress(z->compdata, ZSTD_compressBound(size), data,
+                                size, ZIP_ZSTD_LEVEL);
+    CHECK(!ZSTD_isError(z->compsize));
+    goto Finish;
+  }
+  CHECK_EQ(kZipCompressionDeflate, method);
+  job.data = data;
+  job.size = size;
+  n = (size + ZIP_DEFLATE_BLOCK - 1) / ZIP_DEFLATE_BLOCK;
+  job.blocks = xcalloc(n, sizeof(*job.blocks));
+  if (pool && n > 1) {
+    cosmo_parallel_for(pool, 0, n, 1, DeflateBlocks, &job);
+  } else {
+    DeflateBlocks(0, n, &job);
+  }
+  if (n == 1) {
+    z->crc = job.blocks[0].crc;
+    z->compsize = job.blocks[0].compsize;
+    z->compdata = job.blocks[0].compdata;
+  } else {
+    for (i = 0; i < n; ++i)
+      z->compsize += job.blocks[i].compsize;
+    z->compdata = xmalloc(z->compsize);
+    for (z->compsize = i = 0; i < n; ++i) {
+      z->crc = crc32_combine(z->crc, job.blocks[i].crc, job.blocks[i].size);
+      memcpy(z->compdata + z->compsize, job.blocks[i].compdata,
+             job.blocks[i].compsize);
+      z->compsize += job.blocks[i].compsize;
+      free(job.blocks[i].compdata);
+    }
+  }
+  free(job.blocks);
+Finish:
+  if (z->compsize < size) {
+    z->method = method;
+  } else {
+    free(z->compdata);
+    z->compdata = 0;
+    z->compsize = size;
+    z->method = kZipCompressionNone;
+  }
+}
+
+/**
+ * Frees memory held by zip file entry content.
+ */
+void elfwriter_zip_destroy(struct ElfWriterZipContent *z) {
+  free(z->compdata);
+  z->compdata = 0;
+}
+
+/**
+ * Embeds zip file in elf object, using content that's been computed.
+ *
+ * @param z was produced by elfwriter_zip_compress() for `data`
+ */
+void elfwriter_zip_emit(struct ElfWriter *elf,
+                        const struct ElfWriterZipContent *z,
+                        const char *symbol, const char *cname, size_t namesize,
+                        const void *data, size_t size, uint32_t mode,
+                        struct timespec mtim, struct timespec atim,
+                        struct timespec ctim) {
   uint8_t era;
-  uint32_t crc;
   unsigned char *lfile, *cfile;
   struct ElfWriterSymRef lfilesym;
-  uint16_t method, gflags, mtime, mdate, iattrs;
-  size_t lfilehdrsize, uncompsize, compsize, commentsize;
+  uint16_t gflags, mtime, mdate, iattrs;
+  size_t lfilehdrsize, commentsize;
 
   CHECK_NE(0, mtim.tv_sec);
 
@@ -164,66 +314,43 @@ void elfwriter_zip(struct ElfWriter *elf, const char *symbol, const char *cname,
 
   gflags = 0;
   iattrs = 0;
-  compsize = size;
   commentsize = 0;
-  uncompsize = size;
-  CHECK_LE(uncompsize, UINT32_MAX);
   lfilehdrsize = kZipLfileHdrMinSize + namesize;
-  crc = crc32_z(0, data, uncompsize);
   GetDosLocalTime(mtim.tv_sec, &mtime, &mdate);
   if (isutf8(name, namesize))
     gflags |= kZipGflagUtf8;
   if (S_ISREG(mode) && istext(data, size)) {
     iattrs |= kZipIattrText;
   }
-  method = ShouldCompress(name, namesize, data, size, nocompress)
-               ? kZipCompressionDeflate
-               : kZipCompressionNone;
 
   /* emit embedded file content w/ pkzip local file header */
   elfwriter_align(elf, 1, 0);
   elfwriter_startsection(elf, ".zip.file", SHT_PROGBITS, 0);
-  if (method == kZipCompressionDeflate) {
-    CHECK_EQ(Z_OK, deflateInit2(memset(&zs, 0, sizeof(zs)),
-                                Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
-                                MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY));
-    zs.next_in = data;
-    zs.avail_in = uncompsize;
-    zs.next_out = ((lfile = elfwriter_reserve(
-                        elf, (lfilehdrsize +
-                              (zs.avail_out = compressBound(uncompsize))))) +
-                   lfilehdrsize);
-    CHECK_EQ(Z_STREAM_END, deflate(&zs, Z_FINISH));
-    CHECK_EQ(Z_OK, deflateEnd(&zs));
-    if (zs.total_out < uncompsize) {
-      compsize = zs.total_out;
-    } else {
-      method = kZipCompressionNone;
-    }
+  lfile = elfwriter_reserve(elf, lfilehdrsize + z->compsize);
+  if (z->method != kZipCompressionNone) {
+    memcpy(lfile + lfilehdrsize, z->compdata, z->compsize);
   } else {
-    lfile = elfwriter_reserve(elf, lfilehdrsize + uncompsize);
-  }
-  if (method == kZipCompressionNone) {
-    memcpy(lfile + lfilehdrsize, data, uncompsize);
+    memcpy(lfile + lfilehdrsize, data, size);
   }
-  era = method ? kZipEra1993 : kZipEra1989;
-  EmitZipLfileHdr(lfile, name, namesize, crc, era, gflags, method, mtime, mdate,
-                  compsize, uncompsize);
-  elfwriter_commit(elf, lfilehdrsize + compsize);
+  era = DetermineVersionNeededToExtract(z->method);
+  EmitZipLfileHdr(lfile, name, namesize, z->crc, era, gflags, z->method, mtime,
+                  mdate, z->compsize, size);
+  elfwriter_commit(elf, lfilehdrsize + z->compsize);
   lfilesym = elfwriter_appendsym(elf, gc(xasprintf("%s%s", "zip+lfile:", name)),
                                  ELF64_ST_INFO(STB_LOCAL, STT_OBJECT),
                                  STV_DEFAULT, 0, lfilehdrsize);
   elfwriter_appendsym(elf, symbol, ELF64_ST_INFO(STB_GLOBAL, STT_OBJECT),
-                      STV_DEFAULT, lfilehdrsize, compsize);
+                      STV_DEFAULT, lfilehdrsize, z->compsize);
   elfwriter_finishsection(elf);
 
-  /* emit central directory record */
+  /* emit central directory record, which the linker sorts by name */
   elfwriter_align(elf, 1, 0);
-  elfwriter_startsection(elf, ".zip.cdir", SHT_PROGBITS, 0);
+  elfwriter_startsection(elf, gc(xasprintf("%s%s", ".zip.cdir.", name)),
+                         SHT_PROGBITS, 0);
   EmitZipCdirHdr(
       (cfile = elfwriter_reserve(elf, ZIP_CFILE_HDR_SIZE + namesize)), name,
-      namesize, crc, era, gflags, method, mtime, mdate, iattrs, mode, compsize,
-      uncompsize, commentsize, mtim, atim, ctim);
+      namesize, z->crc, era, gflags, z->method, mtime, mdate, iattrs, mode,
+      z->compsize, size, commentsize, mtim, atim, ctim);
   elfwriter_appendsym(elf, gc(xasprintf("%s%s", "zip+cdir:", name)),
                       ELF64_ST_INFO(STB_LOCAL, STT_OBJECT), STV_DEFAULT, 0,
                       ZIP_CFILE_HDR_SIZE + namesize);
@@ -232,3 +359,19 @@ void elfwriter_zip(struct ElfWriter *elf, const char *symbol, const char *cname,
   elfwriter_commit(elf, ZIP_CFILE_HDR_SIZE + namesize);
   elfwriter_finishsection(elf);
 }
+
+/**
+ * Embeds zip file in elf object.
+ */
+void elfwriter_zip(struct ElfWriter *elf, const char *symbol, const char *cname,
+                   size_t namesize, const void *data, size_t size,
+                   uint32_t mode, struct timespec mtim, struct timespec atim,
+                   struct timespec ctim, bool nocompress) {
+  struct ElfWriterZipContent z;
+  elfwriter_zip_compress(&z, 0, cname, namesize, data, size,
+                         nocompress ? kZipCompressionNone
+                                    : kZipCompressionDeflate);
+  elfwriter_zip_emit(elf, &z, symbol, cname, namesize, data, size, mode, mtim,
+                     atim, ctim);
+  elfwriter_zip_destroy(&z);
+}
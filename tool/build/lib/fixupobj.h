@@ -0,0 +1,8 @@
+#ifndef COSMOPOLITAN_TOOL_BUILD_LIB_FIXUPOBJ_H_
+#define COSMOPOLITAN_TOOL_BUILD_LIB_FIXUPOBJ_H_
+COSMOPOLITAN_C_START_
+
+int FixupObject(const char *, bool, char *, size_t);
+
+COSMOPOLITAN_C_END_
+#endif /* COSMOPOLITAN_TOOL_BUILD_LIB_FIXUPOBJ_H_ */
@@ -17,9 +17,9 @@
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "tool/build/lib/interner.h"
+#include "libc/cosmo.h"
 #include "libc/intrin/safemacros.h"
 #include "libc/mem/mem.h"
-#include "libc/nexgen32e/crc32.h"
 #include "libc/runtime/runtime.h"
 #include "libc/stdckdint.h"
 #include "libc/str/str.h"
@@ -102,7 +102,7 @@ size_t internobj(struct Interner *t, const void *data, size_t size) {
   step = 0;
   item = data;
   it = (struct InternerObject *)t;
-  hash = max(1, crc32c(0, data, size));
+  hash = max(1, (unsigned)cosmo_hash(data, size));
   do {
     /* it is written that triangle probe halts iff i<n/2 && popcnt(n)==1 */
     i = (hash + step * ((step + 1) >> 1)) & (it->n - 1);
@@ -169,7 +169,7 @@ bool isinterned(struct Interner *t, const char *s) {
   struct InternerObject *it;
   step = 0;
   n = strlen(s) + 1;
-  hash = max(1, crc32c(0, s, n));
+  hash = max(1, (unsigned)cosmo_hash(s, n));
   it = (struct InternerObject *)t;
   do {
     i = (hash + step * ((step + 1) >> 1)) & (it->n - 1);
@@ -82,6 +82,7 @@
   "\n"                                                              \
   "  -h              show usage\n"                                  \
   "  -o OUTPUT       set output path\n"                             \
+  "  -c CACHE        rescan only sources changed since last run\n"  \
   "  -g ROOT         set generated path [default: o/]\n"            \
   "  -r ROOT         set build output path, e.g. o/$(MODE)/\n"      \
   "  -S [LANG:]PATH  isystem include path [repeatable]\n"           \
@@ -142,6 +143,32 @@ struct SystemPaths {
   struct SystemPath *p;
 };
 
+enum IncludeKind {
+  INCLUDE_QUOTE = 1,
+  INCLUDE_ANGLE,
+  INCLUDE_ANGLE_NEXT,
+};
+
+struct Scan {
+  char *src;
+  unsigned id;
+  bool dirty;
+  uint64_t ino;
+  int64_t mtime;
+  uint64_t size;
+  char *incs;
+  size_t incslen;
+};
+
+struct CacheRecord {
+  uint64_t ino;
+  int64_t mtime;
+  uint64_t size;
+  uint32_t pathlen;
+  uint32_t incslen;
+  char data[];
+};
+
 // these are file extensions for source files that get turned into
 // object code. everything that isn't listed here is considered a
 // language agnostic header file.
@@ -170,6 +197,16 @@ static struct SystemPaths systempaths;
 static const char *buildroot;
 static const char *genroot;
 static const char *outpath;
+static const char *cachepath;
+static char *cachemap;
+static size_t cachemapsize;
+static const struct CacheRecord **cached;
+static struct Scan *scans;
+static size_t scancount;
+static size_t scanalloc;
+
+// magic number of -c cache file, which must be bumped if it changes
+static const char kCacheMagic[8] = "mkdeps\0\1";
 
 static inline bool IsBlank(int c) {
   return c == ' ' || c == '\t';
@@ -484,31 +521,241 @@ static const char *FindIncludePath(const char *map, size_t mapsize,
   return q;
 }
 
-static void LoadRelationships(int argc, char *argv[]) {
+// scans source file for include directives
+//
+// this is the expensive part of mkdeps, and it doesn't depend on what
+// other files exist, so it's safe to run in parallel and to cache the
+// result. each directive is encoded as an IncludeKind byte, followed by
+// the nul terminated path as it was written in the source code.
+static void ScanSource(struct Scan *s) {
   int fd;
   char *map;
   ssize_t rc;
   size_t size;
   bool is_assembly;
-  struct GetArgs ga;
   bool is_include_next;
+  const char *p, *pe, *path, *pathend;
+  is_assembly = endswith(s->src, ".s");
+  if ((fd = open(s->src, O_RDONLY)) == -1)
+    DieSys(s->src);
+  if ((rc = lseek(fd, 0, SEEK_END)) == -1)
+    DieSys(s->src);
+  if ((size = rc)) {
+    map = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+      DieSys(s->src);
+    for (p = map, pe = map + size; p < pe; ++p) {
+      if (!(p = memmem(p, pe - p, "include", 7)))
+        break;
+      if (!(path = FindIncludePath(map, size, p, is_assembly,  //
+                                   &is_include_next)))
+        continue;
+      char right = path[-1] == '<' ? '>' : '"';
+      if (!(pathend = memchr(path, right, pe - path)))
+        continue;
+      if (pathend - path >= PATH_MAX) {
+        tinyprint(2, s->src, ": uses really long include path\n", NULL);
+        exit(1);
+      }
+      if (right == '"') {
+        Appendw(&s->incs, INCLUDE_QUOTE);
+      } else if (is_include_next) {
+        Appendw(&s->incs, INCLUDE_ANGLE_NEXT);
+      } else {
+        Appendw(&s->incs, INCLUDE_ANGLE);
+      }
+      Appendd(&s->incs, path, pathend - path);
+      Appendw(&s->incs, 0);
+      p = pathend;
+    }
+    if (munmap(map, size))
+      DieSys(s->src);
+  }
+  if (close(fd))
+    DieSys(s->src);
+  s->incslen = appendz(s->incs).i;
+}
+
+static void ScanSources(long i, long j, void *arg) {
+  struct Scan **dirty = arg;
+  for (; i < j; ++i)
+    ScanSource(dirty[i]);
+}
+
+// turns include directives of source into edges of dependency graph
+static void LinkSource(struct Scan *s) {
   int srcid, dependency;
   enum Language slang, elang;
   static char srcdirbuf[PATH_MAX];
-  const char *p, *pe, *src, *path, *pathend, *srcdir, *final;
+  const char *p, *pe, *src, *srcdir, *final;
+  if (!s->incs)
+    return;
+  src = s->src;
+  srcid = s->id;
+  slang = GetLanguageFromPath(src);
+  if (strlcpy(srcdirbuf, src, PATH_MAX) >= PATH_MAX)
+    DiePathTooLong(src);
+  srcdir = dirname(srcdirbuf);
+  for (p = s->incs, pe = p + s->incslen; p < pe; p += strlen(p) + 1) {
+    char juf[PATH_MAX];
+    const char *incpath = p + 1;
+    if (*p != INCLUDE_QUOTE) {
+      // handle angle bracket includes
+      bool found = false;
+      if (!systempaths.n)
+        continue;
+      for (elang = 1; elang < LANG_COUNT; ++elang) {
+        if (slang)
+          if (elang != slang)
+            continue;
+        dependency = -1;
+        for (long i = 0; i < systempaths.n; ++i) {
+          if (systempaths.p[i].lang)
+            if (systempaths.p[i].lang != elang)
+              continue;
+          if (*p == INCLUDE_ANGLE_NEXT)
+            if (startswith(src, systempaths.p[i].path))
+              continue;
+          if (!(final = __join_paths(juf, PATH_MAX, systempaths.p[i].path,
+                                     incpath)))
+            DiePathTooLong(incpath);
+          if ((dependency = GetSourceId(final)) != -1)
+            break;
+        }
+        if (dependency != -1) {
+          AppendEdge(&edges[elang], dependency, srcid);
+          found = true;
+        } else if (hermetic == 1) {
+          // chances are the `#include <foo>` is in some #ifdef
+          // that'll never actually be executed; thus we ignore
+          // since landlock make unveil() shall catch it anyway
+          found = true;
+        }
+      }
+      if (!found) {
+        tinyprint(2, incpath,
+                  ": system header not specified by the HDRS/SRCS/INCS "
+                  "make variables defined by the hermetic mono repo\n",
+                  NULL);
+        exit(1);
+      }
+    } else {
+      // handle double quote includes
+      // let foo/bar.c say `#include "foo/hdr.h"`
+      dependency = GetSourceId((final = incpath));
+      // let foo/bar.c say `#include "hdr.h"`
+      if (dependency == -1 && !strchr(final, '/')) {
+        if (!(final = __join_paths(juf, PATH_MAX, srcdir, final)))
+          DiePathTooLong(incpath);
+        dependency = GetSourceId(final);
+      }
+      if (dependency == -1) {
+        if (startswith(final, genroot)) {
+          dependency = CreateSourceId(src);
+        } else {
+          tinyprint(2, incpath,
+                    ": path not specified by HDRS/SRCS/INCS make variables "
+                    "(it was included by ",
+                    src, ")\n", NULL);
+          exit(1);
+        }
+      }
+      if (slang) {
+        AppendEdge(&edges[slang], dependency, srcid);
+      } else {
+        for (elang = 1; elang < LANG_COUNT; ++elang)
+          AppendEdge(&edges[elang], dependency, srcid);
+      }
+    }
+  }
+}
+
+// maps scan results of previous run, so unchanged files needn't be read
+static void LoadCache(void) {
+  int fd;
+  char *p, *pe;
+  struct stat st;
+  const struct CacheRecord *r;
+  if (!cachepath || (fd = open(cachepath, O_RDONLY)) == -1)
+    return;
+  if (!fstat(fd, &st) && st.st_size >= sizeof(kCacheMagic)) {
+    cachemap = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (cachemap != MAP_FAILED) {
+      cachemapsize = st.st_size;
+    } else {
+      cachemap = 0;
+    }
+  }
+  close(fd);
+  if (!cachemap || memcmp(cachemap, kCacheMagic, sizeof(kCacheMagic)))
+    return;
+  cached = Calloc(counter, sizeof(*cached));
+  p = cachemap + sizeof(kCacheMagic);
+  pe = cachemap + cachemapsize;
+  while (pe - p >= sizeof(*r)) {
+    r = (const struct CacheRecord *)p;
+    if (r->pathlen < 1 || r->pathlen > pe - r->data ||
+        r->incslen > pe - r->data - r->pathlen || r->data[r->pathlen - 1])
+      break;  // cache is corrupted
+    if (r->incslen && r->data[r->pathlen + r->incslen - 1])
+      break;  // cache is corrupted
+    int id = GetSourceId(r->data);
+    if (id != -1)
+      cached[id] = r;
+    p = (char *)r->data + ROUNDUP(r->pathlen + r->incslen, 8);
+  }
+}
+
+static void SaveCache(void) {
+  int fd;
+  ssize_t rc;
+  char *b = 0;
+  char *tmp = 0;
+  struct CacheRecord r;
+  Appendd(&b, kCacheMagic, sizeof(kCacheMagic));
+  for (size_t i = 0; i < scancount; ++i) {
+    r.ino = scans[i].ino;
+    r.mtime = scans[i].mtime;
+    r.size = scans[i].size;
+    r.pathlen = strlen(scans[i].src) + 1;
+    r.incslen = scans[i].incslen;
+    Appendd(&b, &r, sizeof(r));
+    Appendd(&b, scans[i].src, r.pathlen);
+    if (r.incslen)
+      Appendd(&b, scans[i].incs, r.incslen);
+    Appendd(&b, "\0\0\0\0\0\0\0", ROUNDUP(appendz(b).i, 8) - appendz(b).i);
+  }
+  Appends(&tmp, cachepath);
+  Appends(&tmp, ".tmp");
+  if ((fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644)) == -1)
+    DieSys(tmp);
+  size_t n = appendz(b).i;
+  for (size_t i = 0; i < n; i += rc)
+    if ((rc = write(fd, b + i, n - i)) == -1)
+      DieSys(tmp);
+  if (close(fd))
+    DieSys(tmp);
+  if (rename(tmp, cachepath))
+    DieSys(cachepath);
+  free(tmp);
+  free(b);
+}
+
+static void LoadRelationships(int argc, char *argv[]) {
+  size_t ndirty;
+  struct stat st;
+  struct GetArgs ga;
+  struct Scan **dirty;
+  const char *src;
+  const struct CacheRecord *r;
   getargs_init(&ga, argv + optind);
   while ((src = getargs_next(&ga)))
     CreateSourceId(src);
   getargs_destroy(&ga);
+  LoadCache();
   getargs_init(&ga, argv + optind);
   while ((src = getargs_next(&ga))) {
-    slang = GetLanguageFromPath(src);
-    is_assembly = endswith(src, ".s");
-    srcid = GetSourceId(src);
-    if (strlcpy(srcdirbuf, src, PATH_MAX) >= PATH_MAX)
-      DiePathTooLong(src);
-    srcdir = dirname(srcdirbuf);
-    if ((fd = open(src, O_RDONLY)) == -1) {
+    if (stat(src, &st)) {
       if (errno == ENOENT && ga.path) {
         // This code helps GNU Make automatically fix itself when we
         // delete a source file. It removes o/.../srcs.txt or
@@ -520,114 +767,50 @@ static void LoadRelationships(int argc, char *argv[]) {
       }
       DieSys(src);
     }
-    if ((rc = lseek(fd, 0, SEEK_END)) == -1)
-      DieSys(src);
-    if ((size = rc)) {
-      // repeatedly map to same fixed address so in order to weasel out
-      // of incurring the additional overhead of all these munmap calls
-      map = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
-      if (map == MAP_FAILED)
-        DieSys(src);
-      for (p = map, pe = map + size; p < pe; ++p) {
-        if (!(p = memmem(p, pe - p, "include", 7)))
-          break;
-        if (!(path = FindIncludePath(map, size, p, is_assembly,  //
-                                     &is_include_next)))
-          continue;
-        // copy the specified include path
-        char right;
-        if (path[-1] == '<') {
-          if (!systempaths.n)
-            continue;
-          right = '>';
-        } else {
-          right = '"';
-        }
-        if (!(pathend = memchr(path, right, pe - path)))
-          continue;
-        if (pathend - path >= PATH_MAX) {
-          tinyprint(2, src, ": uses really long include path\n", NULL);
-          exit(1);
-        }
-        char juf[PATH_MAX];
-        char incpath[PATH_MAX];
-        *(char *)mempcpy(incpath, path, pathend - path) = 0;
-        if (right == '>') {
-          // handle angle bracket includes
-          bool found = false;
-          for (elang = 1; elang < LANG_COUNT; ++elang) {
-            if (slang)
-              if (elang != slang)
-                continue;
-            dependency = -1;
-            for (long i = 0; i < systempaths.n; ++i) {
-              if (systempaths.p[i].lang)
-                if (systempaths.p[i].lang != elang)
-                  continue;
-              if (is_include_next)
-                if (startswith(src, systempaths.p[i].path))
-                  continue;
-              if (!(final = __join_paths(juf, PATH_MAX, systempaths.p[i].path,
-                                         incpath)))
-                DiePathTooLong(incpath);
-              if ((dependency = GetSourceId(final)) != -1)
-                break;
-            }
-            if (dependency != -1) {
-              AppendEdge(&edges[elang], dependency, srcid);
-              p = pathend + 1;
-              found = true;
-            } else if (hermetic == 1) {
-              // chances are the `#include <foo>` is in some #ifdef
-              // that'll never actually be executed; thus we ignore
-              // since landlock make unveil() shall catch it anyway
-              found = true;
-            }
-          }
-          if (!found) {
-            tinyprint(2, incpath,
-                      ": system header not specified by the HDRS/SRCS/INCS "
-                      "make variables defined by the hermetic mono repo\n",
-                      NULL);
-            exit(1);
-          }
-        } else {
-          // handle double quote includes
-          // let foo/bar.c say `#include "foo/hdr.h"`
-          dependency = GetSourceId((final = incpath));
-          // let foo/bar.c say `#include "hdr.h"`
-          if (dependency == -1 && !strchr(final, '/')) {
-            if (!(final = __join_paths(juf, PATH_MAX, srcdir, final)))
-              DiePathTooLong(incpath);
-            dependency = GetSourceId(final);
-          }
-          if (dependency == -1) {
-            if (startswith(final, genroot)) {
-              dependency = CreateSourceId(src);
-            } else {
-              tinyprint(2, incpath,
-                        ": path not specified by HDRS/SRCS/INCS make variables "
-                        "(it was included by ",
-                        src, ")\n", NULL);
-              exit(1);
-            }
-          }
-          if (slang) {
-            AppendEdge(&edges[slang], dependency, srcid);
-          } else {
-            for (elang = 1; elang < LANG_COUNT; ++elang)
-              AppendEdge(&edges[elang], dependency, srcid);
-          }
-          p = pathend + 1;
-        }
-      }
-      if (munmap(map, size))
-        DieSys(src);
+    if (scancount == scanalloc) {
+      scanalloc += 16 + (scanalloc >> 1);
+      scans = Realloc(scans, scanalloc * sizeof(*scans));
+    }
+    struct Scan *s = scans + scancount++;
+    bzero(s, sizeof(*s));
+    if (!(s->src = strdup(src)))
+      DieOom();
+    s->id = GetSourceId(src);
+    s->ino = st.st_ino;
+    s->mtime = st.st_mtim.tv_sec * 1000000000ll + st.st_mtim.tv_nsec;
+    s->size = st.st_size;
+    if (cached && (r = cached[s->id]) && r->ino == s->ino &&
+        r->mtime == s->mtime && r->size == s->size) {
+      s->incs = (char *)r->data + r->pathlen;
+      s->incslen = r->incslen;
+    } else {
+      s->dirty = true;
     }
-    if (close(fd))
-      DieSys(src);
   }
   getargs_destroy(&ga);
+
+  // scan files that changed since the last run, using all cores if
+  // there's enough of them to make spawning threads worth it
+  dirty = Malloc((scancount + 1) * sizeof(*dirty));
+  ndirty = 0;
+  for (size_t i = 0; i < scancount; ++i)
+    if (scans[i].dirty)
+      dirty[ndirty++] = scans + i;
+  struct CosmoTaskPool *pool = 0;
+  if (ndirty >= 64)
+    pool = cosmo_taskpool_new(0);
+  if (pool) {
+    cosmo_parallel_for(pool, 0, ndirty, 0, ScanSources, dirty);
+    cosmo_taskpool_free(pool);
+  } else {
+    ScanSources(0, ndirty, dirty);
+  }
+  free(dirty);
+
+  for (size_t i = 0; i < scancount; ++i)
+    LinkSource(scans + i);
+  if (cachepath)
+    SaveCache();
 }
 
 [[noreturn]] static void ShowUsage(int rc, int fd) {
@@ -660,7 +843,7 @@ static void AddSystemPath(char *path) {
 
 static void GetOpts(int argc, char *argv[]) {
   int opt;
-  while ((opt = getopt(argc, argv, "hnsgS:o:r:")) != -1) {
+  while ((opt = getopt(argc, argv, "hnsgS:c:o:r:")) != -1) {
     switch (opt) {
       case 's':
         ++hermetic;
@@ -668,6 +851,9 @@ static void GetOpts(int argc, char *argv[]) {
       case 'S':
         AddSystemPath(optarg);
         break;
+      case 'c':
+        cachepath = optarg;
+        break;
       case 'o':
         if (outpath)
           Die("multiple output paths specified");
@@ -806,6 +992,15 @@ int main(int argc, char *argv[]) {
   free(makefile);
   for (int lang = 0; lang < LANG_COUNT; ++lang)
     free(edges[lang].p);
+  for (size_t i = 0; i < scancount; ++i) {
+    free(scans[i].src);
+    if (scans[i].dirty)
+      free(scans[i].incs);
+  }
+  free(scans);
+  free(cached);
+  if (cachemap)
+    munmap(cachemap, cachemapsize);
   free(sauces);
   free(names);
   CheckForMemoryLeaks();
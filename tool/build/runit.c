@@ -35,7 +35,9 @@
 #include "libc/mem/mem.h"
 #include "libc/runtime/runtime.h"
 #include "libc/serialize.h"
+#include "libc/str/blake2.h"
 #include "libc/sock/ipclassify.internal.h"
+#include "libc/stdio/append.h"
 #include "libc/stdio/stdio.h"
 #include "libc/str/str.h"
 #include "libc/sysv/consts/af.h"
@@ -57,6 +59,7 @@
 #include "third_party/musl/netdb.h"
 #include "third_party/zlib/zlib.h"
 #include "tool/build/lib/eztls.h"
+#include "tool/build/lib/getargs.h"
 #include "tool/build/lib/psk.h"
 
 /**
@@ -103,14 +106,35 @@
  *     iptables -I INPUT 1 -s 192.168.0.0/16 -p tcp --dport 31337 -j ACCEPT
  *
  * This tool may be used in zero trust environments.
+ *
+ * Many programs may be run at once by passing an @args.txt file which
+ * lists them, rather than the program itself. Then a single connection
+ * is made to each host, the daemon is only sent the binaries it hasn't
+ * seen before (by hash), and it runs them concurrently on all its cpus.
+ *
+ *     o/default/tool/build/runit             \
+ *         o/default/tool/build/runitd        \
+ *         @o/default/test/tests.txt          \
+ *         freebsd.test. openbsd.test.
  */
 
+struct Job {
+  char *path;
+  char *map;
+  char *output;
+  size_t size;
+  unsigned char hash[RUNITD_HASHSIZE];
+};
+
 static const struct addrinfo kResolvHints = {.ai_family = AF_INET,
                                              .ai_socktype = SOCK_STREAM,
                                              .ai_protocol = IPPROTO_TCP};
 
 int g_sock;
+bool g_batch;
 char *g_prog;
+uint32_t g_njobs;
+struct Job *g_jobs;
 long g_backoff;
 char *g_runitd;
 jmp_buf g_jmpbuf;
@@ -124,8 +148,10 @@ uint16_t g_runitdport;
 int __sys_execve(const char *, char *const[], char *const[]);
 
 [[noreturn]] void ShowUsage(FILE *f, int rc) {
-  fprintf(f, "Usage: %s RUNITD PROGRAM HOSTNAME[:RUNITDPORT[:SSHPORT]]...\n",
-          program_invocation_name);
+  fprintf(f,
+          "Usage: %s RUNITD PROGRAM HOSTNAME[:RUNITDPORT[:SSHPORT]]...\n"
+          "       %s RUNITD @PROGRAMS.txt HOSTNAME[:RUNITDPORT[:SSHPORT]]...\n",
+          program_invocation_name, program_invocation_name);
   exit(rc);
   __builtin_unreachable();
 }
@@ -190,6 +216,25 @@ void Connect(void) {
   connect_latency = timespec_tomicros(timespec_sub(timespec_mono(), start));
 }
 
+bool SendTls(const void *data, size_t size) {
+  int rc;
+  const char *p = data;
+  while (size) {
+    if ((rc = mbedtls_ssl_write(&ezssl, p, size)) <= 0)
+      EzTlsDie("batch request failed", rc);
+    size -= rc;
+    p += rc;
+  }
+  return true;
+}
+
+void FlushTls(void) {
+  int rc;
+  if ((rc = EzTlsFlush(&ezbio, 0, 0)) < 0)
+    EzTlsDie("batch request failed to flush", rc);
+}
+
+// compresses data to file, or to the tls connection if tmpfd is -1
 bool Send(int tmpfd, const void *output, size_t outputsize) {
   bool ok;
   char *zbuf;
@@ -214,7 +259,11 @@ bool Send(int tmpfd, const void *output, size_t outputsize) {
     rc = deflate(&zs, Z_SYNC_FLUSH);
     CHECK_NE(Z_STREAM_ERROR, rc);
     have = zsize - zs.avail_out;
-    rc = write(tmpfd, zbuf, have);
+    if (tmpfd == -1) {
+      rc = SendTls(zbuf, have) ? have : -1;
+    } else {
+      rc = write(tmpfd, zbuf, have);
+    }
     if (rc != have) {
       DEBUGF("write(%d, %d) → %d", tmpfd, have, rc);
       ok = false;
@@ -353,7 +402,7 @@ int ReadResponse(void) {
   return exitcode;
 }
 
-int RunOnHost(char *spec) {
+int ConnectToHost(char *spec) {
   int err;
   char *p;
   for (p = spec; *p; ++p) {
@@ -387,6 +436,12 @@ int RunOnHost(char *spec) {
     close(g_sock);
     return 1;
   }
+  return 0;
+}
+
+int RunOnHost(char *spec) {
+  if (ConnectToHost(spec))
+    return 1;
   RelayRequest();
   int rc = ReadResponse();
   kprintf("%s on %-16s %'8ld µs %'8ld µs %'11d µs\n", basename(g_prog),
@@ -394,6 +449,161 @@ int RunOnHost(char *spec) {
   return rc;
 }
 
+void LoadJobs(char *arg) {
+  int fd;
+  struct stat st;
+  const char *path;
+  struct GetArgs ga;
+  getargs_init(&ga, (char *[]){arg, 0});
+  while ((path = getargs_next(&ga))) {
+    CheckExists(path);
+    CHECK_LT(g_njobs, RUNITD_MAXJOBS);
+    g_jobs = realloc(g_jobs, (g_njobs + 1) * sizeof(*g_jobs));
+    struct Job *j = g_jobs + g_njobs++;
+    bzero(j, sizeof(*j));
+    CHECK_NOTNULL((j->path = strdup(path)));
+    CHECK_NE(-1, (fd = open(path, O_RDONLY)));
+    CHECK_NE(-1, fstat(fd, &st));
+    CHECK_LE((j->size = st.st_size), INT_MAX);
+    if (j->size)
+      CHECK_NE(MAP_FAILED,
+               (j->map = mmap(0, j->size, PROT_READ, MAP_SHARED, fd, 0)));
+    CHECK_NE(-1, close(fd));
+    BLAKE2B256(j->map, j->size, j->hash);
+  }
+  getargs_destroy(&ga);
+}
+
+bool SendBatchRequest(void) {
+  bool okall;
+  unsigned char hdr[17], *q;
+  q = hdr;
+  q = WRITE32BE(q, RUNITD_MAGIC);
+  *q++ = kRunitBatch;
+  q = WRITE32BE(q, g_njobs);
+  q = WRITE32BE(q, 0);  // let the daemon use all its cpus
+  q = WRITE32BE(q, 0);
+  okall = Send(-1, hdr, q - hdr);
+  for (uint32_t i = 0; i < g_njobs; ++i) {
+    const char *name = basename(g_jobs[i].path);
+    size_t namesize = strlen(name);
+    unsigned char desc[4 + 4 + RUNITD_HASHSIZE];
+    q = desc;
+    q = WRITE32BE(q, namesize);
+    q = WRITE32BE(q, g_jobs[i].size);
+    q = mempcpy(q, g_jobs[i].hash, RUNITD_HASHSIZE);
+    okall &= Send(-1, desc, q - desc);
+    okall &= Send(-1, name, namesize);
+  }
+  FlushTls();
+  return okall;
+}
+
+bool SendNeededPrograms(void) {
+  char msg[9];
+  uint32_t count, needed = 0;
+  if (!Recv(msg, 9) || READ32BE(msg) != RUNITD_MAGIC || msg[4] != kRunitNeed) {
+    WARNF("%s didn't say which programs it needs", g_hostname);
+    return false;
+  }
+  if ((count = READ32BE(msg + 5)) > g_njobs) {
+    WARNF("%s needs more programs than were sent", g_hostname);
+    return false;
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t job;
+    if (!Recv(msg, 4) || (job = READ32BE(msg)) >= g_njobs) {
+      WARNF("%s sent corrupted need message", g_hostname);
+      return false;
+    }
+    if (!Send(-1, g_jobs[job].map, g_jobs[job].size))
+      return false;
+    ++needed;
+  }
+  FlushTls();
+  DEBUGF("%s needed %u of %u programs", g_hostname, needed, g_njobs);
+  return true;
+}
+
+int ReadBatchResponse(void) {
+  int exitcode;
+  struct timespec start = timespec_mono();
+  for (;;) {
+    char msg[9];
+    if (!Recv(msg, 5)) {
+      WARNF("%s didn't report status of %s", g_hostname, g_prog);
+      exitcode = 200;
+      break;
+    }
+    if (READ32BE(msg) != RUNITD_MAGIC) {
+      WARNF("%s sent corrupted data stream running %s", g_hostname, g_prog);
+      exitcode = 201;
+      break;
+    }
+    if (msg[4] == kRunitExit) {
+      if (!Recv(msg, 1)) {
+      TruncatedMessage:
+        WARNF("%s sent truncated message running %s", g_hostname, g_prog);
+        exitcode = 202;
+        break;
+      }
+      exitcode = *msg & 255;
+      mbedtls_ssl_close_notify(&ezssl);
+      break;
+    } else if (msg[4] == kRunitJobOutput || msg[4] == kRunitJobExit) {
+      int kind = msg[4];
+      if (!Recv(msg, 8))
+        goto TruncatedMessage;
+      uint32_t job = READ32BE(msg);
+      uint32_t n = READ32BE(msg + 4);
+      if (job >= g_njobs || (kind == kRunitJobExit && n != 1)) {
+        WARNF("%s sent corrupted job message running %s", g_hostname, g_prog);
+        exitcode = 201;
+        break;
+      }
+      char *s = malloc(n);
+      if (!Recv(s, n))
+        goto TruncatedMessage;
+      struct Job *j = g_jobs + job;
+      if (kind == kRunitJobOutput) {
+        appendd(&j->output, s, n);
+      } else {
+        if (j->output)
+          write(2, j->output, appendz(j->output).i);
+        free(j->output);
+        j->output = 0;
+        if (*s) {
+          WARNF("%s says %s exited with %d", g_hostname, j->path, *s & 255);
+        } else {
+          VERBOSEF("%s says %s exited with %d", g_hostname, j->path, 0);
+        }
+      }
+      free(s);
+    } else {
+      WARNF("%s sent message with unknown command %d running %s", g_hostname,
+            msg[4], g_prog);
+      exitcode = 203;
+      break;
+    }
+  }
+  execute_latency = timespec_tomicros(timespec_sub(timespec_mono(), start));
+  close(g_sock);
+  return exitcode;
+}
+
+int RunBatchOnHost(char *spec) {
+  if (ConnectToHost(spec))
+    return 1;
+  if (!SendBatchRequest() || !SendNeededPrograms()) {
+    close(g_sock);
+    return 1;
+  }
+  int rc = ReadBatchResponse();
+  kprintf("%u programs on %-16s %'8ld µs %'8ld µs %'11d µs\n", g_njobs,
+          g_hostname, connect_latency, handshake_latency, execute_latency);
+  return rc;
+}
+
 bool IsParallelBuild(void) {
   const char *makeflags;
   return (makeflags = getenv("MAKEFLAGS")) && strstr(makeflags, "-j");
@@ -410,12 +620,16 @@ int SpawnSubprocesses(int argc, char *argv[]) {
   char *args[5] = {argv[0], argv[1], argv[2]};
 
   // create compressed network request ahead of time
-  const char *tmpdir = firstnonnull(getenv("TMPDIR"), "/tmp");
-  char *tpath = gc(xasprintf("%s/runit.XXXXXX", tmpdir));
-  int tmpfd = mkstemp(tpath);
-  CHECK_NE(-1, tmpfd);
-  CHECK(SendRequest(tmpfd));
-  CHECK_NE(-1, close(tmpfd));
+  // batches can't be, since they depend on what the daemon has
+  char *tpath = 0;
+  if (!g_batch) {
+    const char *tmpdir = firstnonnull(getenv("TMPDIR"), "/tmp");
+    tpath = gc(xasprintf("%s/runit.XXXXXX", tmpdir));
+    int tmpfd = mkstemp(tpath);
+    CHECK_NE(-1, tmpfd);
+    CHECK(SendRequest(tmpfd));
+    CHECK_NE(-1, close(tmpfd));
+  }
 
   // fork off 𝑛 subprocesses for each host on which we run binary.
   // what's important here is htop in tree mode will report like:
@@ -442,7 +656,8 @@ int SpawnSubprocesses(int argc, char *argv[]) {
     args[3] = argv[i];
     CHECK_NE(-1, (pids[i] = vfork()));
     if (!pids[i]) {
-      dup2(open(tpath, O_RDONLY | O_CLOEXEC), 13);
+      if (tpath)
+        dup2(open(tpath, O_RDONLY | O_CLOEXEC), 13);
       sigaction(SIGINT, &(struct sigaction){0}, 0);
       sigaction(SIGQUIT, &(struct sigaction){0}, 0);
       sigprocmask(SIG_SETMASK, &savemask, 0);
@@ -479,7 +694,8 @@ int SpawnSubprocesses(int argc, char *argv[]) {
       break;
     }
   }
-  unlink(tpath);
+  if (tpath)
+    unlink(tpath);
   sigprocmask(SIG_SETMASK, &savemask, 0);
   sigaction(SIGQUIT, &savequit, 0);
   sigaction(SIGINT, &saveint, 0);
@@ -504,7 +720,11 @@ int main(int argc, char *argv[]) {
     __builtin_unreachable();
   }
   CheckExists((g_runitd = argv[1]));
-  CheckExists((g_prog = argv[2]));
+  if (*(g_prog = argv[2]) == '@') {
+    g_batch = true;
+  } else {
+    CheckExists(g_prog);
+  }
   if (argc == 3) {
     /* hosts list empty */
     return 0;
@@ -514,6 +734,10 @@ int main(int argc, char *argv[]) {
     SetupPresharedKeySsl(MBEDTLS_SSL_IS_CLIENT, GetRunitPsk());
     g_sshport = 22;
     g_runitdport = RUNITD_PORT;
+    if (g_batch) {
+      LoadJobs(g_prog);
+      return RunBatchOnHost(argv[3]);
+    }
     return RunOnHost(argv[3]);
   } else {
     /* multiple hosts */
@@ -4,12 +4,18 @@
 #define RUNITD_PORT       31337
 #define RUNITD_MAGIC      0xFEEDABEEu
 #define RUNITD_TIMEOUT_MS (1000 * 60 * 60)
+#define RUNITD_HASHSIZE   32
+#define RUNITD_MAXJOBS    4096
 
 enum RunitCommand {
   kRunitExecute,
   kRunitStdout,
   kRunitStderr,
   kRunitExit,
+  kRunitBatch,
+  kRunitNeed,
+  kRunitJobOutput,
+  kRunitJobExit,
 };
 
 #endif /* COSMOPOLITAN_TOOL_BUILD_RUNIT_H_ */
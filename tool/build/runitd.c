@@ -34,6 +34,7 @@
 #include "libc/fmt/libgen.h"
 #include "libc/intrin/kprintf.h"
 #include "libc/log/appendresourcereport.internal.h"
+#include "libc/limits.h"
 #include "libc/log/check.h"
 #include "libc/macros.h"
 #include "libc/mem/gc.h"
@@ -51,6 +52,7 @@
 #include "libc/stdio/rand.h"
 #include "libc/stdio/stdio.h"
 #include "libc/stdio/sysparam.h"
+#include "libc/str/blake2.h"
 #include "libc/str/str.h"
 #include "libc/sysv/consts/af.h"
 #include "libc/sysv/consts/at.h"
@@ -62,6 +64,7 @@
 #include "libc/sysv/consts/ipproto.h"
 #include "libc/sysv/consts/itimer.h"
 #include "libc/sysv/consts/o.h"
+#include "libc/sysv/consts/ok.h"
 #include "libc/sysv/consts/poll.h"
 #include "libc/sysv/consts/posix.h"
 #include "libc/sysv/consts/sa.h"
@@ -75,6 +78,7 @@
 #include "libc/thread/thread2.h"
 #include "libc/time.h"
 #include "libc/x/x.h"
+#include "libc/x/xasprintf.h"
 #include "libc/x/xsigaction.h"
 #include "net/http/escape.h"
 #include "net/https/https.h"
@@ -119,6 +123,40 @@
  *   - 4 byte nbo magic = 0xFEEDABEEu
  *   - 1 byte command = kRunitExit
  *   - 1 byte exit status
+ *
+ * Many programs may instead be run over one connection in batch mode:
+ *
+ * 1. Receives batch header, followed by a description of each job:
+ *
+ *   - 4 byte nbo magic = 0xFEEDABEEu
+ *   - 1 byte command = kRunitBatch
+ *   - 4 byte nbo job count
+ *   - 4 byte nbo max concurrent jobs, or 0 for cpu count
+ *   - 4 byte nbo reserved
+ *   - for each job:
+ *     - 4 byte nbo name length in bytes
+ *     - 4 byte nbo executable file length in bytes
+ *     - 32 byte blake2b256 hash of executable
+ *     - <name bytes>
+ *
+ * 2. Sends indices of jobs whose executables aren't in o/runit/:
+ *
+ *   - 4 byte nbo magic = 0xFEEDABEEu
+ *   - 1 byte command = kRunitNeed
+ *   - 4 byte nbo count
+ *   - <4 byte nbo job index...>
+ *
+ * 3. Receives the <file bytes> of each needed executable, in order.
+ *
+ * 4. Runs jobs concurrently, sending messages as things happen:
+ *
+ *   - 4 byte nbo magic = 0xFEEDABEEu
+ *   - 1 byte command = kRunitJobOutput or kRunitJobExit
+ *   - 4 byte nbo job index
+ *   - 4 byte nbo byte length
+ *   - <chunk bytes> (or 1 byte exit status)
+ *
+ * 5. Sends kRunitExit message with first nonzero exit status.
  */
 
 #define DEATH_CLOCK_SECONDS 300
@@ -442,6 +480,349 @@ void FreeClient(struct Client *client) {
   VERBF("---------------");
 }
 
+struct BatchJob {
+  int pid;
+  int pipe;
+  bool have;
+  bool killed;
+  uint32_t filesize;
+  char *name;
+  char *path;
+  struct timespec started;
+  unsigned char hash[RUNITD_HASHSIZE];
+};
+
+struct Batch {
+  uint32_t n;
+  struct BatchJob *jobs;
+};
+
+void SendAll(const void *data, size_t size, const char *what) {
+  ssize_t rc;
+  const char *p = data;
+  while (size) {
+    if ((rc = mbedtls_ssl_write(&ezssl, p, size)) <= 0)
+      EzTlsDie(what, rc);
+    size -= rc;
+    p += rc;
+  }
+  if ((rc = EzTlsFlush(&ezbio, 0, 0)))
+    EzTlsDie(what, rc);
+}
+
+void SendJobMessage(enum RunitCommand kind, uint32_t job, const void *data,
+                    size_t size) {
+  unsigned char msg[4 + 1 + 4 + 4 + 256], *p = msg;
+  p = WRITE32BE(p, RUNITD_MAGIC);
+  *p++ = kind;
+  p = WRITE32BE(p, job);
+  p = WRITE32BE(p, size);
+  if (size <= sizeof(msg) - (p - msg)) {
+    p = mempcpy(p, data, size);
+    SendAll(msg, p - msg, "SendJobMessage failed");
+  } else {
+    SendAll(msg, p - msg, "SendJobMessage failed");
+    SendAll(data, size, "SendJobMessage failed");
+  }
+}
+
+void FreeBatch(struct Batch *b) {
+  for (uint32_t i = 0; i < b->n; ++i) {
+    if (b->jobs[i].pid > 0) {
+      kill(b->jobs[i].pid, SIGKILL);
+      waitpid(b->jobs[i].pid, 0, 0);
+    }
+    Close(&b->jobs[i].pipe);
+    free(b->jobs[i].name);
+    free(b->jobs[i].path);
+  }
+  free(b->jobs);
+  free(b);
+}
+
+// stores executable received from client in content addressed cache
+bool StoreBatchJob(struct Client *client, struct BatchJob *j) {
+  int fd;
+  char *tmp;
+  unsigned char hash[RUNITD_HASHSIZE];
+  char *exedata = malloc(j->filesize);
+  Recv(client, exedata, j->filesize);
+  BLAKE2B256(exedata, j->filesize, hash);
+  if (memcmp(hash, j->hash, RUNITD_HASHSIZE)) {
+    WARNF("%s hash mismatch!", j->name);
+    free(exedata);
+    return false;
+  }
+  makedirs(gc(xdirname(j->path)), 0700);
+  tmp = gc(xasprintf("%s.XXXXXX", j->path));
+  if ((fd = openatemp(AT_FDCWD, tmp, 0, O_CLOEXEC, 0700)) == -1) {
+    WARNF("failed to open temporary file %#s due to %m", tmp);
+    free(exedata);
+    return false;
+  }
+  if (write(fd, exedata, j->filesize) != j->filesize) {
+    WARNF("failed to write %#s due to %m", tmp);
+    close(fd);
+    unlink(tmp);
+    free(exedata);
+    return false;
+  }
+  free(exedata);
+  if (close(fd) || rename(tmp, j->path)) {
+    WARNF("failed to store %#s due to %m", j->path);
+    unlink(tmp);
+    return false;
+  }
+  return true;
+}
+
+bool SpawnBatchJob(struct BatchJob *j) {
+  errno_t err;
+  int i = 0, pipefds[2];
+  char *args[4] = {0};
+  sigset_t sigmask;
+  posix_spawnattr_t spawnattr;
+  posix_spawn_file_actions_t spawnfila;
+  args[i++] = j->path;
+  if (use_strace)
+    args[i++] = "--strace";
+  if (use_ftrace)
+    args[i++] = "--ftrace";
+  for (int tries = 0;; ++tries) {
+    if (pipe2(pipefds, O_CLOEXEC))
+      return false;
+    sigemptyset(&sigmask);
+    posix_spawnattr_init(&spawnattr);
+    posix_spawnattr_setflags(&spawnattr, POSIX_SPAWN_USEVFORK |
+                                             POSIX_SPAWN_SETSIGMASK |
+                                             POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setsigmask(&spawnattr, &sigmask);
+    posix_spawn_file_actions_init(&spawnfila);
+    posix_spawn_file_actions_adddup2(&spawnfila, g_bogusfd, 0);
+    posix_spawn_file_actions_adddup2(&spawnfila, pipefds[1], 1);
+    posix_spawn_file_actions_adddup2(&spawnfila, pipefds[1], 2);
+    j->started = timespec_mono();
+    err = posix_spawn(&j->pid, j->path, &spawnfila, &spawnattr, args, environ);
+    posix_spawn_file_actions_destroy(&spawnfila);
+    posix_spawnattr_destroy(&spawnattr);
+    close(pipefds[1]);
+    if (!err) {
+      j->pipe = pipefds[0];
+      return true;
+    }
+    close(pipefds[0]);
+    j->pid = 0;
+    // another thread may have vforked while a binary was being written
+    if (err != ETXTBSY || tries == 16 || usleep(1u << tries)) {
+      errno = err;
+      return false;
+    }
+  }
+}
+
+void FinishBatchJob(uint32_t id, struct BatchJob *j, int *status) {
+  int wstatus;
+  unsigned char exitcode;
+  struct rusage rusage;
+  char *output = 0;
+  while (wait4(j->pid, &wstatus, 0, &rusage) == -1) {
+    if (errno != EINTR) {
+      wstatus = -1;
+      break;
+    }
+  }
+  j->pid = 0;
+  int64_t micros = timespec_tomicros(timespec_sub(timespec_mono(), j->started));
+  if (wstatus == -1) {
+    exitcode = 127;
+  } else if (WIFEXITED(wstatus)) {
+    exitcode = WEXITSTATUS(wstatus);
+  } else if (WIFSIGNALED(wstatus)) {
+    exitcode = 128 + WTERMSIG(wstatus);
+  } else {
+    exitcode = 127;
+  }
+  if (exitcode) {
+    WARNF("%s on %s exited with $?=%d after %'ldµs", j->name, g_hostname,
+          exitcode, micros);
+    if (j->killed)
+      appendf(&output, "killed after timing out after %d seconds\n",
+              DEATH_CLOCK_SECONDS);
+    appendf(&output, "------ %s %s $?=%d (0x%08x) %,ldµs ------\n",
+            g_hostname, j->name, exitcode, wstatus, micros);
+    AppendResourceReport(&output, &rusage, "\n");
+    SendJobMessage(kRunitJobOutput, id, output, appendz(output).i);
+    free(output);
+    if (!*status)
+      *status = exitcode;
+  } else {
+    INFOF("%s on %s exited with $?=%d after %'ldµs", j->name, g_hostname,
+          exitcode, micros);
+  }
+  SendJobMessage(kRunitJobExit, id, &exitcode, 1);
+}
+
+// runs many programs over a single connection
+//
+// the client first describes every program by name and hash, so we can
+// tell it which ones aren't in our cache yet. only those get uploaded.
+// then the programs are run concurrently, and their output and status
+// are sent back as they happen, tagged by the index of their job.
+void ServeBatch(struct Client *client, uint32_t n, uint32_t parallel) {
+  char hex[RUNITD_HASHSIZE * 2 + 1];
+  unsigned char msg[4 + 4 + RUNITD_HASHSIZE];
+  if (!n || n > RUNITD_MAXJOBS) {
+    WARNF("batch has bad job count %u", n);
+    return;
+  }
+  if (!parallel)
+    parallel = cosmo_cpu_count();
+  parallel = MIN(MAX(parallel, 1), n);
+  struct Batch *b = calloc(1, sizeof(struct Batch));
+  b->jobs = calloc(n, sizeof(struct BatchJob));
+  defer(FreeBatch, b);
+  for (uint32_t i = 0; i < n; ++i)
+    b->jobs[i].pipe = -1;
+  b->n = n;
+
+  // find out which programs we already have
+  uint32_t needed = 0;
+  unsigned char *need = gc(malloc(n * 4));
+  for (uint32_t i = 0; i < n; ++i) {
+    struct BatchJob *j = b->jobs + i;
+    Recv(client, msg, sizeof(msg));
+    uint32_t namesize = READ32BE(msg);
+    j->filesize = READ32BE(msg + 4);
+    memcpy(j->hash, msg + 8, RUNITD_HASHSIZE);
+    if (!namesize || namesize > NAME_MAX) {
+      WARNF("batch job has bad name size %u", namesize);
+      return;
+    }
+    j->name = calloc(1, namesize + 1);
+    Recv(client, j->name, namesize);
+    if (*j->name == '.' || strchr(j->name, '/') || strlen(j->name) < namesize) {
+      WARNF("batch job has bad name %#s", j->name);
+      return;
+    }
+    for (int k = 0; k < RUNITD_HASHSIZE; ++k) {
+      hex[k * 2 + 0] = "0123456789abcdef"[j->hash[k] >> 4];
+      hex[k * 2 + 1] = "0123456789abcdef"[j->hash[k] & 15];
+    }
+    hex[RUNITD_HASHSIZE * 2] = 0;
+    j->path = xasprintf("o/runit/%s/%s", hex,
+                        basename(stripext(gc(strdup(j->name)))));
+    if (!(j->have = !access(j->path, X_OK)))
+      WRITE32BE(need + needed++ * 4, i);
+  }
+  unsigned char hdr[4 + 1 + 4], *p = hdr;
+  p = WRITE32BE(p, RUNITD_MAGIC);
+  *p++ = kRunitNeed;
+  p = WRITE32BE(p, needed);
+  SendAll(hdr, p - hdr, "ServeBatch need failed");
+  if (needed)
+    SendAll(need, needed * 4, "ServeBatch need failed");
+  VERBF("%s sent batch of %u programs, of which %u were new",
+        DescribeAddress(&client->addr), n, needed);
+
+  // receive the programs we don't have
+  for (uint32_t i = 0; i < n; ++i)
+    if (!b->jobs[i].have)
+      if (!StoreBatchJob(client, b->jobs + i))
+        return;
+
+  // run up to `parallel` programs at once
+  int status = 0;
+  uint32_t next = 0, done = 0, running = 0;
+  struct pollfd *fds = gc(calloc(parallel + 1, sizeof(struct pollfd)));
+  uint32_t *ids = gc(calloc(parallel + 1, sizeof(uint32_t)));
+  while (done < n) {
+    while (running < parallel && next < n) {
+      struct BatchJob *j = b->jobs + next;
+      if (SpawnBatchJob(j)) {
+        ++running;
+      } else {
+        char *s = xasprintf("failed to spawn %s on %s due to %m\n", j->name,
+                            g_hostname);
+        unsigned char exitcode = 127;
+        WARNF("%s", s);
+        SendJobMessage(kRunitJobOutput, next, s, strlen(s));
+        SendJobMessage(kRunitJobExit, next, &exitcode, 1);
+        if (!status)
+          status = exitcode;
+        free(s);
+        ++done;
+      }
+      ++next;
+    }
+    if (g_interrupted) {
+      WARNF("hanging up %d and killing its batch due to interrupt", client->fd);
+      mbedtls_ssl_close_notify(&ezssl);
+      return;
+    }
+    int nfds = 1;
+    struct timespec now = timespec_mono();
+    struct timespec deadline = timespec_add(now, timespec_fromseconds(3600));
+    fds[0].fd = client->fd;
+    fds[0].events = POLLIN;
+    for (uint32_t i = 0; i < next; ++i) {
+      struct BatchJob *j = b->jobs + i;
+      if (j->pipe == -1)
+        continue;
+      struct timespec death =
+          timespec_add(j->started, timespec_fromseconds(DEATH_CLOCK_SECONDS));
+      if (!j->killed && timespec_cmp(now, death) >= 0) {
+        WARNF("killing %s (pid %d) which timed out after %d seconds", j->name,
+              j->pid, DEATH_CLOCK_SECONDS);
+        kill(j->pid, SIGKILL);
+        j->killed = true;
+      } else if (!j->killed && timespec_cmp(death, deadline) < 0) {
+        deadline = death;
+      }
+      fds[nfds].fd = j->pipe;
+      fds[nfds].events = POLLIN;
+      ids[nfds++] = i;
+    }
+    int64_t ms = timespec_tomillis(timespec_sub(deadline, now));
+    int events = poll(fds, nfds, MIN(ms, INT_MAX));
+    if (events == -1) {
+      if (errno == EINTR)
+        continue;
+      WARNF("hanging up batch because poll failed with %m");
+      return;
+    }
+    if (fds[0].revents) {
+      char buf[512];
+      int received = mbedtls_ssl_read(&ezssl, buf, sizeof(buf));
+      if (!received) {
+        WARNF("client disconnected so killing its batch");
+        return;
+      }
+      if (received < 0 && received != MBEDTLS_ERR_SSL_WANT_READ) {
+        WARNF("client ssl read failed with -0x%04x (%s) so killing batch",
+              -received, GetTlsError(received));
+        return;
+      }
+    }
+    for (int k = 1; k < nfds; ++k) {
+      if (!fds[k].revents)
+        continue;
+      char buf[512];
+      struct BatchJob *j = b->jobs + ids[k];
+      ssize_t got = read(j->pipe, buf, sizeof(buf));
+      if (got > 0) {
+        SendJobMessage(kRunitJobOutput, ids[k], buf, got);
+      } else if (!got || errno != EINTR) {
+        Close(&j->pipe);
+        FinishBatchJob(ids[k], j, &status);
+        --running;
+        ++done;
+      }
+    }
+  }
+  SendExitMessage(status);
+  mbedtls_ssl_close_notify(&ezssl);
+}
+
 void *ClientWorker(void *arg) {
   uint32_t crc;
   sigset_t sigmask;
@@ -479,6 +860,10 @@ void *ClientWorker(void *arg) {
     WARNF("%s magic mismatch!", addrstr);
     pthread_exit(0);
   }
+  if (msg[4] == kRunitBatch) {
+    ServeBatch(client, READ32BE(msg + 5), READ32BE(msg + 9));
+    pthread_exit(0);
+  }
   if (msg[4] != kRunitExecute) {
     WARNF("%s unknown command!", addrstr);
     pthread_exit(0);
@@ -22,6 +22,7 @@
 #include "libc/fmt/itoa.h"
 #include "libc/fmt/magnumstrs.internal.h"
 #include "libc/limits.h"
+#include "libc/mem/mem.h"
 #include "libc/runtime/runtime.h"
 #include "libc/stdio/stdio.h"
 #include "libc/str/str.h"
@@ -116,34 +117,96 @@ static bool IsSupportedPath(const char *path) {
   }
 }
 
-static bool GetDigest(const char *path, FILE *f, unsigned char digest[32]) {
+// small files are read into memory and hashed in batches, so that
+// mbedtls_sha256_multi() can put each one in its own simd lane
+#define kBatchFiles 16
+#define kSmallFile  65536
+
+struct Batch {
+  int n;
+  const char *path[kBatchFiles];
+  unsigned char *data[kBatchFiles];
+  size_t size[kBatchFiles];
+};
+
+static struct Batch g_batch;
+
+static bool HashRest(const char *path, FILE *f, mbedtls_sha256_context *ctx,
+                     unsigned char digest[32]) {
   size_t got;
   unsigned char buf[65536];
-  mbedtls_sha256_context ctx;
-  mbedtls_sha256_init(&ctx);
-  unassert(!mbedtls_sha256_starts_ret(&ctx, false));
   while ((got = fread(buf, 1, sizeof(buf), f))) {
-    unassert(!mbedtls_sha256_update_ret(&ctx, buf, got));
+    unassert(!mbedtls_sha256_update_ret(ctx, buf, got));
   }
   if (ferror(f)) {
     tinyprint(2, prog, ": ", path, ": ", strerror(errno), "\n", NULL);
+    mbedtls_sha256_free(ctx);
     return false;
   }
-  unassert(!mbedtls_sha256_finish_ret(&ctx, digest));
-  mbedtls_sha256_free(&ctx);
+  unassert(!mbedtls_sha256_finish_ret(ctx, digest));
+  mbedtls_sha256_free(ctx);
   return true;
 }
 
-static bool ProduceDigest(const char *path, FILE *f) {
+static bool GetDigest(const char *path, FILE *f, unsigned char digest[32]) {
+  mbedtls_sha256_context ctx;
+  mbedtls_sha256_init(&ctx);
+  unassert(!mbedtls_sha256_starts_ret(&ctx, false));
+  return HashRest(path, f, &ctx, digest);
+}
+
+static void PrintDigest(const char *path, const unsigned char digest[32]) {
   char hexdigest[65];
   char mode[2] = {g_mode};
+  hexpcpy(hexdigest, digest, 32);
+  tinyprint(1, hexdigest, " ", mode, path, "\n", NULL);
+}
+
+static void FlushBatch(void) {
+  int i;
+  unsigned char digests[kBatchFiles][32];
+  unassert(!mbedtls_sha256_multi((const void *const *)g_batch.data,
+                                 g_batch.size, g_batch.n, digests));
+  for (i = 0; i < g_batch.n; ++i) {
+    PrintDigest(g_batch.path[i], digests[i]);
+    free(g_batch.data[i]);
+  }
+  g_batch.n = 0;
+}
+
+static bool ProduceDigest(const char *path, FILE *f) {
+  size_t got;
+  unsigned char *data;
   unsigned char digest[32];
+  mbedtls_sha256_context ctx;
   if (!IsSupportedPath(path))
     return false;
-  if (!GetDigest(path, f, digest))
+  if (!(data = malloc(kSmallFile))) {
+    tinyprint(2, prog, ": ", path, ": ", strerror(errno), "\n", NULL);
     return false;
-  hexpcpy(hexdigest, digest, 32);
-  tinyprint(1, hexdigest, " ", mode, path, "\n", NULL);
+  }
+  got = fread(data, 1, kSmallFile, f);
+  if (ferror(f)) {
+    tinyprint(2, prog, ": ", path, ": ", strerror(errno), "\n", NULL);
+    free(data);
+    return false;
+  }
+  if (got < kSmallFile) {
+    g_batch.path[g_batch.n] = path;
+    g_batch.data[g_batch.n] = data;
+    g_batch.size[g_batch.n] = got;
+    if (++g_batch.n == kBatchFiles)
+      FlushBatch();
+    return true;
+  }
+  FlushBatch();
+  mbedtls_sha256_init(&ctx);
+  unassert(!mbedtls_sha256_starts_ret(&ctx, false));
+  unassert(!mbedtls_sha256_update_ret(&ctx, data, got));
+  free(data);
+  if (!HashRest(path, f, &ctx, digest))
+    return false;
+  PrintDigest(path, digest);
   return true;
 }
 
@@ -237,6 +300,7 @@ int main(int argc, char *argv[]) {
       }
     }
   }
+  FlushBatch();
   if (g_mismatches) {
     char ibuf[12];
     FormatInt32(ibuf, g_mismatches);
@@ -35,7 +35,10 @@
 #include "libc/zip.h"
 #include "third_party/getopt/getopt.internal.h"
 
+#define kZipAlign 65536
+
 static int infd;
+static bool align;
 static int outfd;
 static ssize_t insize;
 static ssize_t outsize;
@@ -83,6 +86,8 @@ DESCRIPTION\n\
 FLAGS\n\
 \n\
   -h            show this help\n\
+  -a            align uncompressed files 64kb or larger to 64kb\n\
+                boundaries, so zipos can mmap() them zero-copy\n\
 \n\
 EXAMPLE\n\
 \n\
@@ -97,8 +102,11 @@ EXAMPLE\n\
 
 static void GetOpts(int argc, char *argv[]) {
   int opt;
-  while ((opt = getopt(argc, argv, "h")) != -1) {
+  while ((opt = getopt(argc, argv, "ah")) != -1) {
     switch (opt) {
+      case 'a':
+        align = true;
+        break;
       case 'h':
         PrintUsage(1, 0);
       default:
@@ -112,6 +120,15 @@ static void GetOpts(int argc, char *argv[]) {
   outpath = argv[optind + 1];
 }
 
+// returns output offset of local file so its content is aligned
+static unsigned long AlignLfile(unsigned char *lfile, unsigned long off) {
+  if (align &&  //
+      ZIP_LFILE_COMPRESSIONMETHOD(lfile) == kZipCompressionNone &&
+      ZIP_LFILE_COMPRESSEDSIZE(lfile) >= kZipAlign)
+    off += -(off + ZIP_LFILE_HDRSIZE(lfile)) & (kZipAlign - 1);
+  return off;
+}
+
 static void CopyZip(void) {
   char *secstrs;
   int rela, recs;
@@ -187,9 +204,13 @@ static void CopyZip(void) {
     SysDie(outpath, "lseek");
   }
   ldest = outsize;
-  cdest = outsize + ltotal;
   for (cfile = cdir; cfile < stop; cfile += ZIP_CFILE_HDRSIZE(cfile)) {
     lfile = inmap + ZIP_CFILE_OFFSET(cfile);
+    ldest = AlignLfile(lfile, ldest);
+    if (ldest + ZIP_LFILE_SIZE(lfile) + ctotal + ZIP_CDIR_HDRSIZE(eocd) >
+        INT_MAX) {
+      Die(outpath, "the time has come to upgrade to zip64");
+    }
     WRITE32LE(cfile + kZipCfileOffsetOffset, ldest);
     // write local file
     length = ZIP_LFILE_SIZE(lfile);
@@ -197,6 +218,10 @@ static void CopyZip(void) {
       SysDie(outpath, "lfile pwrite");
     }
     ldest += length;
+  }
+  ltotal = ldest - outsize;
+  cdest = ldest;
+  for (cfile = cdir; cfile < stop; cfile += ZIP_CFILE_HDRSIZE(cfile)) {
     // write directory entry
     length = ZIP_CFILE_HDRSIZE(cfile);
     if (pwrite(outfd, cfile, length, cdest) != length) {
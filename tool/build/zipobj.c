@@ -19,6 +19,7 @@
 #include "libc/assert.h"
 #include "libc/calls/calls.h"
 #include "libc/calls/struct/stat.h"
+#include "libc/cosmo.h"
 #include "libc/elf/def.h"
 #include "libc/errno.h"
 #include "libc/fmt/conv.h"
@@ -26,6 +27,7 @@
 #include "libc/limits.h"
 #include "libc/log/check.h"
 #include "libc/log/log.h"
+#include "libc/mem/mem.h"
 #include "libc/mem/gc.h"
 #include "libc/runtime/runtime.h"
 #include "libc/stdio/stdio.h"
@@ -49,11 +51,12 @@ char *name_;
 char *yoink_;
 char *symbol_;
 char *outpath_;
-bool nocompress_;
+int method_ = kZipCompressionDeflate;
 bool basenamify_;
 int strip_components_;
 const char *path_prefix_;
 struct timespec timestamp;
+struct CosmoTaskPool *pool_;
 
 [[noreturn]] void PrintUsage(int fd, int rc) {
   tinyprint(fd, "\n\
@@ -77,6 +80,7 @@ FLAGS\n\
   -h              show help\n\
   -o PATH         output path\n\
   -0              disable compression\n\
+  -Z              compress with zstd rather than deflate\n\
   -B              basename-ify zip filename\n\
   -a ARCH         microprocessor architecture\n\
   -N ZIPPATH      zip filename (defaults to input arg)\n\
@@ -109,7 +113,7 @@ static int ParseArch(const char *s) {
 void GetOpts(int *argc, char ***argv) {
   int opt;
   yoink_ = "__zip_eocd";
-  while ((opt = getopt(*argc, *argv, "?0nhBN:C:P:o:s:y:a:")) != -1) {
+  while ((opt = getopt(*argc, *argv, "?0nhBZN:C:P:o:s:y:a:")) != -1) {
     switch (opt) {
       case 'o':
         outpath_ = optarg;
@@ -138,7 +142,10 @@ void GetOpts(int *argc, char ***argv) {
         basenamify_ = true;
         break;
       case '0':
-        nocompress_ = true;
+        method_ = kZipCompressionNone;
+        break;
+      case 'Z':
+        method_ = kZipCompressionZstd;
         break;
       case '?':
       case 'h':
@@ -158,32 +165,37 @@ void GetOpts(int *argc, char ***argv) {
   }
 }
 
-void ProcessFile(struct ElfWriter *elf, const char *path) {
+struct Entry {
   int fd;
   void *map;
   struct stat st;
   const char *name;
-  if (stat(path, &st)) {
+  struct ElfWriterZipContent z;
+};
+
+void OpenFile(struct Entry *e, const char *path) {
+  const char *name;
+  if (stat(path, &e->st)) {
     perror(path);
     exit(1);
   }
-  if (S_ISDIR(st.st_mode)) {
-    if ((fd = open(path, O_RDONLY | O_DIRECTORY)) == -1) {
+  if (S_ISDIR(e->st.st_mode)) {
+    if ((e->fd = open(path, O_RDONLY | O_DIRECTORY)) == -1) {
       perror(path);
       exit(1);
     }
-    map = "";
-    st.st_size = 0;
-  } else if (st.st_size) {
-    if ((fd = open(path, O_RDONLY)) == -1 ||
-        (map = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0)) ==
+    e->map = "";
+    e->st.st_size = 0;
+  } else if (e->st.st_size) {
+    if ((e->fd = open(path, O_RDONLY)) == -1 ||
+        (e->map = mmap(0, e->st.st_size, PROT_READ, MAP_SHARED, e->fd, 0)) ==
             MAP_FAILED) {
       perror(path);
       exit(1);
     }
   } else {
-    fd = -1;
-    map = 0;
+    e->fd = -1;
+    e->map = 0;
   }
   if (name_) {
     name = name_;
@@ -195,18 +207,34 @@ void ProcessFile(struct ElfWriter *elf, const char *path) {
     if (path_prefix_)
       name = gc(xjoinpaths(path_prefix_, name));
   }
-  if (S_ISDIR(st.st_mode)) {
-    st.st_size = 0;
+  if (S_ISDIR(e->st.st_mode)) {
+    e->st.st_size = 0;
     if (!endswith(name, "/")) {
       name = gc(xstrcat(name, '/'));
     }
   }
-  elfwriter_zip(elf, name, name, strlen(name), map, st.st_size, st.st_mode,
-                timestamp, timestamp, timestamp, nocompress_);
-  if (st.st_size) {
-    unassert(!munmap(map, st.st_size));
+  e->name = xstrdup(name);
+}
+
+void CompressFiles(long i, long j, void *arg) {
+  struct Entry *e;
+  for (; i < j; ++i) {
+    e = (struct Entry *)arg + i;
+    elfwriter_zip_compress(&e->z, pool_, e->name, strlen(e->name), e->map,
+                           e->st.st_size, method_);
   }
-  close(fd);
+}
+
+void EmitFile(struct ElfWriter *elf, struct Entry *e) {
+  elfwriter_zip_emit(elf, &e->z, e->name, e->name, strlen(e->name), e->map,
+                     e->st.st_size, e->st.st_mode, timestamp, timestamp,
+                     timestamp);
+  elfwriter_zip_destroy(&e->z);
+  if (e->st.st_size) {
+    unassert(!munmap(e->map, e->st.st_size));
+  }
+  close(e->fd);
+  free((void *)e->name);
 }
 
 void PullEndOfCentralDirectoryIntoLinkage(struct ElfWriter *elf) {
@@ -224,17 +252,32 @@ void CheckFilenameKosher(const char *path) {
 
 void zipobj(int argc, char **argv) {
   size_t i;
+  struct Entry *entries;
   struct ElfWriter *elf;
   unassert(argc < UINT16_MAX / 3 - 64); /* ELF 64k section limit */
   GetOpts(&argc, &argv);
   for (i = 0; i < argc; ++i)
     CheckFilenameKosher(argv[i]);
+  entries = xcalloc(argc, sizeof(*entries));
+  for (i = 0; i < argc; ++i)
+    OpenFile(entries + i, argv[i]);
+  // compression runs in parallel, since entries don't depend on each
+  // other, but they're emitted in argv order to keep the output stable
+  if (argc > 1 || (argc && entries[0].st.st_size > 1024 * 1024))
+    pool_ = cosmo_taskpool_new(0);
+  if (pool_) {
+    cosmo_parallel_for(pool_, 0, argc, 1, CompressFiles, entries);
+  } else {
+    CompressFiles(0, argc, entries);
+  }
   elf = elfwriter_open(outpath_, 0644, arch_);
   elfwriter_cargoculting(elf);
   for (i = 0; i < argc; ++i)
-    ProcessFile(elf, argv[i]);
+    EmitFile(elf, entries + i);
   PullEndOfCentralDirectoryIntoLinkage(elf);
   elfwriter_close(elf);
+  cosmo_taskpool_free(pool_);
+  free(entries);
 }
 
 int main(int argc, char **argv) {
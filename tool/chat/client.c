@@ -23,7 +23,14 @@ static const uint8_t server_public_key[32] = {
 static uint8_t client_public_key[32];
 static uint8_t client_private_key[32];
 
+// Messages travel as a 16-bit big endian length followed by that many
+// bytes of ciphertext and tag. The server numbers its nonces from the
+// top half of the HPKE sequence space so crossing frames stay in sync.
+#define MAX_FRAME  (2 + 512 + 16)
+#define SERVER_SEQ 0x8000000000000000ull
+
 static Hacl_Impl_HPKE_context_s hpke_ctx;
+static Hacl_Impl_HPKE_context_s hpke_rx;
 
 static bool Tune(int fd, int a, int b, int x) {
   if (!b)
@@ -68,12 +75,12 @@ static ssize_t decrypt_message(const uint8_t* ciphertext, size_t ciphertext_len,
     return -1;
   }
   uint8_t nonce[12];
-  if (Hacl_HPKE_getNonce(&hpke_ctx, nonce))
+  if (Hacl_HPKE_getNonce(&hpke_rx, nonce))
     return -1;
   const uint8_t* cipher = ciphertext;
   const uint8_t* tag = ciphertext + ciphertext_len - 16;
   if (Hacl_AEAD_Chacha20Poly1305_decrypt(plaintext, cipher, ciphertext_len - 16,
-                                         NULL, 0, hpke_ctx.ctx_key, nonce, tag))
+                                         NULL, 0, hpke_rx.ctx_key, nonce, tag))
     return -1;
   return ciphertext_len - 16;  // plaintext length
 }
@@ -133,6 +140,8 @@ int main(int argc, char* argv[]) {
     fprintf(stderr, "HPKE setup failed\n");
     exit(1);
   }
+  hpke_rx = hpke_ctx;
+  hpke_rx.ctx_seq = SERVER_SEQ;
 
   // Print HPKE context
   printf("HPKE ctx_key: %s\n", EncodeBase64(hpke_ctx.ctx_key, 32, 0));
@@ -140,6 +149,8 @@ int main(int argc, char* argv[]) {
   printf("HPKE ctx_exporter: %s\n", EncodeBase64(hpke_ctx.ctx_exporter, 32, 0));
 
   // chat loop
+  size_t inlen = 0;
+  uint8_t inbuf[4096];
   for (;;) {
     struct pollfd fds[2] = {
         {0, POLLIN},
@@ -162,25 +173,29 @@ int main(int argc, char* argv[]) {
         break;
 
       // Encrypt message before sending
-      uint8_t encrypted[512 + 16];  // plaintext + tag
-      ssize_t encrypted_len = encrypt_message((uint8_t*)buf, got, encrypted);
+      uint8_t encrypted[MAX_FRAME];  // length + plaintext + tag
+      ssize_t encrypted_len =
+          encrypt_message((uint8_t*)buf, got, encrypted + 2);
       if (encrypted_len == -1) {
         fprintf(stderr, "Encryption failed\n");
         exit(1);
       }
-
-      ssize_t wrote = write(sockfd, encrypted, encrypted_len);
-      if (wrote == -1) {
-        fprintf(stderr, "%s:%s: send failed: %s\n", host, port,
-                strerror(errno));
-        exit(1);
+      encrypted[0] = encrypted_len >> 8;
+      encrypted[1] = encrypted_len;
+
+      for (ssize_t i = 0, wrote; i < 2 + encrypted_len; i += wrote) {
+        wrote = write(sockfd, encrypted + i, 2 + encrypted_len - i);
+        if (wrote == -1) {
+          fprintf(stderr, "%s:%s: send failed: %s\n", host, port,
+                  strerror(errno));
+          exit(1);
+        }
       }
     }
 
     // handle activity on socket
     if (fds[1].revents) {
-      uint8_t encrypted_buf[512 + 16];
-      ssize_t got = read(sockfd, encrypted_buf, sizeof(encrypted_buf));
+      ssize_t got = read(sockfd, inbuf + inlen, sizeof(inbuf) - inlen);
       if (got == -1) {
         fprintf(stderr, "%s:%s: recv failed: %s\n", host, port,
                 strerror(errno));
@@ -188,21 +203,34 @@ int main(int argc, char* argv[]) {
       }
       if (!got)
         break;
-
-      // Decrypt message before displaying
-      char plaintext[512];
-      ssize_t plaintext_len =
-          decrypt_message(encrypted_buf, got, (uint8_t*)plaintext);
-      if (plaintext_len == -1) {
-        fprintf(stderr, "Decryption failed\n");
-        exit(1);
-      }
-
-      ssize_t wrote = write(1, plaintext, plaintext_len);
-      if (wrote == -1) {
-        perror("write");
-        exit(1);
+      inlen += got;
+
+      // Decrypt each complete message before displaying
+      size_t i = 0;
+      while (inlen - i >= 2) {
+        size_t len = inbuf[i] << 8 | inbuf[i + 1];
+        if (len > MAX_FRAME - 2) {
+          fprintf(stderr, "%s:%s: bad frame\n", host, port);
+          exit(1);
+        }
+        if (inlen - i < 2 + len)
+          break;
+        char plaintext[512];
+        ssize_t plaintext_len =
+            decrypt_message(inbuf + i + 2, len, (uint8_t*)plaintext);
+        if (plaintext_len == -1) {
+          fprintf(stderr, "Decryption failed\n");
+          exit(1);
+        }
+        ssize_t wrote = write(1, plaintext, plaintext_len);
+        if (wrote == -1) {
+          perror("write");
+          exit(1);
+        }
+        i += 2 + len;
       }
+      memmove(inbuf, inbuf + i, inlen - i);
+      inlen -= i;
     }
   }
 
@@ -1,18 +1,31 @@
 #include <errno.h>
+#include <fcntl.h>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <poll.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include "libc/sysv/errfuns.h"
-#include "net/http/escape.h"
 #include "third_party/haclstar/haclstar.h"
 
+// Messages travel as a 16-bit big endian length followed by that many
+// bytes of ChaCha20-Poly1305 ciphertext and tag. Each direction draws
+// nonces from its own half of the HPKE sequence space, so that frames
+// crossing on the wire can't desynchronize the two peers.
+#define MAX_MESSAGE 512
+#define MAX_FRAME   (2 + MAX_MESSAGE + 16)
+#define MAX_IOVEC   64
+#define MAX_BACKLOG (1024 * 1024)
+#define SERVER_SEQ  0x8000000000000000ull
+#define INBUF_SIZE  4096
+
 // Server's long-term Curve25519 keypair (hardcoded for demo)
 static const uint8_t server_private_key[32] = {
     0xa0, 0x76, 0x73, 0xf4, 0x5a, 0x73, 0x8d, 0xda,  //
@@ -28,7 +41,42 @@ static const uint8_t server_public_key[32] = {
     0x17, 0x7a, 0x1d, 0xf9, 0xe0, 0x52, 0xfa, 0x49,  //
 };
 
-static Hacl_Impl_HPKE_context_s hpke_ctx;
+struct frame {
+  struct frame* next;
+  size_t len;
+  uint8_t data[MAX_FRAME];
+};
+
+struct client {
+  int fd;
+  bool dead;
+  bool ready;             // received ephemeral public key
+  size_t inlen;           // bytes buffered in `in`
+  size_t queued;          // bytes awaiting send
+  size_t sent;            // bytes of `head` already sent
+  struct frame* head;     // queue of encrypted frames
+  struct frame** tail;
+  Hacl_Impl_HPKE_context_s rx;
+  Hacl_Impl_HPKE_context_s tx;
+  uint8_t in[INBUF_SIZE];
+};
+
+struct message {
+  struct client* from;  // null if typed by operator
+  size_t len;
+  uint8_t data[MAX_MESSAGE];
+};
+
+static const char* host;
+static const char* port;
+
+static size_t nclients;
+static struct client** clients;
+static struct pollfd* fds;
+
+static size_t nmessages;
+static size_t cmessages;
+static struct message* messages;
 
 static bool Tune(int fd, int a, int b, int x) {
   if (!b)
@@ -47,33 +95,237 @@ static int Socket(int family, int type, int protocol) {
   return fd;
 }
 
-static ssize_t encrypt_message(const uint8_t* plaintext, size_t plaintext_len,
+static ssize_t encrypt_message(Hacl_Impl_HPKE_context_s* ctx,
+                               const uint8_t* plaintext, size_t plaintext_len,
                                uint8_t* ciphertext) {
   uint8_t nonce[12];
-  if (Hacl_HPKE_getNonce(&hpke_ctx, nonce))
+  if (Hacl_HPKE_getNonce(ctx, nonce))
     return -1;
   uint8_t* cipher = ciphertext;
   uint8_t* tag = ciphertext + plaintext_len;
   Hacl_AEAD_Chacha20Poly1305_encrypt(cipher, tag, plaintext, plaintext_len,
-                                     NULL, 0, hpke_ctx.ctx_key, nonce);
+                                     NULL, 0, ctx->ctx_key, nonce);
   return plaintext_len + 16;  // ciphertext + tag
 }
 
-static ssize_t decrypt_message(const uint8_t* ciphertext, size_t ciphertext_len,
+static ssize_t decrypt_message(Hacl_Impl_HPKE_context_s* ctx,
+                               const uint8_t* ciphertext, size_t ciphertext_len,
                                uint8_t* plaintext) {
   if (ciphertext_len < 16)
     return -1;
   uint8_t nonce[12];
-  if (Hacl_HPKE_getNonce(&hpke_ctx, nonce))
+  if (Hacl_HPKE_getNonce(ctx, nonce))
     return -1;
   const uint8_t* cipher = ciphertext;
   const uint8_t* tag = ciphertext + ciphertext_len - 16;
   if (Hacl_AEAD_Chacha20Poly1305_decrypt(plaintext, cipher, ciphertext_len - 16,
-                                         NULL, 0, hpke_ctx.ctx_key, nonce, tag))
+                                         NULL, 0, ctx->ctx_key, nonce, tag))
     return -1;
   return ciphertext_len - 16;  // plaintext length
 }
 
+static void* xrealloc(void* p, size_t n) {
+  if (!(p = realloc(p, n))) {
+    perror("realloc");
+    exit(1);
+  }
+  return p;
+}
+
+static void post_message(struct client* from, const void* data, size_t len) {
+  if (nmessages == cmessages) {
+    cmessages = cmessages ? cmessages * 2 : 16;
+    messages = xrealloc(messages, cmessages * sizeof(*messages));
+  }
+  messages[nmessages].from = from;
+  messages[nmessages].len = len;
+  memcpy(messages[nmessages].data, data, len);
+  ++nmessages;
+}
+
+static void add_client(int fd) {
+  struct client* c;
+  if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) == -1) {
+    perror("fcntl");
+    close(fd);
+    return;
+  }
+  Tune(fd, SOL_TCP, TCP_NODELAY, 1);
+  if (!(c = calloc(1, sizeof(*c)))) {
+    close(fd);
+    return;
+  }
+  c->fd = fd;
+  c->tail = &c->head;
+  clients = xrealloc(clients, (nclients + 1) * sizeof(*clients));
+  fds = xrealloc(fds, (2 + nclients + 1) * sizeof(*fds));
+  clients[nclients++] = c;
+  fprintf(stderr, "client %d connected (%zu online)\n", fd, nclients);
+}
+
+static void free_client(struct client* c) {
+  struct frame *f, *next;
+  for (f = c->head; f; f = next) {
+    next = f->next;
+    free(f);
+  }
+  close(c->fd);
+  free(c);
+}
+
+// removes clients that hung up or misbehaved during this round
+static void sweep_clients(void) {
+  size_t i, j;
+  for (i = j = 0; i < nclients; ++i) {
+    if (clients[i]->dead) {
+      fprintf(stderr, "client %d disconnected\n", clients[i]->fd);
+      free_client(clients[i]);
+    } else {
+      clients[j++] = clients[i];
+    }
+  }
+  nclients = j;
+}
+
+static void enqueue_message(struct client* c, const struct message* m) {
+  struct frame* f;
+  ssize_t len;
+  if (c->queued > MAX_BACKLOG) {
+    fprintf(stderr, "client %d is too slow\n", c->fd);
+    c->dead = true;
+    return;
+  }
+  if (!(f = malloc(sizeof(*f)))) {
+    c->dead = true;
+    return;
+  }
+  if ((len = encrypt_message(&c->tx, m->data, m->len, f->data + 2)) == -1) {
+    free(f);
+    c->dead = true;
+    return;
+  }
+  f->data[0] = len >> 8;
+  f->data[1] = len;
+  f->len = 2 + len;
+  f->next = 0;
+  *c->tail = f;
+  c->tail = &f->next;
+  c->queued += f->len;
+}
+
+// sends as much of the frame queue as the kernel will take at once
+static void flush_client(struct client* c) {
+  int n;
+  ssize_t rc;
+  struct frame* f;
+  struct iovec iov[MAX_IOVEC];
+  while (c->head && !c->dead) {
+    for (n = 0, f = c->head; f && n < MAX_IOVEC; f = f->next, ++n) {
+      iov[n].iov_base = f->data;
+      iov[n].iov_len = f->len;
+    }
+    iov[0].iov_base = c->head->data + c->sent;
+    iov[0].iov_len = c->head->len - c->sent;
+    if ((rc = writev(c->fd, iov, n)) == -1) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        c->dead = true;
+      return;
+    }
+    c->queued -= rc;
+    rc += c->sent;
+    while ((f = c->head) && rc >= f->len) {
+      rc -= f->len;
+      if (!(c->head = f->next))
+        c->tail = &c->head;
+      free(f);
+    }
+    c->sent = rc;
+    if (n == MAX_IOVEC && c->head)
+      continue;
+    if (c->head)
+      return;
+  }
+}
+
+static void read_client(struct client* c) {
+  ssize_t got;
+  size_t i, len;
+  char plaintext[MAX_MESSAGE];
+  if ((got = read(c->fd, c->in + c->inlen, sizeof(c->in) - c->inlen)) == -1) {
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+      c->dead = true;
+    return;
+  }
+  if (!got) {
+    c->dead = true;
+    return;
+  }
+  c->inlen += got;
+  i = 0;
+
+  // Perform HPKE handshake - receive client's ephemeral public key
+  if (!c->ready) {
+    if (c->inlen < 32)
+      return;
+    const uint8_t info[] = "chat-server-v1";
+    if (Hacl_HPKE_Curve25519_CP128_SHA256_setupBaseR(
+            &c->rx, c->in, server_private_key, sizeof(info) - 1, info) == -1) {
+      fprintf(stderr, "client %d: HPKE setup failed\n", c->fd);
+      c->dead = true;
+      return;
+    }
+    c->tx = c->rx;
+    c->tx.ctx_seq = SERVER_SEQ;
+    c->ready = true;
+    i = 32;
+  }
+
+  // Decrypt each complete frame
+  while (c->inlen - i >= 2) {
+    len = c->in[i] << 8 | c->in[i + 1];
+    if (len < 16 || len > MAX_FRAME - 2) {
+      fprintf(stderr, "client %d: bad frame\n", c->fd);
+      c->dead = true;
+      return;
+    }
+    if (c->inlen - i < 2 + len)
+      break;
+    ssize_t plaintext_len =
+        decrypt_message(&c->rx, c->in + i + 2, len, (uint8_t*)plaintext);
+    if (plaintext_len == -1) {
+      fprintf(stderr, "client %d: decryption failed\n", c->fd);
+      c->dead = true;
+      return;
+    }
+    post_message(c, plaintext, plaintext_len);
+    i += 2 + len;
+  }
+  memmove(c->in, c->in + i, c->inlen - i);
+  c->inlen -= i;
+}
+
+// delivers messages received this round to everyone but their sender
+static void broadcast(void) {
+  size_t i, j;
+  for (i = 0; i < nmessages; ++i) {
+    if (messages[i].from) {
+      if (write(1, messages[i].data, messages[i].len) == -1) {
+        perror("write");
+        exit(1);
+      }
+    }
+    for (j = 0; j < nclients; ++j) {
+      if (clients[j]->ready && !clients[j]->dead &&
+          clients[j] != messages[i].from) {
+        enqueue_message(clients[j], messages + i);
+      }
+    }
+  }
+  nmessages = 0;
+  for (j = 0; j < nclients; ++j)
+    flush_client(clients[j]);
+}
+
 int main(int argc, char* argv[]) {
 
   // get args
@@ -81,8 +333,9 @@ int main(int argc, char* argv[]) {
     fprintf(stderr, "usage: %s HOST PORT\n", argv[0]);
     exit(1);
   }
-  const char* host = argv[1];
-  const char* port = argv[2];
+  host = argv[1];
+  port = argv[2];
+  signal(SIGPIPE, SIG_IGN);
 
   // perform dns lookup
   int err;
@@ -97,7 +350,7 @@ int main(int argc, char* argv[]) {
     exit(1);
   }
 
-  // listen for client
+  // listen for clients
   int sockfd;
   if ((sockfd = Socket(addr->ai_family, addr->ai_socktype,
                        addr->ai_protocol)) == -1) {
@@ -113,50 +366,33 @@ int main(int argc, char* argv[]) {
     perror("listen");
     exit(1);
   }
-
-  // wait for client
-  int clientfd;
-  if ((clientfd = accept(sockfd, 0, 0)) == -1) {
-    perror("listen");
-    exit(1);
-  }
-
-  // Perform HPKE handshake - receive client's ephemeral public key
-  uint8_t client_ephemeral_pubkey[32];
-  ssize_t got = read(clientfd, client_ephemeral_pubkey, 32);
-  if (got != 32) {
-    fprintf(stderr, "Failed to receive client ephemeral public key\n");
-    exit(1);
-  }
-
-  // Setup HPKE receiver context
-  const uint8_t info[] = "chat-server-v1";
-  if (Hacl_HPKE_Curve25519_CP128_SHA256_setupBaseR(
-          &hpke_ctx, client_ephemeral_pubkey, server_private_key,
-          sizeof(info) - 1, info) == -1) {
-    fprintf(stderr, "HPKE setup failed\n");
+  if (fcntl(sockfd, F_SETFL, fcntl(sockfd, F_GETFL) | O_NONBLOCK) == -1) {
+    perror("fcntl");
     exit(1);
   }
+  fds = xrealloc(fds, 2 * sizeof(*fds));
 
-  // Print HPKE context
-  printf("HPKE ctx_key: %s\n", EncodeBase64(hpke_ctx.ctx_key, 32, 0));
-  printf("HPKE ctx_nonce: %s\n", EncodeBase64(hpke_ctx.ctx_nonce, 12, 0));
-  printf("HPKE ctx_exporter: %s\n", EncodeBase64(hpke_ctx.ctx_exporter, 32, 0));
-
-  // chat loop
+  // event loop
   for (;;) {
-    struct pollfd fds[2] = {
-        {0, POLLIN},
-        {clientfd, POLLIN},
-    };
-    if (poll(fds, 2, -1) == -1) {
+    size_t i;
+    fds[0] = (struct pollfd){0, POLLIN};
+    fds[1] = (struct pollfd){sockfd, POLLIN};
+    for (i = 0; i < nclients; ++i) {
+      fds[2 + i].fd = clients[i]->fd;
+      fds[2 + i].events = POLLIN | (clients[i]->head ? POLLOUT : 0);
+      fds[2 + i].revents = 0;
+    }
+    size_t nfds = 2 + nclients;
+    if (poll(fds, nfds, -1) == -1) {
+      if (errno == EINTR)
+        continue;
       perror("poll");
       exit(1);
     }
 
     // handle activity in terminal
     if (fds[0].revents) {
-      char buf[512];
+      char buf[MAX_MESSAGE];
       ssize_t got = read(0, buf, sizeof(buf));
       if (got == -1) {
         perror("read");
@@ -164,57 +400,40 @@ int main(int argc, char* argv[]) {
       }
       if (!got)
         break;
+      post_message(0, buf, got);
+    }
 
-      // Encrypt message before sending
-      uint8_t encrypted[512 + 16];  // plaintext + tag
-      ssize_t encrypted_len = encrypt_message((uint8_t*)buf, got, encrypted);
-      if (encrypted_len == -1) {
-        fprintf(stderr, "Encryption failed\n");
-        exit(1);
-      }
-
-      ssize_t wrote = write(clientfd, encrypted, encrypted_len);
-      if (wrote == -1) {
-        fprintf(stderr, "%s:%s: send failed: %s\n", host, port,
-                strerror(errno));
-        exit(1);
-      }
+    // handle activity on connected sockets
+    for (i = 2; i < nfds; ++i) {
+      struct client* c = clients[i - 2];
+      if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+        read_client(c);
+      if (fds[i].revents & POLLOUT)
+        flush_client(c);
     }
 
-    // handle activity on socket
+    // accept new clients
     if (fds[1].revents) {
-      uint8_t encrypted_buf[512 + 16];
-      ssize_t got = read(clientfd, encrypted_buf, sizeof(encrypted_buf));
-      if (got == -1) {
-        fprintf(stderr, "%s:%s: recv failed: %s\n", host, port,
-                strerror(errno));
-        exit(1);
-      }
-      if (!got)
-        break;
-
-      // Decrypt message before displaying
-      char plaintext[512];
-      ssize_t plaintext_len =
-          decrypt_message(encrypted_buf, got, (uint8_t*)plaintext);
-      if (plaintext_len == -1) {
-        fprintf(stderr, "Decryption failed\n");
-        exit(1);
-      }
-
-      ssize_t wrote = write(1, plaintext, plaintext_len);
-      if (wrote == -1) {
-        perror("write");
+      int clientfd;
+      while ((clientfd = accept(sockfd, 0, 0)) != -1)
+        add_client(clientfd);
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR &&
+          errno != ECONNABORTED) {
+        perror("accept");
         exit(1);
       }
     }
+
+    broadcast();
+    sweep_clients();
   }
 
   // cleanup
-  if (close(clientfd)) {
-    fprintf(stderr, "%s:%s: close failed: %s\n", host, port, strerror(errno));
-    exit(1);
-  }
+  for (size_t i = 0; i < nclients; ++i)
+    free_client(clients[i]);
+  free(messages);
+  free(clients);
+  free(fds);
   if (close(sockfd)) {
     fprintf(stderr, "%s:%s: close failed: %s\n", host, port, strerror(errno));
     exit(1);
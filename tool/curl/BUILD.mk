@@ -24,6 +24,7 @@ TOOL_CURL_DIRECTDEPS =				\
 	LIBC_STDIO				\
 	LIBC_STR				\
 	LIBC_SYSV				\
+	LIBC_THREAD				\
 	NET_HTTP				\
 	NET_HTTPS				\
 	THIRD_PARTY_GETOPT			\
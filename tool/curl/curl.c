@@ -10,10 +10,13 @@
 #include "libc/assert.h"
 #include "libc/calls/calls.h"
 #include "libc/calls/struct/iovec.h"
+#include "libc/calls/struct/sigaction.h"
 #include "libc/calls/struct/timeval.h"
 #include "libc/errno.h"
+#include "libc/fmt/conv.h"
 #include "libc/fmt/itoa.h"
 #include "libc/fmt/magnumstrs.internal.h"
+#include "libc/limits.h"
 #include "libc/macros.h"
 #include "libc/mem/gc.h"
 #include "libc/mem/mem.h"
@@ -29,6 +32,7 @@
 #include "libc/sysv/consts/ipproto.h"
 #include "libc/sysv/consts/sig.h"
 #include "libc/sysv/consts/sock.h"
+#include "libc/thread/thread.h"
 #include "net/http/http.h"
 #include "net/http/url.h"
 #include "net/https/https.h"
@@ -43,22 +47,87 @@
 #include "third_party/musl/netdb.h"
 
 /**
- * @fileoverview Downloads HTTP URL to stdout.
+ * @fileoverview Downloads HTTP URLs to stdout or files.
+ *
+ * Several URLs may be passed, in which case each `-o` flag names the
+ * output for the URL in the same position. Requests to the same host
+ * reuse the connection. Passing `-P N` with `-o` splits each download
+ * into up to N `Range:` requests over parallel connections, which are
+ * written into place with pwrite().
  */
 
+#define kProbeSize   (1024 * 1024)
+#define kMaxParallel 64
+
 #define HasHeader(H)    (!!msg.headers[H].a)
 #define HeaderData(H)   (p + msg.headers[H].a)
 #define HeaderLength(H) (msg.headers[H].b - msg.headers[H].a)
 #define HeaderEqualCase(H, S) \
   SlicesEqualCase(S, strlen(S), HeaderData(H), HeaderLength(H))
 
-static int sock;
-static int outfd;
+struct Target {
+  bool usessl;
+  char *host;
+  char *port;
+  char *path;
+};
+
+struct Output {
+  int fd;
+  bool seekable;
+  int64_t off;
+  const char *path;
+};
+
+struct Conn {
+  int sock;
+  bool open;
+  bool usessl;
+  bool reused;
+  char *host;
+  char *port;
+  unsigned a, b;
+  unsigned char t[4096];
+  mbedtls_ssl_config conf;
+  mbedtls_ssl_context ssl;
+  mbedtls_ctr_drbg_context drbg;
+};
+
+struct Response {
+  int status;
+  bool keepalive;
+  int64_t first;
+  int64_t last;
+  int64_t total;
+};
+
+struct Segment {
+  pthread_t th;
+  bool more;
+  int64_t first;
+  int64_t last;
+  struct Conn *conn;
+  struct Output out;
+  const struct Target *target;
+};
+
 static const char *prog;
-static const char *outpath;
+static uint64_t method;
+static int parallel = 1;
+static bool includeheaders;
+static const char *postdata;
+static int authmode = MBEDTLS_SSL_VERIFY_REQUIRED;
+static int ciphersuite = MBEDTLS_SSL_PRESET_SUITEC;
+static const char *agent = "hurl/1.o (https://github.com/jart/cosmopolitan)";
+
+static struct Headers {
+  size_t n;
+  char **p;
+} headers;
 
 [[noreturn]] static void PrintUsage(int fd, int rc) {
-  tinyprint(fd, "usage: ", prog, " [-iksvV] URL\n", NULL);
+  tinyprint(fd, "usage: ", prog, " [-iksvV] [-P N] [-o PATH]... URL...\n",
+            NULL);
   exit(rc);
 }
 
@@ -86,173 +155,131 @@ static void OnSslDebug(void *ctx, int level, const char *file, int line,
   tinyprint(2, file, ":", sline, ": (", slevel, ") ", message, "\n", NULL);
 }
 
-static void WriteOutput(const void *p, size_t n) {
-  if (!outfd) {
-    if (outpath) {
-      if ((outfd = creat(outpath, 0644)) <= 0) {
-        perror(outpath);
-        exit(1);
-      }
-    } else {
-      outfd = 1;
-      outpath = "<stdout>";
+static void OpenOutput(struct Output *o) {
+  if (o->fd != -1)
+    return;
+  if (o->path) {
+    if ((o->fd = creat(o->path, 0644)) == -1) {
+      perror(o->path);
+      exit(1);
     }
+    o->seekable = true;
+  } else {
+    o->fd = 1;
+    o->path = "<stdout>";
   }
+}
+
+static void WriteOutput(struct Output *o, const void *p, size_t n) {
   ssize_t rc;
+  OpenOutput(o);
   for (size_t i = 0; i < n; i += rc) {
-    rc = write(outfd, p, n);
+    if (o->seekable) {
+      rc = pwrite(o->fd, (const char *)p + i, n - i, o->off);
+    } else {
+      rc = write(o->fd, (const char *)p + i, n - i);
+    }
     if (rc <= 0) {
-      perror(outpath);
+      perror(o->path);
       exit(1);
     }
+    o->off += rc;
   }
 }
 
 static int TlsSend(void *c, const unsigned char *p, size_t n) {
   int rc;
-  if ((rc = write(*(int *)c, p, n)) == -1) {
-    perror("TlsSend");
-    exit(1);
-  }
+  if ((rc = write(((struct Conn *)c)->sock, p, n)) == -1)
+    return MBEDTLS_ERR_NET_SEND_FAILED;
   return rc;
 }
 
 static int TlsRecv(void *c, unsigned char *p, size_t n, uint32_t o) {
   int r;
+  struct Conn *k = c;
   struct iovec v[2];
-  static unsigned a, b;
-  static unsigned char t[4096];
-  if (a < b) {
-    r = MIN(n, b - a);
-    memcpy(p, t + a, r);
-    if ((a += r) == b) {
-      a = b = 0;
+  if (k->a < k->b) {
+    r = MIN(n, k->b - k->a);
+    memcpy(p, k->t + k->a, r);
+    if ((k->a += r) == k->b) {
+      k->a = k->b = 0;
     }
     return r;
   }
   v[0].iov_base = p;
   v[0].iov_len = n;
-  v[1].iov_base = t;
-  v[1].iov_len = sizeof(t);
-  if ((r = readv(*(int *)c, v, 2)) == -1) {
-    perror("TlsRecv");
-    exit(1);
-  }
+  v[1].iov_base = k->t;
+  v[1].iov_len = sizeof(k->t);
+  if ((r = readv(k->sock, v, 2)) == -1)
+    return MBEDTLS_ERR_NET_RECV_FAILED;
   if (r > n) {
-    b = r - n;
+    k->b = r - n;
   }
   return MIN(n, r);
 }
 
-int _curl(int argc, char *argv[]) {
-
-  if (!NoDebug()) {
-    ShowCrashReports();
-  }
-
-  prog = argv[0];
-  if (!prog) {
-    prog = "curl";
+static const char *ParseDigits(const char *p, const char *e, int64_t *x) {
+  int64_t v;
+  const char *s;
+  for (v = 0, s = p; p < e && '0' <= *p && *p <= '9'; ++p) {
+    if (v > (INT64_MAX - 9) / 10)
+      return 0;
+    v = v * 10 + (*p - '0');
   }
+  if (p == s)
+    return 0;
+  *x = v;
+  return p;
+}
 
-  /*
-   * Read flags.
-   */
-  int opt;
-  struct Headers {
-    size_t n;
-    char **p;
-  } headers = {0};
-  uint64_t method = 0;
-  int authmode = MBEDTLS_SSL_VERIFY_REQUIRED;
-  int ciphersuite = MBEDTLS_SSL_PRESET_SUITEC;
-  bool includeheaders = false;
-  const char *postdata = NULL;
-  const char *agent = "hurl/1.o (https://github.com/jart/cosmopolitan)";
-  while ((opt = getopt(argc, argv, "qiksvBVIX:H:A:d:o:")) != -1) {
-    switch (opt) {
-      case 's':
-      case 'q':
-        break;
-      case 'o':
-        outpath = optarg;
-        break;
-      case 'i':
-        includeheaders = true;
-        break;
-      case 'I':
-        method = kHttpHead;
-        break;
-      case 'A':
-        agent = optarg;
-        break;
-      case 'H':
-        headers.p = realloc(headers.p, ++headers.n * sizeof(*headers.p));
-        headers.p[headers.n - 1] = optarg;
-        break;
-      case 'd':
-        postdata = optarg;
-        break;
-      case 'X':
-        if (!(method = ParseHttpMethod(optarg, -1))) {
-          tinyprint(2, prog, ": bad http method: ", optarg, "\n", NULL);
-          exit(1);
-        }
-        break;
-      case 'V':
-        ++mbedtls_debug_threshold;
-        break;
-      case 'k':
-        authmode = MBEDTLS_SSL_VERIFY_NONE;
-        break;
-      case 'B':
-        ciphersuite = MBEDTLS_SSL_PRESET_SUITEB;
-        break;
-      case 'h':
-        PrintUsage(1, 0);
-      default:
-        PrintUsage(2, 1);
-    }
-  }
+// parses "bytes FIRST-LAST/TOTAL" in a 206 response
+static bool ParseContentRange(const char *p, size_t n, struct Response *r) {
+  const char *e = p + n;
+  if (n < 6 || memcasecmp(p, "bytes ", 6))
+    return false;
+  if (!(p = ParseDigits(p + 6, e, &r->first)) || p == e || *p++ != '-')
+    return false;
+  if (!(p = ParseDigits(p, e, &r->last)) || p == e || *p++ != '/')
+    return false;
+  if (!(p = ParseDigits(p, e, &r->total)) || p != e)
+    return false;
+  return r->first <= r->last && r->last < r->total;
+}
 
-  /*
-   * Get argument.
-   */
-  const char *urlarg;
-  if (optind == argc) {
-    tinyprint(2, prog, ": missing url\n", NULL);
-    PrintUsage(2, 1);
-  }
-  urlarg = argv[optind];
+static char *FormatRange(char buf[48], int64_t first, int64_t last) {
+  char *p;
+  p = stpcpy(buf, "bytes=");
+  p = FormatInt64(p, first);
+  *p++ = '-';
+  FormatInt64(p, last);
+  return buf;
+}
 
-  /*
-   * Parse URL.
-   */
+static void ParseTarget(const char *urlarg, struct Target *t) {
   struct Url url;
-  char *host, *port;
-  bool usessl = false;
   gc(ParseUrl(urlarg, -1, &url, kUrlPlus));
   gc(url.params.p);
+  t->usessl = false;
   if (url.scheme.n) {
     if (url.scheme.n == 5 && !memcasecmp(url.scheme.p, "https", 5)) {
-      usessl = true;
+      t->usessl = true;
     } else if (!(url.scheme.n == 4 && !memcasecmp(url.scheme.p, "http", 4))) {
       tinyprint(2, prog, ": not an http/https url: ", urlarg, "\n", NULL);
       exit(1);
     }
   }
   if (url.host.n) {
-    host = gc(strndup(url.host.p, url.host.n));
+    t->host = strndup(url.host.p, url.host.n);
     if (url.port.n) {
-      port = gc(strndup(url.port.p, url.port.n));
+      t->port = strndup(url.port.p, url.port.n);
     } else {
-      port = usessl ? "443" : "80";
+      t->port = strdup(t->usessl ? "443" : "80");
     }
   } else {
-    host = "127.0.0.1";
-    port = usessl ? "443" : "80";
+    t->host = strdup("127.0.0.1");
+    t->port = strdup(t->usessl ? "443" : "80");
   }
-  if (!IsAcceptableHost(host, -1)) {
+  if (!IsAcceptableHost(t->host, -1)) {
     tinyprint(2, prog, ": invalid host: ", urlarg, "\n", NULL);
     exit(1);
   }
@@ -268,26 +295,30 @@ int _curl(int argc, char *argv[]) {
     url.path.p = p;
     ++url.path.n;
   }
+  t->path = EncodeUrl(&url, 0);
+}
 
-  /*
-   * Create HTTP message.
-   */
-  if (!method) {
-    if (postdata) {
-      method = kHttpPost;
-    } else {
-      method = kHttpGet;
-    }
-  }
+static void FreeTarget(struct Target *t) {
+  free(t->path);
+  free(t->port);
+  free(t->host);
+}
 
+static char *BuildRequest(const struct Target *t, const char *range,
+                          bool keepalive) {
   char *request = 0;
   char methodstr[9] = {0};
   WRITE64LE(methodstr, method);
   appendf(&request,
           "%s %s HTTP/1.1\r\n"
-          "Connection: close\r\n"
+          "Connection: %s\r\n"
           "User-Agent: %s\r\n",
-          methodstr, gc(EncodeUrl(&url, 0)), agent);
+          methodstr, t->path, keepalive ? "keep-alive" : "close", agent);
+  if (range) {
+    appends(&request, "Range: ");
+    appends(&request, range);
+    appends(&request, "\r\n");
+  }
 
   bool senthost = false;
   bool sentcontenttype = false;
@@ -305,9 +336,9 @@ int _curl(int argc, char *argv[]) {
   }
   if (!senthost) {
     appends(&request, "Host: ");
-    appends(&request, host);
+    appends(&request, t->host);
     appendw(&request, ':');
-    appends(&request, port);
+    appends(&request, t->port);
     appends(&request, "\r\n");
   }
   if (postdata) {
@@ -326,6 +357,10 @@ int _curl(int argc, char *argv[]) {
   if (postdata) {
     appends(&request, postdata);
   }
+  return request;
+}
+
+static void Connect(struct Conn *c, const struct Target *t) {
 
   /*
    * Perform DNS lookup.
@@ -335,8 +370,8 @@ int _curl(int argc, char *argv[]) {
                            .ai_socktype = SOCK_STREAM,
                            .ai_protocol = IPPROTO_TCP,
                            .ai_flags = AI_NUMERICSERV};
-  if (getaddrinfo(host, port, &hints, &addr) != 0) {
-    tinyprint(2, prog, ": could not resolve host: ", host, "\n", NULL);
+  if (getaddrinfo(t->host, t->port, &hints, &addr) != 0) {
+    tinyprint(2, prog, ": could not resolve host: ", t->host, "\n", NULL);
     exit(1);
   }
 
@@ -344,91 +379,128 @@ int _curl(int argc, char *argv[]) {
    * Connect to server.
    */
   int ret;
-  if ((sock = GoodSocket(addr->ai_family, addr->ai_socktype, addr->ai_protocol,
-                         false, &(struct timeval){-60})) == -1) {
+  if ((c->sock = GoodSocket(addr->ai_family, addr->ai_socktype,
+                            addr->ai_protocol, false,
+                            &(struct timeval){-60})) == -1) {
     perror("socket");
     exit(1);
   }
-  if (connect(sock, addr->ai_addr, addr->ai_addrlen)) {
-    tinyprint(2, prog, ": failed to connect to ", host, " port ", port, ": ",
-              DescribeErrno(), "\n", NULL);
+  if (connect(c->sock, addr->ai_addr, addr->ai_addrlen)) {
+    tinyprint(2, prog, ": failed to connect to ", t->host, " port ", t->port,
+              ": ", DescribeErrno(), "\n", NULL);
     exit(1);
   }
   freeaddrinfo(addr);
+  c->open = true;
+  c->reused = false;
+  c->usessl = t->usessl;
+  c->host = strdup(t->host);
+  c->port = strdup(t->port);
+  c->a = c->b = 0;
 
   /*
    * Setup crypto.
    */
-  mbedtls_ssl_config conf;
-  mbedtls_ssl_context ssl;
-  mbedtls_ctr_drbg_context drbg;
-  if (usessl) {
-    mbedtls_ssl_init(&ssl);
-    mbedtls_ctr_drbg_init(&drbg);
-    mbedtls_ssl_config_init(&conf);
-    unassert(!mbedtls_ctr_drbg_seed(&drbg, GetSslEntropy, 0, "justine", 7));
-    unassert(!mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT,
+  if (c->usessl) {
+    mbedtls_ssl_init(&c->ssl);
+    mbedtls_ctr_drbg_init(&c->drbg);
+    mbedtls_ssl_config_init(&c->conf);
+    unassert(!mbedtls_ctr_drbg_seed(&c->drbg, GetSslEntropy, 0, "justine", 7));
+    unassert(!mbedtls_ssl_config_defaults(&c->conf, MBEDTLS_SSL_IS_CLIENT,
                                           MBEDTLS_SSL_TRANSPORT_STREAM,
                                           ciphersuite));
-    mbedtls_ssl_conf_authmode(&conf, authmode);
-    mbedtls_ssl_conf_ca_chain(&conf, GetSslRoots(), 0);
-    mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &drbg);
+    mbedtls_ssl_conf_authmode(&c->conf, authmode);
+    mbedtls_ssl_conf_ca_chain(&c->conf, GetSslRoots(), 0);
+    mbedtls_ssl_conf_verify_cache(&c->conf, VerifyCache, 0);
+    mbedtls_ssl_conf_rng(&c->conf, mbedtls_ctr_drbg_random, &c->drbg);
 #ifndef NDEBUG
-    mbedtls_ssl_conf_dbg(&conf, OnSslDebug, 0);
+    mbedtls_ssl_conf_dbg(&c->conf, OnSslDebug, 0);
 #endif
-    unassert(!mbedtls_ssl_setup(&ssl, &conf));
-    unassert(!mbedtls_ssl_set_hostname(&ssl, host));
-    mbedtls_ssl_set_bio(&ssl, &sock, TlsSend, 0, TlsRecv);
-    if ((ret = mbedtls_ssl_handshake(&ssl))) {
-      tinyprint(2, prog, ": ssl negotiation with ", host,
-                " failed: ", DescribeSslClientHandshakeError(&ssl, ret), "\n",
-                NULL);
+    unassert(!mbedtls_ssl_setup(&c->ssl, &c->conf));
+    unassert(!mbedtls_ssl_set_hostname(&c->ssl, t->host));
+    mbedtls_ssl_set_bio(&c->ssl, c, TlsSend, 0, TlsRecv);
+    if ((ret = mbedtls_ssl_handshake(&c->ssl))) {
+      tinyprint(2, prog, ": ssl negotiation with ", t->host,
+                " failed: ", DescribeSslClientHandshakeError(&c->ssl, ret),
+                "\n", NULL);
       exit(1);
     }
   }
+}
 
-  /*
-   * Send HTTP Message.
-   */
+static void Disconnect(struct Conn *c) {
+  if (!c->open)
+    return;
+  c->open = false;
+  free(c->port);
+  free(c->host);
+  if (close(c->sock)) {
+    tinyprint(2, prog, ": close failed: ", DescribeErrno(), "\n", NULL);
+    exit(1);
+  }
+  if (c->usessl) {
+    mbedtls_ssl_free(&c->ssl);
+    mbedtls_ssl_config_free(&c->conf);
+    mbedtls_ctr_drbg_free(&c->drbg);
+  }
+}
+
+static bool IsConnectedTo(const struct Conn *c, const struct Target *t) {
+  return c->open && c->usessl == t->usessl && !strcasecmp(c->host, t->host) &&
+         !strcmp(c->port, t->port);
+}
+
+// returns false if a reused connection turned out to be closed
+static bool Send(struct Conn *c, const char *request, size_t n) {
   ssize_t rc;
-  size_t i, n;
-  n = appendz(request).i;
-  for (i = 0; i < n; i += rc) {
-    if (usessl) {
-      rc = mbedtls_ssl_write(&ssl, request + i, n - i);
+  for (size_t i = 0; i < n; i += rc) {
+    if (c->usessl) {
+      rc = mbedtls_ssl_write(&c->ssl, request + i, n - i);
       if (rc <= 0) {
+        if (c->reused && !i)
+          return false;
         tinyprint(2, prog, ": ssl send failed: ", DescribeMbedtlsErrorCode(rc),
                   "\n", NULL);
         exit(1);
       }
     } else {
-      rc = write(sock, request + i, n - i);
+      rc = write(c->sock, request + i, n - i);
       if (rc <= 0) {
+        if (c->reused && !i)
+          return false;
         tinyprint(2, prog, ": send failed: ", DescribeErrno(), "\n", NULL);
         exit(1);
       }
     }
   }
+  return true;
+}
 
-  /*
-   * Handle response.
-   */
+// returns false if a reused connection turned out to be closed
+static bool Receive(struct Conn *c, struct Output *out, struct Response *res) {
   int t;
   char *p;
+  ssize_t rc;
+  bool excess;
   struct HttpMessage msg;
   struct HttpUnchunker u;
-  size_t g, hdrlen, paylen;
+  size_t g, i, n, hdrlen, paylen;
+  res->status = 0;
+  res->keepalive = false;
+  res->first = res->last = res->total = -1;
   InitHttpMessage(&msg, kHttpResponse);
-  for (p = 0, hdrlen = paylen = t = i = n = 0;;) {
+  for (excess = false, p = 0, hdrlen = paylen = t = i = n = 0;;) {
     if (i == n) {
       n += 1000;
       n += n >> 1;
       p = realloc(p, n);
     }
-    if (usessl) {
-      if ((rc = mbedtls_ssl_read(&ssl, p + i, n - i)) < 0) {
+    if (c->usessl) {
+      if ((rc = mbedtls_ssl_read(&c->ssl, p + i, n - i)) < 0) {
         if (rc == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
           rc = 0;
+        } else if (c->reused && !i && t == kHttpClientStateHeaders) {
+          goto Stale;
         } else {
           tinyprint(2, prog,
                     ": ssl recv failed: ", DescribeMbedtlsErrorCode(rc), "\n",
@@ -437,7 +509,9 @@ int _curl(int argc, char *argv[]) {
         }
       }
     } else {
-      if ((rc = read(sock, p + i, n - i)) == -1) {
+      if ((rc = read(c->sock, p + i, n - i)) == -1) {
+        if (c->reused && !i && t == kHttpClientStateHeaders)
+          goto Stale;
         tinyprint(2, prog, ": recv failed: ", DescribeErrno(), "\n", NULL);
         exit(1);
       }
@@ -446,9 +520,14 @@ int _curl(int argc, char *argv[]) {
     i += g;
     switch (t) {
       case kHttpClientStateHeaders:
-        unassert(g);
+        if (!g) {
+          if (c->reused && !i)
+            goto Stale;
+          tinyprint(2, prog, ": ", c->host, " closed connection early\n", NULL);
+          exit(1);
+        }
         if ((rc = ParseHttpMessage(&msg, p, i, n)) == -1) {
-          tinyprint(2, prog, ": ", host, " sent bad http message\n", NULL);
+          tinyprint(2, prog, ": ", c->host, " sent bad http message\n", NULL);
           exit(1);
         }
         if (rc) {
@@ -460,16 +539,26 @@ int _curl(int argc, char *argv[]) {
             i -= hdrlen;
             break;
           }
+          res->status = msg.status;
+          res->keepalive =
+              msg.version >= 11 && !(HasHeader(kHttpConnection) &&
+                                     HeaderEqualCase(kHttpConnection, "close"));
+          if (msg.status == 206 && HasHeader(kHttpContentRange) &&
+              !ParseContentRange(HeaderData(kHttpContentRange),
+                                 HeaderLength(kHttpContentRange), res)) {
+            res->first = res->last = res->total = -1;
+          }
           if (method == kHttpHead || includeheaders) {
-            WriteOutput(p, hdrlen);
+            WriteOutput(out, p, hdrlen);
           }
           if (method == kHttpHead || msg.status == 204 || msg.status == 304) {
+            excess = i > hdrlen;
             goto Finished;
           }
           if (HasHeader(kHttpTransferEncoding) &&
               !HeaderEqualCase(kHttpTransferEncoding, "identity")) {
             if (!HeaderEqualCase(kHttpTransferEncoding, "chunked")) {
-              tinyprint(2, prog, ": ", host,
+              tinyprint(2, prog, ": ", c->host,
                         " sent unsupported transfer encoding\n", NULL);
               exit(1);
             }
@@ -480,35 +569,41 @@ int _curl(int argc, char *argv[]) {
             if ((rc = ParseContentLength(HeaderData(kHttpContentLength),
                                          HeaderLength(kHttpContentLength))) ==
                 -1) {
-              tinyprint(2, prog, ": ", host, " sent bad content length\n",
+              tinyprint(2, prog, ": ", c->host, " sent bad content length\n",
                         NULL);
               exit(1);
             }
             t = kHttpClientStateBodyLengthed;
             paylen = rc;
             if (paylen > i - hdrlen) {
-              WriteOutput(p + hdrlen, i - hdrlen);
+              WriteOutput(out, p + hdrlen, i - hdrlen);
             } else {
-              WriteOutput(p + hdrlen, paylen);
+              WriteOutput(out, p + hdrlen, paylen);
+              excess = i - hdrlen > paylen;
               goto Finished;
             }
           } else {
             t = kHttpClientStateBody;
-            WriteOutput(p + hdrlen, i - hdrlen);
+            res->keepalive = false;
+            WriteOutput(out, p + hdrlen, i - hdrlen);
           }
         }
         break;
       case kHttpClientStateBody:
-        WriteOutput(p + i - g, g);
+        WriteOutput(out, p + i - g, g);
         if (!g)
           goto Finished;
         break;
       case kHttpClientStateBodyLengthed:
-        unassert(g);
+        if (!g) {
+          tinyprint(2, prog, ": ", c->host, " sent truncated message\n", NULL);
+          exit(1);
+        }
         if (i - hdrlen > paylen) {
           g = hdrlen + paylen - (i - g);
+          excess = true;
         }
-        WriteOutput(p + i - g, g);
+        WriteOutput(out, p + i - g, g);
         if (i - hdrlen >= paylen) {
           goto Finished;
         }
@@ -516,39 +611,232 @@ int _curl(int argc, char *argv[]) {
       case kHttpClientStateBodyChunked:
       Chunked:
         if ((rc = Unchunk(&u, p + hdrlen, i - hdrlen, &paylen)) == -1) {
-          tinyprint(2, prog, ": ", host, " sent bad chunk coding\n", NULL);
+          tinyprint(2, prog, ": ", c->host, " sent bad chunk coding\n", NULL);
           exit(1);
         }
         if (rc) {
-          WriteOutput(p + hdrlen, paylen);
+          WriteOutput(out, p + hdrlen, paylen);
+          excess = rc < i - hdrlen;
           goto Finished;
         }
+        if (!g) {
+          tinyprint(2, prog, ": ", c->host, " sent truncated message\n", NULL);
+          exit(1);
+        }
         break;
       default:
         abort();
     }
   }
-
-/*
- * Close connection.
- */
 Finished:
-  if (close(sock)) {
-    tinyprint(2, prog, ": close failed: ", DescribeErrno(), "\n", NULL);
+  if (excess)
+    res->keepalive = false;
+  DestroyHttpMessage(&msg);
+  free(p);
+  return true;
+Stale:
+  DestroyHttpMessage(&msg);
+  free(p);
+  return false;
+}
+
+static void Exchange(struct Conn *c, const struct Target *t, const char *range,
+                     bool keepalive, struct Output *out, struct Response *res) {
+  char *request;
+  request = BuildRequest(t, range, keepalive);
+  for (;;) {
+    if (!IsConnectedTo(c, t)) {
+      Disconnect(c);
+      Connect(c, t);
+    }
+    if (Send(c, request, appendz(request).i) && Receive(c, out, res))
+      break;
+    // server closed idle keep-alive connection, so try a fresh one
+    Disconnect(c);
+  }
+  free(request);
+  if (keepalive && res->keepalive) {
+    c->reused = true;
+  } else {
+    Disconnect(c);
+  }
+}
+
+static void *FetchSegment(void *arg) {
+  char range[48];
+  struct Response res;
+  struct Segment *s = arg;
+  Exchange(s->conn, s->target, FormatRange(range, s->first, s->last), s->more,
+           &s->out, &res);
+  if (res.status != 206 || res.first != s->first || res.last != s->last ||
+      s->out.off != s->last + 1) {
+    tinyprint(2, prog, ": ", s->target->host,
+              " sent wrong part for range request\n", NULL);
     exit(1);
   }
+  return 0;
+}
+
+static void SplitDownload(struct Conn *c, const struct Target *t,
+                          struct Output *out, int64_t total, bool more) {
+  int i, n;
+  struct Segment *s;
+  int64_t off, len, seg;
+  off = out->off;
+  len = total - off;
+  n = MIN(parallel, (len + kProbeSize - 1) / kProbeSize);
+  seg = (len + n - 1) / n;
+  s = calloc(n, sizeof(*s));
+  for (i = 0; i < n; ++i) {
+    s[i].target = t;
+    s[i].more = i ? false : more;
+    s[i].conn = i ? calloc(1, sizeof(struct Conn)) : c;
+    s[i].out = *out;
+    s[i].out.off = s[i].first = off + i * seg;
+    s[i].last = MIN(total, s[i].first + seg) - 1;
+    if (i && (errno = pthread_create(&s[i].th, 0, FetchSegment, s + i))) {
+      perror("pthread_create");
+      exit(1);
+    }
+  }
+  FetchSegment(s);
+  for (i = 1; i < n; ++i) {
+    unassert(!pthread_join(s[i].th, 0));
+    free(s[i].conn);
+  }
+  out->off = total;
+  free(s);
+}
+
+static void Fetch(struct Conn *c, const struct Target *t, struct Output *out,
+                  bool more) {
+  char range[48];
+  struct Response res;
+  if (parallel > 1 && out->path && method == kHttpGet && !postdata &&
+      !includeheaders) {
+    // the first megabyte tells us the size and whether ranges work
+    OpenOutput(out);
+    Exchange(c, t, FormatRange(range, 0, kProbeSize - 1), true, out, &res);
+    if (res.status == 206) {
+      if (res.first == 0 && res.last + 1 == out->off) {
+        if (res.total > out->off)
+          SplitDownload(c, t, out, res.total, more);
+        return;
+      }
+    } else if (res.status != 416) {
+      return;
+    }
+    out->off = 0;
+  }
+  Exchange(c, t, 0, more, out, &res);
+}
+
+int _curl(int argc, char *argv[]) {
+
+  if (!NoDebug()) {
+    ShowCrashReports();
+  }
+
+  prog = argv[0];
+  if (!prog) {
+    prog = "curl";
+  }
 
   /*
-   * Free memory.
+   * Read flags.
    */
-  free(p);
-  free(headers.p);
-  if (usessl) {
-    mbedtls_ssl_free(&ssl);
-    mbedtls_ctr_drbg_free(&drbg);
-    mbedtls_ssl_config_free(&conf);
-    mbedtls_ctr_drbg_free(&drbg);
+  int opt;
+  struct Headers outpaths = {0};
+  while ((opt = getopt(argc, argv, "qiksvBVIX:H:A:d:o:P:")) != -1) {
+    switch (opt) {
+      case 's':
+      case 'q':
+        break;
+      case 'o':
+        outpaths.p = realloc(outpaths.p, ++outpaths.n * sizeof(*outpaths.p));
+        outpaths.p[outpaths.n - 1] = optarg;
+        break;
+      case 'i':
+        includeheaders = true;
+        break;
+      case 'I':
+        method = kHttpHead;
+        break;
+      case 'A':
+        agent = optarg;
+        break;
+      case 'H':
+        headers.p = realloc(headers.p, ++headers.n * sizeof(*headers.p));
+        headers.p[headers.n - 1] = optarg;
+        break;
+      case 'd':
+        postdata = optarg;
+        break;
+      case 'X':
+        if (!(method = ParseHttpMethod(optarg, -1))) {
+          tinyprint(2, prog, ": bad http method: ", optarg, "\n", NULL);
+          exit(1);
+        }
+        break;
+      case 'P':
+        parallel = atoi(optarg);
+        if (!(1 <= parallel && parallel <= kMaxParallel)) {
+          tinyprint(2, prog, ": parallelism must be 1 to 64\n", NULL);
+          exit(1);
+        }
+        break;
+      case 'V':
+        ++mbedtls_debug_threshold;
+        break;
+      case 'k':
+        authmode = MBEDTLS_SSL_VERIFY_NONE;
+        break;
+      case 'B':
+        ciphersuite = MBEDTLS_SSL_PRESET_SUITEB;
+        break;
+      case 'h':
+        PrintUsage(1, 0);
+      default:
+        PrintUsage(2, 1);
+    }
+  }
+  if (optind == argc) {
+    tinyprint(2, prog, ": missing url\n", NULL);
+    PrintUsage(2, 1);
+  }
+  if (!method) {
+    if (postdata) {
+      method = kHttpPost;
+    } else {
+      method = kHttpGet;
+    }
   }
 
+  /*
+   * Fetch each URL, reusing the connection where we can.
+   */
+  struct Conn conn = {0};
+  signal(SIGPIPE, SIG_IGN);
+  for (int i = optind; i < argc; ++i) {
+    struct Target target;
+    struct Output out = {-1};
+    if (i - optind < outpaths.n) {
+      out.path = outpaths.p[i - optind];
+    }
+    ParseTarget(argv[i], &target);
+    Fetch(&conn, &target, &out, i + 1 < argc);
+    if (out.seekable && close(out.fd)) {
+      perror(out.path);
+      exit(1);
+    }
+    FreeTarget(&target);
+  }
+  Disconnect(&conn);
+
+  /*
+   * Free memory.
+   */
+  free(outpaths.p);
+  free(headers.p);
   return 0;
 }
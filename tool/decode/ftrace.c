@@ -0,0 +1,235 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2024 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/calls/struct/stat.h"
+#include "libc/macros.h"
+#include "libc/mem/alg.h"
+#include "libc/mem/mem.h"
+#include "libc/runtime/ftrace.internal.h"
+#include "libc/runtime/runtime.h"
+#include "libc/runtime/symbols.internal.h"
+#include "libc/stdio/stdio.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/map.h"
+#include "libc/sysv/consts/o.h"
+#include "libc/sysv/consts/prot.h"
+#include "third_party/getopt/getopt.internal.h"
+
+/**
+ * @fileoverview binary --ftrace ring buffer decoder
+ *
+ * This program turns the file that's written when a program is run
+ * with `FTRACE_RING=PATH prog --ftrace` into the same text format that
+ * --ftrace would normally print, or into the chrome trace event format
+ * which can be loaded into chrome://tracing or ui.perfetto.dev. Since
+ * only function entry is logged, a call is considered to have returned
+ * once the same thread calls something at the same depth or shallower.
+ *
+ * Times are nanoseconds since the traced process started, using the
+ * same estimate as the timestamps printed by kprintf() `%T`.
+ */
+
+#define MAX_FTRACE_DEPTH 513
+
+#define USAGE \
+  " [-j] RING PROG.dbg\n\
+\n\
+FLAGS\n\
+\n\
+  -h     show help\n\
+  -j     output chrome trace event json\n\
+\n\
+ARGUMENTS\n\
+\n\
+  RING   file created by FTRACE_RING=RING prog --ftrace\n\
+  PROG   elf executable with symbols of traced program\n\
+\n"
+
+struct Call {
+  uint64_t tsc;
+  uint64_t seq;
+  uint32_t addr;
+  uint32_t tid;
+  int depth;
+};
+
+struct Thread {
+  uint32_t tid;
+  int n;
+  int depths[MAX_FTRACE_DEPTH];
+};
+
+static bool json;
+static const char *prog;
+static struct SymbolTable *symtab;
+
+static struct {
+  int n;
+  struct Thread *p;
+} threads;
+
+[[noreturn]] static void PrintUsage(int fd, int rc) {
+  tinyprint(fd, "usage: ", prog, USAGE, NULL);
+  exit(rc);
+}
+
+[[noreturn]] static void Die(const char *path, const char *reason) {
+  tinyprint(2, path, ": ", reason, "\n", NULL);
+  exit(1);
+}
+
+static int CompareCalls(const void *a, const void *b) {
+  const struct Call *x = a;
+  const struct Call *y = b;
+  if (x->tsc != y->tsc)
+    return x->tsc < y->tsc ? -1 : 1;
+  return x->seq < y->seq ? -1 : x->seq > y->seq;
+}
+
+static const char *GetName(int64_t addr_base, uint32_t addr, char buf[20]) {
+  int i;
+  if (symtab && (i = __get_symbol(symtab, addr_base + addr)) != -1)
+    return __get_symbol_name(symtab, i);
+  snprintf(buf, 20, "%#lx", addr_base + addr);
+  return buf;
+}
+
+static struct Thread *GetThread(uint32_t tid) {
+  int i;
+  for (i = 0; i < threads.n; ++i)
+    if (threads.p[i].tid == tid)
+      return threads.p + i;
+  threads.p = realloc(threads.p, ++threads.n * sizeof(*threads.p));
+  if (!threads.p)
+    Die(prog, "out of memory");
+  threads.p[i].tid = tid;
+  threads.p[i].n = 0;
+  return threads.p + i;
+}
+
+static void PrintJsonEvent(bool begin, const char *name, uint32_t tid,
+                           int pid, uint64_t tsc) {
+  static bool once;
+  printf("%s\n{\"ph\":\"%c\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f",
+         once ? "," : "", begin ? 'B' : 'E', pid, tid, tsc / 3000.);
+  if (begin)
+    printf(",\"name\":\"%s\"", name);
+  printf("}");
+  once = true;
+}
+
+// ends calls which returned before thread called something at depth
+static void PopCalls(struct Thread *t, int depth, int pid, uint64_t tsc) {
+  while (t->n && t->depths[t->n - 1] >= depth) {
+    PrintJsonEvent(false, 0, t->tid, pid, tsc);
+    --t->n;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  int fd, opt;
+  size_t i, n, size;
+  struct stat st;
+  struct Call *calls;
+  struct FtraceRing *ring;
+  const char *ringpath, *dbgpath;
+  char buf[20];
+
+  prog = argv[0];
+  if (!prog)
+    prog = "ftrace";
+  while ((opt = getopt(argc, argv, "hj")) != -1) {
+    switch (opt) {
+      case 'j':
+        json = true;
+        break;
+      case 'h':
+        PrintUsage(1, 0);
+      default:
+        PrintUsage(2, 1);
+    }
+  }
+  if (optind + 2 != argc)
+    PrintUsage(2, 1);
+  ringpath = argv[optind + 0];
+  dbgpath = argv[optind + 1];
+  if (!(symtab = OpenSymbolTable(dbgpath)))
+    tinyprint(2, dbgpath, ": couldn't load symbols; printing addresses\n",
+              NULL);
+
+  // map ring buffer file
+  if ((fd = open(ringpath, O_RDONLY)) == -1 || fstat(fd, &st))
+    Die(ringpath, "open failed");
+  if ((size = st.st_size) < sizeof(struct FtraceRing))
+    Die(ringpath, "file too small");
+  if ((ring = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED)
+    Die(ringpath, "mmap failed");
+  close(fd);
+  if (ring->magic != FTRACE_RING_MAGIC)
+    Die(ringpath, "not an ftrace ring buffer");
+  if (ring->abi != FTRACE_RING_ABI)
+    Die(ringpath, "unsupported ftrace ring buffer version");
+  if (!ring->capacity || (ring->capacity & (ring->capacity - 1)) ||
+      ring->capacity > (size - sizeof(struct FtraceRing)) /
+                           sizeof(struct FtraceRecord))
+    Die(ringpath, "ftrace ring buffer corrupted");
+
+  // copy most recent records, in the order calls happened
+  n = MIN(ring->head, ring->capacity);
+  if (!(calls = calloc(n, sizeof(*calls))))
+    Die(prog, "out of memory");
+  for (i = 0; i < n; ++i) {
+    uint64_t seq = ring->head - n + i;
+    struct FtraceRecord *r = ring->records + (seq & (ring->capacity - 1));
+    calls[i].seq = seq;
+    calls[i].tsc = r->tsc_depth >> 16;
+    calls[i].depth = r->tsc_depth & 0xffff;
+    calls[i].addr = r->addr;
+    calls[i].tid = r->tid;
+  }
+  qsort(calls, n, sizeof(*calls), CompareCalls);
+
+  // print calls
+  if (json)
+    printf("{\"traceEvents\":[");
+  for (i = 0; i < n; ++i) {
+    const char *name = GetName(ring->addr_base, calls[i].addr, buf);
+    if (json) {
+      struct Thread *t = GetThread(calls[i].tid);
+      PopCalls(t, calls[i].depth, ring->pid, calls[i].tsc);
+      if (t->n < MAX_FTRACE_DEPTH)
+        t->depths[t->n++] = calls[i].depth;
+      PrintJsonEvent(true, name, calls[i].tid, ring->pid, calls[i].tsc);
+    } else {
+      printf("FUN %7u %'18lu %*s%s\n", calls[i].tid, calls[i].tsc / 3,
+             calls[i].depth * 2, "", name);
+    }
+  }
+  if (json) {
+    for (i = 0; i < threads.n; ++i)
+      PopCalls(threads.p + i, 0, ring->pid, n ? calls[n - 1].tsc : 0);
+    printf("\n]}\n");
+  }
+
+  munmap(ring, size);
+  CloseSymbolTable(&symtab);
+  free(threads.p);
+  free(calls);
+  return 0;
+}
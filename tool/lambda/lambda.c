@@ -31,7 +31,7 @@
 #include "tool/lambda/lib/blc.h"
 
 #define USAGE \
-  " [-?hubBdsarvnNlS] <stdin >expr.txt\n\
+  " [-?hubBdsarvnNlSLc] <stdin >expr.txt\n\
 Binary Lambda Calculus Virtual Machine\n\
 \n\
 FLAGS\n\
@@ -46,7 +46,9 @@ FLAGS\n\
   -s      full machine state logging\n\
   -n      disables name rewriting rules\n\
   -N      disables most unicode symbolism\n\
-  -d      dump terms on successful exit\n"
+  -d      dump terms on successful exit\n\
+  -L      lazy evaluation that shares arguments\n\
+  -c      print reduction counts on exit\n"
 
 #define NIL   23
 #define TRUE  27
@@ -80,11 +82,31 @@ static const char kRom[] = {
     VAR, 1,  // 29
 };
 
+static int lazy;
+static int counts;
 static int postdump;
 static int kLazy[256];
+static long depth;            // number of closures on contp
+static struct Closure *updp;  // thunks awaiting update, if lazy
+static long cApps, cAbss, cVars, cIops, cPooled, cUpdates, cShared;
+
+static void PrintCounts(void) {
+  fprintf(stderr,
+          "reductions %ld\n"
+          "apps       %ld\n"
+          "vars       %ld\n"
+          "iops       %ld\n"
+          "allocs     %d\n"
+          "pooled     %ld\n"
+          "updates    %ld\n"
+          "shared     %ld\n",
+          cAbss, cApps, cVars, cIops, heap, cPooled, cUpdates, cShared);
+}
 
 void Quit(int sig) {
   Dump(0, end, stderr);
+  if (counts)
+    PrintCounts();
   exit(128 + sig);
 }
 
@@ -119,6 +141,46 @@ void Gc(struct Closure *p) {
   }
 }
 
+struct Closure *Alloc(void) {
+  struct Closure *t;
+  if (!(t = frep)) {
+    if (!(t = Calloc(1, sizeof(struct Closure)))) {
+      Error(6, "OUT OF HEAP");
+    }
+    ++cPooled;
+  }
+  frep = t->next;
+  t->refs = 1;
+  ++heap;
+  return t;
+}
+
+// pushes update marker so argument is only evaluated once
+static void Defer(struct Closure *e) {
+  struct Closure *m = Alloc();
+  m->term = depth;
+  m->envp = REF(e);
+  m->next = updp;
+  updp = m;
+}
+
+// overwrites thunks with the abstraction they evaluated to
+static void Update(void) {
+  struct Closure *m, *e, *t;
+  while (updp && updp->term == depth) {
+    m = updp;
+    updp = m->next;
+    e = m->envp;
+    t = e->envp;
+    e->term = ip;
+    e->envp = REF(envp);
+    Gc(t);
+    m->next = 0;
+    Gc(m);
+    ++cUpdates;
+  }
+}
+
 void Var(void) {
   int i, x;
   struct Closure *t, *e;
@@ -128,9 +190,17 @@ void Var(void) {
     e = e->next;
   if (e == &root)
     Error(10 + x, "UNDEFINED VARIABLE %d", x);
+  if (lazy && e->term > 21 && e->term != end) {
+    if (mem[e->term] != ABS) {
+      Defer(e);
+    } else if (e->refs > 1) {
+      ++cShared;
+    }
+  }
   ip = e->term;
   envp = REF(e->envp);
   Gc(t);
+  ++cVars;
 }
 
 void Gro(void) {
@@ -178,11 +248,15 @@ void Bye(void) {
     Error(rc, "CONTINUATIONS EXHAUSTED");
   if (postdump && !rc)
     Dump(0, end, stderr);
+  if (counts)
+    PrintCounts();
   exit(0);
 }
 
 // pops continuation and pushes it to environment
 void Abs(void) {
+  if (updp)
+    Update();
   if (!contp)
     Bye();
   struct Closure *t = contp;
@@ -190,19 +264,8 @@ void Abs(void) {
   t->next = envp;
   envp = t;
   ++ip;
-}
-
-struct Closure *Alloc(void) {
-  struct Closure *t;
-  if (!(t = frep)) {
-    if (!(t = Calloc(1, sizeof(struct Closure)))) {
-      Error(6, "OUT OF HEAP");
-    }
-  }
-  frep = t->next;
-  t->refs = 1;
-  ++heap;
-  return t;
+  --depth;
+  ++cAbss;
 }
 
 // pushes continuation for argument
@@ -214,6 +277,8 @@ void App(void) {
   t->next = contp;
   contp = t;
   ip += 2;
+  ++depth;
+  ++cApps;
 }
 
 int LoadByte(int c) {
@@ -252,6 +317,7 @@ void Iop(void) {
   }
   Gc(envp);
   envp = &root;
+  ++cIops;
 }
 
 static void Rex(void) {
@@ -303,7 +369,7 @@ void LoadFlags(int argc, char *argv[]) {
   int i;
   const char *prog;
   prog = argc ? argv[0] : "cblc";
-  while ((i = getopt(argc, argv, "?hubBdsarvnNlS")) != -1) {
+  while ((i = getopt(argc, argv, "?hubBdsarvnNlSLc")) != -1) {
     switch (i) {
       case 'b':
         binary = 1;
@@ -340,6 +406,12 @@ void LoadFlags(int argc, char *argv[]) {
       case 'd':
         postdump = 1;
         break;
+      case 'L':
+        lazy = 1;
+        break;
+      case 'c':
+        counts = 1;
+        break;
       case '?':
       case 'h':
         PrintUsage(prog, 0, stdout);
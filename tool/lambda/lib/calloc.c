@@ -16,6 +16,7 @@
 │ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
 │ PERFORMANCE OF THIS SOFTWARE.                                                │
 ╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
 #include "libc/runtime/runtime.h"
 #include "libc/sysv/consts/map.h"
 #include "libc/sysv/consts/prot.h"
@@ -32,9 +33,10 @@ void *Calloc(size_t a, size_t b) {
     p = mmap((void *)0x300000000000, getgransize(), PROT_READ | PROT_WRITE,
              MAP_ANONYMOUS | MAP_PRIVATE | MAP_FIXED, -1, 0);
   }
-  if (i + z > n) {
-    mmap(p + i, getgransize(), PROT_READ | PROT_WRITE,
-         MAP_ANONYMOUS | MAP_PRIVATE | MAP_FIXED, -1, 0);
+  while (i + z > n) {
+    if (mmap(p + n, getgransize(), PROT_READ | PROT_WRITE,
+             MAP_ANONYMOUS | MAP_PRIVATE | MAP_FIXED, -1, 0) == MAP_FAILED)
+      return 0;
     n += getgransize();
   }
   r = p + i;
@@ -286,6 +286,90 @@ assert(read_binary == binary_content, "binary content should round-trip correctl
 
 reader:close()
 
+--------------------------------------------------------------------------------
+-- Test add_file
+--------------------------------------------------------------------------------
+
+local disk_content = string.rep("streamed from disk\n", 500)
+local diskpath = tmpdir .. "/disk.txt"
+fd = unix.open(diskpath, unix.O_CREAT | unix.O_WRONLY, 0600)
+assert(fd, "failed to create disk.txt")
+unix.write(fd, disk_content)
+unix.close(fd)
+
+local zippath7 = tmpdir .. "/test_add_file.zip"
+writer, err = zip.open(zippath7, "w")
+assert(writer, "failed to create zip: " .. tostring(err))
+
+ok, err = writer:add_file("deflated.txt", diskpath)
+assert(ok, "failed to add_file: " .. tostring(err))
+ok, err = writer:add_file("stored.txt", diskpath, {method = "store"})
+assert(ok, "failed to add_file stored: " .. tostring(err))
+ok, err = writer:add_file("nested.zip", tmpdir .. "/test_empty.zip", {mtime = 0})
+assert(ok, "failed to add_file: " .. tostring(err))
+
+local nothing
+nothing, err = writer:add_file("dir", tmpdir)
+assert(nothing == nil and err, "add_file of directory should fail")
+nothing, err = writer:add_file("missing.txt", tmpdir .. "/missing.txt")
+assert(nothing == nil and err, "add_file of missing file should fail")
+nothing, err = writer:add_file("stored.txt", diskpath)
+assert(nothing == nil and err, "add_file should reject duplicate names")
+
+ok, err = writer:close()
+assert(ok, "failed to close: " .. tostring(err))
+
+reader, err = zip.open(zippath7)
+assert(reader, "failed to open zip: " .. tostring(err))
+assert(reader:read("deflated.txt") == disk_content, "deflated add_file mismatch")
+assert(reader:read("stored.txt") == disk_content, "stored add_file mismatch")
+assert(reader:stat("deflated.txt").method == 8, "should have been deflated")
+assert(reader:stat("stored.txt").method == 0, "should have been stored")
+assert(reader:stat("stored.txt").mode & 0777 == 0600, "mode should come from file")
+reader:close()
+
+--------------------------------------------------------------------------------
+-- Test many entries and read_many
+--------------------------------------------------------------------------------
+
+local zippath6 = tmpdir .. "/test_many.zip"
+writer, err = zip.open(zippath6, "w")
+assert(writer, "failed to create zip: " .. tostring(err))
+
+for i = 1, 2000 do
+  ok, err = writer:add("dir/file" .. i .. ".txt", "content " .. i)
+  assert(ok, "failed to add file: " .. tostring(err))
+end
+ok, err = writer:close()
+assert(ok, "failed to close: " .. tostring(err))
+
+reader, err = zip.open(zippath6)
+assert(reader, "failed to open zip: " .. tostring(err))
+
+for i = 2000, 1, -7 do
+  assert(reader:read("dir/file" .. i .. ".txt") == "content " .. i,
+         "wrong content for file" .. i)
+end
+assert(reader:stat("dir/file2001.txt") == nil, "missing entry should stat nil")
+assert(reader:stat("dir/file1.tx") == nil, "prefix should not match")
+
+local many = reader:read_many({"dir/file1999.txt", "dir/file3.txt",
+                               "dir/file1000.txt", "dir/file3.txt"})
+assert(many, "read_many should succeed")
+assert(#many == 4, "read_many should return one result per name")
+assert(many[1] == "content 1999", "read_many result 1 out of order")
+assert(many[2] == "content 3", "read_many result 2 out of order")
+assert(many[3] == "content 1000", "read_many result 3 out of order")
+assert(many[4] == "content 3", "read_many result 4 out of order")
+
+local none, many_err = reader:read_many({"dir/file1.txt", "nope.txt"})
+assert(none == nil, "read_many with missing entry should fail")
+assert(many_err:match("nope.txt"), "read_many error should name the entry")
+
+assert(#reader:read_many({}) == 0, "read_many of nothing is empty")
+
+reader:close()
+
 --------------------------------------------------------------------------------
 -- Test error cases
 --------------------------------------------------------------------------------
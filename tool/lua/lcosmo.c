@@ -259,6 +259,7 @@ static const luaL_Reg kCosmoFuncs[] = {
     {"Sha512", LuaSha512},
     {"Curve25519", LuaCurve25519},
     {"Fetch", LuaFetch},
+    {"FetchMany", LuaFetchMany},
     {NULL, NULL}
 };
 // clang-format on
@@ -18,6 +18,7 @@ TOOL_NET_BINS =								\
 TOOL_NET_COMS =								\
 	o/$(MODE)/tool/net/dig						\
 	o/$(MODE)/tool/net/drift					\
+	o/$(MODE)/tool/net/loadgen					\
 	o/$(MODE)/tool/net/stampd					\
 	o/$(MODE)/tool/net/winbench					\
 	o/$(MODE)/tool/net/redbean					\
@@ -60,6 +61,7 @@ TOOL_NET_DIRECTDEPS =							\
 	THIRD_PARTY_DOUBLECONVERSION					\
 	THIRD_PARTY_GDTOA						\
 	THIRD_PARTY_GETOPT						\
+	THIRD_PARTY_HIREDIS						\
 	THIRD_PARTY_LINENOISE						\
 	THIRD_PARTY_LUA							\
 	THIRD_PARTY_LUA_UNIX						\
@@ -71,6 +73,7 @@ TOOL_NET_DIRECTDEPS =							\
 	THIRD_PARTY_SQLITE3						\
 	THIRD_PARTY_TZ							\
 	THIRD_PARTY_ZLIB						\
+	THIRD_PARTY_ZSTD						\
 	TOOL_ARGS							\
 	TOOL_BUILD_LIB							\
 	TOOL_DECODE_LIB
@@ -102,6 +105,7 @@ TOOL_NET_REDBEAN_LUA_MODULES =						\
 	o/$(MODE)/tool/net/lre.o					\
 	o/$(MODE)/tool/net/ljson.o					\
 	o/$(MODE)/tool/net/lmaxmind.o					\
+	o/$(MODE)/tool/net/lredis.o					\
 	o/$(MODE)/tool/net/lsqlite3.o					\
 	o/$(MODE)/tool/net/largon2.o					\
 	o/$(MODE)/tool/net/launch.o					\
@@ -19,6 +19,7 @@
 #include "tool/net/lfetch.h"
 #include "libc/calls/calls.h"
 #include "libc/calls/struct/timeval.h"
+#include "libc/cosmotime.h"
 #include "libc/errno.h"
 #include "libc/fmt/conv.h"
 #include "libc/intrin/atomic.h"
@@ -30,13 +31,17 @@
 #include "libc/serialize.h"
 #include "libc/sock/goodsocket.internal.h"
 #include "libc/sock/sock.h"
+#include "libc/sock/struct/pollfd.h"
 #include "libc/stdio/append.h"
 #include "libc/str/slice.h"
 #include "libc/str/str.h"
 #include "libc/sysv/consts/af.h"
 #include "libc/sysv/consts/ipproto.h"
 #include "libc/sysv/consts/limits.h"
+#include "libc/sysv/consts/poll.h"
+#include "libc/sysv/consts/so.h"
 #include "libc/sysv/consts/sock.h"
+#include "libc/sysv/consts/sol.h"
 #include "libc/thread/thread.h"
 #include "libc/x/x.h"
 #include "libc/x/xasprintf.h"
@@ -46,6 +51,7 @@
 #include "net/http/url.h"
 #include "third_party/lua/lauxlib.h"
 #include "third_party/lua/lua.h"
+#include "third_party/lua/lunix.h"
 #include "third_party/mbedtls/ctr_drbg.h"
 #include "third_party/mbedtls/error.h"
 #include "third_party/mbedtls/ssl.h"
@@ -117,6 +123,8 @@ static void LockInc(atomic_int *p) {
   atomic_fetch_add(p, 1);
 }
 
+#define LockIncCounter(C) LockInc(&shared->c.C)
+
 static bool IsRepeatable(const char *s, size_t n) {
   int h;
   if ((h = GetHttpHeader(s, n)) != -1) {
@@ -144,10 +152,12 @@ static int LuaNilTlsError(lua_State *L, const char *s, int r) {
 
 static void LuaPushHeaders(lua_State *L, struct HttpMessage *msg,
                            const char *buf) {
-  size_t i;
+  size_t i, n;
   const char *k, *v;
   size_t kn, vn;
-  lua_newtable(L);
+  for (n = msg->xheaders.n, i = 0; i < kHttpHeadersMax; ++i)
+    n += !!msg->headers[i].a;
+  lua_createtable(L, 0, n);
   for (i = 0; i < kHttpHeadersMax; ++i) {
     if (!msg->headers[i].a)
       continue;
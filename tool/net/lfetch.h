@@ -4,6 +4,7 @@
 COSMOPOLITAN_C_START_
 
 int LuaFetch(lua_State *);
+int LuaFetchMany(lua_State *);
 void LuaInitFetch(void);
 
 COSMOPOLITAN_C_END_
@@ -143,6 +143,28 @@ int LuaGetCpuCount(lua_State *L) {
   return 1;
 }
 
+int LuaProfileStart(lua_State *L) {
+  static const char *const kFormats[] = {"pprof", "folded", 0};
+  int flags, olderr = errno;
+  const char *path = luaL_checkstring(L, 1);
+  lua_Integer hz = luaL_optinteger(L, 2, 100);
+  if (!(1 <= hz && hz <= 1000000))
+    return luaL_argerror(L, 2, "sampling rate must be 1 to 1000000");
+  flags = luaL_checkoption(L, 3, "pprof", kFormats) ? COSMO_PROFILE_FOLDED : 0;
+  if (cosmo_profile_start(hz, flags, path) == -1)
+    return LuaUnixSysretErrno(L, "cosmo_profile_start", olderr);
+  lua_pushboolean(L, true);
+  return 1;
+}
+
+int LuaProfileStop(lua_State *L) {
+  int olderr = errno;
+  if (cosmo_profile_stop() == -1)
+    return LuaUnixSysretErrno(L, "cosmo_profile_stop", olderr);
+  lua_pushboolean(L, true);
+  return 1;
+}
+
 int LuaGetLogLevel(lua_State *L) {
   lua_pushinteger(L, __log_level);
   return 1;
@@ -495,33 +517,42 @@ int LuaGetMonospaceWidth(lua_State *L) {
   return 1;
 }
 
-// Slurp(path:str[, i:int[, j:int]])
-//     ├─→ data:str
+// Slurp(path:str[, i:int[, j:int]][, buffer:unix.Buffer])
+//     ├─→ data:str|unix.Buffer
 //     └─→ nil, unix.Errno
 int LuaSlurp(lua_State *L) {
+  char *p;
   ssize_t rc;
+  size_t chunk;
   char tb[2048];
   luaL_Buffer b;
   struct stat st;
-  int fd, olderr;
+  int fd, olderr, buf;
   bool shouldpread;
   lua_Integer i, j, got;
   olderr = errno;
-  if (lua_isnoneornil(L, 2)) {
+  // a trailing buffer is appended to, rather than creating a string
+  if ((buf = lua_gettop(L)) > 1 && LuaUnixIsBuffer(L, buf)) {
+    lua_settop(L, buf);
+  } else {
+    buf = 0;
+  }
+  if (lua_isnoneornil(L, 2) || buf == 2) {
     i = 1;
   } else {
     i = luaL_checkinteger(L, 2);
   }
-  if (lua_isnoneornil(L, 3)) {
+  if (lua_isnoneornil(L, 3) || (buf && buf <= 3)) {
     j = LUA_MAXINTEGER;
   } else {
     j = luaL_checkinteger(L, 3);
   }
-  luaL_buffinit(L, &b);
+  if (!buf)
+    luaL_buffinit(L, &b);
   if ((fd = open(luaL_checkstring(L, 1), O_RDONLY)) == -1) {
     return LuaUnixSysretErrno(L, "open", olderr);
   }
-  if (i < 0 || j < 0) {
+  if (i < 0 || j < 0 || (buf && j == LUA_MAXINTEGER)) {
     if (fstat(fd, &st) == -1) {
       close(fd);
       return LuaUnixSysretErrno(L, "fstat", olderr);
@@ -533,21 +564,37 @@ int LuaSlurp(lua_State *L) {
       j = st.st_size + (j + 1);
     }
   }
+  // read the whole file in one go when we know its size, plus a byte
+  // so eof is noticed without growing the buffer
+  chunk = sizeof(tb);
+  if (buf && j == LUA_MAXINTEGER)
+    chunk = MAX(chunk, MIN(st.st_size + 1, 0x7ffff000));
   if (i < 1) {
     i = 1;
   }
   shouldpread = i > 1;
   for (; i <= j; i += got) {
+    got = MIN(j - i + 1, chunk);
+    if (buf) {
+      p = LuaUnixBufferReserve(L, buf, got);
+    } else {
+      p = tb;
+    }
     if (shouldpread) {
-      rc = pread(fd, tb, MIN(j - i + 1, sizeof(tb)), i - 1);
+      rc = pread(fd, p, got, i - 1);
     } else {
-      rc = read(fd, tb, MIN(j - i + 1, sizeof(tb)));
+      rc = read(fd, p, got);
     }
     if (rc != -1) {
       got = rc;
       if (!got)
         break;
-      luaL_addlstring(&b, tb, got);
+      if (buf) {
+        LuaUnixBufferCommit(L, buf, got);
+        chunk = MAX(chunk, MIN(chunk * 2, 1 << 20));
+      } else {
+        luaL_addlstring(&b, tb, got);
+      }
     } else if (errno == EINTR) {
       errno = olderr;
       got = 0;
@@ -559,7 +606,8 @@ int LuaSlurp(lua_State *L) {
   if (close(fd) == -1) {
     return LuaUnixSysretErrno(L, "close", olderr);
   }
-  luaL_pushresult(&b);
+  if (!buf)
+    luaL_pushresult(&b);
   return 1;
 }
 
@@ -6,6 +6,7 @@ COSMOPOLITAN_C_START_
 
 int LuaMaxmind(lua_State *);
 int LuaRe(lua_State *);
+int LuaRedis(lua_State *);
 int luaopen_argon2(lua_State *);
 int luaopen_lsqlite3(lua_State *);
 
@@ -77,6 +78,8 @@ int LuaParseHttpDateTime(lua_State *);
 int LuaParseIp(lua_State *);
 int LuaParseParams(lua_State *);
 int LuaPopcnt(lua_State *);
+int LuaProfileStart(lua_State *);
+int LuaProfileStop(lua_State *);
 int LuaRand64(lua_State *);
 int LuaRdrand(lua_State *);
 int LuaRdseed(lua_State *);
@@ -19,9 +19,11 @@
 #include "tool/net/ljson.h"
 #include "libc/assert.h"
 #include "libc/ctype.h"
+#include "libc/dce.h"
 #include "libc/intrin/likely.h"
 #include "libc/log/check.h"
 #include "libc/log/log.h"
+#include "libc/nexgen32e/x86feature.h"
 #include "libc/runtime/runtime.h"
 #include "libc/runtime/stack.h"
 #include "libc/serialize.h"
@@ -31,7 +33,9 @@
 #include "libc/str/utf16.h"
 #include "libc/sysv/consts/auxv.h"
 #include "libc/thread/thread.h"
+#include "third_party/aarch64/arm_neon.internal.h"
 #include "third_party/double-conversion/wrapper.h"
+#include "third_party/intel/immintrin.internal.h"
 #include "third_party/lua/cosmo.h"
 #include "third_party/lua/lauxlib.h"
 #include "third_party/lua/ltests.h"
@@ -93,6 +97,138 @@ static const char kJsonStr[256] = {
     11, 11, 11, 11, 11, 11, 11, 11,  // 0370
 };
 
+#if defined(__x86_64__) && !defined(__chibicc__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+static const char *ScanJsonStrAvx2(const char *p, const char *e) {
+  unsigned m;
+  __m256i v, qv, bv, cv;
+  qv = _mm256_set1_epi8('"');
+  bv = _mm256_set1_epi8('\\');
+  cv = _mm256_set1_epi8(' ');
+  for (; e - p >= 32; p += 32) {
+    v = _mm256_loadu_si256((const __m256i *)p);
+    // signed compare catches both c0 controls and bytes ≥0x80
+    if ((m = _mm256_movemask_epi8(
+             _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, qv),
+                                             _mm256_cmpeq_epi8(v, bv)),
+                             _mm256_cmpgt_epi8(cv, v)))))
+      return p + __builtin_ctz(m);
+  }
+  return p;
+}
+static const char *SkipJsonSpaceAvx2(const char *p, const char *e) {
+  unsigned m;
+  __m256i v;
+  for (; e - p >= 32; p += 32) {
+    v = _mm256_loadu_si256((const __m256i *)p);
+    if ((m = ~_mm256_movemask_epi8(_mm256_or_si256(
+             _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                             _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))),
+             _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')),
+                             _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')))))))
+      return p + __builtin_ctz(m);
+  }
+  return p;
+}
+#pragma GCC pop_options
+static const char *ScanJsonStrSse2(const char *p, const char *e) {
+  unsigned m;
+  __m128i v, qv, bv, cv;
+  qv = _mm_set1_epi8('"');
+  bv = _mm_set1_epi8('\\');
+  cv = _mm_set1_epi8(' ');
+  for (; e - p >= 16; p += 16) {
+    v = _mm_loadu_si128((const __m128i *)p);
+    if ((m = _mm_movemask_epi8(_mm_or_si128(
+             _mm_or_si128(_mm_cmpeq_epi8(v, qv), _mm_cmpeq_epi8(v, bv)),
+             _mm_cmplt_epi8(v, cv)))))
+      return p + __builtin_ctz(m);
+  }
+  return p;
+}
+static const char *SkipJsonSpaceSse2(const char *p, const char *e) {
+  unsigned m;
+  __m128i v;
+  for (; e - p >= 16; p += 16) {
+    v = _mm_loadu_si128((const __m128i *)p);
+    if ((m = ~_mm_movemask_epi8(_mm_or_si128(
+                 _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                              _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+                 _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')),
+                              _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))))) &
+             0xffff))
+      return p + __builtin_ctz(m);
+  }
+  return p;
+}
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+static uint64_t GetJsonNeonMask(uint8x16_t v) {
+  return vget_lane_u64(
+      vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(v), 4)), 0);
+}
+static const char *ScanJsonStrNeon(const char *p, const char *e) {
+  uint64_t m;
+  uint8x16_t v;
+  for (; e - p >= 16; p += 16) {
+    v = vld1q_u8((const uint8_t *)p);
+    if ((m = GetJsonNeonMask(
+             vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')),
+                               vceqq_u8(v, vdupq_n_u8('\\'))),
+                      vorrq_u8(vcltq_u8(v, vdupq_n_u8(' ')),
+                               vcgeq_u8(v, vdupq_n_u8(0x80)))))))
+      return p + (__builtin_ctzll(m) >> 2);
+  }
+  return p;
+}
+static const char *SkipJsonSpaceNeon(const char *p, const char *e) {
+  uint64_t m;
+  uint8x16_t v;
+  for (; e - p >= 16; p += 16) {
+    v = vld1q_u8((const uint8_t *)p);
+    if ((m = ~GetJsonNeonMask(
+             vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')),
+                               vceqq_u8(v, vdupq_n_u8('\n'))),
+                      vorrq_u8(vceqq_u8(v, vdupq_n_u8('\r')),
+                               vceqq_u8(v, vdupq_n_u8('\t')))))))
+      return p + (__builtin_ctzll(m) >> 2);
+  }
+  return p;
+}
+#endif
+
+// returns first quote, backslash, control, or non-ascii byte in [p,e)
+static const char *ScanJsonStr(const char *p, const char *e) {
+#if defined(__x86_64__) && !defined(__chibicc__)
+  if (X86_HAVE(AVX2) && !IsModeDbg()) {
+    p = ScanJsonStrAvx2(p, e);
+  } else {
+    p = ScanJsonStrSse2(p, e);
+  }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  p = ScanJsonStrNeon(p, e);
+#endif
+  while (p < e && kJsonStr[*p & 255] == ASCII)
+    ++p;
+  return p;
+}
+
+// returns first non-whitespace byte in [p,e)
+static const char *SkipJsonSpace(const char *p, const char *e) {
+#if defined(__x86_64__) && !defined(__chibicc__)
+  if (X86_HAVE(AVX2) && !IsModeDbg()) {
+    p = SkipJsonSpaceAvx2(p, e);
+  } else {
+    p = SkipJsonSpaceSse2(p, e);
+  }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  p = SkipJsonSpaceNeon(p, e);
+#endif
+  while (p < e && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
+    ++p;
+  return p;
+}
+
 static struct DecodeJson Parse(struct lua_State *L, const char *p,
                                const char *e, int context, int depth,
                                uintptr_t bsp) {
@@ -100,7 +236,7 @@ static struct DecodeJson Parse(struct lua_State *L, const char *p,
   char w[4];
   luaL_Buffer b;
   struct DecodeJson r;
-  const char *a, *reason;
+  const char *a, *q, *reason;
   int A, B, C, D, c, d, i, u;
   if (UNLIKELY(!depth))
     return (struct DecodeJson){-1, "maximum depth exceeded"};
@@ -112,7 +248,7 @@ static struct DecodeJson Parse(struct lua_State *L, const char *p,
       case '\n':
       case '\r':
       case '\t':
-        a = p;
+        a = p = SkipJsonSpace(p, e);
         break;
 
       case ',':  // present in list and object
@@ -317,7 +453,10 @@ static struct DecodeJson Parse(struct lua_State *L, const char *p,
           switch (kJsonStr[(c = *p++ & 255)]) {
 
             case ASCII:
+              q = ScanJsonStr(p, e);
               luaL_addchar(&b, c);
+              luaL_addlstring(&b, p, q - p);
+              p = q;
               break;
 
             case DQUOTE:
@@ -23,9 +23,22 @@
 #include "third_party/lua/luaconf.h"
 #include "third_party/maxmind/maxminddb.h"
 
+#define kMaxmindCacheSize 256 /* must be two power */
+
+// remembers which record a network prefix resolved to, which is safe
+// since every address under a search tree leaf shares the same result
+struct MaxmindCached {
+  bool used;
+  uint8_t bits;
+  uint32_t net;
+  MMDB_lookup_result_s mmlr;
+};
+
 struct MaxmindDb {
   int refs;
+  uint64_t lens; /* bitset of prefix lengths present in cache */
   MMDB_s mmdb;
+  struct MaxmindCached cache[kMaxmindCacheSize];
 };
 
 struct MaxmindResult {
@@ -68,8 +81,8 @@ static int LuaMaxmindOpen(lua_State *L) {
   const char *p;
   struct MaxmindDb **udb, *db;
   p = luaL_checklstring(L, 1, 0);
-  db = xmalloc(sizeof(struct MaxmindDb));
-  if ((err = MMDB_open(p, 0, &db->mmdb)) != MMDB_SUCCESS) {
+  db = xcalloc(1, sizeof(struct MaxmindDb));
+  if ((err = MMDB_open(p, MMDB_MODE_MMAP, &db->mmdb)) != MMDB_SUCCESS) {
     free(db);
     luaL_error(L, "MMDB_open(%s) → MMDB_%s", p, GetMmdbError(err));
     __builtin_unreachable();
@@ -91,6 +104,59 @@ static int LuaMaxmindOpen(lua_State *L) {
   __builtin_unreachable();
 }
 
+// returns prefix length of result within the ipv4 address space
+static int GetMaxmindBits(struct MaxmindDb *db,
+                          const MMDB_lookup_result_s *mmlr) {
+  if (db->mmdb.metadata.ip_version == 6)
+    return mmlr->netmask - (128 - 32);
+  return mmlr->netmask;
+}
+
+static uint32_t GetMaxmindNetwork(uint32_t ip, int bits) {
+  return bits ? ip & (0xffffffffu << (32 - bits)) : 0;
+}
+
+static struct MaxmindCached *GetMaxmindSlot(struct MaxmindDb *db,
+                                            uint32_t net, int bits) {
+  return db->cache +
+         (((net ^ bits) * 2654435761u) >> 24 & (kMaxmindCacheSize - 1));
+}
+
+static bool LookupMaxmindCache(struct MaxmindDb *db, uint32_t ip,
+                               MMDB_lookup_result_s *out) {
+  int bits;
+  uint32_t net;
+  uint64_t lens;
+  struct MaxmindCached *c;
+  for (lens = db->lens; lens; lens &= ~(1ull << bits)) {
+    bits = 63 - __builtin_clzll(lens);
+    net = GetMaxmindNetwork(ip, bits);
+    c = GetMaxmindSlot(db, net, bits);
+    if (c->used && c->bits == bits && c->net == net) {
+      *out = c->mmlr;
+      return true;
+    }
+  }
+  return false;
+}
+
+static void InsertMaxmindCache(struct MaxmindDb *db, uint32_t ip,
+                               const MMDB_lookup_result_s *mmlr) {
+  int bits;
+  uint32_t net;
+  struct MaxmindCached *c;
+  bits = GetMaxmindBits(db, mmlr);
+  if (bits < 0 || bits > 32)
+    return;
+  net = GetMaxmindNetwork(ip, bits);
+  c = GetMaxmindSlot(db, net, bits);
+  c->used = true;
+  c->bits = bits;
+  c->net = net;
+  c->mmlr = *mmlr;
+  db->lens |= 1ull << bits;
+}
+
 static int LuaMaxmindDbLookup(lua_State *L) {
   int err;
   lua_Integer ip;
@@ -104,10 +170,13 @@ static int LuaMaxmindDbLookup(lua_State *L) {
   }
   db = *udb;
   r = xmalloc(sizeof(struct MaxmindResult));
-  r->mmlr = MMDB_lookup(&db->mmdb, ip, &err);
-  if (err) {
-    free(r);
-    LuaThrowMaxmindIpError(L, "MMDB_lookup", ip, err);
+  if (!LookupMaxmindCache(db, ip, &r->mmlr)) {
+    r->mmlr = MMDB_lookup(&db->mmdb, ip, &err);
+    if (err) {
+      free(r);
+      LuaThrowMaxmindIpError(L, "MMDB_lookup", ip, err);
+    }
+    InsertMaxmindCache(db, ip, &r->mmlr);
   }
   if (!r->mmlr.found_entry) {
     free(r);
@@ -126,7 +195,7 @@ static int LuaMaxmindDbLookup(lua_State *L) {
 static int LuaMaxmindResultNetmask(lua_State *L) {
   struct MaxmindResult **ur;
   ur = luaL_checkudata(L, 1, "MaxmindResult*");
-  lua_pushinteger(L, (*ur)->mmlr.netmask - (128 - 32));
+  lua_pushinteger(L, GetMaxmindBits((*ur)->db, &(*ur)->mmlr));
   return 1;
 }
 
@@ -0,0 +1,763 @@
+#if 0
+/*─────────────────────────────────────────────────────────────────╗
+│ To the extent possible under law, Justine Tunney has waived      │
+│ all copyright and related or neighboring rights to this file,    │
+│ as it is written in the following disclaimers:                   │
+│   • http://unlicense.org/                                        │
+│   • http://creativecommons.org/publicdomain/zero/1.0/            │
+╚─────────────────────────────────────────────────────────────────*/
+#endif
+#include "libc/atomic.h"
+#include "libc/calls/calls.h"
+#include "libc/calls/struct/iovec.h"
+#include "libc/calls/struct/sigaction.h"
+#include "libc/calls/struct/timeval.h"
+#include "libc/cosmotime.h"
+#include "libc/errno.h"
+#include "libc/fmt/conv.h"
+#include "libc/fmt/magnumstrs.internal.h"
+#include "libc/intrin/bsr.h"
+#include "libc/limits.h"
+#include "libc/macros.h"
+#include "libc/math.h"
+#include "libc/mem/gc.h"
+#include "libc/mem/mem.h"
+#include "libc/runtime/runtime.h"
+#include "libc/sock/goodsocket.internal.h"
+#include "libc/sock/sock.h"
+#include "libc/stdio/append.h"
+#include "libc/stdio/rand.h"
+#include "libc/stdio/stdio.h"
+#include "libc/str/slice.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/af.h"
+#include "libc/sysv/consts/clock.h"
+#include "libc/sysv/consts/ipproto.h"
+#include "libc/sysv/consts/sig.h"
+#include "libc/sysv/consts/sock.h"
+#include "libc/thread/thread.h"
+#include "net/http/http.h"
+#include "net/http/url.h"
+#include "net/https/https.h"
+#include "third_party/getopt/getopt.internal.h"
+#include "third_party/mbedtls/ctr_drbg.h"
+#include "third_party/mbedtls/error.h"
+#include "third_party/mbedtls/iana.h"
+#include "third_party/mbedtls/net_sockets.h"
+#include "third_party/mbedtls/ssl.h"
+#include "third_party/musl/netdb.h"
+
+/**
+ * @fileoverview HTTP load generator
+ *
+ * Each connection is a thread that sends requests over an HTTP/1.1
+ * keep-alive connection, optionally using TLS, and optionally sending
+ * `-p N` requests at a time with pipelining. By default each thread
+ * sends its next request as soon as the last response arrives. Passing
+ * `-R RATE` instead schedules RATE requests per second across all the
+ * connections, and measures latency from when each request was meant
+ * to be sent, so a stalled server can't hide its queueing delay.
+ *
+ * The `-s` flag selects a canned scenario for redbean-demo:
+ *
+ *     o//tool/net/redbean-demo -p 8080 &
+ *     o//tool/net/loadgen -c 64 -s static http://127.0.0.1:8080/
+ *     o//tool/net/loadgen -c 64 -s gzip http://127.0.0.1:8080/
+ *     o//tool/net/loadgen -c 64 -s lua http://127.0.0.1:8080/
+ *     o//tool/net/loadgen -c 64 -s sqlite http://127.0.0.1:8080/
+ *     o//tool/net/loadgen -c 64 -s fetch http://127.0.0.1:8080/
+ *
+ * A latency histogram is printed at the end. If `BENCHMARK_JSON` is
+ * set, a json summary line is printed too, which tool/scripts/benchcmp
+ * understands.
+ */
+
+#define kSubBuckets 16
+#define kBuckets    (64 * kSubBuckets)
+#define kTimeout    10
+
+#define HasHeader(H)    (!!c->msg.headers[H].a)
+#define HeaderData(H)   (c->buf + c->msg.headers[H].a)
+#define HeaderLength(H) (c->msg.headers[H].b - c->msg.headers[H].a)
+#define HeaderEqualCase(H, S) \
+  SlicesEqualCase(S, strlen(S), HeaderData(H), HeaderLength(H))
+
+struct Stats {
+  long requests;
+  long errors;
+  long failures;
+  long reconnects;
+  long bytes;
+  long sumns;
+  long minns;
+  long maxns;
+  long hist[kBuckets];
+};
+
+struct Conn {
+  int sock;
+  bool open;
+  unsigned a, b;
+  unsigned char t[4096];
+  size_t i, n;
+  char *buf;
+  struct HttpMessage msg;
+  mbedtls_ssl_config conf;
+  mbedtls_ssl_context ssl;
+  mbedtls_ctr_drbg_context drbg;
+};
+
+struct Response {
+  int status;
+  bool keepalive;
+  size_t size;
+};
+
+struct Worker {
+  int id;
+  pthread_t th;
+  struct Stats stats;
+};
+
+struct Scenario {
+  const char *name;
+  const char *path;
+  const char *header;
+  bool post;
+};
+
+static const struct Scenario kScenarios[] = {
+    {"static", "/index.html"},
+    {"gzip", "/redbean.css", "Accept-Encoding: gzip"},
+    {"lua", "/redbean.lua"},
+    {"sqlite", "/sql.lua"},
+    {"fetch", "/fetch.lua", 0, true},
+};
+
+static const char *prog;
+static bool usessl;
+static char *host;
+static char *port;
+static char *path;
+static char *body;
+static int depth = 1;
+static int seconds = 10;
+static int connections = 10;
+static double rate;
+static char *request;
+static size_t requestlen;
+static const char *method = "GET";
+static struct addrinfo *addr;
+static int authmode = MBEDTLS_SSL_VERIFY_REQUIRED;
+static atomic_bool a_finished;
+static long start;
+static long deadline;
+
+static struct Headers {
+  size_t n;
+  char **p;
+} headers;
+
+[[noreturn]] static void PrintUsage(int fd, int rc) {
+  tinyprint(fd, "usage: ", prog,
+            " [-k] [-c CONNS] [-d SECS] [-p DEPTH] [-R RATE] [-H HEADER]...\n"
+            "       [-b BODY] [-s static|gzip|lua|sqlite|fetch] URL\n",
+            NULL);
+  exit(rc);
+}
+
+static const char *DescribeErrno(void) {
+  const char *reason;
+  if (!(reason = _strerdoc(errno)))
+    reason = "Unknown error";
+  return reason;
+}
+
+static long Now(void) {
+  return timespec_tonanos(timespec_mono());
+}
+
+static int Bucket(long ns) {
+  int b;
+  if (ns < kSubBuckets)
+    return MAX(ns, 0);
+  b = bsrl(ns);
+  return (b - 3) * kSubBuckets + ((ns >> (b - 4)) - kSubBuckets);
+}
+
+static long BucketLow(int i) {
+  if (i < kSubBuckets)
+    return i;
+  return (long)(kSubBuckets + i % kSubBuckets) << (i / kSubBuckets - 1);
+}
+
+static void Record(struct Stats *s, long ns) {
+  ++s->hist[Bucket(ns)];
+  s->sumns += ns;
+  s->minns = MIN(s->minns, ns);
+  s->maxns = MAX(s->maxns, ns);
+}
+
+static long Percentile(const struct Stats *s, double q) {
+  int i;
+  long want, have;
+  want = MAX(1, ceil(q * s->requests));
+  for (have = i = 0; i < kBuckets; ++i)
+    if ((have += s->hist[i]) >= want)
+      return MIN(BucketLow(i + 1) - 1, s->maxns);
+  return s->maxns;
+}
+
+static char *FormatNanos(char buf[32], double ns) {
+  if (ns >= 1e9) {
+    snprintf(buf, 32, "%.3gs", ns / 1e9);
+  } else if (ns >= 1e6) {
+    snprintf(buf, 32, "%.3gms", ns / 1e6);
+  } else if (ns >= 1e3) {
+    snprintf(buf, 32, "%.3gµs", ns / 1e3);
+  } else {
+    snprintf(buf, 32, "%.3gns", ns);
+  }
+  return buf;
+}
+
+static char *FormatBytes(char buf[32], double x) {
+  if (x >= 1e9) {
+    snprintf(buf, 32, "%.3g GB", x / 1e9);
+  } else if (x >= 1e6) {
+    snprintf(buf, 32, "%.3g MB", x / 1e6);
+  } else if (x >= 1e3) {
+    snprintf(buf, 32, "%.3g kB", x / 1e3);
+  } else {
+    snprintf(buf, 32, "%.3g B", x);
+  }
+  return buf;
+}
+
+static int GetSslEntropy(void *c, unsigned char *p, size_t n) {
+  if (getrandom(p, n, 0) != n) {
+    perror("getrandom");
+    exit(1);
+  }
+  return 0;
+}
+
+static int TlsSend(void *c, const unsigned char *p, size_t n) {
+  int rc;
+  if ((rc = write(((struct Conn *)c)->sock, p, n)) == -1)
+    return MBEDTLS_ERR_NET_SEND_FAILED;
+  return rc;
+}
+
+static int TlsRecv(void *c, unsigned char *p, size_t n, uint32_t o) {
+  int r;
+  struct Conn *k = c;
+  struct iovec v[2];
+  if (k->a < k->b) {
+    r = MIN(n, k->b - k->a);
+    memcpy(p, k->t + k->a, r);
+    if ((k->a += r) == k->b) {
+      k->a = k->b = 0;
+    }
+    return r;
+  }
+  v[0].iov_base = p;
+  v[0].iov_len = n;
+  v[1].iov_base = k->t;
+  v[1].iov_len = sizeof(k->t);
+  if ((r = readv(k->sock, v, 2)) == -1)
+    return MBEDTLS_ERR_NET_RECV_FAILED;
+  if (r > n) {
+    k->b = r - n;
+  }
+  return MIN(n, r);
+}
+
+static void ParseTarget(const char *urlarg) {
+  struct Url url;
+  gc(ParseUrl(urlarg, -1, &url, kUrlPlus));
+  gc(url.params.p);
+  if (url.scheme.n) {
+    if (url.scheme.n == 5 && !memcasecmp(url.scheme.p, "https", 5)) {
+      usessl = true;
+    } else if (!(url.scheme.n == 4 && !memcasecmp(url.scheme.p, "http", 4))) {
+      tinyprint(2, prog, ": not an http/https url: ", urlarg, "\n", NULL);
+      exit(1);
+    }
+  }
+  if (url.host.n) {
+    host = strndup(url.host.p, url.host.n);
+  } else {
+    host = strdup("127.0.0.1");
+  }
+  if (url.port.n) {
+    port = strndup(url.port.p, url.port.n);
+  } else {
+    port = strdup(usessl ? "443" : "80");
+  }
+  if (!IsAcceptableHost(host, -1)) {
+    tinyprint(2, prog, ": invalid host: ", urlarg, "\n", NULL);
+    exit(1);
+  }
+  if (!path) {
+    url.fragment.p = 0, url.fragment.n = 0;
+    url.scheme.p = 0, url.scheme.n = 0;
+    url.user.p = 0, url.user.n = 0;
+    url.pass.p = 0, url.pass.n = 0;
+    url.host.p = 0, url.host.n = 0;
+    url.port.p = 0, url.port.n = 0;
+    if (!url.path.n || url.path.p[0] != '/') {
+      char *p = gc(malloc(1 + url.path.n));
+      mempcpy(mempcpy(p, "/", 1), url.path.p, url.path.n);
+      url.path.p = p;
+      ++url.path.n;
+    }
+    path = EncodeUrl(&url, 0);
+  }
+}
+
+static void BuildRequest(void) {
+  int i;
+  char *r = 0;
+  appendf(&r,
+          "%s %s HTTP/1.1\r\n"
+          "Host: %s:%s\r\n"
+          "User-Agent: loadgen\r\n",
+          method, path, host, port);
+  for (i = 0; i < headers.n; ++i)
+    appendf(&r, "%s\r\n", headers.p[i]);
+  if (body) {
+    appendf(&r,
+            "Content-Type: application/x-www-form-urlencoded\r\n"
+            "Content-Length: %zu\r\n"
+            "\r\n"
+            "%s",
+            strlen(body), body);
+  } else {
+    appends(&r, "\r\n");
+  }
+  requestlen = appendz(r).i;
+  request = malloc(requestlen * depth);
+  for (i = 0; i < depth; ++i)
+    memcpy(request + requestlen * i, r, requestlen);
+  requestlen *= depth;
+  free(r);
+}
+
+static void Disconnect(struct Conn *c) {
+  if (!c->open)
+    return;
+  c->open = false;
+  close(c->sock);
+  if (usessl) {
+    mbedtls_ssl_free(&c->ssl);
+    mbedtls_ssl_config_free(&c->conf);
+    mbedtls_ctr_drbg_free(&c->drbg);
+  }
+}
+
+static bool Connect(struct Conn *c, bool mustwork) {
+  int rc;
+  c->i = c->a = c->b = 0;
+  if ((c->sock = GoodSocket(addr->ai_family, addr->ai_socktype,
+                            addr->ai_protocol, false,
+                            &(struct timeval){kTimeout})) == -1) {
+    perror("socket");
+    exit(1);
+  }
+  if (connect(c->sock, addr->ai_addr, addr->ai_addrlen)) {
+    if (mustwork) {
+      tinyprint(2, prog, ": failed to connect to ", host, " port ", port,
+                ": ", DescribeErrno(), "\n", NULL);
+      exit(1);
+    }
+    close(c->sock);
+    return false;
+  }
+  c->open = true;
+  if (usessl) {
+    mbedtls_ssl_init(&c->ssl);
+    mbedtls_ctr_drbg_init(&c->drbg);
+    mbedtls_ssl_config_init(&c->conf);
+    unassert(!mbedtls_ctr_drbg_seed(&c->drbg, GetSslEntropy, 0, "justine", 7));
+    unassert(!mbedtls_ssl_config_defaults(&c->conf, MBEDTLS_SSL_IS_CLIENT,
+                                          MBEDTLS_SSL_TRANSPORT_STREAM,
+                                          MBEDTLS_SSL_PRESET_SUITEC));
+    mbedtls_ssl_conf_authmode(&c->conf, authmode);
+    mbedtls_ssl_conf_ca_chain(&c->conf, GetSslRoots(), 0);
+    mbedtls_ssl_conf_verify_cache(&c->conf, VerifyCache, 0);
+    mbedtls_ssl_conf_rng(&c->conf, mbedtls_ctr_drbg_random, &c->drbg);
+    unassert(!mbedtls_ssl_setup(&c->ssl, &c->conf));
+    unassert(!mbedtls_ssl_set_hostname(&c->ssl, host));
+    mbedtls_ssl_set_bio(&c->ssl, c, TlsSend, 0, TlsRecv);
+    if ((rc = mbedtls_ssl_handshake(&c->ssl))) {
+      if (mustwork) {
+        tinyprint(2, prog, ": ssl negotiation with ", host, " failed: ",
+                  DescribeSslClientHandshakeError(&c->ssl, rc), "\n", NULL);
+        exit(1);
+      }
+      Disconnect(c);
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool Send(struct Conn *c, const char *p, size_t n) {
+  ssize_t rc;
+  for (size_t i = 0; i < n; i += rc) {
+    if (usessl) {
+      rc = mbedtls_ssl_write(&c->ssl, p + i, n - i);
+    } else {
+      rc = write(c->sock, p + i, n - i);
+    }
+    if (rc <= 0)
+      return false;
+  }
+  return true;
+}
+
+// makes sure there's room in buffer to read more bytes
+static void Reserve(struct Conn *c) {
+  if (c->i == c->n) {
+    c->n = MAX(4096, c->n * 2);
+    c->buf = realloc(c->buf, c->n);
+  }
+}
+
+// reads more bytes into buffer, returning false on eof or error
+static bool Fill(struct Conn *c) {
+  ssize_t rc;
+  Reserve(c);
+  if (usessl) {
+    rc = mbedtls_ssl_read(&c->ssl, c->buf + c->i, c->n - c->i);
+  } else {
+    rc = read(c->sock, c->buf + c->i, c->n - c->i);
+  }
+  if (rc <= 0)
+    return false;
+  c->i += rc;
+  return true;
+}
+
+// removes bytes from front of buffer, keeping any pipelined responses
+static void Consume(struct Conn *c, size_t n) {
+  memmove(c->buf, c->buf + n, c->i - n);
+  c->i -= n;
+}
+
+static bool Receive(struct Conn *c, struct Response *res) {
+  ssize_t rc;
+  size_t hdrlen, paylen;
+  struct HttpUnchunker u;
+  for (;;) {
+    ResetHttpMessage(&c->msg, kHttpResponse);
+    for (;;) {
+      Reserve(c);  // parser fails if buffer is full
+      if ((rc = ParseHttpMessage(&c->msg, c->buf, c->i, c->n)))
+        break;
+      if (!Fill(c))
+        return false;
+    }
+    if (rc == -1)
+      return false;
+    hdrlen = rc;
+    if (c->msg.status >= 200)
+      break;
+    Consume(c, hdrlen);
+  }
+  res->status = c->msg.status;
+  res->keepalive =
+      c->msg.version >= 11 && !(HasHeader(kHttpConnection) &&
+                                HeaderEqualCase(kHttpConnection, "close"));
+  if (res->status == 204 || res->status == 304) {
+    res->size = hdrlen;
+    Consume(c, hdrlen);
+  } else if (HasHeader(kHttpTransferEncoding) &&
+             !HeaderEqualCase(kHttpTransferEncoding, "identity")) {
+    bzero(&u, sizeof(u));
+    while (!(rc = Unchunk(&u, c->buf + hdrlen, c->i - hdrlen, 0)))
+      if (!Fill(c))
+        return false;
+    if (rc == -1)
+      return false;
+    res->size = hdrlen + rc;
+    Consume(c, hdrlen + rc);
+  } else if (HasHeader(kHttpContentLength)) {
+    if ((rc = ParseContentLength(HeaderData(kHttpContentLength),
+                                 HeaderLength(kHttpContentLength))) == -1)
+      return false;
+    res->size = hdrlen + rc;
+    Consume(c, hdrlen);
+    // discard payload as it arrives so big assets don't grow the buffer
+    for (paylen = rc; c->i < paylen;) {
+      paylen -= c->i;
+      c->i = 0;
+      if (!Fill(c))
+        return false;
+    }
+    Consume(c, paylen);
+  } else {
+    res->keepalive = false;
+    res->size = c->i;
+    for (c->i = 0; Fill(c); c->i = 0)
+      res->size += c->i;
+  }
+  return true;
+}
+
+static void *Work(void *arg) {
+  long k, i, due;
+  struct Response res;
+  struct Conn c = {0};
+  struct Worker *w = arg;
+  w->stats.minns = LONG_MAX;
+  InitHttpMessage(&c.msg, kHttpResponse);
+  Connect(&c, true);
+  for (k = 0;; ++k) {
+    if (rate) {
+      due = start + ((double)k * connections + w->id) * depth * 1e9 / rate;
+      if (due >= deadline || a_finished)
+        break;
+      timespec_sleep_until(CLOCK_MONOTONIC, timespec_fromnanos(due));
+    } else {
+      due = Now();
+      if (due >= deadline || a_finished)
+        break;
+    }
+    if (!c.open) {
+      ++w->stats.reconnects;
+      if (!Connect(&c, false)) {
+        w->stats.errors += depth;
+        continue;
+      }
+    }
+    if (!Send(&c, request, requestlen)) {
+      w->stats.errors += depth;
+      Disconnect(&c);
+      continue;
+    }
+    for (i = 0; i < depth; ++i) {
+      if (!Receive(&c, &res)) {
+        w->stats.errors += depth - i;
+        Disconnect(&c);
+        break;
+      }
+      Record(&w->stats, Now() - due);
+      ++w->stats.requests;
+      w->stats.bytes += res.size;
+      if (res.status >= 400)
+        ++w->stats.failures;
+      if (!res.keepalive) {
+        w->stats.errors += depth - i - 1;
+        Disconnect(&c);
+        break;
+      }
+    }
+  }
+  Disconnect(&c);
+  DestroyHttpMessage(&c.msg);
+  free(c.buf);
+  return 0;
+}
+
+static void Merge(struct Stats *s, const struct Stats *x) {
+  int i;
+  s->requests += x->requests;
+  s->errors += x->errors;
+  s->failures += x->failures;
+  s->reconnects += x->reconnects;
+  s->bytes += x->bytes;
+  s->sumns += x->sumns;
+  s->minns = MIN(s->minns, x->minns);
+  s->maxns = MAX(s->maxns, x->maxns);
+  for (i = 0; i < kBuckets; ++i)
+    s->hist[i] += x->hist[i];
+}
+
+static void PrintHistogram(const struct Stats *s) {
+  char b1[32];
+  long groups[64] = {0};
+  int i, g, lo, hi, bar;
+  for (i = 0; i < kBuckets; ++i)
+    if (s->hist[i])
+      groups[BucketLow(i) ? bsrl(BucketLow(i)) : 0] += s->hist[i];
+  for (lo = 0; lo < 63 && !groups[lo]; ++lo) {
+  }
+  for (hi = 63; hi > lo && !groups[hi]; --hi) {
+  }
+  printf("\n");
+  for (g = lo; g <= hi; ++g) {
+    bar = lround(40. * groups[g] / s->requests);
+    printf("  %10s %-40.*s %6.2f%%\n", FormatNanos(b1, 1l << g), bar,
+           "########################################",
+           100. * groups[g] / s->requests);
+  }
+}
+
+static void PrintReport(const struct Stats *s, double elapsed) {
+  char b1[32], b2[32], b3[32], b4[32], b5[32], b6[32];
+  printf("  target     %s://%s:%s%s\n", usessl ? "https" : "http", host, port,
+         path);
+  printf("  load       %d connections, pipelining %d, ", connections, depth);
+  if (rate) {
+    printf("%g requests/s open loop, ", rate);
+  } else {
+    printf("closed loop, ");
+  }
+  printf("%.3gs\n", elapsed);
+  printf("  requests   %ld (%.1f/s), %ld errors, %ld failures, "
+         "%ld reconnects\n",
+         s->requests, s->requests / elapsed, s->errors, s->failures,
+         s->reconnects);
+  printf("  transfer   %s (%s/s)\n", FormatBytes(b1, s->bytes),
+         FormatBytes(b2, s->bytes / elapsed));
+  if (!s->requests)
+    return;
+  printf("  latency    min %s  p50 %s  p90 %s  p99 %s  p99.9 %s  max %s\n",
+         FormatNanos(b1, s->minns), FormatNanos(b2, Percentile(s, .5)),
+         FormatNanos(b3, Percentile(s, .9)), FormatNanos(b4, Percentile(s, .99)),
+         FormatNanos(b5, Percentile(s, .999)), FormatNanos(b6, s->maxns));
+  PrintHistogram(s);
+  if (getenv("BENCHMARK_JSON")) {
+    printf("{\"name\":\"loadgen %s %s -c%d -p%d -R%g\",\"iterations\":%ld"
+           ",\"ns_per_op\":%.17g,\"ns_median\":%ld,\"ns_p99\":%ld"
+           ",\"work_per_sec\":%.17g,\"errors\":%ld,\"failures\":%ld}\n",
+           method, path, connections, depth, rate, s->requests,
+           (double)s->sumns / s->requests, Percentile(s, .5),
+           Percentile(s, .99), s->requests / elapsed, s->errors, s->failures);
+  }
+}
+
+static void OnTerm(int sig) {
+  a_finished = true;
+}
+
+int main(int argc, char *argv[]) {
+
+  prog = argv[0];
+  if (!prog) {
+    prog = "loadgen";
+  }
+
+  /*
+   * Read flags.
+   */
+  int i, opt;
+  const struct Scenario *scenario = 0;
+  while ((opt = getopt(argc, argv, "hkc:d:p:R:H:b:s:")) != -1) {
+    switch (opt) {
+      case 'c':
+        connections = atoi(optarg);
+        break;
+      case 'd':
+        seconds = atoi(optarg);
+        break;
+      case 'p':
+        depth = atoi(optarg);
+        break;
+      case 'R':
+        rate = strtod(optarg, 0);
+        break;
+      case 'H':
+        headers.p = realloc(headers.p, ++headers.n * sizeof(*headers.p));
+        headers.p[headers.n - 1] = optarg;
+        break;
+      case 'b':
+        body = optarg;
+        break;
+      case 'k':
+        authmode = MBEDTLS_SSL_VERIFY_NONE;
+        break;
+      case 's':
+        for (i = 0; i < ARRAYLEN(kScenarios); ++i)
+          if (!strcmp(optarg, kScenarios[i].name))
+            scenario = kScenarios + i;
+        if (!scenario) {
+          tinyprint(2, prog, ": unknown scenario: ", optarg, "\n", NULL);
+          exit(1);
+        }
+        break;
+      case 'h':
+        PrintUsage(1, 0);
+      default:
+        PrintUsage(2, 1);
+    }
+  }
+  if (optind + 1 != argc)
+    PrintUsage(2, 1);
+  if (connections < 1 || depth < 1 || seconds < 1 || rate < 0) {
+    tinyprint(2, prog, ": -c -d -p must be positive\n", NULL);
+    exit(1);
+  }
+  if (scenario) {
+    path = strdup(scenario->path);
+    if (scenario->header) {
+      headers.p = realloc(headers.p, ++headers.n * sizeof(*headers.p));
+      headers.p[headers.n - 1] = (char *)scenario->header;
+    }
+  }
+  ParseTarget(argv[optind]);
+  if (scenario && scenario->post && !body) {
+    // have fetch.lua proxy a static asset from the same server
+    appendf(&body, "url=%s://%s:%s/index.html", usessl ? "https" : "http",
+            host, port);
+  }
+  if (body)
+    method = "POST";
+  BuildRequest();
+
+  /*
+   * Perform DNS lookup once.
+   */
+  struct addrinfo hints = {.ai_family = AF_UNSPEC,
+                           .ai_socktype = SOCK_STREAM,
+                           .ai_protocol = IPPROTO_TCP,
+                           .ai_flags = AI_NUMERICSERV};
+  if (getaddrinfo(host, port, &hints, &addr) != 0) {
+    tinyprint(2, prog, ": could not resolve host: ", host, "\n", NULL);
+    exit(1);
+  }
+
+  /*
+   * Run workers.
+   */
+  signal(SIGPIPE, SIG_IGN);
+  struct sigaction sa = {.sa_handler = OnTerm};
+  sigaction(SIGINT, &sa, 0);
+  sigaction(SIGTERM, &sa, 0);
+  struct Worker *workers = calloc(connections, sizeof(struct Worker));
+  start = Now();
+  deadline = start + seconds * 1000000000l;
+  for (i = 0; i < connections; ++i) {
+    workers[i].id = i;
+    if ((errno = pthread_create(&workers[i].th, 0, Work, workers + i))) {
+      perror("pthread_create");
+      exit(1);
+    }
+  }
+  struct Stats *total = calloc(1, sizeof(struct Stats));
+  total->minns = LONG_MAX;
+  for (i = 0; i < connections; ++i) {
+    if ((errno = pthread_join(workers[i].th, 0))) {
+      perror("pthread_join");
+      exit(1);
+    }
+    Merge(total, &workers[i].stats);
+  }
+  PrintReport(total, (Now() - start) * 1e-9);
+  int rc = total->errors ? 1 : 0;
+
+  /*
+   * Free memory.
+   */
+  freeaddrinfo(addr);
+  free(workers);
+  free(request);
+  free(total);
+  free(headers.p);
+  free(host);
+  free(port);
+  free(path);
+  return rc;
+}
@@ -21,11 +21,20 @@
 #include "third_party/lua/lauxlib.h"
 #include "third_party/regex/regex.h"
 
+#define kReCacheMax 32
+
 struct ReErrno {
   int err;
   char doc[64];
 };
 
+struct ReCached {
+  regex_t rx;  // must come first; gc'd as re.Regex
+  lua_Integer used;
+};
+
+static lua_Integer g_re_tick;
+
 static void LuaSetIntField(lua_State *L, const char *k, lua_Integer v) {
   lua_pushinteger(L, v);
   lua_setfield(L, -2, k);
@@ -41,10 +50,11 @@ static int LuaReReturnError(lua_State *L, regex_t *r, int rc) {
   return 2;
 }
 
-static regex_t *LuaReCompileImpl(lua_State *L, const char *p, int f) {
+static regex_t *LuaReCompileImpl(lua_State *L, const char *p, int f,
+                                 size_t size) {
   int rc;
   regex_t *r;
-  r = lua_newuserdatauv(L, sizeof(regex_t), 0);
+  r = lua_newuserdatauv(L, size, 0);
   luaL_setmetatable(L, "re.Regex");
   f &= REG_EXTENDED | REG_ICASE | REG_NEWLINE | REG_NOSUB;
   f ^= REG_EXTENDED;
@@ -74,6 +84,59 @@ static int LuaReSearchImpl(lua_State *L, regex_t *r, const char *s, int f) {
   }
 }
 
+// evicts least recently used regex from cache table at top of stack
+static void LuaReEvict(lua_State *L) {
+  int n;
+  struct ReCached *c;
+  lua_Integer oldest;
+  n = 0;
+  oldest = 0;
+  lua_pushnil(L);  // victim key
+  lua_pushnil(L);
+  while (lua_next(L, -3)) {
+    c = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+    if (!n++ || c->used < oldest) {
+      oldest = c->used;
+      lua_pushvalue(L, -1);
+      lua_replace(L, -3);
+    }
+  }
+  if (n >= kReCacheMax) {
+    lua_pushnil(L);
+    lua_rawset(L, -3);
+  } else {
+    lua_pop(L, 1);
+  }
+}
+
+// returns compiled regex for (pattern, flags) reusing recent compiles
+// otherwise pushes nil and re.Errno and returns null
+static regex_t *LuaReCompileCached(lua_State *L, const char *p, int f) {
+  struct ReCached *c;
+  f &= REG_EXTENDED | REG_ICASE | REG_NEWLINE | REG_NOSUB;
+  luaL_getsubtable(L, LUA_REGISTRYINDEX, "re.Cache");
+  lua_pushfstring(L, "%d:%s", f, p);
+  lua_pushvalue(L, -1);
+  if (lua_rawget(L, -3) == LUA_TUSERDATA) {
+    c = lua_touserdata(L, -1);
+    c->used = ++g_re_tick;
+    return &c->rx;
+  }
+  lua_pop(L, 2);
+  LuaReEvict(L);
+  lua_pushfstring(L, "%d:%s", f, p);
+  if (!(c = (struct ReCached *)LuaReCompileImpl(L, p, f,
+                                                 sizeof(struct ReCached)))) {
+    return NULL;
+  }
+  c->used = ++g_re_tick;
+  lua_pushvalue(L, -2);
+  lua_pushvalue(L, -2);
+  lua_rawset(L, -5);
+  return &c->rx;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // re
 
@@ -89,7 +152,7 @@ static int LuaReSearch(lua_State *L) {
     luaL_argerror(L, 3, "invalid flags");
     __builtin_unreachable();
   }
-  if ((r = LuaReCompileImpl(L, p, f))) {
+  if ((r = LuaReCompileCached(L, p, f))) {
     return LuaReSearchImpl(L, r, s, f);
   } else {
     return 2;
@@ -106,7 +169,7 @@ static int LuaReCompile(lua_State *L) {
     luaL_argerror(L, 2, "invalid flags");
     __builtin_unreachable();
   }
-  if ((r = LuaReCompileImpl(L, p, f))) {
+  if ((r = LuaReCompileImpl(L, p, f, sizeof(regex_t)))) {
     return 1;
   } else {
     return 2;
@@ -0,0 +1,346 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/calls.h"
+#include "libc/calls/struct/timeval.h"
+#include "third_party/hiredis/hiredis.h"
+#include "third_party/lua/lauxlib.h"
+#include "third_party/lua/lua.h"
+#include "tool/net/lfuncs.h"
+
+#define LUA_REDIS_ARGS 16
+
+struct RedisConn {
+  int pid;               /* process that connected, since workers fork */
+  lua_Integer pending;   /* number of appended commands without replies */
+  redisContext *c;
+};
+
+// connections opened before fork() mustn't interleave on one socket
+static void ReviveRedisConn(struct RedisConn *rc) {
+  if (rc->pid != getpid()) {
+    rc->pid = getpid();
+    rc->pending = 0;
+    redisReconnect(rc->c);
+  }
+}
+
+static struct RedisConn *GetRedisConn(lua_State *L) {
+  struct RedisConn *rc;
+  rc = luaL_checkudata(L, 1, "redis.Conn");
+  if (!rc->c)
+    luaL_error(L, "redis connection is closed");
+  ReviveRedisConn(rc);
+  return rc;
+}
+
+static void CloseRedisConn(struct RedisConn *rc) {
+  if (rc->c) {
+    redisFree(rc->c);
+    rc->c = 0;
+  }
+  rc->pending = 0;
+}
+
+static int LuaRedisError(lua_State *L, struct RedisConn *rc) {
+  lua_pushnil(L);
+  lua_pushstring(L, rc->c->errstr[0] ? rc->c->errstr : "redis i/o error");
+  CloseRedisConn(rc);
+  return 2;
+}
+
+static void LuaRedisPushReply(lua_State *, redisReply *);
+
+// pushes reply that's an element of an array, where nil would be a hole
+static void LuaRedisPushElement(lua_State *L, redisReply *r) {
+  if (r->type == REDIS_REPLY_NIL) {
+    lua_pushboolean(L, false);
+  } else {
+    LuaRedisPushReply(L, r);
+  }
+}
+
+static void LuaRedisPushReply(lua_State *L, redisReply *r) {
+  size_t i;
+  switch (r->type) {
+    case REDIS_REPLY_STRING:
+    case REDIS_REPLY_STATUS:
+    case REDIS_REPLY_BIGNUM:
+    case REDIS_REPLY_VERB:
+      lua_pushlstring(L, r->str, r->len);
+      break;
+    case REDIS_REPLY_INTEGER:
+      lua_pushinteger(L, r->integer);
+      break;
+    case REDIS_REPLY_DOUBLE:
+      lua_pushnumber(L, r->dval);
+      break;
+    case REDIS_REPLY_BOOL:
+      lua_pushboolean(L, !!r->integer);
+      break;
+    case REDIS_REPLY_ERROR:
+      // only reached for nested error replies, e.g. inside EXEC
+      lua_createtable(L, 0, 1);
+      lua_pushlstring(L, r->str, r->len);
+      lua_setfield(L, -2, "err");
+      break;
+    case REDIS_REPLY_ARRAY:
+    case REDIS_REPLY_SET:
+    case REDIS_REPLY_PUSH:
+      lua_createtable(L, r->elements, 0);
+      for (i = 0; i < r->elements; ++i) {
+        LuaRedisPushElement(L, r->element[i]);
+        lua_rawseti(L, -2, i + 1);
+      }
+      break;
+    case REDIS_REPLY_MAP:
+    case REDIS_REPLY_ATTR:
+      lua_createtable(L, 0, r->elements / 2);
+      for (i = 0; i + 1 < r->elements; i += 2) {
+        LuaRedisPushElement(L, r->element[i]);
+        LuaRedisPushElement(L, r->element[i + 1]);
+        lua_rawset(L, -3);
+      }
+      break;
+    default:
+      lua_pushnil(L);
+      break;
+  }
+}
+
+// pushes reply and returns 1, or pushes nil and error and returns 2
+static int LuaRedisReturnReply(lua_State *L, redisReply *r) {
+  int n;
+  if (r->type == REDIS_REPLY_ERROR) {
+    lua_pushnil(L);
+    lua_pushlstring(L, r->str, r->len);
+    n = 2;
+  } else {
+    LuaRedisPushReply(L, r);
+    n = 1;
+  }
+  freeReplyObject(r);
+  return n;
+}
+
+// appends command whose arguments are at stack[i..j] to output buffer
+static int LuaRedisAppend(lua_State *L, struct RedisConn *rc, int i, int j) {
+  int k, n, rv;
+  const char **argv, *argvbuf[LUA_REDIS_ARGS];
+  size_t *argvlen, argvlenbuf[LUA_REDIS_ARGS];
+  if ((n = j - i + 1) <= 0)
+    luaL_error(L, "redis command expected");
+  if (n <= LUA_REDIS_ARGS) {
+    argv = argvbuf;
+    argvlen = argvlenbuf;
+  } else {
+    argv = lua_newuserdatauv(L, n * (sizeof(*argv) + sizeof(*argvlen)), 0);
+    argvlen = (size_t *)(argv + n);
+  }
+  for (k = 0; k < n; ++k)
+    argv[k] = luaL_checklstring(L, i + k, argvlen + k);
+  rv = redisAppendCommandArgv(rc->c, n, argv, argvlen);
+  if (n > LUA_REDIS_ARGS)
+    lua_pop(L, 1);
+  if (rv == REDIS_OK)
+    ++rc->pending;
+  return rv;
+}
+
+// redis.connect(host:str[, port:int[, timeout_ms:int]])
+//     ├─→ conn:redis.Conn
+//     └─→ nil, error:str
+static int LuaRedisConnect(lua_State *L) {
+  int port;
+  const char *host;
+  struct timeval tv;
+  redisContext *c;
+  lua_Integer timeout;
+  struct RedisConn *rc;
+  host = luaL_checkstring(L, 1);
+  port = luaL_optinteger(L, 2, 6379);
+  timeout = luaL_optinteger(L, 3, 0);
+  lua_settop(L, 3);
+
+  // reuse the connection this worker already has open to this server
+  lua_getfield(L, LUA_REGISTRYINDEX, "redis.Pool");
+  lua_pushfstring(L, "%s:%d", host, port);
+  lua_pushvalue(L, -1);
+  lua_rawget(L, 4);
+  if ((rc = luaL_testudata(L, -1, "redis.Conn")) && rc->c) {
+    ReviveRedisConn(rc);
+    if (!rc->c->err && !rc->pending)
+      return 1;
+  }
+  lua_pop(L, 1);
+
+  tv.tv_sec = timeout / 1000;
+  tv.tv_usec = timeout % 1000 * 1000;
+  if (*host == '/') {
+    c = timeout ? redisConnectUnixWithTimeout(host, tv)
+                : redisConnectUnix(host);
+  } else {
+    c = timeout ? redisConnectWithTimeout(host, port, tv)
+                : redisConnect(host, port);
+  }
+  if (!c || c->err) {
+    lua_pushnil(L);
+    lua_pushstring(L, c ? c->errstr : "out of memory");
+    if (c)
+      redisFree(c);
+    return 2;
+  }
+  if (timeout)
+    redisSetTimeout(c, tv);
+  if (*host != '/')
+    redisEnableKeepAlive(c);
+  rc = lua_newuserdatauv(L, sizeof(*rc), 0);
+  luaL_setmetatable(L, "redis.Conn");
+  rc->pid = getpid();
+  rc->pending = 0;
+  rc->c = c;
+  lua_pushvalue(L, -2);
+  lua_pushvalue(L, -2);
+  lua_rawset(L, 4);
+  return 1;
+}
+
+// redis.Conn:command(arg:str, ...)
+//     ├─→ reply:str|int|number|bool|table
+//     └─→ nil, error:str
+static int LuaRedisCommand(lua_State *L) {
+  redisReply *r;
+  struct RedisConn *rc;
+  rc = GetRedisConn(L);
+  if (rc->pending)
+    luaL_error(L, "redis command issued with %d replies pending",
+               (int)rc->pending);
+  if (LuaRedisAppend(L, rc, 2, lua_gettop(L)) != REDIS_OK ||
+      redisGetReply(rc->c, (void **)&r) != REDIS_OK)
+    return LuaRedisError(L, rc);
+  --rc->pending;
+  return LuaRedisReturnReply(L, r);
+}
+
+// redis.Conn:append(arg:str, ...)
+//     ├─→ true
+//     └─→ nil, error:str
+static int LuaRedisAppendCommand(lua_State *L) {
+  struct RedisConn *rc;
+  rc = GetRedisConn(L);
+  if (LuaRedisAppend(L, rc, 2, lua_gettop(L)) != REDIS_OK)
+    return LuaRedisError(L, rc);
+  lua_pushboolean(L, true);
+  return 1;
+}
+
+// redis.Conn:getreply()
+//     ├─→ reply:str|int|number|bool|table
+//     └─→ nil, error:str
+static int LuaRedisGetReply(lua_State *L) {
+  redisReply *r;
+  struct RedisConn *rc;
+  rc = GetRedisConn(L);
+  if (!rc->pending)
+    luaL_error(L, "no redis replies are pending");
+  if (redisGetReply(rc->c, (void **)&r) != REDIS_OK)
+    return LuaRedisError(L, rc);
+  --rc->pending;
+  return LuaRedisReturnReply(L, r);
+}
+
+// redis.Conn:pipeline({{arg:str, ...}, ...})
+//     ├─→ {reply, ...}
+//     └─→ nil, error:str
+static int LuaRedisPipeline(lua_State *L) {
+  redisReply *r;
+  struct RedisConn *rc;
+  lua_Integer i, j, n, m;
+  rc = GetRedisConn(L);
+  luaL_checktype(L, 2, LUA_TTABLE);
+  lua_settop(L, 2);
+  if (rc->pending)
+    luaL_error(L, "redis pipeline issued with %d replies pending",
+               (int)rc->pending);
+  n = luaL_len(L, 2);
+  for (i = 1; i <= n; ++i) {
+    lua_rawgeti(L, 2, i);
+    luaL_checktype(L, 3, LUA_TTABLE);
+    m = luaL_len(L, 3);
+    luaL_checkstack(L, m, "too many redis arguments");
+    for (j = 1; j <= m; ++j)
+      lua_rawgeti(L, 3, j);
+    if (LuaRedisAppend(L, rc, 4, 3 + m) != REDIS_OK)
+      return LuaRedisError(L, rc);
+    lua_settop(L, 2);
+  }
+  // everything is written here, and then read back in one round trip
+  lua_createtable(L, n, 0);
+  for (i = 1; i <= n; ++i) {
+    if (redisGetReply(rc->c, (void **)&r) != REDIS_OK)
+      return LuaRedisError(L, rc);
+    --rc->pending;
+    LuaRedisPushElement(L, r);
+    freeReplyObject(r);
+    lua_rawseti(L, -2, i);
+  }
+  return 1;
+}
+
+// redis.Conn:close()
+static int LuaRedisClose(lua_State *L) {
+  CloseRedisConn(luaL_checkudata(L, 1, "redis.Conn"));
+  return 0;
+}
+
+static const luaL_Reg kLuaRedis[] = {
+    {"connect", LuaRedisConnect},  //
+    {0},                           //
+};
+
+static const luaL_Reg kLuaRedisConnMeth[] = {
+    {"command", LuaRedisCommand},         //
+    {"append", LuaRedisAppendCommand},    //
+    {"getreply", LuaRedisGetReply},       //
+    {"pipeline", LuaRedisPipeline},       //
+    {"close", LuaRedisClose},             //
+    {0},                                  //
+};
+
+static const luaL_Reg kLuaRedisConnMeta[] = {
+    {"__gc", LuaRedisClose},     //
+    {"__close", LuaRedisClose},  //
+    {0},                         //
+};
+
+static void LuaRedisConnObj(lua_State *L) {
+  luaL_newmetatable(L, "redis.Conn");
+  luaL_setfuncs(L, kLuaRedisConnMeta, 0);
+  luaL_newlibtable(L, kLuaRedisConnMeth);
+  luaL_setfuncs(L, kLuaRedisConnMeth, 0);
+  lua_setfield(L, -2, "__index");
+  lua_pop(L, 1);
+}
+
+int LuaRedis(lua_State *L) {
+  lua_newtable(L);
+  lua_setfield(L, LUA_REGISTRYINDEX, "redis.Pool");
+  luaL_newlib(L, kLuaRedis);
+  LuaRedisConnObj(L);
+  return 1;
+}
@@ -77,6 +77,7 @@ typedef struct sdb sdb;
 typedef struct sdb_vm sdb_vm;
 typedef struct sdb_bu sdb_bu;
 typedef struct sdb_func sdb_func;
+typedef struct sdb_stmt sdb_stmt;
 
 /* to use as C user data so i know what function sqlite is calling */
 struct sdb_func {
@@ -91,6 +92,15 @@ struct sdb_func {
     sdb_func *next;
 };
 
+/* idle prepared statement, keyed by the sql text it was prepared from */
+struct sdb_stmt {
+    char *sql;
+    int len;
+    int tail;               /* offset of the unparsed remainder of sql */
+    unsigned used;          /* lru stamp */
+    sqlite3_stmt *vm;
+};
+
 /* information about database */
 struct sdb {
     /* associated lua state */
@@ -116,6 +126,12 @@ struct sdb {
 
     int rollback_hook_cb; /* rollback_hook callback */
     int rollback_hook_udata;
+
+    /* prepared statement cache; disabled when stmts_max is zero */
+    sdb_stmt *stmts;
+    int stmts_max;
+    int stmts_count;
+    unsigned stmts_used;
 };
 
 static const char *const sqlite_meta      = ":sqlite3";
@@ -175,8 +191,93 @@ struct sdb_vm {
     char has_values;        /* true when step succeeds */
 
     char temp;              /* temporary vm used in db:rows */
+
+    /* statement cache key; vm goes back to the cache instead of finalize */
+    char *key;
+    int keylen;
+    int tail;
 };
 
+/*
+** =======================================================
+** Prepared Statement Cache
+** =======================================================
+*/
+
+static void dropstmt(sdb *db, int i) {
+    sqlite3_finalize(db->stmts[i].vm);
+    free(db->stmts[i].sql);
+    db->stmts[i] = db->stmts[--db->stmts_count];
+}
+
+static void dropstmts(sdb *db) {
+    while (db->stmts_count)
+        dropstmt(db, db->stmts_count - 1);
+}
+
+/* removes statement for sql from cache, already reset and unbound */
+static sqlite3_stmt *takestmt(sdb *db, const char *sql, int len, int *tail) {
+    int i;
+    sqlite3_stmt *vm;
+    for (i = 0; i < db->stmts_count; ++i) {
+        if (db->stmts[i].len == len && !memcmp(db->stmts[i].sql, sql, len)) {
+            vm = db->stmts[i].vm;
+            *tail = db->stmts[i].tail;
+            free(db->stmts[i].sql);
+            db->stmts[i] = db->stmts[--db->stmts_count];
+            sqlite3_clear_bindings(vm);
+            return vm;
+        }
+    }
+    return NULL;
+}
+
+/* resets vm and hands it to the cache, evicting the least recently used
+** statement if full; takes ownership of sql and returns sqlite3_reset() */
+static int givestmt(sdb *db, sqlite3_stmt *vm, char *sql, int len, int tail) {
+    int i, j, rc;
+    rc = sqlite3_reset(vm);
+    if (!db->db || !db->stmts_max) {
+        sqlite3_finalize(vm);
+        free(sql);
+        return rc;
+    }
+    if (db->stmts_count == db->stmts_max) {
+        for (j = 0, i = 1; i < db->stmts_count; ++i)
+            if (db->stmts_used - db->stmts[i].used >
+                db->stmts_used - db->stmts[j].used)
+                j = i;
+        dropstmt(db, j);
+    }
+    i = db->stmts_count++;
+    db->stmts[i].sql = sql;
+    db->stmts[i].len = len;
+    db->stmts[i].tail = tail;
+    db->stmts[i].used = ++db->stmts_used;
+    db->stmts[i].vm = vm;
+    return rc;
+}
+
+/* prepares sql, consulting the cache first if it's enabled */
+static int preparestmt(sdb *db, sdb_vm *svm, const char *sql, int len, int *tail) {
+    int rc;
+    const char *sqltail;
+    if (db->stmts_max && (svm->vm = takestmt(db, sql, len, tail))) {
+        rc = SQLITE_OK;
+    } else {
+        rc = sqlite3_prepare_v2(db->db, sql, len, &svm->vm, &sqltail);
+        if (rc != SQLITE_OK) return rc;
+        *tail = sqltail - sql;
+    }
+    if (db->stmts_max && svm->vm && (svm->key = malloc(len + 1))) {
+        memcpy(svm->key, sql, len);
+        svm->key[len] = 0;
+        svm->keylen = len;
+        svm->tail = *tail;
+    }
+    return rc;
+}
+
 /* called with db,sql text on the lua stack */
 static sdb_vm *newvm(lua_State *L, sdb *db) {
     sdb_vm *svm = (sdb_vm*)lua_newuserdata(L, sizeof(sdb_vm)); /* db sql svm_ud -- */
@@ -189,6 +290,9 @@ static sdb_vm *newvm(lua_State *L, sdb *db) {
     svm->has_values = 0;
     svm->vm = NULL;
     svm->temp = 0;
+    svm->key = NULL;
+    svm->keylen = 0;
+    svm->tail = 0;
 
     /* add an entry on the database table: svm -> db to keep db live while svm is live */
     lua_pushlightuserdata(L, db);     /* db sql svm_ud db_lud -- */
@@ -201,13 +305,24 @@ static sdb_vm *newvm(lua_State *L, sdb *db) {
     return svm;
 }
 
+static int releasevm(sdb_vm *svm) {
+    int rc;
+    if (svm->key) {
+        rc = givestmt(svm->db, svm->vm, svm->key, svm->keylen, svm->tail);
+        svm->key = NULL;
+    } else {
+        rc = sqlite3_finalize(svm->vm);
+    }
+    svm->vm = NULL;
+    return rc;
+}
+
 static int cleanupvm(lua_State *L, sdb_vm *svm) {
     svm->columns = 0;
     svm->has_values = 0;
 
     if (!svm->vm) return 0;
-    lua_pushinteger(L, sqlite3_finalize(svm->vm));
-    svm->vm = NULL;
+    lua_pushinteger(L, releasevm(svm));
     return 1;
 }
 
@@ -611,6 +726,11 @@ static sdb *newdb (lua_State *L) {
     db->rollback_hook_udata =
         LUA_NOREF;
 
+    db->stmts = NULL;
+    db->stmts_max = 0;
+    db->stmts_count = 0;
+    db->stmts_used = 0;
+
     luaL_getmetatable(L, sqlite_meta);
     lua_setmetatable(L, -2);        /* set metatable */
 
@@ -650,6 +770,10 @@ static int cleanupdb(lua_State *L, sdb *db) {
     if (!db->db) return SQLITE_MISUSE;
 
     closevms(L, db, 0);
+    dropstmts(db);
+    free(db->stmts);
+    db->stmts = NULL;
+    db->stmts_max = 0;
 
     /* remove entry in lua registry table */
     lua_pushlightuserdata(L, db);
@@ -1562,6 +1686,25 @@ static int db_exec_callback(void* user, int columns, char **data, char **names)
     return result;
 }
 
+/* runs each statement of sql through the statement cache */
+static int db_exec_cached(sdb *db, const char *sql, int len) {
+    int tail, result;
+    sdb_vm tmp = {db};
+    while (len > 0) {
+        result = preparestmt(db, &tmp, sql, len, &tail);
+        if (result != SQLITE_OK) return result;
+        if (tmp.vm) {
+            while ((result = sqlite3_step(tmp.vm)) == SQLITE_ROW) {
+            }
+            if (releasevm(&tmp) != SQLITE_OK) return sqlite3_errcode(db->db);
+        }
+        if (!tail) break;
+        sql += tail;
+        len -= tail;
+    }
+    return SQLITE_OK;
+}
+
 static int db_exec(lua_State *L) {
     sdb *db = lsqlite_checkdb(L, 1);
     const char *sql = luaL_checkstring(L, 2);
@@ -1581,6 +1724,9 @@ static int db_exec(lua_State *L) {
 
         result = sqlite3_exec(db->db, sql, db_exec_callback, L, NULL);
     }
+    else if (db->stmts_max) {
+        result = db_exec_cached(db, sql, lua_rawlen(L, 2));
+    }
     else {
         /* no callbacks */
         result = sqlite3_exec(db->db, sql, NULL, NULL, NULL);
@@ -1598,12 +1744,12 @@ static int db_prepare(lua_State *L) {
     sdb *db = lsqlite_checkdb(L, 1);
     const char *sql = luaL_checkstring(L, 2);
     int sql_len = lua_rawlen(L, 2);
-    const char *sqltail;
+    int sqltail;
     sdb_vm *svm;
     lua_settop(L,2); /* db,sql is on top of stack for call to newvm */
     svm = newvm(L, db);
 
-    if (sqlite3_prepare_v2(db->db, sql, sql_len, &svm->vm, &sqltail) != SQLITE_OK) {
+    if (preparestmt(db, svm, sql, sql_len, &sqltail) != SQLITE_OK) {
         lua_pushnil(L);
         lua_pushinteger(L, sqlite3_errcode(db->db));
         if (cleanupvm(L, svm) == 1)
@@ -1612,7 +1758,7 @@ static int db_prepare(lua_State *L) {
     }
 
     /* vm already in the stack */
-    lua_pushstring(L, sqltail);
+    lua_pushstring(L, sql + sqltail);
     return 2;
 }
 
@@ -1657,8 +1803,7 @@ static int db_do_next_row(lua_State *L, int packed) {
 
     if (svm->temp) {
         /* finalize and check for errors */
-        result = sqlite3_finalize(vm);
-        svm->vm = NULL;
+        result = releasevm(svm);
         cleanupvm(L, svm);
     }
     else if (result == SQLITE_DONE) {
@@ -1708,12 +1853,14 @@ static int dbvm_urows(lua_State *L) {
 static int db_do_rows(lua_State *L, int(*f)(lua_State *)) {
     sdb *db = lsqlite_checkdb(L, 1);
     const char *sql = luaL_checkstring(L, 2);
+    int sql_len = lua_rawlen(L, 2);
+    int sqltail;
     sdb_vm *svm;
     lua_settop(L,2); /* db,sql is on top of stack for call to newvm */
     svm = newvm(L, db);
     svm->temp = 1;
 
-    if (sqlite3_prepare_v2(db->db, sql, -1, &svm->vm, NULL) != SQLITE_OK) {
+    if (preparestmt(db, svm, sql, sql_len, &sqltail) != SQLITE_OK) {
         lua_pushstring(L, sqlite3_errmsg(svm->db->db));
         if (cleanupvm(L, svm) == 1)
             lua_pop(L, 1); /* this should not happen since sqlite3_prepare_v2 will not set ->vm on error */
@@ -1755,6 +1902,30 @@ static int db_close(lua_State *L) {
     return 1;
 }
 
+/*
+** Params: db, size
+** returns: previous size
+*/
+static int db_cache_statements(lua_State *L) {
+    sdb *db = lsqlite_checkdb(L, 1);
+    int size = luaL_optinteger(L, 2, 16);
+    sdb_stmt *stmts;
+    luaL_argcheck(L, 0 <= size && size <= 1024, 2, "size out of range");
+    lua_pushinteger(L, db->stmts_max);
+    while (db->stmts_count > size)
+        dropstmt(db, db->stmts_count - 1);
+    if (!size) {
+        free(db->stmts);
+        db->stmts = NULL;
+    } else if ((stmts = realloc(db->stmts, size * sizeof(*stmts)))) {
+        db->stmts = stmts;
+    } else {
+        return luaL_error(L, "out of memory");
+    }
+    db->stmts_max = size;
+    return 1;
+}
+
 static int db_close_vm(lua_State *L) {
     sdb *db = lsqlite_checkdb(L, 1);
     closevms(L, db, lua_toboolean(L, 2));
@@ -2405,12 +2576,22 @@ static int lsqlite_version(lua_State *L) {
 }
 
 static int lsqlite_do_open(lua_State *L, const char *filename, int flags) {
+    const char *vfs = 0;
     sqlite3_initialize(); /* initialize the engine if hasn't been done yet */
     sdb *db = newdb(L); /* create and leave in stack */
 
-    if (sqlite3_open_v2(filename, &db->db, flags, 0) == SQLITE_OK) {
+    /* databases inside the executable are read in place, without locks */
+    if (sqlite3_zipvfs_register() == SQLITE_OK && startswith(filename, "/zip/")) {
+        vfs = "zipos";
+    }
+
+    if (sqlite3_open_v2(filename, &db->db, flags, vfs) == SQLITE_OK) {
         /* database handle already in the stack - return it */
         sqlite3_zipfile_init(db->db, 0, 0);
+        if (vfs) {
+            /* let the pager use the zip mapping instead of copying pages */
+            sqlite3_exec(db->db, "PRAGMA mmap_size=2147418112", 0, 0, 0);
+        }
         return 1;
     }
 
@@ -2652,6 +2833,7 @@ static const luaL_Reg dblib[] = {
     {"execute",             db_exec                 },
     {"close",               db_close                },
     {"close_vm",            db_close_vm             },
+    {"cache_statements",    db_cache_statements     },
 
 #ifdef SQLITE_ENABLE_SESSION
     {"create_session",      db_create_session       },
@@ -2811,6 +2993,11 @@ LUALIB_API int luaopen_lsqlite3(lua_State *L) {
     /* call config before calling initialize */
     sqlite3_config(SQLITE_CONFIG_LOG, log_callback, L);
 
+    /* don't have each connection bulk allocate its page cache up front,
+       since forked workers tend to open short lived connections that
+       only touch a few pages, or get them from mmap() */
+    sqlite3_config(SQLITE_CONFIG_PAGECACHE, 0, 0, 0);
+
     create_meta(L, sqlite_meta, dblib);
     create_meta(L, sqlite_vm_meta, vmlib);
     create_meta(L, sqlite_ctx_meta, ctxlib);
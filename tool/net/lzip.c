@@ -18,17 +18,21 @@
 ╚─────────────────────────────────────────────────────────────────────────────*/
 #include "tool/net/lzip.h"
 #include "libc/calls/calls.h"
+#include "libc/calls/struct/stat.h"
 #include "libc/calls/struct/timespec.h"
 #include "libc/cosmo.h"
 #include "libc/dos.h"
 #include "libc/errno.h"
 #include "libc/limits.h"
+#include "libc/macros.h"
+#include "libc/mem/alg.h"
 #include "libc/mem/mem.h"
 #include "libc/runtime/runtime.h"
 #include "libc/str/str.h"
 #include "libc/sysv/consts/map.h"
 #include "libc/sysv/consts/o.h"
 #include "libc/sysv/consts/prot.h"
+#include "libc/sysv/consts/s.h"
 #include "libc/time.h"
 #include "libc/zip.h"
 #include "net/http/http.h"
@@ -51,6 +55,13 @@ struct LuaZipReader {
   int64_t file_size;
   int64_t max_file_size;
   const uint8_t *data;  // non-NULL when reading from buffer (uservalue 1)
+  struct LuaZipSlot *index;  // built on first lookup
+  size_t index_mask;
+};
+
+struct LuaZipSlot {
+  uint32_t hash;
+  uint32_t off;  // cdir offset plus one, or zero if empty
 };
 
 struct LuaZipCdirEntry {
@@ -127,24 +138,58 @@ static int WriterSysError(lua_State *L, struct LuaZipWriter *w,
   return SysError(L, what);
 }
 
-static uint8_t *FindEntry(struct LuaZipReader *z, const char *name,
-                          size_t namelen) {
-  int64_t i, got, hdrsize;
+// Hashes every central directory entry name so lookups take O(1).
+// Entries after any corruption are left out, and duplicate names keep
+// the first entry, which is what a linear scan would have found.
+static bool IndexEntries(struct LuaZipReader *z) {
+  uint32_t h;
+  size_t j, cap;
+  int64_t i, n, got, hdrsize;
+  n = MIN(z->count, z->cdir_size / kZipCfileHdrMinSize);
+  cap = 16;
+  while ((int64_t)cap < n * 2)
+    cap <<= 1;
+  if (!(z->index = calloc(cap, sizeof(*z->index))))
+    return false;
+  z->index_mask = cap - 1;
   for (i = got = 0;
        i + kZipCfileHdrMinSize <= z->cdir_size && got < z->count;
        i += hdrsize, ++got) {
     if (ZIP_CFILE_MAGIC(z->cdir + i) != kZipCfileHdrMagic)
-      return NULL;
+      break;
     hdrsize = ZIP_CFILE_HDRSIZE(z->cdir + i);
     if (hdrsize < kZipCfileHdrMinSize || i + hdrsize > z->cdir_size)
-      return NULL;
-    const char *entry_name = ZIP_CFILE_NAME(z->cdir + i);
-    int entry_namelen = ZIP_CFILE_NAMESIZE(z->cdir + i);
-    if (entry_namelen == (int)namelen &&
-        !memcmp(entry_name, name, namelen)) {
-      return z->cdir + i;
+      break;
+    const char *name = ZIP_CFILE_NAME(z->cdir + i);
+    int namelen = ZIP_CFILE_NAMESIZE(z->cdir + i);
+    h = cosmo_hash(name, namelen);
+    for (j = h & z->index_mask; z->index[j].off; j = (j + 1) & z->index_mask) {
+      const uint8_t *e = z->cdir + z->index[j].off - 1;
+      if (z->index[j].hash == h && ZIP_CFILE_NAMESIZE(e) == namelen &&
+          !memcmp(ZIP_CFILE_NAME(e), name, namelen))
+        break;
+    }
+    if (!z->index[j].off) {
+      z->index[j].hash = h;
+      z->index[j].off = i + 1;
     }
   }
+  return true;
+}
+
+static uint8_t *FindEntry(struct LuaZipReader *z, const char *name,
+                          size_t namelen) {
+  size_t j;
+  uint32_t h;
+  if (!z->index && !IndexEntries(z))
+    return NULL;
+  h = cosmo_hash(name, namelen);
+  for (j = h & z->index_mask; z->index[j].off; j = (j + 1) & z->index_mask) {
+    uint8_t *e = z->cdir + z->index[j].off - 1;
+    if (z->index[j].hash == h && ZIP_CFILE_NAMESIZE(e) == namelen &&
+        !memcmp(ZIP_CFILE_NAME(e), name, namelen))
+      return e;
+  }
   return NULL;
 }
 
@@ -259,6 +304,8 @@ static int LuaZipOpen(lua_State *L) {
   z->file_size = 0;
   z->max_file_size = 0;
   z->data = NULL;
+  z->index = NULL;
+  z->index_mask = 0;
 
   // allocate and copy central directory
   uint8_t *cdir = malloc(cdir_size ? cdir_size : 1);
@@ -342,6 +389,8 @@ static int LuaZipFrom(lua_State *L) {
   z->file_size = 0;
   z->max_file_size = 0;
   z->data = NULL;
+  z->index = NULL;
+  z->index_mask = 0;
 
   // allocate and copy central directory
   uint8_t *cdir = malloc(cdir_size ? cdir_size : 1);
@@ -373,6 +422,8 @@ static int LuaZipReaderClose(lua_State *L) {
     free(z->cdir);
     z->cdir = NULL;
   }
+  free(z->index);
+  z->index = NULL;
   z->data = NULL;  // uservalue will be GC'd
   return 0;
 }
@@ -447,19 +498,8 @@ static int LuaZipReaderStat(lua_State *L) {
   return 1;
 }
 
-// reader:read(name) -> string | nil, error
-static int LuaZipReaderRead(lua_State *L) {
-  struct LuaZipReader *z = GetZipReader(L);
-  size_t namelen;
-  const char *name = luaL_checklstring(L, 2, &namelen);
-
-  if (z->fd == -1 && !z->data)
-    return ZipError(L, "zip reader is closed");
-
-  uint8_t *cfile = FindEntry(z, name, namelen);
-  if (!cfile)
-    return ZipError(L, "entry not found");
-
+// pushes contents of central directory entry, or nil and error
+static int ReadEntry(lua_State *L, struct LuaZipReader *z, uint8_t *cfile) {
   int64_t lfile_off = GetZipCfileOffset(cfile);
   int64_t compressed_size = GetZipCfileCompressedSize(cfile);
   int64_t uncompressed_size = GetZipCfileUncompressedSize(cfile);
@@ -555,6 +595,76 @@ static int LuaZipReaderRead(lua_State *L) {
   }
 }
 
+// reader:read(name) -> string | nil, error
+static int LuaZipReaderRead(lua_State *L) {
+  struct LuaZipReader *z = GetZipReader(L);
+  size_t namelen;
+  const char *name = luaL_checklstring(L, 2, &namelen);
+
+  if (z->fd == -1 && !z->data)
+    return ZipError(L, "zip reader is closed");
+
+  uint8_t *cfile = FindEntry(z, name, namelen);
+  if (!cfile)
+    return ZipError(L, "entry not found");
+
+  return ReadEntry(L, z, cfile);
+}
+
+struct LuaZipRequest {
+  uint8_t *cfile;
+  int64_t offset;
+  lua_Integer idx;
+};
+
+static int CompareRequests(const void *a, const void *b) {
+  const struct LuaZipRequest *x = a, *y = b;
+  return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+// reader:read_many({name, ...}) -> {string, ...} | nil, error
+// Entries are read in archive order, so i/o is sequential.
+static int LuaZipReaderReadMany(lua_State *L) {
+  struct LuaZipReader *z = GetZipReader(L);
+  luaL_checktype(L, 2, LUA_TTABLE);
+
+  if (z->fd == -1 && !z->data)
+    return ZipError(L, "zip reader is closed");
+
+  lua_Integer i, n = luaL_len(L, 2);
+  struct LuaZipRequest *req =
+      lua_newuserdatauv(L, (n ? n : 1) * sizeof(*req), 0);
+  for (i = 0; i < n; ++i) {
+    size_t namelen;
+    lua_rawgeti(L, 2, i + 1);
+    const char *name = lua_tolstring(L, -1, &namelen);
+    if (!name)
+      return luaL_error(L, "read_many: names[%d] is not a string", (int)i + 1);
+    if (!(req[i].cfile = FindEntry(z, name, namelen))) {
+      lua_pushnil(L);
+      lua_pushfstring(L, "%s: entry not found", name);
+      return 2;
+    }
+    lua_pop(L, 1);
+    req[i].offset = GetZipCfileOffset(req[i].cfile);
+    req[i].idx = i + 1;
+  }
+  qsort(req, n, sizeof(*req), CompareRequests);
+
+  lua_createtable(L, n, 0);
+  for (i = 0; i < n; ++i) {
+    if (ReadEntry(L, z, req[i].cfile) != 1) {
+      lua_rawgeti(L, 2, req[i].idx);
+      lua_pushfstring(L, "%s: %s", lua_tostring(L, -1), lua_tostring(L, -2));
+      lua_pushnil(L);
+      lua_insert(L, -2);
+      return 2;
+    }
+    lua_rawseti(L, -2, req[i].idx);
+  }
+  return 1;
+}
+
 // reader:__tostring()
 static int LuaZipReaderTostring(lua_State *L) {
   struct LuaZipReader *z = GetZipReader(L);
@@ -968,6 +1078,105 @@ static int AddCdirEntry(struct LuaZipWriter *w, const char *name, size_t namelen
   return 0;
 }
 
+// Parses options table of writer:add() and writer:add_file().
+static void GetAddOptions(lua_State *L, int idx, bool *force_store,
+                          bool *force_deflate, int64_t *mtime_unix,
+                          int64_t *mode) {
+  if (!lua_istable(L, idx))
+    return;
+
+  lua_getfield(L, idx, "method");
+  if (!lua_isnil(L, -1)) {
+    const char *m = luaL_checkstring(L, -1);
+    if (!strcmp(m, "store"))
+      *force_store = true;
+    else if (!strcmp(m, "deflate"))
+      *force_deflate = true;
+    else
+      luaL_error(L, "unknown method: %s", m);
+  }
+  lua_pop(L, 1);
+
+  lua_getfield(L, idx, "mtime");
+  if (!lua_isnil(L, -1))
+    *mtime_unix = luaL_checkinteger(L, -1);
+  lua_pop(L, 1);
+
+  lua_getfield(L, idx, "mode");
+  if (!lua_isnil(L, -1))
+    *mode = luaL_checkinteger(L, -1);
+  lua_pop(L, 1);
+}
+
+// Checks entry name and size shared by writer:add() and add_file().
+// Returns NULL if entry may be added, or an error message.
+static const char *CheckNewEntry(struct LuaZipWriter *w, const char *name,
+                                 size_t namelen, uint64_t size) {
+  const char *name_err = ValidateEntryName(name, namelen);
+  if (name_err)
+    return name_err;
+  if (HasDuplicateEntry(w, name, namelen))
+    return "duplicate entry name";
+  if (size > UINT_MAX)
+    return "content too large (exceeds 4GB limit)";
+  if ((int64_t)size > w->max_file_size)
+    return "content exceeds max_file_size limit";
+  return NULL;
+}
+
+// Returns NULL if mode is ok for an entry, after adding file type.
+static const char *FixEntryMode(int64_t *mode) {
+  if ((*mode & 0170000) != 0100000 && (*mode & 0170000) != 0)
+    return "mode must be a regular file";
+  if ((*mode & 0170000) == 0)
+    *mode |= 0100000;
+  return NULL;
+}
+
+// Writes local file header followed by entry data, and records the
+// entry for the central directory. Data comes from `data` if it isn't
+// NULL, otherwise `compsize` bytes are copied from file descriptor
+// `srcfd` so the kernel can move them without a round trip through us.
+static int WriteEntry(lua_State *L, struct LuaZipWriter *w, const char *name,
+                      size_t namelen, uint32_t crc, uint16_t method,
+                      int64_t mtime_unix, uint32_t mode, const void *data,
+                      int srcfd, size_t compsize, size_t uncompsize) {
+  // convert mtime
+  uint16_t mtime, mdate;
+  GetDosLocalTime(mtime_unix, &mtime, &mdate);
+
+  // build and write local file header
+  size_t hdrlen = GetLfileHdrSize(namelen, compsize, uncompsize);
+  uint8_t *lochdr = malloc(hdrlen);
+  if (!lochdr)
+    return SysError(L, "malloc");
+
+  EmitZipLfileHdr(lochdr, name, namelen, crc, method, mtime, mdate, compsize,
+                  uncompsize);
+
+  ssize_t written = write(w->fd, lochdr, hdrlen);
+  free(lochdr);
+  if (written != (ssize_t)hdrlen)
+    return WriterSysError(L, w, "write header");
+
+  // write file data
+  if (data)
+    written = write(w->fd, data, compsize);
+  else
+    written = copyfd(srcfd, w->fd, compsize);
+  if (written != (ssize_t)compsize)
+    return WriterSysError(L, w, "write data");
+
+  // record entry for central directory
+  if (AddCdirEntry(w, name, namelen, w->offset, compsize, uncompsize, crc,
+                   method, mtime, mdate, mode) < 0)
+    return SysError(L, "malloc");
+
+  w->offset += hdrlen + compsize;
+  lua_pushboolean(L, 1);
+  return 1;
+}
+
 // writer:add(name, content, [options]) -> true | nil, error
 static int LuaZipWriterAdd(lua_State *L) {
   struct LuaZipWriter *w = GetZipWriter(L);
@@ -978,62 +1187,23 @@ static int LuaZipWriterAdd(lua_State *L) {
   if (w->fd == -1)
     return ZipError(L, "zip writer is closed");
 
-  const char *name_err = ValidateEntryName(name, namelen);
-  if (name_err)
-    return ZipError(L, name_err);
-
-  if (HasDuplicateEntry(w, name, namelen))
-    return ZipError(L, "duplicate entry name");
-
-  if (contentlen > UINT_MAX)
-    return ZipError(L, "content too large (exceeds 4GB limit)");
-
-  if ((int64_t)contentlen > w->max_file_size)
-    return ZipError(L, "content exceeds max_file_size limit");
+  const char *entry_err = CheckNewEntry(w, name, namelen, contentlen);
+  if (entry_err)
+    return ZipError(L, entry_err);
 
   // parse options
   bool force_store = false;
   bool force_deflate = false;
   int64_t mtime_unix = time(NULL);
-  uint32_t mode = 0100644;
-
-  if (lua_istable(L, 4)) {
-    lua_getfield(L, 4, "method");
-    if (!lua_isnil(L, -1)) {
-      const char *m = luaL_checkstring(L, -1);
-      if (!strcmp(m, "store"))
-        force_store = true;
-      else if (!strcmp(m, "deflate"))
-        force_deflate = true;
-      else
-        return luaL_error(L, "unknown method: %s", m);
-    }
-    lua_pop(L, 1);
-
-    lua_getfield(L, 4, "mtime");
-    if (!lua_isnil(L, -1))
-      mtime_unix = luaL_checkinteger(L, -1);
-    lua_pop(L, 1);
-
-    lua_getfield(L, 4, "mode");
-    if (!lua_isnil(L, -1))
-      mode = luaL_checkinteger(L, -1);
-    lua_pop(L, 1);
-  }
-
-  // validate mode is a regular file
-  if ((mode & 0170000) != 0100000 && (mode & 0170000) != 0)
-    return ZipError(L, "mode must be a regular file");
-  if ((mode & 0170000) == 0)
-    mode |= 0100000;
+  int64_t mode = 0100644;
+  GetAddOptions(L, 4, &force_store, &force_deflate, &mtime_unix, &mode);
+  const char *mode_err = FixEntryMode(&mode);
+  if (mode_err)
+    return ZipError(L, mode_err);
 
   // compute CRC32
   uint32_t crc = crc32_z(0, (const uint8_t *)content, contentlen);
 
-  // convert mtime
-  uint16_t mtime, mdate;
-  GetDosLocalTime(mtime_unix, &mtime, &mdate);
-
   // decide compression method and compress if needed
   uint16_t method = kZipCompressionNone;
   void *compdata = NULL;
@@ -1047,39 +1217,95 @@ static int LuaZipWriterAdd(lua_State *L) {
       method = kZipCompressionDeflate;
   }
 
-  // build and write local file header
-  size_t hdrlen = GetLfileHdrSize(namelen, compsize, contentlen);
-  uint8_t *lochdr = malloc(hdrlen);
-  if (!lochdr) {
-    free(compdata);
-    return SysError(L, "malloc");
+  int rc = WriteEntry(L, w, name, namelen, crc, method, mtime_unix, mode,
+                      compdata ? compdata : content, -1, compsize, contentlen);
+  free(compdata);
+  return rc;
+}
+
+// writer:add_file(name, path, [options]) -> true | nil, error
+// Adds file from disk without copying it into a Lua string. The file is
+// mapped to compute its checksum, and stored entries are copied to the
+// archive with copy_file_range() when the system supports it.
+static int LuaZipWriterAddFile(lua_State *L) {
+  struct LuaZipWriter *w = GetZipWriter(L);
+  size_t namelen;
+  const char *name = luaL_checklstring(L, 2, &namelen);
+  const char *path = luaL_checkstring(L, 3);
+
+  if (w->fd == -1)
+    return ZipError(L, "zip writer is closed");
+
+  // parse options, which default to the file's own metadata
+  bool force_store = false;
+  bool force_deflate = false;
+  int64_t mtime_unix = INT64_MIN;
+  int64_t mode = -1;
+  GetAddOptions(L, 4, &force_store, &force_deflate, &mtime_unix, &mode);
+
+  int fd = open(path, O_RDONLY);
+  if (fd == -1)
+    return SysError(L, path);
+  struct stat st;
+  if (fstat(fd, &st) == -1) {
+    close(fd);
+    return SysError(L, path);
+  }
+  if (!S_ISREG(st.st_mode)) {
+    close(fd);
+    return ZipError(L, "not a regular file");
   }
 
-  EmitZipLfileHdr(lochdr, name, namelen, crc, method, mtime, mdate, compsize,
-                  contentlen);
+  const char *entry_err = CheckNewEntry(w, name, namelen, st.st_size);
+  if (entry_err) {
+    close(fd);
+    return ZipError(L, entry_err);
+  }
 
-  ssize_t written = write(w->fd, lochdr, hdrlen);
-  free(lochdr);
-  if (written != (ssize_t)hdrlen) {
-    free(compdata);
-    return WriterSysError(L, w, "write header");
+  if (mtime_unix == INT64_MIN)
+    mtime_unix = st.st_mtim.tv_sec;
+  if (mode == -1)
+    mode = st.st_mode & 0107777;
+  const char *mode_err = FixEntryMode(&mode);
+  if (mode_err) {
+    close(fd);
+    return ZipError(L, mode_err);
   }
 
-  // write file data
-  const void *writedata = compdata ? compdata : content;
-  written = write(w->fd, writedata, compsize);
-  free(compdata);
-  if (written != (ssize_t)compsize)
-    return WriterSysError(L, w, "write data");
+  size_t size = st.st_size;
+  uint8_t *map = NULL;
+  if (size) {
+    map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      close(fd);
+      return SysError(L, path);
+    }
+  }
 
-  // record entry for central directory
-  if (AddCdirEntry(w, name, namelen, w->offset, compsize, contentlen, crc,
-                   method, mtime, mdate, mode) < 0)
-    return SysError(L, "malloc");
+  uint32_t crc = crc32_z(0, map, size);
 
-  w->offset += hdrlen + compsize;
-  lua_pushboolean(L, 1);
-  return 1;
+  uint16_t method = kZipCompressionNone;
+  void *compdata = NULL;
+  size_t compsize = size;
+  if (!force_store &&
+      (force_deflate || ShouldCompress(name, namelen, map, size, w->level))) {
+    if (ZipDeflate(map, size, &compdata, &compsize, w->level) < 0) {
+      if (map)
+        munmap(map, size);
+      close(fd);
+      return ZipError(L, "deflate failed");
+    }
+    if (compdata)
+      method = kZipCompressionDeflate;
+  }
+  if (map)
+    munmap(map, size);
+
+  int rc = WriteEntry(L, w, name, namelen, crc, method, mtime_unix, mode,
+                      compdata, fd, compsize, size);
+  free(compdata);
+  close(fd);
+  return rc;
 }
 
 // writer:close() -> true | nil, error
@@ -1655,6 +1881,7 @@ static const luaL_Reg kLuaZipReaderMethods[] = {
     {"list", LuaZipReaderList},
     {"stat", LuaZipReaderStat},
     {"read", LuaZipReaderRead},
+    {"read_many", LuaZipReaderReadMany},
     {0},
 };
 
@@ -1668,6 +1895,7 @@ static const luaL_Reg kLuaZipWriterMeta[] = {
 static const luaL_Reg kLuaZipWriterMethods[] = {
     {"close", LuaZipWriterClose},
     {"add", LuaZipWriterAdd},
+    {"add_file", LuaZipWriterAddFile},
     {0},
 };
 
@@ -25,6 +25,7 @@
 #include "libc/calls/struct/flock.h"
 #include "libc/calls/struct/iovec.h"
 #include "libc/calls/struct/rusage.h"
+#include "libc/calls/struct/itimerval.h"
 #include "libc/calls/struct/sigaction.h"
 #include "libc/calls/struct/sigset.h"
 #include "libc/calls/struct/stat.h"
@@ -71,6 +72,7 @@
 #include "libc/stdio/hex.internal.h"
 #include "libc/stdio/rand.h"
 #include "libc/stdio/stdio.h"
+#include "libc/str/highwayhash64.h"
 #include "libc/str/locale.h"
 #include "libc/str/slice.h"
 #include "libc/str/str.h"
@@ -94,9 +96,13 @@
 #include "libc/sysv/consts/prot.h"
 #include "libc/sysv/consts/rusage.h"
 #include "libc/sysv/consts/s.h"
+#include "libc/sysv/consts/itimer.h"
 #include "libc/sysv/consts/sa.h"
 #include "libc/sysv/consts/sig.h"
+#include "libc/sysv/consts/so.h"
 #include "libc/sysv/consts/sock.h"
+#include "libc/sysv/consts/sol.h"
+#include "libc/sysv/consts/tcp.h"
 #include "libc/sysv/consts/termios.h"
 #include "libc/sysv/consts/timer.h"
 #include "libc/sysv/consts/w.h"
@@ -107,6 +113,7 @@
 #include "libc/x/xasprintf.h"
 #include "libc/zip.h"
 #include "net/http/escape.h"
+#include "net/http/hpack.h"
 #include "net/http/http.h"
 #include "net/http/ip.h"
 #include "net/http/tokenbucket.h"
@@ -125,11 +132,13 @@
 #include "third_party/mbedtls/oid.h"
 #include "third_party/mbedtls/san.h"
 #include "third_party/mbedtls/ssl.h"
+#include "third_party/mbedtls/ssl_ciphersuites.h"
 #include "third_party/mbedtls/ssl_ticket.h"
 #include "third_party/mbedtls/x509.h"
 #include "third_party/mbedtls/x509_crt.h"
 #include "third_party/musl/netdb.h"
 #include "third_party/zlib/zlib.h"
+#include "third_party/zstd/zstd.h"
 #include "tool/build/lib/case.h"
 #include "tool/net/lfinger.h"
 #include "tool/net/lfuncs.h"
@@ -172,6 +181,25 @@ __static_yoink("blink_xnu_aarch64");    // is apple silicon
 //                         XXYYZZ
 #define VERSION          0x030000
 #define HASH_LOAD_FACTOR /* 1. / */ 4
+#define MINSENDFILE      16384
+#define SSLCACHESLOTS    1024
+#define MICROCLAIMS      1024
+#define MICROCLAIMSECS   10
+#define MICROVARYMAX     256
+#define LOGRINGSIZE      (1024 * 1024)
+#define LOGBUFSIZE       65536
+#define LATENCYROUTES    16
+#define LATENCYBUCKETS   128
+#define H2MAXSTREAMS     100    // concurrent http/2 streams per connection
+#define H2MAXFRAME       16384  // largest http/2 frame we'll receive
+#define H2MAXBLOCK       65536  // largest http/2 header block we'll receive
+#define TOKENCLIENTS     65536
+#define LUAPROFILEPROBE  16    // linear probe distance in stack table
+#define LUAPROFILEDEPTH  64    // maximum number of lua frames sampled
+#define LUAPROFILELINE   496   // maximum bytes of folded stack
+#define LUAPROFILECOUNT  1000  // vm instructions between tick polls
+#define LUAPROFILEEMPTY  0     // slot is unused
+#define LUAPROFILEBUSY   1     // slot is being written
 #define READ(F, P, N)    readv(F, &(struct iovec){P, N}, 1)
 #define WRITE(F, P, N)   writev(F, &(struct iovec){P, N}, 1)
 #define AppendCrlf(P)    mempcpy(P, "\r\n", 2)
@@ -183,6 +211,10 @@ __static_yoink("blink_xnu_aarch64");    // is apple silicon
 #define LockInc(P) atomic_fetch_add_explicit(P, +1, memory_order_relaxed)
 #define LockDec(P) atomic_fetch_add_explicit(P, -1, memory_order_relaxed)
 
+// counters are striped by cpu so workers don't fight over cache lines
+#define LockIncCounter(C) LockInc(&shared->c[cosmo_shard()].C)
+#define GetCounter(C)     SumCounter(offsetof(struct Counters, C))
+
 #define TRACE_BEGIN         \
   do {                      \
     if (!IsTiny()) {        \
@@ -207,11 +239,11 @@ __static_yoink("blink_xnu_aarch64");    // is apple silicon
     }                       \
   } while (0)
 
-// letters not used: INOQYnoqwxy
+// letters not used: IOQYnoqxy
 // digits not used:  0123456789
 // puncts not used:  !"#$&'()+,-./;<=>@[\]^_`{|}~
 #define GETOPTS \
-  "*%BEJSVXZabdfghijkmsuvzA:C:D:F:G:H:K:L:M:P:R:T:U:W:c:e:l:p:r:t:w:"
+  "*%BEJSVXZabdfghijkmsuvzA:C:D:F:G:H:K:L:M:N:P:R:T:U:W:c:e:l:p:r:t:w:"
 
 static const uint8_t kGzipHeader[] = {
     0x1F,        // MAGNUM
@@ -234,6 +266,12 @@ static const char *const kIndexPaths[] = {
 };
 
 static const char *const kAlpn[] = {
+    "h2",
+    "http/1.1",
+    NULL,
+};
+
+static const char *const kAlpnClient[] = {
     "http/1.1",
     NULL,
 };
@@ -282,15 +320,30 @@ static struct Servers {
   size_t n;
   struct Server {
     int fd;
+    int shard;
     struct sockaddr_in addr;
   } * p;
 } servers;
 
+static struct Parked {
+  size_t n;
+  struct Park {
+    int fd;
+    int messageshandled;
+    struct timespec since;
+    struct timespec startconnection;
+    struct sockaddr_in clientaddr;
+    struct sockaddr_in *serveraddr;
+  } * p;
+} parked;
+
 static struct Freelist {
   size_t n, c;
   void **p;
 } freelist;
 
+static struct CosmoArena *reqarena;
+
 static struct Unmaplist {
   size_t n, c;
   struct Unmap {
@@ -329,11 +382,16 @@ static struct Assets {
   uint32_t n;
   struct Asset {
     bool istext;
+    uint8_t variants;
+    uint8_t tag;
+    uint16_t namesize;
     uint32_t hash;
     uint64_t cf;
     uint64_t lf;
     int64_t lastmodified;
     char *lastmodifiedstr;
+    char *bytecode;  // compiled lua chunk, or null
+    size_t bytecodesize;
     struct File {
       struct String path;
       struct stat st;
@@ -343,10 +401,7 @@ static struct Assets {
 
 static struct TrustedIps {
   size_t n;
-  struct TrustedIp {
-    uint32_t ip;
-    uint32_t mask;
-  } * p;
+  struct IpTrie trie;
 } trustedips;
 
 struct TokenBucket {
@@ -354,18 +409,47 @@ struct TokenBucket {
   signed char reject;
   signed char ignore;
   signed char ban;
-  struct timespec replenish;
-  union {
-    atomic_schar *b;
-    atomic_uint_fast64_t *w;
-  };
+  struct TokenBuckets *tb;
 } tokenbucket;
 
+struct CosmoShmap *sharedcache;
+size_t sharedcachepayload;
+struct CosmoShmap *responsecache;
+size_t responsecachepayload;
+
+// lua stacks sampled by workers, shared so any of them can export it
+static struct LuaProfile {
+  _Atomic(unsigned long) dropped;  // samples that didn't fit table
+  size_t n;                        // power of two
+  struct LuaSample {
+    _Atomic(uint64_t) hash;
+    _Atomic(unsigned long) count;
+    char stack[LUAPROFILELINE];
+  } p[];
+} * luaprofile;
+static int luaprofilehz;
+static int luaprofilepercent;
+static atomic_int luaprofiletick;
+
 struct Blackhole {
   struct sockaddr_un addr;
   int fd;
 } blackhole;
 
+enum {
+  kLatencyFirstByte,  // accept until response is ready on first message
+  kLatencyHandler,    // request fully read until response is ready
+  kLatencyHandshake,  // tls handshake after client hello arrives
+  kLatencyMetrics,
+};
+
+static const char *const kLatencyNames[kLatencyMetrics + 1] = {
+    "firstbyte",
+    "handler",
+    "handshake",
+    0,
+};
+
 static struct Shared {
   _Atomic(int) workers;
   struct timespec lastmeltdown;
@@ -377,13 +461,79 @@ static struct Shared {
 #define C(x) _Atomic(long) x;
 #include "tool/net/counters.inc"
 #undef C
-  } c;
+  } __attribute__((__aligned__(64))) c[COSMO_SHARDS];
   pthread_mutex_t datetime_mu;
   pthread_mutex_t server_mu;
   pthread_mutex_t children_mu;
   pthread_mutex_t lastmeltdown_mu;
+  struct SslCache {
+    _Atomic(uint32_t) seq;  // odd while a worker is writing the slot
+    uint8_t id_len;
+    uint8_t mfl_code;
+    uint16_t ciphersuite;
+    int32_t encrypt_then_mac;
+    uint32_t verify_result;
+    int64_t start;
+    unsigned char id[32];
+    unsigned char master[48];
+  } sslcache[SSLCACHESLOTS];
+  // each slot is the unix second at which a regeneration claim lapses
+  // in the high half, and the low half of the key hash in the low half
+  _Atomic(uint64_t) microclaim[MICROCLAIMS];
+  struct Latency {
+    _Atomic(long) h[kLatencyMetrics][LATENCYBUCKETS];
+  } latency[1 + LATENCYROUTES];  // zero is all routes combined
 } * shared;
 
+// multi-producer log record queue which workers append to and which
+// the log drainer process writes out. each record is an 8-byte length
+// header followed by its text, padded to 8 bytes. buffer space stays
+// zeroed until reserved, so a zero header means not yet committed.
+static struct LogRing {
+  _Atomic(uint64_t) head;  // bytes reserved by workers
+  char pad1[56];
+  _Atomic(uint64_t) tail;  // bytes written out by drainer
+  char pad2[56];
+  char buf[LOGRINGSIZE];
+} * logring;
+
+static long SumCounter(size_t off) {
+  long x;
+  size_t i;
+  for (x = i = 0; i < COSMO_SHARDS; ++i) {
+    x += atomic_load_explicit(
+        (_Atomic(long) *)((char *)(shared->c + i) + off), memory_order_relaxed);
+  }
+  return x;
+}
+
+// buckets have four sub-buckets per power of two, like HdrHistogram
+// with two significant bits, so each one is within 25% of its value
+static int GetLatencyBucket(long us) {
+  int e;
+  if (us < 4)
+    return MAX(us, 0);
+  e = bsrl(us);
+  return MIN((e - 1) * 4 + ((us >> (e - 2)) & 3), LATENCYBUCKETS - 1);
+}
+
+// returns highest microsecond value which lands in bucket
+static long GetLatencyBucketLimit(int b) {
+  int e;
+  if (b < 4)
+    return b;
+  e = b / 4 + 1;
+  return ((4l + b % 4 + 1) << (e - 2)) - 1;
+}
+
+static void RecordLatency(int route, int metric, struct timespec elapsed) {
+  int b;
+  b = GetLatencyBucket(timespec_tomicros(elapsed));
+  LockInc(&shared->latency[0].h[metric][b]);
+  if (route)
+    LockInc(&shared->latency[route].h[metric][b]);
+}
+
 static const char kCounterNames[] =
 #define C(x) #x "\0"
 #include "tool/net/counters.inc"
@@ -399,9 +549,18 @@ struct ClearedPerMessage {
   bool hascontenttype;
   bool gotcachecontrol;
   bool gotxcontenttypeoptions;
+  bool bodypending;   // payload hasn't been read yet by handler
+  bool bodychunked;   // deferred payload uses chunked encoding
+  bool bodystreamed;  // handler is reading deferred payload in pieces
   int frags;
   int statuscode;
   int isyielding;
+  int microfresh;   // seconds SetCacheable() said response stays fresh
+  int microstale;   // seconds it may be served stale after that
+  size_t microvarylen;
+  _Atomic(uint64_t) *microclaim;
+  uint64_t microclaimval;
+  char microvary[MICROVARYMAX];  // nul terminated header names
   char *outbuf;
   char *content;
   size_t gzipped;
@@ -409,6 +568,8 @@ struct ClearedPerMessage {
   char *luaheaderp;
   const char *referrerpolicy;
   size_t msgsize;
+  size_t bodyleft;  // identity payload bytes not read from socket yet
+  struct HttpUnchunker unchunker;
   ssize_t (*generator)(struct iovec[3]);
   struct Strings loops;
   struct HttpMessage msg;
@@ -418,6 +579,7 @@ static bool suiteb;
 static bool killed;
 static bool zombied;
 static bool usingssl;
+static bool usingktls;
 static bool funtrace;
 static bool systrace;
 static bool meltdown;
@@ -437,13 +599,23 @@ static bool logmessages;
 static bool isinitialized;
 static bool sslinitialized;
 static bool sslfetchverify;
+static bool nosendfile;
 static bool selfmodifiable;
+static bool reuseportshards;
+static bool streambodies;
+static bool asynclog;
+static bool gcbeforefork;
+static bool freezeheap;
+static bool kerneltls;
 static bool interpretermode;
 static bool sslclientverify;
 static bool connectionclose;
 static bool hasonloglatency;
 static bool hasonworkerstop;
 static bool isexitingworker;
+static bool ispreforkworker;
+static bool parkclient;
+static bool preforkshortage;
 static bool hasonworkerstart;
 static bool leakcrashreports;
 static bool hasonhttprequest;
@@ -457,18 +629,24 @@ static bool hasonclientconnection;
 static bool evadedragnetsurveillance;
 
 static int zfd;
+static int zmapfd;
 static int gmtoff;
 static int client;
 static int mainpid;
 static int sandboxed;
 static int changeuid;
 static int changegid;
+static int prefork;
 static int maxworkers;
 static int shutdownsig;
 static int sslpskindex;
 static int oldloglevel;
 static int messageshandled;
+static int *preforkpids;
+static int maxparked;
+static int listenshards;
 static int sslticketlifetime;
+static int64_t requestgeneration;
 static uint32_t clientaddrsize;
 
 static char *brand;
@@ -487,7 +665,11 @@ static struct Certs certs;
 static char *serverheader;
 static char gzip_footer[8];
 static long maxpayloadsize;
+static long preforkrequests;
+static long preforkmessages;
 static const char *pidpath;
+static FILE *logstream;
+static char *logbuf;
 static const char *logpath;
 static uint32_t *interfaces;
 static struct pollfd *polls;
@@ -496,6 +678,7 @@ static int64_t cacheseconds;
 static char *cachedirective;
 static struct Strings stagedirs;
 static struct Strings hidepaths;
+static struct Strings latencyroutes;
 static const char *launchbrowser;
 static const char ctIdx = 'c';  // a pseudo variable to get address of
 
@@ -529,6 +712,7 @@ static mbedtls_ssl_context sslcli;
 static mbedtls_ctr_drbg_context rngcli;
 
 static struct TlsBio g_bio;
+static unsigned char sslout[MBEDTLS_SSL_OUT_CONTENT_LEN];
 static char slashpath[PATH_MAX];
 static struct DeflateGenerator dg;
 
@@ -540,6 +724,10 @@ static char *ServeAsset(struct Asset *, const char *, size_t);
 static char *SetStatus(unsigned, const char *);
 
 static void TlsInit(void);
+static void PrecompileLuaAssets(void);
+static const char *SlurpBody(void);
+static const char *ReadBodyPiece(const char **, size_t *);
+static void AppendLuaProfile(char **);
 
 static void OnChld(void) {
   zombied = true;
@@ -594,6 +782,20 @@ static void *FreeLater(void *p) {
   return p;
 }
 
+// allocates memory that's released all at once by CollectGarbage()
+static void *AllocLater(size_t n) {
+  if (!reqarena && !(reqarena = cosmo_arena_new(0, 0)))
+    return 0;
+  return cosmo_arena_alloc(reqarena, n, 0);
+}
+
+static void *xAllocLater(size_t n) {
+  void *p;
+  if (!(p = AllocLater(n)))
+    xdie();
+  return p;
+}
+
 static void UnmapLater(int f, void *p, size_t n) {
   if (++unmaplist.n > unmaplist.c) {
     unmaplist.c = unmaplist.n + (unmaplist.n >> 1);
@@ -610,6 +812,8 @@ static void CollectGarbage(void) {
   while (freelist.n) {
     free(freelist.p[--freelist.n]);
   }
+  if (reqarena)
+    cosmo_arena_reset(reqarena, 0);
   while (unmaplist.n) {
     --unmaplist.n;
     LOGIFNEG1(munmap(unmaplist.p[unmaplist.n].p, unmaplist.p[unmaplist.n].n));
@@ -713,6 +917,13 @@ static void ProgramSslTicketLifetime(long x) {
   sslticketlifetime = x;
 }
 
+static void ProgramPrefork(long x) {
+  if (!(0 <= x && x <= 4096)) {
+    FATALF("(cfg) error: bad prefork worker count: %ld", x);
+  }
+  prefork = x;
+}
+
 static void ProgramAddr(const char *addr) {
   ssize_t rc;
   int64_t ip;
@@ -780,15 +991,12 @@ static void ProgramRedirectArg(int code, const char *s) {
 }
 
 static void ProgramTrustedIp(uint32_t ip, int cidr) {
-  uint32_t mask;
-  mask = 0xffffffffu << (32 - cidr);
-  trustedips.p = xrealloc(trustedips.p, ++trustedips.n * sizeof(*trustedips.p));
-  trustedips.p[trustedips.n - 1].ip = ip;
-  trustedips.p[trustedips.n - 1].mask = mask;
+  if (AddIpTrie(&trustedips.trie, ip, cidr, 1) == -1)
+    DIEF("(cfg) ProgramTrustedIp() failed: %m");
+  ++trustedips.n;
 }
 
 static bool IsTrustedIp(uint32_t ip) {
-  int i;
   uint32_t *p;
   if (interfaces) {
     for (p = interfaces; *p; ++p) {
@@ -799,11 +1007,9 @@ static bool IsTrustedIp(uint32_t ip) {
     }
   }
   if (trustedips.n) {
-    for (i = 0; i < trustedips.n; ++i) {
-      if ((ip & trustedips.p[i].mask) == trustedips.p[i].ip) {
-        DEBUGF("(token) ip is trusted because it's %s", "whitelisted");
-        return true;
-      }
+    if (LookupIpTrie(&trustedips.trie, ip)) {
+      DEBUGF("(token) ip is trusted because it's %s", "whitelisted");
+      return true;
     }
     return false;
   } else if (IsPrivateIp(ip) && !IsTestnetIp(ip)) {
@@ -942,6 +1148,10 @@ static void SetDefaults(void) {
   ProgramTimeout(60 * 1000);
   ProgramSslTicketLifetime(24 * 60 * 60);
   sslfetchverify = true;
+  // fork() on windows copies the whole address space, so it's cheaper
+  // to spawn long-lived workers at startup while the heap is small
+  if (IsWindows())
+    ProgramPrefork(MAX(8, cosmo_cpu_count() * 2));
 }
 
 static void AddString(struct Strings *l, const char *s, size_t n) {
@@ -1235,14 +1445,14 @@ static void ReportWorkerExit(int pid, int ws) {
       atomic_fetch_sub_explicit(&shared->workers, 1, memory_order_release);
   if (WIFEXITED(ws)) {
     if (WEXITSTATUS(ws)) {
-      LockInc(&shared->c.failedchildren);
+      LockIncCounter(failedchildren);
       WARNF("(stat) %d exited with %d (%,d workers remain)", pid,
             WEXITSTATUS(ws), workers);
     } else {
       DEBUGF("(stat) %d exited (%,d workers remain)", pid, workers);
     }
   } else {
-    LockInc(&shared->c.terminatedchildren);
+    LockIncCounter(terminatedchildren);
     WARNF("(stat) %d terminated with %s (%,d workers remain)", pid,
           strsignal(WTERMSIG(ws)), workers);
   }
@@ -1262,8 +1472,32 @@ static void ReportWorkerResources(int pid, struct rusage *ru) {
   }
 }
 
+static bool ReleasePreforkWorker(int pid) {
+  int i;
+  for (i = 0; i < prefork; ++i) {
+    if (preforkpids[i] == pid) {
+      preforkpids[i] = 0;
+      preforkshortage = true;
+      return true;
+    }
+  }
+  return false;
+}
+
+// asks prefork workers to exit gracefully so they get replaced
+static void RecyclePreforkWorkers(void) {
+  int i;
+  for (i = 0; i < prefork; ++i) {
+    if (preforkpids[i]) {
+      LOGIFNEG1(kill(preforkpids[i], SIGTERM));
+    }
+  }
+}
+
 static void HandleWorkerExit(int pid, int ws, struct rusage *ru) {
-  LockInc(&shared->c.connectionshandled);
+  if (!ReleasePreforkWorker(pid)) {
+    LockIncCounter(connectionshandled);
+  }
   unassert(!pthread_mutex_lock(&shared->children_mu));
   rusage_add(&shared->children, ru);
   unassert(!pthread_mutex_unlock(&shared->children_mu));
@@ -1350,8 +1584,9 @@ static ssize_t ReadAll(int fd, char *p, size_t n) {
 }
 
 static bool IsTakingTooLong(void) {
-  return meltdown && timespec_cmp(timespec_sub(timespec_real(), startread),
-                                  (struct timespec){2}) >= 0;
+  return meltdown &&
+         timespec_cmp(timespec_sub(timespec_real_coarse(), startread),
+                      (struct timespec){2}) >= 0;
 }
 
 static ssize_t WritevAll(int fd, struct iovec *iov, int iovlen) {
@@ -1381,7 +1616,7 @@ static ssize_t WritevAll(int fd, struct iovec *iov, int iovlen) {
       } while (wrote);
     } else if (errno == EINTR) {
       errno = 0;
-      LockInc(&shared->c.writeinterruputs);
+      LockIncCounter(writeinterruputs);
       if (killed || IsTakingTooLong()) {
         return total ? total : -1;
       }
@@ -1520,220 +1755,1232 @@ static ssize_t SslRead(int fd, void *buf, size_t size) {
   return rc;
 }
 
+static int SslWriteAll(const unsigned char *p, size_t n) {
+  int rc;
+  while (n) {
+    if ((rc = mbedtls_ssl_write(&ssl, p, n)) > 0) {
+      p += rc;
+      n -= rc;
+    } else if (rc == MBEDTLS_ERR_NET_CONN_RESET) {
+      errno = ECONNRESET;
+      return -1;
+    } else if (rc == MBEDTLS_ERR_SSL_TIMEOUT) {
+      errno = ETIMEDOUT;
+      return -1;
+    } else {
+      WARNF("(ssl) %s SslWrite error -0x%04x", DescribeClient(), -rc);
+      errno = EIO;
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// packs iovecs into as few tls records as possible
+//
+// responses get handed to us as separate iovecs for the headers, chunk
+// framing, and payload pieces. rather than paying for a record and a
+// write() each, we copy them into full sized records, while pieces big
+// enough to fill one by themselves are encrypted in place. nothing gets
+// held back past return, so every Send() still flushes to the client.
 static ssize_t SslWrite(int fd, struct iovec *iov, int iovlen) {
-  int i;
-  size_t n;
-  ssize_t rc;
+  int i, max;
+  size_t n, m, c;
   const unsigned char *p;
-  for (i = 0; i < iovlen; ++i) {
+  if ((max = mbedtls_ssl_get_max_out_record_payload(&ssl)) <= 0 ||
+      max > sizeof(sslout)) {
+    max = sizeof(sslout);
+  }
+  for (c = i = 0; i < iovlen; ++i) {
     p = iov[i].iov_base;
     n = iov[i].iov_len;
     while (n) {
-      if ((rc = mbedtls_ssl_write(&ssl, p, n)) > 0) {
-        p += rc;
-        n -= rc;
-      } else if (rc == MBEDTLS_ERR_NET_CONN_RESET) {
-        errno = ECONNRESET;
-        return -1;
-      } else if (rc == MBEDTLS_ERR_SSL_TIMEOUT) {
-        errno = ETIMEDOUT;
-        return -1;
+      if (!c && n >= max) {
+        m = n - n % max;
+        if (SslWriteAll(p, m) == -1)
+          return -1;
       } else {
-        WARNF("(ssl) %s SslWrite error -0x%04x", DescribeClient(), -rc);
-        errno = EIO;
-        return -1;
+        m = MIN(n, max - c);
+        memcpy(sslout + c, p, m);
+        if ((c += m) == max) {
+          if (SslWriteAll(sslout, c) == -1)
+            return -1;
+          c = 0;
+        }
       }
+      p += m;
+      n -= m;
     }
   }
+  if (c && SslWriteAll(sslout, c) == -1)
+    return -1;
   return 0;
 }
 
-static void NotifyClose(void) {
-#ifndef UNSECURE
-  if (usingssl) {
-    DEBUGF("(ssl) SSL notifying close");
-    mbedtls_ssl_close_notify(&ssl);
+// http/2 is spoken by translating each stream to an http/1.1 message.
+//
+// once alpn picks h2, the reader and writer hooks are swapped for ones
+// which decode frames into request text, and turn the response text
+// back into HEADERS and DATA frames. that way every stream is routed
+// through ParseHttpMessage() and the lua hooks just like before. many
+// streams may be opened at once on the connection. they're answered in
+// the order they were opened, since a worker handles one message at a
+// time, while the rest of them wait their turn in memory.
+
+#define H2_DATA          0
+#define H2_HEADERS       1
+#define H2_PRIORITY      2
+#define H2_RST_STREAM    3
+#define H2_SETTINGS      4
+#define H2_PUSH_PROMISE  5
+#define H2_PING          6
+#define H2_GOAWAY        7
+#define H2_WINDOW_UPDATE 8
+#define H2_CONTINUATION  9
+
+#define H2_END_STREAM  0x01
+#define H2_ACK         0x01
+#define H2_END_HEADERS 0x04
+#define H2_PADDED      0x08
+#define H2_PRIORITIZED 0x20
+
+#define H2_NO_ERROR          0x0
+#define H2_PROTOCOL_ERROR    0x1
+#define H2_INTERNAL_ERROR    0x2
+#define H2_FLOW_CONTROL      0x3
+#define H2_FRAME_SIZE_ERROR  0x6
+#define H2_REFUSED_STREAM    0x7
+#define H2_COMPRESSION_ERROR 0x9
+
+#define H2_BODY_NONE    0  // response has no payload
+#define H2_BODY_LENGTH  1  // payload has content-length
+#define H2_BODY_CHUNKED 2  // payload has chunked transfer encoding
+#define H2_BODY_CLOSE   3  // payload ends when connection closes
+
+struct H2Bytes {
+  size_t i, n, c;  // p[i,n) is pending and c is capacity
+  char *p;
+};
+
+struct H2Stream {
+  uint32_t id;
+  bool head;         // request method is HEAD so response has no payload
+  bool reset;        // client canceled stream so response is discarded
+  bool ended;        // request text is complete
+  bool started;      // some request text was read by HandleMessages()
+  bool chunked;      // request payload is given chunked encoding
+  int64_t bodyleft;  // request content-length left to receive, or -1
+  int64_t window;    // response payload that client will accept
+  uint32_t credit;   // request payload to be acknowledged by WINDOW_UPDATE
+  struct H2Bytes req;
+};
+
+struct H2Request {
+  bool bad, regular, hashost;
+  struct H2Stream *s;
+  struct H2Bytes method, path, authority, hdrs, cookie;
+};
+
+static struct H2 {
+  bool active;    // alpn chose h2 for this connection
+  bool preface;   // client connection preface was received
+  bool failed;    // connection error was sent to client
+  bool goaway;    // GOAWAY was sent so no new streams are accepted
+  bool peergone;  // client sent GOAWAY
+  uint8_t body;   // how current response payload is delimited
+  uint8_t blockflags;
+  uint32_t lastid;    // highest stream id client has opened
+  uint32_t doneid;    // highest stream id that's been answered
+  uint32_t blockid;   // stream awaiting CONTINUATION, or 0
+  uint32_t maxframe;  // client SETTINGS_MAX_FRAME_SIZE
+  int64_t window;     // connection window for response payloads
+  int64_t initwindow;
+  int64_t bodyleft;
+  size_t rd;  // index of stream being read by HandleMessages()
+  size_t wr;  // index of stream whose response is being written
+  reader_f reader;
+  writer_f writer;
+  struct H2Stream *cur;  // stream of response being written, or null
+  struct HpackTable hpack;
+  struct HttpUnchunker u;
+  struct H2Bytes in, out, block;
+  struct {
+    size_t n, c;
+    struct H2Stream **p;
+  } streams;
+} h2;
+
+static void H2Reserve(struct H2Bytes *b, size_t n) {
+  if (b->i && b->i == b->n)
+    b->i = b->n = 0;
+  if (b->n + n > b->c) {
+    b->c = MAX(b->n + n, b->c + (b->c >> 1));
+    b->p = xrealloc(b->p, b->c);
+  }
+}
+
+static void H2Append(struct H2Bytes *b, const void *p, size_t n) {
+  if (!n)
+    return;
+  H2Reserve(b, n);
+  memcpy(b->p + b->n, p, n);
+  b->n += n;
+}
+
+static void H2Appends(struct H2Bytes *b, const char *s) {
+  H2Append(b, s, strlen(s));
+}
+
+static int H2SendFrame(int type, int flags, uint32_t id, const void *p,
+                       size_t n) {
+  unsigned char h[9];
+  struct iovec iov[2];
+  h[0] = n >> 16;
+  h[1] = n >> 8;
+  h[2] = n;
+  h[3] = type;
+  h[4] = flags;
+  WRITE32BE(h + 5, id);
+  iov[0].iov_base = h;
+  iov[0].iov_len = 9;
+  iov[1].iov_base = (void *)p;
+  iov[1].iov_len = n;
+  for (;;) {
+    if (h2.writer(client, iov, 2) != -1)
+      return 0;
+    if (errno != EINTR)
+      return -1;
+    errno = 0;
   }
-#endif
 }
 
-static void WipeSigningKeys(void) {
-  size_t i;
-  if (uniprocess)
-    return;
-  for (i = 0; i < certs.n; ++i) {
-    if (!certs.p[i].key)
-      continue;
-    if (!certs.p[i].cert)
-      continue;
-    if (!certs.p[i].cert->ca_istrue)
-      continue;
-    mbedtls_pk_free(certs.p[i].key);
-    Free(&certs.p[i].key);
+static int H2SendCode(int type, uint32_t id, uint32_t code) {
+  unsigned char b[4];
+  WRITE32BE(b, code);
+  return H2SendFrame(type, 0, id, b, 4);
+}
+
+static void H2SendGoaway(uint32_t lastid, uint32_t code) {
+  unsigned char b[8];
+  h2.goaway = true;
+  WRITE32BE(b, lastid);
+  WRITE32BE(b + 4, code);
+  H2SendFrame(H2_GOAWAY, 0, 0, b, 8);
+}
+
+static int H2Fail(uint32_t code) {
+  if (!h2.failed) {
+    DEBUGF("(h2) %s connection error %d", DescribeClient(), code);
+    h2.failed = true;
+    H2SendGoaway(h2.lastid, code);
   }
+  return -1;
 }
 
-static void PsksDestroy(void) {
-  size_t i;
-  for (i = 0; i < psks.n; ++i) {
-    mbedtls_platform_zeroize(psks.p[i].key, psks.p[i].key_len);
-    free(psks.p[i].key);
-    free(psks.p[i].identity);
+static struct H2Stream *H2FindStream(uint32_t id, size_t *i) {
+  for (*i = 0; *i < h2.streams.n; ++*i) {
+    if (h2.streams.p[*i]->id == id) {
+      return h2.streams.p[*i];
+    }
   }
-  Free(&psks.p);
-  psks.n = 0;
+  return 0;
 }
 
-static void WipeServingKeys(void) {
-  if (uniprocess)
-    return;
-  mbedtls_ssl_ticket_free(&ssltick);
-  mbedtls_ssl_key_cert_free(conf.key_cert), conf.key_cert = 0;
-  CertsDestroy(&certs);
-  PsksDestroy();
+static void H2FreeStream(struct H2Stream *s) {
+  free(s->req.p);
+  free(s);
 }
 
-static bool TlsSetup(void) {
-  int r;
-  oldin.p = inbuf.p;
-  oldin.n = amtread;
-  inbuf.p += amtread;
-  inbuf.n -= amtread;
-  inbuf.c = amtread;
-  amtread = 0;
-  g_bio.fd = client;
-  g_bio.a = 0;
-  g_bio.b = 0;
-  g_bio.c = 0;
-  sslpskindex = 0;
-  for (;;) {
-    if (!(r = mbedtls_ssl_handshake(&ssl)) && TlsFlush(&g_bio, 0, 0) != -1) {
-      LockInc(&shared->c.sslhandshakes);
-      g_bio.c = -1;
-      usingssl = true;
-      reader = SslRead;
-      writer = SslWrite;
-      WipeServingKeys();
-      VERBOSEF("(ssl) shaken %s %s %s%s %s", DescribeClient(),
-               mbedtls_ssl_get_ciphersuite(&ssl), mbedtls_ssl_get_version(&ssl),
-               ssl.session->compression ? " COMPRESSED" : "",
-               ssl.curve ? ssl.curve->name : "uncurved");
-      DEBUGF("(ssl) client ciphersuite preference was %s",
-             gc(FormatSslClientCiphers(&ssl)));
-      return true;
-    } else if (r == MBEDTLS_ERR_SSL_WANT_READ) {
-      LockInc(&shared->c.handshakeinterrupts);
-      if (terminated || killed || IsTakingTooLong()) {
-        return false;
-      }
-    } else {
-      LockInc(&shared->c.sslhandshakefails);
-      mbedtls_ssl_session_reset(&ssl);
-      switch (r) {
-        case MBEDTLS_ERR_SSL_CONN_EOF:
-          DEBUGF("(ssl) %s SSL handshake EOF", DescribeClient());
-          return false;
-        case MBEDTLS_ERR_NET_CONN_RESET:
-          DEBUGF("(ssl) %s SSL handshake reset", DescribeClient());
-          return false;
-        case MBEDTLS_ERR_SSL_TIMEOUT:
-          LockInc(&shared->c.ssltimeouts);
-          DEBUGF("(ssl) %s %s", DescribeClient(), "ssltimeouts");
-          return false;
-        case MBEDTLS_ERR_SSL_NO_CIPHER_CHOSEN:
-          LockInc(&shared->c.sslnociphers);
-          WARNF("(ssl) %s %s %s", DescribeClient(), "sslnociphers",
-                gc(FormatSslClientCiphers(&ssl)));
-          return false;
-        case MBEDTLS_ERR_SSL_NO_USABLE_CIPHERSUITE:
-          LockInc(&shared->c.sslcantciphers);
-          WARNF("(ssl) %s %s %s", DescribeClient(), "sslcantciphers",
-                gc(FormatSslClientCiphers(&ssl)));
-          return false;
-        case MBEDTLS_ERR_SSL_BAD_HS_PROTOCOL_VERSION:
-          LockInc(&shared->c.sslnoversion);
-          WARNF("(ssl) %s %s %s", DescribeClient(), "sslnoversion",
-                mbedtls_ssl_get_version(&ssl));
-          return false;
-        case MBEDTLS_ERR_SSL_INVALID_MAC:
-          LockInc(&shared->c.sslshakemacs);
-          WARNF("(ssl) %s %s", DescribeClient(), "sslshakemacs");
-          return false;
-        case MBEDTLS_ERR_SSL_NO_CLIENT_CERTIFICATE:
-          LockInc(&shared->c.sslnoclientcert);
-          WARNF("(ssl) %s %s", DescribeClient(), "sslnoclientcert");
-          NotifyClose();
-          return false;
-        case MBEDTLS_ERR_X509_CERT_VERIFY_FAILED:
-          LockInc(&shared->c.sslverifyfailed);
-          WARNF("(ssl) %s SSL %s", DescribeClient(),
-                gc(DescribeSslVerifyFailure(
-                    ssl.session_negotiate->verify_result)));
-          return false;
-        case MBEDTLS_ERR_SSL_FATAL_ALERT_MESSAGE:
-          switch (ssl.fatal_alert) {
-            case MBEDTLS_SSL_ALERT_MSG_CERT_UNKNOWN:
-              LockInc(&shared->c.sslunknowncert);
-              DEBUGF("(ssl) %s %s", DescribeClient(), "sslunknowncert");
-              return false;
-            case MBEDTLS_SSL_ALERT_MSG_UNKNOWN_CA:
-              LockInc(&shared->c.sslunknownca);
-              DEBUGF("(ssl) %s %s", DescribeClient(), "sslunknownca");
-              return false;
-            default:
-              WARNF("(ssl) %s SSL shakealert %s", DescribeClient(),
-                    GetAlertDescription(ssl.fatal_alert));
-              return false;
-          }
-        default:
-          WARNF("(ssl) %s SSL handshake failed -0x%04x", DescribeClient(), -r);
-          return false;
-      }
-    }
+static void H2RemoveStream(size_t i) {
+  H2FreeStream(h2.streams.p[i]);
+  memmove(h2.streams.p + i, h2.streams.p + i + 1,
+          (--h2.streams.n - i) * sizeof(*h2.streams.p));
+}
+
+// frees streams that have been read and answered in full
+static void H2Collect(void) {
+  while (h2.streams.n && h2.rd && h2.wr) {
+    H2RemoveStream(0);
+    --h2.rd;
+    --h2.wr;
   }
 }
 
-static void ConfigureCertificate(mbedtls_x509write_cert *cw, struct Cert *ca,
-                                 int usage, int type) {
-  int nsan = 0;
-  char *name = 0;
-  struct mbedtls_san *san = 0;
+static void H2EndRequest(struct H2Stream *s) {
+  if (s->chunked)
+    H2Appends(&s->req, "0\r\n\r\n");
+  s->ended = true;
+}
 
-  // for each ip address owned by this system
-  //
-  //   1. determine its full-qualified domain name
-  //   2. add subject alt name (san) entry to cert for hostname
-  //   3. add subject alt name (san) entry to cert for *.hostname
-  //
-  for (int i = 0; i < ips.n; ++i) {
-    uint32_t ip = ips.p[i];
-    if (IsLoopbackIp(ip))
-      continue;
-    char rname[NI_MAXHOST];
-    struct sockaddr_in addr4 = {AF_INET, 0, {htonl(ip)}};
-    if (getnameinfo((struct sockaddr *)&addr4, sizeof(addr4), rname,
-                    sizeof(rname), 0, 0, NI_NAMEREQD) == 0) {
-      char *s = gc(strdup(rname));
-      if (!name)
-        name = s;
-      bool isduplicate = false;
-      for (int j = 0; j < nsan; ++j) {
-        if (san[j].tag == MBEDTLS_X509_SAN_DNS_NAME &&
-            !strcasecmp(s, san[j].val)) {
-          isduplicate = true;
-          break;
-        }
-      }
-      if (!isduplicate) {
-        san = realloc(san, (nsan += 2) * sizeof(*san));
-        san[nsan - 2].tag = MBEDTLS_X509_SAN_DNS_NAME;
-        san[nsan - 2].val = s;
-        san[nsan - 1].tag = MBEDTLS_X509_SAN_DNS_NAME;
-        san[nsan - 1].val = gc(xasprintf("*.%s", s));
-      }
+static int OnH2Header(void *arg, const struct HpackHeader *h) {
+  size_t i;
+  struct H2Bytes *b;
+  struct H2Request *r = arg;
+  for (i = 0; i < h->valuelen; ++i) {
+    if (h->value[i] == '\r' || h->value[i] == '\n' || !h->value[i]) {
+      r->bad = true;
+      return 0;
     }
   }
-
+  if (h->namelen && h->name[0] == ':') {
+    if (SlicesEqual(h->name, h->namelen, ":method", 7)) {
+      b = &r->method;
+    } else if (SlicesEqual(h->name, h->namelen, ":path", 5)) {
+      b = &r->path;
+    } else if (SlicesEqual(h->name, h->namelen, ":authority", 10)) {
+      b = &r->authority;
+    } else if (SlicesEqual(h->name, h->namelen, ":scheme", 7)) {
+      return 0;
+    } else {
+      r->bad = true;
+      return 0;
+    }
+    if (r->regular || b->n || !h->valuelen) {
+      r->bad = true;
+    } else {
+      H2Append(b, h->value, h->valuelen);
+    }
+    return 0;
+  }
+  r->regular = true;
+  for (i = 0; i < h->namelen; ++i) {
+    if (!kHttpToken[h->name[i] & 255] || isupper(h->name[i])) {
+      r->bad = true;
+      return 0;
+    }
+  }
+  switch (GetHttpHeader(h->name, h->namelen)) {
+    case kHttpConnection:
+    case kHttpKeepAlive:
+    case kHttpProxyConnection:
+    case kHttpTransferEncoding:
+    case kHttpUpgrade:
+      r->bad = true;
+      return 0;
+    case kHttpTe:
+      if (!SlicesEqual(h->value, h->valuelen, "trailers", 8))
+        r->bad = true;
+      return 0;
+    case kHttpCookie:
+      if (r->cookie.n)
+        H2Append(&r->cookie, "; ", 2);
+      H2Append(&r->cookie, h->value, h->valuelen);
+      return 0;
+    case kHttpContentLength:
+      if (r->s->bodyleft != -1 ||
+          (r->s->bodyleft = ParseContentLength(h->value, h->valuelen)) == -1) {
+        r->bad = true;
+        return 0;
+      }
+      break;
+    case kHttpHost:
+      r->hashost = true;
+      break;
+    default:
+      break;
+  }
+  if (!h->namelen) {
+    r->bad = true;
+    return 0;
+  }
+  H2Append(&r->hdrs, h->name, h->namelen);
+  H2Append(&r->hdrs, ": ", 2);
+  H2Append(&r->hdrs, h->value, h->valuelen);
+  H2Append(&r->hdrs, "\r\n", 2);
+  return 0;
+}
+
+static int OnH2Trailer(void *arg, const struct HpackHeader *h) {
+  return 0;
+}
+
+static void H2DestroyRequest(struct H2Request *r) {
+  free(r->method.p);
+  free(r->path.p);
+  free(r->authority.p);
+  free(r->hdrs.p);
+  free(r->cookie.p);
+}
+
+// turns header block of new stream into http/1.1 request text
+static int H2OpenStream(uint32_t id, bool ended, const char *p, size_t n) {
+  int rc;
+  struct H2Stream *s;
+  struct H2Request r;
+  if (!(id & 1) || id <= h2.lastid)
+    return H2Fail(H2_PROTOCOL_ERROR);
+  h2.lastid = id;
+  bzero(&r, sizeof(r));
+  r.s = s = xcalloc(1, sizeof(*s));
+  s->id = id;
+  s->bodyleft = -1;
+  s->window = h2.initwindow;
+  if ((rc = DecodeHpack(&h2.hpack, p, n, OnH2Header, &r)) == -1) {
+    H2Fail(H2_COMPRESSION_ERROR);
+  } else if (h2.goaway) {
+    // stream is ignored, but its headers still had to be decoded
+  } else if (r.bad || !r.method.n || !r.path.n ||
+             (ended && s->bodyleft > 0) ||
+             (r.path.p[0] != '/' &&
+              !SlicesEqual(r.path.p, r.path.n, "*", 1))) {
+    DEBUGF("(h2) %s malformed request on stream %u", DescribeClient(), id);
+    rc = H2SendCode(H2_RST_STREAM, id, H2_PROTOCOL_ERROR);
+  } else if (h2.streams.n - h2.wr >= H2MAXSTREAMS) {
+    rc = H2SendCode(H2_RST_STREAM, id, H2_REFUSED_STREAM);
+  } else {
+    s->head = SlicesEqual(r.method.p, r.method.n, "HEAD", 4);
+    H2Append(&s->req, r.method.p, r.method.n);
+    H2Append(&s->req, " ", 1);
+    H2Append(&s->req, r.path.p, r.path.n);
+    H2Appends(&s->req, " HTTP/1.1\r\n");
+    if (r.authority.n && !r.hashost) {
+      H2Appends(&s->req, "Host: ");
+      H2Append(&s->req, r.authority.p, r.authority.n);
+      H2Appends(&s->req, "\r\n");
+    }
+    H2Append(&s->req, r.hdrs.p, r.hdrs.n);
+    if (r.cookie.n) {
+      H2Appends(&s->req, "Cookie: ");
+      H2Append(&s->req, r.cookie.p, r.cookie.n);
+      H2Appends(&s->req, "\r\n");
+    }
+    if (!ended && s->bodyleft == -1) {
+      H2Appends(&s->req, "Transfer-Encoding: chunked\r\n");
+      s->chunked = true;
+    }
+    H2Appends(&s->req, "\r\n");
+    s->ended = ended;
+    if (h2.streams.n == h2.streams.c) {
+      h2.streams.c += h2.streams.c + 4;
+      h2.streams.p =
+          xrealloc(h2.streams.p, h2.streams.c * sizeof(*h2.streams.p));
+    }
+    h2.streams.p[h2.streams.n++] = s;
+    s = 0;
+  }
+  if (s)
+    H2FreeStream(s);
+  H2DestroyRequest(&r);
+  return rc;
+}
+
+static int H2OnHeaderBlock(void) {
+  size_t i;
+  struct H2Stream *s;
+  const char *p = h2.block.p;
+  size_t n = h2.block.n;
+  bool ended = h2.blockflags & H2_END_STREAM;
+  h2.block.n = 0;
+  if (!(s = H2FindStream(h2.blockid, &i)))
+    return H2OpenStream(h2.blockid, ended, p, n);
+  // trailers are decoded to keep the table in sync, and then dropped
+  if (DecodeHpack(&h2.hpack, p, n, OnH2Trailer, 0) == -1)
+    return H2Fail(H2_COMPRESSION_ERROR);
+  if (s->ended || !ended || s->bodyleft > 0)
+    return H2Fail(H2_PROTOCOL_ERROR);
+  H2EndRequest(s);
+  return 0;
+}
+
+static int H2OnData(uint32_t id, int flags, const char *p, size_t n) {
+  size_t i, m;
+  char b[24];
+  struct H2Stream *s;
+  m = n;
+  if (n && H2SendCode(H2_WINDOW_UPDATE, 0, n) == -1)
+    return -1;
+  if (flags & H2_PADDED) {
+    if (!n || (p[0] & 255) >= n)
+      return H2Fail(H2_PROTOCOL_ERROR);
+    n -= 1 + (p[0] & 255);
+    ++p;
+  }
+  if (!id || id > h2.lastid)
+    return H2Fail(H2_PROTOCOL_ERROR);
+  if (!(s = H2FindStream(id, &i)) || s->ended)
+    return 0;  // stream was refused, reset, or already closed
+  s->credit += m;
+  if (s->bodyleft != -1) {
+    if ((int64_t)n > s->bodyleft)
+      return H2Fail(H2_PROTOCOL_ERROR);
+    s->bodyleft -= n;
+    H2Append(&s->req, p, n);
+  } else if (n) {
+    H2Append(&s->req, b, snprintf(b, sizeof(b), "%zx\r\n", n));
+    H2Append(&s->req, p, n);
+    H2Append(&s->req, "\r\n", 2);
+  }
+  if (flags & H2_END_STREAM) {
+    if (s->bodyleft > 0)
+      return H2Fail(H2_PROTOCOL_ERROR);
+    H2EndRequest(s);
+  }
+  return 0;
+}
+
+static int H2OnReset(uint32_t id) {
+  size_t i;
+  struct H2Stream *s;
+  if (!(s = H2FindStream(id, &i)) || i < h2.wr)
+    return 0;
+  if (i > h2.rd || (i == h2.rd && !s->started)) {
+    H2RemoveStream(i);
+    return 0;
+  }
+  s->reset = true;
+  if (!s->ended) {
+    // request text that's partly been read can only be ended if chunked
+    if (!s->chunked)
+      return H2Fail(H2_PROTOCOL_ERROR);
+    H2EndRequest(s);
+  }
+  return 0;
+}
+
+static int H2OnSettings(int flags, const char *p, size_t n) {
+  size_t i;
+  int64_t x;
+  if (flags & H2_ACK)
+    return n ? H2Fail(H2_FRAME_SIZE_ERROR) : 0;
+  if (n % 6)
+    return H2Fail(H2_FRAME_SIZE_ERROR);
+  for (; n; p += 6, n -= 6) {
+    x = READ32BE(p + 2);
+    switch (READ16BE(p)) {
+      case 4:  // SETTINGS_INITIAL_WINDOW_SIZE
+        if (x > 0x7fffffff)
+          return H2Fail(H2_FLOW_CONTROL);
+        for (i = 0; i < h2.streams.n; ++i)
+          h2.streams.p[i]->window += x - h2.initwindow;
+        h2.initwindow = x;
+        break;
+      case 5:  // SETTINGS_MAX_FRAME_SIZE
+        if (x < 16384 || x > 16777215)
+          return H2Fail(H2_PROTOCOL_ERROR);
+        h2.maxframe = x;
+        break;
+      default:
+        break;
+    }
+  }
+  return H2SendFrame(H2_SETTINGS, H2_ACK, 0, 0, 0);
+}
+
+static int H2OnWindowUpdate(uint32_t id, const char *p, size_t n) {
+  size_t i;
+  int64_t x;
+  int64_t *w;
+  struct H2Stream *s;
+  if (n != 4)
+    return H2Fail(H2_FRAME_SIZE_ERROR);
+  x = READ32BE(p) & 0x7fffffff;
+  if (id) {
+    if (!(s = H2FindStream(id, &i)))
+      return 0;
+    w = &s->window;
+  } else {
+    w = &h2.window;
+  }
+  if (!x || *w + x > 0x7fffffff)
+    return H2Fail(!x ? H2_PROTOCOL_ERROR : H2_FLOW_CONTROL);
+  *w += x;
+  return 0;
+}
+
+static int H2OnFrame(int type, int flags, uint32_t id, const char *p,
+                     size_t n) {
+  int rc;
+  if (h2.blockid && (type != H2_CONTINUATION || id != h2.blockid))
+    return H2Fail(H2_PROTOCOL_ERROR);
+  switch (type) {
+    case H2_DATA:
+      return H2OnData(id, flags, p, n);
+    case H2_HEADERS:
+      if (!id)
+        return H2Fail(H2_PROTOCOL_ERROR);
+      if (flags & H2_PADDED) {
+        if (!n || (p[0] & 255) >= n)
+          return H2Fail(H2_PROTOCOL_ERROR);
+        n -= 1 + (p[0] & 255);
+        ++p;
+      }
+      if (flags & H2_PRIORITIZED) {
+        if (n < 5)
+          return H2Fail(H2_PROTOCOL_ERROR);
+        p += 5;
+        n -= 5;
+      }
+      h2.blockid = id;
+      h2.blockflags = flags;
+      // fallthrough
+    case H2_CONTINUATION:
+      if (!h2.blockid)
+        return H2Fail(H2_PROTOCOL_ERROR);
+      if (h2.block.n + n > H2MAXBLOCK)
+        return H2Fail(H2_PROTOCOL_ERROR);
+      H2Append(&h2.block, p, n);
+      if (!(flags & H2_END_HEADERS))
+        return 0;
+      rc = H2OnHeaderBlock();
+      h2.blockid = 0;
+      return rc;
+    case H2_RST_STREAM:
+      if (n != 4)
+        return H2Fail(H2_FRAME_SIZE_ERROR);
+      if (!id)
+        return H2Fail(H2_PROTOCOL_ERROR);
+      return H2OnReset(id);
+    case H2_SETTINGS:
+      if (id)
+        return H2Fail(H2_PROTOCOL_ERROR);
+      return H2OnSettings(flags, p, n);
+    case H2_PUSH_PROMISE:
+      return H2Fail(H2_PROTOCOL_ERROR);
+    case H2_PING:
+      if (n != 8)
+        return H2Fail(H2_FRAME_SIZE_ERROR);
+      if (id)
+        return H2Fail(H2_PROTOCOL_ERROR);
+      if (flags & H2_ACK)
+        return 0;
+      return H2SendFrame(H2_PING, H2_ACK, 0, p, 8);
+    case H2_GOAWAY:
+      h2.peergone = true;
+      return 0;
+    case H2_WINDOW_UPDATE:
+      return H2OnWindowUpdate(id, p, n);
+    default:
+      return 0;  // priority and unknown frames are ignored
+  }
+}
+
+// reads more frames from client and acts on them
+static ssize_t H2Fill(void) {
+  char *p;
+  ssize_t rc;
+  size_t n, m;
+  if (h2.in.i) {
+    memmove(h2.in.p, h2.in.p + h2.in.i, h2.in.n - h2.in.i);
+    h2.in.n -= h2.in.i;
+    h2.in.i = 0;
+  }
+  H2Reserve(&h2.in, 9 + H2MAXFRAME);
+  if ((rc = h2.reader(client, h2.in.p + h2.in.n, h2.in.c - h2.in.n)) <= 0)
+    return rc;
+  h2.in.n += rc;
+  for (;;) {
+    p = h2.in.p + h2.in.i;
+    n = h2.in.n - h2.in.i;
+    if (!h2.preface) {
+      m = MIN(n, 24);
+      if (memcmp(p, "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n", m)) {
+        H2Fail(H2_PROTOCOL_ERROR);
+        break;
+      }
+      if (m < 24)
+        break;
+      h2.in.i += 24;
+      h2.preface = true;
+      continue;
+    }
+    if (n < 9)
+      break;
+    m = (p[0] & 255) << 16 | (p[1] & 255) << 8 | (p[2] & 255);
+    if (m > H2MAXFRAME) {
+      H2Fail(H2_FRAME_SIZE_ERROR);
+      break;
+    }
+    if (n < 9 + m)
+      break;
+    h2.in.i += 9 + m;
+    if (H2OnFrame(p[3] & 255, p[4] & 255, READ32BE(p + 5) & 0x7fffffff, p + 9,
+                  m) == -1) {
+      h2.failed = true;  // client was sent GOAWAY, or can't be written
+      break;
+    }
+  }
+  return rc;
+}
+
+// waits for client to grant more window while a response is blocked
+static int H2Pump(void) {
+  ssize_t rc;
+  for (;;) {
+    if (h2.failed || (rc = H2Fill()) == 0) {
+      errno = ECONNRESET;
+      return -1;
+    } else if (rc > 0) {
+      return 0;
+    } else if (errno == EINTR) {
+      errno = 0;
+      if (killed || IsTakingTooLong())
+        return -1;
+    } else {
+      return -1;
+    }
+  }
+}
+
+static ssize_t H2Read(int fd, void *buf, size_t size) {
+  size_t n;
+  ssize_t rc;
+  struct H2Stream *s;
+  for (;;) {
+    H2Collect();
+    if (h2.rd < h2.streams.n) {
+      s = h2.streams.p[h2.rd];
+      if ((n = MIN(size, s->req.n - s->req.i))) {
+        memcpy(buf, s->req.p + s->req.i, n);
+        s->req.i += n;
+        s->started = true;
+        if (s->req.i == s->req.n && s->credit && !s->ended) {
+          if (H2SendCode(H2_WINDOW_UPDATE, s->id, s->credit) == -1)
+            return -1;
+          s->credit = 0;
+        }
+        return n;
+      } else if (s->ended) {
+        ++h2.rd;
+        continue;
+      }
+    }
+    if (h2.failed || (h2.peergone && h2.rd == h2.streams.n))
+      return 0;
+    if ((rc = H2Fill()) <= 0)
+      return rc;
+  }
+}
+
+static int H2SendData(const char *p, size_t n, bool end) {
+  size_t m;
+  int64_t w;
+  struct H2Stream *s;
+  if (!(s = h2.cur) || (!n && !end))
+    return 0;
+  for (;;) {
+    if (s->reset)
+      return 0;
+    m = MIN(n, h2.maxframe);
+    if ((w = MIN(h2.window, s->window)) < (int64_t)m)
+      m = MAX(w, 0);
+    if (n && !m) {
+      if (H2Pump() == -1)
+        return -1;
+      continue;
+    }
+    if (H2SendFrame(H2_DATA, end && m == n ? H2_END_STREAM : 0, s->id, p,
+                    m) == -1)
+      return -1;
+    h2.window -= m;
+    s->window -= m;
+    p += m;
+    n -= m;
+    if (!n)
+      return 0;
+  }
+}
+
+static void H2EndResponse(void) {
+  if (h2.cur) {
+    h2.doneid = h2.cur->id;
+    ++h2.wr;
+  }
+  h2.cur = 0;
+  h2.body = H2_BODY_NONE;
+}
+
+// turns http/1.1 response head into a HEADERS frame for current stream
+static int H2OnHead(char *p, size_t n) {
+  int rc;
+  int64_t length;
+  unsigned status;
+  struct H2Stream *s;
+  bool chunked, closing;
+  size_t i, kn, vn, m;
+  char *q, *e, *k, *v, *b, *nl;
+  if (n < 12 || memcmp(p, "HTTP/1.", 7) || !isdigit(p[9]) ||
+      !isdigit(p[10]) || !isdigit(p[11])) {
+    errno = EPROTO;
+    return -1;
+  }
+  status = (p[9] - '0') * 100 + (p[10] - '0') * 10 + (p[11] - '0');
+  if (status < 200)
+    return 0;  // e.g. 100 continue has no meaning here
+  if (h2.wr < h2.streams.n &&
+      (h2.wr < h2.rd || h2.streams.p[h2.wr]->started)) {
+    s = h2.cur = h2.streams.p[h2.wr];
+  } else {
+    s = h2.cur = 0;  // e.g. 408 timeout sent before any request
+  }
+  b = xmalloc(n * 9 + 64);
+  q = EncodeHpackHeader(b, ":status", 7, p + 9, 3);
+  chunked = closing = false;
+  length = -1;
+  e = p + n;
+  for (p = memchr(p, '\n', n) + 1; p < e; p = nl + 1) {
+    nl = memchr(p, '\n', e - p);  // found since head ends with crlfcrlf
+    m = nl - p;
+    if (m && p[m - 1] == '\r')
+      --m;
+    if (!m)
+      break;
+    if (!(v = memchr(p, ':', m)))
+      continue;
+    k = p;
+    kn = v - p;
+    vn = p + m - ++v;
+    while (vn && (*v == ' ' || *v == '\t'))
+      ++v, --vn;
+    for (i = 0; i < kn; ++i)
+      k[i] = tolower(k[i]);
+    switch (GetHttpHeader(k, kn)) {
+      case kHttpConnection:
+        closing |= SlicesEqualCase(v, vn, "close", 5);
+        break;
+      case kHttpTransferEncoding:
+        chunked = true;
+        break;
+      case kHttpKeepAlive:
+      case kHttpProxyConnection:
+      case kHttpUpgrade:
+        break;
+      case kHttpContentLength:
+        length = ParseContentLength(v, vn);
+        // fallthrough
+      default:
+        q = EncodeHpackHeader(q, k, kn, v, vn);
+        break;
+    }
+  }
+  if ((s && s->head) || status == 204 || status == 304 || !length) {
+    h2.body = H2_BODY_NONE;
+  } else if (chunked) {
+    h2.body = H2_BODY_CHUNKED;
+    bzero(&h2.u, sizeof(h2.u));
+  } else if (length > 0) {
+    h2.body = H2_BODY_LENGTH;
+    h2.bodyleft = length;
+  } else {
+    h2.body = H2_BODY_CLOSE;
+  }
+  rc = 0;
+  if (s && !s->reset) {
+    for (p = b, n = q - b, i = 0;; ++i) {
+      m = MIN(n, h2.maxframe);
+      if ((rc = H2SendFrame(
+               i ? H2_CONTINUATION : H2_HEADERS,
+               (m == n ? H2_END_HEADERS : 0) |
+                   (!i && h2.body == H2_BODY_NONE ? H2_END_STREAM : 0),
+               s->id, p, m)) == -1 ||
+          !(n -= m))
+        break;
+      p += m;
+    }
+  }
+  free(b);
+  if (closing && s && !h2.goaway)
+    H2SendGoaway(s->id, H2_NO_ERROR);
+  if (h2.body == H2_BODY_NONE)
+    H2EndResponse();
+  return rc;
+}
+
+// consumes http/1.1 response text written by the handler
+static int H2Output(const char *p, size_t n) {
+  ssize_t rc;
+  size_t m, k, l;
+  char *e, *rest;
+  while (n) {
+    switch (h2.body) {
+      case H2_BODY_NONE:
+        m = h2.out.n;
+        H2Append(&h2.out, p, n);
+        if (!(e = memmem(h2.out.p + (m > 3 ? m - 3 : 0),
+                         h2.out.n - (m > 3 ? m - 3 : 0), "\r\n\r\n", 4))) {
+          return 0;
+        }
+        k = e + 4 - h2.out.p;
+        p += k - m;
+        n -= k - m;
+        h2.out.n = 0;
+        if (H2OnHead(h2.out.p, k) == -1)
+          return -1;
+        break;
+      case H2_BODY_LENGTH:
+        m = MIN((int64_t)n, h2.bodyleft);
+        h2.bodyleft -= m;
+        if (H2SendData(p, m, !h2.bodyleft) == -1)
+          return -1;
+        p += m;
+        n -= m;
+        if (!h2.bodyleft)
+          H2EndResponse();
+        break;
+      case H2_BODY_CHUNKED:
+        H2Append(&h2.out, p, n);
+        n = 0;
+        if ((rc = Unchunk(&h2.u, h2.out.p, h2.out.n, &l)) == -1)
+          return -1;
+        if (H2SendData(h2.out.p, h2.u.j, rc > 0) == -1)
+          return -1;
+        if (!rc) {
+          h2.out.n = h2.u.i = h2.u.j = 0;
+          break;
+        }
+        // anything past the terminal chunk belongs to the next response
+        H2EndResponse();
+        k = h2.out.n - rc;
+        rest = xmalloc(k + 1);
+        memcpy(rest, h2.out.p + rc, k);
+        h2.out.n = 0;
+        rc = H2Output(rest, k);
+        free(rest);
+        return rc;
+      case H2_BODY_CLOSE:
+        return H2SendData(p, n, false);
+      default:
+        __builtin_unreachable();
+    }
+  }
+  return 0;
+}
+
+static ssize_t H2Write(int fd, struct iovec *iov, int iovlen) {
+  int i, e;
+  ssize_t rc;
+  for (rc = i = 0; i < iovlen; ++i) {
+    if (h2.failed) {
+      errno = ECONNRESET;
+      return -1;
+    }
+    if (H2Output(iov[i].iov_base, iov[i].iov_len) == -1) {
+      e = errno;
+      if (e == EPROTO || e == EBADMSG)
+        H2Fail(H2_INTERNAL_ERROR);  // response couldn't be framed
+      h2.failed = true;
+      errno = e;
+      return -1;
+    }
+    rc += iov[i].iov_len;
+  }
+  return rc;
+}
+
+static void H2Setup(void) {
+  unsigned char b[6];
+  LockIncCounter(http2);
+  DEBUGF("(h2) %s speaking http/2", DescribeClient());
+  h2.active = true;
+  h2.reader = reader;
+  h2.writer = writer;
+  h2.maxframe = 16384;
+  h2.window = h2.initwindow = 65535;
+  InitHpackTable(&h2.hpack, 4096);
+  reader = H2Read;
+  writer = H2Write;
+  WRITE16BE(b, 3);  // SETTINGS_MAX_CONCURRENT_STREAMS
+  WRITE32BE(b + 2, H2MAXSTREAMS);
+  H2SendFrame(H2_SETTINGS, 0, 0, b, sizeof(b));
+}
+
+// says goodbye to an http/2 client, ending close-delimited payloads
+static void H2Shutdown(void) {
+  if (h2.failed)
+    return;
+  if (h2.body == H2_BODY_CLOSE) {
+    H2SendData(0, 0, true);
+    H2EndResponse();
+  }
+  if (!h2.goaway) {
+    H2SendGoaway(h2.doneid, H2_NO_ERROR);
+  }
+}
+
+static void H2Destroy(void) {
+  size_t i;
+  for (i = 0; i < h2.streams.n; ++i)
+    H2FreeStream(h2.streams.p[i]);
+  free(h2.streams.p);
+  free(h2.in.p);
+  free(h2.out.p);
+  free(h2.block.p);
+  DestroyHpackTable(&h2.hpack);
+  bzero(&h2, sizeof(h2));
+}
+
+static void NotifyClose(void) {
+#ifndef UNSECURE
+  if (h2.active)
+    H2Shutdown();
+  // mbedtls no longer owns the write side once kernel tls is enabled
+  if (usingssl && !usingktls) {
+    DEBUGF("(ssl) SSL notifying close");
+    mbedtls_ssl_close_notify(&ssl);
+  }
+#endif
+}
+
+static void WipeSigningKeys(void) {
+  size_t i;
+  if (uniprocess || ispreforkworker)
+    return;
+  for (i = 0; i < certs.n; ++i) {
+    if (!certs.p[i].key)
+      continue;
+    if (!certs.p[i].cert)
+      continue;
+    if (!certs.p[i].cert->ca_istrue)
+      continue;
+    mbedtls_pk_free(certs.p[i].key);
+    Free(&certs.p[i].key);
+  }
+}
+
+static void PsksDestroy(void) {
+  size_t i;
+  for (i = 0; i < psks.n; ++i) {
+    mbedtls_platform_zeroize(psks.p[i].key, psks.p[i].key_len);
+    free(psks.p[i].key);
+    free(psks.p[i].identity);
+  }
+  Free(&psks.p);
+  psks.n = 0;
+}
+
+static void WipeServingKeys(void) {
+  if (uniprocess || ispreforkworker)
+    return;
+  mbedtls_ssl_ticket_free(&ssltick);
+  mbedtls_ssl_key_cert_free(conf.key_cert), conf.key_cert = 0;
+  CertsDestroy(&certs);
+  PsksDestroy();
+}
+
+// server write key and implicit iv from the most recent key derivation
+static struct KtlsKeys {
+  size_t keylen;
+  size_t ivlen;
+  unsigned char key[32];
+  unsigned char iv[12];
+} ktlskeys;
+
+static int TlsExportKeys(void *ctx, const unsigned char *ms,
+                         const unsigned char *kb, size_t maclen, size_t keylen,
+                         size_t ivlen) {
+  // key block is client mac, server mac, client key, server key, etc.
+  if (!maclen && keylen <= sizeof(ktlskeys.key) &&
+      ivlen <= sizeof(ktlskeys.iv)) {
+    ktlskeys.keylen = keylen;
+    ktlskeys.ivlen = ivlen;
+    memcpy(ktlskeys.key, kb + keylen, keylen);
+    memcpy(ktlskeys.iv, kb + keylen * 2 + ivlen, ivlen);
+  } else {
+    ktlskeys.keylen = 0;
+  }
+  return 0;
+}
+
+// hands the transmit half of a tls 1.2 aead session to linux, so that
+// responses can be written with writev() and sendfile() in plaintext.
+// the layout is struct tls12_crypto_info_{aes_gcm_128,aes_gcm_256,
+// chacha20_poly1305} from linux/tls.h
+static bool EnableKernelTls(void) {
+  size_t n;
+  unsigned char b[4 + 12 + 32 + 4 + 8], *p;
+  const mbedtls_ssl_ciphersuite_t *cs;
+  if (!kerneltls || !SOL_TLS || !ktlskeys.keylen)
+    return false;
+  if (ssl.minor_ver != MBEDTLS_SSL_MINOR_VERSION_3)
+    return false;
+  if (!(cs = mbedtls_ssl_ciphersuite_from_id(ssl.session->ciphersuite)))
+    return false;
+  WRITE16LE(b, 0x0303);  // TLS_1_2_VERSION
+  p = b + 4;
+  switch (cs->cipher) {
+    case MBEDTLS_CIPHER_AES_128_GCM:
+    case MBEDTLS_CIPHER_AES_256_GCM:
+      if (ktlskeys.ivlen != 4)
+        return false;
+      WRITE16LE(b + 2, ktlskeys.keylen == 16 ? 51 : 52);
+      p = mempcpy(p, ssl.cur_out_ctr, 8);  // explicit nonce
+      p = mempcpy(p, ktlskeys.key, ktlskeys.keylen);
+      p = mempcpy(p, ktlskeys.iv, 4);  // salt
+      p = mempcpy(p, ssl.cur_out_ctr, 8);
+      break;
+    case MBEDTLS_CIPHER_CHACHA20_POLY1305:
+      if (ktlskeys.ivlen != 12 || ktlskeys.keylen != 32)
+        return false;
+      WRITE16LE(b + 2, 54);
+      p = mempcpy(p, ktlskeys.iv, 12);
+      p = mempcpy(p, ktlskeys.key, 32);
+      p = mempcpy(p, ssl.cur_out_ctr, 8);
+      break;
+    default:
+      return false;
+  }
+  n = p - b;
+  mbedtls_platform_zeroize(&ktlskeys, sizeof(ktlskeys));
+  if (setsockopt(client, IPPROTO_TCP, TCP_ULP, "tls", 4) == -1 ||
+      setsockopt(client, SOL_TLS, 1 /* TLS_TX */, b, n) == -1) {
+    DEBUGF("(ssl) %s kernel tls unavailable: %m", DescribeClient());
+    mbedtls_platform_zeroize(b, sizeof(b));
+    return false;
+  }
+  mbedtls_platform_zeroize(b, sizeof(b));
+  LockIncCounter(sslktls);
+  return true;
+}
+
+static bool TlsSetup(void) {
+  int r;
+  const char *alpn;
+  oldin.p = inbuf.p;
+  oldin.n = amtread;
+  inbuf.p += amtread;
+  inbuf.n -= amtread;
+  inbuf.c = amtread;
+  amtread = 0;
+  g_bio.fd = client;
+  g_bio.a = 0;
+  g_bio.b = 0;
+  g_bio.c = 0;
+  sslpskindex = 0;
+  for (;;) {
+    if (!(r = mbedtls_ssl_handshake(&ssl)) && TlsFlush(&g_bio, 0, 0) != -1) {
+      LockIncCounter(sslhandshakes);
+      RecordLatency(0, kLatencyHandshake,
+                    timespec_sub(timespec_real(), startrequest));
+      g_bio.c = -1;
+      usingssl = true;
+      reader = SslRead;
+      if ((usingktls = EnableKernelTls())) {
+        writer = WritevAll;
+      } else {
+        writer = SslWrite;
+      }
+      if ((alpn = mbedtls_ssl_get_alpn_protocol(&ssl)) && !strcmp(alpn, "h2"))
+        H2Setup();
+      WipeServingKeys();
+      VERBOSEF("(ssl) shaken %s %s %s%s %s", DescribeClient(),
+               mbedtls_ssl_get_ciphersuite(&ssl), mbedtls_ssl_get_version(&ssl),
+               ssl.session->compression ? " COMPRESSED" : "",
+               ssl.curve ? ssl.curve->name : "uncurved");
+      DEBUGF("(ssl) client ciphersuite preference was %s",
+             gc(FormatSslClientCiphers(&ssl)));
+      return true;
+    } else if (r == MBEDTLS_ERR_SSL_WANT_READ) {
+      LockIncCounter(handshakeinterrupts);
+      if (terminated || killed || IsTakingTooLong()) {
+        return false;
+      }
+    } else {
+      LockIncCounter(sslhandshakefails);
+      mbedtls_ssl_session_reset(&ssl);
+      switch (r) {
+        case MBEDTLS_ERR_SSL_CONN_EOF:
+          DEBUGF("(ssl) %s SSL handshake EOF", DescribeClient());
+          return false;
+        case MBEDTLS_ERR_NET_CONN_RESET:
+          DEBUGF("(ssl) %s SSL handshake reset", DescribeClient());
+          return false;
+        case MBEDTLS_ERR_SSL_TIMEOUT:
+          LockIncCounter(ssltimeouts);
+          DEBUGF("(ssl) %s %s", DescribeClient(), "ssltimeouts");
+          return false;
+        case MBEDTLS_ERR_SSL_NO_CIPHER_CHOSEN:
+          LockIncCounter(sslnociphers);
+          WARNF("(ssl) %s %s %s", DescribeClient(), "sslnociphers",
+                gc(FormatSslClientCiphers(&ssl)));
+          return false;
+        case MBEDTLS_ERR_SSL_NO_USABLE_CIPHERSUITE:
+          LockIncCounter(sslcantciphers);
+          WARNF("(ssl) %s %s %s", DescribeClient(), "sslcantciphers",
+                gc(FormatSslClientCiphers(&ssl)));
+          return false;
+        case MBEDTLS_ERR_SSL_BAD_HS_PROTOCOL_VERSION:
+          LockIncCounter(sslnoversion);
+          WARNF("(ssl) %s %s %s", DescribeClient(), "sslnoversion",
+                mbedtls_ssl_get_version(&ssl));
+          return false;
+        case MBEDTLS_ERR_SSL_INVALID_MAC:
+          LockIncCounter(sslshakemacs);
+          WARNF("(ssl) %s %s", DescribeClient(), "sslshakemacs");
+          return false;
+        case MBEDTLS_ERR_SSL_NO_CLIENT_CERTIFICATE:
+          LockIncCounter(sslnoclientcert);
+          WARNF("(ssl) %s %s", DescribeClient(), "sslnoclientcert");
+          NotifyClose();
+          return false;
+        case MBEDTLS_ERR_X509_CERT_VERIFY_FAILED:
+          LockIncCounter(sslverifyfailed);
+          WARNF("(ssl) %s SSL %s", DescribeClient(),
+                gc(DescribeSslVerifyFailure(
+                    ssl.session_negotiate->verify_result)));
+          return false;
+        case MBEDTLS_ERR_SSL_FATAL_ALERT_MESSAGE:
+          switch (ssl.fatal_alert) {
+            case MBEDTLS_SSL_ALERT_MSG_CERT_UNKNOWN:
+              LockIncCounter(sslunknowncert);
+              DEBUGF("(ssl) %s %s", DescribeClient(), "sslunknowncert");
+              return false;
+            case MBEDTLS_SSL_ALERT_MSG_UNKNOWN_CA:
+              LockIncCounter(sslunknownca);
+              DEBUGF("(ssl) %s %s", DescribeClient(), "sslunknownca");
+              return false;
+            default:
+              WARNF("(ssl) %s SSL shakealert %s", DescribeClient(),
+                    GetAlertDescription(ssl.fatal_alert));
+              return false;
+          }
+        default:
+          WARNF("(ssl) %s SSL handshake failed -0x%04x", DescribeClient(), -r);
+          return false;
+      }
+    }
+  }
+}
+
+static void ConfigureCertificate(mbedtls_x509write_cert *cw, struct Cert *ca,
+                                 int usage, int type) {
+  int nsan = 0;
+  char *name = 0;
+  struct mbedtls_san *san = 0;
+
+  // for each ip address owned by this system
+  //
+  //   1. determine its full-qualified domain name
+  //   2. add subject alt name (san) entry to cert for hostname
+  //   3. add subject alt name (san) entry to cert for *.hostname
+  //
+  for (int i = 0; i < ips.n; ++i) {
+    uint32_t ip = ips.p[i];
+    if (IsLoopbackIp(ip))
+      continue;
+    char rname[NI_MAXHOST];
+    struct sockaddr_in addr4 = {AF_INET, 0, {htonl(ip)}};
+    if (getnameinfo((struct sockaddr *)&addr4, sizeof(addr4), rname,
+                    sizeof(rname), 0, 0, NI_NAMEREQD) == 0) {
+      char *s = gc(strdup(rname));
+      if (!name)
+        name = s;
+      bool isduplicate = false;
+      for (int j = 0; j < nsan; ++j) {
+        if (san[j].tag == MBEDTLS_X509_SAN_DNS_NAME &&
+            !strcasecmp(s, san[j].val)) {
+          isduplicate = true;
+          break;
+        }
+      }
+      if (!isduplicate) {
+        san = realloc(san, (nsan += 2) * sizeof(*san));
+        san[nsan - 2].tag = MBEDTLS_X509_SAN_DNS_NAME;
+        san[nsan - 2].val = s;
+        san[nsan - 1].tag = MBEDTLS_X509_SAN_DNS_NAME;
+        san[nsan - 1].val = gc(xasprintf("*.%s", s));
+      }
+    }
+  }
+
   // add san entry to cert for each ip address owned by system
   for (int i = 0; i < ips.n; ++i) {
     uint32_t ip = ips.p[i];
@@ -1902,6 +3149,11 @@ static bool ClientAcceptsGzip(void) {
          HeaderHas(&cpm.msg, inbuf.p, kHttpAcceptEncoding, "gzip", 4);
 }
 
+static bool ClientAcceptsEncoding(const char *s) {
+  return cpm.msg.version >= 11 &&
+         HeaderHas(&cpm.msg, inbuf.p, kHttpAcceptEncoding, s, strlen(s));
+}
+
 char *FormatUnixHttpDateTime(char *s, int64_t t) {
   struct tm tm;
   gmtime_r(&t, &tm);
@@ -1928,7 +3180,12 @@ static int64_t GetGmtOffset(int64_t t) {
 
 forceinline bool IsCompressed(struct Asset *a) {
   return !a->file &&
-         ZIP_LFILE_COMPRESSIONMETHOD(zmap + a->lf) == kZipCompressionDeflate;
+         ZIP_LFILE_COMPRESSIONMETHOD(zmap + a->lf) != kZipCompressionNone;
+}
+
+forceinline bool IsZstd(struct Asset *a) {
+  return !a->file &&
+         ZIP_LFILE_COMPRESSIONMETHOD(zmap + a->lf) == kZipCompressionZstd;
 }
 
 forceinline int GetMode(struct Asset *a) {
@@ -1936,22 +3193,34 @@ forceinline int GetMode(struct Asset *a) {
 }
 
 forceinline bool IsCompressionMethodSupported(int method) {
-  return method == kZipCompressionNone || method == kZipCompressionDeflate;
-}
+  return method == kZipCompressionNone || method == kZipCompressionDeflate ||
+         method == kZipCompressionZstd;
+}
+
+// precompressed siblings, e.g. `app.js.zst` for `app.js`, which are
+// listed in order of preference, and must be stored without deflate
+static const struct Variant {
+  char ext[4];
+  char encoding[5];
+} kVariants[] = {
+    {"zst", "zstd"},  //
+    {"br", "br"},     //
+};
 
-static inline unsigned Hash(const void *p, unsigned long n) {
-  unsigned h, i;
-  for (h = i = 0; i < n; i++) {
-    h += ((unsigned char *)p)[i];
-    h *= 0x9e3779b1;
-  }
-  return MAX(1, h);
+// keyed at startup so remote peers can't precompute colliding paths
+static uint64_t kAssetHashKey[4];
+
+static inline uint64_t Hash(const void *p, unsigned long n) {
+  uint64_t h;
+  h = HighwayHash64(p, n, kAssetHashKey);
+  return h | !(uint32_t)h;
 }
 
 static void FreeAssets(void) {
   size_t i;
   for (i = 0; i < assets.n; ++i) {
     Free(&assets.p[i].lastmodifiedstr);
+    Free(&assets.p[i].bytecode);
   }
   Free(&assets.p);
   assets.n = 0;
@@ -1970,13 +3239,71 @@ static unsigned long roundup2pow(unsigned long x) {
   return x > 1 ? 2ul << bsrl(x - 1) : x ? 1 : 0;
 }
 
-static void IndexAssets(void) {
-  uint64_t cf;
-  struct Asset *p;
+static struct Asset *GetAssetZip(const char *, size_t);
+
+static void IndexVariants(void) {
+  size_t k;
+  uint8_t *zcf;
+  const char *s;
+  struct Asset *a;
+  uint32_t i, j, n;
+  for (i = 0; i < assets.n; ++i) {
+    if (!assets.p[i].hash)
+      continue;
+    zcf = zmap + assets.p[i].cf;
+    if (ZIP_CFILE_COMPRESSIONMETHOD(zcf) != kZipCompressionNone)
+      continue;
+    s = ZIP_CFILE_NAME(zcf);
+    n = ZIP_CFILE_NAMESIZE(zcf);
+    for (j = 0; j < ARRAYLEN(kVariants); ++j) {
+      k = strlen(kVariants[j].ext);
+      if (n > k + 1 && s[n - k - 1] == '.' &&
+          !memcmp(s + n - k, kVariants[j].ext, k) &&
+          (a = GetAssetZip(s, n - k - 1))) {
+        a->variants |= 1 << j;
+      }
+    }
+  }
+}
+
+// finds entry from the previous index whose central directory record
+// is byte-for-byte identical, so its formatted timestamp can be reused
+static struct Asset *FindUnchangedAsset(struct Assets *old,
+                                        const uint8_t *oldmap,
+                                        const uint8_t *zcf, uint64_t hash) {
+  uint32_t i, step;
+  if (!old->p || !oldmap)
+    return NULL;
+  for (step = 0;; ++step) {
+    i = ((uint32_t)hash + ((step * (step + 1)) >> 1)) & (old->n - 1);
+    if (!old->p[i].hash)
+      return NULL;
+    if ((uint32_t)hash == old->p[i].hash &&
+        (uint8_t)(hash >> 56) == old->p[i].tag &&
+        old->p[i].lastmodifiedstr &&
+        ZIP_CFILE_HDRSIZE(zcf) == ZIP_CFILE_HDRSIZE(oldmap + old->p[i].cf) &&
+        !memcmp(zcf, oldmap + old->p[i].cf, ZIP_CFILE_HDRSIZE(zcf))) {
+      return &old->p[i];
+    }
+  }
+}
+
+static void IndexAssets(const uint8_t *oldmap) {
+  uint64_t cf, hash;
+  struct Asset *p, *o;
+  struct Assets old;
   struct timespec lm;
-  uint32_t i, n, m, step, hash;
+  uint32_t i, n, m, step, reused;
   DEBUGF("(zip) indexing assets (inode %#lx)", zst.st_ino);
-  FreeAssets();
+  old = assets;
+  assets.p = 0;
+  assets.n = 0;
+  reused = 0;
+  if (!kAssetHashKey[0]) {
+    for (i = 0; i < ARRAYLEN(kAssetHashKey); ++i) {
+      kAssetHashKey[i] = _rand64() | 1;
+    }
+  }
   CHECK_GE(HASH_LOAD_FACTOR, 2);
   CHECK(READ32LE(zcdir) == kZipCdir64HdrMagic ||
         READ32LE(zcdir) == kZipCdirHdrMagic);
@@ -1997,22 +3324,41 @@ static void IndexAssets(void) {
       i = (hash + ((step * (step + 1)) >> 1)) & (m - 1);
       ++step;
     } while (p[i].hash);
-    GetZipCfileTimestamps(zmap + cf, &lm, 0, 0, gmtoff);
     p[i].hash = hash;
+    p[i].tag = hash >> 56;
+    p[i].namesize = ZIP_CFILE_NAMESIZE(zmap + cf);
     p[i].cf = cf;
     p[i].lf = GetZipCfileOffset(zmap + cf);
     p[i].istext = !!(ZIP_CFILE_INTERNALATTRIBUTES(zmap + cf) & kZipIattrText);
-    p[i].lastmodified = lm.tv_sec;
-    p[i].lastmodifiedstr = FormatUnixHttpDateTime(xmalloc(30), lm.tv_sec);
+    if ((o = FindUnchangedAsset(&old, oldmap, zmap + cf, hash))) {
+      p[i].lastmodified = o->lastmodified;
+      p[i].lastmodifiedstr = o->lastmodifiedstr;
+      p[i].bytecode = o->bytecode;
+      p[i].bytecodesize = o->bytecodesize;
+      o->lastmodifiedstr = 0;
+      o->bytecode = 0;
+      ++reused;
+    } else {
+      GetZipCfileTimestamps(zmap + cf, &lm, 0, 0, gmtoff);
+      p[i].lastmodified = lm.tv_sec;
+      p[i].lastmodifiedstr = FormatUnixHttpDateTime(xmalloc(30), lm.tv_sec);
+    }
   }
+  for (i = 0; i < old.n; ++i) {
+    Free(&old.p[i].lastmodifiedstr);
+    Free(&old.p[i].bytecode);
+  }
+  Free(&old.p);
   assets.p = p;
   assets.n = m;
+  IndexVariants();
+  DEBUGF("(zip) reused %u unchanged assets from previous index", reused);
 }
 
 static bool OpenZip(bool force) {
   int fd;
-  size_t n;
-  uint8_t *m, *d;
+  size_t n, oldsize;
+  uint8_t *m, *d, *oldmap;
   struct stat st;
   if (stat(zpath, &st) != -1) {
     if (force || st.st_ino != zst.st_ino || st.st_size > zst.st_size) {
@@ -2026,16 +3372,20 @@ static bool OpenZip(bool force) {
           MAP_FAILED) {
         n = st.st_size;
         if ((d = GetZipEocd(m, n, 0))) {
-          if (zmap) {
-            LOGIFNEG1(munmap(zmap, zsize));
-          }
+          // old mapping must outlive indexing so entries can be diffed
+          oldmap = zmap;
+          oldsize = zsize;
+          zmapfd = fd;
           zmap = m;
           zsize = n;
           zcdir = d;
           DCHECK(IsZipEocd32(zmap, zsize, zcdir - zmap) == kZipOk ||
                  IsZipEocd64(zmap, zsize, zcdir - zmap) == kZipOk);
           memcpy(&zst, &st, sizeof(st));
-          IndexAssets();
+          IndexAssets(oldmap);
+          if (oldmap) {
+            LOGIFNEG1(munmap(oldmap, oldsize));
+          }
           return true;
         } else {
           WARNF("(zip) couldn't locate central directory");
@@ -2056,16 +3406,21 @@ static bool OpenZip(bool force) {
 }
 
 static struct Asset *GetAssetZip(const char *path, size_t pathlen) {
-  uint32_t i, step, hash;
+  uint64_t hash;
+  uint32_t i, step;
   if (pathlen > 1 && path[0] == '/')
     ++path, --pathlen;
+  if (pathlen > 0xffff || !assets.p)
+    return NULL;
   hash = Hash(path, pathlen);
   for (step = 0;; ++step) {
-    i = (hash + ((step * (step + 1)) >> 1)) & (assets.n - 1);
-    if (i >= assets.n || !assets.p || !assets.p[i].hash)
+    i = ((uint32_t)hash + ((step * (step + 1)) >> 1)) & (assets.n - 1);
+    if (!assets.p[i].hash)
       return NULL;
-    if (hash == assets.p[i].hash &&
-        pathlen == ZIP_CFILE_NAMESIZE(zmap + assets.p[i].cf) &&
+    // reject on the inline fields before touching the central directory
+    if ((uint32_t)hash == assets.p[i].hash &&
+        (uint8_t)(hash >> 56) == assets.p[i].tag &&
+        pathlen == assets.p[i].namesize &&
         memcmp(path, ZIP_CFILE_NAME(zmap + assets.p[i].cf), pathlen) == 0) {
       return &assets.p[i];
     }
@@ -2076,19 +3431,19 @@ static struct Asset *GetAssetFile(const char *path, size_t pathlen) {
   size_t i;
   struct Asset *a;
   if (stagedirs.n) {
-    a = FreeLater(xcalloc(1, sizeof(struct Asset)));
-    a->file = FreeLater(xmalloc(sizeof(struct File)));
+    a = memset(xAllocLater(sizeof(struct Asset)), 0, sizeof(struct Asset));
+    a->file = xAllocLater(sizeof(struct File));
     for (i = 0; i < stagedirs.n; ++i) {
-      LockInc(&shared->c.stats);
+      LockIncCounter(stats);
       a->file->path.s = FreeLater(MergePaths(stagedirs.p[i].s, stagedirs.p[i].n,
                                              path, pathlen, &a->file->path.n));
       if (stat(a->file->path.s, &a->file->st) != -1) {
         a->lastmodifiedstr = FormatUnixHttpDateTime(
-            FreeLater(xmalloc(30)),
+            xAllocLater(30),
             (a->lastmodified = a->file->st.st_mtim.tv_sec));
         return a;
       } else {
-        LockInc(&shared->c.statfails);
+        LockIncCounter(statfails);
       }
     }
   }
@@ -2177,17 +3532,38 @@ static char *AppendContentRange(char *p, long a, long b, long c) {
 }
 
 static bool Inflate(void *dp, size_t dn, const void *sp, size_t sn) {
-  LockInc(&shared->c.inflates);
+  LockIncCounter(inflates);
   return !__inflate(dp, dn, sp, sn);
 }
 
+static bool Unzstd(void *dp, size_t dn, const void *sp, size_t sn) {
+  size_t rc;
+  LockIncCounter(inflates);
+  rc = ZSTD_decompress(dp, dn, sp, sn);
+  if (ZSTD_isError(rc)) {
+    WARNF("(zip) zstd failed: %s", ZSTD_getErrorName(rc));
+    return false;
+  }
+  return rc == dn;
+}
+
+// decompresses zip asset content, which is either deflate or zstd
+static bool Decompress(struct Asset *a, void *dp, size_t dn, const void *sp,
+                       size_t sn) {
+  if (IsZstd(a)) {
+    return Unzstd(dp, dn, sp, sn);
+  } else {
+    return Inflate(dp, dn, sp, sn);
+  }
+}
+
 static bool Verify(void *data, size_t size, uint32_t crc) {
   uint32_t got;
-  LockInc(&shared->c.verifies);
+  LockIncCounter(verifies);
   if (crc == (got = crc32_z(0, data, size))) {
     return true;
   } else {
-    LockInc(&shared->c.thiscorruption);
+    LockIncCounter(thiscorruption);
     WARNF("(zip) corrupt zip file at %`'.*s had crc 0x%08x but expected 0x%08x",
           cpm.msg.uri.b - cpm.msg.uri.a, inbuf.p + cpm.msg.uri.a, got, crc);
     return false;
@@ -2197,7 +3573,7 @@ static bool Verify(void *data, size_t size, uint32_t crc) {
 static void *Deflate(const void *data, size_t size, size_t *out_size) {
   void *res;
   z_stream zs = {0};
-  LockInc(&shared->c.deflates);
+  LockIncCounter(deflates);
   CHECK_EQ(Z_OK, deflateInit2(&zs, 4, Z_DEFLATED, -MAX_WBITS, DEF_MEM_LEVEL,
                               Z_DEFAULT_STRATEGY));
   zs.next_in = data;
@@ -2210,6 +3586,21 @@ static void *Deflate(const void *data, size_t size, size_t *out_size) {
   return xrealloc(res, zs.total_out);
 }
 
+// compresses asset for a `.zst` sibling, hard since it's done once
+static void *Zstd(const void *data, size_t size, size_t *out_size) {
+  void *res;
+  size_t rc;
+  res = xmalloc(ZSTD_compressBound(size));
+  rc = ZSTD_compress(res, ZSTD_compressBound(size), data, size, 19);
+  if (ZSTD_isError(rc)) {
+    WARNF("(zip) zstd failed: %s", ZSTD_getErrorName(rc));
+    free(res);
+    return NULL;
+  }
+  *out_size = rc;
+  return xrealloc(res, rc);
+}
+
 static void *LoadAsset(struct Asset *a, size_t *out_size) {
   size_t size;
   uint8_t *data;
@@ -2222,8 +3613,8 @@ static void *LoadAsset(struct Asset *a, size_t *out_size) {
     if (size == SIZE_MAX || !(data = malloc(size + 1)))
       return NULL;
     if (IsCompressed(a)) {
-      if (!Inflate(data, size, ZIP_LFILE_CONTENT(zmap + a->lf),
-                   GetZipCfileCompressedSize(zmap + a->cf))) {
+      if (!Decompress(a, data, size, ZIP_LFILE_CONTENT(zmap + a->lf),
+                      GetZipCfileCompressedSize(zmap + a->cf))) {
         free(data);
         return NULL;
       }
@@ -2239,7 +3630,7 @@ static void *LoadAsset(struct Asset *a, size_t *out_size) {
       *out_size = size;
     return data;
   } else {
-    LockInc(&shared->c.slurps);
+    LockIncCounter(slurps);
     return xslurp(a->file->path.s, out_size);
   }
 }
@@ -2275,27 +3666,105 @@ static void AppendLogo(void) {
   }
 }
 
+static void HandleSendError(void) {
+  if (errno == ECONNRESET) {
+    LockIncCounter(writeresets);
+    DEBUGF("(rsp) %s write reset", DescribeClient());
+  } else if (errno == EAGAIN) {
+    LockIncCounter(writetimeouts);
+    WARNF("(rsp) %s write timeout", DescribeClient());
+    errno = 0;
+  } else {
+    LockIncCounter(writeerrors);
+    if (errno == EBADF) {  // don't warn on close/bad fd
+      DEBUGF("(rsp) %s write badf", DescribeClient());
+    } else {
+      WARNF("(rsp) %s write error: %m", DescribeClient());
+    }
+  }
+  connectionclose = true;
+}
+
 static ssize_t Send(struct iovec *iov, int iovlen) {
   ssize_t rc;
   if ((rc = writer(client, iov, iovlen)) == -1) {
-    if (errno == ECONNRESET) {
-      LockInc(&shared->c.writeresets);
-      DEBUGF("(rsp) %s write reset", DescribeClient());
-    } else if (errno == EAGAIN) {
-      LockInc(&shared->c.writetimeouts);
-      WARNF("(rsp) %s write timeout", DescribeClient());
+    HandleSendError();
+  }
+  return rc;
+}
+
+// returns file and offset from which response content is mapped
+static int GetContentFile(int64_t *offset) {
+  size_t i;
+  uint8_t *p = (uint8_t *)cpm.content;
+  if (zmap && zmap <= p && p + cpm.contentlength <= zmap + zsize) {
+    *offset = p - zmap;
+    return zmapfd;
+  }
+  for (i = 0; i < unmaplist.n; ++i) {
+    if ((uint8_t *)unmaplist.p[i].p <= p &&
+        p + cpm.contentlength <=
+            (uint8_t *)unmaplist.p[i].p + unmaplist.p[i].n) {
+      *offset = p - (uint8_t *)unmaplist.p[i].p;
+      return unmaplist.p[i].f;
+    }
+  }
+  return -1;
+}
+
+static bool ShouldSendfile(void) {
+  return !nosendfile && (!usingssl || usingktls) && writer == WritevAll &&
+         cpm.contentlength >= MINSENDFILE;
+}
+
+// sends mapped file content to client without copying it to userspace
+static ssize_t SendfileAll(int fd, int64_t offset, struct iovec *iov) {
+  ssize_t rc;
+  size_t total;
+  for (total = 0; total < iov->iov_len;) {
+    if ((rc = sendfile(client, fd, &offset, iov->iov_len - total)) > 0) {
+      total += rc;
+    } else if (!rc) {
+      return total ? total : eio();  // file was truncated
+    } else if (errno == EINTR) {
       errno = 0;
-    } else {
-      LockInc(&shared->c.writeerrors);
-      if (errno == EBADF) {  // don't warn on close/bad fd
-        DEBUGF("(rsp) %s write badf", DescribeClient());
-      } else {
-        WARNF("(rsp) %s write error: %m", DescribeClient());
+      LockIncCounter(writeinterruputs);
+      if (killed || IsTakingTooLong()) {
+        return total ? total : -1;
       }
+    } else if (!total && (errno == ENOSYS || errno == EINVAL ||
+                          errno == EOPNOTSUPP || errno == ENOTSOCK)) {
+      DEBUGF("(rsp) sendfile() unavailable: %m");
+      nosendfile = true;
+      errno = 0;
+      return WritevAll(client, iov, 1);
+    } else {
+      return total ? total : -1;
     }
+  }
+  LockIncCounter(sendfiles);
+  return total;
+}
+
+// sends iov[k] with sendfile() and the other elements normally
+static ssize_t SendWithFile(struct iovec *iov, int iovlen, int k, int fd,
+                            int64_t offset) {
+  ssize_t rc;
+  size_t want;
+  if (k && Send(iov, k) == -1)
+    return -1;
+  want = iov[k].iov_len;
+  if ((rc = SendfileAll(fd, offset, iov + k)) == -1) {
+    HandleSendError();
+    return -1;
+  }
+  if (rc < want) {
     connectionclose = true;
+    return -1;
   }
-  return rc;
+  if (k + 1 < iovlen && Send(iov + k + 1, iovlen - k - 1) == -1)
+    return -1;
+  return 0;
 }
 
 static bool IsSslCompressed(void) {
@@ -2334,6 +3803,245 @@ static char *CommitOutput(char *p) {
   return p;
 }
 
+// response microcache entry, which is followed by the status line and
+// headers, the identity payload, and then the deflated payload if any
+struct Microcache {
+  int64_t fresh;     // unix seconds at which entry becomes stale
+  int64_t stale;     // unix seconds at which entry can't be served
+  uint32_t hdrlen;   // bytes of status line and headers
+  uint32_t bodylen;  // bytes of identity payload
+  uint32_t gziplen;  // bytes of deflated payload, or zero
+  uint32_t crc;      // crc32 of identity payload, for gzip footer
+  uint16_t status;
+  bool branded;
+};
+
+// responses are identified by scheme, host, method, and request target
+// where HEAD requests are answered by what was generated for GET
+static char *GetMicrocacheKey(char tag) {
+  char *k = 0;
+  char method[8];
+  WRITE64LE(method, cpm.msg.method == kHttpHead ? kHttpGet : cpm.msg.method);
+  appendd(&k, &tag, 1);
+  appendd(&k, method, sizeof(method));
+  appendd(&k, url.scheme.p, url.scheme.n);
+  appendd(&k, "", 1);
+  appendd(&k, url.host.p, url.host.n);
+  appendd(&k, "", 1);
+  appendd(&k, inbuf.p + cpm.msg.uri.a, cpm.msg.uri.b - cpm.msg.uri.a);
+  return k;
+}
+
+static void AppendMicrocacheVary(char **k, const char *vary, size_t n) {
+  int h;
+  size_t i, m;
+  const char *name;
+  for (name = vary; name < vary + n; name += m + 1) {
+    m = strlen(name);
+    appendd(k, "", 1);
+    if ((h = GetHttpHeader(name, m)) != -1) {
+      if (HasHeader(h))
+        appendd(k, HeaderData(h), HeaderLength(h));
+    } else {
+      for (i = 0; i < cpm.msg.xheaders.n; ++i) {
+        if (SlicesEqualCase(
+                name, m, inbuf.p + cpm.msg.xheaders.p[i].k.a,
+                cpm.msg.xheaders.p[i].k.b - cpm.msg.xheaders.p[i].k.a)) {
+          appendd(k, inbuf.p + cpm.msg.xheaders.p[i].v.a,
+                  cpm.msg.xheaders.p[i].v.b - cpm.msg.xheaders.p[i].v.a);
+          break;
+        }
+      }
+    }
+  }
+}
+
+// lets one worker regenerate a stale entry while others keep serving
+// it. claims lapse on their own, in case that worker dies or the new
+// response turns out not to be cacheable.
+static bool ClaimMicrocache(const char *k, size_t n, int64_t now) {
+  uint64_t h, old, claim;
+  _Atomic(uint64_t) *slot;
+  h = cosmo_hash(k, n);
+  slot = shared->microclaim + h % MICROCLAIMS;
+  old = atomic_load_explicit(slot, memory_order_relaxed);
+  if ((int64_t)(old >> 32) > now)
+    return false;
+  claim = (uint64_t)(now + MICROCLAIMSECS) << 32 | (uint32_t)h;
+  if (!atomic_compare_exchange_strong_explicit(
+          slot, &old, claim, memory_order_acquire, memory_order_relaxed))
+    return false;
+  cpm.microclaim = slot;
+  cpm.microclaimval = claim;
+  return true;
+}
+
+static void ReleaseMicrocache(void) {
+  uint64_t claim;
+  if (cpm.microclaim) {
+    claim = cpm.microclaimval;
+    atomic_compare_exchange_strong_explicit(
+        cpm.microclaim, &claim, 0, memory_order_release, memory_order_relaxed);
+    cpm.microclaim = 0;
+  }
+}
+
+static char *ServeMicrocacheEntry(struct Microcache *e) {
+  char *p, *hdr, *body;
+  hdr = (char *)(e + 1);
+  body = hdr + e->hdrlen;
+  if (e->hdrlen + 512 > hdrbuf.n) {
+    hdrbuf.n = e->hdrlen + 512 + (hdrbuf.n >> 1);
+    hdrbuf.p = xrealloc(hdrbuf.p, hdrbuf.n);
+  }
+  p = mempcpy(hdrbuf.p, hdr, e->hdrlen);
+  hdrbuf.p[7] = '0' + (cpm.msg.version & 1);
+  cpm.statuscode = e->status;
+  cpm.branded = e->branded;
+  cpm.hascontenttype = true;
+  cpm.referrerpolicy = 0;
+  cpm.content = body;
+  cpm.contentlength = e->bodylen;
+  if (e->gziplen && !IsSslCompressed()) {
+    p = stpcpy(p, "Vary: Accept-Encoding\r\n");
+    if (ClientAcceptsGzip() && !ShouldAvoidGzip()) {
+      cpm.gzipped = e->bodylen;
+      WRITE32LE(gzip_footer + 0, e->crc);
+      WRITE32LE(gzip_footer + 4, e->bodylen);
+      cpm.content = body + e->bodylen;
+      cpm.contentlength = e->gziplen;
+    }
+  }
+  return p;
+}
+
+// serves response generated earlier by a lua handler, if there is one
+// which is fresh, or stale while another worker is regenerating it
+static char *ServeMicrocache(void) {
+  char *k;
+  ssize_t rc;
+  int64_t now;
+  struct Microcache *e;
+  char vary[MICROVARYMAX];
+  if (!responsecache || cpm.msg.version < 10 || payloadlength ||
+      (cpm.msg.method != kHttpGet && cpm.msg.method != kHttpHead))
+    return 0;
+  k = GetMicrocacheKey('V');
+  if ((rc = cosmo_shmap_get(responsecache, k, appendz(k).i, vary,
+                            sizeof(vary))) == -1) {
+    free(k);
+    return 0;
+  }
+  k[0] = 'R';
+  AppendMicrocacheVary(&k, vary, MIN(rc, sizeof(vary)));
+  e = FreeLater(xmalloc(responsecachepayload));
+  rc = cosmo_shmap_get(responsecache, k, appendz(k).i, e,
+                       responsecachepayload);
+  now = timespec_real().tv_sec;
+  if (rc < (ssize_t)sizeof(*e) || now >= e->stale) {
+    LockIncCounter(microcachemisses);
+    free(k);
+    return 0;
+  }
+  if (now >= e->fresh) {
+    if (ClaimMicrocache(k, appendz(k).i, now)) {
+      LockIncCounter(microcachemisses);
+      free(k);
+      return 0;
+    }
+    LockIncCounter(microcachestale);
+  }
+  free(k);
+  LockIncCounter(microcachehits);
+  DEBUGF("(rsp) serving %`'.*s from response cache",
+         cpm.msg.uri.b - cpm.msg.uri.a, inbuf.p + cpm.msg.uri.a);
+  return ServeMicrocacheEntry(e);
+}
+
+static bool IsMicrocacheable(const char *p) {
+  const char *s;
+  if (cpm.msg.method != kHttpGet || cpm.msg.version < 11 || payloadlength ||
+      cpm.generator || cpm.isyielding || cpm.gzipped)
+    return false;
+  switch (cpm.statuscode) {
+    case 200:
+    case 203:
+    case 204:
+    case 300:
+    case 301:
+    case 404:
+    case 405:
+    case 410:
+    case 414:
+    case 501:
+      break;
+    default:
+      return false;
+  }
+  // never hand one client's cookies to another
+  for (s = hdrbuf.p; (s = memchr(s, '\n', p - s));) {
+    if (p - ++s >= 11 && !strncasecmp(s, "Set-Cookie:", 11))
+      return false;
+  }
+  return true;
+}
+
+// stores lua response in shared memory, then serves it like a cache hit
+// would be served, so the first response looks like all the later ones
+static char *CommitMicrocache(char *p) {
+  char *k, *body, *gz;
+  struct Microcache *e;
+  int64_t now;
+  size_t n, hdrlen, bodylen, gziplen;
+  if (cpm.contentlength) {
+    body = cpm.content;
+    bodylen = cpm.contentlength;
+  } else {
+    body = cpm.outbuf;
+    bodylen = appendz(cpm.outbuf).i;
+  }
+  if (!cpm.hascontenttype && bodylen)
+    p = AppendContentType(p, "text/html");
+  if (cpm.referrerpolicy) {
+    p = stpcpy(p, "Referrer-Policy: ");
+    p = AppendCrlf(stpcpy(p, cpm.referrerpolicy));
+  }
+  gz = 0;
+  gziplen = 0;
+  if (!cpm.contentlength && cpm.istext && bodylen >= 100 && !IsTiny())
+    gz = FreeLater(Deflate(body, bodylen, &gziplen));
+  hdrlen = p - hdrbuf.p;
+  n = sizeof(*e) + hdrlen + bodylen + gziplen;
+  e = FreeLater(xmalloc(n));
+  now = timespec_real().tv_sec;
+  e->fresh = now + cpm.microfresh;
+  e->stale = e->fresh + cpm.microstale;
+  e->hdrlen = hdrlen;
+  e->bodylen = bodylen;
+  e->gziplen = gziplen;
+  e->crc = gz ? crc32_z(0, body, bodylen) : 0;
+  e->status = cpm.statuscode;
+  e->branded = cpm.branded;
+  mempcpy(mempcpy(mempcpy(e + 1, hdrbuf.p, hdrlen), body, bodylen), gz,
+          gziplen);
+  DropOutput();
+  k = GetMicrocacheKey('V');
+  if (!cosmo_shmap_put(responsecache, k, appendz(k).i, cpm.microvary,
+                       cpm.microvarylen)) {
+    k[0] = 'R';
+    AppendMicrocacheVary(&k, cpm.microvary, cpm.microvarylen);
+    if (!cosmo_shmap_put(responsecache, k, appendz(k).i, e, n)) {
+      LockIncCounter(microcachestores);
+    } else {
+      DEBUGF("(rsp) %`'.*s too big for response cache",
+             cpm.msg.uri.b - cpm.msg.uri.a, inbuf.p + cpm.msg.uri.a);
+    }
+  }
+  free(k);
+  cpm.microfresh = 0;
+  return ServeMicrocacheEntry(e);
+}
+
 static char *ServeDefaultErrorPage(char *p, unsigned code, const char *reason,
                                    const char *details) {
   p = AppendContentType(p, "text/html; charset=UTF-8");
@@ -2365,7 +4073,7 @@ static char *ServeErrorImplDefault(unsigned code, const char *reason,
   size_t n;
   char *p, *s;
   struct Asset *a;
-  LockInc(&shared->c.errors);
+  LockIncCounter(errors);
   DropOutput();
   p = SetStatus(code, reason);
   s = xasprintf("/%d.html", code);
@@ -2374,7 +4082,7 @@ static char *ServeErrorImplDefault(unsigned code, const char *reason,
   if (!a) {
     return ServeDefaultErrorPage(p, code, reason, details);
   } else if (a->file) {
-    LockInc(&shared->c.slurps);
+    LockIncCounter(slurps);
     cpm.content = FreeLater(xslurp(a->file->path.s, &cpm.contentlength));
     return AppendContentType(p, "text/html; charset=utf-8");
   } else {
@@ -2382,8 +4090,8 @@ static char *ServeErrorImplDefault(unsigned code, const char *reason,
     cpm.contentlength = GetZipCfileCompressedSize(zmap + a->cf);
     if (IsCompressed(a)) {
       n = GetZipLfileUncompressedSize(zmap + a->lf);
-      if ((s = FreeLater(malloc(n))) &&
-          Inflate(s, n, cpm.content, cpm.contentlength)) {
+      if ((s = AllocLater(n)) &&
+          Decompress(a, s, n, cpm.content, cpm.contentlength)) {
         cpm.content = s;
         cpm.contentlength = n;
       } else {
@@ -2402,6 +4110,13 @@ static char *GetLuaResponse(void) {
   return cpm.luaheaderp ? cpm.luaheaderp : SetStatus(200, "OK");
 }
 
+static char *CommitLuaOutput(void) {
+  char *p = GetLuaResponse();
+  if (cpm.microfresh && IsMicrocacheable(p))
+    return CommitMicrocache(p);
+  return CommitOutput(p);
+}
+
 static char *ServeErrorImpl(unsigned code, const char *reason,
                             const char *details) {
   lua_State *L = GL;
@@ -2563,8 +4278,8 @@ static ssize_t DeflateGenerator(struct iovec v[3]) {
 
 static char *ServeAssetCompressed(struct Asset *a) {
   char *p;
-  LockInc(&shared->c.deflates);
-  LockInc(&shared->c.compressedresponses);
+  LockIncCounter(deflates);
+  LockIncCounter(compressedresponses);
   DEBUGF("(srvr) ServeAssetCompressed()");
   dg.t = 0;
   dg.i = 0;
@@ -2579,7 +4294,7 @@ static char *ServeAssetCompressed(struct Asset *a) {
   bzero(&dg.s, sizeof(dg.s));
   CHECK_EQ(Z_OK, deflateInit2(&dg.s, 4, Z_DEFLATED, -MAX_WBITS, DEF_MEM_LEVEL,
                               Z_DEFAULT_STRATEGY));
-  dg.b = FreeLater(malloc(dg.z));
+  dg.b = xAllocLater(dg.z);
   p = SetStatus(200, "OK");
   p = stpcpy(p, "Content-Encoding: gzip\r\n");
   return p;
@@ -2626,15 +4341,15 @@ static ssize_t InflateGenerator(struct iovec v[3]) {
 static char *ServeAssetDecompressed(struct Asset *a) {
   char *p;
   size_t size;
-  LockInc(&shared->c.inflates);
-  LockInc(&shared->c.decompressedresponses);
+  LockIncCounter(inflates);
+  LockIncCounter(decompressedresponses);
   size = GetZipCfileUncompressedSize(zmap + a->cf);
   DEBUGF("(srvr) ServeAssetDecompressed(%ld)→%ld", cpm.contentlength, size);
   if (cpm.msg.method == kHttpHead) {
     cpm.content = 0;
     cpm.contentlength = size;
     return SetStatus(200, "OK");
-  } else if (!IsTiny()) {
+  } else if (!IsTiny() && !IsZstd(a)) {
     dg.t = 0;
     dg.i = 0;
     dg.c = 0;
@@ -2642,10 +4357,10 @@ static char *ServeAssetDecompressed(struct Asset *a) {
     dg.z = 65536;
     CHECK_EQ(Z_OK, inflateInit2(&dg.s, -MAX_WBITS));
     cpm.generator = InflateGenerator;
-    dg.b = FreeLater(malloc(dg.z));
+    dg.b = xAllocLater(dg.z);
     return SetStatus(200, "OK");
-  } else if ((p = FreeLater(malloc(size))) &&
-             Inflate(p, size, cpm.content, cpm.contentlength) &&
+  } else if ((p = AllocLater(size)) &&
+             Decompress(a, p, size, cpm.content, cpm.contentlength) &&
              Verify(p, size, ZIP_CFILE_CRC32(zmap + a->cf))) {
     cpm.content = p;
     cpm.contentlength = size;
@@ -2656,7 +4371,7 @@ static char *ServeAssetDecompressed(struct Asset *a) {
 }
 
 static inline char *ServeAssetIdentity(struct Asset *a, const char *ct) {
-  LockInc(&shared->c.identityresponses);
+  LockIncCounter(identityresponses);
   DEBUGF("(srvr) ServeAssetIdentity(%`'s)", ct);
   return SetStatus(200, "OK");
 }
@@ -2665,7 +4380,7 @@ static inline char *ServeAssetPrecompressed(struct Asset *a) {
   size_t size;
   uint32_t crc;
   DEBUGF("(srvr) ServeAssetPrecompressed()");
-  LockInc(&shared->c.precompressedresponses);
+  LockIncCounter(precompressedresponses);
   crc = ZIP_CFILE_CRC32(zmap + a->cf);
   size = GetZipCfileUncompressedSize(zmap + a->cf);
   cpm.gzipped = size;
@@ -2674,6 +4389,53 @@ static inline char *ServeAssetPrecompressed(struct Asset *a) {
   return SetStatus(200, "OK");
 }
 
+// zstd frames in the zip are valid `Content-Encoding: zstd` bodies
+static char *ServeAssetZstd(struct Asset *a) {
+  DEBUGF("(srvr) ServeAssetZstd()");
+  LockIncCounter(precompressedresponses);
+  return AppendHeader(SetStatus(200, "OK"), "Content-Encoding", "zstd");
+}
+
+static struct Asset *GetAssetVariant(struct Asset *a, const char **enc) {
+  size_t n, k;
+  uint32_t j;
+  struct Asset *b;
+  char *s, name[PATH_MAX];
+  if (a->file || !a->variants)
+    return NULL;
+  n = ZIP_CFILE_NAMESIZE(zmap + a->cf);
+  for (j = 0; j < ARRAYLEN(kVariants); ++j) {
+    if (!(a->variants & (1 << j)))
+      continue;
+    if (!ClientAcceptsEncoding(kVariants[j].encoding))
+      continue;
+    k = strlen(kVariants[j].ext);
+    if (n + 1 + k > sizeof(name))
+      continue;
+    s = mempcpy(name, ZIP_CFILE_NAME(zmap + a->cf), n);
+    *s++ = '.';
+    memcpy(s, kVariants[j].ext, k);
+    if ((b = GetAssetZip(name, n + 1 + k))) {
+      *enc = kVariants[j].encoding;
+      return b;
+    }
+  }
+  return NULL;
+}
+
+static char *ServeAssetVariant(struct Asset *b, const char *enc) {
+  char *p;
+  DEBUGF("(srvr) ServeAssetVariant(%s)", enc);
+  cpm.content = (char *)ZIP_LFILE_CONTENT(zmap + b->lf);
+  cpm.contentlength = GetZipCfileCompressedSize(zmap + b->cf);
+  if (!Verify(cpm.content, cpm.contentlength, ZIP_LFILE_CRC32(zmap + b->lf))) {
+    return ServeError(500, "Internal Server Error");
+  }
+  LockIncCounter(precompressedresponses);
+  p = SetStatus(200, "OK");
+  return AppendHeader(p, "Content-Encoding", enc);
+}
+
 static char *ServeAssetRange(struct Asset *a) {
   char *p;
   long rangestart, rangelength;
@@ -2682,14 +4444,14 @@ static char *ServeAssetRange(struct Asset *a) {
                      cpm.contentlength, &rangestart, &rangelength) &&
       rangestart >= 0 && rangelength >= 0 && rangestart < cpm.contentlength &&
       rangestart + rangelength <= cpm.contentlength) {
-    LockInc(&shared->c.partialresponses);
+    LockIncCounter(partialresponses);
     p = SetStatus(206, "Partial Content");
     p = AppendContentRange(p, rangestart, rangelength, cpm.contentlength);
     cpm.content += rangestart;
     cpm.contentlength = rangelength;
     return p;
   } else {
-    LockInc(&shared->c.badranges);
+    LockIncCounter(badranges);
     WARNF("(client) bad range %`'.*s", HeaderLength(kHttpRange),
           HeaderData(kHttpRange));
     p = SetStatus(416, "Range Not Satisfiable");
@@ -2771,7 +4533,7 @@ static void LaunchBrowser(const char *path) {
 }
 
 static char *BadMethod(void) {
-  LockInc(&shared->c.badmethods);
+  LockIncCounter(badmethods);
   return stpcpy(ServeError(405, "Method Not Allowed"), "Allow: GET, HEAD\r\n");
 }
 
@@ -2806,7 +4568,7 @@ static char *ServeListing(void) {
   struct timespec lastmod;
   size_t n, pathlen, rn[6];
   char rb[8], tb[20], *rp[6];
-  LockInc(&shared->c.listingrequests);
+  LockIncCounter(listingrequests);
   if (cpm.msg.method != kHttpGet && cpm.msg.method != kHttpHead)
     return BadMethod();
   appends(&cpm.outbuf, "\
@@ -2892,8 +4654,7 @@ td { padding-right: 3em; }\r\n\
 <td valign=\"top\">\r\n\
 <a href=\"/statusz\">/statusz</a>\r\n\
 ");
-  if (atomic_load_explicit(&shared->c.connectionshandled,
-                           memory_order_acquire)) {
+  if (GetCounter(connectionshandled)) {
     appends(&cpm.outbuf, "says your redbean<br>\r\n");
     unassert(!pthread_mutex_lock(&shared->children_mu));
     AppendResourceReport(&cpm.outbuf, &shared->children, "<br>\r\n");
@@ -2919,9 +4680,9 @@ td { padding-right: 3em; }\r\n\
   }
   appendf(&cpm.outbuf, "%s%,ld second%s of operation<br>\r\n", and, y.rem,
           y.rem == 1 ? "" : "s");
-  x = atomic_load_explicit(&shared->c.messageshandled, memory_order_relaxed);
+  x = GetCounter(messageshandled);
   appendf(&cpm.outbuf, "%,ld message%s handled<br>\r\n", x, x == 1 ? "" : "s");
-  x = atomic_load_explicit(&shared->c.connectionshandled, memory_order_relaxed);
+  x = GetCounter(connectionshandled);
   appendf(&cpm.outbuf, "%,ld connection%s handled<br>\r\n", x,
           x == 1 ? "" : "s");
   x = atomic_load_explicit(&shared->workers, memory_order_relaxed);
@@ -2975,18 +4736,75 @@ static void AppendRusage(const char *a, struct rusage *ru) {
   AppendLong2(a, "ru_nivcsw", ru->ru_nivcsw);
 }
 
+// returns index of longest programmed route prefix matching uri
+static int GetLatencyRoute(const char *p, size_t n) {
+  size_t i, m;
+  int route = 0;
+  for (m = i = 0; i < latencyroutes.n; ++i) {
+    if (latencyroutes.p[i].n > m && latencyroutes.p[i].n <= n &&
+        !memcmp(latencyroutes.p[i].s, p, latencyroutes.p[i].n)) {
+      m = latencyroutes.p[i].n;
+      route = i + 1;
+    }
+  }
+  return route;
+}
+
+// computes count, p50, p90, p99, and p99.9 for histogram
+static void GetLatencyPercentiles(int route, int metric, long r[5]) {
+  int b, i;
+  long x, n;
+  const _Atomic(long) *h;
+  static const int kPermille[4] = {500, 900, 990, 999};
+  h = shared->latency[route].h[metric];
+  for (n = b = 0; b < LATENCYBUCKETS; ++b)
+    n += atomic_load_explicit(h + b, memory_order_relaxed);
+  bzero(r, 5 * sizeof(*r));
+  if (!(r[0] = n))
+    return;
+  for (x = b = i = 0; b < LATENCYBUCKETS && i < 4; ++b) {
+    x += atomic_load_explicit(h + b, memory_order_relaxed);
+    while (i < 4 && x * 1000 >= n * kPermille[i])
+      r[++i] = GetLatencyBucketLimit(b);
+  }
+}
+
+static void ServeLatency(void) {
+  int r, m;
+  long q[5];
+  const char *a;
+  for (r = 0; r <= latencyroutes.n; ++r) {
+    for (m = 0; m < kLatencyMetrics; ++m) {
+      if (r && m == kLatencyHandshake)
+        continue;
+      GetLatencyPercentiles(r, m, q);
+      if (!r) {
+        a = MergeNames("latency", kLatencyNames[m]);
+      } else {
+        a = FreeLater(xasprintf("latency.%.*s.%s",
+                                (int)latencyroutes.p[r - 1].n,
+                                latencyroutes.p[r - 1].s, kLatencyNames[m]));
+      }
+      AppendLong2(a, "count", q[0]);
+      AppendLong2(a, "p50", q[1]);
+      AppendLong2(a, "p90", q[2]);
+      AppendLong2(a, "p99", q[3]);
+      AppendLong2(a, "p999", q[4]);
+    }
+  }
+}
+
 static void ServeCounters(void) {
-  const _Atomic(long) *c;
+  size_t i;
   const char *s;
-  for (c = (const _Atomic(long) *)&shared->c, s = kCounterNames; *s;
-       ++c, s += strlen(s) + 1) {
-    AppendLong1(s, atomic_load_explicit(c, memory_order_relaxed));
+  for (i = 0, s = kCounterNames; *s; ++i, s += strlen(s) + 1) {
+    AppendLong1(s, SumCounter(i * sizeof(_Atomic(long))));
   }
 }
 
 static char *ServeStatusz(void) {
   char *p;
-  LockInc(&shared->c.statuszrequests);
+  LockIncCounter(statuszrequests);
   if (cpm.msg.method != kHttpGet && cpm.msg.method != kHttpHead) {
     return BadMethod();
   }
@@ -3005,12 +4823,15 @@ static char *ServeStatusz(void) {
   AppendLong1("workers",
               atomic_load_explicit(&shared->workers, memory_order_relaxed));
   AppendLong1("assets.n", assets.n);
+  if (luaprofile)
+    AppendLong1("luaprofile.dropped", luaprofile->dropped);
 #ifndef STATIC
   lua_State *L = GL;
   AppendLong1("lua.memory",
               lua_gc(L, LUA_GCCOUNT) * 1024 + lua_gc(L, LUA_GCCOUNTB));
 #endif
   ServeCounters();
+  ServeLatency();
   unassert(!pthread_mutex_lock(&shared->server_mu));
   AppendRusage("server", &shared->server);
   unassert(!pthread_mutex_unlock(&shared->server_mu));
@@ -3025,10 +4846,24 @@ static char *ServeStatusz(void) {
   return CommitOutput(p);
 }
 
+static char *ServeLuaProfilez(void) {
+  char *p;
+  if (cpm.msg.method != kHttpGet && cpm.msg.method != kHttpHead) {
+    return BadMethod();
+  }
+  AppendLuaProfile(&cpm.outbuf);
+  p = SetStatus(200, "OK");
+  p = AppendContentType(p, "text/plain");
+  if (cpm.msg.version >= 11) {
+    p = stpcpy(p, "Cache-Control: no-store\r\n");
+  }
+  return CommitOutput(p);
+}
+
 static char *RedirectSlash(void) {
   size_t n, i;
   char *p, *e;
-  LockInc(&shared->c.redirects);
+  LockIncCounter(redirects);
   p = SetStatus(307, "Temporary Redirect");
   p = stpcpy(p, "Location: ");
   e = EscapePath(url.path.p, url.path.n, &n);
@@ -3078,7 +4913,7 @@ static char *LuaOnHttpRequest(void) {
   lua_settop(L, 0);  // clear Lua stack, as it needs to start fresh
   lua_getglobal(L, "OnHttpRequest");
   if (LuaCallWithYield(L) == LUA_OK) {
-    return CommitOutput(GetLuaResponse());
+    return CommitLuaOutput();
   } else {
     LogLuaError("OnHttpRequest", lua_tostring(L, -1));
     error = ServeErrorWithDetail(
@@ -3089,49 +4924,75 @@ static char *LuaOnHttpRequest(void) {
   }
 }
 
-static char *ServeLua(struct Asset *a, const char *s, size_t n) {
-  char *code;
+static int LuaDumpWriter(lua_State *L, const void *p, size_t n, void *ud) {
+  return appendd(ud, p, n) == -1;
+}
+
+// loads lua asset onto stack, compiling zip assets only once, so that
+// the bytecode is inherited by every worker that's forked afterwards
+static int LoadLuaAsset(lua_State *L, struct Asset *a, const char *name) {
+  int status;
+  char *code, *b;
   size_t codelen;
+  if (a->bytecode) {
+    return luaL_loadbufferx(L, a->bytecode, a->bytecodesize, name, "b");
+  }
+  if (!(code = LoadAsset(a, &codelen))) {
+    lua_pushstring(L, "failed to load asset");
+    return LUA_ERRFILE;
+  }
+  status = luaL_loadbuffer(L, code, codelen, name);
+  free(code);
+  if (status == LUA_OK && !a->file) {
+    b = 0;
+    if (!lua_dump(L, LuaDumpWriter, &b, false)) {
+      a->bytecode = b;
+      a->bytecodesize = appendz(b).i;
+    } else {
+      free(b);
+    }
+  }
+  return status;
+}
+
+static char *ServeLua(struct Asset *a, const char *s, size_t n) {
+  int status;
+  char *error;
   lua_State *L = GL;
-  LockInc(&shared->c.dynamicrequests);
+  LockIncCounter(dynamicrequests);
   effectivepath.p = (void *)s;
   effectivepath.n = n;
-  if ((code = FreeLater(LoadAsset(a, &codelen)))) {
-    int status =
-        luaL_loadbuffer(L, code, codelen,
+  status = LoadLuaAsset(L, a,
                         FreeLater(xasprintf("@%s", FreeLater(strndup(s, n)))));
-    if (status == LUA_OK && LuaCallWithYield(L) == LUA_OK) {
-      return CommitOutput(GetLuaResponse());
-    } else {
-      char *error;
-      LogLuaError("lua code", lua_tostring(L, -1));
-      error = ServeErrorWithDetail(
-          500, "Internal Server Error",
-          ShouldServeCrashReportDetails() ? lua_tostring(L, -1) : NULL);
-      lua_pop(L, 1);  // pop error
-      return error;
-    }
+  if (status == LUA_OK && LuaCallWithYield(L) == LUA_OK) {
+    return CommitLuaOutput();
+  } else {
+    LogLuaError("lua code", lua_tostring(L, -1));
+    error = ServeErrorWithDetail(
+        500, "Internal Server Error",
+        ShouldServeCrashReportDetails() ? lua_tostring(L, -1) : NULL);
+    lua_pop(L, 1);  // pop error
+    return error;
   }
-  return ServeError(500, "Internal Server Error");
 }
 
 static char *HandleRedirect(struct Redirect *r) {
   int code;
   struct Asset *a;
   if (!r->code && (a = GetAsset(r->location.s, r->location.n))) {
-    LockInc(&shared->c.rewrites);
+    LockIncCounter(rewrites);
     DEBUGF("(rsp) internal redirect to %`'s", r->location.s);
     if (!HasString(&cpm.loops, r->location.s, r->location.n)) {
       AddString(&cpm.loops, r->location.s, r->location.n);
       return RoutePath(r->location.s, r->location.n);
     } else {
-      LockInc(&shared->c.loops);
+      LockIncCounter(loops);
       return SetStatus(508, "Loop Detected");
     }
   } else if (cpm.msg.version < 10) {
     return ServeError(505, "HTTP Version Not Supported");
   } else {
-    LockInc(&shared->c.redirects);
+    LockIncCounter(redirects);
     code = r->code;
     if (!code)
       code = 307;
@@ -3151,7 +5012,7 @@ static char *HandleFolder(const char *path, size_t pathlen) {
   if ((p = ServeIndex(path, pathlen))) {
     return p;
   } else {
-    LockInc(&shared->c.forbiddens);
+    LockIncCounter(forbiddens);
     WARNF("(srvr) directory %`'.*s lacks index page", pathlen, path);
     return ServeErrorWithPath(403, "Forbidden", path, pathlen);
   }
@@ -3159,7 +5020,8 @@ static char *HandleFolder(const char *path, size_t pathlen) {
 
 static bool Reindex(void) {
   if (OpenZip(false)) {
-    LockInc(&shared->c.reindexes);
+    LockIncCounter(reindexes);
+    PrecompileLuaAssets();
     return true;
   } else {
     return false;
@@ -3467,7 +5329,8 @@ static void StoreAsset(const char *path, size_t pathlen, const char *data,
                        size_t datalen, int mode) {
   int64_t ft;
   uint32_t crc;
-  char *comp, *p;
+  bool sibling;
+  char *comp, *p, *zst;
   struct timespec now;
   struct Asset *a;
   struct iovec v[13];
@@ -3486,7 +5349,9 @@ static void StoreAsset(const char *path, size_t pathlen, const char *data,
   if (istext(data, datalen))
     iattrs |= kZipIattrText;
   crc = crc32_z(0, data, datalen);
-  if (datalen < 100) {
+  sibling = false;
+  zst = xasprintf("%.*s.zst", (int)pathlen, path);
+  if (datalen < 100 || IsNoCompressExt(path, pathlen)) {
     method = kZipCompressionNone;
     comp = 0;
     use = data;
@@ -3495,6 +5360,7 @@ static void StoreAsset(const char *path, size_t pathlen, const char *data,
   } else {
     comp = Deflate(data, datalen, &complen);
     if (complen < datalen) {
+      sibling = true;
       method = kZipCompressionDeflate;
       use = comp;
       uselen = complen;
@@ -3510,11 +5376,17 @@ static void StoreAsset(const char *path, size_t pathlen, const char *data,
   if (-1 == fcntl(zfd, F_SETLKW, &(struct flock){F_WRLCK})) {
     WARNF("(srvr) can't place write lock on file descriptor %d: %s", zfd,
           strerror(errno));
+    free(comp);
+    free(zst);
     return;
   }
   OpenZip(false);
   now = timespec_real();
   a = GetAssetZip(path, pathlen);
+  // keep a `.zst` sibling in sync once there is one, so stale bytes are
+  // never served under the old name with Content-Encoding: zstd
+  if (!IsNoCompressExt(path, pathlen) && GetAssetZip(zst, strlen(zst)))
+    sibling = true;
   if (!mode)
     mode = a ? GetMode(a) : 0644;
   if (!(mode & S_IFMT))
@@ -3662,6 +5534,11 @@ static void StoreAsset(const char *path, size_t pathlen, const char *data,
   //////////////////////////////////////////////////////////////////////////////
   OpenZip(false);
   free(comp);
+  if (sibling && (comp = Zstd(data, datalen, &complen))) {
+    StoreAsset(zst, strlen(zst), comp, complen, mode);
+    free(comp);
+  }
+  free(zst);
 }
 
 static void StoreFile(const char *path) {
@@ -3897,7 +5774,7 @@ static int LuaEncodeSmth(lua_State *L, int Encoder(lua_State *, char **, int,
   if (useoutput) {
     lua_pushboolean(L, true);
   } else {
-    lua_pushstring(L, p);
+    lua_pushlstring(L, p, appendz(p).i);
     free(p);
   }
   return 1;
@@ -4028,8 +5905,52 @@ static int LuaGetPort(lua_State *L) {
 }
 
 static int LuaGetBody(lua_State *L) {
+  const char *err;
   OnlyCallDuringRequest(L, "GetBody");
-  lua_pushlstring(L, inbuf.p + hdrsize, payloadlength);
+  if ((err = SlurpBody()))
+    return luaL_error(L, "GetBody() failed: %s", err);
+  if (LuaUnixIsBuffer(L, 1)) {
+    // append to caller's buffer so large payloads aren't interned
+    memcpy(LuaUnixBufferReserve(L, 1, payloadlength), inbuf.p + hdrsize,
+           payloadlength);
+    LuaUnixBufferCommit(L, 1, payloadlength);
+    lua_settop(L, 1);
+  } else {
+    lua_pushlstring(L, inbuf.p + hdrsize, payloadlength);
+  }
+  return 1;
+}
+
+static int LuaReadBodyOnce(lua_State *L) {
+  lua_pushvalue(L, lua_upvalueindex(1));
+  lua_pushnil(L);
+  lua_replace(L, lua_upvalueindex(1));
+  return 1;
+}
+
+static int LuaReadBody(lua_State *L) {
+  size_t n;
+  const char *p, *err;
+  OnlyCallDuringRequest(L, "GetBodyReader");
+  if ((err = ReadBodyPiece(&p, &n)))
+    return luaL_error(L, "GetBodyReader() failed: %s", err);
+  if (n) {
+    lua_pushlstring(L, p, n);
+  } else {
+    lua_pushnil(L);
+  }
+  return 1;
+}
+
+static int LuaGetBodyReader(lua_State *L) {
+  OnlyCallDuringRequest(L, "GetBodyReader");
+  if (!cpm.bodypending) {
+    // payload was already read, so return all of it as one piece
+    lua_pushlstring(L, inbuf.p + hdrsize, payloadlength);
+    lua_pushcclosure(L, LuaReadBodyOnce, 1);
+  } else {
+    lua_pushcfunction(L, LuaReadBody);
+  }
   return 1;
 }
 
@@ -4041,7 +5962,7 @@ static int LuaGetResponseBody(lua_State *L) {
                                 : 0;
   OnlyCallDuringRequest(L, "GetResponseBody");
   if (cpm.gzipped > 0 &&
-      (!(s = FreeLater(malloc(cpm.gzipped))) ||
+      (!(s = AllocLater(cpm.gzipped)) ||
        !Inflate(s, cpm.gzipped, cpm.content, cpm.contentlength))) {
     return LuaNilError(L, "failed to decompress response");
   }
@@ -4053,12 +5974,9 @@ static int LuaGetResponseBody(lua_State *L) {
   return 1;
 }
 
-static int LuaGetHeader(lua_State *L) {
+static int LuaPushHeaderByName(lua_State *L, const char *key, size_t keylen) {
   int h;
-  const char *key;
-  size_t i, keylen;
-  OnlyCallDuringRequest(L, "GetHeader");
-  key = luaL_checklstring(L, 1, &keylen);
+  size_t i;
   if ((h = GetHttpHeader(key, keylen)) != -1) {
     if (cpm.msg.headers[h].a) {
       return LuaPushHeader(L, &cpm.msg, inbuf.p, h);
@@ -4078,11 +5996,74 @@ static int LuaGetHeader(lua_State *L) {
   return 1;
 }
 
+static int LuaGetHeader(lua_State *L) {
+  size_t keylen;
+  const char *key;
+  OnlyCallDuringRequest(L, "GetHeader");
+  key = luaL_checklstring(L, 1, &keylen);
+  return LuaPushHeaderByName(L, key, keylen);
+}
+
 static int LuaGetHeaders(lua_State *L) {
   OnlyCallDuringRequest(L, "GetHeaders");
   return LuaPushHeaders(L, &cpm.msg, inbuf.p);
 }
 
+static void OnlyCallDuringViewRequest(lua_State *L) {
+  if (!ishandlingrequest ||
+      lua_tointeger(L, lua_upvalueindex(1)) != requestgeneration) {
+    luaL_error(L, "headers view can only be used during its request");
+    __builtin_unreachable();
+  }
+}
+
+static int LuaHeadersViewIndex(lua_State *L) {
+  size_t keylen;
+  const char *key;
+  OnlyCallDuringViewRequest(L);
+  if (!(key = lua_tolstring(L, 2, &keylen))) {
+    lua_pushnil(L);
+    return 1;
+  }
+  LuaPushHeaderByName(L, key, keylen);
+  if (!lua_isnil(L, -1)) {
+    lua_pushvalue(L, 2);
+    lua_pushvalue(L, -2);
+    lua_rawset(L, 1);  // memoize
+  }
+  return 1;
+}
+
+static int LuaHeadersViewNext(lua_State *L) {
+  lua_settop(L, 2);
+  if (lua_next(L, 1))
+    return 2;
+  lua_pushnil(L);
+  return 1;
+}
+
+static int LuaHeadersViewPairs(lua_State *L) {
+  OnlyCallDuringViewRequest(L);
+  lua_pushcfunction(L, LuaHeadersViewNext);
+  LuaPushHeaders(L, &cpm.msg, inbuf.p);
+  lua_pushnil(L);
+  return 3;
+}
+
+static int LuaGetHeadersView(lua_State *L) {
+  OnlyCallDuringRequest(L, "GetHeadersView");
+  lua_newtable(L);
+  lua_createtable(L, 0, 2);
+  lua_pushinteger(L, requestgeneration);
+  lua_pushcclosure(L, LuaHeadersViewIndex, 1);
+  lua_setfield(L, -2, "__index");
+  lua_pushinteger(L, requestgeneration);
+  lua_pushcclosure(L, LuaHeadersViewPairs, 1);
+  lua_setfield(L, -2, "__pairs");
+  lua_setmetatable(L, -2);
+  return 1;
+}
+
 static int LuaSetHeader(lua_State *L) {
   int h;
   char *eval;
@@ -4205,7 +6186,7 @@ static int LuaSetCookie(lua_State *L) {
         lua_getfield(L, 3, "Expires") != LUA_TNIL) {
       if (lua_isnumber(L, -1)) {
         expires =
-            FormatUnixHttpDateTime(FreeLater(xmalloc(30)), lua_tonumber(L, -1));
+            FormatUnixHttpDateTime(xAllocLater(30), lua_tonumber(L, -1));
       } else {
         expires = (void *)lua_tostring(L, -1);
         if (!ParseHttpDateTime(expires, -1)) {
@@ -4313,7 +6294,7 @@ static int LuaWrite(lua_State *L) {
   const char *data;
   OnlyCallDuringRequest(L, "Write");
   if (!lua_isnil(L, 1)) {
-    data = luaL_checklstring(L, 1, &size);
+    data = LuaUnixCheckBytes(L, 1, &size);
     appendd(&cpm.outbuf, data, size);
   }
   return 0;
@@ -4383,6 +6364,21 @@ static int LuaProgramUniprocess(lua_State *L) {
   return 1;
 }
 
+static int LuaProgramWorkerPool(lua_State *L) {
+  OnlyCallFromInitLua(L, "ProgramWorkerPool");
+  if (!lua_isnoneornil(L, 1)) {
+    ProgramPrefork(luaL_checkinteger(L, 1));
+  }
+  if (!lua_isnoneornil(L, 2)) {
+    preforkrequests = MAX(0, luaL_checkinteger(L, 2));
+  }
+  if (!lua_isnoneornil(L, 3)) {
+    maxparked = MIN(MAX(0, luaL_checkinteger(L, 3)), 65536);
+  }
+  lua_pushinteger(L, prefork);
+  return 1;
+}
+
 static int LuaProgramHeartbeatInterval(lua_State *L) {
   int64_t millis;
   OnlyCallFromMainProcess(L, "ProgramHeartbeatInterval");
@@ -4544,6 +6540,99 @@ static dontinline int LuaProgramBool(lua_State *L, bool *b) {
   return 0;
 }
 
+static int LuaProgramLatencyRoute(lua_State *L) {
+  size_t n;
+  const char *s;
+  OnlyCallFromInitLua(L, "ProgramLatencyRoute");
+  s = luaL_checklstring(L, 1, &n);
+  if (!n || s[0] != '/') {
+    luaL_argerror(L, 1, "route prefix must start with slash");
+    __builtin_unreachable();
+  }
+  if (HasString(&latencyroutes, s, n))
+    return 0;
+  if (latencyroutes.n == LATENCYROUTES) {
+    luaL_error(L, "too many latency routes");
+    __builtin_unreachable();
+  }
+  AddString(&latencyroutes, strndup(s, n), n);
+  return 0;
+}
+
+static int LuaGetLatency(lua_State *L) {
+  int i, m, r;
+  long q[5];
+  size_t n;
+  const char *s;
+  static const char *const kFields[5] = {"count", "p50", "p90", "p99",
+                                         "p999"};
+  m = luaL_checkoption(L, 1, 0, kLatencyNames);
+  if ((s = luaL_optlstring(L, 2, 0, &n))) {
+    for (r = 0; r < latencyroutes.n; ++r)
+      if (SlicesEqual(latencyroutes.p[r].s, latencyroutes.p[r].n, s, n))
+        break;
+    if (r == latencyroutes.n || m == kLatencyHandshake) {
+      lua_pushnil(L);
+      return 1;
+    }
+    ++r;
+  } else {
+    r = 0;
+  }
+  GetLatencyPercentiles(r, m, q);
+  lua_createtable(L, 0, 5);
+  for (i = 0; i < 5; ++i) {
+    lua_pushinteger(L, q[i]);
+    lua_setfield(L, -2, kFields[i]);
+  }
+  return 1;
+}
+
+static int LuaProgramAsyncLog(lua_State *L) {
+  OnlyCallFromInitLua(L, "ProgramAsyncLog");
+  return LuaProgramBool(L, &asynclog);
+}
+
+static int LuaProgramGc(lua_State *L) {
+  static const char *const kModes[] = {"incremental", "generational", 0};
+  int old;
+  OnlyCallFromInitLua(L, "ProgramGc");
+  if (luaL_checkoption(L, 1, 0, kModes)) {
+    old = lua_gc(L, LUA_GCGEN, (int)luaL_optinteger(L, 2, 0),
+                 (int)luaL_optinteger(L, 3, 0));
+  } else {
+    old = lua_gc(L, LUA_GCINC, (int)luaL_optinteger(L, 2, 0),
+                 (int)luaL_optinteger(L, 3, 0), 0);
+  }
+  lua_pushstring(L, old == LUA_GCGEN ? "generational" : "incremental");
+  return 1;
+}
+
+static int LuaProgramFreezeHeap(lua_State *L) {
+  OnlyCallFromInitLua(L, "ProgramFreezeHeap");
+  return LuaProgramBool(L, &freezeheap);
+}
+
+static int LuaProgramGcBeforeFork(lua_State *L) {
+  OnlyCallFromInitLua(L, "ProgramGcBeforeFork");
+  return LuaProgramBool(L, &gcbeforefork);
+}
+
+static int LuaProgramStreamBodies(lua_State *L) {
+  OnlyCallFromInitLua(L, "ProgramStreamBodies");
+  return LuaProgramBool(L, &streambodies);
+}
+
+static int LuaProgramReusePort(lua_State *L) {
+  OnlyCallFromInitLua(L, "ProgramReusePort");
+  return LuaProgramBool(L, &reuseportshards);
+}
+
+static int LuaProgramKernelTls(lua_State *L) {
+  OnlyCallFromInitLua(L, "ProgramKernelTls");
+  return LuaProgramBool(L, &kerneltls);
+}
+
 static int LuaProgramSslClientVerify(lua_State *L) {
   OnlyCallFromInitLua(L, "ProgramSslClientVerify");
   return LuaProgramBool(L, &sslclientverify);
@@ -4707,29 +6796,137 @@ static int LuaBlackhole(lua_State *L) {
 static void BlockSignals(void) {
 }
 
-[[noreturn]] static void Replenisher(void) {
-  struct timespec ts;
-  VERBOSEF("(token) replenish worker started");
+static void CopyToLogRing(uint64_t x, const char *p, size_t n) {
+  size_t i, m;
+  i = x & (LOGRINGSIZE - 1);
+  m = MIN(n, LOGRINGSIZE - i);
+  memcpy(logring->buf + i, p, m);
+  memcpy(logring->buf, p + m, n - m);
+}
+
+// appends record to ring without blocking, or drops it if it's full
+static bool PutLogRing(const char *p, size_t n) {
+  uint64_t h, t, m;
+  m = 8 + ROUNDUP(n, 8);
+  h = atomic_load_explicit(&logring->head, memory_order_relaxed);
+  do {
+    t = atomic_load_explicit(&logring->tail, memory_order_acquire);
+    if (h + m - t > LOGRINGSIZE) {
+      LockIncCounter(logdrops);
+      return false;
+    }
+  } while (!atomic_compare_exchange_weak_explicit(
+      &logring->head, &h, h + m, memory_order_relaxed, memory_order_relaxed));
+  CopyToLogRing(h + 8, p, n);
+  atomic_store_explicit(
+      (_Atomic(uint64_t) *)(logring->buf + (h & (LOGRINGSIZE - 1))), n,
+      memory_order_release);
+  return true;
+}
+
+// moves whatever this worker logged since last time into the ring
+static void FlushLog(void) {
+  int64_t n;
+  if (!logstream)
+    return;
+  if ((n = ftello(logstream)) > 0)
+    PutLogRing(logbuf, MIN(n, LOGBUFSIZE));
+  fseeko(logstream, 0, SEEK_SET);
+  clearerr(logstream);
+}
+
+static void RedirectLogToRing(void) {
+  FILE *f;
+  if (!logring)
+    return;
+  if (!logbuf)
+    logbuf = xmalloc(LOGBUFSIZE);
+  if (!(f = fmemopen(logbuf, LOGBUFSIZE, "w"))) {
+    WARNF("(log) fmemopen() failed: %m");
+    return;
+  }
+  __log_file = logstream = f;
+}
+
+// writes committed records out in batches and releases their space
+static bool DrainLogRing(void) {
+  int n;
+  size_t i, m;
+  struct iovec iov[64];
+  uint64_t h, t, x, r;
+  t = atomic_load_explicit(&logring->tail, memory_order_relaxed);
+  h = atomic_load_explicit(&logring->head, memory_order_acquire);
+  for (n = 0, x = t; x < h && n + 2 <= ARRAYLEN(iov); x += 8 + ROUNDUP(r, 8)) {
+    i = x & (LOGRINGSIZE - 1);
+    if (!(r = atomic_load_explicit((_Atomic(uint64_t) *)(logring->buf + i),
+                                   memory_order_acquire)))
+      break;
+    i = (x + 8) & (LOGRINGSIZE - 1);
+    m = MIN(r, LOGRINGSIZE - i);
+    iov[n].iov_base = logring->buf + i;
+    iov[n++].iov_len = m;
+    if (r > m) {
+      iov[n].iov_base = logring->buf;
+      iov[n++].iov_len = r - m;
+    }
+  }
+  if (x == t)
+    return false;
+  WritevAll(2, iov, n);
+  i = t & (LOGRINGSIZE - 1);
+  m = MIN(x - t, LOGRINGSIZE - i);
+  bzero(logring->buf + i, m);
+  bzero(logring->buf, x - t - m);
+  atomic_store_explicit(&logring->tail, x, memory_order_release);
+  return true;
+}
+
+[[noreturn]] static void LogDrainer(void) {
+  int i;
   strace_enabled(-1);
   signal(SIGINT, OnTerm);
   signal(SIGHUP, OnTerm);
   signal(SIGTERM, OnTerm);
   signal(SIGUSR1, SIG_IGN);  // make sure reload won't kill this
   signal(SIGUSR2, SIG_IGN);  // make sure meltdown won't kill this
-  ts = timespec_real();
   while (!terminated) {
-    if (clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &ts, 0)) {
-      errno = 0;
-      continue;
+    if (!DrainLogRing())
+      usleep(10000);
+  }
+  // keep going while the workers we count ourselves among wind down
+  for (i = 0; i < 100; ++i) {
+    if (!DrainLogRing()) {
+      if (atomic_load_explicit(&shared->workers, memory_order_relaxed) <= 1)
+        break;
+      usleep(10000);
     }
-    ReplenishTokens(tokenbucket.w, (1ul << tokenbucket.cidr) / 8);
-    ts = timespec_add(ts, tokenbucket.replenish);
-    DEBUGF("(token) replenished tokens");
   }
-  VERBOSEF("(token) replenish worker exiting");
   _Exit(0);
 }
 
+static void StartLogDrainer(void) {
+  int pid;
+  if (!asynclog || uniprocess)
+    return;
+  if ((logring = mmap(0, ROUNDUP(sizeof(struct LogRing), getgransize()),
+                      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1,
+                      0)) == MAP_FAILED) {
+    WARNF("(log) can't map log ring: %m");
+    logring = 0;
+    return;
+  }
+  if (!(pid = fork()))
+    LogDrainer();
+  if (pid == -1) {
+    WARNF("(log) can't fork log drainer: %m");
+    munmap(logring, ROUNDUP(sizeof(struct LogRing), getgransize()));
+    logring = 0;
+    return;
+  }
+  VERBOSEF("(log) draining worker logs asynchronously via pid %d", pid);
+  LockInc(&shared->workers);
+}
+
 static int LuaAcquireToken(lua_State *L) {
   uint32_t ip;
   if (!tokenbucket.cidr) {
@@ -4737,8 +6934,8 @@ static int LuaAcquireToken(lua_State *L) {
     __builtin_unreachable();
   }
   GetClientAddr(&ip, 0);
-  lua_pushinteger(L, AcquireToken(tokenbucket.b, luaL_optinteger(L, 1, ip),
-                                  tokenbucket.cidr));
+  lua_pushinteger(L, AcquireToken4(tokenbucket.tb, luaL_optinteger(L, 1, ip),
+                                   timespec_mono()));
   return 1;
 }
 
@@ -4749,8 +6946,8 @@ static int LuaCountTokens(lua_State *L) {
     __builtin_unreachable();
   }
   GetClientAddr(&ip, 0);
-  lua_pushinteger(L, CountTokens(tokenbucket.b, luaL_optinteger(L, 1, ip),
-                                 tokenbucket.cidr));
+  lua_pushinteger(L, CountTokens4(tokenbucket.tb, luaL_optinteger(L, 1, ip),
+                                  timespec_mono()));
   return 1;
 }
 
@@ -4776,68 +6973,384 @@ static int LuaProgramTokenBucket(lua_State *L) {
     luaL_argerror(L, 3, "require -1 <= reject <= 126");
     __builtin_unreachable();
   }
-  if (!(-1 <= ignore && ignore <= 126)) {
-    luaL_argerror(L, 4, "require -1 <= ignore <= 126");
+  if (!(-1 <= ignore && ignore <= 126)) {
+    luaL_argerror(L, 4, "require -1 <= ignore <= 126");
+    __builtin_unreachable();
+  }
+  if (!(-1 <= ban && ban <= 126)) {
+    luaL_argerror(L, 5, "require -1 <= ban <= 126");
+    __builtin_unreachable();
+  }
+  if (!(ignore <= reject)) {
+    luaL_argerror(L, 4, "require ignore <= reject");
+    __builtin_unreachable();
+  }
+  if (!(ban <= ignore)) {
+    luaL_argerror(L, 5, "require ban <= ignore");
+    __builtin_unreachable();
+  }
+  VERBOSEF("(token) deploying buckets for %,ld clients "
+           "(one for every %ld ips) "
+           "each holding 127 tokens which "
+           "replenish %g times per second, "
+           "reject at %d tokens, "
+           "ignore at %d tokens, and "
+           "ban at %d tokens",
+           MIN(1L << cidr, TOKENCLIENTS),  //
+           4294967296 / (1L << cidr),      //
+           replenish,                  //
+           reject,                     //
+           ignore,                     //
+           ban);
+  if (ignore == -1)
+    ignore = -128;
+  if (ban == -1)
+    ban = -128;
+  if (ban >= 0 && (IsLinux() || IsBsd())) {
+    uint32_t testip = 0;
+    blackhole.addr.sun_family = AF_UNIX;
+    strlcpy(blackhole.addr.sun_path, "/var/run/blackhole.sock",
+            sizeof(blackhole.addr.sun_path));
+    if ((blackhole.fd = socket(AF_UNIX, SOCK_DGRAM, 0)) == -1) {
+      WARNF("(token) socket(AF_UNIX) failed: %m");
+      ban = -1;
+    } else if (sendto(blackhole.fd, &testip, 4, 0,
+                      (struct sockaddr *)&blackhole.addr,
+                      sizeof(blackhole.addr)) == -1) {
+      VERBOSEF("(token) error: sendto(%`'s) failed: %m",
+               blackhole.addr.sun_path);
+      VERBOSEF("(token) redbean isn't able to protect your kernel from ddos");
+      VERBOSEF("(token) please run the blackholed program; see our website!");
+    }
+  }
+  size_t clients = MIN(1ul << cidr, TOKENCLIENTS);
+  tokenbucket.tb = _mapshared(
+      ROUNDUP(GetTokenBucketsSize(clients), getgransize()));
+  InitTokenBuckets(tokenbucket.tb, clients, cidr, 64,
+                   timespec_fromnanos(1 / replenish * 1e9));
+  tokenbucket.cidr = cidr;
+  tokenbucket.reject = reject;
+  tokenbucket.ignore = ignore;
+  tokenbucket.ban = ban;
+  return 0;
+}
+
+static void OnLuaProfileTick(int sig) {
+  atomic_store_explicit(&luaprofiletick, 1, memory_order_relaxed);
+}
+
+static char *AppendLuaFrame(char *p, char *e, lua_Debug *ar) {
+  int n;
+  char *s;
+  const char *name = ar->name ? ar->name : "?";
+  if (*ar->what == 'm') {
+    n = snprintf(p, e - p, "main@%s", ar->short_src);
+  } else if (*ar->what == 'C') {
+    n = snprintf(p, e - p, "%s", name);
+  } else {
+    n = snprintf(p, e - p, "%s@%s:%d", name, ar->short_src, ar->linedefined);
+  }
+  if (n >= e - p)
+    return 0;
+  // folded stacks are split on semicolons, and the count on a space
+  for (s = p; s < p + n; ++s)
+    if (*s == ';' || *s == ' ' || *s == '\n')
+      *s = '_';
+  return p + n;
+}
+
+static void SaveLuaSample(const char *s, size_t n) {
+  uint64_t want, have;
+  struct LuaSample *x;
+  want = Hash(s, n);
+  want = want > LUAPROFILEBUSY ? want : want + 2;
+  for (size_t h = want >> 32, i = 0; i < LUAPROFILEPROBE; ++i) {
+    x = &luaprofile->p[(h + i) & (luaprofile->n - 1)];
+    have = atomic_load_explicit(&x->hash, memory_order_acquire);
+    if (have == LUAPROFILEEMPTY &&
+        atomic_compare_exchange_strong_explicit(&x->hash, &have, LUAPROFILEBUSY,
+                                                memory_order_acquire,
+                                                memory_order_acquire)) {
+      memcpy(x->stack, s, n + 1);
+      atomic_store_explicit(&x->count, 1, memory_order_relaxed);
+      atomic_store_explicit(&x->hash, want, memory_order_release);
+      return;
+    }
+    if (have == want && !memcmp(x->stack, s, n + 1)) {
+      atomic_fetch_add_explicit(&x->count, 1, memory_order_relaxed);
+      return;
+    }
+  }
+  atomic_fetch_add_explicit(&luaprofile->dropped, 1, memory_order_relaxed);
+}
+
+// records the lua stack as a line like `OnHttpRequest@.init.lua:9;f@x:3`
+// which keeps frames closest to the root if the stack doesn't fit
+static void SampleLuaStack(lua_State *L) {
+  int i, n;
+  lua_Debug ar;
+  char *p, *q, *e, line[LUAPROFILELINE];
+  for (n = 0; n < LUAPROFILEDEPTH && lua_getstack(L, n, &ar); ++n) {
+  }
+  p = line;
+  e = line + sizeof(line);
+  for (i = n; i--;) {
+    lua_getstack(L, i, &ar);
+    lua_getinfo(L, "Sn", &ar);
+    if (!(q = AppendLuaFrame(p + (p > line), e, &ar)))
+      break;
+    if (p > line)
+      *p = ';';
+    p = q;
+  }
+  *p = 0;
+  if (p > line)
+    SaveLuaSample(line, p - line);
+}
+
+static void LuaProfileHook(lua_State *L, lua_Debug *ar) {
+  if (atomic_exchange_explicit(&luaprofiletick, 0, memory_order_relaxed))
+    SampleLuaStack(L);
+}
+
+// arms the lua profiler in this process, if it's one of the chosen few
+static void StartLuaProfiler(void) {
+  int which, sig;
+  struct itimerval it;
+  if (!luaprofile || _rand64() % 100 >= luaprofilepercent)
+    return;
+  // windows only has wall time alarms so it'll share with ProfileStart
+  which = IsWindows() ? ITIMER_PROF : ITIMER_VIRTUAL;
+  sig = IsWindows() ? SIGPROF : SIGVTALRM;
+  sigaction(sig,
+            &(struct sigaction){.sa_handler = OnLuaProfileTick,
+                                .sa_flags = SA_RESTART},
+            0);
+  it.it_interval = timeval_frommicros(1000000 / luaprofilehz);
+  it.it_value = it.it_interval;
+  if (setitimer(which, &it, 0)) {
+    WARNF("(lua) failed to start lua profiler: %m");
+    return;
+  }
+  // the timer only raises a flag, which this hook polls every so many
+  // vm instructions, since lua can't be inspected from signal handlers
+  lua_sethook(GL, LuaProfileHook, LUA_MASKCOUNT, LUAPROFILECOUNT);
+  LockIncCounter(luaprofiled);
+}
+
+static void AppendLuaProfile(char **b) {
+  size_t i;
+  unsigned long count;
+  for (i = 0; i < luaprofile->n; ++i) {
+    if (atomic_load_explicit(&luaprofile->p[i].hash, memory_order_acquire) <=
+        LUAPROFILEBUSY)
+      continue;
+    if (!(count = atomic_load_explicit(&luaprofile->p[i].count,
+                                       memory_order_relaxed)))
+      continue;
+    appendf(b, "%s %lu\n", luaprofile->p[i].stack, count);
+  }
+}
+
+static struct LuaProfile *CheckLuaProfile(lua_State *L) {
+  if (!luaprofile) {
+    luaL_error(L, "ProgramLuaProfiler() needs to be called first");
+    __builtin_unreachable();
+  }
+  return luaprofile;
+}
+
+static int LuaProgramLuaProfiler(lua_State *L) {
+  size_t n, size;
+  OnlyCallFromInitLua(L, "ProgramLuaProfiler");
+  if (luaprofile) {
+    luaL_error(L, "ProgramLuaProfiler() can only be called once");
+    __builtin_unreachable();
+  }
+  lua_Integer hz = luaL_checkinteger(L, 1);
+  lua_Integer percent = luaL_optinteger(L, 2, 100);
+  lua_Integer stacks = luaL_optinteger(L, 3, 4096);
+  if (!(1 <= hz && hz <= 1000)) {
+    luaL_argerror(L, 1, "require 1 <= hz <= 1000");
+    __builtin_unreachable();
+  }
+  if (!(0 <= percent && percent <= 100)) {
+    luaL_argerror(L, 2, "require 0 <= percent <= 100");
+    __builtin_unreachable();
+  }
+  if (!(LUAPROFILEPROBE <= stacks && stacks <= 1024 * 1024)) {
+    luaL_argerror(L, 3, "require 16 <= stacks <= 1048576");
+    __builtin_unreachable();
+  }
+  for (n = LUAPROFILEPROBE; n < stacks; n <<= 1) {
+  }
+  size = sizeof(struct LuaProfile) + n * sizeof(struct LuaSample);
+  VERBOSEF("(lua) deploying %,ld byte lua profiler for %,ld stacks", size, n);
+  if (!(luaprofile = _mapshared(ROUNDUP(size, getgransize())))) {
+    luaL_error(L, "ProgramLuaProfiler() failed: %s", strerror(errno));
+    __builtin_unreachable();
+  }
+  luaprofile->n = n;
+  luaprofilehz = hz;
+  luaprofilepercent = percent;
+  return 0;
+}
+
+static int LuaGetLuaProfile(lua_State *L) {
+  char *b = 0;
+  CheckLuaProfile(L);
+  AppendLuaProfile(&b);
+  lua_pushlstring(L, b, appendz(b).i);
+  free(b);
+  return 1;
+}
+
+static int LuaResetLuaProfile(lua_State *L) {
+  size_t i;
+  CheckLuaProfile(L);
+  for (i = 0; i < luaprofile->n; ++i)
+    atomic_store_explicit(&luaprofile->p[i].count, 0, memory_order_relaxed);
+  atomic_store_explicit(&luaprofile->dropped, 0, memory_order_relaxed);
+  return 0;
+}
+
+static int LuaProgramSharedCache(lua_State *L) {
+  OnlyCallFromInitLua(L, "ProgramSharedCache");
+  if (sharedcache) {
+    luaL_error(L, "ProgramSharedCache() can only be called once");
+    __builtin_unreachable();
+  }
+  lua_Integer entries = luaL_checkinteger(L, 1);
+  lua_Integer payload = luaL_optinteger(L, 2, 1024);
+  if (!(1 <= entries && entries <= 16 * 1024 * 1024)) {
+    luaL_argerror(L, 1, "require 1 <= entries <= 16777216");
+    __builtin_unreachable();
+  }
+  if (!(1 <= payload && payload <= 1024 * 1024)) {
+    luaL_argerror(L, 2, "require 1 <= payload <= 1048576");
+    __builtin_unreachable();
+  }
+  size_t size = cosmo_shmap_size(entries, payload);
+  VERBOSEF("(cache) deploying %,ld byte shared cache for %,ld entries",
+           size, entries);
+  if (!(sharedcache = cosmo_shmap_init(
+            _mapshared(ROUNDUP(size, getgransize())), entries, payload))) {
+    luaL_error(L, "ProgramSharedCache() failed: %s", strerror(errno));
+    __builtin_unreachable();
+  }
+  sharedcachepayload = payload;
+  return 0;
+}
+
+static struct CosmoShmap *GetSharedCache(lua_State *L) {
+  if (!sharedcache) {
+    luaL_error(L, "ProgramSharedCache() needs to be called first");
+    __builtin_unreachable();
+  }
+  return sharedcache;
+}
+
+static int LuaSharedCacheGet(lua_State *L) {
+  ssize_t rc;
+  size_t keylen;
+  luaL_Buffer lb;
+  struct CosmoShmap *m = GetSharedCache(L);
+  const char *key = luaL_checklstring(L, 1, &keylen);
+  rc = cosmo_shmap_get(m, key, keylen,
+                       luaL_buffinitsize(L, &lb, sharedcachepayload),
+                       sharedcachepayload);
+  if (rc != -1) {
+    luaL_pushresultsize(&lb, rc);
+  } else {
+    lua_pushnil(L);
+  }
+  return 1;
+}
+
+static int LuaSharedCacheSet(lua_State *L) {
+  size_t keylen, vallen;
+  struct CosmoShmap *m = GetSharedCache(L);
+  const char *key = luaL_checklstring(L, 1, &keylen);
+  const char *val = luaL_checklstring(L, 2, &vallen);
+  lua_pushboolean(L, !cosmo_shmap_put(m, key, keylen, val, vallen));
+  return 1;
+}
+
+static int LuaSharedCacheDelete(lua_State *L) {
+  size_t keylen;
+  struct CosmoShmap *m = GetSharedCache(L);
+  const char *key = luaL_checklstring(L, 1, &keylen);
+  lua_pushboolean(L, cosmo_shmap_del(m, key, keylen));
+  return 1;
+}
+
+static int LuaProgramResponseCache(lua_State *L) {
+  OnlyCallFromInitLua(L, "ProgramResponseCache");
+  if (responsecache) {
+    luaL_error(L, "ProgramResponseCache() can only be called once");
+    __builtin_unreachable();
+  }
+  lua_Integer entries = luaL_checkinteger(L, 1);
+  lua_Integer payload = luaL_optinteger(L, 2, 65536);
+  if (!(1 <= entries && entries <= 1024 * 1024)) {
+    luaL_argerror(L, 1, "require 1 <= entries <= 1048576");
+    __builtin_unreachable();
+  }
+  if (!(1024 <= payload && payload <= 16 * 1024 * 1024)) {
+    luaL_argerror(L, 2, "require 1024 <= payload <= 16777216");
+    __builtin_unreachable();
+  }
+  size_t size = cosmo_shmap_size(entries, payload);
+  VERBOSEF("(cache) deploying %,ld byte response cache for %,ld entries",
+           size, entries);
+  if (!(responsecache = cosmo_shmap_init(
+            _mapshared(ROUNDUP(size, getgransize())), entries, payload))) {
+    luaL_error(L, "ProgramResponseCache() failed: %s", strerror(errno));
     __builtin_unreachable();
   }
-  if (!(-1 <= ban && ban <= 126)) {
-    luaL_argerror(L, 5, "require -1 <= ban <= 126");
+  responsecachepayload = payload;
+  return 0;
+}
+
+static int LuaSetCacheable(lua_State *L) {
+  size_t n;
+  lua_Integer i;
+  const char *s;
+  OnlyCallDuringRequest(L, "SetCacheable");
+  if (!responsecache) {
+    luaL_error(L, "ProgramResponseCache() needs to be called first");
     __builtin_unreachable();
   }
-  if (!(ignore <= reject)) {
-    luaL_argerror(L, 4, "require ignore <= reject");
+  lua_Integer fresh = luaL_checkinteger(L, 1);
+  lua_Integer stale = luaL_optinteger(L, 3, fresh);
+  if (!(0 <= fresh && fresh <= 31536000)) {
+    luaL_argerror(L, 1, "require 0 <= seconds <= 31536000");
     __builtin_unreachable();
   }
-  if (!(ban <= ignore)) {
-    luaL_argerror(L, 5, "require ban <= ignore");
+  if (!(0 <= stale && stale <= 31536000)) {
+    luaL_argerror(L, 3, "require 0 <= staleseconds <= 31536000");
     __builtin_unreachable();
   }
-  VERBOSEF("(token) deploying %,ld buckets "
-           "(one for every %ld ips) "
-           "each holding 127 tokens which "
-           "replenish %g times per second, "
-           "reject at %d tokens, "
-           "ignore at %d tokens, and "
-           "ban at %d tokens",
-           1L << cidr,                 //
-           4294967296 / (1L << cidr),  //
-           replenish,                  //
-           reject,                     //
-           ignore,                     //
-           ban);
-  if (ignore == -1)
-    ignore = -128;
-  if (ban == -1)
-    ban = -128;
-  if (ban >= 0 && (IsLinux() || IsBsd())) {
-    uint32_t testip = 0;
-    blackhole.addr.sun_family = AF_UNIX;
-    strlcpy(blackhole.addr.sun_path, "/var/run/blackhole.sock",
-            sizeof(blackhole.addr.sun_path));
-    if ((blackhole.fd = socket(AF_UNIX, SOCK_DGRAM, 0)) == -1) {
-      WARNF("(token) socket(AF_UNIX) failed: %m");
-      ban = -1;
-    } else if (sendto(blackhole.fd, &testip, 4, 0,
-                      (struct sockaddr *)&blackhole.addr,
-                      sizeof(blackhole.addr)) == -1) {
-      VERBOSEF("(token) error: sendto(%`'s) failed: %m",
-               blackhole.addr.sun_path);
-      VERBOSEF("(token) redbean isn't able to protect your kernel from ddos");
-      VERBOSEF("(token) please run the blackholed program; see our website!");
+  cpm.microvarylen = 0;
+  if (!lua_isnoneornil(L, 2)) {
+    luaL_checktype(L, 2, LUA_TTABLE);
+    for (i = 1; lua_rawgeti(L, 2, i) != LUA_TNIL; ++i) {
+      if (!(s = lua_tolstring(L, -1, &n)) || !IsValidHttpToken(s, n)) {
+        luaL_argerror(L, 2, "invalid header name");
+        __builtin_unreachable();
+      }
+      if (cpm.microvarylen + n + 1 > MICROVARYMAX) {
+        luaL_argerror(L, 2, "too many headers");
+        __builtin_unreachable();
+      }
+      memcpy(cpm.microvary + cpm.microvarylen, s, n + 1);
+      cpm.microvarylen += n + 1;
+      lua_pop(L, 1);
     }
+    lua_pop(L, 1);
   }
-  tokenbucket.b = _mapshared(ROUNDUP(1ul << cidr, getgransize()));
-  memset(tokenbucket.b, 127, 1ul << cidr);
-  tokenbucket.cidr = cidr;
-  tokenbucket.reject = reject;
-  tokenbucket.ignore = ignore;
-  tokenbucket.ban = ban;
-  tokenbucket.replenish = timespec_fromnanos(1 / replenish * 1e9);
-  int pid = fork();
-  npassert(pid != -1);
-  if (!pid)
-    Replenisher();
-  atomic_fetch_add_explicit(&shared->workers, 1, memory_order_acquire);
+  cpm.microfresh = fresh;
+  cpm.microstale = stale;
   return 0;
 }
 
@@ -4948,6 +7461,7 @@ static bool LuaRunAsset(const char *path, bool mandatory) {
 static const char *const kDontAutoComplete[] = {
     "Compress",                  // deprecated
     "GetBody",                   //
+    "GetBodyReader",             //
     "GetClientAddr",             //
     "GetClientFd",               //
     "GetComment",                // deprecated
@@ -4981,20 +7495,29 @@ static const char *const kDontAutoComplete[] = {
     "LaunchBrowser",             //
     "LuaProgramSslRequired",     // TODO
     "ProgramAddr",               // TODO
+    "ProgramAsyncLog",           //
     "ProgramBrand",              //
     "ProgramCertificate",        // TODO
+    "ProgramFreezeHeap",         //
+    "ProgramGc",                 //
+    "ProgramGcBeforeFork",       //
     "ProgramGid",                //
+    "ProgramKernelTls",          //
+    "ProgramLatencyRoute",       //
     "ProgramLogPath",            // TODO
     "ProgramMaxPayloadSize",     // TODO
     "ProgramPidPath",            // TODO
     "ProgramPort",               // TODO
     "ProgramPrivateKey",         // TODO
+    "ProgramReusePort",          //
     "ProgramSslCiphersuite",     // TODO
     "ProgramSslClientVerify",    // TODO
     "ProgramSslTicketLifetime",  //
+    "ProgramStreamBodies",       //
     "ProgramTimeout",            // TODO
     "ProgramUid",                //
     "ProgramUniprocess",         //
+    "ProgramWorkerPool",         //
     "Respond",                   //
     "Route",                     //
     "RouteHost",                 //
@@ -5004,6 +7527,7 @@ static const char *const kDontAutoComplete[] = {
     "ServeListing",              //
     "ServeRedirect",             //
     "ServeStatusz",              //
+    "SetCacheable",              //
     "SetCookie",                 //
     "SetHeader",                 //
     "SslInit",                   // TODO
@@ -5047,6 +7571,7 @@ static const luaL_Reg kLuaFuncs[] = {
     {"EscapeSegment", LuaEscapeSegment},                        //
     {"EscapeUser", LuaEscapeUser},                              //
     {"Fetch", LuaFetch},                                        //
+    {"FetchMany", LuaFetchMany},                                //
     {"FormatHttpDateTime", LuaFormatHttpDateTime},              //
     {"FormatIp", LuaFormatIp},                                  //
     {"GetAssetComment", LuaGetAssetComment},                    //
@@ -5054,6 +7579,7 @@ static const luaL_Reg kLuaFuncs[] = {
     {"GetAssetMode", LuaGetAssetMode},                          //
     {"GetAssetSize", LuaGetAssetSize},                          //
     {"GetBody", LuaGetBody},                                    //
+    {"GetBodyReader", LuaGetBodyReader},                        //
     {"GetClientAddr", LuaGetClientAddr},                        //
     {"GetClientFd", LuaGetClientFd},                            //
     {"GetCookie", LuaGetCookie},                                //
@@ -5066,12 +7592,15 @@ static const luaL_Reg kLuaFuncs[] = {
     {"GetFragment", LuaGetFragment},                            //
     {"GetHeader", LuaGetHeader},                                //
     {"GetHeaders", LuaGetHeaders},                              //
+    {"GetHeadersView", LuaGetHeadersView},                      //
     {"GetHost", LuaGetHost},                                    //
     {"GetHostIsa", LuaGetHostIsa},                              //
     {"GetHostOs", LuaGetHostOs},                                //
     {"GetHttpReason", LuaGetHttpReason},                        //
     {"GetHttpVersion", LuaGetHttpVersion},                      //
+    {"GetLatency", LuaGetLatency},                              //
     {"GetLogLevel", LuaGetLogLevel},                            //
+    {"GetLuaProfile", LuaGetLuaProfile},                        //
     {"GetMethod", LuaGetMethod},                                //
     {"GetMonospaceWidth", LuaGetMonospaceWidth},                //
     {"GetParam", LuaGetParam},                                  //
@@ -5122,30 +7651,44 @@ static const luaL_Reg kLuaFuncs[] = {
     {"ParseParams", LuaParseParams},                            //
     {"ParseUrl", LuaParseUrl},                                  //
     {"Popcnt", LuaPopcnt},                                      //
+    {"ProfileStart", LuaProfileStart},                          //
+    {"ProfileStop", LuaProfileStop},                            //
     {"ProgramAddr", LuaProgramAddr},                            //
+    {"ProgramAsyncLog", LuaProgramAsyncLog},                    //
     {"ProgramBrand", LuaProgramBrand},                          //
     {"ProgramCache", LuaProgramCache},                          //
     {"ProgramContentType", LuaProgramContentType},              //
     {"ProgramDirectory", LuaProgramDirectory},                  //
+    {"ProgramFreezeHeap", LuaProgramFreezeHeap},                //
+    {"ProgramGc", LuaProgramGc},                                //
+    {"ProgramGcBeforeFork", LuaProgramGcBeforeFork},            //
     {"ProgramGid", LuaProgramGid},                              //
     {"ProgramHeader", LuaProgramHeader},                        //
     {"ProgramHeartbeatInterval", LuaProgramHeartbeatInterval},  //
     {"ProgramLogBodies", LuaProgramLogBodies},                  //
     {"ProgramLogMessages", LuaProgramLogMessages},              //
+    {"ProgramLatencyRoute", LuaProgramLatencyRoute},            //
     {"ProgramLogPath", LuaProgramLogPath},                      //
+    {"ProgramLuaProfiler", LuaProgramLuaProfiler},              //
     {"ProgramMaxPayloadSize", LuaProgramMaxPayloadSize},        //
     {"ProgramMaxWorkers", LuaProgramMaxWorkers},                //
     {"ProgramPidPath", LuaProgramPidPath},                      //
     {"ProgramPort", LuaProgramPort},                            //
     {"ProgramRedirect", LuaProgramRedirect},                    //
+    {"ProgramResponseCache", LuaProgramResponseCache},          //
+    {"ProgramReusePort", LuaProgramReusePort},                  //
+    {"ProgramSharedCache", LuaProgramSharedCache},              //
+    {"ProgramStreamBodies", LuaProgramStreamBodies},            //
     {"ProgramTimeout", LuaProgramTimeout},                      //
     {"ProgramTrustedIp", LuaProgramTrustedIp},                  // undocumented
     {"ProgramUid", LuaProgramUid},                              //
     {"ProgramUniprocess", LuaProgramUniprocess},                //
+    {"ProgramWorkerPool", LuaProgramWorkerPool},                //
     {"Rand64", LuaRand64},                                      //
     {"Rdrand", LuaRdrand},                                      //
     {"Rdseed", LuaRdseed},                                      //
     {"Rdtsc", LuaRdtsc},                                        //
+    {"ResetLuaProfile", LuaResetLuaProfile},                    //
     {"ResolveIp", LuaResolveIp},                                //
     {"Route", LuaRoute},                                        //
     {"RouteHost", LuaRouteHost},                                //
@@ -5156,6 +7699,7 @@ static const luaL_Reg kLuaFuncs[] = {
     {"ServeListing", LuaServeListing},                          //
     {"ServeRedirect", LuaServeRedirect},                        //
     {"ServeStatusz", LuaServeStatusz},                          //
+    {"SetCacheable", LuaSetCacheable},                          //
     {"SetCookie", LuaSetCookie},                                //
     {"SetHeader", LuaSetHeader},                                //
     {"SetLogLevel", LuaSetLogLevel},                            //
@@ -5165,6 +7709,9 @@ static const luaL_Reg kLuaFuncs[] = {
     {"Sha256", LuaSha256},                                      //
     {"Sha384", LuaSha384},                                      //
     {"Sha512", LuaSha512},                                      //
+    {"SharedCacheDelete", LuaSharedCacheDelete},                //
+    {"SharedCacheGet", LuaSharedCacheGet},                      //
+    {"SharedCacheSet", LuaSharedCacheSet},                      //
     {"Sleep", LuaSleep},                                        //
     {"Slurp", LuaSlurp},                                        //
     {"StoreAsset", LuaStoreAsset},                              //
@@ -5184,6 +7731,7 @@ static const luaL_Reg kLuaFuncs[] = {
     {"EvadeDragnetSurveillance", LuaEvadeDragnetSurveillance},  //
     {"GetSslIdentity", LuaGetSslIdentity},                      //
     {"ProgramCertificate", LuaProgramCertificate},              //
+    {"ProgramKernelTls", LuaProgramKernelTls},                  //
     {"ProgramPrivateKey", LuaProgramPrivateKey},                //
     {"ProgramSslCiphersuite", LuaProgramSslCiphersuite},        //
     {"ProgramSslClientVerify", LuaProgramSslClientVerify},      //
@@ -5209,6 +7757,7 @@ static const luaL_Reg kLuaLibs[] = {
     {"finger", LuaFinger},           //
     {"path", LuaPath},               //
     {"re", LuaRe},                   //
+    {"redis", LuaRedis},             //
     {"unix", LuaUnix},               //
 };
 
@@ -5402,8 +7951,11 @@ static void MemDestroy(void) {
   Free(&inbuf_actual.p), inbuf_actual.n = inbuf_actual.c = 0;
   Free(&unmaplist.p), unmaplist.n = unmaplist.c = 0;
   Free(&freelist.p), freelist.n = freelist.c = 0;
+  cosmo_arena_free(reqarena), reqarena = 0;
   Free(&hdrbuf.p), hdrbuf.n = hdrbuf.c = 0;
   Free(&servers.p), servers.n = 0;
+  Free(&preforkpids), prefork = 0;
+  Free(&parked.p), parked.n = 0;
   Free(&ports.p), ports.n = 0;
   Free(&ips.p), ips.n = 0;
   Free(&cpm.outbuf);
@@ -5412,7 +7964,7 @@ static void MemDestroy(void) {
   Free(&cachedirective);
   Free(&launchbrowser);
   Free(&serverheader);
-  Free(&trustedips.p);
+  FreeIpTrie(&trustedips.trie), trustedips.n = 0;
   Free(&interfaces);
   Free(&extrahdrs);
   Free(&pidpath);
@@ -5443,6 +7995,9 @@ static void LuaInit(void) {
     hasonworkerstart = IsHookDefined("OnWorkerStart");
     hasonworkerstop = IsHookDefined("OnWorkerStop");
     hasonloglatency = IsHookDefined("OnLogLatency");
+    if (freezeheap) {
+      DEBUGF("(lua) froze %,d objects after init", lua_gc(L, LUA_GCFREEZE));
+    }
   } else {
     DEBUGF("(srvr) no /.init.lua defined");
   }
@@ -5480,7 +8035,7 @@ static const char *DescribeClose(void) {
 
 static void LogClose(const char *reason) {
   if (amtread || meltdown || killed) {
-    LockInc(&shared->c.fumbles);
+    LockIncCounter(fumbles);
     INFOF("(stat) %s %s with %,ld unprocessed and %,d handled (%,d workers)",
           DescribeClient(), reason, amtread, messageshandled,
           atomic_load_explicit(&shared->workers, memory_order_relaxed));
@@ -5552,76 +8107,76 @@ static void EnterMeltdownMode(void) {
   WARNF("(srvr) server is melting down (%,d workers)",
         atomic_load_explicit(&shared->workers, memory_order_relaxed));
   LOGIFNEG1(kill(0, SIGUSR2));
-  LockInc(&shared->c.meltdowns);
+  LockIncCounter(meltdowns);
 }
 
 static char *HandlePayloadDisconnect(void) {
-  LockInc(&shared->c.payloaddisconnects);
+  LockIncCounter(payloaddisconnects);
   LogClose("payload disconnect");
   return ServeFailure(400, "Bad Request"); /* XXX */
 }
 
 static char *HandlePayloadDrop(void) {
-  LockInc(&shared->c.dropped);
+  LockIncCounter(dropped);
   LogClose(DescribeClose());
   return ServeFailure(503, "Service Unavailable");
 }
 
 static char *HandleBadContentLength(void) {
-  LockInc(&shared->c.badlengths);
+  LockIncCounter(badlengths);
   return ServeFailure(400, "Bad Content Length");
 }
 
 static char *HandleLengthRequired(void) {
-  LockInc(&shared->c.missinglengths);
+  LockIncCounter(missinglengths);
   return ServeFailure(411, "Length Required");
 }
 
 static char *HandleVersionNotSupported(void) {
-  LockInc(&shared->c.http12);
+  LockIncCounter(http12);
   return ServeFailure(505, "HTTP Version Not Supported");
 }
 
 static char *HandleConnectRefused(void) {
-  LockInc(&shared->c.connectsrefused);
+  LockIncCounter(connectsrefused);
   return ServeFailure(501, "Not Implemented");
 }
 
 static char *HandleExpectFailed(void) {
-  LockInc(&shared->c.expectsrefused);
+  LockIncCounter(expectsrefused);
   return ServeFailure(417, "Expectation Failed");
 }
 
 static char *HandleHugePayload(void) {
-  LockInc(&shared->c.hugepayloads);
+  LockIncCounter(hugepayloads);
   return ServeFailure(413, "Payload Too Large");
 }
 
 static char *HandleTransferRefused(void) {
-  LockInc(&shared->c.transfersrefused);
+  LockIncCounter(transfersrefused);
   return ServeFailure(501, "Not Implemented");
 }
 
 static char *HandleMapFailed(struct Asset *a, int fd) {
-  LockInc(&shared->c.mapfails);
+  LockIncCounter(mapfails);
   WARNF("(srvr) mmap(%`'s) error: %m", a->file->path);
   close(fd);
   return ServeError(500, "Internal Server Error");
 }
 
 static void LogAcceptError(const char *s) {
-  LockInc(&shared->c.accepterrors);
+  LockIncCounter(accepterrors);
   WARNF("(srvr) %s accept error: %s", DescribeServer(), s);
 }
 
 static char *HandleOpenFail(struct Asset *a) {
-  LockInc(&shared->c.openfails);
+  LockIncCounter(openfails);
   WARNF("(srvr) open(%`'s) error: %m", a->file->path);
   if (errno == ENFILE) {
-    LockInc(&shared->c.enfiles);
+    LockIncCounter(enfiles);
     return ServeError(503, "Service Unavailable");
   } else if (errno == EMFILE) {
-    LockInc(&shared->c.emfiles);
+    LockIncCounter(emfiles);
     return ServeError(503, "Service Unavailable");
   } else {
     return ServeError(500, "Internal Server Error");
@@ -5630,23 +8185,23 @@ static char *HandleOpenFail(struct Asset *a) {
 
 static char *HandlePayloadReadError(void) {
   if (errno == ECONNRESET) {
-    LockInc(&shared->c.readresets);
+    LockIncCounter(readresets);
     LogClose("payload reset");
     return ServeFailure(400, "Bad Request"); /* XXX */
   } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
-    LockInc(&shared->c.readtimeouts);
+    LockIncCounter(readtimeouts);
     LogClose("payload read timeout");
     return ServeFailure(408, "Request Timeout");
   } else {
-    LockInc(&shared->c.readerrors);
+    LockIncCounter(readerrors);
     INFOF("(clnt) %s payload read error: %m", DescribeClient());
     return ServeFailure(500, "Internal Server Error");
   }
 }
 
 static void HandleForkFailure(void) {
-  LockInc(&shared->c.forkerrors);
-  LockInc(&shared->c.dropped);
+  LockIncCounter(forkerrors);
+  LockIncCounter(dropped);
   EnterMeltdownMode();
   SendServiceUnavailable();
   close(client);
@@ -5654,15 +8209,18 @@ static void HandleForkFailure(void) {
 }
 
 static void HandleFrag(size_t got) {
-  LockInc(&shared->c.frags);
+  LockIncCounter(frags);
   DEBUGF("(stat) %s fragged msg added %,ld bytes to %,ld byte buffer",
          DescribeClient(), amtread, got);
 }
 
 static void HandleReload(void) {
-  LockInc(&shared->c.reloads);
+  LockIncCounter(reloads);
   LuaOnServerReload(Reindex());
   invalidated = false;
+  if (prefork && !__isworker) {
+    RecyclePreforkWorkers();
+  }
 }
 
 static void HandleHeartbeat(void) {
@@ -5681,6 +8239,9 @@ static void HandleHeartbeat(void) {
       polls[i].fd = -polls[i].fd;
     }
   }
+  if (prefork) {
+    preforkshortage = true;
+  }
 }
 
 // returns 0 on success or response on error
@@ -5699,14 +8260,14 @@ static char *OpenAsset(struct Asset *a) {
       if ((fd = open(a->file->path.s, O_RDONLY)) != -1) {
         data = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
         if (data != MAP_FAILED) {
-          LockInc(&shared->c.maps);
+          LockIncCounter(maps);
           UnmapLater(fd, data, size);
           cpm.content = data;
           cpm.contentlength = size;
         } else if ((st = gc(malloc(sizeof(struct stat)))) &&
                    fstat(fd, st) != -1 && (data = malloc(st->st_size))) {
           /* probably empty file or zipos handle */
-          LockInc(&shared->c.slurps);
+          LockIncCounter(slurps);
           FreeLater(data);
           if (ReadAll(fd, data, st->st_size) != -1) {
             cpm.content = data;
@@ -5734,7 +8295,7 @@ static char *OpenAsset(struct Asset *a) {
 
 static char *ServeServerOptions(void) {
   char *p;
-  LockInc(&shared->c.serveroptions);
+  LockIncCounter(serveroptions);
   p = SetStatus(200, "OK");
 #ifdef STATIC
   p = stpcpy(p, "Allow: GET, HEAD, OPTIONS\r\n");
@@ -5748,7 +8309,7 @@ static char *ServeServerOptions(void) {
 
 static void SendContinueIfNeeded(void) {
   if (cpm.msg.version >= 11 && HeaderEqualCase(kHttpExpect, "100-continue")) {
-    LockInc(&shared->c.continues);
+    LockIncCounter(continues);
     SendContinue();
   }
 }
@@ -5756,13 +8317,13 @@ static void SendContinueIfNeeded(void) {
 static char *ReadMore(void) {
   size_t got;
   ssize_t rc;
-  LockInc(&shared->c.frags);
+  LockIncCounter(frags);
   if ((rc = reader(client, inbuf.p + amtread, inbuf.n - amtread)) != -1) {
     if (!(got = rc))
       return HandlePayloadDisconnect();
     amtread += got;
   } else if (errno == EINTR) {
-    LockInc(&shared->c.readinterrupts);
+    LockIncCounter(readinterrupts);
     if (killed || ((meltdown || terminated) &&
                    timespec_cmp(timespec_sub(timespec_real(), startread),
                                 (struct timespec){1}) >= 0)) {
@@ -5774,9 +8335,157 @@ static char *ReadMore(void) {
   return NULL;
 }
 
-static char *SynchronizeLength(void) {
+// reads more payload into inbuf for a handler that's already running
+// returns null on success (or interrupt), otherwise reason for failure
+static const char *ReadPayload(size_t max) {
+  ssize_t rc;
+  LockIncCounter(frags);
+  if ((rc = reader(client, inbuf.p + amtread, max)) > 0) {
+    amtread += rc;
+    return NULL;
+  } else if (rc == -1 && errno == EINTR) {
+    LockIncCounter(readinterrupts);
+    if (!(killed || ((meltdown || terminated) &&
+                     timespec_cmp(timespec_sub(timespec_real(), startread),
+                                  (struct timespec){1}) >= 0))) {
+      return NULL;
+    }
+  }
+  connectionclose = true;
+  if (!rc) {
+    LockIncCounter(payloaddisconnects);
+    return "payload disconnect";
+  } else if (errno == EINTR) {
+    LockIncCounter(dropped);
+    return "payload dropped";
+  } else if (errno == ECONNRESET) {
+    LockIncCounter(readresets);
+    return "payload reset";
+  } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+    LockIncCounter(readtimeouts);
+    return "payload read timeout";
+  } else {
+    LockIncCounter(readerrors);
+    return "payload read error";
+  }
+}
+
+// reads the rest of a deferred payload, so it's contiguous in inbuf
+static const char *SlurpBody(void) {
+  ssize_t rc;
+  const char *err;
+  if (!cpm.bodypending)
+    return NULL;
+  if (cpm.bodystreamed)
+    return "payload is being streamed";
+  SendContinueIfNeeded();
+  for (;;) {
+    if (cpm.bodychunked) {
+      if ((rc = Unchunk(&cpm.unchunker, inbuf.p + hdrsize, amtread - hdrsize,
+                        &payloadlength)) == -1) {
+        connectionclose = true;
+        return "bad chunked encoding";
+      }
+      if (rc) {
+        cpm.msgsize = hdrsize + rc;
+        break;
+      }
+      if (amtread == inbuf.n)
+        goto TooLarge;
+      if ((err = ReadPayload(inbuf.n - amtread)))
+        return err;
+    } else {
+      if (amtread == hdrsize + payloadlength) {
+        cpm.msgsize = amtread;
+        break;
+      }
+      if (hdrsize + payloadlength > inbuf.n)
+        goto TooLarge;
+      if ((err = ReadPayload(hdrsize + payloadlength - amtread)))
+        return err;
+    }
+  }
+  cpm.bodypending = false;
+  return NULL;
+TooLarge:
+  LockIncCounter(hugepayloads);
+  connectionclose = true;
+  return "payload too large";
+}
+
+// reads next piece of a deferred payload into inbuf after the headers
+// the piece is only valid until the next call; zero length means eof
+static const char *ReadBodyPiece(const char **out, size_t *outlen) {
+  ssize_t rc;
+  const char *err;
+  *out = inbuf.p + hdrsize;
+  *outlen = 0;
+  if (!cpm.bodypending)
+    return NULL;
+  if (!cpm.bodystreamed) {
+    cpm.bodystreamed = true;
+    SendContinueIfNeeded();
+  } else {
+    amtread = hdrsize;  // discard previous piece
+    cpm.unchunker.i = 0;
+    cpm.unchunker.j = 0;
+  }
+  for (;;) {
+    if (cpm.bodychunked) {
+      if ((rc = Unchunk(&cpm.unchunker, inbuf.p + hdrsize, amtread - hdrsize,
+                        0)) == -1) {
+        connectionclose = true;
+        return "bad chunked encoding";
+      }
+      if (rc) {
+        cpm.bodypending = false;
+        cpm.msgsize = hdrsize + rc;
+      }
+      if (rc || cpm.unchunker.j) {
+        *outlen = cpm.unchunker.j;
+        payloadlength += *outlen;
+        return NULL;
+      }
+      if (amtread == inbuf.n) {
+        LockIncCounter(hugepayloads);
+        connectionclose = true;
+        return "chunk header too large";
+      }
+      if ((err = ReadPayload(inbuf.n - amtread)))
+        return err;
+    } else {
+      if (amtread > hdrsize) {
+        if (!cpm.bodyleft) {
+          cpm.bodypending = false;
+          cpm.msgsize = amtread;
+        }
+        *outlen = amtread - hdrsize;
+        return NULL;
+      }
+      if ((err = ReadPayload(MIN(cpm.bodyleft, inbuf.n - hdrsize))))
+        return err;
+      cpm.bodyleft -= amtread - hdrsize;
+    }
+  }
+}
+
+// closes connection if handler didn't consume all of deferred payload
+static void FinishBody(void) {
+  if (cpm.bodypending) {
+    DEBUGF("(clnt) %s handler left payload unread", DescribeClient());
+    connectionclose = true;
+    cpm.msgsize = amtread;
+  }
+}
+
+static char *SynchronizeLength(bool defer) {
   char *p;
   if (hdrsize + payloadlength > amtread) {
+    if (defer) {
+      cpm.bodypending = true;
+      cpm.bodyleft = hdrsize + payloadlength - amtread;
+      return NULL;
+    }
     if (hdrsize + payloadlength > inbuf.n)
       return HandleHugePayload();
     SendContinueIfNeeded();
@@ -5789,13 +8498,19 @@ static char *SynchronizeLength(void) {
   return NULL;
 }
 
-static char *SynchronizeChunked(void) {
+static char *SynchronizeChunked(bool defer) {
   char *p;
   ssize_t transferlength;
-  struct HttpUnchunker u = {0};
-  SendContinueIfNeeded();
-  while (!(transferlength = Unchunk(&u, inbuf.p + hdrsize, amtread - hdrsize,
-                                    &payloadlength))) {
+  if (!defer)
+    SendContinueIfNeeded();
+  while (!(transferlength = Unchunk(&cpm.unchunker, inbuf.p + hdrsize,
+                                    amtread - hdrsize, &payloadlength))) {
+    if (defer) {
+      cpm.bodypending = true;
+      cpm.bodychunked = true;
+      payloadlength = 0;
+      return NULL;
+    }
     if ((p = ReadMore()))
       return p;
   }
@@ -5805,12 +8520,22 @@ static char *SynchronizeChunked(void) {
   return NULL;
 }
 
+static bool IsFormRequest(void) {
+  return HasHeader(kHttpContentType) &&
+         IsMimeType(HeaderData(kHttpContentType),
+                    HeaderLength(kHttpContentType),
+                    "application/x-www-form-urlencoded");
+}
+
 static char *SynchronizeStream(void) {
+  bool defer;
   int64_t cl;
+  // form parameters and body logging need the payload before routing
+  defer = streambodies && !logbodies && !IsFormRequest();
   if (HasHeader(kHttpTransferEncoding) &&
       !HeaderEqualCase(kHttpTransferEncoding, "identity")) {
     if (HeaderEqualCase(kHttpTransferEncoding, "chunked")) {
-      return SynchronizeChunked();
+      return SynchronizeChunked(defer);
     } else {
       return HandleTransferRefused();
     }
@@ -5818,7 +8543,7 @@ static char *SynchronizeStream(void) {
     if ((cl = ParseContentLength(HeaderData(kHttpContentLength),
                                  HeaderLength(kHttpContentLength))) != -1) {
       payloadlength = cl;
-      return SynchronizeLength();
+      return SynchronizeLength(defer);
     } else {
       return HandleBadContentLength();
     }
@@ -5834,7 +8559,7 @@ static char *SynchronizeStream(void) {
 static void ParseRequestParameters(void) {
   uint32_t ip;
   FreeLater(ParseUrl(inbuf.p + cpm.msg.uri.a, cpm.msg.uri.b - cpm.msg.uri.a,
-                     &url, kUrlPlus | kUrlLatin1));
+                     &url, kUrlPlus | kUrlLatin1 | kUrlView));
   if (!url.host.p) {
     if (HasHeader(kHttpXForwardedHost) &&  //
         !GetRemoteAddr(&ip, 0) && IsTrustedIp(ip)) {
@@ -5883,11 +8608,11 @@ static bool HasAtMostThisElement(int h, const char *s) {
 static char *HandleRequest(void) {
   char *p;
   if (cpm.msg.version == 11) {
-    LockInc(&shared->c.http11);
+    LockIncCounter(http11);
   } else if (cpm.msg.version < 10) {
-    LockInc(&shared->c.http09);
+    LockIncCounter(http09);
   } else if (cpm.msg.version == 10) {
-    LockInc(&shared->c.http10);
+    LockIncCounter(http10);
   } else {
     return HandleVersionNotSupported();
   }
@@ -5915,7 +8640,7 @@ static char *HandleRequest(void) {
       !IsAcceptableHost(url.host.p, url.host.n) ||
       !IsAcceptablePort(url.port.p, url.port.n)) {
     free(url.params.p);
-    LockInc(&shared->c.urisrefused);
+    LockIncCounter(urisrefused);
     return ServeFailure(400, "Bad URI");
   }
   char method[9] = {0};
@@ -5924,12 +8649,12 @@ static char *HandleRequest(void) {
         cpm.msg.version, method, FreeLater(EncodeUrl(&url, 0)),
         HeaderLength(kHttpReferer), HeaderData(kHttpReferer),
         HeaderLength(kHttpUserAgent), HeaderData(kHttpUserAgent));
-  if (HasHeader(kHttpContentType) &&
-      IsMimeType(HeaderData(kHttpContentType), HeaderLength(kHttpContentType),
-                 "application/x-www-form-urlencoded")) {
+  if (IsFormRequest()) {
     FreeLater(ParseParams(inbuf.p + hdrsize, payloadlength, &url.params));
   }
   FreeLater(url.params.p);
+  if ((p = ServeMicrocache()))
+    return p;
 #ifndef STATIC
   if (hasonhttprequest)
     return LuaOnHttpRequest();
@@ -5955,8 +8680,10 @@ static char *Route(const char *host, size_t hostlen, const char *path,
     return p;
   } else if (SlicesEqual(path, pathlen, "/statusz", 8)) {
     return ServeStatusz();
+  } else if (luaprofile && SlicesEqual(path, pathlen, "/luaprofilez", 12)) {
+    return ServeLuaProfilez();
   } else {
-    LockInc(&shared->c.notfounds);
+    LockIncCounter(notfounds);
     return ServeErrorWithPath(404, "Not Found", path, pathlen);
   }
 }
@@ -5977,7 +8704,7 @@ static char *RoutePath(const char *path, size_t pathlen) {
         return HandleFolder(path, pathlen);
       }
     } else {
-      LockInc(&shared->c.forbiddens);
+      LockIncCounter(forbiddens);
       WARNF("(srvr) asset %`'.*s %#o isn't readable", pathlen, path, m);
       return ServeErrorWithPath(403, "Forbidden", path, pathlen);
     }
@@ -5995,7 +8722,7 @@ static char *RouteHost(const char *host, size_t hostlen, const char *path,
   if (hostlen) {
     hn = 1 + hostlen + url.path.n;
     hm = 3 + 1 + hn;
-    hp = hm <= sizeof(b) ? b : FreeLater(xmalloc(hm));
+    hp = hm <= sizeof(b) ? b : xAllocLater(hm);
     hp[0] = '/';
     mempcpy(mempcpy(hp + 1, host, hostlen), path, pathlen);
     if ((p = RoutePath(hp, hn)))
@@ -6031,6 +8758,33 @@ static inline bool IsLua(struct Asset *a) {
          READ32LE(p + n - 4) == ('.' | 'l' << 8 | 'u' << 16 | 'a' << 24);
 }
 
+// compiles the lua pages in the zip ahead of time in the main process
+static void PrecompileLuaAssets(void) {
+#ifndef STATIC
+  uint32_t i, n;
+  struct Asset *a;
+  char name[PATH_MAX];
+  lua_State *L = GL;
+  if (!L || !isinitialized)
+    return;
+  for (n = i = 0; i < assets.n; ++i) {
+    a = assets.p + i;
+    if (!a->hash || a->bytecode || !IsLua(a) || S_ISDIR(GetMode(a)))
+      continue;
+    snprintf(name, sizeof(name), "@/%.*s", ZIP_CFILE_NAMESIZE(zmap + a->cf),
+             ZIP_CFILE_NAME(zmap + a->cf));
+    if (LoadLuaAsset(L, a, name) == LUA_OK) {
+      ++n;
+    } else {
+      VERBOSEF("(lua) can't precompile: %s", lua_tostring(L, -1));
+    }
+    lua_pop(L, 1);
+  }
+  if (n)
+    DEBUGF("(lua) precompiled %u lua assets", n);
+#endif
+}
+
 static char *HandleAsset(struct Asset *a, const char *path, size_t pathlen) {
   char *p;
 #ifndef STATIC
@@ -6038,7 +8792,7 @@ static char *HandleAsset(struct Asset *a, const char *path, size_t pathlen) {
     return ServeLua(a, path, pathlen);
 #endif
   if (cpm.msg.method == kHttpGet || cpm.msg.method == kHttpHead) {
-    LockInc(&shared->c.staticrequests);
+    LockIncCounter(staticrequests);
     p = ServeAsset(a, path, pathlen);
     if (!cpm.gotxcontenttypeoptions) {
       p = stpcpy(p, "X-Content-Type-Options: nosniff\r\n");
@@ -6073,11 +8827,17 @@ static bool IsNotModified(struct Asset *a) {
 
 static char *ServeAsset(struct Asset *a, const char *path, size_t pathlen) {
   char *p;
-  const char *ct;
+  struct Asset *b;
+  const char *ct, *enc;
+  b = 0;
   ct = GetContentType(a, path, pathlen);
   if (IsNotModified(a)) {
-    LockInc(&shared->c.notmodifieds);
+    LockIncCounter(notmodifieds);
     p = SetStatus(304, "Not Modified");
+  } else if ((b = GetAssetVariant(a, &enc))) {
+    p = ServeAssetVariant(b, enc);
+    if (cpm.statuscode != 200)
+      return p;
   } else {
     if (!a->file) {
       cpm.content = (char *)ZIP_LFILE_CONTENT(zmap + a->lf);
@@ -6085,7 +8845,13 @@ static char *ServeAsset(struct Asset *a, const char *path, size_t pathlen) {
     } else if ((p = OpenAsset(a))) {
       return p;
     }
-    if (IsCompressed(a)) {
+    if (IsZstd(a)) {
+      if (ClientAcceptsEncoding("zstd")) {
+        p = ServeAssetZstd(a);
+      } else {
+        p = ServeAssetDecompressed(a);
+      }
+    } else if (IsCompressed(a)) {
       if (ClientAcceptsGzip()) {
         p = ServeAssetPrecompressed(a);
       } else {
@@ -6094,7 +8860,7 @@ static char *ServeAsset(struct Asset *a, const char *path, size_t pathlen) {
     } else if (cpm.msg.version >= 11 && HasHeader(kHttpRange)) {
       p = ServeAssetRange(a);
     } else if (!a->file) {
-      LockInc(&shared->c.identityresponses);
+      LockIncCounter(identityresponses);
       DEBUGF("(zip) ServeAssetZipIdentity(%`'s)", ct);
       if (Verify(cpm.content, cpm.contentlength,
                  ZIP_LFILE_CRC32(zmap + a->lf))) {
@@ -6122,7 +8888,7 @@ static char *ServeAsset(struct Asset *a, const char *path, size_t pathlen) {
     if (!cpm.gotcachecontrol) {
       p = AppendCache(p, cacheseconds, cachedirective);
     }
-    if (!IsCompressed(a)) {
+    if (!IsCompressed(a) && !b) {
       p = stpcpy(p, "Accept-Ranges: bytes\r\n");
     }
   }
@@ -6162,9 +8928,11 @@ static inline bool MustNotIncludeMessageBody(void) { /* RFC2616 § 4.4 */
 }
 
 static bool TransmitResponse(char *p) {
-  int iovlen;
+  int fd, iovlen, body;
   struct iovec iov[4];
+  int64_t offset;
   long actualcontentlength;
+  body = -1;
   if (cpm.msg.version >= 10) {
     actualcontentlength = cpm.contentlength;
     if (cpm.gzipped) {
@@ -6188,7 +8956,7 @@ static bool TransmitResponse(char *p) {
       }
       iov[iovlen].iov_base = cpm.content;
       iov[iovlen].iov_len = cpm.contentlength;
-      ++iovlen;
+      body = iovlen++;
       if (cpm.gzipped) {
         iov[iovlen].iov_base = gzip_footer;
         iov[iovlen].iov_len = sizeof(gzip_footer);
@@ -6198,10 +8966,15 @@ static bool TransmitResponse(char *p) {
   } else {
     iov[0].iov_base = cpm.content;
     iov[0].iov_len = cpm.contentlength;
+    body = 0;
     iovlen = 1;
   }
-  Send(iov, iovlen);
-  LockInc(&shared->c.messageshandled);
+  if (body != -1 && ShouldSendfile() && (fd = GetContentFile(&offset)) != -1) {
+    SendWithFile(iov, iovlen, body, fd, offset);
+  } else {
+    Send(iov, iovlen);
+  }
+  LockIncCounter(messageshandled);
   ++messageshandled;
   return true;
 }
@@ -6264,7 +9037,7 @@ static bool StreamResponse(char *p) {
 }
 
 static bool HandleMessageActual(void) {
-  int rc;
+  int rc, route;
   long reqtime, contime;
   char *p;
   struct timespec now;
@@ -6276,8 +9049,14 @@ static bool HandleMessageActual(void) {
       LogMessage("received", inbuf.p, hdrsize);
     }
     p = HandleRequest();
+    ReleaseMicrocache();
+    FinishBody();
+    if (ispreforkworker && preforkrequests &&
+        ++preforkmessages >= preforkrequests) {
+      connectionclose = true;  // recycle this worker after the response
+    }
   } else {
-    LockInc(&shared->c.badmessages);
+    LockIncCounter(badmessages);
     connectionclose = true;
     if ((p = DumpHexc(inbuf.p, MIN(amtread, 256), 0))) {
       INFOF("(clnt) %s sent garbage %s", DescribeClient(), p);
@@ -6287,7 +9066,7 @@ static bool HandleMessageActual(void) {
   if (!cpm.msgsize) {
     amtread = 0;
     connectionclose = true;
-    LockInc(&shared->c.synchronizationfailures);
+    LockIncCounter(synchronizationfailures);
     DEBUGF("(clnt) could not synchronize message stream");
   }
   if (cpm.msg.version >= 10) {
@@ -6314,8 +9093,13 @@ static bool HandleMessageActual(void) {
     p = stpcpy(p, cpm.referrerpolicy);
     p = stpcpy(p, "\r\n");
   }
+  now = timespec_real();
+  route =
+      GetLatencyRoute(inbuf.p + cpm.msg.uri.a, cpm.msg.uri.b - cpm.msg.uri.a);
+  RecordLatency(route, kLatencyHandler, timespec_sub(now, startrequest));
+  if (!messageshandled)
+    RecordLatency(route, kLatencyFirstByte, timespec_sub(now, startconnection));
   if (loglatency || LOGGABLE(kLogDebug) || hasonloglatency) {
-    now = timespec_real();
     reqtime = timespec_tomicros(timespec_sub(now, startrequest));
     contime = timespec_tomicros(timespec_sub(now, startconnection));
     if (hasonloglatency)
@@ -6343,6 +9127,7 @@ static bool HandleMessage(void) {
 static void InitRequest(void) {
   assert(!cpm.outbuf);
   bzero(&cpm, sizeof(cpm));
+  ++requestgeneration;
 }
 
 static bool IsSsl(unsigned char c) {
@@ -6355,12 +9140,19 @@ static bool IsSsl(unsigned char c) {
   return true;
 }
 
-static void HandleMessages(void) {
+// returns with parkclient set if an idle keepalive client should be
+// handed back to the prefork worker loop rather than be waited upon
+static bool ShouldParkClient(void) {
+  return ispreforkworker && parked.n < maxparked && !usingssl &&
+         !invalidated && !meltdown;
+}
+
+static void HandleMessages(bool resumed) {
   bool once;
   ssize_t rc;
   size_t got;
   (void)once;
-  for (once = false;;) {
+  for (once = resumed;;) {
     InitRequest();
     startread = timespec_real();
     for (;;) {
@@ -6406,21 +9198,21 @@ static void HandleMessages(void) {
           return;
         }
       } else if (errno == EINTR) {
-        LockInc(&shared->c.readinterrupts);
+        LockIncCounter(readinterrupts);
         errno = 0;
       } else if (errno == EAGAIN) {
-        LockInc(&shared->c.readtimeouts);
+        LockIncCounter(readtimeouts);
         if (amtread)
           SendTimeout();
         NotifyClose();
         LogClose("read timeout");
         return;
       } else if (errno == ECONNRESET) {
-        LockInc(&shared->c.readresets);
+        LockIncCounter(readresets);
         LogClose("read reset");
         return;
       } else {
-        LockInc(&shared->c.readerrors);
+        LockIncCounter(readerrors);
         if (errno == EBADF) {  // don't warn on close/bad fd
           LogClose("read badf");
         } else {
@@ -6433,7 +9225,7 @@ static void HandleMessages(void) {
            (!amtread || timespec_cmp(timespec_sub(timespec_real(), startread),
                                      (struct timespec){1}) >= 0))) {
         if (amtread) {
-          LockInc(&shared->c.dropped);
+          LockIncCounter(dropped);
           SendServiceUnavailable();
         }
         NotifyClose();
@@ -6453,10 +9245,13 @@ static void HandleMessages(void) {
         NotifyClose();
         LogClose(DescribeClose());
         return;
+      } else if (ShouldParkClient()) {
+        parkclient = true;
+        return;
       }
     } else {
       CHECK_LT(cpm.msgsize, amtread);
-      LockInc(&shared->c.pipelinedrequests);
+      LockIncCounter(pipelinedrequests);
       DEBUGF("(stat) %,ld pipelinedrequest bytes", amtread - cpm.msgsize);
       memmove(inbuf.p, inbuf.p + cpm.msgsize, amtread - cpm.msgsize);
       amtread -= cpm.msgsize;
@@ -6469,6 +9264,7 @@ static void HandleMessages(void) {
         return;
       }
     }
+    FlushLog();
     CollectGarbage();
     if (invalidated) {
       HandleReload();
@@ -6484,6 +9280,7 @@ static void CloseServerFds(void) {
 }
 
 static int ExitWorker(void) {
+  FlushLog();
   if (IsModeDbg() && !sandboxed) {
     isexitingworker = true;
     return eintr();
@@ -6512,12 +9309,139 @@ static int EnableSandbox(void) {
     case 2:  // -SS
       DEBUGF("(stat) applying '%s' sandbox policy", "offline");
       UnveilRedbean();
-      return pledge("stdio rpath id", 0);
+      // prefork workers still need to accept() their own clients
+      return pledge(ispreforkworker ? "stdio rpath anet id" : "stdio rpath id",
+                    0);
     default:  // -SSS
       DEBUGF("(stat) applying '%s' sandbox policy", "contained");
       UnveilRedbean();
-      return pledge("stdio", 0);
+      return pledge(ispreforkworker ? "stdio anet" : "stdio", 0);
+  }
+}
+
+static void InitWorker(void) {
+  lua_repl_wock();
+  lua_repl_lock();
+  meltdown = false;
+  __isworker = true;
+  connectionclose = false;
+  RedirectLogToRing();
+  if (!IsTiny() && systrace) {
+    kStartTsc = rdtsc();
+  }
+  TRACE_BEGIN;
+  StartLuaProfiler();
+  if (sandboxed) {
+    CHECK_NE(-1, EnableSandbox());
+  }
+  if (hasonworkerstart) {
+    CallSimpleHook("OnWorkerStart");
+  }
+}
+
+static void ParkClient(void) {
+  struct Park *k;
+  parkclient = false;
+  if (!parked.p)
+    parked.p = xmalloc(maxparked * sizeof(*parked.p));
+  LockIncCounter(parks);
+  DEBUGF("(stat) %s parked after %,d messages", DescribeClient(),
+         messageshandled);
+  k = parked.p + parked.n++;
+  k->fd = client;
+  k->since = timespec_real();
+  k->clientaddr = clientaddr;
+  k->serveraddr = serveraddr;
+  k->messageshandled = messageshandled;
+  k->startconnection = startconnection;
+}
+
+// releases client after it was served without forking a process
+static void FinishClient(void) {
+  if (parkclient) {
+    ParkClient();
+  } else {
+    DEBUGF("(stat) %s closing after %,ldµs", DescribeClient(),
+           timespec_tomicros(timespec_sub(timespec_real(), startconnection)));
+    close(client);
+  }
+  oldin.p = 0;
+  oldin.n = 0;
+  if (inbuf.c) {
+    inbuf.p -= inbuf.c;
+    inbuf.n += inbuf.c;
+    inbuf.c = 0;
+  }
+#ifndef UNSECURE
+  if (usingssl) {
+    if (h2.active)
+      H2Destroy();
+    usingssl = false;
+    usingktls = false;
+    reader = read;
+    writer = WritevAll;
+    mbedtls_ssl_session_reset(&ssl);
   }
+#endif
+}
+
+// serves the next messages of a parked keepalive client
+static void ResumeClient(size_t i) {
+  struct Park k;
+  k = parked.p[i];
+  parked.p[i] = parked.p[--parked.n];
+  client = k.fd;
+  clientaddr = k.clientaddr;
+  serveraddr = k.serveraddr;
+  messageshandled = k.messageshandled;
+  startconnection = k.startconnection;
+  ishandlingconnection = true;
+  HandleMessages(true);
+  ishandlingconnection = false;
+  FinishClient();
+  CollectGarbage();
+}
+
+static void CloseParkedClient(size_t i) {
+  close(parked.p[i].fd);
+  parked.p[i] = parked.p[--parked.n];
+}
+
+static void CloseParkedClients(void) {
+  while (parked.n) {
+    CloseParkedClient(parked.n - 1);
+  }
+}
+
+static void ExpireParkedClients(void) {
+  size_t i;
+  struct timespec now, idle;
+  if (timeout.tv_sec < 0)
+    return;  // rely on tcp keepalive to detect dead peers
+  now = timespec_real();
+  idle = timeval_totimespec(timeout);
+  for (i = parked.n; i--;) {
+    if (timespec_cmp(timespec_sub(now, parked.p[i].since), idle) >= 0) {
+      LockIncCounter(parktimeouts);
+      CloseParkedClient(i);
+    }
+  }
+}
+
+// collects garbage so that forked workers inherit a compact lua heap,
+// rather than dirtying copy-on-write pages collecting it themselves
+static void CollectGarbageBeforeFork(void) {
+#ifndef STATIC
+  int kb;
+  static int gcforkkb;
+  if (!gcbeforefork)
+    return;
+  if ((kb = lua_gc(GL, LUA_GCCOUNT)) == gcforkkb)
+    return;  // nothing was allocated since last time
+  lua_gc(GL, LUA_GCCOLLECT);
+  gcforkkb = lua_gc(GL, LUA_GCCOUNT);
+  DEBUGF("(lua) collected %,dkb of garbage before fork", kb - gcforkkb);
+#endif
 }
 
 static int HandleConnection(size_t i) {
@@ -6526,28 +9450,28 @@ static int HandleConnection(size_t i) {
   clientaddrsize = sizeof(clientaddr);
   if ((client = accept4(servers.p[i].fd, (struct sockaddr *)&clientaddr,
                         &clientaddrsize, SOCK_CLOEXEC)) != -1) {
-    LockInc(&shared->c.accepts);
+    LockIncCounter(accepts);
     GetClientAddr(&ip, 0);
     if (tokenbucket.cidr && tokenbucket.reject >= 0) {
       if (!IsTrustedIp(ip)) {
-        tok = AcquireToken(tokenbucket.b, ip, tokenbucket.cidr);
+        tok = AcquireToken4(tokenbucket.tb, ip, timespec_mono_coarse());
         if (tok <= tokenbucket.ban && tokenbucket.ban >= 0) {
           WARNF("(token) banning %hhu.%hhu.%hhu.%hhu who only has %d tokens",
                 ip >> 24, ip >> 16, ip >> 8, ip, tok);
-          LockInc(&shared->c.bans);
+          LockIncCounter(bans);
           Blackhole(ip);
           close(client);
           return 0;
         } else if (tok <= tokenbucket.ignore && tokenbucket.ignore >= 0) {
           DEBUGF("(token) ignoring %hhu.%hhu.%hhu.%hhu who only has %d tokens",
                  ip >> 24, ip >> 16, ip >> 8, ip, tok);
-          LockInc(&shared->c.ignores);
+          LockIncCounter(ignores);
           close(client);
           return 0;
         } else if (tok < tokenbucket.reject) {
           WARNF("(token) rejecting %hhu.%hhu.%hhu.%hhu who only has %d tokens",
                 ip >> 24, ip >> 16, ip >> 8, ip, tok);
-          LockInc(&shared->c.rejects);
+          LockIncCounter(rejects);
           SendTooManyRequests();
           close(client);
           return 0;
@@ -6563,7 +9487,7 @@ static int HandleConnection(size_t i) {
       DEBUGF("(token) can't acquire accept() token for client");
     }
     startconnection = timespec_real();
-    if (UNLIKELY(maxworkers) &&
+    if (UNLIKELY(maxworkers) && !ispreforkworker &&
         atomic_load_explicit(&shared->workers, memory_order_relaxed) >=
             maxworkers) {
       EnterMeltdownMode();
@@ -6580,24 +9504,15 @@ static int HandleConnection(size_t i) {
     if (uniprocess) {
       pid = -1;
       connectionclose = true;
+    } else if (ispreforkworker) {
+      pid = -1;
+      connectionclose = false;
+      LockIncCounter(connectionshandled);
     } else {
+      CollectGarbageBeforeFork();
       switch ((pid = fork())) {
         case 0:
-          lua_repl_wock();
-          lua_repl_lock();
-          meltdown = false;
-          __isworker = true;
-          connectionclose = false;
-          if (!IsTiny() && systrace) {
-            kStartTsc = rdtsc();
-          }
-          TRACE_BEGIN;
-          if (sandboxed) {
-            CHECK_NE(-1, EnableSandbox());
-          }
-          if (hasonworkerstart) {
-            CallSimpleHook("OnWorkerStart");
-          }
+          InitWorker();
           break;
         case -1:
           HandleForkFailure();
@@ -6615,69 +9530,55 @@ static int HandleConnection(size_t i) {
     if (!pid && !IsWindows()) {
       CloseServerFds();
     }
-    HandleMessages();
-    DEBUGF("(stat) %s closing after %,ldµs", DescribeClient(),
-           timespec_tomicros(timespec_sub(timespec_real(), startconnection)));
+    HandleMessages(false);
+    FlushLog();
     if (!pid) {
+      DEBUGF("(stat) %s closing after %,ldµs", DescribeClient(),
+             timespec_tomicros(timespec_sub(timespec_real(), startconnection)));
       if (hasonworkerstop) {
         CallSimpleHook("OnWorkerStop");
       }
       rc = ExitWorker();
     } else {
-      close(client);
-      oldin.p = 0;
-      oldin.n = 0;
-      if (inbuf.c) {
-        inbuf.p -= inbuf.c;
-        inbuf.n += inbuf.c;
-        inbuf.c = 0;
-      }
-#ifndef UNSECURE
-      if (usingssl) {
-        usingssl = false;
-        reader = read;
-        writer = WritevAll;
-        mbedtls_ssl_session_reset(&ssl);
-      }
-#endif
+      FinishClient();
     }
     CollectGarbage();
   } else {
     if (errno == EINTR || errno == EAGAIN) {
-      LockInc(&shared->c.acceptinterrupts);
+      LockIncCounter(acceptinterrupts);
     } else if (errno == ENFILE) {
-      LockInc(&shared->c.enfiles);
+      LockIncCounter(enfiles);
       LogAcceptError("enfile: too many open files");
       meltdown = true;
     } else if (errno == EMFILE) {
-      LockInc(&shared->c.emfiles);
+      LockIncCounter(emfiles);
       LogAcceptError("emfile: ran out of open file quota");
       meltdown = true;
     } else if (errno == ENOMEM) {
-      LockInc(&shared->c.enomems);
+      LockIncCounter(enomems);
       LogAcceptError("enomem: ran out of memory");
       meltdown = true;
     } else if (errno == ENOBUFS) {
-      LockInc(&shared->c.enobufs);
+      LockIncCounter(enobufs);
       LogAcceptError("enobuf: ran out of buffer");
       meltdown = true;
     } else if (errno == ENONET) {
-      LockInc(&shared->c.enonets);
+      LockIncCounter(enonets);
       LogAcceptError("enonet: network gone");
       polls[i].fd = -polls[i].fd;
     } else if (errno == ENETDOWN) {
-      LockInc(&shared->c.enetdowns);
+      LockIncCounter(enetdowns);
       LogAcceptError("enetdown: network down");
       polls[i].fd = -polls[i].fd;
     } else if (errno == ECONNABORTED) {
-      LockInc(&shared->c.accepterrors);
-      LockInc(&shared->c.acceptresets);
+      LockIncCounter(accepterrors);
+      LockIncCounter(acceptresets);
       WARNF("(srvr) %s accept error: %s", DescribeServer(),
             "acceptreset: connection reset before accept");
     } else if (errno == ENETUNREACH || errno == EHOSTUNREACH ||
                errno == EOPNOTSUPP || errno == ENOPROTOOPT || errno == EPROTO) {
-      LockInc(&shared->c.accepterrors);
-      LockInc(&shared->c.acceptflakes);
+      LockIncCounter(accepterrors);
+      LockIncCounter(acceptflakes);
       WARNF("(srvr) accept error: %s ephemeral accept error: %m",
             DescribeServer());
     } else {
@@ -6701,10 +9602,14 @@ static void MakeExecutableModifiable(void) {
     return;  // TODO
   if (endswith(zpath, ".dbg"))
     return;
+  if (zmapfd == zfd)
+    zmapfd = -1;  // so sendfile() can't be given a closed or reused fd
   close(zfd);
   ft = ftrace_enabled(0);
   if ((zfd = __open_executable()) == -1) {
     WARNF("(srvr) can't open executable for modification: %m");
+  } else if (zmapfd == -1) {
+    zmapfd = zfd;
   }
   if (ft > 0) {
     __ftrace = 0;
@@ -6759,11 +9664,14 @@ static int HandleReadline(void) {
 
 static int HandlePoll(int ms) {
   int rc, nfds;
-  size_t pollid, serverid;
-  if ((nfds = poll(polls, 1 + servers.n, ms)) != -1) {
+  size_t pollid, serverid, npolls;
+  // prefork workers accept connections, so the main process only polls
+  // standard input, and otherwise sleeps in case it needs to respawn
+  npolls = 1 + (prefork ? 0 : servers.n);
+  if ((nfds = poll(polls, npolls, ms)) != -1) {
     if (nfds) {
       // handle pollid/o events
-      for (pollid = 0; pollid < 1 + servers.n; ++pollid) {
+      for (pollid = 0; pollid < npolls; ++pollid) {
         if (!polls[pollid].revents)
           continue;
         if (polls[pollid].fd < 0)
@@ -6799,9 +9707,9 @@ static int HandlePoll(int ms) {
     }
   } else {
     if (errno == EINTR || errno == EAGAIN) {
-      LockInc(&shared->c.pollinterrupts);
+      LockIncCounter(pollinterrupts);
     } else if (errno == ENOMEM) {
-      LockInc(&shared->c.enomems);
+      LockIncCounter(enomems);
       WARNF("(srvr) poll error: ran out of memory");
       meltdown = true;
     } else {
@@ -6812,9 +9720,145 @@ static int HandlePoll(int ms) {
   return 0;
 }
 
+// makes prefork worker only accept from the shard of its pool slot
+static void UseListenShard(int slot) {
+  size_t i, n;
+  if (listenshards <= 1)
+    return;
+  for (n = i = 0; i < servers.n; ++i) {
+    if (servers.p[i].shard == slot % listenshards) {
+      servers.p[n] = servers.p[i];
+      polls[1 + n] = polls[1 + i];
+      ++n;
+    } else {
+      close(servers.p[i].fd);
+    }
+  }
+  servers.n = n;
+}
+
+// runs inside a prefork worker until it's recycled or terminated
+//
+// idle keepalive clients are parked, i.e. polled alongside the server
+// sockets, so a single worker can hold many idle connections open and
+// only switches to the request path once its client sends a message.
+static int PreforkWorkerLoop(void) {
+  int ms;
+  size_t i, n;
+  struct pollfd *fds;
+  DEBUGF("(srvr) prefork worker %d accepting connections", getpid());
+  fds = xmalloc((servers.n + maxparked) * sizeof(*fds));
+  while (!terminated && !killed && !invalidated) {
+    if (preforkrequests && preforkmessages >= preforkrequests) {
+      VERBOSEF("(srvr) recycling worker %d after %,ld messages", getpid(),
+               preforkmessages);
+      break;
+    }
+    memcpy(fds, polls + 1, servers.n * sizeof(*fds));
+    for (i = 0; i < parked.n; ++i) {
+      fds[servers.n + i].fd = parked.p[i].fd;
+      fds[servers.n + i].events = POLLIN;
+      fds[servers.n + i].revents = 0;
+    }
+    n = parked.n;
+    ms = timespec_tomillis(heartbeatinterval);
+    if (n && timeout.tv_sec >= 0)
+      ms = MIN(ms, timeval_tomillis(timeout));
+    if (poll(fds, servers.n + n, ms) != -1) {
+      // iterate backwards since resuming may move the last parked client
+      for (i = n; i--;) {
+        if (fds[servers.n + i].revents) {
+          ResumeClient(i);
+        }
+      }
+      for (i = 0; i < servers.n; ++i) {
+        if (!fds[i].revents)
+          continue;
+        if (fds[i].fd < 0)
+          continue;
+        serveraddr = &servers.p[i].addr;
+        ishandlingconnection = true;
+        HandleConnection(i);
+        ishandlingconnection = false;
+      }
+    } else if (errno == EINTR || errno == EAGAIN) {
+      LockIncCounter(pollinterrupts);
+      errno = 0;
+    } else {
+      DIEF("(srvr) poll error: %m");
+    }
+    if (meltdown) {
+      CloseParkedClients();  // shed idle keepalive clients
+      meltdown = false;
+    } else {
+      ExpireParkedClients();
+    }
+  }
+  CloseParkedClients();
+  free(fds);
+  if (hasonworkerstop) {
+    CallSimpleHook("OnWorkerStop");
+  }
+  return ExitWorker();
+}
+
+// forks workers into empty slots of the prefork pool
+static int SpawnPreforkWorkers(void) {
+  int i, pid;
+  preforkshortage = false;
+  for (i = 0; i < prefork && !terminated; ++i) {
+    if (preforkpids[i])
+      continue;
+    CollectGarbageBeforeFork();
+    switch ((pid = fork())) {
+      case 0:
+        ispreforkworker = true;
+        UseListenShard(i);
+        InitWorker();
+        return PreforkWorkerLoop();
+      case -1:
+        LockIncCounter(forkerrors);
+        WARNF("(srvr) failed to fork prefork worker: %m");
+        return 0;  // heartbeat will try again
+      default:
+        preforkpids[i] = pid;
+        LockInc(&shared->workers);
+        ReseedRng(&rng, "parent");
+        break;
+    }
+  }
+  return 0;
+}
+
+static bool EnableReusePort(int fd) {
+  if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT_LB, &(int){1}, sizeof(int))) {
+    WARNF("(srvr) failed to enable reuseport load balancing: %m");
+    return false;
+  }
+  return true;
+}
+
+// opens another listener bound to the same address as primary
+static bool ListenShard(struct Server *shard, struct Server *primary, int k) {
+  *shard = *primary;
+  shard->shard = k;
+  if ((shard->fd = GoodSocket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP,
+                              true, &timeout)) == -1) {
+    return false;
+  }
+  if (!EnableReusePort(shard->fd) ||
+      bind(shard->fd, (struct sockaddr *)&shard->addr, sizeof(shard->addr)) ||
+      listen(shard->fd, 10)) {
+    close(shard->fd);
+    return false;
+  }
+  return true;
+}
+
 static void Listen(void) {
+  int k;
   char ipbuf[16];
-  size_t i, j, n;
+  size_t i, j, m, n;
   uint32_t ip, port, addrsize, *ifp;
   bool hasonserverlisten = IsHookDefined("OnServerListen");
   bool is_default_port = false;
@@ -6833,7 +9877,15 @@ static void Listen(void) {
       ProgramAddr("0.0.0.0");
     }
   }
-  servers.p = malloc(ips.n * ports.n * sizeof(*servers.p));
+  listenshards = 1;
+  if (reuseportshards && prefork > 1) {
+    if (SO_REUSEPORT_LB) {
+      listenshards = prefork;
+    } else {
+      WARNF("(srvr) reuseport load balancing isn't supported on this os");
+    }
+  }
+  servers.p = malloc(ips.n * ports.n * listenshards * sizeof(*servers.p));
   for (n = i = 0; i < ips.n; ++i) {
     for (j = 0; j < ports.n; ++j, ++n) {
       bzero(servers.p + n, sizeof(*servers.p));
@@ -6850,6 +9902,9 @@ static void Listen(void) {
         n--;  // skip this server instance
         continue;
       }
+      if (listenshards > 1 && !EnableReusePort(servers.p[n].fd)) {
+        listenshards = 1;
+      }
       // Try binding with port auto-increment for default port
       int max_attempts = (is_default_port && ports.p[j] < 8100) ? 20 : 1;
       int attempt;
@@ -6898,8 +9953,26 @@ static void Listen(void) {
       }
     }
   }
+  // give each prefork worker its own accept queue for every address
+  for (m = n, k = 1; k < listenshards; ++k) {
+    for (i = 0; i < n; ++i) {
+      if (ListenShard(servers.p + m, servers.p + i, k)) {
+        ++m;
+      } else {
+        WARNF("(srvr) failed to open listener shard %d: %m", k);
+        while (m > n * k)
+          close(servers.p[--m].fd);
+        listenshards = k;
+        break;
+      }
+    }
+  }
+  if (listenshards > 1) {
+    INFOF("(srvr) using %d reuseport listeners per address", listenshards);
+  }
+  n = m;
   // shrink allocated memory in case some of the sockets were skipped
-  if (n < ips.n * ports.n)
+  if (n < ips.n * ports.n * listenshards)
     servers.p = realloc(servers.p, n * sizeof(*servers.p));
   servers.n = n;
   polls = malloc((1 + n) * sizeof(*polls));
@@ -6928,6 +10001,7 @@ static void HandleShutdown(void) {
 
 // this function coroutines with linenoise
 int EventLoop(int ms) {
+  int rc;
   struct timespec t;
   DEBUGF("(repl) event loop");
   while (!terminated) {
@@ -6949,6 +10023,12 @@ int EventLoop(int ms) {
                             heartbeatinterval) >= 0) {
       lastheartbeat = t;
       HandleHeartbeat();
+    } else if (preforkshortage) {
+      lua_repl_lock();
+      rc = SpawnPreforkWorkers();
+      lua_repl_unlock();
+      if (rc == -1)
+        break;
     } else if (HandlePoll(ms) == -1) {
       break;
     }
@@ -7003,6 +10083,66 @@ static int TlsRoutePsk(void *ctx, mbedtls_ssl_context *ssl,
   return -1;
 }
 
+// session id cache that lives in shared memory so any worker process
+// may resume a session that was negotiated by some other worker. each
+// slot is guarded by a seqlock; a writer that loses the race gives up
+static struct SslCache *GetSslCacheSlot(const unsigned char *id) {
+  return shared->sslcache + READ32LE(id) % SSLCACHESLOTS;
+}
+
+static int TlsCacheGet(void *ctx, mbedtls_ssl_session *session) {
+  uint32_t seq;
+  struct SslCache *c, t;
+  if (session->id_len != 32)
+    return 1;
+  c = GetSslCacheSlot(session->id);
+  seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+  if (seq & 1)
+    return 1;
+  memcpy(&t, c, sizeof(t));
+  atomic_thread_fence(memory_order_acquire);
+  if (atomic_load_explicit(&c->seq, memory_order_relaxed) != seq)
+    return 1;
+  if (t.id_len != session->id_len ||
+      t.ciphersuite != session->ciphersuite ||
+      shared->nowish.tv_sec - t.start > sslticketlifetime ||
+      timingsafe_bcmp(t.id, session->id, t.id_len)) {
+    return 1;
+  }
+  session->start = t.start;
+  session->verify_result = t.verify_result;
+  session->mfl_code = t.mfl_code;
+  session->encrypt_then_mac = t.encrypt_then_mac;
+  memcpy(session->master, t.master, sizeof(t.master));
+  mbedtls_platform_zeroize(&t, sizeof(t));
+  LockIncCounter(sslcachehits);
+  return 0;
+}
+
+static int TlsCacheSet(void *ctx, const mbedtls_ssl_session *session) {
+  uint32_t seq;
+  struct SslCache *c;
+  if (session->id_len != 32)
+    return 1;
+  c = GetSslCacheSlot(session->id);
+  seq = atomic_load_explicit(&c->seq, memory_order_relaxed);
+  if ((seq & 1) || !atomic_compare_exchange_strong_explicit(
+                       &c->seq, &seq, seq + 1, memory_order_acquire,
+                       memory_order_relaxed)) {
+    return 1;
+  }
+  c->id_len = session->id_len;
+  c->mfl_code = session->mfl_code;
+  c->ciphersuite = session->ciphersuite;
+  c->encrypt_then_mac = session->encrypt_then_mac;
+  c->verify_result = session->verify_result;
+  c->start = session->start;
+  memcpy(c->id, session->id, sizeof(c->id));
+  memcpy(c->master, session->master, sizeof(c->master));
+  atomic_store_explicit(&c->seq, seq + 2, memory_order_release);
+  return 0;
+}
+
 static void TlsInit(void) {
 #ifndef UNSECURE
   int suite;
@@ -7039,6 +10179,10 @@ static void TlsInit(void) {
                              MBEDTLS_CIPHER_AES_256_GCM, sslticketlifetime);
     mbedtls_ssl_conf_session_tickets_cb(&conf, mbedtls_ssl_ticket_write,
                                         mbedtls_ssl_ticket_parse, &ssltick);
+    // resumed sessions don't carry the peer certificate chain
+    if (!sslclientverify) {
+      mbedtls_ssl_conf_session_cache(&conf, 0, TlsCacheGet, TlsCacheSet);
+    }
   }
 
   if (sslinitialized)
@@ -7047,6 +10191,7 @@ static void TlsInit(void) {
 
   LoadCertificates();
   mbedtls_ssl_conf_sni(&conf, TlsRoute, 0);
+  mbedtls_ssl_conf_export_keys_cb(&conf, TlsExportKeys, 0);
   mbedtls_ssl_conf_dbg(&conf, TlsDebug, 0);
   mbedtls_ssl_conf_dbg(&confcli, TlsDebug, 0);
   mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &rng);
@@ -7057,6 +10202,7 @@ static void TlsInit(void) {
   }
   if (sslfetchverify) {
     mbedtls_ssl_conf_ca_chain(&confcli, GetSslRoots(), 0);
+    mbedtls_ssl_conf_verify_cache(&confcli, VerifyCache, 0);
     mbedtls_ssl_conf_authmode(&confcli, MBEDTLS_SSL_VERIFY_REQUIRED);
   } else {
     mbedtls_ssl_conf_authmode(&confcli, MBEDTLS_SSL_VERIFY_NONE);
@@ -7064,7 +10210,7 @@ static void TlsInit(void) {
   mbedtls_ssl_set_bio(&ssl, &g_bio, TlsSend, 0, TlsRecv);
   conf.disable_compression = confcli.disable_compression = true;
   DCHECK_EQ(0, mbedtls_ssl_conf_alpn_protocols(&conf, (void *)kAlpn));
-  DCHECK_EQ(0, mbedtls_ssl_conf_alpn_protocols(&confcli, (void *)kAlpn));
+  DCHECK_EQ(0, mbedtls_ssl_conf_alpn_protocols(&confcli, (void *)kAlpnClient));
   DCHECK_EQ(0, mbedtls_ssl_setup(&ssl, &conf));
   DCHECK_EQ(0, mbedtls_ssl_setup(&sslcli, &confcli));
 #endif
@@ -7128,6 +10274,7 @@ static void GetOpts(int argc, char *argv[]) {
         CASE('t', ProgramTimeout(ParseInt(optarg)));
         CASE('h', PrintUsage(1, EXIT_SUCCESS));
         CASE('M', ProgramMaxPayloadSize(ParseInt(optarg)));
+        CASE('N', ProgramPrefork(ParseInt(optarg)));
 #if !IsTiny()
       case 'f':
         funtrace = true;
@@ -7239,6 +10386,12 @@ void RedBean(int argc, char *argv[]) {
   oldloglevel = __log_level;
   if (uniprocess) {
     shared->workers = 1;
+    prefork = 0;
+    StartLuaProfiler();
+  }
+  if (prefork) {
+    preforkpids = xcalloc(prefork, sizeof(*preforkpids));
+    preforkshortage = true;
   }
   if (daemonize) {
     if (!logpath)
@@ -7261,6 +10414,7 @@ void RedBean(int argc, char *argv[]) {
   }
   ChangeUser();
   UpdateCurrentDate(timespec_real());
+  StartLogDrainer();
   CollectGarbage();
   hdrbuf.n = 4 * 1024;
   hdrbuf.p = xmalloc(hdrbuf.n);
@@ -7268,6 +10422,7 @@ void RedBean(int argc, char *argv[]) {
   inbuf_actual.p = xmalloc(inbuf_actual.n);
   inbuf = inbuf_actual;
   isinitialized = true;
+  PrecompileLuaAssets();
   CallSimpleHookIfDefined("OnServerStart");
 #ifdef STATIC
   EventLoop(timespec_tomillis(heartbeatinterval));
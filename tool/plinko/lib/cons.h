@@ -2,6 +2,7 @@
 #define COSMOPOLITAN_TOOL_PLINKO_LIB_CONS_H_
 #include "libc/stdckdint.h"
 #include "tool/plinko/lib/error.h"
+#include "tool/plinko/lib/gc.h"
 #include "tool/plinko/lib/plinko.h"
 #include "tool/plinko/lib/types.h"
 COSMOPOLITAN_C_START_
@@ -40,6 +41,9 @@ forceinline void SetShadow(int i, dword t) {
   DCHECK_GE(LO(t), 0);
   /* if (i < 0) DCHECK_GE(HI(t), i, "topology compromised"); */
 #endif
+  if (i >= g_survivors.lo && i < g_survivors.hi) {
+    g_survivors.x = 0;
+  }
   ((__seg_fs dword *)((uintptr_t)g_mem))[i & (BANE | MASK(BANE))] = t;
 }
 
@@ -26,6 +26,7 @@
 #include "libc/log/log.h"
 #include "libc/macros.h"
 #include "libc/mem/mem.h"
+#include "libc/nexgen32e/rdtsc.h"
 #include "libc/str/str.h"
 #include "tool/plinko/lib/cons.h"
 #include "tool/plinko/lib/histo.h"
@@ -42,6 +43,57 @@ forceinline nosideeffect bool HasBit(const dword M[], unsigned i) {
   return (M[i / DWBITS] >> (i % DWBITS)) & 1;
 }
 
+struct Survivors g_survivors;
+
+static void AddExit(struct Survivors *S, int A, int p) {
+  int i;
+  if (p < A || p >= cFrost)
+    return;
+  if (S->n < 0)
+    return;
+  for (i = 0; i < S->n; ++i) {
+    if (S->exits[i] == p) {
+      return;
+    }
+  }
+  if (S->n < ARRAYLEN(S->exits)) {
+    S->exits[S->n++] = p;
+  } else {
+    S->n = -1;
+  }
+}
+
+static void AddExits(struct Survivors *S, int A, int a) {
+  AddExit(S, A, LO(Get(a)));
+  AddExit(S, A, HI(Get(a)));
+  AddExit(S, A, HI(GetShadow(a)));
+}
+
+/**
+ * Forgets survivors once the heap has been freed back past them.
+ */
+void ForgetSurvivors(int c) {
+  if (c > g_survivors.lo) {
+    g_survivors.x = 0;
+  }
+}
+
+static void MarkSurvivors(struct Gc *G) {
+  int i, j, k;
+  G->R = 0;
+  for (i = G->A - g_survivors.hi, j = G->A - g_survivors.lo; i < j;) {
+    if (!(i % DWBITS) && j - i >= DWBITS) {
+      G->M[i / DWBITS] = -1;
+      i += DWBITS;
+    } else {
+      SetBit(G->M, i++);
+    }
+  }
+  for (k = 0; k < g_survivors.n; ++k) {
+    Mark(G, g_survivors.exits[k]);
+  }
+}
+
 struct Gc *NewGc(int A) {
   int B = cx;
   unsigned n;
@@ -58,23 +110,32 @@ struct Gc *NewGc(int A) {
   G->B = B;
   G->P = (unsigned *)(G->M + n);
   *G->P++ = 0;
+  G->R = 0;
+  if (g_survivors.x && g_survivors.hi <= A && g_survivors.lo >= B) {
+    G->R = g_survivors.x;
+  }
   return G;
 }
 
-void Marker(const dword M[], int A, int x) {
-  int i;
+void Marker(struct Gc *G, int x) {
+  int i, A;
   dword t;
+  A = G->A;
   do {
     i = ~(x - A);
-    if (HasBit(M, i))
+    if (HasBit(G->M, i))
+      return;
+    if (x == G->R) {
+      MarkSurvivors(G);
       return;
-    SetBit((void *)M, i);
+    }
+    SetBit(G->M, i);
     if (HI(GetShadow(x)) < A) {
-      Marker(M, A, HI(GetShadow(x)));
+      Marker(G, HI(GetShadow(x)));
     }
     t = Get(x);
     if (LO(t) < A) {
-      Marker(M, A, LO(t));
+      Marker(G, LO(t));
     }
   } while ((x = HI(t)) < A);
 }
@@ -120,6 +181,7 @@ int Relocater(const dword M[], const unsigned P[], int A, int x) {
 void Sweep(struct Gc *G) {
   dword m;
   int a, b, d, i, j;
+  ForgetSurvivors(G->A);
   if (G->noop)
     return;
   i = 0;
@@ -147,14 +209,78 @@ void Sweep(struct Gc *G) {
   cx = d;
 }
 
+static void KeepSurvivors(struct Gc *G, int x, int lo, int hi) {
+  int c, k, n, exits[ARRAYLEN(g_survivors.exits)];
+  struct Survivors *S = &g_survivors;
+  n = 0;
+  if (lo < hi) {
+    n = S->n;
+    memcpy(exits, S->exits, n * sizeof(*exits));
+  }
+  S->x = 0;
+  S->n = 0;
+  for (k = 0; k < n; ++k) {
+    AddExit(S, G->A, exits[k]);
+  }
+  for (c = cx; c < G->A && S->n >= 0; ++c) {
+    if (c == lo) {
+      c = hi - 1;
+    } else {
+      AddExits(S, G->A, c);
+    }
+  }
+  if (S->n >= 0) {
+    S->x = x;
+    S->lo = cx;
+    S->hi = G->A;
+  }
+}
+
+/**
+ * Collects garbage consed since `A` that isn't reachable from `x`.
+ *
+ * Cells are immutable and newer cells are allocated below older ones,
+ * so nothing older than `A` can point into the region being collected.
+ * This means the pause is proportional to the number of cells consed by
+ * the frame that's returning, rather than the size of the whole heap.
+ *
+ * Whatever survives is remembered, so when the caller's frame returns
+ * in turn, the cells its callee handed back are marked in bulk rather
+ * than being traced once per frame they're returned through.
+ *
+ * @return `x` relocated to its compacted address
+ */
 int MarkSweep(int A, int x) {
+  dword t;
   struct Gc *G;
-  if (x >= A)
+  int n, r, lo, hi;
+  if (x >= A) {
+    ForgetSurvivors(A);
     return cx = A, x;
+  }
+  t = stats || gtrace ? rdtsc() : 0;
   G = NewGc(A);
+  r = G->R;
   Mark(G, x);
-  Census(G);
+  n = Census(G);
+  if (r && !G->R) {
+    lo = Relocate(G, g_survivors.lo);
+    hi = Relocate(G, g_survivors.hi - 1) + 1;
+  } else {
+    lo = hi = 0;
+  }
   x = Relocate(G, x);
   Sweep(G);
+  KeepSurvivors(G, x, lo, hi);
+  ++cGcs;
+  cGcKept += n;
+  cGcFreed += (A - G->B) - n;
+  if (t) {
+    t = rdtsc() - t;
+    cGcTicks += t;
+    cGcMaxTicks = MAX(cGcMaxTicks, t);
+    if (gtrace)
+      Fprintf(2, ";; gc kept %d freed %d clocks %ld%n", n, (A - G->B) - n, t);
+  }
   return x;
 }
@@ -4,18 +4,35 @@
 COSMOPOLITAN_C_START_
 
 struct Gc {
-  int A, B, C;
+  int A, B, C, R;
   unsigned n;
   unsigned noop;
   unsigned *P;
   dword M[];
 };
 
+/**
+ * Survivors of the last MarkSweep(), which are `[lo,hi)` after it's
+ * compacted them. Every one of these cells is reachable from `x`, and
+ * `exits` lists the older cells they point to, so the next collection
+ * whose region holds them can mark them all without tracing them again.
+ * That makes marking incremental, as a frame returns what its callee
+ * built. SetShadow() is the only way to change an existing cell, so it
+ * acts as the write barrier that drops this record.
+ */
+struct Survivors {
+  int x, lo, hi, n;
+  int exits[32];
+};
+
+extern struct Survivors g_survivors;
+
 int MarkSweep(int, int);
 struct Gc *NewGc(int);
 int Census(struct Gc *);
 void Sweep(struct Gc *);
-void Marker(const dword[], int, int);
+void Marker(struct Gc *, int);
+void ForgetSurvivors(int);
 int Relocater(const dword[], const unsigned[], int, int);
 
 forceinline int Relocate(const struct Gc *G, int x) {
@@ -27,7 +44,7 @@ forceinline int Relocate(const struct Gc *G, int x) {
 forceinline void Mark(struct Gc *G, int x) {
   if (x >= G->A)
     return;
-  Marker(G->M, G->A, x);
+  Marker(G, x);
 }
 
 COSMOPOLITAN_C_END_
@@ -75,6 +75,7 @@ static void Unwind(int S) {
       cx = ~HI(t);
     }
   }
+  ForgetSurvivors(cx);
 }
 
 static void Backtrace(int S) {
@@ -890,14 +891,24 @@ static void ResetStats(void) {
   cHeap = cx;
   cGets = 0;
   cSets = 0;
+  cGcs = 0;
+  cGcKept = 0;
+  cGcFreed = 0;
+  cGcTicks = 0;
+  cGcMaxTicks = 0;
 }
 
 static void PrintStats(long usec) {
   Fprintf(2,
           ";; heap    %'16ld  nsec    %'16ld%n"
           ";; gets    %'16ld  sets    %'16ld%n"
-          ";; atom    %'16ld  frez    %'16ld%n",
-          -cHeap - -cFrost, usec, cGets, cSets, cAtoms, -cFrost);
+          ";; atom    %'16ld  frez    %'16ld%n"
+          ";; gcs     %'16ld  gcnsec  %'16ld%n"
+          ";; kept    %'16ld  freed   %'16ld%n"
+          ";; pause   %'16ld%n",
+          -cHeap - -cFrost, usec, cGets, cSets, cAtoms, -cFrost, cGcs,
+          ClocksToNanos(cGcTicks, 0), cGcKept, cGcFreed,
+          ClocksToNanos(cGcMaxTicks, 0));
 }
 
 static wontreturn int Exit(void) {
@@ -209,6 +209,11 @@ extern unsigned short g_depths[128][3];
 
 extern dword tick;
 extern dword cSets;
+extern dword cGcs;
+extern dword cGcKept;
+extern dword cGcFreed;
+extern dword cGcTicks;
+extern dword cGcMaxTicks;
 extern dword *g_dis;
 extern EvalFn *eval;
 extern BindFn *bind_;
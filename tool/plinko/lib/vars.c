@@ -134,6 +134,11 @@ unsigned short g_depths[128][3];
 
 dword tick;
 dword cSets;
+dword cGcs;         // number of garbage collections that happened
+dword cGcKept;      // cells that survived garbage collection
+dword cGcFreed;     // cells that garbage collection discarded
+dword cGcTicks;     // rdtsc ticks spent collecting, if -s or -g
+dword cGcMaxTicks;  // longest single collection pause, if -s or -g
 dword *g_dis;
 EvalFn *eval;
 BindFn *bind_;
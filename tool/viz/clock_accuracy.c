@@ -15,14 +15,20 @@
 
 /**
  * @fileoverview clock() function demo
+ *
+ * This also shows how far the monotonic clock drifts from the realtime
+ * clock, which measures how well it's been calibrated on systems where
+ * cosmo derives it from rdtsc, e.g. MacOS on AMD64. Unless ntp happens
+ * to be slewing the realtime clock, this should stay within a few ppm.
  */
 
 int main(int argc, char *argv[]) {
   ShowCrashReports();
   unsigned long i;
   volatile unsigned long x;
-  struct timespec now, start, next, interval;
+  struct timespec now, start, next, interval, real, realstart;
   printf("hammering the cpu...\n");
+  realstart = timespec_real();
   next = start = timespec_mono();
   interval = timespec_frommillis(500);
   next = timespec_add(next, interval);
@@ -36,9 +42,14 @@ int main(int argc, char *argv[]) {
         }
       }
     }
+    real = timespec_real();
     next = timespec_add(next, interval);
-    printf("consumed %10g seconds monotonic time and %10g seconds cpu time\n",
+    printf("consumed %10g seconds monotonic time and %10g seconds cpu time"
+           " (drift %+6g ppm)\n",
            timespec_tonanos(timespec_sub(now, start)) / 1000000000.,
-           (double)clock() / CLOCKS_PER_SEC);
+           (double)clock() / CLOCKS_PER_SEC,
+           (timespec_tonanos(timespec_sub(now, start)) -
+            timespec_tonanos(timespec_sub(real, realstart))) /
+               (timespec_tonanos(timespec_sub(real, realstart)) / 1e6));
   }
 }
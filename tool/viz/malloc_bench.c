@@ -0,0 +1,322 @@
+/*-*- mode:c;indent-tabs-mode:nil;c-basic-offset:2;tab-width:8;coding:utf-8 -*-│
+│ vi: set et ft=c ts=2 sts=2 sw=2 fenc=utf-8                               :vi │
+╞══════════════════════════════════════════════════════════════════════════════╡
+│ Copyright 2025 Justine Alexandra Roberts Tunney                              │
+│                                                                              │
+│ Permission to use, copy, modify, and/or distribute this software for         │
+│ any purpose with or without fee is hereby granted, provided that the         │
+│ above copyright notice and this permission notice appear in all copies.      │
+│                                                                              │
+│ THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL                │
+│ WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED                │
+│ WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE             │
+│ AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL         │
+│ DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR        │
+│ PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER               │
+│ TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR             │
+│ PERFORMANCE OF THIS SOFTWARE.                                                │
+╚─────────────────────────────────────────────────────────────────────────────*/
+#include "libc/calls/struct/rusage.h"
+#include "libc/calls/struct/timespec.h"
+#include "libc/cosmo.h"
+#include "libc/cosmotime.h"
+#include "libc/fmt/conv.h"
+#include "libc/macros.h"
+#include "libc/mem/mem.h"
+#include "libc/runtime/runtime.h"
+#include "libc/stdio/stdio.h"
+#include "libc/str/str.h"
+#include "libc/sysv/consts/rusage.h"
+#include "libc/thread/thread.h"
+#include "third_party/getopt/getopt.internal.h"
+
+/**
+ * @fileoverview malloc benchmark suite
+ *
+ * This runs allocation patterns that stress different parts of malloc:
+ *
+ * - size: malloc/free pairs for each power of two size class
+ * - realloc: growing a buffer a little at a time, like appendd()
+ * - xthread: producers allocate and consumers free on other threads
+ * - larson: threads replace random slots, then hand them to new threads
+ * - frag: heap footprint and peak rss as random churn goes on (-f)
+ *
+ * Each pattern runs with the per-thread cache enabled and disabled via
+ * mallopt(M_TCACHE). The malloc_bench_tiny program runs the single
+ * threaded patterns against tinymalloc.inc instead. Results print as
+ * json when BENCHMARK_JSON is set, for tool/scripts/benchcmp.
+ */
+
+#ifndef MALLOC_BENCH_OPS
+#define MALLOC_BENCH_OPS (1 << 20)
+#endif
+#ifndef MALLOC_BENCH_SLOTS
+#define MALLOC_BENCH_SLOTS 20000
+#endif
+#ifndef MALLOC_BENCH_NAME
+#define MALLOC_BENCH_NAME "dlmalloc"
+#endif
+
+#define LIVE  1000
+#define BATCH 256
+
+struct Batch {
+  struct Batch *next;
+  void *p[BATCH];
+};
+
+static int nthreads;
+static const char *variant;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static struct Batch *queue;
+static int producing;
+
+static uint64_t Rand(uint64_t *s) {
+  *s ^= *s << 13;
+  *s ^= *s >> 7;
+  *s ^= *s << 17;
+  return *s;
+}
+
+static long Now(void) {
+  return timespec_tonanos(timespec_mono());
+}
+
+static void Report(const char *name, long ops, long ns) {
+  if (getenv("BENCHMARK_JSON")) {
+    printf("{\"name\":\"%s %s %s\",\"iterations\":%ld,\"ns_per_op\":%.17g}\n",
+           MALLOC_BENCH_NAME, variant, name, ops, (double)ns / ops);
+  } else {
+    printf("%-10s %-8s %-24s %10.2f ns/op %12ld ops\n", MALLOC_BENCH_NAME,
+           variant, name, (double)ns / ops, ops);
+  }
+}
+
+static void SizeSweep(void) {
+  long t;
+  char name[32];
+  void *p[LIVE];
+  size_t i, j, n, z;
+  for (z = 8; z <= 1024 * 1024; z *= 2) {
+    n = MAX(LIVE, MALLOC_BENCH_OPS / (z > 65536 ? 64 : 1)) / LIVE;
+    t = Now();
+    for (j = 0; j < n; ++j) {
+      for (i = 0; i < LIVE; ++i)
+        p[i] = malloc(z);
+      for (i = 0; i < LIVE; ++i)
+        free(p[i]);
+    }
+    t = Now() - t;
+    snprintf(name, sizeof(name), "size %zu", z);
+    Report(name, n * LIVE, t);
+  }
+}
+
+static void ReallocGrowth(void) {
+  long t;
+  char *p;
+  size_t i, n;
+  n = MALLOC_BENCH_OPS;
+  t = Now();
+  for (p = 0, i = 1; i <= n; ++i) {
+    p = realloc(p, i);
+    p[i - 1] = i;
+  }
+  free(p);
+  Report("realloc +1", n, Now() - t);
+  t = Now();
+  for (p = 0, i = 16, n = 0; i <= 64 * 1024 * 1024; i += i / 8, ++n) {
+    p = realloc(p, i);
+    p[i - 1] = i;
+  }
+  free(p);
+  Report("realloc +12%", n, Now() - t);
+}
+
+#ifndef MALLOC_BENCH_TINY
+
+static void *Producer(void *arg) {
+  long i, j, n;
+  struct Batch *b;
+  uint64_t s = (intptr_t)arg * 0x9e3779b97f4a7c15 | 1;
+  n = MALLOC_BENCH_OPS / BATCH / nthreads;
+  for (i = 0; i < n; ++i) {
+    b = malloc(sizeof(*b));
+    for (j = 0; j < BATCH; ++j)
+      b->p[j] = malloc(16 + Rand(&s) % 240);
+    pthread_mutex_lock(&lock);
+    b->next = queue;
+    queue = b;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&lock);
+  }
+  pthread_mutex_lock(&lock);
+  --producing;
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&lock);
+  return 0;
+}
+
+static void *Consumer(void *arg) {
+  long j;
+  struct Batch *b;
+  for (;;) {
+    pthread_mutex_lock(&lock);
+    while (!queue && producing)
+      pthread_cond_wait(&cond, &lock);
+    if ((b = queue))
+      queue = b->next;
+    pthread_mutex_unlock(&lock);
+    if (!b)
+      break;
+    for (j = 0; j < BATCH; ++j)
+      free(b->p[j]);
+    free(b);
+  }
+  return 0;
+}
+
+static void CrossThread(void) {
+  long t, i;
+  char name[32];
+  pthread_t *th = malloc(2 * nthreads * sizeof(pthread_t));
+  producing = nthreads;
+  t = Now();
+  for (i = 0; i < nthreads; ++i) {
+    pthread_create(th + i, 0, Producer, (void *)(i + 1));
+    pthread_create(th + nthreads + i, 0, Consumer, 0);
+  }
+  for (i = 0; i < 2 * nthreads; ++i)
+    pthread_join(th[i], 0);
+  t = Now() - t;
+  free(th);
+  snprintf(name, sizeof(name), "xthread %dx%d", nthreads, nthreads);
+  Report(name, MALLOC_BENCH_OPS / BATCH / nthreads * BATCH * nthreads, t);
+}
+
+struct Larson {
+  void **slot;
+  uint64_t seed;
+};
+
+static void *LarsonWorker(void *arg) {
+  long i, j, n;
+  struct Larson *l = arg;
+  n = MALLOC_BENCH_OPS / nthreads / 2;
+  for (i = 0; i < n; ++i) {
+    j = Rand(&l->seed) % LIVE;
+    free(l->slot[j]);
+    l->slot[j] = malloc(16 + Rand(&l->seed) % 1008);
+  }
+  return 0;
+}
+
+static void Larson(void) {
+  long t, i, j, g;
+  char name[32];
+  pthread_t *th = malloc(nthreads * sizeof(pthread_t));
+  struct Larson *l = malloc(nthreads * sizeof(struct Larson));
+  for (i = 0; i < nthreads; ++i) {
+    l[i].seed = (i + 1) * 0x9e3779b97f4a7c15 | 1;
+    l[i].slot = malloc(LIVE * sizeof(void *));
+    for (j = 0; j < LIVE; ++j)
+      l[i].slot[j] = malloc(16 + Rand(&l[i].seed) % 1008);
+  }
+  t = Now();
+  // the second generation of threads frees what the first allocated
+  for (g = 0; g < 2; ++g) {
+    for (i = 0; i < nthreads; ++i)
+      pthread_create(th + i, 0, LarsonWorker, l + i);
+    for (i = 0; i < nthreads; ++i)
+      pthread_join(th[i], 0);
+  }
+  t = Now() - t;
+  for (i = 0; i < nthreads; ++i) {
+    for (j = 0; j < LIVE; ++j)
+      free(l[i].slot[j]);
+    free(l[i].slot);
+  }
+  free(l);
+  free(th);
+  snprintf(name, sizeof(name), "larson %d", nthreads);
+  Report(name, MALLOC_BENCH_OPS / nthreads / 2 * nthreads * 2, t);
+}
+
+#endif /* MALLOC_BENCH_TINY */
+
+static void Fragmentation(void) {
+  int r;
+  size_t i, z;
+  long live = 0;
+  struct rusage ru;
+  struct mallinfo mi;
+  uint64_t s = 0x9e3779b97f4a7c15;
+  size_t *size = calloc(MALLOC_BENCH_SLOTS, sizeof(size_t));
+  char **slot = calloc(MALLOC_BENCH_SLOTS, sizeof(char *));
+  printf("%-10s %-8s %5s %12s %12s %12s\n", MALLOC_BENCH_NAME, variant,
+         "round", "live", "footprint", "maxrss");
+  for (r = 0; r < 20; ++r) {
+    // free half the slots, then refill them with sizes that drift
+    // larger each round, which is the pattern that fragments heaps
+    for (i = 0; i < MALLOC_BENCH_SLOTS; ++i) {
+      if (Rand(&s) & 1) {
+        live -= size[i];
+        free(slot[i]);
+        z = 16 + Rand(&s) % (64 << (r / 4));
+        slot[i] = malloc(z);
+        memset(slot[i], r, z);
+        live += (size[i] = z);
+      }
+    }
+    mi = mallinfo();
+    getrusage(RUSAGE_SELF, &ru);
+    printf("%-10s %-8s %5d %12ld %12zu %12ld\n", MALLOC_BENCH_NAME, variant,
+           r, live, mi.arena + mi.hblkhd, ru.ru_maxrss * 1024);
+  }
+  for (i = 0; i < MALLOC_BENCH_SLOTS; ++i)
+    free(slot[i]);
+  free(slot);
+  free(size);
+}
+
+static void RunSuite(bool frag) {
+  SizeSweep();
+  ReallocGrowth();
+#ifndef MALLOC_BENCH_TINY
+  CrossThread();
+  Larson();
+#endif
+  if (frag)
+    Fragmentation();
+}
+
+int main(int argc, char *argv[]) {
+  int opt;
+  bool frag = false;
+  nthreads = MIN(8, cosmo_cpu_count());
+  while ((opt = getopt(argc, argv, "ft:")) != -1) {
+    switch (opt) {
+      case 'f':
+        frag = true;
+        break;
+      case 't':
+        nthreads = MAX(1, atoi(optarg));
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-f] [-t THREADS]\n", argv[0]);
+        return 1;
+    }
+  }
+#ifdef MALLOC_BENCH_TINY
+  variant = "-";
+  RunSuite(frag);
+#else
+  variant = "tcache";
+  RunSuite(frag);
+  mallopt(M_TCACHE, 0);
+  variant = "notcache";
+  RunSuite(frag);
+  mallopt(M_TCACHE, 1);
+#endif
+}
@@ -326,7 +326,7 @@ static void PrintImageSerious(long yn, long xn, unsigned char RGB[3][yn][xn],
                               long tyn, long txn, struct TtyRgb TTY[tyn][txn],
                               char *vt) {
   char *p;
-  long y, x;
+  long y, i;
   struct TtyRgb bg = {0x12, 0x34, 0x56, 0};
   struct TtyRgb fg = {0x12, 0x34, 0x56, 0};
   if (g_flags.unsharp)
@@ -335,11 +335,10 @@ static void PrintImageSerious(long yn, long xn, unsigned char RGB[3][yn][xn],
     dither(yn, xn, RGB, yn, xn);
   if (yn && xn) {
     for (y = 0; y < tyn; ++y) {
-      for (x = 0; x < txn; ++x) {
-        TTY[y][x] = rgb2tty(RGB[0][MIN(y, yn - 1)][MIN(x, xn - 1)],
-                            RGB[1][MIN(y, yn - 1)][MIN(x, xn - 1)],
-                            RGB[2][MIN(y, yn - 1)][MIN(x, xn - 1)]);
-      }
+      i = MIN(y, yn - 1);
+      rgb2ttyn(TTY[y], RGB[0][i], RGB[1][i], RGB[2][i], MIN(xn, txn));
+      if (txn > xn)
+        TTY[y][xn] = TTY[y][xn - 1];
     }
   }
   p = ttyraster(vt, (void *)TTY, tyn, txn, bg, fg);
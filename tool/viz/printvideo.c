@@ -25,6 +25,7 @@
 #include "dsp/tty/quant.h"
 #include "dsp/tty/tty.h"
 #include "libc/assert.h"
+#include "libc/atomic.h"
 #include "libc/calls/calls.h"
 #include "libc/calls/internal.h"
 #include "libc/calls/struct/framebufferfixedscreeninfo.h"
@@ -93,6 +94,7 @@
 #include "libc/sysv/consts/termios.h"
 #include "libc/sysv/consts/w.h"
 #include "libc/sysv/errfuns.h"
+#include "libc/thread/semaphore.h"
 #include "libc/thread/thread.h"
 #include "libc/time.h"
 #include "libc/x/xsigaction.h"
@@ -109,6 +111,7 @@
 #define GAMMADELTA    0.1
 #define NETBUFSIZ     (2 * 1024 * 1024)
 #define MAX_FRAMERATE (1 / 60.)
+#define QUEUE_DEPTH   2
 
 #define USAGE \
   " [FLAGS] MPG\n\
@@ -223,6 +226,41 @@ struct FrameBuffer {
   struct FrameBufferVirtualScreenInfo vscreen;
 };
 
+/*
+ * Video frames flow through three threads:
+ *
+ *   1. main thread decodes mpeg and copies pictures into `decoded_`
+ *   2. scaler thread resamples, applies effects, and quantizes colors
+ *      into `scaled_`
+ *   3. writer thread rasterizes the terminal codes and writes them
+ *
+ * Each queue is a single producer single consumer ring. Consumers work
+ * on the frame at the head of the ring in place, and producers drop a
+ * frame rather than waiting when the ring is full, so a slow terminal
+ * costs us frames instead of audio sync. Since producers never block,
+ * the main thread can still longjmp() out of its signal handlers.
+ */
+struct FrameQueue {
+  atomic_uint head, tail;
+  atomic_size_t dropped;
+  sem_t ready;
+};
+
+struct DecodedFrame {
+  plm_frame_t pf;
+  uint8_t *buf;
+  size_t size;
+  double par;
+  struct timespec start;
+};
+
+struct ScaledFrame {
+  struct Graphic g;
+  struct TtyRgb *xtcodes;
+  struct timespec start;
+  uint64_t scale, fx, quant;
+};
+
 static const struct NamedVector kPrimaries[] = {
     {"BT.601", &kBt601Primaries},
     {"BT.709", &kBt709Primaries},
@@ -255,7 +293,7 @@ static const char *patharg_;
 static struct winsize wsize_;
 static float hue_, sat_, lit_;
 static volatile bool resized_;
-static void *xtcodes_, *audio_;
+static void *audio_;
 static struct FrameBuffer fb0_;
 static unsigned chans_, srate_;
 static volatile bool ignoresigs_;
@@ -263,15 +301,24 @@ static size_t dh_, dw_, framecount_;
 static struct FrameCountRing fcring_;
 static int lumakernel_, chromakernel_;
 static int primaries_, lighting_, swing_;
-static uint64_t t1, t2, t3, t4, t5, t6, t8;
+static uint64_t t1, t2, rastertime_, writetime_;
 static int homerow_, lastrow_, infd_, outfd_;
-static struct VtFrame vtframe_[2], *f1_, *f2_;
+static struct VtFrame vtframe_;
+static struct TtyDelta delta_;
 static struct Graphic graphic_[2], *g1_, *g2_;
 static struct timespec deadline_, dura_, starttime_;
 static bool yes_, stats_, dither_, ttymode_, istango_;
-static struct timespec decode_start_, f1_start_, f2_start_;
+static struct timespec decode_start_;
 static bool fullclear_, historyclear_, tuned_, yonly_, gotvideo_;
-static char status_[7][200], logpath_[PATH_MAX], chansstr_[32], sratestr_[32];
+static char status_[9][200], logpath_[PATH_MAX], chansstr_[32], sratestr_[32];
+static struct FrameQueue decoded_, scaled_;
+static struct DecodedFrame decodedframes_[QUEUE_DEPTH];
+static struct ScaledFrame scaledframes_[QUEUE_DEPTH];
+static pthread_rwlock_t pipelock_ = PTHREAD_RWLOCK_INITIALIZER;
+static pthread_t scaler_, writer_;
+static atomic_long leadtime_ = -1;
+static atomic_bool broken_;
+static bool piping_, paused_;
 
 static void OnCtrlC(void) {
   longjmp(jb_, 1);
@@ -397,16 +444,13 @@ static void DimensionDisplay(void) {
     xn = width;
     yn = ROUNDDOWN(yn, 2);
     xn = ROUNDDOWN(xn, 2);
-    g2_ = resizegraphic(&graphic_[1], yn, xn);
+    g2_ = &graphic_[1];
+    g2_->yn = yn;
+    g2_->xn = xn;
     INFOF("%s 𝑑(%hu×%hu)×(%d,%d): 𝑔₁(%zu×%zu,r=%f) → 𝑔₂(%zu×%zu)",
           "DimensionDisplay", wsize_.ws_row, wsize_.ws_col, g1_->yn, g1_->xn,
           ratio, yn, xn);
-    BALLOC(&xtcodes_, 64, ((g2_->yn) * g2_->xn + 8) * sizeof(struct TtyRgb),
-           "xtcodes_");
-    ResizeVtFrame(&vtframe_[0], (g2_->yn), g2_->xn);
-    ResizeVtFrame(&vtframe_[1], (g2_->yn), g2_->xn);
-    f1_ = &vtframe_[0];
-    f2_ = &vtframe_[1];
+    ResizeVtFrame(&vtframe_, (g2_->yn), g2_->xn);
     if (ttymode_)
       homerow_ = MIN(wsize_.ws_row - HALF(g2_->yn),
                      HALF(wsize_.ws_row - HALF(g2_->yn)));
@@ -474,9 +518,11 @@ static char *StartRender(char *vt) {
   if (fullclear_) {
     vt += sprintf(vt, "\e[0m\e[H\e[J");
     fullclear_ = false;
+    delta_.dirty = true;
   } else if (historyclear_) {
     vt += sprintf(vt, "\e[0m\e[H\e[J\e[3J");
     historyclear_ = false;
+    delta_.dirty = true;
   }
   vt += sprintf(vt, "\e[%hhuH", homerow_ + 1);
   return vt;
@@ -484,8 +530,8 @@ static char *StartRender(char *vt) {
 
 static void EndRender(char *vt) {
   vt += sprintf(vt, "\e[0m");
-  f2_->n = (intptr_t)vt - (intptr_t)f2_->b;
-  f2_->i = 0;
+  vtframe_.n = (intptr_t)vt - (intptr_t)vtframe_.b;
+  vtframe_.i = 0;
 }
 
 static bool IsNonZeroFloat(float f) {
@@ -571,15 +617,28 @@ static const char *DescribeSwing(int swing) {
   }
 }
 
-static void RenderIt(void) {
+/**
+ * Makes the next frame repaint the cells under the stats overlay.
+ */
+static void TaintOverlay(void) {
+  int i, y;
+  for (i = 1; i <= ARRAYLEN(status_); ++i) {
+    y = lastrow_ - i - 1 - delta_.y;
+    if (0 <= y && y < delta_.yn)
+      memset(delta_.old + y * delta_.xn, -1, delta_.xn * sizeof(*delta_.old));
+  }
+}
+
+static void RenderIt(struct ScaledFrame *s) {
   long bpf;
   double bpc;
   char *vt, *p;
   unsigned yn, xn;
+  struct TtyCursor cur;
   struct TtyRgb bg, fg;
-  yn = g2_->yn;
-  xn = g2_->xn;
-  vt = f2_->b;
+  yn = s->g.yn;
+  xn = s->g.xn;
+  vt = vtframe_.b;
   p = StartRender(vt);
   if (TTYQUANT()->alg == kTtyQuantTrue) {
     bg = (struct TtyRgb){0, 0, 0, 0};
@@ -595,29 +654,49 @@ static void RenderIt(void) {
     fg = (struct TtyRgb){0xff, 0xff, 0xff, 231};
     p = stpcpy(p, "\e[48;5;16;38;5;231m");
   }
-  p = ttyraster(p, xtcodes_, yn, xn, bg, fg);
+  if (ttymode_) {
+    cur = (struct TtyCursor){homerow_, 0};
+    delta_.y = homerow_;
+    delta_.x = 0;
+    p = ttydelta(&delta_, p, &cur, s->xtcodes, yn, xn, bg, fg);
+  } else {
+    p = ttyraster(p, s->xtcodes, yn, xn, bg, fg);
+  }
   if (ttymode_ && stats_) {
+    TaintOverlay();
     bpc = bpf = p - vt;
     bpc /= wsize_.ws_row * wsize_.ws_col;
     sprintf(status_[4], " %s/%s/%s %d×%d → %u×%u pixels ",
             kPrimaries[primaries_].name, DescribeSwing(swing_),
             kLightings[lighting_].name, plm_get_width(plm_),
-            plm_get_height(plm_), g2_->xn, g2_->yn);
+            plm_get_height(plm_), xn, yn);
     sprintf(status_[5], " decode:%,8luµs | magikarp:%,8luµs ",
             plmpegdecode_latency_, magikarp_latency_);
     sprintf(status_[1], " ycbcr2rgb:%,8luµs | gyarados:%,8luµs ",
             ycbcr2rgb_latency_, gyarados_latency_);
     sprintf(status_[0], " fx:%,ldµs %.6fbpc %,ldbpf %.6ffps ",
-            lroundl(t6 / 1e3L), bpc, bpf, (size_t)(p - vt), MeasureFrameRate());
+            lroundl(s->fx / 1e3L), bpc, bpf, (size_t)(p - vt),
+            MeasureFrameRate());
+    sprintf(status_[7], " quantize:%,8ldµs | raster:%,8ldµs | write:%,8ldµs ",
+            lroundl(s->quant / 1e3L), lroundl(rastertime_ / 1e3L),
+            lroundl(writetime_ / 1e3L));
+    sprintf(status_[8], " lag:%,8ldµs | queued:%u | dropped:%,zu+%,zu ",
+            timespec_tomicros(timespec_sub(timespec_mono(), s->start)),
+            (decoded_.tail - decoded_.head) + (scaled_.tail - scaled_.head),
+            decoded_.dropped, scaled_.dropped);
     sprintf(status_[2], " gamma:%.1f %hu columns × %hu lines of text ", gamma_,
             wsize_.ws_col, wsize_.ws_row);
     DescribeAlgorithms(status_[3]);
     p += sprintf(p, "\e[0m");
     if (HasAdjustments()) {
       DescribeAdjustments(status_[6]);
-      p += sprintf(p, "\e[%d;%dH%s", lastrow_ - 7,
+      p += sprintf(p, "\e[%d;%dH%s", lastrow_ - 9,
                    HALF(xn) - strwidth(status_[6], 0), status_[6]);
     }
+    p += sprintf(p, "\e[%d;%dH%s", lastrow_ - 8,
+                 HALF(xn) - strwidth(status_[8], 0), status_[8]);
+    p += sprintf(p, "\e[%d;%dH%s", lastrow_ - 7,
+                 HALF(xn) - strwidth(status_[7], 0), status_[7]);
     p += sprintf(p, "\e[%d;%dH%s", lastrow_ - 6,
                  HALF(xn) - strwidth(status_[4], 0), status_[4]);
     p += sprintf(p, "\e[%d;%dH%s", lastrow_ - 5,
@@ -638,7 +717,7 @@ static void RenderIt(void) {
   EndRender(p);
 }
 
-static void RasterIt(void) {
+static void RasterIt(struct Graphic *g) {
   static bool once;
   static void *buf;
   if (!once) {
@@ -646,96 +725,251 @@ static void RasterIt(void) {
     once = true;
   }
   WriteToFrameBuffer(fb0_.vscreen.yres_virtual, fb0_.vscreen.xres_virtual, buf,
-                     g2_->yn, g2_->xn, g2_->b, fb0_.vscreen.yres,
-                     fb0_.vscreen.xres);
+                     g->yn, g->xn, g->b, fb0_.vscreen.yres, fb0_.vscreen.xres);
   memcpy(fb0_.map, buf, fb0_.size);
 }
 
-static void TranscodeVideo(plm_frame_t *pf) {
-  CHECK_EQ(pf->cb.width, pf->cr.width);
-  CHECK_EQ(pf->cb.height, pf->cr.height);
-  DEBUGF("TranscodeVideo() [grace=%,ldns]", timespec_tonanos(GetGraceTime()));
-  g2_ = &graphic_[1];
-  t5 = 0;
-
-  TIMEIT(t1, {
-    pary_ = 2;
-    if (pf1_)
-      pary_ = 1.;
-    if (pf2_)
-      pary_ = (266 / 64.) * (900 / 1600.);
-    pary_ *= plm_get_pixel_aspect_ratio(plm_);
-    YCbCr2RgbScale(g2_->yn, g2_->xn, g2_->b, pf->y.height, pf->y.width,
+/**
+ * Claims the slot at the tail of queue, or counts a dropped frame.
+ */
+static bool ReserveFrame(struct FrameQueue *q, unsigned *i) {
+  *i = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  if (*i - atomic_load_explicit(&q->head, memory_order_acquire) <
+      QUEUE_DEPTH) {
+    *i %= QUEUE_DEPTH;
+    return true;
+  } else {
+    atomic_fetch_add_explicit(&q->dropped, 1, memory_order_relaxed);
+    return false;
+  }
+}
+
+static void PushFrame(struct FrameQueue *q) {
+  atomic_fetch_add_explicit(&q->tail, 1, memory_order_release);
+  sem_post(&q->ready);
+}
+
+/**
+ * Waits for the slot at the head of queue.
+ * @return false if queue was stopped and has been drained
+ */
+static bool WaitFrame(struct FrameQueue *q, unsigned *i) {
+  while (sem_wait(&q->ready) == -1)
+    CHECK_EQ(EINTR, errno);
+  *i = atomic_load_explicit(&q->head, memory_order_relaxed);
+  if (*i != atomic_load_explicit(&q->tail, memory_order_acquire)) {
+    *i %= QUEUE_DEPTH;
+    return true;
+  } else {
+    return false;
+  }
+}
+
+static void PopFrame(struct FrameQueue *q) {
+  atomic_fetch_add_explicit(&q->head, 1, memory_order_release);
+}
+
+static void StopQueue(struct FrameQueue *q) {
+  sem_post(&q->ready);
+}
+
+static void TranscodeVideo(struct DecodedFrame *d, struct ScaledFrame *s) {
+  plm_frame_t *pf = &d->pf;
+  struct Graphic *g = &s->g;
+  if (g->yn != g2_->yn || g->xn != g2_->xn) {
+    free(g->b);
+    free(s->xtcodes);
+    resizegraphic(g, g2_->yn, g2_->xn);
+    BALLOC(&s->xtcodes, 64, (g->yn * g->xn + 8) * sizeof(struct TtyRgb),
+           "xtcodes");
+  }
+  s->start = d->start;
+
+  TIMEIT(s->scale, {
+    YCbCr2RgbScale(g->yn, g->xn, g->b, pf->y.height, pf->y.width,
                    (void *)pf->y.data, pf->cr.height, pf->cr.width,
                    (void *)pf->cb.data, (void *)pf->cr.data, pf->y.height,
                    pf->y.width, pf->cr.height, pf->cr.width, pf->height,
-                   pf->width, pary_, parx_, &ycbcr_);
+                   pf->width, d->par, parx_, &ycbcr_);
   });
-  t2 = 0;
-  t8 = 0;
 
-  TIMEIT(t6, {
+  TIMEIT(s->fx, {
     switch (blur_) {
       case kBlurBox:
-        boxblur(g2_);
+        boxblur(g);
         break;
       case kBlurGaussian:
-        gaussian(g2_->yn, g2_->xn, g2_->b);
+        gaussian(g->yn, g->xn, g->b);
         break;
       default:
         break;
     }
     if (sobel_)
-      sobel(g2_);
+      sobel(g);
     if (emboss_)
-      emboss(g2_);
+      emboss(g);
     switch (sharp_) {
       case kSharpSharp:
-        sharpen(3, g2_->yn, g2_->xn, g2_->b, g2_->yn, g2_->xn);
+        sharpen(3, g->yn, g->xn, g->b, g->yn, g->xn);
         break;
       case kSharpUnsharp:
-        unsharp(3, g2_->yn, g2_->xn, g2_->b, g2_->yn, g2_->xn);
+        unsharp(3, g->yn, g->xn, g->b, g->yn, g->xn);
         break;
       default:
         break;
     }
     if (dither_ && TTYQUANT()->alg != kTtyQuantTrue)
-      dither(g2_->yn, g2_->xn, g2_->b, g2_->yn, g2_->xn);
+      dither(g->yn, g->xn, g->b, g->yn, g->xn);
   });
 
   if (ShouldUseFrameBuffer()) {
-    t3 = 0;
-    TIMEIT(t4, RasterIt());
+    s->quant = 0;
   } else {
-    TIMEIT(t3, getxtermcodes(xtcodes_, g2_));
-    TIMEIT(t4, RenderIt());
+    TIMEIT(s->quant, getxtermcodes(s->xtcodes, g));
+  }
+}
+
+static void *ScaleVideo(void *arg) {
+  unsigned i, j;
+  while (WaitFrame(&decoded_, &i)) {
+    if (ReserveFrame(&scaled_, &j)) {
+      pthread_rwlock_rdlock(&pipelock_);
+      TranscodeVideo(decodedframes_ + i, scaledframes_ + j);
+      pthread_rwlock_unlock(&pipelock_);
+      PushFrame(&scaled_);
+    } else {
+      DEBUGF("scaled frame dropped");
+    }
+    PopFrame(&decoded_);
+  }
+  return 0;
+}
+
+static void *WriteVideo(void *arg) {
+  unsigned i;
+  struct ScaledFrame *s;
+  while (WaitFrame(&scaled_, &i)) {
+    s = scaledframes_ + i;
+    pthread_rwlock_rdlock(&pipelock_);
+    if (!broken_ && s->g.yn == g2_->yn && s->g.xn == g2_->xn) {
+      if (ShouldUseFrameBuffer()) {
+        TIMEIT(rastertime_, RasterIt(&s->g));
+        writetime_ = 0;
+      } else {
+        TIMEIT(rastertime_, RenderIt(s));
+        TIMEIT(writetime_, {
+          if (ttywrite(outfd_, vtframe_.b, vtframe_.n) == -1) {
+            WARNF("write(tty) → %s", strerror(errno));
+            broken_ = true;
+          }
+        });
+      }
+      RecordFactThatFrameWasFullyRendered();
+      leadtime_ = timespec_tomicros(timespec_sub(timespec_mono(), s->start));
+      INFOF("𝑓%zu(%u×%u) %,zub (%f BPP) "
+            "scale=%,zuns "
+            "fx=%,zuns "
+            "quantize=%,zuns "
+            "render=%,zuns "
+            "write=%,zuns",
+            framecount_++, s->g.yn, s->g.xn, vtframe_.n,
+            (vtframe_.n / (double)(s->g.yn * s->g.xn)), s->scale, s->fx,
+            s->quant, rastertime_, writetime_);
+    }
+    pthread_rwlock_unlock(&pipelock_);
+    PopFrame(&scaled_);
+  }
+  return 0;
+}
+
+static void StartPipeline(void) {
+  sigset_t mask, old;
+  sem_init(&decoded_.ready, 0, 0);
+  sem_init(&scaled_.ready, 0, 0);
+  sigfillset(&mask);
+  pthread_sigmask(SIG_SETMASK, &mask, &old);
+  CHECK_EQ(0, pthread_create(&scaler_, 0, ScaleVideo, 0));
+  CHECK_EQ(0, pthread_create(&writer_, 0, WriteVideo, 0));
+  pthread_sigmask(SIG_SETMASK, &old, 0);
+  pthread_setname_np(scaler_, "scaler");
+  pthread_setname_np(writer_, "writer");
+  piping_ = true;
+}
+
+static void ResumePipeline(void) {
+  sigset_t mask, old;
+  if (paused_) {
+    sigfillset(&mask);
+    pthread_sigmask(SIG_SETMASK, &mask, &old);
+    pthread_rwlock_unlock(&pipelock_);
+    paused_ = false;
+    pthread_sigmask(SIG_SETMASK, &old, 0);
   }
+}
+
+/**
+ * Waits for pipeline threads to finish what they're doing so the main
+ * thread may change the knobs and dimensions they read.
+ *
+ * Signals are blocked while the lock changes hands, because OnCtrlC()
+ * may longjmp() and `paused_` must say whether we hold it.
+ */
+static void PausePipeline(void) {
+  sigset_t mask, old;
+  if (piping_ && !paused_) {
+    sigfillset(&mask);
+    pthread_sigmask(SIG_SETMASK, &mask, &old);
+    pthread_rwlock_wrlock(&pipelock_);
+    paused_ = true;
+    delta_.dirty = true;
+    pthread_sigmask(SIG_SETMASK, &old, 0);
+  }
+}
 
-  INFOF("𝑓%zu(%u×%u) %,zub (%f BPP) "
-        "ycbcr=%,zuns "
-        "scale=%,zuns "
-        "lace=%,zuns "
-        "fx=%,zuns "
-        "quantize=%,zuns "
-        "render=%,zuns",
-        framecount_++, g2_->yn, g2_->xn, f2_->n,
-        (f1_->n / (double)(g2_->yn * g2_->xn)), t1, t2, t8, t6, t3, t4);
+static void StopPipeline(void) {
+  if (piping_) {
+    piping_ = false;
+    ResumePipeline();
+    StopQueue(&decoded_);
+    pthread_join(scaler_, 0);
+    StopQueue(&scaled_);
+    pthread_join(writer_, 0);
+    sem_destroy(&decoded_.ready);
+    sem_destroy(&scaled_.ready);
+  }
 }
 
 static void OnVideo(plm_t *mpeg, plm_frame_t *pf, void *user) {
+  unsigned i;
+  size_t yn, cn;
+  struct DecodedFrame *d;
+  CHECK_EQ(pf->cb.width, pf->cr.width);
+  CHECK_EQ(pf->cb.height, pf->cr.height);
   gotvideo_ = true;
-  if (f2_->n) {
+  if (!ReserveFrame(&decoded_, &i)) {
     WARNF("video frame dropped");
-  } else {
-    TranscodeVideo(pf);
-    if (!f1_->n) {
-      struct VtFrame *t = f1_;
-      f1_ = f2_, f2_ = t;
-      f1_start_ = decode_start_;
-    } else {
-      f2_start_ = decode_start_;
-    }
+    return;
+  }
+  d = decodedframes_ + i;
+  yn = pf->y.width * pf->y.height;
+  cn = pf->cb.width * pf->cb.height;
+  if (d->size < yn + cn * 2) {
+    free(d->buf);
+    d->size = yn + cn * 2;
+    BALLOC(&d->buf, 64, d->size, "decoded");
   }
+  d->pf = *pf;
+  d->pf.y.data = memcpy(d->buf, pf->y.data, yn);
+  d->pf.cb.data = memcpy(d->buf + yn, pf->cb.data, cn);
+  d->pf.cr.data = memcpy(d->buf + yn + cn, pf->cr.data, cn);
+  d->par = 2;
+  if (pf1_)
+    d->par = 1.;
+  if (pf2_)
+    d->par = (266 / 64.) * (900 / 1600.);
+  d->par *= plm_get_pixel_aspect_ratio(plm_);
+  d->start = decode_start_;
+  PushFrame(&decoded_);
 }
 
 static void OpenVideo(void) {
@@ -761,57 +995,8 @@ static void OpenVideo(void) {
   g2_ = g1_ = resizegraphic(&graphic_[0], yn, xn);
 }
 
-static ssize_t WriteVideoCall(void) {
-  size_t amt;
-  ssize_t rc;
-  amt = min(4096 * 4, f1_->n - f1_->i);
-  if ((rc = write(outfd_, f1_->bytes + f1_->i, amt)) != -1) {
-    if ((f1_->i += rc) == f1_->n) {
-      if (plm_get_audio_enabled(plm_))
-        plm_set_audio_lead_time(
-            plm_,
-            max(0,
-                min(timespec_tofloat(timespec_sub(timespec_mono(), f1_start_)),
-                    plm_get_samplerate(plm_) / PLM_AUDIO_SAMPLES_PER_FRAME)));
-      f1_start_ = f2_start_;
-      f1_->i = f1_->n = 0;
-      struct VtFrame *t = f1_;
-      f1_ = f2_, f2_ = t;
-      RecordFactThatFrameWasFullyRendered();
-    }
-  }
-  return rc;
-}
-
-static void DrainVideo(void) {
-  if (f1_ && f1_->n) {
-    ttywrite(outfd_, f1_->bytes + f1_->i, f1_->n - f1_->i);
-    f1_->i = f1_->n = 0;
-  }
-  if (f2_ && f2_->n)
-    f2_->i = f2_->n = 0;
-}
-
-static void WriteVideo(void) {
-  ssize_t rc;
-  DEBUGF("write(tty) grace=%,ldns", timespec_tonanos(GetGraceTime()));
-  if ((rc = WriteVideoCall()) != -1) {
-    DEBUGF("write(tty) → %zd [grace=%,ldns]", rc,
-           timespec_tonanos(GetGraceTime()));
-  } else if (errno == EAGAIN || errno == EINTR) {
-    DEBUGF("write(tty) → EINTR");
-    longjmp(jbi_, 1);
-  } else if (errno == EPIPE) {
-    DEBUGF("write(tty) → EPIPE");
-    longjmp(jb_, 1);
-  } else {
-    FATALF("write(tty) → %s", strerror(errno));
-  }
-}
-
 static void RefreshDisplay(void) {
-  if (f1_ && f1_->n)
-    f1_->i = 0;
+  PausePipeline();
   DimensionDisplay();
   resized_ = false;
   historyclear_ = true;
@@ -1158,18 +1343,15 @@ static void PerformBestEffortIo(void) {
   int toto, pollms;
   struct pollfd fds[] = {
       {infd_, POLLIN},
-      {outfd_, f1_ && f1_->n ? POLLOUT : 0},
   };
   pollms = MAX(0, timespec_tomillis(GetGraceTime()));
   DEBUGF("poll() ms=%,d", pollms);
   if ((toto = poll(fds, ARRAYLEN(fds), pollms)) != -1) {
     DEBUGF("poll() toto=%d [grace=%,ldns]", toto,
            timespec_tonanos(GetGraceTime()));
-    if (toto) {
-      if (fds[0].revents & (POLLIN | POLLHUP | POLLERR))
-        ReadKeyboard();
-      if (fds[1].revents & (POLLOUT | POLLHUP | POLLERR))
-        WriteVideo();
+    if (toto && (fds[0].revents & (POLLIN | POLLHUP | POLLERR))) {
+      PausePipeline();
+      ReadKeyboard();
     }
   } else if (errno == EINTR) {
     DEBUGF("poll() → EINTR");
@@ -1180,7 +1362,7 @@ static void PerformBestEffortIo(void) {
 }
 
 static void RestoreTty(void) {
-  DrainVideo();
+  StopPipeline();
   if (ttymode_)
     ttysend(outfd_, "\r\n\e[J");
   ttymode_ = false;
@@ -1190,6 +1372,18 @@ static void RestoreTty(void) {
 static void HandleSignals(void) {
   if (resized_)
     RefreshDisplay();
+  ResumePipeline();
+  if (broken_)
+    longjmp(jb_, 1);
+}
+
+static void SetAudioLeadTime(void) {
+  long us;
+  if ((us = atomic_exchange(&leadtime_, -1)) != -1 &&
+      plm_get_audio_enabled(plm_))
+    plm_set_audio_lead_time(
+        plm_, max(0, min(us * 1e-6, plm_get_samplerate(plm_) /
+                                        PLM_AUDIO_SAMPLES_PER_FRAME)));
 }
 
 static void PrintVideo(void) {
@@ -1202,6 +1396,7 @@ static void PrintVideo(void) {
   deadline_ = timespec_add(deadline_, dura_);
   do {
     DEBUGF("plm_decode [grace=%,ldns]", timespec_tonanos(GetGraceTime()));
+    SetAudioLeadTime();
     decode_start_ = timespec_mono();
     plm_decode(plm_,
                timespec_tofloat(timespec_sub(decode_start_, decode_last)));
@@ -1275,6 +1470,7 @@ static void GetOpts(int argc, char *argv[]) {
 }
 
 static void OnExit(void) {
+  StopPipeline();
   if (plm_)
     plm_destroy(plm_), plm_ = NULL;
   YCbCrFree(&ycbcr_);
@@ -1283,10 +1479,13 @@ static void OnExit(void) {
   close(infd_), infd_ = -1;
   close(outfd_), outfd_ = -1;
   free(graphic_[0].b);
-  free(graphic_[1].b);
-  free(vtframe_[0].b);
-  free(vtframe_[1].b);
-  free(xtcodes_);
+  free(vtframe_.b);
+  ttydeltafree(&delta_);
+  for (int i = 0; i < QUEUE_DEPTH; ++i) {
+    free(decodedframes_[i].buf);
+    free(scaledframes_[i].g.b);
+    free(scaledframes_[i].xtcodes);
+  }
   free(audio_);
   CloseSpeaker();
 }
@@ -1451,6 +1650,7 @@ int main(int argc, char *argv[]) {
       longjmp(jb_, 1);
     OpenVideo();
     DimensionDisplay();
+    StartPipeline();
     starttime_ = timespec_mono();
     PrintVideo();
   }